@@ -0,0 +1,293 @@
+#include <benchmark/benchmark.h>
+
+#include "hardware_counter_scope.h"
+
+#include "../include/engine.h"
+#include "../include/headless_runner.h"
+#include "../include/impulse_response_cache.h"
+#include "../include/kernel_dispatch.h"
+#include "../include/piston_engine_simulator.h"
+#include "../include/simulator.h"
+#include "../include/transmission.h"
+#include "../include/units.h"
+#include "../include/vehicle.h"
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/compiler.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Macro benchmarks: every script under assets/engines that defines a main
+// node is run for --engine-seconds simulated seconds through the headless
+// runner, once with physics only and once with audio synthesis. Kernel
+// benchmarks live in kernel_benchmarks.cpp and share this main.
+namespace {
+struct EngineOptions {
+    std::string assetPath = ENGINE_SIM_BENCH_ASSET_PATH;
+    double seconds = 2.0;
+};
+
+EngineOptions g_options;
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+struct Instance {
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+    Simulator *simulator = nullptr;
+};
+
+bool definesMain(const std::filesystem::path &script) {
+    std::ifstream file(script);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("public node main", 0) == 0 || line.rfind("node main", 0) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Engine scripts only declare their nodes; a wrapper imports one and runs it
+bool loadEngine(const std::filesystem::path &script, Instance *instance) {
+    const std::filesystem::path wrapper =
+        std::filesystem::temp_directory_path() / ("engine_sim_bench_" + script.stem().string() + ".mr");
+    {
+        std::ofstream file(wrapper);
+        file << "import \"engine_sim.mr\"\n";
+        file << "import \"" << std::filesystem::absolute(script).generic_string() << "\"\n";
+        file << "main()\n";
+    }
+
+    es_script::Compiler compiler;
+    compiler.initialize();
+    compiler.addSearchPath((std::filesystem::path(g_options.assetPath) / "es").string().c_str());
+    compiler.addSearchPath((std::filesystem::path(g_options.assetPath) / "assets").string().c_str());
+
+    if (compiler.compile(wrapper.string().c_str())) {
+        const es_script::Compiler::Output output = compiler.execute();
+        instance->engine = output.engine;
+        instance->vehicle = output.vehicle;
+        instance->transmission = output.transmission;
+    }
+
+    compiler.destroy();
+    std::filesystem::remove(wrapper);
+
+    return instance->engine != nullptr
+        && instance->vehicle != nullptr
+        && instance->transmission != nullptr;
+}
+
+void destroyInstance(Instance *instance) {
+    if (instance->simulator != nullptr) {
+        instance->simulator->releaseSimulation();
+        delete instance->simulator;
+    }
+
+    delete instance->vehicle;
+    delete instance->transmission;
+
+    if (instance->engine != nullptr) {
+        instance->engine->destroy();
+        delete instance->engine;
+    }
+
+    *instance = Instance();
+}
+
+void createSimulator(Instance *instance, bool audio) {
+    Engine *engine = instance->engine;
+    Simulator *simulator = engine->createSimulator(
+            instance->vehicle,
+            instance->transmission,
+            false,
+            audio);
+    engine->calculateDisplacement();
+    simulator->setSimulationFrequency(static_cast<int>(engine->getSimulationFrequency()));
+
+    if (audio) {
+        std::vector<ImpulseResponse *> responses;
+        for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+            responses.push_back(engine->getExhaustSystem(i)->getImpulseResponse());
+        }
+
+        std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> kernels;
+        ImpulseResponseCache::Load(
+            responses.data(),
+            static_cast<int>(responses.size()),
+            simulator->getAudioSampleRate(),
+            &kernels);
+        for (int i = 0; i < static_cast<int>(kernels.size()); ++i) {
+            if (kernels[i] != nullptr) {
+                simulator->synthesizer().initializeImpulseResponse(kernels[i]->filter, i);
+            }
+        }
+
+        simulator->startAudioRenderingThread();
+    }
+
+    instance->simulator = simulator;
+}
+
+// Starter for the first second, then a part throttle rev
+void BM_EngineScript(
+    benchmark::State &state,
+    std::filesystem::path script,
+    bool audio,
+    bool specializedKernels)
+{
+    Instance instance;
+    if (!loadEngine(script, &instance)) {
+        destroyInstance(&instance);
+        state.SkipWithError("failed to load the engine");
+        return;
+    }
+
+    createSimulator(&instance, audio);
+
+    PistonEngineSimulator *pistonSimulator = dynamic_cast<PistonEngineSimulator *>(instance.simulator);
+    if (pistonSimulator != nullptr) {
+        pistonSimulator->setSpecializedStepKernels(specializedKernels);
+    }
+
+    HeadlessRunner::Parameters params;
+    params.duration = g_options.seconds;
+    params.offline = true;
+
+    HeadlessRunner::ControlPoint start;
+    start.starter = true;
+    start.throttle = 0.2;
+
+    HeadlessRunner::ControlPoint rev;
+    rev.time = std::min(1.0, 0.5 * g_options.seconds);
+    rev.throttle = 0.5;
+    params.schedule = { start, rev };
+
+    HeadlessRunner runner;
+    runner.initialize(params);
+
+    // Per simulated step, on this thread only; the audio thread isn't counted
+    HardwareCounterScope hardwareCounters(state);
+    HeadlessRunner::Statistics total;
+    for (auto _ : state) {
+        const HeadlessRunner::Statistics stats = runner.run(instance.simulator);
+        total.simulatedTime += stats.simulatedTime;
+        total.wallTime += stats.wallTime;
+        total.steps += stats.steps;
+        total.fluidSubsteps += stats.fluidSubsteps;
+    }
+
+    hardwareCounters.report(static_cast<double>(total.steps));
+
+    runner.destroy();
+
+    state.SetItemsProcessed(total.steps);
+    state.counters["real_time_factor"] = total.realTimeFactor();
+    state.counters["fluid_substeps"] = total.averageFluidSubsteps();
+    state.counters["cylinders"] = instance.engine->getCylinderCount();
+    state.counters["specialized_kernels"] =
+        (pistonSimulator != nullptr && pistonSimulator->getStepKernelCylinderCount() > 0) ? 1 : 0;
+
+    destroyInstance(&instance);
+}
+
+void registerEngineBenchmarks() {
+    const std::filesystem::path engines =
+        std::filesystem::path(g_options.assetPath) / "assets" / "engines";
+    if (!std::filesystem::is_directory(engines)) {
+        std::fprintf(stderr, "no engine scripts under '%s'\n", engines.string().c_str());
+        return;
+    }
+
+    std::vector<std::filesystem::path> scripts;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(engines)) {
+        if (entry.path().extension() == ".mr" && definesMain(entry.path())) {
+            scripts.push_back(entry.path());
+        }
+    }
+
+    std::sort(scripts.begin(), scripts.end());
+    for (const std::filesystem::path &script : scripts) {
+        const std::string name =
+            std::filesystem::relative(script, engines).replace_extension().generic_string();
+        for (const bool audio : { false, true }) {
+            benchmark::RegisterBenchmark(
+                ("BM_Engine/" + name + (audio ? "/audio" : "/physics")).c_str(),
+                BM_EngineScript,
+                script,
+                audio,
+                true)
+                ->Unit(benchmark::kMillisecond)
+                ->Iterations(1);
+        }
+
+        // The same steps through the loops every layout can use
+        benchmark::RegisterBenchmark(
+            ("BM_Engine/" + name + "/physics_dynamic").c_str(),
+            BM_EngineScript,
+            script,
+            false,
+            false)
+            ->Unit(benchmark::kMillisecond)
+            ->Iterations(1);
+    }
+}
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+} /* namespace */
+
+// Takes --engine-assets=<repo root>, --engine-seconds=<s>,
+// --hardware-counters and --kernel-isa=<isa> on top of the usual
+// --benchmark_* flags
+int main(int argc, char **argv) {
+    std::vector<char *> args;
+    for (int i = 0; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--engine-assets=", 16) == 0) {
+            g_options.assetPath = argv[i] + 16;
+        }
+        else if (std::strncmp(argv[i], "--engine-seconds=", 17) == 0) {
+            g_options.seconds = std::max(0.1, std::atof(argv[i] + 17));
+        }
+        else if (std::strcmp(argv[i], "--hardware-counters") == 0) {
+            if (!HardwareCounters::IsSupported()) {
+                std::fprintf(stderr, "hardware counters are unavailable on this system\n");
+            }
+
+            HardwareCounters::SetEnabled(true);
+        }
+        else if (std::strncmp(argv[i], "--kernel-isa=", 13) == 0) {
+            KernelDispatch::Isa isa;
+            if (!KernelDispatch::Parse(argv[i] + 13, &isa) || !KernelDispatch::SetIsa(isa)) {
+                std::fprintf(stderr, "--kernel-isa=%s isn't supported by this build or host\n", argv[i] + 13);
+                return 1;
+            }
+        }
+        else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    int benchmarkArgc = static_cast<int>(args.size());
+    benchmark::Initialize(&benchmarkArgc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchmarkArgc, args.data())) return 1;
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    registerEngineBenchmarks();
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+    benchmark::AddCustomContext("kernel_isa", KernelDispatch::GetName(KernelDispatch::GetIsa()));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef ATG_ENGINE_SIM_HARDWARE_COUNTER_SCOPE_H
+#define ATG_ENGINE_SIM_HARDWARE_COUNTER_SCOPE_H
+
+#include <benchmark/benchmark.h>
+
+#include "../include/hardware_counters.h"
+
+// Hardware counters over a benchmark's timed loop, reported as user counters
+// next to its time: IPC, then cycles, instructions, cache misses and branch
+// misses per iteration, or per whatever unit the benchmark passes to report().
+// Only collected with --hardware-counters.
+class HardwareCounterScope {
+public:
+    explicit HardwareCounterScope(benchmark::State &state) : m_state(state) {
+        m_counted = HardwareCounters::IsEnabled() && threadCounters().read(&m_start);
+    }
+
+    void report(double units = 0.0) {
+        HardwareCounters::Sample end;
+        if (!m_counted || !threadCounters().read(&end)) return;
+        m_counted = false;
+
+        const HardwareCounters::Sample counted = end - m_start;
+        m_state.counters["ipc"] = counted.ipc();
+        for (int i = 0; i < HardwareCounters::CounterCount; ++i) {
+            const HardwareCounters::Counter counter = static_cast<HardwareCounters::Counter>(i);
+            const double value = static_cast<double>(counted.get(counter));
+            m_state.counters[HardwareCounters::GetCounterName(counter)] = (units > 0)
+                ? benchmark::Counter(value / units)
+                : benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+        }
+    }
+
+private:
+    static HardwareCounters &threadCounters() {
+        // Tried once per thread; reads fail if it couldn't be opened
+        thread_local HardwareCounters counters;
+        thread_local const bool opened = counters.open();
+        (void)opened;
+
+        return counters;
+    }
+
+    benchmark::State &m_state;
+    bool m_counted;
+    HardwareCounters::Sample m_start;
+};
+
+#endif /* ATG_ENGINE_SIM_HARDWARE_COUNTER_SCOPE_H */
@@ -0,0 +1,628 @@
+#include <benchmark/benchmark.h>
+
+#include "hardware_counter_scope.h"
+
+#include "../include/camshaft.h"
+#include "../include/constants.h"
+#include "../include/convolution_batch.h"
+#include "../include/convolution_filter.h"
+#include "../include/crankshaft.h"
+#include "../include/denormals.h"
+#include "../include/flow_rate_batch.h"
+#include "../include/function.h"
+#include "../include/gas_system.h"
+#include "../include/ignition_module.h"
+#include "../include/kernel_dispatch.h"
+#include "../include/low_pass_filter.h"
+#include "../include/random_stream.h"
+#include "../include/ring_buffer.h"
+#include "../include/synthesizer.h"
+#include "../include/units.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+// Roughly a lobe profile or timing curve as the scripts write them
+void initializeCurve(Function *f, int samples) {
+    f->initialize(samples, units::angle(2, units::deg));
+    for (int i = 0; i < samples; ++i) {
+        const double x = units::angle(-90.0 + 180.0 * i / (samples - 1), units::deg);
+        const double lift = std::fmax(0.0, std::cos(x));
+        f->addSample(x, units::distance(400 * lift * lift, units::thou));
+    }
+}
+
+void initializeCrankshaft(Crankshaft *crankshaft) {
+    Crankshaft::Parameters params;
+    params.mass = units::mass(30, units::kg);
+    params.flywheelMass = units::mass(10, units::kg);
+    params.momentOfInertia = 0.2;
+    params.crankThrow = units::distance(2, units::inch);
+    params.rodJournals = 1;
+    crankshaft->initialize(params);
+    crankshaft->m_body.v_theta = -units::rpm(3000);
+}
+
+void BM_GasSystemFlow(benchmark::State &state) {
+    GasSystem runner, collector;
+    runner.initialize(
+        units::pressure(2.0, units::atm),
+        units::volume(500, units::cc),
+        units::celcius(600));
+    collector.initialize(
+        units::pressure(1.0, units::atm),
+        units::volume(2000, units::cc),
+        units::celcius(400));
+
+    GasSystem::FlowParameters params;
+    params.k_flow = GasSystem::k_28inH2O(200);
+    params.dt = 1 / 80000.0;
+    params.direction_x = 1.0;
+    params.direction_y = 0.0;
+    params.crossSectionArea_0 = units::area(2, units::cm2);
+    params.crossSectionArea_1 = units::area(10, units::cm2);
+    params.system_0 = &runner;
+    params.system_1 = &collector;
+
+    int i = 0;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(GasSystem::flow(params));
+
+        // Keep a pressure difference so the flow doesn't settle to zero
+        if (++i == 1024) {
+            runner.reset(units::pressure(2.0, units::atm), units::celcius(600));
+            collector.reset(units::pressure(1.0, units::atm), units::celcius(400));
+            i = 0;
+        }
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GasSystemFlow);
+
+// Arg 1 passes the per-system cached flow constants, 0 derives them from
+// the heat capacity ratio on every call
+void BM_GasSystemFlowRateConstants(benchmark::State &state) {
+    const bool cached = state.range(0) != 0;
+    const double hcr = GasSystem::heatCapacityRatio(5);
+    const double chokedLimit = GasSystem::chokedFlowLimit(5);
+    const double chokedRate = GasSystem::chokedFlowRate(5);
+    const GasSystem::FlowConstants c = GasSystem::flowConstants(5);
+
+    const double P0 = units::pressure(1.2, units::atm);
+    const double T0 = units::celcius(25.0), T1 = units::celcius(400.0);
+
+    double ratio = 0.3;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        const double P1 = P0 * ratio;
+        benchmark::DoNotOptimize(cached
+            ? GasSystem::flowRate(1E-6, P0, P1, T0, T1, c)
+            : GasSystem::flowRate(1E-6, P0, P1, T0, T1, hcr, chokedLimit, chokedRate));
+
+        ratio += 1E-6;
+        if (ratio > 1.3) ratio = 0.3;
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GasSystemFlowRateConstants)->Arg(0)->Arg(1);
+
+// One valve flow evaluation per cylinder, as the fluid substep batches them
+template <typename T_Scalar>
+void BM_FlowRateBatch(benchmark::State &state) {
+    const int connections = static_cast<int>(state.range(0));
+    std::vector<GasSystem> systems(connections * 2);
+    std::vector<GasSystem::FlowState> flows(connections);
+    for (int i = 0; i < connections; ++i) {
+        systems[i * 2].initialize(
+            units::pressure(1.0 + 0.5 * (i % 5), units::atm),
+            units::volume(500, units::cc),
+            units::celcius(600));
+        systems[i * 2 + 1].initialize(
+            units::pressure(1.2, units::atm),
+            units::volume(500, units::cc),
+            units::celcius(400));
+
+        GasSystem::FlowParameters params;
+        params.k_flow = GasSystem::k_28inH2O(200);
+        params.dt = 1 / 80000.0;
+        params.direction_x = 1.0;
+        params.direction_y = 0.0;
+        params.crossSectionArea_0 = units::area(2, units::cm2);
+        params.crossSectionArea_1 = units::area(2, units::cm2);
+        params.system_0 = &systems[i * 2];
+        params.system_1 = &systems[i * 2 + 1];
+        GasSystem::beginFlow(params, &flows[i]);
+    }
+
+    BasicFlowRateBatch<T_Scalar> batch;
+    batch.initialize(connections);
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        batch.clear();
+        for (int i = 0; i < connections; ++i) {
+            batch.add(flows[i]);
+        }
+
+        batch.evaluate();
+        benchmark::DoNotOptimize(batch.getFlowRate(connections - 1));
+    }
+
+    hardwareCounters.report();
+
+    batch.destroy();
+
+    state.SetItemsProcessed(state.iterations() * connections);
+}
+BENCHMARK_TEMPLATE(BM_FlowRateBatch, double)->Arg(8)->Arg(16)->Arg(64);
+BENCHMARK_TEMPLATE(BM_FlowRateBatch, float)->Arg(8)->Arg(16)->Arg(64);
+
+// Args: sample count, and 1 to look up in the baked table
+void BM_FunctionSampleTriangle(benchmark::State &state) {
+    Function f;
+    initializeCurve(&f, static_cast<int>(state.range(0)));
+    if (state.range(1) != 0) f.bake();
+
+    double x = -constants::pi / 2;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.sampleTriangle(x));
+        x += 0.001;
+        if (x > constants::pi / 2) x = -constants::pi / 2;
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations());
+    f.destroy();
+}
+BENCHMARK(BM_FunctionSampleTriangle)
+    ->Args({ 16, 0 })->Args({ 64, 0 })->Args({ 256, 0 })
+    ->Args({ 16, 1 })->Args({ 64, 1 })->Args({ 256, 1 });
+
+void BM_FunctionSampleGaussian(benchmark::State &state) {
+    Function f;
+    initializeCurve(&f, static_cast<int>(state.range(0)));
+
+    double x = -constants::pi / 2;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.sampleGaussian(x));
+        x += 0.001;
+        if (x > constants::pi / 2) x = -constants::pi / 2;
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations());
+    f.destroy();
+}
+BENCHMARK(BM_FunctionSampleGaussian)->Arg(16)->Arg(64)->Arg(256);
+
+// Arg 1 looks the lift up in the baked table, 0 in the profile itself
+void BM_CamshaftValveLift(benchmark::State &state) {
+    Crankshaft crankshaft;
+    initializeCrankshaft(&crankshaft);
+
+    Function lobe;
+    initializeCurve(&lobe, 64);
+
+    Camshaft::Parameters params;
+    params.lobes = 8;
+    params.crankshaft = &crankshaft;
+    params.lobeProfile = &lobe;
+    params.bakeLobe = state.range(0) != 0;
+
+    Camshaft camshaft;
+    camshaft.initialize(params);
+    for (int i = 0; i < params.lobes; ++i) {
+        camshaft.setLobeCenterline(i, i * 4 * constants::pi / params.lobes);
+    }
+
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        for (int i = 0; i < params.lobes; ++i) {
+            benchmark::DoNotOptimize(camshaft.valveLift(i));
+        }
+
+        crankshaft.m_body.theta += 0.01;
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations() * params.lobes);
+    camshaft.destroy();
+    lobe.destroy();
+    crankshaft.destroy();
+}
+BENCHMARK(BM_CamshaftValveLift)->Arg(0)->Arg(1);
+
+// Args: tap count, and 1 for partitioned convolution
+void BM_ConvolutionFilter(benchmark::State &state) {
+    const int taps = static_cast<int>(state.range(0));
+
+    RandomStream random;
+    random.seed(5, 0);
+
+    ConvolutionFilter filter;
+    filter.initialize(taps);
+    for (int i = 0; i < taps; ++i) {
+        filter.getImpulseResponse()[i] =
+            random.uniform(-1.0f, 1.0f) * std::exp(-4.0f * i / taps);
+    }
+
+    if (state.range(1) != 0) filter.preparePartitioned();
+
+    float x = 0;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.f(x));
+        x = random.uniform(-1.0f, 1.0f);
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations());
+    filter.destroy();
+}
+BENCHMARK(BM_ConvolutionFilter)
+    ->Args({ 64, 0 })->Args({ 256, 0 })->Args({ 1024, 0 })->Args({ 4096, 0 })
+    ->Args({ 1024, 1 })->Args({ 4096, 1 })->Args({ 16384, 1 });
+
+// Direct form over a whole block with f_block(); the arg is the tap count
+void BM_ConvolutionFilterBlock(benchmark::State &state) {
+    constexpr int BlockSize = 1024;
+    const int taps = static_cast<int>(state.range(0));
+
+    RandomStream random;
+    random.seed(5, 0);
+
+    ConvolutionFilter filter;
+    filter.initialize(taps);
+    for (int i = 0; i < taps; ++i) {
+        filter.getImpulseResponse()[i] =
+            random.uniform(-1.0f, 1.0f) * std::exp(-4.0f * i / taps);
+    }
+
+    std::vector<float> input(BlockSize);
+    std::vector<float> output(BlockSize);
+    random.fill(input.data(), BlockSize, -1.0f, 1.0f);
+
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        filter.f_block(input.data(), output.data(), BlockSize);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations() * BlockSize);
+    filter.destroy();
+}
+BENCHMARK(BM_ConvolutionFilterBlock)->Arg(256)->Arg(1024)->Arg(4096);
+
+// Args: instance count, and 1 to run them as one ConvolutionBatch. Each
+// instance convolves its own 256-sample block with one shared 16384-tap IR
+void BM_ConvolutionBatch(benchmark::State &state) {
+    constexpr int Taps = 16384;
+    constexpr int BlockSize = 256;
+    const int instances = static_cast<int>(state.range(0));
+    const bool batched = state.range(1) != 0;
+
+    RandomStream random;
+    random.seed(5, 0);
+
+    std::vector<float> ir(Taps);
+    for (int i = 0; i < Taps; ++i) {
+        ir[i] = random.uniform(-1.0f, 1.0f) * std::exp(-4.0f * i / Taps);
+    }
+
+    PartitionedConvolution prototype;
+    prototype.initialize(ir.data(), Taps, 64, 1024);
+
+    ConvolutionBatch batch;
+    std::vector<PartitionedConvolution> separate(batched ? 0 : instances);
+    if (batched) batch.initialize(prototype, instances);
+    for (PartitionedConvolution &convolution : separate) convolution.initialize(prototype);
+
+    std::vector<std::vector<float>> input(instances, std::vector<float>(BlockSize));
+    std::vector<std::vector<float>> output(instances, std::vector<float>(BlockSize));
+    std::vector<const float *> inputs(instances);
+    std::vector<float *> outputs(instances);
+    for (int i = 0; i < instances; ++i) {
+        random.fill(input[i].data(), BlockSize, -1.0f, 1.0f);
+        inputs[i] = input[i].data();
+        outputs[i] = output[i].data();
+    }
+
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        if (batched) {
+            batch.process(inputs.data(), outputs.data(), BlockSize);
+        }
+        else {
+            for (int i = 0; i < instances; ++i) {
+                for (int j = 0; j < BlockSize; ++j) {
+                    outputs[i][j] = separate[i].f(inputs[i][j]);
+                }
+            }
+        }
+
+        benchmark::DoNotOptimize(outputs[0][0]);
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations() * instances * BlockSize);
+    for (PartitionedConvolution &convolution : separate) convolution.destroy();
+    batch.destroy();
+    prototype.destroy();
+}
+BENCHMARK(BM_ConvolutionBatch)
+    ->Args({ 8, 0 })->Args({ 8, 1 })->Args({ 64, 0 })->Args({ 64, 1 });
+
+// An impulse decaying through a low pass into a 256-tap IR, block by block.
+// The low pass rounds down to the smallest subnormal and stays there, so
+// without flushing every later sample is subnormal; subnormal_out counts
+// them and must be 0 with the arg at 1 (DenormalScope enabled)
+void BM_DenormalDecay(benchmark::State &state) {
+    constexpr int BlockSize = 1024;
+    constexpr int Taps = 256;
+    const bool flush = state.range(0) != 0;
+
+    RandomStream random;
+    random.seed(11, 0);
+
+    ConvolutionFilter convolution;
+    convolution.initialize(Taps);
+    for (int i = 0; i < Taps; ++i) {
+        convolution.getImpulseResponse()[i] =
+            random.uniform(-1.0f, 1.0f) * std::exp(-4.0f * i / Taps);
+    }
+
+    LowPassFilter lowPass;
+    lowPass.m_dt = 1 / 44100.0f;
+    lowPass.setCutoffFrequency(2000.0f);
+
+    std::vector<float> input(BlockSize, 0.0f);
+    std::vector<float> filtered(BlockSize);
+    std::vector<float> output(BlockSize);
+    input[0] = 1.0f;
+
+    DenormalScope denormals(flush);
+
+    long long subnormal = 0;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        lowPass.fast_f(input.data(), filtered.data(), BlockSize);
+        convolution.f_block(filtered.data(), output.data(), BlockSize);
+        input[0] = 0.0f;
+
+        for (int i = 0; i < BlockSize; ++i) {
+            if (std::fpclassify(output[i]) == FP_SUBNORMAL) ++subnormal;
+        }
+
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    hardwareCounters.report();
+
+    state.counters["subnormal_out"] = static_cast<double>(subnormal);
+    state.SetItemsProcessed(state.iterations() * BlockSize);
+    convolution.destroy();
+}
+BENCHMARK(BM_DenormalDecay)->Arg(0)->Arg(1);
+
+// One block of a 10 kHz physics rate rendered to 44.1 kHz audio; the arg is
+// the channel count
+void BM_SynthesizerRenderAudio(benchmark::State &state) {
+    const int channels = static_cast<int>(state.range(0));
+    constexpr int InputFrames = 160;
+
+    Synthesizer::Parameters params;
+    params.inputChannelCount = channels;
+    params.inputBufferSize = 4096;
+    params.audioBufferSize = 44100;
+    params.inputSampleRate = 10000;
+    params.audioSampleRate = 44100;
+
+    Synthesizer synth;
+    synth.initialize(params);
+
+    std::vector<int16_t> impulseResponse(4096);
+    RandomStream random;
+    random.seed(7, 0);
+    for (size_t i = 0; i < impulseResponse.size(); ++i) {
+        impulseResponse[i] = static_cast<int16_t>(
+            random.uniform(-1.0f, 1.0f) * 8000 * std::exp(-4.0f * i / impulseResponse.size()));
+    }
+
+    for (int i = 0; i < channels; ++i) {
+        synth.initializeImpulseResponse(
+            impulseResponse.data(), static_cast<unsigned int>(impulseResponse.size()), 1.0f, i);
+    }
+
+    std::vector<double> input(InputFrames * channels);
+    std::vector<int16_t> output(params.audioBufferSize);
+
+    int t = 0;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        for (int i = 0; i < InputFrames; ++i, ++t) {
+            for (int j = 0; j < channels; ++j) {
+                input[i * channels + j] = 1000 * std::sin(0.05 * t + j);
+            }
+        }
+
+        synth.writeInput(input.data(), InputFrames);
+        synth.endInputBlock();
+        synth.renderAudio();
+        synth.readAudioOutput(static_cast<int>(output.size()), output.data());
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations() * InputFrames);
+    synth.destroy();
+}
+BENCHMARK(BM_SynthesizerRenderAudio)->Arg(1)->Arg(4);
+
+void BM_RingBufferWriteRead(benchmark::State &state) {
+    const int block = static_cast<int>(state.range(0));
+
+    RingBuffer<double> buffer;
+    buffer.initialize(4096);
+
+    std::vector<double> output(block);
+    double v = 0;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        for (int i = 0; i < block; ++i) buffer.write(v += 1.0);
+        buffer.readAndRemove(block, output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations() * block);
+    buffer.destroy();
+}
+BENCHMARK(BM_RingBufferWriteRead)->Arg(1)->Arg(32)->Arg(512);
+
+// Masked indexing with one bulk write per block
+void BM_RingBufferPow2BulkWriteRead(benchmark::State &state) {
+    const int block = static_cast<int>(state.range(0));
+
+    RingBuffer<double, true> buffer;
+    buffer.initialize(4096);
+
+    std::vector<double> input(block);
+    std::vector<double> output(block);
+    double v = 0;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        for (int i = 0; i < block; ++i) input[i] = (v += 1.0);
+        buffer.write(input.data(), input.size());
+        buffer.readAndRemove(block, output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations() * block);
+    buffer.destroy();
+}
+BENCHMARK(BM_RingBufferPow2BulkWriteRead)->Arg(1)->Arg(32)->Arg(512);
+
+// One physics step at 10 kHz per iteration; the arg is the cylinder count
+void BM_IgnitionModuleUpdate(benchmark::State &state) {
+    const int cylinders = static_cast<int>(state.range(0));
+
+    Crankshaft crankshaft;
+    initializeCrankshaft(&crankshaft);
+
+    Function timing;
+    timing.initialize(8, units::rpm(1000));
+    for (int i = 0; i < 8; ++i) {
+        timing.addSample(units::rpm(i * 1000.0), units::angle(10 + i * 3.0, units::deg));
+    }
+
+    IgnitionModule::Parameters params;
+    params.cylinderCount = cylinders;
+    params.crankshaft = &crankshaft;
+    params.timingCurve = &timing;
+    params.revLimit = units::rpm(8000);
+
+    IgnitionModule ignition;
+    ignition.initialize(params);
+    for (int i = 0; i < cylinders; ++i) {
+        ignition.setFiringOrder(i, i * 4 * constants::pi / cylinders);
+    }
+    ignition.m_enabled = true;
+    ignition.reset();
+
+    const double dt = 1 / 10000.0;
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        crankshaft.m_body.theta += crankshaft.m_body.v_theta * dt;
+        ignition.update(dt);
+        ignition.resetIgnitionEvents();
+    }
+
+    hardwareCounters.report();
+
+    state.SetItemsProcessed(state.iterations());
+    ignition.destroy();
+    timing.destroy();
+    crankshaft.destroy();
+}
+BENCHMARK(BM_IgnitionModuleUpdate)->Arg(4)->Arg(8)->Arg(12);
+
+// Each ISA's kernels side by side on one host, whichever one the rest of
+// the run is bound to; (isa, length)
+void BM_KernelDotProduct(benchmark::State &state) {
+    const KernelDispatch::Isa isa = static_cast<KernelDispatch::Isa>(state.range(0));
+    const int n = static_cast<int>(state.range(1));
+    if (!KernelDispatch::IsSupported(isa)) {
+        state.SkipWithError("isa not supported here");
+        return;
+    }
+
+    const KernelDispatch::Isa saved = KernelDispatch::GetIsa();
+    KernelDispatch::SetIsa(isa);
+    const KernelDispatch::Table &kernels = KernelDispatch::Get();
+    KernelDispatch::SetIsa(saved);
+
+    RandomStream random;
+    std::vector<float> a(n), b(n);
+    random.fill(a.data(), n, -1.0f, 1.0f);
+    random.fill(b.data(), n, -1.0f, 1.0f);
+
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels.dotProduct(a.data(), b.data(), n));
+    }
+
+    state.SetLabel(KernelDispatch::GetName(isa));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_KernelDotProduct)
+    ->ArgsProduct({ benchmark::CreateDenseRange(0, static_cast<int>(KernelDispatch::Isa::Count) - 1, 1), { 64, 1024 } });
+
+void BM_KernelSpectrumMac(benchmark::State &state) {
+    const KernelDispatch::Isa isa = static_cast<KernelDispatch::Isa>(state.range(0));
+    const int n = static_cast<int>(state.range(1));
+    if (!KernelDispatch::IsSupported(isa)) {
+        state.SkipWithError("isa not supported here");
+        return;
+    }
+
+    const KernelDispatch::Isa saved = KernelDispatch::GetIsa();
+    KernelDispatch::SetIsa(isa);
+    const KernelDispatch::Table &kernels = KernelDispatch::Get();
+    KernelDispatch::SetIsa(saved);
+
+    RandomStream random;
+    std::vector<float> x(2 * n), y(2 * n), acc(2 * n, 0.0f);
+    random.fill(x.data(), 2 * n, -1.0f, 1.0f);
+    random.fill(y.data(), 2 * n, -1.0f, 1.0f);
+
+    HardwareCounterScope hardwareCounters(state);
+    for (auto _ : state) {
+        kernels.multiplyAccumulateSpectrum(acc.data(), x.data(), y.data(), n);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(KernelDispatch::GetName(isa));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_KernelSpectrumMac)
+    ->ArgsProduct({ benchmark::CreateDenseRange(0, static_cast<int>(KernelDispatch::Isa::Count) - 1, 1), { 256, 2048 } });
+} /* namespace */
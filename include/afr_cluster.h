@@ -3,7 +3,7 @@
 
 #include "ui_element.h"
 
-#include "engine.h"
+#include "simulator.h"
 #include "gauge.h"
 #include "cylinder_temperature_gauge.h"
 #include "cylinder_pressure_gauge.h"
@@ -21,7 +21,7 @@ class AfrCluster : public UiElement {
         virtual void update(float dt);
         virtual void render();
 
-        Engine *m_engine;
+        Simulator *m_simulator;
 
     protected:
         LabeledGauge *m_intakeAfrGauge;
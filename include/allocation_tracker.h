@@ -0,0 +1,93 @@
+#ifndef ATG_ENGINE_SIM_ALLOCATION_TRACKER_H
+#define ATG_ENGINE_SIM_ALLOCATION_TRACKER_H
+
+#include <cinttypes>
+#include <string>
+
+// Counts global operator new calls per thread when the library is built with
+// ATG_ENGINE_SIM_TRACK_ALLOCATIONS (CMake: ENGINE_SIM_TRACK_ALLOCATIONS=ON);
+// otherwise the count is always zero.
+//
+// Tracked builds also attribute live bytes and allocation totals to the
+// subsystem tag of the allocating thread, set with scopes. Every Nth
+// allocation records its backtrace, so sites that keep growing show up by
+// their sampled live bytes without the cost of tracing every call. Memory is
+// accounted to the tag it was allocated under wherever it is freed.
+class AllocationTracker {
+public:
+    enum class Tag {
+        Other,
+        Simulation,
+        Synthesizer,
+        Ui,
+        Geometry,
+        DebugTrace,
+        Scripting,
+        Loader,
+        Count
+    };
+
+    static constexpr int TagCount = static_cast<int>(Tag::Count);
+
+    struct TagStatistics {
+        uint64_t liveBytes = 0;
+        uint64_t liveAllocations = 0;
+        uint64_t totalBytes = 0;
+        uint64_t totalAllocations = 0;
+    };
+
+    struct Site {
+        static constexpr int MaxFrames = 12;
+
+        void *frames[MaxFrames] = {};
+        int frameCount = 0;
+        Tag tag = Tag::Other;
+
+        // Of the sampled allocations only; multiply by the sample interval
+        // for an estimate
+        uint64_t liveBytes = 0;
+        uint64_t liveAllocations = 0;
+        uint64_t totalAllocations = 0;
+    };
+
+    // Sets the calling thread's tag for its lifetime and restores the
+    // previous one after
+    class Scope {
+    public:
+        explicit Scope(Tag tag);
+        ~Scope();
+
+    private:
+        Tag m_previous;
+    };
+
+public:
+    static bool IsEnabled();
+    static unsigned long long GetThreadAllocationCount();
+
+    static const char *GetTagName(Tag tag);
+    static Tag GetThreadTag();
+    static void GetTagStatistics(Tag tag, TagStatistics *statistics);
+
+    // One backtrace per interval allocations on each thread; 0 stops
+    // sampling. Backtraces are only available where execinfo is.
+    static void SetSampleInterval(int allocations);
+    static int GetSampleInterval();
+
+    // Fills up to maxSites sites, most sampled live bytes first
+    static int GetTopSites(Site *sites, int maxSites);
+
+    // Symbolized frames, innermost first, separated by " < "
+    static std::string DescribeSite(const Site &site);
+};
+
+#if defined(ATG_ENGINE_SIM_TRACK_ALLOCATIONS)
+#define ATG_ENGINE_SIM_ALLOCATION_CONCAT_(a, b) a##b
+#define ATG_ENGINE_SIM_ALLOCATION_CONCAT(a, b) ATG_ENGINE_SIM_ALLOCATION_CONCAT_(a, b)
+#define ATG_ENGINE_SIM_ALLOCATION_SCOPE(tag) \
+    AllocationTracker::Scope ATG_ENGINE_SIM_ALLOCATION_CONCAT(allocationScope, __LINE__)(AllocationTracker::Tag::tag)
+#else
+#define ATG_ENGINE_SIM_ALLOCATION_SCOPE(tag) ((void)0)
+#endif /* ATG_ENGINE_SIM_TRACK_ALLOCATIONS */
+
+#endif /* ATG_ENGINE_SIM_ALLOCATION_TRACKER_H */
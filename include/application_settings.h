@@ -10,6 +10,101 @@ struct ApplicationSettings {
     std::string pressureUnits = "inHg";
     std::string boostUnits = "psi";
 
+    // "live", "balanced" or "offline"; a positive audioLatency (seconds)
+    // overrides the profile's target
+    std::string latencyProfile = "balanced";
+    double audioLatency = 0.0;
+
+    // Times throttle key presses through physics, synthesis and the device
+    // buffer; see LatencyProbe, reported in the performance HUD (F9)
+    bool latencyProbe = false;
+
+    // Pre-renders hold, full and closed throttle futures on spare job system
+    // workers and plays the matching one when the throttle target changes;
+    // see SpeculativeLookahead
+    bool speculativeLookahead = false;
+
+    // Sizes the audio rings to the latency target alone, see LatencyProfile
+    bool reducedAudioMemory = false;
+
+    // TPDF dither when quantizing the float output for an int16 device
+    bool audioDither = false;
+
+    // Steps the simulator on its own thread instead of once per rendered
+    // frame
+    bool threadedPhysics = false;
+
+    // ThreadPolicy for the audio and physics threads; a core of -1 leaves
+    // the thread unpinned
+    bool realtimeAudio = true;
+    bool realtimePhysics = false;
+    int audioCore = -1;
+    int physicsCore = -1;
+
+    // Shared memory or file name for TelemetryExport, written every
+    // telemetryDecimation steps; empty leaves it off
+    std::string telemetryExport = "";
+    int telemetryDecimation = 10;
+
+    // Caps the render rate while the window is unfocused or hidden, and
+    // while the synthesizer is starved, in favor of simulation
+    bool adaptiveFramerate = true;
+
+    // Pauses, as the P key does, once the window has been unfocused or
+    // hidden for that many seconds, resuming on focus; 0 leaves it off
+    double idlePause = 0.0;
+
+    // Generates the per-frame UI and part shapes on the job system
+    bool parallelGeometry = true;
+
+    // Simulates at preview fidelity while a hot reload or the dyno speed
+    // is being scrubbed, returning to full fidelity once input settles
+    bool previewFidelity = true;
+
+    // Times each engine as it loads and lowers its simulation frequency and
+    // fluid substeps until physics fits in fidelityHeadroom of real time
+    bool calibrateFidelity = false;
+    double fidelityHeadroom = 0.7;
+
+    // Loops the sound of a few captured engine cycles and pauses physics
+    // while the engine holds steady, until an input changes
+    bool cycleAudioCache = false;
+
+    // See ImpulseResponseProcessor
+    bool impulseResponseMinimumPhase = false;
+
+    // Directory derived data is kept in for later runs, see ArtifactCache;
+    // empty keeps nothing on disk. The size is in megabytes.
+    std::string artifactCache = "";
+    int artifactCacheSize = 512;
+
+    // Hardware controllers, see ControlSurface: a raw MIDI device node and
+    // a UDP port for OSC; empty and -1 leave each closed
+    std::string controlSurfaceMidi = "";
+    int controlSurfaceOscPort = -1;
+
+    // Convolves the tail of long impulse responses on a worker thread
+    bool offloadConvolutionTail = false;
+
+    // Solves the rigid bodies once every that many simulation steps; see
+    // Simulator::setRigidBodyInterval()
+    int rigidBodyInterval = 1;
+
+    // InputSession file the first engine's controls are recorded to or
+    // replayed from; replaying wins when both are set, and either skips
+    // fidelity calibration
+    std::string recordInput = "";
+    std::string replayInput = "";
+
+    // Video file the UI is rendered into at a fixed renderFrameRate timestep
+    // instead of the wall clock, for renderDuration seconds before the
+    // application exits; audio goes from the synthesizer straight into the
+    // WAV next to it rather than to the device. Needs a build with video
+    // capture.
+    std::string renderVideo = "";
+    int renderFrameRate = 60;
+    double renderDuration = 10.0;
+
     int colorBackground = 0x0E1012;
     int colorForeground = 0xFFFFFF;
     int colorShadow = 0x0E1012;
@@ -0,0 +1,127 @@
+#ifndef ATG_ENGINE_SIM_ARTIFACT_CACHE_H
+#define ATG_ENGINE_SIM_ARTIFACT_CACHE_H
+
+#include "mapped_file.h"
+
+#include <cinttypes>
+#include <mutex>
+#include <string>
+
+// Directory of derived data shared by every subsystem that can skip work
+// on a later run. An artifact is addressed by a hash of the content it was
+// made from, so a renamed input still hits and an edited one misses, plus
+// EngineSimVersion, so a build that derives things differently never reads
+// an older build's output. Writes go to a temporary file moved into place,
+// so readers never see half an artifact, and reads map the file. Once the
+// directory outgrows its limit the least recently read or written
+// artifacts are removed.
+class ArtifactCache {
+    public:
+        static constexpr uint32_t Magic = 0x43414545; // "EEAC"
+        static constexpr uint32_t Version = 1;
+
+        // Bump whenever any subsystem changes what it derives
+        static constexpr uint32_t EngineSimVersion = 1;
+
+        static constexpr uint64_t DefaultMaxBytes = 512ull * 1024 * 1024;
+
+        enum class Kind : uint32_t {
+            ImpulseResponse,
+            CompiledScript,
+            Count
+        };
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t engineSimVersion;
+            uint32_t kind;
+            uint64_t key;
+            uint64_t payloadSize;
+        };
+
+        // FNV-1a over everything an artifact depends on
+        class Key {
+            public:
+                explicit Key(Kind kind);
+
+                Key &add(const void *data, size_t size);
+                Key &add(const std::string &s);
+                Key &add(double value);
+                Key &add(int64_t value);
+                Key &add(int value) { return add(static_cast<int64_t>(value)); }
+                Key &add(bool value) { return add(static_cast<int64_t>(value ? 1 : 0)); }
+
+                // The file's contents; false, leaving the key as it was, if
+                // it can't be read
+                bool addFile(const std::string &path);
+
+                Kind getKind() const { return m_kind; }
+                uint64_t getHash() const { return m_hash; }
+
+            protected:
+                Kind m_kind;
+                uint64_t m_hash;
+        };
+
+        // A mapped artifact; the payload stays valid until it's closed or
+        // destroyed, even if the cache removes the file meanwhile
+        class Artifact {
+            public:
+                const char *getData() const { return m_file.getData() + sizeof(Header); }
+                size_t getSize() const { return m_size; }
+                void close() { m_file.close(); m_size = 0; }
+
+            protected:
+                friend class ArtifactCache;
+
+                MappedFile m_file;
+                size_t m_size = 0;
+        };
+
+        struct Statistics {
+            unsigned long long hits = 0;
+            unsigned long long misses = 0;
+            unsigned long long writes = 0;
+            unsigned long long evictions = 0;
+        };
+
+    public:
+        ArtifactCache();
+        ~ArtifactCache();
+
+        // An empty directory, the default, turns the cache off
+        void configure(const std::string &directory, uint64_t maxBytes = DefaultMaxBytes);
+        std::string getDirectory() const;
+        uint64_t getMaxBytes() const;
+        bool isEnabled() const;
+
+        // Safe from any thread
+        bool load(const Key &key, Artifact *artifact);
+        bool store(const Key &key, const void *data, size_t size);
+
+        // Removes the oldest artifacts until the rest fit in the limit
+        void trim();
+
+        std::string getPath(const Key &key) const;
+        Statistics getStatistics() const;
+
+        // For the application and the headless runner
+        static ArtifactCache &Shared();
+
+    protected:
+        static const char *getKindName(Kind kind);
+
+        mutable std::mutex m_lock;
+        std::string m_directory;
+        uint64_t m_maxBytes;
+
+        // Bytes in the directory as of the last trim, plus what's been
+        // written since
+        uint64_t m_bytes;
+        unsigned long long m_temporaryCount;
+
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_ARTIFACT_CACHE_H */
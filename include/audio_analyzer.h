@@ -0,0 +1,77 @@
+#ifndef ATG_ENGINE_SIM_AUDIO_ANALYZER_H
+#define ATG_ENGINE_SIM_AUDIO_ANALYZER_H
+
+#include "fft.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <complex>
+
+// Streaming sound metrics over the synthesizer's rendered blocks. Samples
+// are read in place and collected into half-overlapping Hann windows; each
+// full window gets one FFT. The metrics are smoothed over about a quarter
+// second and handed to a single reader through a triple buffer.
+class AudioAnalyzer {
+    public:
+        static constexpr int WindowSize = 2048;
+        static constexpr int HopSize = WindowSize / 2;
+        static constexpr int Harmonics = 4;
+
+        struct Metrics {
+            // RMS level relative to full scale
+            float loudness = -120.0f;
+
+            // Magnitude-weighted mean frequency
+            float spectralCentroid = 0.0f;
+
+            // Power at multiples of the firing frequency relative to the
+            // total, in dB; harmonics[0] is the firing frequency itself
+            float harmonics[Harmonics] = { -120.0f, -120.0f, -120.0f, -120.0f };
+
+            // Depth of the 20-300 Hz amplitude modulation the ear hears as
+            // roughness, as the envelope's coefficient of variation
+            float roughness = 0.0f;
+
+            long long windows = 0;
+        };
+
+    public:
+        AudioAnalyzer();
+        ~AudioAnalyzer();
+
+        void initialize(float sampleRate);
+        void destroy();
+
+        // Audio thread
+        void process(const float *samples, int n);
+
+        // Any thread; the harmonics are measured against this
+        void setFiringFrequency(float frequency) { m_firingFrequency.store(frequency, std::memory_order_relaxed); }
+
+        // Single reader thread
+        const Metrics &getMetrics();
+
+    protected:
+        void analyzeWindow();
+
+        Fft m_fft;
+        std::complex<float> *m_spectrum;
+        float *m_window;
+        float *m_history;
+        int m_historyFill;
+
+        float m_sampleRate;
+        float m_smoothing;
+        std::atomic<float> m_firingFrequency;
+
+        // Smoothed linear quantities, converted when published
+        double m_power;
+        double m_centroid;
+        double m_harmonicPower[Harmonics];
+        double m_roughness;
+        long long m_windows;
+
+        TripleBuffer<Metrics> m_metrics;
+};
+
+#endif /* ATG_ENGINE_SIM_AUDIO_ANALYZER_H */
@@ -0,0 +1,122 @@
+#ifndef ATG_ENGINE_SIM_BATCH_STEPPER_H
+#define ATG_ENGINE_SIM_BATCH_STEPPER_H
+
+#include <string>
+#include <vector>
+
+class Simulator;
+
+// Advances many simulators in lockstep for physics-only sweeps at steady
+// speed, such as variants of one engine held on the dyno. Every lane holds
+// its own speed and throttle, and each frame advances every lane by the
+// same simulated time: the frame's lanes are spread over the shared
+// JobSystem at physics priority and joined before the next frame starts,
+// so no lane runs ahead of the others.
+//
+// Lanes are any simulators set up for offline stepping without an audio
+// thread, including a SimulationHost's between its rounds. Dyno torque is
+// averaged per lane over the frames after measureStart, cycle figures come
+// from each lane's CycleStatistics at the end, and both are reduced across
+// the lanes once the run is over.
+class BatchStepper {
+    public:
+        struct Parameters {
+            double duration = 3.0;
+            double measureStart = 2.0;
+            double frameLength = 1 / 60.0;
+
+            // Including the calling thread, up to the JobSystem's
+            // concurrency; 0 is all of it
+            int threads = 0;
+        };
+
+        struct Lane {
+            Simulator *simulator = nullptr;
+            double rpm = 0.0;
+            double throttle = 1.0;
+        };
+
+        struct LaneResult {
+            // The speed actually held, after clamping to the engine's range
+            double rpm = 0.0;
+
+            double torque = 0.0;
+            double power = 0.0;
+
+            // Cylinder 0, over the cycles in its history at the end
+            double imep = 0.0;
+            double imepCoefficientOfVariation = 0.0;
+            double peakPressure = 0.0;
+            int cycles = 0;
+
+            long long steps = 0;
+            double simulatedTime = 0.0;
+            bool valid = false;
+        };
+
+        // Over the valid lanes; zero if there aren't any
+        struct Reduction {
+            int lanes = 0;
+            double meanTorque = 0.0;
+            double minTorque = 0.0;
+            double maxTorque = 0.0;
+            double meanPower = 0.0;
+            double maxPower = 0.0;
+            double maxPowerRpm = 0.0;
+            double meanImep = 0.0;
+            double meanImepCoefficientOfVariation = 0.0;
+            double maxPeakPressure = 0.0;
+            long long cycles = 0;
+        };
+
+        struct Result {
+            // Indexed like the lanes
+            std::vector<LaneResult> lanes;
+            Reduction reduction;
+
+            long long frames = 0;
+            long long steps = 0;
+            double wallTime = 0.0;
+        };
+
+    public:
+        BatchStepper();
+        ~BatchStepper();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        // Not owned; returns the lane's index
+        int addLane(Simulator *simulator, double rpm, double throttle);
+        int getLaneCount() const { return static_cast<int>(m_lanes.size()); }
+        const Lane &getLane(int lane) const { return m_lanes[lane]; }
+
+        int getThreadCount() const { return m_threads; }
+
+        Result run();
+
+        static Reduction Reduce(const std::vector<LaneResult> &lanes);
+
+        // Columns: lane, rpm, torque_nm, power_kw, imep_kpa, imep_cov,
+        // peak_pressure_kpa, cycles; invalid lanes are left out
+        static bool WriteCsv(const std::string &path, const Result &result);
+
+    protected:
+        struct LaneState {
+            double speed = 0.0;
+            double torque = 0.0;
+            int samples = 0;
+            long long steps = 0;
+        };
+
+        void hold(const Lane &lane, LaneState *state) const;
+        void advance(const Lane &lane, LaneState *state, bool measure) const;
+        LaneResult finish(const Lane &lane, const LaneState &state) const;
+
+        Parameters m_parameters;
+        int m_threads;
+
+        std::vector<Lane> m_lanes;
+};
+
+#endif /* ATG_ENGINE_SIM_BATCH_STEPPER_H */
@@ -8,6 +8,10 @@
 
 #include <cmath>
 
+#if !defined(_MSC_VER) && !defined(__forceinline)
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
 template <typename T_Real>
 class ButterworthLowPassFilter : public Filter {
 public:
@@ -53,6 +57,55 @@ public:
         return y;
     }
 
+    // Same recurrence as fast_f() with the history held in locals for the
+    // whole block; input and output may alias.
+    void fast_f(const T_Real *input, T_Real *output, int n) {
+        if (n <= 0) return;
+
+        T_Real y_prev[4] = {
+            m_y.read(3),
+            m_y.read(2),
+            m_y.read(1),
+            m_y.read(0)
+        };
+
+        T_Real x_prev[4] = {
+            m_x.read(3),
+            m_x.read(2),
+            m_x.read(1),
+            m_x.read(0)
+        };
+
+        const T_Real gain = m_f_4 / m_a[0];
+        for (int i = 0; i < n; ++i) {
+            const T_Real sample = input[i];
+
+            T_Real const n_i = gain * (sample + 4 * x_prev[0] + 6 * x_prev[1] + 4 * x_prev[2] + x_prev[3]);
+            T_Real const d = -m_a[1] * y_prev[0] - m_a[2] * y_prev[1] - m_a[3] * y_prev[2] - m_a[4] * y_prev[3];
+            T_Real const y = n_i + d;
+
+            x_prev[3] = x_prev[2];
+            x_prev[2] = x_prev[1];
+            x_prev[1] = x_prev[0];
+            x_prev[0] = sample;
+
+            y_prev[3] = y_prev[2];
+            y_prev[2] = y_prev[1];
+            y_prev[1] = y_prev[0];
+            y_prev[0] = y;
+
+            output[i] = y;
+        }
+
+        for (int i = 3; i >= 0; --i) {
+            m_x.removeBeginning(1);
+            m_x.write(x_prev[i]);
+
+            m_y.removeBeginning(1);
+            m_y.write(y_prev[i]);
+        }
+    }
+
     inline void setCutoffFrequency(T_Real f_c, T_Real sampleRate) {
         const T_Real f = std::tan(static_cast<T_Real>(constants::pi) * f_c / sampleRate);
         const T_Real f_2 = f * f;
@@ -70,9 +123,12 @@ public:
         m_f_4 = f_4;
     }
 
+    inline T_Real getGain() const { return m_f_4 / m_a[0]; }
+    inline T_Real getCoefficient(int i) const { return m_a[i]; }
+
 protected:
-    RingBuffer<T_Real> m_y;
-    RingBuffer<T_Real> m_x;
+    RingBuffer<T_Real, true> m_y;
+    RingBuffer<T_Real, true> m_x;
     T_Real m_a[5];
     T_Real m_f_4;
 };
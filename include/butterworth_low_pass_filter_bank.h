@@ -0,0 +1,46 @@
+#ifndef ATG_ENGINE_SIM_BUTTERWORTH_LOW_PASS_FILTER_BANK_H
+#define ATG_ENGINE_SIM_BUTTERWORTH_LOW_PASS_FILTER_BANK_H
+
+// ButterworthLowPassFilter<float> run over several channels with the same
+// cutoff, e.g. the air noise of every exhaust. Channels are grouped Lanes at a
+// time, the last group padded with silent lanes, and each group's history is
+// held lane-interleaved so one sample step of the recurrence is a handful of
+// Lanes-wide multiply-adds instead of Lanes scalar filters. Channel i gives
+// the same output as its own ButterworthLowPassFilter<float>.
+class ButterworthLowPassFilterBank {
+    public:
+        // One 128-bit vector of floats, SSE and NEON alike
+        static constexpr int Lanes = 4;
+
+    public:
+        ButterworthLowPassFilterBank();
+        ~ButterworthLowPassFilterBank();
+
+        void initialize(int channels);
+        void destroy();
+
+        void setCutoffFrequency(float f_c, float sampleRate);
+
+        // n samples of every channel, planar; input and output may alias
+        void process(const float *const *input, float *const *output, int n);
+
+        // One sample of one channel, for the per-sample renderer
+        float process(int channel, float sample);
+
+        int getChannelCount() const { return m_channelCount; }
+
+    protected:
+        struct alignas(16) Group {
+            float x[4][Lanes];
+            float y[4][Lanes];
+        };
+
+        Group *m_groups;
+        int m_groupCount;
+        int m_channelCount;
+
+        float m_gain;
+        float m_a[5];
+};
+
+#endif /* ATG_ENGINE_SIM_BUTTERWORTH_LOW_PASS_FILTER_BANK_H */
@@ -6,9 +6,20 @@
 #include "function.h"
 #include "units.h"
 
+#include <memory>
+
 class Crankshaft;
 class Camshaft : public Part {
     public:
+        // A baked lobe table and the profile revision it was baked from;
+        // camshafts with the same profile can point at one table, which is
+        // never written while shared
+        struct BakedLobe {
+            std::shared_ptr<double[]> samples;
+            const Function *profile = nullptr;
+            unsigned int revision = 0;
+        };
+
         struct Parameters {
             // Number of lobes
             int lobes;
@@ -24,8 +35,18 @@ class Camshaft : public Part {
 
             // Base radius
             double baseRadius = units::distance(600, units::thou);
+
+            // Look the lobe up in a uniformly resampled table
+            bool bakeLobe = true;
+
+            // Used instead of baking a table of its own when it was baked
+            // from lobeProfile at its current revision
+            BakedLobe sharedLobe;
         };
 
+        // Power of two so the lookup wraps with a mask
+        static constexpr int BakedLobeSamples = 4096;
+
     public:
         Camshaft();
         virtual ~Camshaft();
@@ -36,6 +57,20 @@ class Camshaft : public Part {
         double valveLift(int lobe) const;
         double sampleLobe(double theta) const;
 
+        // Resamples the lobe profile; valveLift() falls back to
+        // sampleLobe() while the table is disabled or older than the profile
+        void bakeLobeProfile();
+        void setBakedLobe(bool baked);
+        bool isLobeBaked() const;
+        double sampleBakedLobe(double theta) const;
+
+        // Empty until baked
+        BakedLobe getBakedLobe() const;
+
+        // Points at another camshaft's table for the same profile instead
+        // of this one's; false, changing nothing, if it doesn't match
+        bool shareBakedLobe(const BakedLobe &lobe);
+
         void setLobeCenterline(int lobe, double crankAngle) { m_lobeAngles[lobe] = crankAngle / 2; }
         double getLobeCenterline(int lobe) const { return m_lobeAngles[lobe]; }
 
@@ -43,12 +78,22 @@ class Camshaft : public Part {
 
         Function *getLobeProfile() const { return m_lobeProfile; }
         double getAdvance() const { return m_advance; }
+        void setAdvance(double advance) { m_advance = advance; }
         double getBaseRadius() const { return m_baseRadius; }
+        int getLobeCount() const { return m_lobes; }
+        Crankshaft *getCrankshaft() const { return m_crankshaft; }
+        bool isLobeBakeEnabled() const { return m_useBakedLobe; }
 
     private:
         Crankshaft *m_crankshaft;
         Function *m_lobeProfile;
         double *m_lobeAngles;
+
+        std::shared_ptr<double[]> m_bakedTable;
+        double *m_bakedLobe;
+        const Function *m_bakedProfile;
+        unsigned int m_bakedRevision;
+        bool m_useBakedLobe;
         double m_advance;
         double m_baseRadius;
         int m_lobes;
@@ -0,0 +1,55 @@
+#ifndef ATG_ENGINE_SIM_CHAMBER_FORCE_BATCH_H
+#define ATG_ENGINE_SIM_CHAMBER_FORCE_BATCH_H
+
+#include "scs.h"
+
+class CombustionChamber;
+
+// The gas and skirt friction forces of every piston, applied by a single
+// force generator in place of one CombustionChamber::apply() per cylinder.
+// Bore areas, bank directions, friction coefficients and body indices are
+// gathered once when the chambers are set; each pass only gathers the
+// pressure differentials, wall forces and piston velocities, evaluates
+// every force in one vector loop down the streams and scatters the results
+// back. The forces are the same as the chambers' own.
+class ChamberForceBatch : public atg_scs::ForceGenerator {
+    public:
+        ChamberForceBatch();
+        virtual ~ChamberForceBatch();
+
+        void initialize(int cylinderCount);
+        void destroy();
+
+        // Call once the piston is registered with the rigid body system, so
+        // its body index is final
+        void setChamber(int cylinder, CombustionChamber *chamber);
+
+        int getCylinderCount() const { return m_cylinderCount; }
+
+        virtual void apply(atg_scs::SystemState *system) override;
+
+    protected:
+        CombustionChamber **m_chambers;
+        int *m_bodies;
+        double *m_buffer;
+
+        // Constant per cylinder
+        double *m_area;
+        double *m_dx;
+        double *m_dy;
+        double *m_frictionCoeff;
+        double *m_breakawayFriction;
+        double *m_breakawayVelocity;
+        double *m_coulombVelocity;
+        double *m_viscousCoeff;
+
+        // Gathered each pass, then the force along the bore
+        double *m_pressureDifferential;
+        double *m_wallForce;
+        double *m_v_s;
+        double *m_force;
+
+        int m_cylinderCount;
+};
+
+#endif /* ATG_ENGINE_SIM_CHAMBER_FORCE_BATCH_H */
@@ -0,0 +1,88 @@
+#ifndef ATG_ENGINE_SIM_CHAMBER_ZONES_H
+#define ATG_ENGINE_SIM_CHAMBER_ZONES_H
+
+// Splits the single-zone charge of every chamber into unburned, burned and
+// crevice zones once per step. The lanes are the engine's cylinders in
+// structure-of-arrays form, as in FlowRateBatch, so the update is one
+// branch-free loop the compiler vectorizes rather than a zone object per
+// chamber.
+//
+// The unburned zone is compressed isentropically from the charge at
+// ignition and the burned zone holds the rest of the charge's energy. The
+// crevice zone is gas at wall temperature that the flame can't reach. The
+// end gas accumulates the Livengood-Wu integral over the Douaud-Eyzat
+// ignition delay; once it reaches 1 before the flame is done, the lane is
+// knocking.
+class ChamberZones {
+    friend class SimulationCheckpoint;
+
+    public:
+        struct Parameters {
+            int chambers = 0;
+
+            // Per chamber, in the crevices of the piston and head gasket
+            double creviceVolume = 0.0;
+            double wallTemperature = 0.0;
+            double octaneNumber = 95.0;
+        };
+
+    public:
+        ChamberZones();
+        ~ChamberZones();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        // Single-zone state of one chamber at the end of a step; the burned
+        // fraction is of the charge lit at ignition
+        void setCharge(
+            int i,
+            double pressure,
+            double temperature,
+            double volume,
+            double heatCapacityRatio,
+            double burnedFraction,
+            bool lit);
+
+        void evaluate(double dt);
+
+        double getUnburnedTemperature(int i) const { return m_T_u[i]; }
+        double getBurnedTemperature(int i) const { return m_T_b[i]; }
+        double getKnockIntegral(int i) const { return m_knockIntegral[i]; }
+
+        // Share of the charge held in the crevices at the current pressure
+        double getCreviceFraction(int i) const { return m_creviceFraction[i]; }
+
+        // Set on the step the integral crosses 1 and cleared by the next
+        // evaluate(); the value is the unburned fraction left at onset
+        double getKnockIntensity(int i) const { return m_knockIntensity[i]; }
+
+        int getChamberCount() const { return m_parameters.chambers; }
+        long long getKnockCount() const { return m_knockCount; }
+
+    protected:
+        Parameters m_parameters;
+
+        double *m_buffer;
+
+        // Inputs
+        double *m_pressure;
+        double *m_temperature;
+        double *m_volume;
+        double *m_exponent;
+        double *m_burnedFraction;
+        double *m_lit;
+
+        // Zone state
+        double *m_T_u;
+        double *m_P_u;
+        double *m_T_b;
+        double *m_creviceFraction;
+        double *m_knockIntegral;
+        double *m_knockIntensity;
+
+        double m_delayScale;
+        long long m_knockCount;
+};
+
+#endif /* ATG_ENGINE_SIM_CHAMBER_ZONES_H */
@@ -5,13 +5,24 @@
 
 #include "piston.h"
 #include "gas_system.h"
+#include "pipe_segments.h"
 #include "cylinder_head.h"
 #include "units.h"
 #include "fuel.h"
 
+#include "random_stream.h"
+
 class Engine;
 class CombustionChamber : public atg_scs::ForceGenerator {
+    friend class SimulationCheckpoint;
+
     public:
+        static constexpr double WallTemperature = units::celcius(90.0);
+
+        // Shape of the Wiebe burn curve, the usual spark ignition a = 5, m = 2
+        static constexpr double WiebeEfficiency = 5.0;
+        static constexpr double WiebeForm = 2.0;
+
         struct Parameters {
             Piston *PistonPtr;
             CylinderHead *Head;
@@ -23,6 +34,23 @@ class CombustionChamber : public atg_scs::ForceGenerator {
             double CrankcasePressure;
         };
 
+        enum class BurnModel {
+            // Flame front advanced through the bore every substep
+            FlameFront,
+
+            // Wiebe burn curve timed once at ignition from the flame speed
+            Wiebe
+        };
+
+        enum class HeatTransferModel {
+            // Fixed coefficient to the wall
+            Constant,
+
+            // Woschni correlation from the cylinder pressure, temperature
+            // and mean piston speed
+            Woschni
+        };
+
         struct FlameEvent {
             double lit_n = 0;
             double total_n = 0;
@@ -34,6 +62,10 @@ class CombustionChamber : public atg_scs::ForceGenerator {
             double travel_x = 0.0;
             double travel_y = 0.0;
             GasSystem::Mix globalMix;
+
+            double burnDuration = 0.0;
+            double burnTime = 0.0;
+            double burnedFraction = 0.0;
         };
 
         struct FrictionModelParams {
@@ -43,77 +75,251 @@ class CombustionChamber : public atg_scs::ForceGenerator {
             double viscousFrictionCoefficient = units::force(20, units::N);
         };
 
+        // Everything a fluid substep reads or writes, so it stays within one
+        // contiguous block instead of following the head, bank, piston,
+        // intake and exhaust pointers. The engine keeps the blocks of all of
+        // its chambers in one array; the geometry is cached by
+        // updateGeometry() and the valve state by update().
+        struct alignas(64) FluidState {
+            GasSystem system;
+            GasSystem intakeRunnerAndManifold;
+            GasSystem exhaustRunnerAndPrimary;
+
+            GasSystem *plenum = nullptr;
+            GasSystem *collector = nullptr;
+
+            // Set when the manifold runner or the primary is resolved into
+            // segments instead of being lumped into the runner volume
+            PipeSegments *intakePipe = nullptr;
+            PipeSegments *exhaustPipe = nullptr;
+
+            double plenumCrossSectionArea = 0;
+            double intakeRunnerCrossSectionArea = 0;
+            double exhaustRunnerCrossSectionArea = 0;
+            double collectorCrossSectionArea = 0;
+            double cylinderCrossSectionSurfaceArea = 0;
+            double bore = 0;
+            double boreSurfaceArea = 0;
+            double intakeVelocityDecay = 0;
+            double exhaustVelocityDecay = 0;
+            double manifoldToRunnerFlowRate = 0;
+            double primaryToCollectorFlowRate = 0;
+            double blowbyK = 0;
+            double crankcasePressure = 0;
+
+            // Cylinder geometry and wall heat transfer for the current step,
+            // shared by all of its substeps; the valve side cross section
+            // and the wall conductance are derived once by update()
+            double volume = 0;
+            double volumeRate = 0;
+            double wallArea = 0;
+            double heatTransferCoefficient = 0;
+            double cylinderFlowArea = 0;
+            double wallHeatConductance = 0;
+            HeatTransferModel heatTransferModel = HeatTransferModel::Constant;
+
+            double intakeFlowRate = 0;
+            double exhaustFlowRate = 0;
+
+            double intakeFlow = 0;
+            double exhaustFlow = 0;
+
+            // Substeps a runner's plenum or collector flow is gathered over
+            // while its valve is closed, and the time gathered so far
+            int runnerCoarsening = 1;
+            int pendingIntakeRunnerSubsteps = 0;
+            int pendingExhaustRunnerSubsteps = 0;
+            double pendingIntakeRunnerTime = 0;
+            double pendingExhaustRunnerTime = 0;
+
+            double lastTimestepTotalIntakeFlow = 0;
+            double lastTimestepTotalExhaustFlow = 0;
+
+            double peakTemperature = 0;
+            double nBurntFuel = 0;
+
+            // Set by the engine's ChamberZones when it has them: the share
+            // of the charge the flame can't reach, and the unburned share
+            // that autoignited this cycle
+            double creviceFraction = 0;
+            double knockIntensity = 0;
+
+            FlameEvent flameEvent;
+            BurnModel burnModel = BurnModel::FlameFront;
+            bool lit = false;
+        };
+
     public:
         CombustionChamber();
         virtual ~CombustionChamber();
 
         void initialize(const Parameters &params);
         void destroy();
+
+        // Rebuilds the cylinder, runner and primary volumes from the head,
+        // intake and exhaust; only valid before the simulation starts
+        void updateGeometry();
         void setEngine(Engine *engine) { m_engine = engine; }
+        void setFluidState(FluidState *state) { m_fluid = state; }
+        FluidState *getFluidState() { return m_fluid; }
         virtual void apply(atg_scs::SystemState *system);
 
+        // Gas and skirt friction force along the bore for a given piston
+        // speed, positive towards the head
+        double calculatePistonForce(double v_s) const;
+
+        // Pressure differential across the piston the force is taken from,
+        // latched or live
+        double getPistonPressureDifferential() const {
+            return m_forcePressureLatched
+                ? m_forcePressure
+                : m_fluid->system.pressure() - m_fluid->crankcasePressure;
+        }
+
+        // Averages the pressure differential over the samples taken since
+        // the last latch and uses it for the piston force until the next, in
+        // place of the live pressure; see MultirateScheduler. Without any
+        // samples the force keeps what it had.
+        void sampleForcePressure();
+        void latchForcePressure();
+        void releaseForcePressure();
+
         CylinderHead *getCylinderHead() const { return m_head; }
         Piston *getPiston() const { return m_piston; }
 
         double getFrictionForce() const;
+        double getCrankcasePressure() const { return m_fluid->crankcasePressure; }
+        double getIntakeValveLift() const { return m_intakeValveLift; }
+        double getExhaustValveLift() const { return m_exhaustValveLift; }
         double getVolume() const;
         double pistonSpeed() const;
         double calculateMeanPistonSpeed() const;
         double calculateFiringPressure() const;
 
-        bool isLit() const { return m_lit; }
+        void setBurnModel(BurnModel model) { m_fluid->burnModel = model; }
+        BurnModel getBurnModel() const { return m_fluid->burnModel; }
+
+        // Burned fraction 1 - exp(-a * s^(m + 1)) normalized to reach 1 at
+        // the end of the burn, s = 1
+        static double wiebeBurnFraction(double s);
+
+        void setHeatTransferModel(HeatTransferModel model) { m_fluid->heatTransferModel = model; }
+        HeatTransferModel getHeatTransferModel() const { return m_fluid->heatTransferModel; }
+        double getHeatTransferCoefficient() const { return m_fluid->heatTransferCoefficient; }
+        double getVolumeRate() const { return m_fluid->volumeRate; }
+
+        bool isLit() const { return m_fluid->lit; }
         bool popLitLastFrame();
 
         void ignite();
+
+        // Burns the rest of the charge at once, as end gas would on knock
+        void autoignite(double intensity);
+        void setCreviceFraction(double fraction) { m_fluid->creviceFraction = fraction; }
+        double getKnockIntensity() const { return m_fluid->knockIntensity; }
+
         void update(double dt);
-        void flow(double dt);
+
+        // A fluid substep is the engine's FlowGraph intake stage, then
+        // flowCylinder(), the exhaust stage and finishFlow(); the graph's
+        // stages touch the shared plenum/collector, these only this
+        // chamber's state.
+        void flowCylinder(double dt);
+        void finishFlow(double dt);
+
+        // flowCylinder() with the valve flow rates supplied by the caller so
+        // they can be evaluated for every chamber at once.
+        void prepareIntakeValveFlow(double dt, GasSystem::FlowState *intakeValve);
+        void applyIntakeValveFlow(
+            const GasSystem::FlowState &intakeValve,
+            double flowRate,
+            GasSystem::FlowState *exhaustValve);
+        void applyExhaustValveFlow(const GasSystem::FlowState &exhaustValve, double flowRate);
+
+        // flowCylinder() with both valves shut for the step: nothing crosses
+        // either valve, so only heat loss and blowby are left to apply
+        inline bool isSealed() const {
+            return m_fluid->intakeFlowRate == 0 && m_fluid->exhaustFlowRate == 0;
+        }
+
+        void flowSealedCylinder(double dt);
+
+        // Runs the runner to plenum and primary to collector flows of a
+        // closed valve once every that many substeps over their combined
+        // time; 1 runs them every substep
+        void setRunnerCoarsening(int substeps) { m_fluid->runnerCoarsening = substeps; }
+        int getRunnerCoarsening() const { return m_fluid->runnerCoarsening; }
 
         double lastEventAfr() const;
 
-        double getLastIterationExhaustFlow() const { return m_exhaustFlow; }
+        // Shortest time for a pressure signal to cross either runner at the
+        // current sound speed and bulk velocity
+        double calculateRunnerSignalTime() const;
 
-        void resetLastTimestepExhaustFlow() { m_lastTimestepTotalExhaustFlow = 0; }
-        double getLastTimestepExhaustFlow() const { return m_lastTimestepTotalExhaustFlow; }
+        void seedRandom(uint64_t seed);
 
-        void resetLastTimestepIntakeFlow() { m_lastTimestepTotalIntakeFlow = 0; }
-        double getLastTimestepIntakeFlow() const { return m_lastTimestepTotalIntakeFlow; }
+        // Largest fraction of a connected volume's gas that crossed a valve
+        // during the last timestep
+        double calculateLastTimestepFlowFraction() const;
 
-        Function *m_meanPistonSpeedToTurbulence;
-        GasSystem m_system;
-        GasSystem m_intakeRunnerAndManifold;
-        GasSystem m_exhaustRunnerAndPrimary;
-        FlameEvent m_flameEvent;
-        bool m_lit;
+        double getLastIterationExhaustFlow() const { return m_fluid->exhaustFlow; }
 
-        FrictionModelParams m_frictionModel;
+        void resetLastTimestepExhaustFlow() { m_fluid->lastTimestepTotalExhaustFlow = 0; }
+        double getLastTimestepExhaustFlow() const { return m_fluid->lastTimestepTotalExhaustFlow; }
+
+        void resetLastTimestepIntakeFlow() { m_fluid->lastTimestepTotalIntakeFlow = 0; }
+        double getLastTimestepIntakeFlow() const { return m_fluid->lastTimestepTotalIntakeFlow; }
+
+        inline GasSystem *getSystem() { return &m_fluid->system; }
+        inline const GasSystem *getSystem() const { return &m_fluid->system; }
+        inline GasSystem *getIntakeRunner() { return &m_fluid->intakeRunnerAndManifold; }
+        inline GasSystem *getExhaustRunner() { return &m_fluid->exhaustRunnerAndPrimary; }
+        inline const PipeSegments &getIntakePipe() const { return m_intakePipe; }
+        inline const PipeSegments &getExhaustPipe() const { return m_exhaustPipe; }
+        inline const FlameEvent &getFlameEvent() const { return m_fluid->flameEvent; }
 
-        double m_peakTemperature;
-        double m_nBurntFuel;
+        Function *m_meanPistonSpeedToTurbulence;
+        FrictionModelParams m_frictionModel;
 
     protected:
         double calculateFrictionForce(double v) const;
         void updateCycleStates();
+        void updateHeatTransfer();
+        void exchangeHeat(double dt);
+        void burnFlameFront(double dt, double volume);
+        void burnWiebe(double dt);
+        void burn(double n);
 
-        double m_intakeFlowRate;
-        double m_exhaustFlowRate;
-
-        double m_manifoldToRunnerFlowRate;
-        double m_primaryToCollectorFlowRate;
-        double m_cylinderCrossSectionSurfaceArea;
-        double m_cylinderWidthApproximation;
+        FluidState *m_fluid;
 
-        double m_lastTimestepTotalExhaustFlow;
-        double m_lastTimestepTotalIntakeFlow;
-        double m_exhaustFlow;
+        // Valve lifts for the current step, for the UI; their flow rates are
+        // in the fluid state
+        double m_intakeValveLift;
+        double m_exhaustValveLift;
 
-        double m_crankcasePressure;
+        double m_cylinderWidthApproximation;
 
         double *m_pressure;
         double *m_pistonSpeed;
         static constexpr int StateSamples = 256;
 
+        // Kept up to date by updateCycleStates() so the queries are O(1)
+        double m_pistonSpeedSum;
+        double m_peakPressure;
+        int m_peakPressureIndex;
+
         bool m_litLastFrame;
 
+        double m_forcePressureSum;
+        int m_forcePressureSamples;
+        double m_forcePressure;
+        bool m_forcePressureLatched;
+
+        RandomStream m_random;
+
+        PipeSegments m_intakePipe;
+        PipeSegments m_exhaustPipe;
+
         Piston *m_piston;
         CylinderHead *m_head;
         Engine *m_engine;
@@ -13,6 +13,7 @@ class CombustionChamberObject : public SimulationObject {
 
         virtual void generateGeometry();
         virtual void render(const ViewParameters *view);
+        virtual bool getWorldBounds(Bounds *bounds) const;
         virtual void process(float dt);
         virtual void destroy();
 
@@ -11,8 +11,9 @@ class ConnectingRodObject : public SimulationObject {
         ConnectingRodObject();
         virtual ~ConnectingRodObject();
 
-        virtual void generateGeometry();
+        virtual void generateStaticGeometry();
         virtual void render(const ViewParameters *view);
+        virtual bool getWorldBounds(Bounds *bounds) const;
         virtual void process(float dt);
         virtual void destroy();
 
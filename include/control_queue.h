@@ -0,0 +1,110 @@
+#ifndef ATG_ENGINE_SIM_CONTROL_QUEUE_H
+#define ATG_ENGINE_SIM_CONTROL_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+// Wait-free FIFO of timestamped control changes from one producer thread
+// (input handling) to the simulator, which applies each one at the step of
+// its frame matching the event's time. Events must be pushed in time order.
+class ControlQueue {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr size_t Capacity = 1024;
+
+    enum class Control {
+        Throttle,
+        Clutch,
+        Starter,
+        Ignition,
+        Gear,
+        DynoEnabled,
+        DynoHold,
+        DynoSpeed
+    };
+
+    static constexpr int ControlCount = static_cast<int>(Control::DynoSpeed) + 1;
+
+    struct Event {
+        Control control = Control::Throttle;
+        double value = 0.0;
+        Clock::time_point time;
+
+        // Applied at the next step whatever its time
+        bool immediate = false;
+
+        // Carries the LatencyProbe's tag; see LatencyProbe::begin()
+        bool probe = false;
+
+        // Seconds; when positive the simulator glides the control to value
+        // with this time constant, a little every step, instead of setting
+        // it at once
+        double smoothing = 0.0;
+    };
+
+public:
+    ControlQueue() {
+        m_readIndex = 0;
+        m_writeIndex = 0;
+        m_droppedCount = 0;
+    }
+
+    ~ControlQueue() {
+        /* void */
+    }
+
+    // Producer side; returns false and drops the event when the simulator
+    // has fallen a full queue behind
+    bool push(const Event &event) {
+        const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        if (writeIndex - m_readIndex.load(std::memory_order_acquire) >= Capacity) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_events[writeIndex % Capacity] = event;
+        m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool push(Control control, double value, bool immediate = false) {
+        Event event;
+        event.control = control;
+        event.value = value;
+        event.time = Clock::now();
+        event.immediate = immediate;
+
+        return push(event);
+    }
+
+    // Consumer side; the oldest event or nullptr, valid until pop()
+    const Event *peek() const {
+        const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+        if (readIndex == m_writeIndex.load(std::memory_order_acquire)) return nullptr;
+
+        return &m_events[readIndex % Capacity];
+    }
+
+    void pop() {
+        m_readIndex.store(m_readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t size() const {
+        return m_writeIndex.load(std::memory_order_acquire) - m_readIndex.load(std::memory_order_acquire);
+    }
+
+    unsigned long long getDroppedCount() const {
+        return m_droppedCount.load(std::memory_order_relaxed);
+    }
+
+protected:
+    Event m_events[Capacity];
+    std::atomic<size_t> m_readIndex;
+    std::atomic<size_t> m_writeIndex;
+    std::atomic<unsigned long long> m_droppedCount;
+};
+
+#endif /* ATG_ENGINE_SIM_CONTROL_QUEUE_H */
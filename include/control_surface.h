@@ -0,0 +1,162 @@
+#ifndef ATG_ENGINE_SIM_CONTROL_SURFACE_H
+#define ATG_ENGINE_SIM_CONTROL_SURFACE_H
+
+#include "control_queue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Hardware controllers as a second control source next to the keyboard.
+// A listener thread of its own waits on a raw MIDI device (a byte stream,
+// such as an ALSA /dev/snd/midiC1D0 node) and an OSC port over UDP, maps
+// each message through the bindings and pushes it, stamped with the time it
+// arrived, onto a ControlQueue the simulator drains alongside its own. A
+// message reaches the physics within a frame of the physics thread rather
+// than waiting for the next video frame and processEngineInput(). Each
+// binding's smoothing is carried on its events and applied by the simulator
+// every physics step, so 7-bit controller steps glide instead of stepping.
+class ControlSurface {
+    public:
+        enum class Source {
+            MidiControlChange,
+            MidiNote,
+            MidiPitchBend,
+            Osc
+        };
+
+        // One controller message, its value scaled to 0..1
+        struct Message {
+            Source source = Source::Osc;
+
+            // MIDI channel 0-15 and controller or note number
+            int channel = 0;
+            int number = 0;
+
+            std::string address;
+            double value = 0.0;
+        };
+
+        struct Binding {
+            Source source = Source::MidiControlChange;
+
+            // -1 matches any channel
+            int channel = -1;
+            int number = 0;
+            std::string address;
+
+            ControlQueue::Control control = ControlQueue::Control::Throttle;
+
+            // What 0 and 1 map to, in the control's own units
+            double minimum = 0.0;
+            double maximum = 1.0;
+
+            // Seconds; the time constant the simulator glides the control
+            // to each new value with, 0 to jump
+            double smoothing = 0.0;
+
+            // Each press, a rise through 0.5, flips the control between
+            // minimum and maximum instead of following the value
+            bool toggle = false;
+        };
+
+        struct Parameters {
+            // Empty and -1 leave that transport closed
+            std::string midiDevice;
+            int oscPort = -1;
+
+            std::vector<Binding> bindings = DefaultBindings();
+        };
+
+        struct Statistics {
+            unsigned long long messages = 0;
+
+            // Parsed but matching no binding
+            unsigned long long unmapped = 0;
+
+            // Malformed OSC packets
+            unsigned long long rejected = 0;
+        };
+
+        // Raw MIDI byte stream to messages, with running status; system
+        // messages and SysEx are skipped
+        class MidiParser {
+            public:
+                // True when byte completes a message
+                bool feed(uint8_t byte, Message *message);
+
+            protected:
+                uint8_t m_status = 0;
+                uint8_t m_data[2] = { 0, 0 };
+                int m_count = 0;
+                bool m_sysex = false;
+        };
+
+    public:
+        ControlSurface();
+        ~ControlSurface();
+
+        // False if a requested transport couldn't be opened, in which case
+        // nothing is left running
+        bool initialize(const Parameters &params);
+        void destroy();
+
+        bool isRunning() const { return m_thread != nullptr; }
+        int getOscPort() const { return m_oscPort; }
+
+        // For Simulator::setControlSource(); its only producer is the
+        // listener thread
+        ControlQueue *getQueue() { return &m_queue; }
+
+        // Whether the controller has moved control since release(); the
+        // keyboard path leaves owned controls alone, and releases one when
+        // the user takes it back with a key
+        bool owns(ControlQueue::Control control) const;
+        void release(ControlQueue::Control control);
+
+        Statistics getStatistics() const;
+
+        // Mapped to the binding's control and pushed; false if no binding
+        // matches. Called by the listener thread, or directly for testing.
+        bool dispatch(const Message &message, ControlQueue::Clock::time_point time);
+
+        // Every message of an OSC packet or bundle whose first argument is
+        // a float, double, int or boolean; false if malformed
+        static bool ParseOsc(const char *data, size_t size, std::vector<Message> *messages);
+
+        // CC 1 throttle, CC 2 clutch pedal, CC 3 dyno speed, notes 36-39
+        // starter, ignition, dyno and hold, and the same under /engine/ over
+        // OSC
+        static std::vector<Binding> DefaultBindings();
+
+    protected:
+        void worker();
+        bool openMidi(const std::string &device);
+        bool openOsc(int port);
+        void closeTransports();
+
+        Parameters m_parameters;
+        ControlQueue m_queue;
+
+        // Per binding, for toggles
+        std::vector<double> m_lastValues;
+        std::vector<bool> m_toggleStates;
+
+        MidiParser m_midiParser;
+        intptr_t m_midi;
+        intptr_t m_osc;
+        int m_oscPort;
+
+        std::thread *m_thread;
+        std::atomic<bool> m_run;
+        std::atomic<uint32_t> m_owned;
+
+        std::atomic<unsigned long long> m_messages;
+        std::atomic<unsigned long long> m_unmapped;
+        std::atomic<unsigned long long> m_rejected;
+};
+
+#endif /* ATG_ENGINE_SIM_CONTROL_SURFACE_H */
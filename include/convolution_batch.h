@@ -0,0 +1,69 @@
+#ifndef ATG_ENGINE_SIM_CONVOLUTION_BATCH_H
+#define ATG_ENGINE_SIM_CONVOLUTION_BATCH_H
+
+#include "partitioned_convolution.h"
+
+#include <complex>
+
+// Runs one impulse response over many independent signals in lockstep, such
+// as the instances of one definition on a server. It takes the layout and
+// the shared spectra of a prototype PartitionedConvolution; what each
+// instance owns is packed contiguously in instance order, so a block's
+// multiply-accumulate walks every instance against one partition while
+// that partition is still in cache.
+//
+// Each instance's output matches a PartitionedConvolution initialized from
+// the same prototype exactly. A deferred tail runs on the calling thread.
+class ConvolutionBatch {
+    public:
+        ConvolutionBatch();
+        ~ConvolutionBatch();
+
+        void initialize(const PartitionedConvolution &prototype, int instances);
+        void destroy();
+
+        // input[i] and output[i] hold n samples of instance i and may be the
+        // same buffer; with only one instance there is nothing to share and
+        // a PartitionedConvolution is the better fit
+        void process(const float *const *input, float *const *output, int n);
+
+        // See PartitionedConvolution::setActiveFraction(); applies to every
+        // instance
+        void setActiveFraction(float fraction) { m_prototype.setActiveFraction(fraction); }
+
+        int getInstanceCount() const { return m_instanceCount; }
+        bool isInitialized() const { return m_instanceCount > 0; }
+
+    protected:
+        struct BatchStage {
+            const PartitionedConvolution::Stage *prototype = nullptr;
+            int position = 0;
+            int newest = 0;
+
+            // [partition][instance][2 * blockSize]
+            std::complex<float> *history = nullptr;
+
+            // [instance][2 * blockSize]
+            std::complex<float> *work = nullptr;
+            float *input = nullptr;
+
+            // [instance][blockSize]; a deferred stage computes into pending
+            // and swaps it in a block later
+            float *output = nullptr;
+            float *pending = nullptr;
+        };
+
+        void advance(BatchStage *stage);
+
+        // Holds the head taps, the transforms and a reference to the spectra
+        PartitionedConvolution m_prototype;
+
+        // [instance][2 * headSize], sharing one offset
+        float *m_headHistory;
+        int m_headOffset;
+
+        BatchStage m_stages[2];
+        int m_instanceCount;
+};
+
+#endif /* ATG_ENGINE_SIM_CONVOLUTION_BATCH_H */
@@ -3,24 +3,72 @@
 
 #include "filter.h"
 
+#include "partitioned_convolution.h"
+
+#include <memory>
+
 class ConvolutionFilter : public Filter {
+    public:
+        static constexpr int DefaultHeadSize = 64;
+        static constexpr int DefaultTailSize = 1024;
+
     public:
         ConvolutionFilter();
         virtual ~ConvolutionFilter();
 
         void initialize(int samples);
+
+        // Shares the taps of a prepared filter, and its partitions when
+        // partitioned is set, without transforming them again unless the
+        // prototype's tail was laid out for a different worker. Only the
+        // convolution history is this filter's own.
+        void initialize(
+            const ConvolutionFilter &prototype,
+            bool partitioned,
+            ConvolutionWorker *worker = nullptr);
         virtual float f(float sample) override;
         virtual void destroy() override;
 
+        // input and output may alias
+        void f_block(const float *input, float *output, int n);
+
         int getSampleCount() const { return m_sampleCount; }
+
+        // Writable only after initialize(samples), before the taps are
+        // shared with another filter
         float *getImpulseResponse() { return m_impulseResponse; }
+        const float *getImpulseResponse() const { return m_impulseResponse; }
+        bool hasSameResponse(const ConvolutionFilter &other) const;
+
+        // Switches f() to FFT partitioned convolution of the current impulse
+        // response; call again after editing it. Any direct-form history is
+        // released. A worker defers the tail stage to it, see
+        // PartitionedConvolution.
+        void preparePartitioned(
+            int headSize = DefaultHeadSize,
+            int tailSize = DefaultTailSize,
+            ConvolutionWorker *worker = nullptr);
+        bool isPartitioned() const { return m_partitioned.isInitialized(); }
+        bool isTailDeferred() const { return m_partitioned.isTailDeferred(); }
+
+        // See PartitionedConvolution::setActiveFraction(); direct form
+        // always runs every tap
+        void setActiveFraction(float fraction) { m_partitioned.setActiveFraction(fraction); }
 
     protected:
+        float directForm(float sample);
+        void allocateShiftRegister();
+
+        // Newest sample first, stored twice so the window starting at
+        // m_shiftOffset is always contiguous; only kept for direct form
         float *m_shiftRegister;
         int m_shiftOffset;
 
+        std::shared_ptr<float> m_taps;
         float *m_impulseResponse;
         int m_sampleCount;
+
+        PartitionedConvolution m_partitioned;
 };
 
 #endif /* ATG_ENGINE_SIM_CONVOLUTION_FILTER_H */
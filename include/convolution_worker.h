@@ -0,0 +1,56 @@
+#ifndef ATG_ENGINE_SIM_CONVOLUTION_WORKER_H
+#define ATG_ENGINE_SIM_CONVOLUTION_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A thread that runs the deferred tail stages of partitioned convolutions
+// (see PartitionedConvolution) so the audio thread only pays for the head.
+// Jobs go into a fixed ring without allocating; each carries a flag the
+// worker clears once it's done, which the owner checks before it needs the
+// result a block later.
+class ConvolutionWorker {
+    public:
+        typedef void (*Task)(void *context);
+
+    public:
+        ConvolutionWorker();
+        ~ConvolutionWorker();
+
+        // period is the audio thread's wake cadence, see
+        // ThreadPolicy::ApplyToCurrentThread()
+        void initialize(double period, int capacity = 256);
+        void destroy();
+
+        // Sets *busy and runs task(context) on the worker, or right here
+        // when the ring is full or the worker isn't running
+        void submit(Task task, void *context, std::atomic<bool> *busy);
+
+        bool isRunning() const { return m_thread.joinable(); }
+        unsigned long long getInlineCount() const { return m_inlineCount; }
+
+    protected:
+        struct Job {
+            Task task = nullptr;
+            void *context = nullptr;
+            std::atomic<bool> *busy = nullptr;
+        };
+
+        void worker(double period);
+
+        std::vector<Job> m_jobs;
+        size_t m_first;
+        size_t m_count;
+        bool m_run;
+
+        std::atomic<unsigned long long> m_inlineCount;
+
+        std::mutex m_lock;
+        std::condition_variable m_cv;
+        std::thread m_thread;
+};
+
+#endif /* ATG_ENGINE_SIM_CONVOLUTION_WORKER_H */
@@ -0,0 +1,105 @@
+#ifndef ATG_ENGINE_SIM_COST_ESTIMATE_H
+#define ATG_ENGINE_SIM_COST_ESTIMATE_H
+
+#include "fidelity_calibration.h"
+
+#include <string>
+#include <vector>
+
+class Simulator;
+
+// Predicts the share of real time an engine will take from its settings
+// alone, without stepping it, so a script asking for more than the host
+// can give is flagged as it loads rather than when the audio underruns.
+// A simulated second costs, in microseconds,
+//
+//   physics   frequency * (stepFixed + stepPerCylinder * cylinders)
+//   fluid     frequency * fluidSteps
+//                 * (substepPerCylinder * cylinders + substepPerPipe * pipes)
+//   synthesis sampleRate * (sampleFixed + samplePerChannel * channels)
+//   convolution
+//             sampleRate * the taps of each distinct impulse response,
+//                 at the direct or partitioned rate
+//
+// with physics and fluid on the physics thread and the rest on the audio
+// thread. The default coefficients are nominal figures for a desktop
+// x86-64 host, to be refreshed from engine-sim-bench (BM_Engine for the
+// physics, BM_ConvolutionFilter and BM_SynthesizerRenderAudio for the
+// audio); Fit() rescales them to a FidelityCalibration measurement of this
+// host.
+class CostEstimate {
+    public:
+        struct Coefficients {
+            double stepFixed = 2.0;
+            double stepPerCylinder = 0.6;
+            double substepPerCylinder = 0.35;
+            double substepPerPipe = 0.15;
+
+            double sampleFixed = 0.08;
+            double samplePerChannel = 0.04;
+            double directTap = 0.0005;
+            double partitionedFixed = 0.15;
+            double partitionedTap = 0.00004;
+        };
+
+        struct Inputs {
+            int simulationFrequency = 0;
+            int fluidSteps = 0;
+            int fluidThreads = 1;
+            int cylinders = 0;
+
+            // Intake and exhaust systems
+            int pipes = 0;
+
+            double audioSampleRate = 0.0;
+            int channels = 0;
+            bool partitionedConvolution = true;
+
+            // One per distinct impulse response
+            std::vector<int> impulseResponseTaps;
+        };
+
+        struct Term {
+            // Where the cost goes, and the setting that scales it
+            const char *name = "";
+            const char *setting = "";
+
+            // Share of real time on its thread
+            double load = 0.0;
+        };
+
+        struct Report {
+            double physicsLoad = 0.0;
+            double fluidLoad = 0.0;
+            double synthesisLoad = 0.0;
+            double convolutionLoad = 0.0;
+
+            // Per thread, against the headroom
+            double physicsThreadLoad = 0.0;
+            double audioThreadLoad = 0.0;
+            double headroom = 0.0;
+            bool sustainable = true;
+
+            // Costliest first
+            std::vector<Term> terms;
+        };
+
+    public:
+        static Inputs Gather(Simulator *simulator);
+        static Report Estimate(const Inputs &inputs, const Coefficients &coefficients, double headroom = 0.7);
+
+        // Scales the coefficients, the defaults unless given, so the model
+        // reproduces what was timed for the engine described by inputs
+        static Coefficients Fit(
+            const FidelityCalibration::Measurement &measurement,
+            const Inputs &inputs);
+        static Coefficients Fit(
+            const FidelityCalibration::Measurement &measurement,
+            const Inputs &inputs,
+            const Coefficients &reference);
+
+        // "physics 0.42 (simulation_frequency), ..." for logs and the UI
+        static std::string Describe(const Report &report);
+};
+
+#endif /* ATG_ENGINE_SIM_COST_ESTIMATE_H */
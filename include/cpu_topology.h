@@ -0,0 +1,59 @@
+#ifndef ATG_ENGINE_SIM_CPU_TOPOLOGY_H
+#define ATG_ENGINE_SIM_CPU_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+// The host's logical CPUs grouped by NUMA node and by the L2 and L3 caches
+// they share, for placing simulators so each one's threads and memory stay
+// on one node and its threads share a cache. Read from sysfs on Linux and
+// from GetLogicalProcessorInformationEx on Windows; elsewhere every CPU is
+// taken to be on one node with unknown caches.
+class CpuTopology {
+    public:
+        struct Cpu {
+            int id = 0;
+            int node = 0;
+            int package = 0;
+
+            // Lowest CPU sharing the cache, so equal ids share it; -1 when
+            // unknown
+            int l2 = -1;
+            int l3 = -1;
+        };
+
+        struct Placement {
+            int node = 0;
+            std::vector<int> cpus;
+        };
+
+    public:
+        CpuTopology();
+        ~CpuTopology();
+
+        void detect();
+
+        // root is a copy of /sys/devices/system; false if it lists no CPUs
+        bool detectFromSysfs(const std::string &root);
+        void initializeUniform(int cpuCount);
+
+        const std::vector<Cpu> &getCpus() const { return m_cpus; }
+        int getCpuCount() const { return static_cast<int>(m_cpus.size()); }
+        int getNodeCount() const;
+        int getL2GroupCount() const;
+
+        // Instances go round the nodes in turn; on its node each takes the
+        // next whole L2 groups, walking them in L3 order, until it has
+        // threadsPerInstance CPUs. Instances past a node's capacity wrap
+        // around onto its CPUs again.
+        std::vector<Placement> place(int instances, int threadsPerInstance) const;
+
+        // "0-3,8,10-11"
+        static bool ParseCpuList(const std::string &list, std::vector<int> *cpus);
+        static std::string FormatCpuList(const std::vector<int> &cpus);
+
+    protected:
+        std::vector<Cpu> m_cpus;
+};
+
+#endif /* ATG_ENGINE_SIM_CPU_TOPOLOGY_H */
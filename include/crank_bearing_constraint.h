@@ -0,0 +1,31 @@
+#ifndef ATG_ENGINE_SIM_CRANK_BEARING_CONSTRAINT_H
+#define ATG_ENGINE_SIM_CRANK_BEARING_CONSTRAINT_H
+
+#include "scs.h"
+
+class Crankshaft;
+
+// Holds a crankshaft's axis at its position in the block. The bearing sits
+// on the body's own origin, so unlike a FixedPositionConstraint with a
+// local offset its Jacobian doesn't depend on the crank angle: the rows are
+// constant and only the position error is evaluated each pass, without the
+// sine and cosine of the angle.
+class CrankBearingConstraint : public atg_scs::Constraint {
+public:
+    CrankBearingConstraint();
+    virtual ~CrankBearingConstraint();
+
+    // Holds the shaft at its position in the block
+    void connect(Crankshaft *crankshaft);
+
+    virtual void calculate(Output *output, atg_scs::SystemState *system);
+
+    double m_ks;
+    double m_kd;
+
+private:
+    double m_world_x;
+    double m_world_y;
+};
+
+#endif /* ATG_ENGINE_SIM_CRANK_BEARING_CONSTRAINT_H */
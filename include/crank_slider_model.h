@@ -0,0 +1,72 @@
+#ifndef ATG_ENGINE_SIM_CRANK_SLIDER_MODEL_H
+#define ATG_ENGINE_SIM_CRANK_SLIDER_MODEL_H
+
+#include "scs.h"
+
+class Engine;
+class Piston;
+class ConnectingRod;
+class Crankshaft;
+class CombustionChamber;
+
+// Reduced-coordinate piston/rod model: piston and rod poses follow
+// analytically from the crank angle, so only the crankshafts are bodies in
+// the rigid body system. Gas and skirt friction forces are projected onto
+// crank torque together with the reciprocating inertia terms.
+class CrankSliderModel : public atg_scs::ForceGenerator {
+    public:
+        CrankSliderModel();
+        virtual ~CrankSliderModel();
+
+        // Every rod has to sit directly on a crankshaft journal
+        static bool isSupported(const Engine *engine);
+
+        // Adds the mean reciprocating inertia of each cylinder to its
+        // crankshaft; call once the crankshaft mass properties are set
+        void initialize(Engine *engine);
+        void destroy();
+
+        void setTimestep(double dt) { m_dt = dt; }
+
+        // Poses the pistons and rods from the crankshaft bodies; call once
+        // per step after the rigid body system is processed
+        void place();
+
+        virtual void apply(atg_scs::SystemState *system) override;
+
+    protected:
+        struct Cylinder {
+            Piston *piston = nullptr;
+            ConnectingRod *rod = nullptr;
+            Crankshaft *crankshaft = nullptr;
+            CombustionChamber *chamber = nullptr;
+
+            double journal_x = 0.0;
+            double journal_y = 0.0;
+            double meanInertia = 0.0;
+
+            double lastOmega = 0.0;
+            double alpha = 0.0;
+            bool hasLastOmega = false;
+        };
+
+        // Pose and velocities per unit crank speed
+        struct Pose {
+            double piston_x, piston_y;
+            double rod_x, rod_y, rod_theta;
+
+            double ds;
+            double rod_vx, rod_vy, rod_omega;
+
+            double inertia;
+        };
+
+        bool solve(const Cylinder &cylinder, double theta, double c_x, double c_y, Pose *pose) const;
+        void applyPose(const Cylinder &cylinder, const Pose &pose, double omega);
+
+        Cylinder *m_cylinders;
+        int m_cylinderCount;
+        double m_dt;
+};
+
+#endif /* ATG_ENGINE_SIM_CRANK_SLIDER_MODEL_H */
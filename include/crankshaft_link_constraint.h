@@ -0,0 +1,27 @@
+#ifndef ATG_ENGINE_SIM_CRANKSHAFT_LINK_CONSTRAINT_H
+#define ATG_ENGINE_SIM_CRANKSHAFT_LINK_CONSTRAINT_H
+
+#include "scs.h"
+
+class Crankshaft;
+
+// Rigidly gears a crankshaft to the output shaft. Unlike a clutch, the
+// angle error is part of the constraint so the shafts cannot drift apart.
+class CrankshaftLinkConstraint : public atg_scs::Constraint {
+public:
+    CrankshaftLinkConstraint();
+    virtual ~CrankshaftLinkConstraint();
+
+    // Holds the angle between the two shafts at the time of the call
+    void connect(Crankshaft *outputShaft, Crankshaft *crankshaft);
+
+    virtual void calculate(Output *output, atg_scs::SystemState *system);
+
+    double m_ks;
+    double m_kd;
+
+private:
+    double m_offset;
+};
+
+#endif /* ATG_ENGINE_SIM_CRANKSHAFT_LINK_CONSTRAINT_H */
@@ -0,0 +1,112 @@
+#ifndef ATG_ENGINE_SIM_CYCLE_AUDIO_CACHE_H
+#define ATG_ENGINE_SIM_CYCLE_AUDIO_CACHE_H
+
+#include "cycle_statistics.h"
+#include "random_stream.h"
+
+#include <vector>
+
+// Stands in for the physics while an engine holds steady. Once enough engine
+// cycles in a row have the same length in steps and a low IMEP variation,
+// the synthesizer input frames of a few whole cycles are captured, plus a
+// crossfade's worth past the end. The simulator then stops stepping and
+// loops them instead: every pass blends in from the captured continuation of
+// the loop's end, and its gain drifts by a small random amount so the
+// repetition isn't exact.
+//
+// Any change to the inputs interrupts it; live frames are faded in from the
+// replay over the same crossfade, and it starts counting steady cycles
+// again. Storage is allocated in initialize(), never per frame.
+class CycleAudioCache {
+    public:
+        static constexpr int MaxSteadyCycles = 16;
+
+        struct Parameters {
+            // Steady cycles needed before capturing; at most MaxSteadyCycles
+            int steadyCycles = 4;
+
+            // Allowed spread of their lengths relative to the mean, and
+            // coefficient of variation of their IMEP
+            double periodTolerance = 0.01;
+            double imepTolerance = 0.1;
+
+            int captureCycles = 2;
+            int crossfadeFrames = 256;
+
+            // Each pass of the loop is scaled by up to this much either way
+            double gainJitter = 0.02;
+
+            // Longest capture in frames, crossfade included
+            int maxFrames = 1 << 15;
+        };
+
+        enum class State {
+            Watching,
+            Capturing,
+            Replaying,
+            Resuming
+        };
+
+    public:
+        CycleAudioCache();
+        ~CycleAudioCache();
+
+        void initialize(const Parameters &params, int channels);
+        void destroy();
+        void seed(uint64_t seed);
+
+        // The inputs changed: stops capturing, fades out a replay and
+        // forgets the steady cycles counted so far
+        void interrupt();
+
+        // Every live step, with the frame about to be written to the
+        // synthesizer; cycleStart when the step began an engine cycle.
+        // While resuming, the frame is crossfaded from the replay in place.
+        void processLiveFrame(double *frame, bool cycleStart, const CycleStatistics &statistics);
+
+        // While replaying, the frame to write in place of a physics step
+        const double *nextReplayFrame();
+
+        bool isInitialized() const { return m_channels > 0; }
+        bool isReplaying() const { return m_state == State::Replaying; }
+        State getState() const { return m_state; }
+
+        int getChannelCount() const { return m_channels; }
+        int getLoopFrames() const { return m_loopFrames; }
+        int getCrossfadeFrames() const { return m_crossfade; }
+        unsigned long long getReplayedFrames() const { return m_replayedFrames; }
+
+    protected:
+        bool isSteady(const CycleStatistics &statistics) const;
+        void startCapture();
+        const double *replayFrame();
+
+        Parameters m_parameters;
+        int m_channels;
+        RandomStream m_random;
+
+        State m_state;
+
+        // Lengths of the last complete cycles in steps, since the last
+        // interrupt; m_cycleSteps is -1 until a cycle start has been seen
+        int m_periods[MaxSteadyCycles];
+        int m_periodCount;
+        int m_periodIndex;
+        int m_cycleSteps;
+
+        // Frame-major, m_channels per frame
+        std::vector<double> m_frames;
+        int m_capturedFrames;
+        int m_capturedCycles;
+        int m_loopFrames;
+        int m_crossfade;
+
+        int m_position;
+        double m_gain;
+        double m_previousGain;
+        int m_fade;
+        std::vector<double> m_output;
+        unsigned long long m_replayedFrames;
+};
+
+#endif /* ATG_ENGINE_SIM_CYCLE_AUDIO_CACHE_H */
@@ -0,0 +1,98 @@
+#ifndef ATG_ENGINE_SIM_CYCLE_STATISTICS_H
+#define ATG_ENGINE_SIM_CYCLE_STATISTICS_H
+
+// Engine state binned by crank angle over one 720 degree cycle. Every step
+// writes its values into the bin of its angle, and into the bins the crank
+// passed since the previous step, so each bin holds the last value seen at
+// that angle. Running sums over the bins give cycle averages in constant
+// time, independent of how many steps a cycle takes.
+//
+// The cylinder channels follow one cylinder. As each cycle completes, the
+// indicated work (the integral of p dV over the steps) gives its IMEP, and
+// the last HistoryCycles cycles give the cycle-to-cycle variability.
+//
+// Plain data so checkpoints can copy it as it is.
+class CycleStatistics {
+    friend class SimulationCheckpoint;
+
+    public:
+        static constexpr int Bins = 512;
+        static constexpr int HistoryCycles = 32;
+
+        enum class Channel {
+            Torque,
+            CylinderPressure,
+            CylinderVolume,
+            IntakeFlow,
+            ExhaustFlow,
+            IntakeValveLift,
+            ExhaustValveLift,
+            Count
+        };
+
+        static constexpr int ChannelCount = static_cast<int>(Channel::Count);
+
+        struct Cycle {
+            double imep = 0.0;
+            double peakPressure = 0.0;
+            double peakPressureAngle = 0.0;
+            double torque = 0.0;
+        };
+
+    public:
+        CycleStatistics();
+
+        void reset();
+
+        // cycleAngle in [0, 4 pi); direction is +1 when the angle increases
+        // from step to step and -1 when it decreases
+        void addSample(double cycleAngle, int direction, const double values[ChannelCount]);
+
+        // Mean over the bins, so over the last cycle by angle
+        double getAverage(Channel channel) const { return m_sums[static_cast<int>(channel)] / Bins; }
+        double getBin(Channel channel, int bin) const { return m_bins[static_cast<int>(channel)][bin]; }
+        static double GetBinAngle(int bin);
+
+        // True when the last sample began a new cycle
+        bool isCycleStart() const { return m_cycleStart; }
+
+        int getCycleCount() const { return m_cycles; }
+        int getHistoryCount() const { return m_historyCount; }
+
+        // i = 0 is the last completed cycle
+        const Cycle &getCycle(int i) const;
+
+        // Over the cycles in the history; 0 before any cycle has completed
+        double getMeanImep() const;
+        double getImepCoefficientOfVariation() const;
+        double getMeanPeakPressure() const;
+
+    protected:
+        void writeBin(int bin, const double values[ChannelCount]);
+        void completeCycle();
+        void resum();
+
+        double m_bins[ChannelCount][Bins];
+        double m_sums[ChannelCount];
+        int m_lastBin;
+        bool m_cycleStart;
+
+        // The cycle in progress; the first one after reset() started part
+        // way through and isn't recorded
+        bool m_cycleStarted;
+        bool m_hasPrevious;
+        double m_previousPressure;
+        double m_previousVolume;
+        double m_work;
+        double m_minVolume;
+        double m_maxVolume;
+        double m_peakPressure;
+        double m_peakPressureAngle;
+
+        Cycle m_history[HistoryCycles];
+        int m_historyIndex;
+        int m_historyCount;
+        int m_cycles;
+};
+
+#endif /* ATG_ENGINE_SIM_CYCLE_STATISTICS_H */
@@ -12,8 +12,9 @@ class CylinderBankObject : public SimulationObject {
         CylinderBankObject();
         virtual ~CylinderBankObject();
 
-        virtual void generateGeometry();
+        virtual void generateStaticGeometry();
         virtual void render(const ViewParameters *view);
+        virtual bool getWorldBounds(Bounds *bounds) const;
         virtual void process(float dt);
         virtual void destroy();
 
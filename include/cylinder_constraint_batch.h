@@ -0,0 +1,141 @@
+#ifndef ATG_ENGINE_SIM_CYLINDER_CONSTRAINT_BATCH_H
+#define ATG_ENGINE_SIM_CYLINDER_CONSTRAINT_BATCH_H
+
+#include "scs.h"
+
+// The little end and big end links and the cylinder wall constraint of
+// every cylinder, kept in structure-of-arrays form. The rigid body system
+// still sees one constraint per link and wall, but they're thin proxies:
+// the first one calculated each pass gathers the body states of all
+// cylinders and evaluates every position error and Jacobian in straight
+// vector loops, and the rest copy their rows out. Proxies have to be added
+// to the system in cylinder order, little end link first, which is also
+// the order that keeps a Gauss-Seidel sweep walking the bodies in sequence.
+class CylinderConstraintBatch {
+    public:
+        enum class Kind {
+            LittleEnd,
+            BigEnd,
+            Wall
+        };
+
+        class Proxy : public atg_scs::Constraint {
+            friend CylinderConstraintBatch;
+
+            public:
+                Proxy(int constraintCount, int bodyCount);
+                virtual ~Proxy();
+
+                virtual void calculate(Output *output, atg_scs::SystemState *state);
+
+            protected:
+                CylinderConstraintBatch *m_batch;
+                Kind m_kind;
+                int m_cylinder;
+        };
+
+        class LinkProxy : public Proxy {
+            public:
+                LinkProxy() : Proxy(2, 2) { /* void */ }
+        };
+
+        class WallProxy : public Proxy {
+            public:
+                WallProxy() : Proxy(1, 1) { /* void */ }
+        };
+
+    public:
+        CylinderConstraintBatch();
+        ~CylinderConstraintBatch();
+
+        void initialize(int cylinderCount);
+        void destroy();
+
+        // The rod is body 1 of both links; the little end's body 2 is the
+        // piston and the big end's the crankshaft or master rod
+        void setLittleEnd(
+            int cylinder,
+            atg_scs::RigidBody *rod,
+            atg_scs::RigidBody *piston,
+            double rodLocal_y,
+            double pistonLocal_y);
+        void setBigEnd(
+            int cylinder,
+            atg_scs::RigidBody *journalBody,
+            double rodLocal_y,
+            double journal_x,
+            double journal_y);
+
+        // Holds the piston's wrist pin, as set by setLittleEnd(), on the line
+        // through p0 along d
+        void setWall(
+            int cylinder,
+            double d_x,
+            double d_y,
+            double p0_x,
+            double p0_y);
+
+        // Every link and wall alike
+        void setStiffness(double ks, double kd);
+
+        LinkProxy *getLittleEnd(int cylinder) { return &m_links[cylinder * 2 + 0]; }
+        LinkProxy *getBigEnd(int cylinder) { return &m_links[cylinder * 2 + 1]; }
+        WallProxy *getWall(int cylinder) { return &m_walls[cylinder]; }
+
+        int getCylinderCount() const { return m_cylinderCount; }
+        void evaluate(atg_scs::SystemState *state);
+
+    protected:
+        void write(const Proxy *proxy, atg_scs::Constraint::Output *output) const;
+
+        LinkProxy *m_links;
+        WallProxy *m_walls;
+        double *m_buffer;
+
+        // Body attachments
+        double *m_littleEnd_y;
+        double *m_wristPin_y;
+        double *m_bigEnd_y;
+        double *m_journal_x;
+        double *m_journal_y;
+        double *m_wallNormal_x;
+        double *m_wallNormal_y;
+        double *m_wallOffset;
+
+        // Body states, gathered from the system each pass
+        double *m_piston_x;
+        double *m_piston_y;
+        double *m_piston_theta;
+        double *m_piston_omega;
+        double *m_rod_x;
+        double *m_rod_y;
+        double *m_rod_theta;
+        double *m_rod_omega;
+        double *m_journal_px;
+        double *m_journal_py;
+        double *m_journal_theta;
+        double *m_journal_omega;
+
+        // Position errors and the rotational Jacobian terms; the rest are
+        // constant. w is the wrist pin, r the rod's little end, b its big
+        // end and j the journal.
+        double *m_C_little_x;
+        double *m_C_little_y;
+        double *m_C_big_x;
+        double *m_C_big_y;
+        double *m_C_wall;
+        double *m_r_x;
+        double *m_r_y;
+        double *m_w_x;
+        double *m_w_y;
+        double *m_b_x;
+        double *m_b_y;
+        double *m_j_x;
+        double *m_j_y;
+
+        double m_ks;
+        double m_kd;
+        int m_cylinderCount;
+};
+
+#endif /* ATG_ENGINE_SIM_CYLINDER_CONSTRAINT_BATCH_H */
@@ -47,6 +47,8 @@ class CylinderHead : public Part {
 
         double intakeFlowRate(int cylinder) const;
         double exhaustFlowRate(int cylinder) const;
+        double intakeFlowRateAtLift(double lift) const;
+        double exhaustFlowRateAtLift(double lift) const;
         double intakeValveLift(int cylinder) const;
         double exhaustValveLift(int cylinder) const;
 
@@ -74,6 +76,9 @@ class CylinderHead : public Part {
         double getExhaustRunnerVolume() const { return m_exhaustRunnerVolume; }
         double getExhaustRunnerCrossSectionArea() const { return m_exhaustRunnerCrossSectionArea; }
 
+        inline Function *getIntakePortFlow() const { return m_intakePortFlow; }
+        inline Function *getExhaustPortFlow() const { return m_exhaustPortFlow; }
+        inline Valvetrain *getValvetrain() const { return m_valvetrain; }
         Camshaft *getExhaustCamshaft();
         Camshaft *getIntakeCamshaft();
 
@@ -12,8 +12,10 @@ class CylinderHeadObject : public SimulationObject {
         CylinderHeadObject();
         virtual ~CylinderHeadObject();
 
+        virtual void generateStaticGeometry();
         virtual void generateGeometry();
         virtual void render(const ViewParameters *view);
+        virtual bool getWorldBounds(Bounds *bounds) const;
         virtual void process(float dt);
         virtual void destroy();
 
@@ -21,11 +23,23 @@ class CylinderHeadObject : public SimulationObject {
         Engine *m_engine;
 
     protected:
+        static constexpr float RollerRadius = (float)units::distance(300.0, units::thou);
+
         void generateCamshaft(
             Camshaft *camshaft,
             double padding,
             double rollerRadius,
             GeometryGenerator::GeometryIndices *indices);
+
+        GeometryGenerator::GeometryIndices
+            m_valveShadow,
+            m_valveRoller,
+            m_valveRollerShadow,
+            m_valveRollerPin,
+            m_camCenter,
+            m_intakeCam,
+            m_intakeCamShadow,
+            m_exhaustCam;
 };
 
 #endif /* ATG_ENGINE_SIM_CYLINDER_HEAD_OBJECT_H */
@@ -4,6 +4,7 @@
 #include "ui_element.h"
 
 #include "engine.h"
+#include "simulator.h"
 #include "gauge.h"
 
 class CylinderTemperatureGauge : public UiElement {
@@ -17,9 +18,14 @@ class CylinderTemperatureGauge : public UiElement {
         virtual void update(float dt);
         virtual void render();
 
+        // Layout comes from the engine; temperatures from the snapshot
         Engine *m_engine;
+        Simulator *m_simulator;
         double m_maxTemperature;
         double m_minTemperature;
+
+    protected:
+        int getCylinderCount() const;
 };
 
 #endif /* ATG_ENGINE_SIM_CYLINDER_TEMPERATURE_GAUGE_H */
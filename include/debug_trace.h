@@ -1,20 +1,115 @@
 #ifndef ATG_ENGINE_SIM_DEBUG_TRACE_H
 #define ATG_ENGINE_SIM_DEBUG_TRACE_H
 
+#include <atomic>
 #include <string>
 
+// Compile-time trace level: 0 compiles every ATG_ENGINE_SIM_TRACE() out, 1
+// keeps lifecycle events and warnings, 2 also keeps per-frame and periodic
+// traces (CMake: ENGINE_SIM_TRACE_LEVEL)
+#ifndef ATG_ENGINE_SIM_TRACE_LEVEL
+#define ATG_ENGINE_SIM_TRACE_LEVEL 2
+#endif /* ATG_ENGINE_SIM_TRACE_LEVEL */
+
 class DebugTrace {
 public:
+    enum class Category : unsigned int {
+        Main,
+        App,
+        Mainloop,
+        Script,
+        Window,
+        Input,
+        Simulator,
+        Audio,
+        AudioThread,
+        Ui,
+        Assets,
+        Headless,
+        Count
+    };
+
+    enum class Level : int {
+        Event = 1,
+        Verbose = 2
+    };
+
+    static constexpr int CategoryCount = static_cast<int>(Category::Count);
+
+    static constexpr const char *CategoryNames[CategoryCount] = {
+        "main",
+        "app",
+        "mainloop",
+        "script",
+        "window",
+        "input",
+        "simulator",
+        "audio",
+        "audio_thread",
+        "ui",
+        "assets",
+        "headless"
+    };
+
+    // Highest level compiled in per category; lower an entry to strip a
+    // category's traces from the build
+    static constexpr int CompiledLevels[CategoryCount] = {
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL,
+        ATG_ENGINE_SIM_TRACE_LEVEL
+    };
+
+    static constexpr bool IsCompiled(Category category, Level level) {
+        return static_cast<int>(level) <= CompiledLevels[static_cast<int>(category)];
+    }
+
+    static constexpr const char *GetCategoryName(Category category) {
+        return CategoryNames[static_cast<int>(category)];
+    }
+
+    // Zero unless a trace session is running; --debug-trace-categories=a,b
+    // narrows it at startup
+    static bool IsCategoryEnabled(Category category) {
+        return (s_categoryMask.load(std::memory_order_relaxed) & (1u << static_cast<unsigned int>(category))) != 0;
+    }
+
     static bool InitializeFromArguments(int argc, char **argv);
     static void Shutdown();
     static void RequestDump(const char *reason);
 
+    // Counts every RequestDump() call, with or without a session, for other
+    // recorders that dump along with the trace
+    static unsigned long long GetDumpRequestCount();
+
     static bool IsEnabled();
     static std::string SessionDirectory();
     static void SetFrameIndex(unsigned long long frameIndex);
     static unsigned long long GetFrameIndex();
 
     static void Log(const char *component, const char *format, ...);
+
+private:
+    static std::atomic<unsigned int> s_categoryMask;
+    static std::atomic<unsigned long long> s_dumpRequests;
 };
 
+// Arguments are only evaluated when the category is compiled in and enabled
+#define ATG_ENGINE_SIM_TRACE(category, level, ...) \
+    do { \
+        if constexpr (DebugTrace::IsCompiled(DebugTrace::Category::category, DebugTrace::Level::level)) { \
+            if (DebugTrace::IsCategoryEnabled(DebugTrace::Category::category)) { \
+                DebugTrace::Log(DebugTrace::GetCategoryName(DebugTrace::Category::category), __VA_ARGS__); \
+            } \
+        } \
+    } while (false)
+
 #endif /* ATG_ENGINE_SIM_DEBUG_TRACE_H */
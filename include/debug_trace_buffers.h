@@ -0,0 +1,135 @@
+#ifndef ATG_ENGINE_SIM_DEBUG_TRACE_BUFFERS_H
+#define ATG_ENGINE_SIM_DEBUG_TRACE_BUFFERS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// The fixed-size tables and record ring DebugTrace keeps for its snapshot
+// summaries and crash dumps
+namespace debug_trace {
+
+// A record in the crash ring, followed by its payload; size covers both
+#pragma pack(push, 1)
+struct RingRecordHeader {
+    uint16_t size;
+    uint16_t component;
+    uint16_t format;
+    uint8_t argCount;
+    uint8_t reserved;
+    int64_t monoMs;
+    uint64_t frame;
+    uint64_t tid;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(RingRecordHeader) == 32, "readers assume 32 byte record headers");
+
+// Fixed-capacity interner; the text shares one block allocated up front, so
+// interning never allocates. Past capacity intern() returns Full.
+struct StringTable {
+    static constexpr uint16_t Full = 0xFFFF;
+
+    std::vector<char> text;
+    std::vector<uint32_t> offsets;
+    std::vector<uint16_t> lengths;
+    std::vector<uint16_t> slots;
+    size_t textUsed = 0;
+    size_t count = 0;
+
+    void initialize(size_t capacity, size_t textBytes) {
+        capacity = std::min(capacity, static_cast<size_t>(Full));
+        text.assign(textBytes, '\0');
+        offsets.assign(capacity, 0);
+        lengths.assign(capacity, 0);
+        slots.assign(capacity * 2, Full);
+        textUsed = 0;
+        count = 0;
+    }
+
+    uint16_t intern(const char *value, size_t length) {
+        if (slots.empty() || length > 0xFFFF) return Full;
+
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(value[i])) * 16777619u;
+        }
+
+        for (size_t probe = 0; probe < slots.size(); ++probe) {
+            uint16_t &slot = slots[(hash + probe) % slots.size()];
+            if (slot == Full) {
+                if (count >= offsets.size() || textUsed + length > text.size()) return Full;
+
+                std::memcpy(text.data() + textUsed, value, length);
+                offsets[count] = static_cast<uint32_t>(textUsed);
+                lengths[count] = static_cast<uint16_t>(length);
+                textUsed += length;
+                slot = static_cast<uint16_t>(count++);
+                return slot;
+            }
+            else if (lengths[slot] == length && std::memcmp(text.data() + offsets[slot], value, length) == 0) {
+                return slot;
+            }
+        }
+
+        return Full;
+    }
+
+    const char *get(uint16_t id, size_t *length) const {
+        *length = lengths[id];
+        return text.data() + offsets[id];
+    }
+};
+
+// Variable-length records in a fixed byte budget; the oldest are evicted to
+// make room
+struct CompactRing {
+    std::vector<uint8_t> bytes;
+    size_t head = 0;
+    size_t tail = 0;
+    size_t used = 0;
+    uint64_t count = 0;
+
+    void clear() {
+        head = tail = used = 0;
+        count = 0;
+    }
+
+    void copyIn(const void *data, size_t size) {
+        const uint8_t *source = static_cast<const uint8_t *>(data);
+        const size_t first = std::min(size, bytes.size() - head);
+        std::memcpy(bytes.data() + head, source, first);
+        std::memcpy(bytes.data(), source + first, size - first);
+        head = (head + size) % bytes.size();
+        used += size;
+    }
+
+    void copyOut(size_t offset, void *data, size_t size) const {
+        uint8_t *target = static_cast<uint8_t *>(data);
+        const size_t first = std::min(size, bytes.size() - offset);
+        std::memcpy(target, bytes.data() + offset, first);
+        std::memcpy(target + first, bytes.data(), size - first);
+    }
+
+    void push(const RingRecordHeader &header, const uint8_t *payload) {
+        if (header.size > bytes.size()) return;
+
+        while (bytes.size() - used < header.size) {
+            uint16_t size;
+            copyOut(tail, &size, sizeof(size));
+            tail = (tail + size) % bytes.size();
+            used -= size;
+            --count;
+        }
+
+        copyIn(&header, sizeof(header));
+        copyIn(payload, header.size - sizeof(header));
+        ++count;
+    }
+};
+
+} /* namespace debug_trace */
+
+#endif /* ATG_ENGINE_SIM_DEBUG_TRACE_BUFFERS_H */
@@ -9,6 +9,8 @@
 #include <cmath>
 
 class DelayFilter : public Filter {
+    friend class SimulationCheckpoint;
+
 public:
     DelayFilter() {
         m_latencySamples = 0;
@@ -48,7 +50,7 @@ public:
 
 protected:
     int m_latencySamples;
-    RingBuffer<double> m_history;
+    RingBuffer<double, true> m_history;
 };
 
 #endif /* ATG_ENGINE_SIM_DELAY_FILTER_H */
@@ -0,0 +1,54 @@
+#ifndef ATG_ENGINE_SIM_DELAY_LINE_BANK_H
+#define ATG_ENGINE_SIM_DELAY_LINE_BANK_H
+
+#include <cstddef>
+
+// Several delay lines sharing one clock, e.g. the exhaust runners of every
+// cylinder. The history is interleaved, one row of a sample per line per
+// step, so a step writes one contiguous row and reads every line in a single
+// pass. Delays are fractional: whole samples are read from the history and
+// the remainder is interpolated with a third order Lagrange kernel (linear
+// under one sample), so the delay no longer rounds to the step rate.
+class DelayLineBank {
+    friend class SimulationCheckpoint;
+
+    public:
+        DelayLineBank();
+        ~DelayLineBank();
+
+        // Delays in seconds, one per line; clears the history. Can be called
+        // again to re-time the lines when the sample rate changes.
+        void initialize(const double *delays, int lines, double sampleRate);
+        void destroy();
+
+        // One sample per line in and out
+        void process(const double *input, double *output);
+
+        // frames rows of one sample per line
+        void process(const double *input, double *output, int frames);
+
+        int getLineCount() const { return m_lineCount; }
+        int getRowCount() const { return static_cast<int>(m_rowMask + 1); }
+
+        // Delay of a line in samples, whole part and fraction
+        double getDelaySamples(int line) const { return m_delaySamples[line]; }
+
+    protected:
+        static constexpr int Taps = 4;
+
+        // m_rowMask + 1 rows of m_lineCount samples
+        double *m_history;
+        size_t m_rowMask;
+        size_t m_writeRow;
+
+        // Per line, the age in samples of its newest tap, and the
+        // coefficients of that tap and the Taps - 1 older ones, stored
+        // tap-major
+        size_t *m_offsets;
+        double *m_coefficients;
+        double *m_delaySamples;
+
+        int m_lineCount;
+};
+
+#endif /* ATG_ENGINE_SIM_DELAY_LINE_BANK_H */
@@ -0,0 +1,74 @@
+#ifndef ATG_ENGINE_SIM_DENORMALS_H
+#define ATG_ENGINE_SIM_DENORMALS_H
+
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define ATG_ENGINE_SIM_DENORMALS_MXCSR
+#elif defined(__aarch64__)
+#define ATG_ENGINE_SIM_DENORMALS_FPCR
+#endif
+
+// Flushes subnormal results and operands to zero on the calling thread for
+// the lifetime of the scope, restoring the previous mode on exit. Filter
+// states and IR tails decaying toward silence otherwise pass through the
+// subnormal range, where x86 takes a microcode assist on every operation.
+// Uses MXCSR FTZ|DAZ on x86 and FPCR.FZ on AArch64; a no-op elsewhere.
+class DenormalScope {
+    public:
+        explicit DenormalScope(bool enabled = true) {
+            m_saved = read();
+            if (enabled) write(m_saved | FlushBits);
+        }
+
+        ~DenormalScope() {
+            write(m_saved);
+        }
+
+        DenormalScope(const DenormalScope &) = delete;
+        DenormalScope &operator=(const DenormalScope &) = delete;
+
+        static bool IsSupported() {
+#if defined(ATG_ENGINE_SIM_DENORMALS_MXCSR) || defined(ATG_ENGINE_SIM_DENORMALS_FPCR)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        static bool IsFlushing() {
+            return IsSupported() && (read() & FlushBits) == FlushBits;
+        }
+
+    protected:
+#if defined(ATG_ENGINE_SIM_DENORMALS_MXCSR)
+        // FTZ (bit 15) | DAZ (bit 6)
+        static constexpr uint64_t FlushBits = 0x8040;
+
+        static uint64_t read() { return _mm_getcsr(); }
+        static void write(uint64_t value) { _mm_setcsr(static_cast<unsigned int>(value)); }
+#elif defined(ATG_ENGINE_SIM_DENORMALS_FPCR)
+        // FZ (bit 24) covers both inputs and results
+        static constexpr uint64_t FlushBits = 1ull << 24;
+
+        static uint64_t read() {
+            uint64_t value;
+            __asm__ __volatile__("mrs %0, fpcr" : "=r"(value));
+            return value;
+        }
+
+        static void write(uint64_t value) {
+            __asm__ __volatile__("msr fpcr, %0" : : "r"(value));
+        }
+#else
+        static constexpr uint64_t FlushBits = 0;
+
+        static uint64_t read() { return 0; }
+        static void write(uint64_t) { /* void */ }
+#endif
+
+        uint64_t m_saved;
+};
+
+#endif /* ATG_ENGINE_SIM_DENORMALS_H */
@@ -4,11 +4,14 @@
 #include "filter.h"
 
 class DerivativeFilter : public Filter {
+    friend class SimulationCheckpoint;
+
     public:
         DerivativeFilter();
         virtual ~DerivativeFilter();
 
         virtual float f(float sample) override;
+        void fast_f(const float *input, float *output, int n);
 
         float m_dt;
 
@@ -0,0 +1,139 @@
+#ifndef ATG_ENGINE_SIM_DISTRIBUTED_STUDY_H
+#define ATG_ENGINE_SIM_DISTRIBUTED_STUDY_H
+
+#include "parameter_study.h"
+
+#include <cinttypes>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Spreads a ParameterStudy's tasks over worker processes on other hosts.
+// Workers connect to the coordinator over TCP and are sent the study's
+// parameters and the engine snapshot every variant is built from, so they
+// need neither the script nor its assets; each then regenerates the same
+// variants and hold points and only task indices go over the wire.
+//
+// Each worker is kept up to its thread count in tasks. Once none are left
+// to hand out, idle workers are given copies of tasks still running
+// elsewhere, oldest first, and the first result in wins, so one slow or
+// lost host doesn't hold up the end of the study. A worker that
+// disconnects has its unfinished tasks handed out again.
+//
+// Messages are a type and a length followed by the payload, in the host's
+// byte order; coordinator and workers must share it and Version.
+class StudyCoordinator {
+    public:
+        static constexpr uint32_t Magic = 0x59445453; // "STDY"
+        static constexpr uint32_t Version = 1;
+
+        struct Parameters {
+            int port = 7851;
+
+            // Copies of a running task beyond the first that may be handed
+            // to idle workers
+            int maxDuplicates = 1;
+        };
+
+        struct Statistics {
+            // Connected over the whole run
+            int workers = 0;
+            long long dispatched = 0;
+            long long duplicates = 0;
+
+            // Handed out again after their worker disconnected
+            long long requeued = 0;
+
+            // Results of tasks that another worker had already finished
+            long long discarded = 0;
+        };
+
+    public:
+        StudyCoordinator();
+        ~StudyCoordinator();
+
+        // Reads the snapshot and starts listening; port 0 picks one
+        bool initialize(
+            const Parameters &params,
+            const ParameterStudy::Parameters &study,
+            const std::string &snapshotPath);
+        void destroy();
+
+        // Blocks until every task has a result
+        ParameterStudy::Result run();
+
+        int getPort() const { return m_port; }
+        const ParameterStudy &getStudy() const { return m_study; }
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        struct Worker;
+
+        struct Task {
+            bool done = false;
+            int copies = 0;
+            long long dispatched = -1;
+        };
+
+        void accept();
+        bool receive(Worker *worker, ParameterStudy::Result *result);
+        void dispatch(Worker *worker);
+        int nextTask(const Worker &worker);
+        void disconnect(Worker *worker);
+
+        Parameters m_parameters;
+        ParameterStudy m_study;
+        std::vector<uint8_t> m_setup;
+
+        intptr_t m_socket;
+        int m_port;
+
+        std::vector<Worker *> m_workers;
+        std::vector<Task> m_tasks;
+        std::deque<int> m_pending;
+        int m_completed;
+        long long m_dispatchCount;
+
+        Statistics m_statistics;
+};
+
+class StudyWorker {
+    public:
+        struct Parameters {
+            std::string host = "127.0.0.1";
+            int port = 7851;
+            int threads = 1;
+
+            // Where the received snapshot is written
+            std::string snapshotPath;
+        };
+
+        struct Statistics {
+            long long tasks = 0;
+            double wallTime = 0.0;
+        };
+
+        // Called once the setup has arrived and the snapshot is written,
+        // before any task runs; returning false ends the run
+        using Prepare = std::function<bool(const ParameterStudy &study, const std::string &snapshotPath)>;
+
+    public:
+        StudyWorker();
+        ~StudyWorker();
+
+        // Runs tasks until the coordinator reports the study done or the
+        // connection drops; false if the setup never arrived. create and
+        // release are serialized.
+        bool run(
+            const Parameters &params,
+            const Prepare &prepare,
+            const ParameterStudy::CreateSimulator &create,
+            const ParameterStudy::ReleaseSimulator &release);
+
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_DISTRIBUTED_STUDY_H */
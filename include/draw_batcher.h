@@ -0,0 +1,88 @@
+#ifndef ATG_ENGINE_SIM_DRAW_BATCHER_H
+#define ATG_ENGINE_SIM_DRAW_BATCHER_H
+
+#include "delta.h"
+
+#include "geometry_generator.h"
+
+class Shaders;
+
+// Merges consecutive generated shapes that share a layer, stage flags and
+// shader object state (color, transform) into one draw. Indices are copied,
+// rebased onto the first shape of the batch, into an index buffer of the
+// batcher's own that is uploaded once per frame; vertices stay in the
+// geometry generator's buffer.
+class DrawBatcher {
+    public:
+        struct Statistics {
+            int shapes = 0;
+            int draws = 0;
+        };
+
+        static constexpr int MaxBins = 4;
+
+    public:
+        DrawBatcher();
+        ~DrawBatcher();
+
+        void initialize(
+            dbasic::DeltaEngine *engine,
+            Shaders *shaders,
+            ysGPUBuffer *vertexBuffer,
+            ysGPUBuffer *indexBuffer,
+            int indexCapacity);
+        void destroy();
+
+        void beginFrame();
+        void draw(
+            const GeometryGenerator::GeometryIndices &indices,
+            const unsigned short *indexData,
+            int layer,
+            dbasic::StageEnableFlags flags);
+
+        // Submits every open batch; required before anything that is not
+        // batched (text, models) is drawn on top
+        void flush();
+
+        // Sends this frame's indices to the GPU; call once after the last flush()
+        void upload();
+
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        struct Batch {
+            bool open = false;
+            int layer = 0;
+            dbasic::StageEnableFlags flags = 0;
+            dbasic::ShaderObjectVariables state;
+            int baseVertex = 0;
+            int firstIndex = 0;
+            int faceCount = 0;
+        };
+
+        bool append(
+            Batch *batch,
+            const GeometryGenerator::GeometryIndices &indices,
+            const unsigned short *indexData);
+        void open(Batch *batch, int layer, dbasic::StageEnableFlags flags, int baseVertex);
+        void submit(Batch *batch);
+        void submitDirect(
+            const GeometryGenerator::GeometryIndices &indices,
+            int layer,
+            dbasic::StageEnableFlags flags);
+
+        dbasic::DeltaEngine *m_engine;
+        Shaders *m_shaders;
+        ysGPUBuffer *m_vertexBuffer;
+        ysGPUBuffer *m_geometryIndexBuffer;
+        ysGPUBuffer *m_indexBuffer;
+
+        unsigned short *m_indexData;
+        int m_indexCapacity;
+        int m_indexCount;
+
+        Batch m_bins[MaxBins];
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_DRAW_BATCHER_H */
@@ -0,0 +1,127 @@
+#ifndef ATG_ENGINE_SIM_DRIVE_CYCLE_H
+#define ATG_ENGINE_SIM_DRIVE_CYCLE_H
+
+#include "headless_runner.h"
+
+#include <functional>
+#include <vector>
+
+// Drives the vehicle through a launch, either from a scripted schedule of
+// throttle, gear and clutch commands or from shift rules: start the engine,
+// slip the clutch away in first at full throttle and upshift at the shift
+// speed. Runs headless as fast as the simulation allows and reports the
+// time to each target speed, the fuel burned and every gear change, all
+// measured from the launch (the first frame with a gear in and the clutch
+// engaging). Batches of variants, e.g. different gearing, run in parallel
+// on simulators of their own, like the points of a dyno sweep.
+class DriveCycle {
+    public:
+        struct ShiftRules {
+            double throttle = 1.0;
+
+            // Engine speed to upshift at; 0 shifts at 95% of the redline
+            double shiftSpeed = 0.0;
+
+            // Seconds with the clutch open and off throttle per upshift,
+            // and the clutch engagement ramps that follow the launch and
+            // every shift
+            double shiftTime = 0.25;
+            double launchClutchTime = 0.6;
+            double shiftClutchTime = 0.1;
+        };
+
+        struct Parameters {
+            // The starter is held for starterTime seconds; with shift rules
+            // the launch happens at launchTime
+            double starterTime = 1.0;
+            double launchTime = 2.0;
+
+            // Scripted commands; shift rules are used when empty
+            std::vector<HeadlessRunner::ControlPoint> schedule;
+            ShiftRules shiftRules;
+
+            // Vehicle speeds to time; with stopAtTargets the cycle ends once
+            // all of them are reached, otherwise after maxTime seconds
+            std::vector<double> targetSpeeds;
+            bool stopAtTargets = true;
+            double maxTime = 60.0;
+
+            double frameLength = 1 / 60.0;
+            int threads = 1;
+        };
+
+        struct Shift {
+            double time = 0.0;
+            int fromGear = -1;
+            int toGear = -1;
+            double rpm = 0.0;
+            double speed = 0.0;
+        };
+
+        struct Target {
+            double speed = 0.0;
+            bool reached = false;
+            double time = 0.0;
+            double distance = 0.0;
+        };
+
+        struct Result {
+            bool valid = false;
+            bool launched = false;
+            double launchTime = 0.0;
+
+            std::vector<Target> targets;
+            std::vector<Shift> shifts;
+
+            // Since the launch
+            double fuelMass = 0.0;
+            double distance = 0.0;
+            double finalSpeed = 0.0;
+
+            double simulatedTime = 0.0;
+            double wallTime = 0.0;
+        };
+
+        // Turns shift rules into controls one frame at a time from the
+        // snapshot of the frame before
+        class ShiftController {
+            public:
+                ShiftController();
+                ~ShiftController();
+
+                void initialize(const Parameters &params, int gearCount);
+                HeadlessRunner::ControlPoint update(double t, const SimulationSnapshot &snapshot);
+
+            protected:
+                enum class Phase {
+                    Start,
+                    Launch,
+                    Drive,
+                    Shift,
+                    Engage
+                };
+
+                Parameters m_parameters;
+                int m_gearCount;
+                Phase m_phase;
+                double m_phaseStart;
+                int m_gear;
+        };
+
+        using CreateSimulator = std::function<Simulator *(int variant)>;
+        using ReleaseSimulator = std::function<void(int variant, Simulator *simulator)>;
+
+    public:
+        DriveCycle();
+        ~DriveCycle();
+
+        void initialize(const Parameters &params);
+
+        Result run(Simulator *simulator) const;
+        std::vector<Result> run(int variants, const CreateSimulator &create, const ReleaseSimulator &release) const;
+
+    protected:
+        Parameters m_parameters;
+};
+
+#endif /* ATG_ENGINE_SIM_DRIVE_CYCLE_H */
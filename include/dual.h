@@ -0,0 +1,162 @@
+#ifndef ATG_ENGINE_SIM_DUAL_H
+#define ATG_ENGINE_SIM_DUAL_H
+
+#include <algorithm>
+#include <cmath>
+
+// Forward-mode automatic differentiation scalar: a value and its partial
+// derivatives with respect to N seeded inputs, carried through every
+// operation by the chain rule. A kernel templated on its scalar type and
+// run on Duals yields the value and all N sensitivities in one pass, where
+// finite differences would need 2N runs; see GasSystem::flowRate().
+//
+// Comparisons and branches look at the value only, so a derivative is that
+// of the branch taken; at a kink such as the onset of choked flow it's the
+// one-sided derivative.
+template <int N>
+class Dual {
+    public:
+        static constexpr int Directions = N;
+
+        Dual() : m_value(0.0) { std::fill(m_d, m_d + N, 0.0); }
+        Dual(double value) : m_value(value) { std::fill(m_d, m_d + N, 0.0); }
+
+        // An input: a unit derivative in its own direction
+        static Dual Variable(double value, int direction) {
+            Dual x(value);
+            x.m_d[direction] = 1.0;
+
+            return x;
+        }
+
+        inline double value() const { return m_value; }
+        inline double derivative(int direction) const { return m_d[direction]; }
+        inline double &derivative(int direction) { return m_d[direction]; }
+
+        // f(value) with derivative df scaling every direction
+        inline Dual chain(double f, double df) const {
+            Dual r(f);
+            for (int i = 0; i < N; ++i) r.m_d[i] = df * m_d[i];
+
+            return r;
+        }
+
+        inline Dual operator-() const { return chain(-m_value, -1.0); }
+
+        inline Dual &operator+=(const Dual &b) {
+            m_value += b.m_value;
+            for (int i = 0; i < N; ++i) m_d[i] += b.m_d[i];
+            return *this;
+        }
+
+        inline Dual &operator-=(const Dual &b) {
+            m_value -= b.m_value;
+            for (int i = 0; i < N; ++i) m_d[i] -= b.m_d[i];
+            return *this;
+        }
+
+        inline Dual &operator*=(const Dual &b) {
+            for (int i = 0; i < N; ++i) m_d[i] = m_d[i] * b.m_value + m_value * b.m_d[i];
+            m_value *= b.m_value;
+            return *this;
+        }
+
+        inline Dual &operator/=(const Dual &b) {
+            const double q = m_value / b.m_value;
+            for (int i = 0; i < N; ++i) m_d[i] = (m_d[i] - q * b.m_d[i]) / b.m_value;
+            m_value = q;
+            return *this;
+        }
+
+    protected:
+        double m_value;
+        double m_d[N];
+};
+
+template <int N> inline Dual<N> operator+(Dual<N> a, const Dual<N> &b) { return a += b; }
+template <int N> inline Dual<N> operator-(Dual<N> a, const Dual<N> &b) { return a -= b; }
+template <int N> inline Dual<N> operator*(Dual<N> a, const Dual<N> &b) { return a *= b; }
+template <int N> inline Dual<N> operator/(Dual<N> a, const Dual<N> &b) { return a /= b; }
+
+template <int N> inline Dual<N> operator+(Dual<N> a, double b) { return a += Dual<N>(b); }
+template <int N> inline Dual<N> operator-(Dual<N> a, double b) { return a -= Dual<N>(b); }
+template <int N> inline Dual<N> operator*(const Dual<N> &a, double b) { return a.chain(a.value() * b, b); }
+template <int N> inline Dual<N> operator/(const Dual<N> &a, double b) { return a.chain(a.value() / b, 1.0 / b); }
+
+template <int N> inline Dual<N> operator+(double a, const Dual<N> &b) { return b + a; }
+template <int N> inline Dual<N> operator-(double a, const Dual<N> &b) { return Dual<N>(a) - b; }
+template <int N> inline Dual<N> operator*(double a, const Dual<N> &b) { return b * a; }
+template <int N> inline Dual<N> operator/(double a, const Dual<N> &b) { return Dual<N>(a) / b; }
+
+template <int N> inline bool operator<(const Dual<N> &a, const Dual<N> &b) { return a.value() < b.value(); }
+template <int N> inline bool operator>(const Dual<N> &a, const Dual<N> &b) { return a.value() > b.value(); }
+template <int N> inline bool operator<=(const Dual<N> &a, const Dual<N> &b) { return a.value() <= b.value(); }
+template <int N> inline bool operator>=(const Dual<N> &a, const Dual<N> &b) { return a.value() >= b.value(); }
+template <int N> inline bool operator<(const Dual<N> &a, double b) { return a.value() < b; }
+template <int N> inline bool operator>(const Dual<N> &a, double b) { return a.value() > b; }
+template <int N> inline bool operator<=(const Dual<N> &a, double b) { return a.value() <= b; }
+template <int N> inline bool operator>=(const Dual<N> &a, double b) { return a.value() >= b; }
+template <int N> inline bool operator==(const Dual<N> &a, double b) { return a.value() == b; }
+template <int N> inline bool operator!=(const Dual<N> &a, double b) { return a.value() != b; }
+
+// Found by argument-dependent lookup, so kernels call them unqualified
+// after using std::sqrt and the like
+template <int N>
+inline Dual<N> sqrt(const Dual<N> &x) {
+    const double s = std::sqrt(x.value());
+    return x.chain(s, (s > 0) ? 0.5 / s : 0.0);
+}
+
+template <int N>
+inline Dual<N> pow(const Dual<N> &x, double p) {
+    const double f = std::pow(x.value(), p);
+    return x.chain(f, (x.value() != 0) ? p * f / x.value() : 0.0);
+}
+
+template <int N>
+inline Dual<N> exp(const Dual<N> &x) {
+    const double f = std::exp(x.value());
+    return x.chain(f, f);
+}
+
+template <int N>
+inline Dual<N> log(const Dual<N> &x) {
+    return x.chain(std::log(x.value()), 1.0 / x.value());
+}
+
+template <int N>
+inline Dual<N> sin(const Dual<N> &x) {
+    return x.chain(std::sin(x.value()), std::cos(x.value()));
+}
+
+template <int N>
+inline Dual<N> cos(const Dual<N> &x) {
+    return x.chain(std::cos(x.value()), -std::sin(x.value()));
+}
+
+template <int N>
+inline Dual<N> fabs(const Dual<N> &x) {
+    return (x.value() < 0) ? -x : x;
+}
+
+template <int N>
+inline Dual<N> fmax(const Dual<N> &a, double b) {
+    return (a.value() >= b) ? a : Dual<N>(b);
+}
+
+template <int N>
+inline Dual<N> fmin(const Dual<N> &a, double b) {
+    return (a.value() <= b) ? a : Dual<N>(b);
+}
+
+template <int N>
+inline Dual<N> fmax(const Dual<N> &a, const Dual<N> &b) {
+    return (a.value() >= b.value()) ? a : b;
+}
+
+template <int N>
+inline Dual<N> fmin(const Dual<N> &a, const Dual<N> &b) {
+    return (a.value() <= b.value()) ? a : b;
+}
+
+#endif /* ATG_ENGINE_SIM_DUAL_H */
@@ -0,0 +1,99 @@
+#ifndef ATG_ENGINE_SIM_DYNO_SWEEP_H
+#define ATG_ENGINE_SIM_DYNO_SWEEP_H
+
+#include "headless_runner.h"
+#include "steady_state_detector.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Measures a torque/power curve by holding the dyno at a series of speeds.
+// Every hold point runs on its own simulator, so the points are independent
+// and are spread over the shared JobSystem, at most threads at a time. The
+// callbacks create and release those simulators and are serialized, since
+// script compilation isn't reentrant.
+class DynoSweep {
+    public:
+        struct Parameters {
+            double minRpm = 1000.0;
+            double maxRpm = 6000.0;
+            double stepRpm = 500.0;
+            double throttle = 1.0;
+
+            // With stopWhenSettled a point ends as soon as the detector
+            // reports steady state and is measured over the detector's
+            // window. Otherwise, or if it hasn't settled after settleTime
+            // seconds, torque is averaged over measureCycles more cycles.
+            bool stopWhenSettled = true;
+            SteadyStateDetector::Parameters steadyState;
+            double settleTime = 2.0;
+            int measureCycles = 20;
+
+            double frameLength = 1 / 60.0;
+            int threads = 1;
+
+            // Runs the synthesizer's analyzer so points carry sound metrics
+            bool audioMetrics = false;
+        };
+
+        struct Point {
+            double rpm = 0.0;
+            double torque = 0.0;
+            double power = 0.0;
+            double manifoldPressure = 0.0;
+            double intakeAfr = 0.0;
+
+            // Cylinder 0, over the cycles before the end of the point
+            double imep = 0.0;
+            double imepCoefficientOfVariation = 0.0;
+
+            double simulatedTime = 0.0;
+            double wallTime = 0.0;
+            bool valid = false;
+
+            // Simulated time of the settled event, if there was one
+            bool settled = false;
+            double settledTime = 0.0;
+
+            // As of the end of the point, with audioMetrics
+            bool audioAnalyzed = false;
+            double audioLoudness = 0.0;
+            double audioSpectralCentroid = 0.0;
+            double audioRoughness = 0.0;
+        };
+
+        struct Result {
+            std::vector<Point> points;
+            double wallTime = 0.0;
+        };
+
+        using CreateSimulator = std::function<Simulator *(int point)>;
+        using ReleaseSimulator = std::function<void(int point, Simulator *simulator)>;
+
+    public:
+        DynoSweep();
+        ~DynoSweep();
+
+        void initialize(const Parameters &params);
+        Result run(const CreateSimulator &create, const ReleaseSimulator &release);
+
+        std::vector<double> getHoldPoints() const;
+
+        // Columns: rpm, torque_nm, torque_lb_ft, power_kw, power_hp,
+        // manifold_kpa, intake_afr, imep_kpa, imep_cov, settled_s (empty if
+        // it never settled),
+        // then audio_db, centroid_hz, roughness (empty without audioMetrics)
+        static bool WriteCsv(const std::string &path, const Result &result);
+
+        // The three audio columns, each led by a comma
+        static void WriteAudioColumns(FILE *file, const Point &point);
+
+    protected:
+        Point runPoint(Simulator *simulator, double rpm) const;
+
+        Parameters m_parameters;
+};
+
+#endif /* ATG_ENGINE_SIM_DYNO_SWEEP_H */
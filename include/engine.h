@@ -21,6 +21,8 @@ class Simulator;
 class Vehicle;
 class Transmission;
 class Engine : public Part {
+    friend class EnginePatch;
+
     public:
         struct Parameters {
             int cylinderBanks;
@@ -44,12 +46,30 @@ class Engine : public Part {
             double initialHighFrequencyGain;
             double initialNoise;
             double initialJitter;
+
+            // Splits each chamber's charge into unburned, burned and
+            // crevice zones for end gas temperature and knock; see
+            // ChamberZones
+            bool multiZone = false;
+            double creviceVolume = 0.0;
+            double knockOctane = 95.0;
         };
 
     public:
         Engine();
         virtual ~Engine();
 
+        // Engine-wide sums over the intakes and exhausts, kept by
+        // updateAggregates() so readers don't each scan them
+        struct Aggregates {
+            double manifoldPressure = 0.0;
+            double intakeFlowRate = 0.0;
+            double intakeAfr = 0.0;
+            double exhaustO2 = 0.0;
+            double totalFuelMassConsumed = 0.0;
+        };
+
+    public:
         void initialize(const Parameters &params);
         virtual void destroy();
 
@@ -77,6 +97,12 @@ class Engine : public Part {
         virtual double getTotalFuelMassConsumed() const;
         double getTotalVolumeFuelConsumed() const;
 
+        // The simulator updates the aggregates at the end of every step;
+        // anything else changing the intakes or exhausts between steps
+        // updates them itself
+        void updateAggregates();
+        inline const Aggregates &getAggregates() const { return m_aggregates; }
+
         inline double getStarterTorque() const { return m_starterTorque; }
         inline double getStarterSpeed() const { return m_starterSpeed; }
         inline double getRedline() const { return m_redline; }
@@ -101,17 +127,28 @@ class Engine : public Part {
         Intake *getIntake(int i) const { return &m_intakes[i]; }
         CombustionChamber *getChamber(int i) const { return &m_combustionChambers[i]; }
         Fuel *getFuel() { return &m_fuel; }
+        Throttle *getThrottleModel() const { return m_throttle; }
 
         double getSimulationFrequency() const { return m_initialSimulationFrequency; }
         double getInitialHighFrequencyGain() const { return m_initialHighFrequencyGain; }
         double getInitialNoise() const { return m_initialNoise; }
         double getInitialJitter() const { return m_initialJitter; }
 
-        virtual Simulator *createSimulator(Vehicle *vehicle, Transmission *transmission);
+        bool isMultiZone() const { return m_multiZone; }
+        double getCreviceVolume() const { return m_creviceVolume; }
+        double getKnockOctane() const { return m_knockOctane; }
+
+        virtual Simulator *createSimulator(
+            Vehicle *vehicle,
+            Transmission *transmission,
+            bool reducedKinematics = false,
+            bool audio = true);
 
     protected:
         std::string m_name;
 
+        Aggregates m_aggregates;
+
         Crankshaft *m_crankshafts;
         int m_crankshaftCount;
 
@@ -122,6 +159,7 @@ class Engine : public Part {
         Piston *m_pistons;
         ConnectingRod *m_connectingRods;
         CombustionChamber *m_combustionChambers;
+        CombustionChamber::FluidState *m_chamberFluidStates;
         int m_cylinderCount;
 
         double m_starterTorque;
@@ -136,6 +174,10 @@ class Engine : public Part {
         double m_initialNoise;
         double m_initialJitter;
 
+        bool m_multiZone;
+        double m_creviceVolume;
+        double m_knockOctane;
+
         ExhaustSystem *m_exhaustSystems;
         int m_exhaustSystemCount;
 
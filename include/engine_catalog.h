@@ -0,0 +1,82 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_CATALOG_H
+#define ATG_ENGINE_SIM_ENGINE_CATALOG_H
+
+#include <cinttypes>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Index of the engine scripts under assets/engines, for browsing them
+// without compiling each one. Metadata comes from building the engine once
+// and is cached in an index file keyed by a hash of the script and
+// everything it imports, so only new or edited scripts are built again.
+// Any script defining a main node counts as an engine.
+class EngineCatalog {
+    public:
+        static constexpr int Version = 1;
+
+        struct Entry {
+            // Relative to the assets directory, as main.mr imports it
+            std::string script;
+            uint64_t hash = 0;
+
+            // Metadata below matches the hash; valid if the engine built
+            bool indexed = false;
+            bool valid = false;
+
+            std::string name;
+            int cylinderCount = 0;
+            double displacement = 0.0;
+            double redline = 0.0;
+            std::vector<std::string> impulseResponses;
+        };
+
+    public:
+        EngineCatalog();
+        ~EngineCatalog();
+
+        // Finds the engine scripts and takes what it can from the index;
+        // an empty index path keeps it next to the engines
+        void initialize(const std::string &assetPath, const std::string &indexPath = "");
+
+        // Waits for a refresh in progress
+        void destroy();
+
+        // Builds every entry the index didn't cover, then rewrites the
+        // index; in the background unless told otherwise. Scripting builds
+        // only.
+        void refresh(bool background = true);
+        bool isRefreshing() const;
+
+        std::vector<Entry> getEntries() const;
+        int getEntryCount() const;
+        bool getEntry(int index, Entry *entry) const;
+
+        // Writes a copy of main.mr that imports the entry's engine instead,
+        // next to main.mr so its other imports still resolve, and returns
+        // its path; empty on failure. The tag keeps launchers written for
+        // different purposes apart.
+        std::string writeLauncher(const Entry &entry, const std::string &tag = "catalog") const;
+
+        static std::string Describe(const Entry &entry);
+
+        static bool ReadIndex(const std::string &path, std::vector<Entry> *entries);
+        static bool WriteIndex(const std::string &path, const std::vector<Entry> &entries);
+
+    protected:
+        void indexEntries();
+        bool build(Entry *entry) const;
+        uint64_t hashScript(const std::string &script) const;
+
+        std::string m_assetPath;
+        std::string m_indexPath;
+
+        mutable std::mutex m_lock;
+        std::vector<Entry> m_entries;
+
+        std::thread *m_thread;
+        bool m_refreshing;
+};
+
+#endif /* ATG_ENGINE_SIM_ENGINE_CATALOG_H */
@@ -0,0 +1,101 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_CONTROLLER_H
+#define ATG_ENGINE_SIM_ENGINE_CONTROLLER_H
+
+#include "units.h"
+
+class Engine;
+
+// Engine control unit run by the simulator at its own rate instead of every
+// physics step. Sensors are read in one batch from the engine's aggregates
+// at each control period, and the outputs hold until the next one: fuel
+// trim and idle air on the intakes, and a timing trim and spark cut on the
+// ignition module. The built-in laws are closed-loop fuel trim on the
+// intake AFR, idle speed on idle air and spark, and a rev limiter; each is
+// off until its target is set. Subclasses replace control() for others.
+class EngineController {
+    public:
+        struct Parameters {
+            // Hz of simulated time
+            double controlRate = 1000.0;
+
+            // Integral fuel trim, per second per unit of relative AFR
+            // error; a target of 0 leaves the fuel alone
+            double targetAfr = 0.0;
+            double fuelTrimGain = 2.0;
+            double maxFuelTrim = 0.25;
+
+            // Held with the throttle below idleThrottle: an integral on
+            // idle air, per second per rpm of error, and a proportional
+            // spark correction; 0 is off
+            double idleRpm = 0.0;
+            double idleThrottle = 0.02;
+            double idleAirGain = 0.002 / units::rpm(1.0);
+            double maxIdleAir = 2.0;
+            double idleSparkGain = units::angle(0.02, units::deg) / units::rpm(1.0);
+            double maxIdleSpark = units::angle(10.0, units::deg);
+
+            // Spark is cut above the limit until the engine drops below it
+            // less the hysteresis; 0 is off
+            double revLimit = 0.0;
+            double revLimitHysteresis = units::rpm(200.0);
+        };
+
+        struct Sensors {
+            // rad/s
+            double speed = 0.0;
+
+            // 0 closed to 1 wide open
+            double throttle = 0.0;
+
+            double manifoldPressure = 0.0;
+            double intakeAfr = 0.0;
+            double exhaustO2 = 0.0;
+            double intakeFlowRate = 0.0;
+        };
+
+        struct Outputs {
+            // Fraction of fuel added to what the intakes mix in
+            double fuelTrim = 0.0;
+
+            // Multiplies the idle circuit's flow
+            double idleAir = 1.0;
+
+            // Added to the ignition timing
+            double timingTrim = 0.0;
+            bool sparkCut = false;
+        };
+
+    public:
+        EngineController();
+        virtual ~EngineController();
+
+        void initialize(const Parameters &params);
+
+        // Clears the integrators and applies neutral outputs
+        void reset(Engine *engine);
+
+        // Called every physics step; runs control() once a control period of
+        // steps has accumulated and applies its outputs
+        void step(double dt, Engine *engine);
+
+        static Sensors readSensors(const Engine *engine);
+
+        inline const Parameters &getParameters() const { return m_parameters; }
+        inline const Sensors &getSensors() const { return m_sensors; }
+        inline const Outputs &getOutputs() const { return m_outputs; }
+        inline long long getControlCount() const { return m_controlCount; }
+
+    protected:
+        virtual void control(double dt, const Sensors &sensors, Outputs *outputs);
+        void apply(Engine *engine) const;
+
+        Parameters m_parameters;
+        Sensors m_sensors;
+        Outputs m_outputs;
+
+        double m_period;
+        double m_elapsed;
+        long long m_controlCount;
+};
+
+#endif /* ATG_ENGINE_SIM_ENGINE_CONTROLLER_H */
@@ -0,0 +1,51 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_DEFINITION_H
+#define ATG_ENGINE_SIM_ENGINE_DEFINITION_H
+
+#include "engine_snapshot.h"
+#include "mapped_file.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <string>
+
+class EngineInstance;
+
+// The immutable half of an engine: a snapshot kept mapped in memory with the
+// functions, baked curves and lobe tables every engine built from it points
+// at. Each EngineInstance only owns the parts that change while it runs, so
+// a hundred instances of one engine hold one copy of its tables and never
+// go back to the file. Instances are built on one thread at a time but may
+// be destroyed on any, and must all be destroyed before the definition.
+class EngineDefinition {
+    public:
+        EngineDefinition();
+        ~EngineDefinition();
+
+        // Validates the snapshot, fills the shared tables and keeps the file
+        // mapped for later instances
+        bool load(const std::string &snapshotPath);
+        void destroy();
+
+        // False if nothing is loaded or the build fails; the vehicle and
+        // transmission are left null if the snapshot has none
+        bool instantiate(EngineInstance *instance);
+
+        bool isLoaded() const { return m_loaded; }
+        const std::string &getSnapshotPath() const { return m_snapshotPath; }
+        uint64_t getStructureHash() const { return m_structureHash; }
+        int getInstanceCount() const { return m_instanceCount.load(std::memory_order_acquire); }
+
+        const EngineSnapshot::SharedTables &getSharedTables() const { return m_tables; }
+
+    protected:
+        friend class EngineInstance;
+
+        std::string m_snapshotPath;
+        MappedFile m_file;
+        EngineSnapshot::SharedTables m_tables;
+        uint64_t m_structureHash;
+        std::atomic<int> m_instanceCount;
+        bool m_loaded;
+};
+
+#endif /* ATG_ENGINE_SIM_ENGINE_DEFINITION_H */
@@ -0,0 +1,45 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_INSTANCE_H
+#define ATG_ENGINE_SIM_ENGINE_INSTANCE_H
+
+class Engine;
+class EngineDefinition;
+class Simulator;
+class Transmission;
+class Vehicle;
+
+// The mutable half of an engine built by EngineDefinition: its parts, rigid
+// bodies and gas state, the vehicle and transmission, and the simulator once
+// one is attached. Everything read-only is borrowed from the definition.
+class EngineInstance {
+    public:
+        EngineInstance();
+        ~EngineInstance();
+
+        // Releases the simulator, if any, then the engine and drivetrain
+        void destroy();
+
+        // Takes ownership; only one simulator per instance
+        void setSimulator(Simulator *simulator);
+
+        // Fills in a vehicle or transmission the snapshot left out, taking
+        // ownership; pass null for one it has
+        void setDrivetrain(Vehicle *vehicle, Transmission *transmission);
+
+        bool isLive() const { return m_engine != nullptr; }
+        const EngineDefinition *getDefinition() const { return m_definition; }
+        Engine *getEngine() const { return m_engine; }
+        Vehicle *getVehicle() const { return m_vehicle; }
+        Transmission *getTransmission() const { return m_transmission; }
+        Simulator *getSimulator() const { return m_simulator; }
+
+    protected:
+        friend class EngineDefinition;
+
+        EngineDefinition *m_definition;
+        Engine *m_engine;
+        Vehicle *m_vehicle;
+        Transmission *m_transmission;
+        Simulator *m_simulator;
+};
+
+#endif /* ATG_ENGINE_SIM_ENGINE_INSTANCE_H */
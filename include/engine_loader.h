@@ -0,0 +1,171 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_LOADER_H
+#define ATG_ENGINE_SIM_ENGINE_LOADER_H
+
+#include "application_settings.h"
+#include "artifact_cache.h"
+#include "cost_estimate.h"
+#include "fidelity_calibration.h"
+#include "impulse_response_cache.h"
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/script_sources.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+#include <cinttypes>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Engine;
+class Vehicle;
+class Transmission;
+class Simulator;
+
+// Compiles a script, builds its engine and a simulator with impulse responses
+// loaded and the audio thread running, all on a background thread, so the
+// main loop only has to swap the result in. Simulators being replaced are
+// torn down on the same thread. Scripts whose sources were compiled before
+// are read back from the artifact cache instead of being run again.
+class EngineLoader {
+    public:
+        struct Request {
+            std::string assetPath;
+            std::string scriptPath;
+
+            // Applied to the simulator unless the script provides its own
+            ApplicationSettings settings;
+
+            // Frames simulated before the result is handed over, so first
+            // step allocations and thread start-up aren't paid by the main
+            // loop; their audio is discarded
+            int warmupFrames = 4;
+
+            // Rate the synthesizer renders at, and whether it gets its own
+            // thread; hosts that pull audio (plugins) turn the thread off
+            // and render with Synthesizer::renderPendingAudio()
+            double audioSampleRate = 44100;
+            bool audioThread = true;
+
+            // Structure of the engine being replaced; a matching result is
+            // returned without a simulator for EnginePatch to apply
+            bool patchable = false;
+            uint64_t structureHash = 0;
+
+            // Calibrates the new simulator even if the settings don't ask to
+            bool calibrateFidelity = false;
+
+            // Hash of the sources already running; a load whose sources
+            // still hash the same comes back unchanged without compiling.
+            // 0 always loads.
+            uint64_t unchangedSourcesHash = 0;
+        };
+
+        struct Result {
+            Engine *engine = nullptr;
+            Vehicle *vehicle = nullptr;
+            Transmission *transmission = nullptr;
+            Simulator *simulator = nullptr;
+
+            // Same structure as the requested engine; no simulator was made
+            bool patch = false;
+
+            // For a patch, the engine's impulse responses decoded at the
+            // requested audio rate, one per exhaust, for EnginePatch::Apply()
+            std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> impulseResponses;
+
+            // The sources matched unchangedSourcesHash; nothing was made
+            bool unchanged = false;
+
+            // Read from the compiled script cache rather than by running
+            // the script; the engine came from EngineSnapshot::read()
+            bool cached = false;
+
+            // Set when settings came from the script
+            bool configured = false;
+            ApplicationSettings settings;
+
+            // Set when the simulator's fidelity was calibrated
+            FidelityCalibration::Result calibration;
+
+            // Predicted load of the simulator as it was made
+            CostEstimate::Report cost;
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+            // The script and its imports, collected on the loader thread
+            es_script::ScriptSources sources;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+        };
+
+    public:
+        EngineLoader();
+        ~EngineLoader();
+
+        void initialize();
+
+        // Waits for the job in progress, then releases unclaimed results
+        // and anything still waiting to be retired
+        void destroy();
+
+        // Only one load runs at a time; a request made while one is running
+        // replaces any request still queued behind it
+        void request(const Request &request);
+        bool isLoading() const;
+
+        // Hands over the most recent finished load, even one without an
+        // engine so the caller can report the failure
+        bool takeResult(Result *result);
+
+        // Blocks until the load in progress finishes; false when nothing
+        // was requested
+        bool waitForResult(Result *result);
+
+        // Releases a replaced result on the loader thread
+        void retire(const Result &result);
+
+        // Synchronous versions of what the loader thread does
+        static Result Load(const Request &request);
+        static Simulator *CreateSimulator(
+            Engine *engine,
+            Vehicle *vehicle,
+            Transmission *transmission,
+            const ApplicationSettings &settings,
+            double audioSampleRate = 44100,
+            bool audioThread = true,
+            FidelityCalibration::Result *calibration = nullptr);
+
+        // Installs the engine's impulse responses at the simulator's audio
+        // rate; the audio thread must not be running
+        static void LoadImpulseResponses(Simulator *simulator, Engine *engine);
+        static void Release(Result *result);
+
+        // A compiled script as the artifact cache keeps it: the settings it
+        // set followed by a snapshot of the engine, vehicle and transmission
+        // it built, addressed by the hash of its sources. Reading marks the
+        // result cached.
+        static ArtifactCache::Key CompiledScriptKey(uint64_t sourcesHash);
+        static bool WriteCompiledScript(const Result &result, std::vector<char> *data);
+        static bool ReadCompiledScript(const char *data, size_t size, Result *result);
+
+    protected:
+        void worker();
+
+        std::thread *m_thread;
+        bool m_run;
+
+        mutable std::mutex m_lock;
+        std::condition_variable m_cv;
+
+        bool m_pending;
+        bool m_loading;
+        Request m_request;
+
+        bool m_ready;
+        Result m_result;
+
+        std::vector<Result> m_retired;
+};
+
+#endif /* ATG_ENGINE_SIM_ENGINE_LOADER_H */
@@ -0,0 +1,45 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_PATCH_H
+#define ATG_ENGINE_SIM_ENGINE_PATCH_H
+
+#include "impulse_response_cache.h"
+
+#include <memory>
+#include <vector>
+
+class Simulator;
+class Engine;
+class Vehicle;
+class Transmission;
+
+// Applies the tunable parameters of a freshly compiled engine to the one a
+// simulator is running: function tables (timing curves, flow tables, lobe
+// profiles), the ignition timing map and trims, impulse responses and audio
+// levels. Only valid when both engines share a structure, which is checked
+// through EngineSnapshot::hashStructure(); anything else needs a new
+// simulator.
+class EnginePatch {
+    public:
+        struct Statistics {
+            int functions = 0;
+            int impulseResponses = 0;
+            bool ignition = false;
+            bool audio = false;
+        };
+
+    public:
+        // Fails without touching the simulator if the structures differ, or
+        // if impulseResponses doesn't hold a kernel slot for every exhaust
+        // of the source. The kernels are decoded by the caller, off the main
+        // thread (see EngineLoader::Result), and swapped in while audio keeps
+        // rendering. Must be called between frames; the source engine is
+        // left as it was
+        static bool Apply(
+            Simulator *simulator,
+            Engine *source,
+            Vehicle *vehicle,
+            Transmission *transmission,
+            const std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> &impulseResponses,
+            Statistics *statistics);
+};
+
+#endif /* ATG_ENGINE_SIM_ENGINE_PATCH_H */
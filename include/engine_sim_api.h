@@ -0,0 +1,114 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_SIM_API_H
+#define ATG_ENGINE_SIM_ENGINE_SIM_API_H
+
+/*
+ * C interface for embedding the simulator in a host application such as a
+ * game engine. Nothing here starts a thread unless the config asks for one:
+ * the host advances the physics with engine_sim_step() from its own loop and
+ * pulls mono float audio with engine_sim_render() from its audio callback,
+ * which is where synthesis then runs.
+ *
+ * The control setters may be called from any thread and are picked up at
+ * the start of the next step. engine_sim_step() and engine_sim_render() may
+ * each be called from one thread at a time, and those may be different
+ * threads; with drive_from_render set only engine_sim_render() is used.
+ */
+
+#ifdef _WIN32
+#ifdef ATG_ENGINE_SIM_API_EXPORTS
+#define ENGINE_SIM_API __declspec(dllexport)
+#else
+#define ENGINE_SIM_API
+#endif /* ATG_ENGINE_SIM_API_EXPORTS */
+#else
+#define ENGINE_SIM_API __attribute__((visibility("default")))
+#endif /* _WIN32 */
+
+#define ENGINE_SIM_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct engine_sim_instance engine_sim_instance;
+
+typedef enum engine_sim_result {
+    ENGINE_SIM_OK = 0,
+    ENGINE_SIM_ERROR_ARGUMENT = 1,
+    ENGINE_SIM_ERROR_LOAD = 2,
+    ENGINE_SIM_ERROR_NO_SCRIPTING = 3
+} engine_sim_result;
+
+typedef struct engine_sim_config {
+    /* Repository root holding es/ and assets/; used to resolve scripts */
+    const char *asset_path;
+
+    /* Exactly one of the two; a snapshot skips the script runtime */
+    const char *script_path;
+    const char *snapshot_path;
+
+    /* Zero builds a physics-only simulator; engine_sim_render() then
+       writes silence */
+    int audio;
+
+    /* Starts the simulator's own audio thread; engine_sim_render() then
+       only reads what it produced */
+    int audio_thread;
+
+    /* engine_sim_render() advances the physics by the audio it is asked
+       for, so the host's audio callback is the only clock; needs audio */
+    int drive_from_render;
+
+    unsigned long long seed;
+} engine_sim_config;
+
+typedef struct engine_sim_telemetry {
+    double time;
+    double rpm;
+    double redline;
+    double manifold_pressure_pa;
+    double dyno_torque_nm;
+    double dyno_power_w;
+    double speed_mps;
+    int gear;
+    double clutch;
+} engine_sim_telemetry;
+
+ENGINE_SIM_API int engine_sim_api_version(void);
+ENGINE_SIM_API void engine_sim_default_config(engine_sim_config *config);
+
+ENGINE_SIM_API engine_sim_result engine_sim_create(
+    const engine_sim_config *config,
+    engine_sim_instance **instance);
+ENGINE_SIM_API void engine_sim_destroy(engine_sim_instance *instance);
+
+/* Throttle and clutch pressure are 0..1; gear -1 is neutral */
+ENGINE_SIM_API void engine_sim_set_throttle(engine_sim_instance *instance, double throttle);
+ENGINE_SIM_API void engine_sim_set_clutch(engine_sim_instance *instance, double clutch);
+ENGINE_SIM_API void engine_sim_set_gear(engine_sim_instance *instance, int gear);
+ENGINE_SIM_API void engine_sim_set_ignition(engine_sim_instance *instance, int enabled);
+ENGINE_SIM_API void engine_sim_set_starter(engine_sim_instance *instance, int enabled);
+
+/* Holds the crankshaft at rpm, clamped to the engine's dyno range */
+ENGINE_SIM_API void engine_sim_set_dyno(engine_sim_instance *instance, int enabled, double rpm);
+
+/* Advances the physics by dt seconds of simulated time */
+ENGINE_SIM_API void engine_sim_step(engine_sim_instance *instance, double dt);
+
+/* Fills frames mono samples and returns how many came from the simulation;
+   the rest repeat the last engine cycle where there is one and are zeroed
+   otherwise */
+ENGINE_SIM_API int engine_sim_render(engine_sim_instance *instance, float *out, int frames);
+
+ENGINE_SIM_API int engine_sim_get_sample_rate(const engine_sim_instance *instance);
+
+/* Latest published frame; call from one thread at a time */
+ENGINE_SIM_API void engine_sim_get_telemetry(
+    engine_sim_instance *instance,
+    engine_sim_telemetry *telemetry);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ATG_ENGINE_SIM_ENGINE_SIM_API_H */
@@ -2,6 +2,10 @@
 #define ATG_ENGINE_SIM_ENGINE_SIM_APPLICATION_H
 
 #include "geometry_generator.h"
+#include "draw_batcher.h"
+#include "part_instancer.h"
+#include "parallel_geometry.h"
+#include "text_layout_cache.h"
 #include "simulator.h"
 #include "engine.h"
 #include "simulation_object.h"
@@ -17,15 +21,31 @@
 #include "synthesizer.h"
 #include "oscilloscope_cluster.h"
 #include "performance_cluster.h"
+#include "performance_hud.h"
 #include "load_simulation_cluster.h"
 #include "mixer_cluster.h"
 #include "info_cluster.h"
 #include "application_settings.h"
 #include "transmission.h"
+#include "engine_loader.h"
+#include "engine_catalog.h"
+#include "file_watcher.h"
+#include "physics_thread.h"
+#include "control_surface.h"
+#include "render_scheduler.h"
+#include "latency_probe.h"
+#include "speculative_lookahead.h"
+#include "telemetry_export.h"
+#include "flight_recorder.h"
+#include "video_capture.h"
 
 #include "delta.h"
 #include "dtv.h"
 
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/script_sources.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
 #include <vector>
 
 class EngineSimApplication {
@@ -53,11 +73,24 @@ class EngineSimApplication {
                 const GeometryGenerator::GeometryIndices &indices,
                 int layer,
                 dbasic::StageEnableFlags flags);
+
+        // UI shapes are batched; call before drawing text or models over them
+        void flushDraws();
+
         void configure(const ApplicationSettings &settings);
-        GeometryGenerator *getGeometryGenerator() { return &m_geometryGenerator; }
+        double outputLeadTime() const;
+        // The calling thread's generator while ParallelGeometry runs it
+        GeometryGenerator *getGeometryGenerator() {
+            GeometryGenerator *target = GeometryGenerator::GetThreadTarget();
+            return (target != nullptr) ? target : &m_geometryGenerator;
+        }
+
+        ParallelGeometry *getParallelGeometry() { return &m_parallelGeometry; }
+        PartInstancer *getPartInstancer() { return &m_partInstancer; }
 
         Shaders *getShaders() { return &m_shaders; }
         dbasic::TextRenderer *getTextRenderer() { return &m_textRenderer; }
+        TextLayoutCache *getTextLayoutCache() { return &m_textLayoutCache; }
 
         void createObjects(Engine *engine);
         void destroyObjects();
@@ -66,6 +99,14 @@ class EngineSimApplication {
         float pixelsToUnits(float pixels) const;
         float unitsToPixels(float units) const;
 
+        // Engine units a screen pixel covers at the current zoom, in half
+        // octave steps so the static shapes are only cut again on a visible
+        // change; curve edges are sized with it
+        float viewPixelsToUnits(float pixels) const;
+
+        // Engine area on screen, with a margin; parts outside it are culled
+        Bounds getViewBounds() const;
+
         ysVector getBackgroundColor() const { return m_background; }
         ysVector getForegroundColor() const { return m_foreground; }
         ysVector getHightlight1Color() const { return m_highlight1; }
@@ -89,11 +130,69 @@ class EngineSimApplication {
         ApplicationSettings* getAppSettings() { return &m_applicationSettings; }
 
     protected:
+        // Blocks until the first load is in; reloads go through
+        // m_engineLoader instead
         void loadScript();
+        EngineLoader::Request createLoadRequest() const;
+
+        // Once the first samples are written for the device
+        void finishStartupTimeline();
+
+        // Spans captured since the last dump, into the trace session
+        void writeProfileTrace();
+
+        // Watches every file the loaded script was built from
+        void updateScriptWatch();
+
+        // Moves the catalog selection and preloads the engine it lands on
+        void selectCatalogEntry(int step);
+        void switchToPreloaded();
+
+        // Swaps in a finished load; a result without a simulator is
+        // released and the current engine kept
+        void installEngine(const EngineLoader::Result &result);
+
+        // Applies a result with the running engine's structure in place,
+        // keeping the simulation state; false if it has to be rebuilt
+        bool patchEngine(const EngineLoader::Result &result);
+
+        // Device buffer, source and the float staging buffers, sized one
+        // second at m_audioSampleRate
+        void initializeAudioOutput();
+        void destroyAudioOutput();
+
+        // Re-renders the synthesizer natively at a new device rate; only the
+        // audio path is rebuilt, the simulation carries on
+        void reconfigureAudioSampleRate(int sampleRate);
+
+        // Crossfades the replaced simulator's remaining output into the
+        // samples just read; returns the number of samples now in
+        // m_audioOutput
+        int mixRetiringOutput(int samples, int capacity);
         void processEngineInput();
         void renderScene();
 
+        // Parks the physics thread and script watcher and renders on demand;
+        // pausing fades the device output to silence and stops the source
+        // once the fade has played
+        void setPaused(bool paused);
+        void fadeOutAudio();
+
+        // Branch simulators for the speculativeLookahead setting load one at
+        // a time on m_branchLoader, after every install or patch
+        EngineLoader::Request createLookaheadRequest() const;
+        void requestLookaheadBranches();
+        void takeLookaheadBranch(const EngineLoader::Result &result);
+        void releaseLookaheadBranches();
+
+        // Drops the simulator to preview fidelity when a parameter changes
+        // and back to full once none has for PreviewSettleTime seconds; both
+        // run with the physics state lock held
+        void notifyParameterChange();
+        void updateFidelity();
+
         void refreshUserInterface();
+        void layoutUserInterface(int screenWidth, int screenHeight);
 
     protected:
         double m_speedSetting = 1.0;
@@ -103,11 +202,23 @@ class EngineSimApplication {
         double m_targetClutchPressure = 1.0;
         int m_lastMouseWheel = 0;
 
+        // When this frame's input was sampled, before waiting on the physics
+        // thread; control events are stamped with it
+        ControlQueue::Clock::time_point m_inputTime;
+
     protected:
         virtual void initialize();
         virtual void process(float dt);
         virtual void render();
 
+        // Regenerates the retained part shapes if the engine or the view
+        // scale changed; true if they have to be uploaded again
+        bool updateStaticGeometry();
+
+        // Recreates the GPU geometry buffers once the generator has grown
+        // past them; true if they were recreated and need a full upload
+        bool resizeGeometryBuffers();
+
         float m_displayAngle;
         float m_displayHeight;
         int m_gameWindowHeight;
@@ -123,14 +234,33 @@ class EngineSimApplication {
 
         std::string m_assetPath;
 
+        // Script the engine is loaded from; main.mr unless a catalog entry
+        // was switched to
+        std::string m_scriptPath;
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+        // Content hashes of the loaded script and its imports
+        es_script::ScriptSources m_loadedScriptSources;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
         ysRenderTarget *m_mainRenderTarget;
         ysGPUBuffer *m_geometryVertexBuffer;
         ysGPUBuffer *m_geometryIndexBuffer;
+        int m_geometryVertexCapacity;
+        int m_geometryIndexCapacity;
 
         GeometryGenerator m_geometryGenerator;
+        DrawBatcher m_drawBatcher;
+        PartInstancer m_partInstancer;
+        ParallelGeometry m_parallelGeometry;
+        bool m_staticGeometryValid;
+        float m_staticGeometryScale;
+        float m_staticGeometryPixel;
         dbasic::TextRenderer m_textRenderer;
+        TextLayoutCache m_textLayoutCache;
 
         std::vector<SimulationObject *> m_objects;
+        std::vector<SimulationObject *> m_visibleObjects;
         Engine *m_iceEngine;
         Vehicle *m_vehicle;
         Transmission *m_transmission;
@@ -144,12 +274,17 @@ class EngineSimApplication {
         OscilloscopeCluster *m_oscCluster;
         CylinderTemperatureGauge *m_temperatureGauge;
         PerformanceCluster *m_performanceCluster;
+        PerformanceHud *m_performanceHud;
         LoadSimulationCluster *m_loadSimulationCluster;
         MixerCluster *m_mixerCluster;
         InfoCluster *m_infoCluster;
         SimulationObject::ViewParameters m_viewParameters;
 
         bool m_paused;
+        bool m_autoPaused;
+        bool m_audioStopPending;
+        std::chrono::steady_clock::time_point m_audioStopTime;
+        bool m_showPerformanceHud;
 
     protected:
         void startRecording();
@@ -159,11 +294,23 @@ class EngineSimApplication {
         void recordFrame();
         bool isRecording() const { return m_recording; }
 
+        void processOfflineAudio();
+        void sampleAudioScope(int readSamples);
+
+        // Of the frame being processed: fixed while rendering offline
+        float getFrameLength();
+
         static constexpr int ScreenResolutionHistoryLength = 5;
         int m_screenResolution[ScreenResolutionHistoryLength][2];
         int m_screenResolutionIndex;
         bool m_recording;
 
+        // Set by the renderVideo setting of the first engine installed;
+        // counts the frames captured so far
+        bool m_offlineRender;
+        long long m_offlineRenderFrames;
+        std::vector<int16_t> m_offlineAudio;
+
         ysVector m_background;
         ysVector m_foreground;
         ysVector m_shadow;
@@ -181,11 +328,81 @@ class EngineSimApplication {
         AudioBuffer m_audioBuffer;
         ysAudioSource *m_audioSource;
 
+        // Output device's rate, which the synthesizer renders at
+        int m_audioSampleRate;
+
         int m_oscillatorSampleOffset;
+
+        // One device buffer of float output awaiting quantization
+        float *m_audioOutput;
+
+        // The replaced simulator fades out over 50 ms after a reload
+        static constexpr int CrossfadeSamples = 2205;
+        EngineLoader m_engineLoader;
+        FileWatcher m_scriptWatcher;
+
+        // Page Up/Down browse the catalog and build the selection on
+        // m_catalogLoader, so End can switch to it without waiting
+        EngineCatalog m_engineCatalog;
+        EngineLoader m_catalogLoader;
+        EngineLoader::Result m_preloaded;
+        bool m_hasPreloaded;
+        int m_catalogSelection;
+        std::string m_preloadedScript;
+
+        // Only running with the threadedPhysics setting
+        PhysicsThread m_physicsThread;
+
+        // Opened by configure() when the settings name a MIDI device or an
+        // OSC port; controls it has moved are left out of
+        // processEngineInput() until their keys are used again
+        ControlSurface m_controlSurface;
+        std::string m_controlSurfaceMidi;
+        int m_controlSurfaceOscPort;
+
+        // Opened by configure() when the settings name one
+        TelemetryExport m_telemetryExport;
+        std::string m_telemetryExportName;
+        int m_telemetryExportDecimation;
+
+        // Attached to each installed engine while a trace session runs, so
+        // F10 and anomalies dump the last physics steps with the trace
+        FlightRecorder m_flightRecorder;
+
+        // Covers the first engine installed with the recordInput or
+        // replayInput setting, and ends when it's replaced
+        InputSession m_inputSession;
+        bool m_inputSessionStarted;
+
+        // The output device's os_workgroup_t on macOS, joined by real-time
+        // audio threads
+        void *m_audioWorkgroup;
+        RenderScheduler m_renderScheduler;
+        LatencyProbe m_latencyProbe;
+
+        SpeculativeLookahead m_lookahead;
+        EngineLoader m_branchLoader;
+        EngineLoader::Result m_lookaheadBranches[SpeculativeLookahead::FutureCount];
+        int m_lookaheadBranchCount;
+
+        // The load in flight was requested for an engine since replaced
+        bool m_lookaheadBranchStale;
+
+        static constexpr double PreviewSettleTime = 0.75;
+        std::chrono::steady_clock::time_point m_lastParameterChange;
+        EngineLoader::Result m_retiring;
+        float *m_retiringAudioOutput;
+        int m_crossfadePosition;
+
         int m_screen;
 
+        // Screen mode and window size the cluster bounds were computed for
+        int m_layoutScreen;
+        int m_layoutWidth;
+        int m_layoutHeight;
+
 #ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
-        atg_dtv::Encoder m_encoder;
+        VideoCapture m_videoCapture;
 #endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
 };
 
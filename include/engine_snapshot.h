@@ -0,0 +1,122 @@
+#ifndef ATG_ENGINE_SIM_ENGINE_SNAPSHOT_H
+#define ATG_ENGINE_SIM_ENGINE_SNAPSHOT_H
+
+#include "camshaft.h"
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+class Engine;
+class Vehicle;
+class Transmission;
+class Function;
+class ImpulseResponse;
+
+// Versioned binary image of a fully built engine, vehicle and transmission.
+// Written once from a compiled script so later runs can rebuild the same
+// objects without the script runtime. Shared objects (functions, camshafts,
+// impulse responses) are stored once and referenced by index.
+class EngineSnapshot {
+    public:
+        static constexpr uint32_t Magic = 0x4E534545; // "EESN"
+        static constexpr uint32_t Version = 5;
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t payloadSize;
+            // FNV-1a of the payload
+            uint64_t checksum;
+        };
+
+        // Read-only tables of one snapshot, kept across the engines read
+        // from it so they point at one copy: the functions, with their
+        // baked curves, and the baked camshaft lobes. The first read fills
+        // them and the rest reuse them. The tables must outlive every
+        // engine read with them, are not thread-safe, and a function
+        // patched in place changes every engine using it.
+        class SharedTables {
+            public:
+                SharedTables();
+                ~SharedTables();
+
+                void release();
+
+                int getFunctionCount() const { return static_cast<int>(m_functions.size()); }
+                const Function *getFunction(int index) const { return m_functions[index]; }
+                int getLobeCount() const { return static_cast<int>(m_lobes.size()); }
+
+            protected:
+                friend class EngineSnapshot;
+
+                std::vector<Function *> m_functions;
+                std::vector<Camshaft::BakedLobe> m_lobes;
+                bool m_filled;
+        };
+
+    public:
+        // Vehicle and transmission may be null and are then left out
+        static bool write(
+            const std::string &path,
+            Engine *engine,
+            Vehicle *vehicle,
+            Transmission *transmission);
+
+        // The same bytes as the file, into memory
+        static bool write(
+            std::vector<char> *data,
+            Engine *engine,
+            Vehicle *vehicle,
+            Transmission *transmission);
+
+        // Maps the file and initializes new objects straight from it; the
+        // vehicle or transmission come back null if the snapshot has none.
+        // Impulse responses only keep their file names, which are not loaded.
+        static bool read(
+            const std::string &path,
+            Engine **engine,
+            Vehicle **vehicle,
+            Transmission **transmission);
+
+        // As above, sharing tables with every other engine read with the
+        // same shared tables, which must only ever see one snapshot
+        static bool read(
+            const std::string &path,
+            Engine **engine,
+            Vehicle **vehicle,
+            Transmission **transmission,
+            SharedTables *shared);
+
+        // From a whole snapshot file already in memory, as the above
+        static bool read(
+            const char *data,
+            size_t size,
+            Engine **engine,
+            Vehicle **vehicle,
+            Transmission **transmission,
+            SharedTables *shared = nullptr);
+
+        // Frees what read() leaves alive for an engine's lifetime: its
+        // camshafts, valvetrains, impulse responses and functions, less
+        // those owned by shared. Only for engines that came from read(),
+        // before their own destroy().
+        static void releaseTables(Engine *engine, const SharedTables *shared = nullptr);
+
+        // FNV-1a of what a snapshot would store, less function samples,
+        // impulse responses and audio levels; engines with equal hashes
+        // only differ in what EnginePatch applies in place
+        static bool hashStructure(
+            Engine *engine,
+            Vehicle *vehicle,
+            Transmission *transmission,
+            uint64_t *hash);
+
+        // Shared objects in the order a snapshot stores them
+        static void collectFunctions(Engine *engine, std::vector<Function *> *functions);
+        static void collectImpulseResponses(
+            Engine *engine,
+            std::vector<ImpulseResponse *> *impulseResponses);
+};
+
+#endif /* ATG_ENGINE_SIM_ENGINE_SNAPSHOT_H */
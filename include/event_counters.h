@@ -0,0 +1,65 @@
+#ifndef ATG_ENGINE_SIM_EVENT_COUNTERS_H
+#define ATG_ENGINE_SIM_EVENT_COUNTERS_H
+
+#include <cinttypes>
+
+// Counts of the events behind a step's cost (gas flows and how many were
+// choked, flow clamps, solver steps, ignitions, audio ring underruns and
+// overruns, convolved samples) when the library is built with
+// ATG_ENGINE_SIM_COUNT_EVENTS (CMake: ENGINE_SIM_COUNT_EVENTS=ON); otherwise
+// ATG_ENGINE_SIM_COUNT() compiles to nothing and every total is zero.
+//
+// Like the step profiler, each thread adds into its own slot without
+// locking and readers sum the slots. Totals only grow; callers difference
+// two reads to get a frame's or a run's counts.
+class EventCounters {
+public:
+    enum class Counter {
+        GasFlows,
+        ChokedFlows,
+
+        // Flows into a fixed environment cut back to pressure equilibrium
+        EquilibriumClamps,
+
+        // Rigid body system solves; the Gauss-Seidel iterations within one
+        // are internal to the solver library
+        SolverSteps,
+
+        IgnitionEvents,
+        AudioUnderruns,
+        AudioOverruns,
+        ConvolutionSamples,
+        Count
+    };
+
+    static constexpr int CounterCount = static_cast<int>(Counter::Count);
+
+    struct Totals {
+        uint64_t values[CounterCount] = {};
+
+        uint64_t get(Counter counter) const { return values[static_cast<int>(counter)]; }
+        Totals since(const Totals &earlier) const;
+
+        double chokedFraction() const {
+            const uint64_t flows = get(Counter::GasFlows);
+            return (flows > 0) ? static_cast<double>(get(Counter::ChokedFlows)) / flows : 0.0;
+        }
+    };
+
+public:
+    static bool IsEnabled();
+    static const char *GetName(Counter counter);
+
+    static void Add(Counter counter, uint64_t n);
+
+    // Summed over every thread since start
+    static void GetTotals(Totals *totals);
+};
+
+#if defined(ATG_ENGINE_SIM_COUNT_EVENTS)
+#define ATG_ENGINE_SIM_COUNT(counter, n) EventCounters::Add(EventCounters::Counter::counter, (n))
+#else
+#define ATG_ENGINE_SIM_COUNT(counter, n) ((void)0)
+#endif /* ATG_ENGINE_SIM_COUNT_EVENTS */
+
+#endif /* ATG_ENGINE_SIM_EVENT_COUNTERS_H */
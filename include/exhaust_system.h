@@ -8,6 +8,8 @@
 
 class ExhaustSystem : public Part {
     friend class Engine;
+    friend class EnginePatch;
+    friend class SimulationCheckpoint;
 
     public:
         struct Parameters {
@@ -19,6 +21,9 @@ class ExhaustSystem : public Part {
             double velocityDecay;
             double audioVolume;
             ImpulseResponse *impulseResponse;
+
+            // Cells the primary is resolved into; 0 lumps it into the runner
+            int primarySegments = 0;
         };
 
     public:
@@ -28,22 +33,31 @@ class ExhaustSystem : public Part {
         void initialize(const Parameters &params);
         virtual void destroy();
 
-        void process(double dt);
+        // Builds the outlet's flow parameters for the substeps of one step
+        void prepare(double dt);
+        void process();
+
+        // Ambient pressure and temperature at the tailpipe
+        void setAtmosphere(double P, double T);
+        inline double getAtmospherePressure() const { return m_atmosphere.P; }
+        inline double getAtmosphereTemperature() const { return m_atmosphere.T; }
 
         inline int getIndex() const { return m_index; }
         inline double getLength() const { return m_length; }
         inline double getFlow() const { return m_flow; }
         inline double getAudioVolume() const { return m_audioVolume; }
         inline double getPrimaryFlowRate() const { return m_primaryFlowRate; }
+        inline double getOutletFlowRate() const { return m_outletFlowRate; }
         inline double getCollectorCrossSectionArea() const { return m_collectorCrossSectionArea; }
         inline double getPrimaryTubeLength() const { return m_primaryTubeLength; }
         inline double getVelocityDecay() const { return m_velocityDecay; }
+        inline int getPrimarySegments() const { return m_primarySegments; }
         inline ImpulseResponse *getImpulseResponse() const { return m_impulseResponse; }
 
         inline GasSystem *getSystem() { return &m_system; }
 
     protected:
-        GasSystem m_atmosphere;
+        GasSystem::Reservoir m_atmosphere;
         GasSystem m_system;
 
         ImpulseResponse *m_impulseResponse;
@@ -55,9 +69,13 @@ class ExhaustSystem : public Part {
         double m_outletFlowRate;
         double m_audioVolume;
         double m_velocityDecay;
+        int m_primarySegments;
         int m_index;
 
         double m_flow;
+
+        // Set by prepare()
+        GasSystem::ReservoirFlowParameters m_outletFlow;
 };
 
 #endif /* ATG_ENGINE_SIM_EXHAUST_SYSTEM_H */
@@ -0,0 +1,30 @@
+#ifndef ATG_ENGINE_SIM_FFT_H
+#define ATG_ENGINE_SIM_FFT_H
+
+#include <complex>
+
+class Fft {
+    public:
+        Fft();
+        ~Fft();
+
+        // size must be a power of two
+        void initialize(int size);
+        void destroy();
+
+        void forward(std::complex<float> *data) const;
+
+        // Unnormalized; the result is scaled by getSize()
+        void inverse(std::complex<float> *data) const;
+
+        int getSize() const { return m_size; }
+
+    protected:
+        void transform(std::complex<float> *data, bool inverse) const;
+
+        std::complex<float> *m_twiddles;
+        int *m_bitReverse;
+        int m_size;
+};
+
+#endif /* ATG_ENGINE_SIM_FFT_H */
@@ -0,0 +1,73 @@
+#ifndef ATG_ENGINE_SIM_FIDELITY_CALIBRATION_H
+#define ATG_ENGINE_SIM_FIDELITY_CALIBRATION_H
+
+class Simulator;
+
+// Picks the highest simulation frequency and fluid substep count this host
+// can sustain for an engine, and whether its impulse responses are cheaper
+// convolved directly or partitioned, by timing the simulator itself.
+//
+// A step is modeled as a fixed cost plus a cost per fluid substep, measured
+// at two substep counts; the frequency is searched downwards from the
+// script's and the substep count is then the largest that keeps physics
+// within the headroom fraction of real time. Measuring steps the engine,
+// so it runs before the audio thread starts, like warm-up.
+class FidelityCalibration {
+    public:
+        struct Settings {
+            // Share of real time the physics thread, and the audio thread's
+            // convolution, may take
+            double headroom = 0.7;
+
+            // 0 uses the script's values as the upper bounds, so a fast host
+            // gets the fidelity the script asks for and a slow one less
+            int maxFrequency = 0;
+            int minFrequency = 4000;
+            int frequencyStep = 1000;
+            int maxFluidSteps = 0;
+            int minFluidSteps = 1;
+
+            // Steps timed at each substep count
+            int measureSteps = 2000;
+        };
+
+        struct Measurement {
+            int frequency = 0;
+            int fluidSteps = 0;
+
+            // Per step, so a step costs fixed + substep * fluid steps
+            double fixedMicroseconds = 0.0;
+            double substepMicroseconds = 0.0;
+
+            // Per output sample of one channel
+            double directConvolutionMicroseconds = 0.0;
+            double partitionedConvolutionMicroseconds = 0.0;
+            int convolutionChannels = 0;
+            double audioSampleRate = 0.0;
+        };
+
+        struct Result {
+            bool calibrated = false;
+
+            // False when even the lowest fidelity searched doesn't fit
+            bool sustainable = false;
+
+            int simulationFrequency = 0;
+            int fluidSimulationSteps = 0;
+            bool partitionedConvolution = true;
+
+            // Predicted share of real time
+            double physicsLoad = 0.0;
+            double convolutionLoad = 0.0;
+        };
+
+    public:
+        // The audio thread must not be running
+        static Measurement Measure(Simulator *simulator, const Settings &settings);
+        static Result Choose(const Measurement &measurement, const Settings &settings);
+        static void Apply(Simulator *simulator, const Result &result);
+
+        static Result Calibrate(Simulator *simulator, const Settings &settings);
+};
+
+#endif /* ATG_ENGINE_SIM_FIDELITY_CALIBRATION_H */
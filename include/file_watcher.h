@@ -0,0 +1,75 @@
+#ifndef ATG_ENGINE_SIM_FILE_WATCHER_H
+#define ATG_ENGINE_SIM_FILE_WATCHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches a set of files for edits on a background thread, using the
+// platform's change notifications (FSEvents, inotify, ReadDirectoryChangesW)
+// on the directories holding them, and reports them once writes have been
+// quiet for the debounce interval. Editors that save by replacing the file
+// are covered since whole directories are watched.
+class FileWatcher {
+    public:
+        // Platform state, defined next to each implementation
+        class Backend;
+
+    public:
+        FileWatcher();
+        ~FileWatcher();
+
+        void initialize(int debounceMilliseconds = 350);
+        void destroy();
+
+        // Replaces the watched set; directories are re-subscribed on the
+        // watcher thread
+        void watch(const std::vector<std::string> &files);
+
+        // Blocks until the watcher thread has subscribed to the set last
+        // passed to watch(), which it doesn't do while suspended; false if
+        // the timeout passed first. Edits made before then may be missed
+        bool waitForSubscription(std::chrono::milliseconds timeout);
+
+        // Files changed since the last call, after the debounce settled
+        bool takeChanges(std::vector<std::string> *files);
+
+        // While suspended the watcher thread sleeps without polling; events
+        // the platform buffered meanwhile are read on resume
+        void setSuspended(bool suspended);
+
+        // Called by backends from whichever thread delivers events
+        void notify(const std::string &path);
+
+    protected:
+        void worker();
+
+        static std::string normalize(const std::string &path);
+
+        Backend *m_backend;
+        std::thread *m_thread;
+        bool m_run;
+        bool m_suspended;
+
+        std::mutex m_lock;
+        std::condition_variable m_cv;
+
+        std::chrono::milliseconds m_debounce;
+        std::set<std::string> m_files;
+        std::vector<std::string> m_directories;
+
+        // Bumped by watch(); the worker catches up once subscribed
+        unsigned long long m_watchGeneration;
+        unsigned long long m_subscribedGeneration;
+
+        std::set<std::string> m_pending;
+        std::chrono::steady_clock::time_point m_lastEvent;
+
+        std::set<std::string> m_changes;
+};
+
+#endif /* ATG_ENGINE_SIM_FILE_WATCHER_H */
@@ -0,0 +1,177 @@
+#ifndef ATG_ENGINE_SIM_FLIGHT_RECORDER_H
+#define ATG_ENGINE_SIM_FLIGHT_RECORDER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Keeps the last capacity physics steps of one simulator as compact binary
+// frames in a ring allocated up front, for debugging instability after the
+// fact: every rigid body, every chamber's gas state and the inputs. Each
+// frame is checked as it's committed, and the ring is written to a file when
+// one is non-finite or out of bounds, or when DebugTrace::RequestDump() was
+// called since the last step; an anomaly also requests a trace dump.
+//
+// Only the stepping thread touches a recorder. Dumps are written from it too,
+// so a dump stalls one step; nothing is written while steps stay healthy.
+//
+// A dump is a DumpHeader followed by its frames, oldest first, all in the
+// host's native layout. A frame is a FrameHeader, bodyCount BodyStates and
+// chamberCount ChamberStates.
+class FlightRecorder {
+    public:
+        static constexpr uint32_t Magic = 0x52465345; // "ESFR"
+        static constexpr uint32_t Version = 1;
+        static constexpr int DefaultCapacity = 4096;
+
+        enum class Anomaly : uint32_t {
+            None,
+            NonFinite,
+            Pressure,
+            Speed,
+            Request,
+            Count
+        };
+
+        struct Parameters {
+            int capacity = DefaultCapacity;
+
+            // Empty writes into the trace session directory, or the working
+            // directory without a session
+            std::string directory;
+
+            // Pa; 1000 atm
+            double pressureLimit = 1.01325E8;
+
+            // rad/s, of any body; about 50000 rpm
+            double angularSpeedLimit = 5000.0;
+
+            // Anomaly dumps per recorder; requested ones always write
+            int maxAnomalyDumps = 4;
+        };
+
+        struct FrameHeader {
+            uint64_t step;
+
+            // Simulated seconds
+            double time;
+
+            float speedControl;
+            float throttle;
+            float clutchPressure;
+            float dynoSpeed;
+            int32_t gear;
+            uint32_t flags;
+        };
+
+        enum Flags : uint32_t {
+            IgnitionEnabled = 1u << 0,
+            StarterEnabled = 1u << 1,
+            DynoEnabled = 1u << 2,
+            DynoHold = 1u << 3
+        };
+
+        struct BodyState {
+            float p_x, p_y, theta;
+            float v_x, v_y, v_theta;
+        };
+
+        struct ChamberState {
+            // Pa, K, mol, m^3
+            float pressure;
+            float temperature;
+            float molecules;
+            float volume;
+
+            // mol over the last step
+            float intakeFlow;
+            float exhaustFlow;
+        };
+
+        struct DumpHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t headerSize;
+            uint32_t frameSize;
+            uint32_t bodyCount;
+            uint32_t chamberCount;
+            uint32_t frameCount;
+            uint32_t anomaly;
+
+            // Step of the newest frame
+            uint64_t step;
+            char reason[64];
+        };
+
+        // Where a frame being written lives; valid until commit()
+        struct Frame {
+            FrameHeader *header;
+            BodyState *bodies;
+            ChamberState *chambers;
+        };
+
+    public:
+        FlightRecorder();
+        ~FlightRecorder();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        // Allocates the ring for this many bodies and chambers, dropping any
+        // recorded frames if it changes; not on the stepping path
+        void setLayout(int bodies, int chambers);
+        int getBodyCount() const { return m_bodyCount; }
+        int getChamberCount() const { return m_chamberCount; }
+
+        bool isInitialized() const { return !m_ring.empty(); }
+
+        // The next slot in the ring, overwriting the oldest frame once full
+        Frame beginFrame();
+
+        // Checks the frame, then dumps on an anomaly or a pending request
+        Anomaly commit();
+
+        // Writes what the ring holds now; returns the path, or empty on
+        // failure or with no frames
+        std::string dump(const char *reason, Anomaly anomaly = Anomaly::Request);
+
+        // Dumps the recorder of the simulator stepping on this thread, if
+        // any; for checks deep in a step that are about to fail hard
+        static void DumpCurrent(const char *reason);
+        static FlightRecorder *GetCurrent();
+        static void SetCurrent(FlightRecorder *recorder);
+
+        static const char *GetAnomalyName(Anomaly anomaly);
+        static size_t GetFrameSize(int bodies, int chambers);
+
+        int getFrameCount() const { return (int)std::min<uint64_t>(m_written, (uint64_t)m_capacity); }
+        uint64_t getWrittenCount() const { return m_written; }
+        int getDumpCount() const { return m_dumps; }
+        const std::string &getLastDumpPath() const { return m_lastDumpPath; }
+
+    protected:
+        Anomaly check(const Frame &frame) const;
+        Frame frameAt(size_t slot);
+
+        Parameters m_params;
+        std::vector<uint64_t> m_ring;
+        size_t m_frameSize;
+        int m_capacity;
+        int m_bodyCount;
+        int m_chamberCount;
+
+        uint64_t m_written;
+        size_t m_next;
+
+        // DebugTrace::GetDumpRequestCount() as of the last commit
+        unsigned long long m_dumpRequests;
+
+        // Set while frames stay anomalous, so one episode dumps once
+        bool m_anomalous;
+        int m_anomalyDumps;
+        int m_dumps;
+        std::string m_lastDumpPath;
+};
+
+#endif /* ATG_ENGINE_SIM_FLIGHT_RECORDER_H */
@@ -0,0 +1,131 @@
+#ifndef ATG_ENGINE_SIM_FLOW_GRAPH_H
+#define ATG_ENGINE_SIM_FLOW_GRAPH_H
+
+#include "gas_system.h"
+#include "pipe_segments.h"
+
+class Engine;
+
+// Runner joints of an engine, compiled once at load into a flat list of
+// connections between the entries of a volume table. The table holds the
+// plenums, then the collectors, then each chamber's intake and exhaust
+// runners, with the cross-section each one presents at a joint. Connections
+// are grouped by stage and ordered along the gas path, plenum to runner and
+// then runner to collector, in chamber order so that joints sharing a plenum
+// or collector are applied in the same order every substep. A substep's
+// runner stage is then a linear sweep over its range of the list rather
+// than a walk from the engine through each chamber's head, intake and
+// exhaust.
+//
+// Each stage's joints form stars around the plenums or collectors they
+// share. With the implicit option, the lumped joints of a star are solved
+// together per substep: each joint's flow is linearized as a conductance
+// times its pressure drop, every volume's pressure as a linear function of
+// the moles it gains, and the backward Euler system for these is solved
+// in closed form, since every joint only couples to the others through the
+// hub. The flows are then applied as before. Unlike the pairwise sweep,
+// this can't overshoot the pressures' equilibrium however large the
+// substep. Joints resolved into pipe segments keep their own integration.
+class FlowGraph {
+    public:
+        enum class Stage {
+            // Plenum to intake runner
+            Intake,
+
+            // Exhaust runner to collector
+            Exhaust,
+
+            Count
+        };
+
+        struct Connection {
+            int system_0 = -1;
+            int system_1 = -1;
+
+            // Flow constant of the joint, owned by the chamber's fluid state
+            const double *k_flow = nullptr;
+
+            // Set when the joint is resolved into pipe segments
+            PipeSegments *const *pipe = nullptr;
+
+            // Coarsening: the joint is only run while the chamber's valve
+            // on that side is shut once every *coarsening substeps
+            const double *valveFlowRate = nullptr;
+            const int *coarsening = nullptr;
+            int *pendingSubsteps = nullptr;
+            double *pendingTime = nullptr;
+
+            // Whether system_1 sheds its excess velocity after the flow
+            bool dissipate = false;
+
+            // Which side is the plenum or collector the stage's star of
+            // joints shares
+            bool hubIsSystem_0 = true;
+        };
+
+        // Joints of a stage sharing a hub; a range of the grouped order
+        struct Group {
+            int hub = -1;
+            int begin = 0;
+            int end = 0;
+        };
+
+    public:
+        FlowGraph();
+        ~FlowGraph();
+
+        void compile(Engine *engine);
+        void destroy();
+
+        void sweep(Stage stage, double dt);
+
+        // Kept across compiles
+        void setImplicit(bool implicit) { m_implicit = implicit; }
+        bool isImplicit() const { return m_implicit; }
+
+        int getVolumeCount() const { return m_volumeCount; }
+        GasSystem *getVolume(int i) const { return m_volumes[i]; }
+        double getCrossSectionArea(int i) const { return m_crossSectionArea[i]; }
+
+        int getConnectionCount() const { return m_connectionCount; }
+        const Connection &getConnection(int i) const { return m_connections[i]; }
+        int getStageBegin(Stage stage) const { return m_stageBegin[(int)stage]; }
+        int getStageEnd(Stage stage) const { return m_stageBegin[(int)stage + 1]; }
+
+        int getGroupCount(Stage stage) const { return m_groupBegin[(int)stage + 1] - m_groupBegin[(int)stage]; }
+        const Group &getGroup(Stage stage, int i) const { return m_groups[m_groupBegin[(int)stage] + i]; }
+
+    protected:
+        int addVolume(GasSystem *system, double crossSectionArea);
+        int findVolume(const GasSystem *system) const;
+        void groupStage(Stage stage);
+
+        // Advances a joint's coarsening; false when it's skipped this
+        // substep, otherwise the time to run it over is in *h
+        bool advance(const Connection &connection, double dt, double *h);
+        void flow(const Connection &connection, double h);
+        void solveGroup(const Group &group);
+
+        GasSystem **m_volumes;
+        double *m_crossSectionArea;
+        int m_volumeCount;
+
+        Connection *m_connections;
+        int m_connectionCount;
+        int m_stageBegin[(int)Stage::Count + 1];
+
+        // Connection indices in group order, and per connection scratch for
+        // the implicit solve
+        int *m_groupedConnections;
+        Group *m_groups;
+        int m_groupBegin[(int)Stage::Count + 1];
+        GasSystem::FlowState *m_flowStates;
+        double *m_timesteps;
+        double *m_coefficients;
+        double *m_hubCoefficients;
+        double *m_pressureDrops;
+
+        bool m_implicit;
+};
+
+#endif /* ATG_ENGINE_SIM_FLOW_GRAPH_H */
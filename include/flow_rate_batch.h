@@ -0,0 +1,52 @@
+#ifndef ATG_ENGINE_SIM_FLOW_RATE_BATCH_H
+#define ATG_ENGINE_SIM_FLOW_RATE_BATCH_H
+
+#include "fluid_precision.h"
+#include "gas_system.h"
+
+// Structure-of-arrays form of GasSystem::flowRate() for connections that don't
+// share a gas system. The choked/unchoked choice is a select rather than a
+// branch so evaluate() compiles to a straight vector loop. Inputs are narrowed
+// to T_Scalar on add() and the rates widened back to double on read, so the
+// float instantiation only changes the precision of the kernel itself.
+template <typename T_Scalar>
+class BasicFlowRateBatch {
+    public:
+        BasicFlowRateBatch();
+        ~BasicFlowRateBatch();
+
+        void initialize(int capacity);
+        void destroy();
+
+        void clear() { m_count = 0; }
+        int add(const GasSystem::FlowState &state);
+        void evaluate();
+
+        double getFlowRate(int i) const { return static_cast<double>(m_flowRate[i]); }
+        int getCount() const { return m_count; }
+        int getCapacity() const { return m_capacity; }
+
+    protected:
+        T_Scalar *m_buffer;
+
+        T_Scalar *m_k_flow;
+        T_Scalar *m_P0;
+        T_Scalar *m_P1;
+        T_Scalar *m_T0;
+        T_Scalar *m_T1;
+        T_Scalar *m_inverseHeatCapacityRatio;
+        T_Scalar *m_unchokedFlowFactor;
+        T_Scalar *m_chokedFlowLimit;
+        T_Scalar *m_chokedFlowRate;
+        T_Scalar *m_flowRate;
+
+        int m_count;
+        int m_capacity;
+};
+
+extern template class BasicFlowRateBatch<float>;
+extern template class BasicFlowRateBatch<double>;
+
+typedef BasicFlowRateBatch<FluidScalar> FlowRateBatch;
+
+#endif /* ATG_ENGINE_SIM_FLOW_RATE_BATCH_H */
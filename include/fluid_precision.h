@@ -0,0 +1,16 @@
+#ifndef ATG_ENGINE_SIM_FLUID_PRECISION_H
+#define ATG_ENGINE_SIM_FLUID_PRECISION_H
+
+// Scalar type of the vectorized fluid kernels. Builds configured with
+// ATG_ENGINE_SIM_FLUID_SINGLE_PRECISION (CMake:
+// ENGINE_SIM_FLUID_SINGLE_PRECISION=ON) evaluate them in float, which doubles
+// the lanes per vector; gas state is always integrated in double since the
+// per-substep changes in moles and energy are too small relative to the
+// totals to survive a float accumulator.
+#if defined(ATG_ENGINE_SIM_FLUID_SINGLE_PRECISION)
+typedef float FluidScalar;
+#else
+typedef double FluidScalar;
+#endif /* ATG_ENGINE_SIM_FLUID_SINGLE_PRECISION */
+
+#endif /* ATG_ENGINE_SIM_FLUID_PRECISION_H */
@@ -6,6 +6,7 @@
 #include "function.h"
 
 #include <string>
+#include <vector>
 
 class Fuel {
     public:
@@ -24,13 +25,24 @@ class Fuel {
             double maxTurbulenceEffect = 2.0;
             double maxDilutionEffect = 50.0;
             Function *turbulenceToFlameSpeedRatio = nullptr;
+
+            // Look the laminar burning velocity up in tables built once
+            // rather than evaluating its powers at every ignition
+            bool tabulateBurningVelocity = true;
         };
 
+        // Per axis; equivalence ratio is sampled uniformly, temperature
+        // and pressure uniformly in their square roots so the cells are
+        // finer where the powers bend the most
+        static constexpr int BurningVelocitySamples = 128;
+
         Fuel();
         ~Fuel();
 
         void initialize(const Parameters &params);
 
+        inline const std::string &getName() const { return m_name; }
+        inline Function *getTurbulenceToFlameSpeedRatio() const { return m_turbulenceToFlameSpeedRatio; }
         inline double getMolecularMass() const { return m_molecularMass; }
         inline double getEnergyDensity() const { return m_energyDensity; }
         inline double getDensity() const { return m_density; }
@@ -49,9 +61,23 @@ class Fuel {
             double motoringPressure) const;
         virtual double laminarBurningVelocity(double molecularAfr, double T, double P) const;
 
+        // Outside the tables' range the velocity is evaluated directly
+        bool isBurningVelocityTabulated() const { return !m_temperatureFactor.empty(); }
+
+        // Largest relative error of a tabulated velocity, from each
+        // table's error at its cell centres
+        double getBurningVelocityTableError() const { return m_burningVelocityTableError; }
+
         double getMolecularAfr() const { return m_molecularAfr; }
 
     protected:
+        void tabulateBurningVelocity();
+        double sampleBurningVelocityTable(const std::vector<double> &table, double er, double x) const;
+
+        static double baseBurningVelocity(double er);
+        static double temperatureExponent(double er);
+        static double pressureExponent(double er);
+
         std::string m_name;
         double m_molecularMass;
         double m_energyDensity;
@@ -64,6 +90,12 @@ class Fuel {
         double m_maxDilutionEffect;
 
         Function *m_turbulenceToFlameSpeedRatio;
+
+        // Indexed by equivalence ratio, then by the root of temperature or
+        // pressure; the factors the base velocity is scaled by
+        std::vector<double> m_temperatureFactor;
+        std::vector<double> m_pressureFactor;
+        double m_burningVelocityTableError;
 };
 
 #endif /* ATG_ENGINE_FUEL_H */
@@ -3,7 +3,6 @@
 
 #include "ui_element.h"
 
-#include "engine.h"
 #include "simulator.h"
 
 class FuelCluster : public UiElement {
@@ -17,7 +16,6 @@ class FuelCluster : public UiElement {
         virtual void update(float dt);
         virtual void render();
 
-        Engine *m_engine;
         Simulator *m_simulator;
 
     private:
@@ -5,7 +5,7 @@
 
 class Function {
     protected:
-        static GaussianFilter *DefaultGaussianFilter;
+        static GaussianFilter *defaultGaussianFilter();
 
     public:
         Function();
@@ -15,21 +15,52 @@ class Function {
         void resize(int newCapacity);
         void destroy();
 
-        void setInputScale(double s) { m_inputScale = s; }
-        void setOutputScale(double s) { m_outputScale = s; }
+        void setInputScale(double s) { m_inputScale = s; ++m_revision; }
+        void setOutputScale(double s) { m_outputScale = s; m_baked = false; ++m_revision; }
         void addSample(double x, double y);
 
+        // Replaces all samples at once, sorting them by x unless they are
+        // already in order; equal x keep their given order
+        void setSamples(const double *x, const double *y, int n, bool sorted = false);
+
+        // Samples, scales and baking of other, keeping this function's
+        // filter; used to patch live functions after a script edit
+        void assign(const Function &other);
+        bool matches(const Function &other) const;
+
+        // Changes whenever the samples or scales do, so tables derived
+        // from the function can tell when they are stale
+        unsigned int getRevision() const { return m_revision; }
+
         double sampleTriangle(double x) const;
         double sampleGaussian(double x) const;
+
+        // Tabulates both filtered curves on a uniform grid so sampling is a
+        // single lerp; adding samples or changing the output scale drops the
+        // table until the next call. Does nothing without a filter radius.
+        void bake(int resolution = 1024);
+        bool isBaked() const { return m_baked; }
         double triangle(double x) const;
         int closestSample(double x) const;
 
         bool isOrdered() const;
 
+        inline int getSampleCount() const { return m_size; }
+        inline double getSampleX(int i) const { return m_x[i]; }
+        inline double getSampleY(int i) const { return m_y[i]; }
+        inline double getFilterRadius() const { return m_filterRadius; }
+        inline double getInputScale() const { return m_inputScale; }
+        inline double getOutputScale() const { return m_outputScale; }
+        inline int getBakedResolution() const { return m_bakedResolution; }
+
         void getDomain(double *x0, double *x1);
         void getRange(double *y0, double *y1);
 
     protected:
+        double evaluateTriangle(double x) const;
+        double evaluateGaussian(double x) const;
+        double sampleBaked(const double *table, double x) const;
+
         double *m_x;
         double *m_y;
 
@@ -43,6 +74,15 @@ class Function {
         int m_capacity;
         int m_size;
 
+        unsigned int m_revision;
+
+        double *m_bakedTriangle;
+        double *m_bakedGaussian;
+        double m_bakedX0;
+        double m_bakedInverseStep;
+        int m_bakedResolution;
+        bool m_baked;
+
         GaussianFilter *m_gaussianFilter;
 };
 
@@ -2,6 +2,7 @@
 #define ATG_ENGINE_SIM_GAS_SYSTEM_H
 
 #include "constants.h"
+#include "event_counters.h"
 #include "units.h"
 
 #include <cfloat>
@@ -35,6 +36,53 @@ class GasSystem {
             GasSystem *system_0, *system_1;
         };
 
+        // Everything flowRate() needs that only depends on the degrees of
+        // freedom, so the per-flow path avoids pow() and divisions.
+        struct FlowConstants {
+            double heatCapacityRatio = 0;
+            double inverseHeatCapacityRatio = 0;
+            double unchokedFlowFactor = 0;
+            double chokedFlowLimit = 0;
+            double chokedFlowRate = 0;
+        };
+
+        // Boundary at a fixed state that flowing in or out of never
+        // changes, such as the atmosphere; holds what a flow needs from it
+        // so nothing is recomputed per step
+        struct Reservoir {
+            double P = 0;
+            double T = 0;
+            double molarVolume = 0;
+            double density = 0;
+            double E_k_per_mol = 0;
+            FlowConstants flowConstants;
+
+            Mix mix;
+        };
+
+        // Direction is from the reservoir into the system; the cross
+        // section is the system's side of the connection
+        struct ReservoirFlowParameters {
+            double k_flow;
+            double dt;
+            double direction_x, direction_y;
+            double crossSectionArea;
+            const Reservoir *reservoir;
+        };
+
+        // Connection resolved to a source/sink pair; lets the flow rate of
+        // several independent connections be evaluated together between
+        // beginFlow() and endFlow().
+        struct FlowState {
+            GasSystem *source = nullptr, *sink = nullptr;
+            double sourcePressure = 0, sinkPressure = 0;
+            double sourceCrossSection = 0, sinkCrossSection = 0;
+            double dx = 0, dy = 0;
+            double direction = 0;
+            double k_flow = 0;
+            double dt = 0;
+        };
+
     public:
         GasSystem() { /* void */ }
         ~GasSystem() { /* void */ }
@@ -67,6 +115,24 @@ class GasSystem {
             double hcr,
             double chokedFlowLimit,
             double chokedFlowRateCached);
+        static double flowRate(
+            double k_flow,
+            double P0,
+            double P1,
+            double T0,
+            double T1,
+            const FlowConstants &flowConstants);
+
+        // The same flow on any scalar with the arithmetic and math functions
+        // of a double, such as a Dual for its derivatives in the inputs
+        template <typename Scalar>
+        static Scalar flowRate(
+            const Scalar &k_flow,
+            const Scalar &P0,
+            const Scalar &P1,
+            const Scalar &T0,
+            const Scalar &T1,
+            const FlowConstants &flowConstants);
         double loseN(double dn, double E_k_per_mol);
         double gainN(double dn, double E_k_per_mol, const Mix &mix = Mix());
         void dissipateExcessVelocity();
@@ -75,8 +141,15 @@ class GasSystem {
         void dissipateVelocity(double dt, double timeConstant);
 
         static double flow(const FlowParameters &params);
+        static void beginFlow(const FlowParameters &params, FlowState *state);
+        static double flowRate(const FlowState &state);
+        static double endFlow(const FlowState &state, double flowRate);
         double flow(double k_flow, double dt, double P_env, double T_env, const Mix &mix = Mix());
 
+        // As flow() between a system and a volume reset to the reservoir's
+        // state every call, but without the volume; positive flows in
+        double flow(const ReservoirFlowParameters &params);
+
         double pressureEquilibriumMaxFlow(const GasSystem *b) const;
         double pressureEquilibriumMaxFlow(double P_env, double T_env) const;
 
@@ -84,6 +157,8 @@ class GasSystem {
         inline static constexpr double heatCapacityRatio(int degreesOfFreedom);
         inline static double chokedFlowLimit(int degreesOfFreedom);
         inline static double chokedFlowRate(int degreesOfFreedom);
+        static FlowConstants flowConstants(int degreesOfFreedom);
+        static Reservoir reservoir(double P, double T, const Mix &mix = Mix(), int degreesOfFreedom = 5);
 
         inline double approximateDensity() const;
         inline int degreesOfFreedom() const { return m_degreesOfFreedom; }
@@ -96,6 +171,10 @@ class GasSystem {
         inline double bulkKineticEnergy() const;
         inline double c() const;
         inline double dynamicPressure(double dx, double dy) const;
+
+        // Sum of dynamicPressure() along the axis in both directions; only
+        // the direction the gas is moving in contributes
+        inline double axialDynamicPressure(double dx, double dy) const;
         inline double mass() const;
         inline double pressure() const;
         inline double temperature() const;
@@ -108,14 +187,28 @@ class GasSystem {
         inline double n_o2() const;
         inline double heatCapacityRatio() const;
         inline Mix mix() const { return m_state.mix; }
+        inline const State &getState() const { return m_state; }
+        inline void setState(const State &state) { m_state = state; }
+        inline const FlowConstants &getFlowConstants() const { return m_flowConstants; }
+
+    protected:
+        inline double dynamicPressureAtSpeed(double v) const;
+
+        // The momentum a flowing fraction carries through a connection
+        void pushFraction(
+            double fractionVolume,
+            double fractionMass,
+            double crossSectionArea,
+            double dx,
+            double dy,
+            double dt);
 
     protected:
         State m_state;
 
         int m_degreesOfFreedom = 5;
 
-        double m_chokedFlowLimit = 0;
-        double m_chokedFlowFactorCached = 0;
+        FlowConstants m_flowConstants = flowConstants(5);
 
         double m_width = 0.0;
         double m_height = 0.0;
@@ -144,6 +237,57 @@ inline double GasSystem::chokedFlowRate(int degreesOfFreedom) {
     return flowRate;
 }
 
+template <typename Scalar>
+inline Scalar GasSystem::flowRate(
+    const Scalar &k_flow,
+    const Scalar &P0,
+    const Scalar &P1,
+    const Scalar &T0,
+    const Scalar &T1,
+    const FlowConstants &flowConstants)
+{
+    using std::fmax;
+    using std::pow;
+    using std::sqrt;
+
+    if (k_flow == 0) return Scalar(0.0);
+
+    double direction;
+    Scalar T_0;
+    Scalar p_0, p_T; // p_0 = upstream pressure
+    if (P0 > P1) {
+        direction = 1.0;
+        T_0 = T0;
+        p_0 = P0;
+        p_T = P1;
+    }
+    else {
+        direction = -1.0;
+        T_0 = T1;
+        p_0 = P1;
+        p_T = P0;
+    }
+
+    const Scalar p_ratio = p_T / p_0;
+    Scalar flowRate;
+    ATG_ENGINE_SIM_COUNT(GasFlows, 1);
+    if (p_ratio <= flowConstants.chokedFlowLimit) {
+        // Choked flow
+        ATG_ENGINE_SIM_COUNT(ChokedFlows, 1);
+        flowRate = flowConstants.chokedFlowRate / sqrt(constants::R * T_0);
+    }
+    else {
+        const Scalar s = pow(p_ratio, flowConstants.inverseHeatCapacityRatio);
+
+        flowRate = flowConstants.unchokedFlowFactor * (s * (s - p_ratio));
+        flowRate = sqrt(fmax(flowRate, 0.0) / (constants::R * T_0));
+    }
+
+    flowRate = flowRate * (direction * p_0);
+
+    return flowRate * k_flow;
+}
+
 inline double GasSystem::approximateDensity() const {
     return (units::AirMolecularMass * n()) / volume();
 }
@@ -206,6 +350,23 @@ inline double GasSystem::dynamicPressure(double dx, double dy) const {
         return 0;
     }
 
+    return dynamicPressureAtSpeed(v);
+}
+
+inline double GasSystem::axialDynamicPressure(double dx, double dy) const {
+    if (n() == 0 || kineticEnergy() == 0) return 0;
+
+    const double inverseMass = 1 / this->mass();
+    const double v = inverseMass * (dx * m_state.momentum[0] + dy * m_state.momentum[1]);
+
+    if (v == 0) {
+        return 0;
+    }
+
+    return dynamicPressureAtSpeed(std::abs(v));
+}
+
+inline double GasSystem::dynamicPressureAtSpeed(double v) const {
     const double hcr = heatCapacityRatio();
     const double staticPressure = pressure();
     const double density = approximateDensity();
@@ -282,7 +443,7 @@ inline double GasSystem::n_o2() const {
 }
 
 inline double GasSystem::heatCapacityRatio() const {
-    return heatCapacityRatio(m_degreesOfFreedom);
+    return m_flowConstants.heatCapacityRatio;
 }
 
 #endif /* ATG_ENGINE_SIM_GAS_SYSTEM_H */
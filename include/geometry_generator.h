@@ -7,13 +7,33 @@
 
 #include "../include/ui_math.h"
 
+#include <algorithm>
+#include <vector>
+
+// Vertices and 16-bit indices for generated shapes, kept in one arena that
+// grows a whole number of pages at a time when a shape doesn't fit, rather
+// than refusing it. Indices are relative to their shape's base vertex, so
+// they stay 16 bit however many pages there are. The largest counts reached
+// are kept as high-water marks and traced on growth and teardown.
 class GeometryGenerator {
 public:
+    static constexpr int PageVertexCount = 16384;
+    static constexpr int PageIndexCount = 32768;
+    static constexpr int MaxShapeVertexCount = 0x10000;
+
+    // Segments in a full turn of a curve, whatever its maxEdgeLength; the
+    // engine sizes edges in screen pixels at the current zoom, so counts
+    // follow the projected radius between these
+    static constexpr int MinCurveSegments = 3;
+    static constexpr int MaxCurveSegments = 512;
+
     struct GeometryIndices {
         int BaseIndex = -1;
         int BaseVertex = -1;
         int FaceCount = -1;
+        int VertexCount = -1;
 
+        // Only valid until the generator next grows
         dbasic::Vertex *VertexData = nullptr;
     };
 
@@ -119,6 +139,7 @@ public:
     GeometryGenerator();
     ~GeometryGenerator();
 
+    // Initial capacity; rounded up to whole pages
     void initialize(int vertexBufferSize, int indexBufferSize);
     void destroy();
 
@@ -128,8 +149,21 @@ public:
     int getCurrentVertexCount() const { return m_state.vertexPointer; }
     int getCurrentIndexCount() const { return m_state.indexPointer; }
 
+    int getVertexCapacity() const { return m_vertexBufferSize; }
+    int getIndexCapacity() const { return m_indexBufferSize; }
+    int getVertexHighWater() const { return std::max(m_vertexHighWater, m_state.vertexPointer); }
+    int getIndexHighWater() const { return std::max(m_indexHighWater, m_state.indexPointer); }
+
+    // Rewinds to the end of the retained shapes
     void reset();
 
+    // Everything generated so far survives reset() until released
+    void retain();
+    void releaseRetained();
+
+    int getRetainedVertexCount() const { return m_retainedVertexCount; }
+    int getRetainedIndexCount() const { return m_retainedIndexCount; }
+
     bool generateFilledCircle(
         const ysVector &normal,
         const ysVector &center,
@@ -182,12 +216,38 @@ public:
     bool generateIsoscelesTriangle(
         float x, float y, float width, float height);
 
+    // Appends a copy of an earlier shape, transformed, as a subshape of the
+    // current one; normals are copied as they are
+    bool generateInstance(const GeometryIndices &mesh, const ysMatrix &transform);
+
     bool startPath(PathParameters &params);
     bool generatePathSegment(PathParameters &params, bool detached = false);
 
     void startShape();
     void endShape(GeometryIndices *indices);
 
+    // Every shape ended while a log is set is added to it, so the shapes can
+    // be found again once their geometry moves
+    void setShapeLog(std::vector<GeometryIndices *> *log) { m_shapeLog = log; }
+
+    // Copies a range of another generator's vertices and indices to the end
+    // of this one, between shapes; shapes in it move by the offsets returned,
+    // see rebase()
+    bool append(
+        const GeometryGenerator &source,
+        int vertexBegin,
+        int vertexEnd,
+        int indexBegin,
+        int indexEnd,
+        int *vertexOffset,
+        int *indexOffset);
+    void rebase(GeometryIndices *indices, int vertexOffset, int indexOffset) const;
+
+    // Generator the shapes of the calling thread go to instead of the
+    // application's, while ParallelGeometry runs a producer on it
+    static GeometryGenerator *GetThreadTarget();
+    static void SetThreadTarget(GeometryGenerator *generator);
+
 protected:
     void startSubshape();
 
@@ -195,10 +255,19 @@ protected:
     void writeFace(unsigned short i0, unsigned short i1, unsigned short i2);
 
     bool checkCapacity(int vertexCount, int indexCount);
+    void grow(int vertexCount, int indexCount);
 
 protected:
     static ysVector findOrthogonal(const ysVector &v);
 
+    // Half the angle an edge of edgeLength spans on a circle of radius;
+    // edges as long as the diameter give a quarter turn rather than NaN
+    static float edgeAngle(float edgeLength, float radius);
+
+    // Segments for an arc of span radians cut every angle radians, within
+    // the curve segment limits
+    static int curveSegments(float span, float angle);
+
 protected:
     dbasic::Vertex *m_vertexData;
     unsigned short *m_indexData;
@@ -206,6 +275,14 @@ protected:
     int m_vertexBufferSize;
     int m_indexBufferSize;
 
+    int m_retainedVertexCount;
+    int m_retainedIndexCount;
+
+    int m_vertexHighWater;
+    int m_indexHighWater;
+
+    std::vector<GeometryIndices *> *m_shapeLog;
+
     struct State {
         int vertexPointer = 0;
         int indexPointer = 0;
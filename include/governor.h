@@ -4,6 +4,8 @@
 #include "throttle.h"
 
 class Governor : public Throttle {
+    friend class SimulationCheckpoint;
+
 public:
     struct Parameters {
         double minSpeed;
@@ -24,6 +26,14 @@ public:
     virtual void setSpeedControl(double s);
     virtual void update(double dt, Engine *engine);
 
+    inline double getMinSpeed() const { return m_minSpeed; }
+    inline double getMaxSpeed() const { return m_maxSpeed; }
+    inline double getMinVelocity() const { return m_minVelocity; }
+    inline double getMaxVelocity() const { return m_maxVelocity; }
+    inline double getKs() const { return m_k_s; }
+    inline double getKd() const { return m_k_d; }
+    inline double getGamma() const { return m_gamma; }
+
 protected:
     double m_minSpeed;
     double m_maxSpeed;
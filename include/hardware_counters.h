@@ -0,0 +1,64 @@
+#ifndef ATG_ENGINE_SIM_HARDWARE_COUNTERS_H
+#define ATG_ENGINE_SIM_HARDWARE_COUNTERS_H
+
+#include <atomic>
+#include <cinttypes>
+
+// CPU performance counters of the calling thread, user space only, opened as
+// one group so every value covers the same interval. Backed by perf_event on
+// Linux; elsewhere, or where the kernel refuses (perf_event_paranoid, VMs
+// without a PMU), open() fails and nothing is counted.
+//
+// Collection is off until SetEnabled(true), so benchmarks and profiled runs
+// only pay for the reads when they ask for counters.
+class HardwareCounters {
+public:
+    enum class Counter {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        Count
+    };
+
+    static constexpr int CounterCount = static_cast<int>(Counter::Count);
+
+    struct Sample {
+        uint64_t values[CounterCount] = {};
+
+        uint64_t get(Counter counter) const { return values[static_cast<int>(counter)]; }
+        double ipc() const {
+            const uint64_t cycles = get(Counter::Cycles);
+            return (cycles > 0) ? static_cast<double>(get(Counter::Instructions)) / cycles : 0.0;
+        }
+
+        Sample operator-(const Sample &other) const;
+    };
+
+public:
+    HardwareCounters();
+    ~HardwareCounters();
+
+    bool open();
+    void close();
+    bool isOpen() const { return m_leader >= 0; }
+
+    // Running totals since open()
+    bool read(Sample *sample) const;
+
+    static const char *GetCounterName(Counter counter);
+
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Whether counters can be opened on this machine at all
+    static bool IsSupported();
+
+private:
+    int m_leader;
+    int m_descriptors[CounterCount];
+
+    static std::atomic<bool> s_enabled;
+};
+
+#endif /* ATG_ENGINE_SIM_HARDWARE_COUNTERS_H */
@@ -0,0 +1,118 @@
+#ifndef ATG_ENGINE_SIM_HEADLESS_RUNNER_H
+#define ATG_ENGINE_SIM_HEADLESS_RUNNER_H
+
+#include "realtime_stepper.h"
+#include "simulator.h"
+
+#include <cinttypes>
+#include <functional>
+#include <vector>
+
+class HeadlessRunner {
+    public:
+        struct ControlPoint {
+            double time = 0.0;
+            double throttle = 0.0;
+            double dynoSpeed = 0.0;
+            bool dynoEnabled = false;
+            bool starter = false;
+            bool ignition = true;
+
+            // Gear and clutch are only applied with drivetrain set; the
+            // gear is 0-based with -1 as neutral and the clutch pressure is
+            // interpolated like the throttle
+            bool drivetrain = false;
+            int gear = -1;
+            double clutch = 0.0;
+        };
+
+        struct Statistics;
+
+        struct Parameters {
+            double duration = 10.0;
+            double frameLength = 1 / 60.0;
+            double simulationSpeed = 1.0;
+            bool offline = true;
+
+            // Paces every step against the wall clock with RealtimeStepper
+            // instead of running frames back to back; frameLength is then
+            // unused and the controls are sampled every step
+            bool lockstep = false;
+
+            // Linearly interpolated by time; booleans take the value of the
+            // preceding control point.
+            std::vector<ControlPoint> schedule;
+
+            // Called before every frame with the controls sampled from the
+            // schedule at the given time; may replace them
+            std::function<void(double, ControlPoint *)> control;
+
+            // Called on the running thread after every frame with the
+            // snapshot that frame published
+            std::function<void(const SimulationSnapshot &)> telemetry;
+
+            // Called on the running thread after every frame with the
+            // totals so far; pacing is only filled in once the run ends
+            std::function<void(Simulator *, const Statistics &)> progress;
+
+            // Checked after every frame; returning true ends the run early
+            std::function<bool(const SimulationSnapshot &)> stop;
+
+            // Receives the synthesizer output drained after every frame
+            std::function<void(const int16_t *, int)> audio;
+
+            // Replaces the runner's own drain after every frame, for
+            // consumers that read the synthesizer output themselves; returns
+            // the samples taken. audio is unused when this is set
+            std::function<int(Simulator *)> drain;
+        };
+
+        struct Statistics {
+            double simulatedTime = 0.0;
+            double wallTime = 0.0;
+            long long steps = 0;
+            long long frames = 0;
+            long long audioSamples = 0;
+            long long fluidSubsteps = 0;
+
+            // Set when the run ended early because frames stopped taking
+            // any steps
+            bool stalled = false;
+
+            // Only filled in lockstep runs
+            RealtimeStepper::Statistics pacing;
+
+            double realTimeFactor() const {
+                return (wallTime > 0) ? simulatedTime / wallTime : 0.0;
+            }
+
+            double averageFluidSubsteps() const {
+                return (steps > 0) ? (double)fluidSubsteps / steps : 0.0;
+            }
+        };
+
+    public:
+        HeadlessRunner();
+        ~HeadlessRunner();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        Statistics run(Simulator *simulator);
+        ControlPoint sampleSchedule(double t) const;
+
+        // The controls at t of a schedule sorted by time
+        static ControlPoint SampleSchedule(const std::vector<ControlPoint> &schedule, double t);
+
+    protected:
+        Statistics runLockstep(Simulator *simulator);
+        void applyControls(Simulator *simulator, const ControlPoint &control);
+        int drainAudio(Simulator *simulator);
+
+        Parameters m_parameters;
+
+        int16_t *m_audioBuffer;
+        int m_audioBufferSize;
+};
+
+#endif /* ATG_ENGINE_SIM_HEADLESS_RUNNER_H */
@@ -5,9 +5,12 @@
 
 #include "crankshaft.h"
 #include "function.h"
+#include "timing_map.h"
 #include "units.h"
 
 class IgnitionModule : public Part {
+    friend class SimulationCheckpoint;
+
     public:
         struct Parameters {
             int cylinderCount;
@@ -19,10 +22,17 @@ class IgnitionModule : public Part {
 
         struct SparkPlug {
             double angle = 0;
+            double trim = 0;
             bool ignitionEvent = false;
             bool enabled = false;
         };
 
+        // Enabled plugs sorted by trimmed firing angle in [0, 4 * pi)
+        struct ScheduledFiring {
+            double angle;
+            int cylinder;
+        };
+
     public:
         IgnitionModule();
         virtual ~IgnitionModule();
@@ -31,21 +41,61 @@ class IgnitionModule : public Part {
 
         void initialize(const Parameters &params);
         void setFiringOrder(int cylinderIndex, double angle);
+
+        // Extra advance for one cylinder, folded into the schedule so it
+        // costs nothing per step
+        void setCylinderTrim(int cylinderIndex, double trim);
+        inline double getCylinderTrim(int i) const { return m_plugs[i].trim; }
         void reset();
         void update(double dt);
 
         bool getIgnitionEvent(int index) const;
         void resetIgnitionEvents();
 
+        // From the timing map when one is baked, otherwise the timing curve
         double getTimingAdvance();
 
+        // Replaces the timing curve once baked; its pressure axis is fed
+        // by the simulator each step
+        inline TimingMap *getTimingMap() { return &m_timingMap; }
+        inline const TimingMap *getTimingMap() const { return &m_timingMap; }
+        void setManifoldPressure(double pressure) { m_manifoldPressure = pressure; }
+        inline double getManifoldPressure() const { return m_manifoldPressure; }
+
+        // Added to the timing curve
+        void setTimingOffset(double offset) { m_timingOffset = offset; }
+        inline double getTimingOffset() const { return m_timingOffset; }
+
+        // Also added to the timing curve, but owned by an engine
+        // controller so it doesn't fight the user's offset
+        void setTimingTrim(double trim) { m_timingTrim = trim; }
+        inline double getTimingTrim() const { return m_timingTrim; }
+
+        // Suppresses every spark while set, as the rev limiter does
+        void setSparkCut(bool cut) { m_sparkCut = cut; }
+        inline bool isSparkCut() const { return m_sparkCut; }
+
+        inline int getCylinderCount() const { return m_cylinderCount; }
+        inline Crankshaft *getCrankshaft() const { return m_crankshaft; }
+        inline Function *getTimingCurve() const { return m_timingCurve; }
+        inline double getRevLimit() const { return m_revLimit; }
+        inline double getLimiterDuration() const { return m_limiterDuration; }
+        inline bool isPlugEnabled(int i) const { return m_plugs[i].enabled; }
+        inline double getFiringAngle(int i) const { return m_plugs[i].angle; }
+
         bool m_enabled;
 
     protected:
         SparkPlug *getPlug(int i);
 
+        void fireWindow(double start, double length);
+        void schedule(int cylinderIndex);
+
         Function *m_timingCurve;
+        TimingMap m_timingMap;
         SparkPlug *m_plugs;
+        ScheduledFiring *m_schedule;
+        int m_scheduledCount;
         Crankshaft *m_crankshaft;
         int m_cylinderCount;
 
@@ -53,6 +103,10 @@ class IgnitionModule : public Part {
         double m_revLimit;
         double m_revLimitTimer;
         double m_limiterDuration;
+        double m_timingOffset;
+        double m_timingTrim;
+        double m_manifoldPressure;
+        bool m_sparkCut;
 };
 
 #endif /* ATG_ENGINE_SIM_IGNITION_MODULE_H */
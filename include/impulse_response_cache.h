@@ -0,0 +1,57 @@
+#ifndef ATG_ENGINE_SIM_IMPULSE_RESPONSE_CACHE_H
+#define ATG_ENGINE_SIM_IMPULSE_RESPONSE_CACHE_H
+
+#include "convolution_filter.h"
+#include "impulse_response_processor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class ImpulseResponse;
+
+// Process-wide store of decoded impulse responses keyed by file, volume and
+// output sample rate, so exhausts sharing a response and engines reloaded
+// from the same assets decode, resample and transform each one once. Entries are revalidated against the
+// file's size and modification time. Decoded taps go through
+// ImpulseResponseProcessor, and while the shared ArtifactCache is enabled
+// the processed taps are kept there for the next run.
+class ImpulseResponseCache {
+    public:
+        // Taps scaled and trimmed by Synthesizer::prepareImpulseResponse()
+        // and ImpulseResponseProcessor, with the FFT partitions already
+        // prepared
+        class Kernel {
+            public:
+                Kernel();
+                ~Kernel();
+
+                ConvolutionFilter filter;
+        };
+
+    public:
+        // Decodes every response missing from the cache in parallel and
+        // resamples it from the file's rate to sampleRate; kernels[i] is null
+        // where responses[i] couldn't be read
+        static void Load(
+            ImpulseResponse *const *responses,
+            int count,
+            double sampleRate,
+            std::vector<std::shared_ptr<const Kernel>> *kernels);
+
+        static std::shared_ptr<const Kernel> Get(
+            const std::string &filename,
+            double volume,
+            double sampleRate);
+        static void Clear();
+        static int GetEntryCount();
+
+        // A change drops the entries made so far; call before loading
+        static void SetPreprocessing(const ImpulseResponseProcessor::Parameters &params);
+        static ImpulseResponseProcessor::Parameters GetPreprocessing();
+
+        // Responses read back from the ArtifactCache
+        static int GetDiskHitCount();
+};
+
+#endif /* ATG_ENGINE_SIM_IMPULSE_RESPONSE_CACHE_H */
@@ -0,0 +1,45 @@
+#ifndef ATG_ENGINE_SIM_IMPULSE_RESPONSE_PROCESSOR_H
+#define ATG_ENGINE_SIM_IMPULSE_RESPONSE_PROCESSOR_H
+
+#include "convolution_filter.h"
+
+#include <vector>
+
+// Shortens prepared impulse response taps before they're partitioned. The
+// tail is cut where what's left of the response's energy falls under a
+// threshold, and the response can first be converted to minimum phase,
+// which keeps its magnitude spectrum and moves its energy to the front so
+// the cut comes sooner. Taps are already at the synthesizer's rate by then.
+class ImpulseResponseProcessor {
+    public:
+        struct Parameters {
+            bool enabled = true;
+
+            // Energy left in the cut tail relative to the whole response;
+            // 1E-6 is 60 dB down
+            double energyThreshold = 1E-6;
+
+            bool minimumPhase = false;
+            int maxSamples = 10000;
+        };
+
+        // Magnitude of a processed response against the original in third
+        // octave bands up to 90% of Nyquist, over the bands holding any
+        // real energy
+        struct Report {
+            int originalSamples = 0;
+            int processedSamples = 0;
+            double maxDeviation = 0.0;
+            double meanDeviation = 0.0;
+        };
+
+    public:
+        static void Process(const Parameters &params, ConvolutionFilter *filter);
+        static Report Compare(const ConvolutionFilter &original, const ConvolutionFilter &processed, double sampleRate);
+
+        // Shortest length leaving at most threshold of the energy behind
+        static int EnergyLength(const float *taps, int samples, double threshold);
+        static void MinimumPhase(const float *taps, int samples, std::vector<float> *output);
+};
+
+#endif /* ATG_ENGINE_SIM_IMPULSE_RESPONSE_PROCESSOR_H */
@@ -18,7 +18,7 @@ public:
     virtual void update(float dt);
     virtual void render();
 
-    void setEngine(Engine *engine) { m_engine = engine; }
+    void setEngine(Engine *engine) { m_engine = engine; m_engineInfoText.clear(); }
     void setLogMessage(const std::string &logMessage) { m_logMessage = logMessage; }
     std::string getLogMessage() const { return m_logMessage; }
 
@@ -26,6 +26,9 @@ protected:
     Engine *m_engine;
 
     std::string m_logMessage;
+
+    // Displacement line, formatted once per engine
+    std::string m_engineInfoText;
 };
 
 #endif /* ATG_ENGINE_SIM_INFO_CLUSTER_H */
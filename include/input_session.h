@@ -0,0 +1,94 @@
+#ifndef ATG_ENGINE_SIM_INPUT_SESSION_H
+#define ATG_ENGINE_SIM_INPUT_SESSION_H
+
+#include "control_queue.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Control changes as the simulator applied them, stamped with the physics
+// step since the session began that they took effect before. Replayed at
+// the same steps from the same seed and simulation frequency they reproduce
+// the session bit for bit, however the frames fall. Events are stored as a
+// varint step delta, a control byte and the value; a value a control
+// already had isn't stored again, except for gear changes, which aren't
+// idempotent.
+class InputSession {
+    public:
+        static constexpr uint32_t Magic = 0x52534945; // "EISR"
+        static constexpr uint32_t Version = 1;
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t seed;
+            double simulationFrequency;
+        };
+
+        struct Event {
+            unsigned long long step = 0;
+            ControlQueue::Control control = ControlQueue::Control::Throttle;
+            double value = 0.0;
+        };
+
+    public:
+        InputSession();
+        ~InputSession();
+
+        // Recording; events are buffered up to capacity between flushes
+        // and the rest dropped, so write() never allocates
+        bool record(const std::string &path, uint64_t seed, double simulationFrequency, int capacity = 4096);
+        void write(unsigned long long step, ControlQueue::Control control, double value);
+        bool flush();
+
+        // Replaying
+        bool load(const std::string &path);
+
+        // The next event due at or before step, or nullptr; advances past it
+        const Event *next(unsigned long long step);
+
+        // Ends a recording at step, or a replay
+        bool close(unsigned long long step);
+
+        bool isRecording() const { return m_file != nullptr; }
+        bool isReplaying() const { return m_replaying; }
+        bool isFinished() const { return m_replaying && m_cursor >= m_events.size(); }
+
+        uint64_t getSeed() const { return m_seed; }
+        double getSimulationFrequency() const { return m_simulationFrequency; }
+
+        // Steps the recording ran for
+        unsigned long long getLength() const { return m_length; }
+        size_t getEventCount() const { return m_replaying ? m_events.size() : m_written; }
+        unsigned long long getDroppedCount() const { return m_dropped; }
+
+    protected:
+        static constexpr int ControlCount = static_cast<int>(ControlQueue::Control::DynoSpeed) + 1;
+        static constexpr uint8_t EndMarker = 0xFF;
+
+        void encode(unsigned long long step, uint8_t control, const double *value);
+
+        uint64_t m_seed;
+        double m_simulationFrequency;
+        unsigned long long m_length;
+
+        // Recording; encoded events wait here for the next flush
+        FILE *m_file;
+        std::vector<uint8_t> m_encoded;
+        size_t m_capacity;
+        unsigned long long m_lastStep;
+        double m_lastValues[ControlCount];
+        bool m_hasLastValue[ControlCount];
+        size_t m_written;
+        unsigned long long m_dropped;
+        bool m_failed;
+
+        // Replaying
+        std::vector<Event> m_events;
+        size_t m_cursor;
+        bool m_replaying;
+};
+
+#endif /* ATG_ENGINE_SIM_INPUT_SESSION_H */
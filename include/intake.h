@@ -34,6 +34,10 @@ class Intake : public Part {
 
             // Velocity decay factor
             double VelocityDecay = 0.5;
+
+            // Cells the manifold runner is resolved into; 0 lumps it into
+            // the port runner
+            int RunnerSegments = 0;
         };
 
     public:
@@ -43,13 +47,41 @@ class Intake : public Part {
         void initialize(Parameters &params);
         virtual void destroy();
 
-        void process(double dt);
+        // Builds both circuits' flow parameters for the substeps of one
+        // step, so the throttle, idle air and substep length are read once
+        void prepare(double dt);
+        void process();
+
+        // Ambient pressure and temperature the throttle and idle circuit
+        // draw from
+        void setAtmosphere(double P, double T);
+        inline double getAtmospherePressure() const { return m_atmosphere.P; }
+        inline double getAtmosphereTemperature() const { return m_atmosphere.T; }
+        inline const GasSystem::Mix &getAtmosphereMix() const { return m_atmosphere.mix; }
+
+        // Fraction of fuel added to both circuits' mixes, from an engine
+        // controller; rebuilds the mixes, so not for every step
+        void setFuelTrim(double trim);
+        inline double getFuelTrim() const { return m_fuelTrim; }
+
+        // Multiplies the idle circuit's flow constant
+        void setIdleAir(double scale) { m_idleAir = scale; }
+        inline double getIdleAir() const { return m_idleAir; }
 
         inline double getRunnerFlowRate() const { return m_runnerFlowRate; }
         inline double getThrottlePlatePosition() const { return m_idleThrottlePlatePosition * m_throttle; }
         inline double getRunnerLength() const { return m_runnerLength; }
+
+        // Takes effect once the chambers' geometry is updated
+        void setRunnerLength(double length) { m_runnerLength = length; }
         inline double getPlenumCrossSectionArea() const { return m_crossSectionArea; }
         inline double getVelocityDecay() const { return m_velocityDecay; }
+        inline int getRunnerSegments() const { return m_runnerSegments; }
+        inline double getInputFlowK() const { return m_inputFlowK; }
+        inline double getIdleFlowK() const { return m_idleFlowK; }
+        inline double getMolecularAfr() const { return m_molecularAfr; }
+        inline double getIdleThrottlePlatePosition() const { return m_idleThrottlePlatePosition; }
+        inline double getPlenumVolume() const { return m_system.volume(); }
 
         GasSystem m_system;
         double m_throttle;
@@ -67,8 +99,16 @@ class Intake : public Part {
         double m_idleThrottlePlatePosition;
         double m_runnerLength;
         double m_velocityDecay;
+        int m_runnerSegments;
+        double m_fuelTrim;
+        double m_idleAir;
+
+        GasSystem::Reservoir m_atmosphere;
+        GasSystem::Reservoir m_idleAtmosphere;
 
-        GasSystem m_atmosphere;
+        // Set by prepare()
+        GasSystem::ReservoirFlowParameters m_throttleFlow;
+        GasSystem::ReservoirFlowParameters m_idleFlow;
 };
 
 #endif /* ATG_ENGINE_SIM_INTAKE_H */
@@ -5,8 +5,7 @@
 
 #include "butterworth_low_pass_filter.h"
 #include "utilities.h"
-
-#include <random>
+#include "random_stream.h"
 
 class JitterFilter : public Filter {
 public:
@@ -32,11 +31,8 @@ public:
             m_offset = 0;
         }
 
-        std::uniform_real_distribution<float> dist(
-            0.0f,
-            static_cast<float>(m_maxJitter - 1));
-        
-        const float s = m_noiseFilter.fast_f(dist(m_generator) * m_jitterScale * jitterScale);
+        const float s = m_noiseFilter.fast_f(
+            m_random.uniform(0.0f, static_cast<float>(m_maxJitter - 1)) * m_jitterScale * jitterScale);
         const float s_i_0 = clamp(std::floor(s), 0.0f, static_cast<float>(m_maxJitter - 1));
         const float s_i_1 = clamp(std::ceil(s), 0.0f, static_cast<float>(m_maxJitter - 1));
 
@@ -51,9 +47,53 @@ public:
         return v1 * s_frac + v0 * (1 - s_frac);
     }
 
+    // Draws the whole block's offsets through the noise filter before
+    // gathering; output is used as scratch so it must not alias input.
+    void fast_f(const float *input, float *output, int n, float jitterScale = 1.0f) {
+        if (m_history == nullptr || m_maxJitter <= 0) {
+            for (int i = 0; i < n; ++i) {
+                output[i] = input[i];
+            }
+
+            return;
+        }
+
+        const float maxOffset = static_cast<float>(m_maxJitter - 1);
+        for (int i = 0; i < n; ++i) {
+            output[i] = m_random.uniform(0.0f, maxOffset) * m_jitterScale * jitterScale;
+        }
+
+        m_noiseFilter.fast_f(output, output, n);
+
+        for (int i = 0; i < n; ++i) {
+            m_history[m_offset] = input[i];
+            ++m_offset;
+
+            if (m_offset >= m_maxJitter) {
+                m_offset = 0;
+            }
+
+            const float s = output[i];
+            const float s_i_0 = clamp(std::floor(s), 0.0f, maxOffset);
+            const float s_i_1 = clamp(std::ceil(s), 0.0f, maxOffset);
+
+            const float s_frac = (s - s_i_0);
+
+            const int i_0 = static_cast<int>(s_i_0) + m_offset;
+            const int i_1 = static_cast<int>(s_i_1) + m_offset;
+
+            const float v0 = m_history[i_0 >= m_maxJitter ? i_0 - m_maxJitter : i_0];
+            const float v1 = m_history[i_1 >= m_maxJitter ? i_1 - m_maxJitter : i_1];
+
+            output[i] = v1 * s_frac + v0 * (1 - s_frac);
+        }
+    }
+
     inline void setJitterScale(float jitterScale) { m_jitterScale = jitterScale; }
     inline float getJitterScale() const { return m_jitterScale; }
 
+    void seed(uint64_t seed, uint32_t stream) { m_random.seed(seed, stream); }
+
 protected:
     ButterworthLowPassFilter<float> m_noiseFilter;
 
@@ -62,7 +102,7 @@ protected:
     int m_offset;
     float *m_history;
 
-    std::default_random_engine m_generator;
+    RandomStream m_random;
 };
 
 #endif /* ATG_ENGINE_SIM_JITTER_FILTER_H */
@@ -0,0 +1,134 @@
+#ifndef ATG_ENGINE_SIM_JOB_SYSTEM_H
+#define ATG_ENGINE_SIM_JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing scheduler that sweeps, studies, the simulation host and
+// impulse response decoding share, so running several of them at once
+// doesn't put more threads than cores to work. Each worker has a deque per
+// priority: it takes its own newest job first and otherwise steals the
+// oldest from the others, always draining every queue of a higher priority
+// before looking at a lower one. Jobs aren't preempted, so loading jobs are
+// kept off one worker whenever there are two or more, which is then always
+// free for physics.
+//
+// Threads that wait on their jobs run queued jobs of the same or a higher
+// priority meanwhile, so nested fork/join can't deadlock and a physics
+// caller never ends up running a loading job.
+//
+// The per-substep fluid stages stay on their own spinning ThreadPool; they
+// dispatch far too often and too briefly to go through a queue.
+class JobSystem {
+    public:
+        enum class Priority {
+            Physics,
+            Normal,
+            Loading,
+            Count
+        };
+
+        // Fork/join: jobs run on the system and wait() returns once all of
+        // them completed. Destroying a group waits for it.
+        class Group {
+            public:
+                Group(JobSystem *system = nullptr, Priority priority = Priority::Normal);
+                ~Group();
+
+                void run(std::function<void()> job);
+                void wait();
+
+            protected:
+                JobSystem *m_system;
+                Priority m_priority;
+                std::atomic<int> m_pending;
+        };
+
+    public:
+        JobSystem();
+        ~JobSystem();
+
+        // Worker threads, not counting the threads that wait on jobs
+        void initialize(int workerCount);
+
+        // Runs whatever is still queued, then joins the workers
+        void destroy();
+
+        // Runs fn(i) for i in [0, n) on at most width threads including the
+        // calling one (0 is every worker plus the caller) and returns once
+        // all of them completed. Indices are handed out one at a time, so
+        // uneven iterations balance.
+        template <typename T_Fn>
+        void parallelFor(int n, T_Fn &&fn, Priority priority = Priority::Normal, int width = 0) {
+            typedef typename std::remove_reference<T_Fn>::type Fn;
+            run(n, [](void *context, int i) { (*static_cast<Fn *>(context))(i); }, &fn, priority, width);
+        }
+
+        typedef void (*Task)(void *context, int index);
+        void run(int n, Task task, void *context, Priority priority, int width);
+
+        int getWorkerCount() const { return static_cast<int>(m_threads.size()); }
+
+        // Parallel width parallelFor() uses for a width of 0
+        int getConcurrency() const { return getWorkerCount() + 1; }
+
+        // Started on first use with a worker for every hardware thread but
+        // one, and stopped at exit
+        static JobSystem &Shared();
+
+    protected:
+        struct Job {
+            std::function<void()> run;
+            std::atomic<int> *pending = nullptr;
+            Priority priority = Priority::Normal;
+
+            // Holds one of the loading slots while it runs
+            bool reserved = false;
+        };
+
+        struct Queue {
+            std::mutex lock;
+            std::deque<Job> jobs[static_cast<int>(Priority::Count)];
+        };
+
+        void worker(int index);
+        void push(Job job);
+
+        // Takes the most urgent job no less urgent than lowest; false when
+        // there is none
+        bool take(Priority lowest, Job *job);
+        bool takeFrom(int queue, Priority priority, bool newest, Job *job);
+        void execute(Job &job);
+        void wake();
+
+        // Runs queued jobs while waiting for pending to reach zero
+        void help(std::atomic<int> &pending, Priority lowest);
+
+        bool hasWork() const;
+        bool isWorker() const;
+        int currentQueue() const;
+
+        std::vector<std::thread> m_threads;
+
+        // One per worker, then one for threads outside the system
+        std::vector<Queue *> m_queues;
+        int m_loadingSlots;
+
+        std::atomic<int> m_queued[static_cast<int>(Priority::Count)];
+        std::atomic<int> m_runningLoading;
+        std::atomic<unsigned int> m_stealOffset;
+        std::atomic<bool> m_run;
+
+        std::mutex m_sleepLock;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        std::atomic<int> m_sleeping;
+};
+
+#endif /* ATG_ENGINE_SIM_JOB_SYSTEM_H */
@@ -0,0 +1,63 @@
+// Included once by each src/kernels_*.cpp with
+// ATG_ENGINE_SIM_KERNEL_NAMESPACE naming the ISA; no include guard on
+// purpose. Only operators and builtins are used here: an inline library
+// function instantiated under AVX2 flags could otherwise be the copy the
+// linker keeps for every ISA.
+
+#include "kernel_dispatch.h"
+
+#include <cstdint>
+
+namespace ATG_ENGINE_SIM_KERNEL_NAMESPACE {
+
+    // Sums in eight independent lanes so the loop vectorizes; the result can
+    // differ from a sequential sum in the last bits
+    float dotProduct(const float *a, const float *b, int n) {
+        float lanes[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            for (int j = 0; j < 8; ++j) {
+                lanes[j] += a[i + j] * b[i + j];
+            }
+        }
+
+        float result =
+            ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5]))
+            + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+        for (; i < n; ++i) {
+            result += a[i] * b[i];
+        }
+
+        return result;
+    }
+
+    // Clamps NaN to INT16_MIN like fmin(fmax()) did
+    void quantizeToInt16(
+        const float *input, int16_t *output, int n, float scale, const float *dither)
+    {
+        for (int i = 0; i < n; ++i) {
+            float x = input[i] * scale;
+            if (dither != nullptr) x += dither[i];
+
+            x = (x > (float)INT16_MIN) ? x : (float)INT16_MIN;
+            x = (x < (float)INT16_MAX) ? x : (float)INT16_MAX;
+            output[i] = static_cast<int16_t>(x + ((x < 0) ? -0.5f : 0.5f));
+        }
+    }
+
+    // acc += x * y over n interleaved complex values
+    void multiplyAccumulateSpectrum(float *acc, const float *x, const float *y, int n) {
+        for (int i = 0; i < 2 * n; i += 2) {
+            acc[i] += x[i] * y[i] - x[i + 1] * y[i + 1];
+            acc[i + 1] += x[i] * y[i + 1] + x[i + 1] * y[i];
+        }
+    }
+
+    const KernelDispatch::Table Table = {
+        dotProduct,
+        quantizeToInt16,
+        multiplyAccumulateSpectrum
+    };
+
+} /* namespace ATG_ENGINE_SIM_KERNEL_NAMESPACE */
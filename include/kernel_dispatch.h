@@ -0,0 +1,65 @@
+#ifndef ATG_ENGINE_SIM_KERNEL_DISPATCH_H
+#define ATG_ENGINE_SIM_KERNEL_DISPATCH_H
+
+#include <cstdint>
+
+// Hot audio kernels compiled once per instruction set and bound at startup
+// to the best one the host runs, so one binary serves AVX2 servers,
+// AVX-512 boxes and Apple Silicon alike. The same loop bodies
+// (kernel_bodies.h) are built by one translation unit per ISA with that
+// ISA's flags and FP contraction off, so every path sums the same lanes in
+// the same order and matches the scalar one bit for bit.
+//
+// The ISA is chosen on first use: ENGINE_SIM_KERNEL_ISA in the environment
+// if the host supports it, otherwise the best available. setIsa() forces
+// one for A/B benchmarking and should be called before any kernels run.
+class KernelDispatch {
+    public:
+        enum class Isa {
+            Scalar,     // Vectorizer off
+            Sse2,       // x86-64 baseline
+            Avx2,
+            Avx512,
+            Neon,       // AArch64 baseline
+            Count
+        };
+
+        struct Table {
+            float (*dotProduct)(const float *a, const float *b, int n);
+            void (*quantizeToInt16)(
+                const float *input, int16_t *output, int n, float scale, const float *dither);
+            void (*multiplyAccumulateSpectrum)(float *acc, const float *x, const float *y, int n);
+        };
+
+        struct CpuFeatures {
+            bool sse2 = false;
+            bool avx2 = false;
+            bool avx512f = false;
+            bool neon = false;
+        };
+
+    public:
+        static const Table &Get();
+
+        static Isa GetIsa();
+        static bool SetIsa(Isa isa);
+        static bool IsSupported(Isa isa);
+        static Isa Best();
+
+        static const CpuFeatures &GetCpuFeatures();
+
+        static const char *GetName(Isa isa);
+        static bool Parse(const char *name, Isa *isa);
+
+    protected:
+        // Null when the build or the compiler couldn't target the ISA
+        static const Table *scalarTable();
+        static const Table *baselineTable();
+        static const Table *avx2Table();
+        static const Table *avx512Table();
+
+        static const Table *table(Isa isa);
+        static const Table *initialize();
+};
+
+#endif /* ATG_ENGINE_SIM_KERNEL_DISPATCH_H */
@@ -28,6 +28,14 @@ class LabeledGauge : public UiElement {
         float m_margin = 10.0f;
         float m_needleInnerRadius = 0.1f;
         float m_needleOuterRadius = 0.7f;
+
+    protected:
+        // The value as last displayed, in units of its last digit, and its
+        // text; reformatted only when the displayed digits or units change
+        long long m_displayedValue;
+        int m_displayedPrecision;
+        std::string m_displayedUnit;
+        std::string m_valueText;
 };
 
 #endif /* ATG_ENGINE_SIM_LABELED_GAUGE_H */
@@ -0,0 +1,91 @@
+#ifndef ATG_ENGINE_SIM_LATENCY_PROBE_H
+#define ATG_ENGINE_SIM_LATENCY_PROBE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Measures how long an input takes to be heard. A tagged control event is
+// followed through each stage of the audio path: the physics step that
+// applies it, the synthesizer input block that publishes the first sample
+// written after it, the render that turns that sample into output, the
+// read that hands the output to the application and the moment it reaches
+// the device's write position. Each stage is marked by the one thread that
+// runs it, in order, so a single probe is in flight at a time; the next tag
+// begins once it completes, or after Timeout if a stage never comes.
+//
+// Samples are followed by their index in the synthesizer's rings, so the
+// input stage can be up to one block of staged synthesizer frames early,
+// and the device stage is the one the application computes from its lead,
+// not a measured play-out.
+class LatencyProbe {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Stage {
+            Input,
+            Applied,
+            Published,
+            Rendered,
+            Read,
+            Played,
+            Count
+        };
+
+        static constexpr int StageCount = static_cast<int>(Stage::Count);
+        static constexpr int HistoryLength = 256;
+        static constexpr double Timeout = 2.0;
+
+        struct Statistics {
+            int count = 0;
+            double p50 = 0.0;
+            double p99 = 0.0;
+            double max = 0.0;
+        };
+
+    public:
+        LatencyProbe();
+        ~LatencyProbe();
+
+        void setEnabled(bool enabled) { m_enabled = enabled; }
+        bool isEnabled() const { return m_enabled; }
+
+        // Input thread; false if disabled or a probe is still in flight
+        bool begin(Clock::time_point inputTime);
+
+        // Whether the probe in flight is waiting for stage to be marked
+        inline bool isWaiting(Stage stage) const {
+            return m_stage.load(std::memory_order_acquire) == static_cast<int>(stage) - 1;
+        }
+
+        // Position the stage recorded, a ring index or an offset into a read
+        inline size_t getPosition(Stage stage) const { return m_positions[static_cast<int>(stage)]; }
+
+        void mark(Stage stage, size_t position = 0) { mark(stage, position, Clock::now()); }
+        void mark(Stage stage, size_t position, Clock::time_point time);
+
+        // Milliseconds from the previous stage to this one, over the last
+        // HistoryLength probes; Stage::Input gives input to device
+        Statistics getStatistics(Stage stage) const;
+        int getCompletedCount() const;
+
+        void reset();
+
+        static const char *GetStageName(Stage stage);
+
+    protected:
+        void complete();
+
+        std::atomic<bool> m_enabled;
+        std::atomic<int> m_stage;
+        Clock::time_point m_times[StageCount];
+        size_t m_positions[StageCount];
+
+        mutable std::mutex m_historyLock;
+        std::vector<double> m_history[StageCount];
+        int m_completed;
+};
+
+#endif /* ATG_ENGINE_SIM_LATENCY_PROBE_H */
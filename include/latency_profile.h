@@ -0,0 +1,40 @@
+#ifndef ATG_ENGINE_SIM_LATENCY_PROFILE_H
+#define ATG_ENGINE_SIM_LATENCY_PROFILE_H
+
+#include <string>
+
+// Audio pipeline sizing derived from a single end-to-end latency target
+struct LatencyProfile {
+    static constexpr double LiveLatency = 0.015;
+    static constexpr double BalancedLatency = 0.1;
+    static constexpr double OfflineLatency = 0.5;
+
+    // Input queued ahead of the audio thread, in seconds
+    double targetLatency = BalancedLatency;
+
+    // Output written ahead of the device's play cursor, in seconds
+    double outputLeadTime = BalancedLatency;
+
+    int inputBufferSize = 44100;
+    int audioBufferSize = 44100;
+
+    // Most samples the audio thread keeps queued for output in live mode
+    int renderLimit = 1985;
+
+    // Reduced memory trims the rings to what the latency actually needs, for
+    // servers running many instances with a steady producer
+    static LatencyProfile fromTargetLatency(
+        double latency,
+        int sampleRate = 44100,
+        bool reducedMemory = false);
+
+    // Accepts "live", "balanced" or "offline" (case insensitive); a positive
+    // targetLatency overrides the named profile's latency
+    static LatencyProfile fromSettings(
+        const std::string &name,
+        double targetLatency = 0.0,
+        int sampleRate = 44100,
+        bool reducedMemory = false);
+};
+
+#endif /* ATG_ENGINE_SIM_LATENCY_PROFILE_H */
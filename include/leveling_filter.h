@@ -5,18 +5,46 @@
 
 #include "function.h"
 
+#include <vector>
+
 class LevelingFilter : public Filter {
     public:
         LevelingFilter();
         virtual ~LevelingFilter();
 
         virtual float f(float sample);
+        void fast_f(const float *input, float *output, int n);
         float getAttenuation() const { return m_attenuation; }
 
+        // Block mode: the peak envelope and the target gain are updated once
+        // per blockSize samples and the gain is ramped linearly across the
+        // block, so there is one division per block instead of per sample.
+        // The output is delayed by lookahead samples while the envelope sees
+        // the undelayed input, so the gain is already down when a transient
+        // leaves. Allocates; call before rendering. A blockSize of 0 goes
+        // back to leveling every sample.
+        //
+        // With more than one channel, block_f() takes n interleaved frames
+        // and every channel gets the gain of the loudest, so levelling
+        // doesn't move a mix's stereo image; blockSize and lookahead stay in
+        // frames.
+        void initializeBlockMode(int blockSize, int lookahead, int channels = 1);
+        void block_f(const float *input, float *output, int n);
+        int getLookahead() const { return m_lookahead; }
+        int getChannelCount() const { return m_channels; }
+
     protected:
         float m_peak;
         float m_attenuation;
 
+        // Block mode; m_lookahead delayed samples followed by one block
+        std::vector<float> m_delay;
+        int m_blockSize;
+        int m_lookahead;
+        int m_channels;
+        float m_blockPeakDecay;
+        float m_blockSmoothing;
+
     public:
         float p_maxLevel;
         float p_minLevel;
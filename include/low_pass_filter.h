@@ -23,6 +23,18 @@ class LowPassFilter : public Filter {
             return m_y;
         }
 
+        __forceinline void fast_f(const float *input, float *output, int n) {
+            const float alpha = m_dt / (m_rc + m_dt);
+
+            float y = m_y;
+            for (int i = 0; i < n; ++i) {
+                y = alpha * input[i] + (1 - alpha) * y;
+                output[i] = y;
+            }
+
+            m_y = y;
+        }
+
         inline void setCutoffFrequency(float f) {
             m_rc = 1.0f / (f * 2.0f * static_cast<float>(constants::pi));
         }
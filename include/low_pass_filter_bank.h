@@ -0,0 +1,36 @@
+#ifndef ATG_ENGINE_SIM_LOW_PASS_FILTER_BANK_H
+#define ATG_ENGINE_SIM_LOW_PASS_FILTER_BANK_H
+
+// LowPassFilter run over several channels with the same cutoff, grouped and
+// padded like ButterworthLowPassFilterBank. Channel i gives the same output
+// as its own LowPassFilter.
+class LowPassFilterBank {
+    public:
+        static constexpr int Lanes = 4;
+
+    public:
+        LowPassFilterBank();
+        ~LowPassFilterBank();
+
+        void initialize(int channels);
+        void destroy();
+
+        void setCutoffFrequency(float f, float dt);
+
+        // n samples of every channel, planar; input and output may alias
+        void process(const float *const *input, float *const *output, int n);
+
+        // One sample of one channel, for the per-sample renderer
+        float process(int channel, float sample);
+
+        int getChannelCount() const { return m_channelCount; }
+
+    protected:
+        float *m_y;
+        int m_groupCount;
+        int m_channelCount;
+
+        float m_alpha;
+};
+
+#endif /* ATG_ENGINE_SIM_LOW_PASS_FILTER_BANK_H */
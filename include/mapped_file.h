@@ -0,0 +1,31 @@
+#ifndef ATG_ENGINE_SIM_MAPPED_FILE_H
+#define ATG_ENGINE_SIM_MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file; memory-mapped on POSIX hosts and read into
+// memory elsewhere
+class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        bool open(const std::string &path);
+        void close();
+
+        const char *getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    private:
+        const char *m_data;
+        size_t m_size;
+
+#if defined(_WIN32)
+        std::vector<char> m_buffer;
+#else
+        void *m_mapped;
+#endif /* _WIN32 */
+};
+
+#endif /* ATG_ENGINE_SIM_MAPPED_FILE_H */
@@ -0,0 +1,105 @@
+#ifndef ATG_ENGINE_SIM_METRICS_EXPORTER_H
+#define ATG_ENGINE_SIM_METRICS_EXPORTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Simulator;
+
+// Serves Prometheus text exposition (format 0.0.4) over HTTP for server
+// deployments: per-instance figures the owners publish, and the process-wide
+// step profiler stages as histograms, event counters and allocation tags
+// where those are compiled in.
+//
+// Nothing here runs on a real-time thread. Owners publish a finished
+// InstanceMetrics with relaxed stores, which never wait, and the background
+// thread reads them and the other registries' relaxed counters when a
+// scraper asks. A scrape can mix two publishes of one instance; each value
+// on its own is always whole.
+class MetricsExporter {
+    public:
+        static constexpr int MaxInstances = 64;
+
+        enum class Metric {
+            Steps,
+            SimulatedSeconds,
+            WallSeconds,
+            Rpm,
+            AudioBlocks,
+            AudioRenderSeconds,
+            AudioUnderruns,
+            AudioOverruns,
+            LockContentions,
+            InputDroppedSamples,
+            InputQueueSamples,
+            OutputQueueSamples,
+            Count
+        };
+
+        static constexpr int MetricCount = static_cast<int>(Metric::Count);
+
+        struct InstanceMetrics {
+            double values[MetricCount] = {};
+
+            void set(Metric metric, double value) { values[static_cast<int>(metric)] = value; }
+            double get(Metric metric) const { return values[static_cast<int>(metric)]; }
+        };
+
+        struct Parameters {
+            // 0 picks a free port
+            int port = 9464;
+        };
+
+    public:
+        MetricsExporter();
+        ~MetricsExporter();
+
+        bool initialize(const Parameters &params);
+        void destroy();
+
+        bool isOpen() const { return m_socket != ClosedSocket; }
+        int getPort() const { return m_port; }
+
+        // Reads the synthesizer and engine; call on the simulator's own
+        // thread. Steps and times are the caller's.
+        static void Collect(Simulator *simulator, InstanceMetrics *metrics);
+
+        // Shown as the instance's engine label; set before publishing
+        void setInstanceLabel(int instance, const std::string &label);
+        void publish(int instance, const InstanceMetrics &metrics);
+        void removeInstance(int instance);
+
+        std::string render() const;
+        unsigned long long getScrapeCount() const { return m_scrapes.load(std::memory_order_relaxed); }
+
+    protected:
+        static constexpr intptr_t ClosedSocket = -1;
+
+        struct InstanceSlot {
+            std::atomic<bool> active{ false };
+            std::atomic<double> values[MetricCount];
+        };
+
+        static_assert(std::atomic<double>::is_always_lock_free, "publishing must not lock");
+
+        void serve();
+        void respond(intptr_t client);
+
+        InstanceSlot m_instances[MaxInstances];
+
+        // Guarded by m_labelLock; neither side is a real-time thread
+        std::string m_labels[MaxInstances];
+        mutable std::mutex m_labelLock;
+
+        intptr_t m_socket;
+        int m_port;
+
+        std::thread *m_thread;
+        std::atomic<bool> m_run;
+        std::atomic<unsigned long long> m_scrapes;
+};
+
+#endif /* ATG_ENGINE_SIM_METRICS_EXPORTER_H */
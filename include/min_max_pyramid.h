@@ -0,0 +1,58 @@
+#ifndef ATG_ENGINE_SIM_MIN_MAX_PYRAMID_H
+#define ATG_ENGINE_SIM_MIN_MAX_PYRAMID_H
+
+#include <vector>
+
+// Multi-resolution summary of a ring of (x, y) samples for drawing more of
+// them than there are pixels. Level l keeps, for each aligned block of 2^l
+// ring slots, its lowest and highest sample, so a run of samples can be
+// drawn as two points per block without losing its peaks.
+//
+// The ring itself is owned by the caller, which reports each write; only the
+// blocks over written slots are recombined, log2(size) per sample.
+class MinMaxPyramid {
+    public:
+        struct Point {
+            double x, y;
+        };
+
+        struct Block {
+            Point lo, hi;
+            int loIndex, hiIndex;
+        };
+
+    public:
+        MinMaxPyramid();
+        ~MinMaxPyramid();
+
+        void initialize(int size);
+        void destroy();
+
+        // Slots [first, first + count) of the ring, wrapping, were written
+        void update(const Point *samples, int first, int count);
+
+        // Writes the window of count samples starting at slot start, in ring
+        // order, using the finest level that needs at most about maxPoints
+        // points; returns how many were written, never more than count
+        int decimate(
+            const Point *samples,
+            int start,
+            int count,
+            int maxPoints,
+            Point *out) const;
+
+        int getSize() const { return m_size; }
+        int getLevelCount() const { return (int)m_levels.size() + 1; }
+        const Block &getBlock(int level, int index) const { return m_levels[level - 1][index]; }
+
+    protected:
+        void updateRange(const Point *samples, int begin, int end);
+        int decimateRange(const Point *samples, int begin, int end, int level, Point *out) const;
+
+        int m_size;
+
+        // m_levels[l - 1] holds the blocks of 2^l slots
+        std::vector<std::vector<Block>> m_levels;
+};
+
+#endif /* ATG_ENGINE_SIM_MIN_MAX_PYRAMID_H */
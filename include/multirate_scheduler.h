@@ -0,0 +1,69 @@
+#ifndef ATG_ENGINE_SIM_MULTIRATE_SCHEDULER_H
+#define ATG_ENGINE_SIM_MULTIRATE_SCHEDULER_H
+
+#include "scs.h"
+
+#include <vector>
+
+class Engine;
+
+// Solves the rigid bodies once every interval simulation steps while the
+// gas keeps stepping at the full rate. Each solve covers the whole interval
+// ahead, and the engine's crankshafts, pistons and rods, along with the
+// vehicle mass the clutch and transmission drive, are then moved in a
+// straight line from where they were to the solved state, one step at a
+// time, so chamber volumes, valve lifts, ignition angles and the vehicle's
+// speed still change every step. The last step of an interval lands exactly on the solved
+// state, which the next solve starts from. The piston force over an
+// interval comes from each chamber's pressure averaged over the interval
+// before, the pressure the gas saw along the path the pistons were moved.
+class MultirateScheduler {
+    public:
+        MultirateScheduler();
+        ~MultirateScheduler();
+
+        // Takes the bodies from engine, which may be null to only set the
+        // interval, and the vehicle mass if there is one, and returns the
+        // chambers to the live pressure; restarts at the beginning of an
+        // interval
+        void initialize(Engine *engine, atg_scs::RigidBody *vehicleMass, int interval);
+        void destroy();
+
+        int getInterval() const { return m_interval; }
+
+        // Whether the coming step begins an interval and needs a solve
+        bool isSolveDue() const { return m_phase == 0; }
+
+        // Around the solve: fixes the chambers' piston force and records
+        // where the bodies start, then where they end up
+        void beginSolve();
+        void endSolve();
+
+        // Before each step's engine update; places the bodies for the step
+        void interpolate();
+
+        // After each step's fluid update
+        void samplePressures();
+
+    protected:
+        struct State {
+            double p_x = 0.0;
+            double p_y = 0.0;
+            double theta = 0.0;
+            double v_x = 0.0;
+            double v_y = 0.0;
+            double v_theta = 0.0;
+        };
+
+        static State capture(const atg_scs::RigidBody &body);
+
+        Engine *m_engine;
+        int m_interval;
+        int m_phase;
+
+        std::vector<atg_scs::RigidBody *> m_bodies;
+        std::vector<State> m_start;
+        std::vector<State> m_end;
+};
+
+#endif /* ATG_ENGINE_SIM_MULTIRATE_SCHEDULER_H */
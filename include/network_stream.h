@@ -0,0 +1,174 @@
+#ifndef ATG_ENGINE_SIM_NETWORK_STREAM_H
+#define ATG_ENGINE_SIM_NETWORK_STREAM_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class Synthesizer;
+struct SimulationSnapshot;
+
+// Serves the synthesizer output and telemetry to remote listeners over UDP,
+// and takes their control changes back on the same socket. A listener is
+// any address that sent a Hello or Control packet in the last
+// listenerTimeout seconds. Audio goes out as raw 16-bit mono PCM in frames
+// of frameSamples (5 ms at 44.1 kHz by default), read from the
+// synthesizer's output ring straight into the packet; whatever is less than
+// a frame waits for the next call.
+//
+// Every call is non-blocking. A packet the socket can't take is dropped
+// rather than queued, so a slow listener costs only its own packets. Packets
+// are in the host's byte order and native alignment; the layout is part of
+// the protocol and only ever extended by bumping Version.
+class NetworkStream {
+    public:
+        static constexpr uint32_t Magic = 0x534E5345; // "ESNS"
+        static constexpr uint16_t Version = 1;
+        static constexpr int MaxFrameSamples = 1024;
+
+        enum class PacketType : uint16_t {
+            Hello = 1,
+            Goodbye = 2,
+            Audio = 3,
+            Telemetry = 4,
+            Control = 5
+        };
+
+        struct PacketHeader {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t type;
+
+            // Per packet type, so listeners can count their losses
+            uint32_t sequence;
+            uint32_t reserved;
+        };
+
+        struct AudioPacket {
+            PacketHeader header;
+            uint32_t sampleRate;
+            uint16_t channels;
+            uint16_t sampleCount;
+
+            // Of the first sample since the stream started
+            uint64_t position;
+            int16_t samples[MaxFrameSamples];
+        };
+
+        struct TelemetryPacket {
+            PacketHeader header;
+            double time;
+            float rpm;
+            float redline;
+            float manifoldPressure;
+            float intakeAfr;
+            float dynoTorque;
+            float dynoPower;
+            float vehicleSpeed;
+            int32_t gear;
+            uint32_t flags;
+            uint32_t listeners;
+        };
+
+        enum Flags : uint32_t {
+            IgnitionEnabled = 1u << 0,
+            StarterEnabled = 1u << 1,
+            DynoEnabled = 1u << 2
+        };
+
+        struct ControlPacket {
+            PacketHeader header;
+            float throttle;
+            float clutch;
+
+            // rpm
+            float dynoSpeed;
+            int32_t gear;
+            uint32_t flags;
+        };
+
+        struct Controls {
+            double throttle = 0.0;
+            double clutch = 1.0;
+            double dynoSpeed = 0.0;
+            int gear = -1;
+            bool ignition = true;
+            bool starter = false;
+            bool dyno = false;
+        };
+
+        struct Parameters {
+            int port = 7850;
+            int frameSamples = 220;
+            int maxListeners = 32;
+            double listenerTimeout = 5.0;
+        };
+
+        struct Statistics {
+            unsigned long long audioPackets = 0;
+            unsigned long long telemetryPackets = 0;
+            unsigned long long controlPackets = 0;
+
+            // Sends the socket refused; never retried
+            unsigned long long droppedPackets = 0;
+            unsigned long long rejectedPackets = 0;
+        };
+
+    public:
+        NetworkStream();
+        ~NetworkStream();
+
+        bool initialize(const Parameters &params);
+        void destroy();
+
+        bool isOpen() const;
+
+        // Takes every waiting packet off the socket; returns true and
+        // updates controls when a listener sent new ones. With several
+        // listeners controlling, the latest packet wins.
+        bool poll(Controls *controls);
+
+        // Sends every whole frame in the synthesizer's output to every
+        // listener; returns the samples consumed
+        int sendAudio(Synthesizer &synthesizer);
+
+        void sendTelemetry(const SimulationSnapshot &snapshot);
+
+        int getListenerCount() const { return static_cast<int>(m_listeners.size()); }
+        int getPort() const { return m_port; }
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Address {
+            uint8_t storage[128];
+            uint32_t length;
+        };
+
+        struct Listener {
+            Address address;
+            Clock::time_point lastSeen;
+        };
+
+        void touchListener(const Address &address);
+        void removeListener(const Address &address);
+        void expireListeners();
+        void broadcast(const void *data, int size);
+        void fillHeader(PacketHeader *header, PacketType type, uint32_t sequence) const;
+
+        Parameters m_parameters;
+        intptr_t m_socket;
+        int m_port;
+
+        std::vector<Listener> m_listeners;
+
+        AudioPacket m_audioPacket;
+        uint32_t m_audioSequence;
+        uint32_t m_telemetrySequence;
+        uint64_t m_position;
+
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_NETWORK_STREAM_H */
@@ -3,11 +3,12 @@
 
 #include "ui_element.h"
 
+#include "min_max_pyramid.h"
+#include "geometry_generator.h"
+
 class Oscilloscope : public UiElement {
     public:
-        struct DataPoint {
-            double x, y;
-        };
+        typedef MinMaxPyramid::Point DataPoint;
 
     public:
         Oscilloscope();
@@ -17,6 +18,7 @@ class Oscilloscope : public UiElement {
         virtual void destroy();
 
         virtual void update(float dt);
+        virtual void generateGeometry();
         virtual void render();
         void render(const Bounds &bounds);
 
@@ -26,7 +28,11 @@ class Oscilloscope : public UiElement {
 
         void addDataPoint(double x, double y);
 
+        // Adds count points at x0, x0 + dx, ... taking every stride-th y
+        void addDataPoints(double x0, double dx, const float *y, int stride, int count);
+
         void setBufferSize(int n);
+        int getBufferSize() const { return m_bufferSize; }
         void reset();
 
         double m_xMin;
@@ -45,11 +51,38 @@ class Oscilloscope : public UiElement {
         ysVector i_color;
 
     protected:
+        // The path and zero line for bounds; false with nothing to draw
+        bool generate(
+            const Bounds &bounds,
+            GeometryGenerator::GeometryIndices *lines,
+            GeometryGenerator::GeometryIndices *zeroLine);
+        void draw(
+            const GeometryGenerator::GeometryIndices &lines,
+            const GeometryGenerator::GeometryIndices &zeroLine);
+
+        // Shapes generateGeometry() left for the next render() at m_bounds
+        GeometryGenerator::GeometryIndices m_lines;
+        GeometryGenerator::GeometryIndices m_zeroLine;
+        bool m_prepared;
+
         DataPoint *m_points;
         Point *m_renderBuffer;
         int m_writeIndex;
         int m_bufferSize;
         int m_pointCount;
+
+        // Points added since m_renderBuffer was last brought up to date;
+        // everything is converted again when the mapping changes
+        int m_unconvertedCount;
+        Bounds m_convertedBounds;
+        double m_convertedRange[4];
+
+        // Once there are more points than about two per horizontal pixel,
+        // the path is drawn from the pyramid's min/max blocks instead, and
+        // converted every frame since the blocks chosen depend on the width
+        MinMaxPyramid m_pyramid;
+        DataPoint *m_decimatedPoints;
+        Point *m_decimatedBuffer;
 };
 
 #endif /* ATG_ENGINE_SIM_OSCILLOSCOPE_H */
@@ -10,6 +10,9 @@ class OscilloscopeCluster : public UiElement {
     private:
         static constexpr int MaxLayeredScopes = 5;
 
+        // One plotted point per this many simulation steps
+        static constexpr int SampleDecimation = 2;
+
     public:
         OscilloscopeCluster();
         virtual ~OscilloscopeCluster();
@@ -20,7 +23,11 @@ class OscilloscopeCluster : public UiElement {
 
         virtual void update(float dt);
         virtual void render();
+        virtual void layout();
+        virtual void onVisibilityChanged(bool shown);
 
+        // Drains the simulator's telemetry tap into the scopes; while the
+        // cluster is hidden the simulator doesn't write telemetry at all
         void sample();
         void setSimulator(Simulator *simulator);
 
@@ -43,7 +50,10 @@ class OscilloscopeCluster : public UiElement {
             const std::string &title,
             bool overlay=false);
 
+        void addRecord(const TelemetryTap::Record &record);
+
         Simulator *m_simulator;
+        unsigned int m_sampleIndex;
         Oscilloscope
             *m_torqueScope,
             *m_powerScope,
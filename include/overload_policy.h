@@ -0,0 +1,51 @@
+#ifndef ATG_ENGINE_SIM_OVERLOAD_POLICY_H
+#define ATG_ENGINE_SIM_OVERLOAD_POLICY_H
+
+// Decides how much fidelity to shed when the physics can't keep the audio
+// fed. Every frame it's given the audio buffered ahead of the device as a
+// fraction of the latency target. A few frames in a row under the shed
+// headroom, or any underrun, sheds one more level; a longer run over the
+// recover headroom restores one. Levels are cumulative and shed the cheapest
+// fidelity to give up first.
+class OverloadPolicy {
+    public:
+        enum class Level {
+            None,
+            Scopes,
+            FluidSubsteps,
+            Convolution
+        };
+
+        struct Parameters {
+            double shedHeadroom = 0.5;
+            double recoverHeadroom = 0.9;
+            int shedFrames = 3;
+            int recoverFrames = 120;
+        };
+
+    public:
+        OverloadPolicy();
+        ~OverloadPolicy();
+
+        void initialize(const Parameters &params);
+        void reset();
+
+        // Returns whether the level changed
+        bool update(double headroom, bool underrun);
+
+        Level getLevel() const { return m_level; }
+        bool isShedding(Level level) const { return m_level >= level; }
+        unsigned long long getShedCount() const { return m_shedCount; }
+
+        static const char *GetLevelName(Level level);
+
+    protected:
+        Parameters m_parameters;
+        Level m_level;
+
+        int m_lowFrames;
+        int m_highFrames;
+        unsigned long long m_shedCount;
+};
+
+#endif /* ATG_ENGINE_SIM_OVERLOAD_POLICY_H */
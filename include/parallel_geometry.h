@@ -0,0 +1,81 @@
+#ifndef ATG_ENGINE_SIM_PARALLEL_GEOMETRY_H
+#define ATG_ENGINE_SIM_PARALLEL_GEOMETRY_H
+
+#include "geometry_generator.h"
+
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+class JobSystem;
+
+// Generates the per-frame shapes of independent producers, such as the UI
+// elements and simulation objects, on the job system. Each thread writes
+// into pages of its own, and the producers' ranges are then copied into the
+// shared generator in producer order, so its buffers come out the same
+// however the jobs were scheduled.
+//
+// Producers go through EngineSimApplication::getGeometryGenerator() as
+// usual. The GeometryIndices they end shapes into are rebased as they're
+// copied, so they have to outlive run(). generateInstance() reads the
+// generator it writes into, so producers can't instance shapes kept in the
+// shared one.
+class ParallelGeometry {
+    public:
+        struct Statistics {
+            int producers = 0;
+            int threads = 0;
+            int vertices = 0;
+            int indices = 0;
+        };
+
+    public:
+        ParallelGeometry();
+        ~ParallelGeometry();
+
+        void initialize(JobSystem *jobs);
+        void destroy();
+
+        // Off runs every producer on the calling thread, straight into the
+        // shared generator
+        void setEnabled(bool enabled) { m_enabled = enabled; }
+        bool isEnabled() const { return m_enabled; }
+
+        // Calls generate(i) for i in [0, n) with target as the generator
+        // and returns once their shapes are in it
+        template <typename T_Fn>
+        void run(GeometryGenerator *target, int n, T_Fn &&generate) {
+            typedef typename std::remove_reference<T_Fn>::type Fn;
+            run(target, n, [](void *context, int i) { (*static_cast<Fn *>(context))(i); }, &generate);
+        }
+
+        typedef void (*Producer)(void *context, int index);
+        void run(GeometryGenerator *target, int n, Producer producer, void *context);
+
+        // Of the last run()
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        struct Range {
+            GeometryGenerator *generator = nullptr;
+            int vertexBegin = 0, vertexEnd = 0;
+            int indexBegin = 0, indexEnd = 0;
+            std::vector<GeometryGenerator::GeometryIndices *> shapes;
+        };
+
+        void generate(int index, Producer producer, void *context);
+        void merge(GeometryGenerator *target, int n);
+
+        JobSystem *m_jobs;
+        bool m_enabled;
+
+        // One per thread taking part in a run
+        std::vector<GeometryGenerator *> m_threadGenerators;
+        std::atomic<int> m_nextThread;
+        unsigned long long m_run;
+
+        std::vector<Range> m_ranges;
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_PARALLEL_GEOMETRY_H */
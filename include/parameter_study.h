@@ -0,0 +1,112 @@
+#ifndef ATG_ENGINE_SIM_PARAMETER_STUDY_H
+#define ATG_ENGINE_SIM_PARAMETER_STUDY_H
+
+#include "dyno_sweep.h"
+
+#include <cinttypes>
+#include <functional>
+#include <string>
+#include <vector>
+
+class Engine;
+
+// Runs dyno measurements over a set of engine variants. Variants come from
+// a grid or a random sample of the parameter space and are made by patching
+// a freshly built base engine before its simulator is created, so the
+// script is never recompiled. Every (variant, rpm) pair is a separate task;
+// idle threads claim the next one, so cheap and expensive points balance
+// out.
+class ParameterStudy {
+    public:
+        enum class Parameter {
+            IntakeCamAdvance,       // crank degrees, added to the script's
+            ExhaustCamAdvance,      // crank degrees, added to the script's
+            IgnitionOffset,         // degrees, added to the timing curve
+            HeaderPrimaryLength,    // inches, every cylinder
+            IntakeRunnerLength,     // inches, every intake
+            Count
+        };
+
+        enum class Design {
+            Grid,
+            Random
+        };
+
+        struct Axis {
+            Parameter parameter = Parameter::IgnitionOffset;
+            double min = 0.0;
+            double max = 0.0;
+
+            // Grid designs only
+            int steps = 2;
+        };
+
+        struct Parameters {
+            std::vector<Axis> axes;
+            Design design = Design::Grid;
+            int samples = 16;
+            uint64_t seed = 0;
+
+            // Hold points and measurement of every variant; its thread
+            // count caps how many tasks run at once
+            DynoSweep::Parameters sweep;
+        };
+
+        // One value per axis
+        struct Variant {
+            std::vector<double> values;
+        };
+
+        struct Result {
+            std::vector<Variant> variants;
+
+            // Indexed like variants
+            std::vector<DynoSweep::Result> sweeps;
+
+            double wallTime = 0.0;
+        };
+
+        // The engine must be built and patched with apply() before the
+        // simulator is created from it
+        using CreateSimulator = std::function<Simulator *(int task, const Variant &variant)>;
+        using ReleaseSimulator = std::function<void(int task, Simulator *simulator)>;
+
+    public:
+        ParameterStudy();
+        ~ParameterStudy();
+
+        void initialize(const Parameters &params);
+        Result run(const CreateSimulator &create, const ReleaseSimulator &release);
+
+        const std::vector<Variant> &getVariants() const { return m_variants; }
+        const Parameters &getParameters() const { return m_parameters; }
+        int getHoldPointCount() const { return (int)m_holdPoints.size(); }
+
+        // Task i measures variant i / getHoldPointCount() at hold point
+        // i % getHoldPointCount()
+        int getTaskCount() const;
+
+        // One task on the calling thread, as run() does for each; create
+        // and release must already be serialized by the caller
+        DynoSweep::Point runTask(
+            int task,
+            const CreateSimulator &create,
+            const ReleaseSimulator &release) const;
+
+        void apply(Engine *engine, const Variant &variant) const;
+
+        // Columns: variant, one per axis, then the dyno sweep columns
+        bool writeCsv(const std::string &path, const Result &result) const;
+
+        static const char *GetParameterName(Parameter parameter);
+        static bool ParseParameter(const std::string &name, Parameter *parameter);
+
+    protected:
+        void generateVariants();
+
+        Parameters m_parameters;
+        std::vector<Variant> m_variants;
+        std::vector<double> m_holdPoints;
+};
+
+#endif /* ATG_ENGINE_SIM_PARAMETER_STUDY_H */
@@ -0,0 +1,94 @@
+#ifndef ATG_ENGINE_SIM_PART_INSTANCER_H
+#define ATG_ENGINE_SIM_PART_INSTANCER_H
+
+#include "delta.h"
+
+#include "geometry_generator.h"
+
+#include <vector>
+
+class EngineSimApplication;
+
+// Shares one generated mesh between every part that has the same shape, and
+// draws the parts queued against those meshes in as few calls as the draw
+// order allows. Each instance is a transform and color taken from its rigid
+// body; at flush() the instances of a group are written, transformed, into
+// one shape of the frame's geometry and drawn with an identity transform.
+// An instance only joins the latest group of its layer, so, within a layer,
+// instances are still drawn in the order they were queued.
+class PartInstancer {
+    public:
+        enum class Part {
+            WristPinHole,
+            ConnectingRodBody,
+            ConnectingRodPins
+        };
+
+        struct MeshKey {
+            Part part = Part::WristPinHole;
+            float parameters[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            bool operator==(const MeshKey &other) const;
+        };
+
+        struct Statistics {
+            int meshes = 0;
+            int instances = 0;
+            int draws = 0;
+        };
+
+    public:
+        PartInstancer();
+        ~PartInstancer();
+
+        void initialize(EngineSimApplication *app);
+        void destroy();
+
+        // Meshes are retained geometry; cleared whenever that is regenerated
+        void clearMeshes();
+        const GeometryGenerator::GeometryIndices *findMesh(const MeshKey &key) const;
+        void addMesh(const MeshKey &key, const GeometryGenerator::GeometryIndices &mesh);
+
+        void beginFrame();
+        void addInstance(
+            const GeometryGenerator::GeometryIndices &mesh,
+            const ysMatrix &transform,
+            const ysVector &color,
+            int layer);
+
+        // Draws and clears everything queued so far
+        void flush();
+
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        struct Mesh {
+            MeshKey key;
+            GeometryGenerator::GeometryIndices indices;
+        };
+
+        struct Instance {
+            GeometryGenerator::GeometryIndices mesh;
+            ysMatrix transform;
+        };
+
+        struct Group {
+            int layer = 0;
+            ysVector color;
+            std::vector<Instance> instances;
+        };
+
+        void draw(const Group &group);
+
+        EngineSimApplication *m_app;
+
+        std::vector<Mesh> m_meshes;
+
+        // Groups keep their instance storage between frames
+        std::vector<Group> m_groups;
+        int m_groupCount;
+
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_PART_INSTANCER_H */
@@ -0,0 +1,131 @@
+#ifndef ATG_ENGINE_SIM_PARTITIONED_CONVOLUTION_H
+#define ATG_ENGINE_SIM_PARTITIONED_CONVOLUTION_H
+
+#include "convolution_worker.h"
+#include "fft.h"
+
+#include <atomic>
+#include <complex>
+#include <memory>
+
+// Zero-latency convolution: the first headSize taps run in direct form, the
+// rest is split into uniformly partitioned overlap-save stages whose block
+// size grows from headSize to tailSize further into the impulse response.
+//
+// Given a worker, the tail stage is deferred: each of its blocks is handed
+// to the worker when its input is complete and picked up a block later, so
+// the tail starts at 2 * tailSize and the first stage covers the taps in
+// between. The layout is fixed at initialization; a deferred tail without a
+// worker runs on the calling thread with the same result.
+class PartitionedConvolution {
+    friend class ConvolutionBatch;
+
+    public:
+        PartitionedConvolution();
+        ~PartitionedConvolution();
+
+        // headSize and tailSize must be powers of two with
+        // tailSize >= headSize; tailSize == headSize gives a single uniform
+        // stage
+        void initialize(
+            const float *impulseResponse,
+            int samples,
+            int headSize,
+            int tailSize,
+            ConvolutionWorker *worker = nullptr);
+
+        // Shares the prepared spectra of another instance instead of
+        // transforming the impulse response again, along with its layout;
+        // history starts empty. The spectra are read-only once prepared, so
+        // every copy of a response holds them once.
+        void initialize(const PartitionedConvolution &prototype, ConvolutionWorker *worker = nullptr);
+
+        // Waits for any deferred block still on the worker
+        void destroy();
+
+        float f(float sample);
+
+        // Multiplies only this fraction of each stage's partitions, at least
+        // one, leaving off the end of the impulse response to save time.
+        // Input spectra are kept either way, so going back to the full
+        // length is seamless.
+        void setActiveFraction(float fraction) { m_activeFraction = fraction; }
+        float getActiveFraction() const { return m_activeFraction; }
+
+        bool isInitialized() const { return m_sampleCount > 0; }
+        int getSampleCount() const { return m_sampleCount; }
+        bool isTailDeferred() const { return m_deferTail; }
+
+        // Deferred blocks the worker hadn't finished by the time they were
+        // due, which the calling thread then waited for
+        unsigned long long getDeferredStallCount() const { return m_deferredStalls; }
+
+    protected:
+        struct Stage {
+            Fft fft;
+            int blockSize = 0;
+            int partitionCount = 0;
+            int position = 0;
+            int newest = 0;
+
+            // partitionCount spectra of 2 * blockSize bins each, shared
+            // with the stages copied from this one
+            std::shared_ptr<std::complex<float>> partitionStorage;
+            const std::complex<float> *partitions = nullptr;
+            std::complex<float> *history = nullptr;
+            std::complex<float> *work = nullptr;
+
+            // Previous and current input blocks back to back
+            float *input = nullptr;
+            float *output = nullptr;
+
+            // Deferred stages hand the worker a copy of the input and
+            // swap in its output a block later
+            bool deferred = false;
+            int activeCount = 0;
+            float *deferredInput = nullptr;
+            float *deferredOutput = nullptr;
+            std::atomic<bool> *busy = nullptr;
+        };
+
+        // Allocates new spectra unless partitions are given
+        void allocateStage(
+            Stage *stage,
+            int blockSize,
+            int partitionCount,
+            bool deferred,
+            std::shared_ptr<std::complex<float>> partitions = nullptr);
+        void initializeStage(
+            Stage *stage,
+            const float *impulseResponse,
+            int offset,
+            int length,
+            int blockSize,
+            bool deferred);
+        void destroyStage(Stage *stage);
+        void advanceStage(Stage *stage);
+        bool waitForStage(Stage *stage);
+        int getActiveCount(const Stage *stage) const;
+
+        static void processStage(Stage *stage, const float *input, float *output);
+        static void processDeferredStage(void *context);
+
+        // Direct-form head; history is stored twice so each dot product is
+        // contiguous
+        float *m_head;
+        float *m_headHistory;
+        int m_headSize;
+        int m_headOffset;
+
+        Stage m_stages[2];
+        int m_stageCount;
+
+        int m_sampleCount;
+        float m_activeFraction;
+
+        ConvolutionWorker *m_worker;
+        bool m_deferTail;
+        unsigned long long m_deferredStalls;
+};
+
+#endif /* ATG_ENGINE_SIM_PARTITIONED_CONVOLUTION_H */
@@ -10,6 +10,9 @@
 #include "labeled_gauge.h"
 #include "throttle_display.h"
 #include "simulator.h"
+#include "allocation_tracker.h"
+
+#include <chrono>
 
 class PerformanceCluster : public UiElement {
     public:
@@ -21,6 +24,7 @@ class PerformanceCluster : public UiElement {
 
         virtual void update(float dt);
         virtual void render();
+        virtual void layout();
 
         void setSimulator(Simulator *simulator) { m_simulator = simulator; }
         void addTimePerTimestepSample(double sample);
@@ -33,14 +37,22 @@ class PerformanceCluster : public UiElement {
         LabeledGauge *m_simulationFrequencyGauge;
         LabeledGauge *m_inputSamplesGauge;
         LabeledGauge *m_audioLagGauge;
+        LabeledGauge *m_fluidStepsGauge;
 
     protected:
+        void renderStepProfile(const Bounds &bounds);
+        void renderAllocationProfile(const Bounds &bounds);
+
         double m_timePerTimestep;
 
         double m_filteredSimulationFrequency;
         double m_audioLatency;
         double m_inputBufferUsage;
 
+        std::chrono::steady_clock::time_point m_allocationSampleTime;
+        uint64_t m_allocationTotals[AllocationTracker::TagCount];
+        double m_allocationRate[AllocationTracker::TagCount];
+
         Simulator *m_simulator;
 };
 
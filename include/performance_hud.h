@@ -0,0 +1,70 @@
+#ifndef ATG_ENGINE_SIM_PERFORMANCE_HUD_H
+#define ATG_ENGINE_SIM_PERFORMANCE_HUD_H
+
+#include "ui_element.h"
+
+#include "simulator.h"
+#include "step_profiler.h"
+#include "synthesizer.h"
+#include "latency_probe.h"
+
+#include <chrono>
+
+// Overlay of how close each thread is to its deadline: physics step cost
+// against the real time one step may take, audio block render time against
+// the block's duration and main thread frame work against the display
+// period, each as a budget meter that turns orange then red as it fills.
+// Below them are the share of the step taken by the solver, fluid and
+// synthesis, underruns, allocation rate and, with a latency probe, the
+// input to device latency of throttle presses.
+//
+// Percentiles come from the step profiler's histograms over the last
+// window; without ATG_ENGINE_SIM_PROFILE_STEPS the physics meter falls back
+// to the smoothed time per timestep and the stage rows are left out.
+class PerformanceHud : public UiElement {
+    public:
+        static constexpr double WindowSeconds = 0.5;
+
+    public:
+        PerformanceHud();
+        virtual ~PerformanceHud();
+
+        virtual void initialize(EngineSimApplication *app);
+        virtual void destroy();
+
+        virtual void update(float dt);
+        virtual void render();
+
+        void setSimulator(Simulator *simulator) { m_simulator = simulator; }
+        void setLatencyProbe(LatencyProbe *probe) { m_latencyProbe = probe; }
+        void addTimePerTimestepSample(double sample);
+
+    protected:
+        void resample(double elapsed);
+
+        void renderMeter(
+            const std::string &label,
+            double used,
+            double budget,
+            const Bounds &bounds);
+
+        std::chrono::steady_clock::time_point m_sampleTime;
+
+        StepProfiler::Statistics m_stageTotals[StepProfiler::StageCount];
+        StepProfiler::Statistics m_stageWindow[StepProfiler::StageCount];
+
+        Synthesizer::RenderStatistics m_renderTotals;
+        Synthesizer::RenderStatistics m_renderWindow;
+
+        uint64_t m_allocationTotal;
+        double m_allocationRate;
+        double m_underrunRate;
+        double m_overrunRate;
+
+        double m_timePerTimestep;
+
+        Simulator *m_simulator;
+        LatencyProbe *m_latencyProbe;
+};
+
+#endif /* ATG_ENGINE_SIM_PERFORMANCE_HUD_H */
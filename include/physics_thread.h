@@ -0,0 +1,65 @@
+#ifndef ATG_ENGINE_SIM_PHYSICS_THREAD_H
+#define ATG_ENGINE_SIM_PHYSICS_THREAD_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Simulator;
+
+// Runs simulator frames on a dedicated thread, scheduled by ThreadPolicy, at
+// a fixed wall-clock cadence, so stalls on the render thread (resizes,
+// layout, presenting) don't starve the synthesizer. Each frame is stepped with the
+// state lock held; other threads take it to read or change simulator state
+// and only block the next frame, which then covers the time it lost.
+class PhysicsThread {
+    public:
+        static constexpr double DefaultFrequency = 240.0;
+
+    public:
+        PhysicsThread();
+        ~PhysicsThread();
+
+        void initialize(Simulator *simulator, double frequency = DefaultFrequency);
+
+        // Returns once the frame in progress has finished
+        void destroy();
+
+        bool isRunning() const { return m_thread != nullptr; }
+        std::mutex &getStateLock() { return m_stateLock; }
+
+        // While paused the thread sleeps until resumed or asked for a step
+        // rather than waking every period
+        void setPaused(bool paused);
+        bool isPaused() const { return m_paused; }
+
+        // Runs a single frame while paused
+        void requestStep();
+
+        // Published after every frame
+        double getTimePerTimestep() const { return m_timePerTimestep.load(std::memory_order_relaxed); }
+        unsigned long long getFrameCount() const { return m_frames.load(std::memory_order_relaxed); }
+
+    protected:
+        void worker();
+
+        Simulator *m_simulator;
+        std::thread *m_thread;
+        std::chrono::nanoseconds m_period;
+
+        std::atomic<bool> m_run;
+        std::atomic<bool> m_paused;
+        std::atomic<int> m_stepRequests;
+
+        std::atomic<double> m_timePerTimestep;
+        std::atomic<unsigned long long> m_frames;
+
+        std::mutex m_stateLock;
+
+        std::mutex m_parkLock;
+        std::condition_variable m_parked;
+};
+
+#endif /* ATG_ENGINE_SIM_PHYSICS_THREAD_H */
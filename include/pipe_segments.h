@@ -0,0 +1,98 @@
+#ifndef ATG_ENGINE_SIM_PIPE_SEGMENTS_H
+#define ATG_ENGINE_SIM_PIPE_SEGMENTS_H
+
+#include "gas_system.h"
+
+// Straight pipe of equal finite volume cells between two gas systems, in
+// place of a single lumped volume when pressure waves along a runner or
+// primary should travel at the speed of sound rather than arrive at once.
+// The cells are stored as structure-of-arrays and advanced with a Rusanov
+// flux, so each pass over the faces and then the cells is a straight loop
+// the compiler vectorizes. The end faces exchange gas with the two systems
+// upwind, moving its enthalpy and momentum along, so moles and energy are
+// conserved across the connection. Long steps are split to keep the
+// Courant number below MaxCourantNumber.
+class PipeSegments {
+    friend class SimulationCheckpoint;
+
+    public:
+        static constexpr double MaxCourantNumber = 0.5;
+
+        struct Parameters {
+            int segments = 0;
+            double length = 0.0;
+            double crossSectionArea = 0.0;
+
+            double P = units::pressure(1.0, units::atm);
+            double T = units::celcius(25.0);
+            GasSystem::Mix mix;
+            int degreesOfFreedom = 5;
+        };
+
+    public:
+        PipeSegments();
+        ~PipeSegments();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        void reset(double P, double T, const GasSystem::Mix &mix = GasSystem::Mix());
+
+        // Positive x runs from system_0 to system_1; returns the moles that
+        // crossed into system_1 (negative if they came out of it)
+        double flow(double dt, GasSystem *system_0, GasSystem *system_1);
+
+        int getSegmentCount() const { return m_segments; }
+        double getLength() const { return m_segmentLength * m_segments; }
+        double getVolume() const { return m_segmentVolume * m_segments; }
+
+        double getPressure(int i) const;
+        double getTemperature(int i) const;
+        double getVelocity(int i) const;
+        double n(int i) const { return m_n[i]; }
+        double getTotalN() const;
+        double getTotalEnergy() const;
+
+    protected:
+        void computeFaceFluxes(GasSystem *system_0, GasSystem *system_1);
+        void exchange(GasSystem *system, int face, double sign, double dt);
+        void step(double dt, GasSystem *system_0, GasSystem *system_1);
+        double maxStableTimestep(const GasSystem *system_0, const GasSystem *system_1) const;
+
+        int m_segments;
+        double m_segmentLength;
+        double m_segmentVolume;
+        double m_crossSectionArea;
+        double m_heatCapacityRatio;
+        double m_molarHeatCapacity;
+
+        double *m_buffer;
+
+        // Cells: moles, total energy, axial momentum, fuel and oxygen moles
+        double *m_n;
+        double *m_E;
+        double *m_momentum;
+        double *m_fuel;
+        double *m_o2;
+
+        // Per-cell primitives for the flux pass, with a ghost at each end
+        // for the connected systems
+        double *m_density;
+        double *m_velocity;
+        double *m_pressure;
+        double *m_soundSpeed;
+        double *m_fuelFraction;
+        double *m_o2Fraction;
+
+        // Faces, per unit area and time: moles, energy, momentum, fuel and
+        // oxygen
+        double *m_faceN;
+        double *m_faceE;
+        double *m_faceMomentum;
+        double *m_faceFuel;
+        double *m_faceO2;
+
+        double m_transferred;
+};
+
+#endif /* ATG_ENGINE_SIM_PIPE_SEGMENTS_H */
@@ -24,7 +24,7 @@ class Piston : public Part {
         virtual ~Piston();
 
         void initialize(const Parameters &params);
-        inline void setCylinderConstraint(atg_scs::LineConstraint *constraint);
+        inline void setCylinderConstraint(atg_scs::Constraint *constraint);
         virtual void destroy();
 
         double relativeX() const;
@@ -43,7 +43,7 @@ class Piston : public Part {
     protected:
         ConnectingRod *m_rod;
         CylinderBank *m_bank;
-        atg_scs::LineConstraint *m_cylinderConstraint;
+        atg_scs::Constraint *m_cylinderConstraint;
         int m_cylinderIndex;
         double m_compressionHeight;
         double m_displacement;
@@ -52,7 +52,7 @@ class Piston : public Part {
         double m_blowby_k;
 };
 
-void Piston::setCylinderConstraint(atg_scs::LineConstraint *constraint) {
+void Piston::setCylinderConstraint(atg_scs::Constraint *constraint) {
     m_cylinderConstraint = constraint;
 }
 
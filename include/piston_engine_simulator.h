@@ -12,13 +12,27 @@
 #include "starter_motor.h"
 #include "derivative_filter.h"
 #include "vehicle_drag_constraint.h"
-#include "delay_filter.h"
+#include "delay_line_bank.h"
+#include "thread_pool.h"
+#include "flow_rate_batch.h"
+#include "simulation_arena.h"
+#include "crank_slider_model.h"
+#include "crank_bearing_constraint.h"
+#include "crankshaft_link_constraint.h"
+#include "cylinder_constraint_batch.h"
+#include "chamber_force_batch.h"
+#include "chamber_zones.h"
+#include "flow_graph.h"
+#include "simulation_checkpoint.h"
 
 #include "scs.h"
 
 #include <chrono>
 
 class PistonEngineSimulator : public Simulator {
+    friend class SimulationCheckpoint;
+    friend class WarmStart;
+
     public:
         PistonEngineSimulator();
         virtual ~PistonEngineSimulator() override;
@@ -29,45 +43,213 @@ class PistonEngineSimulator : public Simulator {
         void endFrame() override;
         virtual void destroy() override;
 
-        void setFluidSimulationSteps(int steps) { m_fluidSimulationSteps = steps; }
-        int getFluidSimulationSteps() const { return m_fluidSimulationSteps; }
+        // The full fidelity substep count; previews take one
+        void setFluidSimulationSteps(int steps);
+        virtual int getFluidSimulationSteps() const override { return m_fluidSimulationSteps; }
+
+        // Picks the substep count every step so that a pressure signal moves
+        // at most the Courant number of a runner length per substep and no
+        // more than the max flow fraction of a volume's gas crosses a valve
+        void setAdaptiveFluidSimulationSteps(bool enabled, int minSteps = 2, int maxSteps = 16);
+        bool isAdaptiveFluidSimulationSteps() const { return m_adaptiveFluidSimulationSteps; }
+        void setFluidCourantNumber(double courantNumber) { m_fluidCourantNumber = courantNumber; }
+        double getFluidCourantNumber() const { return m_fluidCourantNumber; }
+        void setMaxFluidFlowFraction(double fraction) { m_maxFluidFlowFraction = fraction; }
+        double getMaxFluidFlowFraction() const { return m_maxFluidFlowFraction; }
+        int estimateFluidSimulationSteps() const;
         int getFluidSimulationFrequency() const { return m_fluidSimulationSteps * getSimulationFrequency(); }
 
+        void setFluidThreadCount(int threads);
+        int getFluidThreadCount() const { return m_fluidThreadPool.getThreadCount(); }
+
+        void setBatchedFlowRates(bool batched) { m_batchedFlowRates = batched; }
+        bool getBatchedFlowRates() const { return m_batchedFlowRates; }
+
+        // Solves the runner joints sharing a plenum or collector together,
+        // see FlowGraph; kept across loads
+        void setImplicitRunnerFlow(bool implicit) { m_flowGraph.setImplicit(implicit); }
+        bool isImplicitRunnerFlow() const { return m_flowGraph.isImplicit(); }
+
+        // See CombustionChamber::setRunnerCoarsening(); kept across loads
+        void setRunnerCoarsening(int substeps);
+        int getRunnerCoarsening() const { return m_runnerCoarsening; }
+
+        // Only initialized for engines built with multi_zone set
+        const ChamberZones &getChamberZones() const { return m_chamberZones; }
+
+        // Runner joints compiled from the engine at load
+        const FlowGraph &getFlowGraph() const { return m_flowGraph; }
+
+        // Drives the pistons and rods analytically from the crank angle
+        // instead of as constrained bodies; set before loadSimulation(). Only
+        // takes effect when every rod sits directly on a crankshaft journal.
+        void setReducedKinematics(bool reduced) { m_reducedKinematics = reduced; }
+        bool isReducedKinematics() const { return m_reducedKinematics; }
+
+        // Runs the per-step loops over cylinders and exhaust systems as
+        // instantiated for the engine's counts when it's a common layout;
+        // off, or for any other layout, they loop over the engine's own
+        // counts. On by default; for A/B comparison.
+        void setSpecializedStepKernels(bool specialized);
+        bool isSpecializedStepKernels() const { return m_specializedStepKernels; }
+
+        // 0 while the dynamic loops run
+        int getStepKernelCylinderCount() const { return m_stepKernels->cylinders; }
+
+        // Leaves the dyno, the starter and the drivetrain out of the rigid
+        // body solve while they can't apply any torque, and registers them
+        // again the step they can. On by default; for A/B comparison.
+        void setConstraintPruning(bool pruning);
+        bool isConstraintPruning() const { return m_constraintPruning; }
+        int getPrunedConstraintCount() const;
+
         virtual double getAverageOutputSignal() const override;
 
         DerivativeFilter m_derivativeFilter;
 
     protected:
         virtual void simulateStep_() override;
+        virtual void applyFidelity() override;
+        virtual bool captureSpeculativeCheckpoint() override;
+        virtual bool restoreSpeculativeCheckpoint() override;
+        virtual void flushSynthesizerFrames() override { flushSynthesizerInput(); }
+        virtual bool updateSolvedSet() override;
+        virtual atg_scs::RigidBody *getVehicleMass() override { return &m_vehicleMass; }
 
     protected:
         void placeAndInitialize();
+        void placeCylinders();
         void placeCylinder(int i);
+        void initializeExhaustDelays();
+        void initializeExhaustAudioRoutes();
+        void simulateFluidSubstep(double dt);
+        void simulateValveFlowBatched(double dt);
+        void updateFluidSimulationSteps();
+        int shedFluidSimulationSteps(int steps) const;
+        void updateChamberZones(double dt);
         
     protected:
-        virtual void writeToSynthesizer() override;
+        // One instantiation of the step loops; a count of 0 is read from the
+        // engine, so those loops serve every layout
+        struct StepKernels {
+            int cylinders;
+            int exhausts;
+            void (PistonEngineSimulator::*updateChambers)(IgnitionModule *im, double dt);
+            void (PistonEngineSimulator::*resetChamberFlows)();
+            void (PistonEngineSimulator::*writeExhaustFrame)(double *frame);
+        };
+
+        static const StepKernels &SelectStepKernels(int cylinders, int exhausts);
+        void selectStepKernels();
+
+        template <int Cylinders>
+        void updateChambers(IgnitionModule *im, double dt);
+
+        template <int Cylinders>
+        void resetChamberFlows();
+
+        template <int Cylinders, int Exhausts>
+        void writeExhaustFrame(double *frame);
+
+        template <int Cylinders, int Exhausts>
+        static constexpr StepKernels MakeStepKernels();
+
+        const StepKernels *m_stepKernels;
+        bool m_specializedStepKernels;
 
     protected:
-        DelayFilter *m_delayFilters;
+        // Steps staged per synthesizer writeInput() call; the remainder is
+        // flushed at the end of every frame
+        static constexpr int SynthesizerStagingFrames = 32;
 
-        atg_scs::FixedPositionConstraint *m_crankConstraints;
-        atg_scs::ClutchConstraint *m_crankshaftLinks;
+        virtual void writeToSynthesizer() override;
+        virtual void writeSynthesizerFrame(const double *frame) override;
+        void flushSynthesizerInput();
+
+    protected:
+        // Where each cylinder's exhaust pulse goes, fixed at load: the
+        // runner it's read from, the exhaust system it's mixed into and its
+        // share of the mix (sound attenuation over the cylinder count and
+        // the squared pipe length). The exhaust's audio volume is applied
+        // per exhaust after mixing, since patches can change it.
+        struct ExhaustAudioRoute {
+            const GasSystem *runner;
+            int exhaust;
+            double gain;
+        };
+
+        ExhaustAudioRoute *m_exhaustAudioRoutes;
+
+        // One exhaust delay line per cylinder, with per step scratch rows of
+        // the runner pressures and the pulses going in and coming out
+        DelayLineBank m_exhaustDelays;
+        double *m_runnerPressures;
+        double *m_runnerDynamicPressures;
+        double *m_exhaustPulses;
+        double *m_delayedExhaustPulses;
+
+        CrankBearingConstraint *m_crankConstraints;
+        CrankshaftLinkConstraint *m_crankshaftLinks;
         atg_scs::RotationFrictionConstraint *m_crankshaftFrictionConstraints;
-        atg_scs::LineConstraint *m_cylinderWallConstraints;
-        atg_scs::LinkConstraint *m_linkConstraints;
+        CylinderConstraintBatch m_cylinderConstraints;
+        ChamberForceBatch m_chamberForces;
         atg_scs::RigidBody m_vehicleMass;
         VehicleDragConstraint m_vehicleDrag;
 
+        CrankSliderModel m_crankSlider;
+        bool m_reducedKinematics;
+
+        // Subsystems in the rigid body system, see setConstraintPruning()
+        enum : unsigned int {
+            DynoSubsystem = 0x1,
+            StarterSubsystem = 0x2,
+            VehicleSubsystem = 0x4,
+            AllSubsystems = 0x7
+        };
+
+        // rad/s of the vehicle's rotating mass below which it counts as parked
+        static constexpr double VehicleRestSpeed = 1E-6;
+
+        unsigned int getSolvedSubsystems() const;
+        void registerSystem();
+
+        bool m_constraintPruning;
+        unsigned int m_solvedSubsystems;
+
         std::chrono::steady_clock::time_point m_simulationStart;
         std::chrono::steady_clock::time_point m_simulationEnd;
 
+        SimulationArena m_arena;
+
         Engine *m_engine;
         Transmission *m_transmission;
         Vehicle *m_vehicle;
 
+        // SynthesizerStagingFrames rows of one sample per exhaust system
         double *m_exhaustFlowStagingBuffer;
+        int m_stagedSynthesizerFrames;
 
         int m_fluidSimulationSteps;
+        int m_fullFluidSimulationSteps;
+        int m_minFluidSimulationSteps;
+        int m_maxFluidSimulationSteps;
+        double m_fluidCourantNumber;
+        double m_maxFluidFlowFraction;
+        bool m_adaptiveFluidSimulationSteps;
+
+        ThreadPool m_fluidThreadPool;
+
+        FlowRateBatch m_valveFlowBatch;
+        GasSystem::FlowState *m_valveFlowStates;
+        int *m_valveBatchSlots;
+        bool m_batchedFlowRates;
+        int m_runnerCoarsening;
+
+        ChamberZones m_chamberZones;
+        FlowGraph m_flowGraph;
+
+        // Start of the current frame, for speculative stepping
+        SimulationCheckpoint m_speculativeCheckpoint;
 };
 
 #endif /* ATG_ENGINE_SIM_PISTON_ENGINE_SIMULATOR_H */
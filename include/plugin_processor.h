@@ -0,0 +1,117 @@
+#ifndef ATG_ENGINE_SIM_PLUGIN_PROCESSOR_H
+#define ATG_ENGINE_SIM_PLUGIN_PROCESSOR_H
+
+class Simulator;
+
+// Drives a simulator from an audio plugin host's block callback. Physics
+// runs in fixed frames of audio time, cut at parameter events, and the
+// synthesizer renders each frame on the calling thread. Neither depends on
+// where the host's blocks begin and end, so the output is the same at every
+// buffer size; the price is a fixed latency of one frame plus a safety
+// margin, by which events and audio are both delayed.
+//
+// The simulator must have been created without its audio thread, at the
+// host's sample rate. process() takes no contended locks and makes no
+// allocations; debug traces stay compiled out unless a trace session is
+// running, which a plugin never starts.
+class PluginProcessor {
+    public:
+        enum class Parameter {
+            Throttle,
+            Clutch,
+            Gear,
+            Ignition,
+            Starter,
+            DynoEnabled,
+            DynoSpeed,
+            Count
+        };
+
+        static constexpr int ParameterCount = static_cast<int>(Parameter::Count);
+
+        struct Event {
+            // Samples from the start of the block; events must be sorted
+            int offset = 0;
+            Parameter parameter = Parameter::Throttle;
+            double value = 0.0;
+        };
+
+        struct Parameters {
+            // Samples of audio simulated and rendered at a time
+            int frameSize = 64;
+
+            // Covers the synthesizer producing a few samples fewer than the
+            // physics frame is long
+            int safetyFrames = 64;
+
+            // Events waiting for the physics to reach them; more than this
+            // in flight and the excess is dropped, see
+            // getDroppedEventCount()
+            int eventCapacity = 1024;
+        };
+
+    public:
+        PluginProcessor();
+        ~PluginProcessor();
+
+        // Not real-time safe
+        void initialize(Simulator *simulator, const Parameters &params);
+        void destroy();
+
+        // Gear is an index (-1 neutral), dyno speed in rpm, switches are
+        // on above 0.5
+        void setParameter(Parameter parameter, double value);
+        double getParameter(Parameter parameter) const;
+
+        static const char *GetParameterName(Parameter parameter);
+        static void GetParameterRange(Parameter parameter, double *minimum, double *maximum, double *initial);
+
+        // Fills frames mono samples
+        void process(const Event *events, int eventCount, float *output, int frames);
+
+        int getLatency() const { return m_latency; }
+        unsigned long long getUnderrunCount() const { return m_underruns; }
+
+        // Events that arrived with the queue full. Applying them early
+        // instead would move them by however much of the latency was left,
+        // which depends on the host's block size
+        unsigned long long getDroppedEventCount() const { return m_droppedEvents; }
+
+    protected:
+        struct PendingEvent {
+            long long position;
+            Parameter parameter;
+            double value;
+        };
+
+        void simulateFrame(long long end);
+        void applyParameters();
+        void advance(int frames);
+
+        Simulator *m_simulator;
+        double m_sampleRate;
+        int m_frameSize;
+        int m_latency;
+
+        // In samples since initialize(); the physics leads the output by
+        // between the latency and the latency less one frame
+        long long m_physicsPosition;
+        long long m_outputPosition;
+
+        // Simulated time owed to the audio that has been asked for, always
+        // less than one step after advance()
+        double m_pendingTime;
+
+        // FIFO ordered by position
+        PendingEvent *m_events;
+        int m_eventCapacity;
+        int m_eventStart;
+        int m_eventCount;
+
+        unsigned long long m_underruns;
+        unsigned long long m_droppedEvents;
+
+        double m_values[ParameterCount];
+};
+
+#endif /* ATG_ENGINE_SIM_PLUGIN_PROCESSOR_H */
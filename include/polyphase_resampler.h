@@ -0,0 +1,65 @@
+#ifndef ATG_ENGINE_SIM_POLYPHASE_RESAMPLER_H
+#define ATG_ENGINE_SIM_POLYPHASE_RESAMPLER_H
+
+// Windowed-sinc resampler for several channels sharing one clock. The kernel
+// is tabulated at a fixed number of phases and linearly interpolated between
+// them, so any ratio works without recomputing coefficients; tables are kept
+// per normalized cutoff so switching between a few simulation speeds is free.
+class PolyphaseResampler {
+    public:
+        PolyphaseResampler();
+        ~PolyphaseResampler();
+
+        // taps must be even
+        void initialize(int channels, int taps = 32, int phases = 64, int tableCount = 4);
+        void destroy();
+
+        // Cutoff in Hz; it is further limited to just under the lower of the
+        // two Nyquist frequencies
+        void setRates(double inputRate, double outputRate, double cutoff);
+
+        // Takes one sample per channel
+        void push(const double *frame);
+
+        // Writes the outputs due since the last push, at most maxSamples per
+        // channel; call until it returns fewer than maxSamples
+        int generate(float *const *output, int maxSamples);
+
+        // Advances past the outputs due since the last push without
+        // computing them
+        int discard();
+
+        int getChannelCount() const { return m_channelCount; }
+        int getTapCount() const { return m_taps; }
+
+    protected:
+        struct Table {
+            double cutoff = -1.0;
+            float *coefficients = nullptr;
+        };
+
+        void computeTable(Table *table, double cutoff);
+
+        Table *m_tables;
+        Table *m_table;
+        int m_tableCount;
+        int m_nextTable;
+
+        // Per channel, newest sample first and stored twice so the window
+        // starting at m_historyOffset is always contiguous
+        float *m_history;
+        int m_historyOffset;
+
+        float *m_kernel;
+
+        int m_channelCount;
+        int m_taps;
+        int m_phases;
+
+        // Position of the next output past the window center, in input
+        // samples, and its increment per output sample
+        double m_phase;
+        double m_step;
+};
+
+#endif /* ATG_ENGINE_SIM_POLYPHASE_RESAMPLER_H */
@@ -0,0 +1,61 @@
+#ifndef ATG_ENGINE_SIM_RANDOM_STREAM_H
+#define ATG_ENGINE_SIM_RANDOM_STREAM_H
+
+#include <cinttypes>
+
+// Counter-based generator: the i-th value of a stream is a hash of the
+// stream key and i, so a run is reproducible from (seed, stream) and fill()
+// has no loop-carried dependency beyond the counter.
+class RandomStream {
+    public:
+        RandomStream() { seed(0, 0); }
+
+        void seed(uint64_t seed, uint32_t stream) {
+            m_key = hash(static_cast<uint32_t>(seed) ^ hash(static_cast<uint32_t>(seed >> 32) + stream));
+            m_counter = 0;
+        }
+
+        inline uint32_t next() { return value(m_counter++); }
+
+        // [0, 1)
+        inline double uniform() {
+            const uint64_t hi = next() >> 5, lo = next() >> 6;
+            return (hi * 67108864.0 + lo) * (1.0 / 9007199254740992.0);
+        }
+
+        // [min, max)
+        inline float uniform(float min, float max) {
+            const float scale = (max - min) * (1.0f / 16777216.0f);
+            return min + scale * (next() >> 8);
+        }
+
+        void fill(float *target, int n, float min, float max) {
+            const uint32_t counter = m_counter;
+            const float scale = (max - min) * (1.0f / 16777216.0f);
+            for (int i = 0; i < n; ++i) {
+                target[i] = min + scale * (value(counter + static_cast<uint32_t>(i)) >> 8);
+            }
+
+            m_counter += static_cast<uint32_t>(n);
+        }
+
+    protected:
+        static inline uint32_t hash(uint32_t x) {
+            x ^= x >> 16;
+            x *= 0x7FEB352Du;
+            x ^= x >> 15;
+            x *= 0x846CA68Bu;
+            x ^= x >> 16;
+
+            return x;
+        }
+
+        inline uint32_t value(uint32_t counter) const {
+            return hash(m_key + counter * 0x9E3779B9u);
+        }
+
+        uint32_t m_key;
+        uint32_t m_counter;
+};
+
+#endif /* ATG_ENGINE_SIM_RANDOM_STREAM_H */
@@ -0,0 +1,99 @@
+#ifndef ATG_ENGINE_SIM_REALTIME_STEPPER_H
+#define ATG_ENGINE_SIM_REALTIME_STEPPER_H
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <functional>
+
+class Simulator;
+
+// Advances a simulator one step per period of wall-clock time (the timestep
+// over the simulation speed, 100 us at 10 kHz) for hardware-in-the-loop
+// benches. Frames are used without their usual burst of steps: each step
+// waits for its own deadline, sleeping until shortly before it and spinning
+// the rest, and the I/O hooks run at a fixed step cadence around it. A step
+// that starts late runs immediately so simulated time stays locked to the
+// wall clock; one further behind than resyncPeriods re-anchors the clock
+// instead, counting every step it skips.
+//
+// run() blocks the calling thread, which it schedules as the physics role
+// of ThreadPolicy; the hooks run on it as well and share its deadlines.
+class RealtimeStepper {
+    public:
+        static constexpr int BucketCount = 32;
+
+        struct Parameters {
+            // Steps per simulator frame; frames publish snapshots and hand
+            // the synthesizer its input. 0 picks about a millisecond's worth
+            int stepsPerFrame = 0;
+
+            // Hooks run every ioInterval steps
+            int ioInterval = 1;
+
+            // How long before each deadline the sleep ends and the spin
+            // begins; covers the OS's wake-up latency
+            double spinTime = 200E-6;
+
+            double resyncPeriods = 100.0;
+
+            // Before the step, with the index of the step about to run
+            std::function<void(Simulator *, long long)> input;
+
+            // After the step, with the index of the step just run
+            std::function<void(Simulator *, long long)> output;
+
+            // After every frame; returning true ends the run
+            std::function<bool(Simulator *)> frame;
+        };
+
+        struct Statistics {
+            long long steps = 0;
+            long long frames = 0;
+
+            // Steps finishing after the next step's deadline
+            long long missedDeadlines = 0;
+            long long skippedSteps = 0;
+            long long resyncs = 0;
+
+            // Wake-up lateness: how long after its deadline each step began
+            double totalLatenessMicroseconds = 0.0;
+            double maxLatenessMicroseconds = 0.0;
+
+            // buckets[i] counts steps between 2^(i - 1) and 2^i nanoseconds
+            // late
+            uint64_t buckets[BucketCount] = {};
+
+            double wallTime = 0.0;
+
+            double averageLatenessMicroseconds() const {
+                return (steps > 0) ? totalLatenessMicroseconds / steps : 0.0;
+            }
+
+            double percentileLatenessMicroseconds(double p) const;
+        };
+
+    public:
+        RealtimeStepper();
+        ~RealtimeStepper();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        // Returns after duration seconds of wall time, or when stopped
+        Statistics run(Simulator *simulator, double duration);
+
+        // Ends run() after the step in progress; callable from any thread
+        void stop() { m_run = false; }
+
+    protected:
+        typedef std::chrono::steady_clock Clock;
+
+        void waitUntil(Clock::time_point deadline) const;
+        static void record(Statistics *statistics, Clock::duration lateness);
+
+        Parameters m_parameters;
+        std::atomic<bool> m_run;
+};
+
+#endif /* ATG_ENGINE_SIM_REALTIME_STEPPER_H */
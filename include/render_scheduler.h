@@ -0,0 +1,91 @@
+#ifndef ATG_ENGINE_SIM_RENDER_SCHEDULER_H
+#define ATG_ENGINE_SIM_RENDER_SCHEDULER_H
+
+#include <chrono>
+
+// Decides how often the run loop renders. Full rate while the window has
+// focus and the synthesizer is fed; capped when unfocused; no rendering at
+// all while the window can't be seen. When the synthesizer's input falls
+// below its latency target the UI is updated at a reduced rate and, if the
+// simulator runs on its own thread, the loop idles so that thread gets the
+// CPU. While the loop steps the simulator itself it never idles below
+// SteppingFramerate, the lowest rate the loop's frame step covers. While
+// paused the loop only polls input, at pausedFramerate, and renders when
+// asked to or once every pausedRedrawInterval seconds.
+class RenderScheduler {
+    public:
+        enum class Mode {
+            Full,
+            Unfocused,
+            PhysicsBehind,
+            Hidden,
+            Paused
+        };
+
+        struct Parameters {
+            double unfocusedFramerate = 30.0;
+            double physicsBehindFramerate = 30.0;
+            double hiddenFramerate = 10.0;
+            double pausedFramerate = 15.0;
+            double pausedRedrawInterval = 1.0;
+
+            // Fractions of the latency target; entering and leaving the
+            // behind state at different levels keeps it from flickering
+            double behindLatency = 0.5;
+            double recoveredLatency = 0.8;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr double SteppingFramerate = 30.0;
+
+    public:
+        RenderScheduler();
+        ~RenderScheduler();
+
+        void initialize(const Parameters &params);
+
+        void setEnabled(bool enabled) { m_enabled = enabled; }
+        bool isEnabled() const { return m_enabled; }
+
+        // Set while the run loop, not a physics thread, steps the simulator
+        void setSteppingSimulation(bool stepping) { m_steppingSimulation = stepping; }
+
+        // Pausing applies whether or not the scheduler is enabled
+        void setPaused(bool paused);
+        bool isPaused() const { return m_paused; }
+
+        // Renders the next frame while paused
+        void requestRedraw() { m_redrawRequested = true; }
+
+        Mode update(bool focused, bool visible, double latency, double targetLatency);
+        Mode getMode() const { return m_mode; }
+
+        bool shouldRender() const;
+
+        // Whether the UI should be updated this frame; rate limited while
+        // physics is behind, and on request only while paused
+        bool takeUiUpdate(Clock::time_point now);
+
+        // Zero when uncapped
+        Clock::duration getFrameInterval() const;
+
+        // Time to idle before the next loop iteration given when the current
+        // one started
+        Clock::duration getIdleTime(Clock::time_point frameStart, Clock::time_point now) const;
+
+        static const char *GetModeName(Mode mode);
+
+    protected:
+        Parameters m_parameters;
+        Mode m_mode;
+        bool m_enabled;
+        bool m_behind;
+        bool m_steppingSimulation;
+        bool m_paused;
+        bool m_redrawRequested;
+        bool m_redraw;
+        Clock::time_point m_lastUiUpdate;
+};
+
+#endif /* ATG_ENGINE_SIM_RENDER_SCHEDULER_H */
@@ -22,6 +22,7 @@ class RightGaugeCluster : public UiElement {
 
         virtual void update(float dt);
         virtual void render();
+        virtual void layout();
 
         void setEngine(Engine *engine);
         void setUnits();
@@ -38,8 +39,8 @@ class RightGaugeCluster : public UiElement {
     protected:
         Engine *m_engine;
 
-        void renderTachSpeedCluster(const Bounds &bounds);
-        void renderFuelAirCluster(const Bounds &bounds);
+        void renderTachSpeedCluster();
+        void renderFuelAirCluster();
 
         LabeledGauge *m_tachometer;
         LabeledGauge *m_speedometer;
@@ -6,7 +6,9 @@
 #include <algorithm>
 #include <cstring>
 
-template <typename T_Data>
+// With T_PowerOfTwo the capacity is rounded up to a power of two at
+// initialize() and indices wrap with a mask instead of a division
+template <typename T_Data, bool T_PowerOfTwo = false>
 class RingBuffer {
 public:
     RingBuffer() {
@@ -27,6 +29,12 @@ public:
             return;
         }
 
+        if constexpr (T_PowerOfTwo) {
+            size_t rounded = 1;
+            while (rounded < capacity) rounded <<= 1;
+            capacity = rounded;
+        }
+
         m_buffer = new T_Data[capacity];
         m_capacity = capacity;
         m_writeIndex = 0;
@@ -54,12 +62,31 @@ public:
         }
     }
 
+    // Writes n elements with at most two copies; only the last capacity
+    // elements are kept if n is larger
+    inline void write(const T_Data *data, size_t n) {
+        if (data == nullptr || m_buffer == nullptr || m_capacity == 0 || n == 0) return;
+
+        if (n > m_capacity) {
+            const size_t skipped = n - m_capacity;
+            data += skipped;
+            m_writeIndex = wrap(m_writeIndex + skipped);
+            n = m_capacity;
+        }
+
+        const size_t firstSpan = std::min(n, m_capacity - m_writeIndex);
+        memcpy(m_buffer + m_writeIndex, data, firstSpan * sizeof(T_Data));
+        if (n > firstSpan) {
+            memcpy(m_buffer, data + firstSpan, (n - firstSpan) * sizeof(T_Data));
+        }
+
+        m_writeIndex = wrapOnce(m_writeIndex + n);
+    }
+
     inline void overwrite(T_Data data, size_t index) {
         if (m_buffer == nullptr || m_capacity == 0) return;
 
-        const size_t wrappedIndex = index % m_capacity;
-        const size_t absoluteIndex = m_start + wrappedIndex;
-        m_buffer[absoluteIndex >= m_capacity ? absoluteIndex - m_capacity : absoluteIndex] = data;
+        m_buffer[wrapOnce(m_start + wrap(index))] = data;
     }
 
     inline size_t index(size_t base, int offset) {
@@ -67,12 +94,12 @@ public:
 
         if (offset == 0) return base;
         else if (offset < 0) {
-            const size_t offset_u = static_cast<size_t>(-offset) % m_capacity;
+            const size_t offset_u = wrap(static_cast<size_t>(-offset));
             if (offset_u <= base) return base - offset_u;
             else return (base + m_capacity) - offset_u;
         }
         else {
-            const size_t offset_u = static_cast<size_t>(offset) % m_capacity;
+            const size_t offset_u = wrap(static_cast<size_t>(offset));
             const size_t rawOffset = base + offset_u;
             if (rawOffset >= m_capacity) return rawOffset - m_capacity;
             else return rawOffset;
@@ -84,10 +111,7 @@ public:
             return T_Data{};
         }
 
-        const size_t wrappedIndex = index % m_capacity;
-        return (m_start + wrappedIndex) >= m_capacity
-            ? m_buffer[m_start + wrappedIndex - m_capacity]
-            : m_buffer[m_start + wrappedIndex];
+        return m_buffer[wrapOnce(m_start + wrap(index))];
     }
 
     inline void read(size_t n, T_Data *target) {
@@ -131,7 +155,7 @@ public:
                 (n - (m_capacity - m_start)) * sizeof(T_Data));
         }
 
-        m_start = (m_start + n) % m_capacity;
+        m_start = wrapOnce(m_start + n);
     }
 
     inline void setWriteIndex(size_t writeIndex) {
@@ -139,14 +163,14 @@ public:
             m_writeIndex = 0;
         }
         else {
-            m_writeIndex = writeIndex % m_capacity;
+            m_writeIndex = wrap(writeIndex);
         }
     }
 
     inline void removeBeginning(size_t n) {
         if (m_capacity == 0) return;
 
-        m_start = (m_start + (n % m_capacity)) % m_capacity;
+        m_start = wrapOnce(m_start + wrap(n));
     }
 
     inline void setStartIndex(size_t startIndex) {
@@ -154,7 +178,7 @@ public:
             m_start = 0;
         }
         else {
-            m_start = startIndex % m_capacity;
+            m_start = wrap(startIndex);
         }
     }
 
@@ -174,7 +198,30 @@ public:
         return m_start;
     }
 
+    inline size_t capacity() const {
+        return m_capacity;
+    }
+
 private:
+    inline size_t wrap(size_t index) const {
+        if constexpr (T_PowerOfTwo) {
+            return index & (m_capacity - 1);
+        }
+        else {
+            return index % m_capacity;
+        }
+    }
+
+    // For indices below twice the capacity
+    inline size_t wrapOnce(size_t index) const {
+        if constexpr (T_PowerOfTwo) {
+            return index & (m_capacity - 1);
+        }
+        else {
+            return (index >= m_capacity) ? index - m_capacity : index;
+        }
+    }
+
     T_Data *m_buffer;
     size_t m_capacity;
     size_t m_writeIndex;
@@ -0,0 +1,70 @@
+#ifndef ATG_ENGINE_SIM_SIMULATION_ARENA_H
+#define ATG_ENGINE_SIM_SIMULATION_ARENA_H
+
+#include <assert.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Single contiguous block for the per-simulation arrays. The owner sums
+// footprint() for everything it needs, initializes once and then allocates
+// in the order the step loop touches the data.
+class SimulationArena {
+    public:
+        SimulationArena();
+        ~SimulationArena();
+
+        void initialize(size_t capacity);
+
+        // Runs destructors in reverse allocation order and frees the block
+        void destroy();
+
+        template <typename T>
+        static constexpr size_t footprint(int n) {
+            return (n > 0) ? n * sizeof(T) + alignof(T) - 1 : 0;
+        }
+
+        template <typename T>
+        T *allocate(int n) {
+            static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned type");
+            if (n <= 0) return nullptr;
+
+            const size_t offset = (m_used + alignof(T) - 1) & ~(alignof(T) - 1);
+            assert(offset + n * sizeof(T) <= m_capacity);
+
+            T *data = reinterpret_cast<T *>(m_buffer + offset);
+            for (int i = 0; i < n; ++i) {
+                new (data + i) T();
+            }
+
+            m_used = offset + n * sizeof(T);
+
+            if (!std::is_trivially_destructible<T>::value) {
+                m_allocations.push_back({ data, n, [](void *p, int count) {
+                    T *objects = static_cast<T *>(p);
+                    for (int i = count - 1; i >= 0; --i) objects[i].~T();
+                }});
+            }
+
+            return data;
+        }
+
+        size_t getCapacity() const { return m_capacity; }
+        size_t getUsed() const { return m_used; }
+
+    protected:
+        struct Allocation {
+            void *data;
+            int count;
+            void (*destroy)(void *data, int count);
+        };
+
+        unsigned char *m_buffer;
+        size_t m_capacity;
+        size_t m_used;
+
+        std::vector<Allocation> m_allocations;
+};
+
+#endif /* ATG_ENGINE_SIM_SIMULATION_ARENA_H */
@@ -0,0 +1,54 @@
+#ifndef ATG_ENGINE_SIM_SIMULATION_CHECKPOINT_H
+#define ATG_ENGINE_SIM_SIMULATION_CHECKPOINT_H
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+class PistonEngineSimulator;
+
+// Dynamic state of a loaded simulation: rigid bodies, gas systems, flame
+// events, ignition, VTEC and throttle state, noise streams and the exhaust
+// delay lines. Captured between frames and restored in place into a simulator
+// running the same engine, so many runs can fork from one warmed-up state.
+// The synthesizer is owned by the audio thread and isn't included; restored
+// runs start their audio from whatever the synthesizer currently holds.
+// Configuration, such as the fluid substep count, is left as the simulator
+// has it.
+//
+// The layout is that of the running build; checkpoints are not meant to be
+// kept across builds.
+class SimulationCheckpoint {
+    public:
+        static constexpr uint32_t Magic = 0x4B435345; // "ESCK"
+        static constexpr uint32_t Version = 8;
+
+    public:
+        SimulationCheckpoint();
+        ~SimulationCheckpoint();
+
+        void capture(PistonEngineSimulator *simulator);
+
+        // Fails without touching the simulator if its engine doesn't have
+        // the layout the checkpoint was captured from
+        bool restore(PistonEngineSimulator *simulator) const;
+
+        bool save(const std::string &path) const;
+        bool load(const std::string &path);
+
+        bool isEmpty() const { return m_data.empty(); }
+        size_t getSize() const { return m_data.size(); }
+
+    private:
+        // Engine shape and format version the state below depends on
+        static std::vector<int32_t> describeLayout(PistonEngineSimulator *simulator);
+
+        // Walks every dynamic field in a fixed order, so capture and restore
+        // can't drift apart
+        template <typename Archive>
+        static void transfer(Archive *archive, PistonEngineSimulator *simulator);
+
+        std::vector<char> m_data;
+};
+
+#endif /* ATG_ENGINE_SIM_SIMULATION_CHECKPOINT_H */
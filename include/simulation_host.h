@@ -0,0 +1,127 @@
+#ifndef ATG_ENGINE_SIM_SIMULATION_HOST_H
+#define ATG_ENGINE_SIM_SIMULATION_HOST_H
+
+#include "engine_definition.h"
+#include "engine_instance.h"
+#include "job_system.h"
+
+#include <string>
+#include <vector>
+
+class Engine;
+class Simulator;
+class Transmission;
+class Vehicle;
+
+// Hosts many simulators in one process and advances them on demand on the
+// shared JobSystem at physics priority, for a service where each player
+// owns an instance.
+// Engines are built from snapshots registered as EngineDefinitions. Every
+// instance of a definition points at the same functions, baked curves and
+// lobe tables rather than a copy of its own, and impulse responses come
+// from ImpulseResponseCache as usual.
+//
+// Callers request simulated time per instance and then run rounds. A round
+// advances each instance with time pending by at most one slice, so a long
+// request can't starve the others. The round is split into batches of
+// instances of one definition, which keeps a worker on the same shared
+// tables. Idle threads claim the next batch. Instances and their
+// simulators may only be touched between rounds.
+class SimulationHost {
+    public:
+        struct Parameters {
+            // Including the thread calling runRound(), up to the JobSystem's
+            // concurrency; 0 is all of it
+            int threads = 0;
+
+            // Simulated seconds an instance runs before the next one's turn
+            double sliceLength = 1 / 60.0;
+
+            int batchSize = 8;
+
+            // Each slice's audio is rendered on the worker that ran it,
+            // without an audio thread per instance; read it between rounds
+            bool audio = false;
+
+            unsigned long long seed = 0;
+        };
+
+        struct Statistics {
+            long long rounds = 0;
+            long long slices = 0;
+            long long batches = 0;
+            long long steps = 0;
+            double simulatedTime = 0.0;
+
+            // Inside runRound()
+            double wallTime = 0.0;
+        };
+
+    public:
+        SimulationHost();
+        ~SimulationHost();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        // Maps the snapshot once up front; -1 if it doesn't load
+        int addDefinition(const std::string &snapshotPath);
+
+        // -1 if the definition is unknown or the engine fails to build
+        int createInstance(int definition);
+        void destroyInstance(int instance);
+
+        Simulator *getSimulator(int instance) const;
+        int getDefinition(int instance) const;
+        const EngineDefinition *getEngineDefinition(int definition) const;
+        int getInstanceCount() const { return m_liveInstances; }
+
+        // Adds simulated seconds for the next rounds to run; less than a
+        // timestep stays pending until more is requested
+        void request(int instance, double seconds);
+        double getPending(int instance) const;
+
+        // Returns the instances that were advanced
+        int runRound();
+
+        // Rounds until no instance has a whole timestep pending
+        void runPending();
+
+        int getThreadCount() const { return m_threads; }
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        struct Instance {
+            int definition = -1;
+            EngineInstance engine;
+            Simulator *simulator = nullptr;
+            double pending = 0.0;
+        };
+
+        struct Batch {
+            int begin = 0;
+            int end = 0;
+            long long steps = 0;
+            double simulatedTime = 0.0;
+        };
+
+        Instance *getInstance(int instance) const;
+        void release(Instance *instance);
+        long long advance(Instance *instance);
+
+        Parameters m_parameters;
+        int m_threads;
+
+        std::vector<EngineDefinition *> m_definitions;
+        std::vector<Instance *> m_instances;
+        std::vector<int> m_freeInstances;
+        int m_liveInstances;
+
+        // Scratch for runRound()
+        std::vector<Instance *> m_ready;
+        std::vector<Batch> m_batches;
+
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_SIMULATION_HOST_H */
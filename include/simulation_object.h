@@ -3,6 +3,7 @@
 
 #include "scs.h"
 #include "delta.h"
+#include "ui_math.h"
 
 class Piston;
 class CylinderBank;
@@ -20,7 +21,16 @@ class SimulationObject {
         virtual ~SimulationObject();
 
         virtual void initialize(EngineSimApplication *app);
+        // Shapes that only depend on the engine and the view scale, kept in
+        // the retained part of the geometry buffers until either changes
+        virtual void generateStaticGeometry();
+
+        // Shapes that change every frame
         virtual void generateGeometry();
+
+        // Engine-space box around everything the object draws, for culling;
+        // false when it should always be drawn
+        virtual bool getWorldBounds(Bounds *bounds) const;
         virtual void render(const ViewParameters *settings);
         virtual void process(float dt);
         virtual void destroy();
@@ -36,8 +46,21 @@ class SimulationObject {
             float ly = 0.0f,
             float theta = 0.0f,
             float z = 0.0f);
+        ysMatrix bodyTransform(
+            atg_scs::RigidBody *rigidBody,
+            float scale = 1.0f,
+            float lx = 0.0f,
+            float ly = 0.0f,
+            float theta = 0.0f,
+            float z = 0.0f) const;
         ysVector tintByLayer(const ysVector &col, int layers) const;
 
+        static Bounds boundsAround(double x, double y, double radius) {
+            return Bounds(
+                (float)(x - radius), (float)(x + radius),
+                (float)(y - radius), (float)(y + radius));
+        }
+
         EngineSimApplication *m_app;
 };
 
@@ -0,0 +1,70 @@
+#ifndef ATG_ENGINE_SIM_SIMULATION_SNAPSHOT_H
+#define ATG_ENGINE_SIM_SIMULATION_SNAPSHOT_H
+
+// Plain copy of the scalar state the gauges show, published by the
+// simulator once per frame. Readers never touch the live engine so the
+// UI and the headless runner can sample it from another thread.
+struct SimulationSnapshot {
+    static constexpr int MaxCylinders = 32;
+    static constexpr int AudioHarmonics = 4;
+
+    // Frames published and seconds simulated since initialize()
+    long long frame = 0;
+    double time = 0.0;
+
+    // Engine
+    double rpm = 0.0;
+    double redline = 0.0;
+    double displacement = 0.0;
+    double manifoldPressure = 0.0;
+    double intakeFlowRate = 0.0;
+    double intakeAfr = 0.0;
+    double exhaustO2 = 0.0;
+    double totalFuelConsumed = 0.0;
+    double totalFuelMassConsumed = 0.0;
+    bool ignitionEnabled = false;
+
+    // Vehicle
+    double speed = 0.0;
+    double travelledDistance = 0.0;
+    int gear = -1;
+    double clutchPressure = 0.0;
+
+    // Load
+    double filteredDynoTorque = 0.0;
+    double dynoPower = 0.0;
+    double dynoSpeed = 0.0;
+    bool dynoEnabled = false;
+    bool dynoHold = false;
+    bool starterEnabled = false;
+
+    // Cylinder 0 over the last CycleStatistics::HistoryCycles cycles
+    double imep = 0.0;
+    double imepCoefficientOfVariation = 0.0;
+    double peakCylinderPressure = 0.0;
+
+    // Simulation
+    int simulationFrequency = 0;
+    double simulationSpeed = 0.0;
+    int fluidSimulationSteps = 0;
+
+    // Physics paused while the audio cache loops steady cycles instead
+    bool audioCacheReplaying = false;
+
+    // OverloadPolicy::Level shed to keep the audio fed
+    int overloadLevel = 0;
+
+    // Sound metrics; only filled while synthesizer analysis is enabled and
+    // lagging the physics by the audio latency
+    bool audioAnalyzed = false;
+    float audioLoudness = 0.0f;
+    float audioSpectralCentroid = 0.0f;
+    float audioHarmonics[AudioHarmonics] = {};
+    float audioRoughness = 0.0f;
+
+    // Only the first min(cylinderCount, MaxCylinders) entries are filled
+    int cylinderCount = 0;
+    double cylinderTemperature[MaxCylinders] = {};
+};
+
+#endif /* ATG_ENGINE_SIM_SIMULATION_SNAPSHOT_H */
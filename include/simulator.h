@@ -10,11 +10,31 @@
 #include "derivative_filter.h"
 #include "vehicle_drag_constraint.h"
 #include "delay_filter.h"
+#include "latency_profile.h"
+#include "telemetry_tap.h"
+#include "telemetry_export.h"
+#include "flight_recorder.h"
+#include "engine_controller.h"
+#include "simulation_snapshot.h"
+#include "triple_buffer.h"
+#include "control_queue.h"
+#include "input_session.h"
+#include "synthesizer_capture.h"
+#include "cycle_statistics.h"
+#include "cycle_audio_cache.h"
+#include "overload_policy.h"
+#include "speculative_stepping.h"
+#include "multirate_scheduler.h"
+#include "smoothed_parameter.h"
 #include "engine.h"
 
+#include <atomic>
 #include <chrono>
+#include <functional>
 
 class Simulator {
+    friend class SimulationCheckpoint;
+
 public:
     enum class SystemType {
         NsvOptimized,
@@ -23,9 +43,27 @@ public:
 
     struct Parameters {
         SystemType systemType = SystemType::NsvOptimized;
+
+        // Without audio the synthesizer is never set up: no exhaust pulses
+        // are assembled, no audio thread runs and no output is produced.
+        // Physics, telemetry and snapshots are unaffected.
+        bool audio = true;
     };
 
-    static constexpr int DynoTorqueSamples = 512;
+    // Preview trades accuracy for speed while parameters are being
+    // scrubbed: the simulation frequency drops to 1/PreviewFrequencyDivisor
+    // of the target (but not below MinPreviewSimulationFrequency) and piston
+    // engines take a single fluid substep
+    enum class Fidelity {
+        Full,
+        Preview
+    };
+
+    static constexpr int PreviewFrequencyDivisor = 4;
+    static constexpr int MinPreviewSimulationFrequency = 2000;
+
+    // Part of each impulse response convolved once overload sheds it
+    static constexpr float ShedConvolutionFraction = 0.25f;
 
 public:
     Simulator();
@@ -36,9 +74,15 @@ public:
     void releaseSimulation();
 
     virtual void startFrame(double dt);
+
+    // A frame of exactly this many steps, for callers pacing the steps
+    // themselves; no latency following and no rounding of dt
+    void startFrameSteps(int steps);
+
     bool simulateStep();
     virtual double getTotalExhaustFlow() const;
     int readAudioOutput(int samples, int16_t *target);
+    int readAudioOutput(int samples, float *target);
     virtual void endFrame();
     virtual void destroy();
 
@@ -49,21 +93,130 @@ public:
 
     Synthesizer &synthesizer() { return m_synthesizer; }
 
+    // Per-step records for the UI; off unless something drains them
+    TelemetryTap &telemetry() { return m_telemetry; }
+    // Read every step, possibly on the physics thread
+    void setTelemetryEnabled(bool enabled) { m_telemetryEnabled.store(enabled, std::memory_order_relaxed); }
+    bool isTelemetryEnabled() const { return m_telemetryEnabled.load(std::memory_order_relaxed); }
+
+    // Shared-memory records at the export's decimation, written from the
+    // stepping thread; not owned, null to stop
+    void setTelemetryExport(TelemetryExport *telemetryExport);
+
+    // Fed every live step from the stepping thread, which also writes its
+    // dumps; not owned, null to stop. Sized for the loaded engine here and
+    // on every load.
+    void setFlightRecorder(FlightRecorder *recorder);
+    FlightRecorder *getFlightRecorder() const { return m_flightRecorder; }
+
+    // Stepped at the end of every physics step, after the aggregates are
+    // updated; not owned, null to stop
+    void setEngineController(EngineController *controller);
+    EngineController *getEngineController() const { return m_engineController; }
+
+    // Gauge state as of the last endFrame(); the reader calls
+    // updateSnapshot() once per frame and reads the result until the next
+    // call. One reader thread only.
+    bool updateSnapshot() { return m_snapshots.update(); }
+    const SimulationSnapshot &getSnapshot() const { return m_snapshots.read(); }
+
+    // Control changes from the input thread. A frame covers the wall time
+    // since the previous one started and applies each event at the step at
+    // the same fraction of the frame, so changes keep their spacing (at the
+    // cost of at most one frame of latency) instead of all landing on the
+    // first step. One producer thread only.
+    ControlQueue &controls() { return m_controls; }
+    void applyControl(const ControlQueue::Event &event);
+
+    // The value a control currently has, in the units applyControl() takes
+    double getControl(ControlQueue::Control control);
+
+    // A second queue drained alongside controls(), for a producer thread of
+    // its own such as a ControlSurface; not owned, null to stop. Its events
+    // with a smoothing time glide there a little every step, and a change
+    // from controls() cancels the glide. Same callers as
+    // setInputSession().
+    void setControlSource(ControlQueue *source);
+    ControlQueue *getControlSource() const { return m_controlSource; }
+
+    // Records every control applied from here on, or replays a recorded
+    // session in place of the live ones; not owned, null to stop. Attaching
+    // reseeds the simulator, from the session when replaying, and while a
+    // session is attached the frequency and fidelity hold and overload
+    // handling is off, since either would change the physics between runs.
+    // Same callers as setSimulationFrequency(), between frames.
+    void setInputSession(InputSession *session);
+    InputSession *getInputSession() const { return m_inputSession; }
+
+    // Steps since the session was attached
+    unsigned long long getSessionStep() const { return m_sessionStep; }
+
+    // Copies every synthesizer input frame into a recording capture,
+    // flushed at the end of each frame; not owned, null to stop. Same
+    // callers as setInputSession().
+    void setSynthesizerCapture(SynthesizerCapture *capture) { m_synthesizerCapture = capture; }
+    SynthesizerCapture *getSynthesizerCapture() const { return m_synthesizerCapture; }
+
     Engine *getEngine() const { return m_engine; }
     Transmission *getTransmission() const { return m_transmission; }
     Vehicle *getVehicle() const { return m_vehicle; }
     atg_scs::RigidBodySystem *getSystem() { return m_system; }
 
-    void setSimulationFrequency(int frequency) { m_simulationFrequency = frequency; }
+    // Both can be called at any point of a run by whoever may touch
+    // simulator state (the stepping thread, or with the physics thread's
+    // state lock held). Between frames they take effect immediately,
+    // otherwise at the start of the next frame, so every frame is stepped at
+    // one rate. Everything derived from the timestep (exhaust delay lines,
+    // fluid substeps, the synthesizer's resampling ratio) follows. The
+    // frequency set is the full fidelity target; getSimulationFrequency() is
+    // the one being stepped at.
+    void setSimulationFrequency(int frequency);
+    int getTargetSimulationFrequency() const { return m_targetSimulationFrequency; }
     int getSimulationFrequency() const { return m_simulationFrequency; }
 
+    void setFidelity(Fidelity fidelity);
+    Fidelity getFidelity() const { return m_fidelity; }
+
+    // Solves the rigid bodies once every that many steps, see
+    // MultirateScheduler; the gas keeps the simulation frequency times its
+    // fluid substeps. 1, the default, solves every step. Kept across loads,
+    // same callers as setSimulationFrequency().
+    void setRigidBodyInterval(int steps);
+    int getRigidBodyInterval() const { return m_multirate.getInterval(); }
+    double getRigidBodyFrequency() const { return m_simulationFrequency / (double)getRigidBodyInterval(); }
+
     double getTimestep() const { return 1.0 / m_simulationFrequency; }
 
+    // Resizes the synthesizer buffers; call before the audio rendering
+    // thread is started and before impulse responses are loaded
+    void setLatencyProfile(const LatencyProfile &profile);
+    const LatencyProfile &getLatencyProfile() const { return m_latencyProfile; }
+
+    // Enables the synthesizer's multichannel float output with one default
+    // mix (exhaust system i into channel i modulo the count); 0 disables it.
+    // Same restrictions as setLatencyProfile().
+    void setSynthesizerOutputChannelCount(int channels);
+    int getSynthesizerOutputChannelCount() const { return m_synthesizerOutputChannels; }
+
+    // Rate the synthesizer renders at, 44100 by default; same restrictions
+    // as setLatencyProfile()
+    void setAudioSampleRate(double sampleRate);
+    double getAudioSampleRate() const { return m_audioSampleRate; }
+
     void setTargetSynthesizerLatency(double latency) { m_targetSynthesizerLatency = latency; }
     double getTargetSynthesizerLatency() const { return m_targetSynthesizerLatency; }
     double getSynthesizerInputLatency() const { return m_synthesizer.getLatency(); }
     double getSynthesizerInputLatencyTarget() const;
 
+    void setOfflineMode(bool offline);
+    bool isOfflineMode() const { return m_offline; }
+    bool isAudioEnabled() const { return m_audioEnabled; }
+
+    // Seeds every combustion chamber and synthesizer channel stream so runs
+    // with the same seed and inputs are reproducible
+    void setRandomSeed(uint64_t seed);
+    uint64_t getRandomSeed() const { return m_randomSeed; }
+
     void setSimulationSpeed(double simSpeed) { m_simulationSpeed = simSpeed; }
     double getSimulationSpeed() const { return m_simulationSpeed; }
     int getCurrentIteration() const { return m_currentIteration; }
@@ -71,9 +224,55 @@ public:
 
     int simulationSteps() const { return m_steps; }
 
+    // Steps of the current frame the audio cache stood in for
+    int getFrameReplayedSteps() const { return m_frameReplayedSteps; }
+    unsigned long long getStepAllocationCount() const { return m_stepAllocations; }
+
+    // Torque, and cylinder 0's pressure, volume, flows and valve lifts, by
+    // crank angle over the last cycle; written every step by the stepping
+    // thread
+    const CycleStatistics &cycleStatistics() const { return m_cycleStatistics; }
+
+    // Loops captured cycles of synthesizer input in place of physics steps
+    // while the engine holds steady, until an input changes; see
+    // CycleAudioCache. Only with audio; same callers as
+    // setSimulationFrequency()
+    void setAudioCacheEnabled(bool enabled, const CycleAudioCache::Parameters &params = {});
+    bool isAudioCacheEnabled() const { return m_audioCacheEnabled; }
+    bool isAudioCacheReplaying() const { return m_audioCache.isReplaying(); }
+    const CycleAudioCache &audioCache() const { return m_audioCache; }
+
+    // Called on the stepping thread with every live frame of synthesizer
+    // input and whether its step began an engine cycle, for tools that
+    // record it; empty to stop
+    void setSynthesizerTap(const std::function<void(const double *, bool)> &tap) { m_synthesizerTap = tap; }
+
+    // While live audio falls behind, sheds fidelity in OverloadPolicy's
+    // order and has the synthesizer ready to conceal underruns with the last
+    // engine cycle; on by default, same callers as setSimulationFrequency()
+    void setOverloadHandlingEnabled(bool enabled);
+    bool isOverloadHandlingEnabled() const { return m_overloadHandling; }
+    OverloadPolicy::Level getOverloadLevel() const { return m_overloadPolicy.getLevel(); }
+    bool isOverloadShedding(OverloadPolicy::Level level) const { return m_overloadPolicy.isShedding(level); }
+
+    // Steps at the set frequency, which can then be coarser than is stable
+    // everywhere, and validates every step, see SpeculativeStepping. Each
+    // frame starts from an in-memory checkpoint; a step failing validation
+    // restores it and redoes the frame at the refinement times the rate,
+    // which holds for a few frames before speculating again. Controls
+    // applied before the failure hold from the start of the redo, and input
+    // the synthesizer already has stands, so the redo is silent up to the
+    // failed step. Off while an input session is attached; same callers as
+    // setSimulationFrequency().
+    void setSpeculativeStepping(bool enabled, const SpeculativeStepping::Parameters &params = {});
+    bool isSpeculativeStepping() const { return m_speculativeStepping; }
+    bool isSpeculativeRefined() const { return m_speculativeRefinement > 1; }
+    const SpeculativeStepping &speculativeStepping() const { return m_speculative; }
+
     virtual double getFilteredDynoTorque() const;
     virtual double getDynoPower() const;
     virtual double getAverageOutputSignal() const;
+    virtual int getFluidSimulationSteps() const;
 
     double filteredEngineSpeed() const { return m_filteredEngineSpeed; }
 
@@ -85,18 +284,90 @@ protected:
     virtual void simulateStep_();
     virtual void writeToSynthesizer() = 0;
 
+    // Writes one frame of synthesizer input as-is, for the audio cache
+    virtual void writeSynthesizerFrame(const double *frame) = 0;
+
+    // Called by writeToSynthesizer() with each frame before it's written;
+    // the audio cache captures it or fades it in from its replay
+    void processSynthesizerFrame(double *frame);
+
+    // In-memory state for speculative stepping to roll back to, captured
+    // between frames; simulators without one never roll back
+    virtual bool captureSpeculativeCheckpoint() { return false; }
+    virtual bool restoreSpeculativeCheckpoint() { return false; }
+
+    // Hands synthesizer input staged by writeToSynthesizer() over now
+    virtual void flushSynthesizerFrames() { /* void */ }
+
+    // Called before every solve, after the step's controls are applied;
+    // true when it changed what the rigid body system solves
+    virtual bool updateSolvedSet() { return false; }
+
+    // The rotating mass standing in for the vehicle, moved with the engine's
+    // bodies between multirate solves; null without one
+    virtual atg_scs::RigidBody *getVehicleMass() { return nullptr; }
+
+    // Sets the stepped frequency from the target and the fidelity; derived
+    // simulators extend it for state that depends on either
+    virtual void applyFidelity();
+
     atg_scs::RigidBodySystem *m_system;
 
 private:
     void updateFilteredEngineSpeed(double dt);
+    bool beginFrame();
+    void resetIntakeFlows();
+    void clearIntakeFlows();
+    void drainControls();
+    void drainControls(ControlQueue *queue, bool source);
+    void glideControls();
+    void setControl(ControlQueue::Control control, double value);
+    void writeCycleStatistics();
+    void initializeAudioCache();
+    bool updateAudioCacheInputs();
+    void writeTelemetry();
+    void writeTelemetryExport();
+    void sizeFlightRecorder();
+    void writeFlightRecorder();
+    void publishSnapshot();
+    void reinitializeSynthesizer();
+    void updateFidelity();
+    void updateOverload();
+    void beginSpeculativeFrame();
+    bool rollBackSpeculativeFrame(SpeculativeStepping::Failure failure);
 
 private:
     atg_scs::RigidBody m_vehicleMass;
     VehicleDragConstraint m_vehicleDrag;
 
+    MultirateScheduler m_multirate;
+
     Synthesizer m_synthesizer;
 
+    TelemetryTap m_telemetry;
+    std::atomic<bool> m_telemetryEnabled;
+    TelemetryExport *m_telemetryExport;
+    EventCounters::Totals m_exportedEvents;
+    FlightRecorder *m_flightRecorder;
+    EngineController *m_engineController;
+
+    TripleBuffer<SimulationSnapshot> m_snapshots;
+    long long m_snapshotFrame;
+    double m_snapshotTime;
+
     std::chrono::steady_clock::time_point m_simulationStart;
+
+    ControlQueue m_controls;
+    ControlQueue *m_controlSource;
+    SmoothedParameter m_controlGlides[ControlQueue::ControlCount];
+    double m_controlGlideTimes[ControlQueue::ControlCount];
+    InputSession *m_inputSession;
+    SynthesizerCapture *m_synthesizerCapture;
+    unsigned long long m_sessionStep;
+    bool m_sessionOverloadHandling;
+    ControlQueue::Clock::time_point m_controlWindowStart;
+    ControlQueue::Clock::time_point m_controlWindowEnd;
+    bool m_controlWindowValid;
     std::chrono::steady_clock::time_point m_simulationEnd;
     int m_currentIteration;
 
@@ -107,16 +378,62 @@ private:
     double m_physicsProcessingTime;
 
     int m_simulationFrequency;
-
+    int m_targetSimulationFrequency;
+    Fidelity m_fidelity;
+    bool m_frameInProgress;
+    bool m_fidelityUpdatePending;
+
+    LatencyProfile m_latencyProfile;
+    int m_synthesizerOutputChannels;
+    double m_audioSampleRate;
     double m_targetSynthesizerLatency;
     double m_simulationSpeed;
+    bool m_offline;
+    bool m_audioEnabled;
+    uint64_t m_randomSeed;
+
+    CycleStatistics m_cycleStatistics;
+
+    // What the cache's capture was made under; any change ends a replay
+    struct AudioCacheInputs {
+        double speedControl = 0.0;
+        double clutchPressure = 0.0;
+        double dynoSpeed = 0.0;
+        double simulationSpeed = 0.0;
+        int gear = -1;
+        int simulationFrequency = 0;
+        bool ignition = false;
+        bool starter = false;
+        bool dynoEnabled = false;
+        bool dynoHold = false;
+    };
+
+    CycleAudioCache m_audioCache;
+    CycleAudioCache::Parameters m_audioCacheParameters;
+    AudioCacheInputs m_audioCacheInputs;
+    bool m_audioCacheEnabled;
 
-    double *m_dynoTorqueSamples;
-    int m_lastDynoTorqueSample;
+    std::function<void(const double *, bool)> m_synthesizerTap;
+
+    OverloadPolicy m_overloadPolicy;
+    bool m_overloadHandling;
+
+    SpeculativeStepping m_speculative;
+    bool m_speculativeStepping;
+    bool m_speculativeCheckpointed;
+    int m_speculativeRefinement;
+    int m_speculativeHoldFrames;
+
+    // Redone steps the synthesizer, controller and taps already saw
+    int m_speculativeSilentSteps;
+    unsigned long long m_concealedSamples;
 
     double m_filteredEngineSpeed;
 
     int m_steps;
+    int m_frameReplayedSteps;
+
+    unsigned long long m_stepAllocations;
 };
 
 #endif /* ATG_ENGINE_SIM_SIMULATOR_H */
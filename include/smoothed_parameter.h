@@ -0,0 +1,62 @@
+#ifndef ATG_ENGINE_SIM_SMOOTHED_PARAMETER_H
+#define ATG_ENGINE_SIM_SMOOTHED_PARAMETER_H
+
+#include <cmath>
+
+// A control value as the audio thread sees it. Gains ramp() linearly across
+// a block from where the last block left them to the target, so a jump
+// becomes a slope rather than a click. Values that feed filter designs
+// glide() a fraction of the way each block instead, and report whether
+// they moved, so coefficients are recomputed only while the value is
+// actually changing and never once it has settled.
+class SmoothedParameter {
+    public:
+        SmoothedParameter() {
+            m_value = 0.0f;
+            m_target = 0.0f;
+        }
+
+        void reset(float value) {
+            m_value = value;
+            m_target = value;
+        }
+
+        void setTarget(float target) { m_target = target; }
+        float getTarget() const { return m_target; }
+        float getValue() const { return m_value; }
+        bool isSettled() const { return m_value == m_target; }
+
+        // Returns the value before the block; sample i of n gets
+        // start + (i + 1) * step and the block ends on the target
+        float ramp(int n, float *step) {
+            const float start = m_value;
+            *step = (n > 0) ? (m_target - start) / n : 0.0f;
+            m_value = m_target;
+
+            return start;
+        }
+
+        // Moves fraction of the remaining distance, landing on the target
+        // once within tolerance of it; false if the value didn't change
+        bool glide(float fraction, float tolerance) {
+            if (m_value == m_target) return false;
+
+            const float next = m_value + (m_target - m_value) * fraction;
+            m_value = (std::abs(m_target - next) <= tolerance) ? m_target : next;
+
+            return true;
+        }
+
+        // Fraction of the distance covered by a block of n samples for a
+        // glide with time constant seconds
+        static float GlideFraction(int n, float sampleRate, float seconds) {
+            if (seconds <= 0 || sampleRate <= 0) return 1.0f;
+            return 1.0f - std::exp(-n / (seconds * sampleRate));
+        }
+
+    protected:
+        float m_value;
+        float m_target;
+};
+
+#endif /* ATG_ENGINE_SIM_SMOOTHED_PARAMETER_H */
@@ -0,0 +1,94 @@
+#ifndef ATG_ENGINE_SIM_SOUND_BANK_H
+#define ATG_ENGINE_SIM_SOUND_BANK_H
+
+#include "synthesizer.h"
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+// Synthesizer input baked from an engine over a grid of speeds and
+// throttles. Every cell holds a few consecutive engine cycles, each resampled
+// to the same number of frames so cycle phase lines up across cells, followed
+// by one more cycle that continues the last; a player crossfades into a
+// cycle from the continuation of the one before it. Samples are stored as
+// floats, cell-major with the rpm index outermost, then frame-major.
+class SoundBank {
+    public:
+        static constexpr uint32_t Magic = 0x42535345; // "ESSB"
+        static constexpr uint32_t Version = 1;
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            int32_t channels;
+            int32_t rpmCount;
+            int32_t throttleCount;
+            int32_t framesPerCycle;
+            int32_t cyclesPerCell;
+            int32_t reserved;
+            double inputSampleRate;
+        };
+
+        struct ImpulseResponse {
+            std::string filename;
+            double volume = 1.0;
+        };
+
+    public:
+        SoundBank();
+        ~SoundBank();
+
+        void initialize(
+            const std::vector<double> &rpms,
+            const std::vector<double> &throttles,
+            int channels,
+            int framesPerCycle,
+            int cyclesPerCell);
+        void destroy();
+
+        bool save(const std::string &path) const;
+        bool load(const std::string &path);
+
+        // (cyclesPerCell + 1) * framesPerCycle frames of getChannelCount()
+        // samples each
+        float *getCell(int rpmIndex, int throttleIndex);
+        const float *getCell(int rpmIndex, int throttleIndex) const;
+        int getCellFrames() const { return (m_cyclesPerCell + 1) * m_framesPerCycle; }
+
+        // Linearly interpolated at a phase in cycles from the start of the
+        // cell, up to cyclesPerCell + 1
+        void sample(int rpmIndex, int throttleIndex, double phase, double *frame) const;
+
+        bool isEmpty() const { return m_samples.empty(); }
+        int getChannelCount() const { return m_channels; }
+        int getFramesPerCycle() const { return m_framesPerCycle; }
+        int getCyclesPerCell() const { return m_cyclesPerCell; }
+        const std::vector<double> &getRpms() const { return m_rpms; }
+        const std::vector<double> &getThrottles() const { return m_throttles; }
+
+        // The engine's simulation frequency, which the frames were written at
+        double getInputSampleRate() const { return m_inputSampleRate; }
+        void setInputSampleRate(double sampleRate) { m_inputSampleRate = sampleRate; }
+
+        // The engine's synthesizer settings and impulse responses, so a
+        // player renders the bank the way the engine would
+        const Synthesizer::AudioParameters &getAudioParameters() const { return m_audioParameters; }
+        void setAudioParameters(const Synthesizer::AudioParameters &params) { m_audioParameters = params; }
+        const ImpulseResponse &getImpulseResponse(int channel) const { return m_impulseResponses[channel]; }
+        void setImpulseResponse(int channel, const std::string &filename, double volume);
+
+    protected:
+        std::vector<double> m_rpms;
+        std::vector<double> m_throttles;
+        int m_channels;
+        int m_framesPerCycle;
+        int m_cyclesPerCell;
+        double m_inputSampleRate;
+
+        Synthesizer::AudioParameters m_audioParameters;
+        std::vector<ImpulseResponse> m_impulseResponses;
+        std::vector<float> m_samples;
+};
+
+#endif /* ATG_ENGINE_SIM_SOUND_BANK_H */
@@ -0,0 +1,81 @@
+#ifndef ATG_ENGINE_SIM_SOUND_BANK_BAKER_H
+#define ATG_ENGINE_SIM_SOUND_BANK_BAKER_H
+
+#include "headless_runner.h"
+#include "sound_bank.h"
+
+#include <functional>
+#include <vector>
+
+// Fills a SoundBank by holding the engine on the dyno at every speed and
+// throttle of the grid, letting it settle and recording the synthesizer
+// input of the cycles that follow. Cells are independent and, like
+// DynoSweep's points, run on simulators of their own on the JobSystem.
+class SoundBankBaker {
+    public:
+        struct Parameters {
+            std::vector<double> rpms;
+            std::vector<double> throttles;
+
+            int framesPerCycle = 1024;
+            int cyclesPerCell = 4;
+
+            double settleTime = 2.0;
+
+            // A cell that hasn't produced its cycles this long after
+            // settling is left silent
+            double captureTime = 2.0;
+
+            double frameLength = 1 / 60.0;
+            int threads = 1;
+        };
+
+        struct Result {
+            int cells = 0;
+            int captured = 0;
+            double simulatedTime = 0.0;
+            double wallTime = 0.0;
+        };
+
+        // Records frames from the first cycle start it sees until it has
+        // the requested cycles and one more to continue them
+        class CycleCapture {
+            public:
+                void begin(int channels, int cycles, int maxFrames);
+                void addFrame(const double *frame, bool cycleStart);
+                bool isComplete() const { return m_complete; }
+
+                // Resamples each recorded cycle, the continuation included,
+                // to framesPerCycle frames
+                void normalize(int framesPerCycle, float *output) const;
+
+            protected:
+                int m_channels = 0;
+                int m_cycles = 0;
+                int m_maxFrames = 0;
+                bool m_complete = false;
+
+                std::vector<double> m_frames;
+                std::vector<int> m_cycleStarts;
+        };
+
+        typedef std::function<Simulator *(int cell)> CreateSimulator;
+        typedef std::function<void(int cell, Simulator *simulator)> ReleaseSimulator;
+
+    public:
+        SoundBankBaker();
+        ~SoundBankBaker();
+
+        void initialize(const Parameters &params);
+
+        // The bank takes its channels, rate, audio parameters and impulse
+        // responses from the first simulator created
+        Result run(const CreateSimulator &create, const ReleaseSimulator &release, SoundBank *bank);
+
+    protected:
+        bool bakeCell(Simulator *simulator, int rpmIndex, int throttleIndex, SoundBank *bank, double *simulatedTime) const;
+
+        Parameters m_parameters;
+};
+
+#endif /* ATG_ENGINE_SIM_SOUND_BANK_BAKER_H */
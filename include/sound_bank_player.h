@@ -0,0 +1,89 @@
+#ifndef ATG_ENGINE_SIM_SOUND_BANK_PLAYER_H
+#define ATG_ENGINE_SIM_SOUND_BANK_PLAYER_H
+
+#include "sound_bank.h"
+#include "random_stream.h"
+#include "synthesizer.h"
+
+#include <cinttypes>
+#include <vector>
+
+// Plays a SoundBank without simulating the engine. Every engine cycle is a
+// grain: a cycle picked at random from the cells around the current speed
+// and throttle, blended bilinearly between them and stretched to the
+// current speed. Each grain fades in from the continuation of the one
+// before it. The frames go through a synthesizer of the player's own, so
+// the bank gets the same convolution, noise and leveling as the engine.
+class SoundBankPlayer {
+    public:
+        struct Parameters {
+            double audioSampleRate = 44100.0;
+
+            // 0 plays at the rate the bank was baked at
+            double inputSampleRate = 0.0;
+
+            // Part of each cycle spent fading in from the last one
+            double crossfade = 0.15;
+        };
+
+    public:
+        SoundBankPlayer();
+        ~SoundBankPlayer();
+
+        // The bank isn't owned and has to outlive the player
+        void initialize(const SoundBank *bank, const Parameters &params);
+        void destroy();
+        void seed(uint64_t seed);
+
+        void setOperatingPoint(double rpm, double throttle);
+        double getRpm() const { return m_rpm; }
+        double getThrottle() const { return m_throttle; }
+
+        // Interleaved synthesizer input frames at the input sample rate
+        void generate(double *frames, int count);
+
+        // Generates and renders until samples of output are ready; returns
+        // the samples written, short only if the synthesizer makes none
+        int render(int samples, int16_t *output);
+
+        Synthesizer &synthesizer() { return m_synthesizer; }
+        double getInputSampleRate() const { return m_inputSampleRate; }
+        unsigned long long getGrainCount() const { return m_grains; }
+
+    protected:
+        struct Weight {
+            int rpmIndex;
+            int throttleIndex;
+            double weight;
+        };
+
+        static void Bracket(const std::vector<double> &axis, double x, int *i0, int *i1, double *t);
+        void updateWeights();
+        void nextGrain();
+        void mixCells(double phase, double *frame);
+
+        const SoundBank *m_bank;
+        Parameters m_parameters;
+        double m_inputSampleRate;
+        RandomStream m_random;
+
+        double m_rpm;
+        double m_throttle;
+        Weight m_weights[4];
+
+        // Cycle index within the cells and position in the current cycle
+        int m_grain;
+        int m_previousGrain;
+        double m_phase;
+        unsigned long long m_grains;
+
+        std::vector<double> m_frame;
+        std::vector<double> m_blend;
+        std::vector<double> m_cell;
+        std::vector<double> m_input;
+        int m_blockFrames;
+
+        Synthesizer m_synthesizer;
+};
+
+#endif /* ATG_ENGINE_SIM_SOUND_BANK_PLAYER_H */
@@ -0,0 +1,103 @@
+#ifndef ATG_ENGINE_SIM_SPATIAL_MIXER_H
+#define ATG_ENGINE_SIM_SPATIAL_MIXER_H
+
+#include "leveling_filter.h"
+#include "synthesizer.h"
+
+#include <atomic>
+#include <cinttypes>
+
+// One stereo output for many engines, for traffic and multiplayer scenes.
+// Every source is a synthesizer initialized with leveling off; each block
+// the mixer reads the same number of samples from all of them, attenuates
+// each by its distance from the listener, pans it by its bearing and sums
+// them into a pair of planar buses, then levels the interleaved mix once
+// with a linked leveler. The per-engine cost is its physics and its
+// excitation and convolution; the leveling and the device are paid for
+// once.
+//
+// The listener sits at the origin facing +y with +x to its right, in
+// meters. Gains follow the inverse distance law past referenceDistance,
+// raised to rolloff, and the pan is constant power. Source gains are
+// ramped across a block so moving sources don't zipper.
+class SpatialMixer {
+    public:
+        static constexpr int OutputChannels = 2;
+
+        struct Parameters {
+            int maxSources = 32;
+
+            // Frames mixed per pass; mix() calls of any length are split
+            int blockSize = 256;
+
+            float referenceDistance = 5.0f;
+            float rolloff = 1.0f;
+
+            float volume = 1.0f;
+            float levelerTarget = 30000.0f;
+            float levelerMaxGain = 1.9f;
+            float levelerMinGain = 0.00001f;
+            int levelerBlockSize = 64;
+            int levelerLookahead = 64;
+        };
+
+        struct Statistics {
+            unsigned long long blocks = 0;
+
+            // Reads that found a source with fewer samples than the block
+            unsigned long long underruns = 0;
+        };
+
+    public:
+        SpatialMixer();
+        ~SpatialMixer();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        // Not owned; from the thread that mixes, between mix() calls.
+        // Returns the source's index, -1 when there's no room.
+        int addSource(Synthesizer *synthesizer);
+        void removeSource(int source);
+        int getSourceCount() const;
+
+        // From any thread; picked up by the next block
+        void setSourcePosition(int source, float x, float y);
+        void setSourceGain(int source, float gain);
+
+        // Interleaved stereo frames; every source is read for exactly count
+        // samples, with silence standing in for what it hasn't rendered yet
+        void mix(int frames, float *output);
+        void mix(int frames, int16_t *output);
+
+        // Gains a source at (x, y) gets, before the block ramp
+        void computeGains(float x, float y, float gain, float *left, float *right) const;
+
+        const Statistics &getStatistics() const { return m_statistics; }
+        float getLevelerGain() const { return m_leveler.getAttenuation(); }
+
+    protected:
+        struct Source {
+            Synthesizer *synthesizer = nullptr;
+            std::atomic<float> x{0.0f};
+            std::atomic<float> y{0.0f};
+            std::atomic<float> gain{1.0f};
+
+            // Gains the last block ended on
+            float left = 0.0f;
+            float right = 0.0f;
+        };
+
+        void mixBlock(int frames, float *output);
+
+        Parameters m_parameters;
+        Source *m_sources;
+        float *m_read;
+        float *m_left;
+        float *m_right;
+
+        LevelingFilter m_leveler;
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_SPATIAL_MIXER_H */
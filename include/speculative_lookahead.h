@@ -0,0 +1,148 @@
+#ifndef ATG_ENGINE_SIM_SPECULATIVE_LOOKAHEAD_H
+#define ATG_ENGINE_SIM_SPECULATIVE_LOOKAHEAD_H
+
+#include "job_system.h"
+#include "simulation_checkpoint.h"
+#include "synthesizer.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+class PistonEngineSimulator;
+
+// Hides the synthesizer's input latency from throttle changes. Every
+// interval the live simulator is checkpointed and a few likely throttle
+// futures are simulated from the checkpoint: held where it is, opened to
+// upThrottle and closed to downThrottle. Each future runs for horizon
+// seconds on its own branch simulator, as a job on the job system, and
+// renders its synthesizer alongside. Branch audio is indexed like the live
+// synthesizer's rings, from the input position the checkpoint was taken at.
+//
+// When the throttle target changes, the matching future of the newest
+// generation forked before the next sample to be read takes over. It
+// covers the samples from there up to the ones the live simulator renders
+// after the change, with a crossfade in and back out, so the change is
+// heard once the next read reaches the device rather than after the
+// synthesizer's input has drained. A branch hears the change from its fork
+// and the live simulator from the change itself, so they differ by up to
+// an interval of throttle history at the hand back; the crossfade covers it.
+//
+// Branch simulators come from the caller, built from the live engine's
+// script without an audio thread, so the checkpoints restore into them.
+class SpeculativeLookahead {
+    public:
+        enum class Future {
+            Hold,
+            Up,
+            Down,
+            Count
+        };
+
+        static constexpr int FutureCount = static_cast<int>(Future::Count);
+        static constexpr int GenerationCount = 4;
+
+        struct Parameters {
+            double interval = 0.05;
+            double horizon = 0.25;
+
+            // Branches smooth the throttle towards their future once per
+            // frame of this length, like the application's input handling
+            double frameLength = 1 / 60.0;
+
+            double upThrottle = 1.0;
+            double downThrottle = 0.0;
+
+            // A throttle target within this of a future's matches it
+            double tolerance = 0.01;
+
+            int crossfadeSamples = 256;
+        };
+
+        struct Statistics {
+            unsigned long long forks = 0;
+            unsigned long long engaged = 0;
+
+            // Changes no ready branch covered
+            unsigned long long missed = 0;
+
+            // Branches whose checkpoint didn't restore
+            unsigned long long failed = 0;
+        };
+
+    public:
+        SpeculativeLookahead();
+        ~SpeculativeLookahead();
+
+        void initialize(JobSystem *jobs, const Parameters &params);
+
+        // Waits for the branch jobs in flight
+        void destroy();
+
+        // Not owned; nullptr entries, or no array, turn lookahead off. Waits
+        // for the jobs running on the previous branches.
+        void setBranches(PistonEngineSimulator *const *branches);
+        bool hasBranches() const;
+
+        // Main thread, between live frames with the physics state lock
+        // held; forks a generation once interval has passed and the
+        // previous one finished. throttle is the live throttle now.
+        bool update(PistonEngineSimulator *live, double throttle, std::chrono::steady_clock::time_point now);
+
+        // Main thread, when the throttle target changes: readPosition is
+        // the live output position of the next sample to be read and
+        // livePosition the live input position the change will first be
+        // heard at. False when no branch matches.
+        bool engage(double throttle, size_t readPosition, size_t livePosition);
+        bool isEngaged() const { return m_active.generation >= 0; }
+
+        // Blends the engaged branch into count samples read from the live
+        // output at position
+        void mix(float *samples, int count, size_t position);
+
+        const Statistics &getStatistics() const { return m_statistics; }
+        const Parameters &getParameters() const { return m_parameters; }
+
+        static const char *GetFutureName(Future future);
+
+    protected:
+        struct Generation {
+            SimulationCheckpoint checkpoint;
+            size_t base = 0;
+            double throttle = 0.0;
+            int frequency = 0;
+            double speed = 1.0;
+            Synthesizer::AudioParameters audioParameters;
+
+            std::vector<float> audio[FutureCount];
+            std::atomic<int> pending{0};
+            bool valid = false;
+        };
+
+        struct Active {
+            int generation = -1;
+            int future = 0;
+            size_t start = 0;
+            size_t end = 0;
+        };
+
+        void simulate(Generation *generation, int future);
+        double getFutureThrottle(const Generation &generation, int future) const;
+        bool isReady(const Generation &generation) const;
+        void wait();
+
+        JobSystem::Group *m_jobs;
+        Parameters m_parameters;
+
+        PistonEngineSimulator *m_branches[FutureCount];
+        std::atomic<unsigned long long> m_failedBranches;
+
+        Generation m_generations[GenerationCount];
+        int m_nextGeneration;
+        std::chrono::steady_clock::time_point m_lastFork;
+
+        Active m_active;
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_SPECULATIVE_LOOKAHEAD_H */
@@ -0,0 +1,76 @@
+#ifndef ATG_ENGINE_SIM_SPECULATIVE_STEPPING_H
+#define ATG_ENGINE_SIM_SPECULATIVE_STEPPING_H
+
+#include "units.h"
+
+class Engine;
+class GasSystem;
+
+// Validates each step of a simulator running at a larger timestep than is
+// stable everywhere, see Simulator::setSpeculativeStepping(). The checks are
+// cheap enough for every step: non-finite rigid body or gas state, gas with
+// negative moles or energy or past the temperature and pressure bounds,
+// bodies spinning past the speed bound, and pistons drifting off their
+// cylinder axis, which is how solver error shows up first.
+class SpeculativeStepping {
+    public:
+        enum class Failure {
+            None,
+            NonFinite,
+            GasBounds,
+            Speed,
+            ConstraintDrift,
+            Count
+        };
+
+        static constexpr int FailureCount = static_cast<int>(Failure::Count);
+
+        struct Parameters {
+            // A failed frame is redone at this many times the step rate
+            int refinement = 4;
+
+            // Frames kept at the finer rate after a rollback before
+            // speculating again
+            int holdFrames = 30;
+
+            double maxTemperature = units::kelvin(6000.0);
+            double maxPressure = units::pressure(1000.0, units::atm);
+
+            // rad/s, about 50000 rpm
+            double maxAngularSpeed = 5000.0;
+            double maxPistonDrift = units::distance(1.0, units::mm);
+        };
+
+        struct Statistics {
+            unsigned long long frames = 0;
+            unsigned long long refinedFrames = 0;
+            unsigned long long rollbacks = 0;
+
+            // Of steps that failed, whether or not they could be redone
+            unsigned long long failures[FailureCount] = {};
+        };
+
+    public:
+        SpeculativeStepping();
+        ~SpeculativeStepping();
+
+        void initialize(const Parameters &params);
+        void reset();
+
+        Failure check(const Engine *engine) const;
+        static Failure CheckGas(const GasSystem &system, const Parameters &params);
+
+        void recordFrame(bool refined);
+        void recordFailure(Failure failure, bool rolledBack);
+
+        const Parameters &getParameters() const { return m_parameters; }
+        const Statistics &getStatistics() const { return m_statistics; }
+
+        static const char *GetFailureName(Failure failure);
+
+    protected:
+        Parameters m_parameters;
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_SPECULATIVE_STEPPING_H */
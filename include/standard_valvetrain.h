@@ -22,6 +22,9 @@ public:
     virtual Camshaft *getActiveIntakeCamshaft() override;
     virtual Camshaft *getActiveExhaustCamshaft() override;
 
+    inline Camshaft *getIntakeCamshaft() const { return m_intakeCamshaft; }
+    inline Camshaft *getExhaustCamshaft() const { return m_exhaustCamshaft; }
+
 private:
     Camshaft *m_intakeCamshaft;
     Camshaft *m_exhaustCamshaft;
@@ -0,0 +1,54 @@
+#ifndef ATG_ENGINE_SIM_STARTUP_TIMELINE_H
+#define ATG_ENGINE_SIM_STARTUP_TIMELINE_H
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+// Phases of start-up, recorded from any thread between Start() and Stop()
+// and written as a Chrome trace (chrome://tracing, Perfetto) so phases that
+// run concurrently show up side by side. Scopes outside a recording, such
+// as those of later hot reloads, record nothing.
+class StartupTimeline {
+public:
+    struct Event {
+        std::string name;
+
+        // Small ids in the order threads first recorded, 0 for Start()'s
+        int thread = 0;
+
+        // Microseconds since Start(); instant events have no duration
+        int64_t begin = 0;
+        int64_t duration = 0;
+        bool instant = false;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+
+    private:
+        const char *m_name;
+        int64_t m_begin;
+    };
+
+    static void Start();
+    static void Stop();
+    static bool IsRecording();
+
+    // Microseconds since Start()
+    static int64_t Now();
+
+    static void Record(const char *name, int64_t begin, int64_t end);
+    static void Mark(const char *name);
+
+    // First mark with the name, in microseconds since Start()
+    static bool FindMark(const char *name, int64_t *time);
+
+    static std::vector<Event> GetEvents();
+    static std::string ToChromeTrace();
+    static bool WriteChromeTrace(const std::string &path);
+};
+
+#endif /* ATG_ENGINE_SIM_STARTUP_TIMELINE_H */
@@ -0,0 +1,80 @@
+#ifndef ATG_ENGINE_SIM_STEADY_STATE_DETECTOR_H
+#define ATG_ENGINE_SIM_STEADY_STATE_DETECTOR_H
+
+#include "simulation_snapshot.h"
+
+#include <vector>
+
+// Decides when an engine has settled by comparing averages taken over whole
+// engine cycles (two crank revolutions). Once the last windowCycles cycle
+// averages of dyno torque, rpm, manifold pressure and AFR each stay within
+// their tolerance of the window mean, the engine counts as settled. The
+// cycle where that first happens is reported once, as the settled event.
+class SteadyStateDetector {
+    public:
+        // The allowed spread is the larger of relative * |mean| and absolute
+        struct Tolerance {
+            double relative;
+            double absolute;
+        };
+
+        struct Parameters {
+            int windowCycles = 4;
+
+            // Cycles ignored after reset(), while the transient decays
+            int warmupCycles = 2;
+
+            Tolerance torque = { 0.02, 1.0 };               // N m
+            Tolerance rpm = { 0.005, 5.0 };                 // rpm
+            Tolerance manifoldPressure = { 0.02, 500.0 };   // Pa
+            Tolerance afr = { 0.02, 0.1 };
+        };
+
+        struct Average {
+            double torque = 0.0;
+            double rpm = 0.0;
+            double manifoldPressure = 0.0;
+            double afr = 0.0;
+        };
+
+    public:
+        SteadyStateDetector();
+        ~SteadyStateDetector();
+
+        void initialize(const Parameters &params);
+        void reset();
+
+        // Feed once per frame; returns true on the cycle that settles
+        bool addSample(const SimulationSnapshot &snapshot);
+
+        bool isSettled() const { return m_settled; }
+        int getCycleCount() const { return m_cycles; }
+        double getSettledTime() const { return m_settledTime; }
+
+        // Mean of the cycles in the window
+        Average getWindowAverage() const;
+
+    protected:
+        bool isWindowSettled() const;
+        static bool WithinTolerance(
+            const std::vector<Average> &window,
+            double Average::*value,
+            const Tolerance &tolerance);
+
+        Parameters m_parameters;
+
+        std::vector<Average> m_window;
+        int m_windowNext;
+
+        Average m_cycleSum;
+        double m_cycleWeight;
+        double m_cycleAngle;
+        double m_lastTime;
+        bool m_started;
+
+        int m_cycles;
+        bool m_settled;
+        double m_settledTime;
+};
+
+#endif /* ATG_ENGINE_SIM_STEADY_STATE_DETECTOR_H */
@@ -0,0 +1,148 @@
+#ifndef ATG_ENGINE_SIM_STEP_PROFILER_H
+#define ATG_ENGINE_SIM_STEP_PROFILER_H
+
+#include "hardware_counters.h"
+
+#include <cinttypes>
+#include <string>
+
+// Per-stage timing of simulation steps and of the frames around them when the
+// library is built with ATG_ENGINE_SIM_PROFILE_STEPS (CMake:
+// ENGINE_SIM_PROFILE_STEPS=ON); otherwise the scoped timers compile to
+// nothing and every statistic is zero.
+//
+// Each thread records into its own slot of power-of-two latency buckets, so
+// timing a stage never takes a lock; readers sum the slots. While a capture
+// is running the same timers also append their begin and end to a shared
+// span ring, which is exported as a Chrome trace (chrome://tracing,
+// Perfetto) with one track per thread.
+//
+// Counted stages also read the thread's hardware counters around each call
+// once HardwareCounters::SetEnabled(true) is set.
+class StepProfiler {
+public:
+    enum class Stage {
+        Solver,
+        EngineUpdate,
+        IgnitionUpdate,
+        ChamberUpdate,
+        FluidExhaust,
+        FluidIntake,
+        FluidChambers,
+        ChamberZones,
+        WriteToSynthesizer,
+        SynthesizerInput,
+        SynthesizerRender,
+
+        // Acquiring the synthesizer's input lock, on either thread
+        SynthesizerLockWait,
+
+        Step,
+        Frame,
+        AudioOutput,
+        UiUpdate,
+        RenderScene,
+        Present,
+        Count
+    };
+
+    static constexpr int StageCount = static_cast<int>(Stage::Count);
+    static constexpr int BucketCount = 32;
+
+    struct Statistics {
+        uint64_t count = 0;
+        double totalMicroseconds = 0.0;
+
+        // buckets[i] counts samples between 2^(i - 1) and 2^i nanoseconds
+        uint64_t buckets[BucketCount] = {};
+
+        double averageMicroseconds() const {
+            return (count > 0) ? totalMicroseconds / count : 0.0;
+        }
+
+        double percentileMicroseconds(double p) const;
+
+        // What was recorded after earlier, a snapshot of the same stage
+        Statistics since(const Statistics &earlier) const;
+
+        // Summed over the calls that read hardware counters
+        uint64_t counterSamples = 0;
+        uint64_t counters[HardwareCounters::CounterCount] = {};
+
+        double countersPerCall(HardwareCounters::Counter counter) const {
+            return (counterSamples > 0)
+                ? static_cast<double>(counters[static_cast<int>(counter)]) / counterSamples
+                : 0.0;
+        }
+
+        double ipc() const {
+            const uint64_t cycles = counters[static_cast<int>(HardwareCounters::Counter::Cycles)];
+            return (cycles > 0)
+                ? static_cast<double>(counters[static_cast<int>(HardwareCounters::Counter::Instructions)]) / cycles
+                : 0.0;
+        }
+    };
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Stage stage) : m_stage(stage), m_start(Now()) { /* void */ }
+        ~ScopedTimer() { Record(m_stage, m_start, Now()); }
+
+    private:
+        Stage m_stage;
+        uint64_t m_start;
+    };
+
+    class CountedTimer {
+    public:
+        explicit CountedTimer(Stage stage);
+        ~CountedTimer();
+
+    private:
+        Stage m_stage;
+        bool m_counted;
+        HardwareCounters::Sample m_counters;
+        uint64_t m_start;
+    };
+
+    static bool IsEnabled();
+    static const char *GetStageName(Stage stage);
+
+    // Summed over every thread since start
+    static void GetStatistics(Stage stage, Statistics *statistics);
+
+    static uint64_t Now();
+    static void Record(Stage stage, uint64_t start, uint64_t end);
+    static void RecordCounters(Stage stage, const HardwareCounters::Sample &counters);
+
+    // Opened on the calling thread the first time it asks
+    static bool ReadThreadCounters(HardwareCounters::Sample *counters);
+
+    // Labels the calling thread's track in exported traces
+    static void SetThreadName(const char *name);
+
+    // Keeps the most recent spansCapacity spans. The ring of an earlier
+    // capture with another capacity is kept until exit, in case a thread is
+    // still writing to it.
+    static void StartCapture(int spansCapacity);
+    static void StopCapture();
+    static bool IsCapturing();
+
+    // Meant to be read once the capture is stopped
+    static std::string ToChromeTrace();
+    static bool WriteChromeTrace(const std::string &path);
+};
+
+#if defined(ATG_ENGINE_SIM_PROFILE_STEPS)
+#define ATG_ENGINE_SIM_PROFILE_CONCAT_(a, b) a##b
+#define ATG_ENGINE_SIM_PROFILE_CONCAT(a, b) ATG_ENGINE_SIM_PROFILE_CONCAT_(a, b)
+#define ATG_ENGINE_SIM_PROFILE_SCOPE(stage) \
+    StepProfiler::ScopedTimer ATG_ENGINE_SIM_PROFILE_CONCAT(stepProfilerTimer, __LINE__)(StepProfiler::Stage::stage)
+#define ATG_ENGINE_SIM_PROFILE_COUNTED_SCOPE(stage) \
+    StepProfiler::CountedTimer ATG_ENGINE_SIM_PROFILE_CONCAT(stepProfilerTimer, __LINE__)(StepProfiler::Stage::stage)
+#else
+#define ATG_ENGINE_SIM_PROFILE_SCOPE(stage) ((void)0)
+#define ATG_ENGINE_SIM_PROFILE_COUNTED_SCOPE(stage) ((void)0)
+#endif /* ATG_ENGINE_SIM_PROFILE_STEPS */
+
+#endif /* ATG_ENGINE_SIM_STEP_PROFILER_H */
@@ -2,21 +2,36 @@
 #define ATG_ENGINE_SIM_ENGINE_SYNTHESIZER_H
 
 #include "convolution_filter.h"
+#include "convolution_worker.h"
 #include "leveling_filter.h"
 #include "derivative_filter.h"
-#include "low_pass_filter.h"
+#include "low_pass_filter_bank.h"
 #include "jitter_filter.h"
 #include "ring_buffer.h"
 #include "butterworth_low_pass_filter.h"
+#include "butterworth_low_pass_filter_bank.h"
+#include "polyphase_resampler.h"
+#include "random_stream.h"
+#include "smoothed_parameter.h"
+#include "triple_buffer.h"
+#include "audio_analyzer.h"
+#include "latency_probe.h"
 
 #include <cinttypes>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <vector>
 
 class Synthesizer {
     public:
+        // Output is rendered as floats at full scale +-1; int16 readers get
+        // it multiplied by this and rounded
+        static constexpr float Int16Scale = 32768.0f;
+
         struct AudioParameters {
             float volume = 1.0f;
             float convolution = 1.0f;
@@ -36,22 +51,72 @@ class Synthesizer {
             int audioBufferSize = 44100;
             float inputSampleRate = 10000;
             float audioSampleRate = 44100;
+
+            // Most samples queued for output outside of offline mode
+            int renderLimit = 2000;
+
+            // Channels of the float multichannel output; 0 disables it
+            int outputChannelCount = 0;
+
+            // Impulse responses longer than the head partition are
+            // convolved in the frequency domain
+            bool partitionedConvolution = true;
+
+            // Partitioned impulse responses past twice the tail block have
+            // their tail convolved on a worker thread, see
+            // PartitionedConvolution
+            bool offloadConvolutionTail = false;
+
+            // The leveler's gain is computed once per levelerBlockSize
+            // samples and ramped in between, with the output delayed by
+            // levelerLookahead samples. Off by default: 0 levels every
+            // sample with no added latency
+            int levelerBlockSize = 0;
+            int levelerLookahead = 0;
+
+            // Off, the output is left unleveled for a mixer that levels the
+            // sum of many synthesizers once, see SpatialMixer
+            bool leveling = true;
+
+            // Time constant, in seconds, of the glide of the filter cutoffs
+            // towards a new setting; gains ramp across a single block. 0
+            // applies cutoffs at the next block.
+            float parameterSmoothing = 0.02f;
             AudioParameters initialAudioParameters;
         };
 
+        // Audio thread time spent rendering blocks, not counting waits for
+        // input or output space, and the cycles that found the input ring
+        // empty (underrun) or more than three quarters full (overrun). The
+        // lock contentions are acquisitions of the input lock that had to
+        // wait, on either thread.
+        struct RenderStatistics {
+            unsigned long long blocks = 0;
+            unsigned long long samples = 0;
+            double microseconds = 0.0;
+            unsigned long long underruns = 0;
+            unsigned long long overruns = 0;
+            unsigned long long lockContentions = 0;
+            unsigned long long inputDroppedSamples = 0;
+
+            double averageBlockMicroseconds() const {
+                return (blocks > 0) ? microseconds / blocks : 0.0;
+            }
+        };
+
         struct InputChannel {
-            RingBuffer<float> data;
+            // Ring of inputBufferSize samples indexed by the shared input
+            // read/write counters
+            float *data = nullptr;
             float *transferBuffer = nullptr;
-            double lastInputSample = 0.0f;
+            float *noiseBuffer = nullptr;
         };
 
         struct ProcessingFilters {
             ConvolutionFilter convolution;
             DerivativeFilter derivative;
             JitterFilter jitterFilter;
-            ButterworthLowPassFilter<float> airNoiseLowPass;
-            LowPassFilter inputDcFilter;
-            ButterworthLowPassFilter<double> antialiasing;
+            RandomStream airNoise;
         };
 
     public:
@@ -64,61 +129,351 @@ class Synthesizer {
             unsigned int samples,
             float volume,
             int index);
+
+        // Takes a kernel built by prepareImpulseResponse(), copying its FFT
+        // partitions rather than recomputing them
+        void initializeImpulseResponse(const ConvolutionFilter &prepared, int index);
+
+        // Same as initializeImpulseResponse(prepared, i) for every channel,
+        // null being a pass-through, but safe while audio is rendering: the
+        // kernels are installed at the start of the next block instead of
+        // the audio thread having to stop
+        void swapImpulseResponses(const std::vector<std::shared_ptr<const ConvolutionFilter>> &prepared);
+
+        // Re-prepares the installed impulse responses for direct or
+        // partitioned convolution; call before the audio thread starts
+        void setPartitionedConvolution(bool partitioned);
+        bool isPartitionedConvolution() const { return m_partitionedConvolution; }
+
+        // Same rules as setPartitionedConvolution()
+        void setConvolutionTailOffload(bool offload);
+        bool isConvolutionTailOffload() const { return m_offloadConvolutionTail; }
+        int getInputChannelCount() const { return m_inputChannelCount; }
+        bool isLeveling() const { return m_leveling; }
+
+        // Without multichannel output, channels given the same impulse
+        // response and volume are summed into one convolution, so the cost
+        // follows the distinct responses rather than the channel count.
+        // getConvolution() is the filter that convolves the channel.
+        const ConvolutionFilter &getConvolution(int index) const { return m_filters[m_convolutionGroups[index]].convolution; }
+        int getConvolutionCount() const;
+
+        // Scales and trims a decoded impulse response into filter's taps,
+        // resampling it from sourceSampleRate to targetSampleRate when both
+        // are set and differ
+        static void prepareImpulseResponse(
+            const int16_t *impulseResponse,
+            unsigned int samples,
+            float volume,
+            ConvolutionFilter *filter,
+            double sourceSampleRate = 0.0,
+            double targetSampleRate = 0.0);
         void startAudioRenderingThread();
         void endAudioRenderingThread();
         void destroy();
 
+        // Wait-free and allocation-free, so it can be driven from a platform
+        // audio callback; must only be called from one thread at a time.
+        // The int16 variant quantizes on the way out.
         int readAudioOutput(int samples, int16_t *buffer);
+        int readAudioOutput(int samples, float *buffer);
+        int audioSamplesAvailable() const;
+
+        // Quantizes float output for an int16 device, with TPDF dither when
+        // enabled; same threading rules as readAudioOutput()
+        void quantizeOutput(const float *input, int16_t *output, int samples);
+
+        // Underrun concealment for readers that have to hand a device
+        // something. While a period is set, the output read is remembered and
+        // concealOutput() continues it by repeating the last period, a little
+        // quieter each time around; output read afterwards is crossfaded in
+        // from the repeat. Returns the samples written, 0 if there isn't a
+        // period of output to repeat yet. Same threading rules as
+        // readAudioOutput(); a period of 0, the default, turns it off.
+        void setConcealmentPeriod(double seconds);
+        int concealOutput(int samples, float *buffer);
+        int concealOutput(int samples, int16_t *buffer);
+        unsigned long long getConcealedSampleCount() const { return m_concealedSamples.load(std::memory_order_relaxed); }
+
+        // Part of each impulse response's partitions convolved, to shed load;
+        // picked up by the audio thread at the start of its next block
+        void setConvolutionFraction(float fraction) { m_convolutionFraction.store(fraction, std::memory_order_relaxed); }
+        float getConvolutionFraction() const { return m_convolutionFraction.load(std::memory_order_relaxed); }
 
-        void writeInput(const double *data);
+        void setOutputDither(bool dither) { m_outputDither = dither; }
+        bool isOutputDither() const { return m_outputDither; }
+
+        // Interleaved frames of getOutputChannelCount() floats, mixed from
+        // the input channels after convolution and before antialiasing,
+        // leveling and volume. Frames are dropped rather than overwritten
+        // when the reader falls behind. Same threading rules as
+        // readAudioOutput().
+        int readMultichannelOutput(int frames, float *buffer);
+
+        // Zero-copy variant: points at the oldest unread frames and returns
+        // how many are contiguous; release them with
+        // consumeMultichannelOutput()
+        int peekMultichannelOutput(const float **frames) const;
+        void consumeMultichannelOutput(int frames);
+        int multichannelFramesAvailable() const;
+
+        // Gain from an input channel into an output channel; defaults to
+        // input i feeding output i modulo the output count. Call before the
+        // audio thread starts.
+        void setOutputMix(int input, int output, float gain);
+        float getOutputMix(int input, int output) const;
+        int getOutputChannelCount() const { return m_outputChannelCount; }
+
+        // data holds frames of m_inputChannelCount samples each, one frame
+        // per physics step
+        void writeInput(const double *data, int frames);
+        void writeInput(const double *data) { writeInput(data, 1); }
         void endInputBlock();
 
         void waitProcessed();
+        bool isProcessed() const;
+        int inputSamplesAvailable() const;
 
         void audioRenderingThread();
         void renderAudio();
 
+        // Renders whatever input has arrived on the calling thread without
+        // waiting for more; for hosts that run without the audio thread and
+        // pull samples from their own callback. Returns the samples rendered.
+        int renderPendingAudio();
+
         double getLatency() const;
 
+        // Running sample counts of the input published so far and of the
+        // output read so far; input sample n becomes output sample n
+        size_t getInputPosition() const { return m_inputWriteIndex.load(std::memory_order_acquire); }
+        size_t getOutputPosition() const { return m_audioReadIndex.load(std::memory_order_acquire); }
+
+        void setOfflineMode(bool offline);
+        bool isOfflineMode() const { return m_offline; }
+
         int inputDelta(int s1, int s0) const;
         double inputDistance(double s1, double s0) const;
 
         void setInputSampleRate(double sampleRate);
         double getInputSampleRate() const { return m_inputSampleRate; }
+        double getAudioSampleRate() const { return m_audioSampleRate; }
 
         int16_t renderAudio(int inputOffset);
 
+        // Runs each filter stage over the first n transferred samples of every
+        // channel, the low passes across all channels at once; produces the
+        // same output as n renderAudio(i) calls when the leveler is per
+        // sample (levelerBlockSize = 0). Overwrites the transfer buffers.
+        void renderAudioBlock(int n, float *output);
+        void renderAudioBlock(int n, int16_t *output);
+        int audioBufferLimit() const;
+
+        // Lock-free; parameters are written and read back from a single
+        // control thread and picked up by the audio thread at the start of
+        // its next block
         double getLevelerGain();
         AudioParameters getAudioParameters();
         void setAudioParameters(const AudioParameters &params);
 
+        // Channel i draws from streams 2i (jitter) and 2i + 1 (air noise);
+        // call before the audio thread starts
+        void setRandomSeed(uint64_t seed);
+        uint64_t getRandomSeed() const { return m_randomSeed; }
+
+        // Off by default; when on every rendered block is also fed to the
+        // analyzer, in place, on the audio thread
+        void setAnalysisEnabled(bool enabled) { m_analysisEnabled.store(enabled, std::memory_order_relaxed); }
+        bool isAnalysisEnabled() const { return m_analysisEnabled.load(std::memory_order_relaxed); }
+        AudioAnalyzer &analyzer() { return m_analyzer; }
+
+        // Marks the published, rendered and read stages of the probe's
+        // sample as it passes through the rings; nullptr, the default,
+        // leaves it out
+        void setLatencyProbe(LatencyProbe *probe) { m_latencyProbe.store(probe, std::memory_order_release); }
+        LatencyProbe *getLatencyProbe() const { return m_latencyProbe.load(std::memory_order_acquire); }
+
+        // Totals since initialize(); can be read from any thread
+        RenderStatistics getRenderStatistics() const;
+
     //protected:
         ButterworthLowPassFilter<float> m_antialiasing;
         LevelingFilter m_levelingFilter;
         InputChannel *m_inputChannels;
         AudioParameters m_audioParameters;
+        AudioParameters m_controlAudioParameters;
+        TripleBuffer<AudioParameters> m_audioParameterUpdates;
+        std::atomic<float> m_levelerGain;
         int m_inputChannelCount;
         int m_inputBufferSize;
-        int m_inputSamplesRead;
         int m_latency;
-        double m_inputWriteOffset;
-        double m_lastInputSampleOffset;
 
-        RingBuffer<int16_t> m_audioBuffer;
+        // Converts physics-rate input to the audio rate and band-limits it
+        // to m_inputCutoffFrequency in the same pass
+        PolyphaseResampler m_resampler;
+        float **m_resamplerOutputs;
+
+        // Planar channel tables for the filter banks: stage rows, transfer
+        // buffers and noise buffers, m_inputChannelCount each
+        float **m_stageChannels;
+        float **m_transferChannels;
+        float **m_noiseChannels;
+        float m_inputCutoffFrequency;
+
+        // Output ring with the same single-producer/single-consumer scheme
+        // as the input: the audio thread publishes m_audioWriteIndex and the
+        // reader publishes m_audioReadIndex
+        float *m_audioBuffer;
         int m_audioBufferSize;
+        int m_renderLimit;
+        std::atomic<size_t> m_audioWriteIndex;
+        std::atomic<size_t> m_audioReadIndex;
 
         float m_inputSampleRate;
         float m_audioSampleRate;
 
         std::thread *m_thread;
         std::atomic<bool> m_run;
-        bool m_processed;
+        bool m_offline;
+
+        // Single-producer/single-consumer input handoff. The physics thread
+        // owns the write cursor and publishes it in endInputBlock(); the
+        // audio thread publishes the read index once a block is copied out.
+        // Both are running sample counts shared by every channel. The write
+        // position counts every resampled sample and keeps advancing when
+        // the ring is full and samples are dropped.
+        size_t m_inputWritePosition;
+        size_t m_inputWriteCursor;
+
+        // Producer side; the probe's sample, published with the block
+        size_t m_probedInputIndex;
+        bool m_probedInput;
+        std::atomic<size_t> m_inputWriteIndex;
+        std::atomic<size_t> m_inputReadIndex;
+        std::atomic<size_t> m_inputObservedIndex;
+
+        // The condition variable is only used to wake an idle thread
+        std::atomic<bool> m_renderWaiting;
+        std::atomic<int> m_processedWaiters;
 
-        std::mutex m_inputLock;
         std::mutex m_lock0;
         std::condition_variable m_cv0;
 
+        std::atomic<unsigned long long> m_lock0ContentionCount{0};
+        std::atomic<unsigned long long> m_inputDroppedCount{0};
+        std::atomic<unsigned long long> m_renderedBlocks{0};
+        std::atomic<unsigned long long> m_renderedSamples{0};
+        std::atomic<unsigned long long> m_renderNanoseconds{0};
+        std::atomic<unsigned long long> m_underrunCount{0};
+        std::atomic<unsigned long long> m_overrunCount{0};
+
+        uint64_t m_randomSeed;
+        bool m_partitionedConvolution;
+        bool m_offloadConvolutionTail;
+        bool m_leveling;
+        ConvolutionWorker m_convolutionWorker;
+
         ProcessingFilters *m_filters;
+
+        // Channel whose filter convolves each channel's signal; a channel
+        // sharing another's keeps an identity filter of its own
+        int *m_convolutionGroups;
+        float *m_convolutionInputs;
+
+        // The per-channel low passes that share a cutoff, run across every
+        // channel at once
+        ButterworthLowPassFilterBank m_airNoiseLowPass;
+        LowPassFilterBank m_inputDcFilter;
+
+        // Block render scratch, m_inputBufferSize samples each; the stage
+        // buffer has one row per input channel so the banks see every channel
+        float *m_stageBuffer;
+        float *m_dcBuffer;
+        float *m_signalBuffer;
+        float *m_outputBuffer;
+
+        // Reader-side dither state; two DitherBlockSize scratch rows
+        static constexpr int DitherBlockSize = 256;
+        std::atomic<bool> m_outputDither;
+        RandomStream m_ditherNoise;
+        float *m_ditherBuffer;
+
+        // Reader-side concealment state: the last output read or concealed,
+        // up to MaxConcealmentPeriod seconds of it, and a scratch block for
+        // the int16 readers
+        static constexpr float ConcealmentDecay = 0.9f;
+        static constexpr int ConcealmentFade = 64;
+        static constexpr int ConcealmentBlockSize = 256;
+        static constexpr double MaxConcealmentPeriod = 0.25;
+        std::atomic<int> m_concealmentPeriod;
+        float *m_concealmentHistory;
+        int m_concealmentHistorySize;
+        size_t m_concealmentWrite;
+        float m_concealmentOffset;
+        int m_concealmentFade;
+        bool m_concealing;
+        float *m_concealmentBuffer;
+        std::atomic<unsigned long long> m_concealedSamples{0};
+
+        // Audio thread side of setConvolutionFraction()
+        std::atomic<float> m_convolutionFraction;
+        float m_appliedConvolutionFraction;
+
+        // Audio thread side of swapImpulseResponses()
+        std::mutex m_impulseResponseLock;
+        std::vector<std::shared_ptr<const ConvolutionFilter>> m_pendingImpulseResponses;
+        std::atomic<bool> m_impulseResponsesPending{false};
+
+        // Audio thread view of m_audioParameters; the gains ramp across
+        // each block and the cutoffs glide, so filters are redesigned only
+        // while a setting is moving
+        float m_parameterSmoothing;
+        SmoothedParameter m_smoothedVolume;
+        SmoothedParameter m_smoothedConvolution;
+        SmoothedParameter m_smoothedDerivativeMix;
+        SmoothedParameter m_smoothedAirNoise;
+        SmoothedParameter m_smoothedAirNoiseCutoff;
+        SmoothedParameter m_smoothedInputSampleNoise;
+
+        // Input-major m_inputChannelCount x m_outputChannelCount gains and
+        // the block's interleaved mix, m_inputBufferSize frames
+        int m_outputChannelCount;
+        float *m_outputMix;
+        float *m_mixBuffer;
+
+        // m_audioBufferSize frames, same single-producer/single-consumer
+        // indexing as m_audioBuffer
+        float *m_multichannelBuffer;
+        std::atomic<size_t> m_multichannelWriteIndex;
+        std::atomic<size_t> m_multichannelReadIndex;
+        std::atomic<unsigned long long> m_multichannelDroppedCount{0};
+
+        AudioAnalyzer m_analyzer;
+        std::atomic<bool> m_analysisEnabled;
+
+        std::atomic<LatencyProbe *> m_latencyProbe;
+
+    protected:
+        int beginAudioRead(int samples, size_t *readIndex) const;
+        void endAudioRead(size_t readIndex);
+
+        void recordOutput(float *buffer, int samples);
+        void pushConcealmentHistory(float sample);
+        float repeatSample(int period) const;
+
+        // Snaps the smoothed parameters onto m_audioParameters
+        void resetSmoothedParameters();
+
+        // Called around every impulse response change of a channel
+        void unshareConvolution(int index);
+        void shareConvolution(int index);
+        ConvolutionWorker *tailWorker() { return m_offloadConvolutionTail ? &m_convolutionWorker : nullptr; }
+        void installPendingImpulseResponses();
+
+        // Everything renderAudio() does once input is there; may release lk0
+        int renderInput(
+            std::unique_lock<std::mutex> &lk0,
+            std::chrono::steady_clock::time_point wakeTs);
 };
 
 #endif /* ATG_ENGINE_SIM_ENGINE_SYNTHESIZER_H */
@@ -0,0 +1,94 @@
+#ifndef ATG_ENGINE_SIM_SYNTHESIZER_CAPTURE_H
+#define ATG_ENGINE_SIM_SYNTHESIZER_CAPTURE_H
+
+#include "synthesizer.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Synthesizer input as the simulator wrote it, one float per exhaust system
+// per step, together with the synthesizer settings, impulse responses and
+// exhaust volumes it was written with. Rendering it again through another
+// synthesizer (see SynthesizerReplay) lets the audio settings change
+// without simulating the engine again.
+//
+// Recording buffers frames up to capacity between flushes and drops the
+// rest, so write() never allocates; simulators flush at the end of every
+// frame. A capture is a Header, the AudioParameters, a Channel description
+// per input channel and the frames, frame-major, all in the host's native
+// layout. A capture cut short keeps every frame flushed before it ended.
+// The input rate is the one given to record(), so a simulator that changes
+// frequency partway through replays at the wrong pitch from there on.
+class SynthesizerCapture {
+    public:
+        static constexpr uint32_t Magic = 0x43535345; // "ESSC"
+        static constexpr uint32_t Version = 1;
+        static constexpr int DefaultCapacity = 65536;
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            int32_t channels;
+            int32_t reserved;
+            double inputSampleRate;
+        };
+
+        struct Channel {
+            std::string impulseResponse;
+            double impulseResponseVolume = 1.0;
+
+            // Already applied to the captured frames
+            double audioVolume = 1.0;
+        };
+
+    public:
+        SynthesizerCapture();
+        ~SynthesizerCapture();
+
+        // Capacity is in frames
+        bool record(
+            const std::string &path,
+            double inputSampleRate,
+            const Synthesizer::AudioParameters &audioParameters,
+            const std::vector<Channel> &channels,
+            int capacity = DefaultCapacity);
+        void write(const double *frames, int count);
+        bool flush();
+        bool close();
+
+        bool load(const std::string &path);
+
+        bool isRecording() const { return m_file != nullptr; }
+        int getChannelCount() const { return (int)m_channels.size(); }
+        double getInputSampleRate() const { return m_inputSampleRate; }
+        const Synthesizer::AudioParameters &getAudioParameters() const { return m_audioParameters; }
+        const Channel &getChannel(int channel) const { return m_channels[channel]; }
+
+        // Loaded frames of getChannelCount() samples each
+        const float *getFrames() const { return m_frames.data(); }
+        size_t getFrameCount() const;
+
+        // Frames written or dropped while recording
+        unsigned long long getWrittenCount() const { return m_written; }
+        unsigned long long getDroppedCount() const { return m_dropped; }
+
+    protected:
+        double m_inputSampleRate;
+        Synthesizer::AudioParameters m_audioParameters;
+        std::vector<Channel> m_channels;
+
+        // Recording; converted frames wait here for the next flush
+        FILE *m_file;
+        std::vector<float> m_buffer;
+        size_t m_capacity;
+        unsigned long long m_written;
+        unsigned long long m_dropped;
+        bool m_failed;
+
+        // Loaded
+        std::vector<float> m_frames;
+};
+
+#endif /* ATG_ENGINE_SIM_SYNTHESIZER_CAPTURE_H */
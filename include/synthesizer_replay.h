@@ -0,0 +1,65 @@
+#ifndef ATG_ENGINE_SIM_SYNTHESIZER_REPLAY_H
+#define ATG_ENGINE_SIM_SYNTHESIZER_REPLAY_H
+
+#include "synthesizer_capture.h"
+
+#include <cinttypes>
+#include <vector>
+
+// Renders a SynthesizerCapture through a synthesizer of its own, with the
+// capture's settings or new ones. Changing the impulse responses, the
+// synthesizer parameters or an exhaust's volume costs a render rather than
+// a simulation. Volumes are rescaled against the ones the capture was
+// written with, since those are already in the frames.
+class SynthesizerReplay {
+    public:
+        struct Parameters {
+            double audioSampleRate = 44100.0;
+
+            // 0 plays at the rate the capture was written at
+            double inputSampleRate = 0.0;
+
+            bool overrideAudioParameters = false;
+            Synthesizer::AudioParameters audioParameters;
+
+            // Empty keeps the capture's; otherwise one per channel
+            std::vector<SynthesizerCapture::Channel> channels;
+        };
+
+    public:
+        SynthesizerReplay();
+        ~SynthesizerReplay();
+
+        // The capture isn't owned and has to outlive the replay
+        bool initialize(const SynthesizerCapture *capture, const Parameters &params);
+        void destroy();
+
+        // Returns the samples written; short once the capture has played out
+        // and the synthesizer has nothing left to render
+        int render(int samples, int16_t *output);
+
+        bool isFinished() const;
+        size_t getFramePosition() const { return m_position; }
+
+        Synthesizer &synthesizer() { return m_synthesizer; }
+        double getInputSampleRate() const { return m_inputSampleRate; }
+
+    protected:
+        void feed(int frames);
+
+        const SynthesizerCapture *m_capture;
+        double m_inputSampleRate;
+        std::vector<double> m_gains;
+        std::vector<double> m_input;
+        int m_blockFrames;
+        size_t m_position;
+
+        // Output samples the capture lasts at the output rate; past the end
+        // of the frames silence goes in until the resampler lets them out
+        size_t m_length;
+        size_t m_rendered;
+
+        Synthesizer m_synthesizer;
+};
+
+#endif /* ATG_ENGINE_SIM_SYNTHESIZER_REPLAY_H */
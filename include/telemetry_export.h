@@ -0,0 +1,170 @@
+#ifndef ATG_ENGINE_SIM_TELEMETRY_EXPORT_H
+#define ATG_ENGINE_SIM_TELEMETRY_EXPORT_H
+
+#include "event_counters.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Live engine state in shared memory for dashboards and loggers in other
+// processes. A name starting with '/' and containing no other '/' is a POSIX
+// shared memory object (a named file mapping on Windows); anything else is a
+// file that is created and mapped. The layout is a Header followed by a
+// power-of-two ring of fixed-size Records, all little-endian in the host's
+// native alignment, and only ever extended by bumping Version.
+//
+// The simulator writes one record every decimation steps and never waits on
+// readers. Each record carries its own sequence number, which is cleared
+// while the record is written and set to index + 1 afterwards. A reader
+// copies a record and keeps it only if the sequence matched before and after
+// the copy; records overwritten while being read are dropped.
+class TelemetryExport {
+    public:
+        static constexpr uint32_t Magic = 0x4D545345; // "ESTM"
+        static constexpr uint32_t Version = 2;
+        static constexpr int MaxCylinders = 32;
+        static constexpr int DefaultCapacity = 4096;
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t headerSize;
+            uint32_t recordSize;
+            uint32_t capacity;
+            uint32_t cylinderCount;
+
+            // Records written so far; record i is at i % capacity
+            std::atomic<uint64_t> writeIndex;
+
+            // Simulated seconds between records
+            double recordInterval;
+            uint8_t reserved[24];
+        };
+
+        struct Record {
+            std::atomic<uint64_t> sequence;
+
+            // Simulated seconds since the simulator was initialized
+            double time;
+
+            float rpm;
+            float throttle;
+
+            // N m, as measured by the dyno
+            float dynoTorque;
+
+            // Pa
+            float manifoldPressure;
+            float intakeAfr;
+
+            // m/s
+            float vehicleSpeed;
+            int32_t gear;
+            uint32_t flags;
+
+            // Pa; the first Header::cylinderCount entries are filled
+            float cylinderPressure[MaxCylinders];
+
+            // Process-wide EventCounters since the previous record, in
+            // EventCounters::Counter order; zero unless the build counts
+            uint32_t events[EventCounters::CounterCount];
+        };
+
+        enum Flags : uint32_t {
+            IgnitionEnabled = 1u << 0,
+            StarterEnabled = 1u << 1,
+            DynoEnabled = 1u << 2
+        };
+
+        // Everything a reader copies out of a record
+        struct Sample {
+            uint64_t index;
+            double time;
+            float rpm;
+            float throttle;
+            float dynoTorque;
+            float manifoldPressure;
+            float intakeAfr;
+            float vehicleSpeed;
+            int32_t gear;
+            uint32_t flags;
+            float cylinderPressure[MaxCylinders];
+            uint32_t events[EventCounters::CounterCount];
+        };
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must be lock-free");
+        static_assert(sizeof(Header) == 64, "header layout is part of the format");
+
+    public:
+        TelemetryExport();
+        ~TelemetryExport();
+
+        // Capacity is rounded up to a power of two; an existing export of
+        // the same name is replaced
+        bool open(const std::string &name, int capacity = DefaultCapacity, int decimation = 1);
+        void close();
+
+        bool isOpen() const { return m_header != nullptr; }
+        int getDecimation() const { return m_decimation; }
+
+        // Called every step; true once every decimation steps
+        bool isDue() {
+            if (++m_counter < m_decimation) return false;
+
+            m_counter = 0;
+            return true;
+        }
+
+        void setLayout(int cylinderCount, double recordInterval);
+        void write(const Sample &sample);
+
+        unsigned long long getWrittenCount() const;
+
+    protected:
+        Header *m_header;
+        Record *m_records;
+        uint64_t m_mask;
+
+        int m_decimation;
+        int m_counter;
+
+        std::string m_name;
+        void *m_mapping;
+        size_t m_size;
+        bool m_ownsName;
+};
+
+// Reading side, for tools built against this header and for tests
+class TelemetryExportReader {
+    public:
+        TelemetryExportReader();
+        ~TelemetryExportReader();
+
+        // Fails when the export doesn't exist yet or its magic, version or
+        // sizes don't match this build
+        bool open(const std::string &name);
+        void close();
+
+        bool isOpen() const { return m_header != nullptr; }
+        int getCylinderCount() const;
+        double getRecordInterval() const;
+
+        // Copies the records written since the last read, oldest first.
+        // Records the writer has lapped are counted as dropped and skipped.
+        int read(TelemetryExport::Sample *target, int maxSamples);
+
+        unsigned long long getDroppedCount() const { return m_dropped; }
+
+    protected:
+        const TelemetryExport::Header *m_header;
+        const TelemetryExport::Record *m_records;
+        uint64_t m_mask;
+        uint64_t m_readIndex;
+        unsigned long long m_dropped;
+
+        void *m_mapping;
+        size_t m_size;
+};
+
+#endif /* ATG_ENGINE_SIM_TELEMETRY_EXPORT_H */
@@ -0,0 +1,159 @@
+#ifndef ATG_ENGINE_SIM_TELEMETRY_LOG_H
+#define ATG_ENGINE_SIM_TELEMETRY_LOG_H
+
+#include "telemetry_export.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Columnar file log of a TelemetryExport, for sweeps and soak tests. A
+// background thread drains the export with a TelemetryExportReader, so the
+// simulator only ever writes its lock-free ring and never waits on the
+// disk; records the thread falls a whole ring behind on are counted as
+// dropped. Every chunkRows records each channel is encoded as a column of
+// its own and the chunk is appended to the file, so a log cut short keeps
+// every complete chunk.
+//
+// Integer columns are runs of equal deltas. Float columns are the bits that
+// differ from a linear prediction of the previous two values' bit patterns,
+// split into byte planes with runs packed, so the bytes that barely change
+// between steps cost next to nothing. Both are lossless.
+//
+// A log is a FileHeader, columnCount ColumnHeaders with their names, then
+// chunks: a ChunkHeader followed by one size-prefixed column after another,
+// in header order. Everything is little-endian in the host's native layout.
+class TelemetryLog {
+    public:
+        static constexpr uint32_t Magic = 0x4C545345; // "ESTL"
+        static constexpr uint32_t Version = 1;
+        static constexpr int DefaultChunkRows = 4096;
+
+        enum class Encoding : uint8_t {
+            DeltaRuns,
+            PredictedFloat,
+            PredictedDouble
+        };
+
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t cylinderCount;
+            uint32_t columnCount;
+
+            // Simulated seconds between records
+            double recordInterval;
+        };
+
+        struct ColumnHeader {
+            uint8_t encoding;
+            uint8_t nameLength;
+        };
+
+        struct ChunkHeader {
+            uint32_t rowCount;
+
+            // Bytes of column data that follow
+            uint32_t size;
+        };
+
+        struct Parameters {
+            int chunkRows = DefaultChunkRows;
+
+            // Seconds between drains of the export
+            double pollInterval = 0.01;
+        };
+
+        struct Statistics {
+            unsigned long long rows = 0;
+            unsigned long long chunks = 0;
+            unsigned long long bytes = 0;
+            unsigned long long dropped = 0;
+        };
+
+    public:
+        TelemetryLog();
+        ~TelemetryLog();
+
+        // The export must already be open; what its ring still holds is
+        // logged first
+        bool open(const std::string &exportName, const std::string &path, const Parameters &params);
+
+        // Drains what the export still holds and writes the last chunk
+        void close();
+
+        bool isOpen() const { return m_thread != nullptr; }
+        Statistics getStatistics() const;
+
+        // Column names in file order for a layout of cylinderCount cylinders
+        static std::vector<std::string> GetColumnNames(int cylinderCount);
+
+        static void EncodeChunk(
+            const TelemetryExport::Sample *samples,
+            int count,
+            int cylinderCount,
+            std::vector<uint8_t> *target);
+        static bool DecodeChunk(
+            const uint8_t *data,
+            size_t size,
+            int count,
+            int cylinderCount,
+            std::vector<TelemetryExport::Sample> *target);
+
+    protected:
+        void worker();
+        bool drain();
+        bool writeChunk(int count);
+        bool writeHeader();
+
+        TelemetryExportReader m_reader;
+        Parameters m_parameters;
+        FILE *m_file;
+
+        std::thread *m_thread;
+        bool m_run;
+        std::mutex m_lock;
+        std::condition_variable m_cv;
+
+        // Worker side
+        std::vector<TelemetryExport::Sample> m_pending;
+        std::vector<uint8_t> m_encoded;
+        int m_cylinderCount;
+        bool m_headerWritten;
+        bool m_failed;
+
+        mutable std::mutex m_statisticsLock;
+        Statistics m_statistics;
+};
+
+// Reading side, for tools built against this header and for tests
+class TelemetryLogReader {
+    public:
+        TelemetryLogReader();
+        ~TelemetryLogReader();
+
+        // Fails when the file isn't a log of this version
+        bool open(const std::string &path);
+        void close();
+
+        bool isOpen() const { return m_file != nullptr; }
+        int getCylinderCount() const { return (int)m_header.cylinderCount; }
+        double getRecordInterval() const { return m_header.recordInterval; }
+        const std::vector<std::string> &getColumnNames() const { return m_columns; }
+
+        // Appends the next chunk's records; false at the end of the file or
+        // at a chunk that was cut short
+        bool readChunk(std::vector<TelemetryExport::Sample> *target);
+
+    protected:
+        FILE *m_file;
+        TelemetryLog::FileHeader m_header;
+        std::vector<std::string> m_columns;
+        std::vector<uint8_t> m_buffer;
+};
+
+#endif /* ATG_ENGINE_SIM_TELEMETRY_LOG_H */
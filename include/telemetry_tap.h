@@ -0,0 +1,52 @@
+#ifndef ATG_ENGINE_SIM_TELEMETRY_TAP_H
+#define ATG_ENGINE_SIM_TELEMETRY_TAP_H
+
+#include <atomic>
+
+// Single-producer, single-consumer ring of per-step engine state. The
+// simulator appends a record after every step without locking or
+// allocating; the UI drains it once per frame and decides what to plot.
+// Records are dropped, not blocked on, when the consumer falls behind.
+class TelemetryTap {
+    public:
+        struct Record {
+            float cycleAngle;
+            float pressureCycleAngle;
+            float totalExhaustFlow;
+            float exhaustFlow;
+            float intakeFlow;
+            float molecules;
+            float exhaustValveLift;
+            float intakeValveLift;
+            float volume;
+            float pressure;
+            float totalPressure;
+        };
+
+        static constexpr int DefaultCapacity = 8192;
+
+    public:
+        TelemetryTap();
+        ~TelemetryTap();
+
+        // Capacity is rounded up to a power of two
+        void initialize(int capacity = DefaultCapacity);
+        void destroy();
+
+        bool write(const Record &record);
+        int read(Record *target, int maxRecords);
+
+        // Records written but not yet read
+        int getPendingCount() const;
+        unsigned long long getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    protected:
+        Record *m_records;
+        unsigned int m_mask;
+
+        std::atomic<unsigned int> m_writeIndex;
+        std::atomic<unsigned int> m_readIndex;
+        std::atomic<unsigned long long> m_dropped;
+};
+
+#endif /* ATG_ENGINE_SIM_TELEMETRY_TAP_H */
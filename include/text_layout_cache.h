@@ -0,0 +1,66 @@
+#ifndef ATG_ENGINE_SIM_TEXT_LAYOUT_CACHE_H
+#define ATG_ENGINE_SIM_TEXT_LAYOUT_CACHE_H
+
+#include "delta.h"
+
+#include <string>
+#include <unordered_map>
+
+// Laid-out widths of the strings drawn by the UI, keyed by string and font
+// height and shared by every element, so a string is only measured again
+// once it changes. Runs not used for EvictionFrames frames are dropped so
+// that values which change every frame don't accumulate.
+class TextLayoutCache {
+    public:
+        static constexpr unsigned int EvictionFrames = 120;
+
+        struct Statistics {
+            int runs = 0;
+            int hits = 0;
+            int layouts = 0;
+        };
+
+    public:
+        TextLayoutCache();
+        ~TextLayoutCache();
+
+        void initialize(dbasic::TextRenderer *renderer);
+        void destroy();
+
+        void beginFrame();
+        float getWidth(const std::string &s, float height);
+
+        const Statistics &getStatistics() const { return m_statistics; }
+
+    protected:
+        struct Key {
+            std::string text;
+            float height;
+
+            bool operator==(const Key &other) const {
+                return height == other.height && text == other.text;
+            }
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key &key) const {
+                return std::hash<std::string>()(key.text) ^ (std::hash<float>()(key.height) << 1);
+            }
+        };
+
+        struct Run {
+            float width = 0.0f;
+            unsigned int lastUsed = 0;
+        };
+
+        dbasic::TextRenderer *m_renderer;
+        std::unordered_map<Key, Run, KeyHash> m_runs;
+
+        // Reused for lookups so a hit doesn't allocate
+        Key m_lookup;
+
+        unsigned int m_frame;
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_TEXT_LAYOUT_CACHE_H */
@@ -0,0 +1,63 @@
+#ifndef ATG_ENGINE_SIM_THREAD_POLICY_H
+#define ATG_ENGINE_SIM_THREAD_POLICY_H
+
+#include <vector>
+
+// Process-wide scheduling policy for the threads the simulation's latency
+// depends on. Real-time audio uses the time-constraint policy and joins the
+// output device's audio workgroup on macOS, and SCHED_FIFO on Linux; both
+// fall back to a raised priority when the OS refuses (SCHED_FIFO needs
+// an rtprio limit or CAP_SYS_NICE). Core pinning is a hard affinity on Linux
+// and Windows and only an affinity hint on macOS, whose scheduler places
+// threads by QoS instead.
+class ThreadPolicy {
+    public:
+        enum class Role {
+            Audio,
+            Physics
+        };
+
+        struct Settings {
+            // The audio thread waits on its input most of the time, so
+            // real-time scheduling costs little; the physics thread can use
+            // its whole period and is only raised by default
+            bool realtimeAudio = true;
+            bool realtimePhysics = false;
+
+            // -1 lets the thread migrate
+            int audioCore = -1;
+            int physicsCore = -1;
+        };
+
+    public:
+        // Takes effect for threads started afterwards
+        static void SetSettings(const Settings &settings);
+        static Settings GetSettings();
+
+        // Called on the thread itself. period is its wake cadence in
+        // seconds, which the time-constraint policy budgets half of for
+        // computation; coreOffset spreads several threads of one role over
+        // consecutive cores. Returns false when any part was refused, in
+        // which case the thread runs with whatever did apply.
+        static bool ApplyToCurrentThread(Role role, double period, int coreOffset = 0);
+
+        // Leaves the audio workgroup joined by ApplyToCurrentThread(); call
+        // before the thread exits
+        static void ReleaseCurrentThread(Role role);
+
+        // Confines the calling thread to a set of CPUs, such as a
+        // CpuTopology placement; threads it starts afterwards inherit the
+        // set on Linux. Only a hint on macOS, where it returns false.
+        static bool PinCurrentThread(const std::vector<int> &cpus);
+
+        // The CPUs the calling thread may run on, to restore after pinning
+        static bool GetCurrentThreadCpus(std::vector<int> *cpus);
+
+        // The output device's os_workgroup_t (macOS 11+), which real-time
+        // audio threads started afterwards join so the OS schedules them
+        // with the device's IO thread; null clears it. It stays owned by the
+        // caller and must outlive those threads. Ignored elsewhere.
+        static void SetAudioWorkgroup(void *workgroup);
+};
+
+#endif /* ATG_ENGINE_SIM_THREAD_POLICY_H */
@@ -0,0 +1,58 @@
+#ifndef ATG_ENGINE_SIM_THREAD_POOL_H
+#define ATG_ENGINE_SIM_THREAD_POOL_H
+
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+    public:
+        typedef void (*Task)(void *context, int index);
+
+    public:
+        ThreadPool();
+        ~ThreadPool();
+
+        void initialize(int threadCount);
+        void destroy();
+
+        // Runs task(context, i) for i in [0, n) across the pool and the calling
+        // thread; returns once every index has completed.
+        void run(int n, Task task, void *context);
+
+        template <typename T_Fn>
+        void parallelFor(int n, T_Fn &&fn) {
+            typedef typename std::remove_reference<T_Fn>::type Fn;
+            run(n, [](void *context, int i) { (*static_cast<Fn *>(context))(i); }, &fn);
+        }
+
+        int getThreadCount() const { return static_cast<int>(m_threads.size()) + 1; }
+
+    protected:
+        void worker();
+        void execute(uint32_t generation);
+        uint32_t generation() const { return static_cast<uint32_t>(m_work >> 32); }
+
+        std::vector<std::thread> m_threads;
+
+        // Packs the dispatch generation (high bits) with the next task index
+        // (low bits) so a late worker can never claim an index from a newer
+        // dispatch.
+        std::atomic<uint64_t> m_work;
+        std::atomic<int> m_remaining;
+        std::atomic<int> m_sleeping;
+        std::atomic<bool> m_run;
+
+        std::atomic<Task> m_task;
+        std::atomic<void *> m_context;
+        std::atomic<int> m_taskCount;
+
+        std::mutex m_lock;
+        std::condition_variable m_cv;
+};
+
+#endif /* ATG_ENGINE_SIM_THREAD_POOL_H */
@@ -0,0 +1,61 @@
+#ifndef ATG_ENGINE_SIM_TIMING_MAP_H
+#define ATG_ENGINE_SIM_TIMING_MAP_H
+
+class Function;
+
+// Ignition advance over crank speed and manifold pressure, baked onto a
+// uniform grid so a lookup is two clamped index computations and one
+// bilinear blend. Scripts describe the map as timing curves at a handful
+// of manifold pressures; pressures between rows are blended linearly.
+class TimingMap {
+    public:
+        TimingMap();
+        ~TimingMap();
+
+        void initialize(
+            int speedSamples,
+            int pressureSamples,
+            double speed0,
+            double speed1,
+            double pressure0,
+            double pressure1);
+        void destroy();
+
+        // Fills the grid from curves of advance against crank speed, one per
+        // manifold pressure; rows are sorted by pressure here
+        void build(const Function *const *rows, const double *pressures, int rowCount);
+
+        void setValue(int speedIndex, int pressureIndex, double advance);
+        inline double getValue(int speedIndex, int pressureIndex) const {
+            return m_values[pressureIndex * m_speedSamples + speedIndex];
+        }
+
+        double sample(double speed, double pressure) const;
+
+        inline bool isBaked() const { return m_values != nullptr; }
+        inline int getSpeedSamples() const { return m_speedSamples; }
+        inline int getPressureSamples() const { return m_pressureSamples; }
+        inline double getSpeed0() const { return m_speed0; }
+        inline double getSpeed1() const { return m_speed1; }
+        inline double getPressure0() const { return m_pressure0; }
+        inline double getPressure1() const { return m_pressure1; }
+
+        // Grid and values of other; used to patch a running engine
+        void assign(const TimingMap &other);
+        bool matches(const TimingMap &other) const;
+
+    protected:
+        double *m_values;
+
+        int m_speedSamples;
+        int m_pressureSamples;
+
+        double m_speed0;
+        double m_speed1;
+        double m_pressure0;
+        double m_pressure1;
+        double m_invSpeedStep;
+        double m_invPressureStep;
+};
+
+#endif /* ATG_ENGINE_SIM_TIMING_MAP_H */
@@ -6,6 +6,8 @@
 #include "scs.h"
 
 class Transmission {
+    friend class SimulationCheckpoint;
+
     public:
         struct Parameters {
             int GearCount;
@@ -26,6 +28,9 @@ class Transmission {
             Engine *engine);
         void changeGear(int newGear);
         inline int getGear() const { return m_gear; }
+        inline int getGearCount() const { return m_gearCount; }
+        inline double getGearRatio(int i) const { return m_gearRatios[i]; }
+        inline double getMaxClutchTorque() const { return m_maxClutchTorque; }
         inline void setClutchPressure(double pressure) { m_clutchPressure = pressure; }
         inline double getClutchPressure() const { return m_clutchPressure; }
 
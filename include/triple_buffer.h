@@ -0,0 +1,59 @@
+#ifndef ATG_ENGINE_SIM_TRIPLE_BUFFER_H
+#define ATG_ENGINE_SIM_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Wait-free handoff of the latest value from one writer thread to one reader
+// thread. The writer fills its private slot and swaps it with the shared
+// middle slot; the reader swaps the middle slot with its own only when it
+// holds something newer.
+template <typename T_Data>
+class TripleBuffer {
+public:
+    TripleBuffer() {
+        m_back = 0;
+        m_middle = 1;
+        m_front = 2;
+    }
+
+    ~TripleBuffer() {
+        /* void */
+    }
+
+    // Not thread safe; call before either side is running
+    void reset(const T_Data &value) {
+        for (int i = 0; i < 3; ++i) {
+            m_slots[i] = value;
+        }
+
+        m_back = 0;
+        m_middle = 1;
+        m_front = 2;
+    }
+
+    void write(const T_Data &value) {
+        m_slots[m_back] = value;
+        m_back = m_middle.exchange(m_back | DirtyBit, std::memory_order_acq_rel) & IndexMask;
+    }
+
+    // Returns true if a newer value was picked up
+    bool update() {
+        if ((m_middle.load(std::memory_order_relaxed) & DirtyBit) == 0) return false;
+
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+
+    const T_Data &read() const { return m_slots[m_front]; }
+
+protected:
+    static constexpr int IndexMask = 0x3;
+    static constexpr int DirtyBit = 0x4;
+
+    T_Data m_slots[3];
+    int m_back;
+    int m_front;
+    std::atomic<int> m_middle;
+};
+
+#endif /* ATG_ENGINE_SIM_TRIPLE_BUFFER_H */
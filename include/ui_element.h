@@ -5,6 +5,7 @@
 
 #include "delta.h"
 
+#include <string>
 #include <vector>
 
 class EngineSimApplication;
@@ -25,6 +26,21 @@ class UiElement {
         virtual void render();
         virtual const char *getDebugName() const;
 
+        // Per-frame shapes that don't depend on draw state, generated before
+        // render() and possibly on another thread alongside other elements',
+        // see ParallelGeometry
+        virtual void generateGeometry();
+
+        // This element and its visible descendants, in drawing order
+        void collectShown(std::vector<UiElement *> *elements);
+
+        // Recomputes child bounds; only called by updateLayout() when this
+        // element's bounds moved or invalidateLayout() was called
+        virtual void layout();
+        void updateLayout();
+        void invalidateLayout();
+        bool isLayoutDirty() const { return m_layoutDirty; }
+
         virtual void signal(UiElement *element, Event event);
         virtual void onMouseDown(const Point &mouseLocal);
         virtual void onMouseUp(const Point &mouseLocal);
@@ -45,6 +61,7 @@ class UiElement {
             newElement->m_signalTarget = signalTarget;
             newElement->m_index = (int)m_children.size();
             m_children.push_back(newElement);
+            invalidateLayout();
 
             return newElement;
         }
@@ -60,8 +77,13 @@ class UiElement {
         Point worldToLocal(const Point &wp) const { return wp - getWorldPosition(); }
         Point localToWorld(const Point &lp) const { return lp + getWorldPosition(); }
 
+        // Hidden elements and everything under them skip update() and
+        // layout() as well as drawing; onVisibilityChanged() tells them when
+        // they come on or go off screen so they can suspend their own work
         void setVisible(bool visible);
         bool isVisible() const { return m_visible; }
+        bool isShown() const;
+        virtual void onVisibilityChanged(bool shown);
 
         size_t getChildCount() const { return m_children.size(); }
         UiElement *getChild(size_t index) const { return (index < m_children.size()) ? m_children[index] : nullptr; }
@@ -73,6 +95,7 @@ class UiElement {
 
     protected:
         void signal(Event event);
+        void notifyVisibilityChanged(bool shown);
 
         float pixelsToUnits(float length) const;
         Point pixelsToUnits(const Point &p) const;
@@ -84,6 +107,9 @@ class UiElement {
 
         void resetShader();
 
+        // Width of a label, remembered while the string and height repeat
+        float measureText(const std::string &s, float height);
+
         void drawModel(
                 dbasic::ModelAsset *model,
                 const ysVector &color,
@@ -132,6 +158,10 @@ class UiElement {
         bool m_mouseHeld;
         bool m_visible;
 
+    protected:
+        Bounds m_layoutBounds;
+        bool m_layoutDirty;
+
     protected:
         EngineSimApplication *m_app;
 };
@@ -21,6 +21,7 @@ class UiManager {
 
     protected:
         UiElement m_root;
+        std::vector<UiElement *> m_shown;
 
         UiElement *m_dragStart;
         UiElement *m_hover;
@@ -128,6 +128,10 @@ struct Bounds {
         return p >= m0 && p <= m1;
     }
 
+    bool overlaps(const Bounds &b) const {
+        return b.m0 <= m1 && m0 <= b.m1;
+    }
+
     Bounds add(const Bounds &b) const {
         return { m0.componentMin(b.m0), m1.componentMax(b.m1) };
     }
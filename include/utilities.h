@@ -1,10 +1,26 @@
 #ifndef ATG_ENGINE_SIM_UTILITIES_H
 #define ATG_ENGINE_SIM_UTILITIES_H
 
+#include <cinttypes>
+
 double modularDistance(double a, double b, double mod = 1.0);
 double positiveMod(double x, double mod);
 double erfApproximation(double x);
 
+// The three below run the host's best kernels (see kernel_dispatch.h)
+
+// Sums in eight independent lanes so the loop vectorizes; the result can
+// differ from a sequential sum in the last bits
+float dotProduct(const float *a, const float *b, int n);
+
+// output = saturate(round(input * scale + dither)), rounding half away from
+// zero; dither may be null. Branch-free so the loop vectorizes.
+void quantizeToInt16(
+    const float *input, int16_t *output, int n, float scale, const float *dither = nullptr);
+
+// acc += x * y over n interleaved complex values
+void multiplyAccumulateSpectrum(float *acc, const float *x, const float *y, int n);
+
 template <typename t>
 inline t clamp(t x, t x0 = static_cast<t>(0.0), t x1 = static_cast<t>(1.0)) {
     if (x <= x0) return x0;
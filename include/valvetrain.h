@@ -12,6 +12,10 @@ public:
 
     virtual Camshaft *getActiveIntakeCamshaft() = 0;
     virtual Camshaft *getActiveExhaustCamshaft() = 0;
+
+    // Once per simulation step, so anything the lift depends on other than
+    // the camshafts is settled outside the lift queries
+    virtual void update(double dt) { /* void */ }
 };
 
 #endif /* ATG_ENGINE_SIM_VALVETRAIN_H */
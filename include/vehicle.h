@@ -4,6 +4,8 @@
 #include "scs.h"
 
 class Vehicle {
+    friend class SimulationCheckpoint;
+
     public:
         struct Parameters {
             double mass;
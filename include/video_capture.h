@@ -0,0 +1,87 @@
+#ifndef ATG_ENGINE_SIM_VIDEO_CAPTURE_H
+#define ATG_ENGINE_SIM_VIDEO_CAPTURE_H
+
+#ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
+
+#include "dtv.h"
+
+#include "wav_writer.h"
+
+#include <condition_variable>
+#include <cinttypes>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Moves recording off the render thread. The render thread only copies the
+// screen into one of a few frame slots; a capture thread hands the slots to
+// the (hardware) encoder, blocking on it instead of the frame loop, and
+// streams the synthesizer output into a WAV file next to the video. Frames
+// are paced by the audio clock: the video has exactly one frame per
+// 1/frameRate seconds of audio, duplicating frames when rendering is slower
+// than the frame rate and skipping readbacks when it is faster, so the two
+// files line up when muxed.
+class VideoCapture {
+    public:
+        static constexpr int FrameSlots = 4;
+
+    public:
+        VideoCapture();
+        ~VideoCapture();
+
+        bool start(
+            const atg_dtv::Encoder::VideoSettings &settings,
+            const std::string &audioPath,
+            int sampleRate);
+        void stop();
+
+        bool isRunning() const { return m_thread != nullptr; }
+
+        // Render thread: returns the buffer to read the screen into, or
+        // nullptr when no frame is due or every slot is still queued; with
+        // wait it blocks for a slot instead, for offline renders where no
+        // frame may be dropped
+        uint8_t *beginFrame(bool wait = false);
+        void endFrame();
+
+        // Audio thread of the frame loop; samples are mono int16
+        void writeAudio(const int16_t *samples, int count);
+
+        int getDroppedFrames() const { return m_droppedFrames; }
+
+    protected:
+        struct Slot {
+            std::vector<uint8_t> rgb;
+            int repeat = 0;
+        };
+
+        void worker();
+        void flushAudio(std::vector<int16_t> *pending);
+
+        atg_dtv::Encoder m_encoder;
+        std::thread *m_thread;
+
+        std::mutex m_lock;
+        std::condition_variable m_wake;
+        std::condition_variable m_slotFreed;
+        bool m_run;
+
+        Slot m_slots[FrameSlots];
+        std::vector<int> m_freeSlots;
+        std::vector<int> m_queuedSlots;
+        int m_currentSlot;
+
+        std::vector<int16_t> m_pendingAudio;
+        long long m_audioSamples;
+        long long m_videoFrames;
+        int m_sampleRate;
+        int m_frameRate;
+        int m_droppedFrames;
+
+        WavWriter m_audioFile;
+};
+
+#endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
+
+#endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE_H */
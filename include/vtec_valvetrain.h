@@ -5,6 +5,8 @@
 
 class Engine;
 class VtecValvetrain : public Valvetrain {
+    friend class SimulationCheckpoint;
+
 public:
     struct Parameters {
         double minRpm;
@@ -12,6 +14,13 @@ public:
         double manifoldVacuum;
         double minThrottlePosition;
 
+        // Once engaged, disengages only below minRpm less this
+        double rpmHysteresis = 0.0;
+
+        // How long a change in the conditions has to hold before the
+        // solenoid switches cams, either way
+        double engagementDelay = 0.0;
+
         Camshaft *intakeCamshaft;
         Camshaft *exhaustCamshaft;
 
@@ -33,8 +42,26 @@ public:
     virtual Camshaft *getActiveIntakeCamshaft() override;
     virtual Camshaft *getActiveExhaustCamshaft() override;
 
+    // Latches the cams the lift queries read until the next update
+    virtual void update(double dt) override;
+    inline bool isEngaged() const { return m_engaged; }
+
+    inline Camshaft *getIntakeCamshaft() const { return m_intakeCamshaft; }
+    inline Camshaft *getExhaustCamshaft() const { return m_exhaustCamshaft; }
+    inline Camshaft *getVtecIntakeCamshaft() const { return m_vtecIntakeCamshaft; }
+    inline Camshaft *getVtecExhaustCamshaft() const { return m_vtecExhaustCamshaft; }
+    inline double getMinRpm() const { return m_minRpm; }
+    inline double getMinSpeed() const { return m_minSpeed; }
+    inline double getManifoldVacuum() const { return m_manifoldVacuum; }
+    inline double getMinThrottlePosition() const { return m_minThrottlePosition; }
+    inline double getRpmHysteresis() const { return m_rpmHysteresis; }
+    inline double getEngagementDelay() const { return m_engagementDelay; }
+
 private:
-    bool isVtecEnabled() const;
+    bool isVtecEnabled(double minRpm) const;
+
+    // Points the lift queries at the cams m_engaged selects
+    void latchCamshafts();
 
     Camshaft *m_intakeCamshaft;
     Camshaft *m_exhaustCamshaft;
@@ -42,12 +69,20 @@ private:
     Camshaft *m_vtecIntakeCamshaft;
     Camshaft *m_vtecExhaustCamshaft;
 
+    Camshaft *m_activeIntakeCamshaft;
+    Camshaft *m_activeExhaustCamshaft;
+
     Engine *m_engine;
 
     double m_minRpm;
     double m_minSpeed;
     double m_manifoldVacuum;
     double m_minThrottlePosition;
+    double m_rpmHysteresis;
+    double m_engagementDelay;
+
+    bool m_engaged;
+    double m_switchTime;
 };
 
 #endif /* ATG_ENGINE_SIM_VTEC_STANDARD_VALVETRAIN_H */
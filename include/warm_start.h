@@ -0,0 +1,74 @@
+#ifndef ATG_ENGINE_SIM_WARM_START_H
+#define ATG_ENGINE_SIM_WARM_START_H
+
+#include "gas_system.h"
+#include "units.h"
+
+class Intake;
+class PistonEngineSimulator;
+
+// Places a freshly loaded engine straight into an approximate running state
+// instead of leaving it at rest at 1 atm and 25 C for the starter, so a run
+// settles in a few cycles rather than a full crank-to-idle transient.
+//
+// The crankshafts spin at the requested speed with the pistons and rods
+// moving to match. Each intake's manifold pressure is where the flow past
+// its throttle plate meets the cylinders' demand, and every chamber holds
+// what its point in the cycle would: the charge while the intake is open,
+// compressed or expanded polytropically once sealed, and exhaust at the
+// collector's pressure. The runners and exhaust are warm. The ignition
+// module restarts from the current angle, and a cylinder caught between its
+// spark and top dead center is lit.
+class WarmStart {
+    public:
+        struct Settings {
+            // rad/s
+            double speed = units::rpm(1000.0);
+
+            // 0 estimates each intake's from its throttle plate as it stands
+            double manifoldPressure = 0.0;
+
+            double volumetricEfficiency = 0.85;
+            double polytropicExponent = 1.3;
+            double intakeTemperature = units::celcius(40.0);
+            double exhaustTemperature = units::celcius(650.0);
+
+            // Burned gas at top dead center, before the expansion
+            double combustionTemperature = units::kelvin(2300.0);
+        };
+
+        struct Result {
+            bool applied = false;
+
+            // Averaged over the intakes
+            double manifoldPressure = 0.0;
+            int litCylinders = 0;
+        };
+
+        struct ChamberEstimate {
+            double pressure = 0.0;
+            double temperature = 0.0;
+            bool burned = false;
+        };
+
+    public:
+        // After loadSimulation(), before the first step
+        static Result Apply(PistonEngineSimulator *simulator, const Settings &settings);
+
+        // demand is the cylinders' intake flow in mol/s per Pa of manifold
+        // pressure
+        static double EstimateManifoldPressure(const Intake *intake, double demand);
+
+        // phase is the cycle angle past the cylinder's firing top dead
+        // center in [0, 4 * pi), volume between minVolume and maxVolume
+        static ChamberEstimate EstimateChamber(
+            double phase,
+            double volume,
+            double minVolume,
+            double maxVolume,
+            double manifoldPressure,
+            double exhaustPressure,
+            const Settings &settings);
+};
+
+#endif /* ATG_ENGINE_SIM_WARM_START_H */
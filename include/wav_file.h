@@ -0,0 +1,31 @@
+#ifndef ATG_ENGINE_SIM_WAV_FILE_H
+#define ATG_ENGINE_SIM_WAV_FILE_H
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+// Portable RIFF/WAVE reader for impulse responses. Integer PCM of 8 to 32
+// bits and 32-bit float are decoded to int16; multichannel files keep only
+// their first channel.
+class WavFile {
+    public:
+        WavFile();
+        ~WavFile();
+
+        bool load(const std::string &path);
+        bool decode(const char *data, size_t size);
+        void destroy();
+
+        const int16_t *getSamples() const { return m_samples.data(); }
+        unsigned int getSampleCount() const { return static_cast<unsigned int>(m_samples.size()); }
+        int getSampleRate() const { return m_sampleRate; }
+        int getChannelCount() const { return m_channelCount; }
+
+    private:
+        std::vector<int16_t> m_samples;
+        int m_sampleRate;
+        int m_channelCount;
+};
+
+#endif /* ATG_ENGINE_SIM_WAV_FILE_H */
@@ -0,0 +1,31 @@
+#ifndef ATG_ENGINE_SIM_WAV_WRITER_H
+#define ATG_ENGINE_SIM_WAV_WRITER_H
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+// Streams 16-bit mono PCM to a RIFF/WAVE file. The header is written up
+// front and its sizes are filled in by close(), so a file that was never
+// closed still opens in most players.
+class WavWriter {
+    public:
+        WavWriter();
+        ~WavWriter();
+
+        bool open(const std::string &path, int sampleRate);
+        bool write(const int16_t *samples, int count);
+        bool close();
+
+        bool isOpen() const { return m_file != nullptr; }
+        long long getSampleCount() const { return m_sampleCount; }
+
+    private:
+        void writeHeader();
+
+        FILE *m_file;
+        int m_sampleRate;
+        long long m_sampleCount;
+};
+
+#endif /* ATG_ENGINE_SIM_WAV_WRITER_H */
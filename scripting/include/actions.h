@@ -14,6 +14,7 @@
 #include "cylinder_head_node.h"
 #include "cylinder_bank_node.h"
 #include "ignition_module_node.h"
+#include "timing_map_node.h"
 #include "transmission_node.h"
 #include "vehicle_node.h"
 
@@ -368,6 +369,57 @@ namespace es_script {
         double m_flowInput = 0.0;
     };
 
+    class ParameterNode : public Node {
+        class ParameterNodeOutput : public piranha::NodeOutput {
+        public:
+            ParameterNodeOutput() : NodeOutput(&piranha::FundamentalType::FloatType) {
+                m_value = 0.0;
+            }
+
+            virtual ~ParameterNodeOutput() {
+                /* void */
+            }
+
+            virtual void fullCompute(void *target) const {
+                *reinterpret_cast<double *>(target) = m_value;
+            }
+
+            void setValue(double value) { m_value = value; }
+
+        protected:
+            double m_value;
+        };
+
+    public:
+        ParameterNode() { /* void */ }
+        virtual ~ParameterNode() { /* void */ }
+
+    protected:
+        virtual void registerInputs() {
+            addInput("name", &m_name);
+            addInput("default", &m_default);
+
+            Node::registerInputs();
+        }
+
+        virtual void registerOutputs() {
+            registerOutput(&m_output, "__out");
+
+            setPrimaryOutput("__out");
+        }
+
+        virtual void _evaluate() {
+            readAllInputs();
+
+            m_output.setValue(Compiler::parameter(m_name, m_default));
+        }
+
+    protected:
+        ParameterNodeOutput m_output;
+        std::string m_name;
+        double m_default = 0.0;
+    };
+
     class ConnectIgnitionWireNode : public Node {
     public:
         ConnectIgnitionWireNode() { /* void */ }
@@ -378,6 +430,7 @@ namespace es_script {
             addInput("wire", &m_wire, InputTarget::Type::Object);
             addInput("ignition_module", &m_module, InputTarget::Type::Object);
             addInput("angle", &m_angle);
+            addInput("trim", &m_trim);
 
             Node::registerInputs();
         }
@@ -385,13 +438,64 @@ namespace es_script {
         virtual void _evaluate() {
             readAllInputs();
 
-            m_module->connect(m_wire, m_angle);
+            m_module->connect(m_wire, m_angle, m_trim);
         }
 
     protected:
         IgnitionWireNode *m_wire = nullptr;
         IgnitionModuleNode *m_module = nullptr;
         double m_angle = 0.0;
+        double m_trim = 0.0;
+    };
+
+    class SetTimingMapNode : public Node {
+    public:
+        SetTimingMapNode() { /* void */ }
+        virtual ~SetTimingMapNode() { /* void */ }
+
+    protected:
+        virtual void registerInputs() {
+            addInput("timing_map", &m_map, InputTarget::Type::Object);
+            addInput("ignition_module", &m_module, InputTarget::Type::Object);
+
+            Node::registerInputs();
+        }
+
+        virtual void _evaluate() {
+            readAllInputs();
+
+            m_module->setTimingMap(m_map);
+        }
+
+    protected:
+        TimingMapNode *m_map = nullptr;
+        IgnitionModuleNode *m_module = nullptr;
+    };
+
+    class AddTimingMapRowNode : public Node {
+    public:
+        AddTimingMapRowNode() { /* void */ }
+        virtual ~AddTimingMapRowNode() { /* void */ }
+
+    protected:
+        virtual void registerInputs() {
+            addInput("pressure", &m_pressure);
+            addInput("timing", &m_timing, InputTarget::Type::Object);
+            addInput("timing_map", &m_map, InputTarget::Type::Object);
+
+            Node::registerInputs();
+        }
+
+        virtual void _evaluate() {
+            readAllInputs();
+
+            m_map->addRow(m_pressure, m_timing);
+        }
+
+    protected:
+        double m_pressure = 0.0;
+        FunctionNode *m_timing = nullptr;
+        TimingMapNode *m_map = nullptr;
     };
 
     class AddIgnitionModuleNode : public Node {
@@ -555,6 +659,38 @@ namespace es_script {
             addInput("speed_units", &m_settings.speedUnits);
             addInput("pressure_units", &m_settings.pressureUnits);
             addInput("boost_units", &m_settings.boostUnits);
+            addInput("latency_profile", &m_settings.latencyProfile);
+            addInput("audio_latency", &m_settings.audioLatency);
+            addInput("latency_probe", &m_settings.latencyProbe);
+            addInput("speculative_lookahead", &m_settings.speculativeLookahead);
+            addInput("reduced_audio_memory", &m_settings.reducedAudioMemory);
+            addInput("audio_dither", &m_settings.audioDither);
+            addInput("threaded_physics", &m_settings.threadedPhysics);
+            addInput("realtime_audio", &m_settings.realtimeAudio);
+            addInput("realtime_physics", &m_settings.realtimePhysics);
+            addInput("audio_core", &m_settings.audioCore);
+            addInput("physics_core", &m_settings.physicsCore);
+            addInput("telemetry_export", &m_settings.telemetryExport);
+            addInput("telemetry_decimation", &m_settings.telemetryDecimation);
+            addInput("adaptive_framerate", &m_settings.adaptiveFramerate);
+            addInput("idle_pause", &m_settings.idlePause);
+            addInput("parallel_geometry", &m_settings.parallelGeometry);
+            addInput("preview_fidelity", &m_settings.previewFidelity);
+            addInput("calibrate_fidelity", &m_settings.calibrateFidelity);
+            addInput("fidelity_headroom", &m_settings.fidelityHeadroom);
+            addInput("cycle_audio_cache", &m_settings.cycleAudioCache);
+            addInput("impulse_response_minimum_phase", &m_settings.impulseResponseMinimumPhase);
+            addInput("artifact_cache", &m_settings.artifactCache);
+            addInput("artifact_cache_size", &m_settings.artifactCacheSize);
+            addInput("control_surface_midi", &m_settings.controlSurfaceMidi);
+            addInput("control_surface_osc_port", &m_settings.controlSurfaceOscPort);
+            addInput("offload_convolution_tail", &m_settings.offloadConvolutionTail);
+            addInput("rigid_body_interval", &m_settings.rigidBodyInterval);
+            addInput("record_input", &m_settings.recordInput);
+            addInput("replay_input", &m_settings.replayInput);
+            addInput("render_video", &m_settings.renderVideo);
+            addInput("render_frame_rate", &m_settings.renderFrameRate);
+            addInput("render_duration", &m_settings.renderDuration);
 
             addInput("color_background", &m_settings.colorBackground);
             addInput("color_foreground", &m_settings.colorForeground);
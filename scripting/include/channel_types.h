@@ -25,6 +25,7 @@ namespace es_script {
         static const piranha::ChannelType VehicleChannel;
         static const piranha::ChannelType TransmissionChannel;
         static const piranha::ChannelType ThrottleChannel;
+        static const piranha::ChannelType TimingMapChannel;
     };
 
     template <typename Type>
@@ -59,6 +60,7 @@ namespace es_script {
     ASSIGN_CHANNEL_TYPE(VehicleNode, VehicleChannel);
     ASSIGN_CHANNEL_TYPE(TransmissionNode, VehicleChannel);
     ASSIGN_CHANNEL_TYPE(ThrottleNode, ThrottleChannel);
+    ASSIGN_CHANNEL_TYPE(TimingMapNode, TimingMapChannel);
 
 } /* namespace es_script */
 
@@ -6,12 +6,24 @@
 #include "engine_sim.h"
 #include "piranha.h"
 
+#include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace es_script {
 
     class Compiler {
     public:
+        // Values for the parameter() nodes a script declares, by name
+        using ParameterBindings = std::map<std::string, double>;
+
+        struct Parameter {
+            std::string name;
+            double defaultValue = 0.0;
+            double value = 0.0;
+        };
+
         struct Output {
             Engine *engine = nullptr;
             Vehicle *vehicle = nullptr;
@@ -20,10 +32,18 @@ namespace es_script {
             ApplicationSettings applicationSettings;
 
             std::vector<Function *> functions;
+
+            // Every parameter the script declared, in the order evaluated
+            std::vector<Parameter> parameters;
         };
 
     private:
         static Output *s_output;
+        static const ParameterBindings *s_bindings;
+
+        // Scripts write into s_output, and loads can run on several
+        // threads, so compiling and executing happen one at a time
+        static std::mutex s_scriptLock;
 
     public:
         Compiler();
@@ -31,10 +51,21 @@ namespace es_script {
 
         static Output *output();
 
+        // Called by parameter nodes while a script executes: records the
+        // parameter and returns its binding, or the default if it has none
+        static double parameter(const std::string &name, double defaultValue);
+
         void initialize();
         void addSearchPath(const piranha::IrPath &path);
         bool compile(const piranha::IrPath &path);
         Output execute();
+
+        // Builds a fresh program from the already compiled script and runs
+        // it with the given bindings, so every call returns new objects and
+        // nothing is parsed or resolved again. Scripts execute one at a
+        // time across all compilers.
+        Output execute(const ParameterBindings &bindings);
+
         void destroy();
 
     private:
@@ -43,6 +74,7 @@ namespace es_script {
     private:
         LanguageRules m_rules;
         piranha::Compiler *m_compiler;
+        piranha::IrCompilationUnit *m_unit;
         piranha::NodeProgram m_program;
     };
 
@@ -114,6 +114,8 @@ namespace es_script {
                 meanPistonSpeedToTurbulence->addSample(s, s * 0.5);
             }
 
+            meanPistonSpeedToTurbulence->bake();
+
             Fuel *fuel = engine->getFuel();
             m_fuel->generate(fuel, &context);
 
@@ -164,6 +166,9 @@ namespace es_script {
             addInput("hf_gain", &m_parameters.initialHighFrequencyGain);
             addInput("jitter", &m_parameters.initialJitter);
             addInput("noise", &m_parameters.initialNoise);
+            addInput("multi_zone", &m_parameters.multiZone);
+            addInput("crevice_volume", &m_parameters.creviceVolume);
+            addInput("knock_octane", &m_parameters.knockOctane);
 
             ObjectReferenceNode<EngineNode>::registerInputs();
         }
@@ -10,17 +10,13 @@
 namespace es_script {
 
     class FunctionNode : public ObjectReferenceNode<FunctionNode> {
-    public:
-        struct Sample {
-            double x, y;
-        };
-
     public:
         FunctionNode() { /* void */ }
         virtual ~FunctionNode() { /* void */ }
 
         void addSample(double x, double y) {
-            m_samples.push_back({ x, y });
+            m_x.push_back(x);
+            m_y.push_back(y);
         }
 
         void setFilterRadius(double filterRadius) {
@@ -33,11 +29,14 @@ namespace es_script {
                 return existingFunction;
             }
             else {
+                // Sorted once here; scripts such as generated lobe profiles
+                // add their samples out of order
                 Function *function = new Function;
-                function->initialize((int)m_samples.size(), m_filterRadius);
+                function->initialize((int)m_x.size(), m_filterRadius);
+                function->setSamples(m_x.data(), m_y.data(), (int)m_x.size());
 
-                for (const Sample &sample : m_samples) {
-                    function->addSample(sample.x, sample.y);
+                if (m_staticSamples) {
+                    function->bake();
                 }
 
                 context->addFunction(this, function);
@@ -48,6 +47,7 @@ namespace es_script {
     protected:
         virtual void registerInputs() {
             addInput("filter_radius", &m_filterRadius);
+            addInput("static_samples", &m_staticSamples);
 
             ObjectReferenceNode<FunctionNode>::registerInputs();
         }
@@ -59,8 +59,10 @@ namespace es_script {
             readAllInputs();
         }
 
-        std::vector<Sample> m_samples;
+        std::vector<double> m_x;
+        std::vector<double> m_y;
         double m_filterRadius = 0.0;
+        bool m_staticSamples = false;
     };
 
 } /* namespace es_script */
@@ -5,6 +5,7 @@
 
 #include "engine_context.h"
 #include "function_node.h"
+#include "timing_map_node.h"
 
 #include "engine_sim.h"
 
@@ -17,6 +18,7 @@ namespace es_script {
         struct Post {
             IgnitionWireNode *wire;
             double angle;
+            double trim;
         };
 
     public:
@@ -33,6 +35,10 @@ namespace es_script {
             params.limiterDuration = m_limiterDuration;
             engine->getIgnitionModule()->initialize(params);
 
+            if (m_timingMap != nullptr) {
+                m_timingMap->generate(engine->getIgnitionModule()->getTimingMap(), context);
+            }
+
             for (const Post &post : m_posts) {
                 std::set<IgnitionWireNode::Connection> connections =
                     post.wire->getConnections();
@@ -43,12 +49,17 @@ namespace es_script {
                     );
 
                     engine->getIgnitionModule()->setFiringOrder(index, post.angle);
+                    engine->getIgnitionModule()->setCylinderTrim(index, post.trim);
                 }
             }
         }
 
-        void connect(IgnitionWireNode *wire, double angle) {
-            m_posts.push_back({ wire, angle });
+        void connect(IgnitionWireNode *wire, double angle, double trim) {
+            m_posts.push_back({ wire, angle, trim });
+        }
+
+        void setTimingMap(TimingMapNode *map) {
+            m_timingMap = map;
         }
 
     protected:
@@ -69,6 +80,7 @@ namespace es_script {
 
         double m_revLimit = 0.0;
         FunctionNode *m_timingCurve = nullptr;
+        TimingMapNode *m_timingMap = nullptr;
         double m_limiterDuration = 0.0;
         std::vector<Post> m_posts;
     };
@@ -32,11 +32,14 @@ namespace es_script {
                     path = parentPath.append(path);
                 }
 
+                // Only the path is kept; the file is read once an exhaust
+                // system's synthesizer asks ImpulseResponseCache for it
                 ImpulseResponse *impulseResponse = new ImpulseResponse;
                 impulseResponse->initialize(
                     path.toString(),
                     m_volume);
 
+                context->addImpulseResponse(this, impulseResponse);
                 return impulseResponse;
             }
         }
@@ -0,0 +1,51 @@
+#ifndef ATG_ENGINE_SIM_SCRIPT_SOURCES_H
+#define ATG_ENGINE_SIM_SCRIPT_SOURCES_H
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+namespace es_script {
+
+    // Content hashes of a script and every .mr file it imports, resolved the
+    // way the compiler does (importing file's directory, then search paths).
+    // Used as the key for whether a loaded script is stale.
+    class ScriptSources {
+    public:
+        struct File {
+            std::string path;
+            uint64_t hash;
+        };
+
+    public:
+        ScriptSources();
+        ~ScriptSources();
+
+        // Where the compiler looks for imports before any path it's given
+        static const std::vector<std::string> &DefaultSearchPaths();
+
+        // The defaults followed by the asset library's, the order
+        // EngineLoader compiles with
+        static std::vector<std::string> SearchPaths(const std::string &assetPath);
+
+        void addSearchPath(const std::string &path);
+        bool collect(const std::string &mainScript);
+
+        uint64_t getHash() const { return m_hash; }
+        const std::vector<File> &getFiles() const { return m_files; }
+
+        // Paths whose contents differ from (or are missing in) another set
+        std::vector<std::string> changedSince(const ScriptSources &previous) const;
+
+    private:
+        bool collectFile(const std::string &path);
+        std::string resolveImport(const std::string &importingFile, const std::string &import) const;
+
+        std::vector<std::string> m_searchPaths;
+        std::vector<File> m_files;
+        uint64_t m_hash;
+    };
+
+} /* namespace es_script */
+
+#endif /* ATG_ENGINE_SIM_SCRIPT_SOURCES_H */
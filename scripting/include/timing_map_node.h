@@ -0,0 +1,82 @@
+#ifndef ATG_ENGINE_SIM_TIMING_MAP_NODE_H
+#define ATG_ENGINE_SIM_TIMING_MAP_NODE_H
+
+#include "object_reference_node.h"
+
+#include "engine_context.h"
+#include "function_node.h"
+
+#include "engine_sim.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace es_script {
+
+    class TimingMapNode : public ObjectReferenceNode<TimingMapNode> {
+    public:
+        struct Row {
+            double pressure;
+            FunctionNode *timing;
+        };
+
+    public:
+        TimingMapNode() { /* void */ }
+        virtual ~TimingMapNode() { /* void */ }
+
+        void addRow(double pressure, FunctionNode *timing) {
+            m_rows.push_back({ pressure, timing });
+        }
+
+        void generate(TimingMap *map, EngineContext *context) const {
+            if (m_rows.empty()) return;
+
+            std::vector<const Function *> functions;
+            std::vector<double> pressures;
+            for (const Row &row : m_rows) {
+                functions.push_back(row.timing->generate(context));
+                pressures.push_back(row.pressure);
+            }
+
+            // A single row still needs a span to interpolate over
+            const double p0 = *std::min_element(pressures.begin(), pressures.end());
+            const double p1 = std::max(
+                *std::max_element(pressures.begin(), pressures.end()), p0 + 1.0);
+
+            map->initialize(
+                std::max(m_speedSamples, 2),
+                std::max(m_pressureSamples, 2),
+                m_minSpeed,
+                std::max(m_maxSpeed, m_minSpeed + 1.0),
+                p0,
+                p1);
+            map->build(functions.data(), pressures.data(), (int)m_rows.size());
+        }
+
+    protected:
+        virtual void registerInputs() {
+            addInput("min_speed", &m_minSpeed);
+            addInput("max_speed", &m_maxSpeed);
+            addInput("speed_samples", &m_speedSamples);
+            addInput("pressure_samples", &m_pressureSamples);
+
+            ObjectReferenceNode<TimingMapNode>::registerInputs();
+        }
+
+        virtual void _evaluate() {
+            setOutput(this);
+
+            // Read inputs
+            readAllInputs();
+        }
+
+        double m_minSpeed = 0.0;
+        double m_maxSpeed = 0.0;
+        int m_speedSamples = 64;
+        int m_pressureSamples = 16;
+        std::vector<Row> m_rows;
+    };
+
+} /* namespace es_script */
+
+#endif /* ATG_ENGINE_SIM_TIMING_MAP_NODE_H */
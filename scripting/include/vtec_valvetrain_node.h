@@ -39,6 +39,8 @@ namespace es_script {
             params.minSpeed = m_parameters.minSpeed;
             params.minThrottlePosition = m_parameters.minThrottlePosition;
             params.manifoldVacuum = m_parameters.manifoldVacuum;
+            params.rpmHysteresis = m_parameters.rpmHysteresis;
+            params.engagementDelay = m_parameters.engagementDelay;
             params.engine = context->getEngine();
             valvetrain->initialize(params);
 
@@ -56,6 +58,8 @@ namespace es_script {
             addInput("min_speed", &m_parameters.minSpeed);
             addInput("manifold_vacuum", &m_parameters.manifoldVacuum);
             addInput("min_throttle_position", &m_parameters.minThrottlePosition);
+            addInput("rpm_hysteresis", &m_parameters.rpmHysteresis);
+            addInput("engagement_delay", &m_parameters.engagementDelay);
 
             ValvetrainNode::registerInputs();
         }
@@ -1,9 +1,14 @@
 #include "../include/compiler.h"
 
+#include "../include/script_sources.h"
+
 es_script::Compiler::Output *es_script::Compiler::s_output = nullptr;
+const es_script::Compiler::ParameterBindings *es_script::Compiler::s_bindings = nullptr;
+std::mutex es_script::Compiler::s_scriptLock;
 
 es_script::Compiler::Compiler() {
     m_compiler = nullptr;
+    m_unit = nullptr;
 }
 
 es_script::Compiler::~Compiler() {
@@ -18,13 +23,34 @@ es_script::Compiler::Output *es_script::Compiler::output() {
     return s_output;
 }
 
+double es_script::Compiler::parameter(const std::string &name, double defaultValue) {
+    double value = defaultValue;
+    if (s_bindings != nullptr) {
+        const auto binding = s_bindings->find(name);
+        if (binding != s_bindings->end()) value = binding->second;
+    }
+
+    std::vector<Parameter> &parameters = output()->parameters;
+    for (const Parameter &declared : parameters) {
+        if (declared.name == name) return value;
+    }
+
+    Parameter declared;
+    declared.name = name;
+    declared.defaultValue = defaultValue;
+    declared.value = value;
+    parameters.push_back(declared);
+
+    return value;
+}
+
 void es_script::Compiler::initialize() {
     m_compiler = new piranha::Compiler(&m_rules);
     m_compiler->setFileExtension(".mr");
 
-    m_compiler->addSearchPath("../../es/");
-    m_compiler->addSearchPath("../es/");
-    m_compiler->addSearchPath("es/");
+    for (const std::string &path : ScriptSources::DefaultSearchPaths()) {
+        m_compiler->addSearchPath(path.c_str());
+    }
 
     m_rules.initialize();
 }
@@ -35,6 +61,8 @@ void es_script::Compiler::addSearchPath(const piranha::IrPath &path) {
 }
 
 bool es_script::Compiler::compile(const piranha::IrPath &path) {
+    std::lock_guard<std::mutex> lock(s_scriptLock);
+
     bool successful = false;
     piranha::IrCompilationUnit *unit = m_compiler->compile(path);
     if (unit == nullptr) {
@@ -45,6 +73,7 @@ bool es_script::Compiler::compile(const piranha::IrPath &path) {
     else {
         const piranha::ErrorList *errors = m_compiler->getErrorList();
         if (errors->getErrorCount() == 0) {
+            m_unit = unit;
             unit->build(&m_program);
 
             m_program.initialize();
@@ -64,6 +93,9 @@ bool es_script::Compiler::compile(const piranha::IrPath &path) {
 }
 
 es_script::Compiler::Output es_script::Compiler::execute() {
+    std::lock_guard<std::mutex> lock(s_scriptLock);
+
+    *output() = Output();
     const bool result = m_program.execute();
 
     if (!result) {
@@ -73,12 +105,33 @@ es_script::Compiler::Output es_script::Compiler::execute() {
     return *output();
 }
 
+es_script::Compiler::Output es_script::Compiler::execute(const ParameterBindings &bindings) {
+    if (m_unit == nullptr) return Output();
+
+    std::lock_guard<std::mutex> lock(s_scriptLock);
+
+    piranha::NodeProgram program;
+    m_unit->build(&program);
+    program.initialize();
+
+    *output() = Output();
+    s_bindings = &bindings;
+    program.execute();
+    s_bindings = nullptr;
+
+    const Output result = *output();
+    program.free();
+
+    return result;
+}
+
 void es_script::Compiler::destroy() {
     m_program.free();
     m_compiler->free();
 
     delete m_compiler;
     m_compiler = nullptr;
+    m_unit = nullptr;
 }
 
 void es_script::Compiler::printError(
@@ -13,6 +13,7 @@
 #include "../include/vehicle_node.h"
 #include "../include/transmission_node.h"
 #include "../include/throttle_nodes.h"
+#include "../include/timing_map_node.h"
 
 es_script::LanguageRules::LanguageRules() {
     /* void */
@@ -74,6 +75,8 @@ void es_script::LanguageRules::registerBuiltinNodeTypes() {
         "__engine_sim__transmission_channel", &es_script::ObjectChannel::TransmissionChannel);
     registerBuiltinType<piranha::ChannelNode>(
         "__engine_sim__throttle_channel", &es_script::ObjectChannel::ThrottleChannel);
+    registerBuiltinType<piranha::ChannelNode>(
+        "__engine_sim__timing_map_channel", &es_script::ObjectChannel::TimingMapChannel);
 
     // Literals
     registerBuiltinType<piranha::DefaultLiteralFloatNode>(
@@ -140,8 +143,11 @@ void es_script::LanguageRules::registerBuiltinNodeTypes() {
     registerBuiltinType<SetCylinderHeadNode>("__engine_sim__set_cylinder_head");
     registerBuiltinType<ConnectIgnitionWireNode>("__engine_sim__connect_ignition_wire");
     registerBuiltinType<AddIgnitionModuleNode>("__engine_sim__add_ignition_module");
+    registerBuiltinType<AddTimingMapRowNode>("__engine_sim__add_timing_map_row");
+    registerBuiltinType<SetTimingMapNode>("__engine_sim__set_timing_map");
     registerBuiltinType<k_28inH2ONode>("__engine_sim__k_28inH2O");
     registerBuiltinType<k_CarbNode>("__engine_sim__k_carb");
+    registerBuiltinType<ParameterNode>("__engine_sim__parameter");
     registerBuiltinType<GenerateHarmonicCamLobeNode>("__engine_sim__generate_harmonic_cam_lobe");
     registerBuiltinType<SetApplicationSettingsNode>("__engine_sim__set_application_settings");
     registerBuiltinType<SetVehicleNode>("__engine_sim__set_vehicle");
@@ -162,6 +168,7 @@ void es_script::LanguageRules::registerBuiltinNodeTypes() {
     registerBuiltinType<IntakeNode>("__engine_sim__intake");
     registerBuiltinType<IgnitionModuleNode>("__engine_sim__ignition_module");
     registerBuiltinType<IgnitionWireNode>("__engine_sim__ignition_wire");
+    registerBuiltinType<TimingMapNode>("__engine_sim__timing_map");
     registerBuiltinType<FuelNode>("__engine_sim__fuel");
     registerBuiltinType<ImpulseResponseNode>("__engine_sim__impulse_response");
     registerBuiltinType<StandardValvetrainNode>("__engine_sim__standard_valvetrain");
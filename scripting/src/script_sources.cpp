@@ -0,0 +1,161 @@
+#include "../include/script_sources.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+constexpr uint64_t FnvOffset = 14695981039346656037ull;
+constexpr uint64_t FnvPrime = 1099511628211ull;
+
+uint64_t hashBytes(const char *data, size_t size, uint64_t hash = FnvOffset) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= FnvPrime;
+    }
+
+    return hash;
+}
+
+bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Collects the quoted path after each `import` keyword outside comments
+void findImports(const std::string &source, std::vector<std::string> *imports) {
+    const size_t n = source.size();
+    for (size_t i = 0; i < n; ++i) {
+        if (source[i] == '/' && i + 1 < n && source[i + 1] == '/') {
+            while (i < n && source[i] != '\n') ++i;
+            continue;
+        }
+        else if (source[i] == '/' && i + 1 < n && source[i + 1] == '*') {
+            const size_t end = source.find("*/", i + 2);
+            if (end == std::string::npos) return;
+            i = end + 1;
+            continue;
+        }
+        else if (source[i] == '"') {
+            const size_t end = source.find('"', i + 1);
+            if (end == std::string::npos) return;
+            i = end;
+            continue;
+        }
+
+        if (source.compare(i, 6, "import") != 0) continue;
+        if (i > 0 && isIdentifierChar(source[i - 1])) continue;
+        if (i + 6 < n && isIdentifierChar(source[i + 6])) continue;
+
+        size_t j = i + 6;
+        while (j < n && (source[j] == ' ' || source[j] == '\t')) ++j;
+        if (j >= n || source[j] != '"') continue;
+
+        const size_t end = source.find('"', j + 1);
+        if (end == std::string::npos) return;
+
+        imports->push_back(source.substr(j + 1, end - j - 1));
+        i = end;
+    }
+}
+} /* namespace */
+
+es_script::ScriptSources::ScriptSources() {
+    m_hash = FnvOffset;
+}
+
+es_script::ScriptSources::~ScriptSources() {
+    /* void */
+}
+
+const std::vector<std::string> &es_script::ScriptSources::DefaultSearchPaths() {
+    static const std::vector<std::string> paths = { "../../es/", "../es/", "es/" };
+    return paths;
+}
+
+std::vector<std::string> es_script::ScriptSources::SearchPaths(const std::string &assetPath) {
+    std::vector<std::string> paths = DefaultSearchPaths();
+    paths.push_back((std::filesystem::path(assetPath) / "es").string());
+
+    return paths;
+}
+
+void es_script::ScriptSources::addSearchPath(const std::string &path) {
+    m_searchPaths.push_back(path);
+}
+
+bool es_script::ScriptSources::collect(const std::string &mainScript) {
+    m_files.clear();
+
+    const bool found = collectFile(mainScript);
+
+    m_hash = FnvOffset;
+    for (const File &file : m_files) {
+        m_hash = hashBytes(file.path.data(), file.path.size(), m_hash);
+        m_hash = hashBytes(reinterpret_cast<const char *>(&file.hash), sizeof(file.hash), m_hash);
+    }
+
+    return found;
+}
+
+std::vector<std::string> es_script::ScriptSources::changedSince(const ScriptSources &previous) const {
+    std::vector<std::string> changed;
+    for (const File &file : m_files) {
+        bool same = false;
+        for (const File &old : previous.m_files) {
+            if (old.path == file.path) {
+                same = old.hash == file.hash;
+                break;
+            }
+        }
+
+        if (!same) changed.push_back(file.path);
+    }
+
+    return changed;
+}
+
+bool es_script::ScriptSources::collectFile(const std::string &path) {
+    for (const File &file : m_files) {
+        if (file.path == path) return true;
+    }
+
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) return false;
+
+    const std::string source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    m_files.push_back({ path, hashBytes(source.data(), source.size()) });
+
+    std::vector<std::string> imports;
+    findImports(source, &imports);
+
+    // Unresolved imports are left for the compiler to report
+    for (const std::string &import : imports) {
+        const std::string resolved = resolveImport(path, import);
+        if (!resolved.empty()) {
+            collectFile(resolved);
+        }
+    }
+
+    return true;
+}
+
+std::string es_script::ScriptSources::resolveImport(
+    const std::string &importingFile,
+    const std::string &import) const
+{
+    std::error_code ec;
+    const std::filesystem::path local =
+        std::filesystem::path(importingFile).parent_path() / import;
+    if (std::filesystem::is_regular_file(local, ec)) {
+        return local.lexically_normal().string();
+    }
+
+    for (const std::string &searchPath : m_searchPaths) {
+        const std::filesystem::path candidate = std::filesystem::path(searchPath) / import;
+        if (std::filesystem::is_regular_file(candidate, ec)) {
+            return candidate.lexically_normal().string();
+        }
+    }
+
+    return "";
+}
@@ -8,7 +8,7 @@
 #include <sstream>
 
 AfrCluster::AfrCluster() {
-    m_engine = nullptr;
+    m_simulator = nullptr;
     m_intakeAfrGauge = nullptr;
     m_exhaustAfrGauge = nullptr;
 }
@@ -73,13 +73,13 @@ void AfrCluster::render() {
     const Bounds bottom = m_bounds.verticalSplit(0.0f, 0.5f);
 
     m_intakeAfrGauge->m_bounds = top;
-    m_intakeAfrGauge->m_gauge->m_value = (m_engine != nullptr)
-        ? static_cast<float>(m_engine->getIntakeAfr())
+    m_intakeAfrGauge->m_gauge->m_value = (m_simulator != nullptr)
+        ? static_cast<float>(m_simulator->getSnapshot().intakeAfr)
         : 0.0f;
 
     m_exhaustAfrGauge->m_bounds = bottom;
-    m_exhaustAfrGauge->m_gauge->m_value = (m_engine != nullptr)
-        ? static_cast<float>(m_engine->getExhaustO2()) * 100.0f
+    m_exhaustAfrGauge->m_gauge->m_value = (m_simulator != nullptr)
+        ? static_cast<float>(m_simulator->getSnapshot().exhaustO2) * 100.0f
         : 0.0f;
 
     UiElement::render();
@@ -0,0 +1,339 @@
+#include "../include/allocation_tracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define ATG_ENGINE_SIM_ALLOCATION_BACKTRACES
+#endif
+#endif
+
+namespace {
+const char *TagNames[] = {
+    "other",
+    "simulation",
+    "synthesizer",
+    "ui",
+    "geometry",
+    "debug_trace",
+    "scripting",
+    "loader"
+};
+
+static_assert(
+    sizeof(TagNames) / sizeof(TagNames[0]) == AllocationTracker::TagCount,
+    "every tag needs a name");
+} /* namespace */
+
+const char *AllocationTracker::GetTagName(Tag tag) {
+    return TagNames[static_cast<int>(tag)];
+}
+
+#if defined(ATG_ENGINE_SIM_TRACK_ALLOCATIONS)
+
+namespace {
+constexpr uint32_t NoSite = 0xFFFFFFFF;
+constexpr int MaxSites = 4096;
+constexpr int SkippedFrames = 3;
+
+// Placed in front of every block so the free side knows what to undo
+struct alignas(std::max_align_t) Header {
+    uint64_t size;
+    uint32_t site;
+    uint16_t tag;
+};
+
+struct TagCounters {
+    std::atomic<uint64_t> liveBytes{ 0 };
+    std::atomic<uint64_t> liveAllocations{ 0 };
+    std::atomic<uint64_t> totalBytes{ 0 };
+    std::atomic<uint64_t> totalAllocations{ 0 };
+};
+
+// Open addressed by the hash of the frames; entries are never removed, so
+// a site index stays valid for the life of the process
+struct SiteSlot {
+    std::atomic<bool> used{ false };
+    uint64_t hash = 0;
+    void *frames[AllocationTracker::Site::MaxFrames] = {};
+    int frameCount = 0;
+    AllocationTracker::Tag tag = AllocationTracker::Tag::Other;
+    std::atomic<uint64_t> liveBytes{ 0 };
+    std::atomic<uint64_t> liveAllocations{ 0 };
+    std::atomic<uint64_t> totalAllocations{ 0 };
+};
+
+TagCounters g_tags[AllocationTracker::TagCount];
+SiteSlot g_sites[MaxSites];
+std::atomic_flag g_siteLock = ATOMIC_FLAG_INIT;
+std::atomic<int> g_sampleInterval{ 4096 };
+
+thread_local unsigned long long t_allocationCount = 0;
+thread_local AllocationTracker::Tag t_tag = AllocationTracker::Tag::Other;
+thread_local int t_untilSample = 1;
+thread_local bool t_sampling = false;
+
+uint32_t findSite(void **frames, int frameCount, AllocationTracker::Tag tag) {
+    uint64_t hash = 1469598103934665603ull ^ static_cast<uint64_t>(tag);
+    for (int i = 0; i < frameCount; ++i) {
+        hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+    }
+
+    while (g_siteLock.test_and_set(std::memory_order_acquire)) { /* void */ }
+
+    uint32_t found = NoSite;
+    for (int probe = 0; probe < MaxSites; ++probe) {
+        SiteSlot &slot = g_sites[(hash + probe) % MaxSites];
+        if (!slot.used.load(std::memory_order_relaxed)) {
+            slot.hash = hash;
+            slot.frameCount = frameCount;
+            slot.tag = tag;
+            std::memcpy(slot.frames, frames, sizeof(void *) * frameCount);
+            slot.used.store(true, std::memory_order_release);
+            found = static_cast<uint32_t>((hash + probe) % MaxSites);
+            break;
+        }
+        else if (slot.hash == hash
+            && slot.tag == tag
+            && slot.frameCount == frameCount
+            && std::memcmp(slot.frames, frames, sizeof(void *) * frameCount) == 0)
+        {
+            found = static_cast<uint32_t>((hash + probe) % MaxSites);
+            break;
+        }
+    }
+
+    g_siteLock.clear(std::memory_order_release);
+
+    return found;
+}
+
+uint32_t sampleSite(AllocationTracker::Tag tag) {
+#if defined(ATG_ENGINE_SIM_ALLOCATION_BACKTRACES)
+    const int interval = g_sampleInterval.load(std::memory_order_relaxed);
+    if (interval <= 0 || t_sampling || --t_untilSample > 0) return NoSite;
+
+    t_untilSample = interval;
+    t_sampling = true;
+
+    void *frames[AllocationTracker::Site::MaxFrames + SkippedFrames];
+    const int captured = backtrace(frames, AllocationTracker::Site::MaxFrames + SkippedFrames);
+    const int skipped = std::min(captured, SkippedFrames);
+    const uint32_t site = findSite(frames + skipped, captured - skipped, tag);
+
+    t_sampling = false;
+
+    return site;
+#else
+    (void)tag;
+    return NoSite;
+#endif /* ATG_ENGINE_SIM_ALLOCATION_BACKTRACES */
+}
+
+void *trackedAllocateNoThrow(size_t size) noexcept {
+    ++t_allocationCount;
+
+    Header *header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+    if (header == nullptr) return nullptr;
+
+    const AllocationTracker::Tag tag = t_tag;
+    header->size = size;
+    header->tag = static_cast<uint16_t>(tag);
+    header->site = sampleSite(tag);
+
+    TagCounters &counters = g_tags[header->tag];
+    counters.liveBytes.fetch_add(size, std::memory_order_relaxed);
+    counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    counters.totalBytes.fetch_add(size, std::memory_order_relaxed);
+    counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (header->site != NoSite) {
+        SiteSlot &site = g_sites[header->site];
+        site.liveBytes.fetch_add(size, std::memory_order_relaxed);
+        site.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+        site.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return header + 1;
+}
+
+void *trackedAllocate(size_t size) {
+    void *p = trackedAllocateNoThrow(size);
+    if (p == nullptr) throw std::bad_alloc();
+
+    return p;
+}
+
+void trackedFree(void *p) noexcept {
+    if (p == nullptr) return;
+
+    Header *header = static_cast<Header *>(p) - 1;
+
+    TagCounters &counters = g_tags[header->tag];
+    counters.liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+    if (header->site != NoSite) {
+        SiteSlot &site = g_sites[header->site];
+        site.liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+        site.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::free(header);
+}
+} /* namespace */
+
+void *operator new(size_t size) { return trackedAllocate(size); }
+void *operator new[](size_t size) { return trackedAllocate(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return trackedAllocateNoThrow(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return trackedAllocateNoThrow(size);
+}
+
+void operator delete(void *p) noexcept { trackedFree(p); }
+void operator delete[](void *p) noexcept { trackedFree(p); }
+void operator delete(void *p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void *p, size_t) noexcept { trackedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { trackedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { trackedFree(p); }
+
+AllocationTracker::Scope::Scope(Tag tag) {
+    m_previous = t_tag;
+    t_tag = tag;
+}
+
+AllocationTracker::Scope::~Scope() {
+    t_tag = m_previous;
+}
+
+bool AllocationTracker::IsEnabled() {
+    return true;
+}
+
+unsigned long long AllocationTracker::GetThreadAllocationCount() {
+    return t_allocationCount;
+}
+
+AllocationTracker::Tag AllocationTracker::GetThreadTag() {
+    return t_tag;
+}
+
+void AllocationTracker::GetTagStatistics(Tag tag, TagStatistics *statistics) {
+    const TagCounters &counters = g_tags[static_cast<int>(tag)];
+    statistics->liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+    statistics->liveAllocations = counters.liveAllocations.load(std::memory_order_relaxed);
+    statistics->totalBytes = counters.totalBytes.load(std::memory_order_relaxed);
+    statistics->totalAllocations = counters.totalAllocations.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::SetSampleInterval(int allocations) {
+    g_sampleInterval.store(std::max(0, allocations), std::memory_order_relaxed);
+}
+
+int AllocationTracker::GetSampleInterval() {
+    return g_sampleInterval.load(std::memory_order_relaxed);
+}
+
+int AllocationTracker::GetTopSites(Site *sites, int maxSites) {
+    int count = 0;
+    for (int i = 0; i < MaxSites && maxSites > 0; ++i) {
+        const SiteSlot &slot = g_sites[i];
+        if (!slot.used.load(std::memory_order_acquire)) continue;
+
+        Site site;
+        std::memcpy(site.frames, slot.frames, sizeof(void *) * slot.frameCount);
+        site.frameCount = slot.frameCount;
+        site.tag = slot.tag;
+        site.liveBytes = slot.liveBytes.load(std::memory_order_relaxed);
+        site.liveAllocations = slot.liveAllocations.load(std::memory_order_relaxed);
+        site.totalAllocations = slot.totalAllocations.load(std::memory_order_relaxed);
+
+        // Insertion into the short sorted prefix
+        if (count < maxSites) {
+            sites[count++] = site;
+        }
+        else if (site.liveBytes > sites[count - 1].liveBytes) {
+            sites[count - 1] = site;
+        }
+        else {
+            continue;
+        }
+
+        for (int j = count - 1; j > 0 && sites[j].liveBytes > sites[j - 1].liveBytes; --j) {
+            std::swap(sites[j], sites[j - 1]);
+        }
+    }
+
+    return count;
+}
+
+#else
+
+AllocationTracker::Scope::Scope(Tag tag) {
+    m_previous = tag;
+}
+
+AllocationTracker::Scope::~Scope() {
+    /* void */
+}
+
+bool AllocationTracker::IsEnabled() {
+    return false;
+}
+
+unsigned long long AllocationTracker::GetThreadAllocationCount() {
+    return 0;
+}
+
+AllocationTracker::Tag AllocationTracker::GetThreadTag() {
+    return Tag::Other;
+}
+
+void AllocationTracker::GetTagStatistics(Tag tag, TagStatistics *statistics) {
+    (void)tag;
+    *statistics = TagStatistics();
+}
+
+void AllocationTracker::SetSampleInterval(int allocations) {
+    (void)allocations;
+}
+
+int AllocationTracker::GetSampleInterval() {
+    return 0;
+}
+
+int AllocationTracker::GetTopSites(Site *sites, int maxSites) {
+    (void)sites;
+    (void)maxSites;
+    return 0;
+}
+
+#endif /* ATG_ENGINE_SIM_TRACK_ALLOCATIONS */
+
+std::string AllocationTracker::DescribeSite(const Site &site) {
+    std::string description;
+
+#if defined(ATG_ENGINE_SIM_ALLOCATION_BACKTRACES)
+    char **symbols = backtrace_symbols(const_cast<void *const *>(site.frames), site.frameCount);
+    for (int i = 0; i < site.frameCount; ++i) {
+        if (i > 0) description += " < ";
+        description += (symbols != nullptr) ? symbols[i] : "?";
+    }
+
+    std::free(symbols);
+#else
+    (void)site;
+#endif /* ATG_ENGINE_SIM_ALLOCATION_BACKTRACES */
+
+    return description;
+}
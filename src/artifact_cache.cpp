@@ -0,0 +1,290 @@
+#include "../include/artifact_cache.h"
+
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+constexpr uint64_t FnvOffset = 14695981039346656037ull;
+constexpr uint64_t FnvPrime = 1099511628211ull;
+
+constexpr const char *Extension = ".eac";
+
+struct StoredArtifact {
+    std::filesystem::file_time_type used;
+    uintmax_t size;
+    std::filesystem::path path;
+};
+
+void collect(const std::string &directory, std::vector<StoredArtifact> *artifacts) {
+    std::error_code error;
+    for (auto it = std::filesystem::directory_iterator(directory, error);
+        !error && it != std::filesystem::directory_iterator();
+        it.increment(error))
+    {
+        if (!it->is_regular_file(error) || it->path().extension() != Extension) continue;
+
+        StoredArtifact artifact;
+        artifact.size = it->file_size(error);
+        if (error) continue;
+
+        artifact.used = it->last_write_time(error);
+        if (error) continue;
+
+        artifact.path = it->path();
+        artifacts->push_back(artifact);
+    }
+}
+
+// Write times stand in for use; stamped from the clock rather than left to
+// the filesystem, whose timestamps can be coarser than a burst of writes
+void touch(const std::string &path) {
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+}
+} /* namespace */
+
+ArtifactCache::Key::Key(Kind kind) {
+    m_kind = kind;
+    m_hash = FnvOffset;
+
+    add(static_cast<int64_t>(kind));
+    add(static_cast<int64_t>(EngineSimVersion));
+}
+
+ArtifactCache::Key &ArtifactCache::Key::add(const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        m_hash ^= bytes[i];
+        m_hash *= FnvPrime;
+    }
+
+    return *this;
+}
+
+ArtifactCache::Key &ArtifactCache::Key::add(const std::string &s) {
+    add(static_cast<int64_t>(s.size()));
+    return add(s.data(), s.size());
+}
+
+ArtifactCache::Key &ArtifactCache::Key::add(double value) {
+    return add(&value, sizeof(value));
+}
+
+ArtifactCache::Key &ArtifactCache::Key::add(int64_t value) {
+    return add(&value, sizeof(value));
+}
+
+bool ArtifactCache::Key::addFile(const std::string &path) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    add(static_cast<int64_t>(file.getSize()));
+    add(file.getData(), file.getSize());
+
+    return true;
+}
+
+ArtifactCache::ArtifactCache() {
+    m_maxBytes = DefaultMaxBytes;
+    m_bytes = 0;
+    m_temporaryCount = 0;
+}
+
+ArtifactCache::~ArtifactCache() {
+    /* void */
+}
+
+void ArtifactCache::configure(const std::string &directory, uint64_t maxBytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (directory == m_directory && maxBytes == m_maxBytes) return;
+
+        m_directory = directory;
+        m_maxBytes = maxBytes;
+        m_bytes = 0;
+    }
+
+    if (directory.empty()) return;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    trim();
+
+    ATG_ENGINE_SIM_TRACE(
+        Assets, Event,
+        "artifact_cache directory=%s max_mb=%.1f",
+        directory.c_str(),
+        maxBytes / (1024.0 * 1024.0));
+}
+
+std::string ArtifactCache::getDirectory() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_directory;
+}
+
+uint64_t ArtifactCache::getMaxBytes() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_maxBytes;
+}
+
+bool ArtifactCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return !m_directory.empty();
+}
+
+bool ArtifactCache::load(const Key &key, Artifact *artifact) {
+    artifact->close();
+
+    const std::string path = getPath(key);
+    if (path.empty()) return false;
+
+    bool valid = artifact->m_file.open(path) && artifact->m_file.getSize() >= sizeof(Header);
+    if (valid) {
+        Header header;
+        std::memcpy(&header, artifact->m_file.getData(), sizeof(header));
+        valid = header.magic == Magic
+            && header.version == Version
+            && header.engineSimVersion == EngineSimVersion
+            && header.kind == static_cast<uint32_t>(key.getKind())
+            && header.key == key.getHash()
+            && header.payloadSize == artifact->m_file.getSize() - sizeof(Header);
+        artifact->m_size = static_cast<size_t>(header.payloadSize);
+    }
+
+    if (valid) touch(path);
+    else artifact->close();
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (valid) ++m_statistics.hits;
+    else ++m_statistics.misses;
+
+    return valid;
+}
+
+bool ArtifactCache::store(const Key &key, const void *data, size_t size) {
+    const std::string path = getPath(key);
+    if (path.empty()) return false;
+
+    std::string temporary;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%llu.tmp", m_temporaryCount++);
+        temporary = path + suffix;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.engineSimVersion = EngineSimVersion;
+    header.kind = static_cast<uint32_t>(key.getKind());
+    header.key = key.getHash();
+    header.payloadSize = size;
+
+    const bool written =
+        std::fwrite(&header, sizeof(header), 1, file) == 1
+        && (size == 0 || std::fwrite(data, 1, size, file) == size);
+
+    error.clear();
+    if (std::fclose(file) == 0 && written) {
+        std::filesystem::rename(temporary, path, error);
+    }
+
+    if (!written || error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    touch(path);
+
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        ++m_statistics.writes;
+        m_bytes += sizeof(Header) + size;
+        full = m_bytes > m_maxBytes;
+    }
+
+    if (full) trim();
+    return true;
+}
+
+void ArtifactCache::trim() {
+    std::string directory;
+    uint64_t maxBytes;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        directory = m_directory;
+        maxBytes = m_maxBytes;
+    }
+
+    if (directory.empty()) return;
+
+    std::vector<StoredArtifact> artifacts;
+    collect(directory, &artifacts);
+
+    uint64_t bytes = 0;
+    for (const StoredArtifact &artifact : artifacts) bytes += artifact.size;
+
+    std::sort(artifacts.begin(), artifacts.end(), [](const StoredArtifact &a, const StoredArtifact &b) {
+        return a.used < b.used;
+    });
+
+    unsigned long long evicted = 0;
+    for (size_t i = 0; i < artifacts.size() && bytes > maxBytes; ++i) {
+        std::error_code error;
+        if (!std::filesystem::remove(artifacts[i].path, error)) continue;
+
+        bytes -= artifacts[i].size;
+        ++evicted;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_bytes = bytes;
+    m_statistics.evictions += evicted;
+}
+
+std::string ArtifactCache::getPath(const Key &key) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_directory.empty()) return "";
+
+    char name[64];
+    std::snprintf(
+        name,
+        sizeof(name),
+        "%s-%016llx%s",
+        getKindName(key.getKind()),
+        static_cast<unsigned long long>(key.getHash()),
+        Extension);
+
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+ArtifactCache::Statistics ArtifactCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_statistics;
+}
+
+ArtifactCache &ArtifactCache::Shared() {
+    static ArtifactCache cache;
+    return cache;
+}
+
+const char *ArtifactCache::getKindName(Kind kind) {
+    switch (kind) {
+        case Kind::ImpulseResponse: return "impulse_response";
+        case Kind::CompiledScript: return "compiled_script";
+        default: return "artifact";
+    }
+}
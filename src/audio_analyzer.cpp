@@ -0,0 +1,183 @@
+#include "../include/audio_analyzer.h"
+
+#include "../include/constants.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// Envelope blocks of about 1.5 ms at 44.1 kHz
+constexpr int EnvelopeBlock = 64;
+constexpr double SmoothingTime = 0.25;
+
+float toDecibels(double power) {
+    return static_cast<float>(10.0 * std::log10(std::max(power, 1E-12)));
+}
+} /* namespace */
+
+AudioAnalyzer::AudioAnalyzer() {
+    m_spectrum = nullptr;
+    m_window = nullptr;
+    m_history = nullptr;
+    m_historyFill = 0;
+
+    m_sampleRate = 0;
+    m_smoothing = 1;
+    m_firingFrequency = 0;
+
+    m_power = 0;
+    m_centroid = 0;
+    m_roughness = 0;
+    m_windows = 0;
+    for (int i = 0; i < Harmonics; ++i) m_harmonicPower[i] = 0;
+}
+
+AudioAnalyzer::~AudioAnalyzer() {
+    assert(m_spectrum == nullptr);
+    assert(m_window == nullptr);
+    assert(m_history == nullptr);
+}
+
+void AudioAnalyzer::initialize(float sampleRate) {
+    destroy();
+
+    m_fft.initialize(WindowSize);
+    m_spectrum = new std::complex<float>[WindowSize];
+    m_window = new float[WindowSize];
+    m_history = new float[WindowSize];
+    m_historyFill = 0;
+
+    for (int i = 0; i < WindowSize; ++i) {
+        m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * constants::pi * i / WindowSize));
+        m_history[i] = 0;
+    }
+
+    m_sampleRate = sampleRate;
+    m_smoothing = static_cast<float>(1.0 - std::exp(-HopSize / (SmoothingTime * sampleRate)));
+
+    m_power = 0;
+    m_centroid = 0;
+    m_roughness = 0;
+    m_windows = 0;
+    for (int i = 0; i < Harmonics; ++i) m_harmonicPower[i] = 0;
+
+    m_metrics.reset(Metrics());
+}
+
+void AudioAnalyzer::destroy() {
+    m_fft.destroy();
+
+    delete[] m_spectrum;
+    delete[] m_window;
+    delete[] m_history;
+
+    m_spectrum = nullptr;
+    m_window = nullptr;
+    m_history = nullptr;
+}
+
+void AudioAnalyzer::process(const float *samples, int n) {
+    if (m_history == nullptr) return;
+
+    while (n > 0) {
+        const int copy = std::min(n, WindowSize - m_historyFill);
+        std::memcpy(m_history + m_historyFill, samples, sizeof(float) * copy);
+        m_historyFill += copy;
+        samples += copy;
+        n -= copy;
+
+        if (m_historyFill == WindowSize) {
+            analyzeWindow();
+
+            std::memmove(m_history, m_history + HopSize, sizeof(float) * (WindowSize - HopSize));
+            m_historyFill = WindowSize - HopSize;
+        }
+    }
+}
+
+const AudioAnalyzer::Metrics &AudioAnalyzer::getMetrics() {
+    m_metrics.update();
+    return m_metrics.read();
+}
+
+void AudioAnalyzer::analyzeWindow() {
+    double meanSquare = 0;
+    double envelopeSum = 0, envelopeSquareSum = 0;
+    for (int block = 0; block < WindowSize / EnvelopeBlock; ++block) {
+        double blockSquare = 0;
+        for (int i = 0; i < EnvelopeBlock; ++i) {
+            const float s = m_history[block * EnvelopeBlock + i];
+            blockSquare += s * s;
+        }
+
+        meanSquare += blockSquare;
+
+        const double envelope = std::sqrt(blockSquare / EnvelopeBlock);
+        envelopeSum += envelope;
+        envelopeSquareSum += envelope * envelope;
+    }
+
+    meanSquare /= WindowSize;
+
+    const int blocks = WindowSize / EnvelopeBlock;
+    const double envelopeMean = envelopeSum / blocks;
+    const double envelopeVariance =
+        std::max(0.0, envelopeSquareSum / blocks - envelopeMean * envelopeMean);
+    const double roughness = (envelopeMean > 1E-9) ? std::sqrt(envelopeVariance) / envelopeMean : 0.0;
+
+    for (int i = 0; i < WindowSize; ++i) {
+        m_spectrum[i] = std::complex<float>(m_history[i] * m_window[i], 0.0f);
+    }
+
+    m_fft.forward(m_spectrum);
+
+    const double binWidth = m_sampleRate / WindowSize;
+    double totalPower = 0, weightedMagnitude = 0, totalMagnitude = 0;
+    for (int k = 1; k <= WindowSize / 2; ++k) {
+        const double power = std::norm(m_spectrum[k]);
+        const double magnitude = std::sqrt(power);
+        totalPower += power;
+        weightedMagnitude += magnitude * k * binWidth;
+        totalMagnitude += magnitude;
+    }
+
+    const double centroid = (totalMagnitude > 0) ? weightedMagnitude / totalMagnitude : 0.0;
+
+    // The Hann main lobe spans two bins either side of a tone
+    const double firingFrequency = m_firingFrequency.load(std::memory_order_relaxed);
+    double harmonicPower[Harmonics] = {};
+    for (int h = 0; h < Harmonics; ++h) {
+        const double frequency = firingFrequency * (h + 1);
+        if (frequency <= 0 || frequency >= m_sampleRate / 2) continue;
+
+        const int center = static_cast<int>(std::lround(frequency / binWidth));
+        for (int k = std::max(1, center - 2); k <= std::min(WindowSize / 2, center + 2); ++k) {
+            harmonicPower[h] += std::norm(m_spectrum[k]);
+        }
+
+        harmonicPower[h] = (totalPower > 0) ? harmonicPower[h] / totalPower : 0.0;
+    }
+
+    const double a = (m_windows == 0) ? 1.0 : m_smoothing;
+    m_power += a * (meanSquare - m_power);
+    m_centroid += a * (centroid - m_centroid);
+    m_roughness += a * (roughness - m_roughness);
+    for (int h = 0; h < Harmonics; ++h) {
+        m_harmonicPower[h] += a * (harmonicPower[h] - m_harmonicPower[h]);
+    }
+
+    ++m_windows;
+
+    Metrics metrics;
+    metrics.loudness = toDecibels(m_power);
+    metrics.spectralCentroid = static_cast<float>(m_centroid);
+    metrics.roughness = static_cast<float>(m_roughness);
+    metrics.windows = m_windows;
+    for (int h = 0; h < Harmonics; ++h) {
+        metrics.harmonics[h] = toDecibels(m_harmonicPower[h]);
+    }
+
+    m_metrics.write(metrics);
+}
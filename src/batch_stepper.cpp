@@ -0,0 +1,228 @@
+#include "../include/batch_stepper.h"
+
+#include "../include/control_queue.h"
+#include "../include/cycle_statistics.h"
+#include "../include/debug_trace.h"
+#include "../include/denormals.h"
+#include "../include/engine.h"
+#include "../include/job_system.h"
+#include "../include/simulator.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+BatchStepper::BatchStepper() {
+    m_threads = 1;
+}
+
+BatchStepper::~BatchStepper() {
+    /* void */
+}
+
+void BatchStepper::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.duration = std::max(params.duration, 0.0);
+    m_parameters.measureStart = std::clamp(params.measureStart, 0.0, m_parameters.duration);
+    m_parameters.frameLength = std::max(params.frameLength, 1E-6);
+
+    const int concurrency = JobSystem::Shared().getConcurrency();
+    m_threads = (params.threads > 0)
+        ? std::min(params.threads, concurrency)
+        : concurrency;
+
+    m_lanes.clear();
+}
+
+void BatchStepper::destroy() {
+    m_lanes.clear();
+}
+
+int BatchStepper::addLane(Simulator *simulator, double rpm, double throttle) {
+    Lane lane;
+    lane.simulator = simulator;
+    lane.rpm = rpm;
+    lane.throttle = throttle;
+    m_lanes.push_back(lane);
+
+    return static_cast<int>(m_lanes.size()) - 1;
+}
+
+BatchStepper::Result BatchStepper::run() {
+    const int laneCount = getLaneCount();
+    const long long frames = static_cast<long long>(
+        std::ceil(m_parameters.duration / m_parameters.frameLength - 1E-9));
+    const long long measureFrame = static_cast<long long>(
+        std::ceil(m_parameters.measureStart / m_parameters.frameLength - 1E-9));
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "batch_stepper begin lanes=%d threads=%d frames=%lld",
+        laneCount,
+        m_threads,
+        frames);
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<LaneState> states(laneCount);
+    for (int i = 0; i < laneCount; ++i) {
+        hold(m_lanes[i], &states[i]);
+    }
+
+    // The join at the end of every parallelFor() is the lockstep barrier
+    for (long long frame = 0; frame < frames; ++frame) {
+        const bool measure = frame >= measureFrame;
+        JobSystem::Shared().parallelFor(laneCount, [this, &states, measure](int i) {
+            DenormalScope denormals;
+            advance(m_lanes[i], &states[i], measure);
+        }, JobSystem::Priority::Physics, m_threads);
+    }
+
+    Result result;
+    result.lanes.resize(laneCount);
+    for (int i = 0; i < laneCount; ++i) {
+        result.lanes[i] = finish(m_lanes[i], states[i]);
+        result.steps += states[i].steps;
+    }
+
+    result.reduction = Reduce(result.lanes);
+    result.frames = frames;
+    result.wallTime =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "batch_stepper complete lanes=%d steps=%lld wall_s=%.3f",
+        result.reduction.lanes,
+        result.steps,
+        result.wallTime);
+
+    return result;
+}
+
+BatchStepper::Reduction BatchStepper::Reduce(const std::vector<LaneResult> &lanes) {
+    Reduction reduction;
+    for (const LaneResult &lane : lanes) {
+        if (!lane.valid) continue;
+
+        if (reduction.lanes == 0) {
+            reduction.minTorque = reduction.maxTorque = lane.torque;
+            reduction.maxPower = lane.power;
+            reduction.maxPowerRpm = lane.rpm;
+        }
+        else {
+            reduction.minTorque = std::min(reduction.minTorque, lane.torque);
+            reduction.maxTorque = std::max(reduction.maxTorque, lane.torque);
+            if (lane.power > reduction.maxPower) {
+                reduction.maxPower = lane.power;
+                reduction.maxPowerRpm = lane.rpm;
+            }
+        }
+
+        reduction.meanTorque += lane.torque;
+        reduction.meanPower += lane.power;
+        reduction.meanImep += lane.imep;
+        reduction.meanImepCoefficientOfVariation += lane.imepCoefficientOfVariation;
+        reduction.maxPeakPressure = std::max(reduction.maxPeakPressure, lane.peakPressure);
+        reduction.cycles += lane.cycles;
+        ++reduction.lanes;
+    }
+
+    if (reduction.lanes > 0) {
+        reduction.meanTorque /= reduction.lanes;
+        reduction.meanPower /= reduction.lanes;
+        reduction.meanImep /= reduction.lanes;
+        reduction.meanImepCoefficientOfVariation /= reduction.lanes;
+    }
+
+    return reduction;
+}
+
+bool BatchStepper::WriteCsv(const std::string &path, const Result &result) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    std::fprintf(file, "lane,rpm,torque_nm,power_kw,imep_kpa,imep_cov,peak_pressure_kpa,cycles\n");
+    for (int i = 0; i < static_cast<int>(result.lanes.size()); ++i) {
+        const LaneResult &lane = result.lanes[i];
+        if (!lane.valid) continue;
+
+        std::fprintf(
+            file,
+            "%d,%.0f,%.3f,%.3f,%.3f,%.4f,%.3f,%d\n",
+            i,
+            lane.rpm,
+            units::convert(lane.torque, units::Nm),
+            units::convert(lane.power, units::kW),
+            units::convert(lane.imep, units::kPa),
+            lane.imepCoefficientOfVariation,
+            units::convert(lane.peakPressure, units::kPa),
+            lane.cycles);
+    }
+
+    return std::fclose(file) == 0;
+}
+
+void BatchStepper::hold(const Lane &lane, LaneState *state) const {
+    Simulator *simulator = lane.simulator;
+    Engine *engine = simulator->getEngine();
+    state->speed = std::clamp(
+        units::rpm(lane.rpm), engine->getDynoMinSpeed(), engine->getDynoMaxSpeed());
+
+    // Same controls HeadlessRunner applies for a dyno hold
+    auto apply = [simulator](ControlQueue::Control type, double value) {
+        ControlQueue::Event event;
+        event.control = type;
+        event.value = value;
+        event.immediate = true;
+        simulator->applyControl(event);
+    };
+
+    apply(ControlQueue::Control::Throttle, std::clamp(lane.throttle, 0.0, 1.0));
+    apply(ControlQueue::Control::Ignition, 1.0);
+    apply(ControlQueue::Control::Starter, 0.0);
+    apply(ControlQueue::Control::DynoEnabled, 1.0);
+    apply(ControlQueue::Control::DynoHold, 1.0);
+    apply(ControlQueue::Control::DynoSpeed, state->speed);
+}
+
+void BatchStepper::advance(const Lane &lane, LaneState *state, bool measure) const {
+    Simulator *simulator = lane.simulator;
+
+    // Whole steps only, so every lane covers the same simulated time
+    const double timestep = simulator->getTimestep();
+    const int steps = std::max(static_cast<int>(std::floor(m_parameters.frameLength / timestep + 1E-9)), 1);
+
+    simulator->startFrameSteps(steps);
+    while (simulator->simulateStep()) { /* void */ }
+    simulator->endFrame();
+
+    state->steps += steps;
+    if (measure) {
+        state->torque += simulator->getFilteredDynoTorque();
+        ++state->samples;
+    }
+}
+
+BatchStepper::LaneResult BatchStepper::finish(const Lane &lane, const LaneState &state) const {
+    const CycleStatistics &cycles = lane.simulator->cycleStatistics();
+
+    LaneResult result;
+    result.rpm = state.speed / units::rpm(1.0);
+    result.steps = state.steps;
+    result.simulatedTime = state.steps * lane.simulator->getTimestep();
+    result.imep = cycles.getMeanImep();
+    result.imepCoefficientOfVariation = cycles.getImepCoefficientOfVariation();
+    result.peakPressure = cycles.getMeanPeakPressure();
+    result.cycles = cycles.getCycleCount();
+
+    if (state.samples > 0) {
+        result.torque = state.torque / state.samples;
+        result.power = result.torque * state.speed;
+        result.valid = true;
+    }
+
+    return result;
+}
@@ -0,0 +1,117 @@
+#include "../include/butterworth_low_pass_filter_bank.h"
+
+#include "../include/butterworth_low_pass_filter.h"
+
+#include <algorithm>
+
+ButterworthLowPassFilterBank::ButterworthLowPassFilterBank() {
+    m_groups = nullptr;
+    m_groupCount = 0;
+    m_channelCount = 0;
+
+    m_gain = 0;
+    for (int i = 0; i < 5; ++i) m_a[i] = 0;
+}
+
+ButterworthLowPassFilterBank::~ButterworthLowPassFilterBank() {
+    destroy();
+}
+
+void ButterworthLowPassFilterBank::initialize(int channels) {
+    destroy();
+
+    if (channels <= 0) return;
+
+    m_channelCount = channels;
+    m_groupCount = (channels + Lanes - 1) / Lanes;
+    m_groups = new Group[m_groupCount];
+    for (int g = 0; g < m_groupCount; ++g) {
+        m_groups[g] = Group();
+    }
+}
+
+void ButterworthLowPassFilterBank::destroy() {
+    if (m_groups != nullptr) delete[] m_groups;
+
+    m_groups = nullptr;
+    m_groupCount = 0;
+    m_channelCount = 0;
+}
+
+void ButterworthLowPassFilterBank::setCutoffFrequency(float f_c, float sampleRate) {
+    // Designed by the scalar filter so both round the coefficients alike
+    ButterworthLowPassFilter<float> design;
+    design.setCutoffFrequency(f_c, sampleRate);
+
+    m_gain = design.getGain();
+    for (int i = 0; i < 5; ++i) {
+        m_a[i] = design.getCoefficient(i);
+    }
+}
+
+void ButterworthLowPassFilterBank::process(
+    const float *const *input, float *const *output, int n)
+{
+    if (n <= 0) return;
+
+    const float gain = m_gain;
+    const float a1 = m_a[1], a2 = m_a[2], a3 = m_a[3], a4 = m_a[4];
+
+    for (int g = 0; g < m_groupCount; ++g) {
+        Group &group = m_groups[g];
+        const int first = g * Lanes;
+        const int used = std::min(Lanes, m_channelCount - first);
+
+        alignas(16) float x0[Lanes], x1[Lanes], x2[Lanes], x3[Lanes];
+        alignas(16) float y0[Lanes], y1[Lanes], y2[Lanes], y3[Lanes];
+        alignas(16) float s[Lanes] = {};
+        for (int l = 0; l < Lanes; ++l) {
+            x0[l] = group.x[0][l]; x1[l] = group.x[1][l]; x2[l] = group.x[2][l]; x3[l] = group.x[3][l];
+            y0[l] = group.y[0][l]; y1[l] = group.y[1][l]; y2[l] = group.y[2][l]; y3[l] = group.y[3][l];
+        }
+
+        for (int i = 0; i < n; ++i) {
+            for (int l = 0; l < used; ++l) {
+                s[l] = input[first + l][i];
+            }
+
+            for (int l = 0; l < Lanes; ++l) {
+                const float n_i = gain * (s[l] + 4 * x0[l] + 6 * x1[l] + 4 * x2[l] + x3[l]);
+                const float d = -a1 * y0[l] - a2 * y1[l] - a3 * y2[l] - a4 * y3[l];
+                const float y = n_i + d;
+
+                x3[l] = x2[l]; x2[l] = x1[l]; x1[l] = x0[l]; x0[l] = s[l];
+                y3[l] = y2[l]; y2[l] = y1[l]; y1[l] = y0[l]; y0[l] = y;
+            }
+
+            for (int l = 0; l < used; ++l) {
+                output[first + l][i] = y0[l];
+            }
+        }
+
+        for (int l = 0; l < Lanes; ++l) {
+            group.x[0][l] = x0[l]; group.x[1][l] = x1[l]; group.x[2][l] = x2[l]; group.x[3][l] = x3[l];
+            group.y[0][l] = y0[l]; group.y[1][l] = y1[l]; group.y[2][l] = y2[l]; group.y[3][l] = y3[l];
+        }
+    }
+}
+
+float ButterworthLowPassFilterBank::process(int channel, float sample) {
+    Group &group = m_groups[channel / Lanes];
+    const int l = channel % Lanes;
+
+    const float n = m_gain * (sample + 4 * group.x[0][l] + 6 * group.x[1][l] + 4 * group.x[2][l] + group.x[3][l]);
+    const float d =
+        -m_a[1] * group.y[0][l] - m_a[2] * group.y[1][l] - m_a[3] * group.y[2][l] - m_a[4] * group.y[3][l];
+    const float y = n + d;
+
+    for (int k = 3; k > 0; --k) {
+        group.x[k][l] = group.x[k - 1][l];
+        group.y[k][l] = group.y[k - 1][l];
+    }
+
+    group.x[0][l] = sample;
+    group.y[0][l] = y;
+
+    return y;
+}
@@ -11,6 +11,10 @@ Camshaft::Camshaft() {
     m_crankshaft = nullptr;
     m_lobeAngles = nullptr;
     m_lobeProfile = nullptr;
+    m_bakedLobe = nullptr;
+    m_bakedProfile = nullptr;
+    m_bakedRevision = 0;
+    m_useBakedLobe = false;
     m_lobes = 0;
     m_advance = 0;
     m_baseRadius = 0;
@@ -18,6 +22,7 @@ Camshaft::Camshaft() {
 
 Camshaft::~Camshaft() {
     assert(m_lobeAngles == nullptr);
+    assert(m_bakedLobe == nullptr);
 }
 
 void Camshaft::initialize(const Parameters &params) {
@@ -29,17 +34,30 @@ void Camshaft::initialize(const Parameters &params) {
     m_lobeProfile = params.lobeProfile;
     m_advance = params.advance;
     m_baseRadius = params.baseRadius;
+
+    m_useBakedLobe = params.bakeLobe;
+    if (!shareBakedLobe(params.sharedLobe)) {
+        m_bakedTable.reset(new double[BakedLobeSamples + 1]);
+        m_bakedLobe = m_bakedTable.get();
+        bakeLobeProfile();
+    }
 }
 
 void Camshaft::destroy() {
     delete[] m_lobeAngles;
+    m_bakedTable.reset();
     m_lobeAngles = nullptr;
+    m_bakedLobe = nullptr;
+    m_bakedProfile = nullptr;
 
     m_lobes = 0;
 }
 
 double Camshaft::valveLift(int lobe) const {
-    return sampleLobe(getAngle() + m_lobeAngles[lobe]);
+    const double theta = getAngle() + m_lobeAngles[lobe];
+    return isLobeBaked()
+        ? sampleBakedLobe(theta)
+        : sampleLobe(theta);
 }
 
 double Camshaft::sampleLobe(double theta) const {
@@ -50,6 +68,74 @@ double Camshaft::sampleLobe(double theta) const {
     return m_lobeProfile->sampleTriangle(clampedTheta);
 }
 
+void Camshaft::bakeLobeProfile() {
+    m_bakedProfile = nullptr;
+    if (m_bakedLobe == nullptr || m_lobeProfile == nullptr) return;
+
+    // A shared table stays as the others baked it
+    if (m_bakedTable.use_count() > 1) {
+        m_bakedTable.reset(new double[BakedLobeSamples + 1]);
+        m_bakedLobe = m_bakedTable.get();
+    }
+
+    for (int i = 0; i < BakedLobeSamples; ++i) {
+        m_bakedLobe[i] = sampleLobe(2 * constants::pi * i / BakedLobeSamples);
+    }
+
+    m_bakedLobe[BakedLobeSamples] = m_bakedLobe[0];
+    m_bakedProfile = m_lobeProfile;
+    m_bakedRevision = m_lobeProfile->getRevision();
+}
+
+void Camshaft::setBakedLobe(bool baked) {
+    m_useBakedLobe = baked;
+    if (baked && !isLobeBaked()) {
+        bakeLobeProfile();
+    }
+}
+
+bool Camshaft::isLobeBaked() const {
+    return m_useBakedLobe
+        && m_bakedProfile != nullptr
+        && m_bakedProfile == m_lobeProfile
+        && m_bakedRevision == m_lobeProfile->getRevision();
+}
+
+Camshaft::BakedLobe Camshaft::getBakedLobe() const {
+    BakedLobe lobe;
+    if (m_bakedProfile == nullptr) return lobe;
+
+    lobe.samples = m_bakedTable;
+    lobe.profile = m_bakedProfile;
+    lobe.revision = m_bakedRevision;
+    return lobe;
+}
+
+bool Camshaft::shareBakedLobe(const BakedLobe &lobe) {
+    if (lobe.samples == nullptr
+        || m_lobeProfile == nullptr
+        || lobe.profile != m_lobeProfile
+        || lobe.revision != m_lobeProfile->getRevision())
+    {
+        return false;
+    }
+
+    m_bakedTable = lobe.samples;
+    m_bakedLobe = m_bakedTable.get();
+    m_bakedProfile = lobe.profile;
+    m_bakedRevision = lobe.revision;
+    return true;
+}
+
+double Camshaft::sampleBakedLobe(double theta) const {
+    const double t = theta * (BakedLobeSamples / (2 * constants::pi));
+    const double t0 = std::floor(t);
+    const int i = static_cast<int>(t0) & (BakedLobeSamples - 1);
+    const double s = t - t0;
+
+    return m_bakedLobe[i] + s * (m_bakedLobe[i + 1] - m_bakedLobe[i]);
+}
+
 double Camshaft::getAngle() const {
     const double angle =
         std::fmod((m_crankshaft->getAngle() + m_advance) * 0.5, 2 * constants::pi);
@@ -0,0 +1,129 @@
+#include "../include/chamber_force_batch.h"
+
+#include "../include/combustion_chamber.h"
+#include "../include/constants.h"
+#include "../include/cylinder_bank.h"
+#include "../include/piston.h"
+
+#include <assert.h>
+#include <cmath>
+
+ChamberForceBatch::ChamberForceBatch() {
+    m_chambers = nullptr;
+    m_bodies = nullptr;
+    m_buffer = nullptr;
+
+    m_area = m_dx = m_dy = nullptr;
+    m_frictionCoeff = m_breakawayFriction = m_breakawayVelocity = nullptr;
+    m_coulombVelocity = m_viscousCoeff = nullptr;
+
+    m_pressureDifferential = m_wallForce = m_v_s = m_force = nullptr;
+
+    m_cylinderCount = 0;
+}
+
+ChamberForceBatch::~ChamberForceBatch() {
+    assert(m_buffer == nullptr);
+}
+
+void ChamberForceBatch::initialize(int cylinderCount) {
+    destroy();
+
+    constexpr int Streams = 12;
+    m_cylinderCount = cylinderCount;
+    m_chambers = new CombustionChamber *[cylinderCount];
+    m_bodies = new int[cylinderCount];
+    m_buffer = new double[(size_t)Streams * cylinderCount];
+
+    double *stream = m_buffer;
+    double **streams[] = {
+        &m_area, &m_dx, &m_dy,
+        &m_frictionCoeff, &m_breakawayFriction, &m_breakawayVelocity,
+        &m_coulombVelocity, &m_viscousCoeff,
+        &m_pressureDifferential, &m_wallForce, &m_v_s, &m_force
+    };
+
+    static_assert(sizeof(streams) / sizeof(streams[0]) == Streams, "stream count");
+    for (double **s : streams) {
+        *s = stream;
+        stream += cylinderCount;
+    }
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        m_chambers[i] = nullptr;
+        m_bodies[i] = -1;
+    }
+
+    for (int i = 0; i < Streams * cylinderCount; ++i) m_buffer[i] = 0.0;
+}
+
+void ChamberForceBatch::destroy() {
+    if (m_chambers != nullptr) delete[] m_chambers;
+    if (m_bodies != nullptr) delete[] m_bodies;
+    if (m_buffer != nullptr) delete[] m_buffer;
+
+    m_chambers = nullptr;
+    m_bodies = nullptr;
+    m_buffer = nullptr;
+    m_cylinderCount = 0;
+}
+
+void ChamberForceBatch::setChamber(int cylinder, CombustionChamber *chamber) {
+    const CylinderBank *bank = chamber->getCylinderHead()->getCylinderBank();
+    const CombustionChamber::FrictionModelParams &friction = chamber->m_frictionModel;
+
+    m_chambers[cylinder] = chamber;
+    m_bodies[cylinder] = chamber->getPiston()->m_body.index;
+
+    m_area[cylinder] = (bank->getBore() * bank->getBore() / 4.0) * constants::pi;
+    m_dx[cylinder] = bank->getDx();
+    m_dy[cylinder] = bank->getDy();
+
+    m_frictionCoeff[cylinder] = friction.frictionCoeff;
+    m_breakawayFriction[cylinder] = friction.breakawayFriction;
+    m_breakawayVelocity[cylinder] = friction.breakawayFrictionVelocity * constants::root_2;
+    m_coulombVelocity[cylinder] = friction.breakawayFrictionVelocity / 10;
+    m_viscousCoeff[cylinder] = friction.viscousFrictionCoefficient;
+}
+
+void ChamberForceBatch::apply(atg_scs::SystemState *system) {
+    const int n = m_cylinderCount;
+
+    // The only scattered reads
+    for (int i = 0; i < n; ++i) {
+        const CombustionChamber *chamber = m_chambers[i];
+        const int body = m_bodies[i];
+
+        m_pressureDifferential[i] = chamber->getPistonPressureDifferential();
+        m_wallForce[i] = chamber->getPiston()->calculateCylinderWallForce();
+        m_v_s[i] = system->v_x[body] * m_dx[i] + system->v_y[body] * m_dy[i];
+    }
+
+    // Same terms as CombustionChamber::calculatePistonForce()
+    constexpr double limit = 1E-3;
+    for (int i = 0; i < n; ++i) {
+        const double v_s = m_v_s[i];
+        const double v = std::abs(v_s);
+
+        const double F_coul = m_frictionCoeff[i] * m_wallForce[i];
+        const double F_0 = constants::root_2 * constants::e * (m_breakawayFriction[i] - F_coul);
+        const double F_1 = v / m_breakawayVelocity[i];
+        const double F_2 = std::exp(-F_1 * F_1) * F_1;
+        const double F_3 = F_coul * std::tanh(v / m_coulombVelocity[i]);
+        const double F_4 = m_viscousCoeff[i] * v;
+
+        const double attenuation = std::fmin(v, limit) / limit;
+        const double F = (F_0 * F_2 + F_3 + F_4) * attenuation;
+
+        m_force[i] = -m_area[i] * m_pressureDifferential[i] + ((v_s > 0) ? -F : F);
+    }
+
+    // Applied at the body origin, so there's no torque
+    for (int i = 0; i < n; ++i) {
+        assert(std::isfinite(m_force[i]));
+
+        const int body = m_bodies[i];
+        system->f_x[body] += m_force[i] * m_dx[i];
+        system->f_y[body] += m_force[i] * m_dy[i];
+    }
+}
@@ -0,0 +1,149 @@
+#include "../include/chamber_zones.h"
+
+#include "../include/units.h"
+
+#include <assert.h>
+#include <cmath>
+
+namespace {
+// Douaud-Eyzat end gas ignition delay, tau = A (ON / 100)^3.402 p^-1.7 e^(B / T)
+// with p in atm and tau in seconds
+constexpr double DelayCoefficient = 17.68E-3;
+constexpr double DelayOctaneExponent = 3.402;
+constexpr double DelayPressureExponent = -1.7;
+constexpr double DelayActivationTemperature = 3800.0;
+} /* namespace */
+
+ChamberZones::ChamberZones() {
+    m_buffer = nullptr;
+
+    m_pressure = nullptr;
+    m_temperature = nullptr;
+    m_volume = nullptr;
+    m_exponent = nullptr;
+    m_burnedFraction = nullptr;
+    m_lit = nullptr;
+
+    m_T_u = nullptr;
+    m_P_u = nullptr;
+    m_T_b = nullptr;
+    m_creviceFraction = nullptr;
+    m_knockIntegral = nullptr;
+    m_knockIntensity = nullptr;
+
+    m_delayScale = 0.0;
+    m_knockCount = 0;
+}
+
+ChamberZones::~ChamberZones() {
+    assert(m_buffer == nullptr);
+}
+
+void ChamberZones::initialize(const Parameters &params) {
+    destroy();
+
+    m_parameters = params;
+    m_delayScale =
+        DelayCoefficient * std::pow(params.octaneNumber / 100.0, DelayOctaneExponent);
+
+    constexpr int Streams = 12;
+    const int n = params.chambers;
+    m_buffer = new double[(size_t)Streams * n];
+    for (int i = 0; i < Streams * n; ++i) m_buffer[i] = 0.0;
+
+    double *stream = m_buffer;
+    m_pressure = stream; stream += n;
+    m_temperature = stream; stream += n;
+    m_volume = stream; stream += n;
+    m_exponent = stream; stream += n;
+    m_burnedFraction = stream; stream += n;
+    m_lit = stream; stream += n;
+    m_T_u = stream; stream += n;
+    m_P_u = stream; stream += n;
+    m_T_b = stream; stream += n;
+    m_creviceFraction = stream; stream += n;
+    m_knockIntegral = stream; stream += n;
+    m_knockIntensity = stream;
+
+    m_knockCount = 0;
+}
+
+void ChamberZones::destroy() {
+    if (m_buffer != nullptr) delete[] m_buffer;
+
+    m_buffer = nullptr;
+    m_pressure = m_temperature = m_volume = m_exponent = nullptr;
+    m_burnedFraction = m_lit = nullptr;
+    m_T_u = m_P_u = m_T_b = nullptr;
+    m_creviceFraction = m_knockIntegral = m_knockIntensity = nullptr;
+
+    m_parameters.chambers = 0;
+}
+
+void ChamberZones::setCharge(
+    int i,
+    double pressure,
+    double temperature,
+    double volume,
+    double heatCapacityRatio,
+    double burnedFraction,
+    bool lit)
+{
+    assert(i >= 0 && i < m_parameters.chambers);
+
+    m_pressure[i] = pressure;
+    m_temperature[i] = temperature;
+    m_volume[i] = volume;
+    m_exponent[i] = (heatCapacityRatio - 1) / heatCapacityRatio;
+    m_burnedFraction[i] = burnedFraction;
+    m_lit[i] = lit ? 1.0 : 0.0;
+}
+
+void ChamberZones::evaluate(double dt) {
+    const int n = m_parameters.chambers;
+    const double V_c = m_parameters.creviceVolume;
+    const double T_w = m_parameters.wallTemperature;
+    const double invT_w = (T_w > 0) ? 1 / T_w : 0.0;
+
+    long long knocks = 0;
+    for (int i = 0; i < n; ++i) {
+        const double P = m_pressure[i];
+        const double T = m_temperature[i];
+        const bool lit = m_lit[i] > 0;
+
+        // Crevice gas is at the pressure of the charge but the wall's
+        // temperature, so it holds more moles than its volume suggests
+        const double x_c = (m_volume[i] > 0)
+            ? std::fmin((V_c / m_volume[i]) * T * invT_w, 1.0)
+            : 0.0;
+
+        // The end gas follows the charge until ignition and is compressed
+        // on its own adiabat after
+        const double T_u = (lit && m_P_u[i] > 0)
+            ? m_T_u[i] * std::pow(P / m_P_u[i], m_exponent[i])
+            : T;
+
+        const double x_b = m_burnedFraction[i];
+        const double burned = (1 - x_c) * x_b;
+        const double T_b = (burned > 0)
+            ? std::fmax((T - x_c * T_w - (1 - x_c) * (1 - x_b) * T_u) / burned, T_u)
+            : T_u;
+
+        const double tau = m_delayScale
+            * std::pow(P / units::pressure(1.0, units::atm), DelayPressureExponent)
+            * std::exp(DelayActivationTemperature / T_u);
+        const double previousIntegral = lit ? m_knockIntegral[i] : 0.0;
+        const double integral = lit ? previousIntegral + dt / tau : 0.0;
+        const bool onset = lit && x_b < 1 && previousIntegral < 1 && integral >= 1;
+
+        m_T_u[i] = T_u;
+        m_P_u[i] = P;
+        m_T_b[i] = T_b;
+        m_creviceFraction[i] = x_c;
+        m_knockIntegral[i] = integral;
+        m_knockIntensity[i] = onset ? 1 - x_b : 0.0;
+        knocks += onset ? 1 : 0;
+    }
+
+    m_knockCount += knocks;
+}
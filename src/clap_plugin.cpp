@@ -0,0 +1,345 @@
+#include "../include/plugin_processor.h"
+
+#include "../include/engine_loader.h"
+#include "../include/simulator.h"
+
+#include <clap/clap.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// CLAP entry over PluginProcessor. The engine is compiled when the host
+// activates the plugin, at the host's sample rate, from the script named by
+// ENGINE_SIM_PLUGIN_SCRIPT with ENGINE_SIM_PLUGIN_ASSETS as the repository
+// root. Parameters are automatable at sample offsets; the output is one mono
+// port.
+namespace {
+constexpr int MaxEventsPerBlock = 1024;
+
+struct Plugin {
+    clap_plugin_t plugin;
+    const clap_host_t *host = nullptr;
+
+    EngineLoader::Result engine;
+    PluginProcessor processor;
+    bool active = false;
+
+    // Filled on the audio thread; sized up front so process() never allocates
+    PluginProcessor::Event events[MaxEventsPerBlock];
+};
+
+const char *const Features[] = {
+    CLAP_PLUGIN_FEATURE_INSTRUMENT,
+    CLAP_PLUGIN_FEATURE_SYNTHESIZER,
+    CLAP_PLUGIN_FEATURE_MONO,
+    nullptr
+};
+
+const clap_plugin_descriptor_t Descriptor = {
+    CLAP_VERSION_INIT,
+    "com.engine-sim.engine-sim",
+    "Engine Simulator",
+    "engine-sim",
+    "https://github.com/ange-yaghi/engine-sim",
+    "",
+    "",
+    "0.1.0",
+    "Combustion engine simulation with the throttle and dyno load as parameters",
+    Features
+};
+
+Plugin *self(const clap_plugin_t *plugin) {
+    return static_cast<Plugin *>(plugin->plugin_data);
+}
+
+const char *environment(const char *name, const char *fallback) {
+    const char *value = std::getenv(name);
+    return (value != nullptr && value[0] != '\0') ? value : fallback;
+}
+
+bool isParameterEvent(const clap_event_header_t *header) {
+    return header->space_id == CLAP_CORE_EVENT_SPACE_ID && header->type == CLAP_EVENT_PARAM_VALUE;
+}
+
+bool toParameter(clap_id id, PluginProcessor::Parameter *parameter) {
+    if (id >= static_cast<clap_id>(PluginProcessor::ParameterCount)) return false;
+
+    *parameter = static_cast<PluginProcessor::Parameter>(id);
+    return true;
+}
+
+// Parameters
+
+uint32_t paramsCount(const clap_plugin_t *) {
+    return PluginProcessor::ParameterCount;
+}
+
+bool paramsGetInfo(const clap_plugin_t *, uint32_t index, clap_param_info_t *info) {
+    PluginProcessor::Parameter parameter;
+    if (!toParameter(index, &parameter)) return false;
+
+    std::memset(info, 0, sizeof(clap_param_info_t));
+    info->id = index;
+    info->flags = CLAP_PARAM_IS_AUTOMATABLE;
+    if (parameter != PluginProcessor::Parameter::Throttle
+        && parameter != PluginProcessor::Parameter::Clutch
+        && parameter != PluginProcessor::Parameter::DynoSpeed)
+    {
+        info->flags |= CLAP_PARAM_IS_STEPPED;
+    }
+
+    std::snprintf(info->name, sizeof(info->name), "%s", PluginProcessor::GetParameterName(parameter));
+    PluginProcessor::GetParameterRange(parameter, &info->min_value, &info->max_value, &info->default_value);
+
+    return true;
+}
+
+bool paramsGetValue(const clap_plugin_t *plugin, clap_id id, double *value) {
+    PluginProcessor::Parameter parameter;
+    if (!toParameter(id, &parameter)) return false;
+
+    *value = self(plugin)->processor.getParameter(parameter);
+    return true;
+}
+
+bool paramsValueToText(const clap_plugin_t *, clap_id id, double value, char *text, uint32_t size) {
+    PluginProcessor::Parameter parameter;
+    if (!toParameter(id, &parameter)) return false;
+
+    std::snprintf(text, size, "%.3f", value);
+    return true;
+}
+
+bool paramsTextToValue(const clap_plugin_t *, clap_id id, const char *text, double *value) {
+    PluginProcessor::Parameter parameter;
+    if (!toParameter(id, &parameter)) return false;
+
+    *value = std::atof(text);
+    return true;
+}
+
+void paramsFlush(const clap_plugin_t *plugin, const clap_input_events_t *in, const clap_output_events_t *) {
+    const uint32_t count = in->size(in);
+    for (uint32_t i = 0; i < count; ++i) {
+        const clap_event_header_t *header = in->get(in, i);
+        if (!isParameterEvent(header)) continue;
+
+        const clap_event_param_value_t *event = reinterpret_cast<const clap_event_param_value_t *>(header);
+        PluginProcessor::Parameter parameter;
+        if (toParameter(event->param_id, &parameter)) {
+            self(plugin)->processor.setParameter(parameter, event->value);
+        }
+    }
+}
+
+const clap_plugin_params_t Params = {
+    paramsCount,
+    paramsGetInfo,
+    paramsGetValue,
+    paramsValueToText,
+    paramsTextToValue,
+    paramsFlush
+};
+
+// Audio ports and latency
+
+uint32_t audioPortsCount(const clap_plugin_t *, bool isInput) {
+    return isInput ? 0 : 1;
+}
+
+bool audioPortsGet(const clap_plugin_t *, uint32_t index, bool isInput, clap_audio_port_info_t *info) {
+    if (isInput || index != 0) return false;
+
+    std::memset(info, 0, sizeof(clap_audio_port_info_t));
+    info->id = 0;
+    std::snprintf(info->name, sizeof(info->name), "%s", "Output");
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->channel_count = 1;
+    info->port_type = CLAP_PORT_MONO;
+    info->in_place_pair = CLAP_INVALID_ID;
+
+    return true;
+}
+
+const clap_plugin_audio_ports_t AudioPorts = {
+    audioPortsCount,
+    audioPortsGet
+};
+
+uint32_t latencyGet(const clap_plugin_t *plugin) {
+    return static_cast<uint32_t>(self(plugin)->processor.getLatency());
+}
+
+const clap_plugin_latency_t Latency = {
+    latencyGet
+};
+
+// Plugin
+
+bool pluginInit(const clap_plugin_t *) {
+    return true;
+}
+
+void pluginDeactivate(const clap_plugin_t *plugin) {
+    Plugin *p = self(plugin);
+    if (!p->active) return;
+
+    p->processor.destroy();
+    EngineLoader::Release(&p->engine);
+    p->active = false;
+}
+
+void pluginDestroy(const clap_plugin_t *plugin) {
+    pluginDeactivate(plugin);
+    delete self(plugin);
+}
+
+bool pluginActivate(const clap_plugin_t *plugin, double sampleRate, uint32_t, uint32_t) {
+    Plugin *p = self(plugin);
+    pluginDeactivate(plugin);
+
+    EngineLoader::Request request;
+    request.assetPath = environment("ENGINE_SIM_PLUGIN_ASSETS", ".");
+    request.scriptPath = environment("ENGINE_SIM_PLUGIN_SCRIPT", "assets/main.mr");
+    request.audioSampleRate = sampleRate;
+    request.audioThread = false;
+
+    p->engine = EngineLoader::Load(request);
+    if (p->engine.simulator == nullptr) {
+        EngineLoader::Release(&p->engine);
+        return false;
+    }
+
+    p->processor.initialize(p->engine.simulator, PluginProcessor::Parameters());
+    p->active = true;
+
+    return true;
+}
+
+bool pluginStartProcessing(const clap_plugin_t *) {
+    return true;
+}
+
+void pluginStopProcessing(const clap_plugin_t *) {
+    /* void */
+}
+
+void pluginReset(const clap_plugin_t *) {
+    /* void */
+}
+
+clap_process_status pluginProcess(const clap_plugin_t *plugin, const clap_process_t *process) {
+    Plugin *p = self(plugin);
+    if (!p->active || process->audio_outputs_count < 1) return CLAP_PROCESS_ERROR;
+
+    int eventCount = 0;
+    const clap_input_events_t *in = process->in_events;
+    const uint32_t count = in->size(in);
+    for (uint32_t i = 0; i < count; ++i) {
+        const clap_event_header_t *header = in->get(in, i);
+        if (!isParameterEvent(header)) continue;
+
+        const clap_event_param_value_t *event = reinterpret_cast<const clap_event_param_value_t *>(header);
+        PluginProcessor::Parameter parameter;
+        if (!toParameter(event->param_id, &parameter)) continue;
+
+        // Past the limit, later events still land, just at the block start
+        if (eventCount == MaxEventsPerBlock) {
+            p->processor.setParameter(parameter, event->value);
+            continue;
+        }
+
+        PluginProcessor::Event &e = p->events[eventCount++];
+        e.offset = static_cast<int>(header->time);
+        e.parameter = parameter;
+        e.value = event->value;
+    }
+
+    float *output = process->audio_outputs[0].data32[0];
+    p->processor.process(p->events, eventCount, output, static_cast<int>(process->frames_count));
+
+    for (uint32_t c = 1; c < process->audio_outputs[0].channel_count; ++c) {
+        std::memcpy(
+            process->audio_outputs[0].data32[c],
+            output,
+            sizeof(float) * process->frames_count);
+    }
+
+    return CLAP_PROCESS_CONTINUE;
+}
+
+const void *pluginGetExtension(const clap_plugin_t *, const char *id) {
+    if (std::strcmp(id, CLAP_EXT_PARAMS) == 0) return &Params;
+    if (std::strcmp(id, CLAP_EXT_AUDIO_PORTS) == 0) return &AudioPorts;
+    if (std::strcmp(id, CLAP_EXT_LATENCY) == 0) return &Latency;
+    return nullptr;
+}
+
+void pluginOnMainThread(const clap_plugin_t *) {
+    /* void */
+}
+
+// Factory and entry
+
+uint32_t factoryGetPluginCount(const clap_plugin_factory_t *) {
+    return 1;
+}
+
+const clap_plugin_descriptor_t *factoryGetPluginDescriptor(const clap_plugin_factory_t *, uint32_t index) {
+    return (index == 0) ? &Descriptor : nullptr;
+}
+
+const clap_plugin_t *factoryCreatePlugin(
+    const clap_plugin_factory_t *,
+    const clap_host_t *host,
+    const char *pluginId)
+{
+    if (!clap_version_is_compatible(host->clap_version) || std::strcmp(pluginId, Descriptor.id) != 0) {
+        return nullptr;
+    }
+
+    Plugin *p = new Plugin;
+    p->host = host;
+    p->plugin.desc = &Descriptor;
+    p->plugin.plugin_data = p;
+    p->plugin.init = pluginInit;
+    p->plugin.destroy = pluginDestroy;
+    p->plugin.activate = pluginActivate;
+    p->plugin.deactivate = pluginDeactivate;
+    p->plugin.start_processing = pluginStartProcessing;
+    p->plugin.stop_processing = pluginStopProcessing;
+    p->plugin.reset = pluginReset;
+    p->plugin.process = pluginProcess;
+    p->plugin.get_extension = pluginGetExtension;
+    p->plugin.on_main_thread = pluginOnMainThread;
+
+    return &p->plugin;
+}
+
+const clap_plugin_factory_t Factory = {
+    factoryGetPluginCount,
+    factoryGetPluginDescriptor,
+    factoryCreatePlugin
+};
+
+bool entryInit(const char *) {
+    return true;
+}
+
+void entryDeinit() {
+    /* void */
+}
+
+const void *entryGetFactory(const char *factoryId) {
+    return (std::strcmp(factoryId, CLAP_PLUGIN_FACTORY_ID) == 0) ? &Factory : nullptr;
+}
+} /* namespace */
+
+extern "C" CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    CLAP_VERSION_INIT,
+    entryInit,
+    entryDeinit,
+    entryGetFactory
+};
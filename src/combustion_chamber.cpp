@@ -8,33 +8,64 @@
 #include "../include/exhaust_system.h"
 #include "../include/cylinder_bank.h"
 #include "../include/engine.h"
+#include "../include/flight_recorder.h"
 
+#include <cfloat>
 #include <cmath>
 
+namespace {
+// The Wiebe burn curve, tabulated since it is evaluated every fluid substep
+// of a burn
+constexpr int WiebeSamples = 256;
+
+const double *wiebeTable() {
+    static const double *table = [] {
+        constexpr double a = CombustionChamber::WiebeEfficiency;
+        constexpr double m = CombustionChamber::WiebeForm;
+
+        double *t = new double[WiebeSamples + 1];
+        const double scale = 1.0 / (1.0 - std::exp(-a));
+        for (int i = 0; i <= WiebeSamples; ++i) {
+            const double s = (double)i / WiebeSamples;
+            t[i] = (1.0 - std::exp(-a * std::pow(s, m + 1))) * scale;
+        }
+
+        return t;
+    }();
+
+    return table;
+}
+
+constexpr double ConstantHeatTransferCoefficient = 100.0;
+
+// Woschni's gas velocity over the mean piston speed outside gas exchange
+constexpr double WoschniVelocityFactor = 2.28;
+
+} /* namespace */
+
 CombustionChamber::CombustionChamber() {
-    m_crankcasePressure = 0.0;
+    m_fluid = nullptr;
     m_piston = nullptr;
     m_head = nullptr;
     m_engine = nullptr;
     m_pistonSpeed = nullptr;
     m_pressure = nullptr;
-    m_lit = false;
+    m_pistonSpeedSum = 0;
+    m_peakPressure = 0;
+    m_peakPressureIndex = 0;
     m_litLastFrame = false;
-    m_peakTemperature = 0;
+
+    m_forcePressureSum = 0;
+    m_forcePressureSamples = 0;
+    m_forcePressure = 0;
+    m_forcePressureLatched = false;
 
     m_meanPistonSpeedToTurbulence = nullptr;
-    m_nBurntFuel = 0;
 
-    m_manifoldToRunnerFlowRate = 0;
-    m_primaryToCollectorFlowRate = 0;
     m_cylinderWidthApproximation = 0;
-    m_cylinderCrossSectionSurfaceArea = 0;
 
-    m_lastTimestepTotalExhaustFlow = 0;
-    m_lastTimestepTotalIntakeFlow = 0;
-    m_exhaustFlow = 0;
-    m_exhaustFlowRate = 0;
-    m_intakeFlowRate = 0;
+    m_exhaustValveLift = 0;
+    m_intakeValveLift = 0;
 
     m_fuel = nullptr;
 }
@@ -45,12 +76,16 @@ CombustionChamber::~CombustionChamber() {
 }
 
 void CombustionChamber::initialize(const Parameters &params) {
+    assert(m_fluid != nullptr);
+
     m_piston = params.PistonPtr;
     m_head = params.Head;
     m_fuel = params.FuelPtr;
-    m_crankcasePressure = params.CrankcasePressure;
+    m_fluid->crankcasePressure = params.CrankcasePressure;
     m_meanPistonSpeedToTurbulence = params.MeanPistonSpeedToTurbulence;
 
+    seedRandom(0);
+
     m_pistonSpeed = new double[StateSamples];
     m_pressure = new double[StateSamples];
     for (int i = 0; i < StateSamples; ++i) {
@@ -58,18 +93,42 @@ void CombustionChamber::initialize(const Parameters &params) {
         m_pressure[i] = 0;
     }
 
+    m_pistonSpeedSum = 0;
+    m_peakPressure = 0;
+    m_peakPressureIndex = 0;
+
+    updateGeometry();
+}
+
+void CombustionChamber::updateGeometry() {
     Intake *intake = m_head->getIntake(m_piston->getCylinderIndex());
     ExhaustSystem *exhaust = m_head->getExhaustSystem(m_piston->getCylinderIndex());
 
-    m_manifoldToRunnerFlowRate = intake->getRunnerFlowRate();
-    m_primaryToCollectorFlowRate = exhaust->getPrimaryFlowRate();
-
-    const double bore_r = m_head->getCylinderBank()->getBore() / 2.0;
-    m_cylinderCrossSectionSurfaceArea = constants::pi * bore_r * bore_r;
-    m_cylinderWidthApproximation = std::sqrt(m_cylinderCrossSectionSurfaceArea);
+    m_fluid->manifoldToRunnerFlowRate = intake->getRunnerFlowRate();
+    m_fluid->primaryToCollectorFlowRate = exhaust->getPrimaryFlowRate();
+    m_fluid->plenum = &intake->m_system;
+    m_fluid->collector = exhaust->getSystem();
+    m_fluid->plenumCrossSectionArea = intake->getPlenumCrossSectionArea();
+    m_fluid->intakeRunnerCrossSectionArea = m_head->getIntakeRunnerCrossSectionArea();
+    m_fluid->exhaustRunnerCrossSectionArea = m_head->getExhaustRunnerCrossSectionArea();
+    m_fluid->collectorCrossSectionArea = exhaust->getCollectorCrossSectionArea();
+    m_fluid->intakeVelocityDecay = intake->getVelocityDecay();
+    m_fluid->exhaustVelocityDecay = exhaust->getVelocityDecay();
+    m_fluid->blowbyK = m_piston->getBlowbyK();
 
-    const double height = getVolume() / m_cylinderCrossSectionSurfaceArea;
-    m_system.setGeometry(
+    const CylinderBank *bank = m_head->getCylinderBank();
+    const double bore_r = bank->getBore() / 2.0;
+    m_fluid->bore = bank->getBore();
+    m_fluid->boreSurfaceArea = bank->boreSurfaceArea();
+    m_fluid->cylinderCrossSectionSurfaceArea = constants::pi * bore_r * bore_r;
+    m_cylinderWidthApproximation = std::sqrt(m_fluid->cylinderCrossSectionSurfaceArea);
+
+    m_fluid->volume = getVolume();
+    m_fluid->volumeRate = 0;
+    updateHeatTransfer();
+
+    const double height = m_fluid->volume / m_fluid->cylinderCrossSectionSurfaceArea;
+    m_fluid->system.setGeometry(
         m_cylinderWidthApproximation,
         height,
         1.0,
@@ -79,13 +138,30 @@ void CombustionChamber::initialize(const Parameters &params) {
     const double intakeRunnerWidth = std::sqrt(intakeRunnerCrossSection);
     const double manifoldRunnerLength = intake->getRunnerLength();
     const double manifoldRunnerVolume = intakeRunnerCrossSection * manifoldRunnerLength;
-    const double totalIntakeRunnerVolume = m_head->getIntakeRunnerVolume() + manifoldRunnerVolume;
+    const int intakeSegments = intake->getRunnerSegments();
+
+    // A segmented manifold runner keeps one segment's share of its volume in
+    // the lumped runner, next to the port, and the rest in the pipe
+    const double lumpedManifoldRunnerVolume = (intakeSegments > 0)
+        ? manifoldRunnerVolume / (intakeSegments + 1)
+        : manifoldRunnerVolume;
+    const double totalIntakeRunnerVolume = m_head->getIntakeRunnerVolume() + lumpedManifoldRunnerVolume;
     const double overallIntakeRunnerLength = totalIntakeRunnerVolume / intakeRunnerCrossSection;
-    m_intakeRunnerAndManifold.initialize(
+    m_fluid->intakePipe = nullptr;
+    if (intakeSegments > 0) {
+        PipeSegments::Parameters pipeParams;
+        pipeParams.segments = intakeSegments;
+        pipeParams.length = manifoldRunnerLength * intakeSegments / (intakeSegments + 1);
+        pipeParams.crossSectionArea = intakeRunnerCrossSection;
+        m_intakePipe.initialize(pipeParams);
+        m_fluid->intakePipe = &m_intakePipe;
+    }
+
+    m_fluid->intakeRunnerAndManifold.initialize(
         units::pressure(1.0, units::atm),
         totalIntakeRunnerVolume,
         units::celcius(25.0));
-    m_intakeRunnerAndManifold.setGeometry(
+    m_fluid->intakeRunnerAndManifold.setGeometry(
         overallIntakeRunnerLength,
         intakeRunnerWidth,
         1.0,
@@ -96,13 +172,27 @@ void CombustionChamber::initialize(const Parameters &params) {
     const double exhaustTubeLength =
         exhaust->getPrimaryTubeLength() + m_head->getHeaderPrimaryLength(m_piston->getCylinderIndex());
     const double exhaustTubeVolume = exhaustRunnerCrossSection * exhaustTubeLength;
-    const double totalExhaustRunnerVolume = m_head->getExhaustRunnerVolume() + exhaustTubeVolume;
+    const int exhaustSegments = exhaust->getPrimarySegments();
+    const double lumpedExhaustTubeVolume = (exhaustSegments > 0)
+        ? exhaustTubeVolume / (exhaustSegments + 1)
+        : exhaustTubeVolume;
+    const double totalExhaustRunnerVolume = m_head->getExhaustRunnerVolume() + lumpedExhaustTubeVolume;
     const double overallExhaustRunnerLength = totalExhaustRunnerVolume / exhaustRunnerCrossSection;
-    m_exhaustRunnerAndPrimary.initialize(
+    m_fluid->exhaustPipe = nullptr;
+    if (exhaustSegments > 0) {
+        PipeSegments::Parameters pipeParams;
+        pipeParams.segments = exhaustSegments;
+        pipeParams.length = exhaustTubeLength * exhaustSegments / (exhaustSegments + 1);
+        pipeParams.crossSectionArea = exhaustRunnerCrossSection;
+        m_exhaustPipe.initialize(pipeParams);
+        m_fluid->exhaustPipe = &m_exhaustPipe;
+    }
+
+    m_fluid->exhaustRunnerAndPrimary.initialize(
         units::pressure(1.0, units::atm),
         totalExhaustRunnerVolume,
         units::celcius(25.0));
-    m_exhaustRunnerAndPrimary.setGeometry(
+    m_fluid->exhaustRunnerAndPrimary.setGeometry(
         overallExhaustRunnerLength,
         exhaustRunnerWidth,
         1.0,
@@ -115,6 +205,9 @@ void CombustionChamber::destroy() {
 
     m_pistonSpeed = nullptr;
     m_pressure = nullptr;
+
+    m_intakePipe.destroy();
+    m_exhaustPipe.destroy();
 }
 
 double CombustionChamber::getVolume() const {
@@ -139,24 +232,11 @@ double CombustionChamber::pistonSpeed() const {
 }
 
 double CombustionChamber::calculateMeanPistonSpeed() const {
-    double avg = 0;
-    for (int i = 0; i < StateSamples; ++i) {
-        avg += m_pistonSpeed[i];
-    }
-
-    avg /= StateSamples;
-    return avg;
+    return m_pistonSpeedSum / StateSamples;
 }
 
 double CombustionChamber::calculateFiringPressure() const {
-    double firingPressure = 0;
-    for (int i = 0; i < StateSamples; ++i) {
-        if (m_pressure[i] > firingPressure) {
-            firingPressure = m_pressure[i];
-        }
-    }
-
-    return firingPressure;
+    return m_peakPressure;
 }
 
 bool CombustionChamber::popLitLastFrame() {
@@ -167,25 +247,25 @@ bool CombustionChamber::popLitLastFrame() {
 }
 
 void CombustionChamber::ignite() {
-    if (!m_lit) {
-        if (m_system.mix().p_fuel == 0) return;
+    if (!m_fluid->lit) {
+        if (m_fluid->system.mix().p_fuel == 0) return;
 
-        const double afr = m_system.mix().p_o2 / m_system.mix().p_fuel;
+        const double afr = m_fluid->system.mix().p_o2 / m_fluid->system.mix().p_fuel;
         const double equivalenceRatio = afr / m_fuel->getMolecularAfr();
         if (equivalenceRatio < 0.5) return;
         else if (equivalenceRatio > 1.9) return;
 
-        const double idealInert = m_system.mix().p_o2 / 0.7;
-        const double dilution = (m_system.mix().p_inert / idealInert) - 1;
-
-        m_flameEvent.lastVolume = getVolume();
-        m_flameEvent.travel_x = 0;
-        m_flameEvent.travel_y = 0;
-        m_flameEvent.lit_n = 0;
-        m_flameEvent.total_n = m_system.n();
-        m_flameEvent.percentageLit = 0;
-        m_flameEvent.globalMix = m_system.mix();
-        m_lit = true;
+        const double idealInert = m_fluid->system.mix().p_o2 / 0.7;
+        const double dilution = (m_fluid->system.mix().p_inert / idealInert) - 1;
+
+        m_fluid->flameEvent.lastVolume = getVolume();
+        m_fluid->flameEvent.travel_x = 0;
+        m_fluid->flameEvent.travel_y = 0;
+        m_fluid->flameEvent.lit_n = 0;
+        m_fluid->flameEvent.total_n = m_fluid->system.n();
+        m_fluid->flameEvent.percentageLit = 0;
+        m_fluid->flameEvent.globalMix = m_fluid->system.mix();
+        m_fluid->lit = true;
         m_litLastFrame = true;
 
         const double randomness =
@@ -208,156 +288,315 @@ void CombustionChamber::ignite() {
                 * clamp(1 - dilution / maxDilutionEffect));
         const double rand_s =
             lowEfficiencyAttenuation
-            * ((1 - randomness) + randomness * ((double)rand() / RAND_MAX));
+            * ((1 - randomness) + randomness * m_random.uniform());
         const double efficiencyAttenuation =
             (mixingFactor * rand_s + (1 - mixingFactor));
-        m_flameEvent.efficiency =
-            efficiencyAttenuation * maxBurningEfficiency;
-        m_flameEvent.flameSpeed = m_fuel->flameSpeed(
+        m_fluid->flameEvent.efficiency =
+            efficiencyAttenuation * maxBurningEfficiency * (1 - m_fluid->creviceFraction);
+        m_fluid->flameEvent.flameSpeed = m_fuel->flameSpeed(
             turbulence,
             afr,
-            m_system.temperature(),
-            m_system.pressure(),
+            m_fluid->system.temperature(),
+            m_fluid->system.pressure(),
             calculateFiringPressure(),
             units::pressure(160, units::psi));
+
+        // The flame front is done once it has crossed both the bore radius
+        // and the chamber height at ignition
+        CylinderBank *bank = m_head->getCylinderBank();
+        const double travel = std::fmax(
+            bank->getBore() / 2,
+            m_fluid->flameEvent.lastVolume / bank->boreSurfaceArea());
+        m_fluid->flameEvent.burnDuration = (m_fluid->flameEvent.flameSpeed > 0)
+            ? travel / m_fluid->flameEvent.flameSpeed
+            : 0.0;
+        m_fluid->flameEvent.burnTime = 0;
+        m_fluid->flameEvent.burnedFraction = 0;
+        m_fluid->knockIntensity = 0;
     }
 }
 
+void CombustionChamber::autoignite(double intensity) {
+    if (!m_fluid->lit) return;
+
+    const double remaining = m_fluid->flameEvent.total_n - m_fluid->flameEvent.lit_n;
+    if (remaining > 0) {
+        burn(remaining);
+        m_fluid->flameEvent.percentageLit = 1;
+    }
+
+    m_fluid->knockIntensity = intensity;
+    m_fluid->lit = false;
+}
+
 void CombustionChamber::update(double dt) {
-    m_system.setVolume(getVolume());
+    const double previousVolume = m_fluid->volume;
+    m_fluid->volume = getVolume();
+    m_fluid->volumeRate = (dt > 0) ? (m_fluid->volume - previousVolume) / dt : 0.0;
+    m_fluid->system.setVolume(m_fluid->volume);
 
     updateCycleStates();
+    updateHeatTransfer();
+
+    FluidState &fluid = *m_fluid;
+    const double cylinderHeight = fluid.volume / fluid.cylinderCrossSectionSurfaceArea;
+    fluid.cylinderFlowArea = fluid.volume / cylinderHeight;
+    fluid.wallHeatConductance = fluid.wallArea * fluid.heatTransferCoefficient;
+
+    const int cylinder = m_piston->getCylinderIndex();
+    m_intakeValveLift = m_head->intakeValveLift(cylinder);
+    m_exhaustValveLift = m_head->exhaustValveLift(cylinder);
+    m_fluid->intakeFlowRate = m_head->intakeFlowRateAtLift(m_intakeValveLift);
+    m_fluid->exhaustFlowRate = m_head->exhaustFlowRateAtLift(m_exhaustValveLift);
+}
+
+void CombustionChamber::seedRandom(uint64_t seed) {
+    m_random.seed(seed, m_piston->getCylinderBank()->getIndex() * 64 + m_piston->getCylinderIndex());
+}
+
+double CombustionChamber::calculateRunnerSignalTime() const {
+    const double intakeLength =
+        m_fluid->intakeRunnerAndManifold.volume() / m_head->getIntakeRunnerCrossSectionArea();
+    const double exhaustLength =
+        m_fluid->exhaustRunnerAndPrimary.volume() / m_head->getExhaustRunnerCrossSectionArea();
+
+    const double intakeSpeed = m_fluid->intakeRunnerAndManifold.c() + std::sqrt(
+        m_fluid->intakeRunnerAndManifold.velocity_x() * m_fluid->intakeRunnerAndManifold.velocity_x()
+        + m_fluid->intakeRunnerAndManifold.velocity_y() * m_fluid->intakeRunnerAndManifold.velocity_y());
+    const double exhaustSpeed = m_fluid->exhaustRunnerAndPrimary.c() + std::sqrt(
+        m_fluid->exhaustRunnerAndPrimary.velocity_x() * m_fluid->exhaustRunnerAndPrimary.velocity_x()
+        + m_fluid->exhaustRunnerAndPrimary.velocity_y() * m_fluid->exhaustRunnerAndPrimary.velocity_y());
+
+    double t = DBL_MAX;
+    if (intakeSpeed > 0) t = std::fmin(t, intakeLength / intakeSpeed);
+    if (exhaustSpeed > 0) t = std::fmin(t, exhaustLength / exhaustSpeed);
+
+    return t;
+}
+
+double CombustionChamber::calculateLastTimestepFlowFraction() const {
+    const double n_intake = std::fmin(m_fluid->intakeRunnerAndManifold.n(), m_fluid->system.n());
+    const double n_exhaust = std::fmin(m_fluid->system.n(), m_fluid->exhaustRunnerAndPrimary.n());
+
+    double fraction = 0;
+    if (n_intake > 0) fraction = std::fmax(fraction, std::abs(m_fluid->lastTimestepTotalIntakeFlow) / n_intake);
+    if (n_exhaust > 0) fraction = std::fmax(fraction, std::abs(m_fluid->lastTimestepTotalExhaustFlow) / n_exhaust);
 
-    m_intakeFlowRate = m_head->intakeFlowRate(m_piston->getCylinderIndex());
-    m_exhaustFlowRate = m_head->exhaustFlowRate(m_piston->getCylinderIndex());
+    return fraction;
 }
 
-void CombustionChamber::flow(double dt) {
-    if (m_system.temperature() > m_peakTemperature) {
-        m_peakTemperature = m_system.temperature();
+void CombustionChamber::flowCylinder(double dt) {
+    if (isSealed()) {
+        flowSealedCylinder(dt);
+        return;
     }
 
-    const double volume = getVolume();
-    const double cylinderHeight = volume / m_cylinderCrossSectionSurfaceArea;
-    const double cylinderSurfaceArea =
-        cylinderHeight * constants::pi * m_head->getCylinderBank()->getBore()
-        + m_cylinderCrossSectionSurfaceArea * 2;
+    GasSystem::FlowState intakeValve, exhaustValve;
+    prepareIntakeValveFlow(dt, &intakeValve);
+    applyIntakeValveFlow(intakeValve, GasSystem::flowRate(intakeValve), &exhaustValve);
+    applyExhaustValveFlow(exhaustValve, GasSystem::flowRate(exhaustValve));
+}
 
-    const double dT = units::celcius(90.0) - m_system.temperature();
+void CombustionChamber::flowSealedCylinder(double dt) {
+    FluidState &fluid = *m_fluid;
+    exchangeHeat(dt);
 
-    m_system.changeEnergy(dT * cylinderSurfaceArea * 100 * dt);
-    m_system.flow(m_piston->getBlowbyK(), dt, m_crankcasePressure, units::celcius(25.0));
+    // What the zero flows through both valves leave behind
+    fluid.intakeFlow = 0;
+    fluid.exhaustFlow = 0;
+    fluid.intakeRunnerAndManifold.dissipateExcessVelocity();
+    fluid.system.dissipateExcessVelocity();
+    fluid.exhaustRunnerAndPrimary.dissipateExcessVelocity();
+}
 
-    Intake *intake = m_head->getIntake(m_piston->getCylinderIndex());
-    ExhaustSystem *exhaust = m_head->getExhaustSystem(m_piston->getCylinderIndex());
+void CombustionChamber::updateHeatTransfer() {
+    FluidState &fluid = *m_fluid;
+
+    const double cylinderHeight = fluid.volume / fluid.cylinderCrossSectionSurfaceArea;
+    fluid.wallArea =
+        cylinderHeight * constants::pi * fluid.bore
+        + fluid.cylinderCrossSectionSurfaceArea * 2;
+
+    if (fluid.heatTransferModel == HeatTransferModel::Woschni) {
+        // h = 3.26 B^-0.2 p^0.8 T^-0.55 w^0.8 in m, kPa, K and m/s
+        const double w = WoschniVelocityFactor * calculateMeanPistonSpeed();
+        fluid.heatTransferCoefficient =
+            3.26
+            * std::pow(fluid.bore / units::m, -0.2)
+            * std::pow(fluid.system.pressure() / units::kPa, 0.8)
+            * std::pow(fluid.system.temperature() / units::K, -0.55)
+            * std::pow(w / (units::m / units::sec), 0.8);
+    }
+    else {
+        fluid.heatTransferCoefficient = ConstantHeatTransferCoefficient;
+    }
+}
 
-    const double start_n = m_system.n();
+void CombustionChamber::exchangeHeat(double dt) {
+    FluidState &fluid = *m_fluid;
+    if (fluid.system.temperature() > fluid.peakTemperature) {
+        fluid.peakTemperature = fluid.system.temperature();
+    }
+
+    const double dT = CombustionChamber::WallTemperature - fluid.system.temperature();
+
+    fluid.system.changeEnergy(dT * fluid.wallHeatConductance * dt);
+    fluid.system.flow(fluid.blowbyK, dt, fluid.crankcasePressure, units::celcius(25.0));
+}
+
+void CombustionChamber::prepareIntakeValveFlow(double dt, GasSystem::FlowState *intakeValve) {
+    FluidState &fluid = *m_fluid;
+    exchangeHeat(dt);
 
     GasSystem::FlowParameters flowParams;
     flowParams.dt = dt;
 
-    flowParams.k_flow = m_manifoldToRunnerFlowRate;
-    flowParams.crossSectionArea_0 = intake->getPlenumCrossSectionArea();
-    flowParams.crossSectionArea_1 = m_head->getIntakeRunnerCrossSectionArea();
+    flowParams.k_flow = fluid.intakeFlowRate;
+    flowParams.crossSectionArea_0 = fluid.intakeRunnerCrossSectionArea;
+    flowParams.crossSectionArea_1 = fluid.cylinderFlowArea;
     flowParams.direction_x = 1.0;
     flowParams.direction_y = 0.0;
-    flowParams.system_0 = &intake->m_system;
-    flowParams.system_1 = &m_intakeRunnerAndManifold;
-    GasSystem::flow(flowParams);
+    flowParams.system_0 = &fluid.intakeRunnerAndManifold;
+    flowParams.system_1 = &fluid.system;
+    GasSystem::beginFlow(flowParams, intakeValve);
+}
 
-    m_intakeRunnerAndManifold.dissipateExcessVelocity();
+void CombustionChamber::applyIntakeValveFlow(
+    const GasSystem::FlowState &intakeValve,
+    double flowRate,
+    GasSystem::FlowState *exhaustValve)
+{
+    FluidState &fluid = *m_fluid;
+    fluid.intakeFlow = GasSystem::endFlow(intakeValve, flowRate);
 
-    flowParams.k_flow = m_intakeFlowRate;
-    flowParams.crossSectionArea_0 = m_head->getIntakeRunnerCrossSectionArea();
-    flowParams.crossSectionArea_1 = volume / cylinderHeight;
-    flowParams.direction_x = 1.0;
-    flowParams.direction_y = 0.0;
-    flowParams.system_0 = &m_intakeRunnerAndManifold;
-    flowParams.system_1 = &m_system;
-    const double intakeFlow = GasSystem::flow(flowParams);
+    fluid.intakeRunnerAndManifold.dissipateExcessVelocity();
+    fluid.system.dissipateExcessVelocity();
 
-    m_intakeRunnerAndManifold.dissipateExcessVelocity();
-    m_system.dissipateExcessVelocity();
+    GasSystem::FlowParameters flowParams;
+    flowParams.dt = intakeValve.dt;
 
-    flowParams.k_flow = m_exhaustFlowRate;
-    flowParams.crossSectionArea_0 = volume / cylinderHeight;
-    flowParams.crossSectionArea_1 = m_head->getExhaustRunnerCrossSectionArea();
+    flowParams.k_flow = fluid.exhaustFlowRate;
+    flowParams.crossSectionArea_0 = fluid.cylinderFlowArea;
+    flowParams.crossSectionArea_1 = fluid.exhaustRunnerCrossSectionArea;
     flowParams.direction_x = 1.0;
     flowParams.direction_y = 0.0;
-    flowParams.system_0 = &m_system;
-    flowParams.system_1 = &m_exhaustRunnerAndPrimary;
-    const double exhaustFlow = GasSystem::flow(flowParams);
+    flowParams.system_0 = &fluid.system;
+    flowParams.system_1 = &fluid.exhaustRunnerAndPrimary;
+    GasSystem::beginFlow(flowParams, exhaustValve);
+}
 
-    m_system.dissipateExcessVelocity();
-    m_exhaustRunnerAndPrimary.dissipateExcessVelocity();
+void CombustionChamber::applyExhaustValveFlow(const GasSystem::FlowState &exhaustValve, double flowRate) {
+    m_fluid->exhaustFlow = GasSystem::endFlow(exhaustValve, flowRate);
 
-    flowParams.k_flow = m_primaryToCollectorFlowRate;
-    flowParams.crossSectionArea_0 = m_head->getExhaustRunnerCrossSectionArea();
-    flowParams.crossSectionArea_1 = exhaust->getCollectorCrossSectionArea();
-    flowParams.direction_x = 1.0;
-    flowParams.direction_y = 0.0;
-    flowParams.system_0 = &m_exhaustRunnerAndPrimary;
-    flowParams.system_1 = exhaust->getSystem();
-    GasSystem::flow(flowParams);
+    m_fluid->system.dissipateExcessVelocity();
+    m_fluid->exhaustRunnerAndPrimary.dissipateExcessVelocity();
+}
+
+void CombustionChamber::finishFlow(double dt) {
+    FluidState &fluid = *m_fluid;
+
+    const double volume = fluid.volume;
+    const double intakeFlow = fluid.intakeFlow;
+    const double exhaustFlow = fluid.exhaustFlow;
 
-    m_intakeRunnerAndManifold.updateVelocity(dt, intake->getVelocityDecay());
-    m_system.updateVelocity(dt, 0.5);
-    m_exhaustRunnerAndPrimary.updateVelocity(dt, exhaust->getVelocityDecay());
+    fluid.intakeRunnerAndManifold.updateVelocity(dt, fluid.intakeVelocityDecay);
+    fluid.system.updateVelocity(dt, 0.5);
+    fluid.exhaustRunnerAndPrimary.updateVelocity(dt, fluid.exhaustVelocityDecay);
 
-    if (std::abs(intakeFlow) > 1E-9 && m_lit) {
-        m_lit = false;
+    if (std::abs(intakeFlow) > 1E-9 && fluid.lit) {
+        fluid.lit = false;
     }
 
-    m_exhaustFlow = exhaustFlow;
-    m_lastTimestepTotalExhaustFlow += exhaustFlow;
-    m_lastTimestepTotalIntakeFlow += intakeFlow;
+    fluid.lastTimestepTotalExhaustFlow += exhaustFlow;
+    fluid.lastTimestepTotalIntakeFlow += intakeFlow;
 
-    if (m_lit) {
-        CylinderBank *bank = m_head->getCylinderBank();
-        const double totalTravel_x = bank->getBore() / 2;
-        const double totalTravel_y = volume / bank->boreSurfaceArea();
-        const double expansion = volume / m_flameEvent.lastVolume;
-        const double lastTravel_x = m_flameEvent.travel_x;
-        const double lastTravel_y = m_flameEvent.travel_y * expansion;
-        const double flameSpeed = m_flameEvent.flameSpeed;
-
-        m_flameEvent.travel_x =
-            std::fmin(lastTravel_x + dt * flameSpeed, totalTravel_x);
-        m_flameEvent.travel_y =
-            std::fmin(lastTravel_y + dt * flameSpeed, totalTravel_y);
-
-        if (lastTravel_x < m_flameEvent.travel_x || lastTravel_y < m_flameEvent.travel_y) {
-            const double burnedVolume =
-                m_flameEvent.travel_x * m_flameEvent.travel_x
-                * constants::pi * m_flameEvent.travel_y;
-            const double prevBurnedVolume =
-                lastTravel_x * lastTravel_x * constants::pi * lastTravel_y;
-            const double litVolume = burnedVolume - prevBurnedVolume;
-            const double n = (litVolume / volume) * m_system.n();
-
-            const double fuelBurned =
-                m_system.react(n * m_flameEvent.efficiency, m_flameEvent.globalMix);
-            const double massFuelBurned = fuelBurned * m_fuel->getMolecularMass();
-            m_system.changeEnergy(
-                massFuelBurned * m_fuel->getEnergyDensity());
-
-            m_flameEvent.lit_n += n;
-            m_flameEvent.percentageLit += litVolume / volume;
-
-            m_nBurntFuel += massFuelBurned;
+    if (fluid.lit) {
+        if (fluid.burnModel == BurnModel::Wiebe) {
+            burnWiebe(dt);
         }
         else {
-            m_lit = false;
+            burnFlameFront(dt, volume);
         }
 
-        m_flameEvent.lastVolume = volume;
+        fluid.flameEvent.lastVolume = volume;
+    }
+}
+
+void CombustionChamber::burnFlameFront(double dt, double volume) {
+    const double totalTravel_x = m_fluid->bore / 2;
+    const double totalTravel_y = volume / m_fluid->boreSurfaceArea;
+    const double expansion = volume / m_fluid->flameEvent.lastVolume;
+    const double lastTravel_x = m_fluid->flameEvent.travel_x;
+    const double lastTravel_y = m_fluid->flameEvent.travel_y * expansion;
+    const double flameSpeed = m_fluid->flameEvent.flameSpeed;
+
+    m_fluid->flameEvent.travel_x =
+        std::fmin(lastTravel_x + dt * flameSpeed, totalTravel_x);
+    m_fluid->flameEvent.travel_y =
+        std::fmin(lastTravel_y + dt * flameSpeed, totalTravel_y);
+
+    if (lastTravel_x < m_fluid->flameEvent.travel_x || lastTravel_y < m_fluid->flameEvent.travel_y) {
+        const double burnedVolume =
+            m_fluid->flameEvent.travel_x * m_fluid->flameEvent.travel_x
+            * constants::pi * m_fluid->flameEvent.travel_y;
+        const double prevBurnedVolume =
+            lastTravel_x * lastTravel_x * constants::pi * lastTravel_y;
+        const double litVolume = burnedVolume - prevBurnedVolume;
+        const double n = (litVolume / volume) * m_fluid->system.n();
+
+        burn(n);
+        m_fluid->flameEvent.percentageLit += litVolume / volume;
+    }
+    else {
+        m_fluid->lit = false;
+    }
+}
+
+double CombustionChamber::wiebeBurnFraction(double s) {
+    if (s <= 0) return 0.0;
+    else if (s >= 1) return 1.0;
+
+    const double *table = wiebeTable();
+    const double t = s * WiebeSamples;
+    const int i = static_cast<int>(t);
+    return table[i] + (t - i) * (table[i + 1] - table[i]);
+}
+
+void CombustionChamber::burnWiebe(double dt) {
+    if (m_fluid->flameEvent.burnDuration <= 0) {
+        m_fluid->lit = false;
+        return;
     }
+
+    m_fluid->flameEvent.burnTime += dt;
+    const double s = m_fluid->flameEvent.burnTime / m_fluid->flameEvent.burnDuration;
+    const double burnedFraction = wiebeBurnFraction(s);
+    const double dx = burnedFraction - m_fluid->flameEvent.burnedFraction;
+    m_fluid->flameEvent.burnedFraction = burnedFraction;
+
+    burn(dx * m_fluid->flameEvent.total_n);
+    m_fluid->flameEvent.percentageLit += dx;
+
+    if (s >= 1.0) {
+        m_fluid->lit = false;
+    }
+}
+
+void CombustionChamber::burn(double n) {
+    const double fuelBurned =
+        m_fluid->system.react(n * m_fluid->flameEvent.efficiency, m_fluid->flameEvent.globalMix);
+    const double massFuelBurned = fuelBurned * m_fuel->getMolecularMass();
+    m_fluid->system.changeEnergy(
+        massFuelBurned * m_fuel->getEnergyDensity());
+
+    m_fluid->flameEvent.lit_n += n;
+    m_fluid->nBurntFuel += massFuelBurned;
 }
 
 double CombustionChamber::lastEventAfr() const {
-    const double totalFuel = m_flameEvent.globalMix.p_fuel * m_flameEvent.total_n;
-    const double totalOxygen = m_flameEvent.globalMix.p_o2 * m_flameEvent.total_n;
-    const double totalInert = m_flameEvent.globalMix.p_inert * m_flameEvent.total_n;
+    const double totalFuel = m_fluid->flameEvent.globalMix.p_fuel * m_fluid->flameEvent.total_n;
+    const double totalOxygen = m_fluid->flameEvent.globalMix.p_o2 * m_fluid->flameEvent.total_n;
+    const double totalInert = m_fluid->flameEvent.globalMix.p_inert * m_fluid->flameEvent.total_n;
 
     constexpr double octaneMolarMass = units::mass(114.23, units::g);
     constexpr double oxygenMolarMass = units::mass(31.9988, units::g);
@@ -396,24 +635,67 @@ void CombustionChamber::updateCycleStates() {
     }
 
     const int i = (int)std::round((crankAngle / (4 * constants::pi)) * (StateSamples - 1.0));
+    const double previousSpeed = m_pistonSpeed[i];
 
-    m_pistonSpeed[i] = std::abs(pistonSpeed());
-    m_pressure[i] = m_system.pressure();
+    const double speed = std::abs(pistonSpeed());
+    const double pressure = m_fluid->system.pressure();
+
+    // The sum is rebuilt once per cycle so rounding doesn't accumulate
+    m_pistonSpeed[i] = speed;
+    if (i == 0) {
+        m_pistonSpeedSum = 0;
+        for (int j = 0; j < StateSamples; ++j) {
+            m_pistonSpeedSum += m_pistonSpeed[j];
+        }
+    }
+    else {
+        m_pistonSpeedSum += speed - previousSpeed;
+    }
+
+    // Bins are revisited in crank order rather than FIFO, so the peak is
+    // only rescanned when its own bin is overwritten with a lower value
+    m_pressure[i] = pressure;
+    if (pressure >= m_peakPressure) {
+        m_peakPressure = pressure;
+        m_peakPressureIndex = i;
+    }
+    else if (i == m_peakPressureIndex) {
+        m_peakPressure = 0;
+        for (int j = 0; j < StateSamples; ++j) {
+            if (m_pressure[j] > m_peakPressure) {
+                m_peakPressure = m_pressure[j];
+                m_peakPressureIndex = j;
+            }
+        }
+    }
 }
 
 void CombustionChamber::apply(atg_scs::SystemState *system) {
     CylinderBank *bank = m_head->getCylinderBank();
-    const double area = (bank->getBore() * bank->getBore() / 4.0) * constants::pi;
     const double v_x = system->v_x[m_piston->m_body.index];
     const double v_y = system->v_y[m_piston->m_body.index];
 
     const double v_s =
         v_x * bank->getDx() + v_y * bank->getDy();
 
-    const double pressureDifferential = m_system.pressure() - m_crankcasePressure;
-    const double force = -area * pressureDifferential;
+    const double F = calculatePistonForce(v_s);
+
+    system->applyForce(
+        0.0,
+        0.0,
+        F * bank->getDx(),
+        F * bank->getDy(),
+        m_piston->m_body.index);
+}
+
+double CombustionChamber::calculatePistonForce(double v_s) const {
+    CylinderBank *bank = m_head->getCylinderBank();
+    const double area = (bank->getBore() * bank->getBore() / 4.0) * constants::pi;
+
+    const double force = -area * getPistonPressureDifferential();
 
     if (std::isnan(force) || std::isinf(force)) {
+        FlightRecorder::DumpCurrent("non_finite_piston_force");
         assert(false);
     }
 
@@ -426,12 +708,28 @@ void CombustionChamber::apply(atg_scs::SystemState *system) {
         ? -F
         : F;
 
-    system->applyForce(
-        0.0,
-        0.0,
-        (force + F_fric) * bank->getDx(),
-        (force + F_fric) * bank->getDy(),
-        m_piston->m_body.index);
+    return force + F_fric;
+}
+
+void CombustionChamber::sampleForcePressure() {
+    m_forcePressureSum += m_fluid->system.pressure() - m_fluid->crankcasePressure;
+    ++m_forcePressureSamples;
+}
+
+void CombustionChamber::latchForcePressure() {
+    if (m_forcePressureSamples == 0) return;
+
+    m_forcePressure = m_forcePressureSum / m_forcePressureSamples;
+    m_forcePressureLatched = true;
+
+    m_forcePressureSum = 0;
+    m_forcePressureSamples = 0;
+}
+
+void CombustionChamber::releaseForcePressure() {
+    m_forcePressureSum = 0;
+    m_forcePressureSamples = 0;
+    m_forcePressureLatched = false;
 }
 
 double CombustionChamber::getFrictionForce() const {
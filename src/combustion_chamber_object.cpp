@@ -17,13 +17,18 @@ void CombustionChamberObject::generateGeometry() {
     CylinderHead *head = m_chamber->getCylinderHead();
     CylinderBank *bank = head->getCylinderBank();
 
-    const float lineWidth = (float)m_chamber->m_flameEvent.travel_x * 2;
+    // Only the lit chamber in front of each bank is drawn
+    m_indices = GeometryGenerator::GeometryIndices();
+    if (!m_chamber->isLit()) return;
+    else if (m_chamber->getPiston() != getForemostPiston(bank, m_app->getViewParameters().Layer0)) return;
+
+    const float lineWidth = (float)m_chamber->getFlameEvent().travel_x * 2;
     double flameTop_x, flameTop_y;
     double flameBottom_x, flameBottom_y;
     double chamberHeight = head->getCombustionChamberVolume() / bank->boreSurfaceArea();
 
     bank->getPositionAboveDeck(chamberHeight, &flameTop_x, &flameTop_y);
-    bank->getPositionAboveDeck(chamberHeight - m_chamber->m_flameEvent.travel_y, &flameBottom_x, &flameBottom_y);
+    bank->getPositionAboveDeck(chamberHeight - m_chamber->getFlameEvent().travel_y, &flameBottom_x, &flameBottom_y);
 
     GeometryGenerator::Line2dParameters params;
     params.lineWidth = lineWidth;
@@ -46,8 +51,8 @@ void CombustionChamberObject::render(const ViewParameters *view) {
     CylinderBank *bank = head->getCylinderBank();
 
     Piston *frontmostPiston = getForemostPiston(bank, view->Layer0);
-    if (m_chamber->getPiston() == frontmostPiston) {
-        if (m_chamber->m_lit) {
+    if (m_chamber->getPiston() == frontmostPiston && m_indices.FaceCount > 0) {
+        if (m_chamber->isLit()) {
             m_app->getShaders()->SetBaseColor(
                 ysMath::Mul(
                     m_app->getOrange(),
@@ -57,6 +62,21 @@ void CombustionChamberObject::render(const ViewParameters *view) {
     }
 }
 
+bool CombustionChamberObject::getWorldBounds(Bounds *bounds) const {
+    CylinderHead *head = m_chamber->getCylinderHead();
+    CylinderBank *bank = head->getCylinderBank();
+    const double chamberHeight = head->getCombustionChamberVolume() / bank->boreSurfaceArea();
+
+    // Around the flame, which starts at the top of the chamber
+    double top_x, top_y, bottom_x, bottom_y;
+    bank->getPositionAboveDeck(chamberHeight, &top_x, &top_y);
+    bank->getPositionAboveDeck(chamberHeight - m_chamber->getFlameEvent().travel_y, &bottom_x, &bottom_y);
+
+    *bounds = Bounds((float)top_x, (float)bottom_x, (float)top_y, (float)bottom_y)
+        .grow((float)m_chamber->getFlameEvent().travel_x);
+    return true;
+}
+
 void CombustionChamberObject::process(float dt) {
     /* void */
 }
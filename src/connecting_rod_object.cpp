@@ -4,6 +4,8 @@
 #include "../include/units.h"
 #include "../include/ui_utilities.h"
 
+#include <cmath>
+
 ConnectingRodObject::ConnectingRodObject() {
     m_connectingRod = nullptr;
 }
@@ -12,8 +14,9 @@ ConnectingRodObject::~ConnectingRodObject() {
     /* void */
 }
 
-void ConnectingRodObject::generateGeometry() {
+void ConnectingRodObject::generateStaticGeometry() {
     GeometryGenerator *gen = m_app->getGeometryGenerator();
+    PartInstancer *instancer = m_app->getPartInstancer();
     const int rodJournalCount = m_connectingRod->getRodJournalCount();
 
     GeometryGenerator::Line2dParameters params;
@@ -22,25 +25,44 @@ void ConnectingRodObject::generateGeometry() {
     params.y1 = (float)m_connectingRod->getLittleEndLocal();
     params.lineWidth = (float)(m_connectingRod->getCrankshaft()->getThrow() * 0.5);
 
-    gen->startShape();
-    gen->generateLine2d(params);
+    // Rods with the same dimensions share one body
+    PartInstancer::MeshKey key;
+    key.part = PartInstancer::Part::ConnectingRodBody;
+    key.parameters[0] = params.y0;
+    key.parameters[1] = params.y1;
+    key.parameters[2] = params.lineWidth;
+    key.parameters[3] = (rodJournalCount > 0)
+        ? static_cast<float>(m_connectingRod->getSlaveThrow())
+        : 0.0f;
+
+    const GeometryGenerator::GeometryIndices *body = instancer->findMesh(key);
+    if (body != nullptr) {
+        m_connectingRodBody = *body;
+    }
+    else {
+        gen->startShape();
+        gen->generateLine2d(params);
 
-    if (rodJournalCount > 0) {
-        GeometryGenerator::Circle2dParameters circleParams;
-        circleParams.radius = static_cast<float>(m_connectingRod->getSlaveThrow()) * 1.5f;
-        circleParams.center_x = 0.0f;
-        circleParams.center_y = static_cast<float>(m_connectingRod->getBigEndLocal());
+        if (rodJournalCount > 0) {
+            GeometryGenerator::Circle2dParameters circleParams;
+            circleParams.radius = static_cast<float>(m_connectingRod->getSlaveThrow()) * 1.5f;
+            circleParams.maxEdgeLength = m_app->viewPixelsToUnits(5.0f);
+            circleParams.center_x = 0.0f;
+            circleParams.center_y = static_cast<float>(m_connectingRod->getBigEndLocal());
 
-        gen->generateCircle2d(circleParams);
-    }
+            gen->generateCircle2d(circleParams);
+        }
 
-    gen->endShape(&m_connectingRodBody);
+        gen->endShape(&m_connectingRodBody);
+        instancer->addMesh(key, m_connectingRodBody);
+    }
 
     if (rodJournalCount > 0) {
         gen->startShape();
 
         GeometryGenerator::Circle2dParameters circleParams;
         circleParams.radius = static_cast<float>(m_connectingRod->getCrankshaft()->getThrow()) * 0.2f;
+        circleParams.maxEdgeLength = m_app->viewPixelsToUnits(5.0f);
         for (int i = 0; i < rodJournalCount; ++i) {
             double x, y;
             m_connectingRod->getRodJournalPositionLocal(i, &x, &y);
@@ -98,6 +120,15 @@ void ConnectingRodObject::render(const ViewParameters *view) {
     }
 }
 
+bool ConnectingRodObject::getWorldBounds(Bounds *bounds) const {
+    const double reach =
+        std::fmax(std::abs(m_connectingRod->getBigEndLocal()), std::abs(m_connectingRod->getLittleEndLocal()))
+        + m_connectingRod->getCrankshaft()->getThrow()
+        + 1.5 * m_connectingRod->getSlaveThrow();
+    *bounds = boundsAround(m_connectingRod->m_body.p_x, m_connectingRod->m_body.p_y, reach);
+    return true;
+}
+
 void ConnectingRodObject::process(float dt) {
     /* void */
 }
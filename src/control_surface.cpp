@@ -0,0 +1,488 @@
+#include "../include/control_surface.h"
+
+#include "../include/debug_trace.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#if defined(_WIN32)
+typedef SOCKET NativeSocket;
+const intptr_t Closed = static_cast<intptr_t>(INVALID_SOCKET);
+
+void closeSocket(intptr_t s) {
+    closesocket(static_cast<SOCKET>(s));
+    WSACleanup();
+}
+#else
+typedef int NativeSocket;
+const intptr_t Closed = -1;
+
+void closeSocket(intptr_t s) {
+    ::close(static_cast<int>(s));
+}
+#endif /* _WIN32 */
+
+// The listener wakes this often to notice destroy()
+constexpr int PollMilliseconds = 50;
+
+constexpr size_t MaxOscPacket = 4096;
+
+uint32_t controlBit(ControlQueue::Control control) {
+    return 1u << static_cast<int>(control);
+}
+
+// OSC strings are null terminated and padded to four bytes
+bool readOscString(const char *data, size_t size, size_t *offset, std::string *s) {
+    const void *end = std::memchr(data + *offset, '\0', size - *offset);
+    if (end == nullptr) return false;
+
+    const size_t length = static_cast<const char *>(end) - (data + *offset);
+    s->assign(data + *offset, length);
+    *offset += (length + 4) & ~size_t(3);
+
+    return *offset <= size;
+}
+
+uint32_t readBigEndian32(const char *data) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+}
+
+uint64_t readBigEndian64(const char *data) {
+    return (uint64_t(readBigEndian32(data)) << 32) | readBigEndian32(data + 4);
+}
+
+bool parseOscMessage(const char *data, size_t size, std::vector<ControlSurface::Message> *messages) {
+    size_t offset = 0;
+
+    ControlSurface::Message message;
+    std::string tags;
+    if (!readOscString(data, size, &offset, &message.address) || message.address.empty()) return false;
+    if (!readOscString(data, size, &offset, &tags) || tags.empty() || tags[0] != ',') return false;
+
+    // Messages without a usable first argument are valid, just not ours
+    if (tags.size() < 2) return true;
+
+    switch (tags[1]) {
+        case 'f':
+        {
+            if (offset + 4 > size) return false;
+            const uint32_t bits = readBigEndian32(data + offset);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            message.value = value;
+            break;
+        }
+        case 'd':
+        {
+            if (offset + 8 > size) return false;
+            const uint64_t bits = readBigEndian64(data + offset);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            message.value = value;
+            break;
+        }
+        case 'i':
+            if (offset + 4 > size) return false;
+            message.value = static_cast<int32_t>(readBigEndian32(data + offset));
+            break;
+        case 'T':
+            message.value = 1.0;
+            break;
+        case 'F':
+            message.value = 0.0;
+            break;
+        default:
+            return true;
+    }
+
+    messages->push_back(message);
+    return true;
+}
+} /* namespace */
+
+bool ControlSurface::MidiParser::feed(uint8_t byte, Message *message) {
+    // Real-time bytes can arrive anywhere, even inside other messages
+    if (byte >= 0xF8) return false;
+
+    if (byte & 0x80) {
+        m_sysex = byte == 0xF0;
+
+        // Other system messages cancel running status
+        m_status = (byte < 0xF0) ? byte : 0;
+        m_count = 0;
+        return false;
+    }
+
+    if (m_sysex || m_status == 0) return false;
+
+    const uint8_t type = m_status & 0xF0;
+    const int length = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+    m_data[m_count++] = byte;
+    if (m_count < length) return false;
+
+    m_count = 0;
+    message->channel = m_status & 0x0F;
+    message->number = m_data[0];
+    message->address.clear();
+
+    switch (type) {
+        case 0x80:
+            message->source = Source::MidiNote;
+            message->value = 0.0;
+            return true;
+        case 0x90:
+            // Note on at velocity 0 is a note off
+            message->source = Source::MidiNote;
+            message->value = m_data[1] / 127.0;
+            return true;
+        case 0xB0:
+            message->source = Source::MidiControlChange;
+            message->value = m_data[1] / 127.0;
+            return true;
+        case 0xE0:
+            message->source = Source::MidiPitchBend;
+            message->number = 0;
+            message->value = ((m_data[1] << 7) | m_data[0]) / 16383.0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+ControlSurface::ControlSurface() {
+    m_midi = Closed;
+    m_osc = Closed;
+    m_oscPort = -1;
+    m_thread = nullptr;
+    m_run = false;
+    m_owned = 0;
+    m_messages = 0;
+    m_unmapped = 0;
+    m_rejected = 0;
+
+    m_lastValues.assign(m_parameters.bindings.size(), 0.0);
+    m_toggleStates.assign(m_parameters.bindings.size(), false);
+}
+
+ControlSurface::~ControlSurface() {
+    destroy();
+}
+
+bool ControlSurface::initialize(const Parameters &params) {
+    destroy();
+
+    m_parameters = params;
+    m_lastValues.assign(params.bindings.size(), 0.0);
+    m_toggleStates.assign(params.bindings.size(), false);
+    m_midiParser = MidiParser();
+    m_owned = 0;
+
+    const bool opened =
+        (params.midiDevice.empty() || openMidi(params.midiDevice))
+        && (params.oscPort < 0 || openOsc(params.oscPort));
+    if (!opened || (m_midi == Closed && m_osc == Closed)) {
+        closeTransports();
+        return false;
+    }
+
+    m_run = true;
+    m_thread = new std::thread(&ControlSurface::worker, this);
+
+    ATG_ENGINE_SIM_TRACE(
+        Input, Event,
+        "control_surface open midi=%s osc_port=%d bindings=%d",
+        params.midiDevice.empty() ? "none" : params.midiDevice.c_str(),
+        m_oscPort,
+        static_cast<int>(params.bindings.size()));
+
+    return true;
+}
+
+void ControlSurface::destroy() {
+    if (m_thread != nullptr) {
+        m_run = false;
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    closeTransports();
+}
+
+bool ControlSurface::owns(ControlQueue::Control control) const {
+    return (m_owned.load(std::memory_order_relaxed) & controlBit(control)) != 0;
+}
+
+void ControlSurface::release(ControlQueue::Control control) {
+    m_owned.fetch_and(~controlBit(control), std::memory_order_relaxed);
+}
+
+ControlSurface::Statistics ControlSurface::getStatistics() const {
+    Statistics statistics;
+    statistics.messages = m_messages.load(std::memory_order_relaxed);
+    statistics.unmapped = m_unmapped.load(std::memory_order_relaxed);
+    statistics.rejected = m_rejected.load(std::memory_order_relaxed);
+
+    return statistics;
+}
+
+bool ControlSurface::dispatch(const Message &message, ControlQueue::Clock::time_point time) {
+    m_messages.fetch_add(1, std::memory_order_relaxed);
+
+    bool mapped = false;
+    for (size_t i = 0; i < m_parameters.bindings.size(); ++i) {
+        const Binding &binding = m_parameters.bindings[i];
+        if (binding.source != message.source) continue;
+        if (message.source == Source::Osc) {
+            if (binding.address != message.address) continue;
+        }
+        else if ((binding.channel >= 0 && binding.channel != message.channel)
+            || (message.source != Source::MidiPitchBend && binding.number != message.number))
+        {
+            continue;
+        }
+
+        const double value = std::clamp(message.value, 0.0, 1.0);
+        double position = value;
+        if (binding.toggle) {
+            const bool pressed = value >= 0.5 && m_lastValues[i] < 0.5;
+            m_lastValues[i] = value;
+            mapped = true;
+            if (!pressed) continue;
+
+            m_toggleStates[i] = !m_toggleStates[i];
+            position = m_toggleStates[i] ? 1.0 : 0.0;
+        }
+
+        ControlQueue::Event event;
+        event.control = binding.control;
+        event.value = binding.minimum + (binding.maximum - binding.minimum) * position;
+        event.time = time;
+        event.smoothing = binding.smoothing;
+
+        m_owned.fetch_or(controlBit(binding.control), std::memory_order_relaxed);
+        m_queue.push(event);
+        mapped = true;
+    }
+
+    if (!mapped) m_unmapped.fetch_add(1, std::memory_order_relaxed);
+    return mapped;
+}
+
+bool ControlSurface::ParseOsc(const char *data, size_t size, std::vector<Message> *messages) {
+    if (size == 0 || size % 4 != 0) return false;
+    if (data[0] != '#') return parseOscMessage(data, size, messages);
+
+    // "#bundle", a time tag we don't schedule by, then sized elements
+    if (size < 16 || std::memcmp(data, "#bundle", 8) != 0) return false;
+
+    size_t offset = 16;
+    while (offset < size) {
+        if (offset + 4 > size) return false;
+
+        const size_t length = readBigEndian32(data + offset);
+        offset += 4;
+        if (length > size - offset || !ParseOsc(data + offset, length, messages)) return false;
+
+        offset += length;
+    }
+
+    return true;
+}
+
+std::vector<ControlSurface::Binding> ControlSurface::DefaultBindings() {
+    struct Default {
+        int note;
+        const char *address;
+        ControlQueue::Control control;
+        double minimum;
+        double maximum;
+        double smoothing;
+        bool toggle;
+    };
+
+    // A pressed clutch pedal is no clutch pressure
+    const Default defaults[] = {
+        { 1, "/engine/throttle", ControlQueue::Control::Throttle, 0.0, 1.0, 0.01, false },
+        { 2, "/engine/clutch", ControlQueue::Control::Clutch, 1.0, 0.0, 0.02, false },
+        { 3, "/engine/dyno_speed", ControlQueue::Control::DynoSpeed, 0.0, units::rpm(10000.0), 0.05, false },
+        { 36, "/engine/starter", ControlQueue::Control::Starter, 0.0, 1.0, 0.0, false },
+        { 37, "/engine/ignition", ControlQueue::Control::Ignition, 0.0, 1.0, 0.0, true },
+        { 38, "/engine/dyno", ControlQueue::Control::DynoEnabled, 0.0, 1.0, 0.0, true },
+        { 39, "/engine/dyno_hold", ControlQueue::Control::DynoHold, 0.0, 1.0, 0.0, true }
+    };
+
+    std::vector<Binding> bindings;
+    for (const Default &d : defaults) {
+        Binding binding;
+        binding.source = (d.note < 36) ? Source::MidiControlChange : Source::MidiNote;
+        binding.number = d.note;
+        binding.control = d.control;
+        binding.minimum = d.minimum;
+        binding.maximum = d.maximum;
+        binding.smoothing = d.smoothing;
+        binding.toggle = d.toggle;
+        bindings.push_back(binding);
+
+        // OSC buttons send their state, so toggles are the controller's job
+        binding.source = Source::Osc;
+        binding.number = 0;
+        binding.address = d.address;
+        binding.toggle = false;
+        bindings.push_back(binding);
+    }
+
+    return bindings;
+}
+
+void ControlSurface::worker() {
+    char packet[MaxOscPacket];
+    std::vector<Message> messages;
+
+    while (m_run) {
+#if defined(_WIN32)
+        // Only OSC on Windows; see openMidi()
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(static_cast<SOCKET>(m_osc), &readable);
+        timeval timeout = { 0, PollMilliseconds * 1000 };
+        if (select(0, &readable, nullptr, nullptr, &timeout) <= 0) continue;
+        const bool oscReady = true;
+        const bool midiReady = false;
+#else
+        pollfd descriptors[2];
+        int count = 0;
+        if (m_midi != Closed) descriptors[count++] = { static_cast<int>(m_midi), POLLIN, 0 };
+        if (m_osc != Closed) descriptors[count++] = { static_cast<int>(m_osc), POLLIN, 0 };
+        if (::poll(descriptors, count, PollMilliseconds) <= 0) continue;
+
+        const bool midiReady = m_midi != Closed && (descriptors[0].revents & POLLIN) != 0;
+        const bool oscReady = m_osc != Closed && (descriptors[count - 1].revents & POLLIN) != 0;
+
+        // An unplugged device, or a FIFO whose writer left, would otherwise
+        // wake the poll forever
+        if (m_midi != Closed && !midiReady && (descriptors[0].revents & (POLLHUP | POLLERR)) != 0) {
+            ATG_ENGINE_SIM_TRACE(Input, Event, "control_surface midi closed");
+            ::close(static_cast<int>(m_midi));
+            m_midi = Closed;
+        }
+#endif /* _WIN32 */
+
+        // Stamped as they arrive, which the simulator places them by
+        const ControlQueue::Clock::time_point time = ControlQueue::Clock::now();
+
+#if !defined(_WIN32)
+        if (midiReady) {
+            uint8_t bytes[256];
+            const ssize_t n = ::read(static_cast<int>(m_midi), bytes, sizeof(bytes));
+            Message message;
+            for (ssize_t i = 0; i < n; ++i) {
+                if (m_midiParser.feed(bytes[i], &message)) dispatch(message, time);
+            }
+        }
+#else
+        (void)midiReady;
+#endif /* _WIN32 */
+
+        if (oscReady) {
+            for (;;) {
+                const int received = static_cast<int>(recv(static_cast<NativeSocket>(m_osc), packet, sizeof(packet), 0));
+                if (received <= 0) break;
+
+                messages.clear();
+                if (!ParseOsc(packet, static_cast<size_t>(received), &messages)) {
+                    m_rejected.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                for (const Message &message : messages) dispatch(message, time);
+            }
+        }
+    }
+}
+
+bool ControlSurface::openMidi(const std::string &device) {
+#if defined(_WIN32)
+    // Windows MIDI ports aren't byte streams; they'd need the WinMM callback
+    // API, which isn't wired up
+    (void)device;
+    return false;
+#else
+    const int fd = ::open(device.c_str(), O_RDONLY | O_NONBLOCK);
+    if (fd < 0) return false;
+
+    m_midi = fd;
+    return true;
+#endif /* _WIN32 */
+}
+
+bool ControlSurface::openOsc(int port) {
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) return false;
+#endif /* _WIN32 */
+
+    const NativeSocket s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (static_cast<intptr_t>(s) == Closed) {
+#if defined(_WIN32)
+        WSACleanup();
+#endif /* _WIN32 */
+        return false;
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+
+    bool ok = bind(s, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    ok = ok && ioctlsocket(s, FIONBIO, &nonBlocking) == 0;
+    int length = sizeof(address);
+#else
+    ok = ok && fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK) == 0;
+    socklen_t length = sizeof(address);
+#endif /* _WIN32 */
+
+    ok = ok && getsockname(s, reinterpret_cast<sockaddr *>(&address), &length) == 0;
+    if (!ok) {
+        closeSocket(static_cast<intptr_t>(s));
+        return false;
+    }
+
+    m_osc = static_cast<intptr_t>(s);
+    m_oscPort = ntohs(address.sin_port);
+    return true;
+}
+
+void ControlSurface::closeTransports() {
+#if !defined(_WIN32)
+    if (m_midi != Closed) ::close(static_cast<int>(m_midi));
+#endif /* _WIN32 */
+
+    if (m_osc != Closed) closeSocket(m_osc);
+
+    m_midi = Closed;
+    m_osc = Closed;
+    m_oscPort = -1;
+}
@@ -0,0 +1,197 @@
+#include "../include/convolution_batch.h"
+
+#include "../include/event_counters.h"
+#include "../include/utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+ConvolutionBatch::ConvolutionBatch() {
+    m_headHistory = nullptr;
+    m_headOffset = 0;
+    m_instanceCount = 0;
+}
+
+ConvolutionBatch::~ConvolutionBatch() {
+    assert(m_headHistory == nullptr);
+    assert(m_instanceCount == 0);
+}
+
+void ConvolutionBatch::initialize(const PartitionedConvolution &prototype, int instances) {
+    destroy();
+
+    if (!prototype.isInitialized() || instances <= 0) return;
+
+    m_prototype.initialize(prototype);
+    m_prototype.setActiveFraction(prototype.getActiveFraction());
+    m_instanceCount = instances;
+
+    const size_t headSize = (size_t)m_prototype.m_headSize;
+    m_headHistory = new float[2 * headSize * instances];
+    m_headOffset = 0;
+    std::memset(m_headHistory, 0, sizeof(float) * 2 * headSize * instances);
+
+    for (int i = 0; i < m_prototype.m_stageCount; ++i) {
+        const PartitionedConvolution::Stage &source = m_prototype.m_stages[i];
+        const size_t blockSize = (size_t)source.blockSize;
+        const size_t n = 2 * blockSize;
+
+        BatchStage &stage = m_stages[i];
+        stage.prototype = &source;
+        stage.position = 0;
+        stage.newest = 0;
+        stage.history = new std::complex<float>[(size_t)source.partitionCount * instances * n];
+        stage.work = new std::complex<float>[instances * n];
+        stage.input = new float[instances * n];
+        stage.output = new float[instances * blockSize];
+        stage.pending = source.deferred ? new float[instances * blockSize] : nullptr;
+
+        std::fill(
+            stage.history,
+            stage.history + (size_t)source.partitionCount * instances * n,
+            std::complex<float>(0, 0));
+        std::memset(stage.input, 0, sizeof(float) * instances * n);
+        std::memset(stage.output, 0, sizeof(float) * instances * blockSize);
+        if (stage.pending != nullptr) {
+            std::memset(stage.pending, 0, sizeof(float) * instances * blockSize);
+        }
+    }
+}
+
+void ConvolutionBatch::destroy() {
+    for (BatchStage &stage : m_stages) {
+        delete[] stage.history;
+        delete[] stage.work;
+        delete[] stage.input;
+        delete[] stage.output;
+        delete[] stage.pending;
+
+        stage = BatchStage();
+    }
+
+    delete[] m_headHistory;
+
+    m_headHistory = nullptr;
+    m_headOffset = 0;
+    m_instanceCount = 0;
+    m_prototype.destroy();
+}
+
+void ConvolutionBatch::process(const float *const *input, float *const *output, int n) {
+    if (m_instanceCount <= 0) return;
+
+    ATG_ENGINE_SIM_COUNT(ConvolutionSamples, n * m_instanceCount);
+
+    const int headSize = m_prototype.m_headSize;
+    const float *head = m_prototype.m_head;
+    const int stageCount = m_prototype.m_stageCount;
+
+    // Runs up to the next block boundary of any stage one instance at a
+    // time, then advances the full stages for every instance at once
+    for (int done = 0; done < n;) {
+        int length = n - done;
+        for (int s = 0; s < stageCount; ++s) {
+            length = std::min(length, m_stages[s].prototype->blockSize - m_stages[s].position);
+        }
+
+        int headOffset = m_headOffset;
+        for (int i = 0; i < m_instanceCount; ++i) {
+            const float *x = input[i] + done;
+            float *y = output[i] + done;
+            float *history = m_headHistory + 2 * (size_t)headSize * i;
+
+            headOffset = m_headOffset;
+            for (int j = 0; j < length; ++j) {
+                const float sample = x[j];
+                headOffset = (headOffset == 0) ? headSize - 1 : headOffset - 1;
+                history[headOffset] = sample;
+                history[headOffset + headSize] = sample;
+
+                float result = dotProduct(head, history + headOffset, headSize);
+                for (int s = 0; s < stageCount; ++s) {
+                    const BatchStage &stage = m_stages[s];
+                    const int blockSize = stage.prototype->blockSize;
+                    const int position = stage.position + j;
+
+                    result += stage.output[(size_t)blockSize * i + position];
+                    stage.input[2 * (size_t)blockSize * i + blockSize + position] = sample;
+                }
+
+                y[j] = result;
+            }
+        }
+
+        m_headOffset = headOffset;
+        for (int s = 0; s < stageCount; ++s) {
+            BatchStage &stage = m_stages[s];
+            stage.position += length;
+            if (stage.position >= stage.prototype->blockSize) {
+                advance(&stage);
+                stage.position = 0;
+            }
+        }
+
+        done += length;
+    }
+}
+
+void ConvolutionBatch::advance(BatchStage *stage) {
+    const PartitionedConvolution::Stage &source = *stage->prototype;
+    const int blockSize = source.blockSize;
+    const size_t n = 2 * (size_t)blockSize;
+    const int partitionCount = source.partitionCount;
+    const int activeCount = m_prototype.getActiveCount(&source);
+    const size_t slot = n * m_instanceCount;
+
+    // The block handed over last time is due now, as on the worker
+    float *output = stage->output;
+    if (source.deferred) {
+        std::swap(stage->output, stage->pending);
+        output = stage->pending;
+    }
+
+    stage->newest = (stage->newest == 0) ? partitionCount - 1 : stage->newest - 1;
+    std::complex<float> *newest = stage->history + stage->newest * slot;
+    for (int i = 0; i < m_instanceCount; ++i) {
+        std::complex<float> *spectrum = newest + n * i;
+        const float *input = stage->input + n * i;
+        for (size_t k = 0; k < n; ++k) {
+            spectrum[k] = input[k];
+        }
+
+        source.fft.forward(spectrum);
+    }
+
+    // Partition-major so each partition is read once per block for the
+    // whole batch; every instance still sums its partitions in order
+    std::fill(stage->work, stage->work + slot, std::complex<float>(0, 0));
+    for (int p = 0; p < activeCount; ++p) {
+        int h = stage->newest + p;
+        if (h >= partitionCount) h -= partitionCount;
+
+        const float *y = reinterpret_cast<const float *>(source.partitions + (size_t)p * n);
+        const std::complex<float> *history = stage->history + h * slot;
+        for (int i = 0; i < m_instanceCount; ++i) {
+            multiplyAccumulateSpectrum(
+                reinterpret_cast<float *>(stage->work + n * i),
+                reinterpret_cast<const float *>(history + n * i),
+                y,
+                static_cast<int>(n));
+        }
+    }
+
+    const float scale = 1.0f / n;
+    for (int i = 0; i < m_instanceCount; ++i) {
+        std::complex<float> *work = stage->work + n * i;
+        source.fft.inverse(work);
+
+        float *y = output + (size_t)blockSize * i;
+        for (int k = 0; k < blockSize; ++k) {
+            y[k] = work[blockSize + k].real() * scale;
+        }
+
+        float *input = stage->input + n * i;
+        std::memcpy(input, input + blockSize, sizeof(float) * (size_t)blockSize);
+    }
+}
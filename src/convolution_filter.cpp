@@ -1,5 +1,9 @@
 #include "../include/convolution_filter.h"
 
+#include "../include/event_counters.h"
+#include "../include/utilities.h"
+
+#include <algorithm>
 #include <assert.h>
 #include <cstring>
 
@@ -13,7 +17,7 @@ ConvolutionFilter::ConvolutionFilter() {
 
 ConvolutionFilter::~ConvolutionFilter() {
     assert(m_shiftRegister == nullptr);
-    assert(m_impulseResponse == nullptr);
+    assert(m_taps == nullptr);
 }
 
 void ConvolutionFilter::initialize(int samples) {
@@ -26,40 +30,114 @@ void ConvolutionFilter::initialize(int samples) {
     }
 
     m_sampleCount = samples;
-    m_shiftOffset = 0;
-    m_shiftRegister = new float[samples];
-    m_impulseResponse = new float[samples];
+    m_taps = std::shared_ptr<float>(new float[samples], std::default_delete<float[]>());
+    m_impulseResponse = m_taps.get();
+    allocateShiftRegister();
 
-    std::memset(m_shiftRegister, 0, sizeof(float) * (size_t)samples);
     std::memset(m_impulseResponse, 0, sizeof(float) * (size_t)samples);
 }
 
+void ConvolutionFilter::initialize(
+    const ConvolutionFilter &prototype,
+    bool partitioned,
+    ConvolutionWorker *worker)
+{
+    if (&prototype == this) return;
+
+    destroy();
+
+    if (prototype.m_sampleCount <= 0) return;
+
+    m_sampleCount = prototype.m_sampleCount;
+    m_taps = prototype.m_taps;
+    m_impulseResponse = m_taps.get();
+
+    if (!partitioned) {
+        allocateShiftRegister();
+    }
+    else if (prototype.isPartitioned() && prototype.m_partitioned.isTailDeferred() == (worker != nullptr)) {
+        m_partitioned.initialize(prototype.m_partitioned, worker);
+    }
+    else {
+        preparePartitioned(DefaultHeadSize, DefaultTailSize, worker);
+    }
+}
+
+bool ConvolutionFilter::hasSameResponse(const ConvolutionFilter &other) const {
+    if (m_sampleCount != other.m_sampleCount) return false;
+    else if (m_sampleCount == 0 || m_impulseResponse == other.m_impulseResponse) return true;
+
+    return std::memcmp(
+        m_impulseResponse, other.m_impulseResponse, sizeof(float) * (size_t)m_sampleCount) == 0;
+}
+
+void ConvolutionFilter::preparePartitioned(int headSize, int tailSize, ConvolutionWorker *worker) {
+    m_partitioned.initialize(m_impulseResponse, m_sampleCount, headSize, tailSize, worker);
+
+    if (m_partitioned.isInitialized()) {
+        delete[] m_shiftRegister;
+        m_shiftRegister = nullptr;
+    }
+    else if (m_shiftRegister == nullptr) {
+        allocateShiftRegister();
+    }
+}
+
+void ConvolutionFilter::allocateShiftRegister() {
+    delete[] m_shiftRegister;
+
+    m_shiftOffset = 0;
+    m_shiftRegister = new float[2 * (size_t)m_sampleCount];
+    std::memset(m_shiftRegister, 0, sizeof(float) * 2 * (size_t)m_sampleCount);
+}
+
 void ConvolutionFilter::destroy() {
+    m_partitioned.destroy();
+
     delete[] m_shiftRegister;
-    delete[] m_impulseResponse;
 
     m_shiftRegister = nullptr;
+    m_taps.reset();
     m_impulseResponse = nullptr;
     m_shiftOffset = 0;
     m_sampleCount = 0;
 }
 
 float ConvolutionFilter::f(float sample) {
-    if (m_shiftRegister == nullptr || m_impulseResponse == nullptr || m_sampleCount <= 0) {
+    ATG_ENGINE_SIM_COUNT(ConvolutionSamples, 1);
+    if (m_partitioned.isInitialized()) {
+        return m_partitioned.f(sample);
+    }
+    else if (m_shiftRegister == nullptr || m_impulseResponse == nullptr || m_sampleCount <= 0) {
         return sample;
     }
-    m_shiftRegister[m_shiftOffset] = sample;
 
-    float result = 0;
-    for (int i = 0; i < m_sampleCount - m_shiftOffset; ++i) {
-        result += m_impulseResponse[i] * m_shiftRegister[i + m_shiftOffset];
-    }
+    return directForm(sample);
+}
 
-    for (int i = m_sampleCount - m_shiftOffset; i < m_sampleCount; ++i) {
-        result += m_impulseResponse[i] * m_shiftRegister[i - (m_sampleCount - m_shiftOffset)];
+void ConvolutionFilter::f_block(const float *input, float *output, int n) {
+    ATG_ENGINE_SIM_COUNT(ConvolutionSamples, n);
+    if (m_partitioned.isInitialized()) {
+        for (int i = 0; i < n; ++i) {
+            output[i] = m_partitioned.f(input[i]);
+        }
     }
+    else if (m_shiftRegister == nullptr || m_impulseResponse == nullptr || m_sampleCount <= 0) {
+        if (output != input) {
+            std::memmove(output, input, sizeof(float) * (size_t)std::max(0, n));
+        }
+    }
+    else {
+        for (int i = 0; i < n; ++i) {
+            output[i] = directForm(input[i]);
+        }
+    }
+}
 
-    m_shiftOffset = (m_shiftOffset - 1 + m_sampleCount) % m_sampleCount;
+float ConvolutionFilter::directForm(float sample) {
+    m_shiftOffset = (m_shiftOffset == 0) ? m_sampleCount - 1 : m_shiftOffset - 1;
+    m_shiftRegister[m_shiftOffset] = sample;
+    m_shiftRegister[m_shiftOffset + m_sampleCount] = sample;
 
-    return result;
+    return dotProduct(m_impulseResponse, m_shiftRegister + m_shiftOffset, m_sampleCount);
 }
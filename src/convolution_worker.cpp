@@ -0,0 +1,93 @@
+#include "../include/convolution_worker.h"
+
+#include "../include/thread_policy.h"
+
+#include <algorithm>
+#include <cassert>
+
+ConvolutionWorker::ConvolutionWorker() {
+    m_first = 0;
+    m_count = 0;
+    m_run = false;
+    m_inlineCount = 0;
+}
+
+ConvolutionWorker::~ConvolutionWorker() {
+    assert(!m_thread.joinable());
+}
+
+void ConvolutionWorker::initialize(double period, int capacity) {
+    destroy();
+
+    m_jobs.assign(std::max(capacity, 1), Job());
+    m_first = 0;
+    m_count = 0;
+    m_run = true;
+    m_inlineCount = 0;
+    m_thread = std::thread(&ConvolutionWorker::worker, this, period);
+}
+
+void ConvolutionWorker::destroy() {
+    if (!m_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lk(m_lock);
+        m_run = false;
+    }
+
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+void ConvolutionWorker::submit(Task task, void *context, std::atomic<bool> *busy) {
+    busy->store(true, std::memory_order_relaxed);
+
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lk(m_lock);
+        if (m_run && m_count < m_jobs.size()) {
+            Job &job = m_jobs[(m_first + m_count) % m_jobs.size()];
+            job.task = task;
+            job.context = context;
+            job.busy = busy;
+            ++m_count;
+            queued = true;
+        }
+    }
+
+    if (queued) {
+        m_cv.notify_one();
+        return;
+    }
+
+    ++m_inlineCount;
+    task(context);
+    busy->store(false, std::memory_order_release);
+}
+
+void ConvolutionWorker::worker(double period) {
+    // Its results are due a block after they're handed over, so it gets the
+    // audio thread's scheduling on the next core over
+    ThreadPolicy::ApplyToCurrentThread(ThreadPolicy::Role::Audio, period, 1);
+
+    std::unique_lock<std::mutex> lk(m_lock);
+    while (true) {
+        m_cv.wait(lk, [this] { return m_count > 0 || !m_run; });
+
+        // Jobs already queued are finished before exiting so no owner is
+        // left waiting on them
+        if (m_count == 0) break;
+
+        const Job job = m_jobs[m_first];
+        m_first = (m_first + 1) % m_jobs.size();
+        --m_count;
+
+        lk.unlock();
+        job.task(job.context);
+        job.busy->store(false, std::memory_order_release);
+        lk.lock();
+    }
+
+    lk.unlock();
+    ThreadPolicy::ReleaseCurrentThread(ThreadPolicy::Role::Audio);
+}
@@ -0,0 +1,151 @@
+#include "../include/cost_estimate.h"
+
+#include "../include/engine.h"
+#include "../include/piston_engine_simulator.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+double convolutionCost(int taps, bool partitioned, const CostEstimate::Coefficients &c) {
+    return partitioned
+        ? c.partitionedFixed + c.partitionedTap * taps
+        : c.directTap * taps;
+}
+} /* namespace */
+
+CostEstimate::Inputs CostEstimate::Gather(Simulator *simulator) {
+    Inputs inputs;
+    inputs.simulationFrequency = simulator->getSimulationFrequency();
+    inputs.fluidSteps = simulator->getFluidSimulationSteps();
+
+    const Engine *engine = simulator->getEngine();
+    if (engine != nullptr) {
+        inputs.cylinders = engine->getCylinderCount();
+        inputs.pipes = engine->getIntakeCount() + engine->getExhaustSystemCount();
+    }
+
+    const PistonEngineSimulator *piston = dynamic_cast<const PistonEngineSimulator *>(simulator);
+    if (piston != nullptr) inputs.fluidThreads = std::max(1, piston->getFluidThreadCount());
+
+    // Channels sharing a response share its convolution
+    const Synthesizer &synthesizer = simulator->synthesizer();
+    inputs.audioSampleRate = synthesizer.getAudioSampleRate();
+    inputs.channels = synthesizer.getInputChannelCount();
+    inputs.partitionedConvolution = synthesizer.isPartitionedConvolution();
+
+    std::vector<const ConvolutionFilter *> counted;
+    for (int i = 0; i < inputs.channels; ++i) {
+        const ConvolutionFilter *filter = &synthesizer.getConvolution(i);
+        if (std::find(counted.begin(), counted.end(), filter) != counted.end()) continue;
+
+        counted.push_back(filter);
+        if (filter->getSampleCount() > 0) inputs.impulseResponseTaps.push_back(filter->getSampleCount());
+    }
+
+    return inputs;
+}
+
+CostEstimate::Report CostEstimate::Estimate(
+    const Inputs &inputs,
+    const Coefficients &c,
+    double headroom)
+{
+    Report report;
+    report.headroom = headroom;
+
+    const double frequency = 1E-6 * inputs.simulationFrequency;
+    report.physicsLoad = frequency * (c.stepFixed + c.stepPerCylinder * inputs.cylinders);
+    report.fluidLoad = frequency * inputs.fluidSteps
+        * (c.substepPerCylinder * inputs.cylinders + c.substepPerPipe * inputs.pipes)
+        / std::max(1, inputs.fluidThreads);
+
+    const double sampleRate = 1E-6 * inputs.audioSampleRate;
+    report.synthesisLoad = sampleRate * (c.sampleFixed + c.samplePerChannel * inputs.channels);
+    for (int taps : inputs.impulseResponseTaps) {
+        report.convolutionLoad += sampleRate * convolutionCost(taps, inputs.partitionedConvolution, c);
+    }
+
+    report.physicsThreadLoad = report.physicsLoad + report.fluidLoad;
+    report.audioThreadLoad = report.synthesisLoad + report.convolutionLoad;
+    report.sustainable = report.physicsThreadLoad <= headroom && report.audioThreadLoad <= headroom;
+
+    report.terms = {
+        { "physics", "simulation_frequency", report.physicsLoad },
+        { "fluid", "fluid_simulation_steps", report.fluidLoad },
+        { "synthesis", "exhaust_systems", report.synthesisLoad },
+        { "convolution", "impulse_response", report.convolutionLoad }
+    };
+
+    std::stable_sort(report.terms.begin(), report.terms.end(), [](const Term &a, const Term &b) {
+        return a.load > b.load;
+    });
+
+    return report;
+}
+
+CostEstimate::Coefficients CostEstimate::Fit(
+    const FidelityCalibration::Measurement &measurement,
+    const Inputs &inputs)
+{
+    return Fit(measurement, inputs, Coefficients());
+}
+
+CostEstimate::Coefficients CostEstimate::Fit(
+    const FidelityCalibration::Measurement &measurement,
+    const Inputs &inputs,
+    const Coefficients &reference)
+{
+    Coefficients fitted = reference;
+
+    const double step = reference.stepFixed + reference.stepPerCylinder * inputs.cylinders;
+    if (step > 0 && measurement.fixedMicroseconds > 0) {
+        const double scale = measurement.fixedMicroseconds / step;
+        fitted.stepFixed *= scale;
+        fitted.stepPerCylinder *= scale;
+    }
+
+    const double substep =
+        (reference.substepPerCylinder * inputs.cylinders + reference.substepPerPipe * inputs.pipes)
+        / std::max(1, inputs.fluidThreads);
+    if (substep > 0 && measurement.substepMicroseconds > 0) {
+        const double scale = measurement.substepMicroseconds / substep;
+        fitted.substepPerCylinder *= scale;
+        fitted.substepPerPipe *= scale;
+    }
+
+    // The calibration times the longest response
+    int longest = 0;
+    for (int taps : inputs.impulseResponseTaps) longest = std::max(longest, taps);
+
+    if (longest > 0) {
+        const double direct = convolutionCost(longest, false, reference);
+        if (measurement.directConvolutionMicroseconds > 0) {
+            fitted.directTap *= measurement.directConvolutionMicroseconds / direct;
+        }
+
+        const double partitioned = convolutionCost(longest, true, reference);
+        if (measurement.partitionedConvolutionMicroseconds > 0) {
+            const double scale = measurement.partitionedConvolutionMicroseconds / partitioned;
+            fitted.partitionedFixed *= scale;
+            fitted.partitionedTap *= scale;
+        }
+    }
+
+    return fitted;
+}
+
+std::string CostEstimate::Describe(const Report &report) {
+    std::string description;
+    for (const Term &term : report.terms) {
+        char buffer[96];
+        std::snprintf(buffer, sizeof(buffer), "%s%s %.2f (%s)",
+            description.empty() ? "" : ", ",
+            term.name,
+            term.load,
+            term.setting);
+        description += buffer;
+    }
+
+    return description;
+}
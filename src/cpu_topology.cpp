@@ -0,0 +1,311 @@
+#include "../include/cpu_topology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+bool readLine(const std::string &path, std::string *line) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::getline(file, *line);
+    return true;
+}
+
+bool readInt(const std::string &path, int *value) {
+    std::string line;
+    if (!readLine(path, &line) || line.empty()) return false;
+
+    char *end = nullptr;
+    const long parsed = std::strtol(line.c_str(), &end, 10);
+    if (end == line.c_str()) return false;
+
+    *value = static_cast<int>(parsed);
+    return true;
+}
+
+// Lowest CPU in a cache's shared_cpu_list, which names it
+int readSharedCache(const std::string &cpuDirectory, int level) {
+    for (int index = 0;; ++index) {
+        const std::string cache = cpuDirectory + "/cache/index" + std::to_string(index);
+
+        int cacheLevel = 0;
+        if (!readInt(cache + "/level", &cacheLevel)) return -1;
+        if (cacheLevel != level) continue;
+
+        std::string type;
+        if (readLine(cache + "/type", &type) && type == "Instruction") continue;
+
+        std::string list;
+        std::vector<int> cpus;
+        if (!readLine(cache + "/shared_cpu_list", &list)) return -1;
+        if (!CpuTopology::ParseCpuList(list, &cpus) || cpus.empty()) return -1;
+
+        return *std::min_element(cpus.begin(), cpus.end());
+    }
+}
+
+#if defined(_WIN32)
+void forEachCpu(const GROUP_AFFINITY &affinity, std::vector<CpuTopology::Cpu> *cpus, int CpuTopology::Cpu::*field, int value) {
+    // Only the first processor group, as SetThreadAffinityMask can't reach
+    // the others
+    if (affinity.Group != 0) return;
+
+    for (CpuTopology::Cpu &cpu : *cpus) {
+        if (cpu.id < static_cast<int>(sizeof(KAFFINITY) * 8)
+            && (affinity.Mask & (static_cast<KAFFINITY>(1) << cpu.id)) != 0)
+        {
+            cpu.*field = value;
+        }
+    }
+}
+
+int lowestCpu(const GROUP_AFFINITY &affinity) {
+    for (int i = 0; i < static_cast<int>(sizeof(KAFFINITY) * 8); ++i) {
+        if ((affinity.Mask & (static_cast<KAFFINITY>(1) << i)) != 0) return i;
+    }
+
+    return -1;
+}
+
+bool detectFromWindows(std::vector<CpuTopology::Cpu> *cpus) {
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return false;
+
+    std::vector<char> buffer(length);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info =
+        reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data());
+    if (!GetLogicalProcessorInformationEx(RelationAll, info, &length)) return false;
+
+    const int count = std::min(
+        static_cast<int>(GetActiveProcessorCount(0)),
+        static_cast<int>(sizeof(KAFFINITY) * 8));
+    cpus->resize(count);
+    for (int i = 0; i < count; ++i) (*cpus)[i].id = i;
+
+    int package = 0;
+    for (DWORD offset = 0; offset < length;) {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *entry =
+            reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data() + offset);
+
+        if (entry->Relationship == RelationNumaNode) {
+            forEachCpu(entry->NumaNode.GroupMask, cpus, &CpuTopology::Cpu::node, entry->NumaNode.NodeNumber);
+        }
+        else if (entry->Relationship == RelationProcessorPackage) {
+            for (WORD i = 0; i < entry->Processor.GroupCount; ++i) {
+                forEachCpu(entry->Processor.GroupMask[i], cpus, &CpuTopology::Cpu::package, package);
+            }
+
+            ++package;
+        }
+        else if (entry->Relationship == RelationCache
+            && entry->Cache.Type != CacheInstruction
+            && (entry->Cache.Level == 2 || entry->Cache.Level == 3))
+        {
+            const GROUP_AFFINITY &mask = entry->Cache.GroupMask;
+            forEachCpu(
+                mask,
+                cpus,
+                (entry->Cache.Level == 2) ? &CpuTopology::Cpu::l2 : &CpuTopology::Cpu::l3,
+                lowestCpu(mask));
+        }
+
+        offset += entry->Size;
+    }
+
+    return count > 0;
+}
+#endif
+} /* namespace */
+
+CpuTopology::CpuTopology() {
+    /* void */
+}
+
+CpuTopology::~CpuTopology() {
+    /* void */
+}
+
+void CpuTopology::detect() {
+#if defined(__linux__)
+    if (detectFromSysfs("/sys/devices/system")) return;
+#elif defined(_WIN32)
+    m_cpus.clear();
+    if (detectFromWindows(&m_cpus)) return;
+#endif
+
+    initializeUniform(static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+bool CpuTopology::detectFromSysfs(const std::string &root) {
+    m_cpus.clear();
+
+    std::string online;
+    std::vector<int> ids;
+    if (!readLine(root + "/cpu/online", &online) || !ParseCpuList(online, &ids) || ids.empty()) {
+        return false;
+    }
+
+    std::map<int, int> nodes;
+    for (int node = 0;; ++node) {
+        std::string list;
+        std::vector<int> cpus;
+        if (!readLine(root + "/node/node" + std::to_string(node) + "/cpulist", &list)) break;
+        if (!ParseCpuList(list, &cpus)) continue;
+
+        for (int cpu : cpus) nodes[cpu] = node;
+    }
+
+    for (int id : ids) {
+        const std::string directory = root + "/cpu/cpu" + std::to_string(id);
+
+        Cpu cpu;
+        cpu.id = id;
+        cpu.node = (nodes.count(id) > 0) ? nodes[id] : 0;
+        if (!readInt(directory + "/topology/physical_package_id", &cpu.package)) cpu.package = 0;
+        cpu.l2 = readSharedCache(directory, 2);
+        cpu.l3 = readSharedCache(directory, 3);
+
+        m_cpus.push_back(cpu);
+    }
+
+    return true;
+}
+
+void CpuTopology::initializeUniform(int cpuCount) {
+    m_cpus.clear();
+    for (int i = 0; i < std::max(cpuCount, 1); ++i) {
+        Cpu cpu;
+        cpu.id = i;
+        m_cpus.push_back(cpu);
+    }
+}
+
+int CpuTopology::getNodeCount() const {
+    std::vector<int> nodes;
+    for (const Cpu &cpu : m_cpus) {
+        if (std::find(nodes.begin(), nodes.end(), cpu.node) == nodes.end()) nodes.push_back(cpu.node);
+    }
+
+    return static_cast<int>(nodes.size());
+}
+
+int CpuTopology::getL2GroupCount() const {
+    std::vector<int> groups;
+    for (const Cpu &cpu : m_cpus) {
+        // A CPU of unknown L2 is a group of its own
+        const int group = (cpu.l2 >= 0) ? cpu.l2 : -1 - cpu.id;
+        if (std::find(groups.begin(), groups.end(), group) == groups.end()) groups.push_back(group);
+    }
+
+    return static_cast<int>(groups.size());
+}
+
+std::vector<CpuTopology::Placement> CpuTopology::place(int instances, int threadsPerInstance) const {
+    std::vector<Placement> placements;
+    if (m_cpus.empty() || instances <= 0) return placements;
+
+    // Each node's CPUs, in cache order, cut at L2 boundaries
+    std::map<int, std::vector<std::vector<int>>> nodeGroups;
+    {
+        std::vector<Cpu> sorted = m_cpus;
+        std::sort(sorted.begin(), sorted.end(), [](const Cpu &a, const Cpu &b) {
+            if (a.node != b.node) return a.node < b.node;
+            if (a.l3 != b.l3) return a.l3 < b.l3;
+            if (a.l2 != b.l2) return a.l2 < b.l2;
+            return a.id < b.id;
+        });
+
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            std::vector<std::vector<int>> &groups = nodeGroups[sorted[i].node];
+            const bool newGroup = i == 0
+                || sorted[i].node != sorted[i - 1].node
+                || sorted[i].l2 < 0
+                || sorted[i].l2 != sorted[i - 1].l2;
+            if (newGroup) groups.emplace_back();
+
+            groups.back().push_back(sorted[i].id);
+        }
+    }
+
+    std::vector<int> nodes;
+    for (const auto &entry : nodeGroups) nodes.push_back(entry.first);
+
+    std::map<int, size_t> nextGroup;
+    const size_t wanted = static_cast<size_t>(std::max(threadsPerInstance, 1));
+    for (int i = 0; i < instances; ++i) {
+        Placement placement;
+        placement.node = nodes[i % nodes.size()];
+
+        const std::vector<std::vector<int>> &groups = nodeGroups[placement.node];
+        size_t &next = nextGroup[placement.node];
+        for (size_t taken = 0; placement.cpus.size() < wanted && taken < groups.size(); ++taken) {
+            const std::vector<int> &group = groups[next % groups.size()];
+            placement.cpus.insert(placement.cpus.end(), group.begin(), group.end());
+            ++next;
+        }
+
+        std::sort(placement.cpus.begin(), placement.cpus.end());
+        placements.push_back(placement);
+    }
+
+    return placements;
+}
+
+bool CpuTopology::ParseCpuList(const std::string &list, std::vector<int> *cpus) {
+    cpus->clear();
+
+    const char *p = list.c_str();
+    while (*p != '\0' && *p != '\n') {
+        char *end = nullptr;
+        const long first = std::strtol(p, &end, 10);
+        if (end == p || first < 0) return false;
+
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = std::strtol(p, &end, 10);
+            if (end == p || last < first) return false;
+            p = end;
+        }
+
+        for (long cpu = first; cpu <= last; ++cpu) cpus->push_back(static_cast<int>(cpu));
+
+        if (*p == ',') ++p;
+        else if (*p != '\0' && *p != '\n') return false;
+    }
+
+    return true;
+}
+
+std::string CpuTopology::FormatCpuList(const std::vector<int> &cpus) {
+    std::vector<int> sorted = cpus;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    std::string list;
+    for (size_t i = 0; i < sorted.size();) {
+        size_t j = i;
+        while (j + 1 < sorted.size() && sorted[j + 1] == sorted[j] + 1) ++j;
+
+        char buffer[32];
+        if (j == i) std::snprintf(buffer, sizeof(buffer), "%s%d", list.empty() ? "" : ",", sorted[i]);
+        else std::snprintf(buffer, sizeof(buffer), "%s%d-%d", list.empty() ? "" : ",", sorted[i], sorted[j]);
+        list += buffer;
+
+        i = j + 1;
+    }
+
+    return list;
+}
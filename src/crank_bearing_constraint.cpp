@@ -0,0 +1,54 @@
+#include "../include/crank_bearing_constraint.h"
+
+#include "../include/crankshaft.h"
+
+#include <cfloat>
+
+CrankBearingConstraint::CrankBearingConstraint() : Constraint(2, 1) {
+    m_ks = 5000.0;
+    m_kd = 10.0;
+
+    m_world_x = 0.0;
+    m_world_y = 0.0;
+}
+
+CrankBearingConstraint::~CrankBearingConstraint() {
+    /* void */
+}
+
+void CrankBearingConstraint::connect(Crankshaft *crankshaft) {
+    m_bodies[0] = &crankshaft->m_body;
+    m_world_x = crankshaft->getPosX();
+    m_world_y = crankshaft->getPosY();
+}
+
+void CrankBearingConstraint::calculate(Output *output, atg_scs::SystemState *system) {
+    const int body = m_bodies[0]->index;
+
+    output->C[0] = system->p_x[body] - m_world_x;
+    output->C[1] = system->p_y[body] - m_world_y;
+
+    output->J[0][0] = 1.0;
+    output->J[0][1] = 0.0;
+    output->J[0][2] = 0.0;
+
+    output->J[1][0] = 0.0;
+    output->J[1][1] = 1.0;
+    output->J[1][2] = 0.0;
+
+    output->J_dot[0][0] = 0.0;
+    output->J_dot[0][1] = 0.0;
+    output->J_dot[0][2] = 0.0;
+
+    output->J_dot[1][0] = 0.0;
+    output->J_dot[1][1] = 0.0;
+    output->J_dot[1][2] = 0.0;
+
+    output->ks[0] = output->ks[1] = m_ks;
+    output->kd[0] = output->kd[1] = m_kd;
+
+    output->v_bias[0] = output->v_bias[1] = 0.0;
+
+    output->limits[0][0] = output->limits[1][0] = -DBL_MAX;
+    output->limits[0][1] = output->limits[1][1] = DBL_MAX;
+}
@@ -0,0 +1,231 @@
+#include "../include/crank_slider_model.h"
+
+#include "../include/engine.h"
+#include "../include/constants.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace {
+constexpr int InertiaSamples = 64;
+constexpr double InertiaDerivativeStep = 1E-4;
+} /* namespace */
+
+CrankSliderModel::CrankSliderModel() {
+    m_cylinders = nullptr;
+    m_cylinderCount = 0;
+    m_dt = 0.0;
+}
+
+CrankSliderModel::~CrankSliderModel() {
+    assert(m_cylinders == nullptr);
+}
+
+bool CrankSliderModel::isSupported(const Engine *engine) {
+    if (engine->getCrankshaftCount() <= 0) return false;
+
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        const ConnectingRod *rod = engine->getConnectingRod(i);
+        if (rod->getMasterRod() != nullptr || rod->getRodJournalCount() != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CrankSliderModel::initialize(Engine *engine) {
+    destroy();
+
+    m_cylinderCount = engine->getCylinderCount();
+    m_cylinders = new Cylinder[m_cylinderCount];
+
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        Cylinder &cylinder = m_cylinders[i];
+        cylinder.piston = engine->getPiston(i);
+        cylinder.rod = cylinder.piston->getRod();
+        cylinder.crankshaft = cylinder.rod->getCrankshaft();
+        cylinder.chamber = engine->getChamber(i);
+        cylinder.crankshaft->getRodJournalPositionLocal(
+            cylinder.rod->getJournal(),
+            &cylinder.journal_x,
+            &cylinder.journal_y);
+
+        // The crankshaft carries the cycle-averaged reciprocating inertia;
+        // only the deviation from it is applied as a torque
+        double inertia = 0.0;
+        int samples = 0;
+        for (int j = 0; j < InertiaSamples; ++j) {
+            Pose pose;
+            const double theta = 2 * constants::pi * j / InertiaSamples;
+            if (solve(cylinder, theta, 0.0, 0.0, &pose)) {
+                inertia += pose.inertia;
+                ++samples;
+            }
+        }
+
+        cylinder.meanInertia = (samples > 0) ? inertia / samples : 0.0;
+        cylinder.crankshaft->m_body.I += cylinder.meanInertia;
+    }
+}
+
+void CrankSliderModel::destroy() {
+    delete[] m_cylinders;
+
+    m_cylinders = nullptr;
+    m_cylinderCount = 0;
+}
+
+void CrankSliderModel::place() {
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        Cylinder &cylinder = m_cylinders[i];
+        const atg_scs::RigidBody &body = cylinder.crankshaft->m_body;
+
+        // Crank acceleration lagged by one step; it only scales the
+        // deviation from the mean inertia, which is small next to the
+        // crankshaft's own
+        cylinder.alpha = (cylinder.hasLastOmega && m_dt > 0)
+            ? (body.v_theta - cylinder.lastOmega) / m_dt
+            : 0.0;
+        cylinder.lastOmega = body.v_theta;
+        cylinder.hasLastOmega = true;
+
+        Pose pose;
+        if (solve(cylinder, body.theta, body.p_x, body.p_y, &pose)) {
+            applyPose(cylinder, pose, body.v_theta);
+        }
+    }
+}
+
+void CrankSliderModel::apply(atg_scs::SystemState *system) {
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        const Cylinder &cylinder = m_cylinders[i];
+        const int index = cylinder.crankshaft->m_body.index;
+
+        const double theta = system->theta[index];
+        const double omega = system->v_theta[index];
+        const double c_x = system->p_x[index];
+        const double c_y = system->p_y[index];
+
+        Pose pose, ahead, behind;
+        if (!solve(cylinder, theta, c_x, c_y, &pose)) continue;
+
+        const double force = cylinder.chamber->calculatePistonForce(pose.ds * omega);
+
+        double dInertia = 0.0;
+        if (solve(cylinder, theta + InertiaDerivativeStep, c_x, c_y, &ahead)
+            && solve(cylinder, theta - InertiaDerivativeStep, c_x, c_y, &behind))
+        {
+            dInertia = (ahead.inertia - behind.inertia) / (2 * InertiaDerivativeStep);
+        }
+
+        // Lagrange's equation for the crank angle: generalized gas force
+        // less the dI/d(theta) * omega^2 / 2 and I * alpha reactions
+        const double torque =
+            force * pose.ds
+            - 0.5 * dInertia * omega * omega
+            - (pose.inertia - cylinder.meanInertia) * cylinder.alpha;
+
+        // A couple: unit lever arm plus an opposing force at the axis
+        const double f_x = -torque * std::sin(theta);
+        const double f_y = torque * std::cos(theta);
+        system->applyForce(1.0, 0.0, f_x, f_y, index);
+        system->applyForce(0.0, 0.0, -f_x, -f_y, index);
+    }
+}
+
+bool CrankSliderModel::solve(
+    const Cylinder &cylinder,
+    double theta,
+    double c_x,
+    double c_y,
+    Pose *pose) const
+{
+    const Piston *piston = cylinder.piston;
+    const ConnectingRod *rod = cylinder.rod;
+    const CylinderBank *bank = piston->getCylinderBank();
+
+    const double d_x = bank->getDx();
+    const double d_y = bank->getDy();
+
+    // Crank pin and its velocity per unit crank speed
+    const double cos_theta = std::cos(theta);
+    const double sin_theta = std::sin(theta);
+    const double j_x = cos_theta * cylinder.journal_x - sin_theta * cylinder.journal_y;
+    const double j_y = sin_theta * cylinder.journal_x + cos_theta * cylinder.journal_y;
+    const double p_x = c_x + j_x;
+    const double p_y = c_y + j_y;
+    const double pv_x = -j_y;
+    const double pv_y = j_x;
+
+    // Wrist pin on the bore axis at distance s from the bank origin, one
+    // rod length from the crank pin (same root as placeCylinder())
+    const double length = rod->getLittleEndLocal() - rod->getBigEndLocal();
+    const double b_x = bank->getX() - p_x;
+    const double b_y = bank->getY() - p_y;
+
+    const double a = d_x * d_x + d_y * d_y;
+    const double b = 2 * (d_x * b_x + d_y * b_y);
+    const double c = b_x * b_x + b_y * b_y - length * length;
+    const double det = b * b - 4 * a * c;
+    if (det < 0) return false;
+
+    const double s = (-b + std::sqrt(det)) / (2 * a);
+
+    const double r_x = b_x + s * d_x;
+    const double r_y = b_y + s * d_y;
+    const double r_d = r_x * d_x + r_y * d_y;
+    if (std::abs(r_d) < 1E-9) return false;
+
+    // |r| is constant, so r . (ds * d - pv) = 0
+    const double ds = (r_x * pv_x + r_y * pv_y) / r_d;
+    const double rv_x = ds * d_x - pv_x;
+    const double rv_y = ds * d_y - pv_y;
+    const double r2 = r_x * r_x + r_y * r_y;
+    const double rod_omega = (r_x * rv_y - r_y * rv_x) / r2;
+
+    const double r_len = std::sqrt(r2);
+    const double u_x = r_x / r_len;
+    const double u_y = r_y / r_len;
+    const double bigEnd = rod->getBigEndLocal();
+
+    pose->rod_theta = std::atan2(r_y, r_x) - constants::pi / 2;
+    pose->rod_x = p_x - bigEnd * u_x;
+    pose->rod_y = p_y - bigEnd * u_y;
+    pose->rod_vx = pv_x + bigEnd * rod_omega * u_y;
+    pose->rod_vy = pv_y - bigEnd * rod_omega * u_x;
+    pose->rod_omega = rod_omega;
+
+    const double pistonTheta = bank->getAngle() + constants::pi;
+    const double wristPin = piston->getWristPinLocation();
+    pose->piston_x = bank->getX() + s * d_x + wristPin * std::sin(pistonTheta);
+    pose->piston_y = bank->getY() + s * d_y - wristPin * std::cos(pistonTheta);
+    pose->ds = ds;
+
+    pose->inertia =
+        piston->getMass() * ds * ds * a
+        + rod->getMass() * (pose->rod_vx * pose->rod_vx + pose->rod_vy * pose->rod_vy)
+        + rod->getMomentOfInertia() * rod_omega * rod_omega;
+
+    return true;
+}
+
+void CrankSliderModel::applyPose(const Cylinder &cylinder, const Pose &pose, double omega) {
+    atg_scs::RigidBody &piston = cylinder.piston->m_body;
+    atg_scs::RigidBody &rod = cylinder.rod->m_body;
+    const CylinderBank *bank = cylinder.piston->getCylinderBank();
+
+    piston.p_x = pose.piston_x;
+    piston.p_y = pose.piston_y;
+    piston.theta = bank->getAngle() + constants::pi;
+    piston.v_x = pose.ds * omega * bank->getDx();
+    piston.v_y = pose.ds * omega * bank->getDy();
+    piston.v_theta = 0.0;
+
+    rod.p_x = pose.rod_x;
+    rod.p_y = pose.rod_y;
+    rod.theta = pose.rod_theta;
+    rod.v_x = pose.rod_vx * omega;
+    rod.v_y = pose.rod_vy * omega;
+    rod.v_theta = pose.rod_omega * omega;
+}
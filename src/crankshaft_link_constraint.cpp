@@ -0,0 +1,53 @@
+#include "../include/crankshaft_link_constraint.h"
+
+#include "../include/crankshaft.h"
+
+#include <cfloat>
+
+CrankshaftLinkConstraint::CrankshaftLinkConstraint() : Constraint(1, 2) {
+    m_ks = 5000.0;
+    m_kd = 10.0;
+
+    m_offset = 0.0;
+}
+
+CrankshaftLinkConstraint::~CrankshaftLinkConstraint() {
+    /* void */
+}
+
+void CrankshaftLinkConstraint::connect(Crankshaft *outputShaft, Crankshaft *crankshaft) {
+    m_bodies[0] = &outputShaft->m_body;
+    m_bodies[1] = &crankshaft->m_body;
+    m_offset = crankshaft->m_body.theta - outputShaft->m_body.theta;
+}
+
+void CrankshaftLinkConstraint::calculate(Output *output, atg_scs::SystemState *system) {
+    const double theta0 = system->theta[m_bodies[0]->index];
+    const double theta1 = system->theta[m_bodies[1]->index];
+
+    output->C[0] = theta1 - theta0 - m_offset;
+
+    output->J[0][0] = 0.0;
+    output->J[0][1] = 0.0;
+    output->J[0][2] = -1.0;
+
+    output->J[0][3] = 0.0;
+    output->J[0][4] = 0.0;
+    output->J[0][5] = 1.0;
+
+    output->J_dot[0][0] = 0.0;
+    output->J_dot[0][1] = 0.0;
+    output->J_dot[0][2] = 0.0;
+
+    output->J_dot[0][3] = 0.0;
+    output->J_dot[0][4] = 0.0;
+    output->J_dot[0][5] = 0.0;
+
+    output->ks[0] = m_ks;
+    output->kd[0] = m_kd;
+
+    output->v_bias[0] = 0.0;
+
+    output->limits[0][0] = -DBL_MAX;
+    output->limits[0][1] = DBL_MAX;
+}
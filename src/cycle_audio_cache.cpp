@@ -0,0 +1,196 @@
+#include "../include/cycle_audio_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+CycleAudioCache::CycleAudioCache() {
+    m_channels = 0;
+    m_state = State::Watching;
+
+    m_periodCount = 0;
+    m_periodIndex = 0;
+    m_cycleSteps = -1;
+
+    m_capturedFrames = 0;
+    m_capturedCycles = 0;
+    m_loopFrames = 0;
+    m_crossfade = 0;
+
+    m_position = 0;
+    m_gain = m_previousGain = 1.0;
+    m_fade = 0;
+    m_replayedFrames = 0;
+}
+
+CycleAudioCache::~CycleAudioCache() {
+    /* void */
+}
+
+void CycleAudioCache::initialize(const Parameters &params, int channels) {
+    m_parameters = params;
+    m_parameters.steadyCycles = std::min(std::max(params.steadyCycles, 1), MaxSteadyCycles);
+    m_parameters.captureCycles = std::max(params.captureCycles, 1);
+    m_parameters.crossfadeFrames = std::max(params.crossfadeFrames, 1);
+    m_parameters.maxFrames = std::max(params.maxFrames, 2);
+
+    m_channels = std::max(channels, 0);
+    m_frames.assign((size_t)m_parameters.maxFrames * m_channels, 0.0);
+    m_output.assign(m_channels, 0.0);
+    m_replayedFrames = 0;
+
+    m_state = State::Watching;
+    interrupt();
+}
+
+void CycleAudioCache::destroy() {
+    m_frames.clear();
+    m_frames.shrink_to_fit();
+    m_output.clear();
+    m_channels = 0;
+    m_state = State::Watching;
+}
+
+void CycleAudioCache::seed(uint64_t seed) {
+    m_random.seed(seed, 0);
+}
+
+void CycleAudioCache::interrupt() {
+    m_periodCount = 0;
+    m_periodIndex = 0;
+    m_cycleSteps = -1;
+
+    if (m_state == State::Replaying) {
+        m_state = State::Resuming;
+        m_fade = m_crossfade;
+    }
+    else if (m_state != State::Resuming) {
+        m_state = State::Watching;
+    }
+}
+
+void CycleAudioCache::processLiveFrame(double *frame, bool cycleStart, const CycleStatistics &statistics) {
+    if (m_channels <= 0 || m_state == State::Replaying) return;
+
+    if (cycleStart) {
+        if (m_cycleSteps > 0) {
+            m_periods[m_periodIndex] = m_cycleSteps;
+            m_periodIndex = (m_periodIndex + 1) % m_parameters.steadyCycles;
+            m_periodCount = std::min(m_periodCount + 1, m_parameters.steadyCycles);
+        }
+
+        m_cycleSteps = 0;
+    }
+
+    if (m_cycleSteps >= 0) ++m_cycleSteps;
+
+    if (m_state == State::Resuming) {
+        const double *replay = replayFrame();
+        const double w = (double)m_fade / (m_crossfade + 1);
+        for (int c = 0; c < m_channels; ++c) {
+            frame[c] = (1 - w) * frame[c] + w * replay[c];
+        }
+
+        if (--m_fade <= 0) {
+            m_state = State::Watching;
+        }
+
+        return;
+    }
+
+    if (m_state == State::Watching) {
+        if (!cycleStart || !isSteady(statistics)) return;
+
+        startCapture();
+    }
+    else if (cycleStart && m_loopFrames == 0 && ++m_capturedCycles == m_parameters.captureCycles) {
+        // The rest is the continuation the loop's end crossfades into
+        m_loopFrames = m_capturedFrames;
+        m_crossfade = std::min(m_parameters.crossfadeFrames, m_loopFrames / 2);
+    }
+
+    if (m_capturedFrames >= m_parameters.maxFrames) {
+        m_state = State::Watching;
+        return;
+    }
+
+    std::copy(frame, frame + m_channels, m_frames.data() + (size_t)m_capturedFrames * m_channels);
+    ++m_capturedFrames;
+
+    if (m_loopFrames > 0 && m_capturedFrames >= m_loopFrames + m_crossfade) {
+        // The live signal stopped at the crossfade's phase of the loop
+        m_state = State::Replaying;
+        m_position = m_crossfade;
+        m_gain = m_previousGain = 1.0;
+    }
+}
+
+const double *CycleAudioCache::nextReplayFrame() {
+    ++m_replayedFrames;
+    return replayFrame();
+}
+
+bool CycleAudioCache::isSteady(const CycleStatistics &statistics) const {
+    const int n = m_parameters.steadyCycles;
+    if (m_periodCount < n || statistics.getHistoryCount() < n) return false;
+
+    int shortest = m_periods[0], longest = m_periods[0];
+    double periodSum = 0;
+    for (int i = 0; i < n; ++i) {
+        shortest = std::min(shortest, m_periods[i]);
+        longest = std::max(longest, m_periods[i]);
+        periodSum += m_periods[i];
+    }
+
+    if (longest - shortest > m_parameters.periodTolerance * periodSum / n) return false;
+
+    double imepSum = 0;
+    for (int i = 0; i < n; ++i) imepSum += statistics.getCycle(i).imep;
+
+    const double mean = imepSum / n;
+    if (n < 2 || std::abs(mean) < 1E-9) return true;
+
+    double variance = 0;
+    for (int i = 0; i < n; ++i) {
+        const double d = statistics.getCycle(i).imep - mean;
+        variance += d * d;
+    }
+
+    return std::sqrt(variance / (n - 1)) <= m_parameters.imepTolerance * std::abs(mean);
+}
+
+void CycleAudioCache::startCapture() {
+    m_state = State::Capturing;
+    m_capturedFrames = 0;
+    m_capturedCycles = 0;
+    m_loopFrames = 0;
+    m_crossfade = 0;
+}
+
+const double *CycleAudioCache::replayFrame() {
+    const int i = m_position;
+    const double *loop = m_frames.data() + (size_t)i * m_channels;
+
+    if (i < m_crossfade) {
+        // Blends from the continuation of the loop's end into its start,
+        // and from the last pass's gain to this one's
+        const double *continuation = m_frames.data() + (size_t)(m_loopFrames + i) * m_channels;
+        const double w = (double)(i + 1) / (m_crossfade + 1);
+        const double gain = m_previousGain + w * (m_gain - m_previousGain);
+        for (int c = 0; c < m_channels; ++c) {
+            m_output[c] = gain * (w * loop[c] + (1 - w) * continuation[c]);
+        }
+    }
+    else {
+        for (int c = 0; c < m_channels; ++c) {
+            m_output[c] = m_gain * loop[c];
+        }
+    }
+
+    if (++m_position >= m_loopFrames) {
+        m_position = 0;
+        m_previousGain = m_gain;
+        m_gain = 1.0 + m_parameters.gainJitter * (2 * m_random.uniform() - 1);
+    }
+
+    return m_output.data();
+}
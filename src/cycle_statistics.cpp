@@ -0,0 +1,161 @@
+#include "../include/cycle_statistics.h"
+
+#include "../include/constants.h"
+
+#include <algorithm>
+#include <cmath>
+
+CycleStatistics::CycleStatistics() {
+    reset();
+}
+
+void CycleStatistics::reset() {
+    for (int c = 0; c < ChannelCount; ++c) {
+        std::fill(m_bins[c], m_bins[c] + Bins, 0.0);
+        m_sums[c] = 0.0;
+    }
+
+    m_lastBin = -1;
+    m_cycleStart = false;
+
+    m_cycleStarted = false;
+    m_hasPrevious = false;
+    m_previousPressure = 0.0;
+    m_previousVolume = 0.0;
+    m_work = 0.0;
+    m_minVolume = 0.0;
+    m_maxVolume = 0.0;
+    m_peakPressure = 0.0;
+    m_peakPressureAngle = 0.0;
+
+    for (Cycle &cycle : m_history) cycle = Cycle();
+    m_historyIndex = 0;
+    m_historyCount = 0;
+    m_cycles = 0;
+}
+
+void CycleStatistics::addSample(double cycleAngle, int direction, const double values[ChannelCount]) {
+    const int bin = std::min(
+        std::max(static_cast<int>(std::floor(Bins * cycleAngle / (4 * constants::pi))), 0),
+        Bins - 1);
+    const int step = (direction < 0) ? -1 : 1;
+
+    // Bins the crank passed since the last step take this step's values
+    if (m_lastBin < 0) {
+        writeBin(bin, values);
+    }
+    else {
+        const int gap = (step * (bin - m_lastBin) + Bins) % Bins;
+        for (int i = 1; i <= gap; ++i) {
+            writeBin((m_lastBin + step * i + Bins) % Bins, values);
+        }
+
+        if (gap == 0) writeBin(bin, values);
+    }
+
+    const bool wrapped = m_lastBin >= 0 && ((step > 0) ? bin < m_lastBin : bin > m_lastBin);
+    m_lastBin = bin;
+    m_cycleStart = wrapped;
+
+    if (wrapped) completeCycle();
+
+    const double pressure = values[static_cast<int>(Channel::CylinderPressure)];
+    const double volume = values[static_cast<int>(Channel::CylinderVolume)];
+    if (m_hasPrevious) {
+        m_work += 0.5 * (pressure + m_previousPressure) * (volume - m_previousVolume);
+        m_minVolume = std::min(m_minVolume, volume);
+        m_maxVolume = std::max(m_maxVolume, volume);
+    }
+    else {
+        m_minVolume = m_maxVolume = volume;
+        m_hasPrevious = true;
+    }
+
+    if (pressure > m_peakPressure) {
+        m_peakPressure = pressure;
+        m_peakPressureAngle = cycleAngle;
+    }
+
+    m_previousPressure = pressure;
+    m_previousVolume = volume;
+}
+
+double CycleStatistics::GetBinAngle(int bin) {
+    return (bin + 0.5) * 4 * constants::pi / Bins;
+}
+
+const CycleStatistics::Cycle &CycleStatistics::getCycle(int i) const {
+    return m_history[(m_historyIndex - 1 - i + 2 * HistoryCycles) % HistoryCycles];
+}
+
+double CycleStatistics::getMeanImep() const {
+    if (m_historyCount == 0) return 0.0;
+
+    double sum = 0.0;
+    for (int i = 0; i < m_historyCount; ++i) sum += getCycle(i).imep;
+
+    return sum / m_historyCount;
+}
+
+double CycleStatistics::getImepCoefficientOfVariation() const {
+    if (m_historyCount < 2) return 0.0;
+
+    const double mean = getMeanImep();
+    double variance = 0.0;
+    for (int i = 0; i < m_historyCount; ++i) {
+        const double d = getCycle(i).imep - mean;
+        variance += d * d;
+    }
+
+    variance /= (m_historyCount - 1);
+
+    return (std::abs(mean) > 1E-9) ? std::sqrt(variance) / std::abs(mean) : 0.0;
+}
+
+double CycleStatistics::getMeanPeakPressure() const {
+    if (m_historyCount == 0) return 0.0;
+
+    double sum = 0.0;
+    for (int i = 0; i < m_historyCount; ++i) sum += getCycle(i).peakPressure;
+
+    return sum / m_historyCount;
+}
+
+void CycleStatistics::writeBin(int bin, const double values[ChannelCount]) {
+    for (int c = 0; c < ChannelCount; ++c) {
+        m_sums[c] += values[c] - m_bins[c][bin];
+        m_bins[c][bin] = values[c];
+    }
+}
+
+void CycleStatistics::completeCycle() {
+    // Once a cycle, so rounding in the running sums can't build up
+    resum();
+
+    const double displacement = m_maxVolume - m_minVolume;
+    if (m_cycleStarted && displacement > 0) {
+        Cycle &cycle = m_history[m_historyIndex];
+        cycle.imep = m_work / displacement;
+        cycle.peakPressure = m_peakPressure;
+        cycle.peakPressureAngle = m_peakPressureAngle;
+        cycle.torque = getAverage(Channel::Torque);
+
+        m_historyIndex = (m_historyIndex + 1) % HistoryCycles;
+        m_historyCount = std::min(m_historyCount + 1, HistoryCycles);
+        ++m_cycles;
+    }
+
+    m_cycleStarted = true;
+    m_work = 0.0;
+    m_minVolume = m_maxVolume = m_previousVolume;
+    m_peakPressure = 0.0;
+    m_peakPressureAngle = 0.0;
+}
+
+void CycleStatistics::resum() {
+    for (int c = 0; c < ChannelCount; ++c) {
+        double sum = 0.0;
+        for (int i = 0; i < Bins; ++i) sum += m_bins[c][i];
+        m_sums[c] = sum;
+    }
+}
@@ -11,7 +11,7 @@ CylinderBankObject::~CylinderBankObject() {
     /* void */
 }
 
-void CylinderBankObject::generateGeometry() {
+void CylinderBankObject::generateStaticGeometry() {
     const double s = m_bank->getBore() / 2.0;
     const double boreSurfaceArea =
         constants::pi * m_bank->getBore() * m_bank->getBore() / 4.0;
@@ -38,7 +38,7 @@ void CylinderBankObject::generateGeometry() {
 
     GeometryGenerator::Circle2dParameters circleParams;
     circleParams.radius = lineWidth / 2.0f;
-    circleParams.maxEdgeLength = m_app->pixelsToUnits(5.0f);
+    circleParams.maxEdgeLength = m_app->viewPixelsToUnits(5.0f);
 
     gen->startShape();
 
@@ -79,6 +79,22 @@ void CylinderBankObject::render(const ViewParameters *view) {
     m_app->drawGenerated(m_walls, 0x0);
 }
 
+bool CylinderBankObject::getWorldBounds(Bounds *bounds) const {
+    const double chamberHeight = m_head->getCombustionChamberVolume() / m_bank->boreSurfaceArea();
+    const double displayDepth = 1.0 - m_bank->getDisplayDepth();
+    const double top = m_bank->getDeckHeight() + chamberHeight;
+    const double bottom = displayDepth * m_bank->getDeckHeight();
+
+    // The walls are a bore and a bit apart
+    *bounds = Bounds(
+        (float)(m_bank->getX() + m_bank->getDx() * top),
+        (float)(m_bank->getX() + m_bank->getDx() * bottom),
+        (float)(m_bank->getY() + m_bank->getDy() * top),
+        (float)(m_bank->getY() + m_bank->getDy() * bottom))
+        .grow((float)m_bank->getBore());
+    return true;
+}
+
 void CylinderBankObject::process(float dt) {
     /* void */
 }
@@ -0,0 +1,281 @@
+#include "../include/cylinder_constraint_batch.h"
+
+#include <assert.h>
+#include <cfloat>
+#include <cmath>
+
+CylinderConstraintBatch::Proxy::Proxy(int constraintCount, int bodyCount)
+    : atg_scs::Constraint(constraintCount, bodyCount)
+{
+    m_batch = nullptr;
+    m_kind = Kind::Wall;
+    m_cylinder = 0;
+}
+
+CylinderConstraintBatch::Proxy::~Proxy() {
+    /* void */
+}
+
+void CylinderConstraintBatch::Proxy::calculate(Output *output, atg_scs::SystemState *state) {
+    if (m_kind == Kind::LittleEnd && m_cylinder == 0) {
+        m_batch->evaluate(state);
+    }
+
+    m_batch->write(this, output);
+}
+
+CylinderConstraintBatch::CylinderConstraintBatch() {
+    m_links = nullptr;
+    m_walls = nullptr;
+    m_buffer = nullptr;
+
+    m_littleEnd_y = m_wristPin_y = m_bigEnd_y = nullptr;
+    m_journal_x = m_journal_y = nullptr;
+    m_wallNormal_x = m_wallNormal_y = m_wallOffset = nullptr;
+
+    m_piston_x = m_piston_y = m_piston_theta = m_piston_omega = nullptr;
+    m_rod_x = m_rod_y = m_rod_theta = m_rod_omega = nullptr;
+    m_journal_px = m_journal_py = m_journal_theta = m_journal_omega = nullptr;
+
+    m_C_little_x = m_C_little_y = m_C_big_x = m_C_big_y = m_C_wall = nullptr;
+    m_r_x = m_r_y = m_w_x = m_w_y = m_b_x = m_b_y = m_j_x = m_j_y = nullptr;
+
+    m_ks = 5000.0;
+    m_kd = 10.0;
+    m_cylinderCount = 0;
+}
+
+CylinderConstraintBatch::~CylinderConstraintBatch() {
+    assert(m_buffer == nullptr);
+}
+
+void CylinderConstraintBatch::initialize(int cylinderCount) {
+    destroy();
+
+    constexpr int Streams = 33;
+    m_cylinderCount = cylinderCount;
+    m_links = new LinkProxy[(size_t)cylinderCount * 2];
+    m_walls = new WallProxy[cylinderCount];
+    m_buffer = new double[(size_t)Streams * cylinderCount];
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        Proxy *proxies[] = { getLittleEnd(i), getBigEnd(i), getWall(i) };
+        const Kind kinds[] = { Kind::LittleEnd, Kind::BigEnd, Kind::Wall };
+        for (int j = 0; j < 3; ++j) {
+            proxies[j]->m_batch = this;
+            proxies[j]->m_kind = kinds[j];
+            proxies[j]->m_cylinder = i;
+        }
+    }
+
+    double *stream = m_buffer;
+    double **streams[] = {
+        &m_littleEnd_y, &m_wristPin_y, &m_bigEnd_y, &m_journal_x, &m_journal_y,
+        &m_wallNormal_x, &m_wallNormal_y, &m_wallOffset,
+        &m_piston_x, &m_piston_y, &m_piston_theta, &m_piston_omega,
+        &m_rod_x, &m_rod_y, &m_rod_theta, &m_rod_omega,
+        &m_journal_px, &m_journal_py, &m_journal_theta, &m_journal_omega,
+        &m_C_little_x, &m_C_little_y, &m_C_big_x, &m_C_big_y, &m_C_wall,
+        &m_r_x, &m_r_y, &m_w_x, &m_w_y, &m_b_x, &m_b_y, &m_j_x, &m_j_y
+    };
+
+    static_assert(sizeof(streams) / sizeof(streams[0]) == Streams, "stream count");
+    for (double **s : streams) {
+        *s = stream;
+        stream += cylinderCount;
+    }
+
+    for (int i = 0; i < Streams * cylinderCount; ++i) m_buffer[i] = 0.0;
+}
+
+void CylinderConstraintBatch::destroy() {
+    if (m_links != nullptr) delete[] m_links;
+    if (m_walls != nullptr) delete[] m_walls;
+    if (m_buffer != nullptr) delete[] m_buffer;
+
+    m_links = nullptr;
+    m_walls = nullptr;
+    m_buffer = nullptr;
+    m_cylinderCount = 0;
+}
+
+void CylinderConstraintBatch::setLittleEnd(
+    int cylinder,
+    atg_scs::RigidBody *rod,
+    atg_scs::RigidBody *piston,
+    double rodLocal_y,
+    double pistonLocal_y)
+{
+    LinkProxy *link = getLittleEnd(cylinder);
+    link->m_bodies[0] = rod;
+    link->m_bodies[1] = piston;
+
+    getBigEnd(cylinder)->m_bodies[0] = rod;
+    getWall(cylinder)->m_bodies[0] = piston;
+
+    m_littleEnd_y[cylinder] = rodLocal_y;
+    m_wristPin_y[cylinder] = pistonLocal_y;
+}
+
+void CylinderConstraintBatch::setBigEnd(
+    int cylinder,
+    atg_scs::RigidBody *journalBody,
+    double rodLocal_y,
+    double journal_x,
+    double journal_y)
+{
+    getBigEnd(cylinder)->m_bodies[1] = journalBody;
+
+    m_bigEnd_y[cylinder] = rodLocal_y;
+    m_journal_x[cylinder] = journal_x;
+    m_journal_y[cylinder] = journal_y;
+}
+
+void CylinderConstraintBatch::setWall(
+    int cylinder,
+    double d_x,
+    double d_y,
+    double p0_x,
+    double p0_y)
+{
+    m_wallNormal_x[cylinder] = -d_y;
+    m_wallNormal_y[cylinder] = d_x;
+    m_wallOffset[cylinder] = -d_y * p0_x + d_x * p0_y;
+}
+
+void CylinderConstraintBatch::setStiffness(double ks, double kd) {
+    m_ks = ks;
+    m_kd = kd;
+}
+
+void CylinderConstraintBatch::evaluate(atg_scs::SystemState *state) {
+    const int n = m_cylinderCount;
+
+    // The only scattered reads; everything after runs down the streams
+    for (int i = 0; i < n; ++i) {
+        const int piston = m_walls[i].m_bodies[0]->index;
+        const int rod = m_links[i * 2 + 0].m_bodies[0]->index;
+        const int journal = m_links[i * 2 + 1].m_bodies[1]->index;
+
+        m_piston_x[i] = state->p_x[piston];
+        m_piston_y[i] = state->p_y[piston];
+        m_piston_theta[i] = state->theta[piston];
+        m_piston_omega[i] = state->v_theta[piston];
+
+        m_rod_x[i] = state->p_x[rod];
+        m_rod_y[i] = state->p_y[rod];
+        m_rod_theta[i] = state->theta[rod];
+        m_rod_omega[i] = state->v_theta[rod];
+
+        m_journal_px[i] = state->p_x[journal];
+        m_journal_py[i] = state->p_y[journal];
+        m_journal_theta[i] = state->theta[journal];
+        m_journal_omega[i] = state->v_theta[journal];
+    }
+
+    // World offsets of the attachment points from their bodies' origins
+    for (int i = 0; i < n; ++i) {
+        const double cos_rod = std::cos(m_rod_theta[i]);
+        const double sin_rod = std::sin(m_rod_theta[i]);
+        const double cos_piston = std::cos(m_piston_theta[i]);
+        const double sin_piston = std::sin(m_piston_theta[i]);
+        const double cos_journal = std::cos(m_journal_theta[i]);
+        const double sin_journal = std::sin(m_journal_theta[i]);
+
+        m_r_x[i] = -sin_rod * m_littleEnd_y[i];
+        m_r_y[i] = cos_rod * m_littleEnd_y[i];
+        m_b_x[i] = -sin_rod * m_bigEnd_y[i];
+        m_b_y[i] = cos_rod * m_bigEnd_y[i];
+        m_w_x[i] = -sin_piston * m_wristPin_y[i];
+        m_w_y[i] = cos_piston * m_wristPin_y[i];
+        m_j_x[i] = cos_journal * m_journal_x[i] - sin_journal * m_journal_y[i];
+        m_j_y[i] = sin_journal * m_journal_x[i] + cos_journal * m_journal_y[i];
+    }
+
+    for (int i = 0; i < n; ++i) {
+        const double w_x = m_piston_x[i] + m_w_x[i];
+        const double w_y = m_piston_y[i] + m_w_y[i];
+
+        m_C_little_x[i] = m_rod_x[i] + m_r_x[i] - w_x;
+        m_C_little_y[i] = m_rod_y[i] + m_r_y[i] - w_y;
+        m_C_big_x[i] = m_rod_x[i] + m_b_x[i] - (m_journal_px[i] + m_j_x[i]);
+        m_C_big_y[i] = m_rod_y[i] + m_b_y[i] - (m_journal_py[i] + m_j_y[i]);
+        m_C_wall[i] = m_wallNormal_x[i] * w_x + m_wallNormal_y[i] * w_y - m_wallOffset[i];
+    }
+}
+
+void CylinderConstraintBatch::write(const Proxy *proxy, atg_scs::Constraint::Output *output) const {
+    const int i = proxy->m_cylinder;
+
+    if (proxy->m_kind == Kind::Wall) {
+        const double n_x = m_wallNormal_x[i];
+        const double n_y = m_wallNormal_y[i];
+        const double omega = m_piston_omega[i];
+
+        output->C[0] = m_C_wall[i];
+
+        output->J[0][0] = n_x;
+        output->J[0][1] = n_y;
+        output->J[0][2] = -n_x * m_w_y[i] + n_y * m_w_x[i];
+
+        output->J_dot[0][0] = 0.0;
+        output->J_dot[0][1] = 0.0;
+        output->J_dot[0][2] = -omega * (n_x * m_w_x[i] + n_y * m_w_y[i]);
+
+        output->ks[0] = m_ks;
+        output->kd[0] = m_kd;
+        output->v_bias[0] = 0.0;
+        output->limits[0][0] = -DBL_MAX;
+        output->limits[0][1] = DBL_MAX;
+
+        return;
+    }
+
+    // Body 1 is the rod at offset a, body 2 the piston or journal at b
+    const bool littleEnd = proxy->m_kind == Kind::LittleEnd;
+    const double a_x = littleEnd ? m_r_x[i] : m_b_x[i];
+    const double a_y = littleEnd ? m_r_y[i] : m_b_y[i];
+    const double b_x = littleEnd ? m_w_x[i] : m_j_x[i];
+    const double b_y = littleEnd ? m_w_y[i] : m_j_y[i];
+    const double omega_a = m_rod_omega[i];
+    const double omega_b = littleEnd ? m_piston_omega[i] : m_journal_omega[i];
+
+    output->C[0] = littleEnd ? m_C_little_x[i] : m_C_big_x[i];
+    output->C[1] = littleEnd ? m_C_little_y[i] : m_C_big_y[i];
+
+    output->J[0][0] = 1.0;
+    output->J[0][1] = 0.0;
+    output->J[0][2] = -a_y;
+    output->J[0][3] = -1.0;
+    output->J[0][4] = 0.0;
+    output->J[0][5] = b_y;
+
+    output->J[1][0] = 0.0;
+    output->J[1][1] = 1.0;
+    output->J[1][2] = a_x;
+    output->J[1][3] = 0.0;
+    output->J[1][4] = -1.0;
+    output->J[1][5] = -b_x;
+
+    output->J_dot[0][0] = 0.0;
+    output->J_dot[0][1] = 0.0;
+    output->J_dot[0][2] = -a_x * omega_a;
+    output->J_dot[0][3] = 0.0;
+    output->J_dot[0][4] = 0.0;
+    output->J_dot[0][5] = b_x * omega_b;
+
+    output->J_dot[1][0] = 0.0;
+    output->J_dot[1][1] = 0.0;
+    output->J_dot[1][2] = -a_y * omega_a;
+    output->J_dot[1][3] = 0.0;
+    output->J_dot[1][4] = 0.0;
+    output->J_dot[1][5] = b_y * omega_b;
+
+    for (int j = 0; j < 2; ++j) {
+        output->ks[j] = m_ks;
+        output->kd[j] = m_kd;
+        output->v_bias[j] = 0.0;
+        output->limits[j][0] = -DBL_MAX;
+        output->limits[j][1] = DBL_MAX;
+    }
+}
@@ -49,13 +49,19 @@ void CylinderHead::destroy() {
 }
 
 double CylinderHead::intakeFlowRate(int cylinder) const {
-    return m_intakePortFlow->sampleTriangle(
-            intakeValveLift(cylinder));
+    return intakeFlowRateAtLift(intakeValveLift(cylinder));
 }
 
 double CylinderHead::exhaustFlowRate(int cylinder) const {
-    return m_exhaustPortFlow->sampleTriangle(
-            exhaustValveLift(cylinder));
+    return exhaustFlowRateAtLift(exhaustValveLift(cylinder));
+}
+
+double CylinderHead::intakeFlowRateAtLift(double lift) const {
+    return m_intakePortFlow->sampleTriangle(lift);
+}
+
+double CylinderHead::exhaustFlowRateAtLift(double lift) const {
+    return m_exhaustPortFlow->sampleTriangle(lift);
 }
 
 double CylinderHead::intakeValveLift(int cylinder) const {
@@ -13,50 +13,9 @@ CylinderHeadObject::~CylinderHeadObject() {
     /* void */
 }
 
-void CylinderHeadObject::generateGeometry() {
-    /* void */
-}
-
-void CylinderHeadObject::render(const ViewParameters *view) {
-    if (view->Sublayer != 0) return;
-
-    resetShader();
-
-    CylinderBank *bank = m_head->getCylinderBank();
-    const double s = (float)bank->getBore() / 2.0f;
-    const double boreSurfaceArea =
-        constants::pi * bank->getBore() * bank->getBore() / 4.0;
-    const double chamberHeight = m_head->getCombustionChamberVolume() / boreSurfaceArea;
-
-    Piston *frontmostPiston = getForemostPiston(bank, view->Layer0);
-    if (frontmostPiston == nullptr) return;
+void CylinderHeadObject::generateStaticGeometry() {
+    const double s = (float)m_head->getCylinderBank()->getBore() / 2.0f;
 
-    const double theta = bank->getAngle();
-    double x, y;
-    bank->getPositionAboveDeck(chamberHeight, &x, &y);
-
-    const ysMatrix scale = ysMath::ScaleTransform(ysMath::LoadScalar((float)s));
-    const ysMatrix rotation = ysMath::RotationTransform(
-            ysMath::Constants::ZAxis, (float)theta);
-    const ysMatrix translation = ysMath::TranslationTransform(
-            ysMath::LoadVector((float)x, (float)y));
-    const ysMatrix T_headObject = ysMath::MatMult(translation, rotation);
-    const ysMatrix T_head = ysMath::MatMult(
-            T_headObject,
-            scale);
-
-    const ysVector col = m_app->getPink();  ysMath::Add(
-        ysMath::Mul(m_app->getForegroundColor(), ysMath::LoadScalar(0.01f)),
-        ysMath::Mul(m_app->getBackgroundColor(), ysMath::LoadScalar(0.99f))
-    );
-    const ysVector moving = m_app->getForegroundColor();
-
-    GeometryGenerator::GeometryIndices
-        valveShadow,
-        valveRoller,
-        valveRollerShadow,
-        valveRollerPin,
-        camCenter;
     GeometryGenerator *gen = m_app->getGeometryGenerator();
     GeometryGenerator::Line2dParameters params;
 
@@ -91,33 +50,80 @@ void CylinderHeadObject::render(const ViewParameters *view) {
     params.x1 = 0.5f;
     gen->generateLine2d(params);
 
-    gen->endShape(&valveShadow);
+    gen->endShape(&m_valveShadow);
 
-    constexpr float rollerRadius = (float)units::distance(300.0, units::thou);
+    // In bore radii, like the rest of the head
     GeometryGenerator::Circle2dParameters circleParams;
-    circleParams.radius = rollerRadius / (float)s;
+    circleParams.maxEdgeLength = m_app->viewPixelsToUnits(5.0f) / (float)s;
+    circleParams.radius = RollerRadius / (float)s;
     circleParams.center_x = 0.0f;
     circleParams.center_y = 1.99f;
     gen->startShape();
     gen->generateCircle2d(circleParams);
-    gen->endShape(&valveRoller);
+    gen->endShape(&m_valveRoller);
 
-    circleParams.radius = (rollerRadius + m_app->pixelsToUnits(5.0f) / 2) / (float)s;
+    circleParams.radius = (RollerRadius + m_app->pixelsToUnits(5.0f) / 2) / (float)s;
     gen->startShape();
     gen->generateCircle2d(circleParams);
-    gen->endShape(&valveRollerShadow);
+    gen->endShape(&m_valveRollerShadow);
 
-    circleParams.radius = (rollerRadius * 0.25f) / (float)s;
+    circleParams.radius = (RollerRadius * 0.25f) / (float)s;
     gen->startShape();
     gen->generateCircle2d(circleParams);
-    gen->endShape(&valveRollerPin);
+    gen->endShape(&m_valveRollerPin);
 
-    circleParams.radius = (rollerRadius * 0.25f);
+    circleParams.radius = (RollerRadius * 0.25f);
+    circleParams.maxEdgeLength = m_app->viewPixelsToUnits(5.0f);
     circleParams.center_x = 0.0f;
     circleParams.center_y = 0.0f;
     gen->startShape();
     gen->generateCircle2d(circleParams);
-    gen->endShape(&camCenter);
+    gen->endShape(&m_camCenter);
+
+    Camshaft *intakeCam = m_head->getIntakeCamshaft();
+    Camshaft *exhaustCam = m_head->getExhaustCamshaft();
+    generateCamshaft(intakeCam, 0.0, RollerRadius, &m_intakeCam);
+    generateCamshaft(intakeCam, m_app->pixelsToUnits(5.0) / 2, RollerRadius, &m_intakeCamShadow);
+    generateCamshaft(exhaustCam, 0.0, RollerRadius, &m_exhaustCam);
+}
+
+void CylinderHeadObject::generateGeometry() {
+    /* void */
+}
+
+void CylinderHeadObject::render(const ViewParameters *view) {
+    if (view->Sublayer != 0) return;
+
+    resetShader();
+
+    CylinderBank *bank = m_head->getCylinderBank();
+    const double s = (float)bank->getBore() / 2.0f;
+    const double boreSurfaceArea =
+        constants::pi * bank->getBore() * bank->getBore() / 4.0;
+    const double chamberHeight = m_head->getCombustionChamberVolume() / boreSurfaceArea;
+
+    Piston *frontmostPiston = getForemostPiston(bank, view->Layer0);
+    if (frontmostPiston == nullptr) return;
+
+    const double theta = bank->getAngle();
+    double x, y;
+    bank->getPositionAboveDeck(chamberHeight, &x, &y);
+
+    const ysMatrix scale = ysMath::ScaleTransform(ysMath::LoadScalar((float)s));
+    const ysMatrix rotation = ysMath::RotationTransform(
+            ysMath::Constants::ZAxis, (float)theta);
+    const ysMatrix translation = ysMath::TranslationTransform(
+            ysMath::LoadVector((float)x, (float)y));
+    const ysMatrix T_headObject = ysMath::MatMult(translation, rotation);
+    const ysMatrix T_head = ysMath::MatMult(
+            T_headObject,
+            scale);
+
+    const ysVector col = m_app->getPink();  ysMath::Add(
+        ysMath::Mul(m_app->getForegroundColor(), ysMath::LoadScalar(0.01f)),
+        ysMath::Mul(m_app->getBackgroundColor(), ysMath::LoadScalar(0.99f))
+    );
+    const ysVector moving = m_app->getForegroundColor();
 
     m_app->getShaders()->SetObjectTransform(T_head);
     m_app->getShaders()->SetBaseColor(col);
@@ -127,7 +133,7 @@ void CylinderHeadObject::render(const ViewParameters *view) {
         0x0);
     m_app->getShaders()->SetObjectTransform(T_head);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(valveShadow, 0x1);
+    m_app->drawGenerated(m_valveShadow, 0x1);
 
     const double intakeValvePosition = (m_head->getFlipDisplay())
         ? 0.5f
@@ -152,11 +158,11 @@ void CylinderHeadObject::render(const ViewParameters *view) {
         m_app->getAssetManager()->GetModelAsset("Valve"),
         0x33);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(valveRollerShadow, 0x33);
+    m_app->drawGenerated(m_valveRollerShadow, 0x33);
     m_app->getShaders()->SetBaseColor(m_app->getBlue());
-    m_app->drawGenerated(valveRoller, 0x33);
+    m_app->drawGenerated(m_valveRoller, 0x33);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(valveRollerPin, 0x33);
+    m_app->drawGenerated(m_valveRollerPin, 0x33);
 
     const double exhaustLift = (float)m_head->exhaustValveLift(layer);
     const ysMatrix T_exhaustValve = ysMath::MatMult(
@@ -175,24 +181,20 @@ void CylinderHeadObject::render(const ViewParameters *view) {
         m_app->getAssetManager()->GetModelAsset("Valve"),
         0x33);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(valveRollerShadow, 0x33);
+    m_app->drawGenerated(m_valveRollerShadow, 0x33);
     m_app->getShaders()->SetBaseColor(m_app->getYellow());
-    m_app->drawGenerated(valveRoller, 0x33);
+    m_app->drawGenerated(m_valveRoller, 0x33);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(valveRollerPin, 0x33);
+    m_app->drawGenerated(m_valveRollerPin, 0x33);
 
     Camshaft *intakeCam = m_head->getIntakeCamshaft();
     Camshaft *exhaustCam = m_head->getExhaustCamshaft();
-    GeometryGenerator::GeometryIndices intake, intakeShadow, exhaust;
-    generateCamshaft(intakeCam, 0.0, rollerRadius, &intake);
-    generateCamshaft(intakeCam, m_app->pixelsToUnits(5.0) / 2, rollerRadius, &intakeShadow);
-    generateCamshaft(exhaustCam, 0.0, rollerRadius, &exhaust);
 
     ysMatrix T_exhaustCam = ysMath::MatMult(
         T_headObject,
         ysMath::TranslationTransform(ysMath::LoadVector(
             (float)(-intakeValvePosition * s),
-            m_app->pixelsToUnits(5.0f) / 2 + (float)(1.99 * s + exhaustCam->getBaseRadius() + rollerRadius),
+            m_app->pixelsToUnits(5.0f) / 2 + (float)(1.99 * s + exhaustCam->getBaseRadius() + RollerRadius),
             0.0f,
             0.0f)));
     T_exhaustCam = ysMath::MatMult(
@@ -205,15 +207,15 @@ void CylinderHeadObject::render(const ViewParameters *view) {
 
     m_app->getShaders()->SetObjectTransform(T_exhaustCam);
     m_app->getShaders()->SetBaseColor(m_app->getYellow());
-    m_app->drawGenerated(exhaust);
+    m_app->drawGenerated(m_exhaustCam);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(camCenter);
+    m_app->drawGenerated(m_camCenter);
 
     ysMatrix T_intakeCam = ysMath::MatMult(
         T_headObject,
         ysMath::TranslationTransform(ysMath::LoadVector(
             (float)(intakeValvePosition * s),
-            rollerRadius + m_app->pixelsToUnits(5.0f) / 2 + (float)(1.99 * s + intakeCam->getBaseRadius()),
+            RollerRadius + m_app->pixelsToUnits(5.0f) / 2 + (float)(1.99 * s + intakeCam->getBaseRadius()),
             0.0f,
             0.0f)));
     T_intakeCam = ysMath::MatMult(
@@ -226,13 +228,24 @@ void CylinderHeadObject::render(const ViewParameters *view) {
 
     m_app->getShaders()->SetObjectTransform(T_intakeCam);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(intakeShadow);
+    m_app->drawGenerated(m_intakeCamShadow);
 
     m_app->getShaders()->SetObjectTransform(T_intakeCam);
     m_app->getShaders()->SetBaseColor(m_app->getBlue());
-    m_app->drawGenerated(intake);
+    m_app->drawGenerated(m_intakeCam);
     m_app->getShaders()->SetBaseColor(m_app->getBackgroundColor());
-    m_app->drawGenerated(camCenter);
+    m_app->drawGenerated(m_camCenter);
+}
+
+bool CylinderHeadObject::getWorldBounds(Bounds *bounds) const {
+    CylinderBank *bank = m_head->getCylinderBank();
+    const double chamberHeight = m_head->getCombustionChamberVolume() / bank->boreSurfaceArea();
+
+    // The head and its cams reach a couple of bores above the deck
+    double x, y;
+    bank->getPositionAboveDeck(chamberHeight, &x, &y);
+    *bounds = boundsAround(x, y, 2.5 * bank->getBore());
+    return true;
 }
 
 void CylinderHeadObject::process(float dt) {
@@ -255,7 +268,7 @@ void CylinderHeadObject::generateCamshaft(
     params.center_y = 0.0f;
     params.rollerRadius = (float)rollerRadius;
     params.lift = camshaft->getLobeProfile();
-    params.maxEdgeLength = (float)units::distance(50, units::thou);
+    params.maxEdgeLength = m_app->viewPixelsToUnits(2.0f);
 
     m_app->getGeometryGenerator()->startShape();
     m_app->getGeometryGenerator()->generateCam(params);
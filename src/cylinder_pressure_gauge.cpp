@@ -59,7 +59,7 @@ void CylinderPressureGauge::render() {
                 0,
                 piston->getCylinderBank()->getCylinderCount() - piston->getCylinderIndex() - 1).inset(5.0f);
 
-        const double value = units::convert(chamber->m_system.pressure(), units::psi);
+        const double value = units::convert(chamber->getSystem()->pressure(), units::psi);
 
         std::stringstream ss;
         ss << std::lround(value);
@@ -75,7 +75,7 @@ void CylinderPressureGauge::render() {
         m_gauges[i]->m_thetaMin = (float)constants::pi * 1.2f;
         m_gauges[i]->m_thetaMax = -(float)constants::pi * 0.2f;
         m_gauges[i]->m_outerRadius = std::fmin(b_cyl.width(), b_cyl.height()) / 2.0f;
-        m_gauges[i]->m_value = (float)units::convert(chamber->m_system.pressure(), units::psi);
+        m_gauges[i]->m_value = (float)units::convert(chamber->getSystem()->pressure(), units::psi);
         m_gauges[i]->m_needleOuterRadius = m_gauges[i]->m_outerRadius * 0.7f;
         m_gauges[i]->m_needleInnerRadius = -m_gauges[i]->m_outerRadius * 0.1f;
         m_gauges[i]->m_needleWidth = 2.0;
@@ -6,12 +6,14 @@
 #include "../include/engine_sim_application.h"
 #include "../include/ui_utilities.h"
 
+#include <algorithm>
 #include <sstream>
 
 #undef min
 
 CylinderTemperatureGauge::CylinderTemperatureGauge() {
     m_engine = nullptr;
+    m_simulator = nullptr;
     m_maxTemperature = 2000.0;
     m_minTemperature = 200.0;
 }
@@ -36,11 +38,9 @@ void CylinderTemperatureGauge::update(float dt) {
     double maxTemperature = m_maxTemperature;
     double minTemperature = m_minTemperature;
 
-    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
-        Piston *piston = m_engine->getPiston(i);
-        CombustionChamber *chamber = m_engine->getChamber(i);
-
-        const double temperature = chamber->m_system.temperature();
+    const SimulationSnapshot &snapshot = m_simulator->getSnapshot();
+    for (int i = 0; i < getCylinderCount(); ++i) {
+        const double temperature = snapshot.cylinderTemperature[i];
         double value = temperature - m_minTemperature;
 
         m_maxTemperature = std::fmax(m_maxTemperature, value);
@@ -71,9 +71,9 @@ void CylinderTemperatureGauge::render() {
     const ysVector hot = mix(background, m_app->getRed(), 0.1f);
     const ysVector cold = mix(background, m_app->getBlue(), 0.001f);
 
-    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+    const SimulationSnapshot &snapshot = m_simulator->getSnapshot();
+    for (int i = 0; i < getCylinderCount(); ++i) {
         Piston *piston = m_engine->getPiston(i);
-        CombustionChamber *chamber = m_engine->getChamber(i);
         CylinderBank *bank = piston->getCylinderBank();
         const int bankIndex = bank->getIndex();
 
@@ -86,7 +86,7 @@ void CylinderTemperatureGauge::render() {
                 0,
                 bank->getCylinderCount() - piston->getCylinderIndex() - 1).inset(5.0f);
 
-        const double temperature = chamber->m_system.temperature();
+        const double temperature = snapshot.cylinderTemperature[i];
         double value = temperature - m_minTemperature;
 
         const Bounds worldBounds = getRenderBounds(b_cyl);
@@ -109,3 +109,9 @@ void CylinderTemperatureGauge::render() {
 
     UiElement::render();
 }
+
+int CylinderTemperatureGauge::getCylinderCount() const {
+    const int cylinders = std::min(
+        m_engine->getCylinderCount(), m_simulator->getSnapshot().cylinderCount);
+    return std::min(cylinders, SimulationSnapshot::MaxCylinders);
+}
@@ -1,8 +1,13 @@
 #include "../include/debug_trace.h"
 
+#include "../include/allocation_tracker.h"
+#include "../include/debug_trace_buffers.h"
+
 #include <atomic>
 #include <chrono>
 #include <cstdarg>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -14,8 +19,10 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <cctype>
+#include <condition_variable>
 #include <vector>
 #include <algorithm>
 
@@ -28,41 +35,164 @@
 #endif
 
 namespace {
-struct RingRecord {
-    long long monoMs = 0;
+using debug_trace::CompactRing;
+using debug_trace::RingRecordHeader;
+using debug_trace::StringTable;
+
+// Written by Log() on the calling thread when tracing is asynchronous: the
+// format string pointer, its raw arguments and copies of any string
+// arguments. Formatting happens later on the drainer thread.
+struct BinaryRecord {
+    enum class ArgType : uint8_t {
+        Signed,
+        Unsigned,
+        Double,
+        String,
+        Pointer
+    };
+
+    static constexpr int MaxArgs = 12;
+    static constexpr int StringCapacity = 160;
+
+    union Arg {
+        long long i;
+        unsigned long long u;
+        double d;
+        const void *p;
+        uint16_t stringOffset;
+    };
+
+    // nullptr if the message was preformatted into strings
+    const char *format = nullptr;
+    long long systemNs = 0;
+    long long monotonicNs = 0;
     unsigned long long frame = 0;
     unsigned long long tid = 0;
-    char component[32]{};
-    char message[512]{};
+    Arg args[MaxArgs];
+    ArgType argTypes[MaxArgs];
+    uint8_t argCount = 0;
+    uint16_t stringsUsed = 0;
+    char component[32];
+    char strings[StringCapacity];
 };
 
+// Single producer (the owning thread), single consumer (the drainer)
+struct ThreadRing {
+    static constexpr size_t Capacity = 1024;
+
+    BinaryRecord records[Capacity];
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    std::atomic<unsigned long long> dropped{0};
+};
+
+constexpr int MaxTraceThreads = 64;
+
+// Compact session format for long runs (trace.events.bin): a header then
+// fixed-size records that readers can map as one array. Message text goes
+// to trace.messages.bin and component names and message tokens are interned
+// in trace.strings.txt, one per line, with the line number as the id.
+#pragma pack(push, 1)
+struct BinarySessionHeader {
+    uint32_t magic = 0x45545345; /* ESTE */
+    uint32_t version = 1;
+    uint32_t recordSize = 0;
+    uint32_t reserved = 0;
+    int64_t startSystemMs = 0;
+};
+
+struct BinarySessionRecord {
+    int64_t monoMs;
+    uint64_t frame;
+    uint64_t tid;
+    uint64_t messageOffset;
+    uint32_t messageLength;
+    uint16_t component;
+    uint16_t token;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BinarySessionRecord) == 40, "readers assume 40 byte records");
+
+// Crash ring dump (trace.ring.bin): a RingDumpHeader, the component and
+// message template tables as a u16 length and the text of each entry, then
+// the records oldest first. A record is a RingRecordHeader followed by its
+// packed arguments (a BinaryRecord::ArgType byte, then 8 bytes, or a u8
+// length and the text for strings) or, without a template, the message
+// text.
+#pragma pack(push, 1)
+struct RingDumpHeader {
+    uint32_t magic = 0x45535452; /* RSTE */
+    uint32_t version = 2;
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint32_t componentCount = 0;
+    uint32_t templateCount = 0;
+    char reason[64]{};
+};
+#pragma pack(pop)
+
 struct SnapshotBucket {
+    static constexpr int MaxTokens = 32;
+
+    struct TokenCount {
+        uint16_t token;
+        uint64_t count;
+    };
+
     long long windowStartMs = -1;
     uint64_t sampleCount = 0;
-    std::unordered_map<std::string, uint64_t> tokenCounts;
+    TokenCount tokens[MaxTokens];
+    int tokenCount = 0;
+
+    // Samples whose token didn't fit in the bucket or the token table
+    uint64_t otherCount = 0;
 };
 
+constexpr size_t MaxTraceComponents = 64;
+constexpr size_t MaxTraceTokens = 512;
+constexpr size_t MaxTraceTemplates = 1024;
+
 struct TraceState {
     bool enabled = false;
     bool sinkFile = true;
     bool sinkStdout = false;
     bool sinkRing = false;
+    bool sinkBinary = false;
     bool jsonEnabled = false;
     std::string sessionDirectory;
     std::mutex lock;
     std::unordered_map<std::string, std::unique_ptr<std::ofstream>> streams;
     std::unique_ptr<std::ofstream> jsonStream;
+    std::unique_ptr<std::ofstream> binaryEvents;
+    std::unique_ptr<std::ofstream> binaryMessages;
+    std::unique_ptr<std::ofstream> binaryStrings;
+    std::unordered_map<std::string, uint16_t> binaryStringIds;
+    uint64_t binaryMessageOffset = 0;
     std::chrono::steady_clock::time_point monotonicStart = std::chrono::steady_clock::now();
     std::atomic<unsigned long long> frameIndex{0};
     std::atomic<bool> dumpRequested{false};
     std::string dumpReason = "requested";
-    std::vector<RingRecord> ring;
-    size_t ringCapacity = 32768;
-    size_t ringWriteIndex = 0;
-    bool ringWrapped = false;
+    CompactRing ring;
+    size_t ringBytes = 1 << 20;
     int snapshotIntervalMs = 1000;
     bool snapshotMode = true;
-    std::unordered_map<std::string, SnapshotBucket> snapshotBuckets;
+
+    // Indexed by component id, with the last for components past the table
+    std::vector<SnapshotBucket> snapshotBuckets;
+    StringTable components;
+    StringTable tokens;
+    StringTable templates;
+
+    bool async = true;
+    unsigned int categoryMask = ~0u;
+    std::atomic<bool> drainerRunning{false};
+    std::thread drainer;
+    std::mutex drainerLock;
+    std::condition_variable drainerWake;
+    std::atomic<ThreadRing *> rings[MaxTraceThreads] = {};
+    std::atomic<int> ringCount{0};
+    unsigned long long droppedReported = 0;
 };
 
 TraceState g_traceState;
@@ -123,9 +253,13 @@ void configureSinksFromArguments(int argc, char **argv) {
     g_traceState.sinkFile = true;
     g_traceState.sinkStdout = false;
     g_traceState.sinkRing = false;
+    g_traceState.sinkBinary = false;
     g_traceState.jsonEnabled = false;
     g_traceState.snapshotIntervalMs = 1000;
     g_traceState.snapshotMode = true;
+    g_traceState.async = true;
+    g_traceState.categoryMask = ~0u;
+    g_traceState.ringBytes = 1 << 20;
 
     for (int i = 1; i < argc; ++i) {
         const std::string arg = argv[i];
@@ -134,14 +268,19 @@ void configureSinksFromArguments(int argc, char **argv) {
         const std::string highFreqPrefix = "--debug-trace-highfreq-ms=";
         const std::string snapshotPrefix = "--debug-trace-snapshot-ms=";
         const std::string snapshotModePrefix = "--debug-trace-snapshot=";
+        const std::string asyncPrefix = "--debug-trace-async=";
+        const std::string categoriesPrefix = "--debug-trace-categories=";
+        const std::string ringPrefix = "--debug-trace-ring-kb=";
         if (arg.rfind(sinksPrefix, 0) == 0) {
             g_traceState.sinkFile = false;
             g_traceState.sinkStdout = false;
             g_traceState.sinkRing = false;
+            g_traceState.sinkBinary = false;
             const std::string sinks = arg.substr(sinksPrefix.size());
             if (sinks.find("file") != std::string::npos) g_traceState.sinkFile = true;
             if (sinks.find("stdout") != std::string::npos) g_traceState.sinkStdout = true;
             if (sinks.find("ring") != std::string::npos) g_traceState.sinkRing = true;
+            if (sinks.find("binary") != std::string::npos) g_traceState.sinkBinary = true;
         }
         else if (arg.rfind(jsonPrefix, 0) == 0) {
             const std::string jsonValue = arg.substr(jsonPrefix.size());
@@ -161,13 +300,31 @@ void configureSinksFromArguments(int argc, char **argv) {
             const std::string value = arg.substr(snapshotModePrefix.size());
             g_traceState.snapshotMode = !(value == "0" || value == "false" || value == "off");
         }
+        else if (arg.rfind(asyncPrefix, 0) == 0) {
+            const std::string value = arg.substr(asyncPrefix.size());
+            g_traceState.async = !(value == "0" || value == "false" || value == "off");
+        }
+        else if (arg.rfind(ringPrefix, 0) == 0) {
+            const long long parsed = std::atoll(arg.substr(ringPrefix.size()).c_str());
+            g_traceState.ringBytes = (parsed > 0) ? static_cast<size_t>(parsed) * 1024 : 0;
+        }
+        else if (arg.rfind(categoriesPrefix, 0) == 0) {
+            std::stringstream categories(arg.substr(categoriesPrefix.size()));
+            std::string category;
+            g_traceState.categoryMask = 0;
+            while (std::getline(categories, category, ',')) {
+                for (int j = 0; j < DebugTrace::CategoryCount; ++j) {
+                    if (category == DebugTrace::CategoryNames[j]) {
+                        g_traceState.categoryMask |= 1u << j;
+                    }
+                }
+            }
+        }
     }
 }
 
 bool isCriticalEventMessage(const char *text) {
     if (text == nullptr) return false;
-    std::string lower(text);
-    for (char &c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
     static const char *keywords[] = {
         "error",
         "failed",
@@ -186,12 +343,22 @@ bool isCriticalEventMessage(const char *text) {
         "spike",
         "assert"
     };
-    for (const char *k : keywords) {
-        if (lower.find(k) != std::string::npos) return true;
+    for (const char *p = text; *p != '\0'; ++p) {
+        for (const char *k : keywords) {
+            size_t i = 0;
+            while (k[i] != '\0' && std::tolower(static_cast<unsigned char>(p[i])) == k[i]) ++i;
+            if (k[i] == '\0') return true;
+        }
     }
     return false;
 }
 
+size_t messageTokenLength(const char *message) {
+    size_t length = 0;
+    while (message[length] != '\0' && std::strchr(" \t=:", message[length]) == nullptr) ++length;
+    return length;
+}
+
 std::string messageToken(const char *message) {
     std::string token;
     if (message == nullptr) return "message";
@@ -203,8 +370,7 @@ std::string messageToken(const char *message) {
     return token;
 }
 
-std::string timestampNow() {
-    const auto now = std::chrono::system_clock::now();
+std::string formatTimestamp(std::chrono::system_clock::time_point now) {
     const auto nowTime = std::chrono::system_clock::to_time_t(now);
     const auto millis =
         std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
@@ -217,6 +383,10 @@ std::string timestampNow() {
     return timestamp.str();
 }
 
+std::string timestampNow() {
+    return formatTimestamp(std::chrono::system_clock::now());
+}
+
 long long monotonicMillisNow() {
     const auto now = std::chrono::steady_clock::now();
     return std::chrono::duration_cast<std::chrono::milliseconds>(now - g_traceState.monotonicStart).count();
@@ -241,15 +411,92 @@ void appendRingRecord(
     unsigned long long frame,
     unsigned long long tid,
     const std::string &component,
-    const char *message);
+    const char *message,
+    const BinaryRecord *packed);
+
+void openBinarySession() {
+    const std::filesystem::path directory(g_traceState.sessionDirectory);
+    g_traceState.binaryEvents = std::make_unique<std::ofstream>(
+        (directory / "trace.events.bin").string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    g_traceState.binaryMessages = std::make_unique<std::ofstream>(
+        (directory / "trace.messages.bin").string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    g_traceState.binaryStrings = std::make_unique<std::ofstream>(
+        (directory / "trace.strings.txt").string(), std::ios::out | std::ios::trunc);
+    g_traceState.binaryStringIds.clear();
+    g_traceState.binaryMessageOffset = 0;
+
+    BinarySessionHeader header;
+    header.recordSize = sizeof(BinarySessionRecord);
+    header.startSystemMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    g_traceState.binaryEvents->write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void closeBinarySession() {
+    g_traceState.binaryEvents.reset();
+    g_traceState.binaryMessages.reset();
+    g_traceState.binaryStrings.reset();
+    g_traceState.binaryStringIds.clear();
+}
+
+uint16_t internBinaryString(const std::string &value) {
+    auto found = g_traceState.binaryStringIds.find(value);
+    if (found != g_traceState.binaryStringIds.end()) return found->second;
+
+    // The last id is shared by everything past the table's capacity
+    const size_t count = g_traceState.binaryStringIds.size();
+    if (count >= 0xFFFF) return 0xFFFF;
+
+    const uint16_t id = static_cast<uint16_t>(count);
+    g_traceState.binaryStringIds[value] = id;
+    (*g_traceState.binaryStrings) << value << "\n";
+    return id;
+}
+
+void appendBinaryRecordLocked(
+    const std::string &componentName,
+    long long monotonicMs,
+    unsigned long long frame,
+    unsigned long long threadIdHash,
+    const char *message)
+{
+    if (!g_traceState.binaryEvents || !g_traceState.binaryEvents->is_open()) return;
+
+    const size_t length = std::strlen(message);
+
+    BinarySessionRecord record;
+    record.monoMs = monotonicMs;
+    record.frame = frame;
+    record.tid = threadIdHash;
+    record.messageOffset = g_traceState.binaryMessageOffset;
+    record.messageLength = static_cast<uint32_t>(length);
+    record.component = internBinaryString(componentName);
+    record.token = internBinaryString(messageToken(message));
+
+    g_traceState.binaryEvents->write(reinterpret_cast<const char *>(&record), sizeof(record));
+    g_traceState.binaryMessages->write(message, static_cast<std::streamsize>(length));
+    g_traceState.binaryMessageOffset += length;
+}
 
+// Unlike the text sinks the binary files aren't flushed per line
+void flushBinarySessionLocked() {
+    if (!g_traceState.binaryEvents) return;
+
+    g_traceState.binaryStrings->flush();
+    g_traceState.binaryMessages->flush();
+    g_traceState.binaryEvents->flush();
+}
+
+// packed, when not nullptr, holds the format and arguments message was
+// formatted from
 void emitLogToSinksLocked(
     const std::string &componentName,
     const std::string &timestamp,
     long long monotonicMs,
     unsigned long long frame,
     unsigned long long threadIdHash,
-    const char *message)
+    const char *message,
+    const BinaryRecord *packed)
 {
     if (message == nullptr) return;
 
@@ -295,7 +542,15 @@ void emitLogToSinksLocked(
         g_traceState.jsonStream->flush();
     }
 
-    appendRingRecord(monotonicMs, frame, threadIdHash, componentName, message);
+    if (g_traceState.sinkBinary) {
+        appendBinaryRecordLocked(componentName, monotonicMs, frame, threadIdHash, message);
+    }
+
+    appendRingRecord(monotonicMs, frame, threadIdHash, componentName, message, packed);
+}
+
+uint16_t componentId(const std::string &componentName) {
+    return g_traceState.components.intern(componentName.c_str(), componentName.size());
 }
 
 void flushSnapshotBucketLocked(
@@ -308,86 +563,144 @@ void flushSnapshotBucketLocked(
 {
     if (bucket.sampleCount == 0) return;
 
-    std::vector<std::pair<std::string, uint64_t>> tokens(bucket.tokenCounts.begin(), bucket.tokenCounts.end());
-    std::sort(tokens.begin(), tokens.end(), [](const std::pair<std::string, uint64_t> &a, const std::pair<std::string, uint64_t> &b) {
-        return a.second > b.second;
-    });
-    if (tokens.size() > 6) tokens.resize(6);
+    SnapshotBucket::TokenCount top[SnapshotBucket::MaxTokens];
+    std::copy(bucket.tokens, bucket.tokens + bucket.tokenCount, top);
+
+    const int shown = std::min(bucket.tokenCount, 6);
+    std::partial_sort(top, top + shown, top + bucket.tokenCount,
+        [](const SnapshotBucket::TokenCount &a, const SnapshotBucket::TokenCount &b) {
+            return a.count > b.count;
+        });
+
+    char summary[512];
+    int used = std::snprintf(
+        summary,
+        sizeof(summary),
+        "snapshot interval_ms=%d samples=%llu tokens=",
+        g_traceState.snapshotIntervalMs,
+        static_cast<unsigned long long>(bucket.sampleCount));
+    for (int i = 0; i < shown && used > 0 && used < static_cast<int>(sizeof(summary)); ++i) {
+        size_t length;
+        const char *token = g_traceState.tokens.get(top[i].token, &length);
+        used += std::snprintf(
+            summary + used,
+            sizeof(summary) - used,
+            "%s%.*s:%llu",
+            (i > 0) ? "," : "",
+            static_cast<int>(length),
+            token,
+            static_cast<unsigned long long>(top[i].count));
+    }
 
-    std::ostringstream ss;
-    ss << "snapshot interval_ms=" << g_traceState.snapshotIntervalMs
-       << " samples=" << bucket.sampleCount
-       << " tokens=";
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        if (i > 0) ss << ",";
-        ss << tokens[i].first << ":" << tokens[i].second;
+    if (bucket.otherCount > 0 && used > 0 && used < static_cast<int>(sizeof(summary))) {
+        std::snprintf(
+            summary + used,
+            sizeof(summary) - used,
+            "%sother:%llu",
+            (shown > 0) ? "," : "",
+            static_cast<unsigned long long>(bucket.otherCount));
     }
 
-    const std::string summary = ss.str();
-    emitLogToSinksLocked(componentName, timestamp, monotonicMs, frame, threadIdHash, summary.c_str());
+    emitLogToSinksLocked(componentName, timestamp, monotonicMs, frame, threadIdHash, summary, nullptr);
 
     bucket.sampleCount = 0;
-    bucket.tokenCounts.clear();
+    bucket.tokenCount = 0;
+    bucket.otherCount = 0;
     bucket.windowStartMs = monotonicMs;
 }
 
+size_t packArguments(const BinaryRecord &record, uint8_t *payload) {
+    size_t size = 0;
+    for (int i = 0; i < record.argCount; ++i) {
+        payload[size++] = static_cast<uint8_t>(record.argTypes[i]);
+        if (record.argTypes[i] == BinaryRecord::ArgType::String) {
+            const char *value = record.strings + record.args[i].stringOffset;
+            const size_t length = std::min(std::strlen(value), static_cast<size_t>(0xFF));
+            payload[size++] = static_cast<uint8_t>(length);
+            std::memcpy(payload + size, value, length);
+            size += length;
+        }
+        else {
+            std::memcpy(payload + size, &record.args[i], 8);
+            size += 8;
+        }
+    }
+
+    return size;
+}
+
 void appendRingRecord(
     long long monoMs,
     unsigned long long frame,
     unsigned long long tid,
     const std::string &component,
-    const char *message)
+    const char *message,
+    const BinaryRecord *packed)
 {
-    if (!g_traceState.sinkRing || g_traceState.ringCapacity == 0) return;
-    if (g_traceState.ring.empty()) g_traceState.ring.resize(g_traceState.ringCapacity);
+    if (!g_traceState.sinkRing || g_traceState.ringBytes == 0) return;
+    if (g_traceState.ring.bytes.empty()) g_traceState.ring.bytes.resize(g_traceState.ringBytes);
+
+    RingRecordHeader header;
+    header.component = componentId(component);
+    header.format = StringTable::Full;
+    header.argCount = 0;
+    header.reserved = 0;
+    header.monoMs = monoMs;
+    header.frame = frame;
+    header.tid = tid;
+
+    // Messages are capped at 511 bytes of text, as in the old fixed records
+    uint8_t payload[BinaryRecord::MaxArgs * 9 + BinaryRecord::StringCapacity + 512];
+    size_t payloadSize = 0;
+    if (packed != nullptr && packed->format != nullptr) {
+        header.format = g_traceState.templates.intern(packed->format, std::strlen(packed->format));
+    }
 
-    RingRecord &record = g_traceState.ring[g_traceState.ringWriteIndex];
-    record.monoMs = monoMs;
-    record.frame = frame;
-    record.tid = tid;
-    std::snprintf(record.component, sizeof(record.component), "%s", component.c_str());
-    std::snprintf(record.message, sizeof(record.message), "%s", message);
+    if (header.format != StringTable::Full) {
+        header.argCount = packed->argCount;
+        payloadSize = packArguments(*packed, payload);
+    }
+    else {
+        payloadSize = std::min(std::strlen(message), static_cast<size_t>(511));
+        std::memcpy(payload, message, payloadSize);
+    }
 
-    g_traceState.ringWriteIndex = (g_traceState.ringWriteIndex + 1) % g_traceState.ringCapacity;
-    if (g_traceState.ringWriteIndex == 0) g_traceState.ringWrapped = true;
+    header.size = static_cast<uint16_t>(sizeof(header) + payloadSize);
+    g_traceState.ring.push(header, payload);
+}
+
+void writeStringTable(std::ofstream &out, const StringTable &table) {
+    for (size_t i = 0; i < table.count; ++i) {
+        size_t length;
+        const char *text = table.get(static_cast<uint16_t>(i), &length);
+        const uint16_t size = static_cast<uint16_t>(length);
+        out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        out.write(text, static_cast<std::streamsize>(length));
+    }
 }
 
 void flushRingBinaryLocked(const char *reason) {
-    if (!g_traceState.sinkRing || g_traceState.ring.empty()) return;
+    const CompactRing &ring = g_traceState.ring;
+    if (!g_traceState.sinkRing || ring.bytes.empty()) return;
     const std::filesystem::path outPath =
         std::filesystem::path(g_traceState.sessionDirectory) / "trace.ring.bin";
     std::ofstream out(outPath.string(), std::ios::out | std::ios::binary | std::ios::trunc);
     if (!out.is_open()) return;
 
-    struct RingHeader {
-        uint32_t magic = 0x45535452; /* RSTE */
-        uint32_t version = 1;
-        uint64_t count = 0;
-        char reason[64]{};
-    } header;
-
-    const size_t count = g_traceState.ringWrapped ? g_traceState.ringCapacity : g_traceState.ringWriteIndex;
-    header.count = static_cast<uint64_t>(count);
+    RingDumpHeader header;
+    header.count = ring.count;
+    header.bytes = ring.used;
+    header.componentCount = static_cast<uint32_t>(g_traceState.components.count);
+    header.templateCount = static_cast<uint32_t>(g_traceState.templates.count);
     std::snprintf(header.reason, sizeof(header.reason), "%s", reason != nullptr ? reason : "request");
     out.write(reinterpret_cast<const char *>(&header), sizeof(header));
 
-    auto writeRecord = [&](const RingRecord &record) {
-        out.write(reinterpret_cast<const char *>(&record), sizeof(record));
-    };
+    writeStringTable(out, g_traceState.components);
+    writeStringTable(out, g_traceState.templates);
 
-    if (g_traceState.ringWrapped) {
-        for (size_t i = g_traceState.ringWriteIndex; i < g_traceState.ringCapacity; ++i) {
-            writeRecord(g_traceState.ring[i]);
-        }
-        for (size_t i = 0; i < g_traceState.ringWriteIndex; ++i) {
-            writeRecord(g_traceState.ring[i]);
-        }
-    }
-    else {
-        for (size_t i = 0; i < g_traceState.ringWriteIndex; ++i) {
-            writeRecord(g_traceState.ring[i]);
-        }
-    }
+    const size_t first = std::min(ring.used, ring.bytes.size() - ring.tail);
+    out.write(reinterpret_cast<const char *>(ring.bytes.data() + ring.tail), static_cast<std::streamsize>(first));
+    out.write(reinterpret_cast<const char *>(ring.bytes.data()), static_cast<std::streamsize>(ring.used - first));
 }
 
 void flushDumpIfRequestedLocked() {
@@ -399,8 +712,433 @@ void flushDumpIfRequestedLocked() {
         mainStream->flush();
     }
 }
+
+unsigned long long currentThreadIdHash() {
+    thread_local const unsigned long long hash = static_cast<unsigned long long>(
+        std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    return hash;
+}
+
+void dispatchMessageLocked(
+    const std::string &componentName,
+    const std::string &timestamp,
+    long long monotonicMs,
+    unsigned long long frame,
+    unsigned long long threadIdHash,
+    const char *message,
+    const BinaryRecord *packed)
+{
+    if (g_traceState.snapshotMode && g_traceState.snapshotIntervalMs > 0 && !isCriticalEventMessage(message)) {
+        const uint16_t component = std::min(
+            componentId(componentName),
+            static_cast<uint16_t>(MaxTraceComponents));
+        SnapshotBucket &bucket = g_traceState.snapshotBuckets[component];
+        if (bucket.windowStartMs < 0) bucket.windowStartMs = monotonicMs;
+        if (monotonicMs - bucket.windowStartMs >= g_traceState.snapshotIntervalMs) {
+            flushSnapshotBucketLocked(componentName, bucket, timestamp, monotonicMs, frame, threadIdHash);
+        }
+
+        const size_t length = messageTokenLength(message);
+        const uint16_t token = (length > 0)
+            ? g_traceState.tokens.intern(message, length)
+            : g_traceState.tokens.intern("message", 7);
+
+        ++bucket.sampleCount;
+
+        int i = 0;
+        while (i < bucket.tokenCount && bucket.tokens[i].token != token) ++i;
+        if (token == StringTable::Full) ++bucket.otherCount;
+        else if (i < bucket.tokenCount) ++bucket.tokens[i].count;
+        else if (bucket.tokenCount < SnapshotBucket::MaxTokens) {
+            bucket.tokens[bucket.tokenCount++] = { token, 1 };
+        }
+        else ++bucket.otherCount;
+
+        return;
+    }
+
+    emitLogToSinksLocked(componentName, timestamp, monotonicMs, frame, threadIdHash, message, packed);
+}
+
+// Every ring is allocated when the drainer first starts, so a thread's
+// first trace only claims a slot; the audio thread never allocates here.
+// They're kept for the life of the process, since a thread may outlive a
+// trace session and start logging into the next one.
+void allocateRings() {
+    for (int i = 0; i < MaxTraceThreads; ++i) {
+        if (g_traceState.rings[i].load(std::memory_order_relaxed) == nullptr) {
+            g_traceState.rings[i].store(new ThreadRing, std::memory_order_release);
+        }
+    }
+}
+
+ThreadRing *threadRing() {
+    thread_local ThreadRing *ring = [] {
+        const int slot = g_traceState.ringCount.fetch_add(1);
+        return (slot < MaxTraceThreads)
+            ? g_traceState.rings[slot].load(std::memory_order_acquire)
+            : nullptr;
+    }();
+
+    return ring;
+}
+
+enum class LengthModifier {
+    None,
+    Long,
+    LongLong,
+    IntMax,
+    Size,
+    PtrDiff
+};
+
+const char *readLengthModifier(const char *p, LengthModifier *modifier) {
+    const char *start = p;
+    while (*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't') ++p;
+
+    // h and hh arguments are promoted to int
+    const size_t length = static_cast<size_t>(p - start);
+    if (length == 2 && start[0] == 'l' && start[1] == 'l') *modifier = LengthModifier::LongLong;
+    else if (length != 1) *modifier = LengthModifier::None;
+    else if (*start == 'l') *modifier = LengthModifier::Long;
+    else if (*start == 'j') *modifier = LengthModifier::IntMax;
+    else if (*start == 'z') *modifier = LengthModifier::Size;
+    else if (*start == 't') *modifier = LengthModifier::PtrDiff;
+    else *modifier = LengthModifier::None;
+
+    return p;
+}
+
+const char *skipLengthModifier(const char *p) {
+    LengthModifier modifier;
+    return readLengthModifier(p, &modifier);
+}
+
+// Ends text that was cut to fit its buffer with "..." so the output shows
+// where it was cut
+void markTruncated(char *text, size_t length) {
+    for (size_t i = (length > 3) ? length - 3 : 0; i < length; ++i) {
+        text[i] = '.';
+    }
+}
+
+// Captures the arguments a format string consumes; returns false for
+// formats the record can't hold (star widths, long double, too many args),
+// which are preformatted instead.
+bool captureArguments(BinaryRecord *record, const char *format, va_list args) {
+    record->argCount = 0;
+    record->stringsUsed = 0;
+
+    for (const char *p = format; *p != '\0'; ++p) {
+        if (*p != '%') continue;
+        ++p;
+        if (*p == '%') continue;
+
+        while (std::strchr("-+ #0123456789.", *p) != nullptr && *p != '\0') ++p;
+        if (*p == '*' || *p == 'L' || *p == '\0') return false;
+
+        LengthModifier modifier;
+        p = readLengthModifier(p, &modifier);
+
+        if (record->argCount >= BinaryRecord::MaxArgs) return false;
+        BinaryRecord::Arg &arg = record->args[record->argCount];
+        BinaryRecord::ArgType &type = record->argTypes[record->argCount];
+
+        switch (*p) {
+            case 'd':
+            case 'i':
+                type = BinaryRecord::ArgType::Signed;
+                switch (modifier) {
+                    case LengthModifier::Long: arg.i = va_arg(args, long); break;
+                    case LengthModifier::LongLong: arg.i = va_arg(args, long long); break;
+                    case LengthModifier::IntMax: arg.i = va_arg(args, intmax_t); break;
+                    case LengthModifier::Size: arg.i = va_arg(args, std::make_signed<size_t>::type); break;
+                    case LengthModifier::PtrDiff: arg.i = va_arg(args, ptrdiff_t); break;
+                    default: arg.i = va_arg(args, int); break;
+                }
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+                type = BinaryRecord::ArgType::Unsigned;
+                switch (modifier) {
+                    case LengthModifier::Long: arg.u = va_arg(args, unsigned long); break;
+                    case LengthModifier::LongLong: arg.u = va_arg(args, unsigned long long); break;
+                    case LengthModifier::IntMax: arg.u = va_arg(args, uintmax_t); break;
+                    case LengthModifier::Size: arg.u = va_arg(args, size_t); break;
+                    case LengthModifier::PtrDiff: arg.u = va_arg(args, std::make_unsigned<ptrdiff_t>::type); break;
+                    default: arg.u = va_arg(args, unsigned int); break;
+                }
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                type = BinaryRecord::ArgType::Double;
+                arg.d = va_arg(args, double);
+                break;
+            case 's':
+            {
+                type = BinaryRecord::ArgType::String;
+                const char *value = va_arg(args, const char *);
+                if (value == nullptr) value = "(null)";
+
+                const size_t available = BinaryRecord::StringCapacity - record->stringsUsed;
+                if (available == 0) return false;
+
+                const size_t length = std::strlen(value);
+                const size_t n = std::min(length, available - 1);
+                std::memcpy(record->strings + record->stringsUsed, value, n);
+                record->strings[record->stringsUsed + n] = '\0';
+                if (n < length) markTruncated(record->strings + record->stringsUsed, n);
+                arg.stringOffset = record->stringsUsed;
+                record->stringsUsed = static_cast<uint16_t>(record->stringsUsed + n + 1);
+                break;
+            }
+            case 'p':
+                type = BinaryRecord::ArgType::Pointer;
+                arg.p = va_arg(args, const void *);
+                break;
+            default:
+                return false;
+        }
+
+        ++record->argCount;
+    }
+
+    return true;
+}
+
+void formatRecord(const BinaryRecord &record, char *buffer, size_t bufferSize) {
+    if (record.format == nullptr) {
+        std::snprintf(buffer, bufferSize, "%s", record.strings);
+        return;
+    }
+
+    size_t used = 0;
+    int argIndex = 0;
+    auto append = [&](int written) {
+        if (written > 0) used = std::min(used + static_cast<size_t>(written), bufferSize - 1);
+    };
+
+    for (const char *p = record.format; *p != '\0' && used < bufferSize - 1;) {
+        if (*p != '%') {
+            buffer[used++] = *p++;
+            continue;
+        }
+
+        if (p[1] == '%') {
+            buffer[used++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Rebuild the conversion with the stored width of the argument
+        char spec[32];
+        size_t specSize = 0;
+        spec[specSize++] = *p++;
+        while (*p != '\0' && std::strchr("-+ #0123456789.", *p) != nullptr && specSize < 24) {
+            spec[specSize++] = *p++;
+        }
+
+        p = skipLengthModifier(p);
+        const char conversion = *p++;
+        if (argIndex >= record.argCount) break;
+
+        const BinaryRecord::Arg &arg = record.args[argIndex];
+        char *out = buffer + used;
+        const size_t remaining = bufferSize - used;
+        switch (record.argTypes[argIndex++]) {
+            case BinaryRecord::ArgType::Signed:
+                spec[specSize++] = 'l';
+                spec[specSize++] = 'l';
+                spec[specSize++] = conversion;
+                spec[specSize] = '\0';
+                append(std::snprintf(out, remaining, spec, arg.i));
+                break;
+            case BinaryRecord::ArgType::Unsigned:
+                if (conversion == 'c') {
+                    spec[specSize++] = conversion;
+                    spec[specSize] = '\0';
+                    append(std::snprintf(out, remaining, spec, static_cast<int>(arg.u)));
+                    break;
+                }
+
+                spec[specSize++] = 'l';
+                spec[specSize++] = 'l';
+                spec[specSize++] = conversion;
+                spec[specSize] = '\0';
+                append(std::snprintf(out, remaining, spec, arg.u));
+                break;
+            case BinaryRecord::ArgType::Double:
+                spec[specSize++] = conversion;
+                spec[specSize] = '\0';
+                append(std::snprintf(out, remaining, spec, arg.d));
+                break;
+            case BinaryRecord::ArgType::String:
+                spec[specSize++] = conversion;
+                spec[specSize] = '\0';
+                append(std::snprintf(out, remaining, spec, record.strings + arg.stringOffset));
+                break;
+            case BinaryRecord::ArgType::Pointer:
+                spec[specSize++] = conversion;
+                spec[specSize] = '\0';
+                append(std::snprintf(out, remaining, spec, arg.p));
+                break;
+        }
+    }
+
+    buffer[used] = '\0';
+}
+
+bool enqueueRecord(const char *component, const char *format, va_list args) {
+    ThreadRing *ring = threadRing();
+    if (ring == nullptr) return false;
+
+    const size_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= ThreadRing::Capacity) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    BinaryRecord &record = ring->records[head & (ThreadRing::Capacity - 1)];
+    record.systemNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.monotonicNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_traceState.monotonicStart).count();
+    record.frame = g_traceState.frameIndex.load(std::memory_order_relaxed);
+    record.tid = currentThreadIdHash();
+    size_t componentSize = 0;
+    if (component != nullptr) {
+        while (component[componentSize] != '\0' && componentSize < sizeof(record.component) - 1) {
+            record.component[componentSize] = component[componentSize];
+            ++componentSize;
+        }
+    }
+    record.component[componentSize] = '\0';
+
+    va_list captured;
+    va_copy(captured, args);
+    const bool capturedAll = captureArguments(&record, format, captured);
+    va_end(captured);
+
+    if (capturedAll) {
+        record.format = format;
+    }
+    else {
+        record.format = nullptr;
+        const int length = std::vsnprintf(record.strings, sizeof(record.strings), format, args);
+        if (length >= static_cast<int>(sizeof(record.strings))) {
+            markTruncated(record.strings, sizeof(record.strings) - 1);
+        }
+    }
+
+    ring->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void drainRings(std::vector<BinaryRecord> *batch) {
+    batch->clear();
+
+    unsigned long long dropped = 0;
+    const int ringCount = std::min(g_traceState.ringCount.load(), MaxTraceThreads);
+    for (int i = 0; i < ringCount; ++i) {
+        ThreadRing *ring = g_traceState.rings[i].load(std::memory_order_acquire);
+        if (ring == nullptr) continue;
+
+        const size_t head = ring->head.load(std::memory_order_acquire);
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            batch->push_back(ring->records[tail & (ThreadRing::Capacity - 1)]);
+        }
+
+        ring->tail.store(tail, std::memory_order_release);
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+
+    // Interleave the threads back into time order
+    std::stable_sort(batch->begin(), batch->end(), [](const BinaryRecord &a, const BinaryRecord &b) {
+        return a.monotonicNs < b.monotonicNs;
+    });
+
+    std::lock_guard<std::mutex> guard(g_traceState.lock);
+    char messageBuffer[2048];
+    for (const BinaryRecord &record : *batch) {
+        formatRecord(record, messageBuffer, sizeof(messageBuffer));
+
+        const std::chrono::system_clock::time_point time(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(record.systemNs)));
+        dispatchMessageLocked(
+            sanitizeComponentName(record.component),
+            formatTimestamp(time),
+            record.monotonicNs / 1000000,
+            record.frame,
+            record.tid,
+            messageBuffer,
+            &record);
+    }
+
+    if (dropped != g_traceState.droppedReported) {
+        char message[128];
+        std::snprintf(
+            message,
+            sizeof(message),
+            "trace ring overflow dropped_records=%llu",
+            dropped - g_traceState.droppedReported);
+        emitLogToSinksLocked(
+            "main", timestampNow(), monotonicMillisNow(), g_traceState.frameIndex.load(), currentThreadIdHash(), message, nullptr);
+        g_traceState.droppedReported = dropped;
+    }
+
+    flushBinarySessionLocked();
+    flushDumpIfRequestedLocked();
+}
+
+void drainerThread() {
+    ATG_ENGINE_SIM_ALLOCATION_SCOPE(DebugTrace);
+
+    std::vector<BinaryRecord> batch;
+    batch.reserve(ThreadRing::Capacity);
+
+    while (g_traceState.drainerRunning.load()) {
+        {
+            std::unique_lock<std::mutex> lock(g_traceState.drainerLock);
+            g_traceState.drainerWake.wait_for(lock, std::chrono::milliseconds(5));
+        }
+
+        drainRings(&batch);
+    }
+
+    drainRings(&batch);
+}
+
+void startDrainer() {
+    if (g_traceState.drainerRunning.load()) return;
+
+    // Before any thread can queue
+    allocateRings();
+    g_traceState.drainerRunning.store(true);
+    g_traceState.drainer = std::thread(drainerThread);
+}
+
+void stopDrainer() {
+    if (!g_traceState.drainerRunning.exchange(false)) return;
+
+    g_traceState.drainerWake.notify_one();
+    g_traceState.drainer.join();
+}
 } /* namespace */
 
+std::atomic<unsigned int> DebugTrace::s_categoryMask{0};
+std::atomic<unsigned long long> DebugTrace::s_dumpRequests{0};
+
 bool DebugTrace::InitializeFromArguments(int argc, char **argv) {
     const std::string requestedDirectory = resolveSessionDirectoryFromArguments(argc, argv);
     if (requestedDirectory.empty()) {
@@ -430,9 +1168,11 @@ bool DebugTrace::InitializeFromArguments(int argc, char **argv) {
     g_traceState.dumpRequested.store(false);
     g_traceState.dumpReason = "startup";
     g_traceState.ring.clear();
-    g_traceState.ringWriteIndex = 0;
-    g_traceState.ringWrapped = false;
-    g_traceState.snapshotBuckets.clear();
+    if (g_traceState.ring.bytes.size() != g_traceState.ringBytes) g_traceState.ring.bytes.clear();
+    g_traceState.components.initialize(MaxTraceComponents, 2048);
+    g_traceState.tokens.initialize(MaxTraceTokens, 16 * 1024);
+    g_traceState.templates.initialize(MaxTraceTemplates, 64 * 1024);
+    g_traceState.snapshotBuckets.assign(MaxTraceComponents + 1, SnapshotBucket());
 
     if (g_traceState.jsonEnabled) {
         const std::filesystem::path jsonPath =
@@ -443,18 +1183,38 @@ bool DebugTrace::InitializeFromArguments(int argc, char **argv) {
         g_traceState.jsonStream.reset();
     }
 
+    if (g_traceState.sinkBinary) {
+        openBinarySession();
+    }
+    else {
+        closeBinarySession();
+    }
+
+    if (g_traceState.async) {
+        startDrainer();
+    }
+
+    s_categoryMask.store(g_traceState.categoryMask);
+
     Log("main", "debug trace enabled; session_dir=%s", g_traceState.sessionDirectory.c_str());
+    std::string activeCategories;
+    for (int i = 0; i < CategoryCount; ++i) {
+        if ((g_traceState.categoryMask & (1u << i)) == 0) continue;
+        if (!activeCategories.empty()) activeCategories += " ";
+        activeCategories += CategoryNames[i];
+    }
+
+    Log("main", "active categories: %s", activeCategories.c_str());
     Log(
         "main",
-        "active categories: main app mainloop script window input simulator audio audio_thread delta_engine metal_device device error_system");
-    Log(
-        "main",
-        "trace sinks file=%d stdout=%d ring=%d json=%d",
+        "trace sinks file=%d stdout=%d ring=%d binary=%d json=%d",
         g_traceState.sinkFile ? 1 : 0,
         g_traceState.sinkStdout ? 1 : 0,
         g_traceState.sinkRing ? 1 : 0,
+        g_traceState.sinkBinary ? 1 : 0,
         g_traceState.jsonEnabled ? 1 : 0);
     Log("main", "trace snapshot mode=%d interval_ms=%d", g_traceState.snapshotMode ? 1 : 0, g_traceState.snapshotIntervalMs);
+    Log("main", "trace async=%d", g_traceState.async ? 1 : 0);
     Log("main", "cumulative counters reset point=startup");
     return true;
 }
@@ -464,28 +1224,54 @@ void DebugTrace::Shutdown() {
 
     Log("main", "cumulative counters reset point=shutdown");
     Log("main", "debug trace shutting down");
+    s_categoryMask.store(0);
+
+    // Formats whatever the rings still hold before the sinks close
+    stopDrainer();
 
     std::lock_guard<std::mutex> guard(g_traceState.lock);
     const std::string shutdownTs = timestampNow();
     const long long shutdownMono = monotonicMillisNow();
     const unsigned long long shutdownFrame = g_traceState.frameIndex.load();
-    const auto shutdownTid = static_cast<unsigned long long>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
-    for (auto &entry : g_traceState.snapshotBuckets) {
-        flushSnapshotBucketLocked(entry.first, entry.second, shutdownTs, shutdownMono, shutdownFrame, shutdownTid);
+    const unsigned long long shutdownTid = currentThreadIdHash();
+    for (size_t i = 0; i < g_traceState.snapshotBuckets.size(); ++i) {
+        // Components the table had no room for have no name, only the
+        // bucket's id
+        std::string name = std::to_string(i);
+        if (i < g_traceState.components.count) {
+            size_t length;
+            const char *component = g_traceState.components.get(static_cast<uint16_t>(i), &length);
+            name.assign(component, length);
+        }
+
+        flushSnapshotBucketLocked(
+            name,
+            g_traceState.snapshotBuckets[i],
+            shutdownTs,
+            shutdownMono,
+            shutdownFrame,
+            shutdownTid);
     }
     flushDumpIfRequestedLocked();
     flushRingBinaryLocked("shutdown");
     g_traceState.streams.clear();
     g_traceState.jsonStream.reset();
+    closeBinarySession();
     g_traceState.enabled = false;
 }
 
 void DebugTrace::RequestDump(const char *reason) {
+    s_dumpRequests.fetch_add(1, std::memory_order_relaxed);
+
     if (!g_traceState.enabled) return;
     g_traceState.dumpReason = (reason != nullptr) ? reason : "manual";
     g_traceState.dumpRequested.store(true);
 }
 
+unsigned long long DebugTrace::GetDumpRequestCount() {
+    return s_dumpRequests.load(std::memory_order_relaxed);
+}
+
 bool DebugTrace::IsEnabled() {
     return g_traceState.enabled;
 }
@@ -505,9 +1291,27 @@ unsigned long long DebugTrace::GetFrameIndex() {
 void DebugTrace::Log(const char *component, const char *format, ...) {
     if (!g_traceState.enabled || format == nullptr) return;
 
-    char messageBuffer[2048];
     va_list args;
     va_start(args, format);
+    const bool queued = g_traceState.drainerRunning.load(std::memory_order_relaxed)
+        && enqueueRecord(component, format, args);
+    if (queued) {
+        va_end(args);
+        return;
+    }
+
+    // The ring keeps the format and arguments rather than the text
+    BinaryRecord packed;
+    bool isPacked = false;
+    if (g_traceState.sinkRing) {
+        va_list captured;
+        va_copy(captured, args);
+        isPacked = captureArguments(&packed, format, captured);
+        va_end(captured);
+        packed.format = format;
+    }
+
+    char messageBuffer[2048];
     std::vsnprintf(messageBuffer, sizeof(messageBuffer), format, args);
     va_end(args);
 
@@ -515,24 +1319,15 @@ void DebugTrace::Log(const char *component, const char *format, ...) {
     const std::string timestamp = timestampNow();
     const long long monotonicMs = monotonicMillisNow();
     const unsigned long long frame = g_traceState.frameIndex.load();
-    const auto threadIdHash = static_cast<unsigned long long>(
-        std::hash<std::thread::id>{}(std::this_thread::get_id()));
 
     std::lock_guard<std::mutex> guard(g_traceState.lock);
-    if (g_traceState.snapshotMode && g_traceState.snapshotIntervalMs > 0 && !isCriticalEventMessage(messageBuffer)) {
-        SnapshotBucket &bucket = g_traceState.snapshotBuckets[componentName];
-        if (bucket.windowStartMs < 0) bucket.windowStartMs = monotonicMs;
-        if (monotonicMs - bucket.windowStartMs >= g_traceState.snapshotIntervalMs) {
-            flushSnapshotBucketLocked(componentName, bucket, timestamp, monotonicMs, frame, threadIdHash);
-        }
-
-        const std::string token = messageToken(messageBuffer);
-        ++bucket.sampleCount;
-        ++bucket.tokenCounts[token];
-        flushDumpIfRequestedLocked();
-        return;
-    }
-
-    emitLogToSinksLocked(componentName, timestamp, monotonicMs, frame, threadIdHash, messageBuffer);
+    dispatchMessageLocked(
+        componentName,
+        timestamp,
+        monotonicMs,
+        frame,
+        currentThreadIdHash(),
+        messageBuffer,
+        isPacked ? &packed : nullptr);
     flushDumpIfRequestedLocked();
 }
@@ -0,0 +1,119 @@
+#include "../include/delay_line_bank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+DelayLineBank::DelayLineBank() {
+    m_history = nullptr;
+    m_rowMask = 0;
+    m_writeRow = 0;
+
+    m_offsets = nullptr;
+    m_coefficients = nullptr;
+    m_delaySamples = nullptr;
+
+    m_lineCount = 0;
+}
+
+DelayLineBank::~DelayLineBank() {
+    destroy();
+}
+
+void DelayLineBank::initialize(const double *delays, int lines, double sampleRate) {
+    destroy();
+
+    if (lines <= 0) return;
+
+    m_lineCount = lines;
+    m_offsets = new size_t[lines];
+    m_coefficients = new double[(size_t)Taps * lines];
+    m_delaySamples = new double[lines];
+
+    size_t maxOffset = 0;
+    for (int i = 0; i < lines; ++i) {
+        const double delay = std::max(0.0, delays[i] * std::max(0.0, sampleRate));
+        m_delaySamples[i] = delay;
+
+        double h[Taps] = { 0.0, 0.0, 0.0, 0.0 };
+        size_t offset = 0;
+        if (delay < 1.0) {
+            h[0] = 1.0 - delay;
+            h[1] = delay;
+        }
+        else {
+            // Centered on the middle two taps: the delay sits between taps 1
+            // and 2, d samples past the newest one
+            offset = static_cast<size_t>(std::floor(delay)) - 1;
+            const double d = delay - offset;
+            for (int k = 0; k < Taps; ++k) {
+                h[k] = 1.0;
+                for (int j = 0; j < Taps; ++j) {
+                    if (j != k) h[k] *= (d - j) / (k - j);
+                }
+            }
+        }
+
+        m_offsets[i] = offset;
+        for (int k = 0; k < Taps; ++k) {
+            m_coefficients[k * lines + i] = h[k];
+        }
+
+        maxOffset = std::max(maxOffset, offset);
+    }
+
+    size_t rows = 32;
+    while (rows < maxOffset + Taps) rows *= 2;
+
+    m_history = new double[rows * lines];
+    memset(m_history, 0, sizeof(double) * rows * lines);
+    m_rowMask = rows - 1;
+    m_writeRow = 0;
+}
+
+void DelayLineBank::destroy() {
+    delete[] m_history;
+    delete[] m_offsets;
+    delete[] m_coefficients;
+    delete[] m_delaySamples;
+
+    m_history = nullptr;
+    m_offsets = nullptr;
+    m_coefficients = nullptr;
+    m_delaySamples = nullptr;
+
+    m_rowMask = 0;
+    m_writeRow = 0;
+    m_lineCount = 0;
+}
+
+void DelayLineBank::process(const double *input, double *output) {
+    const int lines = m_lineCount;
+    if (lines == 0) return;
+
+    memcpy(m_history + m_writeRow * lines, input, sizeof(double) * lines);
+
+    const double *h0 = m_coefficients;
+    const double *h1 = h0 + lines;
+    const double *h2 = h1 + lines;
+    const double *h3 = h2 + lines;
+
+    // No branches per line, so every line goes through the same
+    // multiply-adds; only the row each one reads from differs
+    for (int i = 0; i < lines; ++i) {
+        const size_t row = m_writeRow - m_offsets[i];
+        output[i] =
+            h0[i] * m_history[((row) & m_rowMask) * lines + i]
+            + h1[i] * m_history[((row - 1) & m_rowMask) * lines + i]
+            + h2[i] * m_history[((row - 2) & m_rowMask) * lines + i]
+            + h3[i] * m_history[((row - 3) & m_rowMask) * lines + i];
+    }
+
+    m_writeRow = (m_writeRow + 1) & m_rowMask;
+}
+
+void DelayLineBank::process(const double *input, double *output, int frames) {
+    for (int i = 0; i < frames; ++i) {
+        process(input + (size_t)i * m_lineCount, output + (size_t)i * m_lineCount);
+    }
+}
@@ -21,3 +21,25 @@ float DerivativeFilter::f(float sample) {
 
     return (sample - temp) / m_dt;
 }
+
+void DerivativeFilter::fast_f(const float *input, float *output, int n) {
+    if (n <= 0) return;
+
+    if (std::abs(m_dt) <= 1e-12f) {
+        m_previous = input[n - 1];
+        for (int i = 0; i < n; ++i) {
+            output[i] = 0.0f;
+        }
+
+        return;
+    }
+
+    float previous = m_previous;
+    for (int i = 0; i < n; ++i) {
+        const float sample = input[i];
+        output[i] = (sample - previous) / m_dt;
+        previous = sample;
+    }
+
+    m_previous = previous;
+}
@@ -0,0 +1,844 @@
+#include "../include/distributed_study.h"
+
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#if defined(_WIN32)
+typedef SOCKET NativeSocket;
+typedef int SocketLength;
+const intptr_t ClosedSocket = static_cast<intptr_t>(INVALID_SOCKET);
+
+bool startSockets() {
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+}
+
+void stopSockets() {
+    WSACleanup();
+}
+
+void closeSocket(intptr_t s) {
+    closesocket(static_cast<SOCKET>(s));
+}
+#else
+typedef int NativeSocket;
+typedef socklen_t SocketLength;
+const intptr_t ClosedSocket = -1;
+
+bool startSockets() {
+    return true;
+}
+
+void stopSockets() {
+    /* void */
+}
+
+void closeSocket(intptr_t s) {
+    ::close(static_cast<int>(s));
+}
+#endif /* _WIN32 */
+
+NativeSocket native(intptr_t s) {
+    return static_cast<NativeSocket>(s);
+}
+
+enum class MessageType : uint32_t {
+    Hello = 1,
+    Setup = 2,
+    Job = 3,
+    Result = 4,
+    Done = 5
+};
+
+struct MessageHeader {
+    uint32_t type;
+    uint32_t size;
+};
+
+// Setup carries the snapshot; anything larger is not a message
+constexpr uint32_t MaxMessageSize = 1u << 30;
+
+class MessageWriter {
+    public:
+        explicit MessageWriter(MessageType type) {
+            const MessageHeader header = { static_cast<uint32_t>(type), 0 };
+            bytes(&header, sizeof(header));
+        }
+
+        template <typename T>
+        void put(const T &value) {
+            bytes(&value, sizeof(T));
+        }
+
+        void bytes(const void *data, size_t size) {
+            const uint8_t *p = static_cast<const uint8_t *>(data);
+            m_data.insert(m_data.end(), p, p + size);
+        }
+
+        // Fills in the payload size
+        std::vector<uint8_t> &finish() {
+            const uint32_t size = static_cast<uint32_t>(m_data.size() - sizeof(MessageHeader));
+            std::memcpy(m_data.data() + offsetof(MessageHeader, size), &size, sizeof(size));
+            return m_data;
+        }
+
+    private:
+        std::vector<uint8_t> m_data;
+};
+
+class MessageReader {
+    public:
+        MessageReader(const uint8_t *data, size_t size) {
+            m_data = data;
+            m_size = size;
+            m_offset = 0;
+            m_ok = true;
+        }
+
+        template <typename T>
+        T get() {
+            T value = T();
+            bytes(&value, sizeof(T));
+            return value;
+        }
+
+        void bytes(void *target, size_t size) {
+            if (!m_ok || m_size - m_offset < size) {
+                m_ok = false;
+                return;
+            }
+
+            std::memcpy(target, m_data + m_offset, size);
+            m_offset += size;
+        }
+
+        const uint8_t *remaining(size_t size) {
+            if (!m_ok || m_size - m_offset < size) {
+                m_ok = false;
+                return nullptr;
+            }
+
+            const uint8_t *p = m_data + m_offset;
+            m_offset += size;
+            return p;
+        }
+
+        bool ok() const { return m_ok; }
+
+    private:
+        const uint8_t *m_data;
+        size_t m_size;
+        size_t m_offset;
+        bool m_ok;
+};
+
+bool sendAll(intptr_t s, const std::vector<uint8_t> &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const int n = static_cast<int>(send(
+            native(s),
+            reinterpret_cast<const char *>(data.data() + sent),
+            static_cast<int>(std::min<size_t>(data.size() - sent, 1 << 20)),
+            0));
+        if (n <= 0) return false;
+
+        sent += n;
+    }
+
+    return true;
+}
+
+bool receiveAll(intptr_t s, void *target, size_t size) {
+    uint8_t *p = static_cast<uint8_t *>(target);
+    size_t received = 0;
+    while (received < size) {
+        const int n = static_cast<int>(recv(
+            native(s),
+            reinterpret_cast<char *>(p + received),
+            static_cast<int>(std::min<size_t>(size - received, 1 << 20)),
+            0));
+        if (n <= 0) return false;
+
+        received += n;
+    }
+
+    return true;
+}
+
+bool receiveMessage(intptr_t s, MessageType *type, std::vector<uint8_t> *payload) {
+    MessageHeader header;
+    if (!receiveAll(s, &header, sizeof(header)) || header.size > MaxMessageSize) return false;
+
+    payload->resize(header.size);
+    if (header.size > 0 && !receiveAll(s, payload->data(), header.size)) return false;
+
+    *type = static_cast<MessageType>(header.type);
+    return true;
+}
+
+void setNoDelay(intptr_t s) {
+    int on = 1;
+    setsockopt(native(s), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&on), sizeof(on));
+}
+
+void putTolerance(MessageWriter *writer, const SteadyStateDetector::Tolerance &tolerance) {
+    writer->put(tolerance.relative);
+    writer->put(tolerance.absolute);
+}
+
+void getTolerance(MessageReader *reader, SteadyStateDetector::Tolerance *tolerance) {
+    tolerance->relative = reader->get<double>();
+    tolerance->absolute = reader->get<double>();
+}
+
+void putStudy(MessageWriter *writer, const ParameterStudy::Parameters &study) {
+    writer->put(static_cast<uint32_t>(study.axes.size()));
+    for (const ParameterStudy::Axis &axis : study.axes) {
+        writer->put(static_cast<int32_t>(axis.parameter));
+        writer->put(axis.min);
+        writer->put(axis.max);
+        writer->put(static_cast<int32_t>(axis.steps));
+    }
+
+    writer->put(static_cast<int32_t>(study.design));
+    writer->put(static_cast<int32_t>(study.samples));
+    writer->put(static_cast<uint64_t>(study.seed));
+
+    const DynoSweep::Parameters &sweep = study.sweep;
+    writer->put(sweep.minRpm);
+    writer->put(sweep.maxRpm);
+    writer->put(sweep.stepRpm);
+    writer->put(sweep.throttle);
+    writer->put(static_cast<uint8_t>(sweep.stopWhenSettled));
+    writer->put(static_cast<int32_t>(sweep.steadyState.windowCycles));
+    writer->put(static_cast<int32_t>(sweep.steadyState.warmupCycles));
+    putTolerance(writer, sweep.steadyState.torque);
+    putTolerance(writer, sweep.steadyState.rpm);
+    putTolerance(writer, sweep.steadyState.manifoldPressure);
+    putTolerance(writer, sweep.steadyState.afr);
+    writer->put(sweep.settleTime);
+    writer->put(static_cast<int32_t>(sweep.measureCycles));
+    writer->put(sweep.frameLength);
+    writer->put(static_cast<uint8_t>(sweep.audioMetrics));
+}
+
+bool getStudy(MessageReader *reader, ParameterStudy::Parameters *study) {
+    const uint32_t axes = reader->get<uint32_t>();
+    if (!reader->ok() || axes > static_cast<uint32_t>(ParameterStudy::Parameter::Count) * 4) return false;
+
+    for (uint32_t i = 0; i < axes; ++i) {
+        ParameterStudy::Axis axis;
+        const int32_t parameter = reader->get<int32_t>();
+        if (parameter < 0 || parameter >= static_cast<int32_t>(ParameterStudy::Parameter::Count)) return false;
+
+        axis.parameter = static_cast<ParameterStudy::Parameter>(parameter);
+        axis.min = reader->get<double>();
+        axis.max = reader->get<double>();
+        axis.steps = reader->get<int32_t>();
+        study->axes.push_back(axis);
+    }
+
+    study->design = static_cast<ParameterStudy::Design>(reader->get<int32_t>());
+    study->samples = reader->get<int32_t>();
+    study->seed = reader->get<uint64_t>();
+
+    DynoSweep::Parameters &sweep = study->sweep;
+    sweep.minRpm = reader->get<double>();
+    sweep.maxRpm = reader->get<double>();
+    sweep.stepRpm = reader->get<double>();
+    sweep.throttle = reader->get<double>();
+    sweep.stopWhenSettled = reader->get<uint8_t>() != 0;
+    sweep.steadyState.windowCycles = reader->get<int32_t>();
+    sweep.steadyState.warmupCycles = reader->get<int32_t>();
+    getTolerance(reader, &sweep.steadyState.torque);
+    getTolerance(reader, &sweep.steadyState.rpm);
+    getTolerance(reader, &sweep.steadyState.manifoldPressure);
+    getTolerance(reader, &sweep.steadyState.afr);
+    sweep.settleTime = reader->get<double>();
+    sweep.measureCycles = reader->get<int32_t>();
+    sweep.frameLength = reader->get<double>();
+    sweep.audioMetrics = reader->get<uint8_t>() != 0;
+
+    return reader->ok();
+}
+
+void putPoint(MessageWriter *writer, const DynoSweep::Point &point) {
+    writer->put(point.rpm);
+    writer->put(point.torque);
+    writer->put(point.power);
+    writer->put(point.manifoldPressure);
+    writer->put(point.intakeAfr);
+    writer->put(point.simulatedTime);
+    writer->put(point.wallTime);
+    writer->put(static_cast<uint8_t>(point.valid));
+    writer->put(static_cast<uint8_t>(point.settled));
+    writer->put(point.settledTime);
+    writer->put(static_cast<uint8_t>(point.audioAnalyzed));
+    writer->put(point.audioLoudness);
+    writer->put(point.audioSpectralCentroid);
+    writer->put(point.audioRoughness);
+}
+
+void getPoint(MessageReader *reader, DynoSweep::Point *point) {
+    point->rpm = reader->get<double>();
+    point->torque = reader->get<double>();
+    point->power = reader->get<double>();
+    point->manifoldPressure = reader->get<double>();
+    point->intakeAfr = reader->get<double>();
+    point->simulatedTime = reader->get<double>();
+    point->wallTime = reader->get<double>();
+    point->valid = reader->get<uint8_t>() != 0;
+    point->settled = reader->get<uint8_t>() != 0;
+    point->settledTime = reader->get<double>();
+    point->audioAnalyzed = reader->get<uint8_t>() != 0;
+    point->audioLoudness = reader->get<double>();
+    point->audioSpectralCentroid = reader->get<double>();
+    point->audioRoughness = reader->get<double>();
+}
+} /* namespace */
+
+struct StudyCoordinator::Worker {
+    intptr_t socket = ClosedSocket;
+    int threads = 0;
+    bool connected = true;
+
+    // Received bytes not yet parsed into a message
+    std::vector<uint8_t> buffer;
+    std::vector<int> running;
+};
+
+StudyCoordinator::StudyCoordinator() {
+    m_socket = ClosedSocket;
+    m_port = 0;
+    m_completed = 0;
+    m_dispatchCount = 0;
+}
+
+StudyCoordinator::~StudyCoordinator() {
+    destroy();
+}
+
+bool StudyCoordinator::initialize(
+    const Parameters &params,
+    const ParameterStudy::Parameters &study,
+    const std::string &snapshotPath)
+{
+    destroy();
+
+    m_parameters = params;
+    m_parameters.maxDuplicates = std::max(params.maxDuplicates, 0);
+    m_study.initialize(study);
+
+    FILE *file = std::fopen(snapshotPath.c_str(), "rb");
+    if (file == nullptr) return false;
+
+    std::vector<uint8_t> snapshot;
+    uint8_t chunk[65536];
+    size_t n = 0;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        snapshot.insert(snapshot.end(), chunk, chunk + n);
+    }
+
+    const bool read = std::ferror(file) == 0 && !snapshot.empty();
+    std::fclose(file);
+    if (!read) return false;
+
+    MessageWriter setup(MessageType::Setup);
+    putStudy(&setup, study);
+    setup.put(static_cast<uint64_t>(snapshot.size()));
+    setup.bytes(snapshot.data(), snapshot.size());
+    m_setup = std::move(setup.finish());
+
+    if (!startSockets()) return false;
+
+    const NativeSocket s = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+    if (static_cast<intptr_t>(s) == ClosedSocket) {
+        stopSockets();
+        return false;
+    }
+
+    int on = 1, off = 0;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on), sizeof(on));
+    setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char *>(&off), sizeof(off));
+
+    sockaddr_in6 address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(static_cast<uint16_t>(params.port));
+
+    SocketLength length = sizeof(address);
+    const bool ok =
+        bind(s, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0
+        && listen(s, 64) == 0
+        && getsockname(s, reinterpret_cast<sockaddr *>(&address), &length) == 0;
+    if (!ok) {
+        closeSocket(static_cast<intptr_t>(s));
+        stopSockets();
+        return false;
+    }
+
+    m_socket = static_cast<intptr_t>(s);
+    m_port = ntohs(address.sin6_port);
+
+    m_tasks.assign(m_study.getTaskCount(), Task());
+    m_pending.clear();
+    for (int i = 0; i < m_study.getTaskCount(); ++i) m_pending.push_back(i);
+    m_completed = 0;
+    m_dispatchCount = 0;
+    m_statistics = Statistics();
+
+    return true;
+}
+
+void StudyCoordinator::destroy() {
+    for (Worker *worker : m_workers) {
+        closeSocket(worker->socket);
+        delete worker;
+    }
+
+    m_workers.clear();
+
+    if (m_socket != ClosedSocket) {
+        closeSocket(m_socket);
+        stopSockets();
+        m_socket = ClosedSocket;
+    }
+
+    m_port = 0;
+    m_setup.clear();
+    m_tasks.clear();
+    m_pending.clear();
+}
+
+ParameterStudy::Result StudyCoordinator::run() {
+    const int holdPoints = m_study.getHoldPointCount();
+    const int tasks = m_study.getTaskCount();
+
+    ParameterStudy::Result result;
+    result.variants = m_study.getVariants();
+    result.sweeps.resize(result.variants.size());
+    for (DynoSweep::Result &sweep : result.sweeps) {
+        sweep.points.resize(holdPoints);
+    }
+
+    if (m_socket == ClosedSocket) return result;
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "study_coordinator begin port=%d variants=%d points=%d",
+        m_port,
+        (int)result.variants.size(),
+        holdPoints);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    while (m_completed < tasks) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(native(m_socket), &readable);
+
+        intptr_t highest = m_socket;
+        for (Worker *worker : m_workers) {
+            FD_SET(native(worker->socket), &readable);
+            highest = std::max(highest, worker->socket);
+        }
+
+        timeval timeout = { 1, 0 };
+        if (select(static_cast<int>(highest + 1), &readable, nullptr, nullptr, &timeout) < 0) break;
+
+        if (FD_ISSET(native(m_socket), &readable)) accept();
+
+        for (Worker *worker : m_workers) {
+            if (FD_ISSET(native(worker->socket), &readable) && !receive(worker, &result)) {
+                disconnect(worker);
+            }
+        }
+
+        for (Worker *worker : m_workers) {
+            if (worker->connected && worker->threads > 0) dispatch(worker);
+        }
+
+        m_workers.erase(
+            std::remove_if(
+                m_workers.begin(),
+                m_workers.end(),
+                [](Worker *worker) {
+                    if (worker->connected) return false;
+
+                    delete worker;
+                    return true;
+                }),
+            m_workers.end());
+    }
+
+    MessageWriter done(MessageType::Done);
+    for (Worker *worker : m_workers) {
+        sendAll(worker->socket, done.finish());
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+    result.wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "study_coordinator complete wall_s=%.3f workers=%d dispatched=%lld duplicates=%lld requeued=%lld discarded=%lld",
+        result.wallTime,
+        m_statistics.workers,
+        m_statistics.dispatched,
+        m_statistics.duplicates,
+        m_statistics.requeued,
+        m_statistics.discarded);
+
+    return result;
+}
+
+void StudyCoordinator::accept() {
+    const NativeSocket s = ::accept(native(m_socket), nullptr, nullptr);
+    if (static_cast<intptr_t>(s) == ClosedSocket) return;
+
+    Worker *worker = new Worker;
+    worker->socket = static_cast<intptr_t>(s);
+    setNoDelay(worker->socket);
+    m_workers.push_back(worker);
+}
+
+bool StudyCoordinator::receive(Worker *worker, ParameterStudy::Result *result) {
+    uint8_t chunk[4096];
+    const int n = static_cast<int>(recv(native(worker->socket), reinterpret_cast<char *>(chunk), sizeof(chunk), 0));
+    if (n <= 0) return false;
+
+    std::vector<uint8_t> &buffer = worker->buffer;
+    buffer.insert(buffer.end(), chunk, chunk + n);
+
+    size_t offset = 0;
+    while (buffer.size() - offset >= sizeof(MessageHeader)) {
+        MessageHeader header;
+        std::memcpy(&header, buffer.data() + offset, sizeof(header));
+        if (header.size > 4096) return false;
+        if (buffer.size() - offset - sizeof(header) < header.size) break;
+
+        MessageReader reader(buffer.data() + offset + sizeof(header), header.size);
+        offset += sizeof(header) + header.size;
+
+        const MessageType type = static_cast<MessageType>(header.type);
+        if (type == MessageType::Hello) {
+            const uint32_t magic = reader.get<uint32_t>();
+            const uint32_t version = reader.get<uint32_t>();
+            const int32_t threads = reader.get<int32_t>();
+            if (!reader.ok() || magic != Magic || version != Version || worker->threads > 0) return false;
+            if (!sendAll(worker->socket, m_setup)) return false;
+
+            worker->threads = std::max(threads, 1);
+            ++m_statistics.workers;
+
+            ATG_ENGINE_SIM_TRACE(
+                Headless, Event,
+                "study_coordinator worker_joined threads=%d workers=%d",
+                worker->threads,
+                (int)m_workers.size());
+        }
+        else if (type == MessageType::Result) {
+            const int32_t task = reader.get<int32_t>();
+            DynoSweep::Point point;
+            getPoint(&reader, &point);
+
+            auto running = std::find(worker->running.begin(), worker->running.end(), task);
+            if (!reader.ok() || running == worker->running.end()) return false;
+
+            worker->running.erase(running);
+            --m_tasks[task].copies;
+
+            if (m_tasks[task].done) {
+                ++m_statistics.discarded;
+                continue;
+            }
+
+            const int holdPoints = m_study.getHoldPointCount();
+            result->sweeps[task / holdPoints].points[task % holdPoints] = point;
+            m_tasks[task].done = true;
+            ++m_completed;
+        }
+        else {
+            return false;
+        }
+    }
+
+    buffer.erase(buffer.begin(), buffer.begin() + offset);
+    return true;
+}
+
+void StudyCoordinator::dispatch(Worker *worker) {
+    while (static_cast<int>(worker->running.size()) < worker->threads) {
+        const int task = nextTask(*worker);
+        if (task < 0) break;
+
+        MessageWriter job(MessageType::Job);
+        job.put(static_cast<int32_t>(task));
+        if (!sendAll(worker->socket, job.finish())) {
+            if (m_tasks[task].copies == 0) m_pending.push_front(task);
+            disconnect(worker);
+            return;
+        }
+
+        Task &state = m_tasks[task];
+        if (state.copies > 0) ++m_statistics.duplicates;
+        if (state.dispatched < 0) state.dispatched = m_dispatchCount++;
+
+        ++state.copies;
+        ++m_statistics.dispatched;
+        worker->running.push_back(task);
+    }
+}
+
+int StudyCoordinator::nextTask(const Worker &worker) {
+    while (!m_pending.empty()) {
+        const int task = m_pending.front();
+        m_pending.pop_front();
+        if (!m_tasks[task].done) return task;
+    }
+
+    // Nothing left to hand out; back up the longest-running task this
+    // worker isn't already on
+    int oldest = -1;
+    for (int i = 0; i < static_cast<int>(m_tasks.size()); ++i) {
+        const Task &task = m_tasks[i];
+        if (task.done || task.copies == 0 || task.copies > m_parameters.maxDuplicates) continue;
+        if (oldest >= 0 && task.dispatched >= m_tasks[oldest].dispatched) continue;
+        if (std::find(worker.running.begin(), worker.running.end(), i) != worker.running.end()) continue;
+
+        oldest = i;
+    }
+
+    return oldest;
+}
+
+void StudyCoordinator::disconnect(Worker *worker) {
+    if (!worker->connected) return;
+
+    for (int task : worker->running) {
+        Task &state = m_tasks[task];
+        --state.copies;
+        if (!state.done && state.copies == 0) {
+            m_pending.push_front(task);
+            ++m_statistics.requeued;
+        }
+    }
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "study_coordinator worker_lost running=%d",
+        (int)worker->running.size());
+
+    worker->running.clear();
+    worker->connected = false;
+    closeSocket(worker->socket);
+    worker->socket = ClosedSocket;
+}
+
+StudyWorker::StudyWorker() {
+    /* void */
+}
+
+StudyWorker::~StudyWorker() {
+    /* void */
+}
+
+bool StudyWorker::run(
+    const Parameters &params,
+    const Prepare &prepare,
+    const ParameterStudy::CreateSimulator &create,
+    const ParameterStudy::ReleaseSimulator &release)
+{
+    m_statistics = Statistics();
+    if (!startSockets()) return false;
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo *addresses = nullptr;
+    const std::string port = std::to_string(params.port);
+    if (getaddrinfo(params.host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+        stopSockets();
+        return false;
+    }
+
+    intptr_t s = ClosedSocket;
+    for (addrinfo *address = addresses; address != nullptr && s == ClosedSocket; address = address->ai_next) {
+        s = static_cast<intptr_t>(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+        if (s == ClosedSocket) continue;
+
+        if (connect(native(s), address->ai_addr, static_cast<SocketLength>(address->ai_addrlen)) != 0) {
+            closeSocket(s);
+            s = ClosedSocket;
+        }
+    }
+
+    freeaddrinfo(addresses);
+    if (s == ClosedSocket) {
+        stopSockets();
+        return false;
+    }
+
+    setNoDelay(s);
+
+    const int threads = std::max(params.threads, 1);
+    MessageWriter hello(MessageType::Hello);
+    hello.put(StudyCoordinator::Magic);
+    hello.put(StudyCoordinator::Version);
+    hello.put(static_cast<int32_t>(threads));
+
+    MessageType type;
+    std::vector<uint8_t> payload;
+    ParameterStudy::Parameters studyParams;
+    bool ready = sendAll(s, hello.finish())
+        && receiveMessage(s, &type, &payload)
+        && type == MessageType::Setup;
+
+    std::string snapshotPath = params.snapshotPath;
+    if (ready) {
+        MessageReader reader(payload.data(), payload.size());
+        ready = getStudy(&reader, &studyParams);
+
+        const uint64_t size = reader.get<uint64_t>();
+        const uint8_t *snapshot = reader.remaining(static_cast<size_t>(size));
+        ready = ready && snapshot != nullptr;
+
+        if (snapshotPath.empty()) {
+            snapshotPath =
+                (std::filesystem::temp_directory_path() / "engine_sim_study_worker.snapshot").string();
+        }
+
+        FILE *file = ready ? std::fopen(snapshotPath.c_str(), "wb") : nullptr;
+        ready = file != nullptr && std::fwrite(snapshot, 1, static_cast<size_t>(size), file) == size;
+        if (file != nullptr) ready = (std::fclose(file) == 0) && ready;
+    }
+
+    ParameterStudy study;
+    if (ready) {
+        studyParams.sweep.threads = threads;
+        study.initialize(studyParams);
+        ready = prepare(study, snapshotPath);
+    }
+
+    if (!ready) {
+        closeSocket(s);
+        stopSockets();
+        return false;
+    }
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "study_worker begin threads=%d tasks=%d",
+        threads,
+        study.getTaskCount());
+
+    std::mutex factoryLock, sendLock, queueLock;
+    std::condition_variable queued;
+    std::deque<int> jobs;
+    bool stop = false;
+
+    const ParameterStudy::CreateSimulator lockedCreate =
+        [&](int task, const ParameterStudy::Variant &variant)
+    {
+        std::lock_guard<std::mutex> lock(factoryLock);
+        return create(task, variant);
+    };
+
+    const ParameterStudy::ReleaseSimulator lockedRelease = [&](int task, Simulator *simulator) {
+        std::lock_guard<std::mutex> lock(factoryLock);
+        release(task, simulator);
+    };
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) {
+        pool.emplace_back([&] {
+            for (;;) {
+                int task = -1;
+                {
+                    std::unique_lock<std::mutex> lock(queueLock);
+                    queued.wait(lock, [&] { return stop || !jobs.empty(); });
+                    if (stop) return;
+
+                    task = jobs.front();
+                    jobs.pop_front();
+                }
+
+                const DynoSweep::Point point = study.runTask(task, lockedCreate, lockedRelease);
+
+                MessageWriter reply(MessageType::Result);
+                reply.put(static_cast<int32_t>(task));
+                putPoint(&reply, point);
+
+                std::lock_guard<std::mutex> lock(sendLock);
+                sendAll(s, reply.finish());
+                ++m_statistics.tasks;
+            }
+        });
+    }
+
+    while (receiveMessage(s, &type, &payload)) {
+        if (type != MessageType::Job) break;
+
+        MessageReader reader(payload.data(), payload.size());
+        const int32_t task = reader.get<int32_t>();
+        if (!reader.ok() || task < 0 || task >= study.getTaskCount()) break;
+
+        std::lock_guard<std::mutex> lock(queueLock);
+        jobs.push_back(task);
+        queued.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        stop = true;
+        queued.notify_all();
+    }
+
+    for (std::thread &thread : pool) thread.join();
+
+    const auto t1 = std::chrono::steady_clock::now();
+    m_statistics.wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "study_worker complete tasks=%lld wall_s=%.3f",
+        m_statistics.tasks,
+        m_statistics.wallTime);
+
+    closeSocket(s);
+    stopSockets();
+
+    if (params.snapshotPath.empty()) {
+        std::error_code error;
+        std::filesystem::remove(snapshotPath, error);
+    }
+
+    return true;
+}
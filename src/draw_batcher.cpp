@@ -0,0 +1,207 @@
+#include "../include/draw_batcher.h"
+
+#include "../include/shaders.h"
+
+#include <assert.h>
+#include <cstring>
+
+DrawBatcher::DrawBatcher() {
+    m_engine = nullptr;
+    m_shaders = nullptr;
+    m_vertexBuffer = nullptr;
+    m_geometryIndexBuffer = nullptr;
+    m_indexBuffer = nullptr;
+
+    m_indexData = nullptr;
+    m_indexCapacity = 0;
+    m_indexCount = 0;
+}
+
+DrawBatcher::~DrawBatcher() {
+    assert(m_indexData == nullptr);
+}
+
+void DrawBatcher::initialize(
+    dbasic::DeltaEngine *engine,
+    Shaders *shaders,
+    ysGPUBuffer *vertexBuffer,
+    ysGPUBuffer *indexBuffer,
+    int indexCapacity)
+{
+    m_engine = engine;
+    m_shaders = shaders;
+    m_vertexBuffer = vertexBuffer;
+    m_geometryIndexBuffer = indexBuffer;
+
+    m_indexCapacity = indexCapacity;
+    m_indexData = new unsigned short[indexCapacity];
+    m_engine->GetDevice()->CreateIndexBuffer(
+        &m_indexBuffer, sizeof(unsigned short) * indexCapacity, nullptr);
+
+    beginFrame();
+}
+
+void DrawBatcher::destroy() {
+    if (m_indexBuffer != nullptr) {
+        m_engine->GetDevice()->DestroyGPUBuffer(m_indexBuffer);
+        m_indexBuffer = nullptr;
+    }
+
+    delete[] m_indexData;
+    m_indexData = nullptr;
+    m_indexCapacity = 0;
+}
+
+void DrawBatcher::beginFrame() {
+    for (Batch &batch : m_bins) {
+        batch.open = false;
+    }
+
+    m_indexCount = 0;
+    m_statistics = Statistics();
+}
+
+void DrawBatcher::draw(
+    const GeometryGenerator::GeometryIndices &indices,
+    const unsigned short *indexData,
+    int layer,
+    dbasic::StageEnableFlags flags)
+{
+    if (indices.FaceCount <= 0) return;
+
+    ++m_statistics.shapes;
+
+    Batch *bin = nullptr;
+    Batch *freeBin = nullptr;
+    for (Batch &batch : m_bins) {
+        if (!batch.open) {
+            if (freeBin == nullptr) freeBin = &batch;
+        }
+        else if (batch.layer == layer && batch.flags == flags) {
+            bin = &batch;
+            break;
+        }
+    }
+
+    if (bin != nullptr) {
+        const bool sameState = std::memcmp(
+            &bin->state,
+            &m_shaders->m_objectVariables,
+            sizeof(dbasic::ShaderObjectVariables)) == 0;
+        if (sameState && append(bin, indices, indexData)) return;
+
+        submit(bin);
+    }
+    else if (freeBin != nullptr) {
+        bin = freeBin;
+    }
+    else {
+        // Different layers and stages never overlap in the queue, so any
+        // bin can give way
+        bin = &m_bins[0];
+        submit(bin);
+    }
+
+    open(bin, layer, flags, indices.BaseVertex);
+    if (!append(bin, indices, indexData)) {
+        bin->open = false;
+        submitDirect(indices, layer, flags);
+    }
+}
+
+void DrawBatcher::flush() {
+    for (Batch &batch : m_bins) {
+        if (batch.open) submit(&batch);
+    }
+}
+
+void DrawBatcher::upload() {
+    if (m_indexCount == 0) return;
+
+    m_engine->GetDevice()->EditBufferDataRange(
+        m_indexBuffer,
+        (char *)m_indexData,
+        sizeof(unsigned short) * m_indexCount,
+        0);
+}
+
+bool DrawBatcher::append(
+    Batch *batch,
+    const GeometryGenerator::GeometryIndices &indices,
+    const unsigned short *indexData)
+{
+    const int indexCount = indices.FaceCount * 3;
+    const int offset = indices.BaseVertex - batch->baseVertex;
+
+    // The batch has to stay the last thing written so its range is contiguous
+    if (offset < 0) return false;
+    if (batch->firstIndex + batch->faceCount * 3 != m_indexCount) return false;
+    if (m_indexCount + indexCount > m_indexCapacity) return false;
+
+    const unsigned short *source = indexData + indices.BaseIndex;
+    unsigned short *target = m_indexData + m_indexCount;
+    for (int i = 0; i < indexCount; ++i) {
+        const int index = source[i] + offset;
+        if (index > 0xFFFF) return false;
+
+        target[i] = static_cast<unsigned short>(index);
+    }
+
+    m_indexCount += indexCount;
+    batch->faceCount += indices.FaceCount;
+
+    return true;
+}
+
+void DrawBatcher::open(Batch *batch, int layer, dbasic::StageEnableFlags flags, int baseVertex) {
+    batch->open = true;
+    batch->layer = layer;
+    batch->flags = flags;
+    batch->state = m_shaders->m_objectVariables;
+    batch->baseVertex = baseVertex;
+    batch->firstIndex = m_indexCount;
+    batch->faceCount = 0;
+}
+
+void DrawBatcher::submit(Batch *batch) {
+    batch->open = false;
+    if (batch->faceCount == 0) return;
+
+    // The queued draw captures the object variables, so the batch's own
+    // state is restored just for the call
+    const dbasic::ShaderObjectVariables current = m_shaders->m_objectVariables;
+    m_shaders->m_objectVariables = batch->state;
+
+    m_engine->DrawGeneric(
+        batch->flags,
+        m_indexBuffer,
+        m_vertexBuffer,
+        sizeof(dbasic::Vertex),
+        batch->firstIndex,
+        batch->baseVertex,
+        batch->faceCount,
+        false,
+        batch->layer);
+
+    m_shaders->m_objectVariables = current;
+    ++m_statistics.draws;
+}
+
+void DrawBatcher::submitDirect(
+    const GeometryGenerator::GeometryIndices &indices,
+    int layer,
+    dbasic::StageEnableFlags flags)
+{
+    m_engine->DrawGeneric(
+        flags,
+        m_geometryIndexBuffer,
+        m_vertexBuffer,
+        sizeof(dbasic::Vertex),
+        indices.BaseIndex,
+        indices.BaseVertex,
+        indices.FaceCount,
+        false,
+        layer);
+
+    ++m_statistics.draws;
+}
@@ -0,0 +1,242 @@
+#include "../include/drive_cycle.h"
+
+#include "../include/debug_trace.h"
+#include "../include/job_system.h"
+#include "../include/units.h"
+#include "../include/utilities.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+DriveCycle::ShiftController::ShiftController() {
+    m_gearCount = 0;
+    m_phase = Phase::Start;
+    m_phaseStart = 0.0;
+    m_gear = -1;
+}
+
+DriveCycle::ShiftController::~ShiftController() {
+    /* void */
+}
+
+void DriveCycle::ShiftController::initialize(const Parameters &params, int gearCount) {
+    m_parameters = params;
+    m_gearCount = gearCount;
+    m_phase = Phase::Start;
+    m_phaseStart = 0.0;
+    m_gear = -1;
+}
+
+HeadlessRunner::ControlPoint DriveCycle::ShiftController::update(
+    double t,
+    const SimulationSnapshot &snapshot)
+{
+    const ShiftRules &rules = m_parameters.shiftRules;
+    const double shiftSpeed = (rules.shiftSpeed > 0)
+        ? rules.shiftSpeed
+        : 0.95 * snapshot.redline;
+
+    const double elapsed = t - m_phaseStart;
+    switch (m_phase) {
+        case Phase::Start:
+            if (t >= m_parameters.launchTime && m_gearCount > 0) {
+                m_phase = Phase::Launch;
+                m_phaseStart = t;
+                m_gear = 0;
+            }
+            break;
+        case Phase::Launch:
+            if (elapsed >= rules.launchClutchTime) m_phase = Phase::Drive;
+            break;
+        case Phase::Drive:
+            if (shiftSpeed > 0
+                && units::rpm(snapshot.rpm) >= shiftSpeed
+                && m_gear + 1 < m_gearCount)
+            {
+                m_phase = Phase::Shift;
+                m_phaseStart = t;
+                ++m_gear;
+            }
+            break;
+        case Phase::Shift:
+            if (elapsed >= rules.shiftTime) {
+                m_phase = Phase::Engage;
+                m_phaseStart = t;
+            }
+            break;
+        case Phase::Engage:
+            if (elapsed >= rules.shiftClutchTime) m_phase = Phase::Drive;
+            break;
+    }
+
+    HeadlessRunner::ControlPoint control;
+    control.time = t;
+    control.drivetrain = true;
+    control.starter = t < m_parameters.starterTime;
+    control.gear = m_gear;
+
+    switch (m_phase) {
+        case Phase::Start:
+        case Phase::Shift:
+            control.throttle = 0.0;
+            control.clutch = 0.0;
+            break;
+        case Phase::Launch:
+            control.throttle = rules.throttle;
+            control.clutch = (rules.launchClutchTime > 0)
+                ? clamp((t - m_phaseStart) / rules.launchClutchTime)
+                : 1.0;
+            break;
+        case Phase::Engage:
+            control.throttle = rules.throttle;
+            control.clutch = (rules.shiftClutchTime > 0)
+                ? clamp((t - m_phaseStart) / rules.shiftClutchTime)
+                : 1.0;
+            break;
+        case Phase::Drive:
+            control.throttle = rules.throttle;
+            control.clutch = 1.0;
+            break;
+    }
+
+    return control;
+}
+
+DriveCycle::DriveCycle() {
+    /* void */
+}
+
+DriveCycle::~DriveCycle() {
+    /* void */
+}
+
+void DriveCycle::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.maxTime = std::max(params.maxTime, 0.0);
+    m_parameters.threads = std::max(params.threads, 1);
+
+    std::sort(m_parameters.targetSpeeds.begin(), m_parameters.targetSpeeds.end());
+}
+
+DriveCycle::Result DriveCycle::run(Simulator *simulator) const {
+    Result result;
+    for (double speed : m_parameters.targetSpeeds) {
+        Target target;
+        target.speed = speed;
+        result.targets.push_back(target);
+    }
+
+    Transmission *transmission = simulator->getTransmission();
+    const int gearCount = (transmission != nullptr) ? transmission->getGearCount() : 0;
+    const bool scripted = !m_parameters.schedule.empty();
+
+    ShiftController controller;
+    controller.initialize(m_parameters, gearCount);
+
+    SimulationSnapshot last;
+    double fuelAtLaunch = 0.0, distanceAtLaunch = 0.0;
+
+    HeadlessRunner::Parameters params;
+    params.duration = m_parameters.maxTime;
+    params.frameLength = m_parameters.frameLength;
+    params.schedule = m_parameters.schedule;
+    params.control = [&](double t, HeadlessRunner::ControlPoint *control) {
+        if (!scripted) {
+            *control = controller.update(t, last);
+            return;
+        }
+
+        control->drivetrain = true;
+        control->starter = t < m_parameters.starterTime;
+    };
+    params.stop = [&](const SimulationSnapshot &snapshot) {
+        const double speed = std::abs(snapshot.speed);
+        if (result.launched && snapshot.gear != last.gear) {
+            Shift shift;
+            shift.time = snapshot.time - result.launchTime;
+            shift.fromGear = last.gear;
+            shift.toGear = snapshot.gear;
+            shift.rpm = last.rpm;
+            shift.speed = speed;
+            result.shifts.push_back(shift);
+        }
+
+        if (!result.launched && snapshot.gear >= 0 && snapshot.clutchPressure > 0) {
+            result.launched = true;
+            result.launchTime = snapshot.time;
+            fuelAtLaunch = snapshot.totalFuelMassConsumed;
+            distanceAtLaunch = snapshot.travelledDistance;
+        }
+
+        last = snapshot;
+        if (!result.launched) return false;
+
+        result.fuelMass = snapshot.totalFuelMassConsumed - fuelAtLaunch;
+        result.distance = snapshot.travelledDistance - distanceAtLaunch;
+        result.finalSpeed = speed;
+
+        bool done = m_parameters.stopAtTargets && !result.targets.empty();
+        for (Target &target : result.targets) {
+            if (!target.reached && speed >= target.speed) {
+                target.reached = true;
+                target.time = snapshot.time - result.launchTime;
+                target.distance = result.distance;
+            }
+
+            done = done && target.reached;
+        }
+
+        return done;
+    };
+
+    HeadlessRunner runner;
+    runner.initialize(params);
+    const HeadlessRunner::Statistics stats = runner.run(simulator);
+    runner.destroy();
+
+    result.valid = result.launched;
+    result.simulatedTime = stats.simulatedTime;
+    result.wallTime = stats.wallTime;
+
+    return result;
+}
+
+std::vector<DriveCycle::Result> DriveCycle::run(
+    int variants,
+    const CreateSimulator &create,
+    const ReleaseSimulator &release) const
+{
+    std::vector<Result> results(std::max(variants, 0));
+
+    const int threads = std::min(m_parameters.threads, std::max(1, variants));
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "drive_cycle begin variants=%d threads=%d scripted=%d max_s=%.3f",
+        variants,
+        threads,
+        m_parameters.schedule.empty() ? 0 : 1,
+        m_parameters.maxTime);
+
+    std::mutex factoryLock;
+
+    JobSystem::Shared().parallelFor(variants, [&](int i) {
+        Simulator *simulator = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(factoryLock);
+            simulator = create(i);
+        }
+
+        if (simulator == nullptr) return;
+
+        results[i] = run(simulator);
+
+        std::lock_guard<std::mutex> lock(factoryLock);
+        release(i, simulator);
+    }, JobSystem::Priority::Normal, threads);
+
+    ATG_ENGINE_SIM_TRACE(Headless, Event, "drive_cycle complete");
+
+    return results;
+}
@@ -0,0 +1,212 @@
+#include "../include/dyno_sweep.h"
+
+#include "../include/constants.h"
+#include "../include/debug_trace.h"
+#include "../include/job_system.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+
+DynoSweep::DynoSweep() {
+    /* void */
+}
+
+DynoSweep::~DynoSweep() {
+    /* void */
+}
+
+void DynoSweep::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.stepRpm = std::max(params.stepRpm, 1.0);
+    m_parameters.measureCycles = std::max(params.measureCycles, 1);
+    m_parameters.threads = std::max(params.threads, 1);
+}
+
+std::vector<double> DynoSweep::getHoldPoints() const {
+    std::vector<double> points;
+    for (double rpm = m_parameters.minRpm; rpm <= m_parameters.maxRpm + 1E-6; rpm += m_parameters.stepRpm) {
+        points.push_back(rpm);
+    }
+
+    return points;
+}
+
+DynoSweep::Result DynoSweep::run(const CreateSimulator &create, const ReleaseSimulator &release) {
+    const std::vector<double> holdPoints = getHoldPoints();
+
+    Result result;
+    result.points.resize(holdPoints.size());
+
+    const int threads = std::min(m_parameters.threads, std::max(1, (int)holdPoints.size()));
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "dyno_sweep begin points=%d threads=%d settle_s=%.3f cycles=%d",
+        (int)holdPoints.size(),
+        threads,
+        m_parameters.settleTime,
+        m_parameters.measureCycles);
+
+    std::mutex factoryLock;
+    const auto t0 = std::chrono::steady_clock::now();
+
+    JobSystem::Shared().parallelFor((int)holdPoints.size(), [&](int i) {
+        Simulator *simulator = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(factoryLock);
+            simulator = create(i);
+        }
+
+        if (simulator == nullptr) {
+            result.points[i].rpm = holdPoints[i];
+            return;
+        }
+
+        result.points[i] = runPoint(simulator, holdPoints[i]);
+
+        std::lock_guard<std::mutex> lock(factoryLock);
+        release(i, simulator);
+    }, JobSystem::Priority::Normal, threads);
+
+    const auto t1 = std::chrono::steady_clock::now();
+    result.wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+
+    ATG_ENGINE_SIM_TRACE(Headless, Event, "dyno_sweep complete wall_s=%.3f", result.wallTime);
+
+    return result;
+}
+
+DynoSweep::Point DynoSweep::runPoint(Simulator *simulator, double rpm) const {
+    // The runner clamps the dyno to the engine's range, so the point is
+    // labeled with the speed that is actually held
+    Engine *engine = simulator->getEngine();
+    const double speed = std::clamp(
+        units::rpm(rpm), engine->getDynoMinSpeed(), engine->getDynoMaxSpeed());
+
+    Point point;
+    point.rpm = speed / units::rpm(1.0);
+
+    // An engine cycle is two crank revolutions
+    const double cycleTime = (speed > 0) ? 4 * constants::pi / speed : 0.0;
+    const double measureStart = m_parameters.settleTime;
+
+    double torque = 0, manifoldPressure = 0, intakeAfr = 0;
+    int samples = 0;
+
+    SteadyStateDetector detector;
+    detector.initialize(m_parameters.steadyState);
+    const double measureEnd = measureStart + cycleTime * m_parameters.measureCycles;
+
+    HeadlessRunner::ControlPoint hold;
+    hold.throttle = m_parameters.throttle;
+    hold.dynoSpeed = speed;
+    hold.dynoEnabled = true;
+
+    simulator->synthesizer().setAnalysisEnabled(m_parameters.audioMetrics);
+
+    HeadlessRunner::Parameters params;
+    params.duration = measureEnd;
+    params.frameLength = m_parameters.frameLength;
+    params.schedule.push_back(hold);
+    params.stop = [&](const SimulationSnapshot &snapshot) {
+        point.audioAnalyzed = snapshot.audioAnalyzed;
+        point.audioLoudness = snapshot.audioLoudness;
+        point.audioSpectralCentroid = snapshot.audioSpectralCentroid;
+        point.audioRoughness = snapshot.audioRoughness;
+        point.imep = snapshot.imep;
+        point.imepCoefficientOfVariation = snapshot.imepCoefficientOfVariation;
+
+        if (!point.settled && detector.addSample(snapshot)) {
+            point.settled = true;
+            point.settledTime = snapshot.time;
+
+            if (m_parameters.stopWhenSettled && snapshot.time < measureStart) {
+                return true;
+            }
+        }
+
+        if (snapshot.time < measureStart) return false;
+
+        torque += snapshot.filteredDynoTorque;
+        manifoldPressure += snapshot.manifoldPressure;
+        intakeAfr += snapshot.intakeAfr;
+        ++samples;
+
+        return snapshot.time >= measureEnd;
+    };
+
+    HeadlessRunner runner;
+    runner.initialize(params);
+    const HeadlessRunner::Statistics stats = runner.run(simulator);
+    runner.destroy();
+
+    point.simulatedTime = stats.simulatedTime;
+    point.wallTime = stats.wallTime;
+    if (samples > 0) {
+        point.torque = torque / samples;
+        point.manifoldPressure = manifoldPressure / samples;
+        point.intakeAfr = intakeAfr / samples;
+        point.valid = true;
+    }
+    else if (point.settled) {
+        const SteadyStateDetector::Average average = detector.getWindowAverage();
+        point.torque = average.torque;
+        point.manifoldPressure = average.manifoldPressure;
+        point.intakeAfr = average.afr;
+        point.valid = true;
+    }
+
+    point.power = point.torque * speed;
+
+    return point;
+}
+
+void DynoSweep::WriteAudioColumns(FILE *file, const Point &point) {
+    if (!point.audioAnalyzed) {
+        std::fprintf(file, ",,,");
+        return;
+    }
+
+    std::fprintf(
+        file,
+        ",%.2f,%.1f,%.4f",
+        point.audioLoudness,
+        point.audioSpectralCentroid,
+        point.audioRoughness);
+}
+
+bool DynoSweep::WriteCsv(const std::string &path, const Result &result) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    std::fprintf(file, "rpm,torque_nm,torque_lb_ft,power_kw,power_hp,manifold_kpa,intake_afr,imep_kpa,imep_cov,settled_s,audio_db,centroid_hz,roughness\n");
+    for (const Point &point : result.points) {
+        if (!point.valid) continue;
+
+        std::fprintf(
+            file,
+            "%.0f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,",
+            point.rpm,
+            units::convert(point.torque, units::Nm),
+            units::convert(point.torque, units::ft_lb),
+            units::convert(point.power, units::kW),
+            units::convert(point.power, units::hp),
+            units::convert(point.manifoldPressure, units::kPa),
+            point.intakeAfr,
+            units::convert(point.imep, units::kPa),
+            point.imepCoefficientOfVariation);
+
+        if (point.settled) std::fprintf(file, "%.3f", point.settledTime);
+        WriteAudioColumns(file, point);
+        std::fprintf(file, "\n");
+    }
+
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+
+    return ok;
+}
@@ -5,10 +5,38 @@
 #include "../include/units.h"
 #include "../include/fuel.h"
 #include "../include/piston_engine_simulator.h"
+#include "../include/valvetrain.h"
 
 #include <cmath>
 #include <assert.h>
 
+namespace {
+constexpr double octaneMolarMass = units::mass(114.23, units::g);
+constexpr double oxygenMolarMass = units::mass(31.9988, units::g);
+constexpr double nitrogenMolarMass = units::mass(28.014, units::g);
+
+double intakeAfr(double totalOxygen, double totalFuel) {
+    if (totalFuel == 0) return 0;
+    else {
+        return
+            (oxygenMolarMass * totalOxygen / 0.21)
+            / (totalFuel * octaneMolarMass);
+    }
+}
+
+double exhaustO2(double totalInert, double totalOxygen, double totalFuel) {
+    if (totalFuel == 0) return 0;
+    else {
+        return
+            (oxygenMolarMass * totalOxygen)
+            / (
+                totalFuel * octaneMolarMass
+                + nitrogenMolarMass * totalInert
+                + oxygenMolarMass * totalOxygen);
+    }
+}
+} /* namespace */
+
 Engine::Engine() {
     m_name = "";
 
@@ -20,6 +48,7 @@ Engine::Engine() {
     m_exhaustSystems = nullptr;
     m_intakes = nullptr;
     m_combustionChambers = nullptr;
+    m_chamberFluidStates = nullptr;
 
     m_crankshaftCount = 0;
     m_cylinderBankCount = 0;
@@ -40,6 +69,10 @@ Engine::Engine() {
     m_initialHighFrequencyGain = 0.01;
     m_initialJitter = 0.5;
     m_initialNoise = 1.0;
+
+    m_multiZone = false;
+    m_creviceVolume = 0.0;
+    m_knockOctane = 95.0;
 }
 
 Engine::~Engine() {
@@ -71,6 +104,9 @@ void Engine::initialize(const Parameters &params) {
     m_initialSimulationFrequency = params.initialSimulationFrequency;
     m_initialJitter = params.initialJitter;
     m_initialNoise = params.initialNoise;
+    m_multiZone = params.multiZone;
+    m_creviceVolume = params.creviceVolume;
+    m_knockOctane = params.knockOctane;
 
     m_crankshafts = new Crankshaft[m_crankshaftCount];
     m_cylinderBanks = new CylinderBank[m_cylinderBankCount];
@@ -80,6 +116,7 @@ void Engine::initialize(const Parameters &params) {
     m_exhaustSystems = new ExhaustSystem[m_exhaustSystemCount];
     m_intakes = new Intake[m_intakeCount];
     m_combustionChambers = new CombustionChamber[m_cylinderCount];
+    m_chamberFluidStates = new CombustionChamber::FluidState[m_cylinderCount];
 
     for (int i = 0; i < m_exhaustSystemCount; ++i) {
         m_exhaustSystems[i].m_index = i;
@@ -87,6 +124,7 @@ void Engine::initialize(const Parameters &params) {
 
     for (int i = 0; i < m_cylinderCount; ++i) {
         m_combustionChambers[i].setEngine(this);
+        m_combustionChambers[i].setFluidState(&m_chamberFluidStates[i]);
     }
 }
 
@@ -120,6 +158,7 @@ void Engine::destroy() {
     if (m_exhaustSystems != nullptr) delete[] m_exhaustSystems;
     if (m_intakes != nullptr) delete[] m_intakes;
     if (m_combustionChambers != nullptr) delete[] m_combustionChambers;
+    if (m_chamberFluidStates != nullptr) delete[] m_chamberFluidStates;
 
     m_crankshafts = nullptr;
     m_cylinderBanks = nullptr;
@@ -129,6 +168,7 @@ void Engine::destroy() {
     m_exhaustSystems = nullptr;
     m_intakes = nullptr;
     m_combustionChambers = nullptr;
+    m_chamberFluidStates = nullptr;
     m_throttle = nullptr;
 }
 
@@ -300,6 +340,19 @@ double Engine::getIntakeFlowRate() const {
 
 void Engine::update(double dt) {
     m_throttle->update(dt, this);
+
+    // Heads may share a valvetrain, which still only steps once
+    for (int i = 0; i < m_cylinderBankCount; ++i) {
+        Valvetrain *valvetrain = m_heads[i].getValvetrain();
+        bool updated = false;
+        for (int j = 0; j < i && !updated; ++j) {
+            updated = m_heads[j].getValvetrain() == valvetrain;
+        }
+
+        if (!updated && valvetrain != nullptr) {
+            valvetrain->update(dt);
+        }
+    }
 }
 
 double Engine::getManifoldPressure() const {
@@ -319,15 +372,7 @@ double Engine::getIntakeAfr() const {
         totalFuel += m_intakes[i].m_system.n_fuel();
     }
 
-    constexpr double octaneMolarMass = units::mass(114.23, units::g);
-    constexpr double oxygenMolarMass = units::mass(31.9988, units::g);
-
-    if (totalFuel == 0) return 0;
-    else {
-        return
-            (oxygenMolarMass * totalOxygen / 0.21)
-            / (totalFuel * octaneMolarMass);
-    }
+    return intakeAfr(totalOxygen, totalFuel);
 }
 
 double Engine::getExhaustO2() const {
@@ -340,25 +385,15 @@ double Engine::getExhaustO2() const {
         totalFuel += m_exhaustSystems[i].m_system.n_fuel();
     }
 
-    constexpr double octaneMolarMass = units::mass(114.23, units::g);
-    constexpr double oxygenMolarMass = units::mass(31.9988, units::g);
-    constexpr double nitrogenMolarMass = units::mass(28.014, units::g);
-
-    if (totalFuel == 0) return 0;
-    else {
-        return
-            (oxygenMolarMass * totalOxygen)
-            / (
-                totalFuel * octaneMolarMass
-                + nitrogenMolarMass * totalInert
-                + oxygenMolarMass * totalOxygen);
-    }
+    return exhaustO2(totalInert, totalOxygen, totalFuel);
 }
 
 void Engine::resetFuelConsumption() {
     for (int i = 0; i < m_intakeCount; ++i) {
         m_intakes[i].m_totalFuelInjected = 0;
     }
+
+    m_aggregates.totalFuelMassConsumed = 0;
 }
 
 double Engine::getTotalFuelMassConsumed() const {
@@ -374,6 +409,33 @@ double Engine::getTotalVolumeFuelConsumed() const {
     return getTotalFuelMassConsumed() / m_fuel.getDensity();
 }
 
+void Engine::updateAggregates() {
+    double pressureSum = 0.0, flowRate = 0.0, fuelInjected = 0.0;
+    double intakeOxygen = 0.0, intakeFuel = 0.0;
+    for (int i = 0; i < m_intakeCount; ++i) {
+        const Intake &intake = m_intakes[i];
+        pressureSum += intake.m_system.pressure();
+        flowRate += intake.m_flowRate;
+        fuelInjected += intake.m_totalFuelInjected;
+        intakeOxygen += intake.m_system.n_o2();
+        intakeFuel += intake.m_system.n_fuel();
+    }
+
+    double exhaustInert = 0.0, exhaustOxygen = 0.0, exhaustFuel = 0.0;
+    for (int i = 0; i < m_exhaustSystemCount; ++i) {
+        const GasSystem &system = m_exhaustSystems[i].m_system;
+        exhaustInert += system.n_inert();
+        exhaustOxygen += system.n_o2();
+        exhaustFuel += system.n_fuel();
+    }
+
+    m_aggregates.manifoldPressure = (m_intakeCount > 0) ? pressureSum / m_intakeCount : 0.0;
+    m_aggregates.intakeFlowRate = flowRate;
+    m_aggregates.intakeAfr = intakeAfr(intakeOxygen, intakeFuel);
+    m_aggregates.exhaustO2 = exhaustO2(exhaustInert, exhaustOxygen, exhaustFuel);
+    m_aggregates.totalFuelMassConsumed = fuelInjected * m_fuel.getMolecularMass();
+}
+
 int Engine::getMaxDepth() const {
     int maxDepth = 0;
     for (int i = 0; i < m_crankshaftCount; ++i) {
@@ -383,11 +445,18 @@ int Engine::getMaxDepth() const {
     return maxDepth;
 }
 
-Simulator *Engine::createSimulator(Vehicle *vehicle, Transmission *transmission) {
+Simulator *Engine::createSimulator(
+    Vehicle *vehicle,
+    Transmission *transmission,
+    bool reducedKinematics,
+    bool audio)
+{
     PistonEngineSimulator *simulator = new PistonEngineSimulator;
     Simulator::Parameters simulatorParams;
     simulatorParams.systemType = Simulator::SystemType::NsvOptimized;
+    simulatorParams.audio = audio;
     simulator->initialize(simulatorParams);
+    simulator->setReducedKinematics(reducedKinematics);
 
     simulator->loadSimulation(this, vehicle, transmission);
     simulator->setFluidSimulationSteps(8);
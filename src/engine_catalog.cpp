@@ -0,0 +1,388 @@
+#include "../include/engine_catalog.h"
+
+#include "../include/engine.h"
+#include "../include/engine_loader.h"
+#include "../include/exhaust_system.h"
+#include "../include/impulse_response.h"
+#include "../include/units.h"
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/compiler.h"
+#include "../scripting/include/script_sources.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+constexpr uint64_t FnvOffset = 14695981039346656037ull;
+constexpr uint64_t FnvPrime = 1099511628211ull;
+
+bool readFile(const std::string &path, std::string *contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    contents->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Fields are tab separated, so names can't hold tabs or line breaks
+std::string sanitize(const std::string &s) {
+    std::string clean = s;
+    std::replace_if(clean.begin(), clean.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+    return clean;
+}
+
+std::vector<std::string> split(const std::string &s, char separator) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        const size_t end = s.find(separator, start);
+        fields.push_back(s.substr(start, (end == std::string::npos) ? std::string::npos : end - start));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+
+    return fields;
+}
+} /* namespace */
+
+EngineCatalog::EngineCatalog() {
+    m_thread = nullptr;
+    m_refreshing = false;
+}
+
+EngineCatalog::~EngineCatalog() {
+    assert(m_thread == nullptr);
+}
+
+void EngineCatalog::initialize(const std::string &assetPath, const std::string &indexPath) {
+    destroy();
+
+    const std::filesystem::path assets = std::filesystem::path(assetPath) / "assets";
+    m_assetPath = assetPath;
+    m_indexPath = indexPath.empty()
+        ? (assets / "engines" / ".engine_catalog").string()
+        : indexPath;
+
+    std::vector<Entry> entries;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(assets / "engines", error);
+        !error && it != std::filesystem::recursive_directory_iterator();
+        it.increment(error))
+    {
+        if (!it->is_regular_file(error) || it->path().extension() != ".mr") continue;
+
+        std::string source;
+        if (!readFile(it->path().string(), &source)) continue;
+        else if (source.find("public node main") == std::string::npos) continue;
+
+        Entry entry;
+        entry.script = it->path().lexically_relative(assets).generic_string();
+        entry.hash = hashScript(it->path().string());
+        entries.push_back(entry);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.script < b.script;
+    });
+
+    std::vector<Entry> cached;
+    ReadIndex(m_indexPath, &cached);
+    for (Entry &entry : entries) {
+        for (const Entry &c : cached) {
+            if (c.script == entry.script && c.hash == entry.hash) {
+                entry = c;
+                break;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_entries = entries;
+}
+
+void EngineCatalog::destroy() {
+    if (m_thread != nullptr) {
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_refreshing = false;
+}
+
+void EngineCatalog::refresh(bool background) {
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    if (m_thread != nullptr) {
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_refreshing = true;
+    }
+
+    if (background) {
+        m_thread = new std::thread(&EngineCatalog::indexEntries, this);
+    }
+    else {
+        indexEntries();
+    }
+#else
+    (void)background;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+}
+
+bool EngineCatalog::isRefreshing() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_refreshing;
+}
+
+std::vector<EngineCatalog::Entry> EngineCatalog::getEntries() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_entries;
+}
+
+int EngineCatalog::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return static_cast<int>(m_entries.size());
+}
+
+bool EngineCatalog::getEntry(int index, Entry *entry) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (index < 0 || index >= static_cast<int>(m_entries.size())) return false;
+
+    *entry = m_entries[index];
+    return true;
+}
+
+std::string EngineCatalog::writeLauncher(const Entry &entry, const std::string &tag) const {
+    const std::filesystem::path assets = std::filesystem::path(m_assetPath) / "assets";
+
+    std::string source;
+    if (!readFile((assets / "main.mr").string(), &source)) return "";
+
+    // The engine import is the one reaching into engines/
+    const std::string import = "import \"" + entry.script + "\"";
+    size_t line = 0;
+    bool replaced = false;
+    while (line < source.size()) {
+        size_t end = source.find('\n', line);
+        if (end == std::string::npos) end = source.size();
+
+        const std::string text = source.substr(line, end - line);
+        if (text.compare(0, 16, "import \"engines/") == 0) {
+            source.replace(line, end - line, import);
+            replaced = true;
+            break;
+        }
+
+        line = end + 1;
+    }
+
+    if (!replaced) source = import + "\n" + source;
+
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(entry.hash));
+    const std::string path = (assets / ("." + tag + "_" + hash + ".mr")).string();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return "";
+
+    file << source;
+    return file.good() ? path : "";
+}
+
+std::string EngineCatalog::Describe(const Entry &entry) {
+    if (!entry.indexed) return entry.script + " (not indexed yet)";
+    else if (!entry.valid) return entry.script + " (fails to build)";
+
+    char description[256];
+    std::snprintf(
+        description,
+        sizeof(description),
+        "%s - %d cyl, %.1f L, %.0f rpm",
+        entry.name.c_str(),
+        entry.cylinderCount,
+        units::convert(entry.displacement, units::L),
+        units::toRpm(entry.redline));
+
+    return description;
+}
+
+bool EngineCatalog::ReadIndex(const std::string &path, std::vector<Entry> *entries) {
+    entries->clear();
+
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    if (!std::getline(file, line) || line != "engine_catalog\t" + std::to_string(Version)) return false;
+
+    // hash, valid, script, name, cylinders, displacement, redline, responses
+    while (std::getline(file, line)) {
+        const std::vector<std::string> fields = split(line, '\t');
+        if (fields.size() != 8) continue;
+
+        Entry entry;
+        entry.hash = std::strtoull(fields[0].c_str(), nullptr, 16);
+        entry.indexed = true;
+        entry.valid = fields[1] == "1";
+        entry.script = fields[2];
+        entry.name = fields[3];
+        entry.cylinderCount = std::atoi(fields[4].c_str());
+        entry.displacement = std::atof(fields[5].c_str());
+        entry.redline = std::atof(fields[6].c_str());
+        if (!fields[7].empty()) entry.impulseResponses = split(fields[7], ';');
+
+        entries->push_back(entry);
+    }
+
+    return true;
+}
+
+bool EngineCatalog::WriteIndex(const std::string &path, const std::vector<Entry> &entries) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file << "engine_catalog\t" << Version << "\n";
+    for (const Entry &entry : entries) {
+        if (!entry.indexed) continue;
+
+        std::string responses;
+        for (const std::string &response : entry.impulseResponses) {
+            if (!responses.empty()) responses += ';';
+            responses += sanitize(response);
+        }
+
+        char numbers[128];
+        std::snprintf(
+            numbers,
+            sizeof(numbers),
+            "%d\t%.17g\t%.17g",
+            entry.cylinderCount,
+            entry.displacement,
+            entry.redline);
+
+        char hash[32];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(entry.hash));
+
+        file << hash << '\t'
+            << (entry.valid ? "1" : "0") << '\t'
+            << sanitize(entry.script) << '\t'
+            << sanitize(entry.name) << '\t'
+            << numbers << '\t'
+            << responses << "\n";
+    }
+
+    return file.good();
+}
+
+void EngineCatalog::indexEntries() {
+    std::vector<Entry> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (const Entry &entry : m_entries) {
+            if (!entry.indexed) pending.push_back(entry);
+        }
+    }
+
+    for (Entry &entry : pending) {
+        entry.valid = build(&entry);
+        entry.indexed = true;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (Entry &current : m_entries) {
+            if (current.script == entry.script) current = entry;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!pending.empty()) WriteIndex(m_indexPath, m_entries);
+    m_refreshing = false;
+}
+
+bool EngineCatalog::build(Entry *entry) const {
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    const std::string launcher = writeLauncher(*entry, "catalog_index");
+    if (launcher.empty()) return false;
+
+    es_script::Compiler compiler;
+    compiler.initialize();
+    compiler.addSearchPath((std::filesystem::path(m_assetPath) / "es").string().c_str());
+
+    EngineLoader::Result built;
+    if (compiler.compile(launcher.c_str())) {
+        const es_script::Compiler::Output output = compiler.execute();
+        built.engine = output.engine;
+        built.vehicle = output.vehicle;
+        built.transmission = output.transmission;
+    }
+
+    compiler.destroy();
+
+    std::error_code error;
+    std::filesystem::remove(launcher, error);
+
+    Engine *engine = built.engine;
+    if (engine == nullptr) {
+        EngineLoader::Release(&built);
+        return false;
+    }
+
+    engine->calculateDisplacement();
+    entry->name = engine->getName();
+    entry->cylinderCount = engine->getCylinderCount();
+    entry->displacement = engine->getDisplacement();
+    entry->redline = engine->getRedline();
+    entry->impulseResponses.clear();
+    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+        const ImpulseResponse *response = engine->getExhaustSystem(i)->getImpulseResponse();
+        if (response == nullptr) continue;
+
+        const std::string file = std::filesystem::path(response->getFilename()).filename().string();
+        if (std::find(entry->impulseResponses.begin(), entry->impulseResponses.end(), file)
+            == entry->impulseResponses.end())
+        {
+            entry->impulseResponses.push_back(file);
+        }
+    }
+
+    EngineLoader::Release(&built);
+    return true;
+#else
+    (void)entry;
+    return false;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+}
+
+uint64_t EngineCatalog::hashScript(const std::string &script) const {
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    // Same search paths as the compiler, so edited imports count
+    es_script::ScriptSources sources;
+    for (const std::string &path : es_script::ScriptSources::SearchPaths(m_assetPath)) {
+        sources.addSearchPath(path);
+    }
+
+    if (sources.collect(script)) return sources.getHash();
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+    std::string source;
+    readFile(script, &source);
+
+    uint64_t hash = FnvOffset;
+    for (char c : source) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FnvPrime;
+    }
+
+    return hash;
+}
@@ -0,0 +1,105 @@
+#include "../include/engine_controller.h"
+
+#include "../include/engine.h"
+#include "../include/utilities.h"
+
+#include <algorithm>
+
+EngineController::EngineController() {
+    m_period = 0.0;
+    m_elapsed = 0.0;
+    m_controlCount = 0;
+}
+
+EngineController::~EngineController() {
+    /* void */
+}
+
+void EngineController::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_period = (params.controlRate > 0) ? 1.0 / params.controlRate : 0.0;
+    m_elapsed = 0.0;
+    m_controlCount = 0;
+    m_sensors = Sensors();
+    m_outputs = Outputs();
+}
+
+void EngineController::reset(Engine *engine) {
+    m_elapsed = 0.0;
+    m_sensors = Sensors();
+    m_outputs = Outputs();
+    apply(engine);
+}
+
+void EngineController::step(double dt, Engine *engine) {
+    m_elapsed += dt;
+    if (m_elapsed < m_period) return;
+
+    m_sensors = readSensors(engine);
+    control(m_elapsed, m_sensors, &m_outputs);
+    apply(engine);
+
+    m_elapsed = 0.0;
+    ++m_controlCount;
+}
+
+EngineController::Sensors EngineController::readSensors(const Engine *engine) {
+    const Engine::Aggregates &aggregates = engine->getAggregates();
+
+    Sensors sensors;
+    sensors.speed = engine->getSpeed();
+    sensors.throttle = 1 - engine->getThrottle();
+    sensors.manifoldPressure = aggregates.manifoldPressure;
+    sensors.intakeAfr = aggregates.intakeAfr;
+    sensors.exhaustO2 = aggregates.exhaustO2;
+    sensors.intakeFlowRate = aggregates.intakeFlowRate;
+
+    return sensors;
+}
+
+void EngineController::control(double dt, const Sensors &sensors, Outputs *outputs) {
+    const Parameters &params = m_parameters;
+
+    if (params.targetAfr > 0 && sensors.intakeAfr > 0) {
+        // Lean reads above the target and adds fuel
+        const double error = (sensors.intakeAfr - params.targetAfr) / params.targetAfr;
+        outputs->fuelTrim = clamp(
+            outputs->fuelTrim + params.fuelTrimGain * error * dt,
+            -params.maxFuelTrim,
+            params.maxFuelTrim);
+    }
+
+    outputs->timingTrim = 0.0;
+    if (params.idleRpm > 0 && sensors.throttle < params.idleThrottle) {
+        const double error = params.idleRpm - sensors.speed;
+        outputs->idleAir = clamp(
+            outputs->idleAir + params.idleAirGain * error * dt,
+            0.0,
+            params.maxIdleAir);
+        outputs->timingTrim = clamp(
+            params.idleSparkGain * error,
+            -params.maxIdleSpark,
+            params.maxIdleSpark);
+    }
+
+    if (params.revLimit > 0) {
+        outputs->sparkCut = outputs->sparkCut
+            ? sensors.speed > params.revLimit - params.revLimitHysteresis
+            : sensors.speed > params.revLimit;
+    }
+}
+
+void EngineController::apply(Engine *engine) const {
+    for (int i = 0; i < engine->getIntakeCount(); ++i) {
+        Intake *intake = engine->getIntake(i);
+        if (intake->getFuelTrim() != m_outputs.fuelTrim) {
+            intake->setFuelTrim(m_outputs.fuelTrim);
+        }
+
+        intake->setIdleAir(m_outputs.idleAir);
+    }
+
+    IgnitionModule *ignition = engine->getIgnitionModule();
+    ignition->setTimingTrim(m_outputs.timingTrim);
+    ignition->setSparkCut(m_outputs.sparkCut);
+}
@@ -0,0 +1,80 @@
+#include "../include/engine_definition.h"
+
+#include "../include/engine.h"
+#include "../include/engine_instance.h"
+#include "../include/transmission.h"
+#include "../include/vehicle.h"
+
+#include <assert.h>
+
+EngineDefinition::EngineDefinition() {
+    m_structureHash = 0;
+    m_instanceCount = 0;
+    m_loaded = false;
+}
+
+EngineDefinition::~EngineDefinition() {
+    assert(getInstanceCount() == 0);
+    destroy();
+}
+
+bool EngineDefinition::load(const std::string &snapshotPath) {
+    destroy();
+
+    if (!m_file.open(snapshotPath)) return false;
+
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+    if (!EngineSnapshot::read(
+        m_file.getData(), m_file.getSize(), &engine, &vehicle, &transmission, &m_tables))
+    {
+        m_file.close();
+        return false;
+    }
+
+    // The first engine only fills the tables
+    EngineSnapshot::hashStructure(engine, vehicle, transmission, &m_structureHash);
+
+    delete vehicle;
+    delete transmission;
+    EngineSnapshot::releaseTables(engine, &m_tables);
+    engine->destroy();
+    delete engine;
+
+    m_snapshotPath = snapshotPath;
+    m_loaded = true;
+
+    return true;
+}
+
+void EngineDefinition::destroy() {
+    assert(getInstanceCount() == 0);
+
+    m_tables.release();
+    m_file.close();
+    m_snapshotPath.clear();
+    m_structureHash = 0;
+    m_loaded = false;
+}
+
+bool EngineDefinition::instantiate(EngineInstance *instance) {
+    instance->destroy();
+    if (!m_loaded) return false;
+
+    if (!EngineSnapshot::read(
+        m_file.getData(),
+        m_file.getSize(),
+        &instance->m_engine,
+        &instance->m_vehicle,
+        &instance->m_transmission,
+        &m_tables))
+    {
+        return false;
+    }
+
+    instance->m_definition = this;
+    m_instanceCount.fetch_add(1, std::memory_order_acq_rel);
+
+    return true;
+}
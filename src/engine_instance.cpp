@@ -0,0 +1,58 @@
+#include "../include/engine_instance.h"
+
+#include "../include/engine.h"
+#include "../include/engine_definition.h"
+#include "../include/simulator.h"
+#include "../include/transmission.h"
+#include "../include/vehicle.h"
+
+#include <assert.h>
+
+EngineInstance::EngineInstance() {
+    m_definition = nullptr;
+    m_engine = nullptr;
+    m_vehicle = nullptr;
+    m_transmission = nullptr;
+    m_simulator = nullptr;
+}
+
+EngineInstance::~EngineInstance() {
+    assert(m_engine == nullptr);
+}
+
+void EngineInstance::destroy() {
+    if (m_simulator != nullptr) {
+        m_simulator->releaseSimulation();
+        delete m_simulator;
+    }
+
+    delete m_vehicle;
+    delete m_transmission;
+
+    if (m_engine != nullptr) {
+        EngineSnapshot::releaseTables(m_engine, &m_definition->m_tables);
+        m_engine->destroy();
+        delete m_engine;
+
+        m_definition->m_instanceCount.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    m_definition = nullptr;
+    m_engine = nullptr;
+    m_vehicle = nullptr;
+    m_transmission = nullptr;
+    m_simulator = nullptr;
+}
+
+void EngineInstance::setSimulator(Simulator *simulator) {
+    assert(m_simulator == nullptr);
+    m_simulator = simulator;
+}
+
+void EngineInstance::setDrivetrain(Vehicle *vehicle, Transmission *transmission) {
+    assert(vehicle == nullptr || m_vehicle == nullptr);
+    assert(transmission == nullptr || m_transmission == nullptr);
+
+    if (vehicle != nullptr) m_vehicle = vehicle;
+    if (transmission != nullptr) m_transmission = transmission;
+}
@@ -0,0 +1,642 @@
+#include "../include/engine_loader.h"
+
+#include "../include/allocation_tracker.h"
+#include "../include/artifact_cache.h"
+#include "../include/engine.h"
+#include "../include/engine_snapshot.h"
+#include "../include/vehicle.h"
+#include "../include/transmission.h"
+#include "../include/simulator.h"
+#include "../include/startup_timeline.h"
+#include "../include/step_profiler.h"
+#include "../include/exhaust_system.h"
+#include "../include/impulse_response_cache.h"
+#include "../include/latency_profile.h"
+#include "../include/thread_policy.h"
+#include "../include/units.h"
+#include "../include/debug_trace.h"
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/compiler.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+namespace {
+
+// Every field of ApplicationSettings, in the order the compiled script
+// cache stores them
+template <typename Visitor>
+void visitSettings(ApplicationSettings &s, Visitor &v) {
+    v(s.startFullscreen);
+    v(s.powerUnits);
+    v(s.torqueUnits);
+    v(s.speedUnits);
+    v(s.pressureUnits);
+    v(s.boostUnits);
+    v(s.latencyProfile);
+    v(s.audioLatency);
+    v(s.latencyProbe);
+    v(s.speculativeLookahead);
+    v(s.reducedAudioMemory);
+    v(s.audioDither);
+    v(s.threadedPhysics);
+    v(s.realtimeAudio);
+    v(s.realtimePhysics);
+    v(s.audioCore);
+    v(s.physicsCore);
+    v(s.telemetryExport);
+    v(s.telemetryDecimation);
+    v(s.adaptiveFramerate);
+    v(s.idlePause);
+    v(s.parallelGeometry);
+    v(s.previewFidelity);
+    v(s.calibrateFidelity);
+    v(s.fidelityHeadroom);
+    v(s.cycleAudioCache);
+    v(s.impulseResponseMinimumPhase);
+    v(s.artifactCache);
+    v(s.artifactCacheSize);
+    v(s.controlSurfaceMidi);
+    v(s.controlSurfaceOscPort);
+    v(s.offloadConvolutionTail);
+    v(s.rigidBodyInterval);
+    v(s.recordInput);
+    v(s.replayInput);
+    v(s.renderVideo);
+    v(s.renderFrameRate);
+    v(s.renderDuration);
+    v(s.colorBackground);
+    v(s.colorForeground);
+    v(s.colorShadow);
+    v(s.colorHighlight1);
+    v(s.colorHighlight2);
+    v(s.colorPink);
+    v(s.colorRed);
+    v(s.colorOrange);
+    v(s.colorYellow);
+    v(s.colorBlue);
+    v(s.colorGreen);
+}
+
+class SettingsWriter {
+    public:
+        explicit SettingsWriter(std::vector<char> *data) : m_data(data) { /* void */ }
+
+        void operator()(bool value) { append<uint8_t>(value ? 1 : 0); }
+        void operator()(int value) { append<int32_t>(value); }
+        void operator()(double value) { append<double>(value); }
+        void operator()(const std::string &value) {
+            append<uint32_t>(static_cast<uint32_t>(value.size()));
+            m_data->insert(m_data->end(), value.begin(), value.end());
+        }
+
+    private:
+        template <typename T>
+        void append(T value) {
+            const char *bytes = reinterpret_cast<const char *>(&value);
+            m_data->insert(m_data->end(), bytes, bytes + sizeof(T));
+        }
+
+        std::vector<char> *m_data;
+};
+
+// Any overrun latches the failure flag and leaves the remaining fields alone
+class SettingsReader {
+    public:
+        SettingsReader(const char *data, size_t size) {
+            m_data = data;
+            m_size = size;
+            m_offset = 0;
+            m_failed = false;
+        }
+
+        void operator()(bool &value) { value = take<uint8_t>() != 0; }
+        void operator()(int &value) { value = take<int32_t>(); }
+        void operator()(double &value) { value = take<double>(); }
+        void operator()(std::string &value) {
+            const uint32_t length = take<uint32_t>();
+            if (m_failed || m_size - m_offset < length) {
+                m_failed = true;
+                return;
+            }
+
+            value.assign(m_data + m_offset, length);
+            m_offset += length;
+        }
+
+        bool failed() const { return m_failed; }
+        size_t getOffset() const { return m_offset; }
+
+    private:
+        template <typename T>
+        T take() {
+            T value{};
+            if (m_failed || m_size - m_offset < sizeof(T)) {
+                m_failed = true;
+                return value;
+            }
+
+            std::memcpy(&value, m_data + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+            return value;
+        }
+
+        const char *m_data;
+        size_t m_size;
+        size_t m_offset;
+        bool m_failed;
+};
+
+void configureArtifactCache(const ApplicationSettings &settings) {
+    ArtifactCache::Shared().configure(
+        settings.artifactCache,
+        static_cast<uint64_t>(std::max(settings.artifactCacheSize, 0)) * 1024 * 1024);
+}
+
+} /* namespace */
+
+EngineLoader::EngineLoader() {
+    m_thread = nullptr;
+    m_run = false;
+    m_pending = false;
+    m_loading = false;
+    m_ready = false;
+}
+
+EngineLoader::~EngineLoader() {
+    assert(m_thread == nullptr);
+}
+
+void EngineLoader::initialize() {
+    m_run = true;
+    m_thread = new std::thread(&EngineLoader::worker, this);
+}
+
+void EngineLoader::destroy() {
+    if (m_thread != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_run = false;
+        }
+
+        m_cv.notify_all();
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_ready) {
+        Release(&m_result);
+        m_ready = false;
+    }
+
+    for (Result &result : m_retired) {
+        Release(&result);
+    }
+
+    m_retired.clear();
+    m_pending = false;
+}
+
+void EngineLoader::request(const Request &request) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_request = request;
+        m_pending = true;
+    }
+
+    m_cv.notify_all();
+}
+
+bool EngineLoader::isLoading() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_pending || m_loading;
+}
+
+bool EngineLoader::takeResult(Result *result) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_ready) return false;
+
+    *result = m_result;
+    m_result = Result();
+    m_ready = false;
+
+    return true;
+}
+
+bool EngineLoader::waitForResult(Result *result) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_cv.wait(lock, [this] { return m_ready || (!m_pending && !m_loading); });
+    if (!m_ready) return false;
+
+    *result = m_result;
+    m_result = Result();
+    m_ready = false;
+
+    return true;
+}
+
+void EngineLoader::retire(const Result &result) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_retired.push_back(result);
+    }
+
+    m_cv.notify_all();
+}
+
+EngineLoader::Result EngineLoader::Load(const Request &request) {
+    ATG_ENGINE_SIM_ALLOCATION_SCOPE(Scripting);
+
+    Result result;
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    for (const std::string &path : es_script::ScriptSources::SearchPaths(request.assetPath)) {
+        result.sources.addSearchPath(path);
+    }
+
+    const bool collected = result.sources.collect(request.scriptPath);
+    ATG_ENGINE_SIM_TRACE(
+        Script, Event,
+        "script_sources files=%d hash=%016llx",
+        static_cast<int>(result.sources.getFiles().size()),
+        static_cast<unsigned long long>(result.sources.getHash()));
+
+    // Saving a file without changing it doesn't count
+    if (collected && request.unchangedSourcesHash != 0
+        && result.sources.getHash() == request.unchangedSourcesHash)
+    {
+        result.unchanged = true;
+        return result;
+    }
+
+    const ArtifactCache::Key compiledKey = CompiledScriptKey(result.sources.getHash());
+    if (collected) {
+        ArtifactCache::Artifact artifact;
+        if (ArtifactCache::Shared().load(compiledKey, &artifact)) {
+            ReadCompiledScript(artifact.getData(), artifact.getSize(), &result);
+            artifact.close();
+        }
+
+        ATG_ENGINE_SIM_TRACE(
+            Script, Event,
+            "compiled_script_cache hit=%d hash=%016llx",
+            result.cached ? 1 : 0,
+            static_cast<unsigned long long>(compiledKey.getHash()));
+    }
+
+    if (!result.cached) {
+        es_script::Compiler compiler;
+        const auto compileStart = std::chrono::steady_clock::now();
+        const int64_t compileBegin = StartupTimeline::Now();
+        ATG_ENGINE_SIM_TRACE(Script, Event, "script_vm_call entry=compiler.initialize");
+        compiler.initialize();
+        const std::string assetScriptLibraryPath = (std::filesystem::path(request.assetPath) / "es").string();
+        compiler.addSearchPath(assetScriptLibraryPath.c_str());
+        ATG_ENGINE_SIM_TRACE(Script, Event, "added script search path=%s", assetScriptLibraryPath.c_str());
+        ATG_ENGINE_SIM_TRACE(Script, Event, "active script path=%s", request.scriptPath.c_str());
+        ATG_ENGINE_SIM_TRACE(Script, Event, "script_vm_call entry=compiler.compile");
+        const bool compiled = compiler.compile(request.scriptPath.c_str());
+        ATG_ENGINE_SIM_TRACE(Script, Event, "script_vm_call exit=compiler.compile success=%d", compiled ? 1 : 0);
+        ATG_ENGINE_SIM_TRACE(
+            Script, Event,
+            "asset_io_latency operation=load_script path=%s elapsed_ms=%.3f",
+            request.scriptPath.c_str(),
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - compileStart).count() / 1000.0);
+        if (compiled) {
+            ATG_ENGINE_SIM_TRACE(Script, Event, "script_vm_call entry=compiler.execute");
+            const es_script::Compiler::Output output = compiler.execute();
+            ATG_ENGINE_SIM_TRACE(Script, Event, "script_vm_call exit=compiler.execute");
+
+            result.engine = output.engine;
+            result.vehicle = output.vehicle;
+            result.transmission = output.transmission;
+            result.settings = output.applicationSettings;
+            result.configured = true;
+        }
+
+        ATG_ENGINE_SIM_TRACE(Script, Event, "script_vm_call entry=compiler.destroy");
+        compiler.destroy();
+        ATG_ENGINE_SIM_TRACE(Script, Event, "script_vm_call exit=compiler.destroy");
+        StartupTimeline::Record("compile_script", compileBegin, StartupTimeline::Now());
+        ATG_ENGINE_SIM_TRACE(
+            Script, Verbose,
+            "subsystem_duration script_compile_execute_us=%lld",
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - compileStart).count()));
+
+        // Stored before anything is simulated, under the cache the script's
+        // own settings name
+        std::vector<char> compiledScript;
+        if (collected && result.engine != nullptr && WriteCompiledScript(result, &compiledScript)) {
+            configureArtifactCache(result.settings);
+            ArtifactCache::Shared().store(compiledKey, compiledScript.data(), compiledScript.size());
+        }
+    }
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+    if (result.engine == nullptr) {
+        Release(&result);
+        return result;
+    }
+
+    if (result.vehicle == nullptr) {
+        Vehicle::Parameters vehParams;
+        vehParams.mass = units::mass(1597, units::kg);
+        vehParams.diffRatio = 3.42;
+        vehParams.tireRadius = units::distance(10, units::inch);
+        vehParams.dragCoefficient = 0.25;
+        vehParams.crossSectionArea = units::distance(6.0, units::foot) * units::distance(6.0, units::foot);
+        vehParams.rollingResistance = 2000.0;
+        result.vehicle = new Vehicle;
+        result.vehicle->initialize(vehParams);
+    }
+
+    if (result.transmission == nullptr) {
+        const double gearRatios[] = { 2.97, 2.07, 1.43, 1.00, 0.84, 0.56 };
+        Transmission::Parameters tParams;
+        tParams.GearCount = 6;
+        tParams.GearRatios = gearRatios;
+        tParams.MaxClutchTorque = units::torque(1000.0, units::ft_lb);
+        result.transmission = new Transmission;
+        result.transmission->initialize(tParams);
+    }
+
+    uint64_t structureHash = 0;
+    if (request.patchable
+        && EngineSnapshot::hashStructure(result.engine, result.vehicle, result.transmission, &structureHash)
+        && structureHash == request.structureHash)
+    {
+        // Decoded here so the main thread only has to swap them in
+        std::vector<ImpulseResponse *> responses;
+        for (int i = 0; i < result.engine->getExhaustSystemCount(); ++i) {
+            responses.push_back(result.engine->getExhaustSystem(i)->getImpulseResponse());
+        }
+
+        ImpulseResponseCache::Load(
+            responses.data(),
+            static_cast<int>(responses.size()),
+            request.audioSampleRate,
+            &result.impulseResponses);
+
+        result.patch = true;
+        return result;
+    }
+
+    {
+        StartupTimeline::Scope scope("create_simulator");
+        ApplicationSettings settings = result.configured ? result.settings : request.settings;
+        settings.calibrateFidelity = settings.calibrateFidelity || request.calibrateFidelity;
+        result.simulator = CreateSimulator(
+            result.engine,
+            result.vehicle,
+            result.transmission,
+            settings,
+            request.audioSampleRate,
+            request.audioThread,
+            &result.calibration);
+
+        result.cost = CostEstimate::Estimate(
+            CostEstimate::Gather(result.simulator),
+            CostEstimate::Coefficients(),
+            settings.fidelityHeadroom);
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
+            "cost_estimate physics_thread=%.3f audio_thread=%.3f sustainable=%d %s",
+            result.cost.physicsThreadLoad,
+            result.cost.audioThreadLoad,
+            result.cost.sustainable ? 1 : 0,
+            CostEstimate::Describe(result.cost).c_str());
+    }
+
+    StartupTimeline::Scope warmupScope("warmup");
+    Simulator *simulator = result.simulator;
+    for (int i = 0; i < request.warmupFrames; ++i) {
+        simulator->startFrame(1 / 60.0);
+        while (simulator->simulateStep()) {
+            /* void */
+        }
+
+        simulator->endFrame();
+        if (!request.audioThread) simulator->synthesizer().renderPendingAudio();
+    }
+
+    float discarded[1024];
+    while (simulator->readAudioOutput(1024, discarded) > 0) {
+        /* void */
+    }
+
+    return result;
+}
+
+Simulator *EngineLoader::CreateSimulator(
+    Engine *engine,
+    Vehicle *vehicle,
+    Transmission *transmission,
+    const ApplicationSettings &settings,
+    double audioSampleRate,
+    bool audioThread,
+    FidelityCalibration::Result *calibration)
+{
+    Simulator *simulator = engine->createSimulator(vehicle, transmission);
+    simulator->setLatencyProfile(LatencyProfile::fromSettings(
+        settings.latencyProfile,
+        settings.audioLatency,
+        44100,
+        settings.reducedAudioMemory));
+    simulator->setAudioSampleRate(audioSampleRate);
+    simulator->synthesizer().setOutputDither(settings.audioDither);
+
+    engine->calculateDisplacement();
+    simulator->setSimulationFrequency(engine->getSimulationFrequency());
+    simulator->setRigidBodyInterval(settings.rigidBodyInterval);
+
+    Synthesizer::AudioParameters audioParams = simulator->synthesizer().getAudioParameters();
+    audioParams.inputSampleNoise = static_cast<float>(engine->getInitialJitter());
+    audioParams.airNoise = static_cast<float>(engine->getInitialNoise());
+    audioParams.dF_F_mix = static_cast<float>(engine->getInitialHighFrequencyGain());
+    simulator->synthesizer().setAudioParameters(audioParams);
+
+    ImpulseResponseProcessor::Parameters irParameters = ImpulseResponseCache::GetPreprocessing();
+    irParameters.minimumPhase = settings.impulseResponseMinimumPhase;
+    ImpulseResponseCache::SetPreprocessing(irParameters);
+    configureArtifactCache(settings);
+    simulator->synthesizer().setConvolutionTailOffload(settings.offloadConvolutionTail);
+    LoadImpulseResponses(simulator, engine);
+
+    // A calibrated frequency would differ from run to run
+    if (settings.calibrateFidelity && settings.recordInput.empty() && settings.replayInput.empty()) {
+        StartupTimeline::Scope scope("calibrate_fidelity");
+        FidelityCalibration::Settings calibrationSettings;
+        calibrationSettings.headroom = settings.fidelityHeadroom;
+
+        const FidelityCalibration::Result calibrated =
+            FidelityCalibration::Calibrate(simulator, calibrationSettings);
+        if (calibration != nullptr) *calibration = calibrated;
+    }
+
+    simulator->setAudioCacheEnabled(settings.cycleAudioCache);
+
+    // Read by the audio thread below and the physics thread the
+    // application starts once the engine is installed
+    ThreadPolicy::Settings threadSettings;
+    threadSettings.realtimeAudio = settings.realtimeAudio;
+    threadSettings.realtimePhysics = settings.realtimePhysics;
+    threadSettings.audioCore = settings.audioCore;
+    threadSettings.physicsCore = settings.physicsCore;
+    ThreadPolicy::SetSettings(threadSettings);
+
+    if (audioThread) simulator->startAudioRenderingThread();
+
+    return simulator;
+}
+
+void EngineLoader::LoadImpulseResponses(Simulator *simulator, Engine *engine) {
+    StartupTimeline::Scope scope("load_impulse_responses");
+
+    // Decoded in parallel and shared through the cache, so hot reloads and
+    // exhausts using the same response don't decode or transform it again
+    std::vector<ImpulseResponse *> responses;
+    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+        responses.push_back(engine->getExhaustSystem(i)->getImpulseResponse());
+    }
+
+    std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> kernels;
+    ImpulseResponseCache::Load(
+        responses.data(),
+        static_cast<int>(responses.size()),
+        simulator->getAudioSampleRate(),
+        &kernels);
+    for (int i = 0; i < static_cast<int>(kernels.size()); ++i) {
+        if (kernels[i] != nullptr) {
+            simulator->synthesizer().initializeImpulseResponse(kernels[i]->filter, i);
+        }
+        else {
+            simulator->synthesizer().initializeImpulseResponse(nullptr, 0, 0.0f, i);
+        }
+    }
+}
+
+void EngineLoader::Release(Result *result) {
+    if (result->simulator != nullptr) {
+        result->simulator->releaseSimulation();
+        delete result->simulator;
+    }
+
+    delete result->vehicle;
+    delete result->transmission;
+
+    if (result->engine != nullptr) {
+        if (result->cached) EngineSnapshot::releaseTables(result->engine);
+        result->engine->destroy();
+        delete result->engine;
+    }
+
+    result->simulator = nullptr;
+    result->vehicle = nullptr;
+    result->transmission = nullptr;
+    result->engine = nullptr;
+    result->impulseResponses.clear();
+}
+
+ArtifactCache::Key EngineLoader::CompiledScriptKey(uint64_t sourcesHash) {
+    // The settings' size stands in for their layout, so a build that adds
+    // a field misses rather than misreads
+    ArtifactCache::Key key(ArtifactCache::Kind::CompiledScript);
+    key
+        .add(static_cast<int64_t>(sourcesHash))
+        .add(static_cast<int64_t>(EngineSnapshot::Version))
+        .add(static_cast<int64_t>(sizeof(ApplicationSettings)));
+
+    return key;
+}
+
+bool EngineLoader::WriteCompiledScript(const Result &result, std::vector<char> *data) {
+    std::vector<char> snapshot;
+    if (!EngineSnapshot::write(&snapshot, result.engine, result.vehicle, result.transmission)) {
+        return false;
+    }
+
+    data->clear();
+    ApplicationSettings settings = result.settings;
+    SettingsWriter writer(data);
+    visitSettings(settings, writer);
+    data->insert(data->end(), snapshot.begin(), snapshot.end());
+
+    return true;
+}
+
+bool EngineLoader::ReadCompiledScript(const char *data, size_t size, Result *result) {
+    ApplicationSettings settings;
+    SettingsReader reader(data, size);
+    visitSettings(settings, reader);
+    if (reader.failed()) return false;
+
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+    const size_t offset = reader.getOffset();
+    if (!EngineSnapshot::read(data + offset, size - offset, &engine, &vehicle, &transmission)) {
+        return false;
+    }
+
+    result->engine = engine;
+    result->vehicle = vehicle;
+    result->transmission = transmission;
+    result->settings = settings;
+    result->configured = true;
+    result->cached = true;
+
+    return true;
+}
+
+void EngineLoader::worker() {
+    StepProfiler::SetThreadName("engine_loader");
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (true) {
+        m_cv.wait(lock, [this] { return !m_run || m_pending || !m_retired.empty(); });
+        if (!m_run) break;
+
+        std::vector<Result> retired;
+        retired.swap(m_retired);
+
+        const bool pending = m_pending;
+        Request request;
+        if (pending) {
+            request = m_request;
+            m_pending = false;
+            m_loading = true;
+        }
+
+        lock.unlock();
+
+        for (Result &result : retired) {
+            Release(&result);
+        }
+
+        if (pending) {
+            Result result = Load(request);
+
+            lock.lock();
+            Result stale = m_ready ? m_result : Result();
+            m_result = result;
+            m_ready = true;
+            m_loading = false;
+            lock.unlock();
+            m_cv.notify_all();
+
+            // Superseded before the main loop picked it up
+            Release(&stale);
+        }
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,114 @@
+#include "../include/engine_patch.h"
+
+#include "../include/engine.h"
+#include "../include/engine_snapshot.h"
+#include "../include/function.h"
+#include "../include/impulse_response_cache.h"
+#include "../include/simulator.h"
+
+#include <memory>
+#include <vector>
+
+bool EnginePatch::Apply(
+    Simulator *simulator,
+    Engine *source,
+    Vehicle *vehicle,
+    Transmission *transmission,
+    const std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> &impulseResponses,
+    Statistics *statistics)
+{
+    *statistics = Statistics();
+
+    Engine *target = simulator->getEngine();
+    if (target == nullptr || source == nullptr) return false;
+
+    uint64_t targetHash = 0, sourceHash = 0;
+    if (!EngineSnapshot::hashStructure(
+            target, simulator->getVehicle(), simulator->getTransmission(), &targetHash)) return false;
+    if (!EngineSnapshot::hashStructure(source, vehicle, transmission, &sourceHash)) return false;
+    if (targetHash != sourceHash) return false;
+
+    std::vector<Function *> targetFunctions, sourceFunctions;
+    EngineSnapshot::collectFunctions(target, &targetFunctions);
+    EngineSnapshot::collectFunctions(source, &sourceFunctions);
+    if (targetFunctions.size() != sourceFunctions.size()) return false;
+
+    std::vector<ImpulseResponse *> targetResponses, sourceResponses;
+    EngineSnapshot::collectImpulseResponses(target, &targetResponses);
+    EngineSnapshot::collectImpulseResponses(source, &sourceResponses);
+    if (targetResponses.size() != sourceResponses.size()) return false;
+    if (static_cast<int>(impulseResponses.size()) != source->getExhaustSystemCount()) return false;
+
+    // Sharing is part of the structure, so the tables pair up one to one
+    for (size_t i = 0; i < targetFunctions.size(); ++i) {
+        if (!targetFunctions[i]->matches(*sourceFunctions[i])) {
+            targetFunctions[i]->assign(*sourceFunctions[i]);
+            ++statistics->functions;
+        }
+    }
+
+    IgnitionModule *targetIgnition = target->getIgnitionModule();
+    IgnitionModule *sourceIgnition = source->getIgnitionModule();
+    if (!targetIgnition->getTimingMap()->matches(*sourceIgnition->getTimingMap())) {
+        targetIgnition->getTimingMap()->assign(*sourceIgnition->getTimingMap());
+        statistics->ignition = true;
+    }
+
+    for (int i = 0; i < target->getCylinderCount(); ++i) {
+        if (targetIgnition->getCylinderTrim(i) != sourceIgnition->getCylinderTrim(i)) {
+            targetIgnition->setCylinderTrim(i, sourceIgnition->getCylinderTrim(i));
+            statistics->ignition = true;
+        }
+    }
+
+    for (size_t i = 0; i < targetResponses.size(); ++i) {
+        ImpulseResponse *response = targetResponses[i];
+        if (response->getFilename() != sourceResponses[i]->getFilename()
+            || response->getVolume() != sourceResponses[i]->getVolume())
+        {
+            response->initialize(sourceResponses[i]->getFilename(), sourceResponses[i]->getVolume());
+            ++statistics->impulseResponses;
+        }
+    }
+
+    bool reloadKernels = statistics->impulseResponses > 0;
+    for (int i = 0; i < target->getExhaustSystemCount(); ++i) {
+        ExhaustSystem *exhaust = target->getExhaustSystem(i);
+        const double audioVolume = source->getExhaustSystem(i)->m_audioVolume;
+        if (exhaust->m_audioVolume != audioVolume) {
+            exhaust->m_audioVolume = audioVolume;
+            statistics->audio = true;
+        }
+    }
+
+    if (target->m_initialHighFrequencyGain != source->m_initialHighFrequencyGain
+        || target->m_initialNoise != source->m_initialNoise
+        || target->m_initialJitter != source->m_initialJitter)
+    {
+        target->m_initialHighFrequencyGain = source->m_initialHighFrequencyGain;
+        target->m_initialNoise = source->m_initialNoise;
+        target->m_initialJitter = source->m_initialJitter;
+
+        Synthesizer::AudioParameters audioParams = simulator->synthesizer().getAudioParameters();
+        audioParams.inputSampleNoise = static_cast<float>(target->getInitialJitter());
+        audioParams.airNoise = static_cast<float>(target->getInitialNoise());
+        audioParams.dF_F_mix = static_cast<float>(target->getInitialHighFrequencyGain());
+        simulator->synthesizer().setAudioParameters(audioParams);
+        statistics->audio = true;
+    }
+
+    if (reloadKernels) {
+        // Each kernel keeps its filter alive until the audio thread has
+        // taken it
+        std::vector<std::shared_ptr<const ConvolutionFilter>> filters;
+        for (const std::shared_ptr<const ImpulseResponseCache::Kernel> &kernel : impulseResponses) {
+            filters.push_back(kernel != nullptr
+                ? std::shared_ptr<const ConvolutionFilter>(kernel, &kernel->filter)
+                : nullptr);
+        }
+
+        simulator->synthesizer().swapImpulseResponses(filters);
+    }
+
+    return true;
+}
@@ -0,0 +1,335 @@
+#include "../include/engine_sim_api.h"
+
+#include "../include/denormals.h"
+#include "../include/engine.h"
+#include "../include/engine_snapshot.h"
+#include "../include/impulse_response_cache.h"
+#include "../include/simulator.h"
+#include "../include/transmission.h"
+#include "../include/units.h"
+#include "../include/vehicle.h"
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/compiler.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct engine_sim_instance {
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+    Simulator *simulator = nullptr;
+
+    bool audio = false;
+    bool audioThread = false;
+    bool driveFromRender = false;
+
+    // Written by the setters from any thread, applied by the step
+    std::atomic<double> throttle{ 0.0 };
+    std::atomic<double> clutch{ 1.0 };
+    std::atomic<int> gear{ -1 };
+    std::atomic<bool> ignition{ true };
+    std::atomic<bool> starter{ false };
+    std::atomic<bool> dyno{ false };
+    std::atomic<double> dynoSpeed{ 0.0 };
+};
+
+namespace {
+bool loadScript(
+    const engine_sim_config &config,
+    engine_sim_instance *instance)
+{
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    es_script::Compiler compiler;
+    compiler.initialize();
+
+    const std::string assetPath = (config.asset_path != nullptr) ? config.asset_path : ".";
+    const std::string libraryPath = (std::filesystem::path(assetPath) / "es").string();
+    compiler.addSearchPath(libraryPath.c_str());
+
+    if (compiler.compile(config.script_path)) {
+        const es_script::Compiler::Output output = compiler.execute();
+        instance->engine = output.engine;
+        instance->vehicle = output.vehicle;
+        instance->transmission = output.transmission;
+    }
+
+    compiler.destroy();
+
+    return instance->engine != nullptr;
+#else
+    (void)config;
+    (void)instance;
+    return false;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+}
+
+void createDefaultDrivetrain(engine_sim_instance *instance) {
+    if (instance->vehicle == nullptr) {
+        Vehicle::Parameters vehParams;
+        vehParams.mass = units::mass(1597, units::kg);
+        vehParams.diffRatio = 3.42;
+        vehParams.tireRadius = units::distance(10, units::inch);
+        vehParams.dragCoefficient = 0.25;
+        vehParams.crossSectionArea = units::distance(6.0, units::foot) * units::distance(6.0, units::foot);
+        vehParams.rollingResistance = 2000.0;
+        instance->vehicle = new Vehicle;
+        instance->vehicle->initialize(vehParams);
+    }
+
+    if (instance->transmission == nullptr) {
+        const double gearRatios[] = { 2.97, 2.07, 1.43, 1.00, 0.84, 0.56 };
+        Transmission::Parameters tParams;
+        tParams.GearCount = 6;
+        tParams.GearRatios = gearRatios;
+        tParams.MaxClutchTorque = units::torque(1000.0, units::ft_lb);
+        instance->transmission = new Transmission;
+        instance->transmission->initialize(tParams);
+    }
+}
+
+void createSimulator(const engine_sim_config &config, engine_sim_instance *instance) {
+    Engine *engine = instance->engine;
+    Simulator *simulator = engine->createSimulator(
+            instance->vehicle,
+            instance->transmission,
+            false,
+            instance->audio);
+    simulator->setRandomSeed(config.seed);
+    engine->calculateDisplacement();
+    simulator->setSimulationFrequency(static_cast<int>(engine->getSimulationFrequency()));
+
+    // The render call is the clock, so every step follows it exactly rather
+    // than chasing the synthesizer latency
+    simulator->setOfflineMode(instance->driveFromRender);
+
+    if (instance->audio) {
+        Synthesizer::AudioParameters audioParams = simulator->synthesizer().getAudioParameters();
+        audioParams.inputSampleNoise = static_cast<float>(engine->getInitialJitter());
+        audioParams.airNoise = static_cast<float>(engine->getInitialNoise());
+        audioParams.dF_F_mix = static_cast<float>(engine->getInitialHighFrequencyGain());
+        simulator->synthesizer().setAudioParameters(audioParams);
+
+        std::vector<ImpulseResponse *> responses;
+        for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+            responses.push_back(engine->getExhaustSystem(i)->getImpulseResponse());
+        }
+
+        std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> kernels;
+        ImpulseResponseCache::Load(
+            responses.data(),
+            static_cast<int>(responses.size()),
+            simulator->getAudioSampleRate(),
+            &kernels);
+        for (int i = 0; i < static_cast<int>(kernels.size()); ++i) {
+            if (kernels[i] != nullptr) {
+                simulator->synthesizer().initializeImpulseResponse(kernels[i]->filter, i);
+            }
+        }
+
+        if (instance->audioThread) {
+            simulator->startAudioRenderingThread();
+        }
+    }
+
+    instance->simulator = simulator;
+}
+
+void applyControls(engine_sim_instance *instance) {
+    Engine *engine = instance->engine;
+    Simulator *simulator = instance->simulator;
+
+    engine->setSpeedControl(std::clamp(instance->throttle.load(std::memory_order_relaxed), 0.0, 1.0));
+    engine->getIgnitionModule()->m_enabled = instance->ignition.load(std::memory_order_relaxed);
+
+    const bool dyno = instance->dyno.load(std::memory_order_relaxed);
+    simulator->m_starterMotor.m_enabled = instance->starter.load(std::memory_order_relaxed);
+    simulator->m_dyno.m_enabled = dyno;
+    simulator->m_dyno.m_hold = dyno;
+    simulator->m_dyno.m_rotationSpeed = std::clamp(
+        instance->dynoSpeed.load(std::memory_order_relaxed),
+        engine->getDynoMinSpeed(),
+        engine->getDynoMaxSpeed());
+
+    Transmission *transmission = simulator->getTransmission();
+    if (transmission != nullptr) {
+        const int gear = instance->gear.load(std::memory_order_relaxed);
+        if (transmission->getGear() != gear) {
+            transmission->changeGear(gear);
+        }
+
+        transmission->setClutchPressure(
+            std::clamp(instance->clutch.load(std::memory_order_relaxed), 0.0, 1.0));
+    }
+}
+} /* namespace */
+
+int engine_sim_api_version(void) {
+    return ENGINE_SIM_API_VERSION;
+}
+
+void engine_sim_default_config(engine_sim_config *config) {
+    if (config == nullptr) return;
+
+    std::memset(config, 0, sizeof(engine_sim_config));
+    config->asset_path = ".";
+    config->audio = 1;
+    config->seed = 1;
+}
+
+engine_sim_result engine_sim_create(
+    const engine_sim_config *config,
+    engine_sim_instance **instance)
+{
+    if (instance == nullptr) return ENGINE_SIM_ERROR_ARGUMENT;
+    *instance = nullptr;
+
+    if (config == nullptr) return ENGINE_SIM_ERROR_ARGUMENT;
+
+    const bool script = config->script_path != nullptr && config->script_path[0] != '\0';
+    const bool snapshot = config->snapshot_path != nullptr && config->snapshot_path[0] != '\0';
+    if (script == snapshot) return ENGINE_SIM_ERROR_ARGUMENT;
+
+#ifndef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    if (script) return ENGINE_SIM_ERROR_NO_SCRIPTING;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+    engine_sim_instance *created = new engine_sim_instance;
+    created->audio = config->audio != 0;
+    created->audioThread = created->audio && config->audio_thread != 0;
+    created->driveFromRender = config->drive_from_render != 0;
+
+    const bool loaded = script
+        ? loadScript(*config, created)
+        : EngineSnapshot::read(
+            config->snapshot_path,
+            &created->engine,
+            &created->vehicle,
+            &created->transmission);
+    if (!loaded || created->engine == nullptr) {
+        engine_sim_destroy(created);
+        return ENGINE_SIM_ERROR_LOAD;
+    }
+
+    createDefaultDrivetrain(created);
+    createSimulator(*config, created);
+
+    *instance = created;
+    return ENGINE_SIM_OK;
+}
+
+void engine_sim_destroy(engine_sim_instance *instance) {
+    if (instance == nullptr) return;
+
+    if (instance->simulator != nullptr) {
+        instance->simulator->releaseSimulation();
+        delete instance->simulator;
+    }
+
+    delete instance->vehicle;
+    delete instance->transmission;
+
+    if (instance->engine != nullptr) {
+        instance->engine->destroy();
+        delete instance->engine;
+    }
+
+    delete instance;
+}
+
+void engine_sim_set_throttle(engine_sim_instance *instance, double throttle) {
+    instance->throttle.store(throttle, std::memory_order_relaxed);
+}
+
+void engine_sim_set_clutch(engine_sim_instance *instance, double clutch) {
+    instance->clutch.store(clutch, std::memory_order_relaxed);
+}
+
+void engine_sim_set_gear(engine_sim_instance *instance, int gear) {
+    instance->gear.store(gear, std::memory_order_relaxed);
+}
+
+void engine_sim_set_ignition(engine_sim_instance *instance, int enabled) {
+    instance->ignition.store(enabled != 0, std::memory_order_relaxed);
+}
+
+void engine_sim_set_starter(engine_sim_instance *instance, int enabled) {
+    instance->starter.store(enabled != 0, std::memory_order_relaxed);
+}
+
+void engine_sim_set_dyno(engine_sim_instance *instance, int enabled, double rpm) {
+    instance->dynoSpeed.store(units::rpm(rpm), std::memory_order_relaxed);
+    instance->dyno.store(enabled != 0, std::memory_order_relaxed);
+}
+
+void engine_sim_step(engine_sim_instance *instance, double dt) {
+    if (dt <= 0) return;
+
+    applyControls(instance);
+
+    DenormalScope denormals;
+    Simulator *simulator = instance->simulator;
+    simulator->startFrame(dt);
+    while (simulator->simulateStep()) { /* void */ }
+    simulator->endFrame();
+}
+
+int engine_sim_render(engine_sim_instance *instance, float *out, int frames) {
+    if (out == nullptr || frames <= 0) return 0;
+
+    int written = 0;
+    int filled = 0;
+    if (instance->audio) {
+        Synthesizer &synthesizer = instance->simulator->synthesizer();
+        const double sampleRate = synthesizer.getAudioSampleRate();
+
+        // Step rounding can leave a frame short, so top up a few times
+        // before giving up and padding with silence
+        for (int attempt = 0; attempt < 4 && written < frames; ++attempt) {
+            if (!instance->audioThread) synthesizer.renderPendingAudio();
+            written += synthesizer.readAudioOutput(frames - written, out + written);
+
+            if (written >= frames || !instance->driveFromRender) break;
+            engine_sim_step(instance, (frames - written) / sampleRate);
+        }
+
+        // Silence only once there's no engine cycle to carry on with
+        filled = written;
+        if (filled < frames) {
+            filled += synthesizer.concealOutput(frames - filled, out + filled);
+        }
+    }
+
+    std::fill(out + filled, out + frames, 0.0f);
+
+    return written;
+}
+
+int engine_sim_get_sample_rate(const engine_sim_instance *instance) {
+    return static_cast<int>(instance->simulator->synthesizer().getAudioSampleRate());
+}
+
+void engine_sim_get_telemetry(
+    engine_sim_instance *instance,
+    engine_sim_telemetry *telemetry)
+{
+    instance->simulator->updateSnapshot();
+    const SimulationSnapshot &snapshot = instance->simulator->getSnapshot();
+
+    telemetry->time = snapshot.time;
+    telemetry->rpm = snapshot.rpm;
+    telemetry->redline = snapshot.redline;
+    telemetry->manifold_pressure_pa = snapshot.manifoldPressure;
+    telemetry->dyno_torque_nm = snapshot.filteredDynoTorque;
+    telemetry->dyno_power_w = snapshot.dynoPower;
+    telemetry->speed_mps = snapshot.speed;
+    telemetry->gear = snapshot.gear;
+    telemetry->clutch = snapshot.clutchPressure;
+}
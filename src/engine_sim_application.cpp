@@ -14,6 +14,16 @@
 #include "../include/feedback_comb_filter.h"
 #include "../include/utilities.h"
 #include "../include/debug_trace.h"
+#include "../include/denormals.h"
+#include "../include/allocation_tracker.h"
+#include "../include/engine_patch.h"
+#include "../include/engine_snapshot.h"
+#include "../include/event_counters.h"
+#include "../include/startup_timeline.h"
+#include "../include/step_profiler.h"
+#include "../include/thread_policy.h"
+#include "../include/job_system.h"
+#include "../include/piston_engine_simulator.h"
 
 #include "../scripting/include/compiler.h"
 
@@ -27,10 +37,13 @@
 #include <cmath>
 #include <cstdint>
 #include <filesystem>
+#include <thread>
 
 #if defined(__APPLE__)
+#include <CoreAudio/CoreAudio.h>
 #include <mach/mach.h>
 #include <os/log.h>
+#include <os/workgroup.h>
 #endif
 
 #if ATG_ENGINE_SIM_DISCORD_ENABLED && defined(_WIN32)
@@ -118,6 +131,9 @@ const char *ysErrorName(ysError error) {
     }
 }
 
+// A few seconds of spans at the step rates engines usually run at
+constexpr int ProfileCaptureSpans = 1 << 20;
+
 void startupLog(const char *format, ...) {
     char buffer[1024];
     va_list args;
@@ -132,6 +148,61 @@ void startupLog(const char *format, ...) {
     os_log_with_type(OS_LOG_DEFAULT, OS_LOG_TYPE_DEFAULT, "engine-sim %{public}s", buffer);
 #endif
 }
+
+#if defined(__APPLE__)
+// Retained; null before macOS 11 or when the device doesn't publish one
+void *defaultOutputWorkgroup() {
+    AudioObjectPropertyAddress address = {
+        kAudioHardwarePropertyDefaultOutputDevice,
+        kAudioObjectPropertyScopeGlobal,
+        0
+    };
+
+    AudioDeviceID device = kAudioObjectUnknown;
+    UInt32 size = sizeof(device);
+    if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &device) != noErr) {
+        return nullptr;
+    }
+
+    if (__builtin_available(macOS 11.0, *)) {
+        os_workgroup_t workgroup = nullptr;
+        address.mSelector = kAudioDevicePropertyIOThreadOSWorkgroup;
+        size = sizeof(workgroup);
+        if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &workgroup) == noErr) {
+            return workgroup;
+        }
+    }
+
+    return nullptr;
+}
+#endif
+
+// Nominal rate of the default output device, so the synthesizer can render
+// at it instead of having the OS resample
+int defaultOutputSampleRate() {
+#if defined(__APPLE__)
+    AudioObjectPropertyAddress address = {
+        kAudioHardwarePropertyDefaultOutputDevice,
+        kAudioObjectPropertyScopeGlobal,
+        0
+    };
+
+    AudioDeviceID device = kAudioObjectUnknown;
+    UInt32 size = sizeof(device);
+    if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &device) == noErr) {
+        Float64 sampleRate = 0;
+        address.mSelector = kAudioDevicePropertyNominalSampleRate;
+        size = sizeof(sampleRate);
+        if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &sampleRate) == noErr
+            && sampleRate > 0)
+        {
+            return static_cast<int>(std::lround(sampleRate));
+        }
+    }
+#endif
+
+    return 44100;
+}
 } /* namespace */
 
 std::string EngineSimApplication::s_buildVersion = "0.1.12a";
@@ -140,9 +211,16 @@ EngineSimApplication::EngineSimApplication() {
     m_assetPath = "";
 
     m_geometryVertexBuffer = nullptr;
+    m_staticGeometryValid = false;
+    m_staticGeometryScale = 0.0f;
+    m_staticGeometryPixel = 0.0f;
     m_geometryIndexBuffer = nullptr;
+    m_geometryVertexCapacity = 0;
+    m_geometryIndexCapacity = 0;
 
     m_paused = false;
+    m_autoPaused = false;
+    m_audioStopPending = false;
     m_recording = false;
     m_screenResolutionIndex = 0;
     for (int i = 0; i < ScreenResolutionHistoryLength; ++i) {
@@ -164,6 +242,13 @@ EngineSimApplication::EngineSimApplication() {
     m_displayHeight = (float)units::distance(2.0, units::foot);
     m_outputAudioBuffer = nullptr;
     m_audioSource = nullptr;
+    m_audioSampleRate = 44100;
+    m_audioWorkgroup = nullptr;
+    m_telemetryExportDecimation = 0;
+    m_controlSurfaceOscPort = -1;
+    m_inputSessionStarted = false;
+    m_offlineRender = false;
+    m_offlineRenderFrames = 0;
 
     m_torque = 0;
     m_dynoSpeed = 0;
@@ -174,6 +259,8 @@ EngineSimApplication::EngineSimApplication() {
     m_temperatureGauge = nullptr;
     m_oscCluster = nullptr;
     m_performanceCluster = nullptr;
+    m_performanceHud = nullptr;
+    m_showPerformanceHud = false;
     m_loadSimulationCluster = nullptr;
     m_mixerCluster = nullptr;
     m_infoCluster = nullptr;
@@ -184,10 +271,20 @@ EngineSimApplication::EngineSimApplication() {
     m_transmission = nullptr;
 
     m_oscillatorSampleOffset = 0;
+    m_audioOutput = nullptr;
+    m_retiringAudioOutput = nullptr;
+    m_crossfadePosition = 0;
+    m_hasPreloaded = false;
+    m_catalogSelection = -1;
+    m_lookaheadBranchCount = 0;
+    m_lookaheadBranchStale = false;
     m_gameWindowHeight = 256;
     m_screenWidth = 256;
     m_screenHeight = 256;
     m_screen = 0;
+    m_layoutScreen = -1;
+    m_layoutWidth = 0;
+    m_layoutHeight = 0;
     m_viewParameters.Layer0 = 0;
     m_viewParameters.Layer1 = 0;
 
@@ -199,7 +296,8 @@ EngineSimApplication::~EngineSimApplication() {
 }
 
 void EngineSimApplication::initialize(void *instance, ysContextObject::DeviceAPI api) {
-    DebugTrace::Log("app", "initialize(void*, api=%d) begin", static_cast<int>(api));
+    ATG_ENGINE_SIM_TRACE(App, Event, "initialize(void*, api=%d) begin", static_cast<int>(api));
+    const int64_t pathsBegin = StartupTimeline::Now();
 
     dbasic::Path modulePath = dbasic::GetModulePath();
     dbasic::Path confPath = modulePath.Append("delta.conf");
@@ -235,8 +333,8 @@ void EngineSimApplication::initialize(void *instance, ysContextObject::DeviceAPI
         if (hasBundledAssets && hasBundledEngine) {
             m_assetPath = bundledResources.string();
             enginePath = bundledEngine.string();
-            DebugTrace::Log(
-                "app",
+            ATG_ENGINE_SIM_TRACE(
+                App, Event,
                 "using bundled resources asset_path=%s engine_path=%s",
                 m_assetPath.c_str(),
                 enginePath.c_str());
@@ -267,8 +365,8 @@ void EngineSimApplication::initialize(void *instance, ysContextObject::DeviceAPI
     }
 
     m_engine.GetConsole()->SetDefaultFontDirectory(enginePath + "/fonts/");
-    DebugTrace::Log(
-        "app",
+    ATG_ENGINE_SIM_TRACE(
+        App, Event,
         "initialize() resolved paths engine=%s asset_root=%s",
         enginePath.c_str(),
         m_assetPath.c_str());
@@ -278,8 +376,41 @@ void EngineSimApplication::initialize(void *instance, ysContextObject::DeviceAPI
         enginePath.c_str(),
         m_assetPath.c_str());
     std::fflush(stderr);
+    StartupTimeline::Record("resolve_paths", pathsBegin, StartupTimeline::Now());
+
+#if defined(__APPLE__)
+    // Before the first script starts an audio thread
+    m_audioWorkgroup = defaultOutputWorkgroup();
+    ThreadPolicy::SetAudioWorkgroup(m_audioWorkgroup);
+#endif
+
+    m_audioSampleRate = defaultOutputSampleRate();
+    ATG_ENGINE_SIM_TRACE(Audio, Event, "audio_device sample_rate=%d", m_audioSampleRate);
+
+    m_scriptPath = m_assetPath + "/assets/main.mr";
+
+    // The first script is compiled, its impulse responses decoded and its
+    // audio thread started on the loader thread while the window, GPU
+    // resources, assets and audio device are set up here; loadScript()
+    // waits for it
+    m_engineLoader.initialize();
+    m_engineLoader.request(createLoadRequest());
+    m_branchLoader.initialize();
+    m_lookahead.initialize(&JobSystem::Shared(), SpeculativeLookahead::Parameters());
 
     const std::string shaderPath = enginePath + "/shaders/";
+#if defined(__APPLE__)
+    // Bundled by the engine-sim-metallib target
+    const std::filesystem::path shaderLibrary =
+        std::filesystem::path(modulePath.ToString()).parent_path()
+        / "Resources" / "engine_sim_shaders.metallib";
+    std::error_code shaderLibraryError;
+    ATG_ENGINE_SIM_TRACE(
+        App, Event,
+        "precompiled shader library %s path=%s",
+        std::filesystem::exists(shaderLibrary, shaderLibraryError) ? "found" : "missing",
+        shaderLibrary.string().c_str());
+#endif /* __APPLE__ */
     const std::string winTitle = "Engine Sim | AngeTheGreat | v" + s_buildVersion;
     dbasic::DeltaEngine::GameEngineSettings settings;
     settings.API = api;
@@ -311,13 +442,16 @@ void EngineSimApplication::initialize(void *instance, ysContextObject::DeviceAPI
         return err;
     };
 
+    const int64_t windowBegin = StartupTimeline::Now();
     const ysError createWindowError = createWindowWithApi(api);
+    StartupTimeline::Record("create_window", windowBegin, StartupTimeline::Now());
     if (createWindowError != ysError::None) {
-        DebugTrace::Log("app", "CreateGameWindow failed: code=%d", static_cast<int>(createWindowError));
+        ATG_ENGINE_SIM_TRACE(App, Event, "CreateGameWindow failed: code=%d", static_cast<int>(createWindowError));
         return;
     }
-    DebugTrace::Log("app", "CreateGameWindow succeeded");
+    ATG_ENGINE_SIM_TRACE(App, Event, "CreateGameWindow succeeded");
 
+    const int64_t gpuBegin = StartupTimeline::Now();
     m_engine.GetDevice()->CreateSubRenderTarget(
         &m_mainRenderTarget,
         m_engine.GetScreenRenderTarget(),
@@ -340,37 +474,39 @@ void EngineSimApplication::initialize(void *instance, ysContextObject::DeviceAPI
 
     m_assetManager.SetEngine(&m_engine);
 
-    m_engine.GetDevice()->CreateIndexBuffer(
-        &m_geometryIndexBuffer, sizeof(unsigned short) * 200000, nullptr);
-    m_engine.GetDevice()->CreateVertexBuffer(
-        &m_geometryVertexBuffer, sizeof(dbasic::Vertex) * 100000, nullptr);
-
-    m_geometryGenerator.initialize(100000, 200000);
+    // Starts small; the arena and the buffers grow with the engine
+    m_geometryGenerator.initialize(
+        2 * GeometryGenerator::PageVertexCount, 2 * GeometryGenerator::PageIndexCount);
+    resizeGeometryBuffers();
+    m_partInstancer.initialize(this);
+    m_parallelGeometry.initialize(&JobSystem::Shared());
+    StartupTimeline::Record("gpu_resources", gpuBegin, StartupTimeline::Now());
 
     initialize();
-    DebugTrace::Log("app", "initialize(void*, api=%d) complete", static_cast<int>(api));
+    ATG_ENGINE_SIM_TRACE(App, Event, "initialize(void*, api=%d) complete", static_cast<int>(api));
 }
 
 void EngineSimApplication::initialize() {
-    DebugTrace::Log("app", "initialize() begin; asset_root=%s", m_assetPath.c_str());
+    ATG_ENGINE_SIM_TRACE(App, Event, "initialize() begin; asset_root=%s", m_assetPath.c_str());
     m_shaders.SetClearColor(ysColor::srgbiToLinear(0x34, 0x98, 0xdb));
     const std::string assetsDir = m_assetPath + "/assets";
     const std::string assetsBase = assetsDir + "/assets";
+    const int64_t assetsBegin = StartupTimeline::Now();
     if (dbasic::Path(assetsDir).Exists()) {
         const std::string sceneFile = assetsBase + ".ysce";
         if (dbasic::Path(sceneFile).Exists()) {
             const auto ioStart = std::chrono::steady_clock::now();
             ysError loadErr = m_assetManager.LoadSceneFile(assetsBase.c_str(), true);
             const auto ioEnd = std::chrono::steady_clock::now();
-            DebugTrace::Log(
-                "assets",
+            ATG_ENGINE_SIM_TRACE(
+                Assets, Event,
                 "asset_io_latency operation=LoadSceneFile path=%s elapsed_ms=%.3f",
                 sceneFile.c_str(),
                 std::chrono::duration_cast<std::chrono::microseconds>(ioEnd - ioStart).count() / 1000.0);
             if (loadErr != ysError::None) {
                 std::fprintf(stderr, "[engine-sim] LoadSceneFile failed: %d\n", (int)loadErr);
                 std::fflush(stderr);
-                DebugTrace::Log("assets", "LoadSceneFile failed: code=%d", static_cast<int>(loadErr));
+                ATG_ENGINE_SIM_TRACE(Assets, Event, "LoadSceneFile failed: code=%d", static_cast<int>(loadErr));
                 return;
             }
             const int textures = m_assetManager.GetTextureCount();
@@ -383,8 +519,8 @@ void EngineSimApplication::initialize() {
             const int hit = (s_lastAssetTotal == currentTotal) ? currentTotal : 0;
             const int miss = (s_lastAssetTotal >= 0) ? std::abs(currentTotal - s_lastAssetTotal) : currentTotal;
             s_lastAssetTotal = currentTotal;
-            DebugTrace::Log(
-                "assets",
+            ATG_ENGINE_SIM_TRACE(
+                Assets, Event,
                 "asset summary textures=%d audio=%d materials=%d scene_objects=%d actions=%d cache_hit=%d cache_miss=%d",
                 textures,
                 audioAssets,
@@ -398,29 +534,29 @@ void EngineSimApplication::initialize() {
             const auto compileIoStart = std::chrono::steady_clock::now();
             ysError compileErr = m_assetManager.CompileInterchangeFile(assetsBase.c_str(), 1.0f, true);
             const auto compileIoEnd = std::chrono::steady_clock::now();
-            DebugTrace::Log(
-                "assets",
+            ATG_ENGINE_SIM_TRACE(
+                Assets, Event,
                 "asset_io_latency operation=CompileInterchangeFile path=%s elapsed_ms=%.3f",
                 assetsBase.c_str(),
                 std::chrono::duration_cast<std::chrono::microseconds>(compileIoEnd - compileIoStart).count() / 1000.0);
             if (compileErr != ysError::None) {
                 std::fprintf(stderr, "[engine-sim] CompileInterchangeFile failed: %d\n", (int)compileErr);
                 std::fflush(stderr);
-                DebugTrace::Log("assets", "CompileInterchangeFile failed: code=%d", static_cast<int>(compileErr));
+                ATG_ENGINE_SIM_TRACE(Assets, Event, "CompileInterchangeFile failed: code=%d", static_cast<int>(compileErr));
                 return;
             }
             const auto loadIoStart = std::chrono::steady_clock::now();
             ysError loadErr = m_assetManager.LoadSceneFile(assetsBase.c_str(), true);
             const auto loadIoEnd = std::chrono::steady_clock::now();
-            DebugTrace::Log(
-                "assets",
+            ATG_ENGINE_SIM_TRACE(
+                Assets, Event,
                 "asset_io_latency operation=LoadSceneFile path=%s elapsed_ms=%.3f",
                 assetsBase.c_str(),
                 std::chrono::duration_cast<std::chrono::microseconds>(loadIoEnd - loadIoStart).count() / 1000.0);
             if (loadErr != ysError::None) {
                 std::fprintf(stderr, "[engine-sim] LoadSceneFile failed: %d\n", (int)loadErr);
                 std::fflush(stderr);
-                DebugTrace::Log("assets", "LoadSceneFile after compile failed: code=%d", static_cast<int>(loadErr));
+                ATG_ENGINE_SIM_TRACE(Assets, Event, "LoadSceneFile after compile failed: code=%d", static_cast<int>(loadErr));
                 return;
             }
             const int textures = m_assetManager.GetTextureCount();
@@ -433,8 +569,8 @@ void EngineSimApplication::initialize() {
             const int hit = (s_lastAssetTotal == currentTotal) ? currentTotal : 0;
             const int miss = (s_lastAssetTotal >= 0) ? std::abs(currentTotal - s_lastAssetTotal) : currentTotal;
             s_lastAssetTotal = currentTotal;
-            DebugTrace::Log(
-                "assets",
+            ATG_ENGINE_SIM_TRACE(
+                Assets, Event,
                 "asset summary textures=%d audio=%d materials=%d scene_objects=%d actions=%d cache_hit=%d cache_miss=%d",
                 textures,
                 audioAssets,
@@ -448,34 +584,33 @@ void EngineSimApplication::initialize() {
     else {
         std::fprintf(stderr, "[engine-sim] assets path not found: %s\n", assetsDir.c_str());
         std::fflush(stderr);
-        DebugTrace::Log("assets", "assets path not found: %s", assetsDir.c_str());
+        ATG_ENGINE_SIM_TRACE(Assets, Event, "assets path not found: %s", assetsDir.c_str());
         return;
     }
 
+    StartupTimeline::Record("load_assets", assetsBegin, StartupTimeline::Now());
+
     m_textRenderer.SetEngine(&m_engine);
     m_textRenderer.SetRenderer(m_engine.GetUiRenderer());
     m_textRenderer.SetFont(m_engine.GetConsole()->GetFont());
+    m_textLayoutCache.initialize(&m_textRenderer);
 
-    loadScript();
-    DebugTrace::Log("script", "initial script loaded");
+    m_scriptWatcher.initialize();
 
-    m_audioBuffer.initialize(44100, 44100);
-    m_audioBuffer.m_writePointer = (int)(44100 * 0.1);
+    // Made silent; the source starts looping once an engine is installed
+    {
+        StartupTimeline::Scope scope("audio_device");
+        initializeAudioOutput();
+    }
 
-    ysAudioParameters params;
-    params.m_bitsPerSample = 16;
-    params.m_channelCount = 1;
-    params.m_sampleRate = 44100;
-    m_outputAudioBuffer =
-        m_engine.GetAudioDevice()->CreateBuffer(&params, 44100);
+    loadScript();
+    ATG_ENGINE_SIM_TRACE(Script, Event, "initial script loaded");
 
-    m_audioSource = m_engine.GetAudioDevice()->CreateSource(m_outputAudioBuffer);
-    m_audioSource->SetMode((m_simulator != nullptr && m_simulator->getEngine() != nullptr)
-        ? ysAudioSource::Mode::Loop
-        : ysAudioSource::Mode::Stop);
-    m_audioSource->SetPan(0.0f);
-    m_audioSource->SetVolume(1.0f);
-    DebugTrace::Log("audio", "audio source initialized");
+    // Indexed after the first load so the two don't compete for the
+    // script compiler
+    m_engineCatalog.initialize(m_assetPath);
+    m_engineCatalog.refresh();
+    m_catalogLoader.initialize();
 
 #if ATG_ENGINE_SIM_DISCORD_ENABLED && defined(_WIN32)
     // Create a global instance of discord-rpc
@@ -491,11 +626,14 @@ void EngineSimApplication::initialize() {
 
     GetDiscordManager()->SetStatus(passMe, engineName, s_buildVersion);
 #endif /* ATG_ENGINE_SIM_DISCORD_ENABLED && _WIN32 */
-    DebugTrace::Log("app", "initialize() complete");
+    ATG_ENGINE_SIM_TRACE(App, Event, "initialize() complete");
 }
 
 void EngineSimApplication::process(float frame_dt) {
-    frame_dt = static_cast<float>(clamp(frame_dt, 1 / 200.0f, 1 / 30.0f));
+    // Offline renders keep to their fixed frame length
+    if (!m_offlineRender) {
+        frame_dt = static_cast<float>(clamp(frame_dt, 1 / 200.0f, 1 / 30.0f));
+    }
 
     static double s_lastSimulationSpeed = -1.0;
     double speed = 1.0 / 1.0;
@@ -526,8 +664,8 @@ void EngineSimApplication::process(float frame_dt) {
     }
 
     if (s_lastSimulationSpeed != speed) {
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
             "simulation_speed changed old=%.6f new=%.6f",
             s_lastSimulationSpeed,
             speed);
@@ -536,38 +674,59 @@ void EngineSimApplication::process(float frame_dt) {
 
     m_simulator->setSimulationSpeed(speed);
 
-    const double avgFramerate = clamp(m_engine.GetAverageFramerate(), 30.0f, 1000.0f);
-    m_simulator->startFrame(1 / avgFramerate);
-
-    auto proc_t0 = std::chrono::steady_clock::now();
-    const int iterationCount = m_simulator->getFrameIterationCount();
-    while (m_simulator->simulateStep()) {
+    if (m_physicsThread.isRunning()) {
+        // Stepped on the physics thread; the run loop holds its state lock
         m_oscCluster->sample();
+        m_performanceCluster->addTimePerTimestepSample(m_physicsThread.getTimePerTimestep());
+        m_performanceHud->addTimePerTimestepSample(m_physicsThread.getTimePerTimestep());
     }
+    else {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(Frame);
+        const double avgFramerate = clamp(m_engine.GetAverageFramerate(), 30.0f, 1000.0f);
+        m_simulator->startFrame(m_offlineRender ? frame_dt : 1 / avgFramerate);
+
+        auto proc_t0 = std::chrono::steady_clock::now();
+        const int iterationCount = m_simulator->getFrameIterationCount();
+        while (m_simulator->simulateStep()) {
+            /* void */
+        }
+
+        // The steps left telemetry records behind for the scopes
+        m_oscCluster->sample();
 
-    auto proc_t1 = std::chrono::steady_clock::now();
+        auto proc_t1 = std::chrono::steady_clock::now();
 
-    m_simulator->endFrame();
+        m_simulator->endFrame();
 
-    auto duration = proc_t1 - proc_t0;
-    if (iterationCount > 0) {
-        m_performanceCluster->addTimePerTimestepSample(
-            (duration.count() / 1E9) / iterationCount);
+        auto duration = proc_t1 - proc_t0;
+        if (iterationCount > 0) {
+            m_performanceCluster->addTimePerTimestepSample(
+                (duration.count() / 1E9) / iterationCount);
+            m_performanceHud->addTimePerTimestepSample(
+                (duration.count() / 1E9) / iterationCount);
+        }
+    }
+
+    ATG_ENGINE_SIM_PROFILE_SCOPE(AudioOutput);
+    if (m_offlineRender) {
+        processOfflineAudio();
+        return;
     }
 
     const SampleOffset safeWritePosition = m_audioSource->GetCurrentWritePosition();
     const SampleOffset writePosition = m_audioBuffer.m_writePointer;
     const auto audioPrepStart = std::chrono::steady_clock::now();
 
+    const double leadTime = outputLeadTime();
     SampleOffset targetWritePosition =
-        m_audioBuffer.getBufferIndex(safeWritePosition, (int)(44100 * 0.1));
+        m_audioBuffer.getBufferIndex(safeWritePosition, (int)(m_audioSampleRate * leadTime));
     SampleOffset maxWrite = m_audioBuffer.offsetDelta(writePosition, targetWritePosition);
 
     SampleOffset currentLead = m_audioBuffer.offsetDelta(safeWritePosition, writePosition);
     SampleOffset newLead = m_audioBuffer.offsetDelta(safeWritePosition, targetWritePosition);
 
-    if (currentLead > 44100 * 0.5) {
-        m_audioBuffer.m_writePointer = m_audioBuffer.getBufferIndex(safeWritePosition, (int)(44100 * 0.05));
+    if (currentLead > m_audioSampleRate * 5 * leadTime) {
+        m_audioBuffer.m_writePointer = m_audioBuffer.getBufferIndex(safeWritePosition, (int)(m_audioSampleRate * 0.5 * leadTime));
         currentLead = m_audioBuffer.offsetDelta(safeWritePosition, m_audioBuffer.m_writePointer);
         maxWrite = m_audioBuffer.offsetDelta(m_audioBuffer.m_writePointer, targetWritePosition);
     }
@@ -576,43 +735,71 @@ void EngineSimApplication::process(float frame_dt) {
         maxWrite = 0;
     }
 
-    int16_t *samples = new int16_t[maxWrite];
-    const int readSamples = m_simulator->readAudioOutput(maxWrite, samples);
-
-    for (SampleOffset i = 0; i < (SampleOffset)readSamples && i < maxWrite; ++i) {
-        const int16_t sample = samples[i];
-        if (m_oscillatorSampleOffset % 4 == 0) {
-            m_oscCluster->getAudioWaveformOscilloscope()->addDataPoint(
-                m_oscillatorSampleOffset,
-                sample / (float)(INT16_MAX));
-        }
-
-        m_audioBuffer.writeSample(sample, m_audioBuffer.m_writePointer, (int)i);
-
-        m_oscillatorSampleOffset = (m_oscillatorSampleOffset + 1) % (44100 / 10);
-    }
-
-    delete[] samples;
-
-    if (readSamples > 0) {
+    // Synthesizer output stays float until it is quantized into the device
+    // buffer segments; only the span that was actually filled is committed
+    int readSamples = 0;
+    if (maxWrite > 0) {
         const SampleOffset beforeCommitWrite = m_audioBuffer.m_writePointer;
         SampleOffset size0, size1;
         void *data0, *data1;
         m_audioSource->LockBufferSegment(
-            m_audioBuffer.m_writePointer, readSamples, &data0, &size0, &data1, &size1);
+            m_audioBuffer.m_writePointer, maxWrite, &data0, &size0, &data1, &size1);
+
+        int16_t *segment0 = reinterpret_cast<int16_t *>(data0);
+        int16_t *segment1 = reinterpret_cast<int16_t *>(data1);
+        const int available0 = (segment0 != nullptr) ? (int)size0 : 0;
+        const int available1 = (segment1 != nullptr) ? (int)size1 : 0;
+        const int capacity = std::min(available0 + available1, m_audioSampleRate);
+        const size_t readPosition = m_simulator->synthesizer().getOutputPosition();
+        readSamples = m_simulator->readAudioOutput(capacity, m_audioOutput);
+        m_lookahead.mix(m_audioOutput, readSamples, readPosition);
+        if (m_retiring.simulator != nullptr) {
+            readSamples = mixRetiringOutput(readSamples, capacity);
+        }
 
-        m_audioBuffer.copyBuffer(
-            reinterpret_cast<int16_t *>(data0), m_audioBuffer.m_writePointer, size0);
-        m_audioBuffer.copyBuffer(
-            reinterpret_cast<int16_t *>(data1),
-            m_audioBuffer.getBufferIndex(m_audioBuffer.m_writePointer, size0),
-            size1);
+        // The probe's sample leaves for the device once the samples queued
+        // ahead of it have
+        if (m_latencyProbe.isWaiting(LatencyProbe::Stage::Played)) {
+            const int offset = (int)m_latencyProbe.getPosition(LatencyProbe::Stage::Read);
+            if (offset < readSamples) {
+                const double delay = (double)(currentLead + offset) / m_audioSampleRate;
+                m_latencyProbe.mark(
+                    LatencyProbe::Stage::Played,
+                    m_audioBuffer.getBufferIndex(m_audioBuffer.m_writePointer, offset),
+                    audioPrepStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(delay)));
+            }
+        }
+
+        // About to run dry; carry the last engine cycle on rather than let
+        // the device play silence, and crossfade back once output catches up
+        Synthesizer &synthesizer = m_simulator->synthesizer();
+        const int minimumLead = (int)(m_audioSampleRate * 0.25 * leadTime);
+        if (currentLead + readSamples < minimumLead) {
+            const int target = std::min(minimumLead - (int)currentLead, capacity);
+            readSamples += synthesizer.concealOutput(target - readSamples, m_audioOutput + readSamples);
+        }
+        const int read0 = std::min(readSamples, available0);
+        synthesizer.quantizeOutput(m_audioOutput, segment0, read0);
+        synthesizer.quantizeOutput(m_audioOutput + read0, segment1, readSamples - read0);
+
+#ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
+        if (isRecording()) {
+            m_videoCapture.writeAudio(segment0, read0);
+            m_videoCapture.writeAudio(segment1, readSamples - read0);
+        }
+#endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
+
+        sampleAudioScope(readSamples);
 
         m_audioSource->UnlockBufferSegments(data0, size0, data1, size1);
         m_audioBuffer.commitBlock(readSamples);
+        if (readSamples > 0 && StartupTimeline::IsRecording()) {
+            finishStartupTimeline();
+        }
         if (m_audioBuffer.m_writePointer < beforeCommitWrite) {
-            DebugTrace::Log(
-                "audio",
+            ATG_ENGINE_SIM_TRACE(
+                Audio, Verbose,
                 "transient_ring_wrap event=audio_buffer write_before=%d write_after=%d samples=%d",
                 beforeCommitWrite,
                 m_audioBuffer.m_writePointer,
@@ -623,32 +810,151 @@ void EngineSimApplication::process(float frame_dt) {
     m_performanceCluster->addInputBufferUsageSample(
         (double)m_simulator->getSynthesizerInputLatency() / m_simulator->getSynthesizerInputLatencyTarget());
     m_performanceCluster->addAudioLatencySample(
-        m_audioBuffer.offsetDelta(m_audioSource->GetCurrentWritePosition(), m_audioBuffer.m_writePointer) / (44100 * 0.1));
+        m_audioBuffer.offsetDelta(m_audioSource->GetCurrentWritePosition(), m_audioBuffer.m_writePointer) / (m_audioSampleRate * leadTime));
     const auto audioPrepEnd = std::chrono::steady_clock::now();
-    DebugTrace::Log(
-        "audio",
+    ATG_ENGINE_SIM_TRACE(
+        Audio, Verbose,
         "subsystem_duration audio_prep_us=%lld",
         static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(audioPrepEnd - audioPrepStart).count()));
 }
 
-void EngineSimApplication::render() {
-    for (SimulationObject *object : m_objects) {
-        object->generateGeometry();
+void EngineSimApplication::processOfflineAudio() {
+    // Everything the synthesizer has rendered goes to the capture; the
+    // offline synthesizer holds the steps back until it's read
+    const int readSamples = m_simulator->readAudioOutput(m_audioSampleRate, m_audioOutput);
+    m_offlineAudio.resize(std::max((int)m_offlineAudio.size(), readSamples));
+    m_simulator->synthesizer().quantizeOutput(m_audioOutput, m_offlineAudio.data(), readSamples);
+
+#ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
+    if (isRecording()) {
+        m_videoCapture.writeAudio(m_offlineAudio.data(), readSamples);
     }
+#endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
 
-    m_viewParameters.Sublayer = 0;
-    for (SimulationObject *object : m_objects) {
-        object->render(&getViewParameters());
+    sampleAudioScope(readSamples);
+}
+
+void EngineSimApplication::sampleAudioScope(int readSamples) {
+    // Every 4th sample of a 0.1 s sweep, pushed one run per sweep
+    constexpr int ScopePeriod = 44100 / 10;
+    constexpr int ScopeDecimation = 4;
+    Oscilloscope *waveformScope = m_oscCluster->getAudioWaveformOscilloscope();
+    const int scopeSamples =
+        (m_oscCluster->isShown() && !m_simulator->isOverloadShedding(OverloadPolicy::Level::Scopes))
+            ? readSamples
+            : 0;
+    for (int i = 0; i < scopeSamples;) {
+        const int span = std::min(readSamples - i, ScopePeriod - m_oscillatorSampleOffset);
+        const int first =
+            (ScopeDecimation - m_oscillatorSampleOffset % ScopeDecimation) % ScopeDecimation;
+        if (first < span) {
+            waveformScope->addDataPoints(
+                m_oscillatorSampleOffset + first,
+                ScopeDecimation,
+                m_audioOutput + i + first,
+                ScopeDecimation,
+                (span - first + ScopeDecimation - 1) / ScopeDecimation);
+        }
+
+        i += span;
+        m_oscillatorSampleOffset = (m_oscillatorSampleOffset + span) % ScopePeriod;
+    }
+}
+
+float EngineSimApplication::getFrameLength() {
+    return m_offlineRender
+        ? 1.0f / m_applicationSettings.renderFrameRate
+        : m_engine.GetFrameLength();
+}
+
+bool EngineSimApplication::updateStaticGeometry() {
+    const float scale = pixelsToUnits(1.0f);
+    const float pixel = viewPixelsToUnits(1.0f);
+    if (m_staticGeometryValid && scale == m_staticGeometryScale && pixel == m_staticGeometryPixel) {
+        return false;
     }
 
-    m_viewParameters.Sublayer = 1;
+    m_geometryGenerator.releaseRetained();
+    m_partInstancer.clearMeshes();
     for (SimulationObject *object : m_objects) {
-        object->render(&getViewParameters());
+        object->generateStaticGeometry();
+    }
+
+    m_geometryGenerator.retain();
+    m_staticGeometryScale = scale;
+    m_staticGeometryPixel = pixel;
+    m_staticGeometryValid = true;
+
+    return true;
+}
+
+bool EngineSimApplication::resizeGeometryBuffers() {
+    const int vertexCapacity = m_geometryGenerator.getVertexCapacity();
+    const int indexCapacity = m_geometryGenerator.getIndexCapacity();
+    if (vertexCapacity <= m_geometryVertexCapacity && indexCapacity <= m_geometryIndexCapacity) {
+        return false;
+    }
+
+    m_drawBatcher.destroy();
+    if (m_geometryVertexBuffer != nullptr) {
+        m_engine.GetDevice()->DestroyGPUBuffer(m_geometryVertexBuffer);
+    }
+
+    if (m_geometryIndexBuffer != nullptr) {
+        m_engine.GetDevice()->DestroyGPUBuffer(m_geometryIndexBuffer);
+    }
+
+    m_engine.GetDevice()->CreateIndexBuffer(
+        &m_geometryIndexBuffer, sizeof(unsigned short) * indexCapacity, nullptr);
+    m_engine.GetDevice()->CreateVertexBuffer(
+        &m_geometryVertexBuffer, sizeof(dbasic::Vertex) * vertexCapacity, nullptr);
+    m_drawBatcher.initialize(
+        &m_engine, &m_shaders, m_geometryVertexBuffer, m_geometryIndexBuffer, indexCapacity);
+
+    ATG_ENGINE_SIM_TRACE(
+        Ui, Event,
+        "geometry buffers resized vertices=%d->%d indices=%d->%d",
+        m_geometryVertexCapacity, vertexCapacity,
+        m_geometryIndexCapacity, indexCapacity);
+
+    m_geometryVertexCapacity = vertexCapacity;
+    m_geometryIndexCapacity = indexCapacity;
+
+    return true;
+}
+
+void EngineSimApplication::render() {
+    // Nothing to build while the engine view is off screen
+    if (!m_engineView->isShown()) {
+        m_uiManager.render();
+        return;
     }
 
-    m_viewParameters.Sublayer = 2;
+    // Parts off screen once zoomed in are neither generated nor drawn
+    const Bounds view = getViewBounds();
+    m_visibleObjects.clear();
     for (SimulationObject *object : m_objects) {
-        object->render(&getViewParameters());
+        Bounds bounds;
+        if (!object->getWorldBounds(&bounds) || bounds.overlaps(view)) {
+            m_visibleObjects.push_back(object);
+        }
+    }
+
+    m_parallelGeometry.run(
+        &m_geometryGenerator,
+        (int)m_visibleObjects.size(),
+        [this](int i) { m_visibleObjects[i]->generateGeometry(); });
+
+    // Instanced parts are drawn at the end of each sublayer, so they stay
+    // under everything from the sublayers above
+    m_partInstancer.beginFrame();
+    for (int sublayer = 0; sublayer < 3; ++sublayer) {
+        m_viewParameters.Sublayer = sublayer;
+        for (SimulationObject *object : m_visibleObjects) {
+            object->render(&getViewParameters());
+        }
+
+        m_partInstancer.flush();
     }
 
     m_uiManager.render();
@@ -664,13 +970,38 @@ float EngineSimApplication::unitsToPixels(float units) const {
     return units * f;
 }
 
+float EngineSimApplication::viewPixelsToUnits(float pixels) const {
+    const float zoom = std::exp2(std::round(2 * std::log2(m_engineView->m_zoom)) / 2);
+    return pixelsToUnits(pixels) / zoom;
+}
+
+Bounds EngineSimApplication::getViewBounds() const {
+    const float height = m_displayHeight / m_engineView->m_zoom;
+    const float aspectRatio = m_engineView->m_bounds.width() / m_engineView->m_bounds.height();
+
+    // Turning the view foreshortens it horizontally, so more fits across
+    const float width =
+        aspectRatio * height / std::fmax(std::abs(std::cos(m_displayAngle)), 0.1f);
+
+    return Bounds(width, height, m_engineView->getCameraPosition(), Bounds::center)
+        .grow(0.1f * height);
+}
+
 void EngineSimApplication::run() {
-    DebugTrace::Log("app", "run() begin");
+    ATG_ENGINE_SIM_ALLOCATION_SCOPE(Ui);
+    ATG_ENGINE_SIM_TRACE(App, Event, "run() begin");
     if (m_simulator == nullptr) {
         startupLog("run aborted: simulator is null after initialization");
         return;
     }
 
+    // The main thread steps the physics unless threadedPhysics is set
+    DenormalScope denormals;
+    StepProfiler::SetThreadName("main");
+    if (StepProfiler::IsEnabled() && DebugTrace::IsEnabled()) {
+        StepProfiler::StartCapture(ProfileCaptureSpans);
+    }
+
     auto nextHeartbeat = std::chrono::steady_clock::now() + std::chrono::seconds(1);
     int framesSinceHeartbeat = 0;
     unsigned long long frameIndex = 0;
@@ -690,13 +1021,14 @@ void EngineSimApplication::run() {
     bool frameMsEwmaInitialized = false;
     double memorySlopeEwma = 0.0;
     bool memorySlopeEwmaInitialized = false;
+    AllocationTracker::TagStatistics previousAllocations[AllocationTracker::TagCount];
+    int allocationSnapshots = 0;
+    EventCounters::Totals previousEvents;
+    EventCounters::GetTotals(&previousEvents);
     const std::filesystem::path watchedScriptPath = std::filesystem::path(m_assetPath) / "assets" / "main.mr";
-    bool scriptWatcherInitialized = false;
-    std::filesystem::file_time_type watchedScriptWriteTime{};
-    bool scriptWatchDebouncePending = false;
-    auto scriptWatchPendingSince = std::chrono::steady_clock::now();
-    auto nextScriptWatchPoll = std::chrono::steady_clock::now() + std::chrono::seconds(1);
-    int lastAudioDeviceSampleRate = -1;
+    auto nextAudioDevicePoll = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    auto inactiveSince = std::chrono::steady_clock::now();
+    std::array<int, 8> pausedView = {};
 
     while (true) {
         ++frameIndex;
@@ -707,8 +1039,8 @@ void EngineSimApplication::run() {
         ++framesSinceHeartbeat;
 
         const bool frameWindowActive = (m_engine.GetGameWindow() != nullptr) ? m_engine.GetGameWindow()->IsActive() : false;
-        DebugTrace::Log(
-            "mainloop",
+        ATG_ENGINE_SIM_TRACE(
+            Mainloop, Verbose,
             "FrameBegin dt=%.6f window=%dx%d focused=%d",
             m_engine.GetFrameLength(),
             m_engine.GetScreenWidth(),
@@ -716,50 +1048,130 @@ void EngineSimApplication::run() {
             frameWindowActive ? 1 : 0);
 
         if (!focusStateInitialized || frameWindowActive != lastFocusState) {
-            DebugTrace::Log("window", "focus %s; pause_policy=manual_only", frameWindowActive ? "gained" : "lost");
+            ATG_ENGINE_SIM_TRACE(
+                Window, Event,
+                "focus %s; idle_pause=%.1f",
+                frameWindowActive ? "gained" : "lost",
+                m_applicationSettings.idlePause);
             lastFocusState = frameWindowActive;
             focusStateInitialized = true;
+            inactiveSince = std::chrono::steady_clock::now();
         }
 
         if (!m_engine.IsOpen()) {
-            DebugTrace::Log("app", "run loop exit: window closed");
+            ATG_ENGINE_SIM_TRACE(App, Event, "run loop exit: window closed");
             break;
         }
         if (m_engine.ProcessKeyDown(ysKey::Code::Escape)) {
-            DebugTrace::Log("input", "escape pressed; exiting run loop");
+            ATG_ENGINE_SIM_TRACE(Input, Event, "escape pressed; exiting run loop");
             break;
         }
 
         if (m_engine.ProcessKeyDown(ysKey::Code::Return)) {
-            DebugTrace::Log("script", "reload requested via Return key");
-            DebugTrace::Log("script", "filesystem_watcher_event source=manual_reload_key path=%s", watchedScriptPath.string().c_str());
-            m_audioSource->SetMode(ysAudioSource::Mode::Stop);
-            loadScript();
-            if (m_simulator->getEngine() != nullptr) {
-                m_audioSource->SetMode(ysAudioSource::Mode::Loop);
+            ATG_ENGINE_SIM_TRACE(Script, Event, "reload requested via Return key");
+            ATG_ENGINE_SIM_TRACE(Script, Event, "filesystem_watcher_event source=manual_reload_key path=%s", watchedScriptPath.string().c_str());
+
+            // Shift recalibrates, which needs a new simulator to time
+            EngineLoader::Request request = createLoadRequest();
+            if (m_engine.IsKeyDown(ysKey::Code::Shift)) {
+                request.calibrateFidelity = true;
+                request.patchable = false;
+                m_infoCluster->setLogMessage("Calibrating fidelity");
+            }
+
+            m_engineLoader.request(request);
+        }
+
+        // Edits are debounced on the watcher thread
+        std::vector<std::string> changedScripts;
+        if (m_scriptWatcher.takeChanges(&changedScripts)) {
+            for (const std::string &path : changedScripts) {
+                ATG_ENGINE_SIM_TRACE(
+                    Script, Event,
+                    "filesystem_watcher_event path=%s action=modified",
+                    path.c_str());
+            }
+
+            // The loader rehashes the sources and skips the load if saving
+            // didn't change them; tunable-only edits are patched in place
+            // when the load finishes
+            EngineLoader::Request request = createLoadRequest();
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+            request.unchangedSourcesHash = m_loadedScriptSources.getHash();
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+            ATG_ENGINE_SIM_TRACE(
+                Script, Event,
+                "filesystem_watcher_debounce action=settled files=%d",
+                static_cast<int>(changedScripts.size()));
+
+            m_engineLoader.request(request);
+        }
+
+        // Loads finish on the loader thread; the swap itself doesn't block
+        EngineLoader::Result loaded;
+        if (m_engineLoader.takeResult(&loaded)) {
+            if (loaded.unchanged) {
+                ATG_ENGINE_SIM_TRACE(Script, Event, "script sources unchanged; reload skipped");
+            }
+            else {
+                installEngine(loaded);
             }
         }
+
+        EngineLoader::Result branch;
+        if (m_branchLoader.takeResult(&branch)) {
+            takeLookaheadBranch(branch);
+        }
+
+        if (m_engine.ProcessKeyDown(ysKey::Code::PageDown)) {
+            selectCatalogEntry(1);
+        }
+        else if (m_engine.ProcessKeyDown(ysKey::Code::PageUp)) {
+            selectCatalogEntry(-1);
+        }
+
+        if (m_engine.ProcessKeyDown(ysKey::Code::End)) {
+            switchToPreloaded();
+        }
+
+        EngineLoader::Result preloaded;
+        if (m_catalogLoader.takeResult(&preloaded)) {
+            if (m_hasPreloaded) m_catalogLoader.retire(m_preloaded);
+            m_preloaded = preloaded;
+            m_hasPreloaded = true;
+
+            m_infoCluster->setLogMessage(preloaded.simulator != nullptr
+                ? "Engine preloaded [END] to switch"
+                : "Engine failed to load");
+        }
         if (m_engine.ProcessKeyDown(ysKey::Code::F10)) {
-            DebugTrace::Log("mainloop", "on-demand dump requested via F10");
+            ATG_ENGINE_SIM_TRACE(Mainloop, Event, "on-demand dump requested via F10");
             DebugTrace::RequestDump("hotkey_f10");
+            writeProfileTrace();
+        }
+
+        if (m_engine.ProcessKeyDown(ysKey::Code::F9)) {
+            m_showPerformanceHud = !m_showPerformanceHud;
+            m_performanceHud->setVisible(m_showPerformanceHud);
+            ATG_ENGINE_SIM_TRACE(Ui, Event, "performance hud visible=%d", m_showPerformanceHud ? 1 : 0);
         }
 
         if (m_engine.ProcessKeyDown(ysKey::Code::Tab)) {
             m_screen++;
             if (m_screen > 2) m_screen = 0;
-            DebugTrace::Log("ui", "screen changed to %d", m_screen);
+            ATG_ENGINE_SIM_TRACE(Ui, Event, "screen changed to %d", m_screen);
         }
 
         if (m_engine.ProcessKeyDown(ysKey::Code::F)) {
             if (m_engine.GetGameWindow()->GetWindowStyle() != ysWindow::WindowStyle::Fullscreen) {
                 m_engine.GetGameWindow()->SetWindowStyle(ysWindow::WindowStyle::Fullscreen);
                 m_infoCluster->setLogMessage("Entered fullscreen mode");
-                DebugTrace::Log("window", "entered fullscreen");
+                ATG_ENGINE_SIM_TRACE(Window, Event, "entered fullscreen");
             }
             else {
                 m_engine.GetGameWindow()->SetWindowStyle(ysWindow::WindowStyle::Windowed);
                 m_infoCluster->setLogMessage("Exited fullscreen mode");
-                DebugTrace::Log("window", "exited fullscreen");
+                ATG_ENGINE_SIM_TRACE(Window, Event, "exited fullscreen");
             }
         }
 
@@ -772,8 +1184,8 @@ void EngineSimApplication::run() {
             lastResizeEvent = std::chrono::steady_clock::now();
             if (!resizeInProgress) {
                 resizeInProgress = true;
-                DebugTrace::Log(
-                    "window",
+                ATG_ENGINE_SIM_TRACE(
+                    Window, Event,
                     "resize begin from=%dx%d to=%dx%d",
                     previousScreenWidth,
                     previousScreenHeight,
@@ -785,8 +1197,8 @@ void EngineSimApplication::run() {
         }
         else if (resizeInProgress && std::chrono::steady_clock::now() - lastResizeEvent > std::chrono::milliseconds(250)) {
             resizeInProgress = false;
-            DebugTrace::Log(
-                "window",
+            ATG_ENGINE_SIM_TRACE(
+                Window, Event,
                 "resize end committed=%dx%d coalesced_events=%d",
                 m_screenWidth,
                 m_screenHeight,
@@ -796,17 +1208,49 @@ void EngineSimApplication::run() {
 
         updateScreenSizeStability();
 
+        m_inputTime = ControlQueue::Clock::now();
+
+        // Everything up to presenting touches simulator state; the physics
+        // thread only waits for this part of the frame
+        std::unique_lock<std::mutex> physicsLock;
+        if (m_physicsThread.isRunning()) {
+            physicsLock = std::unique_lock<std::mutex>(m_physicsThread.getStateLock());
+        }
+
+        // Minimized windows report an empty client area. Recording needs
+        // every frame.
+        const bool frameWindowVisible =
+            m_engine.GetGameWindow()->GetGameWidth() > 0
+            && m_engine.GetGameWindow()->GetGameHeight() > 0;
+        m_renderScheduler.setEnabled(m_applicationSettings.adaptiveFramerate && !isRecording());
+        m_renderScheduler.setSteppingSimulation(!m_physicsThread.isRunning());
+
+        const RenderScheduler::Mode previousRenderMode = m_renderScheduler.getMode();
+        const RenderScheduler::Mode renderMode = m_renderScheduler.update(
+            frameWindowActive,
+            frameWindowVisible,
+            m_simulator->getSynthesizerInputLatency(),
+            m_simulator->getSynthesizerInputLatencyTarget());
+        if (renderMode != previousRenderMode) {
+            ATG_ENGINE_SIM_TRACE(
+                Mainloop, Event,
+                "render_mode old=%s new=%s",
+                RenderScheduler::GetModeName(previousRenderMode),
+                RenderScheduler::GetModeName(renderMode));
+        }
+
         const auto inputStart = std::chrono::steady_clock::now();
         auto inputEnd = inputStart;
         auto simStart = inputStart;
         auto simEnd = inputStart;
-        DebugTrace::Log("mainloop", "allocation-heavy enter processEngineInput");
+        ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "allocation-heavy enter processEngineInput");
         processEngineInput();
+        updateFidelity();
         inputDispatchTime = std::chrono::steady_clock::now();
         {
             inputEnd = std::chrono::steady_clock::now();
             const auto inputMicros = std::chrono::duration_cast<std::chrono::microseconds>(inputEnd - inputStart).count();
-            DebugTrace::Log("mainloop", "allocation-heavy leave processEngineInput duration_us=%lld", static_cast<long long>(inputMicros));
+            ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "allocation-heavy leave processEngineInput duration_us=%lld", static_cast<long long>(inputMicros));
         }
 
         if (m_engine.ProcessKeyDown(ysKey::Code::Insert) &&
@@ -823,45 +1267,142 @@ void EngineSimApplication::run() {
             stopRecording();
         }
 
-        if (!m_paused || m_engine.ProcessKeyDown(ysKey::Code::Right)) {
+        // Offline renders start as soon as the window settles
+        if (m_offlineRender && !isRecording() && readyToRecord()) {
+            startRecording();
+            if (!isRecording()) {
+                startupLog("failed to start offline render '%s'", m_applicationSettings.renderVideo.c_str());
+                break;
+            }
+        }
+
+        if (!m_offlineRender && m_engine.ProcessKeyDown(ysKey::Code::P)) {
+            m_autoPaused = false;
+            setPaused(!m_paused);
+        }
+
+        // Background instances pause themselves when idle_pause is set and
+        // resume as soon as they're focused again
+        const bool frameWindowShown = frameWindowActive && frameWindowVisible;
+        if (m_autoPaused && frameWindowShown) {
+            m_autoPaused = false;
+            setPaused(false);
+        }
+        else if (!m_paused
+            && !frameWindowShown
+            && !m_offlineRender
+            && !isRecording()
+            && m_applicationSettings.idlePause > 0
+            && std::chrono::steady_clock::now() - inactiveSince
+                >= std::chrono::duration<double>(m_applicationSettings.idlePause))
+        {
+            m_autoPaused = true;
+            setPaused(true);
+        }
+
+        const bool stepRequested = m_paused && m_engine.ProcessKeyDown(ysKey::Code::Right);
+        if (m_physicsThread.isRunning()) {
+            m_physicsThread.setPaused(m_paused);
+            if (stepRequested) {
+                m_physicsThread.requestStep();
+            }
+        }
+
+        if (m_paused) {
+            if (m_audioStopPending && std::chrono::steady_clock::now() >= m_audioStopTime) {
+                m_audioSource->SetMode(ysAudioSource::Mode::Stop);
+                m_audioStopPending = false;
+                ATG_ENGINE_SIM_TRACE(Audio, Event, "audio source stopped while paused");
+            }
+
+            // Only what the user does changes the picture
+            int mouse_x, mouse_y;
+            m_engine.GetOsMousePos(&mouse_x, &mouse_y);
+            const std::array<int, 8> view = {
+                mouse_x,
+                mouse_y,
+                m_engine.GetMouseWheel(),
+                m_engine.IsMouseButtonDown(ysMouse::Button::Left) ? 1 : 0,
+                m_engine.GetGameWindow()->GetGameWidth(),
+                m_engine.GetGameWindow()->GetGameHeight(),
+                m_screen,
+                (frameWindowActive ? 2 : 0) | (m_showPerformanceHud ? 1 : 0)
+            };
+            if (view != pausedView || stepRequested) {
+                m_renderScheduler.requestRedraw();
+                pausedView = view;
+            }
+        }
+
+        if (!m_paused || stepRequested) {
             simStart = std::chrono::steady_clock::now();
-            DebugTrace::Log("mainloop", "allocation-heavy enter process");
-            process(m_engine.GetFrameLength());
+            ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "allocation-heavy enter process");
+            process(getFrameLength());
             simEnd = std::chrono::steady_clock::now();
             const auto simMicros = std::chrono::duration_cast<std::chrono::microseconds>(simEnd - simStart).count();
-            DebugTrace::Log("mainloop", "allocation-heavy leave process duration_us=%lld", static_cast<long long>(simMicros));
+            ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "allocation-heavy leave process duration_us=%lld", static_cast<long long>(simMicros));
+
+            // Forks between frames, with the state lock still held
+            m_lookahead.update(dynamic_cast<PistonEngineSimulator *>(m_simulator), m_speedSetting, simEnd);
         }
 
+        // Gauges read the snapshot published by the last endFrame()
+        m_simulator->updateSnapshot();
+
         const auto uiStart = std::chrono::steady_clock::now();
-        DebugTrace::Log("mainloop", "allocation-heavy enter ui_update");
-        m_uiManager.update(m_engine.GetFrameLength());
+        ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "allocation-heavy enter ui_update");
+        if (m_renderScheduler.takeUiUpdate(uiStart)) {
+            ATG_ENGINE_SIM_PROFILE_SCOPE(UiUpdate);
+            m_uiManager.update(getFrameLength());
+        }
         const auto uiEnd = std::chrono::steady_clock::now();
-        DebugTrace::Log(
-            "mainloop",
+        ATG_ENGINE_SIM_TRACE(
+            Mainloop, Verbose,
             "allocation-heavy leave ui_update duration_us=%lld",
             static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(uiEnd - uiStart).count()));
 
         const auto renderStart = std::chrono::steady_clock::now();
-        DebugTrace::Log("mainloop", "allocation-heavy enter renderScene");
-        renderScene();
+        ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "allocation-heavy enter renderScene");
+        if (m_renderScheduler.shouldRender()) {
+            ATG_ENGINE_SIM_PROFILE_SCOPE(RenderScene);
+            renderScene();
+        }
         const auto renderEnd = std::chrono::steady_clock::now();
-        DebugTrace::Log(
-            "mainloop",
+        ATG_ENGINE_SIM_TRACE(
+            Mainloop, Verbose,
             "allocation-heavy leave renderScene duration_us=%lld",
             static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(renderEnd - renderStart).count()));
 
-        m_engine.EndFrame();
+        if (physicsLock.owns_lock()) {
+            physicsLock.unlock();
+        }
+
+        {
+            ATG_ENGINE_SIM_PROFILE_SCOPE(Present);
+            m_engine.EndFrame();
+        }
 
         if (isRecording()) {
             recordFrame();
+
+            const double renderFrames =
+                m_applicationSettings.renderDuration * m_applicationSettings.renderFrameRate;
+            if (m_offlineRender && ++m_offlineRenderFrames >= renderFrames) {
+                ATG_ENGINE_SIM_TRACE(
+                    App, Event,
+                    "offline render complete frames=%lld path=%s",
+                    m_offlineRenderFrames,
+                    m_applicationSettings.renderVideo.c_str());
+                break;
+            }
         }
 
         const auto now = std::chrono::steady_clock::now();
         if (now >= nextHeartbeat) {
             const float frameLength = m_engine.GetFrameLength();
             const double fps = (frameLength > 0.0f) ? 1.0 / frameLength : 0.0;
-            DebugTrace::Log(
-                "mainloop",
+            ATG_ENGINE_SIM_TRACE(
+                Mainloop, Verbose,
                 "heartbeat frames=%d frame_dt=%.6f fps=%.2f avg_fps=%.2f screen=%dx%d game_h=%d wheel_coalesced=%d",
                 framesSinceHeartbeat,
                 frameLength,
@@ -871,8 +1412,8 @@ void EngineSimApplication::run() {
                 m_screenHeight,
                 m_gameWindowHeight,
                 g_mouseWheelEventsThisSecond);
-            DebugTrace::Log(
-                "mainloop",
+            ATG_ENGINE_SIM_TRACE(
+                Mainloop, Verbose,
                 "lock_contention_counters render_lock_proxy=%d shared_state_lock_proxy=%d",
                 0,
                 0);
@@ -881,51 +1422,13 @@ void EngineSimApplication::run() {
             nextHeartbeat = now + std::chrono::seconds(1);
         }
 
-        if (now >= nextScriptWatchPoll) {
-            std::error_code watchEc;
-            if (std::filesystem::exists(watchedScriptPath, watchEc)) {
-                const auto currentWriteTime = std::filesystem::last_write_time(watchedScriptPath, watchEc);
-                if (!watchEc) {
-                    if (!scriptWatcherInitialized) {
-                        watchedScriptWriteTime = currentWriteTime;
-                        scriptWatcherInitialized = true;
-                    }
-                    else if (currentWriteTime != watchedScriptWriteTime) {
-                        watchedScriptWriteTime = currentWriteTime;
-                        scriptWatchDebouncePending = true;
-                        scriptWatchPendingSince = now;
-                        DebugTrace::Log(
-                            "script",
-                            "filesystem_watcher_event path=%s action=modified",
-                            watchedScriptPath.string().c_str());
-                    }
-                }
-            }
-
-            if (scriptWatchDebouncePending && (now - scriptWatchPendingSince) >= std::chrono::milliseconds(350)) {
-                scriptWatchDebouncePending = false;
-                DebugTrace::Log(
-                    "script",
-                    "filesystem_watcher_debounce action=settled path=%s reload_policy=manual",
-                    watchedScriptPath.string().c_str());
-            }
-
-            if (m_outputAudioBuffer != nullptr && m_outputAudioBuffer->GetAudioParameters() != nullptr) {
-                const int currentSampleRate = m_outputAudioBuffer->GetAudioParameters()->m_sampleRate;
-                if (lastAudioDeviceSampleRate < 0) {
-                    lastAudioDeviceSampleRate = currentSampleRate;
-                }
-                else if (currentSampleRate != lastAudioDeviceSampleRate) {
-                    DebugTrace::Log(
-                        "audio",
-                        "audio_device_reconfigured old_sample_rate=%d new_sample_rate=%d",
-                        lastAudioDeviceSampleRate,
-                        currentSampleRate);
-                    lastAudioDeviceSampleRate = currentSampleRate;
-                }
+        if (now >= nextAudioDevicePoll) {
+            const int currentSampleRate = defaultOutputSampleRate();
+            if (currentSampleRate != m_audioSampleRate && !m_offlineRender) {
+                reconfigureAudioSampleRate(currentSampleRate);
             }
 
-            nextScriptWatchPoll = now + std::chrono::seconds(1);
+            nextAudioDevicePoll = now + std::chrono::seconds(1);
         }
 
         const auto frameCpuEnd = std::chrono::steady_clock::now();
@@ -939,21 +1442,21 @@ void EngineSimApplication::run() {
             static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(uiEnd - uiStart).count()) / 1000.0;
         const double renderMs =
             static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(renderEnd - renderStart).count()) / 1000.0;
-        DebugTrace::Log("mainloop", "FrameEnd cpu_ms=%.3f", frameCpuMs);
+        ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "FrameEnd cpu_ms=%.3f", frameCpuMs);
         const auto inputToVisualMs = std::chrono::duration_cast<std::chrono::microseconds>(frameCpuEnd - inputDispatchTime).count() / 1000.0;
-        DebugTrace::Log("mainloop", "input_to_visual_latency_ms=%.3f", inputToVisualMs);
+        ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "input_to_visual_latency_ms=%.3f", inputToVisualMs);
         if (!firstFrameCompleteLogged) {
-            DebugTrace::Log("mainloop", "first_frame_complete");
+            ATG_ENGINE_SIM_TRACE(Mainloop, Event, "first_frame_complete");
             firstFrameCompleteLogged = true;
         }
         if (frameCpuMs > 500.0) {
-            DebugTrace::Log("mainloop", "stall_warning threshold=500ms cpu_ms=%.3f", frameCpuMs);
+            ATG_ENGINE_SIM_TRACE(Mainloop, Event, "stall_warning threshold=500ms cpu_ms=%.3f", frameCpuMs);
         }
         else if (frameCpuMs > 100.0) {
-            DebugTrace::Log("mainloop", "stall_warning threshold=100ms cpu_ms=%.3f", frameCpuMs);
+            ATG_ENGINE_SIM_TRACE(Mainloop, Event, "stall_warning threshold=100ms cpu_ms=%.3f", frameCpuMs);
         }
         if (frameCpuMs > 1000.0) {
-            DebugTrace::Log("mainloop", "watchdog_warning main_thread_unresponsive_window cpu_ms=%.3f", frameCpuMs);
+            ATG_ENGINE_SIM_TRACE(Mainloop, Event, "watchdog_warning main_thread_unresponsive_window cpu_ms=%.3f", frameCpuMs);
         }
         if (!frameMsEwmaInitialized) {
             frameMsEwma = frameCpuMs;
@@ -962,8 +1465,8 @@ void EngineSimApplication::run() {
         else {
             frameMsEwma = frameMsEwma * 0.95 + frameCpuMs * 0.05;
             if (frameCpuMs > frameMsEwma * 2.5 && frameCpuMs > 20.0) {
-                DebugTrace::Log(
-                    "mainloop",
+                ATG_ENGINE_SIM_TRACE(
+                    Mainloop, Event,
                     "anomaly_detector frame_spike current_ms=%.3f baseline_ms=%.3f",
                     frameCpuMs,
                     frameMsEwma);
@@ -972,7 +1475,7 @@ void EngineSimApplication::run() {
         expectedFrameEnd += std::chrono::milliseconds(16);
         const auto schedulerDriftUs =
             std::chrono::duration_cast<std::chrono::microseconds>(frameCpuEnd - expectedFrameEnd).count();
-        DebugTrace::Log("mainloop", "scheduler_drift_us=%lld target_fps=60", static_cast<long long>(schedulerDriftUs));
+        ATG_ENGINE_SIM_TRACE(Mainloop, Verbose, "scheduler_drift_us=%lld target_fps=60", static_cast<long long>(schedulerDriftUs));
 
         struct SlowEntry {
             const char *name;
@@ -993,8 +1496,8 @@ void EngineSimApplication::run() {
                 }
             }
         }
-        DebugTrace::Log(
-            "mainloop",
+        ATG_ENGINE_SIM_TRACE(
+            Mainloop, Verbose,
             "top_slow_functions f1=%s:%.3fms f2=%s:%.3fms f3=%s:%.3fms",
             entries[0].name,
             entries[0].ms,
@@ -1003,11 +1506,31 @@ void EngineSimApplication::run() {
             entries[2].name,
             entries[2].ms);
 
+        // What the frame's simulation did, next to what it cost
+        if (EventCounters::IsEnabled()) {
+            EventCounters::Totals events;
+            EventCounters::GetTotals(&events);
+            const EventCounters::Totals frameEvents = events.since(previousEvents);
+            previousEvents = events;
+
+            ATG_ENGINE_SIM_TRACE(
+                Mainloop, Verbose,
+                "event_counters gas_flows=%llu choked_fraction=%.3f equilibrium_clamps=%llu solver_steps=%llu ignitions=%llu underruns=%llu overruns=%llu convolution_samples=%llu",
+                (unsigned long long)frameEvents.get(EventCounters::Counter::GasFlows),
+                frameEvents.chokedFraction(),
+                (unsigned long long)frameEvents.get(EventCounters::Counter::EquilibriumClamps),
+                (unsigned long long)frameEvents.get(EventCounters::Counter::SolverSteps),
+                (unsigned long long)frameEvents.get(EventCounters::Counter::IgnitionEvents),
+                (unsigned long long)frameEvents.get(EventCounters::Counter::AudioUnderruns),
+                (unsigned long long)frameEvents.get(EventCounters::Counter::AudioOverruns),
+                (unsigned long long)frameEvents.get(EventCounters::Counter::ConvolutionSamples));
+        }
+
         if (frameCpuEnd >= nextMemorySnapshot) {
             MemorySnapshot snapshot = captureMemorySnapshot();
             if (snapshot.valid) {
-                DebugTrace::Log(
-                    "mainloop",
+                ATG_ENGINE_SIM_TRACE(
+                    Mainloop, Verbose,
                     "memory_snapshot rss_mb=%.2f phys_footprint_mb=%.2f iosurface_mb=%.2f malloc_metadata_mb=%.2f",
                     snapshot.rssMb,
                     snapshot.footprintMb,
@@ -1017,8 +1540,8 @@ void EngineSimApplication::run() {
                     const double deltaMb = snapshot.footprintMb - previousMemorySnapshot.footprintMb;
                     const double slopeMbPerMin = deltaMb * 60.0;
                     if (slopeMbPerMin > 10.0) {
-                        DebugTrace::Log(
-                            "mainloop",
+                        ATG_ENGINE_SIM_TRACE(
+                            Mainloop, Event,
                             "memory_growth_warning slope_mb_per_min=%.2f delta_mb=%.2f",
                             slopeMbPerMin,
                             deltaMb);
@@ -1030,8 +1553,8 @@ void EngineSimApplication::run() {
                     else {
                         memorySlopeEwma = memorySlopeEwma * 0.9 + slopeMbPerMin * 0.1;
                         if (slopeMbPerMin > memorySlopeEwma + 8.0) {
-                            DebugTrace::Log(
-                                "mainloop",
+                            ATG_ENGINE_SIM_TRACE(
+                                Mainloop, Event,
                                 "anomaly_detector memory_spike current_slope_mb_per_min=%.3f baseline=%.3f",
                                 slopeMbPerMin,
                                 memorySlopeEwma);
@@ -1042,9 +1565,50 @@ void EngineSimApplication::run() {
             }
 
             const int widgetCount = countWidgetsRecursive(m_uiManager.getRoot());
-            DebugTrace::Log("ui", "object_counters widgets=%d", widgetCount);
+            ATG_ENGINE_SIM_TRACE(Ui, Verbose, "object_counters widgets=%d", widgetCount);
+
+            // Live bytes that keep rising under one tag point at the leaking
+            // subsystem; the sampled sites every 30 s narrow it to a call path
+            if (AllocationTracker::IsEnabled()) {
+                for (int i = 0; i < AllocationTracker::TagCount; ++i) {
+                    const AllocationTracker::Tag tag = static_cast<AllocationTracker::Tag>(i);
+
+                    AllocationTracker::TagStatistics statistics;
+                    AllocationTracker::GetTagStatistics(tag, &statistics);
+                    ATG_ENGINE_SIM_TRACE(
+                        Mainloop, Verbose,
+                        "allocation_tag tag=%s live_kb=%.1f live_allocations=%llu allocs_per_s=%llu kb_per_s=%.1f",
+                        AllocationTracker::GetTagName(tag),
+                        statistics.liveBytes / 1024.0,
+                        (unsigned long long)statistics.liveAllocations,
+                        (unsigned long long)(statistics.totalAllocations - previousAllocations[i].totalAllocations),
+                        (statistics.totalBytes - previousAllocations[i].totalBytes) / 1024.0);
+                    previousAllocations[i] = statistics;
+                }
+
+                if (++allocationSnapshots % 30 == 0) {
+                    AllocationTracker::Site sites[5];
+                    const int siteCount = AllocationTracker::GetTopSites(sites, 5);
+                    for (int i = 0; i < siteCount; ++i) {
+                        ATG_ENGINE_SIM_TRACE(
+                            Mainloop, Event,
+                            "allocation_site rank=%d tag=%s sampled_live_kb=%.1f sampled_live_allocations=%llu frames=%s",
+                            i,
+                            AllocationTracker::GetTagName(sites[i].tag),
+                            sites[i].liveBytes / 1024.0,
+                            (unsigned long long)sites[i].liveAllocations,
+                            AllocationTracker::DescribeSite(sites[i]).c_str());
+                    }
+                }
+            }
             nextMemorySnapshot = frameCpuEnd + std::chrono::seconds(1);
         }
+
+        const auto idleTime =
+            m_renderScheduler.getIdleTime(frameCpuStart, std::chrono::steady_clock::now());
+        if (idleTime > std::chrono::steady_clock::duration::zero()) {
+            std::this_thread::sleep_for(idleTime);
+        }
     }
 
     if (isRecording()) {
@@ -1052,114 +1616,624 @@ void EngineSimApplication::run() {
     }
 
     m_simulator->endAudioRenderingThread();
-    DebugTrace::Log("app", "run() end");
+    if (m_retiring.simulator != nullptr) {
+        m_retiring.simulator->endAudioRenderingThread();
+    }
+
+    ATG_ENGINE_SIM_TRACE(App, Event, "run() end");
 }
 
 void EngineSimApplication::destroy() {
-    DebugTrace::Log("app", "destroy() begin");
+    ATG_ENGINE_SIM_TRACE(App, Event, "destroy() begin");
+    writeProfileTrace();
+    StepProfiler::StopCapture();
+
     m_shaderSet.Destroy();
 
+    m_drawBatcher.destroy();
+    m_partInstancer.destroy();
+    m_parallelGeometry.destroy();
+    m_textLayoutCache.destroy();
     m_engine.GetDevice()->DestroyGPUBuffer(m_geometryVertexBuffer);
     m_engine.GetDevice()->DestroyGPUBuffer(m_geometryIndexBuffer);
+    m_geometryGenerator.destroy();
 
     m_assetManager.Destroy();
     m_engine.Destroy();
 
-    m_simulator->destroy();
-    m_audioBuffer.destroy();
-    DebugTrace::Log("app", "destroy() complete");
-}
-
-void EngineSimApplication::loadEngine(
-    Engine *engine,
-    Vehicle *vehicle,
-    Transmission *transmission)
-{
-    destroyObjects();
+    m_physicsThread.destroy();
 
-    if (m_simulator != nullptr) {
-        m_simulator->releaseSimulation();
-        delete m_simulator;
+    const SpeculativeLookahead::Statistics &lookahead = m_lookahead.getStatistics();
+    if (lookahead.forks > 0) {
+        startupLog(
+            "speculative_lookahead forks=%llu engaged=%llu missed=%llu failed=%llu",
+            lookahead.forks,
+            lookahead.engaged,
+            lookahead.missed,
+            lookahead.failed);
     }
 
-    if (m_vehicle != nullptr) {
-        delete m_vehicle;
-        m_vehicle = nullptr;
-    }
+    releaseLookaheadBranches();
+    m_lookahead.destroy();
+    m_branchLoader.destroy();
 
-    if (m_transmission != nullptr) {
-        delete m_transmission;
-        m_transmission = nullptr;
+    if (m_latencyProbe.getCompletedCount() > 0) {
+        for (int i = 0; i < LatencyProbe::StageCount; ++i) {
+            const LatencyProbe::Stage stage = static_cast<LatencyProbe::Stage>(i);
+            const LatencyProbe::Statistics statistics = m_latencyProbe.getStatistics(stage);
+            startupLog(
+                "latency_probe stage=%s count=%d p50_ms=%.2f p99_ms=%.2f max_ms=%.2f",
+                (stage == LatencyProbe::Stage::Input) ? "total" : LatencyProbe::GetStageName(stage),
+                statistics.count,
+                statistics.p50,
+                statistics.p99,
+                statistics.max);
+        }
     }
 
-    if (m_iceEngine != nullptr) {
-        m_iceEngine->destroy();
-        delete m_iceEngine;
+    if (m_simulator->getInputSession() != nullptr) {
+        const unsigned long long steps = m_simulator->getSessionStep();
+        m_simulator->setInputSession(nullptr);
+        m_inputSession.close(steps);
     }
 
-    m_iceEngine = engine;
-    m_vehicle = vehicle;
-    m_transmission = transmission;
+    m_simulator->setFlightRecorder(nullptr);
+    m_simulator->setControlSource(nullptr);
+    m_controlSurface.destroy();
+    m_simulator->destroy();
+    EngineLoader::Release(&m_retiring);
+    m_engineLoader.destroy();
 
-    if (engine == nullptr || vehicle == nullptr || transmission == nullptr) {
-        m_simulator = nullptr;
-        m_iceEngine = nullptr;
-        m_viewParameters.Layer1 = 0;
+    if (m_hasPreloaded) m_catalogLoader.retire(m_preloaded);
+    m_hasPreloaded = false;
+    m_catalogLoader.destroy();
+    m_engineCatalog.destroy();
+    m_scriptWatcher.destroy();
 
-        return;
+    m_telemetryExport.close();
+    m_flightRecorder.destroy();
+
+    ThreadPolicy::SetAudioWorkgroup(nullptr);
+#if defined(__APPLE__)
+    if (m_audioWorkgroup != nullptr) {
+        os_release(m_audioWorkgroup);
+        m_audioWorkgroup = nullptr;
     }
+#endif
 
-    m_simulator = engine->createSimulator(vehicle, transmission);
+    // The device's buffer and source went with the engine
+    m_outputAudioBuffer = nullptr;
+    m_audioSource = nullptr;
+    destroyAudioOutput();
+    ATG_ENGINE_SIM_TRACE(App, Event, "destroy() complete");
+}
 
-    createObjects(engine);
+void EngineSimApplication::initializeAudioOutput() {
+    m_audioBuffer.initialize(m_audioSampleRate, m_audioSampleRate);
+    m_audioBuffer.m_writePointer = (int)(m_audioSampleRate * outputLeadTime());
+    m_audioOutput = new float[m_audioSampleRate];
+    m_retiringAudioOutput = new float[m_audioSampleRate];
 
-    const int reportedMaxDepth = engine->getMaxDepth();
-    m_viewParameters.Layer1 = std::max(reportedMaxDepth, 0);
-    if (reportedMaxDepth != m_viewParameters.Layer1) {
-        DebugTrace::Log(
-            "simulator",
-            "warning: engine max depth clamped reported=%d clamped=%d",
-            reportedMaxDepth,
-            m_viewParameters.Layer1);
-    }
-    engine->calculateDisplacement();
+    ysAudioParameters params;
+    params.m_bitsPerSample = 16;
+    params.m_channelCount = 1;
+    params.m_sampleRate = m_audioSampleRate;
+    m_outputAudioBuffer =
+        m_engine.GetAudioDevice()->CreateBuffer(&params, m_audioSampleRate);
 
-    m_simulator->setSimulationFrequency(engine->getSimulationFrequency());
+    m_audioSource = m_engine.GetAudioDevice()->CreateSource(m_outputAudioBuffer);
+    m_audioSource->SetMode((m_simulator != nullptr && m_simulator->getEngine() != nullptr)
+        ? ysAudioSource::Mode::Loop
+        : ysAudioSource::Mode::Stop);
+    m_audioSource->SetPan(0.0f);
+    m_audioSource->SetVolume(1.0f);
+    ATG_ENGINE_SIM_TRACE(Audio, Event, "audio source initialized sample_rate=%d", m_audioSampleRate);
+}
 
-    Synthesizer::AudioParameters audioParams = m_simulator->synthesizer().getAudioParameters();
-    audioParams.inputSampleNoise = static_cast<float>(engine->getInitialJitter());
-    audioParams.airNoise = static_cast<float>(engine->getInitialNoise());
-    audioParams.dF_F_mix = static_cast<float>(engine->getInitialHighFrequencyGain());
-    m_simulator->synthesizer().setAudioParameters(audioParams);
+void EngineSimApplication::destroyAudioOutput() {
+    if (m_audioSource != nullptr) m_engine.GetAudioDevice()->DestroyAudioSource(m_audioSource);
+    if (m_outputAudioBuffer != nullptr) m_engine.GetAudioDevice()->DestroyAudioBuffer(m_outputAudioBuffer);
 
-    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
-        ImpulseResponse *response = engine->getExhaustSystem(i)->getImpulseResponse();
+    m_audioBuffer.destroy();
+    delete[] m_audioOutput;
+    delete[] m_retiringAudioOutput;
+    m_audioSource = nullptr;
+    m_outputAudioBuffer = nullptr;
+    m_audioOutput = nullptr;
+    m_retiringAudioOutput = nullptr;
+}
 
-#if defined(_WIN32)
-        ysWindowsAudioWaveFile waveFile;
-        waveFile.OpenFile(response->getFilename().c_str());
-        waveFile.InitializeInternalBuffer(waveFile.GetSampleCount());
-        waveFile.FillBuffer(0);
-        waveFile.CloseFile();
+void EngineSimApplication::reconfigureAudioSampleRate(int sampleRate) {
+    ATG_ENGINE_SIM_TRACE(
+        Audio, Event,
+        "audio_device_reconfigured old_sample_rate=%d new_sample_rate=%d",
+        m_audioSampleRate,
+        sampleRate);
 
-        m_simulator->synthesizer().initializeImpulseResponse(
-            reinterpret_cast<const int16_t *>(waveFile.GetBuffer()),
-            waveFile.GetSampleCount(),
-            response->getVolume(),
-            i
-        );
+    // A capture can't change rate partway through its audio file
+    if (isRecording()) {
+        stopRecording();
+    }
 
-        waveFile.DestroyInternalBuffer();
-#else
-        (void)response;
-        (void)i;
-#endif
+    // Its output is at the old rate; cut the crossfade short
+    if (m_retiring.simulator != nullptr) {
+        m_engineLoader.retire(m_retiring);
+        m_retiring = EngineLoader::Result();
     }
 
-    m_simulator->startAudioRenderingThread();
-}
+    destroyAudioOutput();
+    m_audioSampleRate = sampleRate;
 
-void EngineSimApplication::drawGenerated(
+    if (m_simulator != nullptr && m_simulator->getEngine() != nullptr) {
+        // The physics thread writes into the synthesizer between frames
+        std::unique_lock<std::mutex> physicsLock;
+        if (m_physicsThread.isRunning()) {
+            physicsLock = std::unique_lock<std::mutex>(m_physicsThread.getStateLock());
+        }
+
+        m_simulator->endAudioRenderingThread();
+        m_simulator->setAudioSampleRate(sampleRate);
+        EngineLoader::LoadImpulseResponses(m_simulator, m_iceEngine);
+        m_simulator->startAudioRenderingThread();
+    }
+
+    initializeAudioOutput();
+    m_oscillatorSampleOffset = 0;
+
+    // Branch audio has to be at the new rate too
+    requestLookaheadBranches();
+}
+
+void EngineSimApplication::loadEngine(
+    Engine *engine,
+    Vehicle *vehicle,
+    Transmission *transmission)
+{
+    EngineLoader::Result result;
+    result.engine = engine;
+    result.vehicle = vehicle;
+    result.transmission = transmission;
+
+    if (engine != nullptr && vehicle != nullptr && transmission != nullptr) {
+        result.simulator = EngineLoader::CreateSimulator(
+            engine, vehicle, transmission, m_applicationSettings);
+    }
+
+    installEngine(result);
+}
+
+void EngineSimApplication::installEngine(const EngineLoader::Result &result) {
+    if (result.patch) {
+        if (patchEngine(result)) return;
+
+        // The running engine changed since the request was made
+        EngineLoader::Result rebuilt = result;
+        rebuilt.patch = false;
+        rebuilt.simulator = EngineLoader::CreateSimulator(
+            rebuilt.engine,
+            rebuilt.vehicle,
+            rebuilt.transmission,
+            rebuilt.configured ? rebuilt.settings : m_applicationSettings);
+        installEngine(rebuilt);
+        return;
+    }
+
+    if (result.simulator == nullptr) {
+        ATG_ENGINE_SIM_TRACE(Script, Event, "engine load failed; keeping the current engine");
+
+        EngineLoader::Result failed = result;
+        EngineLoader::Release(&failed);
+        return;
+    }
+
+    if (result.configured) {
+        configure(result.settings);
+    }
+
+    static ApplicationSettings s_lastSettings;
+    static bool s_settingsInitialized = false;
+    if (!s_settingsInitialized) {
+        s_lastSettings = m_applicationSettings;
+        s_settingsInitialized = true;
+    }
+    else {
+        if (s_lastSettings.powerUnits != m_applicationSettings.powerUnits) {
+            ATG_ENGINE_SIM_TRACE(
+                Script, Event,
+                "script_var_diff key=powerUnits old=%s new=%s",
+                s_lastSettings.powerUnits.c_str(),
+                m_applicationSettings.powerUnits.c_str());
+        }
+        if (s_lastSettings.torqueUnits != m_applicationSettings.torqueUnits) {
+            ATG_ENGINE_SIM_TRACE(
+                Script, Event,
+                "script_var_diff key=torqueUnits old=%s new=%s",
+                s_lastSettings.torqueUnits.c_str(),
+                m_applicationSettings.torqueUnits.c_str());
+        }
+        if (s_lastSettings.startFullscreen != m_applicationSettings.startFullscreen) {
+            ATG_ENGINE_SIM_TRACE(
+                Script, Event,
+                "script_var_diff key=startFullscreen old=%d new=%d",
+                s_lastSettings.startFullscreen ? 1 : 0,
+                m_applicationSettings.startFullscreen ? 1 : 0);
+        }
+        s_lastSettings = m_applicationSettings;
+    }
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    m_loadedScriptSources = result.sources;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+    updateScriptWatch();
+
+    // The previous simulator must not be stepped once it is retiring
+    m_physicsThread.destroy();
+
+    destroyObjects();
+
+    // The previous simulator keeps playing what it already rendered while
+    // the new one fades in, then is torn down on the loader thread
+    if (m_retiring.simulator != nullptr) {
+        m_engineLoader.retire(m_retiring);
+        m_retiring = EngineLoader::Result();
+    }
+
+    if (m_simulator != nullptr) {
+        m_simulator->setTelemetryExport(nullptr);
+        m_simulator->setFlightRecorder(nullptr);
+        m_simulator->setControlSource(nullptr);
+        if (m_simulator->getInputSession() != nullptr) {
+            const unsigned long long steps = m_simulator->getSessionStep();
+            m_simulator->setInputSession(nullptr);
+            if (!m_inputSession.close(steps)) {
+                startupLog("failed to write input session '%s'", m_applicationSettings.recordInput.c_str());
+            }
+        }
+
+        m_retiring.engine = m_iceEngine;
+        m_retiring.vehicle = m_vehicle;
+        m_retiring.transmission = m_transmission;
+        m_retiring.simulator = m_simulator;
+        m_retiring.simulator->synthesizer().setLatencyProbe(nullptr);
+        m_crossfadePosition = 0;
+    }
+
+    m_iceEngine = result.engine;
+    m_vehicle = result.vehicle;
+    m_transmission = result.transmission;
+    m_simulator = result.simulator;
+
+    // Silent until there is an engine, which may only come with a later
+    // reload if the first load failed; while paused, resuming starts it
+    if (m_audioSource != nullptr && !m_paused) {
+        m_audioSource->SetMode(ysAudioSource::Mode::Loop);
+    }
+
+    createObjects(m_iceEngine);
+
+    m_simulator->setTelemetryExport(m_telemetryExport.isOpen() ? &m_telemetryExport : nullptr);
+    m_simulator->setControlSource(m_controlSurface.isRunning() ? m_controlSurface.getQueue() : nullptr);
+    m_simulator->synthesizer().setLatencyProbe(m_latencyProbe.isEnabled() ? &m_latencyProbe : nullptr);
+
+    if (DebugTrace::IsEnabled()) {
+        if (!m_flightRecorder.isInitialized()) m_flightRecorder.initialize(FlightRecorder::Parameters());
+        m_simulator->setFlightRecorder(&m_flightRecorder);
+    }
+
+    if (!m_inputSessionStarted) {
+        m_inputSessionStarted = true;
+        if (!m_applicationSettings.renderVideo.empty()) {
+#ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
+            m_offlineRender = m_applicationSettings.renderFrameRate > 0;
+#else
+            startupLog("render_video '%s' needs a build with video capture", m_applicationSettings.renderVideo.c_str());
+#endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
+        }
+
+        if (!m_applicationSettings.replayInput.empty()) {
+            if (m_inputSession.load(m_applicationSettings.replayInput)) {
+                m_simulator->setInputSession(&m_inputSession);
+            }
+            else {
+                startupLog("failed to load input session '%s'", m_applicationSettings.replayInput.c_str());
+            }
+        }
+        else if (!m_applicationSettings.recordInput.empty()) {
+            if (m_inputSession.record(
+                m_applicationSettings.recordInput,
+                m_simulator->getRandomSeed(),
+                m_simulator->getTargetSimulationFrequency()))
+            {
+                m_simulator->setInputSession(&m_inputSession);
+            }
+            else {
+                startupLog("failed to open input session '%s'", m_applicationSettings.recordInput.c_str());
+            }
+        }
+    }
+
+    // Offline renders step the physics a fixed frame at a time, with the
+    // synthesizer holding it back rather than the clock
+    if (m_offlineRender) {
+        m_simulator->setOfflineMode(true);
+    }
+    else if (m_applicationSettings.threadedPhysics) {
+        m_physicsThread.initialize(m_simulator);
+    }
+
+    const int reportedMaxDepth = m_iceEngine->getMaxDepth();
+    m_viewParameters.Layer1 = std::max(reportedMaxDepth, 0);
+    if (reportedMaxDepth != m_viewParameters.Layer1) {
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
+            "warning: engine max depth clamped reported=%d clamped=%d",
+            reportedMaxDepth,
+            m_viewParameters.Layer1);
+    }
+
+    refreshUserInterface();
+    requestLookaheadBranches();
+    ATG_ENGINE_SIM_TRACE(Script, Event, "engine installed name=%s", m_iceEngine->getName().c_str());
+
+    if (result.calibration.calibrated) {
+        m_infoCluster->setLogMessage(
+            "Calibrated to " + std::to_string(result.calibration.simulationFrequency) + " Hz, "
+            + std::to_string(result.calibration.fluidSimulationSteps) + " fluid steps"
+            + (result.calibration.sustainable ? "" : " (not sustainable)"));
+    }
+
+    if (!result.cost.sustainable) {
+        m_infoCluster->setLogMessage(
+            "Expected to fall behind real time, costliest first: " + CostEstimate::Describe(result.cost));
+    }
+}
+
+bool EngineSimApplication::patchEngine(const EngineLoader::Result &result) {
+    if (m_simulator == nullptr) return false;
+
+    EnginePatch::Statistics statistics;
+    {
+        // Patches have to land between frames
+        std::unique_lock<std::mutex> physicsLock;
+        if (m_physicsThread.isRunning()) {
+            physicsLock = std::unique_lock<std::mutex>(m_physicsThread.getStateLock());
+        }
+
+        if (!EnginePatch::Apply(
+                m_simulator,
+                result.engine,
+                result.vehicle,
+                result.transmission,
+                result.impulseResponses,
+                &statistics))
+        {
+            return false;
+        }
+
+        notifyParameterChange();
+    }
+
+    if (result.configured) {
+        configure(result.settings);
+    }
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    m_loadedScriptSources = result.sources;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+    updateScriptWatch();
+
+    // Cam shapes follow the lobe profiles
+    if (statistics.functions > 0) {
+        m_staticGeometryValid = false;
+    }
+
+    ATG_ENGINE_SIM_TRACE(
+        Script, Event,
+        "hot_reload mode=patch functions=%d ignition=%d impulse_responses=%d audio=%d",
+        statistics.functions,
+        statistics.ignition ? 1 : 0,
+        statistics.impulseResponses,
+        statistics.audio ? 1 : 0);
+
+    // Only its parameters were needed
+    m_engineLoader.retire(result);
+
+    // The branches were built from the parameters before the patch
+    requestLookaheadBranches();
+
+    return true;
+}
+
+void EngineSimApplication::notifyParameterChange() {
+    if (m_simulator == nullptr || !m_applicationSettings.previewFidelity) return;
+
+    m_lastParameterChange = std::chrono::steady_clock::now();
+    m_simulator->setFidelity(Simulator::Fidelity::Preview);
+}
+
+void EngineSimApplication::updateFidelity() {
+    if (m_simulator == nullptr || m_simulator->getFidelity() == Simulator::Fidelity::Full) return;
+
+    const auto settled = std::chrono::duration<double>(PreviewSettleTime);
+    if (!m_applicationSettings.previewFidelity
+        || std::chrono::steady_clock::now() - m_lastParameterChange >= settled)
+    {
+        m_simulator->setFidelity(Simulator::Fidelity::Full);
+    }
+}
+
+int EngineSimApplication::mixRetiringOutput(int samples, int capacity) {
+    const int retired = m_retiring.simulator->readAudioOutput(capacity, m_retiringAudioOutput);
+    const int n = std::max(samples, retired);
+
+    // The fade only advances with output from the new simulator, so the old
+    // one covers the gap until the new one has audio ready
+    for (int i = 0; i < n; ++i) {
+        const float fresh = (i < samples) ? m_audioOutput[i] : 0.0f;
+        const float old = (i < retired) ? m_retiringAudioOutput[i] : 0.0f;
+        const float t = std::min(
+            1.0f, (float)(m_crossfadePosition + std::min(i, samples)) / CrossfadeSamples);
+        m_audioOutput[i] = old + t * (fresh - old);
+    }
+
+    m_crossfadePosition += samples;
+    if (m_crossfadePosition >= CrossfadeSamples || (retired == 0 && samples > 0)) {
+        m_engineLoader.retire(m_retiring);
+        m_retiring = EngineLoader::Result();
+    }
+
+    return n;
+}
+
+void EngineSimApplication::setPaused(bool paused) {
+    if (paused == m_paused) return;
+
+    m_paused = paused;
+    m_renderScheduler.setPaused(paused);
+    m_physicsThread.setPaused(paused);
+    m_scriptWatcher.setSuspended(paused);
+
+    if (paused) {
+        fadeOutAudio();
+    }
+    else {
+        // The ring is silence ahead of the device; start writing just past
+        // it, as process() does when the lead runs away
+        m_audioStopPending = false;
+        m_audioBuffer.m_writePointer = m_audioBuffer.getBufferIndex(
+            m_audioSource->GetCurrentWritePosition(), (int)(m_audioSampleRate * 0.5 * outputLeadTime()));
+        if (m_simulator->getEngine() != nullptr) {
+            m_audioSource->SetMode(ysAudioSource::Mode::Loop);
+        }
+    }
+
+    m_infoCluster->setLogMessage(paused ? "Paused [P] to resume" : "Resumed");
+    ATG_ENGINE_SIM_TRACE(App, Event, "paused=%d auto=%d", paused ? 1 : 0, m_autoPaused ? 1 : 0);
+}
+
+void EngineSimApplication::fadeOutAudio() {
+    if (m_audioSource == nullptr || m_offlineRender) return;
+
+    // Everything after the queued lead is replaced, a short fade of the
+    // concealed continuation and then silence; the source is stopped once
+    // the fade has played, well before the device wraps back to the lead
+    constexpr double FadeTime = 0.02;
+    const SampleOffset lead =
+        m_audioBuffer.offsetDelta(m_audioSource->GetCurrentWritePosition(), m_audioBuffer.m_writePointer);
+    const int samples = m_audioSampleRate - (int)lead - 1;
+    if (samples <= 0) return;
+
+    const int fade = std::min((int)(m_audioSampleRate * FadeTime), samples);
+    const int concealed = m_simulator->synthesizer().concealOutput(fade, m_audioOutput);
+    for (int i = 0; i < concealed; ++i) {
+        m_audioOutput[i] *= 1.0f - (float)i / fade;
+    }
+
+    SampleOffset size0, size1;
+    void *data0, *data1;
+    m_audioSource->LockBufferSegment(
+        m_audioBuffer.m_writePointer, samples, &data0, &size0, &data1, &size1);
+
+    int16_t *segment0 = reinterpret_cast<int16_t *>(data0);
+    int16_t *segment1 = reinterpret_cast<int16_t *>(data1);
+    const int available0 = (segment0 != nullptr) ? (int)size0 : 0;
+    const int available1 = (segment1 != nullptr) ? (int)size1 : 0;
+    const int written = std::min(available0 + available1, samples);
+    const int faded = std::min(concealed, written);
+    const int faded0 = std::min(faded, available0);
+    m_simulator->synthesizer().quantizeOutput(m_audioOutput, segment0, faded0);
+    m_simulator->synthesizer().quantizeOutput(m_audioOutput + faded0, segment1, faded - faded0);
+    if (faded0 < available0) {
+        std::fill(segment0 + faded0, segment0 + available0, (int16_t)0);
+    }
+    if (available1 > 0) {
+        std::fill(segment1 + (faded - faded0), segment1 + available1, (int16_t)0);
+    }
+
+    m_audioSource->UnlockBufferSegments(data0, size0, data1, size1);
+    m_audioBuffer.commitBlock(written);
+
+    m_audioStopPending = true;
+    m_audioStopTime = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>((double)(lead + faded) / m_audioSampleRate + FadeTime));
+    ATG_ENGINE_SIM_TRACE(Audio, Event, "pause fade lead=%d fade=%d silence=%d", (int)lead, faded, written - faded);
+}
+
+EngineLoader::Request EngineSimApplication::createLookaheadRequest() const {
+    EngineLoader::Request request = createLoadRequest();
+    request.warmupFrames = 0;
+    request.audioThread = false;
+    request.patchable = false;
+
+    return request;
+}
+
+void EngineSimApplication::requestLookaheadBranches() {
+    releaseLookaheadBranches();
+    if (!m_applicationSettings.speculativeLookahead || m_simulator == nullptr || m_offlineRender) return;
+
+    // Branches only help when they run beside the physics, not in its place
+    if (JobSystem::Shared().getWorkerCount() == 0) {
+        startupLog("speculative_lookahead needs a spare core; turned off");
+        return;
+    }
+
+    if (!m_lookaheadBranchStale) {
+        m_branchLoader.request(createLookaheadRequest());
+    }
+}
+
+void EngineSimApplication::takeLookaheadBranch(const EngineLoader::Result &result) {
+    const bool stale = m_lookaheadBranchStale;
+    m_lookaheadBranchStale = false;
+
+    if (stale || result.simulator == nullptr) {
+        m_branchLoader.retire(result);
+        if (!stale) {
+            startupLog("speculative_lookahead branch failed to load; turned off");
+            return;
+        }
+
+        if (!m_applicationSettings.speculativeLookahead) return;
+    }
+    else {
+        m_lookaheadBranches[m_lookaheadBranchCount++] = result;
+    }
+
+    if (m_lookaheadBranchCount < SpeculativeLookahead::FutureCount) {
+        m_branchLoader.request(createLookaheadRequest());
+        return;
+    }
+
+    PistonEngineSimulator *branches[SpeculativeLookahead::FutureCount];
+    for (int i = 0; i < SpeculativeLookahead::FutureCount; ++i) {
+        branches[i] = dynamic_cast<PistonEngineSimulator *>(m_lookaheadBranches[i].simulator);
+    }
+
+    m_lookahead.setBranches(branches);
+    ATG_ENGINE_SIM_TRACE(App, Event, "speculative_lookahead ready=%d", m_lookahead.hasBranches() ? 1 : 0);
+}
+
+void EngineSimApplication::releaseLookaheadBranches() {
+    m_lookahead.setBranches(nullptr);
+    for (int i = 0; i < m_lookaheadBranchCount; ++i) {
+        m_branchLoader.retire(m_lookaheadBranches[i]);
+        m_lookaheadBranches[i] = EngineLoader::Result();
+    }
+
+    m_lookaheadBranchCount = 0;
+
+    // Built for the engine being replaced
+    EngineLoader::Result ready;
+    if (m_branchLoader.takeResult(&ready)) {
+        m_branchLoader.retire(ready);
+    }
+
+    m_lookaheadBranchStale = m_branchLoader.isLoading();
+}
+
+void EngineSimApplication::drawGenerated(
     const GeometryGenerator::GeometryIndices &indices,
     int layer)
 {
@@ -1178,6 +2252,19 @@ void EngineSimApplication::drawGenerated(
     int layer,
     dbasic::StageEnableFlags flags)
 {
+    // Shapes generated after the arena grew this frame are past the end of
+    // the GPU buffers until the next frame resizes them
+    if (indices.BaseVertex + indices.VertexCount > m_geometryVertexCapacity ||
+        indices.BaseIndex + indices.FaceCount * 3 > m_geometryIndexCapacity)
+    {
+        return;
+    }
+
+    if (flags == m_shaders.GetUiFlags()) {
+        m_drawBatcher.draw(indices, m_geometryGenerator.getIndexData(), layer, flags);
+        return;
+    }
+
     m_engine.DrawGeneric(
         flags,
         m_geometryIndexBuffer,
@@ -1190,8 +2277,88 @@ void EngineSimApplication::drawGenerated(
         layer);
 }
 
+void EngineSimApplication::flushDraws() {
+    m_drawBatcher.flush();
+}
+
+double EngineSimApplication::outputLeadTime() const {
+    // The device buffer is one second long; keep the lead well inside it
+    const LatencyProfile profile = (m_simulator != nullptr)
+        ? m_simulator->getLatencyProfile()
+        : LatencyProfile::fromSettings(
+            m_applicationSettings.latencyProfile,
+            m_applicationSettings.audioLatency,
+            44100,
+            m_applicationSettings.reducedAudioMemory);
+
+    return clamp(profile.outputLeadTime, 0.005, 0.15);
+}
+
 void EngineSimApplication::configure(const ApplicationSettings &settings) {
     m_applicationSettings = settings;
+    m_parallelGeometry.setEnabled(settings.parallelGeometry);
+
+    m_latencyProbe.setEnabled(settings.latencyProbe);
+    if (m_simulator != nullptr) {
+        m_simulator->synthesizer().setLatencyProbe(settings.latencyProbe ? &m_latencyProbe : nullptr);
+    }
+
+    // Reopened only when the name or decimation changes so readers keep
+    // their mapping across reloads; the simulator picks it up on install
+    if (settings.telemetryExport != m_telemetryExportName
+        || settings.telemetryDecimation != m_telemetryExportDecimation)
+    {
+        std::unique_lock<std::mutex> physicsLock;
+        if (m_physicsThread.isRunning()) {
+            physicsLock = std::unique_lock<std::mutex>(m_physicsThread.getStateLock());
+        }
+
+        if (m_simulator != nullptr) m_simulator->setTelemetryExport(nullptr);
+        m_telemetryExport.close();
+
+        m_telemetryExportName = settings.telemetryExport;
+        m_telemetryExportDecimation = settings.telemetryDecimation;
+        if (!m_telemetryExportName.empty()
+            && !m_telemetryExport.open(
+                m_telemetryExportName,
+                TelemetryExport::DefaultCapacity,
+                m_telemetryExportDecimation))
+        {
+            startupLog("failed to open telemetry export '%s'", m_telemetryExportName.c_str());
+        }
+        else if (m_simulator != nullptr) {
+            m_simulator->setTelemetryExport(&m_telemetryExport);
+        }
+    }
+
+    if (settings.controlSurfaceMidi != m_controlSurfaceMidi
+        || settings.controlSurfaceOscPort != m_controlSurfaceOscPort)
+    {
+        std::unique_lock<std::mutex> physicsLock;
+        if (m_physicsThread.isRunning()) {
+            physicsLock = std::unique_lock<std::mutex>(m_physicsThread.getStateLock());
+        }
+
+        if (m_simulator != nullptr) m_simulator->setControlSource(nullptr);
+        m_controlSurface.destroy();
+
+        m_controlSurfaceMidi = settings.controlSurfaceMidi;
+        m_controlSurfaceOscPort = settings.controlSurfaceOscPort;
+        if (!m_controlSurfaceMidi.empty() || m_controlSurfaceOscPort >= 0) {
+            ControlSurface::Parameters params;
+            params.midiDevice = m_controlSurfaceMidi;
+            params.oscPort = m_controlSurfaceOscPort;
+            if (!m_controlSurface.initialize(params)) {
+                startupLog(
+                    "failed to open control surface midi='%s' osc_port=%d",
+                    m_controlSurfaceMidi.c_str(),
+                    m_controlSurfaceOscPort);
+            }
+            else if (m_simulator != nullptr) {
+                m_simulator->setControlSource(m_controlSurface.getQueue());
+            }
+        }
+    }
 
     startupLog(
         "theme settings bg=%06X fg=%06X shadow=%06X h1=%06X h2=%06X pink=%06X red=%06X orange=%06X yellow=%06X blue=%06X green=%06X",
@@ -1271,6 +2438,7 @@ void EngineSimApplication::destroyObjects() {
     }
 
     m_objects.clear();
+    m_staticGeometryValid = false;
 }
 
 const SimulationObject::ViewParameters &
@@ -1279,113 +2447,151 @@ const SimulationObject::ViewParameters &
     return m_viewParameters;
 }
 
-void EngineSimApplication::loadScript() {
-    DebugTrace::Log("script", "loadScript begin");
-    Engine *engine = nullptr;
-    Vehicle *vehicle = nullptr;
-    Transmission *transmission = nullptr;
+EngineLoader::Request EngineSimApplication::createLoadRequest() const {
+    EngineLoader::Request request;
+    request.assetPath = m_assetPath;
+    request.scriptPath = m_scriptPath;
+    request.settings = m_applicationSettings;
+    request.audioSampleRate = m_audioSampleRate;
+
+    if (m_simulator != nullptr) {
+        request.patchable = EngineSnapshot::hashStructure(
+            m_iceEngine, m_vehicle, m_transmission, &request.structureHash);
+    }
+
+    return request;
+}
 
+void EngineSimApplication::updateScriptWatch() {
+    std::vector<std::string> files;
 #ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
-    es_script::Compiler compiler;
-    const auto compileStart = std::chrono::steady_clock::now();
-    const auto scriptIoStart = std::chrono::steady_clock::now();
-    DebugTrace::Log("script", "script_vm_call entry=compiler.initialize");
-    compiler.initialize();
-    const std::string scriptPath = m_assetPath + "/assets/main.mr";
-    const std::string assetScriptLibraryPath = (std::filesystem::path(m_assetPath) / "es").string();
-    compiler.addSearchPath(assetScriptLibraryPath.c_str());
-    DebugTrace::Log("script", "added script search path=%s", assetScriptLibraryPath.c_str());
-    DebugTrace::Log("script", "active script path=%s", scriptPath.c_str());
-    DebugTrace::Log("script", "script_vm_call entry=compiler.compile");
-    const bool compiled = compiler.compile(scriptPath.c_str());
-    DebugTrace::Log("script", "script_vm_call exit=compiler.compile success=%d", compiled ? 1 : 0);
-    const auto scriptIoEnd = std::chrono::steady_clock::now();
-    DebugTrace::Log(
-        "script",
-        "asset_io_latency operation=load_script path=%s elapsed_ms=%.3f",
-        scriptPath.c_str(),
-        std::chrono::duration_cast<std::chrono::microseconds>(scriptIoEnd - scriptIoStart).count() / 1000.0);
-    if (compiled) {
-        DebugTrace::Log("script", "script_vm_call entry=compiler.execute");
-        const es_script::Compiler::Output output = compiler.execute();
-        DebugTrace::Log("script", "script_vm_call exit=compiler.execute");
-        configure(output.applicationSettings);
-
-        engine = output.engine;
-        vehicle = output.vehicle;
-        transmission = output.transmission;
+    for (const es_script::ScriptSources::File &file : m_loadedScriptSources.getFiles()) {
+        files.push_back(file.path);
     }
-    else {
-        engine = nullptr;
-        vehicle = nullptr;
-        transmission = nullptr;
-    }
-
-    DebugTrace::Log("script", "script_vm_call entry=compiler.destroy");
-    compiler.destroy();
-    DebugTrace::Log("script", "script_vm_call exit=compiler.destroy");
-    const auto compileEnd = std::chrono::steady_clock::now();
-    DebugTrace::Log(
-        "script",
-        "subsystem_duration script_compile_execute_us=%lld",
-        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(compileEnd - compileStart).count()));
 #endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
 
-    if (vehicle == nullptr) {
-        Vehicle::Parameters vehParams;
-        vehParams.mass = units::mass(1597, units::kg);
-        vehParams.diffRatio = 3.42;
-        vehParams.tireRadius = units::distance(10, units::inch);
-        vehParams.dragCoefficient = 0.25;
-        vehParams.crossSectionArea = units::distance(6.0, units::foot) * units::distance(6.0, units::foot);
-        vehParams.rollingResistance = 2000.0;
-        vehicle = new Vehicle;
-        vehicle->initialize(vehParams);
-    }
-
-    if (transmission == nullptr) {
-        const double gearRatios[] = { 2.97, 2.07, 1.43, 1.00, 0.84, 0.56 };
-        Transmission::Parameters tParams;
-        tParams.GearCount = 6;
-        tParams.GearRatios = gearRatios;
-        tParams.MaxClutchTorque = units::torque(1000.0, units::ft_lb);
-        transmission = new Transmission;
-        transmission->initialize(tParams);
-    }
-
-    loadEngine(engine, vehicle, transmission);
-    refreshUserInterface();
-    static ApplicationSettings s_lastSettings;
-    static bool s_settingsInitialized = false;
-    if (!s_settingsInitialized) {
-        s_lastSettings = m_applicationSettings;
-        s_settingsInitialized = true;
+    if (files.empty()) {
+        files.push_back(m_scriptPath);
     }
-    else {
-        if (s_lastSettings.powerUnits != m_applicationSettings.powerUnits) {
-            DebugTrace::Log(
-                "script",
-                "script_var_diff key=powerUnits old=%s new=%s",
-                s_lastSettings.powerUnits.c_str(),
-                m_applicationSettings.powerUnits.c_str());
-        }
-        if (s_lastSettings.torqueUnits != m_applicationSettings.torqueUnits) {
-            DebugTrace::Log(
-                "script",
-                "script_var_diff key=torqueUnits old=%s new=%s",
-                s_lastSettings.torqueUnits.c_str(),
-                m_applicationSettings.torqueUnits.c_str());
-        }
-        if (s_lastSettings.startFullscreen != m_applicationSettings.startFullscreen) {
-            DebugTrace::Log(
-                "script",
-                "script_var_diff key=startFullscreen old=%d new=%d",
-                s_lastSettings.startFullscreen ? 1 : 0,
-                m_applicationSettings.startFullscreen ? 1 : 0);
+
+    m_scriptWatcher.watch(files);
+}
+
+void EngineSimApplication::selectCatalogEntry(int step) {
+    const int count = m_engineCatalog.getEntryCount();
+    if (count == 0) {
+        m_infoCluster->setLogMessage("No engines in the catalog");
+        return;
+    }
+
+    m_catalogSelection = (m_catalogSelection < 0)
+        ? ((step > 0) ? 0 : count - 1)
+        : ((m_catalogSelection + step) % count + count) % count;
+
+    EngineCatalog::Entry entry;
+    m_engineCatalog.getEntry(m_catalogSelection, &entry);
+    m_infoCluster->setLogMessage(
+        "[" + std::to_string(m_catalogSelection + 1) + "/" + std::to_string(count) + "] "
+        + EngineCatalog::Describe(entry));
+    ATG_ENGINE_SIM_TRACE(
+        Script, Event,
+        "catalog selection index=%d script=%s",
+        m_catalogSelection,
+        entry.script.c_str());
+
+    if (entry.indexed && !entry.valid) return;
+
+    const std::string launcher = m_engineCatalog.writeLauncher(entry);
+    if (launcher.empty()) return;
+
+    // Built from scratch; the running engine is never patched into
+    EngineLoader::Request request = createLoadRequest();
+    request.scriptPath = launcher;
+    request.patchable = false;
+
+    m_preloadedScript = launcher;
+    m_catalogLoader.request(request);
+}
+
+void EngineSimApplication::switchToPreloaded() {
+    if (!m_hasPreloaded) {
+        m_infoCluster->setLogMessage(m_catalogLoader.isLoading()
+            ? "Engine still loading"
+            : "No engine preloaded [PGUP/PGDN] to pick one");
+        return;
+    }
+    else if (m_catalogLoader.isLoading()) {
+        // A newer selection is on its way
+        m_infoCluster->setLogMessage("Engine still loading");
+        return;
+    }
+
+    const bool loaded = m_preloaded.simulator != nullptr;
+    if (loaded) m_scriptPath = m_preloadedScript;
+
+    installEngine(m_preloaded);
+    m_preloaded = EngineLoader::Result();
+    m_hasPreloaded = false;
+}
+
+void EngineSimApplication::loadScript() {
+    ATG_ENGINE_SIM_TRACE(Script, Event, "loadScript begin");
+
+    // Normally requested when initialization began
+    EngineLoader::Result loaded;
+    {
+        StartupTimeline::Scope scope("wait_for_engine");
+        if (!m_engineLoader.waitForResult(&loaded)) {
+            m_engineLoader.request(createLoadRequest());
+            m_engineLoader.waitForResult(&loaded);
         }
-        s_lastSettings = m_applicationSettings;
     }
-    DebugTrace::Log("script", "loadScript complete");
+
+    {
+        StartupTimeline::Scope scope("install_engine");
+        installEngine(loaded);
+    }
+
+    ATG_ENGINE_SIM_TRACE(Script, Event, "loadScript complete");
+}
+
+void EngineSimApplication::writeProfileTrace() {
+    if (!StepProfiler::IsCapturing()) return;
+
+    // Restarted empty so the next dump covers only what followed
+    StepProfiler::StopCapture();
+    const std::string path =
+        (std::filesystem::path(DebugTrace::SessionDirectory()) / "profile_trace.json").string();
+    const bool written = StepProfiler::WriteChromeTrace(path);
+    ATG_ENGINE_SIM_TRACE(
+        App, Event,
+        "profile trace %s path=%s",
+        written ? "written" : "failed",
+        path.c_str());
+    StepProfiler::StartCapture(ProfileCaptureSpans);
+}
+
+void EngineSimApplication::finishStartupTimeline() {
+    // Samples handed to the device, not yet heard: the output lead time
+    // is still ahead of them
+    StartupTimeline::Mark("first_sound");
+    StartupTimeline::Stop();
+
+    int64_t firstSound = 0;
+    StartupTimeline::FindMark("first_sound", &firstSound);
+    startupLog("time to first sound %.1f ms", firstSound / 1000.0);
+    ATG_ENGINE_SIM_TRACE(App, Event, "time_to_first_sound ms=%.3f", firstSound / 1000.0);
+
+    if (DebugTrace::IsEnabled()) {
+        const std::string path =
+            (std::filesystem::path(DebugTrace::SessionDirectory()) / "startup_timeline.json").string();
+        const bool written = StartupTimeline::WriteChromeTrace(path);
+        ATG_ENGINE_SIM_TRACE(
+            App, Event,
+            "startup timeline %s path=%s",
+            written ? "written" : "failed",
+            path.c_str());
+    }
 }
 
 void EngineSimApplication::processEngineInput() {
@@ -1393,14 +2599,46 @@ void EngineSimApplication::processEngineInput() {
         return;
     }
 
-    const float dt = m_engine.GetFrameLength();
+    const float dt = getFrameLength();
     const bool fineControlMode = m_engine.IsKeyDown(ysKey::Code::Space);
 
+    // On the physics thread stamped controls keep their spacing within a
+    // frame. Stepped here, the frame that follows covers this input, so they
+    // apply from its first step. A full queue falls back to writing through,
+    // which the state lock held for this function makes safe.
+    const bool stampControls = m_physicsThread.isRunning();
+    auto pushControl = [&](ControlQueue::Control control, double value, bool probe = false) {
+        // The controls pushed every frame would override a control surface
+        // that has moved them, until their keys are used; presses of the
+        // others take theirs back at once
+        switch (control) {
+            case ControlQueue::Control::Throttle:
+            case ControlQueue::Control::Clutch:
+            case ControlQueue::Control::Starter:
+            case ControlQueue::Control::DynoSpeed:
+                if (m_controlSurface.owns(control)) return;
+                break;
+            default:
+                m_controlSurface.release(control);
+                break;
+        }
+
+        ControlQueue::Event event;
+        event.control = control;
+        event.value = value;
+        event.time = m_inputTime;
+        event.immediate = !stampControls;
+        event.probe = probe && m_latencyProbe.begin(m_inputTime);
+        if (!m_simulator->controls().push(event)) {
+            m_simulator->applyControl(event);
+        }
+    };
+
     const int mouseWheel = m_engine.GetMouseWheel();
     const int mouseWheelDelta = mouseWheel - m_lastMouseWheel;
     m_lastMouseWheel = mouseWheel;
     if (mouseWheelDelta != 0) {
-        DebugTrace::Log("input", "mouse wheel delta=%d", mouseWheelDelta);
+        ATG_ENGINE_SIM_TRACE(Input, Verbose, "mouse wheel delta=%d", mouseWheelDelta);
         ++g_mouseWheelEventsThisSecond;
     }
 
@@ -1429,8 +2667,8 @@ void EngineSimApplication::processEngineInput() {
     }};
     static std::array<bool, tracedKeys.size()> previousStates = {};
     auto logScriptWrite = [&](const char *ns, const char *key, double value, const char *source) {
-        DebugTrace::Log(
-            "script",
+        ATG_ENGINE_SIM_TRACE(
+            Script, Verbose,
             "script_var_write ns=%s key=%s value=%.6f source=%s",
             ns,
             key,
@@ -1441,12 +2679,12 @@ void EngineSimApplication::processEngineInput() {
     for (size_t i = 0; i < tracedKeys.size(); ++i) {
         const bool down = m_engine.IsKeyDown(tracedKeys[i].code);
         if (down != previousStates[i]) {
-            DebugTrace::Log("input", "key_%s %s", tracedKeys[i].name, down ? "down" : "up");
+            ATG_ENGINE_SIM_TRACE(Input, Verbose, "key_%s %s", tracedKeys[i].name, down ? "down" : "up");
             previousStates[i] = down;
             ++dispatchDepthProxy;
         }
     }
-    DebugTrace::Log("input", "input_dispatch_queue_depth_proxy=%d", dispatchDepthProxy);
+    ATG_ENGINE_SIM_TRACE(Input, Verbose, "input_dispatch_queue_depth_proxy=%d", dispatchDepthProxy);
 
     bool fineControlInUse = false;
     static auto s_nextAnalogLog = std::chrono::steady_clock::now();
@@ -1454,7 +2692,7 @@ void EngineSimApplication::processEngineInput() {
     static double s_lastLoggedClutchEffective = -1.0;
     auto logWheelBinding = [&](const char *bindingName) {
         if (mouseWheelDelta != 0) {
-            DebugTrace::Log("input", "mouse wheel routed binding=%s delta=%d", bindingName, mouseWheelDelta);
+            ATG_ENGINE_SIM_TRACE(Input, Verbose, "mouse wheel routed binding=%s delta=%d", bindingName, mouseWheelDelta);
         }
     };
     if (m_engine.IsKeyDown(ysKey::Code::Z)) {
@@ -1533,23 +2771,23 @@ void EngineSimApplication::processEngineInput() {
             : 100.0;
 
         const double newSimulationFrequency = clamp(
-            m_simulator->getSimulationFrequency() + mouseWheelDelta * rate * dt,
+            m_simulator->getTargetSimulationFrequency() + mouseWheelDelta * rate * dt,
             400.0, 400000.0);
 
-        const double previousSimulationFrequency = m_simulator->getSimulationFrequency();
+        const double previousSimulationFrequency = m_simulator->getTargetSimulationFrequency();
         m_simulator->setSimulationFrequency(newSimulationFrequency);
-        if (previousSimulationFrequency != m_simulator->getSimulationFrequency()) {
-            DebugTrace::Log(
-                "simulator",
+        if (previousSimulationFrequency != m_simulator->getTargetSimulationFrequency()) {
+            ATG_ENGINE_SIM_TRACE(
+                Simulator, Verbose,
                 "simulation_frequency changed source=wheel old=%.3f new=%.3f",
                 previousSimulationFrequency,
-                m_simulator->getSimulationFrequency());
-            logScriptWrite("sim.control", "simulation_frequency", m_simulator->getSimulationFrequency(), "mouse_wheel");
+                m_simulator->getTargetSimulationFrequency());
+            logScriptWrite("sim.control", "simulation_frequency", m_simulator->getTargetSimulationFrequency(), "mouse_wheel");
         }
         fineControlInUse = true;
         logWheelBinding("simulation_frequency");
 
-        m_infoCluster->setLogMessage("[N] - Set simulation freq to " + std::to_string(m_simulator->getSimulationFrequency()));
+        m_infoCluster->setLogMessage("[N] - Set simulation freq to " + std::to_string(m_simulator->getTargetSimulationFrequency()));
     }
     else if (m_engine.IsKeyDown(ysKey::Code::G) && m_simulator->m_dyno.m_hold) {
         if (mouseWheelDelta > 0) {
@@ -1560,6 +2798,7 @@ void EngineSimApplication::processEngineInput() {
         }
 
         m_dynoSpeed = clamp(m_dynoSpeed, m_iceEngine->getDynoMinSpeed(), m_iceEngine->getDynoMaxSpeed());
+        if (mouseWheelDelta != 0) notifyParameterChange();
 
         m_infoCluster->setLogMessage("[G] - Set dyno speed to " + std::to_string(units::toRpm(m_dynoSpeed)));
         fineControlInUse = true;
@@ -1587,8 +2826,8 @@ void EngineSimApplication::processEngineInput() {
 
     if (prevTargetThrottle != m_targetSpeedSetting) {
         m_infoCluster->setLogMessage("Speed control set to " + std::to_string(m_targetSpeedSetting));
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Verbose,
             "throttle_target changed old=%.5f new=%.5f",
             prevTargetThrottle,
             m_targetSpeedSetting);
@@ -1596,8 +2835,24 @@ void EngineSimApplication::processEngineInput() {
     }
 
     m_speedSetting = m_targetSpeedSetting * 0.5 + 0.5 * m_speedSetting;
+    if (prevTargetThrottle != m_targetSpeedSetting) {
+        m_controlSurface.release(ControlQueue::Control::Throttle);
+    }
 
-    m_iceEngine->setSpeedControl(m_speedSetting);
+    // Throttle key presses and releases are what the latency probe times
+    pushControl(
+        ControlQueue::Control::Throttle,
+        m_speedSetting,
+        prevTargetThrottle != m_targetSpeedSetting);
+
+    // The change is heard from the samples the physics writes next
+    if (prevTargetThrottle != m_targetSpeedSetting && m_lookahead.hasBranches()) {
+        Synthesizer &synthesizer = m_simulator->synthesizer();
+        m_lookahead.engage(
+            m_targetSpeedSetting,
+            synthesizer.getOutputPosition(),
+            synthesizer.getInputPosition());
+    }
     if (m_engine.ProcessKeyDown(ysKey::Code::M)) {
         const int currentLayer = getViewParameters().Layer0;
         if (currentLayer + 1 < m_iceEngine->getMaxDepth()) {
@@ -1614,47 +2869,55 @@ void EngineSimApplication::processEngineInput() {
         m_infoCluster->setLogMessage("[,] - Set render layer to " + std::to_string(getViewParameters().Layer0));
     }
 
+    // The dyno goes through the control queue like the other inputs so an
+    // input session records it; these track what was pushed
+    bool dynoEnabled = m_simulator->m_dyno.m_enabled;
+    bool dynoHold = m_simulator->m_dyno.m_hold;
+
     if (m_engine.ProcessKeyDown(ysKey::Code::D)) {
-        m_simulator->m_dyno.m_enabled = !m_simulator->m_dyno.m_enabled;
+        dynoEnabled = !dynoEnabled;
+        pushControl(ControlQueue::Control::DynoEnabled, dynoEnabled ? 1.0 : 0.0);
+        m_controlSurface.release(ControlQueue::Control::DynoSpeed);
 
-        const std::string msg = m_simulator->m_dyno.m_enabled
+        const std::string msg = dynoEnabled
             ? "DYNOMOMETER ENABLED"
             : "DYNOMOMETER DISABLED";
         m_infoCluster->setLogMessage(msg);
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
             "dyno_enabled toggled source=key_D state=%d",
-            m_simulator->m_dyno.m_enabled ? 1 : 0);
-        logScriptWrite("sim.dyno", "enabled", m_simulator->m_dyno.m_enabled ? 1.0 : 0.0, "key_D");
-        DebugTrace::Log(
-            "ui",
+            dynoEnabled ? 1 : 0);
+        logScriptWrite("sim.dyno", "enabled", dynoEnabled ? 1.0 : 0.0, "key_D");
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Event,
             "user_mode_transition dyno_panel enabled=%d hold=%d",
-            m_simulator->m_dyno.m_enabled ? 1 : 0,
-            m_simulator->m_dyno.m_hold ? 1 : 0);
+            dynoEnabled ? 1 : 0,
+            dynoHold ? 1 : 0);
     }
 
     if (m_engine.ProcessKeyDown(ysKey::Code::H)) {
-        m_simulator->m_dyno.m_hold = !m_simulator->m_dyno.m_hold;
+        dynoHold = !dynoHold;
+        pushControl(ControlQueue::Control::DynoHold, dynoHold ? 1.0 : 0.0);
 
-        const std::string msg = m_simulator->m_dyno.m_hold
-            ? m_simulator->m_dyno.m_enabled ? "HOLD ENABLED" : "HOLD ON STANDBY [ENABLE DYNO. FOR HOLD]"
+        const std::string msg = dynoHold
+            ? dynoEnabled ? "HOLD ENABLED" : "HOLD ON STANDBY [ENABLE DYNO. FOR HOLD]"
             : "HOLD DISABLED";
         m_infoCluster->setLogMessage(msg);
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
             "dyno_hold toggled source=key_H state=%d dyno_enabled=%d",
-            m_simulator->m_dyno.m_hold ? 1 : 0,
-            m_simulator->m_dyno.m_enabled ? 1 : 0);
-        logScriptWrite("sim.dyno", "hold", m_simulator->m_dyno.m_hold ? 1.0 : 0.0, "key_H");
-        DebugTrace::Log(
-            "ui",
+            dynoHold ? 1 : 0,
+            dynoEnabled ? 1 : 0);
+        logScriptWrite("sim.dyno", "hold", dynoHold ? 1.0 : 0.0, "key_H");
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Event,
             "user_mode_transition dyno_hold enabled=%d hold=%d",
-            m_simulator->m_dyno.m_enabled ? 1 : 0,
-            m_simulator->m_dyno.m_hold ? 1 : 0);
+            dynoEnabled ? 1 : 0,
+            dynoHold ? 1 : 0);
     }
 
-    if (m_simulator->m_dyno.m_enabled) {
-        if (!m_simulator->m_dyno.m_hold) {
+    if (dynoEnabled) {
+        if (!dynoHold) {
             if (m_simulator->getFilteredDynoTorque() > units::torque(1.0, units::ft_lb)) {
                 m_dynoSpeed += units::rpm(500) * dt;
             }
@@ -1663,19 +2926,19 @@ void EngineSimApplication::processEngineInput() {
             }
 
             if (m_dynoSpeed > m_iceEngine->getRedline()) {
-                m_simulator->m_dyno.m_enabled = false;
+                pushControl(ControlQueue::Control::DynoEnabled, 0.0);
                 m_dynoSpeed = units::rpm(0);
             }
         }
     }
     else {
-        if (!m_simulator->m_dyno.m_hold) {
+        if (!dynoHold) {
             m_dynoSpeed = units::rpm(0);
         }
     }
 
     m_dynoSpeed = clamp(m_dynoSpeed, m_iceEngine->getDynoMinSpeed(), m_iceEngine->getDynoMaxSpeed());
-    m_simulator->m_dyno.m_rotationSpeed = m_dynoSpeed;
+    pushControl(ControlQueue::Control::DynoSpeed, m_dynoSpeed);
     static double s_lastLoggedDynoSpeed = -1.0;
     if (s_lastLoggedDynoSpeed < 0.0 || std::abs(m_dynoSpeed - s_lastLoggedDynoSpeed) >= units::rpm(50.0)) {
         logScriptWrite("sim.dyno", "rotation_speed", m_dynoSpeed, "update");
@@ -1683,53 +2946,50 @@ void EngineSimApplication::processEngineInput() {
     }
 
     const bool prevStarterEnabled = m_simulator->m_starterMotor.m_enabled;
-    if (m_engine.IsKeyDown(ysKey::Code::S)) {
-        m_simulator->m_starterMotor.m_enabled = true;
-    }
-    else {
-        m_simulator->m_starterMotor.m_enabled = false;
-    }
+    const bool starterEnabled = m_engine.IsKeyDown(ysKey::Code::S);
+    if (starterEnabled) m_controlSurface.release(ControlQueue::Control::Starter);
+    pushControl(ControlQueue::Control::Starter, starterEnabled ? 1.0 : 0.0);
 
-    if (prevStarterEnabled != m_simulator->m_starterMotor.m_enabled) {
-        const std::string msg = m_simulator->m_starterMotor.m_enabled
+    if (prevStarterEnabled != starterEnabled) {
+        const std::string msg = starterEnabled
             ? "STARTER ENABLED"
             : "STARTER DISABLED";
         m_infoCluster->setLogMessage(msg);
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
             "starter toggled source=key_S state=%d",
-            m_simulator->m_starterMotor.m_enabled ? 1 : 0);
-        logScriptWrite("sim.ignition", "starter_enabled", m_simulator->m_starterMotor.m_enabled ? 1.0 : 0.0, "key_S");
+            starterEnabled ? 1 : 0);
+        logScriptWrite("sim.ignition", "starter_enabled", starterEnabled ? 1.0 : 0.0, "key_S");
     }
 
     if (m_engine.ProcessKeyDown(ysKey::Code::A)) {
-        m_simulator->getEngine()->getIgnitionModule()->m_enabled =
-            !m_simulator->getEngine()->getIgnitionModule()->m_enabled;
+        const bool ignitionEnabled = !m_simulator->getEngine()->getIgnitionModule()->m_enabled;
+        pushControl(ControlQueue::Control::Ignition, ignitionEnabled ? 1.0 : 0.0);
 
-        const std::string msg = m_simulator->getEngine()->getIgnitionModule()->m_enabled
+        const std::string msg = ignitionEnabled
             ? "IGNITION ENABLED"
             : "IGNITION DISABLED";
         m_infoCluster->setLogMessage(msg);
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
             "ignition toggled source=key_A state=%d",
-            m_simulator->getEngine()->getIgnitionModule()->m_enabled ? 1 : 0);
+            ignitionEnabled ? 1 : 0);
         logScriptWrite(
             "sim.ignition",
             "ignition_enabled",
-            m_simulator->getEngine()->getIgnitionModule()->m_enabled ? 1.0 : 0.0,
+            ignitionEnabled ? 1.0 : 0.0,
             "key_A");
     }
 
     if (m_engine.ProcessKeyDown(ysKey::Code::Up)) {
         const int oldGear = m_simulator->getTransmission()->getGear();
-        m_simulator->getTransmission()->changeGear(oldGear + 1);
-        const int newGear = m_simulator->getTransmission()->getGear();
+        const int newGear = std::min(oldGear + 1, m_simulator->getTransmission()->getGearCount() - 1);
+        pushControl(ControlQueue::Control::Gear, newGear);
 
         m_infoCluster->setLogMessage(
-            "UPSHIFTED TO " + std::to_string(m_simulator->getTransmission()->getGear() + 1));
-        DebugTrace::Log(
-            "simulator",
+            "UPSHIFTED TO " + std::to_string(newGear + 1));
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
             "gear_changed source=key_Up old=%d new=%d",
             oldGear,
             newGear);
@@ -1737,24 +2997,31 @@ void EngineSimApplication::processEngineInput() {
     }
     else if (m_engine.ProcessKeyDown(ysKey::Code::Down)) {
         const int oldGear = m_simulator->getTransmission()->getGear();
-        m_simulator->getTransmission()->changeGear(oldGear - 1);
-        const int newGear = m_simulator->getTransmission()->getGear();
+        const int newGear = std::max(oldGear - 1, -1);
+        pushControl(ControlQueue::Control::Gear, newGear);
 
-        if (m_simulator->getTransmission()->getGear() != -1) {
+        if (newGear != -1) {
             m_infoCluster->setLogMessage(
-                "DOWNSHIFTED TO " + std::to_string(m_simulator->getTransmission()->getGear() + 1));
+                "DOWNSHIFTED TO " + std::to_string(newGear + 1));
         }
         else {
             m_infoCluster->setLogMessage("SHIFTED TO NEUTRAL");
         }
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Event,
             "gear_changed source=key_Down old=%d new=%d",
             oldGear,
             newGear);
         logScriptWrite("sim.transmission", "gear_index", static_cast<double>(newGear), "key_Down");
     }
 
+    if (m_engine.IsKeyDown(ysKey::Code::T)
+        || m_engine.IsKeyDown(ysKey::Code::U)
+        || m_engine.IsKeyDown(ysKey::Code::Shift))
+    {
+        m_controlSurface.release(ControlQueue::Control::Clutch);
+    }
+
     if (m_engine.IsKeyDown(ysKey::Code::T)) {
         m_targetClutchPressure -= 0.2 * dt;
     }
@@ -1778,7 +3045,7 @@ void EngineSimApplication::processEngineInput() {
 
     const double clutch_s = dt / (dt + clutchRC);
     m_clutchPressure = m_clutchPressure * (1 - clutch_s) + m_targetClutchPressure * clutch_s;
-    m_simulator->getTransmission()->setClutchPressure(m_clutchPressure);
+    pushControl(ControlQueue::Control::Clutch, m_clutchPressure);
 
     const auto now = std::chrono::steady_clock::now();
     const bool throttleMoved = (s_lastLoggedThrottleEffective < 0.0)
@@ -1786,8 +3053,8 @@ void EngineSimApplication::processEngineInput() {
     const bool clutchMoved = (s_lastLoggedClutchEffective < 0.0)
         || std::abs(m_clutchPressure - s_lastLoggedClutchEffective) >= 0.01;
     if ((throttleMoved || clutchMoved) && now >= s_nextAnalogLog) {
-        DebugTrace::Log(
-            "simulator",
+        ATG_ENGINE_SIM_TRACE(
+            Simulator, Verbose,
             "controls effective throttle=%.5f clutch=%.5f throttle_target=%.5f clutch_target=%.5f",
             m_speedSetting,
             m_clutchPressure,
@@ -1802,35 +3069,7 @@ void EngineSimApplication::processEngineInput() {
 
 }
 
-void EngineSimApplication::renderScene() {
-    const auto layoutStart = std::chrono::steady_clock::now();
-    DebugTrace::Log("ui", "layout recompute begin screen=%d", m_screen);
-    getShaders()->ResetBaseColor();
-    getShaders()->SetObjectTransform(ysMath::LoadIdentity());
-
-    m_textRenderer.SetColor(ysColor::linearToSrgb(m_foreground));
-    m_shaders.SetClearColor(m_shadow);
-
-    const int screenWidth = m_engine.GetGameWindow()->GetGameWidth();
-    const int screenHeight = m_engine.GetGameWindow()->GetGameHeight();
-    const float aspectRatio = screenWidth / (float)screenHeight;
-
-    const Point cameraPos = m_engineView->getCameraPosition();
-    static Point s_lastCameraPos = { 0.0f, 0.0f };
-    static bool s_cameraInitialized = false;
-    if (!s_cameraInitialized || cameraPos.x != s_lastCameraPos.x || cameraPos.y != s_lastCameraPos.y) {
-        DebugTrace::Log(
-            "ui",
-            "camera transform update x=%.3f y=%.3f",
-            cameraPos.x,
-            cameraPos.y);
-        s_lastCameraPos = cameraPos;
-        s_cameraInitialized = true;
-    }
-    m_shaders.m_cameraPosition = ysMath::LoadVector(cameraPos.x, cameraPos.y);
-
-    m_shaders.CalculateUiCamera(screenWidth, screenHeight);
-
+void EngineSimApplication::layoutUserInterface(int screenWidth, int screenHeight) {
     if (m_screen == 0) {
         Bounds windowBounds((float)screenWidth, (float)screenHeight, { 0, (float)screenHeight });
         Grid grid;
@@ -1861,15 +3100,12 @@ void EngineSimApplication::renderScene() {
         m_loadSimulationCluster->setVisible(true);
         m_mixerCluster->setVisible(true);
         m_infoCluster->setVisible(true);
-
-        m_oscCluster->activate();
     }
     else if (m_screen == 1) {
         Bounds windowBounds((float)screenWidth, (float)screenHeight, { 0, (float)screenHeight });
         m_engineView->setDrawFrame(false);
         m_engineView->setBounds(windowBounds);
         m_engineView->setLocalPosition({ 0, 0 });
-        m_engineView->activate();
 
         m_engineView->setVisible(true);
         m_rightGaugeCluster->setVisible(false);
@@ -1887,7 +3123,6 @@ void EngineSimApplication::renderScene() {
         m_engineView->setDrawFrame(true);
         m_engineView->setBounds(grid.get(windowBounds, 0, 0, 2, 1));
         m_engineView->setLocalPosition({ 0, 0 });
-        m_engineView->activate();
 
         m_rightGaugeCluster->m_bounds = grid.get(windowBounds, 2, 0, 1, 1);
 
@@ -1900,14 +3135,14 @@ void EngineSimApplication::renderScene() {
         m_infoCluster->setVisible(false);
     }
 
-    static int s_lastScreen = -1;
-    if (s_lastScreen != m_screen) {
-        DebugTrace::Log("ui", "user_mode_transition screen old=%d new=%d", s_lastScreen, m_screen);
-        s_lastScreen = m_screen;
-    }
+    // Over the top left of the engine view on every screen
+    m_performanceHud->m_bounds = Bounds(
+        std::min(460.0f, m_engineView->m_bounds.width() - 20.0f),
+        190.0f,
+        m_engineView->m_bounds.getPosition(Bounds::tl) + Point(10.0f, -10.0f),
+        Bounds::tl);
+    m_performanceHud->setVisible(m_showPerformanceHud);
 
-    const float cameraAspectRatio =
-        m_engineView->m_bounds.width() / m_engineView->m_bounds.height();
     m_engine.GetDevice()->ResizeRenderTarget(
         m_mainRenderTarget,
         m_engineView->m_bounds.width(),
@@ -1920,6 +3155,65 @@ void EngineSimApplication::renderScene() {
         m_engineView->m_bounds.getPosition(Bounds::tl).x,
         screenHeight - m_engineView->m_bounds.getPosition(Bounds::tl).y
     );
+}
+
+void EngineSimApplication::renderScene() {
+    const auto layoutStart = std::chrono::steady_clock::now();
+    ATG_ENGINE_SIM_TRACE(Ui, Verbose, "scene render begin screen=%d", m_screen);
+    getShaders()->ResetBaseColor();
+    getShaders()->SetObjectTransform(ysMath::LoadIdentity());
+
+    m_textRenderer.SetColor(ysColor::linearToSrgb(m_foreground));
+    m_textLayoutCache.beginFrame();
+    m_shaders.SetClearColor(m_shadow);
+
+    const int screenWidth = m_engine.GetGameWindow()->GetGameWidth();
+    const int screenHeight = m_engine.GetGameWindow()->GetGameHeight();
+    const float aspectRatio = screenWidth / (float)screenHeight;
+
+    const Point cameraPos = m_engineView->getCameraPosition();
+    static Point s_lastCameraPos = { 0.0f, 0.0f };
+    static bool s_cameraInitialized = false;
+    if (!s_cameraInitialized || cameraPos.x != s_lastCameraPos.x || cameraPos.y != s_lastCameraPos.y) {
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Verbose,
+            "camera transform update x=%.3f y=%.3f",
+            cameraPos.x,
+            cameraPos.y);
+        s_lastCameraPos = cameraPos;
+        s_cameraInitialized = true;
+    }
+    m_shaders.m_cameraPosition = ysMath::LoadVector(cameraPos.x, cameraPos.y);
+
+    m_shaders.CalculateUiCamera(screenWidth, screenHeight);
+
+    if (screenWidth != m_layoutWidth
+        || screenHeight != m_layoutHeight
+        || m_screen != m_layoutScreen)
+    {
+        ATG_ENGINE_SIM_TRACE(Ui, Verbose, "layout recompute screen=%d", m_screen);
+        layoutUserInterface(screenWidth, screenHeight);
+
+        m_layoutWidth = screenWidth;
+        m_layoutHeight = screenHeight;
+        m_layoutScreen = m_screen;
+    }
+
+    if (m_screen == 0) {
+        m_oscCluster->activate();
+    }
+    else {
+        m_engineView->activate();
+    }
+
+    static int s_lastScreen = -1;
+    if (s_lastScreen != m_screen) {
+        ATG_ENGINE_SIM_TRACE(Ui, Event, "user_mode_transition screen old=%d new=%d", s_lastScreen, m_screen);
+        s_lastScreen = m_screen;
+    }
+
+    const float cameraAspectRatio =
+        m_engineView->m_bounds.width() / m_engineView->m_bounds.height();
     m_shaders.CalculateCamera(
         cameraAspectRatio * m_displayHeight / m_engineView->m_zoom,
         m_displayHeight / m_engineView->m_zoom,
@@ -1928,37 +3222,69 @@ void EngineSimApplication::renderScene() {
         m_screenHeight,
         m_displayAngle);
 
+    // Static part shapes are regenerated and uploaded only when the engine
+    // or the zoom changes; after that only per-frame shapes are sent
+    const bool staticGeometryChanged = updateStaticGeometry();
+    const bool geometryBuffersResized = resizeGeometryBuffers();
+
     m_geometryGenerator.reset();
+    m_drawBatcher.beginFrame();
 
     render();
 
+    m_drawBatcher.flush();
+    m_drawBatcher.upload();
+
+    const bool fullUpload = staticGeometryChanged || geometryBuffersResized;
+    const int firstVertex = fullUpload ? 0 : m_geometryGenerator.getRetainedVertexCount();
+    const int firstIndex = fullUpload ? 0 : m_geometryGenerator.getRetainedIndexCount();
+    const int vertexCount =
+        std::min(m_geometryGenerator.getCurrentVertexCount(), m_geometryVertexCapacity);
+    const int indexCount =
+        std::min(m_geometryGenerator.getCurrentIndexCount(), m_geometryIndexCapacity);
     m_engine.GetDevice()->EditBufferDataRange(
         m_geometryVertexBuffer,
-        (char *)m_geometryGenerator.getVertexData(),
-        sizeof(dbasic::Vertex) * m_geometryGenerator.getCurrentVertexCount(),
-        0);
+        (char *)(m_geometryGenerator.getVertexData() + firstVertex),
+        sizeof(dbasic::Vertex) * (vertexCount - firstVertex),
+        sizeof(dbasic::Vertex) * firstVertex);
 
     m_engine.GetDevice()->EditBufferDataRange(
         m_geometryIndexBuffer,
-        (char *)m_geometryGenerator.getIndexData(),
-        sizeof(unsigned short) * m_geometryGenerator.getCurrentIndexCount(),
-        0);
-
-    DebugTrace::Log(
-        "mainloop",
-        "render_queue_cpu_proxies vertices=%d indices=%d",
+        (char *)(m_geometryGenerator.getIndexData() + firstIndex),
+        sizeof(unsigned short) * (indexCount - firstIndex),
+        sizeof(unsigned short) * firstIndex);
+
+    ATG_ENGINE_SIM_TRACE(
+        Mainloop, Verbose,
+        "render_queue_cpu_proxies vertices=%d/%d indices=%d/%d "
+        "vertex_high_water=%d index_high_water=%d ui_shapes=%d ui_draws=%d "
+        "part_meshes=%d part_instances=%d part_draws=%d "
+        "text_runs=%d text_hits=%d text_layouts=%d",
         m_geometryGenerator.getCurrentVertexCount(),
-        m_geometryGenerator.getCurrentIndexCount());
+        m_geometryGenerator.getVertexCapacity(),
+        m_geometryGenerator.getCurrentIndexCount(),
+        m_geometryGenerator.getIndexCapacity(),
+        m_geometryGenerator.getVertexHighWater(),
+        m_geometryGenerator.getIndexHighWater(),
+        m_drawBatcher.getStatistics().shapes,
+        m_drawBatcher.getStatistics().draws,
+        m_partInstancer.getStatistics().meshes,
+        m_partInstancer.getStatistics().instances,
+        m_partInstancer.getStatistics().draws,
+        m_textLayoutCache.getStatistics().runs,
+        m_textLayoutCache.getStatistics().hits,
+        m_textLayoutCache.getStatistics().layouts);
     const auto layoutEnd = std::chrono::steady_clock::now();
-    DebugTrace::Log(
-        "ui",
-        "layout recompute end duration_us=%lld",
+    ATG_ENGINE_SIM_TRACE(
+        Ui, Verbose,
+        "scene render end duration_us=%lld",
         static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(layoutEnd - layoutStart).count()));
 }
 
 void EngineSimApplication::refreshUserInterface() {
     m_uiManager.destroy();
     m_uiManager.initialize(this);
+    m_layoutScreen = -1;
 
     m_engineView = m_uiManager.getRoot()->addElement<EngineView>();
     m_rightGaugeCluster = m_uiManager.getRoot()->addElement<RightGaugeCluster>();
@@ -1967,6 +3293,7 @@ void EngineSimApplication::refreshUserInterface() {
     m_loadSimulationCluster = m_uiManager.getRoot()->addElement<LoadSimulationCluster>();
     m_mixerCluster = m_uiManager.getRoot()->addElement<MixerCluster>();
     m_infoCluster = m_uiManager.getRoot()->addElement<InfoCluster>();
+    m_performanceHud = m_uiManager.getRoot()->addElement<PerformanceHud>();
 
     m_infoCluster->setEngine(m_iceEngine);
     m_rightGaugeCluster->m_simulator = m_simulator;
@@ -1976,6 +3303,9 @@ void EngineSimApplication::refreshUserInterface() {
         m_oscCluster->setDynoMaxRange(units::toRpm(m_iceEngine->getRedline()));
     }
     m_performanceCluster->setSimulator(m_simulator);
+    m_performanceHud->setSimulator(m_simulator);
+    m_performanceHud->setLatencyProbe(&m_latencyProbe);
+    m_performanceHud->setVisible(m_showPerformanceHud);
     m_loadSimulationCluster->setSimulator(m_simulator);
     m_mixerCluster->setSimulator(m_simulator);
 }
@@ -1986,8 +3316,14 @@ void EngineSimApplication::startRecording() {
 #ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
     atg_dtv::Encoder::VideoSettings settings{};
 
-    // Output filename
+    std::string audioPath = "../workspace/video_capture/engine_sim_video_capture.wav";
     settings.fname = "../workspace/video_capture/engine_sim_video_capture.mp4";
+    if (m_offlineRender) {
+        settings.fname = m_applicationSettings.renderVideo;
+        settings.frameRate = m_applicationSettings.renderFrameRate;
+        audioPath = std::filesystem::path(settings.fname).replace_extension(".wav").string();
+    }
+
     settings.inputWidth = m_engine.GetScreenWidth();
     settings.inputHeight = m_engine.GetScreenHeight();
     settings.width = settings.inputWidth;
@@ -1996,7 +3332,11 @@ void EngineSimApplication::startRecording() {
     settings.inputAlpha = true;
     settings.bitRate = 40000000;
 
-    m_encoder.run(settings, 2);
+    // The synthesizer output is written next to the video, paced so the two
+    // can be muxed without drift
+    if (!m_videoCapture.start(settings, audioPath, m_audioSampleRate)) {
+        m_recording = false;
+    }
 #endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
 }
 
@@ -2026,18 +3366,18 @@ void EngineSimApplication::stopRecording() {
     m_recording = false;
 
 #ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
-    m_encoder.commit();
-    m_encoder.stop();
+    m_videoCapture.stop();
 #endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
 }
 
 void EngineSimApplication::recordFrame() {
 #ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
-    atg_dtv::Frame *frame = m_encoder.newFrame(false);
-    if (frame != nullptr && m_encoder.getError() == atg_dtv::Encoder::Error::None) {
-        m_engine.GetDevice()->ReadRenderTarget(m_engine.GetScreenRenderTarget(), frame->m_rgb);
+    // Encoding happens on the capture thread; here the screen is only copied
+    // out, and not at all when no frame is due
+    uint8_t *rgb = m_videoCapture.beginFrame(m_offlineRender);
+    if (rgb != nullptr) {
+        m_engine.GetDevice()->ReadRenderTarget(m_engine.GetScreenRenderTarget(), rgb);
+        m_videoCapture.endFrame();
     }
-
-    m_encoder.submitFrame();
 #endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
 }
@@ -0,0 +1,1221 @@
+#include "../include/engine_snapshot.h"
+
+#include "../include/engine.h"
+#include "../include/vehicle.h"
+#include "../include/transmission.h"
+#include "../include/direct_throttle_linkage.h"
+#include "../include/governor.h"
+#include "../include/standard_valvetrain.h"
+#include "../include/vtec_valvetrain.h"
+#include "../include/impulse_response.h"
+#include "../include/mapped_file.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr uint64_t FnvOffset = 14695981039346656037ull;
+constexpr uint64_t FnvPrime = 1099511628211ull;
+
+enum class ThrottleType : uint32_t {
+    DirectLinkage = 0,
+    Governor = 1
+};
+
+enum class ValvetrainType : uint32_t {
+    Standard = 0,
+    Vtec = 1
+};
+
+uint64_t hashBytes(const char *data, size_t size) {
+    uint64_t hash = FnvOffset;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= FnvPrime;
+    }
+
+    return hash;
+}
+
+template <typename T>
+int indexOf(const std::vector<T *> &table, const T *object) {
+    if (object == nullptr) return -1;
+
+    const auto it = std::find(table.begin(), table.end(), object);
+    return (it != table.end())
+        ? static_cast<int>(it - table.begin())
+        : -1;
+}
+
+template <typename T>
+void addUnique(std::vector<T *> *table, T *object) {
+    if (object != nullptr && indexOf(*table, object) == -1) {
+        table->push_back(object);
+    }
+}
+
+int crankshaftIndex(Engine *engine, const Crankshaft *crankshaft) {
+    for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+        if (engine->getCrankshaft(i) == crankshaft) return i;
+    }
+
+    return -1;
+}
+
+class Writer {
+    public:
+        template <typename T>
+        void write(T value) {
+            const char *bytes = reinterpret_cast<const char *>(&value);
+            m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+        }
+
+        void writeBool(bool value) { write<uint8_t>(value ? 1 : 0); }
+        void writeIndex(int index) { write<int32_t>(index); }
+
+        void writeString(const std::string &s) {
+            write<uint32_t>(static_cast<uint32_t>(s.size()));
+            m_data.insert(m_data.end(), s.begin(), s.end());
+        }
+
+        const std::vector<char> &getData() const { return m_data; }
+
+    private:
+        std::vector<char> m_data;
+};
+
+// Reads fields in place from the mapped payload; any overrun or bad index
+// latches the failure flag and yields zeros from then on
+class Reader {
+    public:
+        Reader(const char *data, size_t size) {
+            m_data = data;
+            m_size = size;
+            m_offset = 0;
+            m_failed = false;
+        }
+
+        template <typename T>
+        T read() {
+            T value{};
+            if (m_failed || m_size - m_offset < sizeof(T)) {
+                m_failed = true;
+                return value;
+            }
+
+            std::memcpy(&value, m_data + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+            return value;
+        }
+
+        double readDouble() { return read<double>(); }
+        bool readBool() { return read<uint8_t>() != 0; }
+
+        // An index into a table of the given size, or -1 where null is allowed
+        int readIndex(int count, bool nullable = false) {
+            const int32_t index = read<int32_t>();
+            if (nullable && index == -1) return -1;
+            else if (index < 0 || index >= count) {
+                m_failed = true;
+                return -1;
+            }
+
+            return index;
+        }
+
+        // Element counts can't exceed the bytes left, which bounds allocations
+        int readCount(size_t elementSize) {
+            const int32_t count = read<int32_t>();
+            if (count < 0 || static_cast<size_t>(count) > (m_size - m_offset) / elementSize) {
+                m_failed = true;
+                return 0;
+            }
+
+            return count;
+        }
+
+        std::string readString() {
+            const int length = readCount(1);
+            if (m_failed) return std::string();
+
+            const std::string s(m_data + m_offset, length);
+            m_offset += length;
+            return s;
+        }
+
+        bool failed() const { return m_failed; }
+        bool atEnd() const { return m_offset == m_size; }
+
+    private:
+        const char *m_data;
+        size_t m_size;
+        size_t m_offset;
+        bool m_failed;
+};
+
+// Objects the engine points to but doesn't own; the script path leaves
+// these alive for the life of the engine and so does the loader
+struct Tables {
+    std::vector<Function *> functions;
+    std::vector<ImpulseResponse *> impulseResponses;
+    std::vector<Camshaft *> camshafts;
+    std::vector<Valvetrain *> valvetrains;
+
+    void release() {
+        for (Function *function : functions) {
+            function->destroy();
+            delete function;
+        }
+
+        for (Camshaft *camshaft : camshafts) {
+            camshaft->destroy();
+            delete camshaft;
+        }
+
+        for (ImpulseResponse *impulseResponse : impulseResponses) delete impulseResponse;
+        for (Valvetrain *valvetrain : valvetrains) delete valvetrain;
+
+        *this = Tables();
+    }
+};
+
+Function *lookup(const std::vector<Function *> &table, int index) {
+    return (index >= 0) ? table[index] : nullptr;
+}
+
+void collectCamshafts(Valvetrain *valvetrain, std::vector<Camshaft *> *camshafts) {
+    if (StandardValvetrain *standard = dynamic_cast<StandardValvetrain *>(valvetrain)) {
+        addUnique(camshafts, standard->getIntakeCamshaft());
+        addUnique(camshafts, standard->getExhaustCamshaft());
+    }
+    else if (VtecValvetrain *vtec = dynamic_cast<VtecValvetrain *>(valvetrain)) {
+        addUnique(camshafts, vtec->getIntakeCamshaft());
+        addUnique(camshafts, vtec->getExhaustCamshaft());
+        addUnique(camshafts, vtec->getVtecIntakeCamshaft());
+        addUnique(camshafts, vtec->getVtecExhaustCamshaft());
+    }
+}
+
+bool writeThrottle(Writer *writer, Throttle *throttle) {
+    if (DirectThrottleLinkage *linkage = dynamic_cast<DirectThrottleLinkage *>(throttle)) {
+        writer->write(ThrottleType::DirectLinkage);
+        writer->write(linkage->getGamma());
+    }
+    else if (Governor *governor = dynamic_cast<Governor *>(throttle)) {
+        writer->write(ThrottleType::Governor);
+        writer->write(governor->getMinSpeed());
+        writer->write(governor->getMaxSpeed());
+        writer->write(governor->getMinVelocity());
+        writer->write(governor->getMaxVelocity());
+        writer->write(governor->getKs());
+        writer->write(governor->getKd());
+        writer->write(governor->getGamma());
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+Throttle *readThrottle(Reader *reader) {
+    const ThrottleType type = reader->read<ThrottleType>();
+    if (type == ThrottleType::DirectLinkage) {
+        DirectThrottleLinkage::Parameters params;
+        params.gamma = reader->readDouble();
+
+        DirectThrottleLinkage *linkage = new DirectThrottleLinkage;
+        linkage->initialize(params);
+        return linkage;
+    }
+    else if (type == ThrottleType::Governor) {
+        Governor::Parameters params;
+        params.minSpeed = reader->readDouble();
+        params.maxSpeed = reader->readDouble();
+        params.minVelocity = reader->readDouble();
+        params.maxVelocity = reader->readDouble();
+        params.k_s = reader->readDouble();
+        params.k_d = reader->readDouble();
+        params.gamma = reader->readDouble();
+
+        Governor *governor = new Governor;
+        governor->initialize(params);
+        return governor;
+    }
+
+    return nullptr;
+}
+
+bool writeValvetrain(Writer *writer, Valvetrain *valvetrain, const Tables &tables) {
+    if (StandardValvetrain *standard = dynamic_cast<StandardValvetrain *>(valvetrain)) {
+        writer->write(ValvetrainType::Standard);
+        writer->writeIndex(indexOf(tables.camshafts, standard->getIntakeCamshaft()));
+        writer->writeIndex(indexOf(tables.camshafts, standard->getExhaustCamshaft()));
+    }
+    else if (VtecValvetrain *vtec = dynamic_cast<VtecValvetrain *>(valvetrain)) {
+        writer->write(ValvetrainType::Vtec);
+        writer->writeIndex(indexOf(tables.camshafts, vtec->getIntakeCamshaft()));
+        writer->writeIndex(indexOf(tables.camshafts, vtec->getExhaustCamshaft()));
+        writer->writeIndex(indexOf(tables.camshafts, vtec->getVtecIntakeCamshaft()));
+        writer->writeIndex(indexOf(tables.camshafts, vtec->getVtecExhaustCamshaft()));
+        writer->write(vtec->getMinRpm());
+        writer->write(vtec->getMinSpeed());
+        writer->write(vtec->getManifoldVacuum());
+        writer->write(vtec->getMinThrottlePosition());
+        writer->write(vtec->getRpmHysteresis());
+        writer->write(vtec->getEngagementDelay());
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+Valvetrain *readValvetrain(Reader *reader, Engine *engine, const Tables &tables) {
+    const int camshaftCount = static_cast<int>(tables.camshafts.size());
+
+    const ValvetrainType type = reader->read<ValvetrainType>();
+    if (type == ValvetrainType::Standard) {
+        StandardValvetrain::Parameters params;
+        const int intake = reader->readIndex(camshaftCount);
+        const int exhaust = reader->readIndex(camshaftCount);
+        if (reader->failed()) return nullptr;
+
+        params.intakeCamshaft = tables.camshafts[intake];
+        params.exhaustCamshaft = tables.camshafts[exhaust];
+
+        StandardValvetrain *valvetrain = new StandardValvetrain;
+        valvetrain->initialize(params);
+        return valvetrain;
+    }
+    else if (type == ValvetrainType::Vtec) {
+        VtecValvetrain::Parameters params;
+        const int intake = reader->readIndex(camshaftCount);
+        const int exhaust = reader->readIndex(camshaftCount);
+        const int vtecIntake = reader->readIndex(camshaftCount);
+        const int vtecExhaust = reader->readIndex(camshaftCount);
+        params.minRpm = reader->readDouble();
+        params.minSpeed = reader->readDouble();
+        params.manifoldVacuum = reader->readDouble();
+        params.minThrottlePosition = reader->readDouble();
+        params.rpmHysteresis = reader->readDouble();
+        params.engagementDelay = reader->readDouble();
+        if (reader->failed()) return nullptr;
+
+        params.intakeCamshaft = tables.camshafts[intake];
+        params.exhaustCamshaft = tables.camshafts[exhaust];
+        params.vtecIntakeCamshaft = tables.camshafts[vtecIntake];
+        params.vtexExhaustCamshaft = tables.camshafts[vtecExhaust];
+        params.engine = engine;
+
+        VtecValvetrain *valvetrain = new VtecValvetrain;
+        valvetrain->initialize(params);
+        return valvetrain;
+    }
+
+    return nullptr;
+}
+
+void collectTables(Engine *engine, Tables *tables) {
+    for (int i = 0; i < engine->getCylinderBankCount(); ++i) {
+        CylinderHead *head = engine->getHead(i);
+        addUnique(&tables->functions, head->getIntakePortFlow());
+        addUnique(&tables->functions, head->getExhaustPortFlow());
+        addUnique(&tables->valvetrains, head->getValvetrain());
+        collectCamshafts(head->getValvetrain(), &tables->camshafts);
+    }
+
+    for (Camshaft *camshaft : tables->camshafts) {
+        addUnique(&tables->functions, camshaft->getLobeProfile());
+    }
+
+    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+        addUnique(&tables->impulseResponses, engine->getExhaustSystem(i)->getImpulseResponse());
+    }
+
+    IgnitionModule *ignition = engine->getIgnitionModule();
+    Fuel *fuel = engine->getFuel();
+    addUnique(&tables->functions, ignition->getTimingCurve());
+    addUnique(&tables->functions, fuel->getTurbulenceToFlameSpeedRatio());
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        addUnique(&tables->functions, engine->getChamber(i)->m_meanPistonSpeedToTurbulence);
+    }
+}
+
+// The structure-only form leaves out function samples, impulse responses
+// and audio levels, which EnginePatch can change on a running engine
+bool writeEngine(
+    Writer *writer,
+    Engine *engine,
+    Vehicle *vehicle,
+    Transmission *transmission,
+    bool structureOnly)
+{
+    Tables tables;
+    collectTables(engine, &tables);
+
+    IgnitionModule *ignition = engine->getIgnitionModule();
+    Fuel *fuel = engine->getFuel();
+
+    writer->write<int32_t>(static_cast<int32_t>(tables.functions.size()));
+    if (!structureOnly) {
+        for (const Function *function : tables.functions) {
+            const int n = function->getSampleCount();
+            writer->write(function->getFilterRadius());
+            writer->write(function->getInputScale());
+            writer->write(function->getOutputScale());
+            writer->write<int32_t>(function->isBaked() ? function->getBakedResolution() : 0);
+            writer->write<int32_t>(n);
+            for (int i = 0; i < n; ++i) writer->write(function->getSampleX(i));
+            for (int i = 0; i < n; ++i) writer->write(function->getSampleY(i));
+        }
+    }
+
+    writer->write<int32_t>(static_cast<int32_t>(tables.impulseResponses.size()));
+    if (!structureOnly) {
+        for (const ImpulseResponse *impulseResponse : tables.impulseResponses) {
+            writer->writeString(impulseResponse->getFilename());
+            writer->write(impulseResponse->getVolume());
+        }
+    }
+
+    writer->writeString(engine->getName());
+    writer->write<int32_t>(engine->getCrankshaftCount());
+    writer->write<int32_t>(engine->getCylinderBankCount());
+    writer->write<int32_t>(engine->getCylinderCount());
+    writer->write<int32_t>(engine->getExhaustSystemCount());
+    writer->write<int32_t>(engine->getIntakeCount());
+    writer->write(engine->getStarterTorque());
+    writer->write(engine->getStarterSpeed());
+    writer->write(engine->getRedline());
+    writer->write(engine->getDynoMinSpeed());
+    writer->write(engine->getDynoMaxSpeed());
+    writer->write(engine->getDynoHoldStep());
+    writer->write(engine->getSimulationFrequency());
+    if (!structureOnly) {
+        writer->write(engine->getInitialHighFrequencyGain());
+        writer->write(engine->getInitialNoise());
+        writer->write(engine->getInitialJitter());
+    }
+
+    writer->writeBool(engine->isMultiZone());
+    writer->write(engine->getCreviceVolume());
+    writer->write(engine->getKnockOctane());
+
+    if (!writeThrottle(writer, engine->getThrottleModel())) return false;
+
+    for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+        Crankshaft *crankshaft = engine->getCrankshaft(i);
+        writer->write(crankshaft->getMass());
+        writer->write(crankshaft->getFlywheelMass());
+        writer->write(crankshaft->getMomentOfInertia());
+        writer->write(crankshaft->getThrow());
+        writer->write(crankshaft->getPosX());
+        writer->write(crankshaft->getPosY());
+        writer->write(crankshaft->getTdc());
+        writer->write(crankshaft->getFrictionTorque());
+        writer->write<int32_t>(crankshaft->getRodJournalCount());
+        for (int j = 0; j < crankshaft->getRodJournalCount(); ++j) {
+            writer->write(crankshaft->getRodJournalAngle(j));
+        }
+    }
+
+    for (int i = 0; i < engine->getCylinderBankCount(); ++i) {
+        const CylinderBank *bank = engine->getCylinderBank(i);
+        writer->write(bank->getX());
+        writer->write(bank->getY());
+        writer->write(bank->getAngle());
+        writer->write(bank->getBore());
+        writer->write(bank->getDeckHeight());
+        writer->write(bank->getDisplayDepth());
+        writer->write<int32_t>(bank->getCylinderCount());
+    }
+
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        const Piston *piston = engine->getPiston(i);
+        writer->writeIndex(piston->getCylinderBank()->getIndex());
+        writer->writeIndex(piston->getCylinderIndex());
+        writer->writeIndex(static_cast<int>(piston->getRod() - engine->getConnectingRod(0)));
+        writer->write(piston->getBlowbyK());
+        writer->write(piston->getCompressionHeight());
+        writer->write(piston->getWristPinLocation());
+        writer->write(piston->getDisplacement());
+        writer->write(piston->getMass());
+
+        ConnectingRod *rod = engine->getConnectingRod(i);
+        writer->writeIndex(crankshaftIndex(engine, rod->getCrankshaft()));
+        writer->writeIndex(static_cast<int>(rod->getPiston() - engine->getPiston(0)));
+        writer->writeIndex((rod->getMasterRod() != nullptr)
+            ? static_cast<int>(rod->getMasterRod() - engine->getConnectingRod(0))
+            : -1);
+        writer->write<int32_t>(rod->getJournal());
+        writer->write(rod->getMass());
+        writer->write(rod->getMomentOfInertia());
+        writer->write(rod->getCenterOfMass());
+        writer->write(rod->getLength());
+        writer->write(rod->getSlaveThrow());
+        writer->write<int32_t>(rod->getRodJournalCount());
+        for (int j = 0; j < rod->getRodJournalCount(); ++j) {
+            writer->write(rod->getRodJournalAngle(j));
+        }
+    }
+
+    writer->write<int32_t>(static_cast<int32_t>(tables.camshafts.size()));
+    for (const Camshaft *camshaft : tables.camshafts) {
+        writer->writeIndex(crankshaftIndex(engine, camshaft->getCrankshaft()));
+        writer->writeIndex(indexOf(tables.functions, camshaft->getLobeProfile()));
+        writer->write(camshaft->getAdvance());
+        writer->write(camshaft->getBaseRadius());
+        writer->writeBool(camshaft->isLobeBakeEnabled());
+        writer->write<int32_t>(camshaft->getLobeCount());
+        for (int j = 0; j < camshaft->getLobeCount(); ++j) {
+            // Stored as the crank angle setLobeCenterline() takes
+            writer->write(camshaft->getLobeCenterline(j) * 2);
+        }
+    }
+
+    for (int i = 0; i < engine->getCylinderBankCount(); ++i) {
+        CylinderHead *head = engine->getHead(i);
+        writer->writeIndex(indexOf(tables.functions, head->getIntakePortFlow()));
+        writer->writeIndex(indexOf(tables.functions, head->getExhaustPortFlow()));
+        if (!writeValvetrain(writer, head->getValvetrain(), tables)) return false;
+
+        writer->write(head->getCombustionChamberVolume());
+        writer->write(head->getIntakeRunnerVolume());
+        writer->write(head->getIntakeRunnerCrossSectionArea());
+        writer->write(head->getExhaustRunnerVolume());
+        writer->write(head->getExhaustRunnerCrossSectionArea());
+        writer->writeBool(head->getFlipDisplay());
+
+        for (int j = 0; j < engine->getCylinderBank(i)->getCylinderCount(); ++j) {
+            const ExhaustSystem *exhaust = head->getExhaustSystem(j);
+            const Intake *intake = head->getIntake(j);
+            writer->writeIndex((exhaust != nullptr) ? static_cast<int>(exhaust - engine->getExhaustSystem(0)) : -1);
+            writer->writeIndex((intake != nullptr) ? static_cast<int>(intake - engine->getIntake(0)) : -1);
+            writer->write(head->getSoundAttenuation(j));
+            writer->write(head->getHeaderPrimaryLength(j));
+        }
+    }
+
+    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+        const ExhaustSystem *exhaust = engine->getExhaustSystem(i);
+        writer->write(exhaust->getLength());
+        writer->write(exhaust->getCollectorCrossSectionArea());
+        writer->write(exhaust->getOutletFlowRate());
+        writer->write(exhaust->getPrimaryTubeLength());
+        writer->write(exhaust->getPrimaryFlowRate());
+        writer->write(exhaust->getVelocityDecay());
+        writer->write<int32_t>(exhaust->getPrimarySegments());
+        if (!structureOnly) writer->write(exhaust->getAudioVolume());
+        writer->writeIndex(indexOf(tables.impulseResponses, exhaust->getImpulseResponse()));
+    }
+
+    for (int i = 0; i < engine->getIntakeCount(); ++i) {
+        const Intake *intake = engine->getIntake(i);
+        writer->write(intake->getPlenumVolume());
+        writer->write(intake->getPlenumCrossSectionArea());
+        writer->write(intake->getInputFlowK());
+        writer->write(intake->getIdleFlowK());
+        writer->write(intake->getRunnerFlowRate());
+        writer->write(intake->getMolecularAfr());
+        writer->write(intake->getIdleThrottlePlatePosition());
+        writer->write(intake->getRunnerLength());
+        writer->write(intake->getVelocityDecay());
+        writer->write<int32_t>(intake->getRunnerSegments());
+    }
+
+    writer->writeIndex(crankshaftIndex(engine, ignition->getCrankshaft()));
+    writer->writeIndex(indexOf(tables.functions, ignition->getTimingCurve()));
+    writer->write(ignition->getRevLimit());
+    writer->write(ignition->getLimiterDuration());
+    for (int i = 0; i < ignition->getCylinderCount(); ++i) {
+        writer->writeBool(ignition->isPlugEnabled(i));
+        writer->write(ignition->getFiringAngle(i));
+    }
+
+    // The map and trims are tuning, like function samples
+    const TimingMap *timingMap = ignition->getTimingMap();
+    writer->writeBool(timingMap->isBaked());
+    if (!structureOnly) {
+        if (timingMap->isBaked()) {
+            writer->write<int32_t>(timingMap->getSpeedSamples());
+            writer->write<int32_t>(timingMap->getPressureSamples());
+            writer->write(timingMap->getSpeed0());
+            writer->write(timingMap->getSpeed1());
+            writer->write(timingMap->getPressure0());
+            writer->write(timingMap->getPressure1());
+            for (int j = 0; j < timingMap->getPressureSamples(); ++j) {
+                for (int i = 0; i < timingMap->getSpeedSamples(); ++i) {
+                    writer->write(timingMap->getValue(i, j));
+                }
+            }
+        }
+
+        for (int i = 0; i < ignition->getCylinderCount(); ++i) {
+            writer->write(ignition->getCylinderTrim(i));
+        }
+    }
+
+    writer->writeString(fuel->getName());
+    writer->write(fuel->getMolecularMass());
+    writer->write(fuel->getEnergyDensity());
+    writer->write(fuel->getDensity());
+    writer->write(fuel->getMolecularAfr());
+    writer->write(fuel->getMaxBurningEfficiency());
+    writer->write(fuel->getBurningEfficiencyRandomness());
+    writer->write(fuel->getLowEfficiencyAttenuation());
+    writer->write(fuel->getMaxTurbulenceEffect());
+    writer->write(fuel->getMaxDilutionEffect());
+    writer->writeIndex(indexOf(tables.functions, fuel->getTurbulenceToFlameSpeedRatio()));
+
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        const CombustionChamber *chamber = engine->getChamber(i);
+        writer->write(chamber->getCrankcasePressure());
+        writer->writeIndex(indexOf(tables.functions, chamber->m_meanPistonSpeedToTurbulence));
+    }
+
+    writer->writeBool(vehicle != nullptr);
+    if (vehicle != nullptr) {
+        writer->write(vehicle->getMass());
+        writer->write(vehicle->getDragCoefficient());
+        writer->write(vehicle->getCrossSectionArea());
+        writer->write(vehicle->getDiffRatio());
+        writer->write(vehicle->getTireRadius());
+        writer->write(vehicle->getRollingResistance());
+    }
+
+    writer->writeBool(transmission != nullptr);
+    if (transmission != nullptr) {
+        writer->write(transmission->getMaxClutchTorque());
+        writer->write<int32_t>(transmission->getGearCount());
+        for (int i = 0; i < transmission->getGearCount(); ++i) {
+            writer->write(transmission->getGearRatio(i));
+        }
+    }
+
+    return true;
+}
+
+// With shared functions, the stored ones are only skipped over
+bool readTables(Reader *reader, Tables *tables, const std::vector<Function *> *shared) {
+    const int functionCount = reader->readCount(sizeof(double) * 3);
+    if (shared != nullptr && functionCount != static_cast<int>(shared->size())) return false;
+
+    for (int i = 0; i < functionCount && !reader->failed(); ++i) {
+        const double filterRadius = reader->readDouble();
+        const double inputScale = reader->readDouble();
+        const double outputScale = reader->readDouble();
+        const int bakedResolution = reader->read<int32_t>();
+        const int n = reader->readCount(sizeof(double) * 2);
+        if (reader->failed()) return false;
+
+        if (shared != nullptr) {
+            for (int j = 0; j < 2 * n; ++j) reader->readDouble();
+            tables->functions.push_back((*shared)[i]);
+            continue;
+        }
+
+        Function *function = new Function;
+        tables->functions.push_back(function);
+
+        function->initialize(n, filterRadius);
+        function->setInputScale(inputScale);
+        function->setOutputScale(outputScale);
+
+        // Both arrays follow each other in the payload, already sorted
+        std::vector<double> x(n), y(n);
+        for (int j = 0; j < n; ++j) x[j] = reader->readDouble();
+        for (int j = 0; j < n; ++j) y[j] = reader->readDouble();
+        function->setSamples(x.data(), y.data(), n, true);
+
+        if (bakedResolution > 0) {
+            function->bake(bakedResolution);
+        }
+    }
+
+    const int impulseResponseCount = reader->readCount(sizeof(uint32_t) + sizeof(double));
+    for (int i = 0; i < impulseResponseCount && !reader->failed(); ++i) {
+        const std::string filename = reader->readString();
+        const double volume = reader->readDouble();
+
+        ImpulseResponse *impulseResponse = new ImpulseResponse;
+        impulseResponse->initialize(filename, volume);
+        tables->impulseResponses.push_back(impulseResponse);
+    }
+
+    return !reader->failed();
+}
+
+// Same order as EngineNode::buildEngine() so every initialize() sees the
+// objects it expects already set up
+bool readEngine(
+    Reader *reader,
+    Engine *engine,
+    Tables *tables,
+    const std::vector<Function *> *sharedFunctions,
+    std::vector<Camshaft::BakedLobe> *sharedLobes)
+{
+    if (!readTables(reader, tables, sharedFunctions)) return false;
+
+    const int functionCount = static_cast<int>(tables->functions.size());
+    const int impulseResponseCount = static_cast<int>(tables->impulseResponses.size());
+
+    Engine::Parameters params;
+    params.name = reader->readString();
+    params.crankshaftCount = reader->read<int32_t>();
+    params.cylinderBanks = reader->read<int32_t>();
+    params.cylinderCount = reader->read<int32_t>();
+    params.exhaustSystemCount = reader->read<int32_t>();
+    params.intakeCount = reader->read<int32_t>();
+    params.starterTorque = reader->readDouble();
+    params.starterSpeed = reader->readDouble();
+    params.redline = reader->readDouble();
+    params.dynoMinSpeed = reader->readDouble();
+    params.dynoMaxSpeed = reader->readDouble();
+    params.dynoHoldStep = reader->readDouble();
+    params.initialSimulationFrequency = reader->readDouble();
+    params.initialHighFrequencyGain = reader->readDouble();
+    params.initialNoise = reader->readDouble();
+    params.initialJitter = reader->readDouble();
+    params.multiZone = reader->readBool();
+    params.creviceVolume = reader->readDouble();
+    params.knockOctane = reader->readDouble();
+    params.throttle = readThrottle(reader);
+    if (reader->failed() || params.throttle == nullptr) {
+        delete params.throttle;
+        return false;
+    }
+
+    // Every part below reads at least one double, which bounds the counts
+    const size_t maxParts = 1 << 20;
+    if (params.crankshaftCount < 1 || params.cylinderBanks < 1 || params.cylinderCount < 1
+        || params.exhaustSystemCount < 0 || params.intakeCount < 0
+        || static_cast<size_t>(params.crankshaftCount) > maxParts
+        || static_cast<size_t>(params.cylinderBanks) > maxParts
+        || static_cast<size_t>(params.cylinderCount) > maxParts
+        || static_cast<size_t>(params.exhaustSystemCount) > maxParts
+        || static_cast<size_t>(params.intakeCount) > maxParts)
+    {
+        delete params.throttle;
+        return false;
+    }
+
+    engine->initialize(params);
+
+    for (int i = 0; i < params.crankshaftCount; ++i) {
+        Crankshaft::Parameters crankshaftParams;
+        crankshaftParams.mass = reader->readDouble();
+        crankshaftParams.flywheelMass = reader->readDouble();
+        crankshaftParams.momentOfInertia = reader->readDouble();
+        crankshaftParams.crankThrow = reader->readDouble();
+        crankshaftParams.pos_x = reader->readDouble();
+        crankshaftParams.pos_y = reader->readDouble();
+        crankshaftParams.tdc = reader->readDouble();
+        crankshaftParams.frictionTorque = reader->readDouble();
+        crankshaftParams.rodJournals = reader->readCount(sizeof(double));
+        if (reader->failed()) return false;
+
+        Crankshaft *crankshaft = engine->getCrankshaft(i);
+        crankshaft->initialize(crankshaftParams);
+        for (int j = 0; j < crankshaftParams.rodJournals; ++j) {
+            crankshaft->setRodJournalAngle(j, reader->readDouble());
+        }
+    }
+
+    int bankCylinders = 0;
+    for (int i = 0; i < params.cylinderBanks; ++i) {
+        CylinderBank::Parameters bankParams;
+        bankParams.crankshaft = engine->getCrankshaft(0);
+        bankParams.positionX = reader->readDouble();
+        bankParams.positionY = reader->readDouble();
+        bankParams.angle = reader->readDouble();
+        bankParams.bore = reader->readDouble();
+        bankParams.deckHeight = reader->readDouble();
+        bankParams.displayDepth = reader->readDouble();
+        bankParams.cylinderCount = reader->readCount(sizeof(double));
+        bankParams.index = i;
+        if (reader->failed()) return false;
+
+        engine->getCylinderBank(i)->initialize(bankParams);
+        bankCylinders += bankParams.cylinderCount;
+    }
+
+    if (bankCylinders != params.cylinderCount) return false;
+
+    for (int i = 0; i < params.cylinderCount; ++i) {
+        Piston::Parameters pistonParams;
+        const int bank = reader->readIndex(params.cylinderBanks);
+        pistonParams.CylinderIndex = reader->read<int32_t>();
+        const int pistonRod = reader->readIndex(params.cylinderCount);
+        pistonParams.BlowbyFlowCoefficient = reader->readDouble();
+        pistonParams.CompressionHeight = reader->readDouble();
+        pistonParams.WristPinPosition = reader->readDouble();
+        pistonParams.Displacement = reader->readDouble();
+        pistonParams.mass = reader->readDouble();
+
+        ConnectingRod::Parameters rodParams;
+        const int crankshaft = reader->readIndex(params.crankshaftCount);
+        const int rodPiston = reader->readIndex(params.cylinderCount);
+        const int master = reader->readIndex(params.cylinderCount, true);
+        rodParams.journal = reader->read<int32_t>();
+        rodParams.mass = reader->readDouble();
+        rodParams.momentOfInertia = reader->readDouble();
+        rodParams.centerOfMass = reader->readDouble();
+        rodParams.length = reader->readDouble();
+        rodParams.slaveThrow = reader->readDouble();
+        rodParams.rodJournals = reader->readCount(sizeof(double));
+        if (reader->failed()) return false;
+
+        CylinderBank *cylinderBank = engine->getCylinderBank(bank);
+        if (pistonParams.CylinderIndex < 0 || pistonParams.CylinderIndex >= cylinderBank->getCylinderCount()) {
+            return false;
+        }
+
+        pistonParams.Bank = cylinderBank;
+        pistonParams.Rod = engine->getConnectingRod(pistonRod);
+        engine->getPiston(i)->initialize(pistonParams);
+
+        rodParams.crankshaft = engine->getCrankshaft(crankshaft);
+        rodParams.piston = engine->getPiston(rodPiston);
+        rodParams.master = (master != -1) ? engine->getConnectingRod(master) : nullptr;
+
+        ConnectingRod *rod = engine->getConnectingRod(i);
+        rod->initialize(rodParams);
+        for (int j = 0; j < rodParams.rodJournals; ++j) {
+            rod->setRodJournalAngle(j, reader->readDouble());
+        }
+    }
+
+    const int camshaftCount = reader->readCount(sizeof(double));
+    for (int i = 0; i < camshaftCount && !reader->failed(); ++i) {
+        Camshaft::Parameters camshaftParams;
+        const int crankshaft = reader->readIndex(params.crankshaftCount);
+        const int lobeProfile = reader->readIndex(functionCount);
+        camshaftParams.advance = reader->readDouble();
+        camshaftParams.baseRadius = reader->readDouble();
+        camshaftParams.bakeLobe = reader->readBool();
+        camshaftParams.lobes = reader->readCount(sizeof(double));
+        if (reader->failed()) return false;
+
+        camshaftParams.crankshaft = engine->getCrankshaft(crankshaft);
+        camshaftParams.lobeProfile = tables->functions[lobeProfile];
+
+        Camshaft::BakedLobe *sharedLobe = nullptr;
+        if (sharedLobes != nullptr) {
+            for (Camshaft::BakedLobe &lobe : *sharedLobes) {
+                if (lobe.profile == camshaftParams.lobeProfile) sharedLobe = &lobe;
+            }
+
+            if (sharedLobe != nullptr) camshaftParams.sharedLobe = *sharedLobe;
+        }
+
+        Camshaft *camshaft = new Camshaft;
+        tables->camshafts.push_back(camshaft);
+
+        camshaft->initialize(camshaftParams);
+        if (sharedLobes != nullptr && sharedLobe == nullptr && camshaft->isLobeBaked()) {
+            sharedLobes->push_back(camshaft->getBakedLobe());
+        }
+        for (int j = 0; j < camshaftParams.lobes; ++j) {
+            camshaft->setLobeCenterline(j, reader->readDouble());
+        }
+    }
+
+    for (int i = 0; i < params.cylinderBanks && !reader->failed(); ++i) {
+        CylinderHead::Parameters headParams;
+        headParams.Bank = engine->getCylinderBank(i);
+        headParams.IntakePortFlow = lookup(tables->functions, reader->readIndex(functionCount, true));
+        headParams.ExhaustPortFlow = lookup(tables->functions, reader->readIndex(functionCount, true));
+        headParams.ValvetrainSystem = readValvetrain(reader, engine, *tables);
+        if (headParams.ValvetrainSystem == nullptr) return false;
+
+        tables->valvetrains.push_back(headParams.ValvetrainSystem);
+
+        headParams.CombustionChamberVolume = reader->readDouble();
+        headParams.IntakeRunnerVolume = reader->readDouble();
+        headParams.IntakeRunnerCrossSectionArea = reader->readDouble();
+        headParams.ExhaustRunnerVolume = reader->readDouble();
+        headParams.ExhaustRunnerCrossSectionArea = reader->readDouble();
+        headParams.FlipDisplay = reader->readBool();
+        if (reader->failed()) return false;
+
+        CylinderHead *head = engine->getHead(i);
+        head->initialize(headParams);
+
+        for (int j = 0; j < headParams.Bank->getCylinderCount(); ++j) {
+            const int exhaust = reader->readIndex(params.exhaustSystemCount, true);
+            const int intake = reader->readIndex(params.intakeCount, true);
+            const double soundAttenuation = reader->readDouble();
+            const double primaryLength = reader->readDouble();
+            if (reader->failed()) return false;
+
+            head->setExhaustSystem(j, (exhaust != -1) ? engine->getExhaustSystem(exhaust) : nullptr);
+            head->setIntake(j, (intake != -1) ? engine->getIntake(intake) : nullptr);
+            head->setSoundAttenuation(j, soundAttenuation);
+            head->setHeaderPrimaryLength(j, primaryLength);
+        }
+    }
+
+    for (int i = 0; i < params.exhaustSystemCount && !reader->failed(); ++i) {
+        ExhaustSystem::Parameters exhaustParams;
+        exhaustParams.length = reader->readDouble();
+        exhaustParams.collectorCrossSectionArea = reader->readDouble();
+        exhaustParams.outletFlowRate = reader->readDouble();
+        exhaustParams.primaryTubeLength = reader->readDouble();
+        exhaustParams.primaryFlowRate = reader->readDouble();
+        exhaustParams.velocityDecay = reader->readDouble();
+        exhaustParams.primarySegments = reader->read<int32_t>();
+        exhaustParams.audioVolume = reader->readDouble();
+
+        const int impulseResponse = reader->readIndex(impulseResponseCount, true);
+        exhaustParams.impulseResponse = (impulseResponse != -1)
+            ? tables->impulseResponses[impulseResponse]
+            : nullptr;
+
+        engine->getExhaustSystem(i)->initialize(exhaustParams);
+    }
+
+    for (int i = 0; i < params.intakeCount && !reader->failed(); ++i) {
+        Intake::Parameters intakeParams;
+        intakeParams.volume = reader->readDouble();
+        intakeParams.CrossSectionArea = reader->readDouble();
+        intakeParams.InputFlowK = reader->readDouble();
+        intakeParams.IdleFlowK = reader->readDouble();
+        intakeParams.RunnerFlowRate = reader->readDouble();
+        intakeParams.MolecularAfr = reader->readDouble();
+        intakeParams.IdleThrottlePlatePosition = reader->readDouble();
+        intakeParams.RunnerLength = reader->readDouble();
+        intakeParams.VelocityDecay = reader->readDouble();
+        intakeParams.RunnerSegments = reader->read<int32_t>();
+
+        engine->getIntake(i)->initialize(intakeParams);
+    }
+
+    IgnitionModule::Parameters ignitionParams;
+    const int ignitionCrankshaft = reader->readIndex(params.crankshaftCount);
+    ignitionParams.timingCurve = lookup(tables->functions, reader->readIndex(functionCount, true));
+    ignitionParams.revLimit = reader->readDouble();
+    ignitionParams.limiterDuration = reader->readDouble();
+    ignitionParams.cylinderCount = params.cylinderCount;
+    if (reader->failed()) return false;
+
+    ignitionParams.crankshaft = engine->getCrankshaft(ignitionCrankshaft);
+
+    IgnitionModule *ignition = engine->getIgnitionModule();
+    ignition->initialize(ignitionParams);
+    for (int i = 0; i < params.cylinderCount; ++i) {
+        const bool enabled = reader->readBool();
+        const double angle = reader->readDouble();
+        if (enabled) ignition->setFiringOrder(i, angle);
+    }
+
+    if (reader->readBool()) {
+        const int speedSamples = reader->readCount(sizeof(double));
+        const int pressureSamples = reader->readCount(sizeof(double));
+        const double speed0 = reader->readDouble();
+        const double speed1 = reader->readDouble();
+        const double pressure0 = reader->readDouble();
+        const double pressure1 = reader->readDouble();
+        if (reader->failed()) return false;
+        if (speedSamples < 2 || pressureSamples < 2) return false;
+        if (!(speed1 > speed0) || !(pressure1 > pressure0)) return false;
+
+        TimingMap *timingMap = ignition->getTimingMap();
+        timingMap->initialize(speedSamples, pressureSamples, speed0, speed1, pressure0, pressure1);
+        for (int j = 0; j < pressureSamples && !reader->failed(); ++j) {
+            for (int i = 0; i < speedSamples; ++i) {
+                timingMap->setValue(i, j, reader->readDouble());
+            }
+        }
+    }
+
+    for (int i = 0; i < params.cylinderCount; ++i) {
+        ignition->setCylinderTrim(i, reader->readDouble());
+    }
+
+    Fuel::Parameters fuelParams;
+    fuelParams.name = reader->readString();
+    fuelParams.molecularMass = reader->readDouble();
+    fuelParams.energyDensity = reader->readDouble();
+    fuelParams.density = reader->readDouble();
+    fuelParams.molecularAfr = reader->readDouble();
+    fuelParams.maxBurningEfficiency = reader->readDouble();
+    fuelParams.burningEfficiencyRandomness = reader->readDouble();
+    fuelParams.lowEfficiencyAttenuation = reader->readDouble();
+    fuelParams.maxTurbulenceEffect = reader->readDouble();
+    fuelParams.maxDilutionEffect = reader->readDouble();
+    fuelParams.turbulenceToFlameSpeedRatio =
+        lookup(tables->functions, reader->readIndex(functionCount, true));
+    if (reader->failed()) return false;
+
+    engine->getFuel()->initialize(fuelParams);
+
+    for (int i = 0; i < params.cylinderCount; ++i) {
+        CombustionChamber::Parameters chamberParams;
+        chamberParams.CrankcasePressure = reader->readDouble();
+        chamberParams.MeanPistonSpeedToTurbulence =
+            lookup(tables->functions, reader->readIndex(functionCount));
+        chamberParams.StartingPressure = units::pressure(1.0, units::atm);
+        chamberParams.StartingTemperature = units::celcius(25.0);
+        chamberParams.FuelPtr = engine->getFuel();
+        chamberParams.PistonPtr = engine->getPiston(i);
+        chamberParams.Head = engine->getHead(chamberParams.PistonPtr->getCylinderBank()->getIndex());
+        if (reader->failed()) return false;
+
+        engine->getChamber(i)->initialize(chamberParams);
+    }
+
+    return true;
+}
+
+Vehicle *readVehicle(Reader *reader) {
+    if (!reader->readBool()) return nullptr;
+
+    Vehicle::Parameters params;
+    params.mass = reader->readDouble();
+    params.dragCoefficient = reader->readDouble();
+    params.crossSectionArea = reader->readDouble();
+    params.diffRatio = reader->readDouble();
+    params.tireRadius = reader->readDouble();
+    params.rollingResistance = reader->readDouble();
+    if (reader->failed()) return nullptr;
+
+    Vehicle *vehicle = new Vehicle;
+    vehicle->initialize(params);
+    return vehicle;
+}
+
+Transmission *readTransmission(Reader *reader) {
+    if (!reader->readBool()) return nullptr;
+
+    const double maxClutchTorque = reader->readDouble();
+    const int gearCount = reader->readCount(sizeof(double));
+    std::vector<double> gearRatios(gearCount);
+    for (int i = 0; i < gearCount; ++i) {
+        gearRatios[i] = reader->readDouble();
+    }
+
+    if (reader->failed()) return nullptr;
+
+    Transmission::Parameters params;
+    params.GearCount = gearCount;
+    params.GearRatios = gearRatios.data();
+    params.MaxClutchTorque = maxClutchTorque;
+
+    Transmission *transmission = new Transmission;
+    transmission->initialize(params);
+    return transmission;
+}
+} /* namespace */
+
+bool EngineSnapshot::write(
+    const std::string &path,
+    Engine *engine,
+    Vehicle *vehicle,
+    Transmission *transmission)
+{
+    std::vector<char> data;
+    if (!write(&data, engine, vehicle, transmission)) return false;
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+    return (std::fclose(file) == 0) && written;
+}
+
+bool EngineSnapshot::write(
+    std::vector<char> *data,
+    Engine *engine,
+    Vehicle *vehicle,
+    Transmission *transmission)
+{
+    if (engine == nullptr) return false;
+
+    Writer writer;
+    if (!writeEngine(&writer, engine, vehicle, transmission, false)) return false;
+
+    const std::vector<char> &payload = writer.getData();
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.payloadSize = payload.size();
+    header.checksum = hashBytes(payload.data(), payload.size());
+
+    const char *headerBytes = reinterpret_cast<const char *>(&header);
+    data->assign(headerBytes, headerBytes + sizeof(Header));
+    data->insert(data->end(), payload.begin(), payload.end());
+
+    return true;
+}
+
+bool EngineSnapshot::hashStructure(
+    Engine *engine,
+    Vehicle *vehicle,
+    Transmission *transmission,
+    uint64_t *hash)
+{
+    if (engine == nullptr) return false;
+
+    Writer writer;
+    if (!writeEngine(&writer, engine, vehicle, transmission, true)) return false;
+
+    *hash = hashBytes(writer.getData().data(), writer.getData().size());
+    return true;
+}
+
+void EngineSnapshot::collectFunctions(Engine *engine, std::vector<Function *> *functions) {
+    Tables tables;
+    collectTables(engine, &tables);
+    *functions = tables.functions;
+}
+
+void EngineSnapshot::collectImpulseResponses(
+    Engine *engine,
+    std::vector<ImpulseResponse *> *impulseResponses)
+{
+    Tables tables;
+    collectTables(engine, &tables);
+    *impulseResponses = tables.impulseResponses;
+}
+
+EngineSnapshot::SharedTables::SharedTables() {
+    m_filled = false;
+}
+
+EngineSnapshot::SharedTables::~SharedTables() {
+    release();
+}
+
+void EngineSnapshot::SharedTables::release() {
+    for (Function *function : m_functions) {
+        function->destroy();
+        delete function;
+    }
+
+    m_functions.clear();
+    m_lobes.clear();
+    m_filled = false;
+}
+
+void EngineSnapshot::releaseTables(Engine *engine, const SharedTables *shared) {
+    Tables tables;
+    collectTables(engine, &tables);
+
+    if (shared != nullptr) {
+        tables.functions.erase(
+            std::remove_if(
+                tables.functions.begin(),
+                tables.functions.end(),
+                [shared](Function *function) {
+                    return std::find(
+                        shared->m_functions.begin(), shared->m_functions.end(), function)
+                        != shared->m_functions.end();
+                }),
+            tables.functions.end());
+    }
+
+    tables.release();
+}
+
+bool EngineSnapshot::read(
+    const std::string &path,
+    Engine **engine,
+    Vehicle **vehicle,
+    Transmission **transmission)
+{
+    return read(path, engine, vehicle, transmission, nullptr);
+}
+
+bool EngineSnapshot::read(
+    const std::string &path,
+    Engine **engine,
+    Vehicle **vehicle,
+    Transmission **transmission,
+    SharedTables *shared)
+{
+    *engine = nullptr;
+    *vehicle = nullptr;
+    *transmission = nullptr;
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    return read(file.getData(), file.getSize(), engine, vehicle, transmission, shared);
+}
+
+bool EngineSnapshot::read(
+    const char *data,
+    size_t size,
+    Engine **engine,
+    Vehicle **vehicle,
+    Transmission **transmission,
+    SharedTables *shared)
+{
+    *engine = nullptr;
+    *vehicle = nullptr;
+    *transmission = nullptr;
+
+    if (data == nullptr || size < sizeof(Header)) return false;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic != Magic || header.version != Version) return false;
+    else if (header.payloadSize != size - sizeof(Header)) return false;
+
+    const char *payload = data + sizeof(Header);
+    if (hashBytes(payload, header.payloadSize) != header.checksum) return false;
+
+    // Functions the shared tables own are left out of a failed read's
+    // cleanup
+    const bool reuse = shared != nullptr && shared->m_filled;
+    const size_t lobes = (shared != nullptr) ? shared->m_lobes.size() : 0;
+    auto fail = [&](Tables *tables) {
+        if (reuse) tables->functions.clear();
+        if (shared != nullptr) shared->m_lobes.resize(lobes);
+        tables->release();
+        return false;
+    };
+
+    Reader reader(payload, header.payloadSize);
+    Tables tables;
+    Engine *newEngine = new Engine;
+    if (!readEngine(
+        &reader,
+        newEngine,
+        &tables,
+        reuse ? &shared->m_functions : nullptr,
+        (shared != nullptr) ? &shared->m_lobes : nullptr))
+    {
+        newEngine->destroy();
+        delete newEngine;
+        return fail(&tables);
+    }
+
+    Vehicle *newVehicle = readVehicle(&reader);
+    Transmission *newTransmission = readTransmission(&reader);
+    if (reader.failed() || !reader.atEnd()) {
+        delete newVehicle;
+        delete newTransmission;
+        newEngine->destroy();
+        delete newEngine;
+        return fail(&tables);
+    }
+
+    if (shared != nullptr && !reuse) {
+        shared->m_functions = tables.functions;
+        shared->m_filled = true;
+    }
+
+    *engine = newEngine;
+    *vehicle = newVehicle;
+    *transmission = newTransmission;
+
+    return true;
+}
@@ -0,0 +1,97 @@
+#include "../include/event_counters.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+const char *CounterNames[] = {
+    "gas_flows",
+    "choked_flows",
+    "equilibrium_clamps",
+    "solver_steps",
+    "ignition_events",
+    "audio_underruns",
+    "audio_overruns",
+    "convolution_samples"
+};
+
+static_assert(
+    sizeof(CounterNames) / sizeof(CounterNames[0]) == EventCounters::CounterCount,
+    "every counter needs a name");
+} /* namespace */
+
+EventCounters::Totals EventCounters::Totals::since(const Totals &earlier) const {
+    Totals difference;
+    for (int i = 0; i < CounterCount; ++i) {
+        difference.values[i] = values[i] - earlier.values[i];
+    }
+
+    return difference;
+}
+
+const char *EventCounters::GetName(Counter counter) {
+    return CounterNames[static_cast<int>(counter)];
+}
+
+#if defined(ATG_ENGINE_SIM_COUNT_EVENTS)
+
+namespace {
+constexpr int MaxThreads = 64;
+
+// Written only by the owning thread; relaxed atomics keep concurrent reads
+// well defined without ordering cost on the writer
+struct ThreadSlot {
+    std::atomic<uint64_t> values[EventCounters::CounterCount];
+};
+
+ThreadSlot g_slots[MaxThreads];
+std::atomic<int> g_slotCount{ 0 };
+
+ThreadSlot *threadSlot() {
+    thread_local ThreadSlot *slot = [] {
+        const int i = g_slotCount.fetch_add(1, std::memory_order_relaxed);
+        return (i < MaxThreads) ? &g_slots[i] : nullptr;
+    }();
+
+    return slot;
+}
+} /* namespace */
+
+bool EventCounters::IsEnabled() {
+    return true;
+}
+
+void EventCounters::Add(Counter counter, uint64_t n) {
+    ThreadSlot *slot = threadSlot();
+    if (slot == nullptr) return;
+
+    std::atomic<uint64_t> &value = slot->values[static_cast<int>(counter)];
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void EventCounters::GetTotals(Totals *totals) {
+    *totals = Totals();
+
+    const int slots = std::min(g_slotCount.load(std::memory_order_relaxed), MaxThreads);
+    for (int i = 0; i < slots; ++i) {
+        for (int j = 0; j < CounterCount; ++j) {
+            totals->values[j] += g_slots[i].values[j].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+#else
+
+bool EventCounters::IsEnabled() {
+    return false;
+}
+
+void EventCounters::Add(Counter counter, uint64_t n) {
+    /* void */
+}
+
+void EventCounters::GetTotals(Totals *totals) {
+    *totals = Totals();
+}
+
+#endif /* ATG_ENGINE_SIM_COUNT_EVENTS */
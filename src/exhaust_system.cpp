@@ -10,9 +10,12 @@ ExhaustSystem::ExhaustSystem() {
     m_primaryTubeLength = 0;
     m_audioVolume = 0;
     m_velocityDecay = 0;
+    m_primarySegments = 0;
     m_flow = 0;
     m_index = -1;
     m_impulseResponse = nullptr;
+
+    m_outletFlow = GasSystem::ReservoirFlowParameters();
 }
 
 ExhaustSystem::~ExhaustSystem() {
@@ -33,15 +36,7 @@ void ExhaustSystem::initialize(const Parameters &params) {
         1.0,
         0.0);
 
-    m_atmosphere.initialize(
-        units::pressure(1.0, units::atm),
-        units::volume(1000.0, units::m3),
-        units::celcius(25.0));
-    m_atmosphere.setGeometry(
-        units::distance(10.0, units::m),
-        units::distance(10.0, units::m),
-        1.0,
-        0.0);
+    setAtmosphere(units::pressure(1.0, units::atm), units::celcius(25.0));
 
     m_primaryFlowRate = params.primaryFlowRate;
     m_audioVolume = params.audioVolume;
@@ -51,31 +46,34 @@ void ExhaustSystem::initialize(const Parameters &params) {
     m_impulseResponse = params.impulseResponse;
     m_length = params.length;
     m_primaryTubeLength = params.primaryTubeLength;
+    m_primarySegments = params.primarySegments;
 }
 
 void ExhaustSystem::destroy() {
     /* void */
 }
 
-void ExhaustSystem::process(double dt) {
+void ExhaustSystem::setAtmosphere(double P, double T) {
     GasSystem::Mix airMix;
     airMix.p_fuel = 0;
     airMix.p_inert = 1.0;
     airMix.p_o2 = 0.0;
 
-    m_atmosphere.reset(units::pressure(1.0, units::atm), units::celcius(25.0), airMix);
-    GasSystem::FlowParameters flowParams;
-    flowParams.crossSectionArea_0 = m_collectorCrossSectionArea;
-    flowParams.crossSectionArea_1 = units::area(10, units::m2);
-    flowParams.direction_x = 1.0;
-    flowParams.direction_y = 0.0;
-    flowParams.dt = dt;
-    flowParams.system_0 = &m_atmosphere;
-    flowParams.system_1 = &m_system;
-    flowParams.k_flow = m_outletFlowRate;
+    m_atmosphere = GasSystem::reservoir(P, T, airMix);
+}
+
+void ExhaustSystem::prepare(double dt) {
+    m_outletFlow.reservoir = &m_atmosphere;
+    m_outletFlow.crossSectionArea = units::area(10, units::m2);
+    m_outletFlow.direction_x = 1.0;
+    m_outletFlow.direction_y = 0.0;
+    m_outletFlow.dt = dt;
+    m_outletFlow.k_flow = m_outletFlowRate;
+}
 
-    m_flow = m_system.flow(flowParams);
+void ExhaustSystem::process() {
+    m_flow = m_system.flow(m_outletFlow);
 
     m_system.dissipateExcessVelocity();
-    m_system.updateVelocity(dt, m_velocityDecay);
+    m_system.updateVelocity(m_outletFlow.dt, m_velocityDecay);
 }
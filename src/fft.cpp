@@ -0,0 +1,96 @@
+#include "../include/fft.h"
+
+#include "../include/constants.h"
+
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+Fft::Fft() {
+    m_twiddles = nullptr;
+    m_bitReverse = nullptr;
+    m_size = 0;
+}
+
+Fft::~Fft() {
+    assert(m_twiddles == nullptr);
+    assert(m_bitReverse == nullptr);
+}
+
+void Fft::initialize(int size) {
+    assert(size > 0 && (size & (size - 1)) == 0);
+
+    destroy();
+
+    m_size = size;
+    m_twiddles = new std::complex<float>[size / 2 + 1];
+    m_bitReverse = new int[size];
+
+    for (int i = 0; i < size / 2 + 1; ++i) {
+        const double theta = -2.0 * constants::pi * i / size;
+        m_twiddles[i] = std::complex<float>(
+            static_cast<float>(std::cos(theta)),
+            static_cast<float>(std::sin(theta)));
+    }
+
+    int bits = 0;
+    while ((1 << bits) < size) ++bits;
+
+    for (int i = 0; i < size; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+
+        m_bitReverse[i] = r;
+    }
+}
+
+void Fft::destroy() {
+    delete[] m_twiddles;
+    delete[] m_bitReverse;
+
+    m_twiddles = nullptr;
+    m_bitReverse = nullptr;
+    m_size = 0;
+}
+
+void Fft::forward(std::complex<float> *data) const {
+    transform(data, false);
+}
+
+void Fft::inverse(std::complex<float> *data) const {
+    transform(data, true);
+}
+
+void Fft::transform(std::complex<float> *data, bool inverse) const {
+    const int n = m_size;
+    for (int i = 0; i < n; ++i) {
+        const int j = m_bitReverse[i];
+        if (i < j) std::swap(data[i], data[j]);
+    }
+
+    for (int length = 2; length <= n; length <<= 1) {
+        const int half = length / 2;
+        const int stride = n / length;
+
+        for (int i = 0; i < n; i += length) {
+            for (int j = 0; j < half; ++j) {
+                const std::complex<float> w = inverse
+                    ? std::conj(m_twiddles[j * stride])
+                    : m_twiddles[j * stride];
+
+                // Written out rather than using operator* to skip the
+                // NaN/inf recovery path of complex multiplication
+                const std::complex<float> a = data[i + j];
+                const std::complex<float> d = data[i + j + half];
+                const std::complex<float> b(
+                    d.real() * w.real() - d.imag() * w.imag(),
+                    d.real() * w.imag() + d.imag() * w.real());
+
+                data[i + j] = a + b;
+                data[i + j + half] = a - b;
+            }
+        }
+    }
+}
@@ -0,0 +1,207 @@
+#include "../include/fidelity_calibration.h"
+
+#include "../include/piston_engine_simulator.h"
+#include "../include/convolution_filter.h"
+#include "../include/random_stream.h"
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace {
+double timeSteps(Simulator *simulator, int steps) {
+    const auto start = std::chrono::steady_clock::now();
+    simulator->startFrameSteps(steps);
+    while (simulator->simulateStep()) {
+        /* void */
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    simulator->endFrame();
+
+    return std::chrono::duration<double, std::micro>(end - start).count() / std::max(1, steps);
+}
+
+// Per sample, over blocks of noise the size the audio thread renders
+double timeConvolution(const ConvolutionFilter &prototype, bool partitioned) {
+    constexpr int BlockSize = 512;
+    constexpr int Blocks = 32;
+
+    ConvolutionFilter filter;
+    filter.initialize(prototype, partitioned);
+
+    std::vector<float> block(BlockSize);
+    RandomStream noise;
+    noise.seed(1, 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Blocks; ++i) {
+        noise.fill(block.data(), BlockSize, -1.0f, 1.0f);
+        filter.f_block(block.data(), block.data(), BlockSize);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    filter.destroy();
+
+    return std::chrono::duration<double, std::micro>(end - start).count() / (BlockSize * Blocks);
+}
+} /* namespace */
+
+FidelityCalibration::Measurement FidelityCalibration::Measure(
+    Simulator *simulator,
+    const Settings &settings)
+{
+    Measurement measurement;
+    measurement.frequency = simulator->getTargetSimulationFrequency();
+    measurement.fluidSteps = simulator->getFluidSimulationSteps();
+
+    // Adaptive substeps choose their own count every step, so only the
+    // frequency is calibrated for them
+    PistonEngineSimulator *piston = dynamic_cast<PistonEngineSimulator *>(simulator);
+    const bool fluid = piston != nullptr && !piston->isAdaptiveFluidSimulationSteps();
+
+    const int steps = std::max(1, settings.measureSteps);
+    const int low = std::max(1, settings.minFluidSteps);
+    const int high = std::max(
+        low + 1,
+        (settings.maxFluidSteps > 0) ? settings.maxFluidSteps : measurement.fluidSteps);
+
+    // The first steps after a load pay for first-touch allocations
+    timeSteps(simulator, steps / 4);
+
+    if (fluid) {
+        piston->setFluidSimulationSteps(low);
+        const double lowCost = timeSteps(simulator, steps);
+        piston->setFluidSimulationSteps(high);
+        const double highCost = timeSteps(simulator, steps);
+        piston->setFluidSimulationSteps(measurement.fluidSteps);
+
+        measurement.substepMicroseconds = std::max(0.0, (highCost - lowCost) / (high - low));
+        measurement.fixedMicroseconds = std::max(0.0, lowCost - measurement.substepMicroseconds * low);
+    }
+    else {
+        measurement.fixedMicroseconds = timeSteps(simulator, steps);
+    }
+
+    // Every channel renders the same way; the longest response is timed
+    const Synthesizer &synthesizer = simulator->synthesizer();
+    int longest = -1;
+    for (int i = 0; i < synthesizer.getInputChannelCount(); ++i) {
+        if (longest < 0
+            || synthesizer.getConvolution(i).getSampleCount()
+                > synthesizer.getConvolution(longest).getSampleCount())
+        {
+            longest = i;
+        }
+    }
+
+    measurement.audioSampleRate = synthesizer.getAudioSampleRate();
+    measurement.convolutionChannels = synthesizer.getInputChannelCount();
+    if (longest >= 0) {
+        const ConvolutionFilter &prototype = synthesizer.getConvolution(longest);
+        measurement.directConvolutionMicroseconds = timeConvolution(prototype, false);
+        measurement.partitionedConvolutionMicroseconds = timeConvolution(prototype, true);
+    }
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "fidelity_calibration measured step_fixed_us=%.3f step_substep_us=%.3f direct_us=%.4f partitioned_us=%.4f",
+        measurement.fixedMicroseconds,
+        measurement.substepMicroseconds,
+        measurement.directConvolutionMicroseconds,
+        measurement.partitionedConvolutionMicroseconds);
+
+    return measurement;
+}
+
+FidelityCalibration::Result FidelityCalibration::Choose(
+    const Measurement &measurement,
+    const Settings &settings)
+{
+    Result result;
+    result.calibrated = true;
+
+    const int maxFrequency = (settings.maxFrequency > 0) ? settings.maxFrequency : measurement.frequency;
+    const int minFrequency = std::min(std::max(1, settings.minFrequency), maxFrequency);
+    const int frequencyStep = std::max(1, settings.frequencyStep);
+    const bool fluid = measurement.substepMicroseconds > 0;
+    const int maxFluidSteps = !fluid
+        ? measurement.fluidSteps
+        : (settings.maxFluidSteps > 0) ? settings.maxFluidSteps : measurement.fluidSteps;
+    const int minFluidSteps = !fluid
+        ? measurement.fluidSteps
+        : std::min(std::max(1, settings.minFluidSteps), maxFluidSteps);
+
+    const auto load = [&](int frequency, int fluidSteps) {
+        return 1E-6 * frequency
+            * (measurement.fixedMicroseconds + measurement.substepMicroseconds * fluidSteps);
+    };
+
+    // Frequency first: it sets the synthesizer's input rate, and the
+    // substeps only refine the gas dynamics within a step
+    result.simulationFrequency = minFrequency;
+    result.fluidSimulationSteps = minFluidSteps;
+    for (int frequency = maxFrequency; frequency >= minFrequency; frequency -= frequencyStep) {
+        if (load(frequency, minFluidSteps) > settings.headroom) continue;
+
+        int fluidSteps = minFluidSteps;
+        while (fluidSteps < maxFluidSteps && load(frequency, fluidSteps + 1) <= settings.headroom) {
+            ++fluidSteps;
+        }
+
+        result.sustainable = true;
+        result.simulationFrequency = frequency;
+        result.fluidSimulationSteps = fluidSteps;
+        break;
+    }
+
+    result.physicsLoad = load(result.simulationFrequency, result.fluidSimulationSteps);
+
+    // Partitioning costs more than it saves for short responses
+    const double direct = measurement.directConvolutionMicroseconds;
+    const double partitioned = measurement.partitionedConvolutionMicroseconds;
+    result.partitionedConvolution = !(direct > 0 && direct < partitioned);
+    result.convolutionLoad = 1E-6 * measurement.audioSampleRate * measurement.convolutionChannels
+        * (result.partitionedConvolution ? partitioned : direct);
+    if (result.convolutionLoad > settings.headroom) result.sustainable = false;
+
+    return result;
+}
+
+void FidelityCalibration::Apply(Simulator *simulator, const Result &result) {
+    if (!result.calibrated) return;
+
+    simulator->setSimulationFrequency(result.simulationFrequency);
+
+    PistonEngineSimulator *piston = dynamic_cast<PistonEngineSimulator *>(simulator);
+    if (piston != nullptr && !piston->isAdaptiveFluidSimulationSteps()) {
+        piston->setFluidSimulationSteps(result.fluidSimulationSteps);
+    }
+
+    if (simulator->synthesizer().isPartitionedConvolution() != result.partitionedConvolution) {
+        simulator->synthesizer().setPartitionedConvolution(result.partitionedConvolution);
+    }
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "fidelity_calibration applied frequency=%d fluid_steps=%d partitioned=%d physics_load=%.3f convolution_load=%.3f sustainable=%d",
+        result.simulationFrequency,
+        result.fluidSimulationSteps,
+        result.partitionedConvolution ? 1 : 0,
+        result.physicsLoad,
+        result.convolutionLoad,
+        result.sustainable ? 1 : 0);
+}
+
+FidelityCalibration::Result FidelityCalibration::Calibrate(
+    Simulator *simulator,
+    const Settings &settings)
+{
+    if (simulator == nullptr || simulator->getEngine() == nullptr) return Result();
+
+    const Result result = Choose(Measure(simulator, settings), settings);
+    Apply(simulator, result);
+
+    return result;
+}
@@ -0,0 +1,468 @@
+#include "../include/file_watcher.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__APPLE__)
+#include <CoreServices/CoreServices.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <map>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+// Upper bound on how long the watcher thread sleeps between checks for
+// shutdown and new watch sets
+constexpr std::chrono::milliseconds IdleWait(100);
+} /* namespace */
+
+#if defined(__APPLE__)
+class FileWatcher::Backend {
+    public:
+        explicit Backend(FileWatcher *watcher) {
+            m_watcher = watcher;
+            m_stream = nullptr;
+            m_queue = dispatch_queue_create("engine-sim.file-watcher", DISPATCH_QUEUE_SERIAL);
+        }
+
+        ~Backend() {
+            release();
+            dispatch_release(m_queue);
+        }
+
+        void subscribe(const std::vector<std::string> &directories) {
+            release();
+            if (directories.empty()) return;
+
+            CFMutableArrayRef paths = CFArrayCreateMutable(nullptr, 0, &kCFTypeArrayCallBacks);
+            for (const std::string &directory : directories) {
+                CFStringRef path = CFStringCreateWithCString(nullptr, directory.c_str(), kCFStringEncodingUTF8);
+                CFArrayAppendValue(paths, path);
+                CFRelease(path);
+            }
+
+            FSEventStreamContext context = {};
+            context.info = m_watcher;
+            m_stream = FSEventStreamCreate(
+                nullptr,
+                &Backend::callback,
+                &context,
+                paths,
+                kFSEventStreamEventIdSinceNow,
+                0.05,
+                kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer);
+            CFRelease(paths);
+
+            if (m_stream != nullptr) {
+                FSEventStreamSetDispatchQueue(m_stream, m_queue);
+                FSEventStreamStart(m_stream);
+            }
+        }
+
+        // Events arrive on the dispatch queue, which wakes the watcher
+        void wait(std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(m_watcher->m_lock);
+            m_watcher->m_cv.wait_for(lock, timeout);
+        }
+
+    private:
+        static void callback(
+            ConstFSEventStreamRef,
+            void *info,
+            size_t eventCount,
+            void *eventPaths,
+            const FSEventStreamEventFlags *,
+            const FSEventStreamEventId *)
+        {
+            FileWatcher *watcher = static_cast<FileWatcher *>(info);
+            char **paths = static_cast<char **>(eventPaths);
+            for (size_t i = 0; i < eventCount; ++i) {
+                watcher->notify(paths[i]);
+            }
+        }
+
+        void release() {
+            if (m_stream != nullptr) {
+                FSEventStreamStop(m_stream);
+                FSEventStreamInvalidate(m_stream);
+                FSEventStreamRelease(m_stream);
+                m_stream = nullptr;
+            }
+        }
+
+        FileWatcher *m_watcher;
+        FSEventStreamRef m_stream;
+        dispatch_queue_t m_queue;
+};
+#elif defined(__linux__)
+class FileWatcher::Backend {
+    public:
+        explicit Backend(FileWatcher *watcher) {
+            m_watcher = watcher;
+            m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        }
+
+        ~Backend() {
+            if (m_fd >= 0) close(m_fd);
+        }
+
+        void subscribe(const std::vector<std::string> &directories) {
+            if (m_fd < 0) return;
+
+            for (const auto &watch : m_watches) {
+                inotify_rm_watch(m_fd, watch.first);
+            }
+
+            m_watches.clear();
+            for (const std::string &directory : directories) {
+                const int wd = inotify_add_watch(
+                    m_fd,
+                    directory.c_str(),
+                    IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+                if (wd >= 0) {
+                    m_watches[wd] = directory;
+                }
+            }
+        }
+
+        void wait(std::chrono::milliseconds timeout) {
+            if (m_fd < 0) {
+                std::this_thread::sleep_for(timeout);
+                return;
+            }
+
+            pollfd descriptor = { m_fd, POLLIN, 0 };
+            if (poll(&descriptor, 1, static_cast<int>(timeout.count())) <= 0) return;
+
+            alignas(inotify_event) char buffer[16 * 1024];
+            ssize_t n;
+            while ((n = read(m_fd, buffer, sizeof(buffer))) > 0) {
+                for (char *p = buffer; p < buffer + n;) {
+                    const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+                    auto watch = m_watches.find(event->wd);
+                    if (event->len > 0 && watch != m_watches.end()) {
+                        m_watcher->notify(watch->second + "/" + event->name);
+                    }
+
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+
+    private:
+        FileWatcher *m_watcher;
+        int m_fd;
+        std::map<int, std::string> m_watches;
+};
+#elif defined(_WIN32)
+class FileWatcher::Backend {
+    public:
+        explicit Backend(FileWatcher *watcher) {
+            m_watcher = watcher;
+        }
+
+        ~Backend() {
+            release();
+        }
+
+        void subscribe(const std::vector<std::string> &directories) {
+            release();
+
+            for (const std::string &directory : directories) {
+                if (m_directories.size() >= MAXIMUM_WAIT_OBJECTS) break;
+
+                Directory *entry = new Directory;
+                entry->path = directory;
+                entry->handle = CreateFileW(
+                    std::filesystem::path(directory).wstring().c_str(),
+                    FILE_LIST_DIRECTORY,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    nullptr,
+                    OPEN_EXISTING,
+                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                    nullptr);
+                entry->overlapped = {};
+                entry->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+                if (entry->handle == INVALID_HANDLE_VALUE || !arm(entry)) {
+                    close(entry);
+                    continue;
+                }
+
+                m_directories.push_back(entry);
+            }
+        }
+
+        void wait(std::chrono::milliseconds timeout) {
+            if (m_directories.empty()) {
+                Sleep(static_cast<DWORD>(timeout.count()));
+                return;
+            }
+
+            std::vector<HANDLE> events;
+            for (Directory *entry : m_directories) {
+                events.push_back(entry->overlapped.hEvent);
+            }
+
+            const DWORD result = WaitForMultipleObjects(
+                static_cast<DWORD>(events.size()),
+                events.data(),
+                FALSE,
+                static_cast<DWORD>(timeout.count()));
+            if (result >= WAIT_OBJECT_0 + events.size()) return;
+
+            Directory *entry = m_directories[result - WAIT_OBJECT_0];
+            DWORD bytes = 0;
+            if (GetOverlappedResult(entry->handle, &entry->overlapped, &bytes, FALSE) && bytes > 0) {
+                const char *p = entry->buffer;
+                while (true) {
+                    const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(p);
+                    const std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                    m_watcher->notify((std::filesystem::path(entry->path) / name).string());
+
+                    if (info->NextEntryOffset == 0) break;
+                    p += info->NextEntryOffset;
+                }
+            }
+
+            ResetEvent(entry->overlapped.hEvent);
+            arm(entry);
+        }
+
+    private:
+        struct Directory {
+            std::string path;
+            HANDLE handle;
+            OVERLAPPED overlapped;
+            alignas(DWORD) char buffer[16 * 1024];
+        };
+
+        static bool arm(Directory *entry) {
+            return ReadDirectoryChangesW(
+                entry->handle,
+                entry->buffer,
+                sizeof(entry->buffer),
+                FALSE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                nullptr,
+                &entry->overlapped,
+                nullptr) != 0;
+        }
+
+        static void close(Directory *entry) {
+            if (entry->handle != INVALID_HANDLE_VALUE) {
+                CancelIo(entry->handle);
+                CloseHandle(entry->handle);
+            }
+
+            if (entry->overlapped.hEvent != nullptr) {
+                CloseHandle(entry->overlapped.hEvent);
+            }
+
+            delete entry;
+        }
+
+        void release() {
+            for (Directory *entry : m_directories) {
+                close(entry);
+            }
+
+            m_directories.clear();
+        }
+
+        FileWatcher *m_watcher;
+        std::vector<Directory *> m_directories;
+};
+#else
+// No change notifications; modification times are compared on the watcher
+// thread instead of the main loop
+class FileWatcher::Backend {
+    public:
+        explicit Backend(FileWatcher *watcher) {
+            m_watcher = watcher;
+        }
+
+        void subscribe(const std::vector<std::string> &) {
+            std::lock_guard<std::mutex> lock(m_watcher->m_lock);
+
+            m_writeTimes.clear();
+            for (const std::string &file : m_watcher->m_files) {
+                std::error_code ec;
+                m_writeTimes.push_back({ file, std::filesystem::last_write_time(file, ec) });
+            }
+        }
+
+        void wait(std::chrono::milliseconds timeout) {
+            std::this_thread::sleep_for(timeout);
+
+            for (auto &entry : m_writeTimes) {
+                std::error_code ec;
+                const auto writeTime = std::filesystem::last_write_time(entry.first, ec);
+                if (writeTime != entry.second) {
+                    entry.second = writeTime;
+                    m_watcher->notify(entry.first);
+                }
+            }
+        }
+
+    private:
+        FileWatcher *m_watcher;
+        std::vector<std::pair<std::string, std::filesystem::file_time_type>> m_writeTimes;
+};
+#endif
+
+FileWatcher::FileWatcher() {
+    m_backend = nullptr;
+    m_thread = nullptr;
+    m_run = false;
+    m_suspended = false;
+    m_debounce = std::chrono::milliseconds(0);
+    m_watchGeneration = 0;
+    m_subscribedGeneration = 0;
+}
+
+FileWatcher::~FileWatcher() {
+    /* void */
+}
+
+void FileWatcher::initialize(int debounceMilliseconds) {
+    m_debounce = std::chrono::milliseconds(debounceMilliseconds);
+    m_backend = new Backend(this);
+    m_run = true;
+    m_thread = new std::thread(&FileWatcher::worker, this);
+}
+
+void FileWatcher::destroy() {
+    if (m_thread != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_run = false;
+        }
+
+        m_cv.notify_all();
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    delete m_backend;
+    m_backend = nullptr;
+
+    m_files.clear();
+    m_pending.clear();
+    m_changes.clear();
+}
+
+void FileWatcher::watch(const std::vector<std::string> &files) {
+    std::set<std::string> normalized;
+    std::set<std::string> directories;
+    for (const std::string &file : files) {
+        const std::string path = normalize(file);
+        normalized.insert(path);
+        directories.insert(std::filesystem::path(path).parent_path().string());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (normalized == m_files) return;
+
+        m_files = normalized;
+        m_directories.assign(directories.begin(), directories.end());
+        ++m_watchGeneration;
+    }
+
+    m_cv.notify_all();
+}
+
+bool FileWatcher::waitForSubscription(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    return m_cv.wait_for(lock, timeout, [this] {
+        return m_subscribedGeneration == m_watchGeneration;
+    });
+}
+
+void FileWatcher::setSuspended(bool suspended) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (suspended == m_suspended) return;
+
+        m_suspended = suspended;
+    }
+
+    m_cv.notify_all();
+}
+
+bool FileWatcher::takeChanges(std::vector<std::string> *files) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_changes.empty()) return false;
+
+    files->assign(m_changes.begin(), m_changes.end());
+    m_changes.clear();
+
+    return true;
+}
+
+void FileWatcher::notify(const std::string &path) {
+    const std::string normalized = normalize(path);
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_files.count(normalized) == 0) return;
+
+        m_pending.insert(normalized);
+        m_lastEvent = std::chrono::steady_clock::now();
+    }
+
+    m_cv.notify_all();
+}
+
+void FileWatcher::worker() {
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (m_run) {
+        if (m_suspended) {
+            m_cv.wait(lock, [this] { return !m_run || !m_suspended; });
+            continue;
+        }
+
+        if (m_subscribedGeneration != m_watchGeneration) {
+            const std::vector<std::string> directories = m_directories;
+            const unsigned long long generation = m_watchGeneration;
+
+            lock.unlock();
+            m_backend->subscribe(directories);
+            lock.lock();
+
+            m_subscribedGeneration = generation;
+            m_cv.notify_all();
+        }
+
+        std::chrono::milliseconds timeout = IdleWait;
+        if (!m_pending.empty()) {
+            const auto now = std::chrono::steady_clock::now();
+            const auto quiet = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastEvent);
+            if (quiet >= m_debounce) {
+                m_changes.insert(m_pending.begin(), m_pending.end());
+                m_pending.clear();
+                continue;
+            }
+
+            timeout = std::min(timeout, m_debounce - quiet);
+        }
+
+        lock.unlock();
+        m_backend->wait(timeout);
+        lock.lock();
+    }
+}
+
+std::string FileWatcher::normalize(const std::string &path) {
+    std::error_code ec;
+    const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    return ec ? std::filesystem::path(path).lexically_normal().string() : canonical.string();
+}
@@ -109,7 +109,7 @@ void FiringOrderDisplay::render() {
                     0,
                     bank->getCylinderCount() - piston->getCylinderIndex() - 1).inset(5.0f);
 
-            const double temperature = chamber->m_system.temperature();
+            const double temperature = chamber->getSystem()->temperature();
 
             const Bounds worldBounds = getRenderBounds(b_cyl);
             const Point position = worldBounds.getPosition(Bounds::center);
@@ -0,0 +1,249 @@
+#include "../include/flight_recorder.h"
+
+#include "../include/debug_trace.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <process.h>
+#define ATG_GETPID _getpid
+#else
+#include <unistd.h>
+#define ATG_GETPID getpid
+#endif
+
+namespace {
+thread_local FlightRecorder *t_current = nullptr;
+
+// Numbers the dumps of every recorder in the process
+std::atomic<int> s_dumpSequence{ 0 };
+
+const char *AnomalyNames[] = { "none", "non_finite", "pressure", "speed", "request" };
+static_assert(
+    sizeof(AnomalyNames) / sizeof(AnomalyNames[0]) == static_cast<int>(FlightRecorder::Anomaly::Count),
+    "anomaly names");
+
+static_assert(sizeof(FlightRecorder::FrameHeader) % sizeof(uint64_t) == 0, "frame alignment");
+static_assert(sizeof(FlightRecorder::BodyState) % sizeof(float) == 0, "frame alignment");
+static_assert(sizeof(FlightRecorder::ChamberState) % sizeof(float) == 0, "frame alignment");
+
+bool allFinite(const float *values, size_t n) {
+    bool finite = true;
+    for (size_t i = 0; i < n; ++i) {
+        finite &= std::isfinite(values[i]);
+    }
+
+    return finite;
+}
+} /* namespace */
+
+FlightRecorder::FlightRecorder() {
+    m_frameSize = 0;
+    m_capacity = 0;
+    m_bodyCount = 0;
+    m_chamberCount = 0;
+    m_written = 0;
+    m_next = 0;
+    m_dumpRequests = 0;
+    m_anomalous = false;
+    m_anomalyDumps = 0;
+    m_dumps = 0;
+}
+
+FlightRecorder::~FlightRecorder() {
+    /* void */
+}
+
+void FlightRecorder::initialize(const Parameters &params) {
+    m_params = params;
+    m_capacity = std::max(params.capacity, 1);
+    m_dumpRequests = DebugTrace::GetDumpRequestCount();
+    m_anomalous = false;
+    m_anomalyDumps = 0;
+    m_dumps = 0;
+    m_lastDumpPath.clear();
+
+    m_ring.clear();
+    setLayout(m_bodyCount, m_chamberCount);
+}
+
+void FlightRecorder::destroy() {
+    if (t_current == this) t_current = nullptr;
+
+    m_ring.clear();
+    m_ring.shrink_to_fit();
+    m_frameSize = 0;
+    m_capacity = 0;
+    m_bodyCount = 0;
+    m_chamberCount = 0;
+    m_written = 0;
+    m_next = 0;
+}
+
+void FlightRecorder::setLayout(int bodies, int chambers) {
+    if (m_capacity <= 0) return;
+
+    const size_t frameSize = GetFrameSize(bodies, chambers);
+    if (!m_ring.empty() && bodies == m_bodyCount && chambers == m_chamberCount) return;
+
+    m_bodyCount = bodies;
+    m_chamberCount = chambers;
+    m_frameSize = frameSize;
+    m_ring.assign((m_frameSize / sizeof(uint64_t)) * m_capacity, 0);
+    m_written = 0;
+    m_next = 0;
+}
+
+size_t FlightRecorder::GetFrameSize(int bodies, int chambers) {
+    const size_t size = sizeof(FrameHeader)
+        + sizeof(BodyState) * bodies
+        + sizeof(ChamberState) * chambers;
+
+    // Every frame starts 8-byte aligned for its header
+    return (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+}
+
+FlightRecorder::Frame FlightRecorder::frameAt(size_t slot) {
+    uint8_t *base = reinterpret_cast<uint8_t *>(m_ring.data()) + slot * m_frameSize;
+
+    Frame frame;
+    frame.header = reinterpret_cast<FrameHeader *>(base);
+    frame.bodies = reinterpret_cast<BodyState *>(base + sizeof(FrameHeader));
+    frame.chambers = reinterpret_cast<ChamberState *>(
+        base + sizeof(FrameHeader) + sizeof(BodyState) * m_bodyCount);
+
+    return frame;
+}
+
+FlightRecorder::Frame FlightRecorder::beginFrame() {
+    return frameAt(m_next);
+}
+
+FlightRecorder::Anomaly FlightRecorder::commit() {
+    const Frame frame = frameAt(m_next);
+    m_next = (m_next + 1 == (size_t)m_capacity) ? 0 : m_next + 1;
+    ++m_written;
+
+    const Anomaly anomaly = check(frame);
+    bool dumped = false;
+    if (anomaly == Anomaly::None) {
+        m_anomalous = false;
+    }
+    else if (!m_anomalous) {
+        m_anomalous = true;
+        if (m_anomalyDumps < m_params.maxAnomalyDumps) {
+            ++m_anomalyDumps;
+            dump(GetAnomalyName(anomaly), anomaly);
+            DebugTrace::RequestDump("physics_anomaly");
+            dumped = true;
+        }
+    }
+
+    // Any request since the last step, including the one just made, which
+    // the anomaly's dump already covers
+    const unsigned long long requests = DebugTrace::GetDumpRequestCount();
+    if (requests != m_dumpRequests) {
+        m_dumpRequests = requests;
+        if (!dumped) dump("request");
+    }
+
+    return anomaly;
+}
+
+FlightRecorder::Anomaly FlightRecorder::check(const Frame &frame) const {
+    // Bodies and chambers are all floats, so one pass covers them
+    const size_t floats =
+        (sizeof(BodyState) * m_bodyCount + sizeof(ChamberState) * m_chamberCount) / sizeof(float);
+    if (!allFinite(reinterpret_cast<const float *>(frame.bodies), floats)) {
+        return Anomaly::NonFinite;
+    }
+
+    for (int i = 0; i < m_chamberCount; ++i) {
+        if (frame.chambers[i].pressure > m_params.pressureLimit) return Anomaly::Pressure;
+    }
+
+    for (int i = 0; i < m_bodyCount; ++i) {
+        if (std::abs(frame.bodies[i].v_theta) > m_params.angularSpeedLimit) return Anomaly::Speed;
+    }
+
+    return Anomaly::None;
+}
+
+std::string FlightRecorder::dump(const char *reason, Anomaly anomaly) {
+    const int frames = getFrameCount();
+    if (frames == 0) return std::string();
+
+    std::filesystem::path directory = m_params.directory;
+    if (directory.empty()) {
+        directory = DebugTrace::IsEnabled() ? DebugTrace::SessionDirectory() : ".";
+    }
+
+    char name[64];
+    std::snprintf(
+        name,
+        sizeof(name),
+        "flight_recorder_%d_%d.bin",
+        static_cast<int>(ATG_GETPID()),
+        s_dumpSequence.fetch_add(1, std::memory_order_relaxed));
+    const std::filesystem::path path = directory / name;
+
+    std::ofstream out(path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return std::string();
+
+    DumpHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = Magic;
+    header.version = Version;
+    header.headerSize = sizeof(DumpHeader);
+    header.frameSize = static_cast<uint32_t>(m_frameSize);
+    header.bodyCount = static_cast<uint32_t>(m_bodyCount);
+    header.chamberCount = static_cast<uint32_t>(m_chamberCount);
+    header.frameCount = static_cast<uint32_t>(frames);
+    header.anomaly = static_cast<uint32_t>(anomaly);
+    header.step = frameAt((m_next == 0) ? m_capacity - 1 : m_next - 1).header->step;
+    std::snprintf(header.reason, sizeof(header.reason), "%s", (reason != nullptr) ? reason : "request");
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // Oldest first: from the next slot once the ring has wrapped
+    const uint8_t *ring = reinterpret_cast<const uint8_t *>(m_ring.data());
+    const size_t first = (m_written > (uint64_t)m_capacity) ? m_next : 0;
+    const size_t tail = std::min((size_t)frames, (size_t)m_capacity - first);
+    out.write(reinterpret_cast<const char *>(ring + first * m_frameSize), (std::streamsize)(tail * m_frameSize));
+    out.write(reinterpret_cast<const char *>(ring), (std::streamsize)((frames - tail) * m_frameSize));
+    if (!out.good()) return std::string();
+
+    ++m_dumps;
+    m_lastDumpPath = path.string();
+    ATG_ENGINE_SIM_TRACE(
+        Simulator,
+        Event,
+        "flight recorder dump reason=%s frames=%d step=%llu path=%s",
+        header.reason,
+        frames,
+        (unsigned long long)header.step,
+        m_lastDumpPath.c_str());
+
+    return m_lastDumpPath;
+}
+
+void FlightRecorder::DumpCurrent(const char *reason) {
+    if (t_current != nullptr) t_current->dump(reason, Anomaly::NonFinite);
+}
+
+FlightRecorder *FlightRecorder::GetCurrent() {
+    return t_current;
+}
+
+void FlightRecorder::SetCurrent(FlightRecorder *recorder) {
+    t_current = recorder;
+}
+
+const char *FlightRecorder::GetAnomalyName(Anomaly anomaly) {
+    const int i = static_cast<int>(anomaly);
+    return (i >= 0 && i < static_cast<int>(Anomaly::Count)) ? AnomalyNames[i] : "unknown";
+}
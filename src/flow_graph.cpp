@@ -0,0 +1,344 @@
+#include "../include/flow_graph.h"
+
+#include "../include/engine.h"
+
+#include <assert.h>
+#include <cmath>
+#include <utility>
+
+namespace {
+void reverse(GasSystem::FlowState *state) {
+    std::swap(state->source, state->sink);
+    std::swap(state->sourcePressure, state->sinkPressure);
+    std::swap(state->sourceCrossSection, state->sinkCrossSection);
+    state->dx = -state->dx;
+    state->dy = -state->dy;
+    state->direction = -state->direction;
+}
+} /* namespace */
+
+FlowGraph::FlowGraph() {
+    m_volumes = nullptr;
+    m_crossSectionArea = nullptr;
+    m_volumeCount = 0;
+
+    m_connections = nullptr;
+    m_connectionCount = 0;
+
+    m_groupedConnections = nullptr;
+    m_groups = nullptr;
+    m_flowStates = nullptr;
+    m_timesteps = nullptr;
+    m_coefficients = nullptr;
+    m_hubCoefficients = nullptr;
+    m_pressureDrops = nullptr;
+
+    m_implicit = false;
+
+    for (int &begin : m_stageBegin) begin = 0;
+    for (int &begin : m_groupBegin) begin = 0;
+}
+
+FlowGraph::~FlowGraph() {
+    assert(m_volumes == nullptr);
+    assert(m_connections == nullptr);
+    assert(m_groups == nullptr);
+}
+
+void FlowGraph::compile(Engine *engine) {
+    destroy();
+
+    const int intakeCount = engine->getIntakeCount();
+    const int exhaustCount = engine->getExhaustSystemCount();
+    const int cylinderCount = engine->getCylinderCount();
+
+    const int volumeCapacity = intakeCount + exhaustCount + 2 * cylinderCount;
+    m_volumes = new GasSystem *[volumeCapacity];
+    m_crossSectionArea = new double[volumeCapacity];
+    m_connections = new Connection[2 * cylinderCount];
+    m_groupedConnections = new int[2 * cylinderCount];
+    m_groups = new Group[2 * cylinderCount];
+    m_flowStates = new GasSystem::FlowState[2 * cylinderCount];
+    m_timesteps = new double[2 * cylinderCount];
+    m_coefficients = new double[2 * cylinderCount];
+    m_hubCoefficients = new double[2 * cylinderCount];
+    m_pressureDrops = new double[2 * cylinderCount];
+
+    for (int i = 0; i < intakeCount; ++i) {
+        Intake *intake = engine->getIntake(i);
+        addVolume(&intake->m_system, intake->getPlenumCrossSectionArea());
+    }
+
+    for (int i = 0; i < exhaustCount; ++i) {
+        ExhaustSystem *exhaust = engine->getExhaustSystem(i);
+        addVolume(exhaust->getSystem(), exhaust->getCollectorCrossSectionArea());
+    }
+
+    // Each chamber's runners are next to each other in the table
+    const int runners = m_volumeCount;
+    for (int i = 0; i < cylinderCount; ++i) {
+        CombustionChamber::FluidState *fluid = engine->getChamber(i)->getFluidState();
+        addVolume(&fluid->intakeRunnerAndManifold, fluid->intakeRunnerCrossSectionArea);
+        addVolume(&fluid->exhaustRunnerAndPrimary, fluid->exhaustRunnerCrossSectionArea);
+    }
+
+    m_stageBegin[(int)Stage::Intake] = m_connectionCount;
+    for (int i = 0; i < cylinderCount; ++i) {
+        CombustionChamber::FluidState *fluid = engine->getChamber(i)->getFluidState();
+
+        Connection &connection = m_connections[m_connectionCount++];
+        connection.system_0 = findVolume(fluid->plenum);
+        connection.system_1 = runners + 2 * i;
+        connection.k_flow = &fluid->manifoldToRunnerFlowRate;
+        connection.pipe = &fluid->intakePipe;
+        connection.valveFlowRate = &fluid->intakeFlowRate;
+        connection.coarsening = &fluid->runnerCoarsening;
+        connection.pendingSubsteps = &fluid->pendingIntakeRunnerSubsteps;
+        connection.pendingTime = &fluid->pendingIntakeRunnerTime;
+        connection.dissipate = true;
+    }
+
+    m_stageBegin[(int)Stage::Exhaust] = m_connectionCount;
+    for (int i = 0; i < cylinderCount; ++i) {
+        CombustionChamber::FluidState *fluid = engine->getChamber(i)->getFluidState();
+
+        Connection &connection = m_connections[m_connectionCount++];
+        connection.system_0 = runners + 2 * i + 1;
+        connection.system_1 = findVolume(fluid->collector);
+        connection.k_flow = &fluid->primaryToCollectorFlowRate;
+        connection.pipe = &fluid->exhaustPipe;
+        connection.valveFlowRate = &fluid->exhaustFlowRate;
+        connection.coarsening = &fluid->runnerCoarsening;
+        connection.pendingSubsteps = &fluid->pendingExhaustRunnerSubsteps;
+        connection.pendingTime = &fluid->pendingExhaustRunnerTime;
+        connection.dissipate = false;
+        connection.hubIsSystem_0 = false;
+    }
+
+    m_stageBegin[(int)Stage::Count] = m_connectionCount;
+
+    groupStage(Stage::Intake);
+    groupStage(Stage::Exhaust);
+}
+
+void FlowGraph::destroy() {
+    if (m_volumes != nullptr) delete[] m_volumes;
+    if (m_crossSectionArea != nullptr) delete[] m_crossSectionArea;
+    if (m_connections != nullptr) delete[] m_connections;
+    if (m_groupedConnections != nullptr) delete[] m_groupedConnections;
+    if (m_groups != nullptr) delete[] m_groups;
+    if (m_flowStates != nullptr) delete[] m_flowStates;
+    if (m_timesteps != nullptr) delete[] m_timesteps;
+    if (m_coefficients != nullptr) delete[] m_coefficients;
+    if (m_hubCoefficients != nullptr) delete[] m_hubCoefficients;
+    if (m_pressureDrops != nullptr) delete[] m_pressureDrops;
+
+    m_volumes = nullptr;
+    m_crossSectionArea = nullptr;
+    m_connections = nullptr;
+    m_groupedConnections = nullptr;
+    m_groups = nullptr;
+    m_flowStates = nullptr;
+    m_timesteps = nullptr;
+    m_coefficients = nullptr;
+    m_hubCoefficients = nullptr;
+    m_pressureDrops = nullptr;
+    m_volumeCount = 0;
+    m_connectionCount = 0;
+
+    for (int &begin : m_stageBegin) begin = 0;
+    for (int &begin : m_groupBegin) begin = 0;
+}
+
+void FlowGraph::sweep(Stage stage, double dt) {
+    const int end = getStageEnd(stage);
+    if (!m_implicit) {
+        for (int i = getStageBegin(stage); i < end; ++i) {
+            double h;
+            if (advance(m_connections[i], dt, &h)) flow(m_connections[i], h);
+        }
+
+        return;
+    }
+
+    // Pipes go first, as they would in chamber order; the lumped joints
+    // that run this substep are left with their timestep for the solve
+    for (int i = getStageBegin(stage); i < end; ++i) {
+        const Connection &connection = m_connections[i];
+
+        double h;
+        m_timesteps[i] = 0;
+        if (!advance(connection, dt, &h)) continue;
+        else if (*connection.pipe != nullptr) flow(connection, h);
+        else m_timesteps[i] = h;
+    }
+
+    const int groupEnd = m_groupBegin[(int)stage + 1];
+    for (int i = m_groupBegin[(int)stage]; i < groupEnd; ++i) {
+        solveGroup(m_groups[i]);
+    }
+}
+
+bool FlowGraph::advance(const Connection &connection, double dt, double *h) {
+    *connection.pendingTime += dt;
+    if (*connection.valveFlowRate == 0
+        && ++*connection.pendingSubsteps < *connection.coarsening)
+    {
+        return false;
+    }
+
+    *h = *connection.pendingTime;
+    *connection.pendingTime = 0;
+    *connection.pendingSubsteps = 0;
+
+    return true;
+}
+
+void FlowGraph::flow(const Connection &connection, double h) {
+    GasSystem *system_0 = m_volumes[connection.system_0];
+    GasSystem *system_1 = m_volumes[connection.system_1];
+    if (*connection.pipe != nullptr) {
+        (*connection.pipe)->flow(h, system_0, system_1);
+    }
+    else {
+        GasSystem::FlowParameters flowParams;
+        flowParams.dt = h;
+        flowParams.k_flow = *connection.k_flow;
+        flowParams.crossSectionArea_0 = m_crossSectionArea[connection.system_0];
+        flowParams.crossSectionArea_1 = m_crossSectionArea[connection.system_1];
+        flowParams.direction_x = 1.0;
+        flowParams.direction_y = 0.0;
+        flowParams.system_0 = system_0;
+        flowParams.system_1 = system_1;
+        GasSystem::flow(flowParams);
+    }
+
+    if (connection.dissipate) {
+        system_1->dissipateExcessVelocity();
+    }
+}
+
+void FlowGraph::solveGroup(const Group &group) {
+    // With x_j the moles joint j moves from the hub to its leaf over h_j,
+    // g_j its conductance and dP_j the hub's pressure over the leaf's,
+    // backward Euler gives
+    //     x_j = h_j g_j (dP_j - Q - b_j x_j),     Q = sum of a_k x_k
+    // where a_j and b_j are the pressure the hub loses and the leaf gains
+    // per mole moved, R T / V at the temperature of the side it comes from.
+    // So x_j = c_j (dP_j - Q) with c_j = h_j g_j / (1 + h_j g_j b_j), and
+    // weighting by a_j and summing over the joints
+    //     Q = sum(a_j c_j dP_j) / (1 + sum(a_j c_j))
+    GasSystem *hub = m_volumes[group.hub];
+    const double hubVolume = hub->volume();
+    if (hubVolume <= 0) return;
+
+    double sumAC = 0, sumACdP = 0;
+    for (int k = group.begin; k < group.end; ++k) {
+        const int i = m_groupedConnections[k];
+        const Connection &connection = m_connections[i];
+        const double h = m_timesteps[i];
+
+        m_coefficients[i] = 0;
+        if (h == 0) continue;
+
+        GasSystem::FlowParameters flowParams;
+        flowParams.dt = h;
+        flowParams.k_flow = *connection.k_flow;
+        flowParams.crossSectionArea_0 = m_crossSectionArea[connection.system_0];
+        flowParams.crossSectionArea_1 = m_crossSectionArea[connection.system_1];
+        flowParams.direction_x = 1.0;
+        flowParams.direction_y = 0.0;
+        flowParams.system_0 = m_volumes[connection.system_0];
+        flowParams.system_1 = m_volumes[connection.system_1];
+
+        GasSystem::FlowState &state = m_flowStates[i];
+        GasSystem::beginFlow(flowParams, &state);
+
+        const double drop = state.sourcePressure - state.sinkPressure;
+        const bool hubIsSource = state.source == hub;
+        const GasSystem *leaf = hubIsSource ? state.sink : state.source;
+        if (drop <= 0 || leaf->volume() <= 0) continue;
+
+        // Secant conductance at the current drop; the flow goes as about
+        // its square root, so this is steepest near equilibrium
+        const double g = GasSystem::flowRate(state) / drop;
+        const double RT = constants::R * state.source->temperature();
+        const double a = RT / hubVolume;
+        const double b = RT / leaf->volume();
+
+        const double hg = h * g;
+        const double c = hg / (1 + hg * b);
+        m_coefficients[i] = c;
+        m_hubCoefficients[i] = a;
+        m_pressureDrops[i] = hubIsSource ? drop : -drop;
+
+        sumAC += a * c;
+        sumACdP += a * c * m_pressureDrops[i];
+    }
+
+    const double Q = sumACdP / (1 + sumAC);
+    for (int k = group.begin; k < group.end; ++k) {
+        const int i = m_groupedConnections[k];
+        const double c = m_coefficients[i];
+        if (c == 0) continue;
+
+        const double x = c * (m_pressureDrops[i] - Q);
+        GasSystem::FlowState &state = m_flowStates[i];
+        if ((x > 0) != (state.source == hub)) reverse(&state);
+
+        GasSystem::endFlow(state, std::abs(x) / state.dt);
+
+        const Connection &connection = m_connections[i];
+        if (connection.dissipate) {
+            m_volumes[connection.system_1]->dissipateExcessVelocity();
+        }
+    }
+}
+
+void FlowGraph::groupStage(Stage stage) {
+    // Hubs in the order they're first met, and their joints in chamber
+    // order, so the solve applies flows in the same order every substep
+    const int begin = getStageBegin(stage), end = getStageEnd(stage);
+    int groupCount = m_groupBegin[(int)stage];
+    int grouped = begin;
+    for (int i = begin; i < end; ++i) {
+        const int hub = m_connections[i].hubIsSystem_0
+            ? m_connections[i].system_0
+            : m_connections[i].system_1;
+
+        bool found = false;
+        for (int j = m_groupBegin[(int)stage]; j < groupCount && !found; ++j) {
+            found = m_groups[j].hub == hub;
+        }
+
+        if (found) continue;
+
+        Group &group = m_groups[groupCount++];
+        group.hub = hub;
+        group.begin = grouped;
+        for (int j = i; j < end; ++j) {
+            const Connection &connection = m_connections[j];
+            const int connectionHub = connection.hubIsSystem_0 ? connection.system_0 : connection.system_1;
+            if (connectionHub == hub) m_groupedConnections[grouped++] = j;
+        }
+
+        group.end = grouped;
+    }
+
+    m_groupBegin[(int)stage + 1] = groupCount;
+}
+
+int FlowGraph::addVolume(GasSystem *system, double crossSectionArea) {
+    m_volumes[m_volumeCount] = system;
+    m_crossSectionArea[m_volumeCount] = crossSectionArea;
+    return m_volumeCount++;
+}
+
+int FlowGraph::findVolume(const GasSystem *system) const {
+    for (int i = 0; i < m_volumeCount; ++i) {
+        if (m_volumes[i] == system) return i;
+    }
+
+    assert(false);
+    return -1;
+}
@@ -0,0 +1,134 @@
+#include "../include/flow_rate_batch.h"
+
+#include "../include/constants.h"
+#include "../include/event_counters.h"
+
+#include <assert.h>
+#include <cmath>
+
+template <typename T_Scalar>
+BasicFlowRateBatch<T_Scalar>::BasicFlowRateBatch() {
+    m_buffer = nullptr;
+
+    m_k_flow = nullptr;
+    m_P0 = nullptr;
+    m_P1 = nullptr;
+    m_T0 = nullptr;
+    m_T1 = nullptr;
+    m_inverseHeatCapacityRatio = nullptr;
+    m_unchokedFlowFactor = nullptr;
+    m_chokedFlowLimit = nullptr;
+    m_chokedFlowRate = nullptr;
+    m_flowRate = nullptr;
+
+    m_count = 0;
+    m_capacity = 0;
+}
+
+template <typename T_Scalar>
+BasicFlowRateBatch<T_Scalar>::~BasicFlowRateBatch() {
+    assert(m_buffer == nullptr);
+}
+
+template <typename T_Scalar>
+void BasicFlowRateBatch<T_Scalar>::initialize(int capacity) {
+    destroy();
+
+    constexpr int Streams = 10;
+    m_capacity = capacity;
+    m_buffer = new T_Scalar[(size_t)Streams * capacity];
+
+    T_Scalar *stream = m_buffer;
+    m_k_flow = stream; stream += capacity;
+    m_P0 = stream; stream += capacity;
+    m_P1 = stream; stream += capacity;
+    m_T0 = stream; stream += capacity;
+    m_T1 = stream; stream += capacity;
+    m_inverseHeatCapacityRatio = stream; stream += capacity;
+    m_unchokedFlowFactor = stream; stream += capacity;
+    m_chokedFlowLimit = stream; stream += capacity;
+    m_chokedFlowRate = stream; stream += capacity;
+    m_flowRate = stream;
+
+    m_count = 0;
+}
+
+template <typename T_Scalar>
+void BasicFlowRateBatch<T_Scalar>::destroy() {
+    if (m_buffer != nullptr) delete[] m_buffer;
+
+    m_buffer = nullptr;
+    m_k_flow = m_P0 = m_P1 = m_T0 = m_T1 = nullptr;
+    m_inverseHeatCapacityRatio = m_unchokedFlowFactor = nullptr;
+    m_chokedFlowLimit = m_chokedFlowRate = m_flowRate = nullptr;
+
+    m_count = 0;
+    m_capacity = 0;
+}
+
+template <typename T_Scalar>
+int BasicFlowRateBatch<T_Scalar>::add(const GasSystem::FlowState &state) {
+    assert(m_count < m_capacity);
+
+    const int i = m_count++;
+    m_k_flow[i] = static_cast<T_Scalar>(state.k_flow);
+    m_P0[i] = static_cast<T_Scalar>(state.sourcePressure);
+    m_P1[i] = static_cast<T_Scalar>(state.sinkPressure);
+    m_T0[i] = static_cast<T_Scalar>(state.source->temperature());
+    m_T1[i] = static_cast<T_Scalar>(state.sink->temperature());
+
+    const GasSystem::FlowConstants &c = state.source->getFlowConstants();
+    m_inverseHeatCapacityRatio[i] = static_cast<T_Scalar>(c.inverseHeatCapacityRatio);
+    m_unchokedFlowFactor[i] = static_cast<T_Scalar>(c.unchokedFlowFactor);
+    m_chokedFlowLimit[i] = static_cast<T_Scalar>(c.chokedFlowLimit);
+    m_chokedFlowRate[i] = static_cast<T_Scalar>(c.chokedFlowRate);
+
+    return i;
+}
+
+template <typename T_Scalar>
+void BasicFlowRateBatch<T_Scalar>::evaluate() {
+    // Mirrors GasSystem::flowRate(); both branches are computed for every
+    // connection and the result is selected per lane.
+    const T_Scalar R = static_cast<T_Scalar>(constants::R);
+    const int n = m_count;
+    for (int i = 0; i < n; ++i) {
+        const bool forward = m_P0[i] > m_P1[i];
+        const T_Scalar direction = forward ? T_Scalar(1) : T_Scalar(-1);
+        const T_Scalar T_0 = forward ? m_T0[i] : m_T1[i];
+        const T_Scalar p_0 = forward ? m_P0[i] : m_P1[i];
+        const T_Scalar p_T = forward ? m_P1[i] : m_P0[i];
+
+        const T_Scalar p_ratio = p_T / p_0;
+        const T_Scalar RT = R * T_0;
+
+        const T_Scalar choked = m_chokedFlowRate[i] / std::sqrt(RT);
+
+        const T_Scalar s = std::pow(p_ratio, m_inverseHeatCapacityRatio[i]);
+        const T_Scalar unchoked = std::sqrt(
+            std::fmax(m_unchokedFlowFactor[i] * (s * (s - p_ratio)), T_Scalar(0)) / RT);
+
+        const T_Scalar flowRate =
+            ((p_ratio <= m_chokedFlowLimit[i]) ? choked : unchoked) * (direction * p_0);
+
+        m_flowRate[i] = (m_k_flow[i] == 0) ? T_Scalar(0) : flowRate * m_k_flow[i];
+    }
+
+#if defined(ATG_ENGINE_SIM_COUNT_EVENTS)
+    // Kept out of the loop above so it still vectorizes
+    uint64_t flows = 0, choked = 0;
+    for (int i = 0; i < n; ++i) {
+        if (m_k_flow[i] == 0) continue;
+
+        const T_Scalar p_ratio = (m_P0[i] > m_P1[i]) ? m_P1[i] / m_P0[i] : m_P0[i] / m_P1[i];
+        ++flows;
+        if (p_ratio <= m_chokedFlowLimit[i]) ++choked;
+    }
+
+    ATG_ENGINE_SIM_COUNT(GasFlows, flows);
+    ATG_ENGINE_SIM_COUNT(ChokedFlows, choked);
+#endif /* ATG_ENGINE_SIM_COUNT_EVENTS */
+}
+
+template class BasicFlowRateBatch<float>;
+template class BasicFlowRateBatch<double>;
@@ -2,8 +2,29 @@
 
 #include "../include/units.h"
 
+#include <algorithm>
 #include <cmath>
 
+namespace {
+constexpr double MinEquivalenceRatio = 0.3;
+constexpr double MaxEquivalenceRatio = 2.2;
+constexpr double ReferenceTemperature = units::kelvin(298);
+constexpr double ReferencePressure = units::pressure(1.0, units::atm);
+
+const double MinRootTemperature = std::sqrt(units::kelvin(250));
+const double MaxRootTemperature = std::sqrt(units::kelvin(2500));
+const double MinRootPressure = std::sqrt(units::pressure(0.3, units::atm));
+const double MaxRootPressure = std::sqrt(units::pressure(200.0, units::atm));
+
+constexpr double axisSample(double x0, double x1, double i) {
+    return x0 + (x1 - x0) * i / (Fuel::BurningVelocitySamples - 1);
+}
+
+constexpr double axisPosition(double x0, double x1, double x) {
+    return (x - x0) * ((Fuel::BurningVelocitySamples - 1) / (x1 - x0));
+}
+} /* namespace */
+
 Fuel::Fuel() {
     m_molecularMass = 0.0;
     m_energyDensity = 0.0;
@@ -15,6 +36,7 @@ Fuel::Fuel() {
     m_maxTurbulenceEffect = 0.0;
     m_burningEfficiencyRandomness = 0.0;
     m_lowEfficiencyAttenuation = 0.0;
+    m_burningVelocityTableError = 0.0;
 }
 
 Fuel::~Fuel() {
@@ -22,6 +44,7 @@ Fuel::~Fuel() {
 }
 
 void Fuel::initialize(const Parameters &params) {
+    m_name = params.name;
     m_molecularMass = params.molecularMass;
     m_energyDensity = params.energyDensity;
     m_density = params.density;
@@ -32,6 +55,13 @@ void Fuel::initialize(const Parameters &params) {
     m_maxDilutionEffect = params.maxDilutionEffect;
     m_maxTurbulenceEffect = params.maxTurbulenceEffect;
     m_lowEfficiencyAttenuation = params.lowEfficiencyAttenuation;
+
+    m_temperatureFactor.clear();
+    m_pressureFactor.clear();
+    m_burningVelocityTableError = 0.0;
+    if (params.tabulateBurningVelocity) {
+        tabulateBurningVelocity();
+    }
 }
 
 double Fuel::flameSpeed(
@@ -50,16 +80,105 @@ double Fuel::flameSpeed(
 
 double Fuel::laminarBurningVelocity(double molecularAfr, double T, double P) const {
     // Assuming fuel is gasoline
+    const double er = molecularAfr / m_molecularAfr;
+
+    if (isBurningVelocityTabulated()
+        && er >= MinEquivalenceRatio && er <= MaxEquivalenceRatio
+        && T > 0 && P > 0)
+    {
+        const double rootT = std::sqrt(T);
+        const double rootP = std::sqrt(P);
+        if (rootT >= MinRootTemperature && rootT <= MaxRootTemperature
+            && rootP >= MinRootPressure && rootP <= MaxRootPressure)
+        {
+            return baseBurningVelocity(er)
+                * sampleBurningVelocityTable(
+                    m_temperatureFactor, er, axisPosition(MinRootTemperature, MaxRootTemperature, rootT))
+                * sampleBurningVelocityTable(
+                    m_pressureFactor, er, axisPosition(MinRootPressure, MaxRootPressure, rootP));
+        }
+    }
+
+    const double T_ratio = T / ReferenceTemperature;
+    const double P_ratio = P / ReferencePressure;
+
+    return baseBurningVelocity(er)
+        * std::pow(T_ratio, temperatureExponent(er))
+        * std::pow(P_ratio, pressureExponent(er));
+}
+
+void Fuel::tabulateBurningVelocity() {
+    constexpr int n = BurningVelocitySamples;
+    m_temperatureFactor.resize(n * n);
+    m_pressureFactor.resize(n * n);
+
+    const auto temperatureFactor = [](double er, double rootT) {
+        return std::pow(rootT * rootT / ReferenceTemperature, temperatureExponent(er));
+    };
+
+    const auto pressureFactor = [](double er, double rootP) {
+        return std::pow(rootP * rootP / ReferencePressure, pressureExponent(er));
+    };
+
+    for (int i = 0; i < n; ++i) {
+        const double er = axisSample(MinEquivalenceRatio, MaxEquivalenceRatio, i);
+        for (int j = 0; j < n; ++j) {
+            m_temperatureFactor[i * n + j] =
+                temperatureFactor(er, axisSample(MinRootTemperature, MaxRootTemperature, j));
+            m_pressureFactor[i * n + j] =
+                pressureFactor(er, axisSample(MinRootPressure, MaxRootPressure, j));
+        }
+    }
+
+    // Cell centres are where bilinear interpolation strays the furthest
+    double temperatureError = 0.0, pressureError = 0.0;
+    for (int i = 0; i < n - 1; ++i) {
+        const double er = axisSample(MinEquivalenceRatio, MaxEquivalenceRatio, i + 0.5);
+        for (int j = 0; j < n - 1; ++j) {
+            const double exactT = temperatureFactor(er, axisSample(MinRootTemperature, MaxRootTemperature, j + 0.5));
+            const double exactP = pressureFactor(er, axisSample(MinRootPressure, MaxRootPressure, j + 0.5));
+            const double tabulatedT = sampleBurningVelocityTable(m_temperatureFactor, er, j + 0.5);
+            const double tabulatedP = sampleBurningVelocityTable(m_pressureFactor, er, j + 0.5);
+
+            temperatureError = std::max(temperatureError, std::abs(tabulatedT - exactT) / exactT);
+            pressureError = std::max(pressureError, std::abs(tabulatedP - exactP) / exactP);
+        }
+    }
+
+    m_burningVelocityTableError =
+        temperatureError + pressureError + temperatureError * pressureError;
+}
+
+double Fuel::sampleBurningVelocityTable(
+    const std::vector<double> &table,
+    double er,
+    double x) const
+{
+    constexpr int n = BurningVelocitySamples;
+    const double u = axisPosition(MinEquivalenceRatio, MaxEquivalenceRatio, er);
+    const int i = std::min(static_cast<int>(u), n - 2);
+    const int j = std::min(static_cast<int>(x), n - 2);
+    const double s = u - i;
+    const double t = x - j;
+
+    const double *row0 = &table[i * n + j];
+    const double *row1 = row0 + n;
+    return (row0[0] + (row0[1] - row0[0]) * t) * (1 - s)
+        + (row1[0] + (row1[1] - row1[0]) * t) * s;
+}
+
+double Fuel::baseBurningVelocity(double er) {
     constexpr double er_m = 1.21;
     constexpr double B_m = units::distance(30.5, units::cm) / units::sec;
     constexpr double B_er = -units::distance(54.9, units::cm) / units::sec;
-    const double er = molecularAfr / m_molecularAfr;
-    const double alpha = 2.4 - 0.271 * std::pow(er, 3.51);
-    const double beta = -0.357 + 0.14 * std::pow(er, 2.77);
 
-    const double S_L_0 = B_m + B_er * (er - er_m) * (er - er_m);
-    const double T_ratio = T / units::kelvin(298);
-    const double P_ratio = P / units::pressure(1.0, units::atm);
+    return B_m + B_er * (er - er_m) * (er - er_m);
+}
+
+double Fuel::temperatureExponent(double er) {
+    return 2.4 - 0.271 * std::pow(er, 3.51);
+}
 
-    return S_L_0 * std::pow(T_ratio, alpha) * std::pow(P_ratio, beta);
+double Fuel::pressureExponent(double er) {
+    return -0.357 + 0.14 * std::pow(er, 2.77);
 }
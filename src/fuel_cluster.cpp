@@ -7,7 +7,6 @@
 #include <cmath>
 
 FuelCluster::FuelCluster() {
-    m_engine = nullptr;
     m_simulator = nullptr;
 }
 
@@ -64,8 +63,8 @@ void FuelCluster::render() {
     const Bounds costUSD = grid.get(bodyBounds, 0, 4);
     drawText(ss.str(), costUSD, 16.0f, Bounds::lm);
 
-    const double travelledDistance = (m_simulator != nullptr && m_simulator->getVehicle() != nullptr)
-        ? m_simulator->getVehicle()->getTravelledDistance()
+    const double travelledDistance = (m_simulator != nullptr)
+        ? m_simulator->getSnapshot().travelledDistance
         : 0.0;
     const double mpg = (fuelConsumed_gallons > 1E-9)
         ? units::convert(travelledDistance, units::mile) / fuelConsumed_gallons
@@ -94,7 +93,7 @@ void FuelCluster::render() {
 }
 
 double FuelCluster::getTotalVolumeFuelConsumed() const {
-    return (m_engine != nullptr)
-        ? m_engine->getTotalVolumeFuelConsumed()
+    return (m_simulator != nullptr)
+        ? m_simulator->getSnapshot().totalFuelConsumed
         : 0.0;
 }
@@ -5,8 +5,19 @@
 #include <assert.h>
 #include <cmath>
 #include <limits>
-
-GaussianFilter *Function::DefaultGaussianFilter = nullptr;
+#include <vector>
+
+GaussianFilter *Function::defaultGaussianFilter() {
+    // Shared and read-only once built; static init is thread-safe so functions
+    // can be constructed from multiple simulator instances concurrently.
+    static GaussianFilter *filter = [] {
+        GaussianFilter *defaultFilter = new GaussianFilter;
+        defaultFilter->initialize(1.0, 3.0, 1024);
+        return defaultFilter;
+    }();
+
+    return filter;
+}
 
 Function::Function() {
     m_x = m_y = nullptr;
@@ -17,11 +28,14 @@ Function::Function() {
     m_yMax = -std::numeric_limits<double>::infinity();
     m_inputScale = 1.0;
     m_outputScale = 1.0;
+    m_revision = 0;
 
-    if (DefaultGaussianFilter == nullptr) {
-        DefaultGaussianFilter = new GaussianFilter;
-        DefaultGaussianFilter->initialize(1.0, 3.0, 1024);
-    }
+    m_bakedTriangle = nullptr;
+    m_bakedGaussian = nullptr;
+    m_bakedX0 = 0;
+    m_bakedInverseStep = 0;
+    m_bakedResolution = 0;
+    m_baked = false;
 
     m_gaussianFilter = nullptr;
 }
@@ -29,6 +43,8 @@ Function::Function() {
 Function::~Function() {
     assert(m_x == nullptr);
     assert(m_y == nullptr);
+    assert(m_bakedTriangle == nullptr);
+    assert(m_bakedGaussian == nullptr);
 }
 
 void Function::initialize(int size, double filterRadius, GaussianFilter *filter) {
@@ -40,10 +56,13 @@ void Function::initialize(int size, double filterRadius, GaussianFilter *filter)
 
     m_gaussianFilter = (filter != nullptr)
         ? filter
-        : DefaultGaussianFilter;
+        : defaultGaussianFilter();
 }
 
 void Function::resize(int newCapacity) {
+    ++m_revision;
+    m_baked = false;
+
     if (newCapacity <= 0) {
         delete[] m_x;
         delete[] m_y;
@@ -79,17 +98,27 @@ void Function::resize(int newCapacity) {
 void Function::destroy() {
     delete[] m_x;
     delete[] m_y;
+    delete[] m_bakedTriangle;
+    delete[] m_bakedGaussian;
 
     m_x = nullptr;
     m_y = nullptr;
+    m_bakedTriangle = nullptr;
+    m_bakedGaussian = nullptr;
+    m_bakedResolution = 0;
+    m_baked = false;
 
     m_capacity = 0;
     m_size = 0;
     m_yMin = std::numeric_limits<double>::infinity();
     m_yMax = -std::numeric_limits<double>::infinity();
+    ++m_revision;
 }
 
 void Function::addSample(double x, double y) {
+    ++m_revision;
+    m_baked = false;
+
     if (m_size + 1 > m_capacity) {
         resize(m_capacity * 2 + 1);
     }
@@ -128,8 +157,144 @@ void Function::addSample(double x, double y) {
     m_y[index] = y;
 }
 
+void Function::setSamples(const double *x, const double *y, int n, bool sorted) {
+    ++m_revision;
+    m_baked = false;
+
+    // Nothing to keep, so a larger capacity is allocated without copying
+    m_size = 0;
+    if (n > m_capacity) {
+        resize(n);
+    }
+
+    if (n <= 0) {
+        m_yMin = std::numeric_limits<double>::infinity();
+        m_yMax = -std::numeric_limits<double>::infinity();
+        return;
+    }
+
+    if (sorted || std::is_sorted(x, x + n)) {
+        std::memcpy(m_x, x, sizeof(double) * (size_t)n);
+        std::memcpy(m_y, y, sizeof(double) * (size_t)n);
+    }
+    else {
+        std::vector<int> order(n);
+        for (int i = 0; i < n; ++i) order[i] = i;
+        std::stable_sort(
+            order.begin(), order.end(),
+            [x](int a, int b) { return x[a] < x[b]; });
+
+        for (int i = 0; i < n; ++i) {
+            m_x[i] = x[order[i]];
+            m_y[i] = y[order[i]];
+        }
+    }
+
+    m_size = n;
+    m_yMin = *std::min_element(m_y, m_y + n);
+    m_yMax = *std::max_element(m_y, m_y + n);
+}
+
+void Function::assign(const Function &other) {
+    if (other.m_size > m_capacity) {
+        resize(other.m_size);
+    }
+
+    m_size = other.m_size;
+    if (m_size > 0) {
+        std::memcpy(m_x, other.m_x, sizeof(double) * (size_t)m_size);
+        std::memcpy(m_y, other.m_y, sizeof(double) * (size_t)m_size);
+    }
+
+    m_yMin = other.m_yMin;
+    m_yMax = other.m_yMax;
+    m_inputScale = other.m_inputScale;
+    m_outputScale = other.m_outputScale;
+    m_filterRadius = other.m_filterRadius;
+
+    ++m_revision;
+    m_baked = false;
+    if (other.m_baked) {
+        bake(other.m_bakedResolution);
+    }
+}
+
+bool Function::matches(const Function &other) const {
+    if (m_size != other.m_size
+        || m_inputScale != other.m_inputScale
+        || m_outputScale != other.m_outputScale
+        || m_filterRadius != other.m_filterRadius
+        || m_baked != other.m_baked
+        || (m_baked && m_bakedResolution != other.m_bakedResolution))
+    {
+        return false;
+    }
+
+    return std::equal(m_x, m_x + m_size, other.m_x)
+        && std::equal(m_y, m_y + m_size, other.m_y);
+}
+
 double Function::sampleTriangle(double x) const {
     x *= m_inputScale;
+    return (m_baked)
+        ? sampleBaked(m_bakedTriangle, x)
+        : evaluateTriangle(x);
+}
+
+double Function::sampleGaussian(double x) const {
+    x *= m_inputScale;
+    return (m_baked)
+        ? sampleBaked(m_bakedGaussian, x)
+        : evaluateGaussian(x);
+}
+
+void Function::bake(int resolution) {
+    m_baked = false;
+    if (m_size < 2 || m_filterRadius <= 0 || resolution <= 0) return;
+
+    if (resolution != m_bakedResolution) {
+        delete[] m_bakedTriangle;
+        delete[] m_bakedGaussian;
+
+        m_bakedTriangle = new double[(size_t)resolution + 1];
+        m_bakedGaussian = new double[(size_t)resolution + 1];
+        m_bakedResolution = resolution;
+    }
+
+    // The Gaussian keeps changing for one filter support past the last
+    // samples; both filters are constant beyond that. The end samples are
+    // kept on grid points since sampleGaussian() steps there.
+    const double margin = (m_gaussianFilter != nullptr)
+        ? m_filterRadius * m_gaussianFilter->getRadius()
+        : 0.0;
+    const double span = m_x[m_size - 1] - m_x[0];
+    int marginSteps = static_cast<int>(std::ceil(margin * resolution / (span + 2 * margin)));
+    if (resolution - 2 * marginSteps <= 0) marginSteps = 0;
+
+    const double step = span / (resolution - 2 * marginSteps);
+    m_bakedX0 = m_x[0] - marginSteps * step;
+    m_bakedInverseStep = 1.0 / step;
+
+    for (int i = 0; i <= resolution; ++i) {
+        const double x = m_bakedX0 + step * i;
+        m_bakedTriangle[i] = evaluateTriangle(x);
+        m_bakedGaussian[i] = evaluateGaussian(x);
+    }
+
+    m_baked = true;
+}
+
+double Function::sampleBaked(const double *table, double x) const {
+    const double t = (x - m_bakedX0) * m_bakedInverseStep;
+    if (t <= 0) return table[0];
+    else if (t >= m_bakedResolution) return table[m_bakedResolution];
+
+    const int i = static_cast<int>(t);
+    const double s = t - i;
+    return table[i] + s * (table[i + 1] - table[i]);
+}
+
+double Function::evaluateTriangle(double x) const {
     const int closest = closestSample(x);
 
     if (m_size == 0) return 0;
@@ -162,8 +327,7 @@ double Function::sampleTriangle(double x) const {
         : 0;
 }
 
-double Function::sampleGaussian(double x) const {
-    x *= m_inputScale;
+double Function::evaluateGaussian(double x) const {
     const int closest = closestSample(x);
 
     double sum = 0;
@@ -1,8 +1,10 @@
 #include "../include/gas_system.h"
 
+#include "../include/event_counters.h"
 #include "../include/units.h"
 #include "../include/utilities.h"
 
+#include <array>
 #include <cmath>
 #include <cassert>
 
@@ -21,9 +23,7 @@ void GasSystem::initialize(double P, double V, double T, const Mix &mix, int deg
     m_state.mix = mix;
     m_state.momentum[0] = m_state.momentum[1] = 0;
 
-    const double hcr = heatCapacityRatio();
-    m_chokedFlowLimit = chokedFlowLimit(degreesOfFreedom);
-    m_chokedFlowFactorCached = chokedFlowRate(degreesOfFreedom);
+    m_flowConstants = flowConstants(degreesOfFreedom);
 }
 
 void GasSystem::reset(double P, double T, const Mix &mix) {
@@ -180,6 +180,58 @@ double GasSystem::k_carb(double flowRateScfm) {
     );
 }
 
+namespace {
+constexpr int MaxTabulatedDegreesOfFreedom = 8;
+
+GasSystem::FlowConstants computeFlowConstants(
+    double hcr,
+    double chokedFlowLimit,
+    double chokedFlowRate)
+{
+    GasSystem::FlowConstants c;
+    c.heatCapacityRatio = hcr;
+    c.inverseHeatCapacityRatio = 1 / hcr;
+    c.unchokedFlowFactor = (2 * hcr) / (hcr - 1);
+    c.chokedFlowLimit = chokedFlowLimit;
+    c.chokedFlowRate = chokedFlowRate;
+
+    return c;
+}
+} /* namespace */
+
+GasSystem::FlowConstants GasSystem::flowConstants(int degreesOfFreedom) {
+    static const auto table = [] {
+        std::array<FlowConstants, MaxTabulatedDegreesOfFreedom + 1> t;
+        for (int i = 1; i <= MaxTabulatedDegreesOfFreedom; ++i) {
+            t[i] = computeFlowConstants(heatCapacityRatio(i), chokedFlowLimit(i), chokedFlowRate(i));
+        }
+
+        return t;
+    }();
+
+    if (degreesOfFreedom > 0 && degreesOfFreedom <= MaxTabulatedDegreesOfFreedom) {
+        return table[degreesOfFreedom];
+    }
+
+    return computeFlowConstants(
+        heatCapacityRatio(degreesOfFreedom),
+        chokedFlowLimit(degreesOfFreedom),
+        chokedFlowRate(degreesOfFreedom));
+}
+
+GasSystem::Reservoir GasSystem::reservoir(double P, double T, const Mix &mix, int degreesOfFreedom) {
+    Reservoir reservoir;
+    reservoir.P = P;
+    reservoir.T = T;
+    reservoir.molarVolume = constants::R * T / P;
+    reservoir.density = units::AirMolecularMass / reservoir.molarVolume;
+    reservoir.E_k_per_mol = kineticEnergyPerMol(T, degreesOfFreedom);
+    reservoir.flowConstants = flowConstants(degreesOfFreedom);
+    reservoir.mix = mix;
+
+    return reservoir;
+}
+
 double GasSystem::flowRate(
     double k_flow,
     double P0,
@@ -190,42 +242,24 @@ double GasSystem::flowRate(
     double chokedFlowLimit,
     double chokedFlowRateCached)
 {
-    if (k_flow == 0) return 0;
-
-    double direction;
-    double T_0;
-    double p_0, p_T; // p_0 = upstream pressure
-    if (P0 > P1) {
-        direction = 1.0;
-        T_0 = T0;
-        p_0 = P0;
-        p_T = P1;
-    }
-    else {
-        direction = -1.0;
-        T_0 = T1;
-        p_0 = P1;
-        p_T = P0;
-    }
-
-    const double p_ratio = p_T / p_0;
-    double flowRate = 0;
-    if (p_ratio <= chokedFlowLimit) {
-        // Choked flow
-        flowRate = chokedFlowRateCached;
-        flowRate /= std::sqrt(constants::R * T_0);
-    }
-    else {
-        const double s = std::pow(p_ratio, 1 / hcr);
-
-        flowRate = (2 * hcr) / (hcr - 1);
-        flowRate *= s * (s - p_ratio);
-        flowRate = std::sqrt(std::fmax(flowRate, 0.0) / (constants::R * T_0));
-    }
-
-    flowRate *= direction * p_0;
+    return flowRate(
+        k_flow,
+        P0,
+        P1,
+        T0,
+        T1,
+        computeFlowConstants(hcr, chokedFlowLimit, chokedFlowRateCached));
+}
 
-    return flowRate * k_flow;
+double GasSystem::flowRate(
+    double k_flow,
+    double P0,
+    double P1,
+    double T0,
+    double T1,
+    const FlowConstants &flowConstants)
+{
+    return flowRate<double>(k_flow, P0, P1, T0, T1, flowConstants);
 }
 
 double GasSystem::loseN(double dn, double E_k_per_mol) {
@@ -350,12 +384,13 @@ void GasSystem::dissipateVelocity(double dt, double timeConstant) {
 }
 
 double GasSystem::flow(const FlowParameters &params) {
-    GasSystem *source = nullptr, *sink = nullptr;
-    double sourcePressure = 0, sinkPressure = 0;
-    double dx, dy;
-    double sourceCrossSection = 0, sinkCrossSection = 0;
-    double direction = 0;
+    FlowState state;
+    beginFlow(params, &state);
 
+    return endFlow(state, flowRate(state));
+}
+
+void GasSystem::beginFlow(const FlowParameters &params, FlowState *state) {
     const double P_0 =
         params.system_0->pressure()
         + params.system_0->dynamicPressure(params.direction_x, params.direction_y);
@@ -364,37 +399,50 @@ double GasSystem::flow(const FlowParameters &params) {
         + params.system_1->dynamicPressure(-params.direction_x, -params.direction_y);
 
     if (P_0 > P_1) {
-        dx = params.direction_x;
-        dy = params.direction_y;
-        source = params.system_0;
-        sink = params.system_1;
-        sourcePressure = P_0;
-        sinkPressure = P_1;
-        sourceCrossSection = params.crossSectionArea_0;
-        sinkCrossSection = params.crossSectionArea_1;
-        direction = 1.0;
+        state->dx = params.direction_x;
+        state->dy = params.direction_y;
+        state->source = params.system_0;
+        state->sink = params.system_1;
+        state->sourcePressure = P_0;
+        state->sinkPressure = P_1;
+        state->sourceCrossSection = params.crossSectionArea_0;
+        state->sinkCrossSection = params.crossSectionArea_1;
+        state->direction = 1.0;
     }
     else {
-        dx = -params.direction_x;
-        dy = -params.direction_y;
-        source = params.system_1;
-        sink = params.system_0;
-        sourcePressure = P_1;
-        sinkPressure = P_0;
-        sourceCrossSection = params.crossSectionArea_1;
-        sinkCrossSection = params.crossSectionArea_0;
-        direction = -1.0;
+        state->dx = -params.direction_x;
+        state->dy = -params.direction_y;
+        state->source = params.system_1;
+        state->sink = params.system_0;
+        state->sourcePressure = P_1;
+        state->sinkPressure = P_0;
+        state->sourceCrossSection = params.crossSectionArea_1;
+        state->sinkCrossSection = params.crossSectionArea_0;
+        state->direction = -1.0;
     }
 
-    double flow = params.dt * flowRate(
-        params.k_flow,
-        sourcePressure,
-        sinkPressure,
-        source->temperature(),
-        sink->temperature(),
-        source->heatCapacityRatio(),
-        source->m_chokedFlowLimit,
-        source->m_chokedFlowFactorCached);
+    state->k_flow = params.k_flow;
+    state->dt = params.dt;
+}
+
+double GasSystem::flowRate(const FlowState &state) {
+    return flowRate(
+        state.k_flow,
+        state.sourcePressure,
+        state.sinkPressure,
+        state.source->temperature(),
+        state.sink->temperature(),
+        state.source->m_flowConstants);
+}
+
+double GasSystem::endFlow(const FlowState &state, double flowRate) {
+    GasSystem *source = state.source, *sink = state.sink;
+    const double dx = state.dx, dy = state.dy;
+    const double sourceCrossSection = state.sourceCrossSection;
+    const double sinkCrossSection = state.sinkCrossSection;
+    const double direction = state.direction;
+
+    double flow = state.dt * flowRate;
 
     const double maxFlow = source->pressureEquilibriumMaxFlow(sink);
     flow = clamp(flow, 0.0, 0.9 * source->n());
@@ -451,7 +499,7 @@ double GasSystem::flow(const FlowParameters &params) {
 
     if (sinkCrossSection != 0) {
         const double sinkFractionVelocity =
-            clamp((fractionVolume / sinkCrossSection) / params.dt, 0.0, c_sink);
+            clamp((fractionVolume / sinkCrossSection) / state.dt, 0.0, c_sink);
         const double sinkFractionVelocity_squared = sinkFractionVelocity * sinkFractionVelocity;
         const double sinkFractionVelocity_x = sinkFractionVelocity * dx;
         const double sinkFractionVelocity_y = sinkFractionVelocity * dy;
@@ -464,7 +512,7 @@ double GasSystem::flow(const FlowParameters &params) {
 
     if (sourceCrossSection != 0 && sourceMass != 0) {
         const double sourceFractionVelocity =
-            clamp((fractionVolume / sourceCrossSection) / params.dt, 0.0, c_source);
+            clamp((fractionVolume / sourceCrossSection) / state.dt, 0.0, c_source);
         const double sourceFractionVelocity_squared = sourceFractionVelocity * sourceFractionVelocity;
         const double sourceFractionVelocity_x = sourceFractionVelocity * dx;
         const double sourceFractionVelocity_y = sourceFractionVelocity * dy;
@@ -527,11 +575,10 @@ double GasSystem::flow(double k_flow, double dt, double P_env, double T_env, con
         P_env,
         temperature(),
         T_env,
-        heatCapacityRatio(),
-        m_chokedFlowLimit,
-        m_chokedFlowFactorCached);
+        m_flowConstants);
 
     if (std::abs(flow) > std::abs(maxFlow)) {
+        ATG_ENGINE_SIM_COUNT(EquilibriumClamps, 1);
         flow = maxFlow;
     }
 
@@ -553,6 +600,102 @@ double GasSystem::flow(double k_flow, double dt, double P_env, double T_env, con
     return flow;
 }
 
+double GasSystem::flow(const ReservoirFlowParameters &params) {
+    const Reservoir &reservoir = *params.reservoir;
+    const double P = pressure() + dynamicPressure(-params.direction_x, -params.direction_y);
+
+    // Only this system's half of endFlow(); the reservoir's is dropped
+    if (reservoir.P > P) {
+        const double flow = std::fmax(
+            params.dt * flowRate(
+                params.k_flow,
+                reservoir.P,
+                P,
+                reservoir.T,
+                temperature(),
+                reservoir.flowConstants),
+            0.0);
+
+        if (flow != 0) {
+            const double E_k_bulk0 = bulkKineticEnergy();
+            gainN(flow, reservoir.E_k_per_mol, reservoir.mix);
+            m_state.E_k -= bulkKineticEnergy() - E_k_bulk0;
+        }
+
+        pushFraction(
+            flow * reservoir.molarVolume,
+            flow * units::AirMolecularMass,
+            params.crossSectionArea,
+            params.direction_x,
+            params.direction_y,
+            params.dt);
+
+        return flow;
+    }
+    else {
+        if (n() == 0) return 0;
+
+        double flow = params.dt * flowRate(
+            params.k_flow,
+            P,
+            reservoir.P,
+            temperature(),
+            reservoir.T,
+            m_flowConstants);
+        flow = clamp(flow, 0.0, 0.9 * n());
+
+        const double fraction = flow / n();
+        const double fractionVolume = fraction * volume();
+        const double fractionMass = fraction * mass();
+
+        if (flow != 0) {
+            loseN(flow, kineticEnergyPerMol());
+            m_state.momentum[0] -= m_state.momentum[0] * fraction;
+            m_state.momentum[1] -= m_state.momentum[1] * fraction;
+        }
+
+        pushFraction(
+            fractionVolume,
+            fractionMass,
+            params.crossSectionArea,
+            -params.direction_x,
+            -params.direction_y,
+            params.dt);
+
+        return -flow;
+    }
+}
+
+void GasSystem::pushFraction(
+    double fractionVolume,
+    double fractionMass,
+    double crossSectionArea,
+    double dx,
+    double dy,
+    double dt)
+{
+    const double systemMass = mass();
+    if (crossSectionArea != 0 && systemMass != 0) {
+        const double velocity0_x = m_state.momentum[0] / systemMass;
+        const double velocity0_y = m_state.momentum[1] / systemMass;
+
+        const double fractionVelocity =
+            clamp((fractionVolume / crossSectionArea) / dt, 0.0, c());
+        m_state.momentum[0] += fractionVelocity * dx * fractionMass;
+        m_state.momentum[1] += fractionVelocity * dy * fractionMass;
+
+        const double velocity1_x = m_state.momentum[0] / systemMass;
+        const double velocity1_y = m_state.momentum[1] / systemMass;
+
+        m_state.E_k -= 0.5 * systemMass * (velocity1_x * velocity1_x - velocity0_x * velocity0_x);
+        m_state.E_k -= 0.5 * systemMass * (velocity1_y * velocity1_y - velocity0_y * velocity0_y);
+    }
+
+    if (m_state.E_k < 0) {
+        m_state.E_k = 0;
+    }
+}
+
 double GasSystem::pressureEquilibriumMaxFlow(const GasSystem *b) const {
     // pressure_a = (kineticEnergy() + n * b->kineticEnergyPerMol()) / (0.5 * degreesOfFreedom * volume())
     // pressure_b = (b->kineticEnergy() - n *  / (0.5 * b->degreesOfFreedom * b->volume())
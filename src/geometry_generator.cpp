@@ -1,5 +1,15 @@
 #include "../include/geometry_generator.h"
 
+#include "../include/allocation_tracker.h"
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+thread_local GeometryGenerator *t_threadTarget = nullptr;
+} /* namespace */
+
 GeometryGenerator::GeometryGenerator() {
     m_vertexData = nullptr;
     m_indexData = nullptr;
@@ -10,6 +20,14 @@ GeometryGenerator::GeometryGenerator() {
     m_indexBufferSize = 0;
     m_vertexBufferSize = 0;
 
+    m_retainedVertexCount = 0;
+    m_retainedIndexCount = 0;
+
+    m_vertexHighWater = 0;
+    m_indexHighWater = 0;
+
+    m_shapeLog = nullptr;
+
     m_state.subshapeVertexPointer = 0;
 }
 
@@ -18,24 +36,54 @@ GeometryGenerator::~GeometryGenerator() {
 }
 
 void GeometryGenerator::initialize(int vertexBufferSize, int indexBufferSize) {
-    m_vertexData = new dbasic::Vertex[vertexBufferSize];
-    m_indexData = new unsigned short[indexBufferSize];
+    destroy();
 
-    m_vertexBufferSize = vertexBufferSize;
-    m_indexBufferSize = indexBufferSize;
+    m_vertexHighWater = 0;
+    m_indexHighWater = 0;
+
+    grow(
+        std::max(vertexBufferSize, PageVertexCount),
+        std::max(indexBufferSize, PageIndexCount));
 }
 
 void GeometryGenerator::destroy() {
+    if (m_vertexData != nullptr) {
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Event,
+            "geometry_arena destroy vertex_high_water=%d/%d index_high_water=%d/%d",
+            m_vertexHighWater, m_vertexBufferSize,
+            m_indexHighWater, m_indexBufferSize);
+    }
+
     delete[] m_vertexData;
     delete[] m_indexData;
+
+    m_vertexData = nullptr;
+    m_indexData = nullptr;
+    m_vertexBufferSize = 0;
+    m_indexBufferSize = 0;
 }
 
 void GeometryGenerator::reset() {
-    m_state.vertexPointer = 0;
-    m_state.indexPointer = 0;
+    m_vertexHighWater = std::max(m_vertexHighWater, m_state.vertexPointer);
+    m_indexHighWater = std::max(m_indexHighWater, m_state.indexPointer);
+
+    m_state.vertexPointer = m_retainedVertexCount;
+    m_state.indexPointer = m_retainedIndexCount;
     m_state.subshapeVertexPointer = 0;
 }
 
+void GeometryGenerator::retain() {
+    m_retainedVertexCount = m_state.vertexPointer;
+    m_retainedIndexCount = m_state.indexPointer;
+}
+
+void GeometryGenerator::releaseRetained() {
+    m_retainedVertexCount = 0;
+    m_retainedIndexCount = 0;
+    reset();
+}
+
 bool GeometryGenerator::generateFilledCircle(
     const ysVector &normal,
     const ysVector &center,
@@ -45,13 +93,8 @@ bool GeometryGenerator::generateFilledCircle(
     // edge_length = (sin(theta) * radius) * 2
     // theta = arcsin(edge_length / (2 * radius))
 
-    const float angle = std::asinf(maxEdgeLength / (2 * radius));
-    const float steps = ysMath::Constants::TWO_PI / angle;
-
-    int wholeSteps = (int)std::ceilf(steps);
-    wholeSteps = (wholeSteps < 3)
-        ? 3
-        : wholeSteps;
+    const float angle = edgeAngle(maxEdgeLength, radius);
+    const int wholeSteps = curveSegments(ysMath::Constants::TWO_PI, angle);
 
     return generateFilledFanPolygon(
         normal,
@@ -76,9 +119,7 @@ bool GeometryGenerator::generateFilledFanPolygon(
     const int faceCount = segmentCount;
     const int indexCount = faceCount * 3;
 
-    if (vertexCount + m_state.vertexPointer > m_vertexBufferSize ||
-        indexCount + m_state.indexPointer > m_indexBufferSize)
-    {
+    if (!checkCapacity(vertexCount, indexCount)) {
         return false;
     }
 
@@ -132,13 +173,8 @@ bool GeometryGenerator::generateLineRing(
 
     const float maxOuterRadius = params.radius + (params.patternHeight / 2);
 
-    const float angle = std::asinf(params.maxEdgeLength / (2 * maxOuterRadius));
-    const float steps = (actualEndAngle - actualStartAngle) / angle;
-
-    int segmentCount = (int)std::ceilf(steps);
-    segmentCount = (segmentCount < 3)
-        ? 3
-        : segmentCount;
+    const float angle = edgeAngle(params.maxEdgeLength, maxOuterRadius);
+    const int segmentCount = curveSegments(actualEndAngle - actualStartAngle, angle);
 
     const int vertexCount = (segmentCount + 1) * 2;
     const int faceCount = segmentCount * 2;
@@ -146,9 +182,7 @@ bool GeometryGenerator::generateLineRing(
 
     const ysVector up = findOrthogonal(params.normal);
 
-    if (vertexCount + m_state.vertexPointer > m_vertexBufferSize ||
-        indexCount + m_state.indexPointer > m_indexBufferSize)
-    {
+    if (!checkCapacity(vertexCount, indexCount)) {
         return false;
     }
 
@@ -480,13 +514,8 @@ bool GeometryGenerator::generateRing2d(const Ring2dParameters &params) {
 
     startSubshape();
 
-    const float angle = std::asinf(params.maxEdgeLength / (2 * params.outerRadius));
-    const float steps = (params.endAngle - params.startAngle) / angle;
-
-    int segmentCount = (int)std::ceilf(steps);
-    segmentCount = (segmentCount < 3)
-        ? 3
-        : segmentCount;
+    const float angle = edgeAngle(params.maxEdgeLength, params.outerRadius);
+    const int segmentCount = curveSegments(params.endAngle - params.startAngle, angle);
 
     const int vertexCount = (segmentCount + 1) * 2;
     const int faceCount = segmentCount * 2;
@@ -567,15 +596,10 @@ bool GeometryGenerator::generateCircle2d(const Circle2dParameters &params) {
 
     startSubshape();
 
-    float angle = std::asinf(params.maxEdgeLength / (2 * params.radius)) * 2;
+    float angle = edgeAngle(params.maxEdgeLength, params.radius) * 2;
     angle = std::fminf(angle, ysMath::Constants::PI - params.smallestAngle);
 
-    const float steps = ysMath::Constants::TWO_PI / angle;
-
-    int segmentCount = (int)std::ceilf(steps);
-    segmentCount = (segmentCount < 3)
-        ? 3
-        : segmentCount;
+    const int segmentCount = curveSegments(ysMath::Constants::TWO_PI, angle);
 
     const int vertexCount = 1 + segmentCount;
     const int faceCount = segmentCount;
@@ -622,15 +646,10 @@ bool GeometryGenerator::generateCam(const Cam2dParameters &params) {
 
     startSubshape();
 
-    float angle = std::asinf(params.maxEdgeLength / (2 * params.baseRadius)) * 2;
+    float angle = edgeAngle(params.maxEdgeLength, params.baseRadius) * 2;
     angle = std::fminf(angle, ysMath::Constants::PI - params.smallestAngle);
 
-    const float steps = ysMath::Constants::TWO_PI / angle;
-
-    int segmentCount = (int)std::ceilf(steps);
-    segmentCount = (segmentCount < 3)
-        ? 3
-        : segmentCount;
+    const int segmentCount = curveSegments(ysMath::Constants::TWO_PI, angle);
 
     const int vertexCount = 1 + segmentCount;
     const int faceCount = segmentCount;
@@ -965,6 +984,33 @@ bool GeometryGenerator::generatePathSegment(PathParameters &params, bool detache
     return true;
 }
 
+bool GeometryGenerator::generateInstance(const GeometryIndices &mesh, const ysMatrix &transform) {
+    startSubshape();
+
+    if (mesh.VertexCount <= 0 || mesh.FaceCount <= 0) return true;
+    if (!checkCapacity(mesh.VertexCount, mesh.FaceCount * 3)) {
+        return false;
+    }
+
+    // Read after the capacity check, which can move the arena
+    const dbasic::Vertex *source = &m_vertexData[mesh.BaseVertex];
+    for (int i = 0; i < mesh.VertexCount; ++i) {
+        const ysVector4 &pos = source[i].Pos;
+
+        dbasic::Vertex *vertex = writeVertex();
+        vertex->Pos = ysMath::MatMult(transform, ysMath::LoadVector(pos.x, pos.y, pos.z, pos.w));
+        vertex->Normal = source[i].Normal;
+        vertex->TexCoord = source[i].TexCoord;
+    }
+
+    const unsigned short *faces = &m_indexData[mesh.BaseIndex];
+    for (int i = 0; i < mesh.FaceCount; ++i) {
+        writeFace(faces[3 * i + 0], faces[3 * i + 1], faces[3 * i + 2]);
+    }
+
+    return true;
+}
+
 dbasic::Vertex *GeometryGenerator::writeVertex() {
     return &m_vertexData[m_state.vertexPointer++];
 }
@@ -973,11 +1019,81 @@ void GeometryGenerator::startShape() {
     m_state.currentShape.BaseIndex = m_state.indexPointer;
     m_state.currentShape.BaseVertex = m_state.vertexPointer;
     m_state.currentShape.FaceCount = 0;
+    m_state.currentShape.VertexCount = 0;
     m_state.currentShape.VertexData = &m_vertexData[m_state.vertexPointer];
 }
 
 void GeometryGenerator::endShape(GeometryIndices *indices) {
+    m_state.currentShape.VertexCount = m_state.vertexPointer - m_state.currentShape.BaseVertex;
     *indices = m_state.currentShape;
+
+    if (m_shapeLog != nullptr) m_shapeLog->push_back(indices);
+}
+
+bool GeometryGenerator::append(
+    const GeometryGenerator &source,
+    int vertexBegin,
+    int vertexEnd,
+    int indexBegin,
+    int indexEnd,
+    int *vertexOffset,
+    int *indexOffset)
+{
+    // Between shapes, so no shape's vertex limit applies
+    m_state.currentShape = GeometryIndices();
+    if (!checkCapacity(vertexEnd - vertexBegin, indexEnd - indexBegin)) {
+        return false;
+    }
+
+    *vertexOffset = m_state.vertexPointer - vertexBegin;
+    *indexOffset = m_state.indexPointer - indexBegin;
+
+    // Indices are relative to their shape's base vertex, so they copy as is
+    std::copy(
+        source.m_vertexData + vertexBegin,
+        source.m_vertexData + vertexEnd,
+        m_vertexData + m_state.vertexPointer);
+    std::copy(
+        source.m_indexData + indexBegin,
+        source.m_indexData + indexEnd,
+        m_indexData + m_state.indexPointer);
+    m_state.vertexPointer += vertexEnd - vertexBegin;
+    m_state.indexPointer += indexEnd - indexBegin;
+
+    return true;
+}
+
+void GeometryGenerator::rebase(GeometryIndices *indices, int vertexOffset, int indexOffset) const {
+    if (indices->BaseVertex < 0) return;
+
+    indices->BaseVertex += vertexOffset;
+    indices->BaseIndex += indexOffset;
+    indices->VertexData = &m_vertexData[indices->BaseVertex];
+}
+
+float GeometryGenerator::edgeAngle(float edgeLength, float radius) {
+    // edge_length = (sin(theta) * radius) * 2
+    if (!(radius > 0)) return ysMath::Constants::PI / 2;
+    return std::asin(std::fmin(edgeLength / (2 * radius), 1.0f));
+}
+
+int GeometryGenerator::curveSegments(float span, float angle) {
+    const float maxSegments = std::fmax(
+        std::ceil(MaxCurveSegments * std::abs(span) / ysMath::Constants::TWO_PI),
+        (float)MinCurveSegments);
+    const float steps = (angle > 0)
+        ? std::abs(span) / angle
+        : maxSegments;
+
+    return (int)std::ceil(std::fmin(std::fmax(steps, (float)MinCurveSegments), maxSegments));
+}
+
+GeometryGenerator *GeometryGenerator::GetThreadTarget() {
+    return t_threadTarget;
+}
+
+void GeometryGenerator::SetThreadTarget(GeometryGenerator *generator) {
+    t_threadTarget = generator;
 }
 
 void GeometryGenerator::startSubshape() {
@@ -995,9 +1111,80 @@ void GeometryGenerator::writeFace(unsigned short i0, unsigned short i1, unsigned
 }
 
 bool GeometryGenerator::checkCapacity(int vertexCount, int indexCount) {
-    return
-        (vertexCount + m_state.vertexPointer) <= m_vertexBufferSize &&
-        (indexCount + m_state.indexPointer) <= m_indexBufferSize;
+    // Indices are 16 bit and relative to the shape's base vertex, so a single
+    // shape can't address more than that many vertices
+    const int shapeVertices =
+        m_state.vertexPointer - m_state.currentShape.BaseVertex + vertexCount;
+    if (m_state.currentShape.BaseVertex >= 0 && shapeVertices > MaxShapeVertexCount) {
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Event,
+            "geometry_arena shape_overflow vertices=%d max=%d",
+            shapeVertices, MaxShapeVertexCount);
+        return false;
+    }
+
+    const int vertices = m_state.vertexPointer + vertexCount;
+    const int indices = m_state.indexPointer + indexCount;
+    if (vertices <= m_vertexBufferSize && indices <= m_indexBufferSize) {
+        return true;
+    }
+
+    m_vertexHighWater = std::max(m_vertexHighWater, vertices);
+    m_indexHighWater = std::max(m_indexHighWater, indices);
+
+    // Grow by at least half again so a frame that keeps getting busier
+    // doesn't reallocate on every shape
+    grow(
+        std::max(vertices, m_vertexBufferSize + m_vertexBufferSize / 2),
+        std::max(indices, m_indexBufferSize + m_indexBufferSize / 2));
+
+    return true;
+}
+
+void GeometryGenerator::grow(int vertexCount, int indexCount) {
+    ATG_ENGINE_SIM_ALLOCATION_SCOPE(Geometry);
+
+    const int pagedVertices =
+        ((vertexCount + PageVertexCount - 1) / PageVertexCount) * PageVertexCount;
+    const int pagedIndices =
+        ((indexCount + PageIndexCount - 1) / PageIndexCount) * PageIndexCount;
+
+    if (pagedVertices > m_vertexBufferSize) {
+        dbasic::Vertex *vertexData = new dbasic::Vertex[pagedVertices];
+        if (m_vertexData != nullptr) {
+            std::copy(m_vertexData, m_vertexData + m_state.vertexPointer, vertexData);
+            delete[] m_vertexData;
+        }
+
+        m_vertexData = vertexData;
+    }
+
+    if (pagedIndices > m_indexBufferSize) {
+        unsigned short *indexData = new unsigned short[pagedIndices];
+        if (m_indexData != nullptr) {
+            std::copy(m_indexData, m_indexData + m_state.indexPointer, indexData);
+            delete[] m_indexData;
+        }
+
+        m_indexData = indexData;
+    }
+
+    if (m_state.currentShape.BaseVertex >= 0) {
+        m_state.currentShape.VertexData = &m_vertexData[m_state.currentShape.BaseVertex];
+    }
+
+    if (m_vertexBufferSize > 0) {
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Event,
+            "geometry_arena grow vertex_pages=%d->%d index_pages=%d->%d "
+            "vertex_high_water=%d index_high_water=%d",
+            m_vertexBufferSize / PageVertexCount, std::max(pagedVertices, m_vertexBufferSize) / PageVertexCount,
+            m_indexBufferSize / PageIndexCount, std::max(pagedIndices, m_indexBufferSize) / PageIndexCount,
+            m_vertexHighWater, m_indexHighWater);
+    }
+
+    m_vertexBufferSize = std::max(pagedVertices, m_vertexBufferSize);
+    m_indexBufferSize = std::max(pagedIndices, m_indexBufferSize);
 }
 
 ysVector GeometryGenerator::findOrthogonal(const ysVector &v) {
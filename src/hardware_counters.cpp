@@ -0,0 +1,135 @@
+#include "../include/hardware_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif /* __linux__ */
+
+std::atomic<bool> HardwareCounters::s_enabled{ false };
+
+namespace {
+const char *CounterNames[] = {
+    "cycles",
+    "instructions",
+    "cache_misses",
+    "branch_misses"
+};
+
+static_assert(
+    sizeof(CounterNames) / sizeof(CounterNames[0]) == HardwareCounters::CounterCount,
+    "every counter needs a name");
+
+#if defined(__linux__)
+const uint64_t CounterConfigs[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+int openCounter(uint64_t config, int groupLeader) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = (groupLeader < 0) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // This thread, on whichever core it runs
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupLeader, 0));
+}
+#endif /* __linux__ */
+} /* namespace */
+
+HardwareCounters::Sample HardwareCounters::Sample::operator-(const Sample &other) const {
+    Sample difference;
+    for (int i = 0; i < CounterCount; ++i) {
+        difference.values[i] = values[i] - other.values[i];
+    }
+
+    return difference;
+}
+
+HardwareCounters::HardwareCounters() {
+    m_leader = -1;
+    for (int &descriptor : m_descriptors) descriptor = -1;
+}
+
+HardwareCounters::~HardwareCounters() {
+    close();
+}
+
+bool HardwareCounters::open() {
+    close();
+
+#if defined(__linux__)
+    for (int i = 0; i < CounterCount; ++i) {
+        m_descriptors[i] = openCounter(CounterConfigs[i], m_descriptors[0]);
+        if (m_descriptors[i] < 0) {
+            close();
+            return false;
+        }
+    }
+
+    m_leader = m_descriptors[0];
+    ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    return true;
+#else
+    return false;
+#endif /* __linux__ */
+}
+
+void HardwareCounters::close() {
+#if defined(__linux__)
+    for (int &descriptor : m_descriptors) {
+        if (descriptor >= 0) ::close(descriptor);
+        descriptor = -1;
+    }
+#endif /* __linux__ */
+
+    m_leader = -1;
+}
+
+bool HardwareCounters::read(Sample *sample) const {
+    if (m_leader < 0) return false;
+
+#if defined(__linux__)
+    struct {
+        uint64_t count;
+        uint64_t values[CounterCount];
+    } group;
+
+    if (::read(m_leader, &group, sizeof(group)) != static_cast<ssize_t>(sizeof(group))) return false;
+    if (group.count != CounterCount) return false;
+
+    for (int i = 0; i < CounterCount; ++i) {
+        sample->values[i] = group.values[i];
+    }
+
+    return true;
+#else
+    return false;
+#endif /* __linux__ */
+}
+
+const char *HardwareCounters::GetCounterName(Counter counter) {
+    return CounterNames[static_cast<int>(counter)];
+}
+
+void HardwareCounters::SetEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool HardwareCounters::IsSupported() {
+    HardwareCounters counters;
+    return counters.open();
+}
@@ -0,0 +1,2536 @@
+#include "../include/headless_runner.h"
+#include "../include/batch_stepper.h"
+#include "../include/drive_cycle.h"
+#include "../include/dyno_sweep.h"
+#include "../include/parameter_study.h"
+#include "../include/network_stream.h"
+#include "../include/piston_engine_simulator.h"
+#include "../include/debug_trace.h"
+#include "../include/distributed_study.h"
+#include "../include/allocation_tracker.h"
+#include "../include/artifact_cache.h"
+#include "../include/control_surface.h"
+#include "../include/cost_estimate.h"
+#include "../include/cpu_topology.h"
+#include "../include/step_profiler.h"
+#include "../include/fluid_precision.h"
+#include "../include/engine_controller.h"
+#include "../include/engine_snapshot.h"
+#include "../include/event_counters.h"
+#include "../include/fidelity_calibration.h"
+#include "../include/flight_recorder.h"
+#include "../include/impulse_response.h"
+#include "../include/impulse_response_cache.h"
+#include "../include/kernel_dispatch.h"
+#include "../include/metrics_exporter.h"
+#include "../include/simulation_checkpoint.h"
+#include "../include/sound_bank_baker.h"
+#include "../include/sound_bank_player.h"
+#include "../include/synthesizer_replay.h"
+#include "../include/telemetry_export.h"
+#include "../include/telemetry_log.h"
+#include "../include/thread_policy.h"
+#include "../include/units.h"
+#include "../include/warm_start.h"
+#include "../include/wav_file.h"
+#include "../include/wav_writer.h"
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/compiler.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Options {
+    std::string assetPath = ".";
+    std::string scriptPath;
+    std::string scriptParameters;
+    std::string snapshotPath;
+    std::string exportSnapshotPath;
+    std::string loadCheckpointPath;
+    std::string saveCheckpointPath;
+    std::string audioOutputPath;
+    std::string profileTracePath;
+    double duration = 10.0;
+    double frameLength = 1 / 60.0;
+    double starterTime = 1.0;
+    double warmStartRpm = 0.0;
+    double dynoRpm = 0.0;
+    std::string throttle = "0:0.2";
+    bool offline = true;
+    bool lockstep = false;
+    int instances = 1;
+    int fluidThreads = 1;
+    bool batchedFlowRates = false;
+    bool implicitRunnerFlow = false;
+    int runnerCoarsening = 1;
+    int rigidBodyInterval = 1;
+    int speculativeRefinement = 0;
+    bool reducedKinematics = false;
+    bool dynamicStepKernels = false;
+    bool noConstraintPruning = false;
+    bool wiebeBurn = false;
+    bool woschniHeatTransfer = false;
+    int minFluidSteps = 0;
+    int maxFluidSteps = 0;
+    unsigned long long seed = 0;
+    std::string latencyProfile = "balanced";
+    double audioLatency = 0.0;
+    bool reducedAudioMemory = false;
+    double sampleRate = 44100;
+    double telemetryInterval = 0.0;
+    std::string telemetryExport;
+    int telemetryDecimation = 10;
+    std::string telemetryLog;
+    double ecuRate = 0.0;
+    double ecuAfr = 0.0;
+    double ecuIdleRpm = 0.0;
+    double ecuRevLimit = 0.0;
+    int streamPort = -1;
+    int streamFrame = 220;
+    int streamListeners = 32;
+    int metricsPort = -1;
+    std::string midiDevice;
+    int oscPort = -1;
+    int flightRecorderFrames = 0;
+    std::string flightRecorderDirectory;
+    std::string dynoSweep;
+    std::string sweepOutputPath = "dyno_sweep.csv";
+    double sweepThrottle = 1.0;
+    double sweepSettle = 2.0;
+    int sweepCycles = 20;
+    int sweepThreads = 0;
+    bool sweepFixed = false;
+    std::string sweepTolerance;
+    std::string batchSweep;
+    std::string batchOutputPath = "batch_sweep.csv";
+    int batchCopies = 1;
+    double batchMeasure = 1.0;
+    bool audioMetrics = false;
+    bool physicsOnly = false;
+    bool hardwareCounters = false;
+    std::string kernelIsa;
+    bool previewFidelity = false;
+    bool calibrateFidelity = false;
+    bool costEstimate = false;
+    double fidelityHeadroom = 0.7;
+    bool audioCache = false;
+    bool irPreprocessing = true;
+    bool irMinimumPhase = false;
+    double irEnergyThreshold = ImpulseResponseProcessor::Parameters().energyThreshold;
+    std::string artifactCacheDirectory;
+    int artifactCacheSize = 512;
+    bool irReport = false;
+    bool offloadConvolutionTail = false;
+    std::string recordInput;
+    std::string replayInput;
+    std::string bakeSoundBank;
+    std::string bankRpm = "1000:6000:1000";
+    std::string bankThrottle = "0.1,0.4,1.0";
+    int bankCycles = 4;
+    int bankFramesPerCycle = 1024;
+    std::string playSoundBank;
+    std::string captureSynth;
+    std::string replaySynth;
+    std::string replayIr;
+    double replayIrVolume = 0.0;
+    double replayExhaustVolume = 0.0;
+    double replayVolume = -1.0;
+    double replayConvolution = -1.0;
+    std::string study;
+    std::string studyDesign = "grid";
+    int studySamples = 16;
+    std::string studyOutputPath = "parameter_study.csv";
+    int studyCoordinatorPort = -1;
+    std::string studyWorker;
+    int studyDuplicates = 1;
+    std::string driveCycle;
+    std::string driveTargets = "60,100";
+    std::string driveDiffRatios;
+    double driveTime = 60.0;
+    double shiftRpm = 0.0;
+    int driveThreads = 0;
+    bool realtimeAudio = true;
+    bool realtimePhysics = false;
+    int audioCore = -1;
+    int physicsCore = -1;
+    std::string placement = "none";
+};
+
+const char *argumentValue(const char *arg, const char *name) {
+    const size_t n = std::strlen(name);
+    if (std::strncmp(arg, name, n) == 0 && arg[n] == '=') return arg + n + 1;
+    return nullptr;
+}
+
+bool parseArguments(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = nullptr;
+        if ((value = argumentValue(arg, "--asset-path")) != nullptr) options->assetPath = value;
+        else if ((value = argumentValue(arg, "--script")) != nullptr) options->scriptPath = value;
+        else if ((value = argumentValue(arg, "--script-parameters")) != nullptr) options->scriptParameters = value;
+        else if ((value = argumentValue(arg, "--snapshot")) != nullptr) options->snapshotPath = value;
+        else if ((value = argumentValue(arg, "--export-snapshot")) != nullptr) options->exportSnapshotPath = value;
+        else if ((value = argumentValue(arg, "--load-checkpoint")) != nullptr) options->loadCheckpointPath = value;
+        else if ((value = argumentValue(arg, "--save-checkpoint")) != nullptr) options->saveCheckpointPath = value;
+        else if ((value = argumentValue(arg, "--audio-output")) != nullptr) options->audioOutputPath = value;
+        else if ((value = argumentValue(arg, "--profile-trace")) != nullptr) options->profileTracePath = value;
+        else if ((value = argumentValue(arg, "--duration")) != nullptr) options->duration = std::atof(value);
+        else if ((value = argumentValue(arg, "--frame-length")) != nullptr) options->frameLength = std::atof(value);
+        else if ((value = argumentValue(arg, "--starter-time")) != nullptr) options->starterTime = std::atof(value);
+        else if ((value = argumentValue(arg, "--warm-start")) != nullptr) options->warmStartRpm = std::max(0.0, std::atof(value));
+        else if ((value = argumentValue(arg, "--dyno-rpm")) != nullptr) options->dynoRpm = std::atof(value);
+        else if ((value = argumentValue(arg, "--throttle")) != nullptr) options->throttle = value;
+        else if ((value = argumentValue(arg, "--instances")) != nullptr) options->instances = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--fluid-threads")) != nullptr) options->fluidThreads = std::max(1, std::atoi(value));
+        else if (std::strcmp(arg, "--realtime-scheduling") == 0) options->offline = false;
+        else if (std::strcmp(arg, "--lockstep") == 0) options->lockstep = true;
+        else if (std::strcmp(arg, "--no-realtime-audio") == 0) options->realtimeAudio = false;
+        else if (std::strcmp(arg, "--realtime-physics") == 0) options->realtimePhysics = true;
+        else if ((value = argumentValue(arg, "--audio-core")) != nullptr) options->audioCore = std::atoi(value);
+        else if ((value = argumentValue(arg, "--physics-core")) != nullptr) options->physicsCore = std::atoi(value);
+        else if ((value = argumentValue(arg, "--placement")) != nullptr) options->placement = value;
+        else if ((value = argumentValue(arg, "--seed")) != nullptr) options->seed = std::strtoull(value, nullptr, 10);
+        else if ((value = argumentValue(arg, "--latency-profile")) != nullptr) options->latencyProfile = value;
+        else if ((value = argumentValue(arg, "--audio-latency")) != nullptr) options->audioLatency = std::atof(value);
+        else if (std::strcmp(arg, "--reduced-audio-memory") == 0) options->reducedAudioMemory = true;
+        else if ((value = argumentValue(arg, "--sample-rate")) != nullptr) options->sampleRate = std::atof(value);
+        else if ((value = argumentValue(arg, "--telemetry-interval")) != nullptr) options->telemetryInterval = std::atof(value);
+        else if ((value = argumentValue(arg, "--telemetry-export")) != nullptr) options->telemetryExport = value;
+        else if ((value = argumentValue(arg, "--telemetry-decimation")) != nullptr) options->telemetryDecimation = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--telemetry-log")) != nullptr) options->telemetryLog = value;
+        else if ((value = argumentValue(arg, "--ecu-rate")) != nullptr) options->ecuRate = std::atof(value);
+        else if ((value = argumentValue(arg, "--ecu-afr")) != nullptr) options->ecuAfr = std::atof(value);
+        else if ((value = argumentValue(arg, "--ecu-idle-rpm")) != nullptr) options->ecuIdleRpm = std::atof(value);
+        else if ((value = argumentValue(arg, "--ecu-rev-limit")) != nullptr) options->ecuRevLimit = std::atof(value);
+        else if ((value = argumentValue(arg, "--stream-port")) != nullptr) options->streamPort = std::max(0, std::atoi(value));
+        else if ((value = argumentValue(arg, "--stream-frame")) != nullptr) options->streamFrame = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--stream-listeners")) != nullptr) options->streamListeners = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--metrics-port")) != nullptr) options->metricsPort = std::max(0, std::atoi(value));
+        else if ((value = argumentValue(arg, "--midi-device")) != nullptr) options->midiDevice = value;
+        else if ((value = argumentValue(arg, "--osc-port")) != nullptr) options->oscPort = std::max(0, std::atoi(value));
+        else if ((value = argumentValue(arg, "--flight-recorder")) != nullptr) options->flightRecorderFrames = std::max(0, std::atoi(value));
+        else if ((value = argumentValue(arg, "--flight-recorder-dir")) != nullptr) options->flightRecorderDirectory = value;
+        else if ((value = argumentValue(arg, "--dyno-sweep")) != nullptr) options->dynoSweep = value;
+        else if ((value = argumentValue(arg, "--sweep-output")) != nullptr) options->sweepOutputPath = value;
+        else if ((value = argumentValue(arg, "--sweep-throttle")) != nullptr) options->sweepThrottle = std::atof(value);
+        else if ((value = argumentValue(arg, "--sweep-settle")) != nullptr) options->sweepSettle = std::atof(value);
+        else if ((value = argumentValue(arg, "--sweep-cycles")) != nullptr) options->sweepCycles = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--sweep-threads")) != nullptr) options->sweepThreads = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--sweep-tolerance")) != nullptr) options->sweepTolerance = value;
+        else if (std::strcmp(arg, "--sweep-fixed") == 0) options->sweepFixed = true;
+        else if ((value = argumentValue(arg, "--batch-sweep")) != nullptr) options->batchSweep = value;
+        else if ((value = argumentValue(arg, "--batch-output")) != nullptr) options->batchOutputPath = value;
+        else if ((value = argumentValue(arg, "--batch-copies")) != nullptr) options->batchCopies = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--batch-measure")) != nullptr) options->batchMeasure = std::max(0.0, std::atof(value));
+        else if (std::strcmp(arg, "--audio-metrics") == 0) options->audioMetrics = true;
+        else if (std::strcmp(arg, "--physics-only") == 0) options->physicsOnly = true;
+        else if (std::strcmp(arg, "--hardware-counters") == 0) options->hardwareCounters = true;
+        else if ((value = argumentValue(arg, "--kernel-isa")) != nullptr) options->kernelIsa = value;
+        else if ((value = argumentValue(arg, "--fidelity")) != nullptr) {
+            if (std::strcmp(value, "preview") == 0) options->previewFidelity = true;
+            else if (std::strcmp(value, "full") == 0) options->previewFidelity = false;
+            else {
+                std::fprintf(stderr, "expected --fidelity=full|preview\n");
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--calibrate-fidelity") == 0) options->calibrateFidelity = true;
+        else if (std::strcmp(arg, "--cost-estimate") == 0) options->costEstimate = true;
+        else if ((value = argumentValue(arg, "--fidelity-headroom")) != nullptr) options->fidelityHeadroom = std::atof(value);
+        else if (std::strcmp(arg, "--audio-cache") == 0) options->audioCache = true;
+        else if (std::strcmp(arg, "--no-ir-preprocessing") == 0) options->irPreprocessing = false;
+        else if (std::strcmp(arg, "--ir-min-phase") == 0) options->irMinimumPhase = true;
+        else if ((value = argumentValue(arg, "--ir-energy-threshold")) != nullptr) options->irEnergyThreshold = std::atof(value);
+        else if ((value = argumentValue(arg, "--artifact-cache")) != nullptr) options->artifactCacheDirectory = value;
+        else if ((value = argumentValue(arg, "--artifact-cache-size")) != nullptr) options->artifactCacheSize = std::max(0, std::atoi(value));
+        else if ((value = argumentValue(arg, "--ir-cache")) != nullptr) options->artifactCacheDirectory = value;
+        else if (std::strcmp(arg, "--ir-report") == 0) options->irReport = true;
+        else if (std::strcmp(arg, "--offload-convolution-tail") == 0) options->offloadConvolutionTail = true;
+        else if ((value = argumentValue(arg, "--record-input")) != nullptr) options->recordInput = value;
+        else if ((value = argumentValue(arg, "--replay-input")) != nullptr) options->replayInput = value;
+        else if ((value = argumentValue(arg, "--bake-sound-bank")) != nullptr) options->bakeSoundBank = value;
+        else if ((value = argumentValue(arg, "--bank-rpm")) != nullptr) options->bankRpm = value;
+        else if ((value = argumentValue(arg, "--bank-throttle")) != nullptr) options->bankThrottle = value;
+        else if ((value = argumentValue(arg, "--bank-cycles")) != nullptr) options->bankCycles = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--bank-frames")) != nullptr) options->bankFramesPerCycle = std::max(2, std::atoi(value));
+        else if ((value = argumentValue(arg, "--play-sound-bank")) != nullptr) options->playSoundBank = value;
+        else if ((value = argumentValue(arg, "--capture-synth")) != nullptr) options->captureSynth = value;
+        else if ((value = argumentValue(arg, "--replay-synth")) != nullptr) options->replaySynth = value;
+        else if ((value = argumentValue(arg, "--replay-ir")) != nullptr) options->replayIr = value;
+        else if ((value = argumentValue(arg, "--replay-ir-volume")) != nullptr) options->replayIrVolume = std::atof(value);
+        else if ((value = argumentValue(arg, "--replay-exhaust-volume")) != nullptr) options->replayExhaustVolume = std::atof(value);
+        else if ((value = argumentValue(arg, "--replay-volume")) != nullptr) options->replayVolume = std::atof(value);
+        else if ((value = argumentValue(arg, "--replay-convolution")) != nullptr) options->replayConvolution = std::atof(value);
+        else if ((value = argumentValue(arg, "--study")) != nullptr) options->study = value;
+        else if ((value = argumentValue(arg, "--study-design")) != nullptr) options->studyDesign = value;
+        else if ((value = argumentValue(arg, "--study-samples")) != nullptr) options->studySamples = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--study-output")) != nullptr) options->studyOutputPath = value;
+        else if ((value = argumentValue(arg, "--study-coordinator")) != nullptr) options->studyCoordinatorPort = std::max(0, std::atoi(value));
+        else if ((value = argumentValue(arg, "--study-worker")) != nullptr) options->studyWorker = value;
+        else if ((value = argumentValue(arg, "--study-duplicates")) != nullptr) options->studyDuplicates = std::max(0, std::atoi(value));
+        else if ((value = argumentValue(arg, "--drive-cycle")) != nullptr) options->driveCycle = value;
+        else if ((value = argumentValue(arg, "--drive-targets")) != nullptr) options->driveTargets = value;
+        else if ((value = argumentValue(arg, "--drive-diff-ratios")) != nullptr) options->driveDiffRatios = value;
+        else if ((value = argumentValue(arg, "--drive-time")) != nullptr) options->driveTime = std::atof(value);
+        else if ((value = argumentValue(arg, "--drive-threads")) != nullptr) options->driveThreads = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--shift-rpm")) != nullptr) options->shiftRpm = std::atof(value);
+        else if (std::strcmp(arg, "--batched-flow-rates") == 0) options->batchedFlowRates = true;
+        else if (std::strcmp(arg, "--implicit-runner-flow") == 0) options->implicitRunnerFlow = true;
+        else if ((value = argumentValue(arg, "--runner-coarsening")) != nullptr) options->runnerCoarsening = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--rigid-body-interval")) != nullptr) options->rigidBodyInterval = std::max(1, std::atoi(value));
+        else if ((value = argumentValue(arg, "--speculative-steps")) != nullptr) options->speculativeRefinement = std::max(2, std::atoi(value));
+        else if (std::strcmp(arg, "--reduced-kinematics") == 0) options->reducedKinematics = true;
+        else if (std::strcmp(arg, "--dynamic-step-kernels") == 0) options->dynamicStepKernels = true;
+        else if (std::strcmp(arg, "--no-constraint-pruning") == 0) options->noConstraintPruning = true;
+        else if ((value = argumentValue(arg, "--burn-model")) != nullptr) {
+            if (std::strcmp(value, "wiebe") == 0) options->wiebeBurn = true;
+            else if (std::strcmp(value, "flame-front") == 0) options->wiebeBurn = false;
+            else {
+                std::fprintf(stderr, "expected --burn-model=flame-front|wiebe\n");
+                return false;
+            }
+        }
+        else if ((value = argumentValue(arg, "--heat-transfer")) != nullptr) {
+            if (std::strcmp(value, "woschni") == 0) options->woschniHeatTransfer = true;
+            else if (std::strcmp(value, "constant") == 0) options->woschniHeatTransfer = false;
+            else {
+                std::fprintf(stderr, "expected --heat-transfer=constant|woschni\n");
+                return false;
+            }
+        }
+        else if ((value = argumentValue(arg, "--adaptive-fluid-steps")) != nullptr) {
+            if (std::sscanf(value, "%d:%d", &options->minFluidSteps, &options->maxFluidSteps) != 2) {
+                std::fprintf(stderr, "expected --adaptive-fluid-steps=min:max\n");
+                return false;
+            }
+        }
+        else if (std::strncmp(arg, "--debug-trace", 13) == 0) continue;
+        else {
+            std::fprintf(stderr, "unknown argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    // Steps are paced by the wall clock, so the synthesizer must not also
+    // hold the producer back
+    if (options->lockstep) options->offline = false;
+
+    // Listeners play the stream as it arrives, so it has to be produced at
+    // the rate it is played
+    if (options->streamPort >= 0) options->offline = false;
+
+    if (options->scriptPath.empty()) {
+        options->scriptPath = options->assetPath + "/assets/main.mr";
+    }
+
+    if (options->sampleRate <= 0) {
+        std::fprintf(stderr, "--sample-rate must be positive\n");
+        return false;
+    }
+
+    if (options->physicsOnly && (options->audioMetrics || !options->audioOutputPath.empty())) {
+        std::fprintf(stderr, "--physics-only can't be combined with --audio-metrics or --audio-output\n");
+        return false;
+    }
+
+    if (options->physicsOnly && !options->bakeSoundBank.empty()) {
+        std::fprintf(stderr, "--physics-only can't be combined with --bake-sound-bank\n");
+        return false;
+    }
+
+    if (options->physicsOnly && !options->captureSynth.empty()) {
+        std::fprintf(stderr, "--physics-only can't be combined with --capture-synth\n");
+        return false;
+    }
+
+    if (options->placement != "none" && options->placement != "numa") {
+        std::fprintf(stderr, "expected --placement=none|numa\n");
+        return false;
+    }
+
+    if (options->placement == "numa" && (options->audioCore >= 0 || options->physicsCore >= 0)) {
+        std::fprintf(stderr, "--placement=numa can't be combined with --audio-core or --physics-core\n");
+        return false;
+    }
+
+    // Lanes are stepped without any synthesizer output
+    if (!options->batchSweep.empty()) {
+        if (options->audioMetrics || !options->audioOutputPath.empty()) {
+            std::fprintf(stderr, "--batch-sweep can't be combined with --audio-metrics or --audio-output\n");
+            return false;
+        }
+
+        options->physicsOnly = true;
+    }
+
+    // Sweeps, studies and drive cycles only need sound for its metrics
+    if (!options->dynoSweep.empty() || !options->study.empty() || !options->driveCycle.empty()) {
+        options->physicsOnly = !options->audioMetrics;
+    }
+
+    return true;
+}
+
+// Throttle schedule format: "t0:v0,t1:v1,..." with time in seconds
+std::vector<HeadlessRunner::ControlPoint> parseSchedule(const Options &options) {
+    std::vector<HeadlessRunner::ControlPoint> schedule;
+
+    const std::string &s = options.throttle;
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+
+        const std::string entry = s.substr(start, end - start);
+        const size_t colon = entry.find(':');
+        if (colon != std::string::npos) {
+            HeadlessRunner::ControlPoint p;
+            p.time = std::atof(entry.substr(0, colon).c_str());
+            p.throttle = std::atof(entry.substr(colon + 1).c_str());
+            schedule.push_back(p);
+        }
+
+        start = end + 1;
+    }
+
+    if (schedule.empty()) {
+        schedule.push_back(HeadlessRunner::ControlPoint());
+    }
+
+    std::stable_sort(
+        schedule.begin(),
+        schedule.end(),
+        [](const HeadlessRunner::ControlPoint &a, const HeadlessRunner::ControlPoint &b) {
+            return a.time < b.time;
+        });
+
+    // Starter is held for the first part of the run, then released; a warm
+    // start is already running. The release point carries the throttle the
+    // schedule has at that time, so it doesn't bend the ramp it falls on.
+    const double starterTime = (options.warmStartRpm > 0) ? 0.0 : options.starterTime;
+    HeadlessRunner::ControlPoint release = HeadlessRunner::SampleSchedule(schedule, starterTime);
+    release.time = starterTime;
+    release.starter = false;
+    for (HeadlessRunner::ControlPoint &p : schedule) {
+        p.starter = p.time < starterTime;
+    }
+
+    schedule.front().starter = starterTime > 0;
+    schedule.push_back(release);
+    for (HeadlessRunner::ControlPoint &p : schedule) {
+        p.dynoEnabled = options.dynoRpm > 0;
+        p.dynoSpeed = units::rpm(options.dynoRpm);
+    }
+
+    return schedule;
+}
+
+bool loadScript(
+    const Options &options,
+    Engine **engine,
+    Vehicle **vehicle,
+    Transmission **transmission)
+{
+    *engine = nullptr;
+    *vehicle = nullptr;
+    *transmission = nullptr;
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    // Format: "name=value,..."
+    es_script::Compiler::ParameterBindings bindings;
+    const std::string &s = options.scriptParameters;
+    for (size_t start = 0; start < s.size();) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+
+        const std::string entry = s.substr(start, end - start);
+        const size_t equals = entry.find('=');
+        if (equals == std::string::npos || equals == 0) {
+            std::fprintf(stderr, "invalid script parameter '%s'; expected name=value\n", entry.c_str());
+            return false;
+        }
+
+        bindings[entry.substr(0, equals)] = std::atof(entry.c_str() + equals + 1);
+        start = end + 1;
+    }
+
+    es_script::Compiler compiler;
+    compiler.initialize();
+
+    const std::string libraryPath = (std::filesystem::path(options.assetPath) / "es").string();
+    compiler.addSearchPath(libraryPath.c_str());
+
+    const bool compiled = compiler.compile(options.scriptPath.c_str());
+    if (compiled) {
+        const es_script::Compiler::Output output = bindings.empty()
+            ? compiler.execute()
+            : compiler.execute(bindings);
+        *engine = output.engine;
+        *vehicle = output.vehicle;
+        *transmission = output.transmission;
+
+        for (const auto &binding : bindings) {
+            const bool declared = std::any_of(
+                output.parameters.begin(),
+                output.parameters.end(),
+                [&binding](const es_script::Compiler::Parameter &p) { return p.name == binding.first; });
+            if (!declared) {
+                std::fprintf(stderr, "script declares no parameter '%s'\n", binding.first.c_str());
+            }
+        }
+    }
+
+    compiler.destroy();
+#else
+    std::fprintf(stderr, "built without scripting; pass --snapshot=file\n");
+    (void)options;
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+    return *engine != nullptr;
+}
+
+// A snapshot skips the script runtime entirely; otherwise the script is
+// compiled as usual
+bool loadEngine(
+    const Options &options,
+    Engine **engine,
+    Vehicle **vehicle,
+    Transmission **transmission)
+{
+    const bool loaded = options.snapshotPath.empty()
+        ? loadScript(options, engine, vehicle, transmission)
+        : EngineSnapshot::read(options.snapshotPath, engine, vehicle, transmission);
+
+    if (*vehicle == nullptr) {
+        Vehicle::Parameters vehParams;
+        vehParams.mass = units::mass(1597, units::kg);
+        vehParams.diffRatio = 3.42;
+        vehParams.tireRadius = units::distance(10, units::inch);
+        vehParams.dragCoefficient = 0.25;
+        vehParams.crossSectionArea = units::distance(6.0, units::foot) * units::distance(6.0, units::foot);
+        vehParams.rollingResistance = 2000.0;
+        *vehicle = new Vehicle;
+        (*vehicle)->initialize(vehParams);
+    }
+
+    if (*transmission == nullptr) {
+        const double gearRatios[] = { 2.97, 2.07, 1.43, 1.00, 0.84, 0.56 };
+        Transmission::Parameters tParams;
+        tParams.GearCount = 6;
+        tParams.GearRatios = gearRatios;
+        tParams.MaxClutchTorque = units::torque(1000.0, units::ft_lb);
+        *transmission = new Transmission;
+        (*transmission)->initialize(tParams);
+    }
+
+    return loaded;
+}
+
+bool exportSnapshot(const Options &options) {
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+
+    bool exported = loadScript(options, &engine, &vehicle, &transmission);
+    exported = exported
+        && EngineSnapshot::write(options.exportSnapshotPath, engine, vehicle, transmission);
+
+    delete vehicle;
+    delete transmission;
+
+    if (engine != nullptr) {
+        engine->destroy();
+        delete engine;
+    }
+
+    return exported;
+}
+
+struct Instance {
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+    Simulator *simulator = nullptr;
+    HeadlessRunner::Statistics stats;
+};
+
+// The patch, if any, edits the built engine before its simulator exists
+// Each response once per run: its taps before and after preprocessing and
+// how far its spectrum moved
+void reportImpulseResponses(const std::vector<ImpulseResponse *> &responses, double sampleRate) {
+    static std::set<std::string> reported;
+
+    for (ImpulseResponse *response : responses) {
+        if (response == nullptr || !reported.insert(response->getFilename()).second) continue;
+
+        WavFile file;
+        std::shared_ptr<const ImpulseResponseCache::Kernel> kernel =
+            ImpulseResponseCache::Get(response->getFilename(), response->getVolume(), sampleRate);
+        if (kernel == nullptr || !file.load(response->getFilename())) continue;
+
+        ConvolutionFilter original;
+        Synthesizer::prepareImpulseResponse(
+            file.getSamples(),
+            file.getSampleCount(),
+            static_cast<float>(response->getVolume()),
+            &original,
+            file.getSampleRate(),
+            sampleRate);
+
+        const ImpulseResponseProcessor::Report report =
+            ImpulseResponseProcessor::Compare(original, kernel->filter, sampleRate);
+        std::printf(
+            "impulse_response file=%s taps=%d processed=%d max_deviation_db=%.3f mean_deviation_db=%.3f\n",
+            response->getFilename().c_str(),
+            report.originalSamples,
+            report.processedSamples,
+            report.maxDeviation,
+            report.meanDeviation);
+
+        original.destroy();
+    }
+}
+
+bool createInstance(
+    const Options &options,
+    Instance *instance,
+    const std::function<void(Engine *)> &patch = nullptr)
+{
+    if (!loadEngine(options, &instance->engine, &instance->vehicle, &instance->transmission)) {
+        return false;
+    }
+
+    Engine *engine = instance->engine;
+    if (patch) patch(engine);
+
+    Simulator *simulator = engine->createSimulator(
+            instance->vehicle,
+            instance->transmission,
+            options.reducedKinematics,
+            !options.physicsOnly);
+    simulator->setLatencyProfile(
+            LatencyProfile::fromSettings(
+                options.latencyProfile,
+                options.audioLatency,
+                44100,
+                options.reducedAudioMemory));
+    simulator->setAudioSampleRate(options.sampleRate);
+    simulator->setRandomSeed(options.seed);
+    engine->calculateDisplacement();
+    simulator->setSimulationFrequency(static_cast<int>(engine->getSimulationFrequency()));
+
+    if (!options.physicsOnly) {
+        Synthesizer::AudioParameters audioParams = simulator->synthesizer().getAudioParameters();
+        audioParams.inputSampleNoise = static_cast<float>(engine->getInitialJitter());
+        audioParams.airNoise = static_cast<float>(engine->getInitialNoise());
+        audioParams.dF_F_mix = static_cast<float>(engine->getInitialHighFrequencyGain());
+        simulator->synthesizer().setAudioParameters(audioParams);
+
+        std::vector<ImpulseResponse *> responses;
+        for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+            responses.push_back(engine->getExhaustSystem(i)->getImpulseResponse());
+        }
+
+        simulator->synthesizer().setConvolutionTailOffload(options.offloadConvolutionTail);
+
+        // Shared across instances; only the first one decodes
+        std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> kernels;
+        ImpulseResponseCache::Load(
+            responses.data(),
+            static_cast<int>(responses.size()),
+            simulator->getAudioSampleRate(),
+            &kernels);
+        for (int i = 0; i < static_cast<int>(kernels.size()); ++i) {
+            if (kernels[i] != nullptr) {
+                simulator->synthesizer().initializeImpulseResponse(kernels[i]->filter, i);
+            }
+        }
+
+        if (options.irReport) reportImpulseResponses(responses, simulator->getAudioSampleRate());
+
+        simulator->synthesizer().setAnalysisEnabled(options.audioMetrics);
+    }
+
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        engine->getChamber(i)->setBurnModel(options.wiebeBurn
+            ? CombustionChamber::BurnModel::Wiebe
+            : CombustionChamber::BurnModel::FlameFront);
+        engine->getChamber(i)->setHeatTransferModel(options.woschniHeatTransfer
+            ? CombustionChamber::HeatTransferModel::Woschni
+            : CombustionChamber::HeatTransferModel::Constant);
+    }
+
+    simulator->setRigidBodyInterval(options.rigidBodyInterval);
+    if (options.speculativeRefinement > 0) {
+        SpeculativeStepping::Parameters speculativeParams;
+        speculativeParams.refinement = options.speculativeRefinement;
+        simulator->setSpeculativeStepping(true, speculativeParams);
+    }
+
+    PistonEngineSimulator *pistonSimulator = dynamic_cast<PistonEngineSimulator *>(simulator);
+    if (pistonSimulator != nullptr) {
+        pistonSimulator->setFluidThreadCount(options.fluidThreads);
+        pistonSimulator->setBatchedFlowRates(options.batchedFlowRates);
+        pistonSimulator->setImplicitRunnerFlow(options.implicitRunnerFlow);
+        pistonSimulator->setRunnerCoarsening(options.runnerCoarsening);
+        pistonSimulator->setSpecializedStepKernels(!options.dynamicStepKernels);
+        pistonSimulator->setConstraintPruning(!options.noConstraintPruning);
+        if (options.maxFluidSteps > 0) {
+            pistonSimulator->setAdaptiveFluidSimulationSteps(
+                true, options.minFluidSteps, options.maxFluidSteps);
+        }
+    }
+
+    // Timed with the fluid options above in effect, before the audio
+    // thread competes for the core. The timing would make a recorded
+    // session's starting state differ from its replay's.
+    FidelityCalibration::Measurement measurement;
+    bool measured = false;
+    if (options.calibrateFidelity && options.recordInput.empty() && options.replayInput.empty()) {
+        FidelityCalibration::Settings calibrationSettings;
+        calibrationSettings.headroom = options.fidelityHeadroom;
+
+        measurement = FidelityCalibration::Measure(simulator, calibrationSettings);
+        measured = true;
+
+        const FidelityCalibration::Result calibration =
+            FidelityCalibration::Choose(measurement, calibrationSettings);
+        FidelityCalibration::Apply(simulator, calibration);
+        std::printf(
+            "calibration frequency=%d fluid_steps=%d partitioned_convolution=%d physics_load=%.3f convolution_load=%.3f sustainable=%d\n",
+            calibration.simulationFrequency,
+            calibration.fluidSimulationSteps,
+            calibration.partitionedConvolution ? 1 : 0,
+            calibration.physicsLoad,
+            calibration.convolutionLoad,
+            calibration.sustainable ? 1 : 0);
+    }
+
+    // For the settings as they'll run; fitted to this host when calibrated
+    if (options.costEstimate) {
+        const CostEstimate::Inputs inputs = CostEstimate::Gather(simulator);
+        const CostEstimate::Report cost = CostEstimate::Estimate(
+            inputs,
+            measured ? CostEstimate::Fit(measurement, inputs) : CostEstimate::Coefficients(),
+            options.fidelityHeadroom);
+        std::printf(
+            "cost_estimate physics_load=%.3f fluid_load=%.3f synthesis_load=%.3f convolution_load=%.3f"
+            " physics_thread=%.3f audio_thread=%.3f dominant=%s sustainable=%d fitted=%d\n",
+            cost.physicsLoad,
+            cost.fluidLoad,
+            cost.synthesisLoad,
+            cost.convolutionLoad,
+            cost.physicsThreadLoad,
+            cost.audioThreadLoad,
+            cost.terms.front().setting,
+            cost.sustainable ? 1 : 0,
+            measured ? 1 : 0);
+    }
+
+    // After calibration, which steps the engine from where it was loaded
+    if (options.warmStartRpm > 0 && pistonSimulator != nullptr) {
+        WarmStart::Settings warmStartSettings;
+        warmStartSettings.speed = units::rpm(options.warmStartRpm);
+
+        const WarmStart::Result warmStart = WarmStart::Apply(pistonSimulator, warmStartSettings);
+        std::printf(
+            "warm_start rpm=%.0f manifold_kpa=%.1f lit_cylinders=%d\n",
+            options.warmStartRpm,
+            units::convert(warmStart.manifoldPressure, units::kPa),
+            warmStart.litCylinders);
+    }
+
+    if (options.previewFidelity) {
+        simulator->setFidelity(Simulator::Fidelity::Preview);
+    }
+
+    if (options.audioCache) {
+        simulator->setAudioCacheEnabled(true);
+    }
+
+    if (!options.physicsOnly) {
+        simulator->startAudioRenderingThread();
+    }
+
+    instance->simulator = simulator;
+
+    return true;
+}
+
+void destroyInstance(Instance *instance) {
+    if (instance->simulator != nullptr) {
+        instance->simulator->releaseSimulation();
+        delete instance->simulator;
+    }
+
+    delete instance->vehicle;
+    delete instance->transmission;
+
+    if (instance->engine != nullptr) {
+        instance->engine->destroy();
+        delete instance->engine;
+    }
+
+    *instance = Instance();
+}
+
+// Dyno sweep format: "min:max:step" in rpm
+bool parseSweepParameters(const Options &options, DynoSweep::Parameters *sweepParameters) {
+    DynoSweep::Parameters &params = *sweepParameters;
+    if (std::sscanf(options.dynoSweep.c_str(), "%lf:%lf:%lf", &params.minRpm, &params.maxRpm, &params.stepRpm) != 3) {
+        std::fprintf(stderr, "expected --dyno-sweep=min:max:step\n");
+        return false;
+    }
+
+    params.throttle = options.sweepThrottle;
+    params.settleTime = options.sweepSettle;
+    params.measureCycles = options.sweepCycles;
+    params.stopWhenSettled = !options.sweepFixed;
+
+    // Relative tolerances as "torque:rpm:manifold:afr"
+    if (!options.sweepTolerance.empty()) {
+        SteadyStateDetector::Parameters &steadyState = params.steadyState;
+        if (std::sscanf(
+            options.sweepTolerance.c_str(),
+            "%lf:%lf:%lf:%lf",
+            &steadyState.torque.relative,
+            &steadyState.rpm.relative,
+            &steadyState.manifoldPressure.relative,
+            &steadyState.afr.relative) != 4)
+        {
+            std::fprintf(stderr, "expected --sweep-tolerance=torque:rpm:manifold:afr\n");
+            return false;
+        }
+    }
+
+    params.frameLength = options.frameLength;
+    params.audioMetrics = options.audioMetrics;
+    params.threads = (options.sweepThreads > 0)
+        ? options.sweepThreads
+        : std::max(1, (int)std::thread::hardware_concurrency());
+
+    return true;
+}
+
+// Each hold point gets an instance of its own
+bool runDynoSweep(const Options &options) {
+    DynoSweep::Parameters params;
+    if (!parseSweepParameters(options, &params)) return false;
+
+    DynoSweep sweep;
+    sweep.initialize(params);
+
+    std::vector<Instance> instances(sweep.getHoldPoints().size());
+    const DynoSweep::Result result = sweep.run(
+        [&options, &instances](int point) -> Simulator * {
+            Instance &instance = instances[point];
+            if (!createInstance(options, &instance)) {
+                destroyInstance(&instance);
+                return nullptr;
+            }
+
+            return instance.simulator;
+        },
+        [&instances](int point, Simulator *) {
+            destroyInstance(&instances[point]);
+        });
+
+    for (const DynoSweep::Point &point : result.points) {
+        if (!point.valid) {
+            std::fprintf(stderr, "dyno sweep point rpm=%.0f produced no result\n", point.rpm);
+            continue;
+        }
+
+        std::printf(
+            "dyno rpm=%.0f torque_nm=%.1f power_kw=%.2f manifold_kpa=%.2f intake_afr=%.2f imep_kpa=%.1f imep_cov=%.4f settled=%d simulated_s=%.3f wall_s=%.3f\n",
+            point.rpm,
+            units::convert(point.torque, units::Nm),
+            units::convert(point.power, units::kW),
+            units::convert(point.manifoldPressure, units::kPa),
+            point.intakeAfr,
+            units::convert(point.imep, units::kPa),
+            point.imepCoefficientOfVariation,
+            point.settled ? 1 : 0,
+            point.simulatedTime,
+            point.wallTime);
+    }
+
+    std::printf(
+        "dyno_sweep points=%d threads=%d wall_s=%.3f output=%s\n",
+        (int)result.points.size(),
+        params.threads,
+        result.wallTime,
+        options.sweepOutputPath.c_str());
+
+    if (!DynoSweep::WriteCsv(options.sweepOutputPath, result)) {
+        std::fprintf(stderr, "failed to write dyno sweep to '%s'\n", options.sweepOutputPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Batch sweep format: "min:max:step" in rpm, like a dyno sweep. Every
+// hold point gets batchCopies lanes, each seeded apart, all stepped in
+// lockstep by one BatchStepper
+bool runBatchSweep(const Options &options) {
+    DynoSweep::Parameters sweepParameters;
+    if (std::sscanf(
+        options.batchSweep.c_str(),
+        "%lf:%lf:%lf",
+        &sweepParameters.minRpm,
+        &sweepParameters.maxRpm,
+        &sweepParameters.stepRpm) != 3)
+    {
+        std::fprintf(stderr, "expected --batch-sweep=min:max:step\n");
+        return false;
+    }
+
+    DynoSweep sweep;
+    sweep.initialize(sweepParameters);
+    const std::vector<double> holdPoints = sweep.getHoldPoints();
+
+    BatchStepper::Parameters params;
+    params.measureStart = options.sweepSettle;
+    params.duration = options.sweepSettle + options.batchMeasure;
+    params.frameLength = options.frameLength;
+    params.threads = options.sweepThreads;
+
+    BatchStepper stepper;
+    stepper.initialize(params);
+
+    std::vector<Instance> instances(holdPoints.size() * options.batchCopies);
+    bool created = true;
+    for (size_t i = 0; i < instances.size() && created; ++i) {
+        Options laneOptions = options;
+        laneOptions.seed = options.seed + i % options.batchCopies;
+
+        created = createInstance(laneOptions, &instances[i]);
+        if (created) {
+            stepper.addLane(instances[i].simulator, holdPoints[i / options.batchCopies], options.sweepThrottle);
+        }
+    }
+
+    if (!created) {
+        std::fprintf(stderr, "failed to create batch sweep lanes\n");
+        for (Instance &instance : instances) destroyInstance(&instance);
+        return false;
+    }
+
+    const BatchStepper::Result result = stepper.run();
+    stepper.destroy();
+
+    for (Instance &instance : instances) destroyInstance(&instance);
+
+    for (int i = 0; i < static_cast<int>(result.lanes.size()); ++i) {
+        const BatchStepper::LaneResult &lane = result.lanes[i];
+        if (!lane.valid) {
+            std::fprintf(stderr, "batch sweep lane %d rpm=%.0f produced no result\n", i, lane.rpm);
+            continue;
+        }
+
+        std::printf(
+            "batch lane=%d rpm=%.0f torque_nm=%.1f power_kw=%.2f imep_kpa=%.1f imep_cov=%.4f peak_kpa=%.1f cycles=%d\n",
+            i,
+            lane.rpm,
+            units::convert(lane.torque, units::Nm),
+            units::convert(lane.power, units::kW),
+            units::convert(lane.imep, units::kPa),
+            lane.imepCoefficientOfVariation,
+            units::convert(lane.peakPressure, units::kPa),
+            lane.cycles);
+    }
+
+    const BatchStepper::Reduction &reduction = result.reduction;
+    std::printf(
+        "batch_sweep lanes=%d threads=%d torque_nm=%.1f min_torque_nm=%.1f max_torque_nm=%.1f"
+        " max_power_kw=%.2f max_power_rpm=%.0f imep_kpa=%.1f imep_cov=%.4f peak_kpa=%.1f cycles=%lld"
+        " steps=%lld wall_s=%.3f output=%s\n",
+        reduction.lanes,
+        stepper.getThreadCount(),
+        units::convert(reduction.meanTorque, units::Nm),
+        units::convert(reduction.minTorque, units::Nm),
+        units::convert(reduction.maxTorque, units::Nm),
+        units::convert(reduction.maxPower, units::kW),
+        reduction.maxPowerRpm,
+        units::convert(reduction.meanImep, units::kPa),
+        reduction.meanImepCoefficientOfVariation,
+        units::convert(reduction.maxPeakPressure, units::kPa),
+        reduction.cycles,
+        result.steps,
+        result.wallTime,
+        options.batchOutputPath.c_str());
+
+    if (!BatchStepper::WriteCsv(options.batchOutputPath, result)) {
+        std::fprintf(stderr, "failed to write batch sweep to '%s'\n", options.batchOutputPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Study format: "parameter:min:max:steps,..."; steps only matter for grids
+bool parseStudyParameters(const Options &options, ParameterStudy::Parameters *params) {
+    if (options.dynoSweep.empty()) {
+        std::fprintf(stderr, "--study needs --dyno-sweep=min:max:step for its hold points\n");
+        return false;
+    }
+
+    if (!parseSweepParameters(options, &params->sweep)) return false;
+
+    if (options.studyDesign == "grid") params->design = ParameterStudy::Design::Grid;
+    else if (options.studyDesign == "random") params->design = ParameterStudy::Design::Random;
+    else {
+        std::fprintf(stderr, "expected --study-design=grid|random\n");
+        return false;
+    }
+
+    params->samples = options.studySamples;
+    params->seed = options.seed;
+
+    const std::string &s = options.study;
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+
+        const std::string entry = s.substr(start, end - start);
+        const size_t colon = entry.find(':');
+
+        ParameterStudy::Axis axis;
+        if (colon == std::string::npos
+            || !ParameterStudy::ParseParameter(entry.substr(0, colon), &axis.parameter)
+            || std::sscanf(entry.c_str() + colon + 1, "%lf:%lf:%d", &axis.min, &axis.max, &axis.steps) < 2)
+        {
+            std::fprintf(stderr, "invalid study axis '%s'; expected parameter:min:max[:steps]\n", entry.c_str());
+            return false;
+        }
+
+        params->axes.push_back(axis);
+        start = end + 1;
+    }
+
+    return true;
+}
+
+// Every task on this host's --sweep-threads pool
+ParameterStudy::Result runLocalStudy(const Options &variantOptions, ParameterStudy &study) {
+    std::vector<Instance> instances(study.getTaskCount());
+    return study.run(
+        [&variantOptions, &instances, &study](int task, const ParameterStudy::Variant &variant) -> Simulator * {
+            Instance &instance = instances[task];
+            const bool created = createInstance(
+                variantOptions,
+                &instance,
+                [&study, &variant](Engine *engine) { study.apply(engine, variant); });
+            if (!created) {
+                destroyInstance(&instance);
+                return nullptr;
+            }
+
+            return instance.simulator;
+        },
+        [&instances](int task, Simulator *) {
+            destroyInstance(&instances[task]);
+        });
+}
+
+bool runParameterStudy(const Options &options) {
+    ParameterStudy::Parameters params;
+    if (!parseStudyParameters(options, &params)) return false;
+
+    // The script is compiled once into a snapshot every variant is read back
+    // from
+    Options variantOptions = options;
+    if (options.snapshotPath.empty()) {
+        variantOptions.exportSnapshotPath =
+            (std::filesystem::temp_directory_path() / "engine_sim_parameter_study.snapshot").string();
+        if (!exportSnapshot(variantOptions)) {
+            std::fprintf(stderr, "failed to compile '%s' for the study\n", options.scriptPath.c_str());
+            return false;
+        }
+
+        variantOptions.snapshotPath = variantOptions.exportSnapshotPath;
+    }
+
+    ParameterStudy study;
+    study.initialize(params);
+
+    ParameterStudy::Result result;
+    bool measured = true;
+    if (options.studyCoordinatorPort >= 0) {
+        StudyCoordinator::Parameters coordinatorParams;
+        coordinatorParams.port = options.studyCoordinatorPort;
+        coordinatorParams.maxDuplicates = options.studyDuplicates;
+
+        StudyCoordinator coordinator;
+        measured = coordinator.initialize(coordinatorParams, params, variantOptions.snapshotPath);
+        if (measured) {
+            std::printf("study_coordinator port=%d tasks=%d\n", coordinator.getPort(), study.getTaskCount());
+            std::fflush(stdout);
+
+            result = coordinator.run();
+
+            const StudyCoordinator::Statistics &stats = coordinator.getStatistics();
+            std::printf(
+                "study_coordinator workers=%d dispatched=%lld duplicates=%lld requeued=%lld discarded=%lld\n",
+                stats.workers,
+                stats.dispatched,
+                stats.duplicates,
+                stats.requeued,
+                stats.discarded);
+            coordinator.destroy();
+        }
+        else {
+            std::fprintf(stderr, "failed to start the study coordinator on port %d\n", options.studyCoordinatorPort);
+        }
+    }
+    else {
+        result = runLocalStudy(variantOptions, study);
+    }
+
+    if (options.snapshotPath.empty()) {
+        std::error_code error;
+        std::filesystem::remove(variantOptions.snapshotPath, error);
+    }
+
+    if (!measured) return false;
+
+    std::printf(
+        "parameter_study variants=%d tasks=%d threads=%d wall_s=%.3f output=%s\n",
+        (int)result.variants.size(),
+        study.getTaskCount(),
+        params.sweep.threads,
+        result.wallTime,
+        options.studyOutputPath.c_str());
+
+    if (!study.writeCsv(options.studyOutputPath, result)) {
+        std::fprintf(stderr, "failed to write parameter study to '%s'\n", options.studyOutputPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Runs tasks for a coordinator, given as host:port, until its study is
+// done; the study and the engine come from the coordinator
+bool runStudyWorker(const Options &options) {
+    const size_t colon = options.studyWorker.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        std::fprintf(stderr, "expected --study-worker=host:port\n");
+        return false;
+    }
+
+    StudyWorker::Parameters params;
+    params.host = options.studyWorker.substr(0, colon);
+    params.port = std::atoi(options.studyWorker.c_str() + colon + 1);
+    params.threads = (options.sweepThreads > 0)
+        ? options.sweepThreads
+        : std::max(1, (int)std::thread::hardware_concurrency());
+
+    // Brackets around an IPv6 address are only there to separate the port
+    if (params.host.size() > 2 && params.host.front() == '[' && params.host.back() == ']') {
+        params.host = params.host.substr(1, params.host.size() - 2);
+    }
+
+    const ParameterStudy *study = nullptr;
+    Options variantOptions = options;
+    std::map<int, Instance> instances;
+
+    StudyWorker worker;
+    const bool ran = worker.run(
+        params,
+        [&study, &variantOptions](const ParameterStudy &received, const std::string &snapshotPath) {
+            study = &received;
+            variantOptions.snapshotPath = snapshotPath;
+            variantOptions.audioMetrics = received.getParameters().sweep.audioMetrics;
+            variantOptions.physicsOnly = !variantOptions.audioMetrics;
+            return true;
+        },
+        [&variantOptions, &instances, &study](int task, const ParameterStudy::Variant &variant) -> Simulator * {
+            Instance &instance = instances[task];
+            const bool created = createInstance(
+                variantOptions,
+                &instance,
+                [&study, &variant](Engine *engine) { study->apply(engine, variant); });
+            if (!created) {
+                destroyInstance(&instance);
+                instances.erase(task);
+                return nullptr;
+            }
+
+            return instance.simulator;
+        },
+        [&instances](int task, Simulator *) {
+            destroyInstance(&instances[task]);
+            instances.erase(task);
+        });
+
+    if (!ran) {
+        std::fprintf(stderr, "failed to join the study at '%s'\n", options.studyWorker.c_str());
+        return false;
+    }
+
+    std::printf(
+        "study_worker tasks=%lld threads=%d wall_s=%.3f\n",
+        worker.getStatistics().tasks,
+        params.threads,
+        worker.getStatistics().wallTime);
+
+    return true;
+}
+
+// Comma separated numbers, e.g. "60,100"
+std::vector<double> parseList(const std::string &s) {
+    std::vector<double> values;
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+        if (end > start) values.push_back(std::atof(s.substr(start, end - start).c_str()));
+
+        start = end + 1;
+    }
+
+    return values;
+}
+
+// Drive cycle file: one "time,throttle,gear,clutch" command per line with
+// gears counted from 1 and 0 as neutral; lines that don't parse, such as a
+// header, are skipped
+bool loadDriveSchedule(const std::string &path, std::vector<HeadlessRunner::ControlPoint> *schedule) {
+    FILE *file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) return false;
+
+    char line[256];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        HeadlessRunner::ControlPoint p;
+        if (std::sscanf(line, "%lf,%lf,%d,%lf", &p.time, &p.throttle, &p.gear, &p.clutch) != 4) {
+            continue;
+        }
+
+        p.drivetrain = true;
+        p.gear = std::max(p.gear, 0) - 1;
+        schedule->push_back(p);
+    }
+
+    std::fclose(file);
+
+    return !schedule->empty();
+}
+
+// "--drive-cycle=launch" follows the shift rules; anything else names a
+// schedule file. Each final drive ratio is a variant on its own instance.
+bool runDriveCycle(const Options &options) {
+    DriveCycle::Parameters params;
+    params.starterTime = options.starterTime;
+    params.launchTime = options.starterTime + 1.0;
+    params.maxTime = options.driveTime;
+    params.frameLength = options.frameLength;
+    params.shiftRules.shiftSpeed = units::rpm(options.shiftRpm);
+    params.threads = (options.driveThreads > 0)
+        ? options.driveThreads
+        : std::max(1, (int)std::thread::hardware_concurrency());
+
+    for (double speed : parseList(options.driveTargets)) {
+        params.targetSpeeds.push_back(speed * units::km / units::hour);
+    }
+
+    if (options.driveCycle != "launch" && !loadDriveSchedule(options.driveCycle, &params.schedule)) {
+        std::fprintf(stderr, "failed to read drive cycle '%s'\n", options.driveCycle.c_str());
+        return false;
+    }
+
+    const std::vector<double> diffRatios = parseList(options.driveDiffRatios);
+    const int variants = std::max(1, (int)diffRatios.size());
+
+    DriveCycle cycle;
+    cycle.initialize(params);
+
+    std::vector<Instance> instances(variants);
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::vector<DriveCycle::Result> results = cycle.run(
+        variants,
+        [&options, &instances, &diffRatios](int variant) -> Simulator * {
+            Instance &instance = instances[variant];
+            if (!createInstance(options, &instance)) {
+                destroyInstance(&instance);
+                return nullptr;
+            }
+
+            if (!diffRatios.empty()) {
+                const Vehicle *vehicle = instance.vehicle;
+
+                Vehicle::Parameters vehParams;
+                vehParams.mass = vehicle->getMass();
+                vehParams.dragCoefficient = vehicle->getDragCoefficient();
+                vehParams.crossSectionArea = vehicle->getCrossSectionArea();
+                vehParams.diffRatio = diffRatios[variant];
+                vehParams.tireRadius = vehicle->getTireRadius();
+                vehParams.rollingResistance = vehicle->getRollingResistance();
+                instance.vehicle->initialize(vehParams);
+            }
+
+            return instance.simulator;
+        },
+        [&instances](int variant, Simulator *) {
+            destroyInstance(&instances[variant]);
+        });
+    const auto t1 = std::chrono::steady_clock::now();
+
+    bool valid = false;
+    for (int i = 0; i < variants; ++i) {
+        const DriveCycle::Result &result = results[i];
+        const double diffRatio = diffRatios.empty() ? 0.0 : diffRatios[i];
+        if (!result.valid) {
+            std::fprintf(stderr, "drive cycle variant=%d never launched\n", i);
+            continue;
+        }
+
+        valid = true;
+        for (const DriveCycle::Shift &shift : result.shifts) {
+            std::printf(
+                "shift variant=%d t=%.3f from=%d to=%d rpm=%.0f speed_kph=%.1f\n",
+                i,
+                shift.time,
+                shift.fromGear + 1,
+                shift.toGear + 1,
+                shift.rpm,
+                units::convert(shift.speed, units::km / units::hour));
+        }
+
+        for (const DriveCycle::Target &target : result.targets) {
+            if (!target.reached) {
+                std::printf(
+                    "target variant=%d speed_kph=%.1f reached=0\n",
+                    i,
+                    units::convert(target.speed, units::km / units::hour));
+                continue;
+            }
+
+            std::printf(
+                "target variant=%d speed_kph=%.1f reached=1 t=%.3f distance_m=%.1f\n",
+                i,
+                units::convert(target.speed, units::km / units::hour),
+                target.time,
+                units::convert(target.distance, units::m));
+        }
+
+        std::printf(
+            "drive_cycle variant=%d diff_ratio=%.3f fuel_g=%.2f distance_m=%.1f final_speed_kph=%.1f shifts=%d simulated_s=%.3f wall_s=%.3f rt_factor=%.2f\n",
+            i,
+            diffRatio,
+            units::convert(result.fuelMass, units::g),
+            units::convert(result.distance, units::m),
+            units::convert(result.finalSpeed, units::km / units::hour),
+            (int)result.shifts.size(),
+            result.simulatedTime,
+            result.wallTime,
+            (result.wallTime > 0) ? result.simulatedTime / result.wallTime : 0.0);
+    }
+
+    std::printf(
+        "drive_cycle variants=%d threads=%d wall_s=%.3f\n",
+        variants,
+        params.threads,
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6);
+
+    return valid;
+}
+
+// Every speed and throttle of the grid gets an instance of its own
+bool runSoundBankBake(const Options &options) {
+    SoundBankBaker::Parameters params;
+    double minRpm = 0, maxRpm = 0, stepRpm = 0;
+    if (std::sscanf(options.bankRpm.c_str(), "%lf:%lf:%lf", &minRpm, &maxRpm, &stepRpm) != 3 || stepRpm <= 0) {
+        std::fprintf(stderr, "expected --bank-rpm=min:max:step\n");
+        return false;
+    }
+
+    for (double rpm = minRpm; rpm <= maxRpm + 1E-6; rpm += stepRpm) params.rpms.push_back(rpm);
+    params.throttles = parseList(options.bankThrottle);
+    if (params.rpms.empty() || params.throttles.empty()) {
+        std::fprintf(stderr, "--bake-sound-bank needs at least one speed and throttle\n");
+        return false;
+    }
+
+    params.framesPerCycle = options.bankFramesPerCycle;
+    params.cyclesPerCell = options.bankCycles;
+    params.settleTime = options.sweepSettle;
+    params.frameLength = options.frameLength;
+    params.threads = (options.sweepThreads > 0)
+        ? options.sweepThreads
+        : std::max(1, (int)std::thread::hardware_concurrency());
+
+    SoundBankBaker baker;
+    baker.initialize(params);
+
+    SoundBank bank;
+    std::vector<Instance> instances(params.rpms.size() * params.throttles.size());
+    const SoundBankBaker::Result result = baker.run(
+        [&options, &instances](int cell) -> Simulator * {
+            Instance &instance = instances[cell];
+            if (!createInstance(options, &instance)) {
+                destroyInstance(&instance);
+                return nullptr;
+            }
+
+            return instance.simulator;
+        },
+        [&instances](int cell, Simulator *) {
+            destroyInstance(&instances[cell]);
+        },
+        &bank);
+
+    std::printf(
+        "sound_bank cells=%d captured=%d channels=%d frames_per_cycle=%d cycles=%d simulated_s=%.3f wall_s=%.3f output=%s\n",
+        result.cells,
+        result.captured,
+        bank.getChannelCount(),
+        bank.getFramesPerCycle(),
+        bank.getCyclesPerCell(),
+        result.simulatedTime,
+        result.wallTime,
+        options.bakeSoundBank.c_str());
+
+    if (bank.isEmpty() || !bank.save(options.bakeSoundBank)) {
+        std::fprintf(stderr, "failed to write sound bank to '%s'\n", options.bakeSoundBank.c_str());
+        return false;
+    }
+
+    return result.captured == result.cells;
+}
+
+// Ramps through the bank's speeds over the run at the sweep throttle,
+// without an engine
+bool runSoundBankPlayback(const Options &options) {
+    SoundBank bank;
+    if (!bank.load(options.playSoundBank) || bank.isEmpty()) {
+        std::fprintf(stderr, "failed to read sound bank '%s'\n", options.playSoundBank.c_str());
+        return false;
+    }
+
+    SoundBankPlayer::Parameters params;
+    params.audioSampleRate = options.sampleRate;
+
+    SoundBankPlayer player;
+    player.initialize(&bank, params);
+    player.seed(options.seed);
+
+    WavWriter audioOutput;
+    if (!options.audioOutputPath.empty()
+        && !audioOutput.open(options.audioOutputPath, static_cast<int>(options.sampleRate)))
+    {
+        std::fprintf(stderr, "failed to open audio output '%s'\n", options.audioOutputPath.c_str());
+        player.destroy();
+        return false;
+    }
+
+    const double minRpm = bank.getRpms().front();
+    const double maxRpm = bank.getRpms().back();
+    const int frameSamples = std::max(1, static_cast<int>(options.sampleRate * options.frameLength));
+    const long long totalSamples = static_cast<long long>(options.duration * options.sampleRate);
+    std::vector<int16_t> samples(frameSamples);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    long long rendered = 0;
+    while (rendered < totalSamples) {
+        const double s = (double)rendered / std::max(totalSamples, 1LL);
+        player.setOperatingPoint(minRpm + s * (maxRpm - minRpm), options.sweepThrottle);
+
+        const int n = static_cast<int>(std::min<long long>(frameSamples, totalSamples - rendered));
+        if (player.render(n, samples.data()) < n) break;
+        if (audioOutput.isOpen()) audioOutput.write(samples.data(), n);
+
+        rendered += n;
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+    const double wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+    const double playedTime = rendered / options.sampleRate;
+
+    std::printf(
+        "sound_bank_play samples=%lld grains=%llu played_s=%.3f wall_s=%.3f rt_factor=%.2f\n",
+        rendered,
+        player.getGrainCount(),
+        playedTime,
+        wallTime,
+        (wallTime > 0) ? playedTime / wallTime : 0.0);
+
+    if (audioOutput.isOpen()) audioOutput.close();
+    player.destroy();
+
+    return rendered == totalSamples;
+}
+
+// Renders a synthesizer capture again, with any settings given on the
+// command line in place of the captured ones
+bool runSynthesizerReplay(const Options &options) {
+    SynthesizerCapture capture;
+    if (!capture.load(options.replaySynth) || capture.getFrameCount() == 0) {
+        std::fprintf(stderr, "failed to read synthesizer capture '%s'\n", options.replaySynth.c_str());
+        return false;
+    }
+
+    SynthesizerReplay::Parameters params;
+    params.audioSampleRate = options.sampleRate;
+    params.overrideAudioParameters = true;
+    params.audioParameters = capture.getAudioParameters();
+    if (options.replayVolume >= 0) params.audioParameters.volume = static_cast<float>(options.replayVolume);
+    if (options.replayConvolution >= 0) {
+        params.audioParameters.convolution = static_cast<float>(std::min(options.replayConvolution, 1.0));
+    }
+
+    for (int i = 0; i < capture.getChannelCount(); ++i) {
+        SynthesizerCapture::Channel channel = capture.getChannel(i);
+        if (!options.replayIr.empty()) channel.impulseResponse = options.replayIr;
+        if (options.replayIrVolume > 0) channel.impulseResponseVolume = options.replayIrVolume;
+        if (options.replayExhaustVolume > 0) channel.audioVolume = options.replayExhaustVolume;
+        params.channels.push_back(channel);
+    }
+
+    SynthesizerReplay replay;
+    if (!replay.initialize(&capture, params)) {
+        std::fprintf(stderr, "failed to set up synthesizer replay\n");
+        return false;
+    }
+
+    replay.synthesizer().setRandomSeed(options.seed);
+
+    WavWriter audioOutput;
+    if (!options.audioOutputPath.empty()
+        && !audioOutput.open(options.audioOutputPath, static_cast<int>(options.sampleRate)))
+    {
+        std::fprintf(stderr, "failed to open audio output '%s'\n", options.audioOutputPath.c_str());
+        replay.destroy();
+        return false;
+    }
+
+    const int frameSamples = std::max(1, static_cast<int>(options.sampleRate * options.frameLength));
+    std::vector<int16_t> samples(frameSamples);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    long long rendered = 0;
+    while (!replay.isFinished()) {
+        const int n = replay.render(frameSamples, samples.data());
+        if (n == 0) break;
+        if (audioOutput.isOpen()) audioOutput.write(samples.data(), n);
+
+        rendered += n;
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+    const double wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+    const double playedTime = rendered / options.sampleRate;
+
+    std::printf(
+        "synth_replay=%s channels=%d frames=%zu samples=%lld played_s=%.3f wall_s=%.3f rt_factor=%.2f\n",
+        options.replaySynth.c_str(),
+        capture.getChannelCount(),
+        capture.getFrameCount(),
+        rendered,
+        playedTime,
+        wallTime,
+        (wallTime > 0) ? playedTime / wallTime : 0.0);
+
+    const bool finished = replay.isFinished();
+    if (audioOutput.isOpen()) audioOutput.close();
+    replay.destroy();
+
+    return finished;
+}
+
+void printAudioMetrics(const char *label, int index, const SimulationSnapshot &snapshot) {
+    std::printf(
+        "%s instance=%d t=%.3f audio_db=%.2f centroid_hz=%.1f roughness=%.4f firing_h1_db=%.1f firing_h2_db=%.1f firing_h3_db=%.1f firing_h4_db=%.1f\n",
+        label,
+        index,
+        snapshot.time,
+        snapshot.audioLoudness,
+        snapshot.audioSpectralCentroid,
+        snapshot.audioRoughness,
+        snapshot.audioHarmonics[0],
+        snapshot.audioHarmonics[1],
+        snapshot.audioHarmonics[2],
+        snapshot.audioHarmonics[3]);
+}
+
+// Prints one line of gauge state per interval of simulated time
+std::function<void(const SimulationSnapshot &)> telemetryPrinter(int index, double interval) {
+    double nextSample = 0.0;
+    return [index, interval, nextSample](const SimulationSnapshot &snapshot) mutable {
+        if (snapshot.time < nextSample) return;
+
+        nextSample = snapshot.time + interval;
+        std::printf(
+            "telemetry instance=%d t=%.3f rpm=%.0f manifold_kpa=%.2f intake_afr=%.2f torque_nm=%.1f power_kw=%.2f speed_kph=%.1f\n",
+            index,
+            snapshot.time,
+            snapshot.rpm,
+            units::convert(snapshot.manifoldPressure, units::kPa),
+            snapshot.intakeAfr,
+            units::convert(snapshot.filteredDynoTorque, units::Nm),
+            units::convert(snapshot.dynoPower, units::kW),
+            units::convert(snapshot.speed, units::km / units::hour));
+
+        if (snapshot.audioAnalyzed) printAudioMetrics("telemetry_audio", index, snapshot);
+    };
+}
+
+// An instance's physics thread, its fluid workers beyond the physics
+// thread itself, its audio thread and its convolution tail worker
+int threadsPerInstance(const Options &options) {
+    return 1
+        + (options.fluidThreads - 1)
+        + (options.physicsOnly ? 0 : 1)
+        + ((!options.physicsOnly && options.offloadConvolutionTail) ? 1 : 0);
+}
+
+std::vector<CpuTopology::Placement> placeInstances(const Options &options, int count) {
+    if (options.placement != "numa") return {};
+
+    CpuTopology topology;
+    topology.detect();
+
+    const std::vector<CpuTopology::Placement> placements =
+        topology.place(count, threadsPerInstance(options));
+
+    std::printf(
+        "topology cpus=%d nodes=%d l2_groups=%d\n",
+        topology.getCpuCount(),
+        topology.getNodeCount(),
+        topology.getL2GroupCount());
+    for (size_t i = 0; i < placements.size(); ++i) {
+        std::printf(
+            "placement instance=%d node=%d cpus=%s\n",
+            static_cast<int>(i),
+            placements[i].node,
+            CpuTopology::FormatCpuList(placements[i].cpus).c_str());
+    }
+
+    return placements;
+}
+
+// Script compilation shares state inside the compiler so instances are
+// created serially; only the simulation itself runs in parallel. With a
+// placement, each instance is created from a thread pinned to its CPUs, so
+// first touch puts its arena and buffers in that node's memory and the
+// threads it starts inherit the CPUs.
+bool runInstances(const Options &options, int count, double *aggregateStepsPerSecond) {
+    const std::vector<CpuTopology::Placement> placements = placeInstances(options, count);
+
+    std::vector<int> mainCpus;
+    const bool restoreCpus = !placements.empty() && ThreadPolicy::GetCurrentThreadCpus(&mainCpus);
+
+    std::vector<Instance> instances(count);
+    bool loaded = true;
+    for (int i = 0; i < count && loaded; ++i) {
+        if (!placements.empty()) ThreadPolicy::PinCurrentThread(placements[i].cpus);
+        loaded = createInstance(options, &instances[i]);
+    }
+
+    if (restoreCpus) ThreadPolicy::PinCurrentThread(mainCpus);
+
+    if (!loaded) {
+        if (!options.snapshotPath.empty()) {
+            std::fprintf(stderr, "failed to load engine snapshot '%s'\n", options.snapshotPath.c_str());
+        }
+        else {
+            std::fprintf(stderr, "failed to load engine from '%s' (see error_log.log)\n", options.scriptPath.c_str());
+        }
+
+        for (Instance &instance : instances) destroyInstance(&instance);
+        return false;
+    }
+
+    EventCounters::Totals events0;
+    EventCounters::GetTotals(&events0);
+
+    // Every instance forks from the same warmed-up state
+    if (!options.loadCheckpointPath.empty()) {
+        SimulationCheckpoint checkpoint;
+        bool restored = checkpoint.load(options.loadCheckpointPath);
+        for (Instance &instance : instances) {
+            PistonEngineSimulator *simulator = dynamic_cast<PistonEngineSimulator *>(instance.simulator);
+            restored = restored && simulator != nullptr && checkpoint.restore(simulator);
+        }
+
+        if (!restored) {
+            std::fprintf(stderr, "failed to restore checkpoint '%s'\n", options.loadCheckpointPath.c_str());
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+    }
+
+    HeadlessRunner::Parameters runnerParams;
+    runnerParams.duration = options.duration;
+    runnerParams.frameLength = options.frameLength;
+    runnerParams.offline = options.offline;
+    runnerParams.lockstep = options.lockstep;
+    runnerParams.schedule = parseSchedule(options);
+
+    // Every instance replays a session of its own for as long as it was
+    // recorded; like the audio output, only a single instance records
+    std::vector<InputSession> sessions(count);
+    const std::string &sessionPath = !options.replayInput.empty() ? options.replayInput : options.recordInput;
+    if (!options.replayInput.empty()) {
+        for (int i = 0; i < count; ++i) {
+            if (!sessions[i].load(options.replayInput)) {
+                std::fprintf(stderr, "failed to load input session '%s'\n", options.replayInput.c_str());
+                for (Instance &instance : instances) destroyInstance(&instance);
+                return false;
+            }
+
+            instances[i].simulator->setInputSession(&sessions[i]);
+        }
+
+        runnerParams.duration = sessions[0].getLength() * instances[0].simulator->getTimestep();
+    }
+    else if (!options.recordInput.empty() && count == 1) {
+        Simulator *simulator = instances[0].simulator;
+        if (!sessions[0].record(options.recordInput, simulator->getRandomSeed(), simulator->getTargetSimulationFrequency())) {
+            std::fprintf(stderr, "failed to open input session '%s'\n", options.recordInput.c_str());
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        simulator->setInputSession(&sessions[0]);
+    }
+
+    // Everything the single-instance run feeds its synthesizer, with the
+    // settings it was fed with, for --replay-synth
+    SynthesizerCapture synthesizerCapture;
+    if (!options.captureSynth.empty() && count == 1) {
+        Engine *engine = instances[0].engine;
+        Simulator *simulator = instances[0].simulator;
+
+        std::vector<SynthesizerCapture::Channel> channels(engine->getExhaustSystemCount());
+        for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+            const ExhaustSystem *exhaust = engine->getExhaustSystem(i);
+            const ImpulseResponse *response = exhaust->getImpulseResponse();
+            if (response != nullptr) {
+                channels[i].impulseResponse = response->getFilename();
+                channels[i].impulseResponseVolume = response->getVolume();
+            }
+
+            channels[i].audioVolume = exhaust->getAudioVolume();
+        }
+
+        if (!synthesizerCapture.record(
+            options.captureSynth,
+            simulator->synthesizer().getInputSampleRate(),
+            simulator->synthesizer().getAudioParameters(),
+            channels))
+        {
+            std::fprintf(stderr, "failed to open synthesizer capture '%s'\n", options.captureSynth.c_str());
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        simulator->setSynthesizerCapture(&synthesizerCapture);
+    }
+
+    // Recorded from the single-instance baseline run only
+    WavWriter audioOutput;
+    if (!options.audioOutputPath.empty() && count == 1) {
+        if (!audioOutput.open(options.audioOutputPath, static_cast<int>(options.sampleRate))) {
+            std::fprintf(stderr, "failed to open audio output '%s'\n", options.audioOutputPath.c_str());
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        runnerParams.audio = [&audioOutput](const int16_t *samples, int sampleCount) {
+            audioOutput.write(samples, sampleCount);
+        };
+    }
+
+    // Like the audio output, only the single-instance run is exported. A log
+    // without an export of its own drains a file-backed one next to it, with
+    // room for the log thread to fall behind a faster than real-time run.
+    const bool logging = !options.telemetryLog.empty() && count == 1;
+    const bool privateExport = logging && options.telemetryExport.empty();
+    const std::string exportName = privateExport ? options.telemetryLog + ".ring" : options.telemetryExport;
+
+    TelemetryExport telemetryExport;
+    TelemetryLog telemetryLog;
+    if (!exportName.empty() && count == 1) {
+        const int capacity = logging ? 16 * TelemetryExport::DefaultCapacity : TelemetryExport::DefaultCapacity;
+        if (!telemetryExport.open(exportName, capacity, options.telemetryDecimation)) {
+            std::fprintf(stderr, "failed to open telemetry export '%s'\n", exportName.c_str());
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        if (logging && !telemetryLog.open(exportName, options.telemetryLog, TelemetryLog::Parameters())) {
+            std::fprintf(stderr, "failed to open telemetry log '%s'\n", options.telemetryLog.c_str());
+            telemetryExport.close();
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        instances[0].simulator->setTelemetryExport(&telemetryExport);
+    }
+
+    // Each instance gets a controller of its own; any ECU target turns them on
+    std::vector<EngineController> controllers;
+    if (options.ecuAfr > 0 || options.ecuIdleRpm > 0 || options.ecuRevLimit > 0) {
+        EngineController::Parameters ecuParams;
+        if (options.ecuRate > 0) ecuParams.controlRate = options.ecuRate;
+        ecuParams.targetAfr = options.ecuAfr;
+        ecuParams.idleRpm = units::rpm(options.ecuIdleRpm);
+        ecuParams.revLimit = units::rpm(options.ecuRevLimit);
+
+        controllers.resize(count);
+        for (int i = 0; i < count; ++i) {
+            controllers[i].initialize(ecuParams);
+            instances[i].simulator->setEngineController(&controllers[i]);
+        }
+    }
+
+    // Every instance keeps its own last steps; dumps go to the trace session
+    // unless a directory is given
+    std::vector<FlightRecorder> recorders;
+    if (options.flightRecorderFrames > 0) {
+        FlightRecorder::Parameters recorderParams;
+        recorderParams.capacity = options.flightRecorderFrames;
+        recorderParams.directory = options.flightRecorderDirectory;
+
+        recorders.resize(count);
+        for (int i = 0; i < count; ++i) {
+            recorders[i].initialize(recorderParams);
+            instances[i].simulator->setFlightRecorder(&recorders[i]);
+        }
+    }
+
+    // Serves the single-instance run; the remote controls, once any arrive,
+    // take over from the schedule
+    NetworkStream stream;
+    NetworkStream::Controls remoteControls;
+    bool remoteControlled = false;
+    if (options.streamPort >= 0 && count == 1) {
+        NetworkStream::Parameters streamParams;
+        streamParams.port = options.streamPort;
+        streamParams.frameSamples = options.streamFrame;
+        streamParams.maxListeners = options.streamListeners;
+        if (!stream.initialize(streamParams)) {
+            std::fprintf(stderr, "failed to open network stream on port %d\n", options.streamPort);
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        std::printf("stream_port=%d\n", stream.getPort());
+        std::fflush(stdout);
+
+        runnerParams.control = [&stream, &remoteControls, &remoteControlled](double, HeadlessRunner::ControlPoint *control) {
+            remoteControlled = stream.poll(&remoteControls) || remoteControlled;
+            if (!remoteControlled) return;
+
+            control->throttle = remoteControls.throttle;
+            control->dynoSpeed = remoteControls.dynoSpeed;
+            control->dynoEnabled = remoteControls.dyno;
+            control->starter = remoteControls.starter;
+            control->ignition = remoteControls.ignition;
+            control->drivetrain = true;
+            control->gear = remoteControls.gear;
+            control->clutch = remoteControls.clutch;
+        };
+
+        runnerParams.drain = [&stream](Simulator *simulator) {
+            return stream.sendAudio(simulator->synthesizer());
+        };
+
+        runnerParams.telemetry = [&stream](const SimulationSnapshot &snapshot) {
+            stream.sendTelemetry(snapshot);
+        };
+    }
+
+    // Drained by the first instance's simulator every physics frame; each
+    // control the controller has moved stops following the schedule
+    ControlSurface surface;
+    if ((!options.midiDevice.empty() || options.oscPort >= 0) && count == 1) {
+        ControlSurface::Parameters surfaceParams;
+        surfaceParams.midiDevice = options.midiDevice;
+        surfaceParams.oscPort = options.oscPort;
+        if (!surface.initialize(surfaceParams)) {
+            std::fprintf(stderr, "failed to open control surface\n");
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        instances[0].simulator->setControlSource(surface.getQueue());
+        if (surface.getOscPort() > 0) {
+            std::printf("osc_port=%d\n", surface.getOscPort());
+            std::fflush(stdout);
+        }
+
+        Simulator *simulator = instances[0].simulator;
+        auto scheduled = runnerParams.control;
+        runnerParams.control = [&surface, simulator, scheduled](double t, HeadlessRunner::ControlPoint *control) {
+            if (scheduled) scheduled(t, control);
+
+            auto owned = [&surface, simulator](ControlQueue::Control type, double *value) {
+                if (surface.owns(type)) *value = simulator->getControl(type);
+            };
+
+            double dynoEnabled = control->dynoEnabled ? 1.0 : 0.0;
+            double starter = control->starter ? 1.0 : 0.0;
+            double ignition = control->ignition ? 1.0 : 0.0;
+            owned(ControlQueue::Control::Throttle, &control->throttle);
+            owned(ControlQueue::Control::Clutch, &control->clutch);
+            owned(ControlQueue::Control::DynoSpeed, &control->dynoSpeed);
+            owned(ControlQueue::Control::DynoEnabled, &dynoEnabled);
+            owned(ControlQueue::Control::Starter, &starter);
+            owned(ControlQueue::Control::Ignition, &ignition);
+            control->dynoEnabled = dynoEnabled > 0.5;
+            control->starter = starter > 0.5;
+            control->ignition = ignition > 0.5;
+        };
+    }
+
+    // Scraped on its own thread; the instances only publish into it
+    MetricsExporter metrics;
+    if (options.metricsPort >= 0) {
+        MetricsExporter::Parameters metricsParams;
+        metricsParams.port = options.metricsPort;
+        if (!metrics.initialize(metricsParams)) {
+            std::fprintf(stderr, "failed to open metrics endpoint on port %d\n", options.metricsPort);
+            for (Instance &instance : instances) destroyInstance(&instance);
+            return false;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            metrics.setInstanceLabel(i, instances[i].engine->getName());
+        }
+
+        std::printf("metrics_port=%d\n", metrics.getPort());
+        std::fflush(stdout);
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < count; ++i) {
+        Instance &instance = instances[i];
+        threads.emplace_back([&options, &runnerParams, &instance, &metrics, &placements, i] {
+            if (!placements.empty()) ThreadPolicy::PinCurrentThread(placements[i].cpus);
+
+            // Instances take consecutive cores from the physics core on
+            if (options.realtimePhysics || options.physicsCore >= 0) {
+                ThreadPolicy::ApplyToCurrentThread(ThreadPolicy::Role::Physics, options.frameLength, i);
+            }
+
+            HeadlessRunner::Parameters params = runnerParams;
+            if (options.telemetryInterval > 0) {
+                auto printer = telemetryPrinter(i, options.telemetryInterval);
+                auto streamed = params.telemetry;
+                params.telemetry = [printer, streamed](const SimulationSnapshot &snapshot) mutable {
+                    if (streamed) streamed(snapshot);
+                    printer(snapshot);
+                };
+            }
+
+            if (metrics.isOpen()) {
+                params.progress = [&metrics, i](Simulator *simulator, const HeadlessRunner::Statistics &stats) {
+                    MetricsExporter::InstanceMetrics published;
+                    MetricsExporter::Collect(simulator, &published);
+                    published.set(MetricsExporter::Metric::Steps, static_cast<double>(stats.steps));
+                    published.set(MetricsExporter::Metric::SimulatedSeconds, stats.simulatedTime);
+                    published.set(MetricsExporter::Metric::WallSeconds, stats.wallTime);
+                    metrics.publish(i, published);
+                };
+            }
+
+            HeadlessRunner runner;
+            runner.initialize(params);
+            instance.stats = runner.run(instance.simulator);
+            runner.destroy();
+        });
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    if (surface.isRunning()) {
+        instances[0].simulator->setControlSource(nullptr);
+        const ControlSurface::Statistics surfaceStats = surface.getStatistics();
+        std::printf(
+            "control_surface messages=%llu unmapped=%llu rejected=%llu\n",
+            surfaceStats.messages,
+            surfaceStats.unmapped,
+            surfaceStats.rejected);
+        surface.destroy();
+    }
+
+    if (metrics.isOpen()) {
+        std::printf("metrics_scrapes=%llu\n", metrics.getScrapeCount());
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+    const double wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+
+    if (telemetryExport.isOpen()) {
+        instances[0].simulator->setTelemetryExport(nullptr);
+        std::printf(
+            "telemetry_export=%s records=%llu\n",
+            exportName.c_str(),
+            telemetryExport.getWrittenCount());
+
+        if (telemetryLog.isOpen()) {
+            telemetryLog.close();
+
+            const TelemetryLog::Statistics statistics = telemetryLog.getStatistics();
+            std::printf(
+                "telemetry_log=%s rows=%llu chunks=%llu bytes=%llu dropped=%llu bytes_per_row=%.2f\n",
+                options.telemetryLog.c_str(),
+                statistics.rows,
+                statistics.chunks,
+                statistics.bytes,
+                statistics.dropped,
+                (statistics.rows > 0) ? (double)statistics.bytes / statistics.rows : 0.0);
+        }
+
+        telemetryExport.close();
+        if (privateExport) std::remove(exportName.c_str());
+    }
+
+    if (!recorders.empty()) {
+        int dumps = 0;
+        for (int i = 0; i < count; ++i) {
+            instances[i].simulator->setFlightRecorder(nullptr);
+            dumps += recorders[i].getDumpCount();
+            if (recorders[i].getDumpCount() > 0) {
+                std::printf(
+                    "flight_recorder instance=%d dumps=%d last_dump=%s\n",
+                    i,
+                    recorders[i].getDumpCount(),
+                    recorders[i].getLastDumpPath().c_str());
+            }
+
+            recorders[i].destroy();
+        }
+
+        std::printf("flight_recorder_frames=%d flight_recorder_dumps=%d\n", options.flightRecorderFrames, dumps);
+    }
+
+    if (!controllers.empty()) {
+        const EngineController::Outputs &outputs = controllers[0].getOutputs();
+        std::printf(
+            "ecu_updates=%lld fuel_trim=%.4f idle_air=%.4f timing_trim=%.2f spark_cut=%d\n",
+            controllers[0].getControlCount(),
+            outputs.fuelTrim,
+            outputs.idleAir,
+            outputs.timingTrim / units::deg,
+            outputs.sparkCut ? 1 : 0);
+    }
+
+    if (stream.isOpen()) {
+        const NetworkStream::Statistics &streamStats = stream.getStatistics();
+        std::printf(
+            "stream_port=%d listeners=%d audio_packets=%llu telemetry_packets=%llu control_packets=%llu dropped_packets=%llu rejected_packets=%llu\n",
+            stream.getPort(),
+            stream.getListenerCount(),
+            streamStats.audioPackets,
+            streamStats.telemetryPackets,
+            streamStats.controlPackets,
+            streamStats.droppedPackets,
+            streamStats.rejectedPackets);
+        stream.destroy();
+    }
+
+    // The final engine speed in hex pins down whether a replay matched
+    if (instances[0].simulator->getInputSession() != nullptr) {
+        Simulator *simulator = instances[0].simulator;
+        const unsigned long long steps = simulator->getSessionStep();
+        for (Instance &instance : instances) instance.simulator->setInputSession(nullptr);
+
+        InputSession &session = sessions[0];
+        const bool replayed = session.isReplaying();
+        const size_t events = session.getEventCount();
+        if (session.close(steps)) {
+            std::printf(
+                "input_session=%s mode=%s events=%zu steps=%llu dropped=%llu rpm=%a\n",
+                sessionPath.c_str(),
+                replayed ? "replay" : "record",
+                events,
+                steps,
+                session.getDroppedCount(),
+                simulator->getEngine()->getRpm());
+        }
+        else {
+            std::fprintf(stderr, "failed to write input session '%s'\n", sessionPath.c_str());
+        }
+    }
+
+    if (synthesizerCapture.isRecording()) {
+        instances[0].simulator->setSynthesizerCapture(nullptr);
+        const unsigned long long frames = synthesizerCapture.getWrittenCount();
+        const unsigned long long dropped = synthesizerCapture.getDroppedCount();
+        if (synthesizerCapture.close()) {
+            std::printf(
+                "synth_capture=%s channels=%d frames=%llu dropped=%llu\n",
+                options.captureSynth.c_str(),
+                synthesizerCapture.getChannelCount(),
+                frames,
+                dropped);
+        }
+        else {
+            std::fprintf(stderr, "failed to write synthesizer capture '%s'\n", options.captureSynth.c_str());
+        }
+    }
+
+    if (audioOutput.isOpen()) {
+        const long long samples = audioOutput.getSampleCount();
+        if (audioOutput.close()) {
+            std::printf("audio_output=%s samples=%lld seconds=%.3f\n", options.audioOutputPath.c_str(), samples, samples / options.sampleRate);
+        }
+        else {
+            std::fprintf(stderr, "failed to write audio output '%s'\n", options.audioOutputPath.c_str());
+        }
+    }
+
+    long long totalSteps = 0;
+    for (int i = 0; i < count; ++i) {
+        const HeadlessRunner::Statistics &stats = instances[i].stats;
+        totalSteps += stats.steps;
+
+        std::printf(
+            "instance=%d engine=%s simulated_s=%.3f wall_s=%.3f rt_factor=%.2f steps=%lld steps_per_s=%.0f audio_samples=%lld fluid_substeps=%.2f final_rpm=%.0f\n",
+            i,
+            instances[i].engine->getName().c_str(),
+            stats.simulatedTime,
+            stats.wallTime,
+            stats.realTimeFactor(),
+            stats.steps,
+            (stats.wallTime > 0) ? stats.steps / stats.wallTime : 0.0,
+            stats.audioSamples,
+            stats.averageFluidSubsteps(),
+            instances[i].engine->getRpm());
+
+        if (stats.stalled) {
+            std::fprintf(
+                stderr,
+                "instance=%d stalled after %.3f s: frames stopped taking steps (frame length %.6f s)\n",
+                i,
+                stats.simulatedTime,
+                runnerParams.frameLength);
+        }
+
+        if (options.lockstep) {
+            const RealtimeStepper::Statistics &pacing = stats.pacing;
+            std::printf(
+                "instance=%d lockstep_steps=%lld missed_deadlines=%lld skipped_steps=%lld resyncs=%lld lateness_mean_us=%.3f lateness_p50_us=%.3f lateness_p99_us=%.3f lateness_max_us=%.3f\n",
+                i,
+                pacing.steps,
+                pacing.missedDeadlines,
+                pacing.skippedSteps,
+                pacing.resyncs,
+                pacing.averageLatenessMicroseconds(),
+                pacing.percentileLatenessMicroseconds(0.5),
+                pacing.percentileLatenessMicroseconds(0.99),
+                pacing.maxLatenessMicroseconds);
+        }
+
+        // Last-cycle peak over all cylinders, for comparing burn models
+        double peakPressure = 0;
+        for (int j = 0; j < instances[i].engine->getCylinderCount(); ++j) {
+            peakPressure = std::fmax(
+                peakPressure, instances[i].engine->getChamber(j)->calculateFiringPressure());
+        }
+
+        std::printf(
+            "instance=%d peak_cylinder_pressure_psi=%.1f\n",
+            i,
+            units::convert(peakPressure, units::psi));
+
+        if (instances[i].simulator->isSpeculativeStepping()) {
+            const SpeculativeStepping::Statistics &speculative =
+                instances[i].simulator->speculativeStepping().getStatistics();
+            std::printf(
+                "instance=%d speculative_frames=%llu refined_frames=%llu rollbacks=%llu",
+                i,
+                speculative.frames,
+                speculative.refinedFrames,
+                speculative.rollbacks);
+            for (int j = 1; j < SpeculativeStepping::FailureCount; ++j) {
+                std::printf(
+                    " %s=%llu",
+                    SpeculativeStepping::GetFailureName(static_cast<SpeculativeStepping::Failure>(j)),
+                    speculative.failures[j]);
+            }
+            std::printf("\n");
+        }
+
+        if (instances[i].simulator->isAudioCacheEnabled()) {
+            const CycleAudioCache &cache = instances[i].simulator->audioCache();
+            std::printf(
+                "instance=%d audio_cache_replayed_steps=%llu replayed_fraction=%.3f loop_frames=%d\n",
+                i,
+                cache.getReplayedFrames(),
+                (stats.steps > 0) ? (double)cache.getReplayedFrames() / stats.steps : 0.0,
+                cache.getLoopFrames());
+        }
+
+        const PistonEngineSimulator *pistonSimulator =
+            dynamic_cast<const PistonEngineSimulator *>(instances[i].simulator);
+        if (pistonSimulator != nullptr && pistonSimulator->getChamberZones().getChamberCount() > 0) {
+            const ChamberZones &zones = pistonSimulator->getChamberZones();
+            double unburnedTemperature = 0;
+            for (int j = 0; j < zones.getChamberCount(); ++j) {
+                unburnedTemperature = std::fmax(unburnedTemperature, zones.getUnburnedTemperature(j));
+            }
+
+            std::printf(
+                "instance=%d knock_events=%lld end_gas_temperature_k=%.1f\n",
+                i,
+                zones.getKnockCount(),
+                unburnedTemperature);
+        }
+
+        if (instances[i].simulator->isAudioEnabled()) {
+            const Synthesizer::RenderStatistics render =
+                instances[i].simulator->synthesizer().getRenderStatistics();
+            std::printf(
+                "instance=%d audio_blocks=%llu audio_block_us=%.2f audio_us_per_sample=%.4f\n",
+                i,
+                render.blocks,
+                render.averageBlockMicroseconds(),
+                (render.samples > 0) ? render.microseconds / render.samples : 0.0);
+        }
+
+        if (options.audioMetrics) {
+            instances[i].simulator->updateSnapshot();
+            printAudioMetrics("audio", i, instances[i].simulator->getSnapshot());
+        }
+
+        if (AllocationTracker::IsEnabled()) {
+            std::printf(
+                "instance=%d step_allocations=%llu\n",
+                i,
+                instances[i].simulator->getStepAllocationCount());
+        }
+    }
+
+    *aggregateStepsPerSecond = (wallTime > 0) ? totalSteps / wallTime : 0.0;
+    std::printf(
+        "instances=%d wall_s=%.3f aggregate_steps_per_s=%.0f fluid_precision=%s\n",
+        count,
+        wallTime,
+        *aggregateStepsPerSecond,
+        (sizeof(FluidScalar) == sizeof(float)) ? "float" : "double");
+
+    // Only recorded in ENGINE_SIM_PROFILE_STEPS builds; totals are summed over
+    // every thread and every run so far in this process
+    if (StepProfiler::IsEnabled()) {
+        for (int i = 0; i < StepProfiler::StageCount; ++i) {
+            const StepProfiler::Stage stage = static_cast<StepProfiler::Stage>(i);
+
+            StepProfiler::Statistics statistics;
+            StepProfiler::GetStatistics(stage, &statistics);
+
+            std::printf(
+                "stage=%s calls=%llu total_ms=%.1f mean_us=%.3f p50_us=%.3f p99_us=%.3f\n",
+                StepProfiler::GetStageName(stage),
+                (unsigned long long)statistics.count,
+                statistics.totalMicroseconds / 1000.0,
+                statistics.averageMicroseconds(),
+                statistics.percentileMicroseconds(0.5),
+                statistics.percentileMicroseconds(0.99));
+
+            if (statistics.counterSamples > 0) {
+                std::printf(
+                    "stage_counters=%s ipc=%.2f cycles=%.0f instructions=%.0f cache_misses=%.1f branch_misses=%.1f\n",
+                    StepProfiler::GetStageName(stage),
+                    statistics.ipc(),
+                    statistics.countersPerCall(HardwareCounters::Counter::Cycles),
+                    statistics.countersPerCall(HardwareCounters::Counter::Instructions),
+                    statistics.countersPerCall(HardwareCounters::Counter::CacheMisses),
+                    statistics.countersPerCall(HardwareCounters::Counter::BranchMisses));
+            }
+        }
+    }
+
+    // Only counted in ENGINE_SIM_COUNT_EVENTS builds; summed over every
+    // instance of this run
+    if (EventCounters::IsEnabled()) {
+        EventCounters::Totals events;
+        EventCounters::GetTotals(&events);
+        events = events.since(events0);
+
+        for (int i = 0; i < EventCounters::CounterCount; ++i) {
+            const EventCounters::Counter counter = static_cast<EventCounters::Counter>(i);
+            std::printf(
+                "event=%s count=%llu per_step=%.3f\n",
+                EventCounters::GetName(counter),
+                (unsigned long long)events.get(counter),
+                (totalSteps > 0) ? static_cast<double>(events.get(counter)) / totalSteps : 0.0);
+        }
+
+        std::printf("choked_flow_fraction=%.4f\n", events.chokedFraction());
+    }
+
+    if (AllocationTracker::IsEnabled()) {
+        for (int i = 0; i < AllocationTracker::TagCount; ++i) {
+            const AllocationTracker::Tag tag = static_cast<AllocationTracker::Tag>(i);
+
+            AllocationTracker::TagStatistics statistics;
+            AllocationTracker::GetTagStatistics(tag, &statistics);
+
+            std::printf(
+                "allocation_tag=%s live_kb=%.1f live_allocations=%llu total_mb=%.2f total_allocations=%llu\n",
+                AllocationTracker::GetTagName(tag),
+                statistics.liveBytes / 1024.0,
+                (unsigned long long)statistics.liveAllocations,
+                statistics.totalBytes / (1024.0 * 1024.0),
+                (unsigned long long)statistics.totalAllocations);
+        }
+    }
+
+    // Saved from the single-instance baseline run only
+    bool saved = true;
+    if (!options.saveCheckpointPath.empty() && count == 1) {
+        PistonEngineSimulator *simulator = dynamic_cast<PistonEngineSimulator *>(instances[0].simulator);
+
+        SimulationCheckpoint checkpoint;
+        if (simulator != nullptr) checkpoint.capture(simulator);
+        saved = !checkpoint.isEmpty() && checkpoint.save(options.saveCheckpointPath);
+
+        if (saved) {
+            std::printf("checkpoint=%s bytes=%zu\n", options.saveCheckpointPath.c_str(), checkpoint.getSize());
+        }
+        else {
+            std::fprintf(stderr, "failed to save checkpoint to '%s'\n", options.saveCheckpointPath.c_str());
+        }
+    }
+
+    for (Instance &instance : instances) {
+        destroyInstance(&instance);
+    }
+
+    return saved;
+}
+
+void writeProfileTrace(const Options &options) {
+    if (options.profileTracePath.empty()) return;
+
+    StepProfiler::StopCapture();
+    if (StepProfiler::WriteChromeTrace(options.profileTracePath)) {
+        std::printf("profile_trace=%s\n", options.profileTracePath.c_str());
+    }
+    else {
+        std::fprintf(stderr, "failed to write profile trace '%s'\n", options.profileTracePath.c_str());
+    }
+}
+} /* namespace */
+
+int main(int argc, char **argv) {
+    DebugTrace::InitializeFromArguments(argc, argv);
+
+    Options options;
+    if (!parseArguments(argc, argv, &options)) {
+        std::fprintf(
+            stderr,
+            "usage: engine-sim-headless [--asset-path=dir] [--script=file.mr] [--duration=s]"
+            " [--script-parameters=name=value,...] [--snapshot=file] [--export-snapshot=file]"
+            " [--load-checkpoint=file] [--save-checkpoint=file] [--audio-output=file.wav] [--profile-trace=file.json]"
+            " [--throttle=t0:v0,t1:v1,...] [--starter-time=s] [--warm-start=rpm] [--dyno-rpm=rpm] [--frame-length=s]"
+            " [--instances=n] [--fluid-threads=n] [--batched-flow-rates] [--runner-coarsening=n]"
+            " [--implicit-runner-flow]"
+            " [--rigid-body-interval=n] [--reduced-kinematics] [--dynamic-step-kernels] [--no-constraint-pruning] [--speculative-steps=refinement]"
+            " [--burn-model=flame-front|wiebe] [--heat-transfer=constant|woschni]"
+            " [--adaptive-fluid-steps=min:max] [--seed=n]"
+            " [--latency-profile=live|balanced|offline] [--audio-latency=s] [--reduced-audio-memory] [--sample-rate=hz] [--telemetry-interval=s]"
+            " [--telemetry-export=/name|file] [--telemetry-decimation=n] [--telemetry-log=file.estl]"
+            " [--ecu-rate=hz] [--ecu-afr=afr] [--ecu-idle-rpm=rpm] [--ecu-rev-limit=rpm]"
+            " [--stream-port=n] [--stream-frame=samples] [--stream-listeners=n] [--metrics-port=n]"
+            " [--midi-device=path] [--osc-port=n]"
+            " [--flight-recorder=frames] [--flight-recorder-dir=directory]"
+            " [--dyno-sweep=min:max:step] [--sweep-output=file.csv] [--sweep-throttle=0..1]"
+            " [--sweep-settle=s] [--sweep-cycles=n] [--sweep-threads=n]"
+            " [--sweep-fixed] [--sweep-tolerance=torque:rpm:manifold:afr]"
+            " [--batch-sweep=min:max:step] [--batch-copies=n] [--batch-measure=s] [--batch-output=file.csv]"
+            " [--study=parameter:min:max:steps,...] [--study-design=grid|random] [--study-samples=n]"
+            " [--study-output=file.csv] [--study-coordinator=port] [--study-worker=host:port]"
+            " [--study-duplicates=n] [--audio-metrics] [--physics-only] [--hardware-counters] [--fidelity=full|preview]"
+            " [--kernel-isa=scalar|sse2|avx2|avx512|neon]"
+            " [--calibrate-fidelity] [--fidelity-headroom=0..1] [--cost-estimate] [--audio-cache]"
+            " [--no-ir-preprocessing] [--ir-min-phase] [--ir-energy-threshold=fraction]"
+            " [--artifact-cache=directory] [--artifact-cache-size=mb] [--ir-report] [--offload-convolution-tail]"
+            " [--record-input=file.eis] [--replay-input=file.eis]"
+            " [--bake-sound-bank=file.esb] [--bank-rpm=min:max:step] [--bank-throttle=t,...]"
+            " [--bank-cycles=n] [--bank-frames=n] [--play-sound-bank=file.esb]"
+            " [--capture-synth=file.essc] [--replay-synth=file.essc] [--replay-ir=file.wav]"
+            " [--replay-ir-volume=v] [--replay-exhaust-volume=v] [--replay-volume=v] [--replay-convolution=0..1]"
+            " [--drive-cycle=launch|file.csv] [--drive-targets=kph,...] [--drive-time=s]"
+            " [--shift-rpm=rpm] [--drive-diff-ratios=r,...] [--drive-threads=n]"
+            " [--realtime-scheduling] [--lockstep] [--no-realtime-audio] [--realtime-physics]"
+            " [--audio-core=n] [--physics-core=n] [--placement=none|numa]\n");
+        return 1;
+    }
+
+    ThreadPolicy::Settings threadSettings;
+    threadSettings.realtimeAudio = options.realtimeAudio;
+    threadSettings.realtimePhysics = options.realtimePhysics;
+    threadSettings.audioCore = options.audioCore;
+    threadSettings.physicsCore = options.physicsCore;
+    ThreadPolicy::SetSettings(threadSettings);
+
+    ImpulseResponseProcessor::Parameters irParameters;
+    irParameters.enabled = options.irPreprocessing;
+    irParameters.minimumPhase = options.irMinimumPhase;
+    irParameters.energyThreshold = options.irEnergyThreshold;
+    ImpulseResponseCache::SetPreprocessing(irParameters);
+    ArtifactCache::Shared().configure(
+        options.artifactCacheDirectory,
+        static_cast<uint64_t>(options.artifactCacheSize) * 1024 * 1024);
+
+    if (!options.kernelIsa.empty()) {
+        KernelDispatch::Isa isa;
+        if (!KernelDispatch::Parse(options.kernelIsa.c_str(), &isa)) {
+            std::fprintf(stderr, "expected --kernel-isa=scalar|sse2|avx2|avx512|neon\n");
+            return 1;
+        }
+        else if (!KernelDispatch::SetIsa(isa)) {
+            std::fprintf(stderr, "--kernel-isa=%s isn't supported by this build or host\n", options.kernelIsa.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("kernel_isa=%s\n", KernelDispatch::GetName(KernelDispatch::GetIsa()));
+
+    if (options.hardwareCounters) {
+        if (!StepProfiler::IsEnabled()) {
+            std::fprintf(stderr, "--hardware-counters needs a build with ENGINE_SIM_PROFILE_STEPS=ON\n");
+        }
+        else if (!HardwareCounters::IsSupported()) {
+            std::fprintf(stderr, "hardware counters are unavailable on this system\n");
+        }
+
+        HardwareCounters::SetEnabled(true);
+    }
+
+    // The ring holds the last few seconds of spans at typical step rates
+    if (!options.profileTracePath.empty()) {
+        if (!StepProfiler::IsEnabled()) {
+            std::fprintf(stderr, "--profile-trace needs a build with ENGINE_SIM_PROFILE_STEPS=ON\n");
+        }
+
+        StepProfiler::SetThreadName("main");
+        StepProfiler::StartCapture(1 << 22);
+    }
+
+    if (!options.exportSnapshotPath.empty()) {
+        if (!exportSnapshot(options)) {
+            std::fprintf(stderr, "failed to export engine snapshot to '%s'\n", options.exportSnapshotPath.c_str());
+            writeProfileTrace(options);
+            DebugTrace::Shutdown();
+            return 1;
+        }
+
+        std::printf("snapshot=%s\n", options.exportSnapshotPath.c_str());
+    }
+
+    if (!options.studyWorker.empty()) {
+        const bool worked = runStudyWorker(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return worked ? 0 : 1;
+    }
+
+    if (!options.study.empty()) {
+        const bool studied = runParameterStudy(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return studied ? 0 : 1;
+    }
+
+    if (!options.driveCycle.empty()) {
+        const bool driven = runDriveCycle(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return driven ? 0 : 1;
+    }
+
+    if (!options.replaySynth.empty()) {
+        const bool replayed = runSynthesizerReplay(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return replayed ? 0 : 1;
+    }
+
+    if (!options.playSoundBank.empty()) {
+        const bool played = runSoundBankPlayback(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return played ? 0 : 1;
+    }
+
+    if (!options.bakeSoundBank.empty()) {
+        const bool baked = runSoundBankBake(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return baked ? 0 : 1;
+    }
+
+    if (!options.batchSweep.empty()) {
+        const bool swept = runBatchSweep(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return swept ? 0 : 1;
+    }
+
+    if (!options.dynoSweep.empty()) {
+        const bool swept = runDynoSweep(options);
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return swept ? 0 : 1;
+    }
+
+    // Multi-instance runs measure a single-instance baseline first so the
+    // scaling efficiency can be reported.
+    double baseline = 0.0;
+    if (!runInstances(options, 1, &baseline)) {
+        writeProfileTrace(options);
+        DebugTrace::Shutdown();
+        return 1;
+    }
+
+    if (options.instances > 1) {
+        double aggregate = 0.0;
+        if (!runInstances(options, options.instances, &aggregate)) {
+            writeProfileTrace(options);
+            DebugTrace::Shutdown();
+            return 1;
+        }
+
+        std::printf(
+            "scaling instances=%d speedup=%.2f efficiency=%.2f hardware_threads=%u\n",
+            options.instances,
+            (baseline > 0) ? aggregate / baseline : 0.0,
+            (baseline > 0) ? aggregate / (baseline * options.instances) : 0.0,
+            std::thread::hardware_concurrency());
+    }
+
+    writeProfileTrace(options);
+
+    DebugTrace::Shutdown();
+
+    return 0;
+}
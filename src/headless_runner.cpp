@@ -0,0 +1,268 @@
+#include "../include/headless_runner.h"
+
+#include "../include/debug_trace.h"
+#include "../include/denormals.h"
+#include "../include/utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+HeadlessRunner::HeadlessRunner() {
+    m_audioBuffer = nullptr;
+    m_audioBufferSize = 0;
+}
+
+HeadlessRunner::~HeadlessRunner() {
+    assert(m_audioBuffer == nullptr);
+}
+
+void HeadlessRunner::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.frameLength = std::max(params.frameLength, 1E-4);
+
+    std::stable_sort(
+        m_parameters.schedule.begin(),
+        m_parameters.schedule.end(),
+        [](const ControlPoint &a, const ControlPoint &b) { return a.time < b.time; });
+
+    m_audioBufferSize = 44100;
+    m_audioBuffer = new int16_t[m_audioBufferSize];
+}
+
+void HeadlessRunner::destroy() {
+    delete[] m_audioBuffer;
+    m_audioBuffer = nullptr;
+    m_audioBufferSize = 0;
+}
+
+HeadlessRunner::Statistics HeadlessRunner::run(Simulator *simulator) {
+    Statistics stats;
+    if (simulator == nullptr || simulator->getEngine() == nullptr) {
+        return stats;
+    }
+
+    DenormalScope denormals;
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "run begin duration=%.3f frame_length=%.6f speed=%.3f offline=%d schedule_points=%d",
+        m_parameters.duration,
+        m_parameters.frameLength,
+        m_parameters.simulationSpeed,
+        m_parameters.offline ? 1 : 0,
+        static_cast<int>(m_parameters.schedule.size()));
+
+    simulator->setSimulationSpeed(m_parameters.simulationSpeed);
+    simulator->setOfflineMode(m_parameters.offline);
+
+    if (m_parameters.lockstep) return runLockstep(simulator);
+
+    // Live frames skip their steps while the synthesizer is ahead of its
+    // latency target; this many in a row means the run can't advance
+    constexpr int MaxIdleFrames = 1000;
+    int idleFrames = 0;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    while (stats.simulatedTime < m_parameters.duration) {
+        ControlPoint control = sampleSchedule(stats.simulatedTime);
+        if (m_parameters.control) m_parameters.control(stats.simulatedTime, &control);
+        applyControls(simulator, control);
+
+        simulator->startFrame(m_parameters.frameLength);
+        while (simulator->simulateStep()) {
+            stats.fluidSubsteps += simulator->getFluidSimulationSteps();
+        }
+
+        const int steps = simulator->getFrameIterationCount();
+        simulator->endFrame();
+
+        bool stop = false;
+        if (m_parameters.telemetry || m_parameters.stop) {
+            simulator->updateSnapshot();
+            const SimulationSnapshot &snapshot = simulator->getSnapshot();
+            if (m_parameters.telemetry) m_parameters.telemetry(snapshot);
+            if (m_parameters.stop) stop = m_parameters.stop(snapshot);
+        }
+
+        stats.steps += steps;
+        stats.simulatedTime += steps * simulator->getTimestep();
+        stats.audioSamples += drainAudio(simulator);
+        ++stats.frames;
+
+        if (m_parameters.progress) {
+            stats.wallTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0).count() / 1.0E6;
+            m_parameters.progress(simulator, stats);
+        }
+
+        if (stop) break;
+
+        // A frame shorter than half a step never advances the run, and an
+        // offline frame always takes the same count
+        if (steps > 0) {
+            idleFrames = 0;
+        }
+        else if (m_parameters.offline || ++idleFrames >= MaxIdleFrames) {
+            ATG_ENGINE_SIM_TRACE(
+                Headless, Event,
+                "run stalled simulated_s=%.3f frames=%lld frame_length=%.6f timestep=%.9f",
+                stats.simulatedTime,
+                stats.frames,
+                m_parameters.frameLength,
+                simulator->getTimestep());
+            stats.stalled = true;
+            break;
+        }
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+    stats.wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "run complete simulated_s=%.3f wall_s=%.3f rt_factor=%.2f steps=%lld frames=%lld audio_samples=%lld",
+        stats.simulatedTime,
+        stats.wallTime,
+        stats.realTimeFactor(),
+        stats.steps,
+        stats.frames,
+        stats.audioSamples);
+
+    return stats;
+}
+
+HeadlessRunner::Statistics HeadlessRunner::runLockstep(Simulator *simulator) {
+    Statistics stats;
+    const double timestep = simulator->getTimestep();
+
+    RealtimeStepper::Parameters params;
+    params.input = [this, timestep](Simulator *simulator, long long step) {
+        const double t = step * timestep;
+        ControlPoint control = sampleSchedule(t);
+        if (m_parameters.control) m_parameters.control(t, &control);
+        applyControls(simulator, control);
+    };
+
+    params.output = [&stats](Simulator *simulator, long long) {
+        stats.fluidSubsteps += simulator->getFluidSimulationSteps();
+    };
+
+    // The stepper's own totals are only returned at the end
+    const auto t0 = std::chrono::steady_clock::now();
+    const unsigned long long step0 = simulator->getSessionStep();
+    params.frame = [this, &stats, timestep, t0, step0](Simulator *simulator) {
+        stats.audioSamples += drainAudio(simulator);
+        ++stats.frames;
+
+        if (m_parameters.progress) {
+            stats.steps = static_cast<long long>(simulator->getSessionStep() - step0);
+            stats.simulatedTime = stats.steps * timestep;
+            stats.wallTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0).count() / 1.0E6;
+            m_parameters.progress(simulator, stats);
+        }
+
+        bool stop = false;
+        if (m_parameters.telemetry || m_parameters.stop) {
+            simulator->updateSnapshot();
+            const SimulationSnapshot &snapshot = simulator->getSnapshot();
+            if (m_parameters.telemetry) m_parameters.telemetry(snapshot);
+            if (m_parameters.stop) stop = m_parameters.stop(snapshot);
+        }
+
+        return stop;
+    };
+
+    RealtimeStepper stepper;
+    stepper.initialize(params);
+    stats.pacing = stepper.run(simulator, m_parameters.duration / m_parameters.simulationSpeed);
+    stepper.destroy();
+
+    stats.steps = stats.pacing.steps;
+    stats.frames = stats.pacing.frames;
+    stats.simulatedTime = stats.steps * timestep;
+    stats.wallTime = stats.pacing.wallTime;
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "lockstep complete simulated_s=%.3f wall_s=%.3f steps=%lld missed=%lld p99_lateness_us=%.3f",
+        stats.simulatedTime,
+        stats.wallTime,
+        stats.steps,
+        stats.pacing.missedDeadlines,
+        stats.pacing.percentileLatenessMicroseconds(0.99));
+
+    return stats;
+}
+
+HeadlessRunner::ControlPoint HeadlessRunner::sampleSchedule(double t) const {
+    return SampleSchedule(m_parameters.schedule, t);
+}
+
+HeadlessRunner::ControlPoint HeadlessRunner::SampleSchedule(
+    const std::vector<ControlPoint> &schedule,
+    double t)
+{
+    if (schedule.empty()) return ControlPoint();
+    else if (t <= schedule.front().time) return schedule.front();
+    else if (t >= schedule.back().time) return schedule.back();
+
+    size_t i = 1;
+    while (schedule[i].time < t) ++i;
+
+    const ControlPoint &p0 = schedule[i - 1];
+    const ControlPoint &p1 = schedule[i];
+    const double dt = p1.time - p0.time;
+    const double s = (dt > 0) ? clamp((t - p0.time) / dt) : 1.0;
+
+    ControlPoint result = p0;
+    result.time = t;
+    result.throttle = p0.throttle * (1 - s) + p1.throttle * s;
+    result.dynoSpeed = p0.dynoSpeed * (1 - s) + p1.dynoSpeed * s;
+    result.clutch = p0.clutch * (1 - s) + p1.clutch * s;
+
+    return result;
+}
+
+void HeadlessRunner::applyControls(Simulator *simulator, const ControlPoint &control) {
+    // Through the simulator so an input session records them
+    auto apply = [simulator](ControlQueue::Control type, double value) {
+        ControlQueue::Event event;
+        event.control = type;
+        event.value = value;
+        event.immediate = true;
+        simulator->applyControl(event);
+    };
+
+    Engine *engine = simulator->getEngine();
+    apply(ControlQueue::Control::Throttle, clamp(control.throttle));
+    apply(ControlQueue::Control::Ignition, control.ignition ? 1.0 : 0.0);
+    apply(ControlQueue::Control::Starter, control.starter ? 1.0 : 0.0);
+    apply(ControlQueue::Control::DynoEnabled, control.dynoEnabled ? 1.0 : 0.0);
+    apply(ControlQueue::Control::DynoHold, control.dynoEnabled ? 1.0 : 0.0);
+    apply(
+        ControlQueue::Control::DynoSpeed,
+        clamp(control.dynoSpeed, engine->getDynoMinSpeed(), engine->getDynoMaxSpeed()));
+
+    Transmission *transmission = simulator->getTransmission();
+    if (control.drivetrain && transmission != nullptr) {
+        if (transmission->getGear() != control.gear) {
+            apply(ControlQueue::Control::Gear, control.gear);
+        }
+
+        apply(ControlQueue::Control::Clutch, clamp(control.clutch));
+    }
+}
+
+int HeadlessRunner::drainAudio(Simulator *simulator) {
+    if (m_parameters.drain) return m_parameters.drain(simulator);
+
+    const int samples = simulator->readAudioOutput(m_audioBufferSize, m_audioBuffer);
+    if (m_parameters.audio && samples > 0) {
+        m_parameters.audio(m_audioBuffer, samples);
+    }
+
+    return samples;
+}
@@ -1,13 +1,17 @@
 #include "../include/ignition_module.h"
 
+#include "../include/event_counters.h"
 #include "../include/utilities.h"
 #include "../include/constants.h"
 #include "../include/units.h"
 
+#include <algorithm>
 #include <cmath>
 
 IgnitionModule::IgnitionModule() {
     m_plugs = nullptr;
+    m_schedule = nullptr;
+    m_scheduledCount = 0;
     m_crankshaft = nullptr;
     m_timingCurve = nullptr;
     m_cylinderCount = 0;
@@ -16,22 +20,33 @@ IgnitionModule::IgnitionModule() {
     m_revLimitTimer = 0.0;
     m_revLimit = 0;
     m_limiterDuration = 0;
+    m_timingOffset = 0;
+    m_timingTrim = 0;
+    m_manifoldPressure = 0;
+    m_sparkCut = false;
 }
 
 IgnitionModule::~IgnitionModule() {
     assert(m_plugs == nullptr);
+    assert(m_schedule == nullptr);
 }
 
 void IgnitionModule::destroy() {
     delete[] m_plugs;
+    delete[] m_schedule;
+    m_timingMap.destroy();
 
     m_plugs = nullptr;
+    m_schedule = nullptr;
+    m_scheduledCount = 0;
     m_cylinderCount = 0;
 }
 
 void IgnitionModule::initialize(const Parameters &params) {
     m_cylinderCount = params.cylinderCount;
     m_plugs = new SparkPlug[m_cylinderCount];
+    m_schedule = new ScheduledFiring[m_cylinderCount];
+    m_scheduledCount = 0;
     m_crankshaft = params.crankshaft;
     m_timingCurve = params.timingCurve;
     m_revLimit = params.revLimit;
@@ -43,6 +58,33 @@ void IgnitionModule::setFiringOrder(int cylinderIndex, double angle) {
 
     m_plugs[cylinderIndex].angle = angle;
     m_plugs[cylinderIndex].enabled = true;
+    schedule(cylinderIndex);
+}
+
+void IgnitionModule::setCylinderTrim(int cylinderIndex, double trim) {
+    assert(cylinderIndex < m_cylinderCount);
+
+    m_plugs[cylinderIndex].trim = trim;
+    if (m_plugs[cylinderIndex].enabled) {
+        schedule(cylinderIndex);
+    }
+}
+
+void IgnitionModule::schedule(int cylinderIndex) {
+    ScheduledFiring *end = m_schedule + m_scheduledCount;
+    end = std::remove_if(m_schedule, end, [cylinderIndex](const ScheduledFiring &firing) {
+        return firing.cylinder == cylinderIndex;
+    });
+
+    // More advance fires the plug earlier in the cycle
+    const SparkPlug &plug = m_plugs[cylinderIndex];
+    const ScheduledFiring firing = { positiveMod(plug.angle - plug.trim, 4 * constants::pi), cylinderIndex };
+    ScheduledFiring *position = std::upper_bound(m_schedule, end, firing,
+        [](const ScheduledFiring &a, const ScheduledFiring &b) { return a.angle < b.angle; });
+    std::move_backward(position, end, end + 1);
+    *position = firing;
+
+    m_scheduledCount = static_cast<int>(end - m_schedule) + 1;
 }
 
 void IgnitionModule::reset() {
@@ -53,35 +95,19 @@ void IgnitionModule::reset() {
 void IgnitionModule::update(double dt) {
     const double cycleAngle = m_crankshaft->getCycleAngle();
 
-    if (m_enabled && m_revLimitTimer == 0) {
+    if (m_enabled && !m_sparkCut && m_revLimitTimer == 0) {
+        // The advance shifts every plug by the same amount, so the swept
+        // window is shifted instead and looked up in the sorted schedule
         const double fourPi = 4 * constants::pi;
         const double advance = getTimingAdvance();
+        const double r0 = m_lastCrankshaftAngle;
+        const double r1 = cycleAngle;
 
-        for (int i = 0; i < m_cylinderCount; ++i) {
-            double adjustedAngle = positiveMod(m_plugs[i].angle - advance, fourPi);
-            const double r0 = m_lastCrankshaftAngle;
-            double r1 = cycleAngle;
-
-            if (m_crankshaft->m_body.v_theta < 0) {
-                if (r1 < r0) {
-                    r1 += fourPi;
-                    adjustedAngle += fourPi;
-                }
-
-                if (adjustedAngle >= r0 && adjustedAngle < r1) {
-                    m_plugs[i].ignitionEvent = m_plugs[i].enabled;
-                }
-            }
-            else {
-                if (r1 > r0) {
-                    r1 -= fourPi;
-                    adjustedAngle -= fourPi;
-                }
-
-                if (adjustedAngle >= r1 && adjustedAngle < r0) {
-                    m_plugs[i].ignitionEvent = m_plugs[i].enabled;
-                }
-            }
+        if (m_crankshaft->m_body.v_theta < 0) {
+            fireWindow(r0 + advance, (r1 < r0) ? r1 + fourPi - r0 : r1 - r0);
+        }
+        else {
+            fireWindow(r1 + advance, (r1 > r0) ? r0 + fourPi - r1 : r0 - r1);
         }
     }
 
@@ -108,7 +134,35 @@ void IgnitionModule::resetIgnitionEvents() {
 }
 
 double IgnitionModule::getTimingAdvance() {
-    return m_timingCurve->sampleTriangle(-m_crankshaft->m_body.v_theta);
+    const double speed = -m_crankshaft->m_body.v_theta;
+    const double advance = (m_timingMap.isBaked())
+        ? m_timingMap.sample(speed, m_manifoldPressure)
+        : m_timingCurve->sampleTriangle(speed);
+
+    return advance + m_timingOffset + m_timingTrim;
+}
+
+void IgnitionModule::fireWindow(double start, double length) {
+    const double fourPi = 4 * constants::pi;
+    start = positiveMod(start, fourPi);
+    const double end = start + length;
+
+    const ScheduledFiring *first = m_schedule;
+    const ScheduledFiring *last = m_schedule + m_scheduledCount;
+    const ScheduledFiring *firing = std::lower_bound(first, last, start,
+        [](const ScheduledFiring &a, double angle) { return a.angle < angle; });
+
+    int fired = 0;
+    for (; firing != last && firing->angle < end; ++firing, ++fired) {
+        m_plugs[firing->cylinder].ignitionEvent = true;
+    }
+
+    // The window wraps past the end of the cycle
+    for (firing = first; firing != last && firing->angle + fourPi < end; ++firing, ++fired) {
+        m_plugs[firing->cylinder].ignitionEvent = true;
+    }
+
+    ATG_ENGINE_SIM_COUNT(IgnitionEvents, fired);
 }
 
 IgnitionModule::SparkPlug *IgnitionModule::getPlug(int i) {
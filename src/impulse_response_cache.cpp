@@ -0,0 +1,279 @@
+#include "../include/impulse_response_cache.h"
+
+#include "../include/allocation_tracker.h"
+#include "../include/artifact_cache.h"
+#include "../include/impulse_response.h"
+#include "../include/job_system.h"
+#include "../include/synthesizer.h"
+#include "../include/wav_file.h"
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+namespace {
+// File, volume and the rate the taps are resampled to
+typedef std::tuple<std::string, double, double> Key;
+
+struct FileStamp {
+    std::filesystem::file_time_type modified;
+    uintmax_t size = 0;
+
+    bool operator==(const FileStamp &other) const {
+        return modified == other.modified && size == other.size;
+    }
+};
+
+struct Entry {
+    std::shared_ptr<const ImpulseResponseCache::Kernel> kernel;
+    FileStamp stamp;
+};
+
+struct Request {
+    Key key;
+    FileStamp stamp;
+    std::shared_ptr<const ImpulseResponseCache::Kernel> kernel;
+};
+
+std::mutex g_lock;
+std::map<Key, Entry> g_entries;
+ImpulseResponseProcessor::Parameters g_preprocessing;
+int g_diskHits = 0;
+
+ArtifactCache::Key artifactKey(
+    const Key &key,
+    const ImpulseResponseProcessor::Parameters &params,
+    bool *readable)
+{
+    ArtifactCache::Key artifact(ArtifactCache::Kind::ImpulseResponse);
+    *readable = artifact.addFile(std::get<0>(key));
+    artifact
+        .add(std::get<1>(key))
+        .add(std::get<2>(key))
+        .add(params.enabled)
+        .add(params.energyThreshold)
+        .add(params.minimumPhase)
+        .add(params.maxSamples);
+
+    return artifact;
+}
+
+bool readArtifact(const ArtifactCache::Key &key, ConvolutionFilter *filter) {
+    ArtifactCache::Artifact artifact;
+    if (!ArtifactCache::Shared().load(key, &artifact)) return false;
+
+    const int samples = static_cast<int>(artifact.getSize() / sizeof(float));
+    if (samples <= 0 || artifact.getSize() != samples * sizeof(float)) return false;
+
+    filter->initialize(samples);
+    std::memcpy(filter->getImpulseResponse(), artifact.getData(), artifact.getSize());
+
+    return true;
+}
+
+bool stampFile(const std::string &filename, FileStamp *stamp) {
+    std::error_code error;
+    stamp->size = std::filesystem::file_size(filename, error);
+    if (error) return false;
+
+    stamp->modified = std::filesystem::last_write_time(filename, error);
+    return !error;
+}
+
+// Called without the lock held; decoding dominates the cost of a load
+std::shared_ptr<const ImpulseResponseCache::Kernel> decode(
+    const Key &key,
+    const ImpulseResponseProcessor::Parameters &params)
+{
+    ATG_ENGINE_SIM_ALLOCATION_SCOPE(Loader);
+
+    bool keyed = false;
+    const bool diskCache = ArtifactCache::Shared().isEnabled();
+    const ArtifactCache::Key cacheKey = diskCache
+        ? artifactKey(key, params, &keyed)
+        : ArtifactCache::Key(ArtifactCache::Kind::ImpulseResponse);
+    if (keyed) {
+        std::shared_ptr<ImpulseResponseCache::Kernel> kernel = std::make_shared<ImpulseResponseCache::Kernel>();
+        if (readArtifact(cacheKey, &kernel->filter)) {
+            kernel->filter.preparePartitioned();
+            {
+                std::lock_guard<std::mutex> lock(g_lock);
+                ++g_diskHits;
+            }
+
+            return kernel;
+        }
+    }
+
+    WavFile file;
+    if (!file.load(std::get<0>(key))) {
+        ATG_ENGINE_SIM_TRACE(Assets, Event, "failed to decode impulse response '%s'", std::get<0>(key).c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<ImpulseResponseCache::Kernel> kernel = std::make_shared<ImpulseResponseCache::Kernel>();
+    Synthesizer::prepareImpulseResponse(
+        file.getSamples(),
+        file.getSampleCount(),
+        static_cast<float>(std::get<1>(key)),
+        &kernel->filter,
+        file.getSampleRate(),
+        std::get<2>(key));
+    if (file.getSampleCount() > 0) {
+        const int original = kernel->filter.getSampleCount();
+        ImpulseResponseProcessor::Process(params, &kernel->filter);
+        ATG_ENGINE_SIM_TRACE(
+            Assets, Event,
+            "impulse_response '%s' taps=%d processed=%d",
+            std::get<0>(key).c_str(),
+            original,
+            kernel->filter.getSampleCount());
+
+        if (keyed) {
+            ArtifactCache::Shared().store(
+                cacheKey,
+                kernel->filter.getImpulseResponse(),
+                sizeof(float) * kernel->filter.getSampleCount());
+        }
+
+        kernel->filter.preparePartitioned();
+    }
+
+    return kernel;
+}
+
+std::shared_ptr<const ImpulseResponseCache::Kernel> lookup(const Key &key, const FileStamp &stamp) {
+    auto entry = g_entries.find(key);
+    return (entry != g_entries.end() && entry->second.stamp == stamp)
+        ? entry->second.kernel
+        : nullptr;
+}
+} /* namespace */
+
+ImpulseResponseCache::Kernel::Kernel() {
+    /* void */
+}
+
+ImpulseResponseCache::Kernel::~Kernel() {
+    filter.destroy();
+}
+
+void ImpulseResponseCache::Load(
+    ImpulseResponse *const *responses,
+    int count,
+    double sampleRate,
+    std::vector<std::shared_ptr<const Kernel>> *kernels)
+{
+    kernels->assign(count, nullptr);
+
+    std::vector<Key> keys(count);
+    std::vector<FileStamp> stamps(count);
+    std::vector<bool> present(count, false);
+    std::vector<Request> requests;
+    ImpulseResponseProcessor::Parameters preprocessing;
+    {
+        std::lock_guard<std::mutex> lock(g_lock);
+        preprocessing = g_preprocessing;
+        for (int i = 0; i < count; ++i) {
+            if (responses[i] == nullptr) continue;
+
+            keys[i] = Key(responses[i]->getFilename(), responses[i]->getVolume(), sampleRate);
+            present[i] = stampFile(std::get<0>(keys[i]), &stamps[i]);
+            if (!present[i]) continue;
+
+            (*kernels)[i] = lookup(keys[i], stamps[i]);
+            if ((*kernels)[i] != nullptr) continue;
+
+            const bool requested = std::any_of(
+                requests.begin(), requests.end(),
+                [&](const Request &request) { return request.key == keys[i]; });
+            if (!requested) {
+                requests.push_back({ keys[i], stamps[i], nullptr });
+            }
+        }
+    }
+
+    if (requests.empty()) return;
+
+    JobSystem::Shared().parallelFor(static_cast<int>(requests.size()), [&](int i) {
+        requests[i].kernel = decode(requests[i].key, preprocessing);
+    }, JobSystem::Priority::Loading);
+
+    std::lock_guard<std::mutex> lock(g_lock);
+    for (const Request &request : requests) {
+        if (request.kernel != nullptr) {
+            g_entries[request.key] = { request.kernel, request.stamp };
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (present[i] && (*kernels)[i] == nullptr) {
+            (*kernels)[i] = lookup(keys[i], stamps[i]);
+        }
+    }
+}
+
+std::shared_ptr<const ImpulseResponseCache::Kernel> ImpulseResponseCache::Get(
+    const std::string &filename,
+    double volume,
+    double sampleRate)
+{
+    FileStamp stamp;
+    if (!stampFile(filename, &stamp)) return nullptr;
+
+    const Key key(filename, volume, sampleRate);
+    ImpulseResponseProcessor::Parameters preprocessing;
+    {
+        std::lock_guard<std::mutex> lock(g_lock);
+        std::shared_ptr<const Kernel> kernel = lookup(key, stamp);
+        if (kernel != nullptr) return kernel;
+
+        preprocessing = g_preprocessing;
+    }
+
+    std::shared_ptr<const Kernel> kernel = decode(key, preprocessing);
+    if (kernel != nullptr) {
+        std::lock_guard<std::mutex> lock(g_lock);
+        g_entries[key] = { kernel, stamp };
+    }
+
+    return kernel;
+}
+
+void ImpulseResponseCache::Clear() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    g_entries.clear();
+}
+
+int ImpulseResponseCache::GetEntryCount() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    return static_cast<int>(g_entries.size());
+}
+
+void ImpulseResponseCache::SetPreprocessing(const ImpulseResponseProcessor::Parameters &params) {
+    std::lock_guard<std::mutex> lock(g_lock);
+    const bool changed =
+        params.enabled != g_preprocessing.enabled
+        || params.energyThreshold != g_preprocessing.energyThreshold
+        || params.minimumPhase != g_preprocessing.minimumPhase
+        || params.maxSamples != g_preprocessing.maxSamples;
+    if (!changed) return;
+
+    g_preprocessing = params;
+    g_entries.clear();
+}
+
+ImpulseResponseProcessor::Parameters ImpulseResponseCache::GetPreprocessing() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    return g_preprocessing;
+}
+
+int ImpulseResponseCache::GetDiskHitCount() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    return g_diskHits;
+}
@@ -0,0 +1,146 @@
+#include "../include/impulse_response_processor.h"
+
+#include "../include/fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace {
+int nextPowerOfTwo(int n) {
+    int size = 1;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+// Power spectrum of the taps zero padded to the transform's size
+void powerSpectrum(const Fft &fft, const float *taps, int samples, std::vector<double> *power) {
+    const int size = fft.getSize();
+    std::vector<std::complex<float>> spectrum(size, 0.0f);
+    for (int i = 0; i < std::min(samples, size); ++i) spectrum[i] = taps[i];
+    fft.forward(spectrum.data());
+
+    power->resize(size / 2 + 1);
+    for (int i = 0; i <= size / 2; ++i) (*power)[i] = std::norm(spectrum[i]);
+}
+} /* namespace */
+
+void ImpulseResponseProcessor::Process(const Parameters &params, ConvolutionFilter *filter) {
+    const int samples = filter->getSampleCount();
+    if (!params.enabled || samples <= 1) return;
+
+    std::vector<float> taps(filter->getImpulseResponse(), filter->getImpulseResponse() + samples);
+    if (params.minimumPhase) {
+        std::vector<float> minimum;
+        MinimumPhase(taps.data(), samples, &minimum);
+        taps = minimum;
+    }
+
+    const int length = std::clamp(
+        EnergyLength(taps.data(), samples, params.energyThreshold),
+        1,
+        std::max(params.maxSamples, 1));
+
+    filter->initialize(length);
+    std::copy(taps.begin(), taps.begin() + length, filter->getImpulseResponse());
+}
+
+int ImpulseResponseProcessor::EnergyLength(const float *taps, int samples, double threshold) {
+    double total = 0.0;
+    for (int i = 0; i < samples; ++i) total += (double)taps[i] * taps[i];
+    if (total <= 0.0) return 1;
+
+    const double tail = std::max(threshold, 0.0) * total;
+    double energy = 0.0;
+    for (int i = samples - 1; i > 0; --i) {
+        energy += (double)taps[i] * taps[i];
+        if (energy > tail) return i + 1;
+    }
+
+    return 1;
+}
+
+void ImpulseResponseProcessor::MinimumPhase(const float *taps, int samples, std::vector<float> *output) {
+    // Real cepstrum folded onto positive quefrencies, padded well past the
+    // response so the log spectrum's cepstrum doesn't alias
+    Fft fft;
+    fft.initialize(nextPowerOfTwo(std::max(8 * samples, 64)));
+    const int size = fft.getSize();
+
+    std::vector<std::complex<float>> spectrum(size, 0.0f);
+    for (int i = 0; i < samples; ++i) spectrum[i] = taps[i];
+    fft.forward(spectrum.data());
+
+    float peak = 0.0f;
+    for (const std::complex<float> &bin : spectrum) peak = std::max(peak, std::abs(bin));
+
+    const float floor = std::max(peak * 1E-7f, 1E-30f);
+    for (std::complex<float> &bin : spectrum) bin = std::log(std::max(std::abs(bin), floor));
+    fft.inverse(spectrum.data());
+
+    spectrum[0] = std::real(spectrum[0]) / (float)size;
+    spectrum[size / 2] = std::real(spectrum[size / 2]) / (float)size;
+    for (int i = 1; i < size / 2; ++i) spectrum[i] = std::real(spectrum[i]) * 2.0f / (float)size;
+    for (int i = size / 2 + 1; i < size; ++i) spectrum[i] = 0.0f;
+
+    fft.forward(spectrum.data());
+    for (std::complex<float> &bin : spectrum) bin = std::exp(bin);
+    fft.inverse(spectrum.data());
+
+    output->resize(samples);
+    for (int i = 0; i < samples; ++i) (*output)[i] = std::real(spectrum[i]) / size;
+
+    fft.destroy();
+}
+
+ImpulseResponseProcessor::Report ImpulseResponseProcessor::Compare(
+    const ConvolutionFilter &original,
+    const ConvolutionFilter &processed,
+    double sampleRate)
+{
+    Report report;
+    report.originalSamples = original.getSampleCount();
+    report.processedSamples = processed.getSampleCount();
+    if (report.originalSamples <= 0 || report.processedSamples <= 0 || sampleRate <= 0) return report;
+
+    Fft fft;
+    fft.initialize(nextPowerOfTwo(std::max({ 2 * report.originalSamples, 2 * report.processedSamples, 8192 })));
+    std::vector<double> a, b;
+    powerSpectrum(fft, original.getImpulseResponse(), report.originalSamples, &a);
+    powerSpectrum(fft, processed.getImpulseResponse(), report.processedSamples, &b);
+    const int size = fft.getSize();
+    fft.destroy();
+
+    std::vector<double> bandsA, bandsB;
+    const double binWidth = sampleRate / size;
+    for (double low = 20.0; low * std::cbrt(2.0) < 0.45 * sampleRate; low *= std::cbrt(2.0)) {
+        const int first = std::max(1, static_cast<int>(std::ceil(low / binWidth)));
+        const int last = std::min(size / 2, static_cast<int>(low * std::cbrt(2.0) / binWidth));
+
+        double energyA = 0.0, energyB = 0.0;
+        for (int i = first; i <= last; ++i) {
+            energyA += a[i];
+            energyB += b[i];
+        }
+
+        if (last >= first) {
+            bandsA.push_back(energyA);
+            bandsB.push_back(energyB);
+        }
+    }
+
+    const double loudest = bandsA.empty() ? 0.0 : *std::max_element(bandsA.begin(), bandsA.end());
+    int counted = 0;
+    for (size_t i = 0; i < bandsA.size(); ++i) {
+        if (bandsA[i] <= loudest * 1E-6) continue;
+
+        const double deviation = std::abs(10 * std::log10(std::max(bandsB[i], 1E-30) / bandsA[i]));
+        report.maxDeviation = std::max(report.maxDeviation, deviation);
+        report.meanDeviation += deviation;
+        ++counted;
+    }
+
+    if (counted > 0) report.meanDeviation /= counted;
+
+    return report;
+}
@@ -75,25 +75,29 @@ void InfoCluster::render() {
         Bounds::lm,
         Bounds::lm);
 
-    std::stringstream ss;
-    if (m_engine != nullptr) {
-        ss << std::fixed;
-
-        if (m_engine->getDisplacement() < units::volume(1.0, units::L)) {
-            ss << std::setprecision(0) << units::convert(m_engine->getDisplacement(), units::cc) << " cc -- ";
+    if (m_engineInfoText.empty()) {
+        std::stringstream ss;
+        if (m_engine != nullptr) {
+            ss << std::fixed;
+
+            if (m_engine->getDisplacement() < units::volume(1.0, units::L)) {
+                ss << std::setprecision(0) << units::convert(m_engine->getDisplacement(), units::cc) << " cc -- ";
+            }
+            else {
+                ss << std::setprecision(1) << units::convert(m_engine->getDisplacement(), units::L) << " L -- ";
+            }
+
+            ss << std::setprecision(0) << units::convert(m_engine->getDisplacement(), units::cubic_inches) << " CI";
         }
         else {
-            ss << std::setprecision(1) << units::convert(m_engine->getDisplacement(), units::L) << " L -- ";
+            ss << "N/A";
         }
 
-        ss << std::setprecision(0) << units::convert(m_engine->getDisplacement(), units::cubic_inches) << " CI";
-    }
-    else {
-        ss << "N/A";
+        m_engineInfoText = ss.str();
     }
 
     drawAlignedText(
-        ss.str(),
+        m_engineInfoText,
         engineInfoBounds.inset(10.0f),
         24.0f,
         Bounds::rm,
@@ -0,0 +1,205 @@
+#include "../include/input_session.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// A step delta, a control and a value at the most
+constexpr size_t MaxEventBytes = 10 + 1 + sizeof(double);
+
+bool readVarint(const uint8_t *data, size_t size, size_t *offset, unsigned long long *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && *offset < size; shift += 7) {
+        const uint8_t byte = data[(*offset)++];
+        *value |= (unsigned long long)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+
+    return false;
+}
+} /* namespace */
+
+InputSession::InputSession() {
+    m_seed = 0;
+    m_simulationFrequency = 0.0;
+    m_length = 0;
+
+    m_file = nullptr;
+    m_capacity = 0;
+    m_lastStep = 0;
+    m_written = 0;
+    m_dropped = 0;
+    m_failed = false;
+
+    m_cursor = 0;
+    m_replaying = false;
+
+    std::fill(m_lastValues, m_lastValues + ControlCount, 0.0);
+    std::fill(m_hasLastValue, m_hasLastValue + ControlCount, false);
+}
+
+InputSession::~InputSession() {
+    if (m_file != nullptr) std::fclose(m_file);
+}
+
+bool InputSession::record(const std::string &path, uint64_t seed, double simulationFrequency, int capacity) {
+    close(0);
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.seed = seed;
+    header.simulationFrequency = simulationFrequency;
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) return false;
+    else if (std::fwrite(&header, sizeof(Header), 1, m_file) != 1) {
+        std::fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+
+    m_seed = seed;
+    m_simulationFrequency = simulationFrequency;
+    m_length = 0;
+    m_capacity = (size_t)std::max(capacity, 1) * MaxEventBytes;
+    m_encoded.clear();
+    m_encoded.reserve(m_capacity + MaxEventBytes);
+    m_lastStep = 0;
+    m_written = 0;
+    m_dropped = 0;
+    m_failed = false;
+    std::fill(m_hasLastValue, m_hasLastValue + ControlCount, false);
+
+    return true;
+}
+
+void InputSession::write(unsigned long long step, ControlQueue::Control control, double value) {
+    if (m_file == nullptr) return;
+
+    const int index = static_cast<int>(control);
+    if (control != ControlQueue::Control::Gear
+        && m_hasLastValue[index]
+        && std::memcmp(&m_lastValues[index], &value, sizeof(double)) == 0)
+    {
+        return;
+    }
+    else if (m_encoded.size() + MaxEventBytes > m_capacity) {
+        ++m_dropped;
+        return;
+    }
+
+    encode(step, static_cast<uint8_t>(index), &value);
+    m_lastValues[index] = value;
+    m_hasLastValue[index] = true;
+    ++m_written;
+}
+
+bool InputSession::flush() {
+    if (m_file == nullptr) return false;
+    else if (m_encoded.empty()) return !m_failed;
+
+    m_failed = m_failed
+        || std::fwrite(m_encoded.data(), 1, m_encoded.size(), m_file) != m_encoded.size();
+    m_encoded.clear();
+
+    return !m_failed;
+}
+
+bool InputSession::load(const std::string &path) {
+    close(0);
+
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+
+    std::fclose(file);
+
+    Header header;
+    if (data.size() < sizeof(Header)) return false;
+
+    std::memcpy(&header, data.data(), sizeof(Header));
+    if (header.magic != Magic || header.version != Version) return false;
+
+    // A session cut short by a crash has no end marker and runs to its
+    // last event
+    std::vector<Event> events;
+    unsigned long long step = 0, length = 0;
+    size_t offset = sizeof(Header);
+    while (offset < data.size()) {
+        unsigned long long delta;
+        if (!readVarint(data.data(), data.size(), &offset, &delta) || offset >= data.size()) return false;
+
+        step += delta;
+        length = step;
+
+        const uint8_t control = data[offset++];
+        if (control == EndMarker) break;
+        else if (control >= ControlCount || offset + sizeof(double) > data.size()) return false;
+
+        Event event;
+        event.step = step;
+        event.control = static_cast<ControlQueue::Control>(control);
+        std::memcpy(&event.value, data.data() + offset, sizeof(double));
+        offset += sizeof(double);
+
+        events.push_back(event);
+    }
+
+    m_seed = header.seed;
+    m_simulationFrequency = header.simulationFrequency;
+    m_length = length;
+    m_events = std::move(events);
+    m_cursor = 0;
+    m_replaying = true;
+
+    return true;
+}
+
+const InputSession::Event *InputSession::next(unsigned long long step) {
+    if (m_cursor >= m_events.size() || m_events[m_cursor].step > step) return nullptr;
+
+    return &m_events[m_cursor++];
+}
+
+bool InputSession::close(unsigned long long step) {
+    bool closed = true;
+    if (m_file != nullptr) {
+        encode(std::max(step, m_lastStep), EndMarker, nullptr);
+        closed = flush();
+        closed = (std::fclose(m_file) == 0) && closed;
+        m_file = nullptr;
+        m_length = std::max(step, m_lastStep);
+    }
+
+    m_events.clear();
+    m_cursor = 0;
+    m_replaying = false;
+
+    return closed;
+}
+
+void InputSession::encode(unsigned long long step, uint8_t control, const double *value) {
+    // Controls applied between frames land on the step about to run, which
+    // never goes back
+    unsigned long long delta = (step > m_lastStep) ? step - m_lastStep : 0;
+    m_lastStep = std::max(step, m_lastStep);
+
+    do {
+        const uint8_t byte = delta & 0x7F;
+        delta >>= 7;
+        m_encoded.push_back((delta != 0) ? (byte | 0x80) : byte);
+    } while (delta != 0);
+
+    m_encoded.push_back(control);
+    if (value != nullptr) {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(value);
+        m_encoded.insert(m_encoded.end(), bytes, bytes + sizeof(double));
+    }
+}
@@ -15,6 +15,11 @@ Intake::Intake() {
     m_totalFuelInjected = 0;
     m_molecularAfr = 0;
     m_runnerLength = 0;
+    m_runnerSegments = 0;
+    m_fuelTrim = 0;
+    m_idleAir = 1.0;
+
+    m_throttleFlow = m_idleFlow = GasSystem::ReservoirFlowParameters();
 }
 
 Intake::~Intake() {
@@ -33,16 +38,6 @@ void Intake::initialize(Parameters &params) {
         1.0,
         0.0);
 
-    m_atmosphere.initialize(
-        units::pressure(1.0, units::atm),
-        units::volume(1000.0, units::m3),
-        units::celcius(25.0));
-    m_atmosphere.setGeometry(
-        units::distance(100.0, units::m),
-        units::distance(100.0, units::m),
-        1.0,
-        0.0);
-
     m_inputFlowK = params.InputFlowK;
     m_molecularAfr = params.MolecularAfr;
     m_idleFlowK = params.IdleFlowK;
@@ -50,60 +45,70 @@ void Intake::initialize(Parameters &params) {
     m_runnerLength = params.RunnerLength;
     m_crossSectionArea = params.CrossSectionArea;
     m_velocityDecay = params.VelocityDecay;
+    m_runnerSegments = params.RunnerSegments;
     m_runnerFlowRate = params.RunnerFlowRate;
+    m_fuelTrim = 0;
+    m_idleAir = 1.0;
+
+    setAtmosphere(units::pressure(1.0, units::atm), units::celcius(25.0));
 }
 
 void Intake::destroy() {
     /* void */
 }
 
-void Intake::process(double dt) {
-    const double ideal_afr = 0.8 * m_molecularAfr * 4;
-    const double current_afr = (m_system.mix().p_o2 + m_system.mix().p_inert) / m_system.mix().p_fuel;
-
+void Intake::setAtmosphere(double P, double T) {
+    const double ideal_afr = 0.8 * m_molecularAfr * 4 / (1 + m_fuelTrim);
     const double p_air = ideal_afr / (1 + ideal_afr);
     GasSystem::Mix fuelAirMix;
     fuelAirMix.p_fuel = 1 - p_air;
     fuelAirMix.p_inert = p_air * 0.75;
     fuelAirMix.p_o2 = p_air * 0.25;
 
-    const double idle_afr = 2.0;
+    const double idle_afr = 2.0 / (1 + m_fuelTrim);
     const double p_idle_air = idle_afr / (1 + idle_afr);
     GasSystem::Mix fuelMix;
     fuelMix.p_fuel = (1.0 - p_idle_air);
     fuelMix.p_inert = p_idle_air * 0.75;
     fuelMix.p_o2 = p_idle_air * 0.25;
 
+    m_atmosphere = GasSystem::reservoir(P, T, fuelAirMix);
+    m_idleAtmosphere = GasSystem::reservoir(P, T, fuelMix);
+}
+
+void Intake::setFuelTrim(double trim) {
+    m_fuelTrim = trim;
+    setAtmosphere(m_atmosphere.P, m_atmosphere.T);
+}
+
+void Intake::prepare(double dt) {
     const double throttle = getThrottlePlatePosition();
     const double flowAttenuation = std::cos(throttle * constants::pi / 2);
 
-    GasSystem::FlowParameters flowParams;
-    flowParams.crossSectionArea_0 = units::area(10, units::m2);
-    flowParams.crossSectionArea_1 = m_crossSectionArea;
-    flowParams.direction_x = 0.0;
-    flowParams.direction_y = -1.0;
-    flowParams.dt = dt;
-
-    m_atmosphere.reset(units::pressure(1.0, units::atm), units::celcius(25.0), fuelAirMix);
-    flowParams.system_0 = &m_atmosphere;
-    flowParams.system_1 = &m_system;
-    flowParams.k_flow = flowAttenuation * m_inputFlowK;
-    m_flow = m_system.flow(flowParams);
-
-    m_atmosphere.reset(units::pressure(1.0, units::atm), units::celcius(25.0), fuelMix);
-    flowParams.system_0 = &m_atmosphere;
-    flowParams.system_1 = &m_system;
-    flowParams.k_flow = m_idleFlowK;
-    const double idleCircuitFlow = m_system.flow(flowParams);
+    m_throttleFlow.reservoir = &m_atmosphere;
+    m_throttleFlow.crossSectionArea = m_crossSectionArea;
+    m_throttleFlow.direction_x = 0.0;
+    m_throttleFlow.direction_y = -1.0;
+    m_throttleFlow.dt = dt;
+    m_throttleFlow.k_flow = flowAttenuation * m_inputFlowK;
+
+    m_idleFlow = m_throttleFlow;
+    m_idleFlow.reservoir = &m_idleAtmosphere;
+    m_idleFlow.k_flow = m_idleFlowK * m_idleAir;
+}
+
+void Intake::process() {
+    m_flow = m_system.flow(m_throttleFlow);
+    const double idleCircuitFlow = m_system.flow(m_idleFlow);
 
     m_system.dissipateExcessVelocity();
-    m_system.updateVelocity(dt, m_velocityDecay);
+    m_system.updateVelocity(m_throttleFlow.dt, m_velocityDecay);
 
     if (m_flow > 0) {
-        m_totalFuelInjected += fuelAirMix.p_fuel * m_flow;
+        m_totalFuelInjected += m_atmosphere.mix.p_fuel * m_flow;
     }
 
     if (idleCircuitFlow > 0) {
-        m_totalFuelInjected += fuelMix.p_fuel * idleCircuitFlow;
+        m_totalFuelInjected += m_idleAtmosphere.mix.p_fuel * idleCircuitFlow;
     }
 }
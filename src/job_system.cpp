@@ -0,0 +1,318 @@
+#include "../include/job_system.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace {
+constexpr int SpinCount = 256;
+constexpr int SpinBeforeYield = 32;
+constexpr int HelpSpinCount = 1024;
+
+thread_local const JobSystem *t_system = nullptr;
+thread_local int t_worker = -1;
+
+inline int priorityIndex(JobSystem::Priority priority) {
+    return static_cast<int>(priority);
+}
+} /* namespace */
+
+JobSystem::Group::Group(JobSystem *system, Priority priority) {
+    m_system = (system != nullptr) ? system : &JobSystem::Shared();
+    m_priority = priority;
+    m_pending = 0;
+}
+
+JobSystem::Group::~Group() {
+    wait();
+}
+
+void JobSystem::Group::run(std::function<void()> job) {
+    Job queued;
+    queued.run = std::move(job);
+    queued.pending = &m_pending;
+    queued.priority = m_priority;
+
+    ++m_pending;
+    m_system->push(std::move(queued));
+    m_system->wake();
+}
+
+void JobSystem::Group::wait() {
+    m_system->help(m_pending, m_priority);
+}
+
+JobSystem::JobSystem() {
+    m_queues.push_back(new Queue);
+    m_loadingSlots = 1;
+
+    for (std::atomic<int> &queued : m_queued) queued = 0;
+    m_runningLoading = 0;
+    m_stealOffset = 0;
+    m_run = false;
+    m_sleeping = 0;
+}
+
+JobSystem::~JobSystem() {
+    destroy();
+
+    for (Queue *queue : m_queues) delete queue;
+    m_queues.clear();
+}
+
+void JobSystem::initialize(int workerCount) {
+    destroy();
+
+    workerCount = std::max(workerCount, 0);
+    for (int i = 0; i < workerCount; ++i) {
+        m_queues.insert(m_queues.end() - 1, new Queue);
+    }
+
+    // One worker is kept out of loading when there's more than one
+    m_loadingSlots = std::max(workerCount - 1, 1);
+
+    m_run = true;
+    for (int i = 0; i < workerCount; ++i) {
+        m_threads.emplace_back(&JobSystem::worker, this, i);
+    }
+}
+
+void JobSystem::destroy() {
+    if (m_threads.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_run = false;
+    }
+
+    m_wake.notify_all();
+
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+
+    m_threads.clear();
+
+    // Nothing can be left in them; waiters drain their own jobs
+    Queue *external = m_queues.back();
+    for (size_t i = 0; i + 1 < m_queues.size(); ++i) {
+        for (const std::deque<Job> &jobs : m_queues[i]->jobs) {
+            assert(jobs.empty());
+        }
+
+        delete m_queues[i];
+    }
+
+    m_queues.assign(1, external);
+    m_loadingSlots = 1;
+}
+
+void JobSystem::run(int n, Task task, void *context, Priority priority, int width) {
+    if (n <= 0) return;
+
+    const int threads = std::min(
+        (width > 0) ? std::min(width, getConcurrency()) : getConcurrency(),
+        n);
+
+    if (threads <= 1) {
+        for (int i = 0; i < n; ++i) {
+            task(context, i);
+        }
+
+        return;
+    }
+
+    std::atomic<int> next(0);
+    std::atomic<int> pending(0);
+    const std::function<void()> loop = [&next, n, task, context] {
+        for (int i = next++; i < n; i = next++) {
+            task(context, i);
+        }
+    };
+
+    for (int i = 1; i < threads; ++i) {
+        Job job;
+        job.run = loop;
+        job.pending = &pending;
+        job.priority = priority;
+
+        ++pending;
+        push(std::move(job));
+    }
+
+    wake();
+    loop();
+
+    // Helpers nobody got to yet find the range exhausted and return at once
+    help(pending, priority);
+}
+
+JobSystem &JobSystem::Shared() {
+    static JobSystem system;
+    static std::once_flag started;
+    std::call_once(started, [] {
+        const int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+        system.initialize(std::max(hardwareThreads, 1) - 1);
+    });
+
+    return system;
+}
+
+void JobSystem::worker(int index) {
+    t_system = this;
+    t_worker = index;
+
+    int idle = 0;
+    while (true) {
+        Job job;
+        if (take(Priority::Loading, &job)) {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+
+        if (!m_run) break;
+
+        if (++idle < SpinCount) {
+            if (idle > SpinBeforeYield) std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepLock);
+        ++m_sleeping;
+        m_wake.wait(lock, [this] { return !m_run || hasWork(); });
+        --m_sleeping;
+
+        idle = 0;
+    }
+
+    t_system = nullptr;
+    t_worker = -1;
+}
+
+void JobSystem::push(Job job) {
+    const int p = priorityIndex(job.priority);
+    Queue *queue = m_queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue->lock);
+        queue->jobs[p].push_back(std::move(job));
+    }
+
+    ++m_queued[p];
+}
+
+bool JobSystem::take(Priority lowest, Job *job) {
+    const int own = currentQueue();
+    const int queues = static_cast<int>(m_queues.size());
+
+    for (int p = 0; p <= priorityIndex(lowest); ++p) {
+        if (m_queued[p] == 0) continue;
+
+        // Loading jobs on a worker take a slot before they're taken, so two
+        // workers can't both claim the last one
+        const bool reserve = p == priorityIndex(Priority::Loading) && isWorker();
+        if (reserve && m_runningLoading.fetch_add(1) >= m_loadingSlots) {
+            --m_runningLoading;
+            continue;
+        }
+
+        bool taken = takeFrom(own, static_cast<Priority>(p), true, job);
+        const int offset = static_cast<int>(m_stealOffset++ % queues);
+        for (int i = 0; i < queues && !taken; ++i) {
+            const int victim = (offset + i) % queues;
+            if (victim != own) taken = takeFrom(victim, static_cast<Priority>(p), false, job);
+        }
+
+        if (taken) {
+            job->reserved = reserve;
+            return true;
+        }
+        else if (reserve) {
+            --m_runningLoading;
+        }
+    }
+
+    return false;
+}
+
+bool JobSystem::takeFrom(int queue, Priority priority, bool newest, Job *job) {
+    const int p = priorityIndex(priority);
+    Queue *q = m_queues[queue];
+
+    std::lock_guard<std::mutex> lock(q->lock);
+    std::deque<Job> &jobs = q->jobs[p];
+    if (jobs.empty()) return false;
+
+    if (newest) {
+        *job = std::move(jobs.back());
+        jobs.pop_back();
+    }
+    else {
+        *job = std::move(jobs.front());
+        jobs.pop_front();
+    }
+
+    --m_queued[p];
+    return true;
+}
+
+void JobSystem::execute(Job &job) {
+    job.run();
+
+    if (job.reserved) {
+        // Another loading job may have been waiting for the slot
+        --m_runningLoading;
+        if (m_queued[priorityIndex(Priority::Loading)] > 0) wake();
+    }
+
+    if (job.pending->fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_done.notify_all();
+    }
+}
+
+void JobSystem::wake() {
+    if (m_sleeping == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_sleepLock);
+    m_wake.notify_all();
+}
+
+void JobSystem::help(std::atomic<int> &pending, Priority lowest) {
+    int idle = 0;
+    while (pending > 0) {
+        Job job;
+        if (take(lowest, &job)) {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < HelpSpinCount) {
+            if (idle > SpinBeforeYield) std::this_thread::yield();
+            continue;
+        }
+
+        // Woken as soon as the last job completes; the timeout only picks
+        // up jobs queued meanwhile that this thread could help with
+        std::unique_lock<std::mutex> lock(m_sleepLock);
+        m_done.wait_for(lock, std::chrono::milliseconds(1), [&pending] { return pending == 0; });
+    }
+}
+
+bool JobSystem::hasWork() const {
+    if (m_queued[priorityIndex(Priority::Physics)] > 0) return true;
+    else if (m_queued[priorityIndex(Priority::Normal)] > 0) return true;
+    else if (m_queued[priorityIndex(Priority::Loading)] > 0) {
+        return m_runningLoading < m_loadingSlots;
+    }
+    else return false;
+}
+
+bool JobSystem::isWorker() const {
+    return t_system == this && t_worker >= 0;
+}
+
+int JobSystem::currentQueue() const {
+    return isWorker() ? t_worker : static_cast<int>(m_queues.size()) - 1;
+}
@@ -0,0 +1,158 @@
+#include "../include/kernel_dispatch.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+std::atomic<const KernelDispatch::Table *> s_table{ nullptr };
+std::atomic<int> s_isa{ static_cast<int>(KernelDispatch::Isa::Scalar) };
+std::mutex s_lock;
+
+const char *Names[] = { "scalar", "sse2", "avx2", "avx512", "neon" };
+static_assert(
+    sizeof(Names) / sizeof(Names[0]) == static_cast<int>(KernelDispatch::Isa::Count),
+    "isa names");
+
+KernelDispatch::CpuFeatures detect() {
+    KernelDispatch::CpuFeatures features;
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    features.sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    // The OS has to save the YMM and ZMM state across context switches
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool ymm = (xcr0 & 0x6) == 0x6;
+    const bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        features.avx2 = avx && ymm && (info[1] & (1 << 5)) != 0;
+        features.avx512f = features.avx2 && zmm && (info[1] & (1 << 16)) != 0;
+    }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    // Also checks that the OS saves the wider registers
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2");
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.avx512f = __builtin_cpu_supports("avx512f");
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    features.neon = true;
+#endif
+
+    return features;
+}
+
+// ENGINE_SIM_KERNEL_ISA, if set to an ISA the host runs
+bool environmentIsa(KernelDispatch::Isa *isa) {
+    const char *value = std::getenv("ENGINE_SIM_KERNEL_ISA");
+    return value != nullptr
+        && KernelDispatch::Parse(value, isa)
+        && KernelDispatch::IsSupported(*isa);
+}
+} /* namespace */
+
+const KernelDispatch::Table &KernelDispatch::Get() {
+    const Table *table = s_table.load(std::memory_order_acquire);
+    return (table != nullptr) ? *table : *initialize();
+}
+
+KernelDispatch::Isa KernelDispatch::GetIsa() {
+    Get();
+    return static_cast<Isa>(s_isa.load(std::memory_order_relaxed));
+}
+
+bool KernelDispatch::SetIsa(Isa isa) {
+    if (!IsSupported(isa)) return false;
+
+    std::lock_guard<std::mutex> lock(s_lock);
+    s_isa.store(static_cast<int>(isa), std::memory_order_relaxed);
+    s_table.store(table(isa), std::memory_order_release);
+
+    return true;
+}
+
+bool KernelDispatch::IsSupported(Isa isa) {
+    const CpuFeatures &features = GetCpuFeatures();
+    if (table(isa) == nullptr) return false;
+
+    switch (isa) {
+        case Isa::Scalar: return true;
+        case Isa::Sse2: return features.sse2;
+        case Isa::Avx2: return features.avx2;
+        case Isa::Avx512: return features.avx512f;
+        case Isa::Neon: return features.neon;
+        default: return false;
+    }
+}
+
+KernelDispatch::Isa KernelDispatch::Best() {
+    const Isa order[] = { Isa::Avx512, Isa::Avx2, Isa::Sse2, Isa::Neon };
+    for (Isa isa : order) {
+        if (IsSupported(isa)) return isa;
+    }
+
+    return Isa::Scalar;
+}
+
+const KernelDispatch::CpuFeatures &KernelDispatch::GetCpuFeatures() {
+    static const CpuFeatures features = detect();
+    return features;
+}
+
+const char *KernelDispatch::GetName(Isa isa) {
+    const int i = static_cast<int>(isa);
+    return (i >= 0 && i < static_cast<int>(Isa::Count)) ? Names[i] : "unknown";
+}
+
+bool KernelDispatch::Parse(const char *name, Isa *isa) {
+    for (int i = 0; i < static_cast<int>(Isa::Count); ++i) {
+        if (std::strcmp(name, Names[i]) == 0) {
+            *isa = static_cast<Isa>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const KernelDispatch::Table *KernelDispatch::table(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return scalarTable();
+        case Isa::Sse2: return baselineTable();
+        case Isa::Avx2: return avx2Table();
+        case Isa::Avx512: return avx512Table();
+        case Isa::Neon: return baselineTable();
+        default: return nullptr;
+    }
+}
+
+const KernelDispatch::Table *KernelDispatch::initialize() {
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    const Table *current = s_table.load(std::memory_order_acquire);
+    if (current != nullptr) return current;
+
+    Isa isa;
+    if (!environmentIsa(&isa)) {
+        isa = Best();
+    }
+
+    s_isa.store(static_cast<int>(isa), std::memory_order_relaxed);
+    s_table.store(table(isa), std::memory_order_release);
+
+    return table(isa);
+}
@@ -0,0 +1,15 @@
+#include "../include/kernel_dispatch.h"
+
+// Built with AVX2 flags on x86 (see CMakeLists.txt); empty elsewhere
+#if defined(__AVX2__)
+#define ATG_ENGINE_SIM_KERNEL_NAMESPACE kernels_avx2
+#include "../include/kernel_bodies.h"
+
+const KernelDispatch::Table *KernelDispatch::avx2Table() {
+    return &kernels_avx2::Table;
+}
+#else
+const KernelDispatch::Table *KernelDispatch::avx2Table() {
+    return nullptr;
+}
+#endif
@@ -0,0 +1,15 @@
+#include "../include/kernel_dispatch.h"
+
+// Built with AVX-512F flags on x86 (see CMakeLists.txt); empty elsewhere
+#if defined(__AVX512F__)
+#define ATG_ENGINE_SIM_KERNEL_NAMESPACE kernels_avx512
+#include "../include/kernel_bodies.h"
+
+const KernelDispatch::Table *KernelDispatch::avx512Table() {
+    return &kernels_avx512::Table;
+}
+#else
+const KernelDispatch::Table *KernelDispatch::avx512Table() {
+    return nullptr;
+}
+#endif
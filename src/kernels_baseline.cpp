@@ -0,0 +1,15 @@
+#include "../include/kernel_dispatch.h"
+
+// Built with the target's default flags: SSE2 on x86-64, NEON on AArch64
+#if defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON)
+#define ATG_ENGINE_SIM_KERNEL_NAMESPACE kernels_baseline
+#include "../include/kernel_bodies.h"
+
+const KernelDispatch::Table *KernelDispatch::baselineTable() {
+    return &kernels_baseline::Table;
+}
+#else
+const KernelDispatch::Table *KernelDispatch::baselineTable() {
+    return nullptr;
+}
+#endif
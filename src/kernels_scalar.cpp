@@ -0,0 +1,9 @@
+#include "../include/kernel_dispatch.h"
+
+// Built with the vectorizer off (see CMakeLists.txt)
+#define ATG_ENGINE_SIM_KERNEL_NAMESPACE kernels_scalar
+#include "../include/kernel_bodies.h"
+
+const KernelDispatch::Table *KernelDispatch::scalarTable() {
+    return &kernels_scalar::Table;
+}
@@ -4,6 +4,8 @@
 
 #include <sstream>
 #include <iomanip>
+#include <cmath>
+#include <limits>
 
 LabeledGauge::LabeledGauge() {
     m_gauge = nullptr;
@@ -11,6 +13,8 @@ LabeledGauge::LabeledGauge() {
     m_precision = 2;
     m_unit = "";
     m_spaceBeforeUnit = true;
+    m_displayedValue = std::numeric_limits<long long>::min();
+    m_displayedPrecision = -1;
 }
 
 LabeledGauge::~LabeledGauge() {
@@ -42,12 +46,23 @@ void LabeledGauge::render() {
     drawCenteredText(m_title, title.inset(10.0f), 24.0f);
 
     const double value = m_gauge->m_value;
+    const long long displayed = std::llround(value * std::pow(10.0, m_precision));
+    if (displayed != m_displayedValue
+        || m_precision != m_displayedPrecision
+        || m_unit != m_displayedUnit)
+    {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(m_precision);
+        ss << value << ((m_spaceBeforeUnit && m_unit.length() > 0) ? " " : "") << m_unit;
+
+        m_displayedValue = displayed;
+        m_displayedPrecision = m_precision;
+        m_displayedUnit = m_unit;
+        m_valueText = ss.str();
+    }
 
-    std::stringstream ss;
-    ss << std::fixed << std::setprecision(m_precision);
-    ss << value << ((m_spaceBeforeUnit && m_unit.length() > 0) ? " " : "") << m_unit;
     drawAlignedText(
-        ss.str(),
+        m_valueText,
         gaugeBounds.verticalSplit(0.0f, 2 / 8.0f), 
         gaugeBounds.height() / 8,
         Bounds::bm,
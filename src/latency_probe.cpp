@@ -0,0 +1,134 @@
+#include "../include/latency_probe.h"
+
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+
+LatencyProbe::LatencyProbe() {
+    m_enabled = false;
+    m_stage = -1;
+    m_completed = 0;
+
+    for (int i = 0; i < StageCount; ++i) {
+        m_positions[i] = 0;
+    }
+}
+
+LatencyProbe::~LatencyProbe() {
+    /* void */
+}
+
+bool LatencyProbe::begin(Clock::time_point inputTime) {
+    if (!m_enabled) return false;
+
+    // A probe whose sample was dropped or silenced never completes
+    const int stage = m_stage.load(std::memory_order_acquire);
+    if (stage >= 0) {
+        const std::chrono::duration<double> age = Clock::now() - m_times[static_cast<int>(Stage::Input)];
+        if (age.count() < Timeout) return false;
+
+        ATG_ENGINE_SIM_TRACE(
+            Audio, Event,
+            "latency_probe timeout stage=%s",
+            GetStageName(static_cast<Stage>(stage + 1)));
+    }
+
+    m_stage.store(-1, std::memory_order_relaxed);
+    mark(Stage::Input, 0, inputTime);
+
+    return true;
+}
+
+void LatencyProbe::mark(Stage stage, size_t position, Clock::time_point time) {
+    const int i = static_cast<int>(stage);
+    m_times[i] = time;
+    m_positions[i] = position;
+
+    if (stage == Stage::Played) {
+        complete();
+        m_stage.store(-1, std::memory_order_release);
+    }
+    else {
+        m_stage.store(i, std::memory_order_release);
+    }
+}
+
+void LatencyProbe::complete() {
+    const auto milliseconds = [this](int from, int to) {
+        return std::chrono::duration<double, std::milli>(m_times[to] - m_times[from]).count();
+    };
+
+    std::lock_guard<std::mutex> lock(m_historyLock);
+    const size_t slot = (size_t)(m_completed % HistoryLength);
+    for (int i = 0; i < StageCount; ++i) {
+        const double sample = (i == 0)
+            ? milliseconds(0, StageCount - 1)
+            : milliseconds(i - 1, i);
+        if (m_history[i].size() <= slot) m_history[i].push_back(sample);
+        else m_history[i][slot] = sample;
+    }
+
+    ++m_completed;
+
+    ATG_ENGINE_SIM_TRACE(
+        Audio, Event,
+        "latency_probe total_ms=%.3f applied_ms=%.3f published_ms=%.3f rendered_ms=%.3f read_ms=%.3f played_ms=%.3f",
+        milliseconds(0, StageCount - 1),
+        milliseconds(0, 1),
+        milliseconds(1, 2),
+        milliseconds(2, 3),
+        milliseconds(3, 4),
+        milliseconds(4, 5));
+}
+
+LatencyProbe::Statistics LatencyProbe::getStatistics(Stage stage) const {
+    std::vector<double> samples;
+    {
+        std::lock_guard<std::mutex> lock(m_historyLock);
+        samples = m_history[static_cast<int>(stage)];
+    }
+
+    Statistics statistics;
+    if (samples.empty()) return statistics;
+
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](double p) {
+        const size_t i = (size_t)(p * (samples.size() - 1) + 0.5);
+        return samples[std::min(i, samples.size() - 1)];
+    };
+
+    statistics.count = (int)samples.size();
+    statistics.p50 = percentile(0.5);
+    statistics.p99 = percentile(0.99);
+    statistics.max = samples.back();
+
+    return statistics;
+}
+
+int LatencyProbe::getCompletedCount() const {
+    std::lock_guard<std::mutex> lock(m_historyLock);
+    return m_completed;
+}
+
+void LatencyProbe::reset() {
+    m_stage.store(-1, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(m_historyLock);
+    for (std::vector<double> &history : m_history) {
+        history.clear();
+    }
+
+    m_completed = 0;
+}
+
+const char *LatencyProbe::GetStageName(Stage stage) {
+    switch (stage) {
+        case Stage::Input: return "input";
+        case Stage::Applied: return "applied";
+        case Stage::Published: return "published";
+        case Stage::Rendered: return "rendered";
+        case Stage::Read: return "read";
+        case Stage::Played: return "played";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,47 @@
+#include "../include/latency_profile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+LatencyProfile LatencyProfile::fromTargetLatency(double latency, int sampleRate, bool reducedMemory) {
+    const double rate = std::max(1, sampleRate);
+    const double l = std::max(0.001, latency);
+
+    // Rings hold ten target latencies so producer jitter never drops input;
+    // the live render limit keeps a bit under half the target queued.
+    LatencyProfile profile;
+    profile.targetLatency = l;
+    profile.outputLeadTime = l;
+    profile.inputBufferSize = std::max(1024, (int)std::ceil(10 * l * rate));
+    profile.audioBufferSize = profile.inputBufferSize;
+    profile.renderLimit = std::max(64, (int)std::round(0.45 * l * rate));
+
+    // Reduced, the input ring keeps two and a half targets of headroom and
+    // the output ring twice what the render limit lets the audio thread queue
+    if (reducedMemory) {
+        profile.inputBufferSize = std::max(1024, (int)std::ceil(2.5 * l * rate));
+        profile.audioBufferSize = std::max(1024, 2 * profile.renderLimit);
+    }
+
+    return profile;
+}
+
+LatencyProfile LatencyProfile::fromSettings(
+    const std::string &name,
+    double targetLatency,
+    int sampleRate,
+    bool reducedMemory)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+        [](unsigned char c) { return (char)std::tolower(c); });
+
+    double latency = BalancedLatency;
+    if (lower == "live" || lower == "low") latency = LiveLatency;
+    else if (lower == "offline" || lower == "high") latency = OfflineLatency;
+
+    if (targetLatency > 0) latency = targetLatency;
+
+    return fromTargetLatency(latency, sampleRate, reducedMemory);
+}
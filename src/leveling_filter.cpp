@@ -1,10 +1,19 @@
 #include "../include/leveling_filter.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 LevelingFilter::LevelingFilter() {
     m_peak = 30000.0;
     m_attenuation = 1.0;
+
+    m_blockSize = 0;
+    m_lookahead = 0;
+    m_channels = 1;
+    m_blockPeakDecay = 1.0f;
+    m_blockSmoothing = 0.0f;
+
     p_target = 30000.0;
     p_minLevel = 0.0;
     p_maxLevel = 1.0;
@@ -32,3 +41,117 @@ float LevelingFilter::f(float sample) {
 
     return sample * m_attenuation;
 }
+
+void LevelingFilter::fast_f(const float *input, float *output, int n) {
+    float peak = m_peak;
+    float smoothedAttenuation = m_attenuation;
+
+    for (int i = 0; i < n; ++i) {
+        const float sample = input[i];
+
+        peak = 0.999f * peak;
+        if (std::abs(sample) > peak) {
+            peak = std::abs(sample);
+        }
+
+        if (peak == 0) {
+            output[i] = 0;
+            continue;
+        }
+
+        const float raw_attenuation = p_target / peak;
+
+        float attenuation = raw_attenuation;
+        if (attenuation < p_minLevel) attenuation = p_minLevel;
+        else if (attenuation > p_maxLevel) attenuation = p_maxLevel;
+
+        smoothedAttenuation = 0.9 * smoothedAttenuation + 0.1 * attenuation;
+
+        output[i] = sample * smoothedAttenuation;
+    }
+
+    m_peak = peak;
+    m_attenuation = smoothedAttenuation;
+}
+
+void LevelingFilter::initializeBlockMode(int blockSize, int lookahead, int channels) {
+    m_delay.clear();
+    m_blockSize = 0;
+    m_lookahead = 0;
+    m_channels = 1;
+    if (blockSize <= 0) return;
+
+    m_blockSize = blockSize;
+    m_lookahead = std::max(0, lookahead);
+    m_channels = std::max(1, channels);
+
+    const size_t delaySamples = ((size_t)m_blockSize + m_lookahead) * m_channels;
+    m_delay.assign(delaySamples, 0.0f);
+
+    // The per-sample decay and smoothing of f() compounded over a block
+    m_blockPeakDecay = std::pow(0.999f, static_cast<float>(m_blockSize));
+    m_blockSmoothing = std::pow(0.9f, static_cast<float>(m_blockSize));
+}
+
+void LevelingFilter::block_f(const float *input, float *output, int n) {
+    if (m_delay.empty()) {
+        fast_f(input, output, n);
+        return;
+    }
+
+    float peak = m_peak;
+    float gain = m_attenuation;
+    const int channels = m_channels;
+    float *delay = m_delay.data();
+
+    for (int start = 0; start < n; start += m_blockSize) {
+        const int count = std::min(m_blockSize, n - start);
+        const float *in = input + (size_t)start * channels;
+        float *out = output + (size_t)start * channels;
+
+        float blockPeak = 0;
+        for (int i = 0; i < count * channels; ++i) {
+            blockPeak = std::fmax(blockPeak, std::abs(in[i]));
+        }
+
+        const bool fullBlock = (count == m_blockSize);
+        const float decay =
+            fullBlock ? m_blockPeakDecay : std::pow(0.999f, static_cast<float>(count));
+        const float smoothing =
+            fullBlock ? m_blockSmoothing : std::pow(0.9f, static_cast<float>(count));
+
+        peak = std::fmax(peak * decay, blockPeak);
+
+        float target = gain;
+        if (peak > 0) {
+            target = std::min(std::max(p_target / peak, p_minLevel), p_maxLevel);
+        }
+
+        const float nextGain = target + (gain - target) * smoothing;
+        const float step = (nextGain - gain) / count;
+
+        // Input may alias output, so it goes through the delay line first
+        const int lookahead = m_lookahead * channels;
+        std::memcpy(delay + lookahead, in, sizeof(float) * count * channels);
+        if (channels == 1) {
+            for (int i = 0; i < count; ++i) {
+                out[i] = delay[i] * (gain + step * (i + 1));
+            }
+        }
+        else {
+            for (int i = 0; i < count; ++i) {
+                const float g = gain + step * (i + 1);
+                for (int c = 0; c < channels; ++c) {
+                    out[i * channels + c] = delay[i * channels + c] * g;
+                }
+            }
+        }
+
+        std::memmove(delay, delay + (size_t)count * channels, sizeof(float) * lookahead);
+
+        gain = nextGain;
+    }
+
+    m_peak = peak;
+    m_attenuation = gain;
+}
@@ -119,11 +119,11 @@ void LoadSimulationCluster::update(float dt) {
     UiElement::update(dt);
 
     const bool starterEnabled =
-        (m_simulator != nullptr) ? m_simulator->m_starterMotor.m_enabled : false;
+        (m_simulator != nullptr) ? m_simulator->getSnapshot().starterEnabled : false;
     const bool dynoEnabled =
-        (m_simulator != nullptr) ? m_simulator->m_dyno.m_enabled : false;
+        (m_simulator != nullptr) ? m_simulator->getSnapshot().dynoEnabled : false;
     const bool dynoHold =
-        (m_simulator != nullptr) ? m_simulator->m_dyno.m_hold : false;
+        (m_simulator != nullptr) ? m_simulator->getSnapshot().dynoHold : false;
     const float systemStatuses[] = {
         isIgnitionOn() ? 1.0f : 0.01f,
         starterEnabled ? 1.0f : 0.01f,
@@ -179,15 +179,14 @@ void LoadSimulationCluster::render() {
 
     const Bounds dynoSpeedBounds = grid.get(m_bounds, 0, 1);
     const float dynoRpm = (m_simulator != nullptr)
-        ? (float)units::toRpm(std::abs(m_simulator->m_dyno.m_rotationSpeed))
+        ? (float)units::toRpm(std::abs(m_simulator->getSnapshot().dynoSpeed))
         : 0.0f;
     m_dynoSpeedGauge->m_gauge->m_value = dynoRpm;
     m_dynoSpeedGauge->m_bounds = dynoSpeedBounds;
 
-    Engine *engine = (m_simulator != nullptr) ? m_simulator->getEngine() : nullptr;
-
     constexpr float shortenAngle = (float)units::angle(1.0, units::deg);
-    const double redline = units::toRpm((engine != nullptr) ? engine->getRedline() : 0);
+    const double redline = units::toRpm(
+        (m_simulator != nullptr) ? m_simulator->getSnapshot().redline : 0);
     const double maxRpm = std::fmax(std::floor(redline / 500.0) * 500.0, 1000.0);
     m_dynoSpeedGauge->m_gauge->m_max = (int)(maxRpm);
     m_dynoSpeedGauge->m_gauge->setBandCount(1);
@@ -195,7 +194,7 @@ void LoadSimulationCluster::render() {
         { m_app->getRed(), (float)redline, (float)maxRpm, 3.0f, 6.0f, shortenAngle, -shortenAngle }, 0);
 
     const Bounds torqueBounds = grid.get(m_bounds, 1, 1);
-    const bool dynoEnabled = (m_simulator != nullptr) ? m_simulator->m_dyno.m_enabled : false;
+    const bool dynoEnabled = (m_simulator != nullptr) ? m_simulator->getSnapshot().dynoEnabled : false;
     m_torqueGauge->m_gauge->m_value = dynoEnabled
         ? (float)m_filteredTorque
         : (float)m_peakTorque;
@@ -287,8 +286,9 @@ void LoadSimulationCluster::updateHpAndTorque(float dt) {
     constexpr double RC = 0.1;
     const double alpha = dt / (dt + RC);
 
-    const double torque = m_simulator->getFilteredDynoTorque();
-    const double power = m_simulator->getDynoPower();
+    const SimulationSnapshot &snapshot = m_simulator->getSnapshot();
+    const double torque = snapshot.filteredDynoTorque;
+    const double power = snapshot.dynoPower;
     const double torqueWithUnits = (m_torqueUnits == "Nm")
         ? (units::convert(torque, units::Nm))
         : (units::convert(torque, units::ft_lb));
@@ -302,21 +302,21 @@ void LoadSimulationCluster::updateHpAndTorque(float dt) {
     if (m_simulator->getEngine() != nullptr) {
         if (m_filteredTorque > m_peakTorque) {
             m_peakTorque = m_filteredTorque;
-            m_peakTorqueRpm = m_simulator->getEngine()->getRpm();
+            m_peakTorqueRpm = snapshot.rpm;
         }
 
         if (m_filteredHorsepower > m_peakHorsepower) {
             m_peakHorsepower = std::fmax(m_peakHorsepower, m_filteredHorsepower);
-            m_peakHorsepowerRpm = m_simulator->getEngine()->getRpm();
+            m_peakHorsepowerRpm = snapshot.rpm;
         }
 
         static auto s_nextGaugeLog = std::chrono::steady_clock::now();
         const auto now = std::chrono::steady_clock::now();
         if (now >= s_nextGaugeLog) {
-            const double rpm = m_simulator->getEngine()->getRpm();
-            const double dynoRpm = units::toRpm(std::abs(m_simulator->m_dyno.m_rotationSpeed));
-            DebugTrace::Log(
-                "ui",
+            const double rpm = snapshot.rpm;
+            const double dynoRpm = units::toRpm(std::abs(snapshot.dynoSpeed));
+            ATG_ENGINE_SIM_TRACE(
+                Ui, Verbose,
                 "gauges rpm=%.2f dyno_rpm=%.2f torque=%.2f power=%.2f torque_peak=%.2f power_peak=%.2f",
                 rpm,
                 dynoRpm,
@@ -330,11 +330,8 @@ void LoadSimulationCluster::updateHpAndTorque(float dt) {
 }
 
 bool LoadSimulationCluster::isIgnitionOn() const {
-    if (m_simulator == nullptr) return false;
-
-    Engine *engine = m_simulator->getEngine();
-    return (engine != nullptr)
-        ? engine->getIgnitionModule()->m_enabled
+    return (m_simulator != nullptr)
+        ? m_simulator->getSnapshot().ignitionEnabled
         : false;
 }
 
@@ -0,0 +1,84 @@
+#include "../include/low_pass_filter_bank.h"
+
+#include "../include/constants.h"
+
+#include <algorithm>
+
+LowPassFilterBank::LowPassFilterBank() {
+    m_y = nullptr;
+    m_groupCount = 0;
+    m_channelCount = 0;
+
+    m_alpha = 0;
+}
+
+LowPassFilterBank::~LowPassFilterBank() {
+    destroy();
+}
+
+void LowPassFilterBank::initialize(int channels) {
+    destroy();
+
+    if (channels <= 0) return;
+
+    m_channelCount = channels;
+    m_groupCount = (channels + Lanes - 1) / Lanes;
+    m_y = new float[(size_t)m_groupCount * Lanes];
+    std::fill(m_y, m_y + (size_t)m_groupCount * Lanes, 0.0f);
+}
+
+void LowPassFilterBank::destroy() {
+    if (m_y != nullptr) delete[] m_y;
+
+    m_y = nullptr;
+    m_groupCount = 0;
+    m_channelCount = 0;
+}
+
+void LowPassFilterBank::setCutoffFrequency(float f, float dt) {
+    // Same rounding as LowPassFilter::setCutoffFrequency() and fast_f()
+    const float rc = 1.0f / (f * 2.0f * static_cast<float>(constants::pi));
+    m_alpha = dt / (rc + dt);
+}
+
+void LowPassFilterBank::process(const float *const *input, float *const *output, int n) {
+    if (n <= 0) return;
+
+    const float alpha = m_alpha;
+    for (int g = 0; g < m_groupCount; ++g) {
+        const int first = g * Lanes;
+        const int used = std::min(Lanes, m_channelCount - first);
+
+        float *state = m_y + (size_t)first;
+        alignas(16) float y[Lanes];
+        alignas(16) float s[Lanes] = {};
+        for (int l = 0; l < Lanes; ++l) {
+            y[l] = state[l];
+        }
+
+        for (int i = 0; i < n; ++i) {
+            for (int l = 0; l < used; ++l) {
+                s[l] = input[first + l][i];
+            }
+
+            for (int l = 0; l < Lanes; ++l) {
+                y[l] = alpha * s[l] + (1 - alpha) * y[l];
+            }
+
+            for (int l = 0; l < used; ++l) {
+                output[first + l][i] = y[l];
+            }
+        }
+
+        for (int l = 0; l < Lanes; ++l) {
+            state[l] = y[l];
+        }
+    }
+}
+
+float LowPassFilterBank::process(int channel, float sample) {
+    float &y = m_y[channel];
+    y = m_alpha * sample + (1 - m_alpha) * y;
+
+    return y;
+}
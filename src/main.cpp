@@ -1,5 +1,6 @@
 #include "../include/engine_sim_application.h"
 #include "../include/debug_trace.h"
+#include "../include/startup_timeline.h"
 
 #include <exception>
 #include <csignal>
@@ -8,7 +9,7 @@
 namespace {
 void EngineSimSignalHandler(int signalCode) {
     DebugTrace::RequestDump("signal");
-    DebugTrace::Log("main", "signal handler triggered code=%d", signalCode);
+    ATG_ENGINE_SIM_TRACE(Main, Event, "signal handler triggered code=%d", signalCode);
     DebugTrace::Shutdown();
 
     // Re-raise with default handling so macOS still generates a normal crash report.
@@ -19,11 +20,12 @@ void EngineSimSignalHandler(int signalCode) {
 }
 
 int main(int argc, char **argv) {
+    StartupTimeline::Start();
     DebugTrace::InitializeFromArguments(argc, argv);
-    DebugTrace::Log("main", "installing terminate/signal handlers");
+    ATG_ENGINE_SIM_TRACE(Main, Event, "installing terminate/signal handlers");
 
     std::set_terminate([]() {
-        DebugTrace::Log("main", "std::terminate triggered");
+        ATG_ENGINE_SIM_TRACE(Main, Event, "std::terminate triggered");
         std::abort();
     });
 
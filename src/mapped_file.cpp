@@ -0,0 +1,73 @@
+#include "../include/mapped_file.h"
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+    m_data = nullptr;
+    m_size = 0;
+#if !defined(_WIN32)
+    m_mapped = nullptr;
+#endif /* !_WIN32 */
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string &path) {
+    close();
+
+#if defined(_WIN32)
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+
+    m_buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(m_buffer.data(), m_buffer.size());
+    if (!file || m_buffer.empty()) {
+        m_buffer.clear();
+        return false;
+    }
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    m_mapped = mapped;
+    m_data = static_cast<const char *>(mapped);
+    m_size = static_cast<size_t>(info.st_size);
+    return true;
+#endif /* _WIN32 */
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    m_buffer.clear();
+#else
+    if (m_mapped != nullptr) munmap(m_mapped, m_size);
+    m_mapped = nullptr;
+#endif /* _WIN32 */
+
+    m_data = nullptr;
+    m_size = 0;
+}
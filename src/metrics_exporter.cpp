@@ -0,0 +1,450 @@
+#include "../include/metrics_exporter.h"
+
+#include "../include/allocation_tracker.h"
+#include "../include/debug_trace.h"
+#include "../include/event_counters.h"
+#include "../include/simulator.h"
+#include "../include/step_profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#if defined(_WIN32)
+typedef SOCKET NativeSocket;
+typedef int SocketLength;
+
+bool startSockets() {
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+}
+
+void stopSockets() {
+    WSACleanup();
+}
+
+void closeSocket(intptr_t s) {
+    closesocket(static_cast<SOCKET>(s));
+}
+#else
+typedef int NativeSocket;
+typedef socklen_t SocketLength;
+
+bool startSockets() {
+    return true;
+}
+
+void stopSockets() {
+    /* void */
+}
+
+void closeSocket(intptr_t s) {
+    ::close(static_cast<int>(s));
+}
+#endif /* _WIN32 */
+
+NativeSocket native(intptr_t s) {
+    return static_cast<NativeSocket>(s);
+}
+
+// A scraper hanging up mid-response must not raise SIGPIPE
+#if defined(MSG_NOSIGNAL)
+constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+constexpr int SendFlags = 0;
+#endif /* MSG_NOSIGNAL */
+
+struct MetricInfo {
+    const char *name;
+    const char *type;
+    const char *help;
+};
+
+const MetricInfo Metrics[] = {
+    { "engine_sim_steps_total", "counter", "Simulation steps run" },
+    { "engine_sim_simulated_seconds_total", "counter", "Simulated time" },
+    { "engine_sim_wall_seconds_total", "counter", "Wall time spent running" },
+    { "engine_sim_rpm", "gauge", "Engine speed" },
+    { "engine_sim_audio_blocks_total", "counter", "Audio blocks rendered" },
+    { "engine_sim_audio_render_seconds_total", "counter", "Audio thread time spent rendering" },
+    { "engine_sim_audio_underruns_total", "counter", "Audio cycles that found the input ring empty" },
+    { "engine_sim_audio_overruns_total", "counter", "Audio cycles that found the input ring over three quarters full" },
+    { "engine_sim_audio_lock_contentions_total", "counter", "Synthesizer input lock acquisitions that waited" },
+    { "engine_sim_audio_input_dropped_samples_total", "counter", "Input samples dropped on a full ring" },
+    { "engine_sim_audio_input_queue_samples", "gauge", "Samples waiting in the synthesizer input ring" },
+    { "engine_sim_audio_output_queue_samples", "gauge", "Samples waiting in the synthesizer output ring" }
+};
+
+static_assert(
+    sizeof(Metrics) / sizeof(Metrics[0]) == MetricsExporter::MetricCount,
+    "every metric needs a name");
+
+void header(std::string *out, const char *name, const char *type, const char *help) {
+    *out += "# HELP ";
+    *out += name;
+    *out += ' ';
+    *out += help;
+    *out += "\n# TYPE ";
+    *out += name;
+    *out += ' ';
+    *out += type;
+    *out += '\n';
+}
+
+void sample(std::string *out, const char *name, const char *labels, double value) {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "%s{%s} %.17g\n", name, labels, value);
+    *out += buffer;
+}
+
+// Label values escape backslashes, quotes and newlines
+std::string escape(const std::string &value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') escaped += '\\';
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+void renderStages(std::string *out) {
+    if (!StepProfiler::IsEnabled()) return;
+
+    const char *name = "engine_sim_stage_duration_seconds";
+    header(out, name, "histogram", "Time spent per call in each profiled stage");
+
+    char labels[128];
+    for (int i = 0; i < StepProfiler::StageCount; ++i) {
+        const StepProfiler::Stage stage = static_cast<StepProfiler::Stage>(i);
+
+        StepProfiler::Statistics statistics;
+        StepProfiler::GetStatistics(stage, &statistics);
+        if (statistics.count == 0) continue;
+
+        // Cumulative up to the highest bucket in use; +Inf holds the rest
+        int highest = 0;
+        for (int j = 0; j < StepProfiler::BucketCount; ++j) {
+            if (statistics.buckets[j] > 0) highest = j;
+        }
+
+        uint64_t cumulative = 0;
+        for (int j = 0; j <= highest; ++j) {
+            cumulative += statistics.buckets[j];
+            std::snprintf(
+                labels, sizeof(labels),
+                "stage=\"%s\",le=\"%.9g\"",
+                StepProfiler::GetStageName(stage),
+                static_cast<double>(1ull << j) * 1E-9);
+            sample(out, "engine_sim_stage_duration_seconds_bucket", labels, static_cast<double>(cumulative));
+        }
+
+        std::snprintf(labels, sizeof(labels), "stage=\"%s\",le=\"+Inf\"", StepProfiler::GetStageName(stage));
+        sample(out, "engine_sim_stage_duration_seconds_bucket", labels, static_cast<double>(statistics.count));
+
+        std::snprintf(labels, sizeof(labels), "stage=\"%s\"", StepProfiler::GetStageName(stage));
+        sample(out, "engine_sim_stage_duration_seconds_sum", labels, statistics.totalMicroseconds * 1E-6);
+        sample(out, "engine_sim_stage_duration_seconds_count", labels, static_cast<double>(statistics.count));
+    }
+}
+
+void renderEvents(std::string *out) {
+    if (!EventCounters::IsEnabled()) return;
+
+    EventCounters::Totals totals;
+    EventCounters::GetTotals(&totals);
+
+    header(out, "engine_sim_events_total", "counter", "Hot-path events counted across the process");
+
+    char labels[64];
+    for (int i = 0; i < EventCounters::CounterCount; ++i) {
+        const EventCounters::Counter counter = static_cast<EventCounters::Counter>(i);
+        std::snprintf(labels, sizeof(labels), "event=\"%s\"", EventCounters::GetName(counter));
+        sample(out, "engine_sim_events_total", labels, static_cast<double>(totals.get(counter)));
+    }
+}
+
+void renderAllocations(std::string *out) {
+    if (!AllocationTracker::IsEnabled()) return;
+
+    AllocationTracker::TagStatistics statistics[AllocationTracker::TagCount];
+    for (int i = 0; i < AllocationTracker::TagCount; ++i) {
+        AllocationTracker::GetTagStatistics(static_cast<AllocationTracker::Tag>(i), &statistics[i]);
+    }
+
+    const struct {
+        const char *name;
+        const char *type;
+        const char *help;
+        uint64_t AllocationTracker::TagStatistics::*field;
+    } fields[] = {
+        { "engine_sim_allocations_total", "counter", "Heap allocations made", &AllocationTracker::TagStatistics::totalAllocations },
+        { "engine_sim_allocated_bytes_total", "counter", "Heap bytes allocated", &AllocationTracker::TagStatistics::totalBytes },
+        { "engine_sim_live_bytes", "gauge", "Heap bytes allocated and not yet freed", &AllocationTracker::TagStatistics::liveBytes }
+    };
+
+    char labels[64];
+    for (const auto &field : fields) {
+        header(out, field.name, field.type, field.help);
+        for (int i = 0; i < AllocationTracker::TagCount; ++i) {
+            std::snprintf(
+                labels, sizeof(labels),
+                "tag=\"%s\"",
+                AllocationTracker::GetTagName(static_cast<AllocationTracker::Tag>(i)));
+            sample(out, field.name, labels, static_cast<double>(statistics[i].*field.field));
+        }
+    }
+}
+} /* namespace */
+
+MetricsExporter::MetricsExporter() {
+    m_socket = ClosedSocket;
+    m_port = 0;
+    m_thread = nullptr;
+    m_run = false;
+    m_scrapes = 0;
+
+    for (InstanceSlot &slot : m_instances) {
+        for (std::atomic<double> &value : slot.values) value = 0.0;
+    }
+}
+
+MetricsExporter::~MetricsExporter() {
+    destroy();
+}
+
+bool MetricsExporter::initialize(const Parameters &params) {
+    destroy();
+
+    if (!startSockets()) return false;
+
+    const NativeSocket s = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+    if (static_cast<intptr_t>(s) == ClosedSocket) {
+        stopSockets();
+        return false;
+    }
+
+    int on = 1, off = 0;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on), sizeof(on));
+    setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char *>(&off), sizeof(off));
+
+    sockaddr_in6 address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(static_cast<uint16_t>(params.port));
+
+    SocketLength length = sizeof(address);
+    const bool ok =
+        bind(s, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0
+        && listen(s, 16) == 0
+        && getsockname(s, reinterpret_cast<sockaddr *>(&address), &length) == 0;
+    if (!ok) {
+        closeSocket(static_cast<intptr_t>(s));
+        stopSockets();
+        return false;
+    }
+
+    m_socket = static_cast<intptr_t>(s);
+    m_port = ntohs(address.sin6_port);
+    m_scrapes = 0;
+
+    m_run = true;
+    m_thread = new std::thread(&MetricsExporter::serve, this);
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "metrics_exporter open port=%d",
+        m_port);
+
+    return true;
+}
+
+void MetricsExporter::destroy() {
+    if (m_thread != nullptr) {
+        m_run = false;
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_socket != ClosedSocket) {
+        closeSocket(m_socket);
+        stopSockets();
+        m_socket = ClosedSocket;
+    }
+
+    m_port = 0;
+}
+
+void MetricsExporter::Collect(Simulator *simulator, InstanceMetrics *metrics) {
+    Synthesizer &synthesizer = simulator->synthesizer();
+    const Synthesizer::RenderStatistics render = synthesizer.getRenderStatistics();
+
+    metrics->set(Metric::Rpm, (simulator->getEngine() != nullptr) ? simulator->getEngine()->getRpm() : 0.0);
+    metrics->set(Metric::AudioBlocks, static_cast<double>(render.blocks));
+    metrics->set(Metric::AudioRenderSeconds, render.microseconds * 1E-6);
+    metrics->set(Metric::AudioUnderruns, static_cast<double>(render.underruns));
+    metrics->set(Metric::AudioOverruns, static_cast<double>(render.overruns));
+    metrics->set(Metric::LockContentions, static_cast<double>(render.lockContentions));
+    metrics->set(Metric::InputDroppedSamples, static_cast<double>(render.inputDroppedSamples));
+    metrics->set(Metric::InputQueueSamples, synthesizer.inputSamplesAvailable());
+    metrics->set(Metric::OutputQueueSamples, synthesizer.audioSamplesAvailable());
+}
+
+void MetricsExporter::setInstanceLabel(int instance, const std::string &label) {
+    if (instance < 0 || instance >= MaxInstances) return;
+
+    std::lock_guard<std::mutex> lock(m_labelLock);
+    m_labels[instance] = label;
+}
+
+void MetricsExporter::publish(int instance, const InstanceMetrics &metrics) {
+    if (instance < 0 || instance >= MaxInstances) return;
+
+    InstanceSlot &slot = m_instances[instance];
+    for (int i = 0; i < MetricCount; ++i) {
+        slot.values[i].store(metrics.values[i], std::memory_order_relaxed);
+    }
+
+    slot.active.store(true, std::memory_order_release);
+}
+
+void MetricsExporter::removeInstance(int instance) {
+    if (instance < 0 || instance >= MaxInstances) return;
+    m_instances[instance].active.store(false, std::memory_order_release);
+}
+
+std::string MetricsExporter::render() const {
+    std::string out;
+    out.reserve(16 * 1024);
+
+    std::string labels[MaxInstances];
+    {
+        std::lock_guard<std::mutex> lock(m_labelLock);
+        for (int i = 0; i < MaxInstances; ++i) labels[i] = escape(m_labels[i]);
+    }
+
+    char instanceLabels[256];
+    for (int j = 0; j < MetricCount; ++j) {
+        header(&out, Metrics[j].name, Metrics[j].type, Metrics[j].help);
+        for (int i = 0; i < MaxInstances; ++i) {
+            const InstanceSlot &slot = m_instances[i];
+            if (!slot.active.load(std::memory_order_acquire)) continue;
+
+            std::snprintf(
+                instanceLabels, sizeof(instanceLabels),
+                "instance=\"%d\",engine=\"%s\"",
+                i,
+                labels[i].c_str());
+            sample(&out, Metrics[j].name, instanceLabels, slot.values[j].load(std::memory_order_relaxed));
+        }
+    }
+
+    renderStages(&out);
+    renderEvents(&out);
+    renderAllocations(&out);
+
+    return out;
+}
+
+void MetricsExporter::serve() {
+    while (m_run) {
+        // Wakes up to check m_run even when nobody scrapes
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(native(m_socket), &readable);
+        timeval timeout = { 0, 200 * 1000 };
+        if (select(static_cast<int>(m_socket + 1), &readable, nullptr, nullptr, &timeout) <= 0) continue;
+
+        const NativeSocket client = accept(native(m_socket), nullptr, nullptr);
+        if (static_cast<intptr_t>(client) == ClosedSocket) continue;
+
+        respond(static_cast<intptr_t>(client));
+        closeSocket(static_cast<intptr_t>(client));
+    }
+}
+
+void MetricsExporter::respond(intptr_t client) {
+#if defined(_WIN32)
+    const DWORD receiveTimeout = 2000;
+#else
+    const timeval receiveTimeout = { 2, 0 };
+#endif /* _WIN32 */
+    setsockopt(
+        native(client), SOL_SOCKET, SO_RCVTIMEO,
+        reinterpret_cast<const char *>(&receiveTimeout), sizeof(receiveTimeout));
+
+#if defined(SO_NOSIGPIPE)
+    int on = 1;
+    setsockopt(native(client), SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif /* SO_NOSIGPIPE */
+
+    // Only the request line matters; the rest of the headers are ignored
+    char request[2048];
+    int received = 0;
+    while (received < static_cast<int>(sizeof(request)) - 1) {
+        const int n = static_cast<int>(recv(native(client), request + received, sizeof(request) - 1 - received, 0));
+        if (n <= 0) break;
+
+        received += n;
+        request[received] = '\0';
+        if (std::strstr(request, "\r\n") != nullptr) break;
+    }
+
+    request[received] = '\0';
+
+    const bool metrics =
+        std::strncmp(request, "GET /metrics ", 13) == 0
+        || std::strncmp(request, "GET / ", 6) == 0;
+
+    std::string body, status, contentType;
+    if (metrics) {
+        body = render();
+        status = "200 OK";
+        contentType = "text/plain; version=0.0.4; charset=utf-8";
+        m_scrapes.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        body = "not found\n";
+        status = "404 Not Found";
+        contentType = "text/plain; charset=utf-8";
+    }
+
+    std::string response =
+        "HTTP/1.1 " + status + "\r\n"
+        + "Content-Type: " + contentType + "\r\n"
+        + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        + "Connection: close\r\n\r\n"
+        + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        const int n = static_cast<int>(send(
+            native(client),
+            response.data() + sent,
+            static_cast<int>(response.size() - sent),
+            SendFlags));
+        if (n <= 0) break;
+
+        sent += n;
+    }
+}
@@ -0,0 +1,171 @@
+#include "../include/min_max_pyramid.h"
+
+#include <algorithm>
+
+namespace {
+MinMaxPyramid::Block combine(const MinMaxPyramid::Block &a, const MinMaxPyramid::Block &b) {
+    // Ties keep the earlier low and the later high, so a flat block still
+    // has two distinct points
+    MinMaxPyramid::Block block;
+    if (a.lo.y <= b.lo.y) {
+        block.lo = a.lo;
+        block.loIndex = a.loIndex;
+    }
+    else {
+        block.lo = b.lo;
+        block.loIndex = b.loIndex;
+    }
+
+    if (b.hi.y >= a.hi.y) {
+        block.hi = b.hi;
+        block.hiIndex = b.hiIndex;
+    }
+    else {
+        block.hi = a.hi;
+        block.hiIndex = a.hiIndex;
+    }
+
+    return block;
+}
+
+MinMaxPyramid::Block leaf(const MinMaxPyramid::Point *samples, int index) {
+    return { samples[index], samples[index], index, index };
+}
+} /* namespace */
+
+MinMaxPyramid::MinMaxPyramid() {
+    m_size = 0;
+}
+
+MinMaxPyramid::~MinMaxPyramid() {
+    /* void */
+}
+
+void MinMaxPyramid::initialize(int size) {
+    m_size = std::max(0, size);
+    m_levels.clear();
+
+    for (int level = 1; m_size > 1 && (1 << (level - 1)) < m_size; ++level) {
+        const int blockSize = 1 << level;
+        m_levels.emplace_back((m_size + blockSize - 1) / blockSize, Block{ { 0, 0 }, { 0, 0 }, 0, 0 });
+    }
+}
+
+void MinMaxPyramid::destroy() {
+    m_levels.clear();
+    m_size = 0;
+}
+
+void MinMaxPyramid::update(const Point *samples, int first, int count) {
+    if (m_size <= 0 || count <= 0) return;
+
+    if (count >= m_size) {
+        updateRange(samples, 0, m_size);
+        return;
+    }
+
+    first %= m_size;
+    const int end = first + count;
+    updateRange(samples, first, std::min(end, m_size));
+    if (end > m_size) {
+        updateRange(samples, 0, end - m_size);
+    }
+}
+
+void MinMaxPyramid::updateRange(const Point *samples, int begin, int end) {
+    for (int level = 1; level <= (int)m_levels.size(); ++level) {
+        std::vector<Block> &blocks = m_levels[level - 1];
+        const int firstBlock = begin >> level;
+        const int lastBlock = (end - 1) >> level;
+
+        for (int j = firstBlock; j <= lastBlock; ++j) {
+            const int a = 2 * j, b = 2 * j + 1;
+            if (level == 1) {
+                blocks[j] = (b < m_size)
+                    ? combine(leaf(samples, a), leaf(samples, b))
+                    : leaf(samples, a);
+            }
+            else {
+                const std::vector<Block> &children = m_levels[level - 2];
+                blocks[j] = (b < (int)children.size())
+                    ? combine(children[a], children[b])
+                    : children[a];
+            }
+        }
+    }
+}
+
+int MinMaxPyramid::decimate(
+    const Point *samples,
+    int start,
+    int count,
+    int maxPoints,
+    Point *out) const
+{
+    if (m_size <= 0 || count <= 0) return 0;
+
+    count = std::min(count, m_size);
+    start %= m_size;
+    maxPoints = std::max(maxPoints, 2);
+
+    // Two points per block
+    int level = 0;
+    while (level < (int)m_levels.size() && 2 * (long long)count > (long long)maxPoints << level) {
+        ++level;
+    }
+
+    const int end = start + count;
+    int written = decimateRange(samples, start, std::min(end, m_size), level, out);
+    if (end > m_size) {
+        written += decimateRange(samples, 0, end - m_size, level, out + written);
+    }
+
+    return written;
+}
+
+int MinMaxPyramid::decimateRange(
+    const Point *samples,
+    int begin,
+    int end,
+    int level,
+    Point *out) const
+{
+    // Only blocks wholly inside the range are summarized; the ragged ends
+    // are copied as they are, which is never more points than they hold
+    const int blockSize = 1 << level;
+    const int firstBlock = (begin + blockSize - 1) / blockSize;
+    const int lastBlock = end / blockSize;
+    const int headEnd = std::min(end, firstBlock * blockSize);
+
+    int written = 0;
+    for (int i = begin; i < headEnd; ++i) {
+        out[written++] = samples[i];
+    }
+
+    if (level == 0 || firstBlock >= lastBlock) {
+        for (int i = headEnd; i < end; ++i) {
+            out[written++] = samples[i];
+        }
+
+        return written;
+    }
+
+    const std::vector<Block> &blocks = m_levels[level - 1];
+    for (int j = firstBlock; j < lastBlock; ++j) {
+        const Block &block = blocks[j];
+        if (block.loIndex < block.hiIndex) {
+            out[written++] = block.lo;
+            out[written++] = block.hi;
+        }
+        else {
+            out[written++] = block.hi;
+            out[written++] = block.lo;
+        }
+    }
+
+    for (int i = lastBlock * blockSize; i < end; ++i) {
+        out[written++] = samples[i];
+    }
+
+    return written;
+}
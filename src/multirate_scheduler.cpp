@@ -0,0 +1,117 @@
+#include "../include/multirate_scheduler.h"
+
+#include "../include/engine.h"
+
+#include <algorithm>
+
+MultirateScheduler::MultirateScheduler() {
+    m_engine = nullptr;
+    m_interval = 1;
+    m_phase = 0;
+}
+
+MultirateScheduler::~MultirateScheduler() {
+    /* void */
+}
+
+void MultirateScheduler::initialize(Engine *engine, atg_scs::RigidBody *vehicleMass, int interval) {
+    destroy();
+
+    m_engine = engine;
+    m_interval = std::max(1, interval);
+    if (m_engine == nullptr) return;
+
+    for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
+        m_bodies.push_back(&m_engine->getCrankshaft(i)->m_body);
+    }
+
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_bodies.push_back(&m_engine->getPiston(i)->m_body);
+        m_bodies.push_back(&m_engine->getConnectingRod(i)->m_body);
+    }
+
+    if (vehicleMass != nullptr) m_bodies.push_back(vehicleMass);
+
+    m_start.resize(m_bodies.size());
+    m_end.resize(m_bodies.size());
+
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_engine->getChamber(i)->releaseForcePressure();
+    }
+}
+
+void MultirateScheduler::destroy() {
+    m_bodies.clear();
+    m_start.clear();
+    m_end.clear();
+
+    m_engine = nullptr;
+    m_phase = 0;
+}
+
+void MultirateScheduler::beginSolve() {
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_engine->getChamber(i)->latchForcePressure();
+    }
+
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        m_start[i] = capture(*m_bodies[i]);
+    }
+}
+
+void MultirateScheduler::endSolve() {
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        m_end[i] = capture(*m_bodies[i]);
+    }
+}
+
+void MultirateScheduler::interpolate() {
+    m_phase = (m_phase + 1) % m_interval;
+
+    // Exactly the solved state on the last step
+    if (m_phase == 0) {
+        for (size_t i = 0; i < m_bodies.size(); ++i) {
+            atg_scs::RigidBody *body = m_bodies[i];
+            const State &end = m_end[i];
+            body->p_x = end.p_x;
+            body->p_y = end.p_y;
+            body->theta = end.theta;
+            body->v_x = end.v_x;
+            body->v_y = end.v_y;
+            body->v_theta = end.v_theta;
+        }
+
+        return;
+    }
+
+    const double s = static_cast<double>(m_phase) / m_interval;
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        atg_scs::RigidBody *body = m_bodies[i];
+        const State &start = m_start[i];
+        const State &end = m_end[i];
+        body->p_x = start.p_x + s * (end.p_x - start.p_x);
+        body->p_y = start.p_y + s * (end.p_y - start.p_y);
+        body->theta = start.theta + s * (end.theta - start.theta);
+        body->v_x = start.v_x + s * (end.v_x - start.v_x);
+        body->v_y = start.v_y + s * (end.v_y - start.v_y);
+        body->v_theta = start.v_theta + s * (end.v_theta - start.v_theta);
+    }
+}
+
+void MultirateScheduler::samplePressures() {
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_engine->getChamber(i)->sampleForcePressure();
+    }
+}
+
+MultirateScheduler::State MultirateScheduler::capture(const atg_scs::RigidBody &body) {
+    State state;
+    state.p_x = body.p_x;
+    state.p_y = body.p_y;
+    state.theta = body.theta;
+    state.v_x = body.v_x;
+    state.v_y = body.v_y;
+    state.v_theta = body.v_theta;
+
+    return state;
+}
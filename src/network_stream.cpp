@@ -0,0 +1,342 @@
+#include "../include/network_stream.h"
+
+#include "../include/debug_trace.h"
+#include "../include/simulation_snapshot.h"
+#include "../include/synthesizer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#if defined(_WIN32)
+typedef SOCKET NativeSocket;
+typedef int SocketLength;
+const intptr_t ClosedSocket = static_cast<intptr_t>(INVALID_SOCKET);
+
+bool wouldBlock() {
+    const int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAECONNRESET;
+}
+
+void closeSocket(NativeSocket s) {
+    closesocket(s);
+    WSACleanup();
+}
+#else
+typedef int NativeSocket;
+typedef socklen_t SocketLength;
+const intptr_t ClosedSocket = -1;
+
+bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED;
+}
+
+void closeSocket(NativeSocket s) {
+    ::close(s);
+}
+#endif /* _WIN32 */
+
+NativeSocket native(intptr_t s) {
+    return static_cast<NativeSocket>(s);
+}
+
+bool validHeader(const NetworkStream::PacketHeader &header) {
+    return header.magic == NetworkStream::Magic && header.version == NetworkStream::Version;
+}
+} /* namespace */
+
+NetworkStream::NetworkStream() {
+    m_socket = ClosedSocket;
+    m_port = 0;
+    m_audioSequence = 0;
+    m_telemetrySequence = 0;
+    m_position = 0;
+    std::memset(&m_audioPacket, 0, sizeof(m_audioPacket));
+}
+
+NetworkStream::~NetworkStream() {
+    destroy();
+}
+
+bool NetworkStream::initialize(const Parameters &params) {
+    destroy();
+
+    m_parameters = params;
+    m_parameters.frameSamples = std::clamp(params.frameSamples, 1, MaxFrameSamples);
+    m_parameters.maxListeners = std::max(params.maxListeners, 1);
+
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) return false;
+#endif /* _WIN32 */
+
+    const NativeSocket s = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    if (static_cast<intptr_t>(s) == ClosedSocket) {
+#if defined(_WIN32)
+        WSACleanup();
+#endif /* _WIN32 */
+        return false;
+    }
+
+    // Dual-stack, so IPv4 listeners arrive as mapped addresses
+    int off = 0;
+    setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char *>(&off), sizeof(off));
+
+    // Room for a few frames per listener before sends start dropping
+    int sendBuffer = 1 << 20;
+    setsockopt(s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char *>(&sendBuffer), sizeof(sendBuffer));
+
+    sockaddr_in6 address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(static_cast<uint16_t>(params.port));
+
+    bool ok = bind(s, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    ok = ok && ioctlsocket(s, FIONBIO, &nonBlocking) == 0;
+#else
+    ok = ok && fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif /* _WIN32 */
+
+    SocketLength length = sizeof(address);
+    ok = ok && getsockname(s, reinterpret_cast<sockaddr *>(&address), &length) == 0;
+
+    if (!ok) {
+        closeSocket(s);
+        return false;
+    }
+
+    m_socket = static_cast<intptr_t>(s);
+    m_port = ntohs(address.sin6_port);
+    m_audioSequence = 0;
+    m_telemetrySequence = 0;
+    m_position = 0;
+    m_statistics = Statistics();
+    m_listeners.clear();
+    m_listeners.reserve(m_parameters.maxListeners);
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "network_stream open port=%d frame_samples=%d max_listeners=%d",
+        m_port,
+        m_parameters.frameSamples,
+        m_parameters.maxListeners);
+
+    return true;
+}
+
+void NetworkStream::destroy() {
+    if (m_socket == ClosedSocket) return;
+
+    PacketHeader goodbye;
+    fillHeader(&goodbye, PacketType::Goodbye, 0);
+    broadcast(&goodbye, sizeof(goodbye));
+
+    closeSocket(native(m_socket));
+    m_socket = ClosedSocket;
+    m_port = 0;
+    m_listeners.clear();
+}
+
+bool NetworkStream::isOpen() const {
+    return m_socket != ClosedSocket;
+}
+
+bool NetworkStream::poll(Controls *controls) {
+    if (!isOpen()) return false;
+
+    bool updated = false;
+    ControlPacket packet;
+    for (;;) {
+        Address from;
+        SocketLength length = sizeof(from.storage);
+        const int received = static_cast<int>(recvfrom(
+            native(m_socket),
+            reinterpret_cast<char *>(&packet),
+            sizeof(packet),
+            0,
+            reinterpret_cast<sockaddr *>(from.storage),
+            &length));
+        if (received < 0) {
+            if (!wouldBlock()) ++m_statistics.rejectedPackets;
+            break;
+        }
+
+        from.length = static_cast<uint32_t>(length);
+        if (received < static_cast<int>(sizeof(PacketHeader)) || !validHeader(packet.header)) {
+            ++m_statistics.rejectedPackets;
+            continue;
+        }
+
+        const PacketType type = static_cast<PacketType>(packet.header.type);
+        if (type == PacketType::Hello) {
+            touchListener(from);
+        }
+        else if (type == PacketType::Goodbye) {
+            removeListener(from);
+        }
+        else if (type == PacketType::Control && received >= static_cast<int>(sizeof(ControlPacket))) {
+            touchListener(from);
+            ++m_statistics.controlPackets;
+
+            if (controls != nullptr) {
+                controls->throttle = std::clamp(static_cast<double>(packet.throttle), 0.0, 1.0);
+                controls->clutch = std::clamp(static_cast<double>(packet.clutch), 0.0, 1.0);
+                controls->dynoSpeed = packet.dynoSpeed;
+                controls->gear = packet.gear;
+                controls->ignition = (packet.flags & IgnitionEnabled) != 0;
+                controls->starter = (packet.flags & StarterEnabled) != 0;
+                controls->dyno = (packet.flags & DynoEnabled) != 0;
+            }
+
+            updated = true;
+        }
+        else {
+            ++m_statistics.rejectedPackets;
+        }
+    }
+
+    expireListeners();
+    return updated;
+}
+
+int NetworkStream::sendAudio(Synthesizer &synthesizer) {
+    if (!isOpen()) return 0;
+
+    const int frame = m_parameters.frameSamples;
+    int consumed = 0;
+    while (synthesizer.audioSamplesAvailable() >= frame) {
+        const int samples = synthesizer.readAudioOutput(frame, m_audioPacket.samples);
+        if (samples <= 0) break;
+
+        fillHeader(&m_audioPacket.header, PacketType::Audio, m_audioSequence++);
+        m_audioPacket.sampleRate = static_cast<uint32_t>(synthesizer.getAudioSampleRate());
+        m_audioPacket.channels = 1;
+        m_audioPacket.sampleCount = static_cast<uint16_t>(samples);
+        m_audioPacket.position = m_position;
+
+        // Nothing to send to, but the ring is still drained so listeners
+        // joining later start from the present
+        if (!m_listeners.empty()) {
+            broadcast(
+                &m_audioPacket,
+                static_cast<int>(offsetof(AudioPacket, samples) + samples * sizeof(int16_t)));
+            ++m_statistics.audioPackets;
+        }
+
+        m_position += samples;
+        consumed += samples;
+    }
+
+    return consumed;
+}
+
+void NetworkStream::sendTelemetry(const SimulationSnapshot &snapshot) {
+    if (!isOpen() || m_listeners.empty()) return;
+
+    TelemetryPacket packet;
+    fillHeader(&packet.header, PacketType::Telemetry, m_telemetrySequence++);
+    packet.time = snapshot.time;
+    packet.rpm = static_cast<float>(snapshot.rpm);
+    packet.redline = static_cast<float>(snapshot.redline);
+    packet.manifoldPressure = static_cast<float>(snapshot.manifoldPressure);
+    packet.intakeAfr = static_cast<float>(snapshot.intakeAfr);
+    packet.dynoTorque = static_cast<float>(snapshot.filteredDynoTorque);
+    packet.dynoPower = static_cast<float>(snapshot.dynoPower);
+    packet.vehicleSpeed = static_cast<float>(snapshot.speed);
+    packet.gear = snapshot.gear;
+    packet.flags =
+        (snapshot.ignitionEnabled ? IgnitionEnabled : 0u)
+        | (snapshot.starterEnabled ? StarterEnabled : 0u)
+        | (snapshot.dynoEnabled ? DynoEnabled : 0u);
+    packet.listeners = static_cast<uint32_t>(m_listeners.size());
+
+    broadcast(&packet, sizeof(packet));
+    ++m_statistics.telemetryPackets;
+}
+
+void NetworkStream::touchListener(const Address &address) {
+    const Clock::time_point now = Clock::now();
+    for (Listener &listener : m_listeners) {
+        if (listener.address.length == address.length
+            && std::memcmp(listener.address.storage, address.storage, address.length) == 0)
+        {
+            listener.lastSeen = now;
+            return;
+        }
+    }
+
+    if (static_cast<int>(m_listeners.size()) >= m_parameters.maxListeners) {
+        ++m_statistics.rejectedPackets;
+        return;
+    }
+
+    m_listeners.push_back({ address, now });
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "network_stream listener_joined listeners=%d",
+        static_cast<int>(m_listeners.size()));
+}
+
+void NetworkStream::removeListener(const Address &address) {
+    m_listeners.erase(
+        std::remove_if(
+            m_listeners.begin(),
+            m_listeners.end(),
+            [&address](const Listener &listener) {
+                return listener.address.length == address.length
+                    && std::memcmp(listener.address.storage, address.storage, address.length) == 0;
+            }),
+        m_listeners.end());
+}
+
+void NetworkStream::expireListeners() {
+    const Clock::time_point cutoff = Clock::now()
+        - std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(m_parameters.listenerTimeout));
+    m_listeners.erase(
+        std::remove_if(
+            m_listeners.begin(),
+            m_listeners.end(),
+            [cutoff](const Listener &listener) { return listener.lastSeen < cutoff; }),
+        m_listeners.end());
+}
+
+void NetworkStream::broadcast(const void *data, int size) {
+    for (const Listener &listener : m_listeners) {
+        const int sent = static_cast<int>(sendto(
+            native(m_socket),
+            static_cast<const char *>(data),
+            size,
+            0,
+            reinterpret_cast<const sockaddr *>(listener.address.storage),
+            static_cast<SocketLength>(listener.address.length)));
+        if (sent != size) ++m_statistics.droppedPackets;
+    }
+}
+
+void NetworkStream::fillHeader(PacketHeader *header, PacketType type, uint32_t sequence) const {
+    header->magic = Magic;
+    header->version = Version;
+    header->type = static_cast<uint16_t>(type);
+    header->sequence = sequence;
+    header->reserved = 0;
+}
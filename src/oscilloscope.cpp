@@ -4,6 +4,7 @@
 #include "../include/engine_sim_application.h"
 #include "../include/ui_utilities.h"
 
+#include <algorithm>
 #include <cmath>
 
 Oscilloscope::Oscilloscope() {
@@ -13,9 +14,14 @@ Oscilloscope::Oscilloscope() {
 
     m_points = nullptr;
     m_renderBuffer = nullptr;
+    m_decimatedPoints = nullptr;
+    m_decimatedBuffer = nullptr;
     m_writeIndex = 0;
     m_bufferSize = 0;
     m_pointCount = 0;
+    m_unconvertedCount = 0;
+    m_prepared = false;
+    m_convertedRange[0] = m_convertedRange[1] = m_convertedRange[2] = m_convertedRange[3] = 0;
     m_drawReverse = true;
     m_checkMouse = true;
     m_drawZero = true;
@@ -28,6 +34,8 @@ Oscilloscope::Oscilloscope() {
 Oscilloscope::~Oscilloscope() {
     assert(m_points == nullptr);
     assert(m_renderBuffer == nullptr);
+    assert(m_decimatedPoints == nullptr);
+    assert(m_decimatedBuffer == nullptr);
 }
 
 void Oscilloscope::initialize(EngineSimApplication *app) {
@@ -39,13 +47,19 @@ void Oscilloscope::initialize(EngineSimApplication *app) {
 void Oscilloscope::destroy() {
     delete[] m_points;
     delete[] m_renderBuffer;
+    delete[] m_decimatedPoints;
+    delete[] m_decimatedBuffer;
 
     m_points = nullptr;
     m_renderBuffer = nullptr;
+    m_decimatedPoints = nullptr;
+    m_decimatedBuffer = nullptr;
+    m_pyramid.destroy();
 
     m_writeIndex = 0;
     m_bufferSize = 0;
     m_pointCount = 0;
+    m_unconvertedCount = 0;
 }
 
 void Oscilloscope::update(float dt) {
@@ -54,41 +68,101 @@ void Oscilloscope::update(float dt) {
     m_mouseBounds = m_bounds;
 }
 
+void Oscilloscope::generateGeometry() {
+    m_prepared = generate(m_bounds, &m_lines, &m_zeroLine);
+}
+
 void Oscilloscope::render() {
-    render(m_bounds);
+    if (m_prepared) {
+        m_prepared = false;
+        draw(m_lines, m_zeroLine);
+    }
+    else {
+        render(m_bounds);
+    }
 }
 
 void Oscilloscope::render(const Bounds &bounds) {
+    GeometryGenerator::GeometryIndices lines, zeroLine;
+    if (generate(bounds, &lines, &zeroLine)) {
+        draw(lines, zeroLine);
+    }
+}
+
+bool Oscilloscope::generate(
+    const Bounds &bounds,
+    GeometryGenerator::GeometryIndices *lines,
+    GeometryGenerator::GeometryIndices *zeroLine)
+{
+    *lines = GeometryGenerator::GeometryIndices();
+    *zeroLine = GeometryGenerator::GeometryIndices();
     if (m_points == nullptr || m_renderBuffer == nullptr || m_bufferSize <= 0 || m_pointCount <= 0) {
-        return;
+        return false;
     }
 
-    for (int i = 0; i < m_pointCount; ++i) {
-        const int index = (m_writeIndex - m_pointCount + i + m_bufferSize) % m_bufferSize;
-        m_renderBuffer[index] = dataPointToRenderPosition(m_points[index], bounds);
+    // Screen positions only change for new points unless the scope moved or
+    // rescaled, so the ring isn't reconverted every frame
+    const Bounds renderBounds = getRenderBounds(bounds);
+    const double range[] = { m_xMin, m_xMax, m_yMin, m_yMax };
+    if (renderBounds.m0.x != m_convertedBounds.m0.x
+        || renderBounds.m0.y != m_convertedBounds.m0.y
+        || renderBounds.m1.x != m_convertedBounds.m1.x
+        || renderBounds.m1.y != m_convertedBounds.m1.y
+        || !std::equal(range, range + 4, m_convertedRange))
+    {
+        m_convertedBounds = renderBounds;
+        std::copy(range, range + 4, m_convertedRange);
+        m_unconvertedCount = m_pointCount;
     }
 
     const int start = (m_writeIndex - m_pointCount + m_bufferSize) % m_bufferSize;
-    const int n0 = (start + m_pointCount) > m_bufferSize
-        ? m_bufferSize - start
-        : m_pointCount;
-    const int n1 = m_pointCount - n0;
+    const int maxPoints = 2 * (int)std::ceil(std::abs(renderBounds.width()) / pixelsToUnits(1.0f));
 
-    GeometryGenerator::GeometryIndices lines;
+    GeometryGenerator *gen = m_app->getGeometryGenerator();
     GeometryGenerator::PathParameters params;
-    params.p0 = m_renderBuffer + start;
-    params.p1 = m_renderBuffer;
-    params.n0 = n0;
-    params.n1 = n1;
+    if (m_pointCount > maxPoints) {
+        const int n = m_pyramid.decimate(m_points, start, m_pointCount, maxPoints, m_decimatedPoints);
+        for (int i = 0; i < n; ++i) {
+            m_decimatedBuffer[i] = dataPointToRenderPosition(m_decimatedPoints[i], bounds);
+        }
 
-    m_app->getGeometryGenerator()->startShape();
+        params.p0 = m_decimatedBuffer;
+        params.p1 = m_decimatedBuffer;
+        params.n0 = n;
+        params.n1 = 0;
+    }
+    else {
+        for (int i = m_pointCount - m_unconvertedCount; i < m_pointCount; ++i) {
+            const int index = (m_writeIndex - m_pointCount + i + m_bufferSize) % m_bufferSize;
+            m_renderBuffer[index] = dataPointToRenderPosition(m_points[index], bounds);
+        }
+
+        m_unconvertedCount = 0;
+
+        const int n0 = (start + m_pointCount) > m_bufferSize
+            ? m_bufferSize - start
+            : m_pointCount;
+        params.p0 = m_renderBuffer + start;
+        params.p1 = m_renderBuffer;
+        params.n0 = n0;
+        params.n1 = m_pointCount - n0;
+    }
+
+    const int n0 = params.n0;
+    const int n1 = params.n1;
+
+    gen->startShape();
 
     params.i = 0;
     params.width = pixelsToUnits(0.5f) * (float)m_lineWidth;
-    if (!m_app->getGeometryGenerator()->startPath(params)) {
-        return;
+    if (!gen->startPath(params)) {
+        return false;
     }
 
+    const float minWidth = pixelsToUnits(0.5f);
+    const float unit = pixelsToUnits(1.0f);
+    const float detachDistance = pixelsToUnits(100.0f);
+
     Point prev = params.p0[0];
     bool lastDetached = false;
     for (int i = 1; i < n0 + n1; ++i) {
@@ -101,18 +175,16 @@ void Oscilloscope::render(const Bounds &bounds) {
         const float s = (float)(i) / (n0 + n1);
         const Point p_i = p[index];
         params.i = i;
-        params.width = (float)m_lineWidth * std::fmaxf(
-            pixelsToUnits(1.0f) * s,
-            pixelsToUnits(0.5f));
+        params.width = (float)m_lineWidth * std::fmaxf(unit * s, minWidth);
 
         if (s > 0.95f) {
-            params.width += pixelsToUnits(((s - 0.95f) / 0.05f) * 2);
+            params.width += unit * ((s - 0.95f) / 0.05f) * 2;
         }
 
         const bool detached =
             prev.x > p_i.x
-            || std::abs(p_i.x - prev.x) > pixelsToUnits(100.0f);
-        m_app->getGeometryGenerator()->generatePathSegment(
+            || std::abs(p_i.x - prev.x) > detachDistance;
+        gen->generatePathSegment(
             params,
             (detached || lastDetached) && !m_drawReverse);
 
@@ -121,12 +193,9 @@ void Oscilloscope::render(const Bounds &bounds) {
         prev = p_i;
     }
 
-    m_app->getGeometryGenerator()->endShape(&lines);
-
-    resetShader();
+    gen->endShape(lines);
 
     if (m_drawZero) {
-        GeometryGenerator::GeometryIndices zeroLine;
         const Point zeroA = dataPointToRenderPosition({ (float)m_xMin, 0.0f }, bounds);
         const Point zeroB = dataPointToRenderPosition({ (float)m_xMax, 0.0f }, bounds);
 
@@ -137,10 +206,21 @@ void Oscilloscope::render(const Bounds &bounds) {
         params.y1 = zeroB.y;
         params.lineWidth = pixelsToUnits(0.5f);
 
-        m_app->getGeometryGenerator()->startShape();
-        m_app->getGeometryGenerator()->generateLine2d(params);
-        m_app->getGeometryGenerator()->endShape(&zeroLine);
+        gen->startShape();
+        gen->generateLine2d(params);
+        gen->endShape(zeroLine);
+    }
+
+    return true;
+}
+
+void Oscilloscope::draw(
+    const GeometryGenerator::GeometryIndices &lines,
+    const GeometryGenerator::GeometryIndices &zeroLine)
+{
+    resetShader();
 
+    if (m_drawZero) {
         m_app->getShaders()->SetBaseColor(mix(m_app->getForegroundColor(), m_app->getBackgroundColor(), 0.95f));
         m_app->drawGenerated(zeroLine, 0x11, m_app->getShaders()->GetUiFlags());
     }
@@ -177,10 +257,12 @@ void Oscilloscope::addDataPoint(double x, double y) {
     }
 
     m_points[m_writeIndex] = { x, y };
+    m_pyramid.update(m_points, m_writeIndex, 1);
     m_writeIndex = (m_writeIndex + 1) % m_bufferSize;
     m_pointCount = (m_pointCount >= m_bufferSize)
         ? m_bufferSize
         : m_pointCount + 1;
+    m_unconvertedCount = std::min(m_unconvertedCount + 1, m_pointCount);
 
     if (m_dynamicallyResizeY) {
         if (y + std::abs(0.1 * y) >= m_yMax) {
@@ -200,11 +282,43 @@ void Oscilloscope::addDataPoint(double x, double y) {
     }
 }
 
+void Oscilloscope::addDataPoints(double x0, double dx, const float *y, int stride, int count) {
+    if (m_points == nullptr || m_bufferSize <= 0 || count <= 0) {
+        return;
+    }
+
+    if (m_dynamicallyResizeX || m_dynamicallyResizeY) {
+        for (int i = 0; i < count; ++i) {
+            addDataPoint(x0 + i * dx, y[i * stride]);
+        }
+
+        return;
+    }
+
+    // Only the newest m_bufferSize points would survive anyway
+    const int skipped = std::max(0, count - m_bufferSize);
+    const int first = m_writeIndex;
+    for (int i = skipped; i < count; ++i) {
+        m_points[m_writeIndex] = { x0 + i * dx, y[i * stride] };
+        if (++m_writeIndex == m_bufferSize) m_writeIndex = 0;
+    }
+
+    const int written = count - skipped;
+    m_pyramid.update(m_points, first, written);
+    m_pointCount = std::min(m_pointCount + written, m_bufferSize);
+    m_unconvertedCount = std::min(m_unconvertedCount + written, m_pointCount);
+}
+
 void Oscilloscope::setBufferSize(int n) {
     delete[] m_points;
     delete[] m_renderBuffer;
+    delete[] m_decimatedPoints;
+    delete[] m_decimatedBuffer;
     m_points = nullptr;
     m_renderBuffer = nullptr;
+    m_decimatedPoints = nullptr;
+    m_decimatedBuffer = nullptr;
+    m_pyramid.destroy();
 
     if (n <= 0) {
         m_bufferSize = 0;
@@ -215,7 +329,10 @@ void Oscilloscope::setBufferSize(int n) {
 
     m_points = new DataPoint[n];
     m_renderBuffer = new Point[n];
+    m_decimatedPoints = new DataPoint[n];
+    m_decimatedBuffer = new Point[n];
     m_bufferSize = n;
+    m_pyramid.initialize(n);
 
     reset();
 }
@@ -223,4 +340,5 @@ void Oscilloscope::setBufferSize(int n) {
 void Oscilloscope::reset() {
     m_writeIndex = 0;
     m_pointCount = 0;
+    m_unconvertedCount = 0;
 }
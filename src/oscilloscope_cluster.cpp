@@ -3,10 +3,13 @@
 #include "../include/engine_sim_application.h"
 #include "../include/debug_trace.h"
 
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 
 OscilloscopeCluster::OscilloscopeCluster() {
     m_simulator = nullptr;
+    m_sampleIndex = 0;
     m_torqueScope = nullptr;
     m_powerScope = nullptr;
     m_totalExhaustFlowScope = nullptr;
@@ -251,8 +254,8 @@ void OscilloscopeCluster::signal(UiElement *element, Event event) {
         if (previousFocus0 != m_currentFocusScopes[0]
             || previousFocus1 != m_currentFocusScopes[1]
             || previousFocus2 != m_currentFocusScopes[2]) {
-            DebugTrace::Log(
-                "ui",
+            ATG_ENGINE_SIM_TRACE(
+                Ui, Event,
                 "panel/tab transition source=%s focus=[%s,%s,%s]",
                 scopeName(element),
                 scopeName(m_currentFocusScopes[0]),
@@ -344,47 +347,51 @@ void OscilloscopeCluster::render() {
     UiElement::render();
 }
 
+void OscilloscopeCluster::layout() {
+    // Set here rather than in render() so the scopes' shapes can be
+    // generated before anything is drawn
+    Grid grid;
+    grid.h_cells = 3;
+    grid.v_cells = 4;
+
+    m_torqueScope->m_bounds = m_powerScope->m_bounds = grid.get(m_bounds, 0, 3);
+    m_intakeValveLiftScope->m_bounds = m_exhaustValveLiftScope->m_bounds = grid.get(m_bounds, 2, 2);
+
+    const Bounds &flowBounds = grid.get(m_bounds, 2, 3);
+    m_intakeFlowScope->m_bounds = flowBounds;
+    m_exhaustFlowScope->m_bounds = flowBounds;
+    m_cylinderMoleculesScope->m_bounds = flowBounds;
+
+    m_audioWaveformScope->m_bounds = grid.get(m_bounds, 0, 2);
+    m_pvScope->m_bounds = grid.get(m_bounds, 1, 3);
+    m_totalExhaustFlowScope->m_bounds = grid.get(m_bounds, 1, 2);
+}
+
 void OscilloscopeCluster::sample() {
-    if (m_simulator == nullptr) return;
+    if (m_simulator == nullptr || !m_simulator->isTelemetryEnabled()) return;
 
     Engine *engine = m_simulator->getEngine();
     if (engine == nullptr) return;
 
-    const double cylinderPressure = engine->getChamber(0)->m_system.pressure()
-        + engine->getChamber(0)->m_system.dynamicPressure(-1.0, 0.0);
+    TelemetryTap &telemetry = m_simulator->telemetry();
 
-    if (m_simulator->getCurrentIteration() % 2 == 0) {
-        double cycleAngle = engine->getCrankshaft(0)->getCycleAngle();
-        if (!engine->isSpinningCw()) {
-            cycleAngle = 4 * constants::pi - cycleAngle;
-        }
+    // Anything older would scroll out of the scopes before being drawn
+    const int visible = m_exhaustFlowScope->getBufferSize() * SampleDecimation;
+    int skip = std::max(0, telemetry.getPendingCount() - visible);
+
+    TelemetryTap::Record records[256];
+    int n;
+    while ((n = telemetry.read(records, 256)) > 0) {
+        for (int i = 0; i < n; ++i, ++m_sampleIndex) {
+            if (skip > 0) {
+                --skip;
+                continue;
+            }
 
-        getTotalExhaustFlowOscilloscope()->addDataPoint(
-            cycleAngle,
-            m_simulator->getTotalExhaustFlow() / m_simulator->getTimestep());
-        getCylinderPressureScope()->addDataPoint(
-            engine->getCrankshaft(0)->getCycleAngle(constants::pi),
-            std::sqrt(cylinderPressure));
-        getExhaustFlowOscilloscope()->addDataPoint(
-            cycleAngle,
-            engine->getChamber(0)->getLastTimestepExhaustFlow() / m_simulator->getTimestep());
-        getIntakeFlowOscilloscope()->addDataPoint(
-            cycleAngle,
-            engine->getChamber(0)->getLastTimestepIntakeFlow() / m_simulator->getTimestep());
-        getCylinderMoleculesScope()->addDataPoint(
-            cycleAngle,
-            engine->getChamber(0)->m_system.n());
-        getExhaustValveLiftOscilloscope()->addDataPoint(
-            cycleAngle,
-            engine->getChamber(0)->getCylinderHead()->exhaustValveLift(
-                engine->getChamber(0)->getPiston()->getCylinderIndex()));
-        getIntakeValveLiftOscilloscope()->addDataPoint(
-            cycleAngle,
-            engine->getChamber(0)->getCylinderHead()->intakeValveLift(
-                engine->getChamber(0)->getPiston()->getCylinderIndex()));
-        getPvScope()->addDataPoint(
-            engine->getChamber(0)->getVolume(),
-            std::sqrt(engine->getChamber(0)->m_system.pressure()));
+            if (m_sampleIndex % SampleDecimation == 0) {
+                addRecord(records[i]);
+            }
+        }
     }
 
     m_exhaustFlowScope->m_yMin = m_intakeFlowScope->m_yMin =
@@ -401,8 +408,56 @@ void OscilloscopeCluster::sample() {
         std::fmax(m_powerScope->m_xMax, units::toRpm(engine->getSpeed()));
 }
 
+void OscilloscopeCluster::addRecord(const TelemetryTap::Record &record) {
+    getTotalExhaustFlowOscilloscope()->addDataPoint(record.cycleAngle, record.totalExhaustFlow);
+    getCylinderPressureScope()->addDataPoint(record.pressureCycleAngle, std::sqrt(record.totalPressure));
+    getExhaustFlowOscilloscope()->addDataPoint(record.cycleAngle, record.exhaustFlow);
+    getIntakeFlowOscilloscope()->addDataPoint(record.cycleAngle, record.intakeFlow);
+    getCylinderMoleculesScope()->addDataPoint(record.cycleAngle, record.molecules);
+    getExhaustValveLiftOscilloscope()->addDataPoint(record.cycleAngle, record.exhaustValveLift);
+    getIntakeValveLiftOscilloscope()->addDataPoint(record.cycleAngle, record.intakeValveLift);
+    getPvScope()->addDataPoint(record.volume, std::sqrt(record.pressure));
+}
+
 void OscilloscopeCluster::setSimulator(Simulator *simulator) {
     m_simulator = simulator;
+    m_sampleIndex = 0;
+
+    if (m_simulator != nullptr) {
+        m_simulator->setTelemetryEnabled(isShown());
+    }
+}
+
+void OscilloscopeCluster::onVisibilityChanged(bool shown) {
+    if (m_simulator == nullptr) return;
+
+    m_simulator->setTelemetryEnabled(shown);
+    if (!shown) return;
+
+    // Traces from before the cluster was hidden would join up with the
+    // new ones across the gap; anything still queued is just as old
+    TelemetryTap::Record records[256];
+    while (m_simulator->telemetry().read(records, 256) > 0) {
+        /* void */
+    }
+
+    Oscilloscope *cycleScopes[] = {
+        m_totalExhaustFlowScope,
+        m_cylinderPressureScope,
+        m_exhaustFlowScope,
+        m_intakeFlowScope,
+        m_cylinderMoleculesScope,
+        m_exhaustValveLiftScope,
+        m_intakeValveLiftScope,
+        m_pvScope,
+        m_audioWaveformScope
+    };
+
+    for (Oscilloscope *scope : cycleScopes) {
+        scope->reset();
+    }
+
+    m_sampleIndex = 0;
 }
 
 void OscilloscopeCluster::renderScope(
@@ -428,6 +483,4 @@ void OscilloscopeCluster::renderScope(
 
         drawText(title, focusTitle.inset(20.0f), 24.0f, Bounds::tl);
     }
-
-    osc->m_bounds = bounds;
 }
@@ -0,0 +1,58 @@
+#include "../include/overload_policy.h"
+
+#include <algorithm>
+
+OverloadPolicy::OverloadPolicy() {
+    m_level = Level::None;
+    m_lowFrames = 0;
+    m_highFrames = 0;
+    m_shedCount = 0;
+}
+
+OverloadPolicy::~OverloadPolicy() {
+    /* void */
+}
+
+void OverloadPolicy::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.shedFrames = std::max(params.shedFrames, 1);
+    m_parameters.recoverFrames = std::max(params.recoverFrames, 1);
+    m_parameters.recoverHeadroom = std::max(params.recoverHeadroom, params.shedHeadroom);
+
+    reset();
+}
+
+void OverloadPolicy::reset() {
+    m_level = Level::None;
+    m_lowFrames = 0;
+    m_highFrames = 0;
+}
+
+bool OverloadPolicy::update(double headroom, bool underrun) {
+    m_lowFrames = (headroom < m_parameters.shedHeadroom || underrun) ? m_lowFrames + 1 : 0;
+    m_highFrames = (headroom >= m_parameters.recoverHeadroom && !underrun) ? m_highFrames + 1 : 0;
+
+    if ((underrun || m_lowFrames >= m_parameters.shedFrames) && m_level != Level::Convolution) {
+        m_level = static_cast<Level>(static_cast<int>(m_level) + 1);
+        m_lowFrames = 0;
+        ++m_shedCount;
+        return true;
+    }
+    else if (m_highFrames >= m_parameters.recoverFrames && m_level != Level::None) {
+        m_level = static_cast<Level>(static_cast<int>(m_level) - 1);
+        m_highFrames = 0;
+        return true;
+    }
+
+    return false;
+}
+
+const char *OverloadPolicy::GetLevelName(Level level) {
+    switch (level) {
+        case Level::None: return "none";
+        case Level::Scopes: return "scopes";
+        case Level::FluidSubsteps: return "fluid_substeps";
+        case Level::Convolution: return "convolution";
+        default: return "unknown";
+    }
+}
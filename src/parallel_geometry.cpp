@@ -0,0 +1,148 @@
+#include "../include/parallel_geometry.h"
+
+#include "../include/job_system.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace {
+// Which of a run's generators this thread writes into
+thread_local const ParallelGeometry *t_owner = nullptr;
+thread_local unsigned long long t_run = 0;
+thread_local int t_thread = -1;
+} /* namespace */
+
+ParallelGeometry::ParallelGeometry() {
+    m_jobs = nullptr;
+    m_enabled = true;
+    m_nextThread = 0;
+    m_run = 0;
+}
+
+ParallelGeometry::~ParallelGeometry() {
+    assert(m_threadGenerators.empty());
+}
+
+void ParallelGeometry::initialize(JobSystem *jobs) {
+    m_jobs = jobs;
+}
+
+void ParallelGeometry::destroy() {
+    for (GeometryGenerator *generator : m_threadGenerators) {
+        generator->destroy();
+        delete generator;
+    }
+
+    m_threadGenerators.clear();
+    m_ranges.clear();
+    m_jobs = nullptr;
+}
+
+void ParallelGeometry::run(GeometryGenerator *target, int n, Producer producer, void *context) {
+    m_statistics = Statistics();
+    m_statistics.producers = n;
+    if (n <= 0) return;
+
+    const int threads = (m_enabled && m_jobs != nullptr)
+        ? std::min(m_jobs->getConcurrency(), n)
+        : 1;
+    m_statistics.threads = threads;
+
+    if (threads <= 1) {
+        GeometryGenerator *previous = GeometryGenerator::GetThreadTarget();
+        GeometryGenerator::SetThreadTarget(target);
+
+        const int vertexBegin = target->getCurrentVertexCount();
+        const int indexBegin = target->getCurrentIndexCount();
+        for (int i = 0; i < n; ++i) {
+            producer(context, i);
+        }
+
+        GeometryGenerator::SetThreadTarget(previous);
+        m_statistics.vertices = target->getCurrentVertexCount() - vertexBegin;
+        m_statistics.indices = target->getCurrentIndexCount() - indexBegin;
+
+        return;
+    }
+
+    while ((int)m_threadGenerators.size() < threads) {
+        GeometryGenerator *generator = new GeometryGenerator;
+        generator->initialize(GeometryGenerator::PageVertexCount, GeometryGenerator::PageIndexCount);
+        m_threadGenerators.push_back(generator);
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        m_threadGenerators[i]->reset();
+    }
+
+    if ((int)m_ranges.size() < n) m_ranges.resize(n);
+    m_nextThread = 0;
+    ++m_run;
+
+    m_jobs->parallelFor(
+        n,
+        [this, producer, context](int i) { generate(i, producer, context); },
+        JobSystem::Priority::Normal,
+        threads);
+
+    merge(target, n);
+}
+
+void ParallelGeometry::generate(int index, Producer producer, void *context) {
+    if (t_owner != this || t_run != m_run) {
+        t_owner = this;
+        t_run = m_run;
+        t_thread = m_nextThread.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // parallelFor() runs on at most as many threads as there are generators
+    assert(t_thread < (int)m_threadGenerators.size());
+    GeometryGenerator *generator = m_threadGenerators[t_thread];
+
+    Range &range = m_ranges[index];
+    range.generator = generator;
+    range.vertexBegin = generator->getCurrentVertexCount();
+    range.indexBegin = generator->getCurrentIndexCount();
+    range.shapes.clear();
+
+    GeometryGenerator *previous = GeometryGenerator::GetThreadTarget();
+    GeometryGenerator::SetThreadTarget(generator);
+    generator->setShapeLog(&range.shapes);
+
+    producer(context, index);
+
+    generator->setShapeLog(nullptr);
+    GeometryGenerator::SetThreadTarget(previous);
+
+    range.vertexEnd = generator->getCurrentVertexCount();
+    range.indexEnd = generator->getCurrentIndexCount();
+}
+
+void ParallelGeometry::merge(GeometryGenerator *target, int n) {
+    for (int i = 0; i < n; ++i) {
+        Range &range = m_ranges[i];
+
+        int vertexOffset, indexOffset;
+        if (!target->append(
+            *range.generator,
+            range.vertexBegin,
+            range.vertexEnd,
+            range.indexBegin,
+            range.indexEnd,
+            &vertexOffset,
+            &indexOffset))
+        {
+            continue;
+        }
+
+        // A producer can end shapes into the same indices more than once
+        std::sort(range.shapes.begin(), range.shapes.end());
+        range.shapes.erase(std::unique(range.shapes.begin(), range.shapes.end()), range.shapes.end());
+        for (GeometryGenerator::GeometryIndices *shape : range.shapes) {
+            target->rebase(shape, vertexOffset, indexOffset);
+        }
+
+        m_statistics.vertices += range.vertexEnd - range.vertexBegin;
+        m_statistics.indices += range.indexEnd - range.indexBegin;
+    }
+}
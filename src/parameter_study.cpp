@@ -0,0 +1,270 @@
+#include "../include/parameter_study.h"
+
+#include "../include/combustion_chamber.h"
+#include "../include/cylinder_head.h"
+#include "../include/debug_trace.h"
+#include "../include/engine.h"
+#include "../include/ignition_module.h"
+#include "../include/intake.h"
+#include "../include/job_system.h"
+#include "../include/random_stream.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <set>
+
+ParameterStudy::ParameterStudy() {
+    /* void */
+}
+
+ParameterStudy::~ParameterStudy() {
+    /* void */
+}
+
+void ParameterStudy::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.samples = std::max(params.samples, 1);
+
+    DynoSweep sweep;
+    sweep.initialize(m_parameters.sweep);
+    m_holdPoints = sweep.getHoldPoints();
+
+    generateVariants();
+}
+
+int ParameterStudy::getTaskCount() const {
+    return (int)(m_variants.size() * m_holdPoints.size());
+}
+
+ParameterStudy::Result ParameterStudy::run(const CreateSimulator &create, const ReleaseSimulator &release) {
+    const int holdPoints = (int)m_holdPoints.size();
+    const int tasks = getTaskCount();
+
+    Result result;
+    result.variants = m_variants;
+    result.sweeps.resize(m_variants.size());
+    for (DynoSweep::Result &sweep : result.sweeps) {
+        sweep.points.resize(holdPoints);
+    }
+
+    const int threads = std::min(std::max(m_parameters.sweep.threads, 1), std::max(tasks, 1));
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "parameter_study begin variants=%d points=%d threads=%d",
+        (int)m_variants.size(),
+        holdPoints,
+        threads);
+
+    std::mutex factoryLock;
+    const CreateSimulator lockedCreate = [&](int task, const Variant &variant) {
+        std::lock_guard<std::mutex> lock(factoryLock);
+        return create(task, variant);
+    };
+
+    const ReleaseSimulator lockedRelease = [&](int task, Simulator *simulator) {
+        std::lock_guard<std::mutex> lock(factoryLock);
+        release(task, simulator);
+    };
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    JobSystem::Shared().parallelFor(tasks, [&](int task) {
+        result.sweeps[task / holdPoints].points[task % holdPoints] =
+            runTask(task, lockedCreate, lockedRelease);
+    }, JobSystem::Priority::Normal, threads);
+
+    const auto t1 = std::chrono::steady_clock::now();
+    result.wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+
+    ATG_ENGINE_SIM_TRACE(Headless, Event, "parameter_study complete wall_s=%.3f", result.wallTime);
+
+    return result;
+}
+
+DynoSweep::Point ParameterStudy::runTask(
+    int task,
+    const CreateSimulator &create,
+    const ReleaseSimulator &release) const
+{
+    const int holdPoints = getHoldPointCount();
+    const int variant = task / holdPoints;
+    const int point = task % holdPoints;
+
+    // A single-point sweep on the calling thread; the study's tasks
+    // already keep every core busy
+    DynoSweep::Parameters params = m_parameters.sweep;
+    params.minRpm = params.maxRpm = m_holdPoints[point];
+    params.threads = 1;
+
+    DynoSweep sweep;
+    sweep.initialize(params);
+    const DynoSweep::Result measured = sweep.run(
+        [&](int) { return create(task, m_variants[variant]); },
+        [&](int, Simulator *simulator) { release(task, simulator); });
+
+    return measured.points.empty() ? DynoSweep::Point() : measured.points[0];
+}
+
+void ParameterStudy::apply(Engine *engine, const Variant &variant) const {
+    // Heads can share camshafts, which must only move once
+    std::set<Camshaft *> intakeCams, exhaustCams;
+
+    for (size_t i = 0; i < m_parameters.axes.size() && i < variant.values.size(); ++i) {
+        const double value = variant.values[i];
+        switch (m_parameters.axes[i].parameter) {
+            case Parameter::IntakeCamAdvance:
+            case Parameter::ExhaustCamAdvance:
+            {
+                const bool intake = m_parameters.axes[i].parameter == Parameter::IntakeCamAdvance;
+                for (int j = 0; j < engine->getCylinderBankCount(); ++j) {
+                    CylinderHead *head = engine->getHead(j);
+                    Camshaft *cam = intake ? head->getIntakeCamshaft() : head->getExhaustCamshaft();
+                    std::set<Camshaft *> &moved = intake ? intakeCams : exhaustCams;
+                    if (cam == nullptr || !moved.insert(cam).second) continue;
+
+                    cam->setAdvance(cam->getAdvance() + units::angle(value, units::deg));
+                }
+
+                break;
+            }
+            case Parameter::IgnitionOffset:
+                engine->getIgnitionModule()->setTimingOffset(
+                    engine->getIgnitionModule()->getTimingOffset() + units::angle(value, units::deg));
+                break;
+            case Parameter::HeaderPrimaryLength:
+                for (int j = 0; j < engine->getCylinderBankCount(); ++j) {
+                    engine->getHead(j)->setAllHeaderPrimaryLengths(units::distance(value, units::inch));
+                }
+
+                break;
+            case Parameter::IntakeRunnerLength:
+                for (int j = 0; j < engine->getIntakeCount(); ++j) {
+                    engine->getIntake(j)->setRunnerLength(units::distance(value, units::inch));
+                }
+
+                break;
+            default:
+                break;
+        }
+    }
+
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        engine->getChamber(i)->updateGeometry();
+    }
+}
+
+bool ParameterStudy::writeCsv(const std::string &path, const Result &result) const {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    std::fprintf(file, "variant");
+    for (const Axis &axis : m_parameters.axes) {
+        std::fprintf(file, ",%s", GetParameterName(axis.parameter));
+    }
+
+    std::fprintf(file, ",rpm,torque_nm,power_kw,manifold_kpa,intake_afr,imep_kpa,imep_cov,settled_s,audio_db,centroid_hz,roughness\n");
+    for (size_t i = 0; i < result.variants.size(); ++i) {
+        for (const DynoSweep::Point &point : result.sweeps[i].points) {
+            if (!point.valid) continue;
+
+            std::fprintf(file, "%d", (int)i);
+            for (double value : result.variants[i].values) {
+                std::fprintf(file, ",%.4f", value);
+            }
+
+            std::fprintf(
+                file,
+                ",%.0f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,",
+                point.rpm,
+                units::convert(point.torque, units::Nm),
+                units::convert(point.power, units::kW),
+                units::convert(point.manifoldPressure, units::kPa),
+                point.intakeAfr,
+                units::convert(point.imep, units::kPa),
+                point.imepCoefficientOfVariation);
+
+            if (point.settled) std::fprintf(file, "%.3f", point.settledTime);
+            DynoSweep::WriteAudioColumns(file, point);
+            std::fprintf(file, "\n");
+        }
+    }
+
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+
+    return ok;
+}
+
+const char *ParameterStudy::GetParameterName(Parameter parameter) {
+    switch (parameter) {
+        case Parameter::IntakeCamAdvance: return "intake_cam_advance";
+        case Parameter::ExhaustCamAdvance: return "exhaust_cam_advance";
+        case Parameter::IgnitionOffset: return "ignition_offset";
+        case Parameter::HeaderPrimaryLength: return "header_primary_length";
+        case Parameter::IntakeRunnerLength: return "intake_runner_length";
+        default: return "unknown";
+    }
+}
+
+bool ParameterStudy::ParseParameter(const std::string &name, Parameter *parameter) {
+    for (int i = 0; i < (int)Parameter::Count; ++i) {
+        if (name == GetParameterName((Parameter)i)) {
+            *parameter = (Parameter)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ParameterStudy::generateVariants() {
+    m_variants.clear();
+
+    const std::vector<Axis> &axes = m_parameters.axes;
+    if (axes.empty()) {
+        m_variants.push_back(Variant());
+        return;
+    }
+
+    if (m_parameters.design == Design::Random) {
+        RandomStream random;
+        random.seed(m_parameters.seed, 0);
+
+        for (int i = 0; i < m_parameters.samples; ++i) {
+            Variant variant;
+            for (const Axis &axis : axes) {
+                variant.values.push_back(axis.min + (axis.max - axis.min) * random.uniform());
+            }
+
+            m_variants.push_back(variant);
+        }
+
+        return;
+    }
+
+    // Full factorial; the last axis varies fastest
+    std::vector<int> index(axes.size(), 0);
+    while (true) {
+        Variant variant;
+        for (size_t i = 0; i < axes.size(); ++i) {
+            const int steps = std::max(axes[i].steps, 1);
+            const double s = (steps > 1) ? (double)index[i] / (steps - 1) : 0.0;
+            variant.values.push_back(axes[i].min + (axes[i].max - axes[i].min) * s);
+        }
+
+        m_variants.push_back(variant);
+
+        int axis = (int)axes.size() - 1;
+        for (; axis >= 0; --axis) {
+            if (++index[axis] < std::max(axes[axis].steps, 1)) break;
+            index[axis] = 0;
+        }
+
+        if (axis < 0) break;
+    }
+}
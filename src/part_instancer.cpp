@@ -0,0 +1,128 @@
+#include "../include/part_instancer.h"
+
+#include "../include/engine_sim_application.h"
+
+#include <cstring>
+
+bool PartInstancer::MeshKey::operator==(const MeshKey &other) const {
+    if (part != other.part) return false;
+    for (int i = 0; i < 4; ++i) {
+        if (parameters[i] != other.parameters[i]) return false;
+    }
+
+    return true;
+}
+
+PartInstancer::PartInstancer() {
+    m_app = nullptr;
+    m_groupCount = 0;
+}
+
+PartInstancer::~PartInstancer() {
+    /* void */
+}
+
+void PartInstancer::initialize(EngineSimApplication *app) {
+    m_app = app;
+    clearMeshes();
+    beginFrame();
+}
+
+void PartInstancer::destroy() {
+    m_meshes.clear();
+    m_groups.clear();
+    m_groupCount = 0;
+}
+
+void PartInstancer::clearMeshes() {
+    m_meshes.clear();
+    m_statistics.meshes = 0;
+}
+
+const GeometryGenerator::GeometryIndices *PartInstancer::findMesh(const MeshKey &key) const {
+    for (const Mesh &mesh : m_meshes) {
+        if (mesh.key == key) return &mesh.indices;
+    }
+
+    return nullptr;
+}
+
+void PartInstancer::addMesh(const MeshKey &key, const GeometryGenerator::GeometryIndices &mesh) {
+    m_meshes.push_back({ key, mesh });
+    m_statistics.meshes = static_cast<int>(m_meshes.size());
+}
+
+void PartInstancer::beginFrame() {
+    m_groupCount = 0;
+    m_statistics.instances = 0;
+    m_statistics.draws = 0;
+}
+
+void PartInstancer::addInstance(
+    const GeometryGenerator::GeometryIndices &mesh,
+    const ysMatrix &transform,
+    const ysVector &color,
+    int layer)
+{
+    if (mesh.FaceCount <= 0) return;
+
+    ++m_statistics.instances;
+
+    Group *group = nullptr;
+    for (int i = m_groupCount - 1; i >= 0; --i) {
+        if (m_groups[i].layer != layer) continue;
+        else if (std::memcmp(&m_groups[i].color, &color, sizeof(ysVector)) == 0) {
+            group = &m_groups[i];
+        }
+
+        break;
+    }
+
+    if (group == nullptr) {
+        if (m_groupCount == static_cast<int>(m_groups.size())) {
+            m_groups.emplace_back();
+        }
+
+        group = &m_groups[m_groupCount++];
+        group->layer = layer;
+        group->color = color;
+        group->instances.clear();
+    }
+
+    group->instances.push_back({ mesh, transform });
+}
+
+void PartInstancer::flush() {
+    for (int i = 0; i < m_groupCount; ++i) {
+        draw(m_groups[i]);
+    }
+
+    m_groupCount = 0;
+}
+
+void PartInstancer::draw(const Group &group) {
+    GeometryGenerator *gen = m_app->getGeometryGenerator();
+    Shaders *shaders = m_app->getShaders();
+
+    shaders->ResetBaseColor();
+    shaders->SetObjectTransform(ysMath::LoadIdentity());
+    shaders->SetBaseColor(group.color);
+
+    GeometryGenerator::GeometryIndices indices;
+    gen->startShape();
+    for (const Instance &instance : group.instances) {
+        if (gen->generateInstance(instance.mesh, instance.transform)) continue;
+
+        // Only fails when the shape would outgrow 16-bit indices
+        gen->endShape(&indices);
+        m_app->drawGenerated(indices, group.layer);
+        ++m_statistics.draws;
+
+        gen->startShape();
+        gen->generateInstance(instance.mesh, instance.transform);
+    }
+
+    gen->endShape(&indices);
+    m_app->drawGenerated(indices, group.layer);
+    ++m_statistics.draws;
+}
@@ -0,0 +1,317 @@
+#include "../include/partitioned_convolution.h"
+
+#include "../include/utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+PartitionedConvolution::PartitionedConvolution() {
+    m_head = nullptr;
+    m_headHistory = nullptr;
+    m_headSize = 0;
+    m_headOffset = 0;
+
+    m_stageCount = 0;
+    m_sampleCount = 0;
+    m_activeFraction = 1.0f;
+
+    m_worker = nullptr;
+    m_deferTail = false;
+    m_deferredStalls = 0;
+}
+
+PartitionedConvolution::~PartitionedConvolution() {
+    assert(m_head == nullptr);
+    assert(m_headHistory == nullptr);
+    assert(m_stageCount == 0);
+}
+
+void PartitionedConvolution::initialize(
+    const float *impulseResponse,
+    int samples,
+    int headSize,
+    int tailSize,
+    ConvolutionWorker *worker)
+{
+    assert(headSize > 0 && (headSize & (headSize - 1)) == 0);
+    assert(tailSize >= headSize && (tailSize & (tailSize - 1)) == 0);
+
+    destroy();
+
+    if (impulseResponse == nullptr || samples <= 0) return;
+
+    m_sampleCount = samples;
+    m_worker = worker;
+    m_deferTail = (worker != nullptr);
+    m_headSize = std::min(samples, headSize);
+    m_headOffset = 0;
+    m_head = new float[m_headSize];
+    m_headHistory = new float[2 * (size_t)m_headSize];
+
+    std::memcpy(m_head, impulseResponse, sizeof(float) * (size_t)m_headSize);
+    std::memset(m_headHistory, 0, sizeof(float) * 2 * (size_t)m_headSize);
+
+    // Each stage starts one of its own blocks into the impulse response so a
+    // block's output only depends on input that has already arrived; a
+    // deferred tail's output arrives a block later still
+    const int tailOffset = m_deferTail ? 2 * tailSize : tailSize;
+    const int firstEnd = (tailSize > headSize) ? std::min(samples, tailOffset) : samples;
+    if (firstEnd > headSize) {
+        initializeStage(
+            &m_stages[m_stageCount++],
+            impulseResponse,
+            headSize,
+            firstEnd - headSize,
+            headSize,
+            false);
+    }
+
+    if (samples > firstEnd) {
+        initializeStage(
+            &m_stages[m_stageCount++],
+            impulseResponse,
+            firstEnd,
+            samples - firstEnd,
+            tailSize,
+            m_deferTail);
+    }
+}
+
+void PartitionedConvolution::initialize(
+    const PartitionedConvolution &prototype,
+    ConvolutionWorker *worker)
+{
+    destroy();
+
+    if (!prototype.isInitialized()) return;
+
+    m_sampleCount = prototype.m_sampleCount;
+    m_deferTail = prototype.m_deferTail;
+    m_worker = m_deferTail ? worker : nullptr;
+    m_headSize = prototype.m_headSize;
+    m_headOffset = 0;
+    m_head = new float[m_headSize];
+    m_headHistory = new float[2 * (size_t)m_headSize];
+
+    std::memcpy(m_head, prototype.m_head, sizeof(float) * (size_t)m_headSize);
+    std::memset(m_headHistory, 0, sizeof(float) * 2 * (size_t)m_headSize);
+
+    for (int i = 0; i < prototype.m_stageCount; ++i) {
+        const Stage &source = prototype.m_stages[i];
+        allocateStage(
+            &m_stages[m_stageCount++],
+            source.blockSize,
+            source.partitionCount,
+            source.deferred,
+            source.partitionStorage);
+    }
+}
+
+void PartitionedConvolution::destroy() {
+    for (int i = 0; i < m_stageCount; ++i) {
+        waitForStage(&m_stages[i]);
+        destroyStage(&m_stages[i]);
+    }
+
+    delete[] m_head;
+    delete[] m_headHistory;
+
+    m_head = nullptr;
+    m_headHistory = nullptr;
+    m_headSize = 0;
+    m_headOffset = 0;
+    m_stageCount = 0;
+    m_sampleCount = 0;
+    m_worker = nullptr;
+    m_deferTail = false;
+    m_deferredStalls = 0;
+}
+
+float PartitionedConvolution::f(float sample) {
+    if (m_sampleCount <= 0) return sample;
+
+    m_headOffset = (m_headOffset == 0) ? m_headSize - 1 : m_headOffset - 1;
+    m_headHistory[m_headOffset] = sample;
+    m_headHistory[m_headOffset + m_headSize] = sample;
+
+    float result = dotProduct(m_head, m_headHistory + m_headOffset, m_headSize);
+
+    for (int i = 0; i < m_stageCount; ++i) {
+        Stage &stage = m_stages[i];
+        result += stage.output[stage.position];
+        stage.input[stage.blockSize + stage.position] = sample;
+
+        if (++stage.position >= stage.blockSize) {
+            advanceStage(&stage);
+            stage.position = 0;
+        }
+    }
+
+    return result;
+}
+
+void PartitionedConvolution::allocateStage(
+    Stage *stage,
+    int blockSize,
+    int partitionCount,
+    bool deferred,
+    std::shared_ptr<std::complex<float>> partitions)
+{
+    const int n = 2 * blockSize;
+
+    stage->fft.initialize(n);
+    stage->blockSize = blockSize;
+    stage->partitionCount = partitionCount;
+    stage->position = 0;
+    stage->newest = 0;
+
+    if (partitions == nullptr) {
+        partitions = std::shared_ptr<std::complex<float>>(
+            new std::complex<float>[(size_t)partitionCount * n],
+            std::default_delete<std::complex<float>[]>());
+    }
+
+    stage->partitionStorage = std::move(partitions);
+    stage->partitions = stage->partitionStorage.get();
+    stage->history = new std::complex<float>[(size_t)partitionCount * n];
+    stage->work = new std::complex<float>[n];
+    stage->input = new float[n];
+    stage->output = new float[blockSize];
+
+    std::fill(stage->history, stage->history + (size_t)partitionCount * n, std::complex<float>(0, 0));
+    std::memset(stage->input, 0, sizeof(float) * (size_t)n);
+    std::memset(stage->output, 0, sizeof(float) * (size_t)blockSize);
+
+    stage->deferred = deferred;
+    if (deferred) {
+        stage->deferredInput = new float[n];
+        stage->deferredOutput = new float[blockSize];
+        stage->busy = new std::atomic<bool>(false);
+
+        std::memset(stage->deferredOutput, 0, sizeof(float) * (size_t)blockSize);
+    }
+}
+
+void PartitionedConvolution::initializeStage(
+    Stage *stage,
+    const float *impulseResponse,
+    int offset,
+    int length,
+    int blockSize,
+    bool deferred)
+{
+    const int n = 2 * blockSize;
+    const int partitionCount = (length + blockSize - 1) / blockSize;
+
+    allocateStage(stage, blockSize, partitionCount, deferred);
+
+    for (int p = 0; p < partitionCount; ++p) {
+        std::complex<float> *partition = stage->partitionStorage.get() + (size_t)p * n;
+        for (int i = 0; i < n; ++i) {
+            const int tap = offset + p * blockSize + i;
+            partition[i] = (i < blockSize && tap < offset + length)
+                ? impulseResponse[tap]
+                : 0.0f;
+        }
+
+        stage->fft.forward(partition);
+    }
+}
+
+void PartitionedConvolution::destroyStage(Stage *stage) {
+    stage->fft.destroy();
+
+    delete[] stage->history;
+    delete[] stage->work;
+    delete[] stage->input;
+    delete[] stage->output;
+    delete[] stage->deferredInput;
+    delete[] stage->deferredOutput;
+    delete stage->busy;
+
+    *stage = Stage();
+}
+
+void PartitionedConvolution::advanceStage(Stage *stage) {
+    const int blockSize = stage->blockSize;
+
+    if (!stage->deferred) {
+        stage->activeCount = getActiveCount(stage);
+        processStage(stage, stage->input, stage->output);
+    }
+    else {
+        // The block handed over last time is due now
+        if (waitForStage(stage)) ++m_deferredStalls;
+        stage->activeCount = getActiveCount(stage);
+        std::swap(stage->output, stage->deferredOutput);
+        std::memcpy(stage->deferredInput, stage->input, sizeof(float) * 2 * (size_t)blockSize);
+
+        if (m_worker != nullptr) {
+            m_worker->submit(processDeferredStage, stage, stage->busy);
+        }
+        else {
+            processDeferredStage(stage);
+        }
+    }
+
+    std::memcpy(stage->input, stage->input + blockSize, sizeof(float) * (size_t)blockSize);
+}
+
+bool PartitionedConvolution::waitForStage(Stage *stage) {
+    if (stage->busy == nullptr || !stage->busy->load(std::memory_order_acquire)) return false;
+
+    while (stage->busy->load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+int PartitionedConvolution::getActiveCount(const Stage *stage) const {
+    return std::min(
+        std::max(static_cast<int>(std::ceil(stage->partitionCount * m_activeFraction)), 1),
+        stage->partitionCount);
+}
+
+void PartitionedConvolution::processDeferredStage(void *context) {
+    Stage *stage = static_cast<Stage *>(context);
+    processStage(stage, stage->deferredInput, stage->deferredOutput);
+}
+
+void PartitionedConvolution::processStage(Stage *stage, const float *input, float *output) {
+    const int blockSize = stage->blockSize;
+    const int n = 2 * blockSize;
+    const int partitionCount = stage->partitionCount;
+    const int activeCount = stage->activeCount;
+
+    stage->newest = (stage->newest == 0) ? partitionCount - 1 : stage->newest - 1;
+    std::complex<float> *spectrum = stage->history + (size_t)stage->newest * n;
+    for (int i = 0; i < n; ++i) {
+        spectrum[i] = input[i];
+    }
+
+    stage->fft.forward(spectrum);
+
+    // Partition p pairs with the spectrum from p blocks ago; the product is
+    // expanded by hand in the kernel to keep it on the fast path
+    std::complex<float> *work = stage->work;
+    std::fill(work, work + n, std::complex<float>(0, 0));
+    for (int p = 0; p < activeCount; ++p) {
+        int h = stage->newest + p;
+        if (h >= partitionCount) h -= partitionCount;
+
+        const float *x = reinterpret_cast<const float *>(stage->history + (size_t)h * n);
+        const float *y = reinterpret_cast<const float *>(stage->partitions + (size_t)p * n);
+        multiplyAccumulateSpectrum(reinterpret_cast<float *>(work), x, y, n);
+    }
+
+    stage->fft.inverse(work);
+
+    const float scale = 1.0f / n;
+    for (int i = 0; i < blockSize; ++i) {
+        output[i] = work[blockSize + i].real() * scale;
+    }
+}
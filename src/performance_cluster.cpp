@@ -4,8 +4,12 @@
 #include "../include/gauge.h"
 #include "../include/constants.h"
 #include "../include/engine_sim_application.h"
+#include "../include/step_profiler.h"
+#include "../include/allocation_tracker.h"
 
 #include <sstream>
+#include <iomanip>
+#include <chrono>
 
 PerformanceCluster::PerformanceCluster() {
     m_simulator = nullptr;
@@ -15,11 +19,18 @@ PerformanceCluster::PerformanceCluster() {
     m_simulationFrequencyGauge = nullptr;
     m_inputSamplesGauge = nullptr;
     m_audioLagGauge = nullptr;
+    m_fluidStepsGauge = nullptr;
 
     m_timePerTimestep = 0.0;
     m_filteredSimulationFrequency = 0.0;
     m_inputBufferUsage = 0.0;
     m_audioLatency = 0.0;
+
+    m_allocationSampleTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < AllocationTracker::TagCount; ++i) {
+        m_allocationTotals[i] = 0;
+        m_allocationRate[i] = 0.0;
+    }
 }
 
 PerformanceCluster::~PerformanceCluster() {
@@ -171,6 +182,24 @@ void PerformanceCluster::initialize(EngineSimApplication *app) {
     m_simulationFrequencyGauge->m_gauge->setBandCount(1);
     m_simulationFrequencyGauge->m_gauge->setBand(
         { m_app->getForegroundColor(), 11025, 44100, 3.0f, 6.0f, shortenAngle, shortenAngle }, 0);
+
+    m_fluidStepsGauge = addElement<LabeledGauge>();
+    m_fluidStepsGauge->m_title = "FLUID STEPS";
+    m_fluidStepsGauge->m_unit = "";
+    m_fluidStepsGauge->m_precision = 0;
+    m_fluidStepsGauge->setLocalPosition({ 0, 0 });
+    m_fluidStepsGauge->m_gauge->m_min = 0;
+    m_fluidStepsGauge->m_gauge->m_max = 32;
+    m_fluidStepsGauge->m_gauge->m_minorStep = 1;
+    m_fluidStepsGauge->m_gauge->m_majorStep = 4;
+    m_fluidStepsGauge->m_gauge->m_maxMinorTick = 32;
+    m_fluidStepsGauge->m_gauge->m_thetaMin = (float)constants::pi * 1.2f;
+    m_fluidStepsGauge->m_gauge->m_thetaMax = -(float)constants::pi * 0.2f;
+    m_fluidStepsGauge->m_gauge->m_needleWidth = 4.0f;
+    m_fluidStepsGauge->m_gauge->m_gamma = 1.0f;
+    m_fluidStepsGauge->m_gauge->m_needleKs = 1000.0f;
+    m_fluidStepsGauge->m_gauge->m_needleKd = 20.0f;
+    m_fluidStepsGauge->m_gauge->setBandCount(0);
 }
 
 void PerformanceCluster::destroy() {
@@ -185,47 +214,124 @@ void PerformanceCluster::update(float dt) {
         return;
     }
 
+    const SimulationSnapshot &snapshot = m_simulator->getSnapshot();
     m_filteredSimulationFrequency = 0.9 * m_filteredSimulationFrequency
-        + 0.1 * m_simulator->getSimulationFrequency() * m_simulator->getSimulationSpeed();
+        + 0.1 * snapshot.simulationFrequency * snapshot.simulationSpeed;
 }
 
-void PerformanceCluster::render() {
+void PerformanceCluster::layout() {
     Grid grid;
-    grid.h_cells = 3;
+    grid.h_cells = 4;
     grid.v_cells = 2;
 
-    constexpr float shortenAngle = (float)units::angle(1.0, units::deg);
+    m_fpsGauge->m_bounds = grid.get(m_bounds, 0, 0);
+    m_timePerTimestepGauge->m_bounds = grid.get(m_bounds, 1, 0);
+    m_simSpeedGauge->m_bounds = grid.get(m_bounds, 2, 0);
+    m_fluidStepsGauge->m_bounds = grid.get(m_bounds, 3, 0);
+    m_audioLagGauge->m_bounds = grid.get(m_bounds, 0, 1);
+    m_inputSamplesGauge->m_bounds = grid.get(m_bounds, 1, 1);
+    m_simulationFrequencyGauge->m_bounds = grid.get(m_bounds, 2, 1);
+}
+
+void PerformanceCluster::render() {
     const double filteredSimulationFrequency = (m_filteredSimulationFrequency > 1E-6)
         ? m_filteredSimulationFrequency
         : 1.0;
     const double idealTimePerTimestep = 1.0 / filteredSimulationFrequency;
-    m_timePerTimestepGauge->m_bounds = grid.get(m_bounds, 1, 0);
     m_timePerTimestepGauge->m_gauge->m_value =
         (float)(m_timePerTimestep / idealTimePerTimestep) * 100.0f;
 
-    m_fpsGauge->m_bounds = grid.get(m_bounds, 0, 0);
     m_fpsGauge->m_gauge->m_value = m_app->getEngine()->GetAverageFramerate();
 
-    m_simSpeedGauge->m_bounds = grid.get(m_bounds, 2, 0);
-    const double simulationSpeed = (m_simulator != nullptr) ? m_simulator->getSimulationSpeed() : 0.0;
+    const double simulationSpeed = (m_simulator != nullptr) ? m_simulator->getSnapshot().simulationSpeed : 0.0;
     m_simSpeedGauge->m_gauge->m_value = (simulationSpeed > 1E-6)
         ? 1.0f / (float)simulationSpeed
         : m_simSpeedGauge->m_gauge->m_max;
 
-    m_audioLagGauge->m_bounds = grid.get(m_bounds, 0, 1);
     m_audioLagGauge->m_gauge->m_value = (float)m_audioLatency * 100.0f;
 
-    m_inputSamplesGauge->m_bounds = grid.get(m_bounds, 1, 1);
     m_inputSamplesGauge->m_gauge->m_value = (float)m_inputBufferUsage * 100.0f;
 
-    m_simulationFrequencyGauge->m_bounds = grid.get(m_bounds, 2, 1);
     m_simulationFrequencyGauge->m_gauge->m_value = (m_simulator != nullptr)
-        ? (float)m_simulator->getSimulationFrequency()
+        ? (float)m_simulator->getSnapshot().simulationFrequency
+        : 0.0f;
+
+    m_fluidStepsGauge->m_gauge->m_value = (m_simulator != nullptr)
+        ? (float)m_simulator->getSnapshot().fluidSimulationSteps
         : 0.0f;
 
+    // The last cell is free; the step profile takes precedence when both
+    // are compiled in
+    Grid grid;
+    grid.h_cells = 4;
+    grid.v_cells = 2;
+    if (StepProfiler::IsEnabled()) {
+        renderStepProfile(grid.get(m_bounds, 3, 1));
+    }
+    else if (AllocationTracker::IsEnabled()) {
+        renderAllocationProfile(grid.get(m_bounds, 3, 1));
+    }
+
     UiElement::render();
 }
 
+void PerformanceCluster::renderStepProfile(const Bounds &bounds) {
+    const Bounds inner = bounds.inset(10.0f);
+
+    Grid grid;
+    grid.h_cells = 1;
+    grid.v_cells = StepProfiler::StageCount;
+
+    for (int i = 0; i < StepProfiler::StageCount; ++i) {
+        const StepProfiler::Stage stage = static_cast<StepProfiler::Stage>(i);
+
+        StepProfiler::Statistics statistics;
+        StepProfiler::GetStatistics(stage, &statistics);
+
+        std::stringstream ss;
+        ss << std::setprecision(2) << std::fixed;
+        ss << StepProfiler::GetStageName(stage) << " ";
+        ss << statistics.averageMicroseconds() << " us";
+
+        drawText(ss.str(), grid.get(inner, 0, StepProfiler::StageCount - 1 - i), 10.0f, Bounds::lm);
+    }
+}
+
+void PerformanceCluster::renderAllocationProfile(const Bounds &bounds) {
+    const Bounds inner = bounds.inset(10.0f);
+
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - m_allocationSampleTime).count();
+    const bool resample = elapsed >= 1.0;
+
+    Grid grid;
+    grid.h_cells = 1;
+    grid.v_cells = AllocationTracker::TagCount;
+
+    for (int i = 0; i < AllocationTracker::TagCount; ++i) {
+        const AllocationTracker::Tag tag = static_cast<AllocationTracker::Tag>(i);
+
+        AllocationTracker::TagStatistics statistics;
+        AllocationTracker::GetTagStatistics(tag, &statistics);
+
+        if (resample) {
+            m_allocationRate[i] =
+                (statistics.totalAllocations - m_allocationTotals[i]) / elapsed;
+            m_allocationTotals[i] = statistics.totalAllocations;
+        }
+
+        std::stringstream ss;
+        ss << std::setprecision(1) << std::fixed;
+        ss << AllocationTracker::GetTagName(tag) << " ";
+        ss << statistics.liveBytes / (1024.0 * 1024.0) << " MB ";
+        ss << std::setprecision(0) << m_allocationRate[i] << "/s";
+
+        drawText(ss.str(), grid.get(inner, 0, AllocationTracker::TagCount - 1 - i), 10.0f, Bounds::lm);
+    }
+
+    if (resample) m_allocationSampleTime = now;
+}
+
 void PerformanceCluster::addTimePerTimestepSample(double sample) {
     const double r = 0.95;
     m_timePerTimestep = r * m_timePerTimestep + (1 - r) * sample;
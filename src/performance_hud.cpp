@@ -0,0 +1,259 @@
+#include "../include/performance_hud.h"
+
+#include "../include/engine_sim_application.h"
+#include "../include/allocation_tracker.h"
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <initializer_list>
+
+namespace {
+enum Row {
+    Title,
+    PhysicsMeter,
+    AudioMeter,
+    MainMeter,
+    StepShares,
+    Underruns,
+    Allocations,
+    Latency,
+    RowCount
+};
+} /* namespace */
+
+PerformanceHud::PerformanceHud() {
+    m_simulator = nullptr;
+    m_latencyProbe = nullptr;
+
+    m_sampleTime = std::chrono::steady_clock::now();
+    m_allocationTotal = 0;
+    m_allocationRate = 0.0;
+    m_underrunRate = 0.0;
+    m_overrunRate = 0.0;
+    m_timePerTimestep = 0.0;
+}
+
+PerformanceHud::~PerformanceHud() {
+    /* void */
+}
+
+void PerformanceHud::initialize(EngineSimApplication *app) {
+    UiElement::initialize(app);
+}
+
+void PerformanceHud::destroy() {
+    UiElement::destroy();
+}
+
+void PerformanceHud::update(float dt) {
+    UiElement::update(dt);
+
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - m_sampleTime).count();
+    if (elapsed >= WindowSeconds) {
+        resample(elapsed);
+        m_sampleTime = now;
+    }
+}
+
+void PerformanceHud::resample(double elapsed) {
+    for (int i = 0; i < StepProfiler::StageCount; ++i) {
+        StepProfiler::Statistics statistics;
+        StepProfiler::GetStatistics(static_cast<StepProfiler::Stage>(i), &statistics);
+
+        m_stageWindow[i] = statistics.since(m_stageTotals[i]);
+        m_stageTotals[i] = statistics;
+    }
+
+    if (m_simulator != nullptr) {
+        const Synthesizer::RenderStatistics render = m_simulator->synthesizer().getRenderStatistics();
+
+        // The totals start over when a new engine's synthesizer is set up
+        const Synthesizer::RenderStatistics &earlier = (render.blocks >= m_renderTotals.blocks)
+            ? m_renderTotals
+            : Synthesizer::RenderStatistics();
+        m_renderWindow.blocks = render.blocks - earlier.blocks;
+        m_renderWindow.samples = render.samples - earlier.samples;
+        m_renderWindow.microseconds = render.microseconds - earlier.microseconds;
+        m_renderWindow.underruns = render.underruns - std::min(earlier.underruns, render.underruns);
+        m_renderWindow.overruns = render.overruns - std::min(earlier.overruns, render.overruns);
+        m_renderTotals = render;
+
+        m_underrunRate = m_renderWindow.underruns / elapsed;
+        m_overrunRate = m_renderWindow.overruns / elapsed;
+    }
+
+    uint64_t allocations = 0;
+    for (int i = 0; i < AllocationTracker::TagCount; ++i) {
+        AllocationTracker::TagStatistics statistics;
+        AllocationTracker::GetTagStatistics(static_cast<AllocationTracker::Tag>(i), &statistics);
+        allocations += statistics.totalAllocations;
+    }
+
+    m_allocationRate = (allocations - std::min(m_allocationTotal, allocations)) / elapsed;
+    m_allocationTotal = allocations;
+}
+
+void PerformanceHud::render() {
+    drawFrame(m_bounds, 1.0f, m_app->getForegroundColor(), m_app->getBackgroundColor());
+
+    const Bounds inner = m_bounds.inset(10.0f);
+
+    Grid grid;
+    grid.h_cells = 1;
+    grid.v_cells = RowCount;
+
+    const float textHeight = 12.0f;
+    drawText("PERFORMANCE", grid.get(inner, 0, Title), textHeight, Bounds::lm);
+
+    const bool profiled = StepProfiler::IsEnabled();
+    const StepProfiler::Statistics &step =
+        m_stageWindow[static_cast<int>(StepProfiler::Stage::Step)];
+
+    std::stringstream ss;
+    ss << std::setprecision(1) << std::fixed;
+
+    // One step has to finish in the real time it simulates
+    double stepBudget = 0.0;
+    if (m_simulator != nullptr) {
+        const SimulationSnapshot &snapshot = m_simulator->getSnapshot();
+        const double stepRate = snapshot.simulationFrequency * snapshot.simulationSpeed;
+        stepBudget = (stepRate > 1E-6) ? 1E6 / stepRate : 0.0;
+    }
+
+    if (profiled) {
+        const double p50 = step.percentileMicroseconds(0.5);
+        const double p99 = step.percentileMicroseconds(0.99);
+        ss << "PHYSICS p50 " << p50 << " p99 " << p99 << " / " << stepBudget << " us";
+        renderMeter(ss.str(), p99, stepBudget, grid.get(inner, 0, PhysicsMeter));
+    }
+    else {
+        const double perStep = m_timePerTimestep * 1E6;
+        ss << "PHYSICS " << perStep << " / " << stepBudget << " us";
+        renderMeter(ss.str(), perStep, stepBudget, grid.get(inner, 0, PhysicsMeter));
+    }
+
+    const double sampleRate = (m_simulator != nullptr)
+        ? m_simulator->synthesizer().getAudioSampleRate()
+        : 0.0;
+    const double blockDuration = (m_renderWindow.blocks > 0 && sampleRate > 0)
+        ? 1E6 * m_renderWindow.samples / (m_renderWindow.blocks * sampleRate)
+        : 0.0;
+    const double blockAverage = m_renderWindow.averageBlockMicroseconds();
+    const double blockP99 = profiled
+        ? m_stageWindow[static_cast<int>(StepProfiler::Stage::SynthesizerRender)].percentileMicroseconds(0.99)
+        : 0.0;
+
+    ss.str("");
+    ss << "AUDIO avg " << blockAverage;
+    if (profiled) ss << " p99 " << blockP99;
+    ss << " / " << blockDuration << " us";
+    renderMeter(ss.str(), std::max(blockAverage, blockP99), blockDuration, grid.get(inner, 0, AudioMeter));
+
+    ss.str("");
+    if (profiled) {
+        // Main thread work against the frame it has to fit in; the rest of
+        // the frame is spent waiting for the display
+        const StepProfiler::Stage mainStages[] = {
+            StepProfiler::Stage::AudioOutput,
+            StepProfiler::Stage::UiUpdate,
+            StepProfiler::Stage::RenderScene,
+            StepProfiler::Stage::Present
+        };
+
+        double frameWork = 0.0;
+        for (StepProfiler::Stage stage : mainStages) {
+            frameWork += m_stageWindow[static_cast<int>(stage)].averageMicroseconds();
+        }
+
+        const double framerate = m_app->getEngine()->GetAverageFramerate();
+        const double frameBudget = (framerate > 1E-6) ? 1E3 / framerate : 0.0;
+        ss << "MAIN " << frameWork / 1E3 << " / " << frameBudget << " ms";
+        renderMeter(ss.str(), frameWork / 1E3, frameBudget, grid.get(inner, 0, MainMeter));
+
+        const auto share = [&](std::initializer_list<StepProfiler::Stage> stages) {
+            double total = 0.0;
+            for (StepProfiler::Stage stage : stages) {
+                total += m_stageWindow[static_cast<int>(stage)].totalMicroseconds;
+            }
+
+            return total;
+        };
+
+        const double stepTotal = step.totalMicroseconds;
+        const double solver = share({ StepProfiler::Stage::Solver });
+        const double fluid = share({
+            StepProfiler::Stage::FluidExhaust,
+            StepProfiler::Stage::FluidIntake,
+            StepProfiler::Stage::FluidChambers });
+        const double synthesis = share({ StepProfiler::Stage::WriteToSynthesizer });
+        const double other = std::max(0.0, stepTotal - solver - fluid - synthesis);
+        const double scale = (stepTotal > 0) ? 100.0 / stepTotal : 0.0;
+
+        ss.str("");
+        ss << std::setprecision(0);
+        ss << "SOLVER " << solver * scale << "%  FLUID " << fluid * scale
+            << "%  SYNTH " << synthesis * scale << "%  OTHER " << other * scale << "%";
+        drawText(ss.str(), grid.get(inner, 0, StepShares), textHeight, Bounds::lm);
+    }
+    else {
+        ss << "MAIN / STAGES need ENGINE_SIM_PROFILE_STEPS";
+        drawText(ss.str(), grid.get(inner, 0, MainMeter), textHeight, Bounds::lm);
+    }
+
+    ss.str("");
+    ss << std::setprecision(1) << std::fixed;
+    ss << "UNDERRUN " << m_underrunRate << "/s  OVERRUN " << m_overrunRate << "/s  TOTAL "
+        << m_renderTotals.underruns;
+    drawText(ss.str(), grid.get(inner, 0, Underruns), textHeight, Bounds::lm);
+
+    ss.str("");
+    if (AllocationTracker::IsEnabled()) {
+        ss << std::setprecision(0) << "ALLOCATIONS " << m_allocationRate << "/s";
+    }
+    else {
+        ss << "ALLOCATIONS not tracked";
+    }
+    drawText(ss.str(), grid.get(inner, 0, Allocations), textHeight, Bounds::lm);
+
+    ss.str("");
+    if (m_latencyProbe != nullptr && m_latencyProbe->isEnabled()) {
+        const LatencyProbe::Statistics total = m_latencyProbe->getStatistics(LatencyProbe::Stage::Input);
+        const LatencyProbe::Statistics render = m_latencyProbe->getStatistics(LatencyProbe::Stage::Rendered);
+        const LatencyProbe::Statistics played = m_latencyProbe->getStatistics(LatencyProbe::Stage::Played);
+        ss << std::setprecision(1) << "LATENCY p50 " << total.p50 << " p99 " << total.p99
+            << " ms  RENDER " << render.p99 << "  DEVICE " << played.p99 << "  N " << total.count;
+    }
+    else {
+        ss << "LATENCY needs latency_probe";
+    }
+    drawText(ss.str(), grid.get(inner, 0, Latency), textHeight, Bounds::lm);
+
+    UiElement::render();
+}
+
+void PerformanceHud::renderMeter(
+    const std::string &label,
+    double used,
+    double budget,
+    const Bounds &bounds)
+{
+    drawText(label, bounds.horizontalSplit(0.0f, 0.6f), 12.0f, Bounds::lm);
+
+    const Bounds bar = bounds.horizontalSplit(0.62f, 1.0f).verticalSplit(0.25f, 0.75f);
+    const double fraction = (budget > 0) ? used / budget : 0.0;
+
+    // Orange well before the deadline, so there's time to back off
+    const ysVector color = (fraction < 0.5)
+        ? m_app->getGreen()
+        : (fraction < 0.8) ? m_app->getOrange() : m_app->getRed();
+
+    drawFrame(bar, 1.0f, m_app->getForegroundColor(), m_app->getBackgroundColor());
+    drawBox(bar.horizontalSplit(0.0f, (float)std::min(1.0, fraction)), color);
+}
+
+void PerformanceHud::addTimePerTimestepSample(double sample) {
+    const double r = 0.95;
+    m_timePerTimestep = r * m_timePerTimestep + (1 - r) * sample;
+}
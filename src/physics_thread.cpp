@@ -0,0 +1,136 @@
+#include "../include/physics_thread.h"
+
+#include "../include/allocation_tracker.h"
+#include "../include/simulator.h"
+#include "../include/debug_trace.h"
+#include "../include/denormals.h"
+#include "../include/step_profiler.h"
+#include "../include/thread_policy.h"
+
+#include <algorithm>
+#include <cassert>
+
+PhysicsThread::PhysicsThread() {
+    m_simulator = nullptr;
+    m_thread = nullptr;
+    m_period = std::chrono::nanoseconds(0);
+    m_run = false;
+    m_paused = false;
+    m_stepRequests = 0;
+    m_timePerTimestep = 0.0;
+    m_frames = 0;
+}
+
+PhysicsThread::~PhysicsThread() {
+    assert(m_thread == nullptr);
+}
+
+void PhysicsThread::initialize(Simulator *simulator, double frequency) {
+    m_simulator = simulator;
+    m_period = std::chrono::nanoseconds(static_cast<long long>(1E9 / frequency));
+    m_stepRequests = 0;
+    m_frames = 0;
+    m_run = true;
+    m_thread = new std::thread(&PhysicsThread::worker, this);
+
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "physics_thread start frequency=%.1f", frequency);
+}
+
+void PhysicsThread::destroy() {
+    if (m_thread == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_parkLock);
+        m_run = false;
+    }
+
+    m_parked.notify_all();
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+    m_simulator = nullptr;
+
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "physics_thread stop frames=%llu", getFrameCount());
+}
+
+void PhysicsThread::setPaused(bool paused) {
+    if (paused == m_paused) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_parkLock);
+        m_paused = paused;
+    }
+
+    m_parked.notify_all();
+}
+
+void PhysicsThread::requestStep() {
+    {
+        std::lock_guard<std::mutex> lock(m_parkLock);
+        ++m_stepRequests;
+    }
+
+    m_parked.notify_all();
+}
+
+void PhysicsThread::worker() {
+    ATG_ENGINE_SIM_ALLOCATION_SCOPE(Simulation);
+
+    using Clock = std::chrono::steady_clock;
+
+    // Frames cover the wall time since the previous one, up to a few
+    // periods, so a frame delayed by a reader catches up without bursting
+    const double period = std::chrono::duration<double>(m_period).count();
+    ThreadPolicy::ApplyToCurrentThread(ThreadPolicy::Role::Physics, period);
+    StepProfiler::SetThreadName("physics");
+    DenormalScope denormals;
+
+    auto last = Clock::now();
+    auto next = last + m_period;
+    while (m_run) {
+        std::this_thread::sleep_until(next);
+
+        const auto now = Clock::now();
+        const double dt = std::min(std::chrono::duration<double>(now - last).count(), 4 * period);
+        last = now;
+        next += m_period;
+        if (next < now) {
+            next = now + m_period;
+        }
+
+        if (m_paused) {
+            std::unique_lock<std::mutex> park(m_parkLock);
+            if (m_stepRequests <= 0) {
+                m_parked.wait(park, [this] { return !m_run || !m_paused || m_stepRequests > 0; });
+
+                // Time spent parked isn't simulated
+                last = Clock::now();
+                next = last + m_period;
+                continue;
+            }
+
+            --m_stepRequests;
+        }
+
+        std::lock_guard<std::mutex> lock(m_stateLock);
+        ATG_ENGINE_SIM_PROFILE_SCOPE(Frame);
+        const auto t0 = Clock::now();
+        m_simulator->startFrame(dt);
+
+        const int iterations = m_simulator->getFrameIterationCount();
+        while (m_simulator->simulateStep()) {
+            /* void */
+        }
+
+        const auto t1 = Clock::now();
+        m_simulator->endFrame();
+
+        if (iterations > 0) {
+            m_timePerTimestep.store(
+                std::chrono::duration<double>(t1 - t0).count() / iterations,
+                std::memory_order_relaxed);
+        }
+
+        m_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+}
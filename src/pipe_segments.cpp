@@ -0,0 +1,279 @@
+#include "../include/pipe_segments.h"
+
+#include "../include/constants.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+PipeSegments::PipeSegments() {
+    m_segments = 0;
+    m_segmentLength = 0.0;
+    m_segmentVolume = 0.0;
+    m_crossSectionArea = 0.0;
+    m_heatCapacityRatio = 0.0;
+    m_molarHeatCapacity = 0.0;
+
+    m_buffer = nullptr;
+
+    m_n = m_E = m_momentum = m_fuel = m_o2 = nullptr;
+    m_density = m_velocity = m_pressure = m_soundSpeed = nullptr;
+    m_fuelFraction = m_o2Fraction = nullptr;
+    m_faceN = m_faceE = m_faceMomentum = m_faceFuel = m_faceO2 = nullptr;
+
+    m_transferred = 0.0;
+}
+
+PipeSegments::~PipeSegments() {
+    assert(m_buffer == nullptr);
+}
+
+void PipeSegments::initialize(const Parameters &params) {
+    destroy();
+    if (params.segments <= 0) return;
+
+    const int n = params.segments;
+    m_segments = n;
+    m_segmentLength = params.length / n;
+    m_crossSectionArea = params.crossSectionArea;
+    m_segmentVolume = m_segmentLength * m_crossSectionArea;
+    m_heatCapacityRatio = GasSystem::heatCapacityRatio(params.degreesOfFreedom);
+    m_molarHeatCapacity = 0.5 * params.degreesOfFreedom * constants::R;
+
+    // Five cell streams, six primitive streams with a ghost at each end and
+    // five face streams
+    const size_t cells = n, ghosted = n + 2, faces = n + 1;
+    m_buffer = new double[5 * cells + 6 * ghosted + 5 * faces];
+
+    double *stream = m_buffer;
+    m_n = stream; stream += cells;
+    m_E = stream; stream += cells;
+    m_momentum = stream; stream += cells;
+    m_fuel = stream; stream += cells;
+    m_o2 = stream; stream += cells;
+    m_density = stream; stream += ghosted;
+    m_velocity = stream; stream += ghosted;
+    m_pressure = stream; stream += ghosted;
+    m_soundSpeed = stream; stream += ghosted;
+    m_fuelFraction = stream; stream += ghosted;
+    m_o2Fraction = stream; stream += ghosted;
+    m_faceN = stream; stream += faces;
+    m_faceE = stream; stream += faces;
+    m_faceMomentum = stream; stream += faces;
+    m_faceFuel = stream; stream += faces;
+    m_faceO2 = stream;
+
+    reset(params.P, params.T, params.mix);
+}
+
+void PipeSegments::destroy() {
+    if (m_buffer != nullptr) delete[] m_buffer;
+
+    m_buffer = nullptr;
+    m_n = m_E = m_momentum = m_fuel = m_o2 = nullptr;
+    m_density = m_velocity = m_pressure = m_soundSpeed = nullptr;
+    m_fuelFraction = m_o2Fraction = nullptr;
+    m_faceN = m_faceE = m_faceMomentum = m_faceFuel = m_faceO2 = nullptr;
+
+    m_segments = 0;
+}
+
+void PipeSegments::reset(double P, double T, const GasSystem::Mix &mix) {
+    const double n = P * m_segmentVolume / (constants::R * T);
+    for (int i = 0; i < m_segments; ++i) {
+        m_n[i] = n;
+        m_E[i] = n * m_molarHeatCapacity * T;
+        m_momentum[i] = 0.0;
+        m_fuel[i] = n * mix.p_fuel;
+        m_o2[i] = n * mix.p_o2;
+    }
+}
+
+double PipeSegments::flow(double dt, GasSystem *system_0, GasSystem *system_1) {
+    m_transferred = 0.0;
+    if (m_segments == 0 || dt <= 0) return 0.0;
+
+    const double maxStep = maxStableTimestep(system_0, system_1);
+    const int steps = (maxStep > 0)
+        ? std::max(static_cast<int>(std::ceil(dt / maxStep)), 1)
+        : 1;
+    const double h = dt / steps;
+
+    for (int i = 0; i < steps; ++i) {
+        step(h, system_0, system_1);
+    }
+
+    return m_transferred;
+}
+
+double PipeSegments::getPressure(int i) const {
+    const double m = units::AirMolecularMass * m_n[i];
+    const double bulk = (m > 0) ? 0.5 * m_momentum[i] * m_momentum[i] / m : 0.0;
+    return (m_heatCapacityRatio - 1) * (m_E[i] - bulk) / m_segmentVolume;
+}
+
+double PipeSegments::getTemperature(int i) const {
+    return (m_n[i] > 0)
+        ? getPressure(i) * m_segmentVolume / (m_n[i] * constants::R)
+        : 0.0;
+}
+
+double PipeSegments::getVelocity(int i) const {
+    const double m = units::AirMolecularMass * m_n[i];
+    return (m > 0) ? m_momentum[i] / m : 0.0;
+}
+
+double PipeSegments::getTotalN() const {
+    double n = 0.0;
+    for (int i = 0; i < m_segments; ++i) n += m_n[i];
+    return n;
+}
+
+double PipeSegments::getTotalEnergy() const {
+    double E = 0.0;
+    for (int i = 0; i < m_segments; ++i) E += m_E[i];
+    return E;
+}
+
+double PipeSegments::maxStableTimestep(const GasSystem *system_0, const GasSystem *system_1) const {
+    // The end systems count as cells as long as their own volume is along
+    // the pipe, so a small one isn't emptied in a step
+    double speed = 0.0;
+    for (int i = 0; i < m_segments; ++i) {
+        const double p = std::fmax(getPressure(i), 0.0);
+        const double rho = units::AirMolecularMass * m_n[i] / m_segmentVolume;
+        const double c = (rho > 0) ? std::sqrt(m_heatCapacityRatio * p / rho) : 0.0;
+        speed = std::fmax(speed, std::abs(getVelocity(i)) + c);
+    }
+
+    double dx = m_segmentLength;
+    for (const GasSystem *system : { system_0, system_1 }) {
+        speed = std::fmax(speed, std::abs(system->velocity_x()) + system->c());
+        dx = std::fmin(dx, system->volume() / m_crossSectionArea);
+    }
+
+    return (speed > 0) ? MaxCourantNumber * dx / speed : 0.0;
+}
+
+void PipeSegments::computeFaceFluxes(GasSystem *system_0, GasSystem *system_1) {
+    const int n = m_segments;
+    const double M = units::AirMolecularMass;
+    const double gamma = m_heatCapacityRatio;
+    const double invV = 1 / m_segmentVolume;
+
+    // Ghosts take the state of the connected systems
+    GasSystem *ends[] = { system_0, system_1 };
+    const int ghosts[] = { 0, n + 1 };
+    for (int k = 0; k < 2; ++k) {
+        const GasSystem *system = ends[k];
+        const int g = ghosts[k];
+        m_density[g] = (system->volume() > 0) ? M * system->n() / system->volume() : 0.0;
+        m_velocity[g] = system->velocity_x();
+        m_pressure[g] = system->pressure();
+        m_soundSpeed[g] = system->c();
+        m_fuelFraction[g] = system->mix().p_fuel;
+        m_o2Fraction[g] = system->mix().p_o2;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        const double cellN = m_n[i];
+        const double invN = (cellN > 0) ? 1 / cellN : 0.0;
+        const double m = M * cellN;
+        const double u = (m > 0) ? m_momentum[i] / m : 0.0;
+        const double p = std::fmax((gamma - 1) * (m_E[i] - 0.5 * m_momentum[i] * u) * invV, 0.0);
+        const double rho = m * invV;
+
+        m_density[i + 1] = rho;
+        m_velocity[i + 1] = u;
+        m_pressure[i + 1] = p;
+        m_soundSpeed[i + 1] = (rho > 0) ? std::sqrt(gamma * p / rho) : 0.0;
+        m_fuelFraction[i + 1] = m_fuel[i] * invN;
+        m_o2Fraction[i + 1] = m_o2[i] * invN;
+    }
+
+    const double invM = 1 / M;
+    const double invGammaMinusOne = 1 / (gamma - 1);
+    for (int f = 0; f <= n; ++f) {
+        const double rho_l = m_density[f], rho_r = m_density[f + 1];
+        const double u_l = m_velocity[f], u_r = m_velocity[f + 1];
+        const double p_l = m_pressure[f], p_r = m_pressure[f + 1];
+        const double e_l = p_l * invGammaMinusOne + 0.5 * rho_l * u_l * u_l;
+        const double e_r = p_r * invGammaMinusOne + 0.5 * rho_r * u_r * u_r;
+        const double s = std::fmax(
+            std::abs(u_l) + m_soundSpeed[f],
+            std::abs(u_r) + m_soundSpeed[f + 1]);
+
+        const double massFlux =
+            0.5 * (rho_l * u_l + rho_r * u_r) - 0.5 * s * (rho_r - rho_l);
+        const double nFlux = massFlux * invM;
+
+        m_faceN[f] = nFlux;
+        m_faceMomentum[f] =
+            0.5 * (rho_l * u_l * u_l + p_l + rho_r * u_r * u_r + p_r)
+            - 0.5 * s * (rho_r * u_r - rho_l * u_l);
+        m_faceE[f] =
+            0.5 * ((e_l + p_l) * u_l + (e_r + p_r) * u_r) - 0.5 * s * (e_r - e_l);
+        m_faceFuel[f] = nFlux * ((nFlux > 0) ? m_fuelFraction[f] : m_fuelFraction[f + 1]);
+        m_faceO2[f] = nFlux * ((nFlux > 0) ? m_o2Fraction[f] : m_o2Fraction[f + 1]);
+    }
+}
+
+void PipeSegments::exchange(GasSystem *system, int face, double sign, double dt) {
+    // sign is +1 where a positive flux leaves the system and -1 where it
+    // enters it
+    const double M = units::AirMolecularMass;
+    const double A_dt = m_crossSectionArea * dt;
+
+    GasSystem::State state = system->getState();
+    const double n0 = state.n_mol;
+    const double dn = std::fmax(-sign * m_faceN[face] * A_dt, -n0);
+    if (dn == 0) return;
+
+    // Outflow carries the system's own velocity; inflow the pipe end's
+    const int cell = (sign > 0) ? 0 : m_segments - 1;
+    const double u = (dn < 0)
+        ? system->velocity_x()
+        : ((m_n[cell] > 0) ? m_momentum[cell] / (M * m_n[cell]) : 0.0);
+
+    const double bulk0 = (n0 > 0)
+        ? 0.5 * state.momentum[0] * state.momentum[0] / (M * n0)
+        : 0.0;
+
+    const double n1 = n0 + dn;
+    const double fuel = std::fmax(state.mix.p_fuel * n0 - sign * m_faceFuel[face] * A_dt, 0.0);
+    const double o2 = std::fmax(state.mix.p_o2 * n0 - sign * m_faceO2[face] * A_dt, 0.0);
+
+    state.n_mol = n1;
+    state.momentum[0] += dn * M * u;
+    if (n1 > 0) {
+        state.mix.p_fuel = std::fmin(fuel / n1, 1.0);
+        state.mix.p_o2 = std::fmin(o2 / n1, 1.0 - state.mix.p_fuel);
+        state.mix.p_inert = 1.0 - state.mix.p_fuel - state.mix.p_o2;
+    }
+
+    const double bulk1 = (n1 > 0)
+        ? 0.5 * state.momentum[0] * state.momentum[0] / (M * n1)
+        : 0.0;
+    state.E_k = std::fmax(state.E_k - sign * m_faceE[face] * A_dt - (bulk1 - bulk0), 0.0);
+
+    system->setState(state);
+}
+
+void PipeSegments::step(double dt, GasSystem *system_0, GasSystem *system_1) {
+    computeFaceFluxes(system_0, system_1);
+
+    const int n = m_segments;
+    const double A_dt = m_crossSectionArea * dt;
+    for (int i = 0; i < n; ++i) {
+        m_n[i] = std::fmax(m_n[i] + (m_faceN[i] - m_faceN[i + 1]) * A_dt, 0.0);
+        m_E[i] = std::fmax(m_E[i] + (m_faceE[i] - m_faceE[i + 1]) * A_dt, 0.0);
+        m_momentum[i] += (m_faceMomentum[i] - m_faceMomentum[i + 1]) * A_dt;
+        m_fuel[i] = std::fmax(m_fuel[i] + (m_faceFuel[i] - m_faceFuel[i + 1]) * A_dt, 0.0);
+        m_o2[i] = std::fmax(m_o2[i] + (m_faceO2[i] - m_faceO2[i + 1]) * A_dt, 0.0);
+    }
+
+    exchange(system_0, 0, 1.0, dt);
+    exchange(system_1, n, -1.0, dt);
+
+    m_transferred += m_faceN[n] * A_dt;
+}
@@ -46,6 +46,8 @@ double Piston::relativeY() const {
 }
 
 double Piston::calculateCylinderWallForce() const {
+    if (m_cylinderConstraint == nullptr) return 0.0;
+
     return std::sqrt(
         m_cylinderConstraint->F_x[0][0] * m_cylinderConstraint->F_x[0][0]
         + m_cylinderConstraint->F_y[0][0] * m_cylinderConstraint->F_y[0][0]);
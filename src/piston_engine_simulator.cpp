@@ -1,38 +1,62 @@
 #include "../include/piston_engine_simulator.h"
 
 #include "../include/constants.h"
+#include "../include/debug_trace.h"
+#include "../include/step_profiler.h"
 #include "../include/units.h"
 
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <assert.h>
 #include <chrono>
 #include <set>
+#include <vector>
 
 PistonEngineSimulator::PistonEngineSimulator() {
     m_engine = nullptr;
     m_transmission = nullptr;
     m_vehicle = nullptr;
-    m_delayFilters = nullptr;
+    m_exhaustAudioRoutes = nullptr;
+    m_runnerPressures = nullptr;
+    m_runnerDynamicPressures = nullptr;
+    m_exhaustPulses = nullptr;
+    m_delayedExhaustPulses = nullptr;
 
     m_crankConstraints = nullptr;
-    m_cylinderWallConstraints = nullptr;
-    m_linkConstraints = nullptr;
     m_crankshaftFrictionConstraints = nullptr;
     m_crankshaftLinks = nullptr;
 
     m_exhaustFlowStagingBuffer = nullptr;
+    m_stagedSynthesizerFrames = 0;
+    m_valveFlowStates = nullptr;
+    m_valveBatchSlots = nullptr;
+    m_batchedFlowRates = false;
+    m_runnerCoarsening = 1;
+    m_reducedKinematics = false;
 
     m_derivativeFilter.m_dt = 1.0;
     m_fluidSimulationSteps = 8;
+    m_fullFluidSimulationSteps = 8;
+    m_minFluidSimulationSteps = 2;
+    m_maxFluidSimulationSteps = 16;
+    m_fluidCourantNumber = 0.1;
+    m_maxFluidFlowFraction = 0.02;
+    m_adaptiveFluidSimulationSteps = false;
+
+    m_specializedStepKernels = true;
+    m_constraintPruning = true;
+    m_solvedSubsystems = AllSubsystems;
+    m_stepKernels = &SelectStepKernels(0, 0);
 }
 
 PistonEngineSimulator::~PistonEngineSimulator() {
     assert(m_crankConstraints == nullptr);
-    assert(m_cylinderWallConstraints == nullptr);
-    assert(m_linkConstraints == nullptr);
     assert(m_crankshaftFrictionConstraints == nullptr);
     assert(m_exhaustFlowStagingBuffer == nullptr);
-    assert(m_delayFilters == nullptr);
+    assert(m_exhaustAudioRoutes == nullptr);
+    assert(m_runnerPressures == nullptr);
+    assert(m_valveFlowStates == nullptr);
 }
 
 void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Transmission *transmission) {
@@ -42,31 +66,66 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
     m_vehicle = vehicle;
     m_transmission = transmission;
 
+    if (m_reducedKinematics && !CrankSliderModel::isSupported(engine)) {
+        m_reducedKinematics = false;
+    }
+
     const int crankCount = m_engine->getCrankshaftCount();
     const int cylinderCount = m_engine->getCylinderCount();
-    const int linkCount = cylinderCount * 2;
 
     if (crankCount <= 0) return;
 
-    m_crankConstraints = new atg_scs::FixedPositionConstraint[crankCount];
-    m_cylinderWallConstraints = new atg_scs::LineConstraint[cylinderCount];
-    m_linkConstraints = new atg_scs::LinkConstraint[linkCount];
-    m_crankshaftFrictionConstraints = new atg_scs::RotationFrictionConstraint[crankCount];
-    m_crankshaftLinks = new atg_scs::ClutchConstraint[crankCount - 1];
-    m_delayFilters = new DelayFilter[cylinderCount];
+    const int exhaustSystemCount = m_engine->getExhaustSystemCount();
+
+    // Laid out in the order the step loop visits them: constraints in the
+    // order they're added to the rigid body system, then the fluid and
+    // synthesizer staging data
+    m_arena.initialize(
+        SimulationArena::footprint<CrankBearingConstraint>(crankCount)
+        + SimulationArena::footprint<atg_scs::RotationFrictionConstraint>(crankCount)
+        + SimulationArena::footprint<CrankshaftLinkConstraint>(crankCount - 1)
+        + SimulationArena::footprint<GasSystem::FlowState>(cylinderCount * 2)
+        + SimulationArena::footprint<int>(cylinderCount)
+        + SimulationArena::footprint<ExhaustAudioRoute>(cylinderCount)
+        + SimulationArena::footprint<double>(cylinderCount * 4)
+        + SimulationArena::footprint<double>(exhaustSystemCount * SynthesizerStagingFrames));
+
+    m_crankConstraints = m_arena.allocate<CrankBearingConstraint>(crankCount);
+    m_crankshaftFrictionConstraints = m_arena.allocate<atg_scs::RotationFrictionConstraint>(crankCount);
+    m_crankshaftLinks = m_arena.allocate<CrankshaftLinkConstraint>(crankCount - 1);
+    m_valveFlowStates = m_arena.allocate<GasSystem::FlowState>(cylinderCount * 2);
+    m_valveBatchSlots = m_arena.allocate<int>(cylinderCount);
+    m_exhaustAudioRoutes = m_arena.allocate<ExhaustAudioRoute>(cylinderCount);
+    m_runnerPressures = m_arena.allocate<double>(cylinderCount * 4);
+    m_runnerDynamicPressures = m_runnerPressures + cylinderCount;
+    m_exhaustPulses = m_runnerDynamicPressures + cylinderCount;
+    m_delayedExhaustPulses = m_exhaustPulses + cylinderCount;
+    m_exhaustFlowStagingBuffer =
+        m_arena.allocate<double>(exhaustSystemCount * SynthesizerStagingFrames);
+    m_stagedSynthesizerFrames = 0;
+    m_valveFlowBatch.initialize(cylinderCount);
+    selectStepKernels();
+    m_cylinderConstraints.initialize(cylinderCount);
+    m_chamberForces.initialize(cylinderCount);
+
+    if (m_engine->isMultiZone()) {
+        ChamberZones::Parameters zoneParams;
+        zoneParams.chambers = cylinderCount;
+        zoneParams.creviceVolume = m_engine->getCreviceVolume();
+        zoneParams.wallTemperature = CombustionChamber::WallTemperature;
+        zoneParams.octaneNumber = m_engine->getKnockOctane();
+        m_chamberZones.initialize(zoneParams);
+    }
 
     const double ks = 5000;
     const double kd = 10;
+    m_cylinderConstraints.setStiffness(ks, kd);
 
     for (int i = 0; i < crankCount; ++i) {
         Crankshaft *outputShaft = m_engine->getCrankshaft(0);
         Crankshaft *crankshaft = m_engine->getCrankshaft(i);
 
-        m_crankConstraints[i].setBody(&crankshaft->m_body);
-        m_crankConstraints[i].setWorldPosition(
-            crankshaft->getPosX(),
-            crankshaft->getPosY());
-        m_crankConstraints[i].setLocalPosition(0.0, 0.0);
+        m_crankConstraints[i].connect(crankshaft);
         m_crankConstraints[i].m_kd = kd;
         m_crankConstraints[i].m_ks = ks;
 
@@ -81,29 +140,24 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
         m_crankshaftFrictionConstraints[i].m_maxTorque = crankshaft->getFrictionTorque();
         m_crankshaftFrictionConstraints[i].setBody(&m_engine->getCrankshaft(i)->m_body);
 
-        m_system->addRigidBody(&m_engine->getCrankshaft(i)->m_body);
-        m_system->addConstraint(&m_crankConstraints[i]);
-        m_system->addConstraint(&m_crankshaftFrictionConstraints[i]);
-
         if (crankshaft != outputShaft) {
-            atg_scs::ClutchConstraint *crankLink = &m_crankshaftLinks[i - 1];
-            crankLink->setBody1(&outputShaft->m_body);
-            crankLink->setBody2(&crankshaft->m_body);
-
-            m_system->addConstraint(crankLink);
+            CrankshaftLinkConstraint *crankLink = &m_crankshaftLinks[i - 1];
+            crankLink->connect(outputShaft, crankshaft);
+            crankLink->m_ks = ks;
+            crankLink->m_kd = kd;
         }
     }
 
-    m_transmission->addToSystem(m_system, &m_vehicleMass, m_vehicle, m_engine);
-    m_vehicle->addToSystem(m_system, &m_vehicleMass);
+    if (m_reducedKinematics) {
+        m_crankSlider.initialize(m_engine);
+    }
 
+    m_vehicle->addToSystem(m_system, &m_vehicleMass);
     m_vehicleDrag.initialize(&m_vehicleMass, m_vehicle);
-    m_system->addConstraint(&m_vehicleDrag);
 
     m_vehicleMass.reset();
     m_vehicleMass.m = 1.0;
     m_vehicleMass.I = 1.0;
-    m_system->addRigidBody(&m_vehicleMass);
 
     for (int i = 0; i < cylinderCount; ++i) {
         Piston *piston = m_engine->getPiston(i);
@@ -113,74 +167,70 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
         const double dx = std::cos(bank->getAngle() + constants::pi / 2);
         const double dy = std::sin(bank->getAngle() + constants::pi / 2);
 
-        m_cylinderWallConstraints[i].setBody(&piston->m_body);
-        m_cylinderWallConstraints[i].m_dx = dx;
-        m_cylinderWallConstraints[i].m_dy = dy;
-        m_cylinderWallConstraints[i].m_local_x = 0.0;
-        m_cylinderWallConstraints[i].m_local_y = piston->getWristPinLocation();
-        m_cylinderWallConstraints[i].m_p0_x = bank->getX();
-        m_cylinderWallConstraints[i].m_p0_y = bank->getY();
-        m_cylinderWallConstraints[i].m_ks = ks;
-        m_cylinderWallConstraints[i].m_kd = kd;
-
-        piston->setCylinderConstraint(&m_cylinderWallConstraints[i]);
-
-        m_linkConstraints[i * 2 + 0].setBody1(&connectingRod->m_body);
-        m_linkConstraints[i * 2 + 0].setBody2(&piston->m_body);
-        m_linkConstraints[i * 2 + 0]
-            .setLocalPosition1(0.0, connectingRod->getLittleEndLocal());
-        m_linkConstraints[i * 2 + 0].setLocalPosition2(0.0, piston->getWristPinLocation());
-        m_linkConstraints[i * 2 + 0].m_ks = ks;
-        m_linkConstraints[i * 2 + 0].m_kd = kd;
+        m_cylinderConstraints.setWall(i, dx, dy, bank->getX(), bank->getY());
+
+        if (m_reducedKinematics) {
+            piston->setCylinderConstraint(nullptr);
+            continue;
+        }
+
+        piston->setCylinderConstraint(m_cylinderConstraints.getWall(i));
+
+        m_cylinderConstraints.setLittleEnd(
+            i,
+            &connectingRod->m_body,
+            &piston->m_body,
+            connectingRod->getLittleEndLocal(),
+            piston->getWristPinLocation());
 
         double journal_x = 0.0, journal_y = 0.0;
+        atg_scs::RigidBody *journalBody = nullptr;
         if (connectingRod->getMasterRod() == nullptr) {
             Crankshaft *crankshaft = connectingRod->getCrankshaft();
             crankshaft->getRodJournalPositionLocal(
                 connectingRod->getJournal(),
                 &journal_x,
                 &journal_y);
-            m_linkConstraints[i * 2 + 1].setBody2(&crankshaft->m_body);
+            journalBody = &crankshaft->m_body;
         }
         else {
             connectingRod->getMasterRod()->getRodJournalPositionLocal(
                 connectingRod->getJournal(),
                 &journal_x,
                 &journal_y);
-            m_linkConstraints[i * 2 + 1].setBody2(&connectingRod->getMasterRod()->m_body);
+            journalBody = &connectingRod->getMasterRod()->m_body;
         }
 
-        m_linkConstraints[i * 2 + 1].setBody1(&connectingRod->m_body);
-        m_linkConstraints[i * 2 + 1]
-            .setLocalPosition1(0.0, connectingRod->getBigEndLocal());
-        m_linkConstraints[i * 2 + 1]
-            .setLocalPosition2(journal_x, journal_y);
-        m_linkConstraints[i * 2 + 1].m_ks = ks;
-        m_linkConstraints[i * 2 + 0].m_kd = kd;
+        m_cylinderConstraints.setBigEnd(
+            i,
+            journalBody,
+            connectingRod->getBigEndLocal(),
+            journal_x,
+            journal_y);
 
         piston->m_body.m = piston->getMass();
         piston->m_body.I = 1.0;
 
         connectingRod->m_body.m = connectingRod->getMass();
         connectingRod->m_body.I = connectingRod->getMomentOfInertia();
-
-        m_system->addRigidBody(&piston->m_body);
-        m_system->addRigidBody(&connectingRod->m_body);
-        m_system->addConstraint(&m_linkConstraints[i * 2 + 0]);
-        m_system->addConstraint(&m_linkConstraints[i * 2 + 1]);
-        m_system->addConstraint(&m_cylinderWallConstraints[i]);
-        m_system->addForceGenerator(m_engine->getChamber(i));
+        m_chamberForces.setChamber(i, m_engine->getChamber(i));
     }
 
     m_dyno.connectCrankshaft(m_engine->getOutputCrankshaft());
-    m_system->addConstraint(&m_dyno);
 
     m_starterMotor.connectCrankshaft(m_engine->getOutputCrankshaft());
     m_starterMotor.m_maxTorque = m_engine->getStarterTorque();
     m_starterMotor.m_rotationSpeed = -m_engine->getStarterSpeed();
-    m_system->addConstraint(&m_starterMotor);
+
+    // Binds the drivetrain to the vehicle mass; the first solve prunes
+    m_solvedSubsystems = AllSubsystems;
+    registerSystem();
 
     placeAndInitialize();
+    if (m_reducedKinematics) {
+        m_crankSlider.place();
+    }
+
     initializeSynthesizer();
 }
 
@@ -194,6 +244,26 @@ double PistonEngineSimulator::getAverageOutputSignal() const {
 }
 
 void PistonEngineSimulator::placeAndInitialize() {
+    const int cylinderCount = m_engine->getCylinderCount();
+    placeCylinders();
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        m_engine->getChamber(i)->getSystem()->initialize(
+            units::pressure(1.0, units::atm),
+            m_engine->getChamber(i)->getVolume(),
+            units::celcius(25.0)
+        );
+        m_engine->getChamber(i)->setRunnerCoarsening(m_runnerCoarsening);
+    }
+
+    m_flowGraph.compile(m_engine);
+    initializeExhaustDelays();
+    initializeExhaustAudioRoutes();
+    m_engine->getIgnitionModule()->reset();
+}
+
+void PistonEngineSimulator::placeCylinders() {
+    // Master rods first, since their slaves hang off their journals
     const int cylinderCount = m_engine->getCylinderCount();
     for (int i = 0; i < cylinderCount; ++i) {
         ConnectingRod *rod = m_engine->getConnectingRod(i);
@@ -206,14 +276,14 @@ void PistonEngineSimulator::placeAndInitialize() {
     for (int i = 0; i < cylinderCount; ++i) {
         placeCylinder(i);
     }
+}
 
+void PistonEngineSimulator::initializeExhaustDelays() {
+    // The exhaust pulse is delayed by its travel time down the pipe, timed
+    // at the frequency being stepped at
+    const int cylinderCount = m_engine->getCylinderCount();
+    std::vector<double> delays(cylinderCount);
     for (int i = 0; i < cylinderCount; ++i) {
-        m_engine->getChamber(i)->m_system.initialize(
-            units::pressure(1.0, units::atm),
-            m_engine->getChamber(i)->getVolume(),
-            units::celcius(25.0)
-        );
-
         Piston *piston = m_engine->getChamber(i)->getPiston();
         CylinderHead *head = m_engine->getChamber(i)->getCylinderHead();
         ExhaustSystem *exhaust = head->getExhaustSystem(piston->getCylinderIndex());
@@ -221,13 +291,71 @@ void PistonEngineSimulator::placeAndInitialize() {
             head->getHeaderPrimaryLength(piston->getCylinderIndex())
             + exhaust->getLength();
         const double speedOfSound = 343.0 * units::m / units::sec;
-        const double delay = exhaustLength / speedOfSound;
-        m_delayFilters[i].initialize(delay, 10000.0);
+        delays[i] = exhaustLength / speedOfSound;
     }
 
-    m_engine->getIgnitionModule()->reset();
+    m_exhaustDelays.initialize(delays.data(), cylinderCount, getSimulationFrequency());
+}
+
+void PistonEngineSimulator::initializeExhaustAudioRoutes() {
+    const int cylinderCount = m_engine->getCylinderCount();
+    for (int i = 0; i < cylinderCount; ++i) {
+        Piston *piston = m_engine->getPiston(i);
+        CylinderBank *bank = piston->getCylinderBank();
+        CylinderHead *head = m_engine->getHead(bank->getIndex());
+        ExhaustSystem *exhaust = head->getExhaustSystem(piston->getCylinderIndex());
+
+        const double exhaustLength =
+            head->getHeaderPrimaryLength(piston->getCylinderIndex())
+            + exhaust->getLength();
+
+        ExhaustAudioRoute &route = m_exhaustAudioRoutes[i];
+        route.runner = m_engine->getChamber(i)->getExhaustRunner();
+        route.exhaust = exhaust->getIndex();
+        route.gain =
+            head->getSoundAttenuation(piston->getCylinderIndex())
+            / (cylinderCount * exhaustLength * exhaustLength);
+    }
+}
+
+void PistonEngineSimulator::setFluidSimulationSteps(int steps) {
+    m_fullFluidSimulationSteps = std::max(1, steps);
+    if (getFidelity() == Fidelity::Full) {
+        m_fluidSimulationSteps = shedFluidSimulationSteps(m_fullFluidSimulationSteps);
+    }
+}
+
+int PistonEngineSimulator::shedFluidSimulationSteps(int steps) const {
+    return isOverloadShedding(OverloadPolicy::Level::FluidSubsteps)
+        ? std::max(1, steps / 2)
+        : steps;
+}
 
-    m_exhaustFlowStagingBuffer = new double[m_engine->getExhaustSystemCount()];
+void PistonEngineSimulator::applyFidelity() {
+    const int previousFrequency = getSimulationFrequency();
+    Simulator::applyFidelity();
+
+    m_fluidSimulationSteps = (getFidelity() == Fidelity::Preview)
+        ? 1
+        : shedFluidSimulationSteps(m_fullFluidSimulationSteps);
+
+    // Restarting the delay lines drops a few milliseconds of exhaust pulses,
+    // which is inaudible next to the change of rate itself
+    if (previousFrequency != getSimulationFrequency()
+        && m_engine != nullptr
+        && m_exhaustPulses != nullptr)
+    {
+        initializeExhaustDelays();
+    }
+}
+
+bool PistonEngineSimulator::captureSpeculativeCheckpoint() {
+    m_speculativeCheckpoint.capture(this);
+    return true;
+}
+
+bool PistonEngineSimulator::restoreSpeculativeCheckpoint() {
+    return m_speculativeCheckpoint.restore(this);
 }
 
 void PistonEngineSimulator::placeCylinder(int i) {
@@ -281,44 +409,235 @@ void PistonEngineSimulator::placeCylinder(int i) {
 
 void PistonEngineSimulator::simulateStep_() {
     const double timestep = getTimestep();
-    IgnitionModule *im = m_engine->getIgnitionModule();
-    im->update(timestep);
+    if (m_reducedKinematics) {
+        m_crankSlider.setTimestep(timestep);
+        m_crankSlider.place();
+    }
 
-    const int cylinderCount = m_engine->getCylinderCount();
-    for (int i = 0; i < cylinderCount; ++i) {
-        if (im->getIgnitionEvent(i)) {
-            m_engine->getChamber(i)->ignite();
+    IgnitionModule *im = m_engine->getIgnitionModule();
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(IgnitionUpdate);
+        if (im->getTimingMap()->isBaked()) {
+            im->setManifoldPressure(m_engine->getManifoldPressure());
         }
 
-        m_engine->getChamber(i)->update(timestep);
+        im->update(timestep);
     }
 
-    for (int i = 0; i < cylinderCount; ++i) {
-        m_engine->getChamber(i)->resetLastTimestepExhaustFlow();
-        m_engine->getChamber(i)->resetLastTimestepIntakeFlow();
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(ChamberUpdate);
+        (this->*m_stepKernels->updateChambers)(im, timestep);
     }
 
+    if (m_adaptiveFluidSimulationSteps && getFidelity() == Fidelity::Full) {
+        updateFluidSimulationSteps();
+    }
+
+    (this->*m_stepKernels->resetChamberFlows)();
+
+    // What the substeps share is built once here; the chambers did theirs
+    // in update()
     const int exhaustSystemCount = m_engine->getExhaustSystemCount();
     const int intakeCount = m_engine->getIntakeCount();
     const double fluidTimestep = timestep / m_fluidSimulationSteps;
+    for (int j = 0; j < exhaustSystemCount; ++j) {
+        m_engine->getExhaustSystem(j)->prepare(fluidTimestep);
+    }
+
+    for (int j = 0; j < intakeCount; ++j) {
+        m_engine->getIntake(j)->prepare(fluidTimestep);
+    }
+
     for (int i = 0; i < m_fluidSimulationSteps; ++i) {
-        for (int j = 0; j < exhaustSystemCount; ++j) {
-            m_engine->getExhaustSystem(j)->process(fluidTimestep);
+        {
+            ATG_ENGINE_SIM_PROFILE_SCOPE(FluidExhaust);
+            for (int j = 0; j < exhaustSystemCount; ++j) {
+                m_engine->getExhaustSystem(j)->process();
+            }
         }
 
-        for (int j = 0; j < intakeCount; ++j) {
-            m_engine->getIntake(j)->process(fluidTimestep);
-            m_engine->getIntake(j)->m_flowRate += m_engine->getIntake(j)->m_flow;
+        {
+            ATG_ENGINE_SIM_PROFILE_SCOPE(FluidIntake);
+            for (int j = 0; j < intakeCount; ++j) {
+                m_engine->getIntake(j)->process();
+                m_engine->getIntake(j)->m_flowRate += m_engine->getIntake(j)->m_flow;
+            }
         }
 
-        for (int j = 0; j < cylinderCount; ++j) {
-            m_engine->getChamber(j)->flow(fluidTimestep);
-        }
+        ATG_ENGINE_SIM_PROFILE_SCOPE(FluidChambers);
+        simulateFluidSubstep(fluidTimestep);
+    }
+
+    if (m_chamberZones.getChamberCount() > 0) {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(ChamberZones);
+        updateChamberZones(timestep);
     }
 
     im->resetIgnitionEvents();
 }
 
+void PistonEngineSimulator::updateChamberZones(double dt) {
+    const int cylinderCount = m_engine->getCylinderCount();
+    for (int i = 0; i < cylinderCount; ++i) {
+        const CombustionChamber *chamber = m_engine->getChamber(i);
+        const GasSystem *system = chamber->getSystem();
+        const CombustionChamber::FlameEvent &flame = chamber->getFlameEvent();
+        m_chamberZones.setCharge(
+            i,
+            system->pressure(),
+            system->temperature(),
+            system->volume(),
+            system->heatCapacityRatio(),
+            (flame.total_n > 0) ? flame.lit_n / flame.total_n : 0.0,
+            chamber->isLit());
+    }
+
+    m_chamberZones.evaluate(dt);
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        CombustionChamber *chamber = m_engine->getChamber(i);
+        chamber->setCreviceFraction(m_chamberZones.getCreviceFraction(i));
+
+        const double knock = m_chamberZones.getKnockIntensity(i);
+        if (knock > 0) {
+            chamber->autoignite(knock);
+        }
+    }
+}
+
+void PistonEngineSimulator::simulateFluidSubstep(double dt) {
+    // The flow graph's stages touch the shared plenums and collectors and
+    // sweep their joints serially in chamber order; each chamber's private
+    // state is only touched by its own stages, so the result doesn't depend
+    // on the thread count.
+    const int cylinderCount = m_engine->getCylinderCount();
+    m_flowGraph.sweep(FlowGraph::Stage::Intake, dt);
+
+    if (m_batchedFlowRates) {
+        simulateValveFlowBatched(dt);
+    }
+    else {
+        m_fluidThreadPool.parallelFor(cylinderCount, [this, dt](int j) {
+            m_engine->getChamber(j)->flowCylinder(dt);
+        });
+    }
+
+    m_flowGraph.sweep(FlowGraph::Stage::Exhaust, dt);
+
+    m_fluidThreadPool.parallelFor(cylinderCount, [this, dt](int j) {
+        m_engine->getChamber(j)->finishFlow(dt);
+    });
+}
+
+void PistonEngineSimulator::simulateValveFlowBatched(double dt) {
+    // The intake and exhaust valve connections of different chambers never
+    // share a gas system, so their flow rates are evaluated in one pass.
+    // Sealed chambers have no valve flow and stay out of the batch.
+    const int cylinderCount = m_engine->getCylinderCount();
+    GasSystem::FlowState *intakeValves = m_valveFlowStates;
+    GasSystem::FlowState *exhaustValves = m_valveFlowStates + cylinderCount;
+
+    m_fluidThreadPool.parallelFor(cylinderCount, [this, dt, intakeValves](int j) {
+        CombustionChamber *chamber = m_engine->getChamber(j);
+        if (chamber->isSealed()) {
+            chamber->flowSealedCylinder(dt);
+        }
+        else {
+            chamber->prepareIntakeValveFlow(dt, &intakeValves[j]);
+        }
+    });
+
+    m_valveFlowBatch.clear();
+    int slots = 0;
+    for (int j = 0; j < cylinderCount; ++j) {
+        if (m_engine->getChamber(j)->isSealed()) {
+            m_valveBatchSlots[j] = -1;
+        }
+        else {
+            m_valveBatchSlots[j] = slots++;
+            m_valveFlowBatch.add(intakeValves[j]);
+        }
+    }
+
+    if (slots == 0) return;
+
+    m_valveFlowBatch.evaluate();
+
+    m_fluidThreadPool.parallelFor(cylinderCount, [this, intakeValves, exhaustValves](int j) {
+        if (m_valveBatchSlots[j] < 0) return;
+        m_engine->getChamber(j)->applyIntakeValveFlow(
+            intakeValves[j], m_valveFlowBatch.getFlowRate(m_valveBatchSlots[j]), &exhaustValves[j]);
+    });
+
+    m_valveFlowBatch.clear();
+    for (int j = 0; j < cylinderCount; ++j) {
+        if (m_valveBatchSlots[j] >= 0) m_valveFlowBatch.add(exhaustValves[j]);
+    }
+
+    m_valveFlowBatch.evaluate();
+
+    m_fluidThreadPool.parallelFor(cylinderCount, [this, exhaustValves](int j) {
+        if (m_valveBatchSlots[j] < 0) return;
+        m_engine->getChamber(j)->applyExhaustValveFlow(
+            exhaustValves[j], m_valveFlowBatch.getFlowRate(m_valveBatchSlots[j]));
+    });
+}
+
+void PistonEngineSimulator::setRunnerCoarsening(int substeps) {
+    m_runnerCoarsening = std::max(1, substeps);
+    if (m_engine == nullptr) return;
+
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_engine->getChamber(i)->setRunnerCoarsening(m_runnerCoarsening);
+    }
+}
+
+void PistonEngineSimulator::setAdaptiveFluidSimulationSteps(bool enabled, int minSteps, int maxSteps) {
+    m_adaptiveFluidSimulationSteps = enabled;
+    m_minFluidSimulationSteps = std::max(1, minSteps);
+    m_maxFluidSimulationSteps = std::max(m_minFluidSimulationSteps, maxSteps);
+}
+
+int PistonEngineSimulator::estimateFluidSimulationSteps() const {
+    double signalTime = DBL_MAX;
+    double flowFraction = 0;
+    const int cylinderCount = m_engine->getCylinderCount();
+    for (int i = 0; i < cylinderCount; ++i) {
+        const CombustionChamber *chamber = m_engine->getChamber(i);
+        signalTime = std::fmin(signalTime, chamber->calculateRunnerSignalTime());
+        flowFraction = std::fmax(flowFraction, chamber->calculateLastTimestepFlowFraction());
+    }
+
+    const double maxSubstep = m_fluidCourantNumber * signalTime;
+    double steps = (maxSubstep > 0)
+        ? std::ceil(getTimestep() / maxSubstep)
+        : m_maxFluidSimulationSteps;
+    steps = std::fmax(steps, std::ceil(flowFraction / m_maxFluidFlowFraction));
+
+    return static_cast<int>(std::fmin(
+        std::fmax(steps, m_minFluidSimulationSteps),
+        m_maxFluidSimulationSteps));
+}
+
+void PistonEngineSimulator::updateFluidSimulationSteps() {
+    // Step up immediately but only back off one substep at a time so the
+    // count doesn't chatter between neighbouring values
+    const int estimate = shedFluidSimulationSteps(estimateFluidSimulationSteps());
+    if (estimate > m_fluidSimulationSteps) {
+        m_fluidSimulationSteps = estimate;
+    }
+    else if (estimate < m_fluidSimulationSteps) {
+        --m_fluidSimulationSteps;
+    }
+}
+
+void PistonEngineSimulator::setFluidThreadCount(int threads) {
+    m_fluidThreadPool.destroy();
+    if (threads > 1) {
+        m_fluidThreadPool.initialize(threads);
+    }
+}
+
 double PistonEngineSimulator::getTotalExhaustFlow() const {
     double totalFlow = 0.0;
     for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
@@ -329,84 +648,313 @@ double PistonEngineSimulator::getTotalExhaustFlow() const {
 }
 
 void PistonEngineSimulator::endFrame() {
+    flushSynthesizerInput();
     Simulator::endFrame();
 
     if (m_engine == nullptr) {
         return;
     }
 
-    const double frameTimestep = simulationSteps() * getTimestep();
+    // Replayed steps didn't flow; a fully replayed frame keeps the rates
+    const int liveSteps = simulationSteps() - getFrameReplayedSteps();
+    if (liveSteps <= 0) return;
+
+    const double frameTimestep = liveSteps * getTimestep();
     const int cylinderCount = m_engine->getCylinderCount();
     for (int i = 0; i < m_engine->getIntakeCount(); ++i) {
         m_engine->getIntake(i)->m_flowRate /= frameTimestep;
     }
 }
 
+void PistonEngineSimulator::setConstraintPruning(bool pruning) {
+    m_constraintPruning = pruning;
+}
+
+int PistonEngineSimulator::getPrunedConstraintCount() const {
+    int pruned = 0;
+    if ((m_solvedSubsystems & DynoSubsystem) == 0) ++pruned;
+    if ((m_solvedSubsystems & StarterSubsystem) == 0) ++pruned;
+
+    // The clutch and the drag
+    if ((m_solvedSubsystems & VehicleSubsystem) == 0) pruned += 2;
+
+    return pruned;
+}
+
+unsigned int PistonEngineSimulator::getSolvedSubsystems() const {
+    if (!m_constraintPruning) return AllSubsystems;
+
+    // A disabled dyno or starter and a disengaged clutch have no torque to
+    // give, so leaving them out solves the same system. A decoupled vehicle
+    // only drops out once drag has brought it to rest, as the solve is what
+    // slows it while it coasts.
+    unsigned int solved = 0;
+    if (m_dyno.m_enabled) solved |= DynoSubsystem;
+    if (m_starterMotor.m_enabled) solved |= StarterSubsystem;
+
+    const bool coupled = m_transmission->getGear() != -1 && m_transmission->getClutchPressure() > 0;
+    if (coupled || std::abs(m_vehicleMass.v_theta) > VehicleRestSpeed) {
+        solved |= VehicleSubsystem;
+    }
+
+    return solved;
+}
+
+void PistonEngineSimulator::registerSystem() {
+    const int crankCount = m_engine->getCrankshaftCount();
+    const int cylinderCount = m_engine->getCylinderCount();
+    Crankshaft *outputShaft = m_engine->getOutputCrankshaft();
+
+    for (int i = 0; i < crankCount; ++i) {
+        Crankshaft *crankshaft = m_engine->getCrankshaft(i);
+
+        m_system->addRigidBody(&crankshaft->m_body);
+        m_system->addConstraint(&m_crankConstraints[i]);
+        m_system->addConstraint(&m_crankshaftFrictionConstraints[i]);
+
+        if (crankshaft != outputShaft) {
+            m_system->addConstraint(&m_crankshaftLinks[i - 1]);
+        }
+    }
+
+    if (m_reducedKinematics) {
+        m_system->addForceGenerator(&m_crankSlider);
+    }
+
+    if ((m_solvedSubsystems & VehicleSubsystem) != 0) {
+        m_transmission->addToSystem(m_system, &m_vehicleMass, m_vehicle, m_engine);
+        m_system->addConstraint(&m_vehicleDrag);
+        m_system->addRigidBody(&m_vehicleMass);
+    }
+
+    // Each piston/rod/crank chain is registered as one contiguous run of
+    // bodies and constraints so a Gauss-Seidel sweep resolves the chain
+    // in order and its Jacobian rows stay adjacent; keep it that way
+    for (int i = 0; i < cylinderCount && !m_reducedKinematics; ++i) {
+        Piston *piston = m_engine->getPiston(i);
+
+        m_system->addRigidBody(&piston->m_body);
+        m_system->addRigidBody(&piston->getRod()->m_body);
+        m_system->addConstraint(m_cylinderConstraints.getLittleEnd(i));
+        m_system->addConstraint(m_cylinderConstraints.getBigEnd(i));
+        m_system->addConstraint(m_cylinderConstraints.getWall(i));
+    }
+
+    // Every piston's gas and friction force in one pass
+    if (!m_reducedKinematics) {
+        m_system->addForceGenerator(&m_chamberForces);
+    }
+
+    if ((m_solvedSubsystems & DynoSubsystem) != 0) m_system->addConstraint(&m_dyno);
+    if ((m_solvedSubsystems & StarterSubsystem) != 0) m_system->addConstraint(&m_starterMotor);
+}
+
+bool PistonEngineSimulator::updateSolvedSet() {
+    if (m_engine == nullptr || m_engine->getCrankshaftCount() <= 0) return false;
+
+    const unsigned int solved = getSolvedSubsystems();
+    if (solved == m_solvedSubsystems) return false;
+
+    // Bodies keep their own state, so a subsystem rejoins where it left
+    // off; the vehicle leaves at rest and rejoins at rest
+    if ((solved & VehicleSubsystem) == 0) m_vehicleMass.v_theta = 0;
+
+    m_solvedSubsystems = solved;
+    m_system->reset();
+    registerSystem();
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "solved_set dyno=%d starter=%d vehicle=%d",
+        (solved & DynoSubsystem) != 0 ? 1 : 0,
+        (solved & StarterSubsystem) != 0 ? 1 : 0,
+        (solved & VehicleSubsystem) != 0 ? 1 : 0);
+
+    return true;
+}
+
 void PistonEngineSimulator::destroy() {
+    m_fluidThreadPool.destroy();
+
     if (m_system != nullptr) m_system->reset();
 
-    if (m_crankConstraints != nullptr) delete[] m_crankConstraints;
-    if (m_cylinderWallConstraints != nullptr) delete[] m_cylinderWallConstraints;
-    if (m_linkConstraints != nullptr) delete[] m_linkConstraints;
-    if (m_crankshaftFrictionConstraints != nullptr) delete[] m_crankshaftFrictionConstraints;
-    if (m_exhaustFlowStagingBuffer != nullptr) delete[] m_exhaustFlowStagingBuffer;
     if (m_system != nullptr) delete m_system;
-    if (m_delayFilters != nullptr) delete[] m_delayFilters;
+    m_arena.destroy();
+    m_valveFlowBatch.destroy();
+    m_chamberZones.destroy();
+    m_flowGraph.destroy();
+    m_crankSlider.destroy();
+    m_cylinderConstraints.destroy();
+    m_chamberForces.destroy();
+    m_exhaustDelays.destroy();
 
     m_crankConstraints = nullptr;
-    m_cylinderWallConstraints = nullptr;
-    m_linkConstraints = nullptr;
     m_crankshaftFrictionConstraints = nullptr;
+    m_crankshaftLinks = nullptr;
     m_exhaustFlowStagingBuffer = nullptr;
+    m_stagedSynthesizerFrames = 0;
     m_system = nullptr;
 
     m_vehicle = nullptr;
     m_transmission = nullptr;
     m_engine = nullptr;
-    m_delayFilters = nullptr;
+    m_exhaustAudioRoutes = nullptr;
+    m_runnerPressures = nullptr;
+    m_runnerDynamicPressures = nullptr;
+    m_exhaustPulses = nullptr;
+    m_delayedExhaustPulses = nullptr;
+    m_valveFlowStates = nullptr;
+    m_valveBatchSlots = nullptr;
+    selectStepKernels();
+
+    // The synthesizer and the rest of the base's state
+    Simulator::destroy();
 }
 
 void PistonEngineSimulator::writeToSynthesizer() {
+    double *frame = m_exhaustFlowStagingBuffer
+        + (size_t)m_stagedSynthesizerFrames * m_engine->getExhaustSystemCount();
+    (this->*m_stepKernels->writeExhaustFrame)(frame);
+
+    processSynthesizerFrame(frame);
+
+    if (++m_stagedSynthesizerFrames == SynthesizerStagingFrames) {
+        flushSynthesizerInput();
+    }
+}
+
+void PistonEngineSimulator::writeSynthesizerFrame(const double *frame) {
     const int exhaustSystemCount = m_engine->getExhaustSystemCount();
+    std::copy(
+        frame,
+        frame + exhaustSystemCount,
+        m_exhaustFlowStagingBuffer + (size_t)m_stagedSynthesizerFrames * exhaustSystemCount);
+
+    if (++m_stagedSynthesizerFrames == SynthesizerStagingFrames) {
+        flushSynthesizerInput();
+    }
+}
+
+void PistonEngineSimulator::flushSynthesizerInput() {
+    if (m_stagedSynthesizerFrames == 0) return;
+
+    SynthesizerCapture *capture = getSynthesizerCapture();
+    if (capture != nullptr && capture->isRecording()) {
+        capture->write(m_exhaustFlowStagingBuffer, m_stagedSynthesizerFrames);
+    }
+
+    synthesizer().writeInput(m_exhaustFlowStagingBuffer, m_stagedSynthesizerFrames);
+    m_stagedSynthesizerFrames = 0;
+}
+
+void PistonEngineSimulator::setSpecializedStepKernels(bool specialized) {
+    m_specializedStepKernels = specialized;
+    selectStepKernels();
+}
+
+void PistonEngineSimulator::selectStepKernels() {
+    m_stepKernels = (m_specializedStepKernels && m_engine != nullptr)
+        ? &SelectStepKernels(m_engine->getCylinderCount(), m_engine->getExhaustSystemCount())
+        : &SelectStepKernels(0, 0);
+}
+
+template <int Cylinders>
+void PistonEngineSimulator::updateChambers(IgnitionModule *im, double dt) {
+    const int cylinderCount = (Cylinders > 0) ? Cylinders : m_engine->getCylinderCount();
+    for (int i = 0; i < cylinderCount; ++i) {
+        if (im->getIgnitionEvent(i)) {
+            m_engine->getChamber(i)->ignite();
+        }
+
+        m_engine->getChamber(i)->update(dt);
+    }
+}
+
+template <int Cylinders>
+void PistonEngineSimulator::resetChamberFlows() {
+    const int cylinderCount = (Cylinders > 0) ? Cylinders : m_engine->getCylinderCount();
+    for (int i = 0; i < cylinderCount; ++i) {
+        m_engine->getChamber(i)->resetLastTimestepExhaustFlow();
+        m_engine->getChamber(i)->resetLastTimestepIntakeFlow();
+    }
+}
+
+template <int Cylinders, int Exhausts>
+void PistonEngineSimulator::writeExhaustFrame(double *frame) {
+    const int cylinderCount = (Cylinders > 0) ? Cylinders : m_engine->getCylinderCount();
+    const int exhaustSystemCount = (Exhausts > 0) ? Exhausts : m_engine->getExhaustSystemCount();
     for (int i = 0; i < exhaustSystemCount; ++i) {
-        m_exhaustFlowStagingBuffer[i] = 0;
+        frame[i] = 0;
     }
 
     const double attenuation = std::min(std::abs(filteredEngineSpeed()), 40.0) / 40.0;
     const double attenuation_3 = attenuation * attenuation * attenuation;
 
-    static double lastValveLift[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < cylinderCount; ++i) {
+        const GasSystem *runner = m_exhaustAudioRoutes[i].runner;
+        m_runnerPressures[i] = runner->pressure();
+        m_runnerDynamicPressures[i] = runner->axialDynamicPressure(1.0, 0.0);
+    }
 
-    const double timestep = getTimestep();
-    const int cylinderCount = m_engine->getCylinderCount();
+    const double atmosphericPressure = units::pressure(1.0, units::atm);
+    const double pulseGain = attenuation_3 * 1600;
     for (int i = 0; i < cylinderCount; ++i) {
-        Piston *piston = m_engine->getPiston(i);
-        CylinderBank *bank = piston->getCylinderBank();
-        CylinderHead *head = m_engine->getHead(bank->getIndex());
-        ExhaustSystem *exhaust = head->getExhaustSystem(piston->getCylinderIndex());
-        CombustionChamber *chamber = m_engine->getChamber(i);
+        m_exhaustPulses[i] = pulseGain * (
+            (m_runnerPressures[i] - atmosphericPressure)
+            + 0.1 * m_runnerDynamicPressures[i]);
+    }
 
-        const double exhaustLength =
-            head->getHeaderPrimaryLength(piston->getCylinderIndex())
-            + exhaust->getLength();
+    m_exhaustDelays.process(m_exhaustPulses, m_delayedExhaustPulses);
 
-        double exhaustFlow =
-            attenuation_3 * 1600 * (
-                1.0 * (chamber->m_exhaustRunnerAndPrimary.pressure() - units::pressure(1.0, units::atm))
-                + 0.1 * chamber->m_exhaustRunnerAndPrimary.dynamicPressure(1.0, 0.0)
-                + 0.1 * chamber->m_exhaustRunnerAndPrimary.dynamicPressure(-1.0, 0.0));
+    for (int i = 0; i < cylinderCount; ++i) {
+        const ExhaustAudioRoute &route = m_exhaustAudioRoutes[i];
+        frame[route.exhaust] += route.gain * m_delayedExhaustPulses[i];
+    }
 
-        lastValveLift[i] = head->exhaustValveLift(piston->getCylinderIndex());
+    for (int i = 0; i < exhaustSystemCount; ++i) {
+        frame[i] *= m_engine->getExhaustSystem(i)->getAudioVolume();
+    }
+}
 
-        const double delayedExhaustPulse =
-            m_delayFilters[i].fast_f(exhaustFlow);
+template <int Cylinders, int Exhausts>
+constexpr PistonEngineSimulator::StepKernels PistonEngineSimulator::MakeStepKernels() {
+    return {
+        Cylinders,
+        Exhausts,
+        &PistonEngineSimulator::updateChambers<Cylinders>,
+        &PistonEngineSimulator::resetChamberFlows<Cylinders>,
+        &PistonEngineSimulator::writeExhaustFrame<Cylinders, Exhausts>
+    };
+}
 
-        ExhaustSystem *exhaustSystem = head->getExhaustSystem(piston->getCylinderIndex());
-        m_exhaustFlowStagingBuffer[exhaustSystem->getIndex()] +=
-            head->getSoundAttenuation(piston->getCylinderIndex())
-            * (exhaustSystem->getAudioVolume() * delayedExhaustPulse / cylinderCount)
-            * (1 / (exhaustLength * exhaustLength));
+const PistonEngineSimulator::StepKernels &PistonEngineSimulator::SelectStepKernels(
+    int cylinders,
+    int exhausts)
+{
+    // The layouts of the engines shipped in assets/ and the usual ones
+    // beside them; anything else loops dynamically
+    static const StepKernels Dynamic = MakeStepKernels<0, 0>();
+    static const StepKernels Specialized[] = {
+        MakeStepKernels<1, 1>(),
+        MakeStepKernels<2, 1>(),
+        MakeStepKernels<2, 2>(),
+        MakeStepKernels<3, 1>(),
+        MakeStepKernels<4, 1>(),
+        MakeStepKernels<4, 2>(),
+        MakeStepKernels<5, 1>(),
+        MakeStepKernels<6, 1>(),
+        MakeStepKernels<6, 2>(),
+        MakeStepKernels<8, 1>(),
+        MakeStepKernels<8, 2>(),
+        MakeStepKernels<9, 1>(),
+        MakeStepKernels<10, 2>(),
+        MakeStepKernels<12, 1>(),
+        MakeStepKernels<12, 2>()
+    };
+
+    for (const StepKernels &kernels : Specialized) {
+        if (kernels.cylinders == cylinders && kernels.exhausts == exhausts) return kernels;
     }
 
-    synthesizer().writeInput(m_exhaustFlowStagingBuffer);
+    return Dynamic;
 }
@@ -12,17 +12,32 @@ PistonObject::~PistonObject() {
     /* void */
 }
 
-void PistonObject::generateGeometry() {
+void PistonObject::generateStaticGeometry() {
     GeometryGenerator *gen = m_app->getGeometryGenerator();
+    PartInstancer *instancer = m_app->getPartInstancer();
 
     GeometryGenerator::Circle2dParameters circleParams;
     circleParams.center_x = 0.0f;
     circleParams.center_y = (float)m_piston->getWristPinLocation();
-    circleParams.maxEdgeLength = m_app->pixelsToUnits(5.0f);
+    circleParams.maxEdgeLength = m_app->viewPixelsToUnits(5.0f);
     circleParams.radius = (float)(m_piston->getCylinderBank()->getBore() / 10) * 0.75f;
+
+    PartInstancer::MeshKey key;
+    key.part = PartInstancer::Part::WristPinHole;
+    key.parameters[0] = circleParams.center_y;
+    key.parameters[1] = circleParams.radius;
+    key.parameters[2] = circleParams.maxEdgeLength;
+
+    const GeometryGenerator::GeometryIndices *mesh = instancer->findMesh(key);
+    if (mesh != nullptr) {
+        m_wristPinHole = *mesh;
+        return;
+    }
+
     gen->startShape();
     gen->generateCircle2d(circleParams);
     gen->endShape(&m_wristPinHole);
+    instancer->addMesh(key, m_wristPinHole);
 }
 
 void PistonObject::render(const ViewParameters *view) {
@@ -45,9 +60,16 @@ void PistonObject::render(const ViewParameters *view) {
         m_app->getAssetManager()->GetModelAsset("Piston"),
         0x32 - layer);
 
-    setTransform(&m_piston->m_body);
-    m_app->getShaders()->SetBaseColor(holeCol);
-    m_app->drawGenerated(m_wristPinHole, 0x32 - layer);
+    m_app->getPartInstancer()->addInstance(
+        m_wristPinHole, bodyTransform(&m_piston->m_body), holeCol, 0x32 - layer);
+}
+
+bool PistonObject::getWorldBounds(Bounds *bounds) const {
+    *bounds = boundsAround(
+        m_piston->m_body.p_x,
+        m_piston->m_body.p_y,
+        m_piston->getCylinderBank()->getBore() + m_piston->getCompressionHeight());
+    return true;
 }
 
 void PistonObject::process(float dt) {
@@ -0,0 +1,211 @@
+#include "../include/plugin_processor.h"
+
+#include "../include/denormals.h"
+#include "../include/engine.h"
+#include "../include/simulator.h"
+#include "../include/transmission.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+namespace {
+struct ParameterInfo {
+    const char *name;
+    double minimum;
+    double maximum;
+    double initial;
+};
+
+const ParameterInfo ParameterInfos[] = {
+    { "throttle", 0.0, 1.0, 0.0 },
+    { "clutch", 0.0, 1.0, 1.0 },
+    { "gear", -1.0, 10.0, -1.0 },
+    { "ignition", 0.0, 1.0, 1.0 },
+    { "starter", 0.0, 1.0, 0.0 },
+    { "dyno_enabled", 0.0, 1.0, 0.0 },
+    { "dyno_rpm", 0.0, 20000.0, 3000.0 }
+};
+
+static_assert(
+    sizeof(ParameterInfos) / sizeof(ParameterInfos[0]) == PluginProcessor::ParameterCount,
+    "every parameter needs a description");
+} /* namespace */
+
+PluginProcessor::PluginProcessor() {
+    m_simulator = nullptr;
+    m_sampleRate = 0.0;
+    m_frameSize = 0;
+    m_latency = 0;
+    m_physicsPosition = 0;
+    m_outputPosition = 0;
+    m_pendingTime = 0.0;
+    m_events = nullptr;
+    m_eventCapacity = 0;
+    m_eventStart = 0;
+    m_eventCount = 0;
+    m_underruns = 0;
+    m_droppedEvents = 0;
+
+    for (int i = 0; i < ParameterCount; ++i) {
+        m_values[i] = ParameterInfos[i].initial;
+    }
+}
+
+PluginProcessor::~PluginProcessor() {
+    assert(m_events == nullptr);
+}
+
+void PluginProcessor::initialize(Simulator *simulator, const Parameters &params) {
+    m_simulator = simulator;
+    m_sampleRate = simulator->getAudioSampleRate();
+    m_frameSize = std::max(1, params.frameSize);
+    m_latency = m_frameSize + std::max(0, params.safetyFrames);
+    m_physicsPosition = 0;
+    m_outputPosition = 0;
+    m_pendingTime = 0.0;
+    m_underruns = 0;
+    m_droppedEvents = 0;
+
+    m_eventCapacity = std::max(1, params.eventCapacity);
+    m_events = new PendingEvent[m_eventCapacity];
+    m_eventStart = 0;
+    m_eventCount = 0;
+
+    // Every step follows the host's clock exactly instead of the latency
+    // target, and the output ring is allowed to fill
+    simulator->setOfflineMode(true);
+}
+
+void PluginProcessor::destroy() {
+    delete[] m_events;
+    m_events = nullptr;
+    m_eventCapacity = 0;
+    m_eventCount = 0;
+
+    m_simulator = nullptr;
+}
+
+void PluginProcessor::setParameter(Parameter parameter, double value) {
+    const ParameterInfo &info = ParameterInfos[static_cast<int>(parameter)];
+    m_values[static_cast<int>(parameter)] = std::clamp(value, info.minimum, info.maximum);
+}
+
+double PluginProcessor::getParameter(Parameter parameter) const {
+    return m_values[static_cast<int>(parameter)];
+}
+
+const char *PluginProcessor::GetParameterName(Parameter parameter) {
+    return ParameterInfos[static_cast<int>(parameter)].name;
+}
+
+void PluginProcessor::GetParameterRange(
+    Parameter parameter,
+    double *minimum,
+    double *maximum,
+    double *initial)
+{
+    const ParameterInfo &info = ParameterInfos[static_cast<int>(parameter)];
+    *minimum = info.minimum;
+    *maximum = info.maximum;
+    *initial = info.initial;
+}
+
+void PluginProcessor::process(const Event *events, int eventCount, float *output, int frames) {
+    DenormalScope denormals;
+
+    for (int i = 0; i < eventCount; ++i) {
+        if (m_eventCount == m_eventCapacity) {
+            ++m_droppedEvents;
+            continue;
+        }
+
+        PendingEvent &pending = m_events[(m_eventStart + m_eventCount++) % m_eventCapacity];
+        pending.position = m_outputPosition + events[i].offset + m_latency;
+        pending.parameter = events[i].parameter;
+        pending.value = events[i].value;
+    }
+
+    // Whole frames only; the events past the last one wait for the next call
+    const long long target =
+        ((m_outputPosition + frames + m_latency) / m_frameSize) * m_frameSize;
+    while (m_physicsPosition < target) {
+        simulateFrame(m_physicsPosition + m_frameSize);
+    }
+
+    int read = m_simulator->readAudioOutput(frames, output);
+    if (read < frames) {
+        read += m_simulator->synthesizer().concealOutput(frames - read, output + read);
+        std::fill(output + read, output + frames, 0.0f);
+        ++m_underruns;
+    }
+
+    m_outputPosition += frames;
+}
+
+void PluginProcessor::simulateFrame(long long end) {
+    while (m_physicsPosition < end) {
+        while (m_eventCount > 0 && m_events[m_eventStart].position <= m_physicsPosition) {
+            const PendingEvent &pending = m_events[m_eventStart];
+            setParameter(pending.parameter, pending.value);
+            m_eventStart = (m_eventStart + 1) % m_eventCapacity;
+            --m_eventCount;
+        }
+
+        applyParameters();
+
+        const long long next = (m_eventCount > 0)
+            ? std::min(end, m_events[m_eventStart].position)
+            : end;
+        advance(static_cast<int>(next - m_physicsPosition));
+        m_physicsPosition = next;
+    }
+
+    m_simulator->synthesizer().renderPendingAudio();
+}
+
+void PluginProcessor::applyParameters() {
+    Engine *engine = m_simulator->getEngine();
+    engine->setSpeedControl(m_values[static_cast<int>(Parameter::Throttle)]);
+    engine->getIgnitionModule()->m_enabled = m_values[static_cast<int>(Parameter::Ignition)] > 0.5;
+
+    const bool dyno = m_values[static_cast<int>(Parameter::DynoEnabled)] > 0.5;
+    m_simulator->m_starterMotor.m_enabled = m_values[static_cast<int>(Parameter::Starter)] > 0.5;
+    m_simulator->m_dyno.m_enabled = dyno;
+    m_simulator->m_dyno.m_hold = dyno;
+    m_simulator->m_dyno.m_rotationSpeed = std::clamp(
+        units::rpm(m_values[static_cast<int>(Parameter::DynoSpeed)]),
+        engine->getDynoMinSpeed(),
+        engine->getDynoMaxSpeed());
+
+    Transmission *transmission = m_simulator->getTransmission();
+    if (transmission != nullptr) {
+        const int gear = std::min(
+            static_cast<int>(std::lround(m_values[static_cast<int>(Parameter::Gear)])),
+            transmission->getGearCount() - 1);
+        if (transmission->getGear() != gear) {
+            transmission->changeGear(gear);
+        }
+
+        transmission->setClutchPressure(m_values[static_cast<int>(Parameter::Clutch)]);
+    }
+}
+
+void PluginProcessor::advance(int frames) {
+    if (frames <= 0) return;
+
+    // Whole steps only, so a short piece between two close events neither
+    // rounds up into extra physics nor loses its fraction of a step
+    const double timestep = m_simulator->getTimestep();
+    m_pendingTime += frames / m_sampleRate;
+
+    const int steps = static_cast<int>(std::floor(m_pendingTime / timestep));
+    if (steps <= 0) return;
+
+    m_pendingTime -= steps * timestep;
+
+    m_simulator->startFrame(steps * timestep / m_simulator->getSimulationSpeed());
+    while (m_simulator->simulateStep()) { /* void */ }
+    m_simulator->endFrame();
+}
@@ -0,0 +1,198 @@
+#include "../include/polyphase_resampler.h"
+
+#include "../include/constants.h"
+#include "../include/utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// With a Blackman window the transition band is about 5.5 / taps wide and
+// centered on the cutoff, so this keeps the stopband above Nyquist for 32 taps
+constexpr double MaxNormalizedCutoff = 0.41;
+
+double blackman(double u) {
+    if (std::abs(u) >= 1.0) return 0.0;
+    return 0.42 + 0.5 * std::cos(constants::pi * u) + 0.08 * std::cos(2 * constants::pi * u);
+}
+
+double sinc(double x) {
+    if (std::abs(x) < 1e-12) return 1.0;
+    return std::sin(constants::pi * x) / (constants::pi * x);
+}
+} /* namespace */
+
+PolyphaseResampler::PolyphaseResampler() {
+    m_tables = nullptr;
+    m_table = nullptr;
+    m_tableCount = 0;
+    m_nextTable = 0;
+
+    m_history = nullptr;
+    m_historyOffset = 0;
+
+    m_kernel = nullptr;
+
+    m_channelCount = 0;
+    m_taps = 0;
+    m_phases = 0;
+
+    m_phase = 1.0;
+    m_step = 1.0;
+}
+
+PolyphaseResampler::~PolyphaseResampler() {
+    assert(m_tables == nullptr);
+    assert(m_history == nullptr);
+    assert(m_kernel == nullptr);
+}
+
+void PolyphaseResampler::initialize(int channels, int taps, int phases, int tableCount) {
+    assert(taps > 0 && taps % 2 == 0);
+
+    destroy();
+
+    m_channelCount = std::max(0, channels);
+    m_taps = taps;
+    m_phases = std::max(1, phases);
+    m_tableCount = std::max(1, tableCount);
+    m_nextTable = 0;
+
+    m_tables = new Table[m_tableCount];
+    for (int i = 0; i < m_tableCount; ++i) {
+        m_tables[i].coefficients = new float[(size_t)(m_phases + 1) * m_taps];
+    }
+
+    m_history = new float[(size_t)m_channelCount * 2 * m_taps];
+    std::memset(m_history, 0, sizeof(float) * (size_t)m_channelCount * 2 * m_taps);
+    m_historyOffset = 0;
+
+    m_kernel = new float[m_taps];
+
+    m_phase = 1.0;
+    m_step = 1.0;
+    m_table = nullptr;
+    setRates(1.0, 1.0, 0.5);
+}
+
+void PolyphaseResampler::destroy() {
+    if (m_tables != nullptr) {
+        for (int i = 0; i < m_tableCount; ++i) {
+            delete[] m_tables[i].coefficients;
+        }
+    }
+
+    delete[] m_tables;
+    delete[] m_history;
+    delete[] m_kernel;
+
+    m_tables = nullptr;
+    m_table = nullptr;
+    m_history = nullptr;
+    m_kernel = nullptr;
+    m_tableCount = 0;
+    m_channelCount = 0;
+}
+
+void PolyphaseResampler::setRates(double inputRate, double outputRate, double cutoff) {
+    if (m_tables == nullptr || inputRate <= 0 || outputRate <= 0) return;
+
+    m_step = inputRate / outputRate;
+
+    const double normalizedCutoff = std::min(
+        cutoff / inputRate,
+        MaxNormalizedCutoff * std::min(1.0, outputRate / inputRate));
+
+    for (int i = 0; i < m_tableCount; ++i) {
+        if (std::abs(m_tables[i].cutoff - normalizedCutoff) < 1e-9) {
+            m_table = &m_tables[i];
+            return;
+        }
+    }
+
+    m_table = &m_tables[m_nextTable];
+    m_nextTable = (m_nextTable + 1) % m_tableCount;
+    computeTable(m_table, normalizedCutoff);
+}
+
+void PolyphaseResampler::push(const double *frame) {
+    const int taps = m_taps;
+    m_historyOffset = (m_historyOffset == 0) ? taps - 1 : m_historyOffset - 1;
+    for (int i = 0; i < m_channelCount; ++i) {
+        float *history = m_history + (size_t)i * 2 * taps;
+        history[m_historyOffset] = static_cast<float>(frame[i]);
+        history[m_historyOffset + taps] = static_cast<float>(frame[i]);
+    }
+
+    m_phase -= 1.0;
+}
+
+int PolyphaseResampler::generate(float *const *output, int maxSamples) {
+    const int taps = m_taps;
+
+    int n = 0;
+    for (; n < maxSamples && m_phase < 1.0; ++n) {
+        const double p = std::max(0.0, m_phase) * m_phases;
+        const int j = std::min((int)p, m_phases - 1);
+        const float a = static_cast<float>(p - j);
+
+        // The interpolated kernel is shared by every channel
+        const float *c0 = m_table->coefficients + (size_t)j * taps;
+        const float *c1 = c0 + taps;
+        for (int k = 0; k < taps; ++k) {
+            m_kernel[k] = c0[k] + a * (c1[k] - c0[k]);
+        }
+
+        for (int i = 0; i < m_channelCount; ++i) {
+            const float *window = m_history + (size_t)i * 2 * taps + m_historyOffset;
+            output[i][n] = dotProduct(m_kernel, window, taps);
+        }
+
+        m_phase += m_step;
+    }
+
+    return n;
+}
+
+int PolyphaseResampler::discard() {
+    if (m_phase >= 1.0) return 0;
+
+    int n = (int)std::ceil((1.0 - m_phase) / m_step);
+    m_phase += n * m_step;
+    while (m_phase < 1.0) {
+        m_phase += m_step;
+        ++n;
+    }
+
+    return n;
+}
+
+void PolyphaseResampler::computeTable(Table *table, double cutoff) {
+    const int taps = m_taps;
+    const int half = taps / 2;
+
+    // Row j puts the output j / phases of an input sample past the center;
+    // tap k is the sample k steps older than the newest
+    for (int j = 0; j <= m_phases; ++j) {
+        float *row = table->coefficients + (size_t)j * taps;
+        const double frac = (double)j / m_phases;
+
+        double sum = 0.0;
+        for (int k = 0; k < taps; ++k) {
+            const double x = k - half + frac;
+            const double h = 2 * cutoff * sinc(2 * cutoff * x) * blackman(x / half);
+            row[k] = static_cast<float>(h);
+            sum += h;
+        }
+
+        // Unity DC gain at every phase so a constant input stays constant
+        const float scale = (sum != 0.0) ? static_cast<float>(1.0 / sum) : 0.0f;
+        for (int k = 0; k < taps; ++k) {
+            row[k] *= scale;
+        }
+    }
+
+    table->cutoff = cutoff;
+}
@@ -0,0 +1,176 @@
+#include "../include/realtime_stepper.h"
+
+#include "../include/debug_trace.h"
+#include "../include/denormals.h"
+#include "../include/simulator.h"
+#include "../include/thread_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+int bucketIndex(uint64_t nanoseconds) {
+    int i = 0;
+    while (nanoseconds > 0 && i < RealtimeStepper::BucketCount - 1) {
+        nanoseconds >>= 1;
+        ++i;
+    }
+
+    return i;
+}
+} /* namespace */
+
+double RealtimeStepper::Statistics::percentileLatenessMicroseconds(double p) const {
+    if (steps == 0) return 0.0;
+
+    const double target = p * steps;
+    uint64_t seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return static_cast<double>(1ull << i) / 1000.0;
+        }
+    }
+
+    return static_cast<double>(1ull << (BucketCount - 1)) / 1000.0;
+}
+
+RealtimeStepper::RealtimeStepper() {
+    m_run = false;
+}
+
+RealtimeStepper::~RealtimeStepper() {
+    /* void */
+}
+
+void RealtimeStepper::initialize(const Parameters &params) {
+    m_parameters = params;
+}
+
+void RealtimeStepper::destroy() {
+    m_parameters = Parameters();
+}
+
+RealtimeStepper::Statistics RealtimeStepper::run(Simulator *simulator, double duration) {
+    Statistics stats;
+    if (simulator == nullptr || simulator->getEngine() == nullptr) {
+        return stats;
+    }
+
+    const double period = simulator->getTimestep() / simulator->getSimulationSpeed();
+    const int stepsPerFrame = (m_parameters.stepsPerFrame > 0)
+        ? m_parameters.stepsPerFrame
+        : std::max(1, static_cast<int>(std::lround(1E-3 / period)));
+    const int ioInterval = std::max(1, m_parameters.ioInterval);
+    const double resyncLateness = std::max(1.0, m_parameters.resyncPeriods) * period;
+
+    ThreadPolicy::ApplyToCurrentThread(ThreadPolicy::Role::Physics, period * stepsPerFrame);
+    DenormalScope denormals;
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "realtime_stepper begin period_us=%.3f steps_per_frame=%d io_interval=%d duration=%.3f",
+        period * 1E6,
+        stepsPerFrame,
+        ioInterval,
+        duration);
+
+    // Deadlines are computed from the anchor rather than accumulated, so
+    // a period that isn't a whole number of clock ticks doesn't drift
+    auto deadlineOf = [period](Clock::time_point anchor, long long n) {
+        return anchor + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(n * period));
+    };
+
+    m_run = true;
+    const Clock::time_point t0 = Clock::now();
+    const Clock::time_point end = t0
+        + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+
+    Clock::time_point anchor = t0;
+    long long sinceAnchor = 0;
+    long long step = 0;
+    bool done = false;
+    while (!done) {
+        simulator->startFrameSteps(stepsPerFrame);
+
+        for (int i = 0; i < stepsPerFrame; ++i) {
+            const Clock::time_point deadline = deadlineOf(anchor, sinceAnchor);
+            waitUntil(deadline);
+
+            const Clock::time_point start = Clock::now();
+            Clock::duration lateness = start - deadline;
+            const double latenessSeconds = std::chrono::duration<double>(lateness).count();
+            if (latenessSeconds > resyncLateness) {
+                stats.skippedSteps += static_cast<long long>(latenessSeconds / period);
+                ++stats.resyncs;
+
+                anchor = start;
+                sinceAnchor = 0;
+                lateness = Clock::duration::zero();
+            }
+
+            record(&stats, lateness);
+
+            const bool io = (step % ioInterval) == 0;
+            if (io && m_parameters.input) m_parameters.input(simulator, step);
+            simulator->simulateStep();
+            if (io && m_parameters.output) m_parameters.output(simulator, step);
+
+            ++step;
+            ++sinceAnchor;
+            if (Clock::now() > deadlineOf(anchor, sinceAnchor)) {
+                ++stats.missedDeadlines;
+            }
+
+            if (!m_run || start >= end) {
+                done = true;
+                break;
+            }
+        }
+
+        simulator->endFrame();
+        ++stats.frames;
+
+        if (m_parameters.frame && m_parameters.frame(simulator)) done = true;
+    }
+
+    stats.steps = step;
+    stats.wallTime = std::chrono::duration<double>(Clock::now() - t0).count();
+    m_run = false;
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "realtime_stepper complete steps=%lld missed=%lld skipped=%lld resyncs=%lld mean_lateness_us=%.2f max_lateness_us=%.2f",
+        stats.steps,
+        stats.missedDeadlines,
+        stats.skippedSteps,
+        stats.resyncs,
+        stats.averageLatenessMicroseconds(),
+        stats.maxLatenessMicroseconds);
+
+    return stats;
+}
+
+void RealtimeStepper::waitUntil(Clock::time_point deadline) const {
+    const Clock::duration spin = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(m_parameters.spinTime));
+    if (deadline - Clock::now() > spin) {
+        std::this_thread::sleep_until(deadline - spin);
+    }
+
+    while (Clock::now() < deadline) {
+        /* void */
+    }
+}
+
+void RealtimeStepper::record(Statistics *statistics, Clock::duration lateness) {
+    const long long nanoseconds = std::max<long long>(
+        0, std::chrono::duration_cast<std::chrono::nanoseconds>(lateness).count());
+    const double microseconds = nanoseconds / 1000.0;
+
+    ++statistics->buckets[bucketIndex(static_cast<uint64_t>(nanoseconds))];
+    statistics->totalLatenessMicroseconds += microseconds;
+    statistics->maxLatenessMicroseconds = std::max(statistics->maxLatenessMicroseconds, microseconds);
+}
@@ -0,0 +1,126 @@
+#include "../include/render_scheduler.h"
+
+#include <algorithm>
+
+RenderScheduler::RenderScheduler() {
+    m_mode = Mode::Full;
+    m_enabled = true;
+    m_behind = false;
+    m_steppingSimulation = true;
+    m_paused = false;
+    m_redrawRequested = false;
+    m_redraw = true;
+}
+
+RenderScheduler::~RenderScheduler() {
+    /* void */
+}
+
+void RenderScheduler::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_mode = Mode::Full;
+    m_behind = false;
+    m_redrawRequested = false;
+}
+
+void RenderScheduler::setPaused(bool paused) {
+    m_paused = paused;
+    m_redrawRequested = true;
+}
+
+RenderScheduler::Mode RenderScheduler::update(
+    bool focused,
+    bool visible,
+    double latency,
+    double targetLatency)
+{
+    if (targetLatency > 0) {
+        if (!m_behind && latency < targetLatency * m_parameters.behindLatency) {
+            m_behind = true;
+        }
+        else if (m_behind && latency >= targetLatency * m_parameters.recoveredLatency) {
+            m_behind = false;
+        }
+    }
+
+    if (m_paused) m_mode = visible ? Mode::Paused : Mode::Hidden;
+    else if (!m_enabled) m_mode = Mode::Full;
+    else if (!visible) m_mode = Mode::Hidden;
+    else if (m_behind) m_mode = Mode::PhysicsBehind;
+    else if (!focused) m_mode = Mode::Unfocused;
+    else m_mode = Mode::Full;
+
+    return m_mode;
+}
+
+bool RenderScheduler::shouldRender() const {
+    switch (m_mode) {
+        case Mode::Hidden: return false;
+        case Mode::Paused: return m_redraw;
+        default: return true;
+    }
+}
+
+bool RenderScheduler::takeUiUpdate(Clock::time_point now) {
+    if (m_mode == Mode::Hidden) return false;
+    if (m_mode == Mode::Paused) {
+        const auto interval = std::chrono::duration<double>(m_parameters.pausedRedrawInterval);
+        m_redraw = m_redrawRequested || now - m_lastUiUpdate >= interval;
+        if (!m_redraw) return false;
+
+        m_redrawRequested = false;
+    }
+    if (m_mode == Mode::PhysicsBehind && m_parameters.physicsBehindFramerate > 0) {
+        const auto interval = std::chrono::duration<double>(1.0 / m_parameters.physicsBehindFramerate);
+        if (now - m_lastUiUpdate < interval) return false;
+    }
+
+    m_lastUiUpdate = now;
+    return true;
+}
+
+RenderScheduler::Clock::duration RenderScheduler::getFrameInterval() const {
+    double framerate = 0.0;
+    switch (m_mode) {
+        case Mode::Full: return Clock::duration::zero();
+        case Mode::Unfocused: framerate = m_parameters.unfocusedFramerate; break;
+        case Mode::PhysicsBehind:
+            // Idling would only take time away from the steps
+            if (m_steppingSimulation) return Clock::duration::zero();
+            framerate = m_parameters.physicsBehindFramerate;
+            break;
+        case Mode::Hidden: framerate = m_parameters.hiddenFramerate; break;
+        case Mode::Paused: framerate = m_parameters.pausedFramerate; break;
+    }
+
+    // Nothing is stepped while paused that the frame would have to cover
+    if (framerate <= 0) return Clock::duration::zero();
+    if (m_steppingSimulation && !m_paused) framerate = std::max(framerate, SteppingFramerate);
+
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / framerate));
+}
+
+RenderScheduler::Clock::duration RenderScheduler::getIdleTime(
+    Clock::time_point frameStart,
+    Clock::time_point now) const
+{
+    const Clock::duration interval = getFrameInterval();
+    if (interval == Clock::duration::zero()) return Clock::duration::zero();
+
+    const Clock::duration elapsed = now - frameStart;
+    return (elapsed < interval)
+        ? interval - elapsed
+        : Clock::duration::zero();
+}
+
+const char *RenderScheduler::GetModeName(Mode mode) {
+    switch (mode) {
+        case Mode::Full: return "full";
+        case Mode::Unfocused: return "unfocused";
+        case Mode::PhysicsBehind: return "physics_behind";
+        case Mode::Hidden: return "hidden";
+        case Mode::Paused: return "paused";
+        default: return "unknown";
+    }
+}
@@ -167,8 +167,7 @@ void RightGaugeCluster::destroy() {
 void RightGaugeCluster::update(float dt) {
     m_combusionChamberStatus->m_engine = m_engine;
     m_throttleDisplay->m_engine = m_engine;
-    m_afrCluster->m_engine = m_engine;
-    m_fuelCluster->m_engine = m_engine;
+    m_afrCluster->m_simulator = m_simulator;
     m_fuelCluster->m_simulator = m_simulator;
 
     UiElement::update(dt);
@@ -177,25 +176,39 @@ void RightGaugeCluster::update(float dt) {
 void RightGaugeCluster::render() {
     drawFrame(m_bounds, 1.0, m_app->getForegroundColor(), m_app->getBackgroundColor());
 
+    renderTachSpeedCluster();
+    renderFuelAirCluster();
+
+    UiElement::render();
+}
+
+void RightGaugeCluster::layout() {
     const Bounds tachSpeedCluster = m_bounds.verticalSplit(0.5f, 1.0f);
-    renderTachSpeedCluster(tachSpeedCluster);
+    const Bounds tachSpeedLeft = tachSpeedCluster.horizontalSplit(0.0f, 0.5f);
+    m_tachometer->m_bounds = tachSpeedLeft.verticalSplit(0.5f, 1.0f);
+    m_speedometer->m_bounds = tachSpeedLeft.verticalSplit(0.0f, 0.5f);
+    m_combusionChamberStatus->m_bounds = tachSpeedCluster.horizontalSplit(0.5f, 1.0f);
 
     const Bounds fuelAirCluster = m_bounds.verticalSplit(0.0f, 0.5f);
-    renderFuelAirCluster(fuelAirCluster);
+    const Bounds fuelAirLeft = fuelAirCluster.horizontalSplit(0.0f, 0.5f);
+    const Bounds fuelAirRight = fuelAirCluster.horizontalSplit(0.5f, 1.0f);
+    m_throttleDisplay->m_bounds = fuelAirLeft.verticalSplit(0.5f, 1.0f);
 
-    UiElement::render();
+    const Bounds fuelSection = fuelAirLeft.verticalSplit(0.0f, 0.5f);
+    m_afrCluster->m_bounds = fuelSection.horizontalSplit(0.0f, 0.5f);
+    m_fuelCluster->m_bounds = fuelSection.horizontalSplit(0.5f, 1.0f);
+
+    Grid grid = { 1, 3 };
+    m_manifoldVacuumGauge->m_bounds = grid.get(fuelAirRight, 0, 0, 1, 1);
+    m_intakeCfmGauge->m_bounds = grid.get(fuelAirRight, 0, 1, 1, 1);
+    m_volumetricEffGauge->m_bounds = grid.get(fuelAirRight, 0, 2, 1, 1);
 }
 
 void RightGaugeCluster::setEngine(Engine *engine) {
     m_engine = engine;
 }
 
-void RightGaugeCluster::renderTachSpeedCluster(const Bounds &bounds) {
-    const Bounds left = bounds.horizontalSplit(0.0f, 0.5f);
-    const Bounds right = bounds.horizontalSplit(0.5f, 1.0f);
-
-    const Bounds tach = left.verticalSplit(0.5f, 1.0f);
-    m_tachometer->m_bounds = tach;
+void RightGaugeCluster::renderTachSpeedCluster() {
     m_tachometer->m_gauge->m_value = (float)std::abs(getRpm());
 
     constexpr float shortenAngle = (float)units::angle(1.0, units::deg);
@@ -214,38 +227,15 @@ void RightGaugeCluster::renderTachSpeedCluster(const Bounds &bounds) {
     m_tachometer->m_gauge->setBand(
         { m_app->getRed(), redline, maxRpm, 3.0f, 6.0f, shortenAngle, -shortenAngle }, 2);
 
-    const Bounds speed = left.verticalSplit(0.0f, 0.5f);
-    m_speedometer->m_bounds = speed;
-
     m_speedometer->m_gauge->m_value = (m_speedUnits == "mph") 
         ? (float)units::convert(std::abs(getSpeed()), units::mile / units::hour) 
         : (float)units::convert(std::abs(getSpeed()), units::km / units::hour);
-
-
-    m_combusionChamberStatus->m_bounds = right;
 }
 
-void RightGaugeCluster::renderFuelAirCluster(const Bounds &bounds) {
-    const Bounds left = bounds.horizontalSplit(0.0f, 0.5f);
-    const Bounds right = bounds.horizontalSplit(0.5f, 1.0f);
-
-    const Bounds throttle = left.verticalSplit(0.5f, 1.0f);
-    m_throttleDisplay->m_bounds = throttle;
-
-    const Bounds fuelSection = left.verticalSplit(0.0f, 0.5f);
-    const Bounds afr = fuelSection.horizontalSplit(0.0f, 0.5f);
-    m_afrCluster->m_bounds = afr;
-
-    const Bounds fuelConsumption = fuelSection.horizontalSplit(0.5f, 1.0f);
-    m_fuelCluster->m_bounds = fuelConsumption;
-
+void RightGaugeCluster::renderFuelAirCluster() {
     constexpr double ambientPressure = units::pressure(1.0, units::atm);
     constexpr double ambientTemperature = units::celcius(25.0);
 
-    Grid grid = { 1, 3 };
-    const Bounds manifoldVacuum = grid.get(right, 0, 0, 1, 1);
-    m_manifoldVacuumGauge->m_bounds = manifoldVacuum;
-
     const double vacuumReading = getManifoldPressureWithUnits(ambientPressure);
     if (m_isAbsolute) {
         m_manifoldVacuumGauge->m_gauge->m_value = static_cast<float>(vacuumReading);
@@ -257,25 +247,20 @@ void RightGaugeCluster::renderFuelAirCluster(const Bounds &bounds) {
     }
 
     const double rpm = std::fmax(getRpm(), 0.0);
-    const double theoreticalAirPerRevolution = (m_engine == nullptr)
+    const double theoreticalAirPerRevolution = (m_simulator == nullptr)
         ? 0.0
-        : 0.5 * (ambientPressure * m_engine->getDisplacement())
+        : 0.5 * (ambientPressure * m_simulator->getSnapshot().displacement)
             / (constants::R * ambientTemperature);
     const double theoreticalAirPerSecond = theoreticalAirPerRevolution * rpm / 60.0;
-    const double actualAirPerSecond = (m_engine == nullptr)
+    const double actualAirPerSecond = (m_simulator == nullptr)
         ? 0.0
-        : m_engine->getIntakeFlowRate();
+        : m_simulator->getSnapshot().intakeFlowRate;
     const double volumetricEfficiency = (std::abs(theoreticalAirPerSecond) < 1E-3)
         ? 0.0
         : (actualAirPerSecond / theoreticalAirPerSecond);
 
-    const Bounds cfmBounds = grid.get(right, 0, 1, 1, 1);
-    m_intakeCfmGauge->m_bounds = cfmBounds;
     m_intakeCfmGauge->m_gauge->m_value =
         (float)units::convert(actualAirPerSecond, units::scfm);
-
-    const Bounds volumetricEfficiencyBounds = grid.get(right, 0, 2, 1, 1);
-    m_volumetricEffGauge->m_bounds = volumetricEfficiencyBounds;
     m_volumetricEffGauge->m_gauge->m_value = 100.0f * (float)volumetricEfficiency;
 }
 
@@ -301,26 +286,26 @@ double RightGaugeCluster::getManifoldPressureWithUnits(double ambientPressure) {
 }
 
 double RightGaugeCluster::getRpm() const {
-    return (m_engine != nullptr)
-        ? m_engine->getRpm()
+    return (m_simulator != nullptr)
+        ? m_simulator->getSnapshot().rpm
         : 0;
 }
 
 double RightGaugeCluster::getRedline() const {
-    return (m_engine != nullptr)
-        ? m_engine->getRedline()
+    return (m_simulator != nullptr)
+        ? m_simulator->getSnapshot().redline
         : 0;
 }
 
 double RightGaugeCluster::getSpeed() const {
-    return (m_simulator != nullptr && m_simulator->getVehicle() != nullptr)
-        ? m_simulator->getVehicle()->getSpeed()
+    return (m_simulator != nullptr)
+        ? m_simulator->getSnapshot().speed
         : 0;
 }
 
 double RightGaugeCluster::getManifoldPressure() const {
-    return (m_engine != nullptr)
-        ? m_engine->getManifoldPressure()
+    return (m_simulator != nullptr)
+        ? m_simulator->getSnapshot().manifoldPressure
         : units::pressure(1.0, units::atm);
 }
 
@@ -0,0 +1,33 @@
+#include "../include/simulation_arena.h"
+
+SimulationArena::SimulationArena() {
+    m_buffer = nullptr;
+    m_capacity = 0;
+    m_used = 0;
+}
+
+SimulationArena::~SimulationArena() {
+    assert(m_buffer == nullptr);
+}
+
+void SimulationArena::initialize(size_t capacity) {
+    destroy();
+
+    m_buffer = new unsigned char[capacity];
+    m_capacity = capacity;
+    m_used = 0;
+}
+
+void SimulationArena::destroy() {
+    for (auto it = m_allocations.rbegin(); it != m_allocations.rend(); ++it) {
+        it->destroy(it->data, it->count);
+    }
+
+    m_allocations.clear();
+
+    if (m_buffer != nullptr) delete[] m_buffer;
+
+    m_buffer = nullptr;
+    m_capacity = 0;
+    m_used = 0;
+}
@@ -0,0 +1,373 @@
+#include "../include/simulation_checkpoint.h"
+
+#include "../include/piston_engine_simulator.h"
+#include "../include/governor.h"
+#include "../include/vtec_valvetrain.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+
+namespace {
+class Writer {
+    public:
+        static constexpr bool Reading = false;
+
+        explicit Writer(std::vector<char> *data) {
+            m_data = data;
+        }
+
+        template <typename T>
+        void io(T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "checkpoint fields must be plain data");
+
+            const char *bytes = reinterpret_cast<const char *>(&value);
+            m_data->insert(m_data->end(), bytes, bytes + sizeof(T));
+        }
+
+        template <typename T>
+        void io(T *values, size_t n) {
+            const char *bytes = reinterpret_cast<const char *>(values);
+            m_data->insert(m_data->end(), bytes, bytes + sizeof(T) * n);
+        }
+
+        void invalidate() { /* void */ }
+        bool failed() const { return false; }
+
+    private:
+        std::vector<char> *m_data;
+};
+
+class Reader {
+    public:
+        static constexpr bool Reading = true;
+
+        Reader(const std::vector<char> &data, size_t offset) {
+            m_data = &data;
+            m_offset = offset;
+            m_failed = false;
+        }
+
+        template <typename T>
+        void io(T &value) {
+            io(&value, 1);
+        }
+
+        template <typename T>
+        void io(T *values, size_t n) {
+            static_assert(std::is_trivially_copyable<T>::value, "checkpoint fields must be plain data");
+
+            const size_t size = sizeof(T) * n;
+            if (m_failed || m_data->size() - m_offset < size) {
+                m_failed = true;
+                return;
+            }
+
+            std::memcpy(values, m_data->data() + m_offset, size);
+            m_offset += size;
+        }
+
+        void invalidate() { m_failed = true; }
+        bool failed() const { return m_failed; }
+        bool atEnd() const { return m_offset == m_data->size(); }
+
+    private:
+        const std::vector<char> *m_data;
+        size_t m_offset;
+        bool m_failed;
+};
+
+template <typename Archive>
+void transferBody(Archive *archive, atg_scs::RigidBody *body) {
+    archive->io(body->p_x);
+    archive->io(body->p_y);
+    archive->io(body->theta);
+    archive->io(body->v_x);
+    archive->io(body->v_y);
+    archive->io(body->v_theta);
+
+    // Gear changes rescale the vehicle mass and inertia
+    archive->io(body->m);
+    archive->io(body->I);
+}
+
+template <typename Archive>
+void transferGas(Archive *archive, GasSystem *system) {
+    GasSystem::State state = system->getState();
+    archive->io(state);
+
+    if constexpr (Archive::Reading) {
+        system->setState(state);
+    }
+}
+
+template <typename Archive>
+void transferValue(Archive *archive, double value, void (*apply)(Engine *, double), Engine *engine) {
+    archive->io(value);
+
+    if constexpr (Archive::Reading) {
+        apply(engine, value);
+    }
+}
+} /* namespace */
+
+SimulationCheckpoint::SimulationCheckpoint() {
+    /* void */
+}
+
+SimulationCheckpoint::~SimulationCheckpoint() {
+    /* void */
+}
+
+std::vector<int32_t> SimulationCheckpoint::describeLayout(PistonEngineSimulator *simulator) {
+    Engine *engine = simulator->getEngine();
+
+    std::vector<int32_t> layout = {
+        static_cast<int32_t>(Magic),
+        static_cast<int32_t>(Version),
+        engine->getCrankshaftCount(),
+        engine->getCylinderCount(),
+        engine->getExhaustSystemCount(),
+        engine->getIntakeCount(),
+        dynamic_cast<Governor *>(engine->getThrottleModel()) != nullptr,
+        simulator->getTransmission() != nullptr,
+        simulator->isReducedKinematics(),
+        simulator->m_chamberZones.getChamberCount()
+    };
+
+    for (int i = 0; i < engine->getCylinderBankCount(); ++i) {
+        layout.push_back(dynamic_cast<VtecValvetrain *>(engine->getHead(i)->getValvetrain()) != nullptr);
+    }
+
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        const CombustionChamber *chamber = engine->getChamber(i);
+        layout.push_back(chamber->getIntakePipe().getSegmentCount());
+        layout.push_back(chamber->getExhaustPipe().getSegmentCount());
+    }
+
+    // Delay line lengths follow from the exhaust geometry and the rate
+    // being stepped at
+    const DelayLineBank &delays = simulator->m_exhaustDelays;
+    layout.push_back(delays.getRowCount());
+    for (int i = 0; i < delays.getLineCount(); ++i) {
+        layout.push_back(static_cast<int32_t>(delays.m_offsets[i]));
+    }
+
+    return layout;
+}
+
+template <typename Archive>
+void SimulationCheckpoint::transfer(Archive *archive, PistonEngineSimulator *simulator) {
+    Engine *engine = simulator->getEngine();
+    const int cylinderCount = engine->getCylinderCount();
+
+    for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+        transferBody(archive, &engine->getCrankshaft(i)->m_body);
+    }
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        transferBody(archive, &engine->getPiston(i)->m_body);
+        transferBody(archive, &engine->getConnectingRod(i)->m_body);
+    }
+
+    transferBody(archive, &simulator->m_vehicleMass);
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        CombustionChamber *chamber = engine->getChamber(i);
+        transferGas(archive, &chamber->m_fluid->system);
+        transferGas(archive, &chamber->m_fluid->intakeRunnerAndManifold);
+        transferGas(archive, &chamber->m_fluid->exhaustRunnerAndPrimary);
+
+        archive->io(chamber->m_fluid->flameEvent);
+        archive->io(chamber->m_fluid->lit);
+        archive->io(chamber->m_litLastFrame);
+        archive->io(chamber->m_fluid->peakTemperature);
+        archive->io(chamber->m_fluid->nBurntFuel);
+        archive->io(chamber->m_fluid->creviceFraction);
+        archive->io(chamber->m_fluid->knockIntensity);
+        archive->io(chamber->m_intakeValveLift);
+        archive->io(chamber->m_exhaustValveLift);
+        archive->io(chamber->m_fluid->intakeFlowRate);
+        archive->io(chamber->m_fluid->exhaustFlowRate);
+        archive->io(chamber->m_fluid->manifoldToRunnerFlowRate);
+        archive->io(chamber->m_fluid->primaryToCollectorFlowRate);
+        archive->io(chamber->m_fluid->lastTimestepTotalExhaustFlow);
+        archive->io(chamber->m_fluid->lastTimestepTotalIntakeFlow);
+        archive->io(chamber->m_fluid->exhaustFlow);
+        archive->io(chamber->m_fluid->intakeFlow);
+        archive->io(chamber->m_fluid->pendingIntakeRunnerSubsteps);
+        archive->io(chamber->m_fluid->pendingExhaustRunnerSubsteps);
+        archive->io(chamber->m_fluid->pendingIntakeRunnerTime);
+        archive->io(chamber->m_fluid->pendingExhaustRunnerTime);
+        archive->io(chamber->m_pressure, CombustionChamber::StateSamples);
+        archive->io(chamber->m_pistonSpeed, CombustionChamber::StateSamples);
+        archive->io(chamber->m_pistonSpeedSum);
+        archive->io(chamber->m_peakPressure);
+        archive->io(chamber->m_peakPressureIndex);
+        archive->io(chamber->m_random);
+
+        for (PipeSegments *pipe : { &chamber->m_intakePipe, &chamber->m_exhaustPipe }) {
+            const int n = pipe->getSegmentCount();
+            if (n == 0) continue;
+
+            archive->io(pipe->m_n, n);
+            archive->io(pipe->m_E, n);
+            archive->io(pipe->m_momentum, n);
+            archive->io(pipe->m_fuel, n);
+            archive->io(pipe->m_o2, n);
+        }
+    }
+
+    ChamberZones &zones = simulator->m_chamberZones;
+    if (zones.getChamberCount() > 0) {
+        archive->io(zones.m_T_u, zones.getChamberCount());
+        archive->io(zones.m_P_u, zones.getChamberCount());
+        archive->io(zones.m_knockIntegral, zones.getChamberCount());
+        archive->io(zones.m_knockCount);
+    }
+
+    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+        ExhaustSystem *exhaust = engine->getExhaustSystem(i);
+        transferGas(archive, &exhaust->m_system);
+        archive->io(exhaust->m_flow);
+    }
+
+    for (int i = 0; i < engine->getIntakeCount(); ++i) {
+        Intake *intake = engine->getIntake(i);
+        transferGas(archive, &intake->m_system);
+        archive->io(intake->m_throttle);
+        archive->io(intake->m_flow);
+        archive->io(intake->m_flowRate);
+        archive->io(intake->m_totalFuelInjected);
+    }
+
+    IgnitionModule *ignition = engine->getIgnitionModule();
+    archive->io(ignition->m_enabled);
+    archive->io(ignition->m_lastCrankshaftAngle);
+    archive->io(ignition->m_revLimitTimer);
+    for (int i = 0; i < ignition->m_cylinderCount; ++i) {
+        archive->io(ignition->m_plugs[i].ignitionEvent);
+    }
+
+    // The solenoid, part way through its delay or not, and the cams it
+    // has latched
+    for (int i = 0; i < engine->getCylinderBankCount(); ++i) {
+        if (VtecValvetrain *vtec = dynamic_cast<VtecValvetrain *>(engine->getHead(i)->getValvetrain())) {
+            archive->io(vtec->m_engaged);
+            archive->io(vtec->m_switchTime);
+            if constexpr (Archive::Reading) vtec->latchCamshafts();
+        }
+    }
+
+    // Setting the speed control recomputes the governor target or the
+    // linkage position; the governor's integrator is restored after it
+    transferValue(archive, engine->getSpeedControl(), [](Engine *e, double s) { e->setSpeedControl(s); }, engine);
+    transferValue(archive, engine->getThrottle(), [](Engine *e, double t) { e->setThrottle(t); }, engine);
+    if (Governor *governor = dynamic_cast<Governor *>(engine->getThrottleModel())) {
+        archive->io(governor->m_currentThrottle);
+        archive->io(governor->m_velocity);
+    }
+
+    Transmission *transmission = simulator->getTransmission();
+    if (transmission != nullptr) {
+        archive->io(transmission->m_gear);
+        archive->io(transmission->m_newGear);
+        archive->io(transmission->m_clutchPressure);
+    }
+
+    Vehicle *vehicle = simulator->getVehicle();
+    if (vehicle != nullptr) {
+        archive->io(vehicle->m_travelledDistance);
+    }
+
+    archive->io(simulator->m_filteredEngineSpeed);
+    static_assert(
+        std::is_trivially_copyable<CycleStatistics>::value,
+        "cycle statistics are checkpointed as plain data");
+    archive->io(simulator->m_cycleStatistics);
+    if constexpr (Archive::Reading) {
+        if (simulator->m_cycleStatistics.m_lastBin >= CycleStatistics::Bins) {
+            archive->invalidate();
+            return;
+        }
+    }
+
+    archive->io(simulator->m_dyno.m_enabled);
+    archive->io(simulator->m_dyno.m_hold);
+    archive->io(simulator->m_dyno.m_rotationSpeed);
+    archive->io(simulator->m_starterMotor.m_enabled);
+    archive->io(simulator->m_starterMotor.m_rotationSpeed);
+
+    archive->io(simulator->m_derivativeFilter.m_previous);
+
+    DelayLineBank &delays = simulator->m_exhaustDelays;
+    archive->io(delays.m_writeRow);
+    if constexpr (Archive::Reading) {
+        if (delays.m_writeRow > delays.m_rowMask) {
+            archive->invalidate();
+            return;
+        }
+    }
+
+    archive->io(delays.m_history, (delays.m_rowMask + 1) * delays.m_lineCount);
+}
+
+void SimulationCheckpoint::capture(PistonEngineSimulator *simulator) {
+    m_data.clear();
+
+    std::vector<int32_t> layout = describeLayout(simulator);
+    int32_t layoutSize = static_cast<int32_t>(layout.size());
+
+    Writer writer(&m_data);
+    writer.io(layoutSize);
+    writer.io(layout.data(), layout.size());
+
+    transfer(&writer, simulator);
+}
+
+bool SimulationCheckpoint::restore(PistonEngineSimulator *simulator) const {
+    const std::vector<int32_t> expected = describeLayout(simulator);
+
+    Reader reader(m_data, 0);
+    int32_t layoutSize = 0;
+    reader.io(layoutSize);
+    if (reader.failed() || layoutSize != static_cast<int32_t>(expected.size())) return false;
+
+    std::vector<int32_t> layout(layoutSize);
+    reader.io(layout.data(), layout.size());
+    if (reader.failed() || layout != expected) return false;
+
+    // Kept so a truncated or corrupt body leaves the simulator as it was
+    SimulationCheckpoint previous;
+    previous.capture(simulator);
+
+    transfer(&reader, simulator);
+    const bool restored = !reader.failed() && reader.atEnd();
+    if (!restored) {
+        Reader undo(previous.m_data, sizeof(int32_t) * (1 + expected.size()));
+        transfer(&undo, simulator);
+    }
+
+    // The restored bodies start an interval of their own
+    simulator->setRigidBodyInterval(simulator->getRigidBodyInterval());
+    simulator->getEngine()->updateAggregates();
+    return restored;
+}
+
+bool SimulationCheckpoint::save(const std::string &path) const {
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    const bool written = std::fwrite(m_data.data(), 1, m_data.size(), file) == m_data.size();
+    return (std::fclose(file) == 0) && written;
+}
+
+bool SimulationCheckpoint::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !m_data.empty();
+}
@@ -0,0 +1,301 @@
+#include "../include/simulation_host.h"
+
+#include "../include/denormals.h"
+#include "../include/engine.h"
+#include "../include/impulse_response_cache.h"
+#include "../include/simulator.h"
+#include "../include/transmission.h"
+#include "../include/units.h"
+#include "../include/vehicle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+namespace {
+// Same drivetrain engine_sim_create() falls back on
+void createDefaultDrivetrain(EngineInstance *instance) {
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+
+    if (instance->getVehicle() == nullptr) {
+        Vehicle::Parameters vehParams;
+        vehParams.mass = units::mass(1597, units::kg);
+        vehParams.diffRatio = 3.42;
+        vehParams.tireRadius = units::distance(10, units::inch);
+        vehParams.dragCoefficient = 0.25;
+        vehParams.crossSectionArea = units::distance(6.0, units::foot) * units::distance(6.0, units::foot);
+        vehParams.rollingResistance = 2000.0;
+        vehicle = new Vehicle;
+        vehicle->initialize(vehParams);
+    }
+
+    if (instance->getTransmission() == nullptr) {
+        const double gearRatios[] = { 2.97, 2.07, 1.43, 1.00, 0.84, 0.56 };
+        Transmission::Parameters tParams;
+        tParams.GearCount = 6;
+        tParams.GearRatios = gearRatios;
+        tParams.MaxClutchTorque = units::torque(1000.0, units::ft_lb);
+        transmission = new Transmission;
+        transmission->initialize(tParams);
+    }
+
+    instance->setDrivetrain(vehicle, transmission);
+}
+} /* namespace */
+
+SimulationHost::SimulationHost() {
+    m_threads = 1;
+    m_liveInstances = 0;
+}
+
+SimulationHost::~SimulationHost() {
+    /* void */
+}
+
+void SimulationHost::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.sliceLength = std::max(params.sliceLength, 0.0);
+    m_parameters.batchSize = std::max(params.batchSize, 1);
+
+    const int concurrency = JobSystem::Shared().getConcurrency();
+    m_threads = (params.threads > 0)
+        ? std::min(params.threads, concurrency)
+        : concurrency;
+
+    m_statistics = Statistics();
+}
+
+void SimulationHost::destroy() {
+    for (int i = 0; i < static_cast<int>(m_instances.size()); ++i) {
+        destroyInstance(i);
+    }
+
+    for (Instance *instance : m_instances) delete instance;
+    m_instances.clear();
+    m_freeInstances.clear();
+
+    // Only once no engine points into them
+    for (EngineDefinition *definition : m_definitions) {
+        definition->destroy();
+        delete definition;
+    }
+
+    m_definitions.clear();
+}
+
+int SimulationHost::addDefinition(const std::string &snapshotPath) {
+    EngineDefinition *definition = new EngineDefinition;
+    if (!definition->load(snapshotPath)) {
+        delete definition;
+        return -1;
+    }
+
+    m_definitions.push_back(definition);
+    return static_cast<int>(m_definitions.size()) - 1;
+}
+
+int SimulationHost::createInstance(int definition) {
+    if (definition < 0 || definition >= static_cast<int>(m_definitions.size())) return -1;
+
+    int index;
+    if (!m_freeInstances.empty()) {
+        index = m_freeInstances.back();
+        m_freeInstances.pop_back();
+    }
+    else {
+        index = static_cast<int>(m_instances.size());
+        m_instances.push_back(new Instance);
+    }
+
+    Instance *built = m_instances[index];
+    if (!m_definitions[definition]->instantiate(&built->engine)) {
+        m_freeInstances.push_back(index);
+        return -1;
+    }
+
+    createDefaultDrivetrain(&built->engine);
+
+    Engine *engine = built->engine.getEngine();
+    Simulator *simulator = engine->createSimulator(
+        built->engine.getVehicle(),
+        built->engine.getTransmission(),
+        false,
+        m_parameters.audio);
+    simulator->setRandomSeed(m_parameters.seed);
+    engine->calculateDisplacement();
+    simulator->setSimulationFrequency(static_cast<int>(engine->getSimulationFrequency()));
+
+    // Slices are paced by the host, not by the synthesizer latency
+    simulator->setOfflineMode(true);
+
+    if (m_parameters.audio) {
+        Synthesizer::AudioParameters audioParams = simulator->synthesizer().getAudioParameters();
+        audioParams.inputSampleNoise = static_cast<float>(engine->getInitialJitter());
+        audioParams.airNoise = static_cast<float>(engine->getInitialNoise());
+        audioParams.dF_F_mix = static_cast<float>(engine->getInitialHighFrequencyGain());
+        simulator->synthesizer().setAudioParameters(audioParams);
+
+        std::vector<ImpulseResponse *> responses;
+        for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+            responses.push_back(engine->getExhaustSystem(i)->getImpulseResponse());
+        }
+
+        std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> kernels;
+        ImpulseResponseCache::Load(
+            responses.data(),
+            static_cast<int>(responses.size()),
+            simulator->getAudioSampleRate(),
+            &kernels);
+        for (int i = 0; i < static_cast<int>(kernels.size()); ++i) {
+            if (kernels[i] != nullptr) {
+                simulator->synthesizer().initializeImpulseResponse(kernels[i]->filter, i);
+            }
+        }
+    }
+
+    built->engine.setSimulator(simulator);
+    built->definition = definition;
+    built->simulator = simulator;
+    built->pending = 0.0;
+    ++m_liveInstances;
+
+    return index;
+}
+
+void SimulationHost::destroyInstance(int instance) {
+    Instance *target = getInstance(instance);
+    if (target == nullptr) return;
+
+    release(target);
+    m_freeInstances.push_back(instance);
+    --m_liveInstances;
+}
+
+Simulator *SimulationHost::getSimulator(int instance) const {
+    const Instance *target = getInstance(instance);
+    return (target != nullptr) ? target->simulator : nullptr;
+}
+
+int SimulationHost::getDefinition(int instance) const {
+    const Instance *target = getInstance(instance);
+    return (target != nullptr) ? target->definition : -1;
+}
+
+const EngineDefinition *SimulationHost::getEngineDefinition(int definition) const {
+    if (definition < 0 || definition >= static_cast<int>(m_definitions.size())) return nullptr;
+
+    return m_definitions[definition];
+}
+
+void SimulationHost::request(int instance, double seconds) {
+    Instance *target = getInstance(instance);
+    if (target == nullptr || !(seconds > 0)) return;
+
+    target->pending += seconds;
+}
+
+double SimulationHost::getPending(int instance) const {
+    const Instance *target = getInstance(instance);
+    return (target != nullptr) ? target->pending : 0.0;
+}
+
+int SimulationHost::runRound() {
+    const auto start = std::chrono::steady_clock::now();
+
+    m_ready.clear();
+    for (Instance *instance : m_instances) {
+        if (instance->simulator == nullptr) continue;
+        if (instance->pending >= instance->simulator->getTimestep()) {
+            m_ready.push_back(instance);
+        }
+    }
+
+    if (m_ready.empty()) return 0;
+
+    // Instance order within a definition keeps rounds deterministic
+    std::stable_sort(m_ready.begin(), m_ready.end(), [](const Instance *a, const Instance *b) {
+        return a->definition < b->definition;
+    });
+
+    m_batches.clear();
+    const int readyCount = static_cast<int>(m_ready.size());
+    for (int i = 0; i < readyCount;) {
+        Batch batch;
+        batch.begin = i;
+        batch.end = i + 1;
+        while (batch.end < readyCount
+            && batch.end - batch.begin < m_parameters.batchSize
+            && m_ready[batch.end]->definition == m_ready[batch.begin]->definition)
+        {
+            ++batch.end;
+        }
+
+        m_batches.push_back(batch);
+        i = batch.end;
+    }
+
+    JobSystem::Shared().parallelFor(static_cast<int>(m_batches.size()), [this](int i) {
+        DenormalScope denormals;
+
+        Batch &batch = m_batches[i];
+        for (int j = batch.begin; j < batch.end; ++j) {
+            const long long steps = advance(m_ready[j]);
+            batch.steps += steps;
+            batch.simulatedTime += steps * m_ready[j]->simulator->getTimestep();
+        }
+    }, JobSystem::Priority::Physics, m_threads);
+
+    for (const Batch &batch : m_batches) {
+        m_statistics.steps += batch.steps;
+        m_statistics.simulatedTime += batch.simulatedTime;
+    }
+
+    ++m_statistics.rounds;
+    m_statistics.slices += readyCount;
+    m_statistics.batches += static_cast<long long>(m_batches.size());
+    m_statistics.wallTime +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return readyCount;
+}
+
+void SimulationHost::runPending() {
+    while (runRound() > 0) { /* void */ }
+}
+
+SimulationHost::Instance *SimulationHost::getInstance(int instance) const {
+    if (instance < 0 || instance >= static_cast<int>(m_instances.size())) return nullptr;
+
+    Instance *target = m_instances[instance];
+    return (target->simulator != nullptr) ? target : nullptr;
+}
+
+void SimulationHost::release(Instance *instance) {
+    instance->engine.destroy();
+    instance->definition = -1;
+    instance->simulator = nullptr;
+    instance->pending = 0.0;
+}
+
+long long SimulationHost::advance(Instance *instance) {
+    Simulator *simulator = instance->simulator;
+    const double timestep = simulator->getTimestep();
+
+    // A slice shorter than one step still makes progress
+    const double slice = std::min(instance->pending, m_parameters.sliceLength);
+    const int steps = std::max(static_cast<int>(std::floor(slice / timestep)), 1);
+
+    simulator->startFrameSteps(steps);
+    while (simulator->simulateStep()) { /* void */ }
+    simulator->endFrame();
+
+    instance->pending = std::max(instance->pending - steps * timestep, 0.0);
+
+    if (m_parameters.audio) {
+        simulator->synthesizer().renderPendingAudio();
+    }
+
+    return steps;
+}
@@ -17,10 +17,18 @@ void SimulationObject::initialize(EngineSimApplication *app) {
     m_app = app;
 }
 
+void SimulationObject::generateStaticGeometry() {
+    /* void */
+}
+
 void SimulationObject::generateGeometry() {
     /* void */
 }
 
+bool SimulationObject::getWorldBounds(Bounds *bounds) const {
+    return false;
+}
+
 void SimulationObject::render(const ViewParameters *settings) {
     /* void */
 }
@@ -64,6 +72,18 @@ void SimulationObject::setTransform(
     float ly,
     float angle,
     float z)
+{
+    m_app->getShaders()->SetObjectTransform(
+        bodyTransform(rigidBody, scale, lx, ly, angle, z));
+}
+
+ysMatrix SimulationObject::bodyTransform(
+    atg_scs::RigidBody *rigidBody,
+    float scale,
+    float lx,
+    float ly,
+    float angle,
+    float z) const
 {
     double p_x, p_y;
     rigidBody->localToWorld(lx, ly, &p_x, &p_y);
@@ -75,8 +95,7 @@ void SimulationObject::setTransform(
             ysMath::LoadVector((float)p_x, (float)p_y, z));
     const ysMatrix scaleTransform = ysMath::ScaleTransform(ysMath::LoadScalar(scale));
 
-    m_app->getShaders()->SetObjectTransform(
-        ysMath::MatMult(ysMath::MatMult(trans, rot), scaleTransform));
+    return ysMath::MatMult(ysMath::MatMult(trans, rot), scaleTransform);
 }
 
 ysVector SimulationObject::tintByLayer(const ysVector &col, int layers) const {
@@ -1,5 +1,12 @@
 #include "../include/simulator.h"
 #include "../include/debug_trace.h"
+#include "../include/allocation_tracker.h"
+#include "../include/event_counters.h"
+#include "../include/step_profiler.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <cmath>
 
 Simulator::Simulator() {
     m_engine = nullptr;
@@ -10,24 +17,59 @@ Simulator::Simulator() {
     m_physicsProcessingTime = 0;
 
     m_simulationSpeed = 1.0;
-    m_targetSynthesizerLatency = 0.1;
+    m_targetSynthesizerLatency = m_latencyProfile.targetLatency;
+    m_synthesizerOutputChannels = 0;
+    m_audioSampleRate = 44100;
+    m_offline = false;
+    m_audioEnabled = true;
+    m_randomSeed = 0;
     m_simulationFrequency = 10000;
+    m_targetSimulationFrequency = 10000;
+    m_fidelity = Fidelity::Full;
+    m_frameInProgress = false;
+    m_controlWindowValid = false;
+    m_fidelityUpdatePending = false;
     m_steps = 0;
+    m_frameReplayedSteps = 0;
+    m_stepAllocations = 0;
 
     m_currentIteration = 0;
 
     m_filteredEngineSpeed = 0.0;
-    m_dynoTorqueSamples = nullptr;
-    m_lastDynoTorqueSample = 0;
+    m_audioCacheEnabled = false;
+    m_overloadHandling = true;
+    m_speculativeStepping = false;
+    m_speculativeCheckpointed = false;
+    m_speculativeRefinement = 1;
+    m_speculativeHoldFrames = 0;
+    m_speculativeSilentSteps = 0;
+    m_concealedSamples = 0;
+    m_telemetryEnabled = false;
+    m_telemetryExport = nullptr;
+    m_flightRecorder = nullptr;
+    m_engineController = nullptr;
+    m_inputSession = nullptr;
+    m_controlSource = nullptr;
+    for (double &time : m_controlGlideTimes) time = 0.0;
+    m_synthesizerCapture = nullptr;
+    m_sessionStep = 0;
+    m_sessionOverloadHandling = true;
+    m_snapshotFrame = 0;
+    m_snapshotTime = 0.0;
 }
 
 Simulator::~Simulator() {
     assert(m_system == nullptr);
-    assert(m_dynoTorqueSamples == nullptr);
 }
 
 void Simulator::initialize(const Parameters &params) {
-    DebugTrace::Log("simulator", "initialize begin system_type=%d", static_cast<int>(params.systemType));
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "initialize begin system_type=%d audio=%d",
+        static_cast<int>(params.systemType),
+        params.audio ? 1 : 0);
+    m_audioEnabled = params.audio;
+
     if (params.systemType == SystemType::NsvOptimized) {
         atg_scs::OptimizedNsvRigidBodySystem *system =
             new atg_scs::OptimizedNsvRigidBodySystem;
@@ -44,56 +86,112 @@ void Simulator::initialize(const Parameters &params) {
         m_system = system;
     }
 
-    m_dynoTorqueSamples = new double[DynoTorqueSamples];
-    for (int i = 0; i < DynoTorqueSamples; ++i) {
-        m_dynoTorqueSamples[i] = 0.0;
-    }
-    DebugTrace::Log("simulator", "initialize complete");
+    m_cycleStatistics.reset();
+    m_overloadPolicy.initialize(OverloadPolicy::Parameters());
+    m_concealedSamples = 0;
+
+    m_telemetry.initialize();
+
+    m_snapshotFrame = 0;
+    m_snapshotTime = 0.0;
+    m_snapshots.reset(SimulationSnapshot());
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "initialize complete");
 }
 
 void Simulator::loadSimulation(Engine *engine, Vehicle *vehicle, Transmission *transmission) {
     m_engine = engine;
     m_vehicle = vehicle;
     m_transmission = transmission;
+
+    if (m_engine != nullptr) m_engine->updateAggregates();
+
+    m_multirate.initialize(m_engine, getVehicleMass(), m_multirate.getInterval());
+    setRandomSeed(m_randomSeed);
+    sizeFlightRecorder();
 }
 
 void Simulator::releaseSimulation() {
-    DebugTrace::Log("simulator", "releaseSimulation begin");
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "releaseSimulation begin");
     m_synthesizer.endAudioRenderingThread();
     if (m_system != nullptr) m_system->reset();
 
     destroy();
-    DebugTrace::Log("simulator", "releaseSimulation complete");
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "releaseSimulation complete");
 }
 
 void Simulator::startFrame(double dt) {
+    if (!beginFrame()) return;
+
+    const double timestep = getTimestep();
+    m_steps = (int)std::round((dt * m_simulationSpeed) / timestep);
+
+    // Offline frames always advance by exactly dt; the synthesizer throttles
+    // the producer instead of the step count drifting with latency. Without
+    // audio there is no latency to follow.
+    if (!m_offline && m_audioEnabled) {
+        const double targetLatency = getSynthesizerInputLatencyTarget();
+        if (m_synthesizer.getLatency() < targetLatency) {
+            m_steps = static_cast<int>((m_steps + 1) * 1.1);
+        }
+        else if (m_synthesizer.getLatency() > targetLatency) {
+            m_steps = static_cast<int>((m_steps - 1) * 0.9);
+            if (m_steps < 0) {
+                m_steps = 0;
+            }
+        }
+    }
+
+    if (m_audioEnabled) updateOverload();
+
+    resetIntakeFlows();
+}
+
+void Simulator::startFrameSteps(int steps) {
+    if (!beginFrame()) return;
+
+    m_steps = std::max(steps, 0);
+    resetIntakeFlows();
+}
+
+bool Simulator::beginFrame() {
+    if (m_fidelityUpdatePending) {
+        m_fidelityUpdatePending = false;
+        applyFidelity();
+    }
+
     if (m_engine == nullptr) {
         m_steps = 0;
-        return;
+        return false;
     }
 
+    beginSpeculativeFrame();
+
+    m_frameInProgress = true;
     m_simulationStart = std::chrono::steady_clock::now();
+
+    m_controlWindowStart = m_controlWindowValid ? m_controlWindowEnd : m_simulationStart;
+    m_controlWindowEnd = m_simulationStart;
+    m_controlWindowValid = true;
     m_currentIteration = 0;
-    m_synthesizer.setInputSampleRate(m_simulationFrequency * m_simulationSpeed);
+    m_frameReplayedSteps = 0;
+    if (m_audioEnabled) {
+        m_synthesizer.setInputSampleRate(m_simulationFrequency * m_simulationSpeed);
+    }
 
-    const double timestep = getTimestep();
-    m_steps = (int)std::round((dt * m_simulationSpeed) / timestep);
+    return true;
+}
 
-    const double targetLatency = getSynthesizerInputLatencyTarget();
-    if (m_synthesizer.getLatency() < targetLatency) {
-        m_steps = static_cast<int>((m_steps + 1) * 1.1);
-    }
-    else if (m_synthesizer.getLatency() > targetLatency) {
-        m_steps = static_cast<int>((m_steps - 1) * 0.9);
-        if (m_steps < 0) {
-            m_steps = 0;
-        }
-    }
+void Simulator::resetIntakeFlows() {
+    // Frames the audio cache replays don't step the intakes, so the last
+    // live frame's rates stand
+    if (m_steps <= 0 || m_audioCache.isReplaying()) return;
 
-    if (m_steps > 0) {
-        for (int i = 0; i < m_engine->getIntakeCount(); ++i) {
-            m_engine->getIntake(i)->m_flowRate = 0;
-        }
+    clearIntakeFlows();
+}
+
+void Simulator::clearIntakeFlows() {
+    for (int i = 0; i < m_engine->getIntakeCount(); ++i) {
+        m_engine->getIntake(i)->m_flowRate = 0;
     }
 }
 
@@ -108,80 +206,729 @@ bool Simulator::simulateStep() {
         return false;
     }
 
+    unsigned long long allocations0 = AllocationTracker::GetThreadAllocationCount();
+    ATG_ENGINE_SIM_PROFILE_COUNTED_SCOPE(Step);
+    FlightRecorder::SetCurrent(m_flightRecorder);
+
+    drainControls();
+
+    if (m_audioCache.isInitialized()) {
+        if (updateAudioCacheInputs()) {
+            if (m_audioCache.isReplaying()) {
+                ATG_ENGINE_SIM_TRACE(
+                    Simulator, Event,
+                    "audio_cache resume replayed_frames=%llu",
+                    m_audioCache.getReplayedFrames());
+
+                // The rest of the frame is live and accumulates its own flow
+                if (m_frameReplayedSteps > 0) clearIntakeFlows();
+            }
+
+            m_audioCache.interrupt();
+        }
+
+        if (m_audioCache.isReplaying()) {
+            // Physics holds still; the loop stands in for its output
+            writeSynthesizerFrame(m_audioCache.nextReplayFrame());
+            ++m_frameReplayedSteps;
+            ++m_currentIteration;
+            ++m_sessionStep;
+            return true;
+        }
+    }
+
     const double timestep = getTimestep();
-    m_system->process(timestep, 1);
+    const int rigidBodyInterval = m_multirate.getInterval();
+
+    // A change to the solved set resizes the solver's state, which
+    // allocates; the solve that follows it is left out of the check below
+    const unsigned long long resize0 = AllocationTracker::GetThreadAllocationCount();
+    const bool resized = (rigidBodyInterval == 1 || m_multirate.isSolveDue()) && updateSolvedSet();
+
+    if (rigidBodyInterval == 1) {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(Solver);
+        ATG_ENGINE_SIM_COUNT(SolverSteps, 1);
+        m_system->process(timestep, 1);
+    }
+    else {
+        if (m_multirate.isSolveDue()) {
+            ATG_ENGINE_SIM_PROFILE_SCOPE(Solver);
+            ATG_ENGINE_SIM_COUNT(SolverSteps, 1);
+            m_multirate.beginSolve();
+            m_system->process(timestep * rigidBodyInterval, 1);
+            m_multirate.endSolve();
+        }
+
+        m_multirate.interpolate();
+    }
+
+    if (resized) allocations0 += AllocationTracker::GetThreadAllocationCount() - resize0;
+
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(EngineUpdate);
+        m_engine->update(timestep);
+    }
 
-    m_engine->update(timestep);
     m_vehicle->update(timestep);
     m_transmission->update(timestep);
 
     updateFilteredEngineSpeed(timestep);
 
-    Crankshaft *outputShaft = m_engine->getOutputCrankshaft();
-    outputShaft->resetAngle();
+    // Only on the solved state, so the interpolation never spans a wrap
+    if (m_multirate.isSolveDue()) {
+        Crankshaft *outputShaft = m_engine->getOutputCrankshaft();
+        const double unwrappedAngle = outputShaft->m_body.theta;
+        outputShaft->resetAngle();
 
-    for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
-        Crankshaft *shaft = m_engine->getCrankshaft(i);
-
-        // Correct drift (temporary hack)
-        shaft->m_body.theta = outputShaft->m_body.theta;
+        // The other shafts are geared to the output shaft by the link
+        // constraints, so they only take the same whole-cycle wrap
+        const double wrap = unwrappedAngle - outputShaft->m_body.theta;
+        for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
+            Crankshaft *shaft = m_engine->getCrankshaft(i);
+            if (shaft != outputShaft) {
+                shaft->m_body.theta -= wrap;
+            }
+        }
     }
 
-    const int index =
-        static_cast<int>(std::floor(DynoTorqueSamples * outputShaft->getCycleAngle() / (4 * constants::pi)));
-    const int step = m_engine->isSpinningCw() ? 1 : -1;
-    m_dynoTorqueSamples[index] = m_dyno.getTorque();
+    simulateStep_();
+    if (rigidBodyInterval > 1) m_multirate.samplePressures();
 
-    if (m_lastDynoTorqueSample != index) {
-        for (int i = m_lastDynoTorqueSample + step; i != index; i += step) {
-            if (i >= DynoTorqueSamples) {
-                i = -1;
-                continue;
-            }
-            else if (i < 0) {
-                i = DynoTorqueSamples;
-                continue;
-            }
+    if (m_speculativeCheckpointed) {
+        const SpeculativeStepping::Failure failure = m_speculative.check(m_engine);
 
-            m_dynoTorqueSamples[i] = m_dyno.getTorque();
+        // Restoring allocates, but this step is undone with it
+        if (failure != SpeculativeStepping::Failure::None && rollBackSpeculativeFrame(failure)) {
+            FlightRecorder::SetCurrent(nullptr);
+            return true;
         }
+    }
+
+    const bool silent = m_speculativeSilentSteps > 0;
+    if (silent) --m_speculativeSilentSteps;
+
+    m_engine->updateAggregates();
+    writeCycleStatistics();
 
-        m_lastDynoTorqueSample = index;
+    if (m_engineController != nullptr && !silent) {
+        m_engineController->step(timestep, m_engine);
     }
 
-    simulateStep_();
+    if (m_audioEnabled && !silent) {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(WriteToSynthesizer);
+        writeToSynthesizer();
+    }
+
+    // The scopes are the first thing to go under overload
+    if (isTelemetryEnabled() && !silent && !isOverloadShedding(OverloadPolicy::Level::Scopes)) {
+        writeTelemetry();
+    }
+
+    if (m_telemetryExport != nullptr && !silent && m_telemetryExport->isDue()) {
+        writeTelemetryExport();
+    }
+
+    // Only non-zero in ENGINE_SIM_TRACK_ALLOCATIONS builds
+    const unsigned long long allocations =
+        AllocationTracker::GetThreadAllocationCount() - allocations0;
+    m_stepAllocations += allocations;
+    assert(allocations == 0);
+
+    // After the allocation check, since a dump allocates
+    if (m_flightRecorder != nullptr && !silent) {
+        writeFlightRecorder();
+    }
 
-    writeToSynthesizer();
+    FlightRecorder::SetCurrent(nullptr);
 
     ++m_currentIteration;
+    ++m_sessionStep;
     return true;
 }
 
+void Simulator::writeCycleStatistics() {
+    double values[CycleStatistics::ChannelCount] = {};
+    values[static_cast<int>(CycleStatistics::Channel::Torque)] = m_dyno.getTorque();
+
+    if (m_engine->getCylinderCount() > 0) {
+        CombustionChamber *chamber = m_engine->getChamber(0);
+        const double timestep = getTimestep();
+
+        values[static_cast<int>(CycleStatistics::Channel::CylinderPressure)] = chamber->getSystem()->pressure();
+        values[static_cast<int>(CycleStatistics::Channel::CylinderVolume)] = chamber->getVolume();
+        values[static_cast<int>(CycleStatistics::Channel::IntakeFlow)] = chamber->getLastTimestepIntakeFlow() / timestep;
+        values[static_cast<int>(CycleStatistics::Channel::ExhaustFlow)] = chamber->getLastTimestepExhaustFlow() / timestep;
+        values[static_cast<int>(CycleStatistics::Channel::IntakeValveLift)] = chamber->getIntakeValveLift();
+        values[static_cast<int>(CycleStatistics::Channel::ExhaustValveLift)] = chamber->getExhaustValveLift();
+    }
+
+    m_cycleStatistics.addSample(
+        m_engine->getOutputCrankshaft()->getCycleAngle(),
+        m_engine->isSpinningCw() ? 1 : -1,
+        values);
+}
+
+void Simulator::setAudioCacheEnabled(bool enabled, const CycleAudioCache::Parameters &params) {
+    m_audioCacheEnabled = enabled;
+    m_audioCacheParameters = params;
+    initializeAudioCache();
+}
+
+void Simulator::initializeAudioCache() {
+    if (!m_audioCacheEnabled || !m_audioEnabled || m_engine == nullptr) {
+        m_audioCache.destroy();
+        return;
+    }
+
+    m_audioCache.initialize(m_audioCacheParameters, m_engine->getExhaustSystemCount());
+    m_audioCache.seed(m_randomSeed);
+    updateAudioCacheInputs();
+}
+
+bool Simulator::updateAudioCacheInputs() {
+    AudioCacheInputs inputs;
+    inputs.speedControl = m_engine->getSpeedControl();
+    inputs.dynoSpeed = m_dyno.m_rotationSpeed;
+    inputs.simulationSpeed = m_simulationSpeed;
+    inputs.simulationFrequency = m_simulationFrequency;
+    inputs.ignition = m_engine->getIgnitionModule()->m_enabled;
+    inputs.starter = m_starterMotor.m_enabled;
+    inputs.dynoEnabled = m_dyno.m_enabled;
+    inputs.dynoHold = m_dyno.m_hold;
+    if (m_transmission != nullptr) {
+        inputs.gear = m_transmission->getGear();
+        inputs.clutchPressure = m_transmission->getClutchPressure();
+    }
+
+    const AudioCacheInputs &last = m_audioCacheInputs;
+    const bool changed = inputs.speedControl != last.speedControl
+        || inputs.clutchPressure != last.clutchPressure
+        || inputs.dynoSpeed != last.dynoSpeed
+        || inputs.simulationSpeed != last.simulationSpeed
+        || inputs.gear != last.gear
+        || inputs.simulationFrequency != last.simulationFrequency
+        || inputs.ignition != last.ignition
+        || inputs.starter != last.starter
+        || inputs.dynoEnabled != last.dynoEnabled
+        || inputs.dynoHold != last.dynoHold;
+    m_audioCacheInputs = inputs;
+
+    return changed;
+}
+
+void Simulator::processSynthesizerFrame(double *frame) {
+    if (m_audioCache.isInitialized()) {
+        m_audioCache.processLiveFrame(frame, m_cycleStatistics.isCycleStart(), m_cycleStatistics);
+        if (m_audioCache.isReplaying()) {
+            ATG_ENGINE_SIM_TRACE(
+                Simulator, Event,
+                "audio_cache replay loop_frames=%d crossfade=%d",
+                m_audioCache.getLoopFrames(),
+                m_audioCache.getCrossfadeFrames());
+        }
+    }
+
+    if (m_synthesizerTap) m_synthesizerTap(frame, m_cycleStatistics.isCycleStart());
+}
+
+void Simulator::writeTelemetry() {
+    if (m_engine->getCylinderCount() == 0) return;
+
+    CombustionChamber *chamber = m_engine->getChamber(0);
+    Crankshaft *crankshaft = m_engine->getCrankshaft(0);
+    const double timestep = getTimestep();
+
+    double cycleAngle = crankshaft->getCycleAngle();
+    if (!m_engine->isSpinningCw()) {
+        cycleAngle = 4 * constants::pi - cycleAngle;
+    }
+
+    TelemetryTap::Record record;
+    record.cycleAngle = static_cast<float>(cycleAngle);
+    record.pressureCycleAngle = static_cast<float>(crankshaft->getCycleAngle(constants::pi));
+    record.totalExhaustFlow = static_cast<float>(getTotalExhaustFlow() / timestep);
+    record.exhaustFlow = static_cast<float>(chamber->getLastTimestepExhaustFlow() / timestep);
+    record.intakeFlow = static_cast<float>(chamber->getLastTimestepIntakeFlow() / timestep);
+    record.molecules = static_cast<float>(chamber->getSystem()->n());
+    record.exhaustValveLift = static_cast<float>(chamber->getExhaustValveLift());
+    record.intakeValveLift = static_cast<float>(chamber->getIntakeValveLift());
+    record.volume = static_cast<float>(chamber->getVolume());
+    record.pressure = static_cast<float>(chamber->getSystem()->pressure());
+    record.totalPressure = static_cast<float>(
+        chamber->getSystem()->pressure() + chamber->getSystem()->dynamicPressure(-1.0, 0.0));
+    m_telemetry.write(record);
+}
+
+void Simulator::setTelemetryExport(TelemetryExport *telemetryExport) {
+    m_telemetryExport = telemetryExport;
+    EventCounters::GetTotals(&m_exportedEvents);
+}
+
+void Simulator::setFlightRecorder(FlightRecorder *recorder) {
+    if (FlightRecorder::GetCurrent() == m_flightRecorder) FlightRecorder::SetCurrent(nullptr);
+
+    m_flightRecorder = recorder;
+    sizeFlightRecorder();
+}
+
+void Simulator::sizeFlightRecorder() {
+    if (m_flightRecorder == nullptr || m_engine == nullptr) return;
+
+    // Every crankshaft, then each cylinder's piston and connecting rod
+    m_flightRecorder->setLayout(
+        m_engine->getCrankshaftCount() + 2 * m_engine->getCylinderCount(),
+        m_engine->getCylinderCount());
+}
+
+void Simulator::writeFlightRecorder() {
+    if (!m_flightRecorder->isInitialized()) return;
+
+    const FlightRecorder::Frame frame = m_flightRecorder->beginFrame();
+    FlightRecorder::FrameHeader *header = frame.header;
+    header->step = m_sessionStep;
+    header->time = m_snapshotTime + (m_currentIteration + 1) * getTimestep();
+    header->speedControl = static_cast<float>(m_engine->getSpeedControl());
+    header->throttle = static_cast<float>(m_engine->getThrottle());
+    header->clutchPressure = (m_transmission != nullptr)
+        ? static_cast<float>(m_transmission->getClutchPressure())
+        : 0.0f;
+    header->dynoSpeed = static_cast<float>(m_dyno.m_rotationSpeed);
+    header->gear = (m_transmission != nullptr) ? m_transmission->getGear() : -1;
+
+    header->flags = 0;
+    if (m_engine->getIgnitionModule()->m_enabled) header->flags |= FlightRecorder::IgnitionEnabled;
+    if (m_starterMotor.m_enabled) header->flags |= FlightRecorder::StarterEnabled;
+    if (m_dyno.m_enabled) header->flags |= FlightRecorder::DynoEnabled;
+    if (m_dyno.m_hold) header->flags |= FlightRecorder::DynoHold;
+
+    FlightRecorder::BodyState *body = frame.bodies;
+    auto writeBody = [&body](const atg_scs::RigidBody &source) {
+        body->p_x = static_cast<float>(source.p_x);
+        body->p_y = static_cast<float>(source.p_y);
+        body->theta = static_cast<float>(source.theta);
+        body->v_x = static_cast<float>(source.v_x);
+        body->v_y = static_cast<float>(source.v_y);
+        body->v_theta = static_cast<float>(source.v_theta);
+        ++body;
+    };
+
+    const int cylinders = m_engine->getCylinderCount();
+    for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
+        writeBody(m_engine->getCrankshaft(i)->m_body);
+    }
+
+    for (int i = 0; i < cylinders; ++i) {
+        writeBody(m_engine->getPiston(i)->m_body);
+        writeBody(m_engine->getConnectingRod(i)->m_body);
+    }
+
+    for (int i = 0; i < cylinders; ++i) {
+        CombustionChamber *chamber = m_engine->getChamber(i);
+        const GasSystem *gas = chamber->getSystem();
+
+        FlightRecorder::ChamberState &state = frame.chambers[i];
+        state.pressure = static_cast<float>(gas->pressure());
+        state.temperature = static_cast<float>(gas->temperature());
+        state.molecules = static_cast<float>(gas->n());
+        state.volume = static_cast<float>(chamber->getVolume());
+        state.intakeFlow = static_cast<float>(chamber->getLastTimestepIntakeFlow());
+        state.exhaustFlow = static_cast<float>(chamber->getLastTimestepExhaustFlow());
+    }
+
+    m_flightRecorder->commit();
+}
+
+void Simulator::setEngineController(EngineController *controller) {
+    // Outputs left behind by the previous controller are neutralized
+    if (m_engineController != nullptr && m_engine != nullptr) {
+        m_engineController->reset(m_engine);
+    }
+
+    m_engineController = controller;
+    if (controller != nullptr && m_engine != nullptr) {
+        controller->reset(m_engine);
+    }
+}
+
+void Simulator::writeTelemetryExport() {
+    const int cylinders = std::min(m_engine->getCylinderCount(), TelemetryExport::MaxCylinders);
+    m_telemetryExport->setLayout(cylinders, getTimestep() * m_telemetryExport->getDecimation());
+
+    TelemetryExport::Sample sample;
+    sample.index = 0;
+    sample.time = m_snapshotTime + (m_currentIteration + 1) * getTimestep();
+    sample.rpm = static_cast<float>(m_engine->getRpm());
+    sample.throttle = static_cast<float>(m_engine->getThrottle());
+    sample.dynoTorque = static_cast<float>(m_dyno.getTorque());
+    const Engine::Aggregates &aggregates = m_engine->getAggregates();
+    sample.manifoldPressure = static_cast<float>(aggregates.manifoldPressure);
+    sample.intakeAfr = static_cast<float>(aggregates.intakeAfr);
+    sample.vehicleSpeed = (m_vehicle != nullptr) ? static_cast<float>(m_vehicle->getSpeed()) : 0.0f;
+    sample.gear = (m_transmission != nullptr) ? m_transmission->getGear() : -1;
+
+    sample.flags = 0;
+    if (m_engine->getIgnitionModule()->m_enabled) sample.flags |= TelemetryExport::IgnitionEnabled;
+    if (m_starterMotor.m_enabled) sample.flags |= TelemetryExport::StarterEnabled;
+    if (m_dyno.m_enabled) sample.flags |= TelemetryExport::DynoEnabled;
+
+    for (int i = 0; i < TelemetryExport::MaxCylinders; ++i) {
+        sample.cylinderPressure[i] = (i < cylinders)
+            ? static_cast<float>(m_engine->getChamber(i)->getSystem()->pressure())
+            : 0.0f;
+    }
+
+    EventCounters::Totals events;
+    EventCounters::GetTotals(&events);
+    const EventCounters::Totals delta = events.since(m_exportedEvents);
+    for (int i = 0; i < EventCounters::CounterCount; ++i) {
+        sample.events[i] = static_cast<uint32_t>(delta.values[i]);
+    }
+
+    m_exportedEvents = events;
+    m_telemetryExport->write(sample);
+}
+
 double Simulator::getTotalExhaustFlow() const {
     return 0.0;
 }
 
+void Simulator::setSimulationFrequency(int frequency) {
+    if (m_inputSession != nullptr) return;
+
+    m_targetSimulationFrequency = std::max(1, frequency);
+    updateFidelity();
+}
+
+void Simulator::setRigidBodyInterval(int steps) {
+    m_multirate.initialize(m_engine, getVehicleMass(), steps);
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "rigid_body_interval steps=%d",
+        m_multirate.getInterval());
+}
+
+void Simulator::setFidelity(Fidelity fidelity) {
+    if (fidelity == m_fidelity || m_inputSession != nullptr) return;
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "fidelity old=%d new=%d",
+        static_cast<int>(m_fidelity),
+        static_cast<int>(fidelity));
+    m_fidelity = fidelity;
+    updateFidelity();
+}
+
+void Simulator::updateFidelity() {
+    if (m_frameInProgress) m_fidelityUpdatePending = true;
+    else applyFidelity();
+}
+
+void Simulator::setOverloadHandlingEnabled(bool enabled) {
+    if (enabled == m_overloadHandling) return;
+
+    m_overloadHandling = enabled;
+    if (!enabled) {
+        m_synthesizer.setConcealmentPeriod(0);
+        if (m_overloadPolicy.getLevel() != OverloadPolicy::Level::None) {
+            m_overloadPolicy.reset();
+            m_synthesizer.setConvolutionFraction(1.0f);
+            updateFidelity();
+        }
+    }
+}
+
+void Simulator::setSpeculativeStepping(bool enabled, const SpeculativeStepping::Parameters &params) {
+    m_speculative.initialize(params);
+    m_speculativeStepping = enabled;
+
+    if (!enabled) {
+        m_speculativeCheckpointed = false;
+        if (m_speculativeRefinement > 1) {
+            m_speculativeRefinement = 1;
+            updateFidelity();
+        }
+    }
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "speculative_stepping enabled=%d refinement=%d hold_frames=%d",
+        enabled ? 1 : 0,
+        params.refinement,
+        params.holdFrames);
+}
+
+void Simulator::beginSpeculativeFrame() {
+    m_speculativeCheckpointed = false;
+    m_speculativeSilentSteps = 0;
+
+    const bool active = m_speculativeStepping && m_inputSession == nullptr;
+    if (m_speculativeRefinement > 1 && (!active || --m_speculativeHoldFrames <= 0)) {
+        m_speculativeRefinement = 1;
+        applyFidelity();
+    }
+
+    if (!active) return;
+
+    // A refined frame has nothing finer to fall back to
+    const bool refined = m_speculativeRefinement > 1;
+    m_speculative.recordFrame(refined);
+    if (!refined && !m_audioCache.isReplaying()) {
+        m_speculativeCheckpointed = captureSpeculativeCheckpoint();
+    }
+}
+
+bool Simulator::rollBackSpeculativeFrame(SpeculativeStepping::Failure failure) {
+    const int validSteps = m_currentIteration;
+    m_speculativeCheckpointed = false;
+
+    // Replayed steps have no physics to redo
+    if (m_frameReplayedSteps > 0) {
+        m_speculative.recordFailure(failure, false);
+        return false;
+    }
+
+    // The checkpoint predates any control changes so far this frame
+    constexpr int ControlCount = ControlQueue::ControlCount;
+    double controls[ControlCount];
+    for (int i = 0; i < ControlCount; ++i) {
+        controls[i] = getControl(static_cast<ControlQueue::Control>(i));
+    }
+
+    // Everything staged so far passed validation
+    if (m_audioEnabled) flushSynthesizerFrames();
+
+    if (!restoreSpeculativeCheckpoint()) {
+        m_speculative.recordFailure(failure, false);
+        return false;
+    }
+
+    for (int i = 0; i < ControlCount; ++i) {
+        const ControlQueue::Control control = static_cast<ControlQueue::Control>(i);
+        if (getControl(control) != controls[i]) setControl(control, controls[i]);
+    }
+
+    const SpeculativeStepping::Parameters &params = m_speculative.getParameters();
+    const int refinement = std::max(params.refinement, 2);
+    m_speculativeRefinement = refinement;
+    m_speculativeHoldFrames = std::max(params.holdFrames, 1);
+    applyFidelity();
+
+    m_steps *= refinement;
+    m_speculativeSilentSteps = validSteps * refinement;
+    m_currentIteration = 0;
+    clearIntakeFlows();
+
+    m_speculative.recordFailure(failure, true);
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "speculative_rollback failure=%s step=%d frequency=%d",
+        SpeculativeStepping::GetFailureName(failure),
+        validSteps,
+        m_simulationFrequency);
+
+    return true;
+}
+
+double Simulator::getControl(ControlQueue::Control control) {
+    switch (control) {
+        case ControlQueue::Control::Throttle:
+            return m_engine->getSpeedControl();
+        case ControlQueue::Control::Clutch:
+            return (m_transmission != nullptr) ? m_transmission->getClutchPressure() : 0.0;
+        case ControlQueue::Control::Starter:
+            return m_starterMotor.m_enabled ? 1.0 : 0.0;
+        case ControlQueue::Control::Ignition:
+            return m_engine->getIgnitionModule()->m_enabled ? 1.0 : 0.0;
+        case ControlQueue::Control::Gear:
+            return (m_transmission != nullptr) ? m_transmission->getGear() : -1.0;
+        case ControlQueue::Control::DynoEnabled:
+            return m_dyno.m_enabled ? 1.0 : 0.0;
+        case ControlQueue::Control::DynoHold:
+            return m_dyno.m_hold ? 1.0 : 0.0;
+        case ControlQueue::Control::DynoSpeed:
+            return m_dyno.m_rotationSpeed;
+    }
+
+    return 0.0;
+}
+
+void Simulator::updateOverload() {
+    if (!m_overloadHandling) return;
+
+    // One engine cycle is what's repeated if the device underruns
+    const double speed = std::abs(m_engine->getSpeed());
+    m_synthesizer.setConcealmentPeriod((speed > 0) ? 4 * constants::pi / speed : 0.0);
+
+    // Offline producers are paced by the reader; there's no load to shed
+    if (m_offline) return;
+
+    const unsigned long long concealed = m_synthesizer.getConcealedSampleCount();
+    const bool underrun = concealed != m_concealedSamples;
+    m_concealedSamples = concealed;
+
+    const double targetLatency = getSynthesizerInputLatencyTarget();
+    const double headroom = (targetLatency > 0) ? m_synthesizer.getLatency() / targetLatency : 1.0;
+    if (!m_overloadPolicy.update(headroom, underrun)) return;
+
+    const OverloadPolicy::Level level = m_overloadPolicy.getLevel();
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "overload level=%s headroom=%.3f underrun=%d",
+        OverloadPolicy::GetLevelName(level),
+        headroom,
+        underrun ? 1 : 0);
+
+    m_synthesizer.setConvolutionFraction(
+        (level >= OverloadPolicy::Level::Convolution) ? ShedConvolutionFraction : 1.0f);
+    updateFidelity();
+}
+
+void Simulator::applyFidelity() {
+    m_simulationFrequency = (m_fidelity == Fidelity::Preview)
+        ? std::max(
+            std::min(m_targetSimulationFrequency, MinPreviewSimulationFrequency),
+            m_targetSimulationFrequency / PreviewFrequencyDivisor)
+        : m_targetSimulationFrequency;
+    m_simulationFrequency *= m_speculativeRefinement;
+
+    if (m_audioEnabled) {
+        m_synthesizer.setInputSampleRate(m_simulationFrequency * m_simulationSpeed);
+    }
+}
+
+void Simulator::setOfflineMode(bool offline) {
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "offline_mode old=%d new=%d", m_offline ? 1 : 0, offline ? 1 : 0);
+    m_offline = offline;
+    m_synthesizer.setOfflineMode(offline);
+}
+
+void Simulator::setRandomSeed(uint64_t seed) {
+    m_randomSeed = seed;
+    m_synthesizer.setRandomSeed(seed);
+    m_audioCache.seed(seed);
+
+    if (m_engine != nullptr) {
+        for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+            m_engine->getChamber(i)->seedRandom(seed);
+        }
+    }
+}
+
 int Simulator::readAudioOutput(int samples, int16_t *target) {
     return m_synthesizer.readAudioOutput(samples, target);
 }
 
+int Simulator::readAudioOutput(int samples, float *target) {
+    return m_synthesizer.readAudioOutput(samples, target);
+}
+
 void Simulator::endFrame() {
-    m_synthesizer.endInputBlock();
+    if (m_inputSession != nullptr && m_inputSession->isRecording()) m_inputSession->flush();
+    if (m_synthesizerCapture != nullptr && m_synthesizerCapture->isRecording()) m_synthesizerCapture->flush();
+    if (m_audioEnabled) m_synthesizer.endInputBlock();
+    publishSnapshot();
+    m_frameInProgress = false;
+}
+
+void Simulator::publishSnapshot() {
+    m_snapshotTime += m_currentIteration * getTimestep();
+
+    SimulationSnapshot snapshot;
+    snapshot.frame = m_snapshotFrame++;
+    snapshot.time = m_snapshotTime;
+    snapshot.manifoldPressure = units::pressure(1.0, units::atm);
+
+    if (m_engine != nullptr) {
+        snapshot.rpm = m_engine->getRpm();
+        snapshot.redline = m_engine->getRedline();
+        snapshot.displacement = m_engine->getDisplacement();
+        const Engine::Aggregates &aggregates = m_engine->getAggregates();
+        snapshot.manifoldPressure = aggregates.manifoldPressure;
+        snapshot.intakeFlowRate = aggregates.intakeFlowRate;
+        snapshot.intakeAfr = aggregates.intakeAfr;
+        snapshot.exhaustO2 = aggregates.exhaustO2;
+        snapshot.totalFuelConsumed = aggregates.totalFuelMassConsumed / m_engine->getFuel()->getDensity();
+        snapshot.totalFuelMassConsumed = aggregates.totalFuelMassConsumed;
+        snapshot.ignitionEnabled = m_engine->getIgnitionModule()->m_enabled;
+
+        snapshot.cylinderCount = m_engine->getCylinderCount();
+        const int cylinders = std::min(snapshot.cylinderCount, SimulationSnapshot::MaxCylinders);
+        for (int i = 0; i < cylinders; ++i) {
+            snapshot.cylinderTemperature[i] = m_engine->getChamber(i)->getSystem()->temperature();
+        }
+    }
+
+    if (m_vehicle != nullptr) {
+        snapshot.speed = m_vehicle->getSpeed();
+        snapshot.travelledDistance = m_vehicle->getTravelledDistance();
+    }
+
+    if (m_transmission != nullptr) {
+        snapshot.gear = m_transmission->getGear();
+        snapshot.clutchPressure = m_transmission->getClutchPressure();
+    }
+
+    snapshot.filteredDynoTorque = getFilteredDynoTorque();
+    snapshot.imep = m_cycleStatistics.getMeanImep();
+    snapshot.imepCoefficientOfVariation = m_cycleStatistics.getImepCoefficientOfVariation();
+    snapshot.peakCylinderPressure = m_cycleStatistics.getMeanPeakPressure();
+    snapshot.dynoPower = getDynoPower();
+    snapshot.dynoSpeed = m_dyno.m_rotationSpeed;
+    snapshot.dynoEnabled = m_dyno.m_enabled;
+    snapshot.dynoHold = m_dyno.m_hold;
+    snapshot.starterEnabled = m_starterMotor.m_enabled;
+
+    snapshot.simulationFrequency = m_simulationFrequency;
+    snapshot.simulationSpeed = m_simulationSpeed;
+    snapshot.fluidSimulationSteps = getFluidSimulationSteps();
+    snapshot.audioCacheReplaying = m_audioCache.isReplaying();
+    snapshot.overloadLevel = static_cast<int>(m_overloadPolicy.getLevel());
+
+    if (m_audioEnabled && m_synthesizer.isAnalysisEnabled()) {
+        // Every cylinder fires once per two revolutions
+        AudioAnalyzer &analyzer = m_synthesizer.analyzer();
+        if (m_engine != nullptr) {
+            analyzer.setFiringFrequency(
+                static_cast<float>(std::abs(snapshot.rpm) / 60.0 * snapshot.cylinderCount / 2.0));
+        }
+
+        static_assert(
+            SimulationSnapshot::AudioHarmonics == AudioAnalyzer::Harmonics,
+            "snapshot and analyzer harmonic counts differ");
+
+        const AudioAnalyzer::Metrics &metrics = analyzer.getMetrics();
+        snapshot.audioAnalyzed = metrics.windows > 0;
+        snapshot.audioLoudness = metrics.loudness;
+        snapshot.audioSpectralCentroid = metrics.spectralCentroid;
+        snapshot.audioRoughness = metrics.roughness;
+        for (int i = 0; i < SimulationSnapshot::AudioHarmonics; ++i) {
+            snapshot.audioHarmonics[i] = metrics.harmonics[i];
+        }
+    }
+
+    m_snapshots.write(snapshot);
 }
 
 void Simulator::destroy() {
-    DebugTrace::Log("simulator", "destroy begin");
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "destroy begin");
     m_synthesizer.destroy();
-    DebugTrace::Log("simulator", "destroy complete");
+    m_audioCache.destroy();
+    m_telemetry.destroy();
+    m_multirate.destroy();
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "destroy complete");
 }
 
 void Simulator::startAudioRenderingThread() {
-    DebugTrace::Log("simulator", "startAudioRenderingThread");
+    if (!m_audioEnabled) return;
+
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "startAudioRenderingThread");
     m_synthesizer.startAudioRenderingThread();
 }
 
 void Simulator::endAudioRenderingThread() {
-    DebugTrace::Log("simulator", "endAudioRenderingThread");
+    ATG_ENGINE_SIM_TRACE(Simulator, Event, "endAudioRenderingThread");
     m_synthesizer.endAudioRenderingThread();
 }
 
@@ -190,14 +937,7 @@ double Simulator::getSynthesizerInputLatencyTarget() const {
 }
 
 double Simulator::getFilteredDynoTorque() const {
-    if (m_dynoTorqueSamples == nullptr) return 0;
-
-    double averageTorque = 0;
-    for (int i = 0; i < DynoTorqueSamples; ++i) {
-        averageTorque += m_dynoTorqueSamples[i];
-    }
-
-    return averageTorque / DynoTorqueSamples;
+    return m_cycleStatistics.getAverage(CycleStatistics::Channel::Torque);
 }
 
 double Simulator::getDynoPower() const {
@@ -210,19 +950,222 @@ double Simulator::getAverageOutputSignal() const {
     return 0.0;
 }
 
+int Simulator::getFluidSimulationSteps() const {
+    return 0;
+}
+
+void Simulator::setLatencyProfile(const LatencyProfile &profile) {
+    m_latencyProfile = profile;
+    m_targetSynthesizerLatency = profile.targetLatency;
+    reinitializeSynthesizer();
+}
+
+void Simulator::setSynthesizerOutputChannelCount(int channels) {
+    m_synthesizerOutputChannels = std::max(0, channels);
+    reinitializeSynthesizer();
+}
+
+void Simulator::setAudioSampleRate(double sampleRate) {
+    if (sampleRate <= 0 || sampleRate == m_audioSampleRate) return;
+
+    m_audioSampleRate = sampleRate;
+    reinitializeSynthesizer();
+}
+
+void Simulator::reinitializeSynthesizer() {
+    if (m_engine == nullptr || !m_audioEnabled) return;
+
+    const Synthesizer::AudioParameters audioParams = m_synthesizer.getAudioParameters();
+
+    m_synthesizer.destroy();
+    initializeSynthesizer();
+    m_synthesizer.setAudioParameters(audioParams);
+    m_synthesizer.setRandomSeed(m_randomSeed);
+    m_synthesizer.setOfflineMode(m_offline);
+}
+
 void Simulator::initializeSynthesizer() {
+    if (!m_audioEnabled) return;
+
     Synthesizer::Parameters synthParams;
-    synthParams.audioBufferSize = 44100;
-    synthParams.audioSampleRate = 44100;
-    synthParams.inputBufferSize = 44100;
+    synthParams.audioBufferSize = m_latencyProfile.audioBufferSize;
+    synthParams.audioSampleRate = static_cast<float>(m_audioSampleRate);
+    synthParams.inputBufferSize = m_latencyProfile.inputBufferSize;
+    synthParams.renderLimit = m_latencyProfile.renderLimit;
+    synthParams.outputChannelCount = m_synthesizerOutputChannels;
     synthParams.inputChannelCount = m_engine->getExhaustSystemCount();
     synthParams.inputSampleRate = static_cast<float>(getSimulationFrequency());
     m_synthesizer.initialize(synthParams);
+
+    initializeAudioCache();
 }
 
 void Simulator::simulateStep_() {
 }
 
+void Simulator::applyControl(const ControlQueue::Event &event) {
+    if (m_inputSession != nullptr) {
+        if (m_inputSession->isReplaying()) return;
+        m_inputSession->write(m_sessionStep, event.control, event.value);
+    }
+
+    setControl(event.control, event.value);
+
+    LatencyProbe *probe = m_synthesizer.getLatencyProbe();
+    if (event.probe && probe != nullptr && probe->isWaiting(LatencyProbe::Stage::Applied)) {
+        probe->mark(LatencyProbe::Stage::Applied);
+    }
+}
+
+void Simulator::setInputSession(InputSession *session) {
+    if (m_inputSession != nullptr) {
+        m_inputSession = nullptr;
+        setOverloadHandlingEnabled(m_sessionOverloadHandling);
+    }
+
+    if (session == nullptr) return;
+
+    if (session->isReplaying()) {
+        setSimulationFrequency(static_cast<int>(std::lround(session->getSimulationFrequency())));
+    }
+
+    setFidelity(Fidelity::Full);
+    setRandomSeed(session->isReplaying() ? session->getSeed() : m_randomSeed);
+
+    m_sessionOverloadHandling = m_overloadHandling;
+    setOverloadHandlingEnabled(false);
+
+    m_inputSession = session;
+    m_sessionStep = 0;
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "input_session %s seed=%llu frequency=%d",
+        session->isReplaying() ? "replay" : "record",
+        static_cast<unsigned long long>(m_randomSeed),
+        m_targetSimulationFrequency);
+}
+
+void Simulator::setControl(ControlQueue::Control control, double value) {
+    switch (control) {
+        case ControlQueue::Control::Throttle:
+            m_engine->setSpeedControl(value);
+            break;
+        case ControlQueue::Control::Clutch:
+            if (m_transmission != nullptr) m_transmission->setClutchPressure(value);
+            break;
+        case ControlQueue::Control::Starter:
+            m_starterMotor.m_enabled = value > 0.5;
+            break;
+        case ControlQueue::Control::Ignition:
+            m_engine->getIgnitionModule()->m_enabled = value > 0.5;
+            break;
+        case ControlQueue::Control::Gear:
+            if (m_transmission != nullptr) m_transmission->changeGear(static_cast<int>(std::lround(value)));
+            break;
+        case ControlQueue::Control::DynoEnabled:
+            m_dyno.m_enabled = value > 0.5;
+            break;
+        case ControlQueue::Control::DynoHold:
+            m_dyno.m_hold = value > 0.5;
+            break;
+        case ControlQueue::Control::DynoSpeed:
+            m_dyno.m_rotationSpeed = value;
+            break;
+    }
+}
+
+void Simulator::setControlSource(ControlQueue *source) {
+    m_controlSource = source;
+    for (int i = 0; i < ControlQueue::ControlCount; ++i) {
+        m_controlGlides[i].reset(0.0f);
+        m_controlGlideTimes[i] = 0.0;
+    }
+}
+
+void Simulator::drainControls() {
+    // Live controls are dropped while a replay stands in for them
+    if (m_inputSession != nullptr && m_inputSession->isReplaying()) {
+        while (m_controls.peek() != nullptr) m_controls.pop();
+        if (m_controlSource != nullptr) {
+            while (m_controlSource->peek() != nullptr) m_controlSource->pop();
+        }
+
+        const InputSession::Event *event;
+        while ((event = m_inputSession->next(m_sessionStep)) != nullptr) {
+            setControl(event->control, event->value);
+        }
+
+        return;
+    }
+
+    drainControls(&m_controls, false);
+    if (m_controlSource != nullptr) {
+        drainControls(m_controlSource, true);
+        glideControls();
+    }
+}
+
+void Simulator::drainControls(ControlQueue *queue, bool source) {
+    const double window =
+        std::chrono::duration<double>(m_controlWindowEnd - m_controlWindowStart).count();
+
+    const ControlQueue::Event *event;
+    while ((event = queue->peek()) != nullptr) {
+        if (!event->immediate) {
+            // Pushed after this frame started; its place is in the next one
+            if (event->time > m_controlWindowEnd) break;
+
+            int step = 0;
+            if (window > 0 && event->time > m_controlWindowStart) {
+                const double offset =
+                    std::chrono::duration<double>(event->time - m_controlWindowStart).count();
+                step = static_cast<int>(m_steps * offset / window);
+            }
+
+            if (step > m_currentIteration) break;
+        }
+
+        const int i = static_cast<int>(event->control);
+        if (source && event->smoothing > 0) {
+            // Glides start from wherever the control is now
+            if (m_controlGlideTimes[i] <= 0) {
+                m_controlGlides[i].reset(static_cast<float>(getControl(event->control)));
+            }
+
+            m_controlGlides[i].setTarget(static_cast<float>(event->value));
+            m_controlGlideTimes[i] = event->smoothing;
+        }
+        else {
+            m_controlGlideTimes[i] = 0.0;
+            applyControl(*event);
+        }
+
+        queue->pop();
+    }
+}
+
+void Simulator::glideControls() {
+    for (int i = 0; i < ControlQueue::ControlCount; ++i) {
+        SmoothedParameter &glide = m_controlGlides[i];
+        if (m_controlGlideTimes[i] <= 0) continue;
+
+        const float tolerance = 1E-4f * std::max(1.0f, std::abs(glide.getTarget()));
+        const float fraction = SmoothedParameter::GlideFraction(
+            1, static_cast<float>(m_simulationFrequency), static_cast<float>(m_controlGlideTimes[i]));
+        if (!glide.glide(fraction, tolerance)) {
+            m_controlGlideTimes[i] = 0.0;
+            continue;
+        }
+
+        // Through applyControl() so a recorded session replays every step
+        ControlQueue::Event event;
+        event.control = static_cast<ControlQueue::Control>(i);
+        event.value = glide.getValue();
+        applyControl(event);
+    }
+}
+
 void Simulator::updateFilteredEngineSpeed(double dt) {
     const double alpha = dt / (100 + dt);
     m_filteredEngineSpeed = alpha * m_filteredEngineSpeed + (1 - alpha) * m_engine->getRpm();
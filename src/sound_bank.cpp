@@ -0,0 +1,223 @@
+#include "../include/sound_bank.h"
+
+#include "../include/mapped_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+static_assert(
+    std::is_trivially_copyable<Synthesizer::AudioParameters>::value,
+    "audio parameters are stored as raw bytes");
+
+// Copies fields out of the mapped file; an overrun latches the failure flag
+class Reader {
+    public:
+        Reader(const char *data, size_t size) {
+            m_data = data;
+            m_size = size;
+            m_offset = 0;
+            m_failed = false;
+        }
+
+        bool read(void *target, size_t size) {
+            if (m_failed || m_size - m_offset < size) {
+                m_failed = true;
+                return false;
+            }
+
+            std::memcpy(target, m_data + m_offset, size);
+            m_offset += size;
+            return true;
+        }
+
+        bool readString(std::string *s) {
+            uint32_t length = 0;
+            if (!read(&length, sizeof(length)) || m_size - m_offset < length) {
+                m_failed = true;
+                return false;
+            }
+
+            s->assign(m_data + m_offset, length);
+            m_offset += length;
+            return true;
+        }
+
+        bool failed() const { return m_failed; }
+        bool atEnd() const { return m_offset == m_size; }
+
+    private:
+        const char *m_data;
+        size_t m_size;
+        size_t m_offset;
+        bool m_failed;
+};
+} /* namespace */
+
+SoundBank::SoundBank() {
+    m_channels = 0;
+    m_framesPerCycle = 0;
+    m_cyclesPerCell = 0;
+    m_inputSampleRate = 0.0;
+}
+
+SoundBank::~SoundBank() {
+    /* void */
+}
+
+void SoundBank::initialize(
+    const std::vector<double> &rpms,
+    const std::vector<double> &throttles,
+    int channels,
+    int framesPerCycle,
+    int cyclesPerCell)
+{
+    m_rpms = rpms;
+    m_throttles = throttles;
+    m_channels = std::max(channels, 0);
+    m_framesPerCycle = std::max(framesPerCycle, 2);
+    m_cyclesPerCell = std::max(cyclesPerCell, 1);
+
+    m_impulseResponses.assign(m_channels, ImpulseResponse());
+    m_samples.assign(
+        m_rpms.size() * m_throttles.size() * getCellFrames() * m_channels, 0.0f);
+}
+
+void SoundBank::destroy() {
+    m_rpms.clear();
+    m_throttles.clear();
+    m_impulseResponses.clear();
+    m_samples.clear();
+    m_samples.shrink_to_fit();
+    m_channels = 0;
+}
+
+float *SoundBank::getCell(int rpmIndex, int throttleIndex) {
+    const size_t cell = (size_t)rpmIndex * m_throttles.size() + throttleIndex;
+    return m_samples.data() + cell * getCellFrames() * m_channels;
+}
+
+const float *SoundBank::getCell(int rpmIndex, int throttleIndex) const {
+    const size_t cell = (size_t)rpmIndex * m_throttles.size() + throttleIndex;
+    return m_samples.data() + cell * getCellFrames() * m_channels;
+}
+
+void SoundBank::sample(int rpmIndex, int throttleIndex, double phase, double *frame) const {
+    const int last = getCellFrames() - 1;
+    const double position = std::min(std::max(phase * m_framesPerCycle, 0.0), (double)last);
+    const int i0 = std::min(static_cast<int>(position), last);
+    const int i1 = std::min(i0 + 1, last);
+    const double s = position - i0;
+
+    const float *cell = getCell(rpmIndex, throttleIndex);
+    const float *f0 = cell + (size_t)i0 * m_channels;
+    const float *f1 = cell + (size_t)i1 * m_channels;
+    for (int c = 0; c < m_channels; ++c) {
+        frame[c] = f0[c] + s * (f1[c] - f0[c]);
+    }
+}
+
+void SoundBank::setImpulseResponse(int channel, const std::string &filename, double volume) {
+    m_impulseResponses[channel].filename = filename;
+    m_impulseResponses[channel].volume = volume;
+}
+
+bool SoundBank::save(const std::string &path) const {
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.channels = m_channels;
+    header.rpmCount = static_cast<int32_t>(m_rpms.size());
+    header.throttleCount = static_cast<int32_t>(m_throttles.size());
+    header.framesPerCycle = m_framesPerCycle;
+    header.cyclesPerCell = m_cyclesPerCell;
+    header.reserved = 0;
+    header.inputSampleRate = m_inputSampleRate;
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    bool written =
+        std::fwrite(&header, sizeof(Header), 1, file) == 1
+        && std::fwrite(m_rpms.data(), sizeof(double), m_rpms.size(), file) == m_rpms.size()
+        && std::fwrite(m_throttles.data(), sizeof(double), m_throttles.size(), file) == m_throttles.size()
+        && std::fwrite(&m_audioParameters, sizeof(m_audioParameters), 1, file) == 1;
+
+    for (const ImpulseResponse &response : m_impulseResponses) {
+        const uint32_t length = static_cast<uint32_t>(response.filename.size());
+        written = written
+            && std::fwrite(&length, sizeof(length), 1, file) == 1
+            && std::fwrite(response.filename.data(), 1, length, file) == length
+            && std::fwrite(&response.volume, sizeof(double), 1, file) == 1;
+    }
+
+    written = written
+        && std::fwrite(m_samples.data(), sizeof(float), m_samples.size(), file) == m_samples.size();
+
+    return (std::fclose(file) == 0) && written;
+}
+
+bool SoundBank::load(const std::string &path) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    Reader reader(file.getData(), file.getSize());
+
+    Header header;
+    if (!reader.read(&header, sizeof(Header))) return false;
+    else if (header.magic != Magic || header.version != Version) return false;
+    else if (header.channels < 0 || header.rpmCount < 0 || header.throttleCount < 0) return false;
+    else if (header.framesPerCycle < 2 || header.cyclesPerCell < 1) return false;
+
+    // Every count is bounded by the bytes that have to follow it
+    std::vector<double> rpms, throttles;
+    const size_t grid = (size_t)header.rpmCount + header.throttleCount;
+    if (grid * sizeof(double) > file.getSize()) return false;
+
+    rpms.resize(header.rpmCount);
+    throttles.resize(header.throttleCount);
+    reader.read(rpms.data(), rpms.size() * sizeof(double));
+    reader.read(throttles.data(), throttles.size() * sizeof(double));
+
+    Synthesizer::AudioParameters audioParameters;
+    reader.read(&audioParameters, sizeof(audioParameters));
+
+    // A length and a volume per channel at the least
+    if ((size_t)header.channels > file.getSize() / (sizeof(uint32_t) + sizeof(double))) return false;
+
+    std::vector<ImpulseResponse> impulseResponses(header.channels);
+    for (ImpulseResponse &response : impulseResponses) {
+        reader.readString(&response.filename);
+        reader.read(&response.volume, sizeof(double));
+    }
+
+    if (reader.failed()) return false;
+
+    // Sized in double first so a corrupt header can't overflow the product
+    const double cellSamples =
+        ((double)header.cyclesPerCell + 1) * header.framesPerCycle * header.channels;
+    if ((double)header.rpmCount * header.throttleCount * cellSamples > file.getSize() / sizeof(float)) {
+        return false;
+    }
+
+    const size_t samples =
+        (size_t)header.rpmCount * header.throttleCount * static_cast<size_t>(cellSamples);
+
+    std::vector<float> data(samples);
+    reader.read(data.data(), samples * sizeof(float));
+    if (reader.failed() || !reader.atEnd()) return false;
+
+    m_rpms = std::move(rpms);
+    m_throttles = std::move(throttles);
+    m_channels = header.channels;
+    m_framesPerCycle = header.framesPerCycle;
+    m_cyclesPerCell = header.cyclesPerCell;
+    m_inputSampleRate = header.inputSampleRate;
+    m_audioParameters = audioParameters;
+    m_impulseResponses = std::move(impulseResponses);
+    m_samples = std::move(data);
+
+    return true;
+}
@@ -0,0 +1,217 @@
+#include "../include/sound_bank_baker.h"
+
+#include "../include/constants.h"
+#include "../include/debug_trace.h"
+#include "../include/impulse_response.h"
+#include "../include/job_system.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+void SoundBankBaker::CycleCapture::begin(int channels, int cycles, int maxFrames) {
+    m_channels = std::max(channels, 0);
+    m_cycles = std::max(cycles, 1);
+    m_maxFrames = std::max(maxFrames, 1);
+    m_complete = false;
+
+    m_frames.clear();
+    m_frames.reserve((size_t)m_maxFrames * m_channels);
+    m_cycleStarts.clear();
+}
+
+void SoundBankBaker::CycleCapture::addFrame(const double *frame, bool cycleStart) {
+    if (m_complete || m_channels <= 0) return;
+
+    const int frames = static_cast<int>(m_frames.size() / m_channels);
+    if (cycleStart) m_cycleStarts.push_back(frames);
+
+    if (m_cycleStarts.empty() || frames >= m_maxFrames) return;
+
+    m_frames.insert(m_frames.end(), frame, frame + m_channels);
+
+    // The frame that starts the cycle after the continuation closes it
+    if (static_cast<int>(m_cycleStarts.size()) == m_cycles + 2) m_complete = true;
+}
+
+void SoundBankBaker::CycleCapture::normalize(int framesPerCycle, float *output) const {
+    if (!m_complete) return;
+
+    const int last = static_cast<int>(m_frames.size() / m_channels) - 1;
+    for (int k = 0; k <= m_cycles; ++k) {
+        const int start = m_cycleStarts[k];
+        const double length = m_cycleStarts[k + 1] - start;
+
+        for (int j = 0; j < framesPerCycle; ++j) {
+            const double position = start + j * length / framesPerCycle;
+            const int i0 = std::min(static_cast<int>(position), last);
+            const int i1 = std::min(i0 + 1, last);
+            const double s = position - i0;
+
+            const double *f0 = m_frames.data() + (size_t)i0 * m_channels;
+            const double *f1 = m_frames.data() + (size_t)i1 * m_channels;
+            float *out = output + ((size_t)k * framesPerCycle + j) * m_channels;
+            for (int c = 0; c < m_channels; ++c) {
+                out[c] = static_cast<float>(f0[c] + s * (f1[c] - f0[c]));
+            }
+        }
+    }
+}
+
+SoundBankBaker::SoundBankBaker() {
+    /* void */
+}
+
+SoundBankBaker::~SoundBankBaker() {
+    /* void */
+}
+
+void SoundBankBaker::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.framesPerCycle = std::max(params.framesPerCycle, 2);
+    m_parameters.cyclesPerCell = std::max(params.cyclesPerCell, 1);
+    m_parameters.threads = std::max(params.threads, 1);
+
+    std::sort(m_parameters.rpms.begin(), m_parameters.rpms.end());
+    std::sort(m_parameters.throttles.begin(), m_parameters.throttles.end());
+}
+
+SoundBankBaker::Result SoundBankBaker::run(
+    const CreateSimulator &create,
+    const ReleaseSimulator &release,
+    SoundBank *bank)
+{
+    const int throttles = static_cast<int>(m_parameters.throttles.size());
+    const int cells = static_cast<int>(m_parameters.rpms.size()) * throttles;
+
+    Result result;
+    result.cells = cells;
+
+    const int threads = std::min(m_parameters.threads, std::max(1, cells));
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "sound_bank begin cells=%d threads=%d frames_per_cycle=%d cycles=%d",
+        cells,
+        threads,
+        m_parameters.framesPerCycle,
+        m_parameters.cyclesPerCell);
+
+    std::mutex factoryLock;
+    bool bankInitialized = false;
+    std::vector<double> simulatedTimes(cells, 0.0);
+    std::vector<char> captured(cells, 0);
+    const auto t0 = std::chrono::steady_clock::now();
+
+    JobSystem::Shared().parallelFor(cells, [&](int i) {
+        Simulator *simulator = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(factoryLock);
+            simulator = create(i);
+
+            // Cells are only written once this is done, by whoever created
+            // a simulator after it
+            if (simulator != nullptr && !bankInitialized) {
+                Engine *engine = simulator->getEngine();
+                bank->initialize(
+                    m_parameters.rpms,
+                    m_parameters.throttles,
+                    engine->getExhaustSystemCount(),
+                    m_parameters.framesPerCycle,
+                    m_parameters.cyclesPerCell);
+                bank->setInputSampleRate(simulator->getSimulationFrequency());
+                bank->setAudioParameters(simulator->synthesizer().getAudioParameters());
+
+                for (int c = 0; c < engine->getExhaustSystemCount(); ++c) {
+                    const ImpulseResponse *response = engine->getExhaustSystem(c)->getImpulseResponse();
+                    if (response != nullptr) {
+                        bank->setImpulseResponse(c, response->getFilename(), response->getVolume());
+                    }
+                }
+
+                bankInitialized = true;
+            }
+        }
+
+        if (simulator == nullptr) return;
+
+        captured[i] = bakeCell(simulator, i / throttles, i % throttles, bank, &simulatedTimes[i]) ? 1 : 0;
+
+        std::lock_guard<std::mutex> lock(factoryLock);
+        release(i, simulator);
+    }, JobSystem::Priority::Normal, threads);
+
+    const auto t1 = std::chrono::steady_clock::now();
+    result.wallTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1.0E6;
+
+    for (int i = 0; i < cells; ++i) {
+        result.captured += captured[i];
+        result.simulatedTime += simulatedTimes[i];
+    }
+
+    ATG_ENGINE_SIM_TRACE(
+        Headless, Event,
+        "sound_bank complete captured=%d wall_s=%.3f",
+        result.captured,
+        result.wallTime);
+
+    return result;
+}
+
+bool SoundBankBaker::bakeCell(
+    Simulator *simulator,
+    int rpmIndex,
+    int throttleIndex,
+    SoundBank *bank,
+    double *simulatedTime) const
+{
+    Engine *engine = simulator->getEngine();
+    const double speed = std::clamp(
+        units::rpm(m_parameters.rpms[rpmIndex]), engine->getDynoMinSpeed(), engine->getDynoMaxSpeed());
+    if (speed <= 0 || bank->getChannelCount() <= 0) return false;
+
+    // Room for the cycles at up to twice their expected length
+    const double cycleSteps = 4 * constants::pi / speed * simulator->getSimulationFrequency();
+    CycleCapture capture;
+    capture.begin(
+        bank->getChannelCount(),
+        m_parameters.cyclesPerCell,
+        static_cast<int>(2 * (m_parameters.cyclesPerCell + 2) * cycleSteps));
+
+    // Replayed frames aren't the engine's own
+    simulator->setAudioCacheEnabled(false);
+
+    bool armed = false;
+    simulator->setSynthesizerTap([&](const double *frame, bool cycleStart) {
+        if (armed) capture.addFrame(frame, cycleStart);
+    });
+
+    HeadlessRunner::ControlPoint hold;
+    hold.throttle = m_parameters.throttles[throttleIndex];
+    hold.dynoSpeed = speed;
+    hold.dynoEnabled = true;
+
+    HeadlessRunner::Parameters params;
+    params.duration = m_parameters.settleTime + m_parameters.captureTime;
+    params.frameLength = m_parameters.frameLength;
+    params.schedule.push_back(hold);
+    params.stop = [&](const SimulationSnapshot &snapshot) {
+        if (snapshot.time >= m_parameters.settleTime) armed = true;
+        return capture.isComplete();
+    };
+
+    HeadlessRunner runner;
+    runner.initialize(params);
+    const HeadlessRunner::Statistics stats = runner.run(simulator);
+    runner.destroy();
+
+    simulator->setSynthesizerTap(nullptr);
+    *simulatedTime = stats.simulatedTime;
+
+    if (!capture.isComplete()) return false;
+
+    capture.normalize(m_parameters.framesPerCycle, bank->getCell(rpmIndex, throttleIndex));
+    return true;
+}
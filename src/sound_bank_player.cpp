@@ -0,0 +1,204 @@
+#include "../include/sound_bank_player.h"
+
+#include "../include/impulse_response_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+SoundBankPlayer::SoundBankPlayer() {
+    m_bank = nullptr;
+    m_inputSampleRate = 0.0;
+
+    m_rpm = 0.0;
+    m_throttle = 0.0;
+    for (Weight &weight : m_weights) weight = { 0, 0, 0.0 };
+
+    m_grain = 0;
+    m_previousGrain = -1;
+    m_phase = 0.0;
+    m_grains = 0;
+    m_blockFrames = 0;
+}
+
+SoundBankPlayer::~SoundBankPlayer() {
+    /* void */
+}
+
+void SoundBankPlayer::initialize(const SoundBank *bank, const Parameters &params) {
+    m_bank = bank;
+    m_parameters = params;
+    m_parameters.crossfade = std::min(std::max(params.crossfade, 0.0), 1.0);
+
+    if (params.inputSampleRate > 0) m_inputSampleRate = params.inputSampleRate;
+    else if (bank->getInputSampleRate() > 0) m_inputSampleRate = bank->getInputSampleRate();
+    else m_inputSampleRate = params.audioSampleRate;
+
+    const int channels = bank->getChannelCount();
+    m_frame.assign(channels, 0.0);
+    m_blend.assign(channels, 0.0);
+    m_cell.assign(channels, 0.0);
+
+    Synthesizer::Parameters synthParams;
+    synthParams.inputChannelCount = channels;
+    synthParams.inputBufferSize = 4096;
+    synthParams.audioBufferSize = 44100;
+    synthParams.inputSampleRate = static_cast<float>(m_inputSampleRate);
+    synthParams.audioSampleRate = static_cast<float>(params.audioSampleRate);
+    synthParams.initialAudioParameters = bank->getAudioParameters();
+    m_synthesizer.initialize(synthParams);
+    m_synthesizer.setOfflineMode(true);
+
+    for (int i = 0; i < channels; ++i) {
+        const SoundBank::ImpulseResponse &response = bank->getImpulseResponse(i);
+        const std::shared_ptr<const ImpulseResponseCache::Kernel> kernel = response.filename.empty()
+            ? nullptr
+            : ImpulseResponseCache::Get(response.filename, response.volume, params.audioSampleRate);
+
+        if (kernel != nullptr) m_synthesizer.initializeImpulseResponse(kernel->filter, i);
+        else m_synthesizer.initializeImpulseResponse(nullptr, 0, 0.0f, i);
+    }
+
+    // A block renders to at most half of the synthesizer's input ring
+    m_blockFrames = std::max(
+        1,
+        static_cast<int>(synthParams.inputBufferSize / 2 * m_inputSampleRate / params.audioSampleRate));
+    m_input.assign((size_t)m_blockFrames * channels, 0.0);
+
+    m_rpm = bank->getRpms().empty() ? 0.0 : bank->getRpms().front();
+    m_throttle = bank->getThrottles().empty() ? 0.0 : bank->getThrottles().back();
+    updateWeights();
+
+    m_grain = 0;
+    m_previousGrain = -1;
+    m_phase = 0.0;
+    m_grains = 0;
+}
+
+void SoundBankPlayer::destroy() {
+    m_synthesizer.destroy();
+    m_frame.clear();
+    m_blend.clear();
+    m_cell.clear();
+    m_input.clear();
+    m_bank = nullptr;
+}
+
+void SoundBankPlayer::seed(uint64_t seed) {
+    m_random.seed(seed, 0);
+    m_synthesizer.setRandomSeed(seed);
+}
+
+void SoundBankPlayer::setOperatingPoint(double rpm, double throttle) {
+    m_rpm = std::max(rpm, 0.0);
+    m_throttle = throttle;
+    updateWeights();
+}
+
+void SoundBankPlayer::generate(double *frames, int count) {
+    const int channels = (m_bank != nullptr) ? m_bank->getChannelCount() : 0;
+    if (channels <= 0 || m_bank->isEmpty()) {
+        std::fill(frames, frames + (size_t)count * channels, 0.0);
+        return;
+    }
+
+    // An engine cycle is two crank revolutions
+    const double step = m_rpm / 120.0 / m_inputSampleRate;
+    const double crossfade = m_parameters.crossfade;
+
+    for (int f = 0; f < count; ++f) {
+        while (m_phase >= 1.0) {
+            m_phase -= 1.0;
+            nextGrain();
+        }
+
+        mixCells(m_grain + m_phase, m_frame.data());
+        if (m_previousGrain >= 0 && m_phase < crossfade) {
+            mixCells(m_previousGrain + 1 + m_phase, m_blend.data());
+
+            const double w = m_phase / crossfade;
+            for (int c = 0; c < channels; ++c) {
+                m_frame[c] = w * m_frame[c] + (1 - w) * m_blend[c];
+            }
+        }
+
+        std::copy(m_frame.begin(), m_frame.end(), frames + (size_t)f * channels);
+        m_phase += step;
+    }
+}
+
+int SoundBankPlayer::render(int samples, int16_t *output) {
+    int rendered = 0;
+    int idle = 0;
+    while (rendered < samples && m_bank != nullptr && m_bank->getChannelCount() > 0) {
+        const int available = m_synthesizer.audioSamplesAvailable();
+        if (available > 0) {
+            rendered += m_synthesizer.readAudioOutput(
+                std::min(available, samples - rendered), output + rendered);
+            idle = 0;
+            continue;
+        }
+
+        // The synthesizer's resampler holds back the first few frames
+        if (++idle > 64) break;
+
+        const int frames = std::min(
+            m_blockFrames,
+            static_cast<int>(std::ceil(
+                (samples - rendered) * m_inputSampleRate / m_synthesizer.getAudioSampleRate())) + 1);
+        generate(m_input.data(), frames);
+        m_synthesizer.writeInput(m_input.data(), frames);
+        m_synthesizer.endInputBlock();
+        m_synthesizer.renderPendingAudio();
+    }
+
+    std::fill(output + rendered, output + samples, 0);
+    return rendered;
+}
+
+void SoundBankPlayer::Bracket(const std::vector<double> &axis, double x, int *i0, int *i1, double *t) {
+    *i0 = *i1 = 0;
+    *t = 0.0;
+    if (axis.size() < 2 || x <= axis.front()) return;
+    else if (x >= axis.back()) {
+        *i0 = *i1 = static_cast<int>(axis.size()) - 1;
+        return;
+    }
+
+    *i1 = static_cast<int>(std::upper_bound(axis.begin(), axis.end(), x) - axis.begin());
+    *i0 = *i1 - 1;
+    *t = (x - axis[*i0]) / (axis[*i1] - axis[*i0]);
+}
+
+void SoundBankPlayer::updateWeights() {
+    int r0, r1, t0, t1;
+    double r, t;
+    Bracket(m_bank->getRpms(), m_rpm, &r0, &r1, &r);
+    Bracket(m_bank->getThrottles(), m_throttle, &t0, &t1, &t);
+
+    m_weights[0] = { r0, t0, (1 - r) * (1 - t) };
+    m_weights[1] = { r1, t0, r * (1 - t) };
+    m_weights[2] = { r0, t1, (1 - r) * t };
+    m_weights[3] = { r1, t1, r * t };
+}
+
+void SoundBankPlayer::nextGrain() {
+    m_previousGrain = m_grain;
+    m_grain = std::min(
+        static_cast<int>(m_random.uniform() * m_bank->getCyclesPerCell()),
+        m_bank->getCyclesPerCell() - 1);
+    ++m_grains;
+}
+
+void SoundBankPlayer::mixCells(double phase, double *frame) {
+    const int channels = m_bank->getChannelCount();
+    std::fill(frame, frame + channels, 0.0);
+
+    for (const Weight &weight : m_weights) {
+        if (weight.weight <= 0) continue;
+
+        m_bank->sample(weight.rpmIndex, weight.throttleIndex, phase, m_cell.data());
+        for (int c = 0; c < channels; ++c) {
+            frame[c] += weight.weight * m_cell[c];
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include "../include/spatial_mixer.h"
+
+#include "../include/constants.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+SpatialMixer::SpatialMixer() {
+    m_sources = nullptr;
+    m_read = nullptr;
+    m_left = nullptr;
+    m_right = nullptr;
+}
+
+SpatialMixer::~SpatialMixer() {
+    assert(m_sources == nullptr);
+}
+
+void SpatialMixer::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.maxSources = std::max(1, params.maxSources);
+    m_parameters.blockSize = std::max(1, params.blockSize);
+    m_parameters.referenceDistance = std::max(params.referenceDistance, 1E-3f);
+
+    m_sources = new Source[m_parameters.maxSources];
+    m_read = new float[m_parameters.blockSize];
+    m_left = new float[m_parameters.blockSize];
+    m_right = new float[m_parameters.blockSize];
+
+    m_leveler.p_target = params.levelerTarget;
+    m_leveler.p_maxLevel = params.levelerMaxGain;
+    m_leveler.p_minLevel = params.levelerMinGain;
+    m_leveler.initializeBlockMode(
+        std::max(1, params.levelerBlockSize),
+        params.levelerLookahead,
+        OutputChannels);
+
+    m_statistics = Statistics();
+}
+
+void SpatialMixer::destroy() {
+    delete[] m_sources;
+    delete[] m_read;
+    delete[] m_left;
+    delete[] m_right;
+
+    m_sources = nullptr;
+    m_read = nullptr;
+    m_left = nullptr;
+    m_right = nullptr;
+}
+
+int SpatialMixer::addSource(Synthesizer *synthesizer) {
+    for (int i = 0; i < m_parameters.maxSources; ++i) {
+        Source &source = m_sources[i];
+        if (source.synthesizer != nullptr) continue;
+
+        // Fades in over its first block
+        source.synthesizer = synthesizer;
+        source.x = 0.0f;
+        source.y = 0.0f;
+        source.gain = 1.0f;
+        source.left = source.right = 0.0f;
+
+        return i;
+    }
+
+    return -1;
+}
+
+void SpatialMixer::removeSource(int source) {
+    if (source < 0 || source >= m_parameters.maxSources) return;
+    m_sources[source].synthesizer = nullptr;
+}
+
+int SpatialMixer::getSourceCount() const {
+    int count = 0;
+    for (int i = 0; i < m_parameters.maxSources; ++i) {
+        if (m_sources[i].synthesizer != nullptr) ++count;
+    }
+
+    return count;
+}
+
+void SpatialMixer::setSourcePosition(int source, float x, float y) {
+    if (source < 0 || source >= m_parameters.maxSources) return;
+
+    m_sources[source].x.store(x, std::memory_order_relaxed);
+    m_sources[source].y.store(y, std::memory_order_relaxed);
+}
+
+void SpatialMixer::setSourceGain(int source, float gain) {
+    if (source < 0 || source >= m_parameters.maxSources) return;
+    m_sources[source].gain.store(gain, std::memory_order_relaxed);
+}
+
+void SpatialMixer::computeGains(float x, float y, float gain, float *left, float *right) const {
+    const float distance = std::sqrt(x * x + y * y);
+    const float reference = m_parameters.referenceDistance;
+    const float attenuation = (distance > reference)
+        ? std::pow(reference / distance, m_parameters.rolloff)
+        : 1.0f;
+
+    // Sine of the bearing; straight ahead and behind are both centered
+    const float pan = (distance > 0) ? std::min(std::max(x / distance, -1.0f), 1.0f) : 0.0f;
+    const float angle = (pan + 1) * static_cast<float>(constants::pi / 4);
+
+    *left = gain * attenuation * std::cos(angle);
+    *right = gain * attenuation * std::sin(angle);
+}
+
+void SpatialMixer::mix(int frames, float *output) {
+    for (int start = 0; start < frames; start += m_parameters.blockSize) {
+        const int n = std::min(m_parameters.blockSize, frames - start);
+        mixBlock(n, output + (size_t)start * OutputChannels);
+    }
+}
+
+void SpatialMixer::mix(int frames, int16_t *output) {
+    float block[2 * 256];
+    const int blockFrames = 256;
+
+    for (int start = 0; start < frames; start += blockFrames) {
+        const int n = std::min(blockFrames, frames - start);
+        mix(n, block);
+
+        int16_t *target = output + (size_t)start * OutputChannels;
+        for (int i = 0; i < n * OutputChannels; ++i) {
+            const float s = std::round(block[i] * Synthesizer::Int16Scale);
+            target[i] = static_cast<int16_t>(std::min(std::max(s, -32768.0f), 32767.0f));
+        }
+    }
+}
+
+void SpatialMixer::mixBlock(int frames, float *output) {
+    std::fill(m_left, m_left + frames, 0.0f);
+    std::fill(m_right, m_right + frames, 0.0f);
+
+    for (int s = 0; s < m_parameters.maxSources; ++s) {
+        Source &source = m_sources[s];
+        if (source.synthesizer == nullptr) continue;
+
+        const int read = source.synthesizer->readAudioOutput(frames, m_read);
+        if (read < frames) {
+            std::fill(m_read + read, m_read + frames, 0.0f);
+            ++m_statistics.underruns;
+        }
+
+        float left, right;
+        computeGains(
+            source.x.load(std::memory_order_relaxed),
+            source.y.load(std::memory_order_relaxed),
+            source.gain.load(std::memory_order_relaxed),
+            &left,
+            &right);
+
+        const float leftStep = (left - source.left) / frames;
+        const float rightStep = (right - source.right) / frames;
+        const float left0 = source.left;
+        const float right0 = source.right;
+
+        // Separate buses keep the loops contiguous for the vectorizer
+        for (int i = 0; i < frames; ++i) {
+            m_left[i] += m_read[i] * (left0 + leftStep * (i + 1));
+        }
+
+        for (int i = 0; i < frames; ++i) {
+            m_right[i] += m_read[i] * (right0 + rightStep * (i + 1));
+        }
+
+        source.left = left;
+        source.right = right;
+    }
+
+    // The leveler works at the synthesizer's int16 scale
+    for (int i = 0; i < frames; ++i) {
+        output[2 * i + 0] = m_left[i] * Synthesizer::Int16Scale;
+        output[2 * i + 1] = m_right[i] * Synthesizer::Int16Scale;
+    }
+
+    m_leveler.p_target = m_parameters.levelerTarget;
+    m_leveler.block_f(output, output, frames);
+
+    const float volume = m_parameters.volume * (1 / Synthesizer::Int16Scale);
+    for (int i = 0; i < frames * OutputChannels; ++i) {
+        output[i] *= volume;
+    }
+
+    ++m_statistics.blocks;
+}
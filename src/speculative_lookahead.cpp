@@ -0,0 +1,287 @@
+#include "../include/speculative_lookahead.h"
+
+#include "../include/debug_trace.h"
+#include "../include/piston_engine_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpeculativeLookahead::SpeculativeLookahead() {
+    m_jobs = nullptr;
+    m_failedBranches = 0;
+    m_nextGeneration = 0;
+
+    for (int i = 0; i < FutureCount; ++i) {
+        m_branches[i] = nullptr;
+    }
+}
+
+SpeculativeLookahead::~SpeculativeLookahead() {
+    /* void */
+}
+
+void SpeculativeLookahead::initialize(JobSystem *jobs, const Parameters &params) {
+    m_parameters = params;
+    m_jobs = new JobSystem::Group(jobs, JobSystem::Priority::Normal);
+    m_lastFork = std::chrono::steady_clock::time_point();
+}
+
+void SpeculativeLookahead::destroy() {
+    setBranches(nullptr);
+
+    delete m_jobs;
+    m_jobs = nullptr;
+}
+
+void SpeculativeLookahead::setBranches(PistonEngineSimulator *const *branches) {
+    wait();
+
+    for (int i = 0; i < FutureCount; ++i) {
+        m_branches[i] = (branches != nullptr) ? branches[i] : nullptr;
+    }
+
+    for (Generation &generation : m_generations) {
+        generation.valid = false;
+    }
+
+    m_active = Active();
+}
+
+bool SpeculativeLookahead::hasBranches() const {
+    for (int i = 0; i < FutureCount; ++i) {
+        if (m_branches[i] == nullptr) return false;
+    }
+
+    return m_jobs != nullptr;
+}
+
+bool SpeculativeLookahead::update(
+    PistonEngineSimulator *live,
+    double throttle,
+    std::chrono::steady_clock::time_point now)
+{
+    m_statistics.failed = m_failedBranches.load(std::memory_order_relaxed);
+
+    if (live == nullptr || !hasBranches()) return false;
+    if (std::chrono::duration<double>(now - m_lastFork).count() < m_parameters.interval) return false;
+
+    // The branch simulators are shared by every generation, so only one can
+    // be in flight
+    for (const Generation &generation : m_generations) {
+        if (generation.pending.load(std::memory_order_acquire) > 0) return false;
+    }
+
+    // The engaged generation keeps its audio until the live output catches up
+    int slot = -1;
+    for (int i = 0; i < GenerationCount; ++i) {
+        const int candidate = (m_nextGeneration + i) % GenerationCount;
+        if (candidate != m_active.generation) {
+            slot = candidate;
+            break;
+        }
+    }
+
+    m_nextGeneration = (slot + 1) % GenerationCount;
+    m_lastFork = now;
+
+    Generation &generation = m_generations[slot];
+    generation.valid = false;
+    generation.checkpoint.capture(live);
+    generation.base = live->synthesizer().getInputPosition();
+    generation.throttle = throttle;
+    generation.frequency = live->getSimulationFrequency();
+    generation.speed = live->getSimulationSpeed();
+    generation.audioParameters = live->synthesizer().getAudioParameters();
+    generation.pending.store(FutureCount, std::memory_order_release);
+    generation.valid = true;
+
+    for (int i = 0; i < FutureCount; ++i) {
+        Generation *target = &generation;
+        m_jobs->run([this, target, i]() {
+            simulate(target, i);
+            target->pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    ++m_statistics.forks;
+
+    return true;
+}
+
+bool SpeculativeLookahead::engage(double throttle, size_t readPosition, size_t livePosition) {
+    if (!hasBranches()) return false;
+
+    // One change at a time; the live output takes the next one as it is
+    if (isEngaged()) {
+        ++m_statistics.missed;
+        return false;
+    }
+
+    const size_t crossfade = (size_t)std::max(1, m_parameters.crossfadeSamples);
+
+    int best = -1;
+    int bestFuture = 0;
+    for (int i = 0; i < GenerationCount; ++i) {
+        const Generation &generation = m_generations[i];
+        if (!isReady(generation)) continue;
+
+        for (int f = 0; f < FutureCount; ++f) {
+            if (std::abs(getFutureThrottle(generation, f) - throttle) > m_parameters.tolerance) continue;
+
+            const std::vector<float> &audio = generation.audio[f];
+            if (audio.empty() || generation.base + audio.size() < livePosition + crossfade) continue;
+
+            // The newest fork at or before the read position hears the most
+            // of the change; failing that, the earliest one after it
+            if (best < 0) {
+                best = i;
+                bestFuture = f;
+                continue;
+            }
+
+            const size_t base = m_generations[best].base;
+            const bool before = generation.base <= readPosition;
+            const bool bestBefore = base <= readPosition;
+            const bool better = (before && (!bestBefore || generation.base > base))
+                || (!before && !bestBefore && generation.base < base);
+            if (better) {
+                best = i;
+                bestFuture = f;
+            }
+        }
+    }
+
+    if (best < 0) {
+        ++m_statistics.missed;
+        ATG_ENGINE_SIM_TRACE(Audio, Verbose, "lookahead_missed throttle=%.3f", throttle);
+        return false;
+    }
+
+    m_active.generation = best;
+    m_active.future = bestFuture;
+    m_active.start = std::max(readPosition, m_generations[best].base);
+    m_active.end = livePosition;
+
+    if (m_active.end <= m_active.start + crossfade) {
+        m_active = Active();
+        ++m_statistics.missed;
+        return false;
+    }
+
+    ++m_statistics.engaged;
+    ATG_ENGINE_SIM_TRACE(
+        Audio, Event,
+        "lookahead_engaged future=%s samples=%d",
+        GetFutureName(static_cast<Future>(bestFuture)),
+        (int)(m_active.end - m_active.start));
+
+    return true;
+}
+
+void SpeculativeLookahead::mix(float *samples, int count, size_t position) {
+    if (!isEngaged()) return;
+
+    const Generation &generation = m_generations[m_active.generation];
+    const std::vector<float> &audio = generation.audio[m_active.future];
+    const double crossfade = (double)std::max(1, m_parameters.crossfadeSamples);
+
+    for (int i = 0; i < count; ++i) {
+        const size_t index = position + i;
+        if (index < m_active.start) continue;
+        if (index >= m_active.end) break;
+
+        const size_t offset = index - generation.base;
+        if (offset >= audio.size()) break;
+
+        const double w = std::min(1.0, (index - m_active.start) / crossfade)
+            * std::min(1.0, (m_active.end - index) / crossfade);
+        samples[i] += (float)(w * (audio[offset] - samples[i]));
+    }
+
+    if (position + count >= m_active.end) {
+        m_active = Active();
+    }
+}
+
+const char *SpeculativeLookahead::GetFutureName(Future future) {
+    switch (future) {
+        case Future::Hold: return "hold";
+        case Future::Up: return "up";
+        case Future::Down: return "down";
+        default: return "unknown";
+    }
+}
+
+void SpeculativeLookahead::simulate(Generation *generation, int future) {
+    PistonEngineSimulator *branch = m_branches[future];
+    std::vector<float> &audio = generation->audio[future];
+    audio.clear();
+
+    branch->setSimulationFrequency(generation->frequency);
+    branch->setSimulationSpeed(generation->speed);
+    if (!generation->checkpoint.restore(branch)) {
+        m_failedBranches.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Synthesizer &synthesizer = branch->synthesizer();
+    synthesizer.setAudioParameters(generation->audioParameters);
+
+    // Whatever the previous generation left behind isn't part of this one
+    float buffer[1024];
+    do {
+        synthesizer.renderPendingAudio();
+    } while (branch->readAudioOutput(1024, buffer) > 0);
+
+    const double target = getFutureThrottle(*generation, future);
+    const size_t horizon = (size_t)(m_parameters.horizon * synthesizer.getAudioSampleRate());
+    double throttle = generation->throttle;
+    const int steps = std::max(
+        1,
+        (int)std::lround(m_parameters.frameLength * generation->speed * generation->frequency));
+
+    audio.reserve(horizon + 1024);
+    while (audio.size() < horizon) {
+        throttle = 0.5 * target + 0.5 * throttle;
+
+        ControlQueue::Event event;
+        event.control = ControlQueue::Control::Throttle;
+        event.value = throttle;
+        event.immediate = true;
+        branch->applyControl(event);
+
+        // Paced by step count, as the branch's drained synthesizer would
+        // otherwise have a frame follow its latency target
+        branch->startFrameSteps(steps);
+        while (branch->simulateStep()) {
+            /* void */
+        }
+
+        branch->endFrame();
+        synthesizer.renderPendingAudio();
+
+        const size_t previous = audio.size();
+        int read;
+        while ((read = branch->readAudioOutput(1024, buffer)) > 0) {
+            audio.insert(audio.end(), buffer, buffer + read);
+        }
+
+        if (audio.size() == previous) break;
+    }
+}
+
+double SpeculativeLookahead::getFutureThrottle(const Generation &generation, int future) const {
+    switch (static_cast<Future>(future)) {
+        case Future::Up: return m_parameters.upThrottle;
+        case Future::Down: return m_parameters.downThrottle;
+        default: return generation.throttle;
+    }
+}
+
+bool SpeculativeLookahead::isReady(const Generation &generation) const {
+    return generation.valid && generation.pending.load(std::memory_order_acquire) == 0;
+}
+
+void SpeculativeLookahead::wait() {
+    if (m_jobs != nullptr) m_jobs->wait();
+}
@@ -0,0 +1,112 @@
+#include "../include/speculative_stepping.h"
+
+#include "../include/engine.h"
+
+#include <cmath>
+
+namespace {
+const char *FailureNames[] = { "none", "non_finite", "gas_bounds", "speed", "constraint_drift" };
+static_assert(
+    sizeof(FailureNames) / sizeof(FailureNames[0]) == SpeculativeStepping::FailureCount,
+    "failure names");
+
+SpeculativeStepping::Failure checkBody(
+    const atg_scs::RigidBody &body,
+    const SpeculativeStepping::Parameters &params)
+{
+    const double sum = body.p_x + body.p_y + body.theta + body.v_x + body.v_y + body.v_theta;
+    if (!std::isfinite(sum)) return SpeculativeStepping::Failure::NonFinite;
+    if (std::abs(body.v_theta) > params.maxAngularSpeed) return SpeculativeStepping::Failure::Speed;
+
+    return SpeculativeStepping::Failure::None;
+}
+
+// Distance of the piston from its bank's axis, which the cylinder constraint
+// holds it to
+double pistonDrift(const Piston *piston) {
+    const CylinderBank *bank = piston->getCylinderBank();
+    const double x = piston->m_body.p_x - bank->getX();
+    const double y = piston->m_body.p_y - bank->getY();
+    const double length = std::sqrt(bank->getDx() * bank->getDx() + bank->getDy() * bank->getDy());
+
+    return std::abs(x * bank->getDy() - y * bank->getDx()) / length;
+}
+} /* namespace */
+
+SpeculativeStepping::SpeculativeStepping() {
+    /* void */
+}
+
+SpeculativeStepping::~SpeculativeStepping() {
+    /* void */
+}
+
+void SpeculativeStepping::initialize(const Parameters &params) {
+    m_parameters = params;
+    reset();
+}
+
+void SpeculativeStepping::reset() {
+    m_statistics = Statistics();
+}
+
+SpeculativeStepping::Failure SpeculativeStepping::check(const Engine *engine) const {
+    Failure failure = Failure::None;
+
+    for (int i = 0; i < engine->getCrankshaftCount() && failure == Failure::None; ++i) {
+        failure = checkBody(engine->getCrankshaft(i)->m_body, m_parameters);
+    }
+
+    for (int i = 0; i < engine->getCylinderCount() && failure == Failure::None; ++i) {
+        const Piston *piston = engine->getPiston(i);
+        failure = checkBody(piston->m_body, m_parameters);
+        if (failure == Failure::None) failure = checkBody(engine->getConnectingRod(i)->m_body, m_parameters);
+        if (failure == Failure::None && pistonDrift(piston) > m_parameters.maxPistonDrift) {
+            failure = Failure::ConstraintDrift;
+        }
+
+        CombustionChamber *chamber = engine->getChamber(i);
+        if (failure == Failure::None) failure = CheckGas(*chamber->getSystem(), m_parameters);
+        if (failure == Failure::None) failure = CheckGas(*chamber->getIntakeRunner(), m_parameters);
+        if (failure == Failure::None) failure = CheckGas(*chamber->getExhaustRunner(), m_parameters);
+    }
+
+    for (int i = 0; i < engine->getIntakeCount() && failure == Failure::None; ++i) {
+        failure = CheckGas(engine->getIntake(i)->m_system, m_parameters);
+    }
+
+    for (int i = 0; i < engine->getExhaustSystemCount() && failure == Failure::None; ++i) {
+        failure = CheckGas(*engine->getExhaustSystem(i)->getSystem(), m_parameters);
+    }
+
+    return failure;
+}
+
+SpeculativeStepping::Failure SpeculativeStepping::CheckGas(
+    const GasSystem &system,
+    const Parameters &params)
+{
+    const double n = system.n();
+    const double E_k = system.kineticEnergy();
+    if (!std::isfinite(n + E_k + system.volume())) return Failure::NonFinite;
+    if (n < 0 || E_k < 0) return Failure::GasBounds;
+    if (system.temperature() > params.maxTemperature) return Failure::GasBounds;
+    if (system.pressure() > params.maxPressure) return Failure::GasBounds;
+
+    return Failure::None;
+}
+
+void SpeculativeStepping::recordFrame(bool refined) {
+    ++m_statistics.frames;
+    if (refined) ++m_statistics.refinedFrames;
+}
+
+void SpeculativeStepping::recordFailure(Failure failure, bool rolledBack) {
+    ++m_statistics.failures[static_cast<int>(failure)];
+    if (rolledBack) ++m_statistics.rollbacks;
+}
+
+const char *SpeculativeStepping::GetFailureName(Failure failure) {
+    const int i = static_cast<int>(failure);
+    return (i >= 0 && i < FailureCount) ? FailureNames[i] : "unknown";
+}
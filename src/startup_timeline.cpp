@@ -0,0 +1,173 @@
+#include "../include/startup_timeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+struct TimelineState {
+    std::mutex lock;
+    bool recording = false;
+    std::chrono::steady_clock::time_point origin;
+    std::map<std::thread::id, int> threads;
+    std::vector<StartupTimeline::Event> events;
+};
+
+TimelineState &state() {
+    static TimelineState s_state;
+    return s_state;
+}
+
+// Caller holds the lock
+int threadIndex(TimelineState &timeline) {
+    const std::thread::id id = std::this_thread::get_id();
+    auto it = timeline.threads.find(id);
+    if (it != timeline.threads.end()) return it->second;
+
+    const int index = static_cast<int>(timeline.threads.size());
+    timeline.threads[id] = index;
+    return index;
+}
+
+void appendEscaped(std::string *out, const std::string &s) {
+    for (const char c : s) {
+        if (c == '"' || c == '\\') out->push_back('\\');
+        out->push_back(c);
+    }
+}
+} /* namespace */
+
+StartupTimeline::Scope::Scope(const char *name) {
+    m_name = name;
+    m_begin = IsRecording() ? Now() : -1;
+}
+
+StartupTimeline::Scope::~Scope() {
+    if (m_begin >= 0) Record(m_name, m_begin, Now());
+}
+
+void StartupTimeline::Start() {
+    TimelineState &timeline = state();
+    std::lock_guard<std::mutex> lock(timeline.lock);
+    timeline.origin = std::chrono::steady_clock::now();
+    timeline.threads.clear();
+    timeline.events.clear();
+    timeline.recording = true;
+    threadIndex(timeline);
+}
+
+void StartupTimeline::Stop() {
+    TimelineState &timeline = state();
+    std::lock_guard<std::mutex> lock(timeline.lock);
+    timeline.recording = false;
+}
+
+bool StartupTimeline::IsRecording() {
+    TimelineState &timeline = state();
+    std::lock_guard<std::mutex> lock(timeline.lock);
+    return timeline.recording;
+}
+
+int64_t StartupTimeline::Now() {
+    TimelineState &timeline = state();
+    std::chrono::steady_clock::time_point origin;
+    {
+        std::lock_guard<std::mutex> lock(timeline.lock);
+        origin = timeline.origin;
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - origin).count();
+}
+
+void StartupTimeline::Record(const char *name, int64_t begin, int64_t end) {
+    TimelineState &timeline = state();
+    std::lock_guard<std::mutex> lock(timeline.lock);
+    if (!timeline.recording) return;
+
+    Event event;
+    event.name = name;
+    event.thread = threadIndex(timeline);
+    event.begin = begin;
+    event.duration = (end > begin) ? end - begin : 0;
+    timeline.events.push_back(event);
+}
+
+void StartupTimeline::Mark(const char *name) {
+    const int64_t now = Now();
+
+    TimelineState &timeline = state();
+    std::lock_guard<std::mutex> lock(timeline.lock);
+    if (!timeline.recording) return;
+
+    Event event;
+    event.name = name;
+    event.thread = threadIndex(timeline);
+    event.begin = now;
+    event.instant = true;
+    timeline.events.push_back(event);
+}
+
+bool StartupTimeline::FindMark(const char *name, int64_t *time) {
+    TimelineState &timeline = state();
+    std::lock_guard<std::mutex> lock(timeline.lock);
+    for (const Event &event : timeline.events) {
+        if (event.instant && event.name == name) {
+            *time = event.begin;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<StartupTimeline::Event> StartupTimeline::GetEvents() {
+    TimelineState &timeline = state();
+    std::lock_guard<std::mutex> lock(timeline.lock);
+    return timeline.events;
+}
+
+std::string StartupTimeline::ToChromeTrace() {
+    const std::vector<Event> events = GetEvents();
+
+    std::string out = "{\"traceEvents\":[";
+    char buffer[128];
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event &event = events[i];
+        if (i > 0) out += ",";
+
+        out += "\n{\"name\":\"";
+        appendEscaped(&out, event.name);
+        if (event.instant) {
+            std::snprintf(
+                buffer, sizeof(buffer),
+                "\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lld,\"pid\":1,\"tid\":%d}",
+                static_cast<long long>(event.begin),
+                event.thread);
+        }
+        else {
+            std::snprintf(
+                buffer, sizeof(buffer),
+                "\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}",
+                static_cast<long long>(event.begin),
+                static_cast<long long>(event.duration),
+                event.thread);
+        }
+
+        out += buffer;
+    }
+
+    out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return out;
+}
+
+bool StartupTimeline::WriteChromeTrace(const std::string &path) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file << ToChromeTrace();
+    return file.good();
+}
@@ -0,0 +1,141 @@
+#include "../include/steady_state_detector.h"
+
+#include "../include/constants.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <cmath>
+
+SteadyStateDetector::SteadyStateDetector() {
+    m_windowNext = 0;
+    m_cycleWeight = 0.0;
+    m_cycleAngle = 0.0;
+    m_lastTime = 0.0;
+    m_started = false;
+    m_cycles = 0;
+    m_settled = false;
+    m_settledTime = 0.0;
+}
+
+SteadyStateDetector::~SteadyStateDetector() {
+    /* void */
+}
+
+void SteadyStateDetector::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_parameters.windowCycles = std::max(params.windowCycles, 2);
+    m_parameters.warmupCycles = std::max(params.warmupCycles, 0);
+
+    reset();
+}
+
+void SteadyStateDetector::reset() {
+    m_window.clear();
+    m_windowNext = 0;
+
+    m_cycleSum = Average();
+    m_cycleWeight = 0.0;
+    m_cycleAngle = 0.0;
+    m_lastTime = 0.0;
+    m_started = false;
+
+    m_cycles = 0;
+    m_settled = false;
+    m_settledTime = 0.0;
+}
+
+bool SteadyStateDetector::addSample(const SimulationSnapshot &snapshot) {
+    if (!m_started) {
+        m_started = true;
+        m_lastTime = snapshot.time;
+        return false;
+    }
+
+    const double dt = snapshot.time - m_lastTime;
+    m_lastTime = snapshot.time;
+    if (dt <= 0) return false;
+
+    // Samples are weighted by the time they cover since frames can vary
+    m_cycleSum.torque += snapshot.filteredDynoTorque * dt;
+    m_cycleSum.rpm += snapshot.rpm * dt;
+    m_cycleSum.manifoldPressure += snapshot.manifoldPressure * dt;
+    m_cycleSum.afr += snapshot.intakeAfr * dt;
+    m_cycleWeight += dt;
+    m_cycleAngle += std::abs(units::rpm(snapshot.rpm)) * dt;
+
+    if (m_cycleAngle < 4 * constants::pi) return false;
+
+    Average cycle;
+    cycle.torque = m_cycleSum.torque / m_cycleWeight;
+    cycle.rpm = m_cycleSum.rpm / m_cycleWeight;
+    cycle.manifoldPressure = m_cycleSum.manifoldPressure / m_cycleWeight;
+    cycle.afr = m_cycleSum.afr / m_cycleWeight;
+
+    m_cycleSum = Average();
+    m_cycleWeight = 0.0;
+    m_cycleAngle = std::fmod(m_cycleAngle, 4 * constants::pi);
+
+    if (++m_cycles <= m_parameters.warmupCycles) return false;
+
+    if ((int)m_window.size() < m_parameters.windowCycles) {
+        m_window.push_back(cycle);
+    }
+    else {
+        m_window[m_windowNext] = cycle;
+        m_windowNext = (m_windowNext + 1) % m_parameters.windowCycles;
+    }
+
+    if (m_settled || !isWindowSettled()) return false;
+
+    m_settled = true;
+    m_settledTime = snapshot.time;
+
+    return true;
+}
+
+SteadyStateDetector::Average SteadyStateDetector::getWindowAverage() const {
+    Average average;
+    if (m_window.empty()) return average;
+
+    for (const Average &cycle : m_window) {
+        average.torque += cycle.torque;
+        average.rpm += cycle.rpm;
+        average.manifoldPressure += cycle.manifoldPressure;
+        average.afr += cycle.afr;
+    }
+
+    const double n = (double)m_window.size();
+    average.torque /= n;
+    average.rpm /= n;
+    average.manifoldPressure /= n;
+    average.afr /= n;
+
+    return average;
+}
+
+bool SteadyStateDetector::isWindowSettled() const {
+    if ((int)m_window.size() < m_parameters.windowCycles) return false;
+
+    return WithinTolerance(m_window, &Average::torque, m_parameters.torque)
+        && WithinTolerance(m_window, &Average::rpm, m_parameters.rpm)
+        && WithinTolerance(m_window, &Average::manifoldPressure, m_parameters.manifoldPressure)
+        && WithinTolerance(m_window, &Average::afr, m_parameters.afr);
+}
+
+bool SteadyStateDetector::WithinTolerance(
+    const std::vector<Average> &window,
+    double Average::*value,
+    const Tolerance &tolerance)
+{
+    double minimum = window[0].*value, maximum = minimum, sum = 0;
+    for (const Average &cycle : window) {
+        minimum = std::min(minimum, cycle.*value);
+        maximum = std::max(maximum, cycle.*value);
+        sum += cycle.*value;
+    }
+
+    const double mean = sum / window.size();
+    const double allowed = std::max(tolerance.relative * std::abs(mean), tolerance.absolute);
+
+    return maximum - mean <= allowed && mean - minimum <= allowed;
+}
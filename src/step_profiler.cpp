@@ -0,0 +1,416 @@
+#include "../include/step_profiler.h"
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#elif defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#endif
+
+namespace {
+const char *StageNames[] = {
+    "solver",
+    "engine_update",
+    "ignition_update",
+    "chamber_update",
+    "fluid_exhaust",
+    "fluid_intake",
+    "fluid_chambers",
+    "chamber_zones",
+    "write_to_synthesizer",
+    "synthesizer_input",
+    "synthesizer_render",
+    "synthesizer_lock_wait",
+    "step",
+    "frame",
+    "audio_output",
+    "ui_update",
+    "render_scene",
+    "present"
+};
+
+static_assert(
+    sizeof(StageNames) / sizeof(StageNames[0]) == StepProfiler::StageCount,
+    "every stage needs a name");
+
+} /* namespace */
+
+double StepProfiler::Statistics::percentileMicroseconds(double p) const {
+    if (count == 0) return 0.0;
+
+    const double target = p * count;
+    uint64_t seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return static_cast<double>(1ull << i) / 1000.0;
+        }
+    }
+
+    return static_cast<double>(1ull << (BucketCount - 1)) / 1000.0;
+}
+
+StepProfiler::Statistics StepProfiler::Statistics::since(const Statistics &earlier) const {
+    Statistics difference;
+    difference.count = count - earlier.count;
+    difference.totalMicroseconds = totalMicroseconds - earlier.totalMicroseconds;
+    for (int i = 0; i < BucketCount; ++i) {
+        difference.buckets[i] = buckets[i] - earlier.buckets[i];
+    }
+
+    difference.counterSamples = counterSamples - earlier.counterSamples;
+    for (int i = 0; i < HardwareCounters::CounterCount; ++i) {
+        difference.counters[i] = counters[i] - earlier.counters[i];
+    }
+
+    return difference;
+}
+
+const char *StepProfiler::GetStageName(Stage stage) {
+    return StageNames[static_cast<int>(stage)];
+}
+
+StepProfiler::CountedTimer::CountedTimer(Stage stage) {
+    m_stage = stage;
+    m_counted = HardwareCounters::IsEnabled() && ReadThreadCounters(&m_counters);
+    m_start = Now();
+}
+
+StepProfiler::CountedTimer::~CountedTimer() {
+    Record(m_stage, m_start, Now());
+
+    HardwareCounters::Sample counters;
+    if (m_counted && ReadThreadCounters(&counters)) {
+        RecordCounters(m_stage, counters - m_counters);
+    }
+}
+
+bool StepProfiler::ReadThreadCounters(HardwareCounters::Sample *counters) {
+    thread_local HardwareCounters threadCounters;
+    thread_local bool opened = threadCounters.open();
+
+    return opened && threadCounters.read(counters);
+}
+
+bool StepProfiler::WriteChromeTrace(const std::string &path) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file << ToChromeTrace();
+    return file.good();
+}
+
+#if defined(ATG_ENGINE_SIM_PROFILE_STEPS)
+
+namespace {
+constexpr int MaxThreads = 64;
+
+int bucketIndex(double nanoseconds) {
+    int i = 0;
+    uint64_t n = static_cast<uint64_t>(nanoseconds);
+    while (n > 0 && i < StepProfiler::BucketCount - 1) {
+        n >>= 1;
+        ++i;
+    }
+
+    return i;
+}
+
+// Written only by the owning thread; relaxed atomics keep concurrent reads
+// well defined without ordering cost on the writer
+struct ThreadSlot {
+    std::atomic<uint64_t> count[StepProfiler::StageCount];
+    std::atomic<uint64_t> ticks[StepProfiler::StageCount];
+    std::atomic<uint64_t> buckets[StepProfiler::StageCount][StepProfiler::BucketCount];
+    std::atomic<uint64_t> counterSamples[StepProfiler::StageCount];
+    std::atomic<uint64_t> counters[StepProfiler::StageCount][HardwareCounters::CounterCount];
+    std::atomic<const char *> name;
+};
+
+ThreadSlot g_slots[MaxThreads];
+std::atomic<int> g_slotCount{ 0 };
+
+ThreadSlot *threadSlot() {
+    thread_local ThreadSlot *slot = [] {
+        const int i = g_slotCount.fetch_add(1, std::memory_order_relaxed);
+        return (i < MaxThreads) ? &g_slots[i] : nullptr;
+    }();
+
+    return slot;
+}
+
+// Fields are relaxed atomics so an export racing a late writer reads a
+// stale span rather than undefined behavior
+struct Span {
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> end;
+    std::atomic<int> stage;
+    std::atomic<int> thread;
+};
+
+struct SpanRing {
+    std::unique_ptr<Span[]> spans;
+    uint64_t capacity = 0;
+    std::atomic<uint64_t> head{ 0 };
+};
+
+std::atomic<SpanRing *> g_ring{ nullptr };
+std::atomic<bool> g_capturing{ false };
+
+// Every ring made so far; guarded by g_ringLock
+std::vector<std::unique_ptr<SpanRing>> g_rings;
+std::mutex g_ringLock;
+
+void increment(std::atomic<uint64_t> &counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// The tick rate is measured against the steady clock over the process
+// lifetime rather than assumed
+struct Calibration {
+    uint64_t ticks;
+    std::chrono::steady_clock::time_point time;
+};
+
+const Calibration g_start = { StepProfiler::Now(), std::chrono::steady_clock::now() };
+
+double nanosecondsPerTick() {
+#if defined(__APPLE__)
+    static const double scale = [] {
+        mach_timebase_info_data_t info;
+        mach_timebase_info(&info);
+        return static_cast<double>(info.numer) / info.denom;
+    }();
+
+    return scale;
+#elif defined(__x86_64__) || defined(_M_X64)
+    const uint64_t ticks = StepProfiler::Now() - g_start.ticks;
+    const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_start.time).count());
+    return (ticks > 0) ? ns / ticks : 1.0;
+#else
+    return 1.0;
+#endif
+}
+} /* namespace */
+
+bool StepProfiler::IsEnabled() {
+    return true;
+}
+
+uint64_t StepProfiler::Now() {
+#if defined(__APPLE__)
+    return mach_absolute_time();
+#elif defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void StepProfiler::Record(Stage stage, uint64_t start, uint64_t end) {
+    ThreadSlot *slot = threadSlot();
+    if (slot == nullptr) return;
+
+    const int s = static_cast<int>(stage);
+    if (g_capturing.load(std::memory_order_relaxed)) {
+        SpanRing *ring = g_ring.load(std::memory_order_acquire);
+        const uint64_t i = ring->head.fetch_add(1, std::memory_order_relaxed);
+        Span &span = ring->spans[i % ring->capacity];
+        span.start.store(start, std::memory_order_relaxed);
+        span.end.store(end, std::memory_order_relaxed);
+        span.stage.store(s, std::memory_order_relaxed);
+        span.thread.store(static_cast<int>(slot - g_slots), std::memory_order_relaxed);
+    }
+
+    uint64_t ticks = end - start;
+    increment(slot->count[s], 1);
+    increment(slot->ticks[s], ticks);
+
+    // Bucketed in ticks; converted to nanoseconds when read
+    int bucket = 0;
+    while (ticks > 0 && bucket < BucketCount - 1) {
+        ticks >>= 1;
+        ++bucket;
+    }
+
+    increment(slot->buckets[s][bucket], 1);
+}
+
+void StepProfiler::RecordCounters(Stage stage, const HardwareCounters::Sample &counters) {
+    ThreadSlot *slot = threadSlot();
+    if (slot == nullptr) return;
+
+    const int s = static_cast<int>(stage);
+    increment(slot->counterSamples[s], 1);
+    for (int i = 0; i < HardwareCounters::CounterCount; ++i) {
+        increment(slot->counters[s][i], counters.values[i]);
+    }
+}
+
+void StepProfiler::GetStatistics(Stage stage, Statistics *statistics) {
+    *statistics = Statistics();
+
+    const int s = static_cast<int>(stage);
+    const double scale = nanosecondsPerTick();
+    const int slots = std::min(g_slotCount.load(std::memory_order_relaxed), MaxThreads);
+
+    uint64_t ticks = 0;
+    for (int i = 0; i < slots; ++i) {
+        const ThreadSlot &slot = g_slots[i];
+        statistics->count += slot.count[s].load(std::memory_order_relaxed);
+        ticks += slot.ticks[s].load(std::memory_order_relaxed);
+
+        statistics->counterSamples += slot.counterSamples[s].load(std::memory_order_relaxed);
+        for (int j = 0; j < HardwareCounters::CounterCount; ++j) {
+            statistics->counters[j] += slot.counters[s][j].load(std::memory_order_relaxed);
+        }
+
+        for (int j = 0; j < BucketCount; ++j) {
+            // Re-bucket from ticks to nanoseconds using the bucket's midpoint
+            const uint64_t n = slot.buckets[s][j].load(std::memory_order_relaxed);
+            const double ns = (j == 0) ? 0.0 : 0.75 * (1ull << j) * scale;
+            statistics->buckets[bucketIndex(ns)] += n;
+        }
+    }
+
+    statistics->totalMicroseconds = ticks * scale / 1000.0;
+}
+
+void StepProfiler::SetThreadName(const char *name) {
+    ThreadSlot *slot = threadSlot();
+    if (slot != nullptr) slot->name.store(name, std::memory_order_relaxed);
+}
+
+void StepProfiler::StartCapture(int spansCapacity) {
+    std::lock_guard<std::mutex> lock(g_ringLock);
+    g_capturing.store(false, std::memory_order_relaxed);
+
+    const uint64_t capacity = static_cast<uint64_t>(std::max(spansCapacity, 1));
+    SpanRing *ring = g_ring.load(std::memory_order_relaxed);
+    if (ring == nullptr || ring->capacity != capacity) {
+        std::unique_ptr<SpanRing> created = std::make_unique<SpanRing>();
+        created->spans = std::make_unique<Span[]>(capacity);
+        created->capacity = capacity;
+        ring = created.get();
+        g_rings.push_back(std::move(created));
+    }
+
+    ring->head.store(0, std::memory_order_relaxed);
+    g_ring.store(ring, std::memory_order_release);
+    g_capturing.store(true, std::memory_order_release);
+}
+
+void StepProfiler::StopCapture() {
+    g_capturing.store(false, std::memory_order_release);
+}
+
+bool StepProfiler::IsCapturing() {
+    return g_capturing.load(std::memory_order_relaxed);
+}
+
+std::string StepProfiler::ToChromeTrace() {
+    std::string out = "{\"traceEvents\":[";
+    bool first = true;
+    char buffer[192];
+
+    const int slots = std::min(g_slotCount.load(std::memory_order_relaxed), MaxThreads);
+    for (int i = 0; i < slots; ++i) {
+        const char *name = g_slots[i].name.load(std::memory_order_relaxed);
+        if (name == nullptr) continue;
+
+        std::snprintf(
+            buffer, sizeof(buffer),
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",",
+            i,
+            name);
+        out += buffer;
+        first = false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_ringLock);
+    SpanRing *ring = g_ring.load(std::memory_order_acquire);
+    if (ring != nullptr) {
+        const double microsecondsPerTick = nanosecondsPerTick() / 1000.0;
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        const uint64_t count = std::min(head, ring->capacity);
+        for (uint64_t i = head - count; i < head; ++i) {
+            const Span &span = ring->spans[i % ring->capacity];
+            const uint64_t start = span.start.load(std::memory_order_relaxed);
+            const uint64_t end = span.end.load(std::memory_order_relaxed);
+            const int stage = span.stage.load(std::memory_order_relaxed);
+            if (stage < 0 || stage >= StageCount || end < start) continue;
+
+            std::snprintf(
+                buffer, sizeof(buffer),
+                "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                first ? "" : ",",
+                StageNames[stage],
+                (static_cast<double>(start) - static_cast<double>(g_start.ticks)) * microsecondsPerTick,
+                (end - start) * microsecondsPerTick,
+                span.thread.load(std::memory_order_relaxed));
+            out += buffer;
+            first = false;
+        }
+    }
+
+    out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return out;
+}
+
+#else
+
+bool StepProfiler::IsEnabled() {
+    return false;
+}
+
+uint64_t StepProfiler::Now() {
+    return 0;
+}
+
+void StepProfiler::Record([[maybe_unused]] Stage stage, [[maybe_unused]] uint64_t start, [[maybe_unused]] uint64_t end) {
+    /* void */
+}
+
+void StepProfiler::RecordCounters(
+    [[maybe_unused]] Stage stage,
+    [[maybe_unused]] const HardwareCounters::Sample &counters)
+{
+    /* void */
+}
+
+void StepProfiler::GetStatistics([[maybe_unused]] Stage stage, Statistics *statistics) {
+    *statistics = Statistics();
+}
+
+void StepProfiler::SetThreadName([[maybe_unused]] const char *name) {
+    /* void */
+}
+
+void StepProfiler::StartCapture([[maybe_unused]] int spansCapacity) {
+    /* void */
+}
+
+void StepProfiler::StopCapture() {
+    /* void */
+}
+
+bool StepProfiler::IsCapturing() {
+    return false;
+}
+
+std::string StepProfiler::ToChromeTrace() {
+    return "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+#endif /* ATG_ENGINE_SIM_PROFILE_STEPS */
@@ -1,8 +1,14 @@
 #include "../include/synthesizer.h"
 
+#include "../include/allocation_tracker.h"
 #include "../include/utilities.h"
 #include "../include/delta.h"
 #include "../include/debug_trace.h"
+#include "../include/denormals.h"
+#include "../include/event_counters.h"
+#include "../include/step_profiler.h"
+#include "../include/thread_policy.h"
+#include "../include/constants.h"
 
 #include <algorithm>
 #include <atomic>
@@ -11,13 +17,54 @@
 #include <cstring>
 
 namespace {
-std::atomic<unsigned long long> g_lock0ContentionCount{0};
-std::atomic<unsigned long long> g_inputLockContentionCount{0};
+// Expected cadence of the audio thread, the faster physics frame rate; the
+// real-time policy budgets half of it for rendering
+constexpr double RenderPeriod = 1 / 240.0;
+
+// Zero crossings on each side of the windowed sinc impulse responses are
+// resampled with
+constexpr int ResampleLobes = 16;
+
+double windowedSinc(double x, double lobes) {
+    if (x == 0) return 1.0;
+    else if (std::abs(x) >= lobes) return 0.0;
+
+    const double px = constants::pi * x;
+    return (std::sin(px) / px) * (std::sin(px / lobes) / (px / lobes));
+}
+
+// Band-limited to the lower of the two Nyquist rates; the taps are scaled by
+// the rate ratio so the filter's gain doesn't change with the rate
+void resampleImpulseResponse(ConvolutionFilter *filter, double ratio) {
+    const int sourceCount = filter->getSampleCount();
+    const float *source = filter->getImpulseResponse();
+    const double cutoff = std::fmin(1.0, 1.0 / ratio);
+    const double reach = ResampleLobes / cutoff;
+    const int targetCount = std::max(1, static_cast<int>(std::ceil(sourceCount / ratio)));
+
+    float *taps = new float[targetCount];
+    for (int m = 0; m < targetCount; ++m) {
+        const double t = m * ratio;
+        const int first = std::max(0, static_cast<int>(std::ceil(t - reach)));
+        const int last = std::min(sourceCount - 1, static_cast<int>(std::floor(t + reach)));
+
+        double sum = 0.0;
+        for (int k = first; k <= last; ++k) {
+            sum += source[k] * windowedSinc(cutoff * (t - k), ResampleLobes);
+        }
+
+        taps[m] = static_cast<float>(sum * cutoff * ratio);
+    }
+
+    filter->initialize(targetCount);
+    std::memcpy(filter->getImpulseResponse(), taps, sizeof(float) * (size_t)targetCount);
+    delete[] taps;
+}
 
 void logLockWait(const char *lockName, long long waitUs) {
     if (waitUs <= 0) return;
     if (waitUs >= 200) {
-        DebugTrace::Log("audio_thread", "lock_wait lock=%s wait_us=%lld", lockName, waitUs);
+        ATG_ENGINE_SIM_TRACE(AudioThread, Verbose, "lock_wait lock=%s wait_us=%lld", lockName, waitUs);
     }
 }
 } /* namespace */
@@ -29,64 +76,209 @@ Synthesizer::Synthesizer() {
     m_inputChannels = nullptr;
     m_inputChannelCount = 0;
     m_inputBufferSize = 0;
-    m_inputWriteOffset = 0.0;
-    m_inputSamplesRead = 0;
-
+    m_latency = 0;
+    m_levelerGain = 1.0f;
+
+    m_inputWritePosition = 0;
+    m_inputWriteCursor = 0;
+    m_probedInputIndex = 0;
+    m_probedInput = false;
+    m_inputWriteIndex = 0;
+    m_inputReadIndex = 0;
+    m_inputObservedIndex = 0;
+    m_renderWaiting = false;
+    m_processedWaiters = 0;
+
+    m_audioBuffer = nullptr;
     m_audioBufferSize = 0;
+    m_renderLimit = 0;
+    m_audioWriteIndex = 0;
+    m_audioReadIndex = 0;
 
     m_inputSampleRate = 0.0;
     m_audioSampleRate = 0.0;
 
-    m_lastInputSampleOffset = 0.0;
+    m_resamplerOutputs = nullptr;
+    m_stageChannels = nullptr;
+    m_transferChannels = nullptr;
+    m_noiseChannels = nullptr;
+    m_inputCutoffFrequency = 1900.0f;
 
     m_run = true;
+    m_offline = false;
     m_thread = nullptr;
     m_filters = nullptr;
+    m_convolutionGroups = nullptr;
+    m_convolutionInputs = nullptr;
+    m_randomSeed = 0;
+    m_partitionedConvolution = true;
+    m_offloadConvolutionTail = false;
+    m_leveling = true;
+    m_parameterSmoothing = 0.0f;
+
+    m_stageBuffer = nullptr;
+    m_dcBuffer = nullptr;
+    m_signalBuffer = nullptr;
+    m_outputBuffer = nullptr;
+    m_outputDither = false;
+    m_analysisEnabled = false;
+    m_latencyProbe = nullptr;
+    m_ditherBuffer = nullptr;
+
+    m_concealmentPeriod = 0;
+    m_concealmentHistory = nullptr;
+    m_concealmentHistorySize = 0;
+    m_concealmentWrite = 0;
+    m_concealmentOffset = 0.0f;
+    m_concealmentFade = 0;
+    m_concealing = false;
+    m_concealmentBuffer = nullptr;
+    m_convolutionFraction = 1.0f;
+    m_appliedConvolutionFraction = 1.0f;
+
+    m_outputChannelCount = 0;
+    m_outputMix = nullptr;
+    m_mixBuffer = nullptr;
+    m_multichannelBuffer = nullptr;
+    m_multichannelWriteIndex = 0;
+    m_multichannelReadIndex = 0;
 }
 
 Synthesizer::~Synthesizer() {
     assert(m_inputChannels == nullptr);
+    assert(m_audioBuffer == nullptr);
     assert(m_thread == nullptr);
     assert(m_filters == nullptr);
+    assert(m_convolutionGroups == nullptr);
+    assert(m_convolutionInputs == nullptr);
+    assert(m_stageBuffer == nullptr);
+    assert(m_dcBuffer == nullptr);
+    assert(m_signalBuffer == nullptr);
+    assert(m_outputBuffer == nullptr);
+    assert(m_ditherBuffer == nullptr);
+    assert(m_concealmentHistory == nullptr);
+    assert(m_concealmentBuffer == nullptr);
+    assert(m_resamplerOutputs == nullptr);
+    assert(m_stageChannels == nullptr);
+    assert(m_outputMix == nullptr);
+    assert(m_mixBuffer == nullptr);
+    assert(m_multichannelBuffer == nullptr);
 }
 
 void Synthesizer::initialize(const Parameters &p) {
     m_inputChannelCount = std::max(0, p.inputChannelCount);
     m_inputBufferSize = std::max(1, p.inputBufferSize);
-    m_inputWriteOffset = m_inputBufferSize;
     m_audioBufferSize = std::max(1, p.audioBufferSize);
+    m_renderLimit = std::max(1, p.renderLimit);
     m_inputSampleRate = (p.inputSampleRate > 0.0f) ? p.inputSampleRate : 1.0f;
     m_audioSampleRate = (p.audioSampleRate > 0.0f) ? p.audioSampleRate : 1.0f;
     m_audioParameters = p.initialAudioParameters;
-
-    m_inputSamplesRead = 0;
-
-    m_inputWriteOffset = 0;
-    m_processed = true;
-
-    m_audioBuffer.initialize((size_t)m_audioBufferSize);
+    m_controlAudioParameters = p.initialAudioParameters;
+    m_audioParameterUpdates.reset(p.initialAudioParameters);
+    m_partitionedConvolution = p.partitionedConvolution;
+    m_offloadConvolutionTail = p.offloadConvolutionTail;
+    m_leveling = p.leveling;
+    m_parameterSmoothing = std::max(0.0f, p.parameterSmoothing);
+    resetSmoothedParameters();
+    if (m_offloadConvolutionTail) m_convolutionWorker.initialize(RenderPeriod);
+
+    m_renderedBlocks = 0;
+    m_renderedSamples = 0;
+    m_renderNanoseconds = 0;
+    m_underrunCount = 0;
+    m_overrunCount = 0;
+    m_lock0ContentionCount = 0;
+    m_inputDroppedCount = 0;
+
+    m_inputWritePosition = 0;
+    m_inputWriteCursor = 0;
+    m_probedInputIndex = 0;
+    m_probedInput = false;
+    m_inputWriteIndex = 0;
+    m_inputReadIndex = 0;
+    m_inputObservedIndex = 0;
+
+    m_audioBuffer = new float[m_audioBufferSize];
+    m_audioWriteIndex = 0;
+    m_audioReadIndex = 0;
     m_inputChannels = new InputChannel[m_inputChannelCount];
     for (int i = 0; i < m_inputChannelCount; ++i) {
         m_inputChannels[i].transferBuffer = new float[m_inputBufferSize];
-        m_inputChannels[i].data.initialize((size_t)m_inputBufferSize);
+        m_inputChannels[i].noiseBuffer = new float[m_inputBufferSize];
+        m_inputChannels[i].data = new float[m_inputBufferSize];
+    }
+
+    m_stageBuffer = new float[(size_t)m_inputBufferSize * m_inputChannelCount];
+    m_dcBuffer = new float[m_inputBufferSize];
+    m_signalBuffer = new float[m_inputBufferSize];
+    m_outputBuffer = new float[m_inputBufferSize];
+    m_ditherBuffer = new float[2 * DitherBlockSize];
+
+    m_concealmentHistorySize = static_cast<int>(MaxConcealmentPeriod * m_audioSampleRate) + 1;
+    m_concealmentHistory = new float[m_concealmentHistorySize];
+    m_concealmentBuffer = new float[ConcealmentBlockSize];
+    m_concealmentWrite = 0;
+    m_concealmentOffset = 0.0f;
+    m_concealmentFade = 0;
+    m_concealing = false;
+    m_concealedSamples = 0;
+    m_appliedConvolutionFraction = 1.0f;
+
+    m_analyzer.initialize(m_audioSampleRate);
+
+    m_resampler.initialize(m_inputChannelCount);
+    m_resampler.setRates(m_inputSampleRate, m_audioSampleRate, m_inputCutoffFrequency);
+    m_resamplerOutputs = new float *[m_inputChannelCount];
+
+    m_stageChannels = new float *[3 * (size_t)m_inputChannelCount];
+    m_transferChannels = m_stageChannels + m_inputChannelCount;
+    m_noiseChannels = m_transferChannels + m_inputChannelCount;
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        m_stageChannels[i] = m_stageBuffer + (size_t)i * m_inputBufferSize;
+        m_transferChannels[i] = m_inputChannels[i].transferBuffer;
+        m_noiseChannels[i] = m_inputChannels[i].noiseBuffer;
+    }
+
+    m_outputChannelCount = std::max(0, p.outputChannelCount);
+    if (m_outputChannelCount > 0) {
+        const size_t mixSize = (size_t)m_inputChannelCount * m_outputChannelCount;
+        m_outputMix = new float[mixSize];
+        for (int i = 0; i < m_inputChannelCount; ++i) {
+            for (int j = 0; j < m_outputChannelCount; ++j) {
+                m_outputMix[i * m_outputChannelCount + j] =
+                    (i % m_outputChannelCount == j) ? 1.0f : 0.0f;
+            }
+        }
+
+        m_mixBuffer = new float[(size_t)m_inputBufferSize * m_outputChannelCount];
+        m_multichannelBuffer = new float[(size_t)m_audioBufferSize * m_outputChannelCount];
     }
 
+    m_multichannelWriteIndex = 0;
+    m_multichannelReadIndex = 0;
+
+    m_airNoiseLowPass.initialize(m_inputChannelCount);
+    m_airNoiseLowPass.setCutoffFrequency(
+        m_audioParameters.airNoiseFrequencyCutoff, m_audioSampleRate);
+
+    m_inputDcFilter.initialize(m_inputChannelCount);
+    m_inputDcFilter.setCutoffFrequency(10.0f, 1 / m_audioSampleRate);
+
     m_filters = new ProcessingFilters[m_inputChannelCount];
+    m_convolutionGroups = new int[m_inputChannelCount];
+    m_convolutionInputs = new float[m_inputChannelCount];
     for (int i = 0; i < m_inputChannelCount; ++i) {
-        m_filters[i].airNoiseLowPass.setCutoffFrequency(
-            m_audioParameters.airNoiseFrequencyCutoff, m_audioSampleRate);
+        m_convolutionGroups[i] = i;
 
         m_filters[i].derivative.m_dt = 1 / m_audioSampleRate;
 
-        m_filters[i].inputDcFilter.setCutoffFrequency(10.0);
-        m_filters[i].inputDcFilter.m_dt = 1 / m_audioSampleRate;
-
         m_filters[i].jitterFilter.initialize(
             10,
             m_audioParameters.inputSampleNoiseFrequencyCutoff,
             m_audioSampleRate);
-
-        m_filters[i].antialiasing.setCutoffFrequency(1900.0f, m_audioSampleRate);
+        m_filters[i].jitterFilter.setJitterScale(m_audioParameters.inputSampleNoise);
+        m_filters[i].jitterFilter.seed(m_randomSeed, 2 * i);
+        m_filters[i].airNoise.seed(m_randomSeed, 2 * i + 1);
 
         // Default to a safe identity convolution until an impulse response is loaded.
         m_filters[i].convolution.initialize(1);
@@ -96,11 +288,11 @@ void Synthesizer::initialize(const Parameters &p) {
     m_levelingFilter.p_target = m_audioParameters.levelerTarget;
     m_levelingFilter.p_maxLevel = m_audioParameters.levelerMaxGain;
     m_levelingFilter.p_minLevel = m_audioParameters.levelerMinGain;
+    m_levelingFilter.initializeBlockMode(p.levelerBlockSize, p.leveling ? p.levelerLookahead : 0);
+    m_levelerGain = m_levelingFilter.getAttenuation();
     m_antialiasing.setCutoffFrequency(m_audioSampleRate * 0.45f, m_audioSampleRate);
 
-    for (int i = 0; i < m_audioBufferSize; ++i) {
-        m_audioBuffer.write(0);
-    }
+    std::memset(m_audioBuffer, 0, sizeof(float) * (size_t)m_audioBufferSize);
 }
 
 void Synthesizer::initializeImpulseResponse(
@@ -113,9 +305,133 @@ void Synthesizer::initializeImpulseResponse(
         return;
     }
 
-    if (impulseResponse == nullptr || samples == 0) {
+    unshareConvolution(index);
+    prepareImpulseResponse(impulseResponse, samples, volume, &m_filters[index].convolution);
+    if (m_partitionedConvolution && samples > 0 && impulseResponse != nullptr) {
+        m_filters[index].convolution.preparePartitioned(
+            ConvolutionFilter::DefaultHeadSize,
+            ConvolutionFilter::DefaultTailSize,
+            tailWorker());
+    }
+
+    shareConvolution(index);
+}
+
+void Synthesizer::initializeImpulseResponse(const ConvolutionFilter &prepared, int index) {
+    if (index < 0 || index >= m_inputChannelCount || m_filters == nullptr) {
+        return;
+    }
+
+    unshareConvolution(index);
+    m_filters[index].convolution.initialize(prepared, m_partitionedConvolution, tailWorker());
+    shareConvolution(index);
+}
+
+void Synthesizer::swapImpulseResponses(const std::vector<std::shared_ptr<const ConvolutionFilter>> &prepared) {
+    std::lock_guard<std::mutex> lock(m_impulseResponseLock);
+    m_pendingImpulseResponses = prepared;
+    m_impulseResponsesPending.store(true, std::memory_order_release);
+}
+
+void Synthesizer::installPendingImpulseResponses() {
+    std::vector<std::shared_ptr<const ConvolutionFilter>> prepared;
+    {
+        std::lock_guard<std::mutex> lock(m_impulseResponseLock);
+        prepared.swap(m_pendingImpulseResponses);
+        m_impulseResponsesPending.store(false, std::memory_order_relaxed);
+    }
+
+    const int count = std::min(static_cast<int>(prepared.size()), m_inputChannelCount);
+    for (int i = 0; i < count; ++i) {
+        if (prepared[i] != nullptr) initializeImpulseResponse(*prepared[i], i);
+        else initializeImpulseResponse(nullptr, 0, 0.0f, i);
+    }
+
+    // Applied again to the new partitions below
+    m_appliedConvolutionFraction = -1.0f;
+}
+
+int Synthesizer::getConvolutionCount() const {
+    int count = 0;
+    for (int i = 0; i < m_inputChannelCount && m_filters != nullptr; ++i) {
+        if (m_convolutionGroups[i] == i) ++count;
+    }
+
+    return count;
+}
+
+void Synthesizer::unshareConvolution(int index) {
+    if (m_convolutionGroups[index] != index) {
+        m_convolutionGroups[index] = index;
+        return;
+    }
+
+    // The channels sharing this one's response take it over
+    int next = -1;
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        if (i == index || m_convolutionGroups[i] != index) continue;
+
+        if (next < 0) {
+            next = i;
+            m_filters[i].convolution.initialize(
+                m_filters[index].convolution, m_partitionedConvolution, tailWorker());
+        }
+
+        m_convolutionGroups[i] = next;
+    }
+}
+
+void Synthesizer::shareConvolution(int index) {
+    // The multichannel mix needs every channel convolved on its own
+    if (m_outputChannelCount > 0) return;
+
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        if (i == index || m_convolutionGroups[i] != i) continue;
+        else if (!m_filters[i].convolution.hasSameResponse(m_filters[index].convolution)) continue;
+
         m_filters[index].convolution.initialize(1);
         m_filters[index].convolution.getImpulseResponse()[0] = 1.0f;
+        m_convolutionGroups[index] = i;
+        return;
+    }
+}
+
+void Synthesizer::setPartitionedConvolution(bool partitioned) {
+    m_partitionedConvolution = partitioned;
+    if (m_filters == nullptr) return;
+
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        if (m_convolutionGroups[i] != i) continue;
+
+        ConvolutionFilter prototype;
+        prototype.initialize(m_filters[i].convolution, partitioned, tailWorker());
+        m_filters[i].convolution.initialize(prototype, partitioned, tailWorker());
+        prototype.destroy();
+    }
+}
+
+void Synthesizer::setConvolutionTailOffload(bool offload) {
+    if (offload == m_offloadConvolutionTail) return;
+
+    // The filters are laid out again before the worker they might be
+    // waiting on goes away
+    m_offloadConvolutionTail = offload;
+    if (offload) m_convolutionWorker.initialize(RenderPeriod);
+    setPartitionedConvolution(m_partitionedConvolution);
+    if (!offload) m_convolutionWorker.destroy();
+}
+
+void Synthesizer::prepareImpulseResponse(
+    const int16_t *impulseResponse,
+    unsigned int samples,
+    float volume,
+    ConvolutionFilter *filter,
+    double sourceSampleRate,
+    double targetSampleRate)
+{
+    if (impulseResponse == nullptr || samples == 0) {
+        filter->initialize(1);
+        filter->getImpulseResponse()[0] = 1.0f;
         return;
     }
 
@@ -128,27 +444,31 @@ void Synthesizer::initializeImpulseResponse(
 
     unsigned int sampleCount = std::min(10000U, clippedLength);
     if (sampleCount == 0) sampleCount = 1;
-    m_filters[index].convolution.initialize(sampleCount);
+    filter->initialize(sampleCount);
     for (unsigned int i = 0; i < sampleCount; ++i) {
         if (i < clippedLength) {
-            m_filters[index].convolution.getImpulseResponse()[i] =
+            filter->getImpulseResponse()[i] =
                 volume * impulseResponse[i] / INT16_MAX;
         }
         else {
-            m_filters[index].convolution.getImpulseResponse()[i] = (i == 0) ? 1.0f : 0.0f;
+            filter->getImpulseResponse()[i] = (i == 0) ? 1.0f : 0.0f;
         }
     }
+
+    if (sourceSampleRate > 0 && targetSampleRate > 0 && sourceSampleRate != targetSampleRate) {
+        resampleImpulseResponse(filter, sourceSampleRate / targetSampleRate);
+    }
 }
 
 void Synthesizer::startAudioRenderingThread() {
-    DebugTrace::Log("audio_thread", "startAudioRenderingThread requested");
+    ATG_ENGINE_SIM_TRACE(AudioThread, Event, "startAudioRenderingThread requested");
     m_run = true;
     m_thread = new std::thread(&Synthesizer::audioRenderingThread, this);
 }
 
 void Synthesizer::endAudioRenderingThread() {
     if (m_thread != nullptr) {
-        DebugTrace::Log("audio_thread", "endAudioRenderingThread begin");
+        ATG_ENGINE_SIM_TRACE(AudioThread, Event, "endAudioRenderingThread begin");
         m_run = false;
         endInputBlock();
 
@@ -156,140 +476,479 @@ void Synthesizer::endAudioRenderingThread() {
         delete m_thread;
 
         m_thread = nullptr;
-        DebugTrace::Log("audio_thread", "endAudioRenderingThread complete");
+        ATG_ENGINE_SIM_TRACE(AudioThread, Event, "endAudioRenderingThread complete");
     }
 }
 
 void Synthesizer::destroy() {
-    m_audioBuffer.destroy();
+    delete[] m_audioBuffer;
+    m_audioBuffer = nullptr;
 
     for (int i = 0; i < m_inputChannelCount; ++i) {
         delete[] m_inputChannels[i].transferBuffer;
+        delete[] m_inputChannels[i].noiseBuffer;
+        delete[] m_inputChannels[i].data;
         m_inputChannels[i].transferBuffer = nullptr;
-        m_inputChannels[i].data.destroy();
+        m_inputChannels[i].noiseBuffer = nullptr;
+        m_inputChannels[i].data = nullptr;
         m_filters[i].jitterFilter.destroy();
         m_filters[i].convolution.destroy();
     }
 
     delete[] m_inputChannels;
     delete[] m_filters;
+    delete[] m_convolutionGroups;
+    delete[] m_convolutionInputs;
+    delete[] m_stageBuffer;
+    delete[] m_dcBuffer;
+    delete[] m_signalBuffer;
+    delete[] m_outputBuffer;
+    delete[] m_ditherBuffer;
+    delete[] m_concealmentHistory;
+    delete[] m_concealmentBuffer;
+    delete[] m_resamplerOutputs;
+    delete[] m_stageChannels;
+    delete[] m_outputMix;
+    delete[] m_mixBuffer;
+    delete[] m_multichannelBuffer;
+    m_resampler.destroy();
+    m_analyzer.destroy();
+    m_convolutionWorker.destroy();
+    {
+        std::lock_guard<std::mutex> lock(m_impulseResponseLock);
+        m_pendingImpulseResponses.clear();
+        m_impulseResponsesPending = false;
+    }
 
     m_inputChannels = nullptr;
     m_filters = nullptr;
+    m_convolutionGroups = nullptr;
+    m_convolutionInputs = nullptr;
+    m_stageBuffer = nullptr;
+    m_dcBuffer = nullptr;
+    m_signalBuffer = nullptr;
+    m_outputBuffer = nullptr;
+    m_ditherBuffer = nullptr;
+    m_concealmentHistory = nullptr;
+    m_concealmentBuffer = nullptr;
+    m_concealmentHistorySize = 0;
+    m_resamplerOutputs = nullptr;
+    m_stageChannels = nullptr;
+    m_transferChannels = nullptr;
+    m_noiseChannels = nullptr;
+    m_airNoiseLowPass.destroy();
+    m_inputDcFilter.destroy();
+    m_outputMix = nullptr;
+    m_mixBuffer = nullptr;
+    m_multichannelBuffer = nullptr;
 
     m_inputChannelCount = 0;
+    m_outputChannelCount = 0;
 }
 
 int Synthesizer::readAudioOutput(int samples, int16_t *buffer) {
-    if (samples <= 0 || buffer == nullptr) {
+    if (samples <= 0 || buffer == nullptr || m_audioBuffer == nullptr) {
         return 0;
     }
 
-    const auto lockStart = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(m_lock0);
-    const auto lockEnd = std::chrono::steady_clock::now();
-    const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-    if (lockWaitUs > 0) g_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
-    logLockWait("m_lock0(readAudioOutput)", static_cast<long long>(lockWaitUs));
+    // Concealment needs the output as floats to remember and crossfade it
+    if (m_concealmentPeriod.load(std::memory_order_relaxed) > 0) {
+        int samplesConsumed = 0;
+        for (int i = 0; i < samples; i += ConcealmentBlockSize) {
+            const int n = std::min(ConcealmentBlockSize, samples - i);
+            const int read = readAudioOutput(n, m_concealmentBuffer);
+            quantizeOutput(m_concealmentBuffer, buffer + i, n);
+            samplesConsumed += read;
+
+            if (read < n) {
+                std::memset(buffer + i + n, 0, sizeof(int16_t) * ((size_t)samples - i - n));
+                break;
+            }
+        }
 
-    const int newDataLength = m_audioBuffer.size();
-    if (newDataLength >= samples) {
-        m_audioBuffer.readAndRemove(samples, buffer);
+        return samplesConsumed;
     }
-    else {
-        m_audioBuffer.readAndRemove(newDataLength, buffer);
-        memset(
-            buffer + newDataLength,
-            0,
-            sizeof(int16_t) * ((size_t)samples - newDataLength));
+
+    size_t readIndex;
+    const int samplesConsumed = beginAudioRead(samples, &readIndex);
+
+    const size_t start = readIndex % (size_t)m_audioBufferSize;
+    const int first = std::min(samplesConsumed, m_audioBufferSize - (int)start);
+    quantizeOutput(m_audioBuffer + start, buffer, first);
+    quantizeOutput(m_audioBuffer, buffer + first, samplesConsumed - first);
+    memset(
+        buffer + samplesConsumed,
+        0,
+        sizeof(int16_t) * ((size_t)samples - samplesConsumed));
+
+    endAudioRead(readIndex + samplesConsumed);
+
+    return samplesConsumed;
+}
+
+int Synthesizer::readAudioOutput(int samples, float *buffer) {
+    if (samples <= 0 || buffer == nullptr || m_audioBuffer == nullptr) {
+        return 0;
     }
-    
-    const int samplesConsumed = std::min(samples, newDataLength);
+
+    size_t readIndex;
+    const int samplesConsumed = beginAudioRead(samples, &readIndex);
+
+    const size_t start = readIndex % (size_t)m_audioBufferSize;
+    const int first = std::min(samplesConsumed, m_audioBufferSize - (int)start);
+    memcpy(buffer, m_audioBuffer + start, sizeof(float) * first);
+    memcpy(buffer + first, m_audioBuffer, sizeof(float) * (samplesConsumed - first));
+    recordOutput(buffer, samplesConsumed);
+    memset(
+        buffer + samplesConsumed,
+        0,
+        sizeof(float) * ((size_t)samples - samplesConsumed));
+
+    endAudioRead(readIndex + samplesConsumed);
 
     return samplesConsumed;
 }
 
+void Synthesizer::setConcealmentPeriod(double seconds) {
+    const int period = (seconds > 0) ? static_cast<int>(std::round(seconds * m_audioSampleRate)) : 0;
+    m_concealmentPeriod.store(
+        std::min(period, m_concealmentHistorySize - 1), std::memory_order_relaxed);
+}
+
+int Synthesizer::concealOutput(int samples, float *buffer) {
+    const int period = m_concealmentPeriod.load(std::memory_order_relaxed);
+    if (samples <= 0 || buffer == nullptr || m_concealmentHistory == nullptr) return 0;
+    else if (period <= 0 || m_concealmentWrite < (size_t)period) return 0;
+
+    // The repeat starts a period back, so it's offset to meet the last
+    // sample and the offset is let go over the fade
+    if (!m_concealing) {
+        const float last =
+            m_concealmentHistory[(m_concealmentWrite - 1) % m_concealmentHistorySize];
+        m_concealmentOffset = last - repeatSample(period);
+        m_concealing = true;
+    }
+
+    for (int i = 0; i < samples; ++i) {
+        buffer[i] = repeatSample(period) + m_concealmentOffset;
+        m_concealmentOffset *= 1.0f - 1.0f / ConcealmentFade;
+        pushConcealmentHistory(buffer[i]);
+    }
+
+    m_concealmentFade = ConcealmentFade;
+    m_concealedSamples.fetch_add(samples, std::memory_order_relaxed);
+
+    return samples;
+}
+
+int Synthesizer::concealOutput(int samples, int16_t *buffer) {
+    if (samples <= 0 || buffer == nullptr || m_concealmentBuffer == nullptr) return 0;
+
+    int concealed = 0;
+    for (int i = 0; i < samples; i += ConcealmentBlockSize) {
+        const int n = std::min(ConcealmentBlockSize, samples - i);
+        if (concealOutput(n, m_concealmentBuffer) < n) break;
+
+        quantizeOutput(m_concealmentBuffer, buffer + i, n);
+        concealed += n;
+    }
+
+    return concealed;
+}
+
+void Synthesizer::recordOutput(float *buffer, int samples) {
+    const int period = m_concealmentPeriod.load(std::memory_order_relaxed);
+    if (period <= 0 || m_concealmentHistory == nullptr) {
+        m_concealing = false;
+        m_concealmentFade = 0;
+        return;
+    }
+
+    for (int i = 0; i < samples; ++i) {
+        if (m_concealmentFade > 0 && m_concealmentWrite >= (size_t)period) {
+            const float w = (float)(ConcealmentFade - m_concealmentFade + 1) / (ConcealmentFade + 1);
+            buffer[i] = w * buffer[i] + (1 - w) * repeatSample(period);
+            --m_concealmentFade;
+        }
+
+        pushConcealmentHistory(buffer[i]);
+    }
+
+    if (samples > 0) m_concealing = false;
+}
+
+void Synthesizer::pushConcealmentHistory(float sample) {
+    m_concealmentHistory[m_concealmentWrite % m_concealmentHistorySize] = sample;
+    ++m_concealmentWrite;
+}
+
+float Synthesizer::repeatSample(int period) const {
+    return ConcealmentDecay
+        * m_concealmentHistory[(m_concealmentWrite - period) % m_concealmentHistorySize];
+}
+
+int Synthesizer::beginAudioRead(int samples, size_t *readIndex) const {
+    *readIndex = m_audioReadIndex.load(std::memory_order_relaxed);
+    const size_t newDataLength =
+        m_audioWriteIndex.load(std::memory_order_acquire) - *readIndex;
+
+    return (int)std::min((size_t)samples, newDataLength);
+}
+
+void Synthesizer::endAudioRead(size_t readIndex) {
+    // The probe's sample is somewhere in this read; the reader finds it by
+    // its offset
+    LatencyProbe *probe = m_latencyProbe.load(std::memory_order_acquire);
+    if (probe != nullptr && probe->isWaiting(LatencyProbe::Stage::Read)) {
+        const size_t sample = probe->getPosition(LatencyProbe::Stage::Rendered);
+        const size_t previous = m_audioReadIndex.load(std::memory_order_relaxed);
+        if (sample < readIndex) {
+            probe->mark(LatencyProbe::Stage::Read, (sample > previous) ? sample - previous : 0);
+        }
+    }
+
+    m_audioReadIndex.store(readIndex);
+
+    // Offline rendering is paced by the reader, so wake the audio thread if
+    // it is waiting for space
+    if (m_offline && m_renderWaiting.load()) {
+        { std::lock_guard<std::mutex> lk(m_lock0); }
+        m_cv0.notify_all();
+    }
+}
+
+void Synthesizer::quantizeOutput(const float *input, int16_t *output, int samples) {
+    if (!m_outputDither || m_ditherBuffer == nullptr) {
+        quantizeToInt16(input, output, samples, Int16Scale);
+        return;
+    }
+
+    // Triangular dither of +-1 LSB from the sum of two uniform draws
+    float *dither = m_ditherBuffer;
+    float *second = m_ditherBuffer + DitherBlockSize;
+    for (int i = 0; i < samples; i += DitherBlockSize) {
+        const int n = std::min(DitherBlockSize, samples - i);
+        m_ditherNoise.fill(dither, n, -0.5f, 0.5f);
+        m_ditherNoise.fill(second, n, -0.5f, 0.5f);
+        for (int j = 0; j < n; ++j) {
+            dither[j] += second[j];
+        }
+
+        quantizeToInt16(input + i, output + i, n, Int16Scale, dither);
+    }
+}
+
+int Synthesizer::audioSamplesAvailable() const {
+    return static_cast<int>(
+        m_audioWriteIndex.load(std::memory_order_acquire)
+        - m_audioReadIndex.load(std::memory_order_acquire));
+}
+
+int Synthesizer::readMultichannelOutput(int frames, float *buffer) {
+    if (frames <= 0 || buffer == nullptr || m_multichannelBuffer == nullptr) {
+        return 0;
+    }
+
+    const int channels = m_outputChannelCount;
+
+    int read = 0;
+    while (read < frames) {
+        const float *data = nullptr;
+        const int n = std::min(frames - read, peekMultichannelOutput(&data));
+        if (n <= 0) break;
+
+        memcpy(buffer + (size_t)read * channels, data, sizeof(float) * (size_t)n * channels);
+        consumeMultichannelOutput(n);
+        read += n;
+    }
+
+    memset(
+        buffer + (size_t)read * channels,
+        0,
+        sizeof(float) * (size_t)(frames - read) * channels);
+
+    return read;
+}
+
+int Synthesizer::peekMultichannelOutput(const float **frames) const {
+    if (m_multichannelBuffer == nullptr) {
+        *frames = nullptr;
+        return 0;
+    }
+
+    const size_t capacity = (size_t)m_audioBufferSize;
+    const size_t readIndex = m_multichannelReadIndex.load(std::memory_order_relaxed);
+    const size_t available =
+        m_multichannelWriteIndex.load(std::memory_order_acquire) - readIndex;
+    const size_t start = readIndex % capacity;
+
+    *frames = m_multichannelBuffer + start * m_outputChannelCount;
+    return (int)std::min(available, capacity - start);
+}
+
+void Synthesizer::consumeMultichannelOutput(int frames) {
+    if (frames <= 0) return;
+
+    const size_t readIndex = m_multichannelReadIndex.load(std::memory_order_relaxed);
+    const size_t available =
+        m_multichannelWriteIndex.load(std::memory_order_acquire) - readIndex;
+    m_multichannelReadIndex.store(readIndex + std::min((size_t)frames, available));
+}
+
+int Synthesizer::multichannelFramesAvailable() const {
+    return static_cast<int>(
+        m_multichannelWriteIndex.load(std::memory_order_acquire)
+        - m_multichannelReadIndex.load(std::memory_order_acquire));
+}
+
+void Synthesizer::setOutputMix(int input, int output, float gain) {
+    if (m_outputMix == nullptr) return;
+    if (input < 0 || input >= m_inputChannelCount) return;
+    if (output < 0 || output >= m_outputChannelCount) return;
+
+    m_outputMix[input * m_outputChannelCount + output] = gain;
+}
+
+float Synthesizer::getOutputMix(int input, int output) const {
+    if (m_outputMix == nullptr) return 0.0f;
+    if (input < 0 || input >= m_inputChannelCount) return 0.0f;
+    if (output < 0 || output >= m_outputChannelCount) return 0.0f;
+
+    return m_outputMix[input * m_outputChannelCount + output];
+}
+
 void Synthesizer::waitProcessed() {
     {
         const auto lockStart = std::chrono::steady_clock::now();
-        std::unique_lock<std::mutex> lk(m_lock0);
+        std::unique_lock<std::mutex> lk(m_lock0, std::defer_lock);
+        {
+            ATG_ENGINE_SIM_PROFILE_SCOPE(SynthesizerLockWait);
+            lk.lock();
+        }
         const auto lockEnd = std::chrono::steady_clock::now();
         const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-        if (lockWaitUs > 0) g_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
+        if (lockWaitUs > 0) m_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
         logLockWait("m_lock0(waitProcessed)", static_cast<long long>(lockWaitUs));
-        m_cv0.wait(lk, [this] { return m_processed; });
+
+        ++m_processedWaiters;
+        m_cv0.wait(lk, [this] { return isProcessed() || !m_run; });
+        --m_processedWaiters;
     }
 }
 
-void Synthesizer::writeInput(const double *data) {
-    if (data == nullptr || m_inputChannelCount <= 0 || m_inputChannels == nullptr || m_filters == nullptr) {
+bool Synthesizer::isProcessed() const {
+    return m_inputObservedIndex.load() == m_inputWriteIndex.load();
+}
+
+int Synthesizer::inputSamplesAvailable() const {
+    return static_cast<int>(
+        m_inputWriteIndex.load(std::memory_order_acquire)
+        - m_inputReadIndex.load(std::memory_order_acquire));
+}
+
+void Synthesizer::writeInput(const double *data, int frames) {
+    if (data == nullptr || frames <= 0) {
         return;
     }
 
-    if (m_inputSampleRate <= 0 || m_inputBufferSize <= 0) {
+    ATG_ENGINE_SIM_PROFILE_SCOPE(SynthesizerInput);
+
+    if (m_inputChannelCount <= 0 || m_inputChannels == nullptr || m_filters == nullptr) {
         return;
     }
 
-    m_inputWriteOffset += (double)m_audioSampleRate / m_inputSampleRate;
-    if (m_inputWriteOffset >= (double)m_inputBufferSize) {
-        m_inputWriteOffset -= (double)m_inputBufferSize;
+    if (m_inputSampleRate <= 0 || m_inputBufferSize <= 0) {
+        return;
     }
 
-    for (int i = 0; i < m_inputChannelCount; ++i) {
-        RingBuffer<float> &buffer = m_inputChannels[i].data;
-        const double lastInputSample = m_inputChannels[i].lastInputSample;
-        const size_t baseIndex = buffer.writeIndex();
-        const double distance =
-            inputDistance(m_inputWriteOffset, m_lastInputSampleOffset);
-        if (distance <= 1e-12) {
-            m_inputChannels[i].lastInputSample = data[i];
-            continue;
-        }
-
-        double s =
-            inputDistance(baseIndex, m_lastInputSampleOffset);
-        for (; s <= distance; s += 1.0) {
-            if (s >= m_inputBufferSize) s -= m_inputBufferSize;
+    // The free space only grows while the block is written, so one read of
+    // the consumer index covers every frame. Samples past it still advance
+    // the resampler so the time base stays put, but they are not computed
+    // or stored.
+    const size_t capacity = (size_t)m_inputBufferSize;
+    const size_t space =
+        capacity - (m_inputWriteCursor - m_inputReadIndex.load(std::memory_order_acquire));
+
+    // The first block written after the probe's control was applied; its
+    // first sample stands for the whole block
+    LatencyProbe *probe = m_latencyProbe.load(std::memory_order_acquire);
+    const bool probed = probe != nullptr && probe->isWaiting(LatencyProbe::Stage::Published);
+
+    size_t written = 0;
+    size_t dropped = 0;
+    for (int f = 0; f < frames; ++f) {
+        m_resampler.push(data + (size_t)f * m_inputChannelCount);
+
+        while (written < space) {
+            const size_t index = (m_inputWriteCursor + written) % capacity;
+            const int run = (int)std::min(capacity - index, space - written);
+            for (int i = 0; i < m_inputChannelCount; ++i) {
+                m_resamplerOutputs[i] = m_inputChannels[i].data + index;
+            }
 
-            const double f = s / distance;
-            const double sample = lastInputSample * (1 - f) + data[i] * f;
+            const int n = m_resampler.generate(m_resamplerOutputs, run);
+            written += n;
 
-            buffer.write(m_filters[i].antialiasing.fast_f(static_cast<float>(sample)));
+            if (n < run) break;
         }
 
-        m_inputChannels[i].lastInputSample = data[i];
+        dropped += (size_t)m_resampler.discard();
+    }
+
+    if (dropped > 0) {
+        m_inputDroppedCount.fetch_add(dropped, std::memory_order_relaxed);
     }
 
-    m_lastInputSampleOffset = m_inputWriteOffset;
+    if (probed && written > 0) {
+        m_probedInputIndex = m_inputWriteCursor;
+        m_probedInput = true;
+    }
+
+    m_inputWritePosition += written + dropped;
+    m_inputWriteCursor += written;
 }
 
 void Synthesizer::endInputBlock() {
-    const auto lockStart = std::chrono::steady_clock::now();
-    std::unique_lock<std::mutex> lk(m_inputLock); 
-    const auto lockEnd = std::chrono::steady_clock::now();
-    const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-    if (lockWaitUs > 0) g_inputLockContentionCount.fetch_add(1, std::memory_order_relaxed);
-    logLockWait("m_inputLock(endInputBlock)", static_cast<long long>(lockWaitUs));
+    m_inputWriteIndex.store(m_inputWriteCursor);
 
-    for (int i = 0; i < m_inputChannelCount; ++i) {
-        m_inputChannels[i].data.removeBeginning(m_inputSamplesRead);
+    if (m_probedInput) {
+        m_probedInput = false;
+
+        LatencyProbe *probe = m_latencyProbe.load(std::memory_order_acquire);
+        if (probe != nullptr && probe->isWaiting(LatencyProbe::Stage::Published)) {
+            probe->mark(LatencyProbe::Stage::Published, m_probedInputIndex);
+        }
     }
+    m_latency = static_cast<int>(m_inputWriteCursor - m_inputReadIndex.load());
 
-    if (m_inputChannelCount != 0) {
-        m_latency = m_inputChannels[0].data.size();
+    // Taking the lock only matters when the audio thread may be between its
+    // predicate check and the wait; in steady state it is busy rendering
+    if (m_renderWaiting.load()) {
+        { std::lock_guard<std::mutex> lk(m_lock0); }
+        m_cv0.notify_all();
     }
-    
-    m_inputSamplesRead = 0;
-    m_processed = false;
 
-    lk.unlock();
-    m_cv0.notify_one();
+    // Offline rendering blocks the producer until the audio thread has picked
+    // up this block rather than letting the input ring run ahead.
+    if (m_offline && m_thread != nullptr && m_run) {
+        std::unique_lock<std::mutex> lk0(m_lock0);
+        ++m_processedWaiters;
+        m_cv0.wait(lk0, [this] { return isProcessed() || !m_run; });
+        --m_processedWaiters;
+    }
 }
 
 void Synthesizer::audioRenderingThread() {
-    DebugTrace::Log("audio_thread", "audioRenderingThread started");
+    ATG_ENGINE_SIM_ALLOCATION_SCOPE(Synthesizer);
+    ATG_ENGINE_SIM_TRACE(AudioThread, Event, "audioRenderingThread started");
+    StepProfiler::SetThreadName("audio");
+
+    ThreadPolicy::ApplyToCurrentThread(ThreadPolicy::Role::Audio, RenderPeriod);
+
     auto nextHeartbeat = std::chrono::steady_clock::now() + std::chrono::seconds(1);
     int cyclesSinceHeartbeat = 0;
+    unsigned long long lockContentions = 0;
+    unsigned long long inputDropped = 0;
     int underrunCount = 0;
     int overrunCount = 0;
     long long totalCycleMicros = 0;
@@ -302,11 +961,15 @@ void Synthesizer::audioRenderingThread() {
         totalCycleMicros += std::chrono::duration_cast<std::chrono::microseconds>(cycleEnd - cycleStart).count();
 
         if (m_inputChannelCount > 0 && m_inputChannels != nullptr) {
-            if (m_inputChannels[0].data.size() <= 0) {
+            if (inputSamplesAvailable() <= 0) {
                 ++underrunCount;
+                m_underrunCount.fetch_add(1, std::memory_order_relaxed);
+                ATG_ENGINE_SIM_COUNT(AudioUnderruns, 1);
             }
-            else if (m_inputChannels[0].data.size() > (size_t)(m_inputBufferSize * 3 / 4)) {
+            else if (inputSamplesAvailable() > m_inputBufferSize * 3 / 4) {
                 ++overrunCount;
+                m_overrunCount.fetch_add(1, std::memory_order_relaxed);
+                ATG_ENGINE_SIM_COUNT(AudioOverruns, 1);
             }
         }
 
@@ -316,28 +979,33 @@ void Synthesizer::audioRenderingThread() {
                 (cyclesSinceHeartbeat > 0)
                 ? static_cast<double>(totalCycleMicros) / cyclesSinceHeartbeat
                 : 0.0;
-            DebugTrace::Log(
-                "audio_thread",
+            ATG_ENGINE_SIM_TRACE(
+                AudioThread, Verbose,
                 "heartbeat cycles=%d input_channels=%d input_buffer=%d audio_buffer=%d latency=%.6f processed=%d avg_cycle_us=%.2f underrun=%d overrun=%d",
                 cyclesSinceHeartbeat,
                 m_inputChannelCount,
-                (m_inputChannelCount > 0 && m_inputChannels != nullptr) ? static_cast<int>(m_inputChannels[0].data.size()) : 0,
-                static_cast<int>(m_audioBuffer.size()),
+                inputSamplesAvailable(),
+                audioSamplesAvailable(),
                 getLatency(),
-                m_processed ? 1 : 0,
+                isProcessed() ? 1 : 0,
                 avgCycleMicros,
                 underrunCount,
                 overrunCount);
-            DebugTrace::Log(
-                "audio_thread",
+            ATG_ENGINE_SIM_TRACE(
+                AudioThread, Verbose,
                 "mailbox_queue_lengths input_ring=%d audio_ring=%d",
-                (m_inputChannelCount > 0 && m_inputChannels != nullptr) ? static_cast<int>(m_inputChannels[0].data.size()) : 0,
-                static_cast<int>(m_audioBuffer.size()));
-            DebugTrace::Log(
-                "audio_thread",
-                "lock_contention_counters lock0=%llu input_lock=%llu",
-                (unsigned long long)g_lock0ContentionCount.exchange(0, std::memory_order_relaxed),
-                (unsigned long long)g_inputLockContentionCount.exchange(0, std::memory_order_relaxed));
+                inputSamplesAvailable(),
+                audioSamplesAvailable());
+            // The totals keep running for getRenderStatistics()
+            const unsigned long long lockContentionTotal = m_lock0ContentionCount.load(std::memory_order_relaxed);
+            const unsigned long long inputDroppedTotal = m_inputDroppedCount.load(std::memory_order_relaxed);
+            ATG_ENGINE_SIM_TRACE(
+                AudioThread, Verbose,
+                "lock_contention_counters lock0=%llu input_dropped=%llu",
+                lockContentionTotal - lockContentions,
+                inputDroppedTotal - inputDropped);
+            lockContentions = lockContentionTotal;
+            inputDropped = inputDroppedTotal;
             cyclesSinceHeartbeat = 0;
             totalCycleMicros = 0;
             underrunCount = 0;
@@ -346,33 +1014,45 @@ void Synthesizer::audioRenderingThread() {
         }
     }
 
-    DebugTrace::Log("audio_thread", "audioRenderingThread exiting");
+    ThreadPolicy::ReleaseCurrentThread(ThreadPolicy::Role::Audio);
+    ATG_ENGINE_SIM_TRACE(AudioThread, Event, "audioRenderingThread exiting");
 }
 
 #undef max
 void Synthesizer::renderAudio() {
     const auto lockStart = std::chrono::steady_clock::now();
-    std::unique_lock<std::mutex> lk0(m_lock0);
+    std::unique_lock<std::mutex> lk0(m_lock0, std::defer_lock);
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(SynthesizerLockWait);
+        lk0.lock();
+    }
     const auto lockEnd = std::chrono::steady_clock::now();
     const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-    if (lockWaitUs > 0) g_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
+    if (lockWaitUs > 0) m_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
     logLockWait("m_lock0(renderAudio)", static_cast<long long>(lockWaitUs));
 
     const auto sleepStart = std::chrono::steady_clock::now();
 
-    m_cv0.wait(lk0, [this] {
+    const auto ready = [this] {
         const bool hasInputChannel = m_inputChannelCount > 0 && m_inputChannels != nullptr;
         const bool inputAvailable =
             hasInputChannel
-            && m_inputChannels[0].data.size() > 0
-            && m_audioBuffer.size() < 2000;
-        return !m_run || (inputAvailable && !m_processed);
-    });
+            && inputSamplesAvailable() > 0
+            && audioSamplesAvailable() < audioBufferLimit();
+        return !m_run || inputAvailable;
+    };
+
+    if (!ready()) {
+        m_renderWaiting = true;
+        m_cv0.wait(lk0, ready);
+        m_renderWaiting = false;
+    }
+
     const auto wakeTs = std::chrono::steady_clock::now();
     const auto sleepUs = std::chrono::duration_cast<std::chrono::microseconds>(wakeTs - sleepStart).count();
     if (sleepUs >= 500) {
-        DebugTrace::Log(
-            "audio_thread",
+        ATG_ENGINE_SIM_TRACE(
+            AudioThread, Verbose,
             "thread_state transition=wake reason=%s slept_us=%lld",
             m_run ? "input_or_space" : "shutdown",
             static_cast<long long>(sleepUs));
@@ -382,37 +1062,182 @@ void Synthesizer::renderAudio() {
         return;
     }
 
+    renderInput(lk0, wakeTs);
+}
+
+int Synthesizer::renderPendingAudio() {
+    std::unique_lock<std::mutex> lk0(m_lock0);
+    return renderInput(lk0, std::chrono::steady_clock::now());
+}
+
+int Synthesizer::renderInput(
+    std::unique_lock<std::mutex> &lk0,
+    std::chrono::steady_clock::time_point wakeTs)
+{
     if (m_inputChannelCount <= 0 || m_inputChannels == nullptr || m_filters == nullptr) {
-        m_processed = true;
-        lk0.unlock();
-        m_cv0.notify_one();
-        return;
+        return 0;
     }
 
+    // Per block rather than per thread so pull-mode callers on a host's
+    // thread get it too, and get their own mode back
+    DenormalScope denormals;
+
+    const size_t writeIndex = m_inputWriteIndex.load(std::memory_order_acquire);
+    const size_t readIndex = m_inputReadIndex.load(std::memory_order_relaxed);
     const int n = std::min(
-        std::max(0, 2000 - (int)m_audioBuffer.size()),
-        (int)m_inputChannels[0].data.size());
+        std::max(0, audioBufferLimit() - audioSamplesAvailable()),
+        static_cast<int>(writeIndex - readIndex));
+
+    lk0.unlock();
 
+    const size_t capacity = (size_t)m_inputBufferSize;
+    const size_t start = readIndex % capacity;
+    const size_t first = std::min((size_t)n, capacity - start);
     for (int i = 0; i < m_inputChannelCount; ++i) {
-        m_inputChannels[i].data.read(n, m_inputChannels[i].transferBuffer);
+        const float *data = m_inputChannels[i].data;
+        float *transfer = m_inputChannels[i].transferBuffer;
+        memcpy(transfer, data + start, sizeof(float) * first);
+        memcpy(transfer + first, data, sizeof(float) * (n - first));
     }
-    
-    m_inputSamplesRead = n;
-    m_processed = true;
 
-    lk0.unlock();
+    m_inputReadIndex.store(readIndex + n);
+    m_inputObservedIndex.store(writeIndex);
+
+    if (m_processedWaiters.load() > 0) {
+        { std::lock_guard<std::mutex> lk(m_lock0); }
+        m_cv0.notify_all();
+    }
+
+    if (m_audioParameterUpdates.update()) {
+        m_audioParameters = m_audioParameterUpdates.read();
+        m_smoothedVolume.setTarget(m_audioParameters.volume);
+        m_smoothedConvolution.setTarget(m_audioParameters.convolution);
+        m_smoothedDerivativeMix.setTarget(m_audioParameters.dF_F_mix);
+        m_smoothedAirNoise.setTarget(m_audioParameters.airNoise);
+        m_smoothedAirNoiseCutoff.setTarget(m_audioParameters.airNoiseFrequencyCutoff);
+        m_smoothedInputSampleNoise.setTarget(m_audioParameters.inputSampleNoise);
+    }
+
+    if (m_impulseResponsesPending.load(std::memory_order_acquire)) {
+        installPendingImpulseResponses();
+    }
+
+    const float convolutionFraction = m_convolutionFraction.load(std::memory_order_relaxed);
+    if (convolutionFraction != m_appliedConvolutionFraction) {
+        m_appliedConvolutionFraction = convolutionFraction;
+        for (int i = 0; i < m_inputChannelCount; ++i) {
+            m_filters[i].convolution.setActiveFraction(convolutionFraction);
+        }
+    }
+
+    // Settled cutoffs keep their coefficients; a moving one is redesigned
+    // once per block on its way, within a tenth of a percent of the target
+    const float glide = SmoothedParameter::GlideFraction(n, m_audioSampleRate, m_parameterSmoothing);
+    const float cutoff = m_smoothedAirNoiseCutoff.getTarget();
+    if (m_smoothedAirNoiseCutoff.glide(glide, 1E-3f * std::abs(cutoff))) {
+        m_airNoiseLowPass.setCutoffFrequency(m_smoothedAirNoiseCutoff.getValue(), m_audioSampleRate);
+    }
+
+    if (m_smoothedInputSampleNoise.glide(glide, 1E-4f)) {
+        for (int i = 0; i < m_inputChannelCount; ++i) {
+            m_filters[i].jitterFilter.setJitterScale(m_smoothedInputSampleNoise.getValue());
+        }
+    }
 
     for (int i = 0; i < m_inputChannelCount; ++i) {
-        m_filters[i].airNoiseLowPass.setCutoffFrequency(
-            static_cast<float>(m_audioParameters.airNoiseFrequencyCutoff), m_audioSampleRate);
-        m_filters[i].jitterFilter.setJitterScale(m_audioParameters.inputSampleNoise);
+        m_filters[i].airNoise.fill(m_inputChannels[i].noiseBuffer, n, -1.0f, 1.0f);
+    }
+
+    renderAudioBlock(n, m_outputBuffer);
+    if (m_analysisEnabled.load(std::memory_order_relaxed)) {
+        m_analyzer.process(m_outputBuffer, n);
+    }
+
+    const size_t audioCapacity = (size_t)m_audioBufferSize;
+    const size_t audioWriteIndex = m_audioWriteIndex.load(std::memory_order_relaxed);
+    const size_t audioStart = audioWriteIndex % audioCapacity;
+    const size_t audioFirst = std::min((size_t)n, audioCapacity - audioStart);
+    memcpy(m_audioBuffer + audioStart, m_outputBuffer, sizeof(float) * audioFirst);
+    memcpy(m_audioBuffer, m_outputBuffer + audioFirst, sizeof(float) * (n - audioFirst));
+    m_audioWriteIndex.store(audioWriteIndex + n, std::memory_order_release);
+
+    // Input and output samples are one to one here
+    LatencyProbe *probe = m_latencyProbe.load(std::memory_order_acquire);
+    if (probe != nullptr && probe->isWaiting(LatencyProbe::Stage::Rendered)) {
+        const size_t sample = probe->getPosition(LatencyProbe::Stage::Published);
+        if (sample < readIndex + n) {
+            probe->mark(
+                LatencyProbe::Stage::Rendered,
+                audioWriteIndex + ((sample > readIndex) ? sample - readIndex : 0));
+        }
+    }
+
+    if (m_multichannelBuffer != nullptr) {
+        const int channels = m_outputChannelCount;
+        const size_t writeIndex = m_multichannelWriteIndex.load(std::memory_order_relaxed);
+        const size_t space =
+            audioCapacity - (writeIndex - m_multichannelReadIndex.load(std::memory_order_acquire));
+        const size_t frames = std::min((size_t)n, space);
+        const size_t start = writeIndex % audioCapacity;
+        const size_t first = std::min(frames, audioCapacity - start);
+        memcpy(
+            m_multichannelBuffer + start * channels,
+            m_mixBuffer,
+            sizeof(float) * first * channels);
+        memcpy(
+            m_multichannelBuffer,
+            m_mixBuffer + first * channels,
+            sizeof(float) * (frames - first) * channels);
+        m_multichannelWriteIndex.store(writeIndex + frames, std::memory_order_release);
+
+        if (frames < (size_t)n) {
+            m_multichannelDroppedCount.fetch_add(n - frames, std::memory_order_relaxed);
+        }
     }
 
-    for (int i = 0; i < n; ++i) {
-        m_audioBuffer.write(renderAudio(i));
+    m_levelerGain.store(m_levelingFilter.getAttenuation(), std::memory_order_relaxed);
+
+    if (n > 0) {
+        const auto renderEnd = std::chrono::steady_clock::now();
+        m_renderedBlocks.fetch_add(1, std::memory_order_relaxed);
+        m_renderedSamples.fetch_add(n, std::memory_order_relaxed);
+        m_renderNanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(renderEnd - wakeTs).count(),
+            std::memory_order_relaxed);
     }
 
-    m_cv0.notify_one();
+    return n;
+}
+
+Synthesizer::RenderStatistics Synthesizer::getRenderStatistics() const {
+    RenderStatistics statistics;
+    statistics.blocks = m_renderedBlocks.load(std::memory_order_relaxed);
+    statistics.samples = m_renderedSamples.load(std::memory_order_relaxed);
+    statistics.microseconds = m_renderNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+    statistics.underruns = m_underrunCount.load(std::memory_order_relaxed);
+    statistics.overruns = m_overrunCount.load(std::memory_order_relaxed);
+    statistics.lockContentions = m_lock0ContentionCount.load(std::memory_order_relaxed);
+    statistics.inputDroppedSamples = m_inputDroppedCount.load(std::memory_order_relaxed);
+
+    return statistics;
+}
+
+void Synthesizer::setOfflineMode(bool offline) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock0);
+        m_offline = offline;
+    }
+
+    ATG_ENGINE_SIM_TRACE(Audio, Event, "offline_mode=%d", offline ? 1 : 0);
+    m_cv0.notify_all();
+}
+
+int Synthesizer::audioBufferLimit() const {
+    // Offline rendering fills the whole output ring and relies on the consumer
+    // draining it; live playback keeps the buffer short to bound latency.
+    return m_offline
+        ? m_audioBufferSize - 1
+        : std::min(m_renderLimit, m_audioBufferSize - 1);
 }
 
 double Synthesizer::getLatency() const {
@@ -420,7 +1245,16 @@ double Synthesizer::getLatency() const {
         return 0.0;
     }
 
-    return (double)m_latency / m_audioSampleRate;
+    return (double)(m_latency + m_levelingFilter.getLookahead()) / m_audioSampleRate;
+}
+
+void Synthesizer::resetSmoothedParameters() {
+    m_smoothedVolume.reset(m_audioParameters.volume);
+    m_smoothedConvolution.reset(m_audioParameters.convolution);
+    m_smoothedDerivativeMix.reset(m_audioParameters.dF_F_mix);
+    m_smoothedAirNoise.reset(m_audioParameters.airNoise);
+    m_smoothedAirNoiseCutoff.reset(m_audioParameters.airNoiseFrequencyCutoff);
+    m_smoothedInputSampleNoise.reset(m_audioParameters.inputSampleNoise);
 }
 
 int Synthesizer::inputDelta(int s1, int s0) const {
@@ -445,9 +1279,10 @@ void Synthesizer::setInputSampleRate(double sampleRate) {
         std::lock_guard<std::mutex> lock(m_lock0);
         const auto lockEnd = std::chrono::steady_clock::now();
         const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-        if (lockWaitUs > 0) g_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
+        if (lockWaitUs > 0) m_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
         logLockWait("m_lock0(setInputSampleRate)", static_cast<long long>(lockWaitUs));
         m_inputSampleRate = sampleRate;
+        m_resampler.setRates(m_inputSampleRate, m_audioSampleRate, m_inputCutoffFrequency);
     }
 }
 
@@ -460,31 +1295,37 @@ int16_t Synthesizer::renderAudio(int inputSample) {
     const float dF_F_mix = m_audioParameters.dF_F_mix;
     const float convAmount = m_audioParameters.convolution;
 
-    float signal = 0;
     for (int i = 0; i < m_inputChannelCount; ++i) {
-        const float r_0 = 2.0 * ((double)rand() / RAND_MAX) - 1.0;
+        m_convolutionInputs[i] = 0;
+    }
 
+    for (int i = 0; i < m_inputChannelCount; ++i) {
         const float jitteredSample =
             m_filters[i].jitterFilter.fast_f(m_inputChannels[i].transferBuffer[inputSample]);
 
         const float f_in = jitteredSample;
-        const float f_dc = m_filters[i].inputDcFilter.fast_f(f_in);
+        const float f_dc = m_inputDcFilter.process(i, f_in);
         const float f = f_in - f_dc;
         const float f_p = m_filters[i].derivative.f(f_in);
 
-        const float noise = 2.0 * ((double)rand() / RAND_MAX) - 1.0;
-        const float r =
-            m_filters[i].airNoiseLowPass.fast_f(noise);
+        const float noise = m_inputChannels[i].noiseBuffer[inputSample];
+        const float r = m_airNoiseLowPass.process(i, noise);
         const float r_mixed =
             airNoise * r + (1 - airNoise);
 
-        float v_in =
+        const float v_in =
             f_p * dF_F_mix
             + f * r_mixed * (1 - dF_F_mix);
-        if (std::fpclassify(v_in) == FP_SUBNORMAL) {
-            v_in = 0;
-        }
 
+        m_convolutionInputs[m_convolutionGroups[i]] += v_in;
+    }
+
+    // Everything up to here is linear, so shared responses convolve the sum
+    float signal = 0;
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        if (m_convolutionGroups[i] != i) continue;
+
+        const float v_in = m_convolutionInputs[i];
         const float v =
             convAmount * m_filters[i].convolution.f(v_in)
             + (1 - convAmount) * v_in;
@@ -495,44 +1336,165 @@ int16_t Synthesizer::renderAudio(int inputSample) {
     signal = m_antialiasing.fast_f(signal);
 
     m_levelingFilter.p_target = m_audioParameters.levelerTarget;
-    const float v_leveled = m_levelingFilter.f(signal) * m_audioParameters.volume;
-    int r_int = std::lround(v_leveled);
-    if (r_int > INT16_MAX) {
-        r_int = INT16_MAX;
+    const float v_leveled =
+        (m_leveling ? m_levelingFilter.f(signal) : signal) * m_audioParameters.volume;
+    const float v_out = v_leveled * (1 / Int16Scale);
+
+    int16_t r;
+    quantizeToInt16(&v_out, &r, 1, Int16Scale);
+
+    return r;
+}
+
+void Synthesizer::renderAudioBlock(int n, int16_t *output) {
+    if (n <= 0) return;
+
+    renderAudioBlock(n, m_outputBuffer);
+    quantizeToInt16(m_outputBuffer, output, n, Int16Scale);
+}
+
+void Synthesizer::renderAudioBlock(int n, float *output) {
+    if (n <= 0) return;
+
+    ATG_ENGINE_SIM_PROFILE_COUNTED_SCOPE(SynthesizerRender);
+
+    if (m_inputChannelCount <= 0 || m_inputChannels == nullptr || m_filters == nullptr) {
+        memset(output, 0, sizeof(float) * (size_t)n);
+        return;
+    }
+
+    // Every channel ramps the same way across the block
+    float airNoiseStep, dF_F_mixStep, convAmountStep, volumeStep;
+    const float airNoise0 = m_smoothedAirNoise.ramp(n, &airNoiseStep);
+    const float dF_F_mix0 = m_smoothedDerivativeMix.ramp(n, &dF_F_mixStep);
+    const float convAmount0 = m_smoothedConvolution.ramp(n, &convAmountStep);
+    const float volume0 = m_smoothedVolume.ramp(n, &volumeStep);
+
+    float *f = m_dcBuffer;
+    float *signal = m_signalBuffer;
+
+    for (int j = 0; j < n; ++j) {
+        signal[j] = 0;
+    }
+
+    const int outputs = m_outputChannelCount;
+    float *mix = m_mixBuffer;
+    if (mix != nullptr) {
+        memset(mix, 0, sizeof(float) * (size_t)n * outputs);
+    }
+
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        m_filters[i].jitterFilter.fast_f(m_inputChannels[i].transferBuffer, m_stageChannels[i], n);
     }
-    else if (r_int < INT16_MIN) {
-        r_int = INT16_MIN;
+
+    // The transfer buffers are free once jittered and take the DC estimate;
+    // the air noise is filtered in place
+    m_inputDcFilter.process(m_stageChannels, m_transferChannels, n);
+    m_airNoiseLowPass.process(m_noiseChannels, m_noiseChannels, n);
+
+    // Each channel's convolution input is left in its stage buffer
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        ProcessingFilters &filters = m_filters[i];
+        float *f_in = m_stageChannels[i];
+        const float *dc = m_transferChannels[i];
+        const float *noise = m_noiseChannels[i];
+
+        for (int j = 0; j < n; ++j) {
+            f[j] = f_in[j] - dc[j];
+        }
+
+        // f_in is not needed past this point, so the derivative is produced
+        // in place
+        float *f_p = f_in;
+        filters.derivative.fast_f(f_in, f_p, n);
+
+        float *v_in = f_p;
+        for (int j = 0; j < n; ++j) {
+            const float airNoise = airNoise0 + airNoiseStep * (j + 1);
+            const float dF_F_mix = dF_F_mix0 + dF_F_mixStep * (j + 1);
+            const float r_mixed =
+                airNoise * noise[j] + (1 - airNoise);
+
+            v_in[j] =
+                f_p[j] * dF_F_mix
+                + f[j] * r_mixed * (1 - dF_F_mix);
+        }
     }
 
-    return static_cast<int16_t>(r_int);
+    // Everything up to here is linear, so shared responses convolve the sum
+    // of the channels that share them
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        if (m_convolutionGroups[i] != i) continue;
+
+        ProcessingFilters &filters = m_filters[i];
+        float *v_in = m_stageChannels[i];
+        for (int k = 0; k < m_inputChannelCount; ++k) {
+            if (k == i || m_convolutionGroups[k] != i) continue;
+
+            const float *shared = m_stageChannels[k];
+            for (int j = 0; j < n; ++j) {
+                v_in[j] += shared[j];
+            }
+        }
+
+        float *convolved = f;
+        filters.convolution.f_block(v_in, convolved, n);
+        for (int j = 0; j < n; ++j) {
+            const float convAmount = convAmount0 + convAmountStep * (j + 1);
+            const float v =
+                convAmount * convolved[j]
+                + (1 - convAmount) * v_in[j];
+
+            convolved[j] = v;
+            signal[j] += v;
+        }
+
+        if (mix == nullptr) continue;
+
+        const float *gains = m_outputMix + (size_t)i * outputs;
+        for (int o = 0; o < outputs; ++o) {
+            const float gain = gains[o];
+            if (gain == 0.0f) continue;
+
+            for (int j = 0; j < n; ++j) {
+                mix[(size_t)j * outputs + o] += gain * convolved[j];
+            }
+        }
+    }
+
+    m_antialiasing.fast_f(signal, signal, n);
+
+    if (m_leveling) {
+        m_levelingFilter.p_target = m_audioParameters.levelerTarget;
+        m_levelingFilter.block_f(signal, signal, n);
+    }
+
+    for (int j = 0; j < n; ++j) {
+        const float volume = volume0 + volumeStep * (j + 1);
+        output[j] = (signal[j] * volume) * (1 / Int16Scale);
+    }
 }
 
 double Synthesizer::getLevelerGain() {
-    const auto lockStart = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(m_lock0);
-    const auto lockEnd = std::chrono::steady_clock::now();
-    const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-    if (lockWaitUs > 0) g_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
-    logLockWait("m_lock0(getLevelerGain)", static_cast<long long>(lockWaitUs));
-    return m_levelingFilter.getAttenuation();
+    return m_levelerGain.load(std::memory_order_relaxed);
 }
 
 Synthesizer::AudioParameters Synthesizer::getAudioParameters() {
-    const auto lockStart = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(m_lock0);
-    const auto lockEnd = std::chrono::steady_clock::now();
-    const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-    if (lockWaitUs > 0) g_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
-    logLockWait("m_lock0(getAudioParameters)", static_cast<long long>(lockWaitUs));
-    return m_audioParameters;
+    return m_controlAudioParameters;
 }
 
 void Synthesizer::setAudioParameters(const AudioParameters &params) {
-    const auto lockStart = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(m_lock0);
-    const auto lockEnd = std::chrono::steady_clock::now();
-    const auto lockWaitUs = std::chrono::duration_cast<std::chrono::microseconds>(lockEnd - lockStart).count();
-    if (lockWaitUs > 0) g_lock0ContentionCount.fetch_add(1, std::memory_order_relaxed);
-    logLockWait("m_lock0(setAudioParameters)", static_cast<long long>(lockWaitUs));
-    m_audioParameters = params;
+    m_controlAudioParameters = params;
+    m_audioParameterUpdates.write(params);
+}
+
+void Synthesizer::setRandomSeed(uint64_t seed) {
+    m_randomSeed = seed;
+
+    for (int i = 0; i < m_inputChannelCount && m_filters != nullptr; ++i) {
+        m_filters[i].jitterFilter.seed(seed, 2 * i);
+        m_filters[i].airNoise.seed(seed, 2 * i + 1);
+    }
+
+    m_ditherNoise.seed(seed, 2 * m_inputChannelCount);
 }
@@ -0,0 +1,173 @@
+#include "../include/synthesizer_capture.h"
+
+#include "../include/mapped_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+static_assert(
+    std::is_trivially_copyable<Synthesizer::AudioParameters>::value,
+    "audio parameters are stored as raw bytes");
+
+bool readBytes(const char *data, size_t size, size_t *offset, void *target, size_t count) {
+    if (size - *offset < count) return false;
+
+    std::memcpy(target, data + *offset, count);
+    *offset += count;
+    return true;
+}
+} /* namespace */
+
+SynthesizerCapture::SynthesizerCapture() {
+    m_inputSampleRate = 0.0;
+
+    m_file = nullptr;
+    m_capacity = 0;
+    m_written = 0;
+    m_dropped = 0;
+    m_failed = false;
+}
+
+SynthesizerCapture::~SynthesizerCapture() {
+    close();
+}
+
+bool SynthesizerCapture::record(
+    const std::string &path,
+    double inputSampleRate,
+    const Synthesizer::AudioParameters &audioParameters,
+    const std::vector<Channel> &channels,
+    int capacity)
+{
+    close();
+    if (channels.empty()) return false;
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) return false;
+
+    m_inputSampleRate = inputSampleRate;
+    m_audioParameters = audioParameters;
+    m_channels = channels;
+    m_frames.clear();
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.channels = static_cast<int32_t>(channels.size());
+    header.reserved = 0;
+    header.inputSampleRate = inputSampleRate;
+
+    bool written =
+        std::fwrite(&header, sizeof(Header), 1, m_file) == 1
+        && std::fwrite(&m_audioParameters, sizeof(m_audioParameters), 1, m_file) == 1;
+
+    for (const Channel &channel : m_channels) {
+        const uint32_t length = static_cast<uint32_t>(channel.impulseResponse.size());
+        written = written
+            && std::fwrite(&length, sizeof(length), 1, m_file) == 1
+            && std::fwrite(channel.impulseResponse.data(), 1, length, m_file) == length
+            && std::fwrite(&channel.impulseResponseVolume, sizeof(double), 1, m_file) == 1
+            && std::fwrite(&channel.audioVolume, sizeof(double), 1, m_file) == 1;
+    }
+
+    m_capacity = (size_t)std::max(capacity, 1) * m_channels.size();
+    m_buffer.clear();
+    m_buffer.reserve(m_capacity);
+    m_written = 0;
+    m_dropped = 0;
+    m_failed = !written;
+
+    return written;
+}
+
+void SynthesizerCapture::write(const double *frames, int count) {
+    if (m_file == nullptr || count <= 0) return;
+
+    const size_t channels = m_channels.size();
+    const size_t room = (m_capacity - m_buffer.size()) / channels;
+    const size_t accepted = std::min((size_t)count, room);
+
+    for (size_t i = 0; i < accepted * channels; ++i) {
+        m_buffer.push_back(static_cast<float>(frames[i]));
+    }
+
+    m_written += accepted;
+    m_dropped += count - accepted;
+}
+
+bool SynthesizerCapture::flush() {
+    if (m_file == nullptr) return false;
+    if (m_buffer.empty()) return !m_failed;
+
+    if (std::fwrite(m_buffer.data(), sizeof(float), m_buffer.size(), m_file) != m_buffer.size()) {
+        m_failed = true;
+    }
+
+    m_buffer.clear();
+    return !m_failed;
+}
+
+bool SynthesizerCapture::close() {
+    if (m_file == nullptr) return false;
+
+    flush();
+    const bool ok = std::fclose(m_file) == 0 && !m_failed;
+    m_file = nullptr;
+
+    return ok;
+}
+
+bool SynthesizerCapture::load(const std::string &path) {
+    close();
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    const char *data = file.getData();
+    const size_t size = file.getSize();
+    size_t offset = 0;
+
+    Header header;
+    if (!readBytes(data, size, &offset, &header, sizeof(Header))) return false;
+    else if (header.magic != Magic || header.version != Version) return false;
+    else if (header.channels < 1) return false;
+
+    Synthesizer::AudioParameters audioParameters;
+    if (!readBytes(data, size, &offset, &audioParameters, sizeof(audioParameters))) return false;
+
+    // A length and two volumes per channel at the least
+    if ((size_t)header.channels > size / (sizeof(uint32_t) + 2 * sizeof(double))) return false;
+
+    std::vector<Channel> channels(header.channels);
+    for (Channel &channel : channels) {
+        uint32_t length = 0;
+        if (!readBytes(data, size, &offset, &length, sizeof(length))) return false;
+        else if (size - offset < length) return false;
+
+        channel.impulseResponse.assign(data + offset, length);
+        offset += length;
+
+        if (!readBytes(data, size, &offset, &channel.impulseResponseVolume, sizeof(double))) return false;
+        if (!readBytes(data, size, &offset, &channel.audioVolume, sizeof(double))) return false;
+    }
+
+    // A trailing partial frame is what a capture cut short mid-write leaves
+    const size_t frameBytes = sizeof(float) * header.channels;
+    const size_t frames = (size - offset) / frameBytes;
+
+    std::vector<float> samples(frames * header.channels);
+    if (!samples.empty()) std::memcpy(samples.data(), data + offset, frames * frameBytes);
+
+    m_inputSampleRate = header.inputSampleRate;
+    m_audioParameters = audioParameters;
+    m_channels = std::move(channels);
+    m_frames = std::move(samples);
+
+    return true;
+}
+
+size_t SynthesizerCapture::getFrameCount() const {
+    return m_channels.empty() ? 0 : m_frames.size() / m_channels.size();
+}
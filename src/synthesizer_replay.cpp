@@ -0,0 +1,137 @@
+#include "../include/synthesizer_replay.h"
+
+#include "../include/impulse_response_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+SynthesizerReplay::SynthesizerReplay() {
+    m_capture = nullptr;
+    m_inputSampleRate = 0.0;
+    m_blockFrames = 0;
+    m_position = 0;
+    m_length = 0;
+    m_rendered = 0;
+}
+
+SynthesizerReplay::~SynthesizerReplay() {
+    /* void */
+}
+
+bool SynthesizerReplay::initialize(const SynthesizerCapture *capture, const Parameters &params) {
+    const int channels = capture->getChannelCount();
+    if (channels <= 0) return false;
+    else if (!params.channels.empty() && (int)params.channels.size() != channels) return false;
+
+    m_capture = capture;
+
+    if (params.inputSampleRate > 0) m_inputSampleRate = params.inputSampleRate;
+    else if (capture->getInputSampleRate() > 0) m_inputSampleRate = capture->getInputSampleRate();
+    else m_inputSampleRate = params.audioSampleRate;
+
+    Synthesizer::Parameters synthParams;
+    synthParams.inputChannelCount = channels;
+    synthParams.inputBufferSize = 4096;
+    synthParams.audioBufferSize = 44100;
+    synthParams.inputSampleRate = static_cast<float>(m_inputSampleRate);
+    synthParams.audioSampleRate = static_cast<float>(params.audioSampleRate);
+    synthParams.initialAudioParameters = params.overrideAudioParameters
+        ? params.audioParameters
+        : capture->getAudioParameters();
+    m_synthesizer.initialize(synthParams);
+    m_synthesizer.setOfflineMode(true);
+
+    m_gains.assign(channels, 1.0);
+    for (int i = 0; i < channels; ++i) {
+        const SynthesizerCapture::Channel &captured = capture->getChannel(i);
+        const SynthesizerCapture::Channel &channel =
+            params.channels.empty() ? captured : params.channels[i];
+
+        // A channel captured silent has nothing to scale back up
+        m_gains[i] = (captured.audioVolume != 0)
+            ? channel.audioVolume / captured.audioVolume
+            : 0.0;
+
+        const std::shared_ptr<const ImpulseResponseCache::Kernel> kernel = channel.impulseResponse.empty()
+            ? nullptr
+            : ImpulseResponseCache::Get(
+                channel.impulseResponse, channel.impulseResponseVolume, params.audioSampleRate);
+
+        if (kernel != nullptr) m_synthesizer.initializeImpulseResponse(kernel->filter, i);
+        else m_synthesizer.initializeImpulseResponse(nullptr, 0, 0.0f, i);
+    }
+
+    // A block renders to at most half of the synthesizer's input ring
+    m_blockFrames = std::max(
+        1,
+        static_cast<int>(synthParams.inputBufferSize / 2 * m_inputSampleRate / params.audioSampleRate));
+    m_input.assign((size_t)m_blockFrames * channels, 0.0);
+
+    m_position = 0;
+    m_rendered = 0;
+    m_length = static_cast<size_t>(std::llround(
+        capture->getFrameCount() * params.audioSampleRate / m_inputSampleRate));
+
+    return true;
+}
+
+void SynthesizerReplay::destroy() {
+    m_synthesizer.destroy();
+    m_gains.clear();
+    m_input.clear();
+    m_capture = nullptr;
+}
+
+int SynthesizerReplay::render(int samples, int16_t *output) {
+    int rendered = 0;
+    int idle = 0;
+    while (rendered < samples && m_capture != nullptr && m_rendered < m_length) {
+        const int available = std::min(
+            m_synthesizer.audioSamplesAvailable(),
+            static_cast<int>(std::min<size_t>(m_length - m_rendered, INT32_MAX)));
+        if (available > 0) {
+            const int read = m_synthesizer.readAudioOutput(
+                std::min(available, samples - rendered), output + rendered);
+            rendered += read;
+            m_rendered += read;
+            idle = 0;
+            continue;
+        }
+
+        // The synthesizer's resampler holds back the first few frames
+        if (++idle > 64) break;
+
+        const int frames = std::min(
+            m_blockFrames,
+            static_cast<int>(std::ceil(
+                (samples - rendered) * m_inputSampleRate / m_synthesizer.getAudioSampleRate())) + 1);
+        feed(frames);
+    }
+
+    std::fill(output + rendered, output + samples, 0);
+    return rendered;
+}
+
+bool SynthesizerReplay::isFinished() const {
+    return m_capture == nullptr || m_rendered >= m_length;
+}
+
+void SynthesizerReplay::feed(int frames) {
+    const int channels = m_capture->getChannelCount();
+    const size_t remaining = m_capture->getFrameCount() - std::min(m_position, m_capture->getFrameCount());
+    const int captured = static_cast<int>(std::min<size_t>(remaining, frames));
+
+    const float *source = m_capture->getFrames() + m_position * channels;
+    for (int f = 0; f < captured; ++f) {
+        for (int c = 0; c < channels; ++c) {
+            m_input[(size_t)f * channels + c] = source[(size_t)f * channels + c] * m_gains[c];
+        }
+    }
+
+    std::fill(m_input.begin() + (size_t)captured * channels, m_input.begin() + (size_t)frames * channels, 0.0);
+    m_position += frames;
+
+    m_synthesizer.writeInput(m_input.data(), frames);
+    m_synthesizer.endInputBlock();
+    m_synthesizer.renderPendingAudio();
+}
@@ -0,0 +1,374 @@
+#include "../include/telemetry_export.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+bool isSharedMemoryName(const std::string &name) {
+    return name.size() > 1 && name[0] == '/' && name.find('/', 1) == std::string::npos;
+}
+
+uint32_t roundUpToPowerOfTwo(int n) {
+    uint32_t capacity = 1;
+    while (capacity < static_cast<uint32_t>(std::max(n, 1))) capacity <<= 1;
+    return capacity;
+}
+
+#if defined(_WIN32)
+std::string mappingName(const std::string &name) {
+    return "Local\\" + name.substr(1);
+}
+
+void *mapForWriting(const std::string &name, size_t size, void **handle) {
+    HANDLE file = INVALID_HANDLE_VALUE;
+    if (!isSharedMemoryName(name)) {
+        file = CreateFileA(
+            name.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        if (file == INVALID_HANDLE_VALUE) return nullptr;
+    }
+
+    const unsigned long long size64 = size;
+    HANDLE mapping = CreateFileMappingA(
+        file,
+        nullptr,
+        PAGE_READWRITE,
+        static_cast<DWORD>(size64 >> 32),
+        static_cast<DWORD>(size64 & 0xFFFFFFFF),
+        isSharedMemoryName(name) ? mappingName(name).c_str() : nullptr);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    if (mapping == nullptr) return nullptr;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    *handle = mapping;
+    return view;
+}
+
+void *mapForReading(const std::string &name, size_t *size, void **handle) {
+    HANDLE mapping = nullptr;
+    if (isSharedMemoryName(name)) {
+        mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, mappingName(name).c_str());
+    }
+    else {
+        HANDLE file = CreateFileA(
+            name.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+    }
+
+    if (mapping == nullptr) return nullptr;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(view, &info, sizeof(info));
+    *size = info.RegionSize;
+    *handle = mapping;
+    return view;
+}
+
+void unmap(const void *view, size_t, void *handle) {
+    UnmapViewOfFile(view);
+    CloseHandle(static_cast<HANDLE>(handle));
+}
+#else
+int openForWriting(const std::string &name) {
+    if (isSharedMemoryName(name)) {
+        // Readers still mapping a previous export keep their copy
+        shm_unlink(name.c_str());
+        return shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    }
+
+    return ::open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+}
+
+void *mapForWriting(const std::string &name, size_t size, void **) {
+    const int fd = openForWriting(name);
+    if (fd < 0) return nullptr;
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    return (view == MAP_FAILED) ? nullptr : view;
+}
+
+void *mapForReading(const std::string &name, size_t *size, void **) {
+    const int fd = isSharedMemoryName(name)
+        ? shm_open(name.c_str(), O_RDONLY, 0)
+        : ::open(name.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TelemetryExport::Header))) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    void *view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return nullptr;
+
+    *size = static_cast<size_t>(info.st_size);
+    return view;
+}
+
+void unmap(const void *view, size_t size, void *) {
+    munmap(const_cast<void *>(view), size);
+}
+#endif /* _WIN32 */
+} /* namespace */
+
+TelemetryExport::TelemetryExport() {
+    m_header = nullptr;
+    m_records = nullptr;
+    m_mask = 0;
+    m_decimation = 1;
+    m_counter = 0;
+    m_mapping = nullptr;
+    m_size = 0;
+    m_ownsName = false;
+}
+
+TelemetryExport::~TelemetryExport() {
+    close();
+}
+
+bool TelemetryExport::open(const std::string &name, int capacity, int decimation) {
+    close();
+
+    const uint32_t records = roundUpToPowerOfTwo(capacity);
+    const size_t size = sizeof(Header) + sizeof(Record) * records;
+
+    void *view = mapForWriting(name, size, &m_mapping);
+    if (view == nullptr) return false;
+
+    std::memset(view, 0, size);
+
+    m_header = static_cast<Header *>(view);
+    m_records = reinterpret_cast<Record *>(static_cast<char *>(view) + sizeof(Header));
+    m_mask = records - 1;
+    m_decimation = std::max(decimation, 1);
+    m_counter = 0;
+    m_name = name;
+    m_size = size;
+    m_ownsName = isSharedMemoryName(name);
+
+    m_header->version = Version;
+    m_header->headerSize = sizeof(Header);
+    m_header->recordSize = sizeof(Record);
+    m_header->capacity = records;
+    m_header->cylinderCount = 0;
+    m_header->recordInterval = 0.0;
+    m_header->writeIndex.store(0, std::memory_order_relaxed);
+
+    // Last, so a reader that sees the magic sees the rest of the header
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = Magic;
+
+    return true;
+}
+
+void TelemetryExport::close() {
+    if (m_header == nullptr) return;
+
+    unmap(m_header, m_size, m_mapping);
+
+#if !defined(_WIN32)
+    if (m_ownsName) shm_unlink(m_name.c_str());
+#endif /* !_WIN32 */
+
+    m_header = nullptr;
+    m_records = nullptr;
+    m_mask = 0;
+    m_mapping = nullptr;
+    m_size = 0;
+    m_name.clear();
+    m_ownsName = false;
+}
+
+void TelemetryExport::setLayout(int cylinderCount, double recordInterval) {
+    m_header->cylinderCount = static_cast<uint32_t>(std::clamp(cylinderCount, 0, MaxCylinders));
+    m_header->recordInterval = recordInterval;
+}
+
+void TelemetryExport::write(const Sample &sample) {
+    const uint64_t index = m_header->writeIndex.load(std::memory_order_relaxed);
+    Record &record = m_records[index & m_mask];
+
+    record.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    record.time = sample.time;
+    record.rpm = sample.rpm;
+    record.throttle = sample.throttle;
+    record.dynoTorque = sample.dynoTorque;
+    record.manifoldPressure = sample.manifoldPressure;
+    record.intakeAfr = sample.intakeAfr;
+    record.vehicleSpeed = sample.vehicleSpeed;
+    record.gear = sample.gear;
+    record.flags = sample.flags;
+    std::memcpy(record.cylinderPressure, sample.cylinderPressure, sizeof(record.cylinderPressure));
+    std::memcpy(record.events, sample.events, sizeof(record.events));
+
+    record.sequence.store(index + 1, std::memory_order_release);
+    m_header->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+unsigned long long TelemetryExport::getWrittenCount() const {
+    return (m_header != nullptr) ? m_header->writeIndex.load(std::memory_order_relaxed) : 0;
+}
+
+TelemetryExportReader::TelemetryExportReader() {
+    m_header = nullptr;
+    m_records = nullptr;
+    m_mask = 0;
+    m_readIndex = 0;
+    m_dropped = 0;
+    m_mapping = nullptr;
+    m_size = 0;
+}
+
+TelemetryExportReader::~TelemetryExportReader() {
+    close();
+}
+
+bool TelemetryExportReader::open(const std::string &name) {
+    close();
+
+    size_t size = 0;
+    void *view = mapForReading(name, &size, &m_mapping);
+    if (view == nullptr) return false;
+
+    const TelemetryExport::Header *header = static_cast<const TelemetryExport::Header *>(view);
+    const bool valid = size >= sizeof(TelemetryExport::Header)
+        && header->magic == TelemetryExport::Magic
+        && header->version == TelemetryExport::Version
+        && header->headerSize == sizeof(TelemetryExport::Header)
+        && header->recordSize == sizeof(TelemetryExport::Record)
+        && header->capacity > 0
+        && (header->capacity & (header->capacity - 1)) == 0
+        && size >= sizeof(TelemetryExport::Header) + sizeof(TelemetryExport::Record) * header->capacity;
+    if (!valid) {
+        unmap(view, size, m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    m_header = header;
+    m_records = reinterpret_cast<const TelemetryExport::Record *>(
+        static_cast<const char *>(view) + sizeof(TelemetryExport::Header));
+    m_mask = header->capacity - 1;
+    m_size = size;
+
+    // Starts with what is still in the ring
+    const uint64_t written = header->writeIndex.load(std::memory_order_acquire);
+    m_readIndex = (written > header->capacity) ? written - header->capacity : 0;
+    m_dropped = 0;
+
+    return true;
+}
+
+void TelemetryExportReader::close() {
+    if (m_header == nullptr) return;
+
+    unmap(m_header, m_size, m_mapping);
+    m_header = nullptr;
+    m_records = nullptr;
+    m_mapping = nullptr;
+    m_size = 0;
+}
+
+int TelemetryExportReader::getCylinderCount() const {
+    return (m_header != nullptr) ? static_cast<int>(m_header->cylinderCount) : 0;
+}
+
+double TelemetryExportReader::getRecordInterval() const {
+    return (m_header != nullptr) ? m_header->recordInterval : 0.0;
+}
+
+int TelemetryExportReader::read(TelemetryExport::Sample *target, int maxSamples) {
+    if (m_header == nullptr) return 0;
+
+    const uint64_t written = m_header->writeIndex.load(std::memory_order_acquire);
+    const uint64_t capacity = m_mask + 1;
+    if (written - m_readIndex > capacity) {
+        m_dropped += written - capacity - m_readIndex;
+        m_readIndex = written - capacity;
+    }
+
+    int n = 0;
+    while (n < maxSamples && m_readIndex < written) {
+        const TelemetryExport::Record &record = m_records[m_readIndex & m_mask];
+        const uint64_t expected = m_readIndex + 1;
+        ++m_readIndex;
+
+        if (record.sequence.load(std::memory_order_acquire) != expected) {
+            ++m_dropped;
+            continue;
+        }
+
+        TelemetryExport::Sample &sample = target[n];
+        sample.index = expected - 1;
+        sample.time = record.time;
+        sample.rpm = record.rpm;
+        sample.throttle = record.throttle;
+        sample.dynoTorque = record.dynoTorque;
+        sample.manifoldPressure = record.manifoldPressure;
+        sample.intakeAfr = record.intakeAfr;
+        sample.vehicleSpeed = record.vehicleSpeed;
+        sample.gear = record.gear;
+        sample.flags = record.flags;
+        std::memcpy(sample.cylinderPressure, record.cylinderPressure, sizeof(sample.cylinderPressure));
+        std::memcpy(sample.events, record.events, sizeof(sample.events));
+
+        // Overwritten during the copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load(std::memory_order_relaxed) != expected) {
+            ++m_dropped;
+            continue;
+        }
+
+        ++n;
+    }
+
+    return n;
+}
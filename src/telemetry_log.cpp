@@ -0,0 +1,589 @@
+#include "../include/telemetry_log.h"
+
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+void putVarint(uint64_t value, std::vector<uint8_t> *target) {
+    while (value >= 0x80) {
+        target->push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+
+    target->push_back((uint8_t)value);
+}
+
+bool getVarint(const uint8_t *&data, const uint8_t *end, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data >= end) return false;
+
+        const uint8_t byte = *data++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// (delta, run length) pairs
+void encodeDeltaRuns(const std::vector<int64_t> &values, std::vector<uint8_t> *target) {
+    int64_t previous = 0;
+    size_t i = 0;
+    while (i < values.size()) {
+        const int64_t delta = values[i] - previous;
+        size_t run = 1;
+        while (i + run < values.size() && values[i + run] - values[i + run - 1] == delta) {
+            ++run;
+        }
+
+        putVarint(zigzag(delta), target);
+        putVarint(run, target);
+
+        previous = values[i + run - 1];
+        i += run;
+    }
+}
+
+bool decodeDeltaRuns(const uint8_t *data, const uint8_t *end, int count, std::vector<int64_t> *values) {
+    values->clear();
+
+    int64_t value = 0;
+    while ((int)values->size() < count) {
+        uint64_t delta, run;
+        if (!getVarint(data, end, &delta) || !getVarint(data, end, &run)) return false;
+        if (run == 0 || run > (uint64_t)(count - (int)values->size())) return false;
+
+        for (uint64_t j = 0; j < run; ++j) {
+            value += unzigzag(delta);
+            values->push_back(value);
+        }
+    }
+
+    return data == end;
+}
+
+// PackBits: a header n of 0-127 is followed by n + 1 literal bytes, one of
+// 128-255 by a single byte repeated n - 125 times
+void packRuns(const uint8_t *data, size_t n, std::vector<uint8_t> *target) {
+    size_t i = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 130 && data[i + run] == data[i]) ++run;
+
+        if (run >= 3) {
+            target->push_back((uint8_t)(run + 125));
+            target->push_back(data[i]);
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next run of three
+        size_t literal = 0;
+        while (i + literal < n && literal < 128) {
+            const size_t j = i + literal;
+            if (j + 2 < n && data[j] == data[j + 1] && data[j] == data[j + 2]) break;
+            ++literal;
+        }
+
+        target->push_back((uint8_t)(literal - 1));
+        target->insert(target->end(), data + i, data + i + literal);
+        i += literal;
+    }
+}
+
+bool unpackRuns(const uint8_t *&data, const uint8_t *end, size_t n, uint8_t *target) {
+    size_t written = 0;
+    while (written < n) {
+        if (data >= end) return false;
+
+        const uint8_t header = *data++;
+        if (header < 128) {
+            const size_t literal = (size_t)header + 1;
+            if (literal > n - written || literal > (size_t)(end - data)) return false;
+
+            std::memcpy(target + written, data, literal);
+            data += literal;
+            written += literal;
+        }
+        else {
+            const size_t run = (size_t)header - 125;
+            if (run > n - written || data >= end) return false;
+
+            std::memset(target + written, *data++, run);
+            written += run;
+        }
+    }
+
+    return true;
+}
+
+// Residuals against 2 b[i - 1] - b[i - 2] on the bit patterns, which is the
+// linear prediction wherever sign and exponent hold still
+template <typename T_Bits>
+void encodePredicted(const std::vector<T_Bits> &bits, std::vector<uint8_t> *target) {
+    const size_t n = bits.size();
+    std::vector<uint8_t> plane(n);
+
+    for (size_t b = 0; b < sizeof(T_Bits); ++b) {
+        T_Bits b0 = 0, b1 = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const T_Bits predicted = (T_Bits)(2 * b1 - b0);
+            plane[i] = (uint8_t)((bits[i] ^ predicted) >> (8 * b));
+            b0 = b1;
+            b1 = bits[i];
+        }
+
+        packRuns(plane.data(), n, target);
+    }
+}
+
+template <typename T_Bits>
+bool decodePredicted(const uint8_t *data, const uint8_t *end, int count, std::vector<T_Bits> *bits) {
+    const size_t n = (size_t)count;
+    std::vector<T_Bits> residuals(n, 0);
+    std::vector<uint8_t> plane(n);
+
+    for (size_t b = 0; b < sizeof(T_Bits); ++b) {
+        if (!unpackRuns(data, end, n, plane.data())) return false;
+        for (size_t i = 0; i < n; ++i) {
+            residuals[i] |= (T_Bits)plane[i] << (8 * b);
+        }
+    }
+
+    bits->resize(n);
+    T_Bits b0 = 0, b1 = 0;
+    for (size_t i = 0; i < n; ++i) {
+        (*bits)[i] = residuals[i] ^ (T_Bits)(2 * b1 - b0);
+        b0 = b1;
+        b1 = (*bits)[i];
+    }
+
+    return data == end;
+}
+
+// Every column is read and written through one of these, in file order
+struct Column {
+    std::string name;
+    TelemetryLog::Encoding encoding;
+    int64_t (*getInteger)(const TelemetryExport::Sample &, int);
+    void (*setInteger)(TelemetryExport::Sample *, int, int64_t);
+    float *(*floatField)(TelemetryExport::Sample *, int);
+    int slot;
+};
+
+std::vector<Column> columns(int cylinderCount) {
+    std::vector<Column> result;
+
+    const auto integer = [&result](
+        const std::string &name,
+        int64_t (*get)(const TelemetryExport::Sample &, int),
+        void (*set)(TelemetryExport::Sample *, int, int64_t),
+        int slot)
+    {
+        result.push_back({ name, TelemetryLog::Encoding::DeltaRuns, get, set, nullptr, slot });
+    };
+
+    const auto real = [&result](const std::string &name, float *(*field)(TelemetryExport::Sample *, int), int slot) {
+        result.push_back({ name, TelemetryLog::Encoding::PredictedFloat, nullptr, nullptr, field, slot });
+    };
+
+    integer(
+        "index",
+        [](const TelemetryExport::Sample &s, int) { return (int64_t)s.index; },
+        [](TelemetryExport::Sample *s, int, int64_t v) { s->index = (uint64_t)v; },
+        0);
+    result.push_back({ "time", TelemetryLog::Encoding::PredictedDouble, nullptr, nullptr, nullptr, 0 });
+
+    real("rpm", [](TelemetryExport::Sample *s, int) { return &s->rpm; }, 0);
+    real("throttle", [](TelemetryExport::Sample *s, int) { return &s->throttle; }, 0);
+    real("dyno_torque", [](TelemetryExport::Sample *s, int) { return &s->dynoTorque; }, 0);
+    real("manifold_pressure", [](TelemetryExport::Sample *s, int) { return &s->manifoldPressure; }, 0);
+    real("intake_afr", [](TelemetryExport::Sample *s, int) { return &s->intakeAfr; }, 0);
+    real("vehicle_speed", [](TelemetryExport::Sample *s, int) { return &s->vehicleSpeed; }, 0);
+
+    integer(
+        "gear",
+        [](const TelemetryExport::Sample &s, int) { return (int64_t)s.gear; },
+        [](TelemetryExport::Sample *s, int, int64_t v) { s->gear = (int32_t)v; },
+        0);
+    integer(
+        "flags",
+        [](const TelemetryExport::Sample &s, int) { return (int64_t)s.flags; },
+        [](TelemetryExport::Sample *s, int, int64_t v) { s->flags = (uint32_t)v; },
+        0);
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        real(
+            "cylinder_pressure_" + std::to_string(i),
+            [](TelemetryExport::Sample *s, int slot) { return &s->cylinderPressure[slot]; },
+            i);
+    }
+
+    for (int i = 0; i < EventCounters::CounterCount; ++i) {
+        integer(
+            std::string("events_") + EventCounters::GetName(static_cast<EventCounters::Counter>(i)),
+            [](const TelemetryExport::Sample &s, int slot) { return (int64_t)s.events[slot]; },
+            [](TelemetryExport::Sample *s, int slot, int64_t v) { s->events[slot] = (uint32_t)v; },
+            i);
+    }
+
+    return result;
+}
+
+template <typename T>
+void append(std::vector<uint8_t> *target, const T &value) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+    target->insert(target->end(), bytes, bytes + sizeof(T));
+}
+
+} /* namespace */
+
+TelemetryLog::TelemetryLog() {
+    m_file = nullptr;
+    m_thread = nullptr;
+    m_run = false;
+    m_cylinderCount = 0;
+    m_headerWritten = false;
+    m_failed = false;
+}
+
+TelemetryLog::~TelemetryLog() {
+    close();
+}
+
+bool TelemetryLog::open(const std::string &exportName, const std::string &path, const Parameters &params) {
+    close();
+
+    if (!m_reader.open(exportName)) return false;
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) {
+        m_reader.close();
+        return false;
+    }
+
+    m_parameters = params;
+    m_parameters.chunkRows = std::max(1, params.chunkRows);
+    m_pending.clear();
+    m_pending.reserve(m_parameters.chunkRows);
+    m_headerWritten = false;
+    m_failed = false;
+    m_cylinderCount = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_statisticsLock);
+        m_statistics = Statistics();
+    }
+
+    m_run = true;
+    m_thread = new std::thread(&TelemetryLog::worker, this);
+
+    return true;
+}
+
+void TelemetryLog::close() {
+    if (m_thread == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_run = false;
+    }
+
+    m_cv.notify_one();
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+
+    std::fclose(m_file);
+    m_file = nullptr;
+    m_reader.close();
+
+    const Statistics statistics = getStatistics();
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "telemetry_log closed rows=%llu chunks=%llu bytes=%llu dropped=%llu failed=%d",
+        statistics.rows,
+        statistics.chunks,
+        statistics.bytes,
+        statistics.dropped,
+        m_failed ? 1 : 0);
+}
+
+TelemetryLog::Statistics TelemetryLog::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_statisticsLock);
+    return m_statistics;
+}
+
+std::vector<std::string> TelemetryLog::GetColumnNames(int cylinderCount) {
+    std::vector<std::string> names;
+    for (const Column &column : columns(cylinderCount)) {
+        names.push_back(column.name);
+    }
+
+    return names;
+}
+
+void TelemetryLog::EncodeChunk(
+    const TelemetryExport::Sample *samples,
+    int count,
+    int cylinderCount,
+    std::vector<uint8_t> *target)
+{
+    target->clear();
+
+    std::vector<int64_t> integers(count);
+    std::vector<uint32_t> floats(count);
+    std::vector<uint64_t> doubles(count);
+    std::vector<uint8_t> encoded;
+
+    for (const Column &column : columns(cylinderCount)) {
+        encoded.clear();
+
+        if (column.encoding == Encoding::DeltaRuns) {
+            for (int i = 0; i < count; ++i) integers[i] = column.getInteger(samples[i], column.slot);
+            encodeDeltaRuns(integers, &encoded);
+        }
+        else if (column.encoding == Encoding::PredictedFloat) {
+            for (int i = 0; i < count; ++i) {
+                TelemetryExport::Sample *sample = const_cast<TelemetryExport::Sample *>(&samples[i]);
+                std::memcpy(&floats[i], column.floatField(sample, column.slot), sizeof(uint32_t));
+            }
+
+            encodePredicted(floats, &encoded);
+        }
+        else {
+            for (int i = 0; i < count; ++i) std::memcpy(&doubles[i], &samples[i].time, sizeof(uint64_t));
+            encodePredicted(doubles, &encoded);
+        }
+
+        append(target, (uint32_t)encoded.size());
+        target->insert(target->end(), encoded.begin(), encoded.end());
+    }
+}
+
+bool TelemetryLog::DecodeChunk(
+    const uint8_t *data,
+    size_t size,
+    int count,
+    int cylinderCount,
+    std::vector<TelemetryExport::Sample> *target)
+{
+    const size_t first = target->size();
+    TelemetryExport::Sample empty;
+    std::memset(&empty, 0, sizeof(empty));
+    target->resize(first + count, empty);
+    TelemetryExport::Sample *samples = target->data() + first;
+
+    std::vector<int64_t> integers;
+    std::vector<uint32_t> floats;
+    std::vector<uint64_t> doubles;
+
+    const uint8_t *end = data + size;
+    for (const Column &column : columns(cylinderCount)) {
+        uint32_t columnSize;
+        if ((size_t)(end - data) < sizeof(columnSize)) return false;
+
+        std::memcpy(&columnSize, data, sizeof(columnSize));
+        data += sizeof(columnSize);
+        if (columnSize > (size_t)(end - data)) return false;
+
+        const uint8_t *columnEnd = data + columnSize;
+        if (column.encoding == Encoding::DeltaRuns) {
+            if (!decodeDeltaRuns(data, columnEnd, count, &integers)) return false;
+            for (int i = 0; i < count; ++i) column.setInteger(&samples[i], column.slot, integers[i]);
+        }
+        else if (column.encoding == Encoding::PredictedFloat) {
+            if (!decodePredicted(data, columnEnd, count, &floats)) return false;
+            for (int i = 0; i < count; ++i) {
+                std::memcpy(column.floatField(&samples[i], column.slot), &floats[i], sizeof(uint32_t));
+            }
+        }
+        else {
+            if (!decodePredicted(data, columnEnd, count, &doubles)) return false;
+            for (int i = 0; i < count; ++i) std::memcpy(&samples[i].time, &doubles[i], sizeof(uint64_t));
+        }
+
+        data = columnEnd;
+    }
+
+    return data == end;
+}
+
+void TelemetryLog::worker() {
+    const auto interval = std::chrono::duration<double>(m_parameters.pollInterval);
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (m_run) {
+        m_cv.wait_for(lock, interval, [this] { return !m_run; });
+
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+
+    lock.unlock();
+
+    drain();
+    if (!m_pending.empty()) writeChunk((int)m_pending.size());
+}
+
+bool TelemetryLog::drain() {
+    TelemetryExport::Sample samples[256];
+
+    int read;
+    while ((read = m_reader.read(samples, 256)) > 0) {
+        for (int i = 0; i < read; ++i) {
+            m_pending.push_back(samples[i]);
+            if ((int)m_pending.size() >= m_parameters.chunkRows) {
+                writeChunk((int)m_pending.size());
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_statisticsLock);
+    m_statistics.dropped = m_reader.getDroppedCount();
+
+    return !m_failed;
+}
+
+bool TelemetryLog::writeChunk(int count) {
+    if (!m_headerWritten) {
+        m_cylinderCount = std::min(m_reader.getCylinderCount(), TelemetryExport::MaxCylinders);
+        m_failed = !writeHeader();
+        m_headerWritten = true;
+    }
+
+    EncodeChunk(m_pending.data(), count, m_cylinderCount, &m_encoded);
+    m_pending.erase(m_pending.begin(), m_pending.begin() + count);
+
+    ChunkHeader header;
+    header.rowCount = (uint32_t)count;
+    header.size = (uint32_t)m_encoded.size();
+
+    // A failed write stops the log rather than leaving a gap in it
+    if (!m_failed) {
+        m_failed = std::fwrite(&header, sizeof(header), 1, m_file) != 1
+            || std::fwrite(m_encoded.data(), 1, m_encoded.size(), m_file) != m_encoded.size();
+    }
+
+    if (m_failed) return false;
+
+    std::lock_guard<std::mutex> lock(m_statisticsLock);
+    m_statistics.rows += count;
+    ++m_statistics.chunks;
+    m_statistics.bytes += sizeof(header) + m_encoded.size();
+
+    return true;
+}
+
+bool TelemetryLog::writeHeader() {
+    const std::vector<Column> layout = columns(m_cylinderCount);
+
+    std::vector<uint8_t> data;
+    FileHeader header;
+    header.magic = Magic;
+    header.version = Version;
+    header.cylinderCount = (uint32_t)m_cylinderCount;
+    header.columnCount = (uint32_t)layout.size();
+    header.recordInterval = m_reader.getRecordInterval();
+    append(&data, header);
+
+    for (const Column &column : layout) {
+        ColumnHeader columnHeader;
+        columnHeader.encoding = static_cast<uint8_t>(column.encoding);
+        columnHeader.nameLength = (uint8_t)std::min<size_t>(column.name.size(), 255);
+        append(&data, columnHeader);
+        data.insert(data.end(), column.name.begin(), column.name.begin() + columnHeader.nameLength);
+    }
+
+    std::lock_guard<std::mutex> lock(m_statisticsLock);
+    m_statistics.bytes += data.size();
+
+    return std::fwrite(data.data(), 1, data.size(), m_file) == data.size();
+}
+
+TelemetryLogReader::TelemetryLogReader() {
+    m_file = nullptr;
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+TelemetryLogReader::~TelemetryLogReader() {
+    close();
+}
+
+bool TelemetryLogReader::open(const std::string &path) {
+    close();
+
+    m_file = std::fopen(path.c_str(), "rb");
+    if (m_file == nullptr) return false;
+
+    bool valid = std::fread(&m_header, sizeof(m_header), 1, m_file) == 1
+        && m_header.magic == TelemetryLog::Magic
+        && m_header.version == TelemetryLog::Version
+        && m_header.cylinderCount <= (uint32_t)TelemetryExport::MaxCylinders
+        && m_header.columnCount == TelemetryLog::GetColumnNames((int)m_header.cylinderCount).size();
+
+    for (uint32_t i = 0; valid && i < m_header.columnCount; ++i) {
+        TelemetryLog::ColumnHeader column;
+        char name[256];
+        valid = std::fread(&column, sizeof(column), 1, m_file) == 1
+            && std::fread(name, 1, column.nameLength, m_file) == column.nameLength;
+        if (valid) m_columns.push_back(std::string(name, column.nameLength));
+    }
+
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void TelemetryLogReader::close() {
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    m_columns.clear();
+}
+
+bool TelemetryLogReader::readChunk(std::vector<TelemetryExport::Sample> *target) {
+    if (m_file == nullptr) return false;
+
+    TelemetryLog::ChunkHeader header;
+    if (std::fread(&header, sizeof(header), 1, m_file) != 1) return false;
+
+    m_buffer.resize(header.size);
+    if (std::fread(m_buffer.data(), 1, header.size, m_file) != header.size) return false;
+
+    const size_t first = target->size();
+    if (!TelemetryLog::DecodeChunk(
+        m_buffer.data(),
+        m_buffer.size(),
+        (int)header.rowCount,
+        (int)m_header.cylinderCount,
+        target))
+    {
+        target->resize(first);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,72 @@
+#include "../include/telemetry_tap.h"
+
+TelemetryTap::TelemetryTap() {
+    m_records = nullptr;
+    m_mask = 0;
+    m_writeIndex = 0;
+    m_readIndex = 0;
+    m_dropped = 0;
+}
+
+TelemetryTap::~TelemetryTap() {
+    delete[] m_records;
+}
+
+void TelemetryTap::initialize(int capacity) {
+    destroy();
+
+    unsigned int size = 1;
+    while (size < static_cast<unsigned int>(capacity)) size <<= 1;
+
+    m_records = new Record[size];
+    m_mask = size - 1;
+}
+
+void TelemetryTap::destroy() {
+    delete[] m_records;
+    m_records = nullptr;
+    m_mask = 0;
+
+    m_writeIndex = 0;
+    m_readIndex = 0;
+    m_dropped = 0;
+}
+
+bool TelemetryTap::write(const Record &record) {
+    if (m_records == nullptr) return false;
+
+    const unsigned int writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+    const unsigned int readIndex = m_readIndex.load(std::memory_order_acquire);
+    if (writeIndex - readIndex > m_mask) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_records[writeIndex & m_mask] = record;
+    m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+
+    return true;
+}
+
+int TelemetryTap::read(Record *target, int maxRecords) {
+    if (m_records == nullptr) return 0;
+
+    const unsigned int readIndex = m_readIndex.load(std::memory_order_relaxed);
+    const unsigned int writeIndex = m_writeIndex.load(std::memory_order_acquire);
+
+    unsigned int n = writeIndex - readIndex;
+    if (n > static_cast<unsigned int>(maxRecords)) n = static_cast<unsigned int>(maxRecords);
+
+    for (unsigned int i = 0; i < n; ++i) {
+        target[i] = m_records[(readIndex + i) & m_mask];
+    }
+
+    m_readIndex.store(readIndex + n, std::memory_order_release);
+
+    return static_cast<int>(n);
+}
+
+int TelemetryTap::getPendingCount() const {
+    return static_cast<int>(
+        m_writeIndex.load(std::memory_order_acquire) - m_readIndex.load(std::memory_order_acquire));
+}
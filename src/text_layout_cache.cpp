@@ -0,0 +1,57 @@
+#include "../include/text_layout_cache.h"
+
+TextLayoutCache::TextLayoutCache() {
+    m_renderer = nullptr;
+    m_lookup.height = 0.0f;
+    m_frame = 0;
+}
+
+TextLayoutCache::~TextLayoutCache() {
+    /* void */
+}
+
+void TextLayoutCache::initialize(dbasic::TextRenderer *renderer) {
+    m_renderer = renderer;
+    m_runs.clear();
+    m_frame = 0;
+    m_statistics = Statistics();
+}
+
+void TextLayoutCache::destroy() {
+    m_runs.clear();
+    m_renderer = nullptr;
+}
+
+void TextLayoutCache::beginFrame() {
+    ++m_frame;
+    if (m_frame % EvictionFrames == 0) {
+        for (auto it = m_runs.begin(); it != m_runs.end();) {
+            if (m_frame - it->second.lastUsed > EvictionFrames) it = m_runs.erase(it);
+            else ++it;
+        }
+    }
+
+    m_statistics.runs = static_cast<int>(m_runs.size());
+    m_statistics.hits = 0;
+    m_statistics.layouts = 0;
+}
+
+float TextLayoutCache::getWidth(const std::string &s, float height) {
+    m_lookup.text.assign(s);
+    m_lookup.height = height;
+
+    auto it = m_runs.find(m_lookup);
+    if (it != m_runs.end()) {
+        it->second.lastUsed = m_frame;
+        ++m_statistics.hits;
+        return it->second.width;
+    }
+
+    Run run;
+    run.width = m_renderer->CalculateWidth(s, height);
+    run.lastUsed = m_frame;
+    m_runs.emplace(m_lookup, run);
+    ++m_statistics.layouts;
+
+    return run.width;
+}
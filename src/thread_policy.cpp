@@ -0,0 +1,264 @@
+#include "../include/thread_policy.h"
+
+#include "../include/debug_trace.h"
+
+#include <algorithm>
+#include <mutex>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#include <os/workgroup.h>
+#include <pthread.h>
+#include <pthread/qos.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+std::mutex g_lock;
+ThreadPolicy::Settings g_settings;
+void *g_audioWorkgroup = nullptr;
+
+#if defined(__APPLE__)
+// Joined per thread, so the token has to live with the thread
+thread_local os_workgroup_t t_joinedWorkgroup = nullptr;
+thread_local os_workgroup_join_token_s t_joinToken;
+#endif
+
+const char *roleName(ThreadPolicy::Role role) {
+    return (role == ThreadPolicy::Role::Audio) ? "audio" : "physics";
+}
+
+#if defined(__APPLE__)
+bool setTimeConstraint(double period) {
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    const double ticksPerSecond = 1E9 * timebase.denom / timebase.numer;
+
+    // The kernel rejects computations over 50 ms
+    const double seconds = std::clamp(period, 0.0005, 0.05);
+    thread_time_constraint_policy_data_t policy;
+    policy.period = static_cast<uint32_t>(seconds * ticksPerSecond);
+    policy.computation = static_cast<uint32_t>(0.5 * seconds * ticksPerSecond);
+    policy.constraint = static_cast<uint32_t>(seconds * ticksPerSecond);
+    policy.preemptible = TRUE;
+
+    return thread_policy_set(
+        pthread_mach_thread_np(pthread_self()),
+        THREAD_TIME_CONSTRAINT_POLICY,
+        reinterpret_cast<thread_policy_t>(&policy),
+        THREAD_TIME_CONSTRAINT_POLICY_COUNT) == KERN_SUCCESS;
+}
+
+bool setAffinity(int core) {
+    // Threads sharing a tag are kept on one L2; Apple silicon ignores it
+    thread_affinity_policy_data_t policy;
+    policy.affinity_tag = core + 1;
+
+    const kern_return_t result = thread_policy_set(
+        pthread_mach_thread_np(pthread_self()),
+        THREAD_AFFINITY_POLICY,
+        reinterpret_cast<thread_policy_t>(&policy),
+        THREAD_AFFINITY_POLICY_COUNT);
+    return result == KERN_SUCCESS || result == KERN_NOT_SUPPORTED;
+}
+
+bool joinWorkgroup(void *workgroup) {
+    if (workgroup == nullptr || t_joinedWorkgroup != nullptr) return true;
+
+    if (__builtin_available(macOS 11.0, *)) {
+        os_workgroup_t group = static_cast<os_workgroup_t>(workgroup);
+        if (os_workgroup_join(group, &t_joinToken) != 0) return false;
+
+        t_joinedWorkgroup = group;
+    }
+
+    return true;
+}
+
+void leaveWorkgroup() {
+    if (t_joinedWorkgroup == nullptr) return;
+
+    if (__builtin_available(macOS 11.0, *)) {
+        os_workgroup_leave(t_joinedWorkgroup, &t_joinToken);
+    }
+
+    t_joinedWorkgroup = nullptr;
+}
+#elif defined(_WIN32)
+bool setAffinity(int core) {
+    if (core >= static_cast<int>(sizeof(DWORD_PTR) * 8)) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+}
+#elif defined(__linux__)
+bool setFifo(ThreadPolicy::Role role) {
+    // Audio above physics, both well under the kernel's own threads
+    const int minimum = sched_get_priority_min(SCHED_FIFO);
+    const int maximum = sched_get_priority_max(SCHED_FIFO);
+
+    sched_param param;
+    param.sched_priority =
+        std::min(minimum + ((role == ThreadPolicy::Role::Audio) ? 20 : 10), maximum);
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+bool setAffinity(int core) {
+    if (core >= CPU_SETSIZE) return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+}
+#endif
+} /* namespace */
+
+void ThreadPolicy::SetSettings(const Settings &settings) {
+    std::lock_guard<std::mutex> lock(g_lock);
+    g_settings = settings;
+}
+
+ThreadPolicy::Settings ThreadPolicy::GetSettings() {
+    std::lock_guard<std::mutex> lock(g_lock);
+    return g_settings;
+}
+
+void ThreadPolicy::SetAudioWorkgroup(void *workgroup) {
+    std::lock_guard<std::mutex> lock(g_lock);
+    g_audioWorkgroup = workgroup;
+}
+
+bool ThreadPolicy::ApplyToCurrentThread(Role role, double period, int coreOffset) {
+    Settings settings;
+    void *workgroup = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_lock);
+        settings = g_settings;
+        workgroup = g_audioWorkgroup;
+    }
+
+    const bool realtime = (role == Role::Audio) ? settings.realtimeAudio : settings.realtimePhysics;
+    const int baseCore = (role == Role::Audio) ? settings.audioCore : settings.physicsCore;
+    const int core = (baseCore >= 0) ? baseCore + std::max(coreOffset, 0) : -1;
+
+    bool scheduled = true;
+    bool pinned = true;
+    bool joined = true;
+
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+    if (realtime) {
+        scheduled = setTimeConstraint(period);
+        if (scheduled && role == Role::Audio) joined = joinWorkgroup(workgroup);
+    }
+
+    if (core >= 0) pinned = setAffinity(core);
+#elif defined(_WIN32)
+    (void)period;
+    (void)workgroup;
+    const int priority = realtime ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+    scheduled = SetThreadPriority(GetCurrentThread(), priority) != 0;
+    if (core >= 0) pinned = setAffinity(core);
+#elif defined(__linux__)
+    (void)period;
+    (void)workgroup;
+    if (realtime) scheduled = setFifo(role);
+    if (core >= 0) pinned = setAffinity(core);
+#else
+    (void)period;
+    (void)workgroup;
+    (void)realtime;
+    pinned = core < 0;
+#endif
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "thread_policy role=%s realtime=%d scheduled=%d core=%d pinned=%d workgroup=%d",
+        roleName(role),
+        realtime ? 1 : 0,
+        scheduled ? 1 : 0,
+        core,
+        pinned ? 1 : 0,
+        joined ? 1 : 0);
+
+    return scheduled && pinned && joined;
+}
+
+void ThreadPolicy::ReleaseCurrentThread(Role role) {
+#if defined(__APPLE__)
+    if (role == Role::Audio) leaveWorkgroup();
+#else
+    (void)role;
+#endif
+}
+
+bool ThreadPolicy::PinCurrentThread(const std::vector<int> &cpus) {
+    if (cpus.empty()) return false;
+
+    bool pinned = false;
+#if defined(__APPLE__)
+    // Keeping the threads of one placement on one L2 is all macOS offers
+    setAffinity(cpus.front());
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+
+    pinned = mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+
+    pinned = CPU_COUNT(&set) > 0
+        && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#endif
+
+    ATG_ENGINE_SIM_TRACE(
+        Simulator, Event,
+        "thread_policy pin cpus=%d first=%d pinned=%d",
+        static_cast<int>(cpus.size()),
+        cpus.front(),
+        pinned ? 1 : 0);
+
+    return pinned;
+}
+
+bool ThreadPolicy::GetCurrentThreadCpus(std::vector<int> *cpus) {
+    cpus->clear();
+
+#if defined(_WIN32)
+    // Read back by setting it, then put it straight back
+    const HANDLE thread = GetCurrentThread();
+    const DWORD_PTR mask = SetThreadAffinityMask(thread, ~static_cast<DWORD_PTR>(0));
+    if (mask == 0) return false;
+    SetThreadAffinityMask(thread, mask);
+
+    for (int i = 0; i < static_cast<int>(sizeof(DWORD_PTR) * 8); ++i) {
+        if ((mask & (static_cast<DWORD_PTR>(1) << i)) != 0) cpus->push_back(i);
+    }
+
+    return true;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0) return false;
+
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+        if (CPU_ISSET(i, &set)) cpus->push_back(i);
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
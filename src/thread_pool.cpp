@@ -0,0 +1,129 @@
+#include "../include/thread_pool.h"
+
+#include <cassert>
+
+namespace {
+constexpr int SpinCount = 4096;
+constexpr int SpinBeforeYield = 64;
+constexpr uint64_t ClosedIndex = 0xFFFFFFFF;
+} /* namespace */
+
+ThreadPool::ThreadPool() {
+    m_work = 0;
+    m_remaining = 0;
+    m_sleeping = 0;
+    m_run = false;
+
+    m_task = nullptr;
+    m_context = nullptr;
+    m_taskCount = 0;
+}
+
+ThreadPool::~ThreadPool() {
+    assert(m_threads.empty());
+}
+
+void ThreadPool::initialize(int threadCount) {
+    destroy();
+
+    m_run = true;
+    for (int i = 1; i < threadCount; ++i) {
+        m_threads.emplace_back(&ThreadPool::worker, this);
+    }
+}
+
+void ThreadPool::destroy() {
+    if (m_threads.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lk(m_lock);
+        m_run = false;
+        m_taskCount = 0;
+        m_work = (uint64_t)(generation() + 1) << 32;
+    }
+
+    m_cv.notify_all();
+
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+
+    m_threads.clear();
+}
+
+void ThreadPool::run(int n, Task task, void *context) {
+    if (n <= 0) return;
+
+    if (m_threads.empty() || n == 1) {
+        for (int i = 0; i < n; ++i) {
+            task(context, i);
+        }
+
+        return;
+    }
+
+    // Advance the generation with the index closed first so workers still
+    // draining the previous dispatch can't pair a stale index with the new
+    // task count.
+    const uint32_t g = generation() + 1;
+    m_work = ((uint64_t)g << 32) | ClosedIndex;
+    m_task = task;
+    m_context = context;
+    m_taskCount = n;
+    m_remaining = n;
+    m_work = (uint64_t)g << 32;
+
+    if (m_sleeping > 0) {
+        std::lock_guard<std::mutex> lk(m_lock);
+        m_cv.notify_all();
+    }
+
+    execute(g);
+
+    for (int i = 0; m_remaining > 0; ++i) {
+        if (i > SpinBeforeYield) std::this_thread::yield();
+    }
+}
+
+void ThreadPool::worker() {
+    uint32_t seen = generation();
+    while (true) {
+        for (int i = 0; i < SpinCount && generation() == seen; ++i) {
+            if (i > SpinBeforeYield) std::this_thread::yield();
+        }
+
+        if (generation() == seen) {
+            std::unique_lock<std::mutex> lk(m_lock);
+            ++m_sleeping;
+            m_cv.wait(lk, [this, seen] { return generation() != seen || !m_run; });
+            --m_sleeping;
+        }
+
+        if (!m_run) return;
+
+        seen = generation();
+        execute(seen);
+    }
+}
+
+void ThreadPool::execute(uint32_t g) {
+    uint64_t work = m_work;
+    while (true) {
+        if ((uint32_t)(work >> 32) != g) return;
+
+        if ((work & 0xFFFFFFFF) == ClosedIndex) {
+            work = m_work;
+            continue;
+        }
+
+        const int i = static_cast<int>(work & 0xFFFFFFFF);
+        if (i >= m_taskCount) return;
+
+        if (!m_work.compare_exchange_weak(work, work + 1)) continue;
+
+        m_task.load()(m_context, i);
+        --m_remaining;
+
+        work = m_work;
+    }
+}
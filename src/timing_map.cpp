@@ -0,0 +1,152 @@
+#include "../include/timing_map.h"
+
+#include "../include/function.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+TimingMap::TimingMap() {
+    m_values = nullptr;
+    m_speedSamples = 0;
+    m_pressureSamples = 0;
+    m_speed0 = m_speed1 = 0.0;
+    m_pressure0 = m_pressure1 = 0.0;
+    m_invSpeedStep = m_invPressureStep = 0.0;
+}
+
+TimingMap::~TimingMap() {
+    assert(m_values == nullptr);
+}
+
+void TimingMap::initialize(
+    int speedSamples,
+    int pressureSamples,
+    double speed0,
+    double speed1,
+    double pressure0,
+    double pressure1)
+{
+    assert(speedSamples >= 2 && pressureSamples >= 2);
+    assert(speed1 > speed0 && pressure1 > pressure0);
+
+    destroy();
+
+    m_speedSamples = speedSamples;
+    m_pressureSamples = pressureSamples;
+    m_speed0 = speed0;
+    m_speed1 = speed1;
+    m_pressure0 = pressure0;
+    m_pressure1 = pressure1;
+    m_invSpeedStep = (speedSamples - 1) / (speed1 - speed0);
+    m_invPressureStep = (pressureSamples - 1) / (pressure1 - pressure0);
+
+    m_values = new double[(size_t)speedSamples * pressureSamples];
+    std::fill(m_values, m_values + (size_t)speedSamples * pressureSamples, 0.0);
+}
+
+void TimingMap::destroy() {
+    delete[] m_values;
+
+    m_values = nullptr;
+    m_speedSamples = 0;
+    m_pressureSamples = 0;
+}
+
+void TimingMap::build(const Function *const *rows, const double *pressures, int rowCount) {
+    assert(isBaked());
+    if (rowCount <= 0) return;
+
+    std::vector<int> order(rowCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [pressures](int a, int b) { return pressures[a] < pressures[b]; });
+
+    std::vector<double> row0(m_speedSamples), row1(m_speedSamples);
+    for (int j = 0; j < m_pressureSamples; ++j) {
+        const double pressure =
+            m_pressure0 + (m_pressure1 - m_pressure0) * j / (m_pressureSamples - 1);
+
+        // Outside the given rows the nearest one holds
+        int upper = 0;
+        while (upper < rowCount && pressures[order[upper]] < pressure) ++upper;
+        const int r0 = order[std::max(upper - 1, 0)];
+        const int r1 = order[std::min(upper, rowCount - 1)];
+
+        const double span = pressures[r1] - pressures[r0];
+        const double s = (span > 0)
+            ? std::fmin(std::fmax((pressure - pressures[r0]) / span, 0.0), 1.0)
+            : 0.0;
+
+        for (int i = 0; i < m_speedSamples; ++i) {
+            const double speed = m_speed0 + (m_speed1 - m_speed0) * i / (m_speedSamples - 1);
+            const double a0 = rows[r0]->sampleTriangle(speed);
+            const double a1 = (r1 == r0) ? a0 : rows[r1]->sampleTriangle(speed);
+            setValue(i, j, a0 + (a1 - a0) * s);
+        }
+    }
+}
+
+void TimingMap::setValue(int speedIndex, int pressureIndex, double advance) {
+    assert(speedIndex >= 0 && speedIndex < m_speedSamples);
+    assert(pressureIndex >= 0 && pressureIndex < m_pressureSamples);
+
+    m_values[pressureIndex * m_speedSamples + speedIndex] = advance;
+}
+
+double TimingMap::sample(double speed, double pressure) const {
+    const double u = std::fmin(
+        std::fmax((speed - m_speed0) * m_invSpeedStep, 0.0), m_speedSamples - 1.0);
+    const double v = std::fmin(
+        std::fmax((pressure - m_pressure0) * m_invPressureStep, 0.0), m_pressureSamples - 1.0);
+
+    const int i = std::min(static_cast<int>(u), m_speedSamples - 2);
+    const int j = std::min(static_cast<int>(v), m_pressureSamples - 2);
+    const double s = u - i;
+    const double t = v - j;
+
+    const double *a = m_values + (size_t)j * m_speedSamples + i;
+    const double *b = a + m_speedSamples;
+    const double lower = a[0] + (a[1] - a[0]) * s;
+    const double upper = b[0] + (b[1] - b[0]) * s;
+
+    return lower + (upper - lower) * t;
+}
+
+bool TimingMap::matches(const TimingMap &other) const {
+    if (m_speedSamples != other.m_speedSamples
+        || m_pressureSamples != other.m_pressureSamples
+        || m_speed0 != other.m_speed0
+        || m_speed1 != other.m_speed1
+        || m_pressure0 != other.m_pressure0
+        || m_pressure1 != other.m_pressure1)
+    {
+        return false;
+    }
+
+    return std::equal(
+        m_values,
+        m_values + (size_t)m_speedSamples * m_pressureSamples,
+        other.m_values);
+}
+
+void TimingMap::assign(const TimingMap &other) {
+    if (!other.isBaked()) {
+        destroy();
+        return;
+    }
+
+    initialize(
+        other.m_speedSamples,
+        other.m_pressureSamples,
+        other.m_speed0,
+        other.m_speed1,
+        other.m_pressure0,
+        other.m_pressure1);
+    std::copy(
+        other.m_values,
+        other.m_values + (size_t)m_speedSamples * m_pressureSamples,
+        m_values);
+}
@@ -7,6 +7,7 @@
 #include <chrono>
 #include <cmath>
 #include <algorithm>
+#include <functional>
 #include <typeinfo>
 #include <unordered_map>
 
@@ -65,6 +66,7 @@ UiElement::UiElement() {
     m_mouseOver = false;
     m_mouseHeld = false;
     m_visible = true;
+    m_layoutDirty = true;
 }
 
 UiElement::~UiElement() {
@@ -86,7 +88,7 @@ void UiElement::destroy() {
 
 void UiElement::update(float dt) {
     for (UiElement *child : m_children) {
-        child->update(dt);
+        if (child->isVisible()) child->update(dt);
     }
 }
 
@@ -97,8 +99,8 @@ void UiElement::render() {
         const Bounds renderBounds = child->unitsToPixels(child->getRenderBounds(child->m_bounds));
         WidgetTraceState &state = g_widgetState[child];
         if (!state.initialized || boundsChanged(state.bounds, renderBounds)) {
-            DebugTrace::Log(
-                "ui",
+            ATG_ENGINE_SIM_TRACE(
+                Ui, Verbose,
                 "widget invalidation reason=BOUNDS_CHANGED id=%p name=%s bounds=(%.2f,%.2f,%.2f,%.2f)",
                 child,
                 child->getDebugName(),
@@ -119,8 +121,8 @@ void UiElement::render() {
             || state.visible != visible
             || state.culled != culledOffscreen
             || state.z != child->m_index) {
-            DebugTrace::Log(
-                "ui",
+            ATG_ENGINE_SIM_TRACE(
+                Ui, Verbose,
                 "widget visibility id=%p name=%s visible=%d culled=%d reason=%s z=%d layer=%d bounds=(%.2f,%.2f,%.2f,%.2f)",
                 child,
                 child->getDebugName(),
@@ -141,11 +143,11 @@ void UiElement::render() {
         if (!shouldDraw) continue;
 
         const auto t0 = std::chrono::steady_clock::now();
-        DebugTrace::Log("ui", "widget draw begin id=%p name=%s z=%d", child, child->getDebugName(), child->m_index);
+        ATG_ENGINE_SIM_TRACE(Ui, Verbose, "widget draw begin id=%p name=%s z=%d", child, child->getDebugName(), child->m_index);
         child->render();
         const auto t1 = std::chrono::steady_clock::now();
-        DebugTrace::Log(
-            "ui",
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Verbose,
             "widget draw end id=%p name=%s duration_us=%lld",
             child,
             child->getDebugName(),
@@ -157,6 +159,47 @@ const char *UiElement::getDebugName() const {
     return typeid(*this).name();
 }
 
+void UiElement::layout() {
+    /* void */
+}
+
+void UiElement::generateGeometry() {
+    /* void */
+}
+
+void UiElement::collectShown(std::vector<UiElement *> *elements) {
+    elements->push_back(this);
+    for (UiElement *child : m_children) {
+        if (child->isVisible()) child->collectShown(elements);
+    }
+}
+
+void UiElement::updateLayout() {
+    if (m_layoutDirty || boundsChanged(m_layoutBounds, m_bounds)) {
+        ATG_ENGINE_SIM_TRACE(
+            Ui, Verbose,
+            "widget layout id=%p name=%s dirty=%d",
+            this,
+            getDebugName(),
+            m_layoutDirty ? 1 : 0);
+        layout();
+        m_layoutBounds = m_bounds;
+        m_layoutDirty = false;
+    }
+
+    // Hidden children keep their stale layout until they are shown, when
+    // their bounds no longer match it
+    for (UiElement *child : m_children) {
+        if (child->isVisible()) child->updateLayout();
+    }
+}
+
+void UiElement::invalidateLayout() {
+    for (UiElement *element = this; element != nullptr; element = element->m_parent) {
+        element->m_layoutDirty = true;
+    }
+}
+
 void UiElement::signal(UiElement *element, Event event) {
     /* void */
 }
@@ -219,8 +262,8 @@ void UiElement::setLocalPosition(const Point &p, const Point &ref) {
     const Point nextPosition = m_localPosition + (p - current);
     if (pointsEqual(nextPosition, m_localPosition)) return;
     m_localPosition = nextPosition;
-    DebugTrace::Log(
-        "ui",
+    ATG_ENGINE_SIM_TRACE(
+        Ui, Verbose,
         "widget invalidation reason=LOCAL_POSITION id=%p name=%s local_pos=(%.2f,%.2f)",
         this,
         getDebugName(),
@@ -231,8 +274,8 @@ void UiElement::setLocalPosition(const Point &p, const Point &ref) {
 void UiElement::setLocalPosition(const Point &p) {
     if (pointsEqual(p, m_localPosition)) return;
     m_localPosition = p;
-    DebugTrace::Log(
-        "ui",
+    ATG_ENGINE_SIM_TRACE(
+        Ui, Verbose,
         "widget invalidation reason=LOCAL_POSITION id=%p name=%s local_pos=(%.2f,%.2f)",
         this,
         getDebugName(),
@@ -243,12 +286,36 @@ void UiElement::setLocalPosition(const Point &p) {
 void UiElement::setVisible(bool visible) {
     if (m_visible == visible) return;
     m_visible = visible;
-    DebugTrace::Log(
-        "ui",
+    if (m_parent != nullptr) m_parent->invalidateLayout();
+    ATG_ENGINE_SIM_TRACE(
+        Ui, Verbose,
         "widget invalidation reason=VISIBILITY id=%p name=%s visible=%d",
         this,
         getDebugName(),
         m_visible ? 1 : 0);
+
+    notifyVisibilityChanged(isShown());
+}
+
+bool UiElement::isShown() const {
+    for (const UiElement *element = this; element != nullptr; element = element->m_parent) {
+        if (!element->m_visible) return false;
+    }
+
+    return true;
+}
+
+void UiElement::onVisibilityChanged(bool shown) {
+    /* void */
+}
+
+void UiElement::notifyVisibilityChanged(bool shown) {
+    onVisibilityChanged(shown);
+
+    // Children hidden on their own stay hidden either way
+    for (UiElement *child : m_children) {
+        if (child->m_visible) child->notifyVisibilityChanged(shown);
+    }
 }
 
 void UiElement::bringToFront(UiElement *element) {
@@ -264,8 +331,8 @@ void UiElement::bringToFront(UiElement *element) {
         element->m_index = i++;
     }
 
-    DebugTrace::Log(
-        "ui",
+    ATG_ENGINE_SIM_TRACE(
+        Ui, Verbose,
         "widget invalidation reason=Z_ORDER id=%p name=%s new_z=%d",
         element,
         element->getDebugName(),
@@ -284,8 +351,8 @@ void UiElement::activate() {
     }
 
     if (!zOrderChanged) return;
-    DebugTrace::Log(
-        "ui",
+    ATG_ENGINE_SIM_TRACE(
+        Ui, Verbose,
         "widget invalidation reason=ACTIVATE id=%p name=%s",
         this,
         getDebugName());
@@ -330,6 +397,10 @@ Bounds UiElement::unitsToPixels(const Bounds &b) const {
     return { unitsToPixels(b.m0), unitsToPixels(b.m1) };
 }
 
+float UiElement::measureText(const std::string &s, float height) {
+    return m_app->getTextLayoutCache()->getWidth(s, height);
+}
+
 void UiElement::resetShader() {
     m_app->getShaders()->ResetBaseColor();
     m_app->getShaders()->SetObjectTransform(ysMath::LoadIdentity());
@@ -341,6 +412,8 @@ void UiElement::drawModel(
     const Point &p,
     const Point &s)
 {
+    m_app->flushDraws();
+
     resetShader();
 
     const Point p_render = getRenderPoint(p);
@@ -428,6 +501,8 @@ void UiElement::drawText(
         float height,
         const Point &ref)
 {
+    m_app->flushDraws();
+
     const Bounds renderBounds = unitsToPixels(getRenderBounds(bounds));
     const Point origin = renderBounds.getPosition(ref);
 
@@ -442,10 +517,12 @@ void UiElement::drawAlignedText(
         const Point &ref,
         const Point &refText)
 {
+    m_app->flushDraws();
+
     const Bounds renderBounds = unitsToPixels(getRenderBounds(bounds));
     const Point origin = renderBounds.getPosition(ref);
 
-    const float textWidth = m_app->getTextRenderer()->CalculateWidth(s, height);
+    const float textWidth = measureText(s, height);
     const float textHeight = height;
 
     const Bounds textBounds(
@@ -465,10 +542,12 @@ void UiElement::drawCenteredText(
         float height,
         const Point &ref)
 {
+    m_app->flushDraws();
+
     const Bounds renderBounds = unitsToPixels(getRenderBounds(bounds));
     const Point origin = renderBounds.getPosition(ref);
 
-    const float width = m_app->getTextRenderer()->CalculateWidth(s, height);
+    const float width = measureText(s, height);
     m_app->getTextRenderer()->RenderText(
             s, origin.x - width / 2, origin.y - height / 4, height);
 }
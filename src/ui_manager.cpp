@@ -74,5 +74,14 @@ void UiManager::update(float dt) {
 }
 
 void UiManager::render() {
+    m_root.updateLayout();
+
+    m_shown.clear();
+    m_root.collectShown(&m_shown);
+    m_app->getParallelGeometry()->run(
+        m_app->getGeometryGenerator(),
+        (int)m_shown.size(),
+        [this](int i) { m_shown[i]->generateGeometry(); });
+
     m_root.render();
 }
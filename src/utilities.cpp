@@ -1,5 +1,7 @@
 #include "../include/utilities.h"
 
+#include "../include/kernel_dispatch.h"
+
 #include <cmath>
 
 double modularDistance(double a0, double b0, double mod) {
@@ -40,3 +42,17 @@ double erfApproximation(double x) {
 
     return 1 - q4;
 }
+
+float dotProduct(const float *a, const float *b, int n) {
+    return KernelDispatch::Get().dotProduct(a, b, n);
+}
+
+void quantizeToInt16(
+    const float *input, int16_t *output, int n, float scale, const float *dither)
+{
+    KernelDispatch::Get().quantizeToInt16(input, output, n, scale, dither);
+}
+
+void multiplyAccumulateSpectrum(float *acc, const float *x, const float *y, int n) {
+    KernelDispatch::Get().multiplyAccumulateSpectrum(acc, x, y, n);
+}
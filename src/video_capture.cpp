@@ -0,0 +1,183 @@
+#include "../include/video_capture.h"
+
+#ifdef ATG_ENGINE_SIM_VIDEO_CAPTURE
+
+#include <assert.h>
+#include <cstring>
+
+VideoCapture::VideoCapture() {
+    m_thread = nullptr;
+    m_run = false;
+    m_currentSlot = -1;
+    m_audioSamples = 0;
+    m_videoFrames = 0;
+    m_sampleRate = 44100;
+    m_frameRate = 60;
+    m_droppedFrames = 0;
+}
+
+VideoCapture::~VideoCapture() {
+    assert(m_thread == nullptr);
+}
+
+bool VideoCapture::start(
+    const atg_dtv::Encoder::VideoSettings &settings,
+    const std::string &audioPath,
+    int sampleRate)
+{
+    stop();
+
+    const size_t frameSize =
+        (size_t)settings.inputWidth * settings.inputHeight * (settings.inputAlpha ? 4 : 3);
+
+    m_freeSlots.clear();
+    m_queuedSlots.clear();
+    for (int i = 0; i < FrameSlots; ++i) {
+        m_slots[i].rgb.resize(frameSize);
+        m_slots[i].repeat = 0;
+        m_freeSlots.push_back(i);
+    }
+
+    m_currentSlot = -1;
+    m_pendingAudio.clear();
+    m_audioSamples = 0;
+    m_videoFrames = 0;
+    m_sampleRate = sampleRate;
+    m_frameRate = (settings.frameRate > 0) ? settings.frameRate : 60;
+    m_droppedFrames = 0;
+
+    m_audioFile.open(audioPath, sampleRate);
+
+    // The encoder keeps its own queue small; the slots absorb the rest
+    m_encoder.run(settings, 2);
+    if (m_encoder.getError() != atg_dtv::Encoder::Error::None) {
+        m_encoder.stop();
+        m_audioFile.close();
+
+        return false;
+    }
+
+    m_run = true;
+    m_thread = new std::thread(&VideoCapture::worker, this);
+
+    return true;
+}
+
+void VideoCapture::stop() {
+    if (m_thread == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_run = false;
+    }
+
+    m_wake.notify_one();
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+
+    m_encoder.commit();
+    m_encoder.stop();
+
+    flushAudio(&m_pendingAudio);
+    m_audioFile.close();
+
+    for (Slot &slot : m_slots) {
+        slot.rgb.clear();
+        slot.rgb.shrink_to_fit();
+    }
+}
+
+uint8_t *VideoCapture::beginFrame(bool wait) {
+    if (m_thread == nullptr) return nullptr;
+
+    const long long due = m_audioSamples * m_frameRate / m_sampleRate + 1;
+    if (due <= m_videoFrames) return nullptr;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (wait) {
+        m_slotFreed.wait(lock, [this] { return !m_freeSlots.empty(); });
+    }
+
+    if (m_freeSlots.empty()) {
+        // The frames missed here are made up by repeating the next one
+        ++m_droppedFrames;
+        return nullptr;
+    }
+
+    m_currentSlot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    m_slots[m_currentSlot].repeat = (int)(due - m_videoFrames);
+
+    return m_slots[m_currentSlot].rgb.data();
+}
+
+void VideoCapture::endFrame() {
+    if (m_currentSlot == -1) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_videoFrames += m_slots[m_currentSlot].repeat;
+        m_queuedSlots.push_back(m_currentSlot);
+        m_currentSlot = -1;
+    }
+
+    m_wake.notify_one();
+}
+
+void VideoCapture::writeAudio(const int16_t *samples, int count) {
+    if (m_thread == nullptr || count <= 0) return;
+
+    m_audioSamples += count;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_pendingAudio.insert(m_pendingAudio.end(), samples, samples + count);
+}
+
+void VideoCapture::worker() {
+    std::vector<int16_t> audio;
+    std::vector<int> slots;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (true) {
+        m_wake.wait(lock, [this] { return !m_run || !m_queuedSlots.empty(); });
+
+        const bool run = m_run;
+        slots.swap(m_queuedSlots);
+        audio.swap(m_pendingAudio);
+        lock.unlock();
+
+        for (int index : slots) {
+            const Slot &slot = m_slots[index];
+            for (int i = 0; i < slot.repeat; ++i) {
+                if (m_encoder.getError() != atg_dtv::Encoder::Error::None) break;
+
+                // Blocks until the encoder has a frame free; only this
+                // thread waits
+                atg_dtv::Frame *frame = m_encoder.newFrame(true);
+                if (frame == nullptr) break;
+
+                std::memcpy(frame->m_rgb, slot.rgb.data(), slot.rgb.size());
+                m_encoder.submitFrame();
+            }
+        }
+
+        flushAudio(&audio);
+
+        lock.lock();
+        for (int index : slots) {
+            m_freeSlots.push_back(index);
+        }
+        slots.clear();
+        m_slotFreed.notify_one();
+
+        if (!run && m_queuedSlots.empty()) break;
+    }
+}
+
+void VideoCapture::flushAudio(std::vector<int16_t> *pending) {
+    m_audioFile.write(pending->data(), (int)pending->size());
+    pending->clear();
+}
+
+#endif /* ATG_ENGINE_SIM_VIDEO_CAPTURE */
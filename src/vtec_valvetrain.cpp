@@ -9,12 +9,20 @@ VtecValvetrain::VtecValvetrain() {
     m_vtecIntakeCamshaft = nullptr;
     m_vtecExhaustCamshaft = nullptr;
 
+    m_activeIntakeCamshaft = nullptr;
+    m_activeExhaustCamshaft = nullptr;
+
     m_engine = nullptr;
 
     m_minRpm = 0.0;
     m_minSpeed = 0.0;
     m_minThrottlePosition = 0.0;
     m_manifoldVacuum = 0.0;
+    m_rpmHysteresis = 0.0;
+    m_engagementDelay = 0.0;
+
+    m_engaged = false;
+    m_switchTime = 0.0;
 }
 
 VtecValvetrain::~VtecValvetrain() {
@@ -31,36 +39,59 @@ void VtecValvetrain::initialize(const Parameters &parameters) {
     m_minSpeed = parameters.minSpeed;
     m_minThrottlePosition = parameters.minThrottlePosition;
     m_manifoldVacuum = parameters.manifoldVacuum;
+    m_rpmHysteresis = parameters.rpmHysteresis;
+    m_engagementDelay = parameters.engagementDelay;
     m_engine = parameters.engine;
+
+    m_engaged = false;
+    m_switchTime = 0.0;
+    m_activeIntakeCamshaft = m_intakeCamshaft;
+    m_activeExhaustCamshaft = m_exhaustCamshaft;
 }
 
 double VtecValvetrain::intakeValveLift(int cylinder) {
-    return isVtecEnabled()
-        ? m_vtecIntakeCamshaft->valveLift(cylinder)
-        : m_intakeCamshaft->valveLift(cylinder);
+    return m_activeIntakeCamshaft->valveLift(cylinder);
 }
 
 double VtecValvetrain::exhaustValveLift(int cylinder) {
-    return isVtecEnabled()
-        ? m_vtecExhaustCamshaft->valveLift(cylinder)
-        : m_exhaustCamshaft->valveLift(cylinder);
+    return m_activeExhaustCamshaft->valveLift(cylinder);
 }
 
 Camshaft *VtecValvetrain::getActiveIntakeCamshaft() {
-    return isVtecEnabled()
-        ? m_vtecIntakeCamshaft
-        : m_intakeCamshaft;
+    return m_activeIntakeCamshaft;
 }
 
 Camshaft *VtecValvetrain::getActiveExhaustCamshaft() {
-    return isVtecEnabled()
-        ? m_vtecExhaustCamshaft
-        : m_exhaustCamshaft;
+    return m_activeExhaustCamshaft;
+}
+
+void VtecValvetrain::update(double dt) {
+    const bool requested = m_engaged
+        ? isVtecEnabled(m_minRpm - m_rpmHysteresis)
+        : isVtecEnabled(m_minRpm);
+
+    if (requested == m_engaged) {
+        m_switchTime = 0.0;
+    }
+    else {
+        m_switchTime += dt;
+        if (m_switchTime >= m_engagementDelay) {
+            m_engaged = requested;
+            m_switchTime = 0.0;
+        }
+    }
+
+    latchCamshafts();
+}
+
+void VtecValvetrain::latchCamshafts() {
+    m_activeIntakeCamshaft = m_engaged ? m_vtecIntakeCamshaft : m_intakeCamshaft;
+    m_activeExhaustCamshaft = m_engaged ? m_vtecExhaustCamshaft : m_exhaustCamshaft;
 }
 
-bool VtecValvetrain::isVtecEnabled() const {
+bool VtecValvetrain::isVtecEnabled(double minRpm) const {
     return
-        m_engine->getManifoldPressure() > m_manifoldVacuum
-        && m_engine->getSpeed() > m_minRpm
+        m_engine->getAggregates().manifoldPressure > m_manifoldVacuum
+        && m_engine->getSpeed() > minRpm
         && (1 - m_engine->getThrottle()) > m_minThrottlePosition;
 }
@@ -0,0 +1,252 @@
+#include "../include/warm_start.h"
+
+#include "../include/piston_engine_simulator.h"
+#include "../include/constants.h"
+#include "../include/debug_trace.h"
+#include "../include/utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+// Seconds either side of the current angle the bodies are placed at to
+// difference their velocities
+constexpr double VelocityStep = 1E-6;
+
+struct BodyPose {
+    double p_x, p_y, theta;
+};
+
+void recordPoses(Engine *engine, std::vector<BodyPose> *poses) {
+    const int cylinderCount = engine->getCylinderCount();
+    for (int i = 0; i < cylinderCount; ++i) {
+        const atg_scs::RigidBody &piston = engine->getPiston(i)->m_body;
+        const atg_scs::RigidBody &rod = engine->getConnectingRod(i)->m_body;
+        (*poses)[2 * i + 0] = { piston.p_x, piston.p_y, piston.theta };
+        (*poses)[2 * i + 1] = { rod.p_x, rod.p_y, rod.theta };
+    }
+}
+
+void rotateCrankshafts(Engine *engine, double dtheta) {
+    for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+        engine->getCrankshaft(i)->m_body.theta += dtheta;
+    }
+}
+
+void setVelocity(atg_scs::RigidBody *body, const BodyPose &ahead, const BodyPose &behind) {
+    const double dt = 2 * VelocityStep;
+    body->v_x = (ahead.p_x - behind.p_x) / dt;
+    body->v_y = (ahead.p_y - behind.p_y) / dt;
+    body->v_theta = std::remainder(ahead.theta - behind.theta, 2 * constants::pi) / dt;
+}
+
+double sweptVolume(const CombustionChamber *chamber, double s) {
+    const CylinderHead *head = chamber->getCylinderHead();
+    const CylinderBank *bank = head->getCylinderBank();
+    const Piston *piston = chamber->getPiston();
+
+    return bank->boreSurfaceArea() * (bank->getDeckHeight() - s - piston->getCompressionHeight())
+        + head->getCombustionChamberVolume()
+        - piston->getDisplacement();
+}
+} /* namespace */
+
+WarmStart::Result WarmStart::Apply(PistonEngineSimulator *simulator, const Settings &settings) {
+    Result result;
+
+    Engine *engine = simulator->getEngine();
+    if (engine == nullptr) return result;
+
+    const int cylinderCount = engine->getCylinderCount();
+    const double omega = -settings.speed;
+
+    // The bodies stay where loadSimulation() placed them and pick up the
+    // velocities of the crank turning through that angle
+    for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+        engine->getCrankshaft(i)->m_body.v_theta = omega;
+    }
+
+    if (simulator->m_reducedKinematics) {
+        simulator->m_crankSlider.place();
+    }
+    else {
+        std::vector<BodyPose> ahead(2 * cylinderCount), behind(2 * cylinderCount);
+
+        rotateCrankshafts(engine, omega * VelocityStep);
+        simulator->placeCylinders();
+        recordPoses(engine, &ahead);
+
+        rotateCrankshafts(engine, -2 * omega * VelocityStep);
+        simulator->placeCylinders();
+        recordPoses(engine, &behind);
+
+        rotateCrankshafts(engine, omega * VelocityStep);
+        simulator->placeCylinders();
+        for (int i = 0; i < cylinderCount; ++i) {
+            setVelocity(&engine->getPiston(i)->m_body, ahead[2 * i + 0], behind[2 * i + 0]);
+            setVelocity(&engine->getConnectingRod(i)->m_body, ahead[2 * i + 1], behind[2 * i + 1]);
+        }
+    }
+
+    // Each intake feeds the cylinders whose heads draw from it
+    std::vector<double> minVolume(cylinderCount), maxVolume(cylinderCount);
+    std::vector<double> demand(engine->getIntakeCount(), 0.0);
+    for (int i = 0; i < cylinderCount; ++i) {
+        const CombustionChamber *chamber = engine->getChamber(i);
+        const ConnectingRod *rod = engine->getConnectingRod(i);
+        const double halfStroke = rod->getCrankshaft()->getThrow();
+
+        minVolume[i] = std::fmax(sweptVolume(chamber, rod->getLength() + halfStroke), 1E-9);
+        maxVolume[i] = std::fmax(sweptVolume(chamber, rod->getLength() - halfStroke), minVolume[i]);
+
+        const Intake *intake =
+            chamber->getCylinderHead()->getIntake(chamber->getPiston()->getCylinderIndex());
+        demand[intake - engine->getIntake(0)] +=
+            settings.volumetricEfficiency
+            * (maxVolume[i] - minVolume[i])
+            * (settings.speed / (4 * constants::pi))
+            / (constants::R * settings.intakeTemperature);
+    }
+
+    std::vector<double> manifoldPressure(engine->getIntakeCount());
+    for (int i = 0; i < engine->getIntakeCount(); ++i) {
+        Intake *intake = engine->getIntake(i);
+        manifoldPressure[i] = (settings.manifoldPressure > 0)
+            ? settings.manifoldPressure
+            : EstimateManifoldPressure(intake, demand[i]);
+
+        intake->m_system.reset(manifoldPressure[i], settings.intakeTemperature, intake->getAtmosphereMix());
+        result.manifoldPressure += manifoldPressure[i] / engine->getIntakeCount();
+    }
+
+    const GasSystem::Mix burned;
+    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+        GasSystem *collector = engine->getExhaustSystem(i)->getSystem();
+        collector->reset(collector->pressure(), settings.exhaustTemperature, burned);
+    }
+
+    IgnitionModule *ignition = engine->getIgnitionModule();
+    ignition->setManifoldPressure(result.manifoldPressure);
+    ignition->reset();
+
+    const double cycleAngle = ignition->getCrankshaft()->getCycleAngle();
+    const double advance = ignition->getTimingAdvance();
+    for (int i = 0; i < cylinderCount; ++i) {
+        CombustionChamber *chamber = engine->getChamber(i);
+        CombustionChamber::FluidState *fluid = chamber->getFluidState();
+        const CylinderHead *head = chamber->getCylinderHead();
+        const int cylinderIndex = chamber->getPiston()->getCylinderIndex();
+
+        const Intake *intake = head->getIntake(cylinderIndex);
+        const double intakePressure = manifoldPressure[intake - engine->getIntake(0)];
+        const double exhaustPressure = head->getExhaustSystem(cylinderIndex)->getSystem()->pressure();
+        const GasSystem::Mix &charge = intake->getAtmosphereMix();
+
+        // Without a plug the cylinder only pumps, so it's kept on the charge
+        const double phase = ignition->isPlugEnabled(i)
+            ? positiveMod(cycleAngle - ignition->getFiringAngle(i), 4 * constants::pi)
+            : 2 * constants::pi;
+        const double volume = std::fmin(std::fmax(chamber->getVolume(), minVolume[i]), maxVolume[i]);
+        const ChamberEstimate estimate = EstimateChamber(
+            phase,
+            volume,
+            minVolume[i],
+            maxVolume[i],
+            intakePressure,
+            exhaustPressure,
+            settings);
+
+        fluid->lit = false;
+        fluid->system.reset(estimate.pressure, estimate.temperature, estimate.burned ? burned : charge);
+
+        fluid->intakeRunnerAndManifold.reset(intakePressure, settings.intakeTemperature, charge);
+        if (fluid->intakePipe != nullptr) {
+            fluid->intakePipe->reset(intakePressure, settings.intakeTemperature, charge);
+        }
+
+        fluid->exhaustRunnerAndPrimary.reset(exhaustPressure, settings.exhaustTemperature, burned);
+        if (fluid->exhaustPipe != nullptr) {
+            fluid->exhaustPipe->reset(exhaustPressure, settings.exhaustTemperature, burned);
+        }
+
+        // The spark for this cycle already went by, with the charge still to
+        // burn before top dead center
+        const double sparkAdvance = advance + ignition->getCylinderTrim(i);
+        if (ignition->isPlugEnabled(i) && sparkAdvance > 0 && phase >= 4 * constants::pi - sparkAdvance) {
+            chamber->ignite();
+            if (chamber->isLit()) ++result.litCylinders;
+        }
+    }
+
+    result.applied = true;
+    ATG_ENGINE_SIM_TRACE(
+        Simulator,
+        Event,
+        "warm start rpm=%.0f manifold_kpa=%.1f lit=%d",
+        units::toRpm(settings.speed),
+        units::convert(result.manifoldPressure, units::kPa),
+        result.litCylinders);
+
+    return result;
+}
+
+double WarmStart::EstimateManifoldPressure(const Intake *intake, double demand) {
+    const double P_a = intake->getAtmospherePressure();
+    const double T_a = intake->getAtmosphereTemperature();
+    const double k_flow =
+        std::cos(intake->getThrottlePlatePosition() * constants::pi / 2) * intake->getInputFlowK()
+        + intake->getIdleFlowK() * intake->getIdleAir();
+    const GasSystem::FlowConstants flowConstants = GasSystem::flowConstants(5);
+
+    // Supply falls and demand rises with the manifold pressure, so the
+    // balance is bracketed by vacuum and the atmosphere
+    double low = 0.0, high = P_a;
+    for (int i = 0; i < 60; ++i) {
+        const double P = 0.5 * (low + high);
+        const double supply = GasSystem::flowRate(k_flow, P_a, P, T_a, T_a, flowConstants);
+        if (supply > demand * P) low = P;
+        else high = P;
+    }
+
+    return 0.5 * (low + high);
+}
+
+WarmStart::ChamberEstimate WarmStart::EstimateChamber(
+    double phase,
+    double volume,
+    double minVolume,
+    double maxVolume,
+    double manifoldPressure,
+    double exhaustPressure,
+    const Settings &settings)
+{
+    const double pi = constants::pi;
+    const double k = settings.polytropicExponent;
+    const double trappedPressure = settings.volumetricEfficiency * manifoldPressure;
+
+    ChamberEstimate estimate;
+    if (phase < pi) {
+        // Power: the trapped charge burned at top dead center and expanding
+        const double n = trappedPressure * maxVolume / (constants::R * settings.intakeTemperature);
+        const double burnedPressure = n * constants::R * settings.combustionTemperature / minVolume;
+        estimate.pressure = burnedPressure * std::pow(minVolume / volume, k);
+        estimate.temperature = settings.combustionTemperature * std::pow(minVolume / volume, k - 1);
+        estimate.burned = true;
+    }
+    else if (phase < 2 * pi) {
+        estimate.pressure = exhaustPressure;
+        estimate.temperature = settings.exhaustTemperature;
+        estimate.burned = true;
+    }
+    else if (phase < 3 * pi) {
+        estimate.pressure = manifoldPressure;
+        estimate.temperature = settings.intakeTemperature;
+    }
+    else {
+        estimate.pressure = trappedPressure * std::pow(maxVolume / volume, k);
+        estimate.temperature = settings.intakeTemperature * std::pow(maxVolume / volume, k - 1);
+    }
+
+    return estimate;
+}
@@ -0,0 +1,129 @@
+#include "../include/wav_file.h"
+
+#include "../include/mapped_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr uint16_t FormatPcm = 1;
+constexpr uint16_t FormatFloat = 3;
+constexpr uint16_t FormatExtensible = 0xFFFE;
+
+// RIFF fields are little-endian regardless of the host
+uint32_t readU32(const unsigned char *p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint16_t readU16(const unsigned char *p) {
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+int16_t decodeSample(const unsigned char *p, uint16_t format, int bytes) {
+    if (format == FormatFloat) {
+        const uint32_t bits = readU32(p);
+        float value;
+        std::memcpy(&value, &bits, sizeof(float));
+
+        if (!std::isfinite(value)) return 0;
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * INT16_MAX));
+    }
+
+    switch (bytes) {
+        case 1: return static_cast<int16_t>((int(p[0]) - 128) << 8);
+        case 2: return static_cast<int16_t>(readU16(p));
+        case 3: return static_cast<int16_t>(readU16(p + 1));
+        default: return static_cast<int16_t>(readU16(p + 2));
+    }
+}
+} /* namespace */
+
+WavFile::WavFile() {
+    m_sampleRate = 0;
+    m_channelCount = 0;
+}
+
+WavFile::~WavFile() {
+    /* void */
+}
+
+bool WavFile::load(const std::string &path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        destroy();
+        return false;
+    }
+
+    return decode(file.getData(), file.getSize());
+}
+
+bool WavFile::decode(const char *data, size_t size) {
+    destroy();
+
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    if (bytes == nullptr || size < 12
+        || std::memcmp(bytes, "RIFF", 4) != 0
+        || std::memcmp(bytes + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+
+    uint16_t format = 0;
+    int channels = 0, sampleRate = 0, bitsPerSample = 0;
+    const unsigned char *samples = nullptr;
+    size_t sampleBytes = 0;
+
+    // Chunks are word aligned; anything besides fmt and data is skipped
+    size_t offset = 12;
+    while (offset + 8 <= size) {
+        const unsigned char *chunk = bytes + offset;
+        const size_t chunkSize = readU32(chunk + 4);
+        const size_t available = std::min(chunkSize, size - offset - 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            format = readU16(chunk + 8);
+            channels = readU16(chunk + 10);
+            sampleRate = static_cast<int>(readU32(chunk + 12));
+            bitsPerSample = readU16(chunk + 22);
+
+            if (format == FormatExtensible && available >= 26) {
+                format = readU16(chunk + 32);
+            }
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0) {
+            // Truncated files keep whatever samples they have
+            samples = chunk + 8;
+            sampleBytes = available;
+        }
+
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    const int sampleSize = bitsPerSample / 8;
+    const bool supported =
+        (format == FormatPcm && bitsPerSample % 8 == 0 && sampleSize >= 1 && sampleSize <= 4)
+        || (format == FormatFloat && bitsPerSample == 32);
+    if (!supported || channels <= 0 || samples == nullptr) {
+        return false;
+    }
+
+    const size_t frameSize = static_cast<size_t>(sampleSize) * channels;
+    const size_t frames = sampleBytes / frameSize;
+
+    m_samples.resize(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        m_samples[i] = decodeSample(samples + i * frameSize, format, sampleSize);
+    }
+
+    m_sampleRate = sampleRate;
+    m_channelCount = channels;
+
+    return true;
+}
+
+void WavFile::destroy() {
+    m_samples.clear();
+    m_sampleRate = 0;
+    m_channelCount = 0;
+}
@@ -0,0 +1,84 @@
+#include "../include/wav_writer.h"
+
+#include <vector>
+
+namespace {
+// RIFF fields are little-endian regardless of the host
+void appendU32(std::vector<unsigned char> *data, uint32_t v) {
+    for (int i = 0; i < 4; ++i) data->push_back(static_cast<unsigned char>((v >> (8 * i)) & 0xFF));
+}
+
+void appendU16(std::vector<unsigned char> *data, uint16_t v) {
+    data->push_back(static_cast<unsigned char>(v & 0xFF));
+    data->push_back(static_cast<unsigned char>(v >> 8));
+}
+} /* namespace */
+
+WavWriter::WavWriter() {
+    m_file = nullptr;
+    m_sampleRate = 0;
+    m_sampleCount = 0;
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::open(const std::string &path, int sampleRate) {
+    close();
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) return false;
+
+    m_sampleRate = sampleRate;
+    m_sampleCount = 0;
+    writeHeader();
+
+    return std::ferror(m_file) == 0;
+}
+
+bool WavWriter::write(const int16_t *samples, int count) {
+    if (m_file == nullptr) return false;
+    if (count <= 0) return true;
+
+    std::vector<unsigned char> data;
+    data.reserve(static_cast<size_t>(count) * 2);
+    for (int i = 0; i < count; ++i) {
+        appendU16(&data, static_cast<uint16_t>(samples[i]));
+    }
+
+    m_sampleCount += count;
+    return std::fwrite(data.data(), 1, data.size(), m_file) == data.size();
+}
+
+bool WavWriter::close() {
+    if (m_file == nullptr) return true;
+
+    std::fseek(m_file, 0, SEEK_SET);
+    writeHeader();
+
+    const bool ok = std::ferror(m_file) == 0;
+    std::fclose(m_file);
+    m_file = nullptr;
+
+    return ok;
+}
+
+void WavWriter::writeHeader() {
+    const uint32_t dataBytes = static_cast<uint32_t>(m_sampleCount * 2);
+
+    std::vector<unsigned char> header = { 'R', 'I', 'F', 'F' };
+    appendU32(&header, 36 + dataBytes);
+    header.insert(header.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+    appendU32(&header, 16);
+    appendU16(&header, 1);
+    appendU16(&header, 1);
+    appendU32(&header, static_cast<uint32_t>(m_sampleRate));
+    appendU32(&header, static_cast<uint32_t>(m_sampleRate) * 2);
+    appendU16(&header, 2);
+    appendU16(&header, 16);
+    header.insert(header.end(), { 'd', 'a', 't', 'a' });
+    appendU32(&header, dataBytes);
+
+    std::fwrite(header.data(), 1, header.size(), m_file);
+}
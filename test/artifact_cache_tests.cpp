@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "../include/artifact_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+std::filesystem::path cacheDirectory(const char *name) {
+    const std::filesystem::path directory = std::filesystem::path(testing::TempDir()) / name;
+    std::filesystem::remove_all(directory);
+
+    return directory;
+}
+
+void writeFile(const std::filesystem::path &path, const std::string &contents) {
+    FILE *file = std::fopen(path.string().c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fclose(file);
+}
+
+ArtifactCache::Key key(int index) {
+    return ArtifactCache::Key(ArtifactCache::Kind::ImpulseResponse).add(index);
+}
+} /* namespace */
+
+TEST(ArtifactCacheTests, StoreAndLoad) {
+    const std::filesystem::path directory = cacheDirectory("artifact_cache_tests");
+
+    ArtifactCache cache;
+    ArtifactCache::Artifact artifact;
+    EXPECT_FALSE(cache.store(key(0), "x", 1));
+    EXPECT_FALSE(cache.load(key(0), &artifact));
+
+    cache.configure(directory.string());
+    ASSERT_TRUE(cache.isEnabled());
+    EXPECT_FALSE(cache.load(key(0), &artifact));
+
+    std::vector<float> taps(100);
+    for (int i = 0; i < 100; ++i) taps[i] = i * 0.25f;
+    ASSERT_TRUE(cache.store(key(0), taps.data(), sizeof(float) * taps.size()));
+
+    ASSERT_TRUE(cache.load(key(0), &artifact));
+    ASSERT_EQ(artifact.getSize(), sizeof(float) * taps.size());
+    EXPECT_EQ(std::memcmp(artifact.getData(), taps.data(), artifact.getSize()), 0);
+    EXPECT_FALSE(cache.load(key(1), &artifact));
+
+    // Nothing but the finished file is left behind, and a damaged one misses
+    int files = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        EXPECT_EQ(entry.path().extension(), ".eac");
+        ++files;
+    }
+
+    EXPECT_EQ(files, 1);
+
+    const std::string path = cache.getPath(key(0));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_FALSE(cache.load(key(0), &artifact));
+
+    const ArtifactCache::Statistics statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.hits, 1);
+    EXPECT_EQ(statistics.misses, 3);
+    EXPECT_EQ(statistics.writes, 1);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ArtifactCacheTests, KeysFollowContent) {
+    const std::filesystem::path directory = cacheDirectory("artifact_cache_content_tests");
+    std::filesystem::create_directories(directory);
+
+    writeFile(directory / "a.wav", "response");
+    writeFile(directory / "b.wav", "response");
+
+    ArtifactCache::Key a(ArtifactCache::Kind::ImpulseResponse);
+    ArtifactCache::Key b(ArtifactCache::Kind::ImpulseResponse);
+    ASSERT_TRUE(a.addFile((directory / "a.wav").string()));
+    ASSERT_TRUE(b.addFile((directory / "b.wav").string()));
+    EXPECT_EQ(a.getHash(), b.getHash());
+
+    writeFile(directory / "b.wav", "responsf");
+    ArtifactCache::Key edited(ArtifactCache::Kind::ImpulseResponse);
+    ASSERT_TRUE(edited.addFile((directory / "b.wav").string()));
+    EXPECT_NE(edited.getHash(), a.getHash());
+
+    ArtifactCache::Key missing(ArtifactCache::Kind::ImpulseResponse);
+    EXPECT_FALSE(missing.addFile((directory / "c.wav").string()));
+
+    // Settings are part of the key too
+    EXPECT_NE(key(0).add(1.0).getHash(), key(0).add(2.0).getHash());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ArtifactCacheTests, EvictsLeastRecentlyUsed) {
+    const std::filesystem::path directory = cacheDirectory("artifact_cache_eviction_tests");
+    const std::vector<char> payload(1000, 'a');
+    const uint64_t artifactBytes = sizeof(ArtifactCache::Header) + payload.size();
+
+    ArtifactCache cache;
+    cache.configure(directory.string(), 3 * artifactBytes);
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(cache.store(key(i), payload.data(), payload.size()));
+
+    ArtifactCache::Artifact artifact;
+    ASSERT_TRUE(cache.load(key(0), &artifact));
+    artifact.close();
+
+    ASSERT_TRUE(cache.store(key(3), payload.data(), payload.size()));
+    EXPECT_EQ(cache.getStatistics().evictions, 1);
+
+    EXPECT_TRUE(cache.load(key(0), &artifact));
+    EXPECT_FALSE(cache.load(key(1), &artifact));
+    EXPECT_TRUE(cache.load(key(2), &artifact));
+    EXPECT_TRUE(cache.load(key(3), &artifact));
+
+    // A smaller limit trims what's already there
+    artifact.close();
+    cache.configure(directory.string(), artifactBytes);
+    EXPECT_TRUE(cache.load(key(3), &artifact));
+    EXPECT_FALSE(cache.load(key(0), &artifact));
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "../include/audio_analyzer.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr double Pi = 3.14159265358979;
+
+std::vector<float> sine(double frequency, double amplitude, int n) {
+    std::vector<float> samples(n);
+    for (int i = 0; i < n; ++i) {
+        samples[i] = static_cast<float>(amplitude * std::sin(2 * Pi * frequency * i / 44100.0));
+    }
+
+    return samples;
+}
+
+} /* namespace */
+
+TEST(AudioAnalyzerTests, SineLevelCentroidAndHarmonics) {
+    AudioAnalyzer analyzer;
+    analyzer.initialize(44100.0f);
+    analyzer.setFiringFrequency(1000.0f);
+
+    EXPECT_EQ(analyzer.getMetrics().windows, 0);
+
+    // Fed in odd-sized blocks, as the audio thread does
+    const std::vector<float> samples = sine(1000.0, 0.5, 44100);
+    for (size_t i = 0; i < samples.size(); i += 700) {
+        analyzer.process(samples.data() + i, (int)std::min<size_t>(700, samples.size() - i));
+    }
+
+    const AudioAnalyzer::Metrics &metrics = analyzer.getMetrics();
+    EXPECT_GT(metrics.windows, 40);
+    EXPECT_NEAR(metrics.loudness, 20 * std::log10(0.5 / std::sqrt(2.0)), 0.1);
+    EXPECT_NEAR(metrics.spectralCentroid, 1000.0, 100.0);
+    EXPECT_GT(metrics.harmonics[0], -0.5f);
+    EXPECT_LT(metrics.harmonics[1], -40.0f);
+    EXPECT_LT(metrics.roughness, 0.05f);
+
+    analyzer.destroy();
+}
+
+TEST(AudioAnalyzerTests, AmplitudeModulationIsRough) {
+    AudioAnalyzer analyzer;
+    analyzer.initialize(44100.0f);
+
+    // 2 kHz carrier fully modulated at 70 Hz
+    std::vector<float> samples = sine(2000.0, 0.5, 44100);
+    for (int i = 0; i < (int)samples.size(); ++i) {
+        samples[i] *= static_cast<float>(0.5 + 0.5 * std::sin(2 * Pi * 70.0 * i / 44100.0));
+    }
+
+    analyzer.process(samples.data(), (int)samples.size());
+    EXPECT_GT(analyzer.getMetrics().roughness, 0.3f);
+
+    analyzer.destroy();
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include "../include/batch_stepper.h"
+
+#include "../include/simulator.h"
+#include "test_engine.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Copies of the test twin loaded into simulators without audio
+struct Rig {
+    std::vector<Engine *> engines;
+    std::vector<Vehicle *> vehicles;
+    std::vector<Transmission *> transmissions;
+    std::vector<Simulator *> simulators;
+
+    explicit Rig(int lanes) {
+        for (int i = 0; i < lanes; ++i) {
+            Engine *engine = test_engine::buildEngine();
+            Vehicle *vehicle = test_engine::buildVehicle();
+            Transmission *transmission = test_engine::buildTransmission();
+            Simulator *simulator = engine->createSimulator(vehicle, transmission, false, false);
+            simulator->setSimulationFrequency(10000);
+            simulator->setOfflineMode(true);
+
+            engines.push_back(engine);
+            vehicles.push_back(vehicle);
+            transmissions.push_back(transmission);
+            simulators.push_back(simulator);
+        }
+    }
+
+    ~Rig() {
+        for (size_t i = 0; i < simulators.size(); ++i) {
+            simulators[i]->releaseSimulation();
+            delete simulators[i];
+            test_engine::release(engines[i], vehicles[i], transmissions[i]);
+        }
+    }
+};
+
+BatchStepper::Parameters shortRun(int threads) {
+    BatchStepper::Parameters params;
+    params.duration = 0.1;
+    params.measureStart = 0.05;
+    params.frameLength = 1 / 60.0;
+    params.threads = threads;
+    return params;
+}
+
+BatchStepper::LaneResult lane(double rpm, double torque, double imep, int cycles) {
+    BatchStepper::LaneResult result;
+    result.rpm = rpm;
+    result.torque = torque;
+    result.power = torque * units::rpm(rpm);
+    result.imep = imep;
+    result.imepCoefficientOfVariation = 0.01 * cycles;
+    result.peakPressure = 10.0 * imep;
+    result.cycles = cycles;
+    result.valid = true;
+    return result;
+}
+
+// Same bits, not just equal values
+uint64_t bits(double value) {
+    uint64_t result;
+    std::memcpy(&result, &value, sizeof(value));
+    return result;
+}
+
+} /* namespace */
+
+TEST(BatchStepperTests, ReducesOverValidLanes) {
+    std::vector<BatchStepper::LaneResult> lanes = {
+        lane(2000, 100.0, 800.0, 4),
+        lane(4000, 140.0, 1000.0, 8),
+        lane(6000, 90.0, 600.0, 12)
+    };
+
+    // Left out of every figure
+    BatchStepper::LaneResult invalid = lane(8000, 1000.0, 1.0E6, 100);
+    invalid.valid = false;
+    lanes.push_back(invalid);
+
+    const BatchStepper::Reduction reduction = BatchStepper::Reduce(lanes);
+    EXPECT_EQ(reduction.lanes, 3);
+    EXPECT_DOUBLE_EQ(reduction.meanTorque, 110.0);
+    EXPECT_DOUBLE_EQ(reduction.minTorque, 90.0);
+    EXPECT_DOUBLE_EQ(reduction.maxTorque, 140.0);
+    EXPECT_DOUBLE_EQ(reduction.meanPower, (lanes[0].power + lanes[1].power + lanes[2].power) / 3);
+    EXPECT_DOUBLE_EQ(reduction.maxPower, lanes[1].power);
+    EXPECT_DOUBLE_EQ(reduction.maxPowerRpm, 4000.0);
+    EXPECT_DOUBLE_EQ(reduction.meanImep, 800.0);
+    EXPECT_DOUBLE_EQ(reduction.meanImepCoefficientOfVariation, 0.08);
+    EXPECT_DOUBLE_EQ(reduction.maxPeakPressure, 10000.0);
+    EXPECT_EQ(reduction.cycles, 24);
+
+    const BatchStepper::Reduction empty = BatchStepper::Reduce({ invalid });
+    EXPECT_EQ(empty.lanes, 0);
+    EXPECT_EQ(empty.meanTorque, 0.0);
+    EXPECT_EQ(empty.maxPower, 0.0);
+}
+
+TEST(BatchStepperTests, StepsLanesInLockstep) {
+    Rig rig(3);
+
+    BatchStepper stepper;
+    stepper.initialize(shortRun(0));
+    EXPECT_EQ(stepper.addLane(rig.simulators[0], 2000, 1.0), 0);
+    EXPECT_EQ(stepper.addLane(rig.simulators[1], 4000, 0.5), 1);
+    EXPECT_EQ(stepper.addLane(rig.simulators[2], 9000, 0.2), 2);
+    ASSERT_EQ(stepper.getLaneCount(), 3);
+
+    const BatchStepper::Result result = stepper.run();
+    stepper.destroy();
+
+    // Six frames of whole steps, three of them measured
+    EXPECT_EQ(result.frames, 6);
+    ASSERT_EQ(result.lanes.size(), 3u);
+    EXPECT_EQ(result.steps, 3 * 6 * 166);
+    for (const BatchStepper::LaneResult &lane : result.lanes) {
+        EXPECT_TRUE(lane.valid);
+        EXPECT_EQ(lane.steps, 6 * 166);
+        EXPECT_DOUBLE_EQ(lane.simulatedTime, 6 * 166 / 10000.0);
+    }
+
+    // The speed held is clamped to the engine's dyno range
+    EXPECT_DOUBLE_EQ(result.lanes[0].rpm, 2000.0);
+    EXPECT_DOUBLE_EQ(result.lanes[1].rpm, 4000.0);
+    EXPECT_NEAR(result.lanes[2].rpm, 6500.0, 1E-9);
+
+    EXPECT_EQ(result.reduction.lanes, 3);
+}
+
+TEST(BatchStepperTests, ResultIsIndependentOfThreadCount) {
+    const double rpms[] = { 2500, 3500, 4500, 5500 };
+
+    std::vector<BatchStepper::LaneResult> reference;
+    for (const int threads : { 1, 2, 4 }) {
+        Rig rig(4);
+
+        BatchStepper stepper;
+        stepper.initialize(shortRun(threads));
+        for (int i = 0; i < 4; ++i) stepper.addLane(rig.simulators[i], rpms[i], 0.8);
+
+        const BatchStepper::Result result = stepper.run();
+        stepper.destroy();
+
+        if (reference.empty()) {
+            reference = result.lanes;
+            continue;
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_EQ(bits(result.lanes[i].torque), bits(reference[i].torque))
+                << "lane " << i << " threads " << threads;
+            EXPECT_EQ(bits(result.lanes[i].imep), bits(reference[i].imep))
+                << "lane " << i << " threads " << threads;
+            EXPECT_EQ(result.lanes[i].cycles, reference[i].cycles)
+                << "lane " << i << " threads " << threads;
+        }
+    }
+}
+
+TEST(BatchStepperTests, CsvLeavesOutInvalidLanes) {
+    BatchStepper::Result result;
+    result.lanes = { lane(2000, 100.0, 800.0, 4), BatchStepper::LaneResult(), lane(4000, 140.0, 1000.0, 8) };
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "engine_sim_batch_stepper_tests.csv";
+    ASSERT_TRUE(BatchStepper::WriteCsv(path.string(), result));
+
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) lines.push_back(line);
+    file.close();
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "lane,rpm,torque_nm,power_kw,imep_kpa,imep_cov,peak_pressure_kpa,cycles");
+    EXPECT_EQ(lines[1].substr(0, 12), "0,2000,100.0");
+    EXPECT_EQ(lines[2].substr(0, 12), "2,4000,140.0");
+}
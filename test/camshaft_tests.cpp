@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "../include/camshaft.h"
+#include "../include/constants.h"
+
+#include <cmath>
+
+TEST(CamshaftTests, BakedLobeMatchesProfile) {
+    Function lobe;
+    lobe.initialize(64, units::angle(2, units::deg));
+    for (int i = -32; i <= 32; ++i) {
+        const double x = units::angle(i * 3.0, units::deg);
+        const double lift = std::fmax(0.0, std::cos(x * 2.0));
+        lobe.addSample(x, units::distance(400 * lift * lift, units::thou));
+    }
+
+    Camshaft::Parameters params;
+    params.lobes = 1;
+    params.crankshaft = nullptr;
+    params.lobeProfile = &lobe;
+
+    Camshaft camshaft;
+    camshaft.initialize(params);
+    EXPECT_TRUE(camshaft.isLobeBaked());
+
+    for (int i = -1000; i <= 1000; ++i) {
+        const double theta = i * 0.0137;
+        EXPECT_NEAR(
+            camshaft.sampleBakedLobe(theta),
+            camshaft.sampleLobe(theta),
+            units::distance(0.5, units::thou));
+    }
+
+    // Editing the profile invalidates the table until it is baked again
+    lobe.addSample(0.0, 0.0);
+    EXPECT_FALSE(camshaft.isLobeBaked());
+
+    camshaft.bakeLobeProfile();
+    EXPECT_TRUE(camshaft.isLobeBaked());
+    EXPECT_NEAR(camshaft.sampleBakedLobe(0.0), camshaft.sampleLobe(0.0), 1E-9);
+
+    camshaft.destroy();
+    lobe.destroy();
+}
+
+TEST(CamshaftTests, SharedLobeIsCopiedBeforeRebaking) {
+    Function lobe;
+    lobe.initialize(64, units::angle(2, units::deg));
+    for (int i = -32; i <= 32; ++i) {
+        const double x = units::angle(i * 3.0, units::deg);
+        lobe.addSample(x, units::distance(300 * std::fmax(0.0, std::cos(x * 2.0)), units::thou));
+    }
+
+    Camshaft::Parameters params;
+    params.lobes = 1;
+    params.crankshaft = nullptr;
+    params.lobeProfile = &lobe;
+
+    Camshaft a;
+    a.initialize(params);
+
+    params.sharedLobe = a.getBakedLobe();
+    Camshaft b;
+    b.initialize(params);
+    EXPECT_TRUE(b.isLobeBaked());
+    EXPECT_EQ(b.getBakedLobe().samples, a.getBakedLobe().samples);
+
+    // A stale table is baked afresh instead
+    lobe.addSample(0.0, 0.0);
+    Camshaft c;
+    c.initialize(params);
+    EXPECT_NE(c.getBakedLobe().samples, a.getBakedLobe().samples);
+    EXPECT_TRUE(c.isLobeBaked());
+
+    const double before = a.sampleBakedLobe(0.0);
+    b.bakeLobeProfile();
+    EXPECT_NE(b.getBakedLobe().samples, a.getBakedLobe().samples);
+    EXPECT_DOUBLE_EQ(a.sampleBakedLobe(0.0), before);
+    EXPECT_NEAR(b.sampleBakedLobe(0.0), b.sampleLobe(0.0), 1E-9);
+
+    a.destroy();
+    b.destroy();
+    c.destroy();
+    lobe.destroy();
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include "../include/chamber_force_batch.h"
+
+#include "../include/piston_engine_simulator.h"
+#include "test_engine.h"
+
+#include <cmath>
+
+namespace {
+constexpr int Cylinders = 2;
+
+// The test twin loaded into a simulator without audio, with its pistons
+// renumbered into a system state of its own and wall constraints whose
+// reaction forces are set by hand
+struct Rig {
+    atg_scs::LineConstraint walls[Cylinders];
+    double v_x[Cylinders], v_y[Cylinders];
+    double f_x[Cylinders], f_y[Cylinders];
+    atg_scs::SystemState state;
+
+    Engine *engine;
+    Vehicle *vehicle;
+    Transmission *transmission;
+    PistonEngineSimulator *simulator;
+    ChamberForceBatch batch;
+
+    Rig() {
+        engine = test_engine::buildEngine();
+        vehicle = test_engine::buildVehicle();
+        transmission = test_engine::buildTransmission();
+        simulator = static_cast<PistonEngineSimulator *>(
+            engine->createSimulator(vehicle, transmission, false, false));
+
+        state.v_x = v_x;
+        state.v_y = v_y;
+        state.f_x = f_x;
+        state.f_y = f_y;
+
+        batch.initialize(Cylinders);
+        for (int i = 0; i < Cylinders; ++i) {
+            Piston *piston = engine->getPiston(i);
+            piston->m_body.index = i;
+            piston->setCylinderConstraint(&walls[i]);
+
+            batch.setChamber(i, engine->getChamber(i));
+        }
+    }
+
+    ~Rig() {
+        batch.destroy();
+        for (int i = 0; i < Cylinders; ++i) {
+            engine->getPiston(i)->setCylinderConstraint(nullptr);
+        }
+
+        simulator->releaseSimulation();
+        delete simulator;
+        test_engine::release(engine, vehicle, transmission);
+    }
+
+    void setPiston(int i, double v_x_i, double v_y_i, double wallForce) {
+        v_x[i] = v_x_i;
+        v_y[i] = v_y_i;
+        walls[i].F_x[0][0] = 0.6 * wallForce;
+        walls[i].F_y[0][0] = -0.8 * wallForce;
+    }
+
+    void clearForces() {
+        for (int i = 0; i < Cylinders; ++i) f_x[i] = f_y[i] = 0.0;
+    }
+};
+
+void expectSameForce(double batch, double chamber, const char *axis, int i) {
+    EXPECT_NEAR(batch, chamber, 1E-9 * std::fmax(1.0, std::abs(chamber)))
+        << axis << " of cylinder " << i;
+}
+
+// Runs the batch and every chamber's own apply() over the same state
+void expectMatchesChambers(Rig &rig) {
+    rig.clearForces();
+    rig.batch.apply(&rig.state);
+    const double f_x[] = { rig.f_x[0], rig.f_x[1] };
+    const double f_y[] = { rig.f_y[0], rig.f_y[1] };
+
+    rig.clearForces();
+    for (int i = 0; i < Cylinders; ++i) {
+        rig.engine->getChamber(i)->apply(&rig.state);
+    }
+
+    for (int i = 0; i < Cylinders; ++i) {
+        ASSERT_TRUE(std::isfinite(f_x[i]) && std::isfinite(f_y[i])) << "cylinder " << i;
+        expectSameForce(f_x[i], rig.f_x[i], "f_x", i);
+        expectSameForce(f_y[i], rig.f_y[i], "f_y", i);
+    }
+}
+
+} /* namespace */
+
+TEST(ChamberForceBatchTests, MatchesChamberApply) {
+    Rig rig;
+    ASSERT_EQ(rig.batch.getCylinderCount(), Cylinders);
+
+    // A chamber above and one below the crankcase
+    rig.engine->getChamber(0)->getFluidState()->system.reset(
+        units::pressure(12.0, units::atm), units::celcius(900.0));
+    rig.engine->getChamber(1)->getFluidState()->system.reset(
+        units::pressure(0.4, units::atm), units::celcius(60.0));
+
+    // At rest, inside the attenuation band, around breakaway and well past
+    // it, in both directions along the bore and across it
+    const double speeds[] = { 0.0, 2E-4, -7E-4, 0.05, -0.3, 4.0, -25.0 };
+    const double wallForces[] = { 0.0, 150.0, 2500.0 };
+    for (const double speed : speeds) {
+        for (const double wallForce : wallForces) {
+            rig.setPiston(0, 0.3 * speed, speed, wallForce);
+            rig.setPiston(1, -speed, 0.5 * speed, 2.0 * wallForce);
+            SCOPED_TRACE(::testing::Message() << "speed " << speed << " wall force " << wallForce);
+            expectMatchesChambers(rig);
+        }
+    }
+}
+
+TEST(ChamberForceBatchTests, MatchesChamberApplyWithLatchedPressure) {
+    Rig rig;
+    CombustionChamber *chamber = rig.engine->getChamber(1);
+
+    // The latched average differs from the live pressure
+    chamber->getFluidState()->system.reset(units::pressure(30.0, units::atm), units::celcius(1500.0));
+    chamber->sampleForcePressure();
+    chamber->getFluidState()->system.reset(units::pressure(2.0, units::atm), units::celcius(300.0));
+    chamber->sampleForcePressure();
+    chamber->latchForcePressure();
+    chamber->getFluidState()->system.reset(units::pressure(5.0, units::atm), units::celcius(400.0));
+
+    rig.setPiston(0, 1.5, -3.0, 400.0);
+    rig.setPiston(1, -0.2, 6.0, 900.0);
+    expectMatchesChambers(rig);
+
+    chamber->releaseForcePressure();
+    expectMatchesChambers(rig);
+}
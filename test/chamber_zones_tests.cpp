@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "../include/chamber_zones.h"
+#include "../include/units.h"
+
+#include <cmath>
+
+namespace {
+ChamberZones::Parameters makeZones(double octane) {
+    ChamberZones::Parameters params;
+    params.chambers = 2;
+    params.creviceVolume = units::volume(1.0, units::cc);
+    params.wallTemperature = units::celcius(90.0);
+    params.octaneNumber = octane;
+    return params;
+}
+} /* namespace */
+
+TEST(ChamberZonesTests, UnburnedZoneFollowsAdiabat) {
+    ChamberZones zones;
+    zones.initialize(makeZones(95.0));
+
+    const double P0 = units::pressure(10.0, units::atm);
+    const double T0 = units::kelvin(600.0);
+    const double V = units::volume(500.0, units::cc);
+    zones.setCharge(0, P0, T0, V, 1.4, 0.0, false);
+    zones.setCharge(1, P0, T0, V, 1.4, 0.0, false);
+    zones.evaluate(1E-4);
+    EXPECT_DOUBLE_EQ(zones.getUnburnedTemperature(0), T0);
+    EXPECT_NEAR(zones.getCreviceFraction(0), (1.0 / 500.0) * T0 / units::celcius(90.0), 1E-12);
+
+    // Lit: the charge heats up, but the end gas only sees the pressure rise
+    const double P1 = 2 * P0;
+    zones.setCharge(0, P1, 2000.0, V, 1.4, 0.5, true);
+    zones.setCharge(1, P0, T0, V, 1.4, 0.0, false);
+    zones.evaluate(1E-4);
+
+    const double expected = T0 * std::pow(2.0, 0.4 / 1.4);
+    EXPECT_NEAR(zones.getUnburnedTemperature(0), expected, 1E-9);
+    EXPECT_GT(zones.getBurnedTemperature(0), 2000.0);
+    EXPECT_GT(zones.getKnockIntegral(0), 0.0);
+    EXPECT_EQ(zones.getKnockIntegral(1), 0.0);
+
+    zones.destroy();
+}
+
+TEST(ChamberZonesTests, LowOctaneKnocksFirst) {
+    ChamberZones low, high;
+    low.initialize(makeZones(80.0));
+    high.initialize(makeZones(100.0));
+
+    const double V = units::volume(500.0, units::cc);
+    const double P = units::pressure(40.0, units::atm);
+    int lowOnset = -1, highOnset = -1;
+    for (int step = 0; step < 200; ++step) {
+        for (ChamberZones *zones : { &low, &high }) {
+            // Ignited after the first step
+            zones->setCharge(0, P, units::kelvin(850.0), V, 1.35, step / 400.0, step > 0);
+            zones->setCharge(1, P, units::kelvin(850.0), V, 1.35, 0.0, false);
+            zones->evaluate(1E-4);
+        }
+
+        if (lowOnset < 0 && low.getKnockIntensity(0) > 0) lowOnset = step;
+        if (highOnset < 0 && high.getKnockIntensity(0) > 0) highOnset = step;
+    }
+
+    ASSERT_GE(lowOnset, 0);
+    EXPECT_TRUE(highOnset < 0 || highOnset > lowOnset);
+    EXPECT_EQ(low.getKnockCount(), 1);
+    EXPECT_EQ(low.getKnockIntensity(1), 0.0);
+
+    low.destroy();
+    high.destroy();
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include "../include/combustion_chamber.h"
+
+#include "../include/crankshaft.h"
+#include "../include/cylinder_bank.h"
+#include "../include/cylinder_head.h"
+#include "../include/piston.h"
+#include "test_engine.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double wiebe(double s) {
+    constexpr double a = CombustionChamber::WiebeEfficiency;
+    constexpr double m = CombustionChamber::WiebeForm;
+    return (1.0 - std::exp(-a * std::pow(s, m + 1))) / (1.0 - std::exp(-a));
+}
+
+// A chamber on the twin's first cylinder with a fluid state of its own,
+// recording whatever crank angle, piston speed and pressure it's given
+class Probe : public CombustionChamber {
+    public:
+        explicit Probe(Engine *engine) {
+            m_twin = engine;
+            setEngine(engine);
+            setFluidState(&m_state);
+
+            Parameters params;
+            params.PistonPtr = engine->getPiston(0);
+            params.Head = engine->getHead(0);
+            params.FuelPtr = engine->getFuel();
+            params.MeanPistonSpeedToTurbulence = engine->getChamber(0)->m_meanPistonSpeedToTurbulence;
+            params.StartingPressure = units::pressure(1.0, units::atm);
+            params.StartingTemperature = units::celcius(25.0);
+            params.CrankcasePressure = units::pressure(1.0, units::atm);
+            initialize(params);
+        }
+
+        ~Probe() {
+            destroy();
+        }
+
+        void record(double cycleAngle, double speed, double pressure) {
+            // The cycle angle runs against the crank angle
+            m_twin->getOutputCrankshaft()->m_body.theta = -cycleAngle;
+
+            const CylinderBank *bank = getCylinderHead()->getCylinderBank();
+            getPiston()->m_body.v_x = speed * bank->getDx();
+            getPiston()->m_body.v_y = speed * bank->getDy();
+
+            m_state.system.initialize(pressure, units::volume(500.0, units::cc), units::celcius(25.0));
+            updateCycleStates();
+        }
+
+        // The scans the running sum and peak replaced
+        double scanMeanPistonSpeed() const {
+            double sum = 0;
+            for (int i = 0; i < StateSamples; ++i) sum += m_pistonSpeed[i];
+            return sum / StateSamples;
+        }
+
+        double scanFiringPressure() const {
+            double peak = 0;
+            for (int i = 0; i < StateSamples; ++i) peak = std::max(peak, m_pressure[i]);
+            return peak;
+        }
+
+    protected:
+        Engine *m_twin;
+        FluidState m_state;
+};
+
+} /* namespace */
+
+TEST(CombustionChamberTests, WiebeBurnStartsAndEndsClamped) {
+    EXPECT_EQ(CombustionChamber::wiebeBurnFraction(0.0), 0.0);
+    EXPECT_EQ(CombustionChamber::wiebeBurnFraction(1.0), 1.0);
+
+    // Before ignition and after the burn
+    EXPECT_EQ(CombustionChamber::wiebeBurnFraction(-0.5), 0.0);
+    EXPECT_EQ(CombustionChamber::wiebeBurnFraction(1.5), 1.0);
+
+    EXPECT_NEAR(CombustionChamber::wiebeBurnFraction(1E-9), 0.0, 1E-9);
+    EXPECT_NEAR(CombustionChamber::wiebeBurnFraction(1.0 - 1E-9), 1.0, 1E-6);
+}
+
+TEST(CombustionChamberTests, WiebeBurnIsMonotonic) {
+    constexpr int Samples = 10000;
+
+    double last = CombustionChamber::wiebeBurnFraction(0.0);
+    for (int i = 1; i <= Samples; ++i) {
+        const double x = CombustionChamber::wiebeBurnFraction((double)i / Samples);
+        EXPECT_GT(x, last) << "s = " << (double)i / Samples;
+        last = x;
+    }
+}
+
+TEST(CombustionChamberTests, WiebeBurnMatchesShapeParameters) {
+    constexpr double a = CombustionChamber::WiebeEfficiency;
+    constexpr double m = CombustionChamber::WiebeForm;
+
+    for (int i = 0; i <= 1000; ++i) {
+        const double s = i / 1000.0;
+        EXPECT_NEAR(CombustionChamber::wiebeBurnFraction(s), wiebe(s), 5E-5) << "s = " << s;
+    }
+
+    // The normalized time at which a given fraction has burned follows
+    // from inverting the curve
+    for (double x : { 0.1, 0.5, 0.9 }) {
+        const double s_x = std::pow(-std::log(1.0 - x * (1.0 - std::exp(-a))) / a, 1.0 / (m + 1));
+        EXPECT_NEAR(CombustionChamber::wiebeBurnFraction(s_x), x, 5E-5);
+    }
+}
+
+TEST(CombustionChamberTests, CycleStatesMatchFullScan) {
+    Engine *engine = test_engine::buildEngine();
+    Vehicle *vehicle = test_engine::buildVehicle();
+    Transmission *transmission = test_engine::buildTransmission();
+
+    Probe probe(engine);
+    EXPECT_EQ(probe.calculateMeanPistonSpeed(), 0.0);
+    EXPECT_EQ(probe.calculateFiringPressure(), 0.0);
+
+    // Slow cycles write each bin several times, fast ones skip bins. The
+    // firing peak falls from cycle to cycle, so its bin keeps being
+    // overwritten with less, then climbs again.
+    const double steps[] = { 0.01, 0.01, 0.13, 0.13, 0.05, 0.21, 0.01, 0.13 };
+    const double peaks[] = { 60.0, 45.0, 30.0, 20.0, 25.0, 70.0, 10.0, 40.0 };
+
+    int samples = 0;
+    for (int cycle = 0; cycle < 8; ++cycle) {
+        SCOPED_TRACE(::testing::Message() << "cycle " << cycle);
+
+        for (double angle = 0; angle < 4 * constants::pi; angle += steps[cycle]) {
+            const double s = angle / (4 * constants::pi);
+            const double speed = (5.0 + cycle) * std::sin(2 * constants::pi * s);
+            const double firing = units::pressure(peaks[cycle], units::atm) * std::exp(-100.0 * (s - 0.5) * (s - 0.5));
+            probe.record(angle, speed, units::pressure(1.0, units::atm) + firing);
+            ++samples;
+
+            ASSERT_NEAR(probe.calculateMeanPistonSpeed(), probe.scanMeanPistonSpeed(), 1E-9) << "sample " << samples;
+            ASSERT_EQ(probe.calculateFiringPressure(), probe.scanFiringPressure()) << "sample " << samples;
+        }
+    }
+
+    test_engine::release(engine, vehicle, transmission);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include "../include/piston_engine_simulator.h"
+
+#include "../include/control_queue.h"
+#include "test_engine.h"
+
+#include <cmath>
+
+namespace {
+
+// The test twin loaded into a simulator without audio
+struct Rig {
+    Engine *engine;
+    Vehicle *vehicle;
+    Transmission *transmission;
+    PistonEngineSimulator *simulator;
+
+    explicit Rig(bool pruning) {
+        engine = test_engine::buildEngine();
+        vehicle = test_engine::buildVehicle();
+        transmission = test_engine::buildTransmission();
+        simulator = static_cast<PistonEngineSimulator *>(
+            engine->createSimulator(vehicle, transmission, false, false));
+        simulator->setSimulationFrequency(10000);
+        simulator->setOfflineMode(true);
+        simulator->setConstraintPruning(pruning);
+    }
+
+    ~Rig() {
+        simulator->releaseSimulation();
+        delete simulator;
+        test_engine::release(engine, vehicle, transmission);
+    }
+
+    void apply(ControlQueue::Control control, double value) {
+        ControlQueue::Event event;
+        event.control = control;
+        event.value = value;
+        event.immediate = true;
+        simulator->applyControl(event);
+    }
+
+    void run(int steps) {
+        simulator->startFrameSteps(steps);
+        while (simulator->simulateStep()) { /* void */ }
+        simulator->endFrame();
+    }
+};
+
+struct Phase {
+    const char *name;
+    bool starter;
+    bool dyno;
+    int gear;
+    double clutch;
+    double throttle;
+    int steps;
+};
+
+void expectClose(double pruned, double full, const char *what) {
+    EXPECT_NEAR(pruned, full, 1E-3 * std::fmax(1.0, std::abs(full))) << what;
+}
+
+} /* namespace */
+
+TEST(ConstraintPruningTests, MatchesFullSolveOverToggles) {
+    Rig pruned(true);
+    Rig full(false);
+    ASSERT_TRUE(pruned.simulator->isConstraintPruning());
+    ASSERT_FALSE(full.simulator->isConstraintPruning());
+
+    const Phase script[] = {
+        { "cranking", true, false, -1, 0.0, 0.3, 2000 },
+        { "dyno hold", false, true, -1, 0.0, 0.5, 3000 },
+        { "dyno off", false, false, -1, 0.0, 0.2, 1000 },
+        { "in gear", false, false, 0, 1.0, 0.5, 2000 },
+        { "neutral coast-down", false, false, -1, 0.0, 0.0, 3000 },
+        { "starter again", true, false, -1, 0.0, 0.0, 1000 }
+    };
+
+    for (Rig *rig : { &pruned, &full }) {
+        rig->apply(ControlQueue::Control::Ignition, 1.0);
+        rig->apply(ControlQueue::Control::DynoHold, 1.0);
+        rig->apply(ControlQueue::Control::DynoSpeed, units::rpm(2500));
+    }
+
+    for (const Phase &phase : script) {
+        SCOPED_TRACE(phase.name);
+
+        for (Rig *rig : { &pruned, &full }) {
+            rig->apply(ControlQueue::Control::Starter, phase.starter ? 1.0 : 0.0);
+            rig->apply(ControlQueue::Control::DynoEnabled, phase.dyno ? 1.0 : 0.0);
+            rig->apply(ControlQueue::Control::Gear, phase.gear);
+            rig->apply(ControlQueue::Control::Clutch, phase.clutch);
+            rig->apply(ControlQueue::Control::Throttle, phase.throttle);
+            rig->run(phase.steps);
+        }
+
+        ASSERT_TRUE(std::isfinite(pruned.engine->getSpeed()));
+        expectClose(pruned.engine->getSpeed(), full.engine->getSpeed(), "crank speed");
+        expectClose(pruned.vehicle->getSpeed(), full.vehicle->getSpeed(), "vehicle speed");
+        expectClose(
+            pruned.simulator->getFilteredDynoTorque(),
+            full.simulator->getFilteredDynoTorque(),
+            "dyno torque");
+
+        EXPECT_EQ(full.simulator->getPrunedConstraintCount(), 0);
+
+        // The drivetrain stays in while coupled or rolling
+        int expected = (phase.dyno ? 0 : 1) + (phase.starter ? 0 : 1);
+        if (phase.gear < 0 && pruned.vehicle->getSpeed() == 0.0) expected += 2;
+        EXPECT_EQ(pruned.simulator->getPrunedConstraintCount(), expected);
+    }
+}
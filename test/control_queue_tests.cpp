@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "../include/control_queue.h"
+
+#include <memory>
+#include <thread>
+
+TEST(ControlQueueTests, EventsComeOutInOrder) {
+    ControlQueue queue;
+    EXPECT_EQ(queue.peek(), nullptr);
+
+    EXPECT_TRUE(queue.push(ControlQueue::Control::Throttle, 0.25));
+    EXPECT_TRUE(queue.push(ControlQueue::Control::Starter, 1.0, true));
+    EXPECT_EQ(queue.size(), 2u);
+
+    const ControlQueue::Event *event = queue.peek();
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ(event->control, ControlQueue::Control::Throttle);
+    EXPECT_EQ(event->value, 0.25);
+    EXPECT_FALSE(event->immediate);
+    queue.pop();
+
+    event = queue.peek();
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ(event->control, ControlQueue::Control::Starter);
+    EXPECT_TRUE(event->immediate);
+    queue.pop();
+
+    EXPECT_EQ(queue.peek(), nullptr);
+}
+
+TEST(ControlQueueTests, FullQueueDropsNewEvents) {
+    std::unique_ptr<ControlQueue> queue(new ControlQueue);
+    for (size_t i = 0; i < ControlQueue::Capacity; ++i) {
+        ASSERT_TRUE(queue->push(ControlQueue::Control::Clutch, static_cast<double>(i)));
+    }
+
+    EXPECT_FALSE(queue->push(ControlQueue::Control::Clutch, -1.0));
+    EXPECT_EQ(queue->getDroppedCount(), 1u);
+    EXPECT_EQ(queue->peek()->value, 0.0);
+
+    queue->pop();
+    EXPECT_TRUE(queue->push(ControlQueue::Control::Clutch, -1.0));
+}
+
+TEST(ControlQueueTests, ConcurrentProducerKeepsOrder) {
+    constexpr int Events = 200000;
+
+    std::unique_ptr<ControlQueue> queue(new ControlQueue);
+    std::thread producer([&queue] {
+        for (int i = 0; i < Events;) {
+            if (queue->push(ControlQueue::Control::Throttle, static_cast<double>(i))) ++i;
+        }
+    });
+
+    int expected = 0;
+    while (expected < Events) {
+        const ControlQueue::Event *event = queue->peek();
+        if (event == nullptr) continue;
+
+        ASSERT_EQ(event->value, static_cast<double>(expected));
+        queue->pop();
+        ++expected;
+    }
+
+    producer.join();
+}
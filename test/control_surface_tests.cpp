@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include "../include/control_surface.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+void appendOscString(std::string *packet, const std::string &s) {
+    *packet += s;
+    packet->append(4 - s.size() % 4, '\0');
+}
+
+void appendBigEndian32(std::string *packet, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) packet->push_back(static_cast<char>((value >> shift) & 0xFF));
+}
+
+std::string oscFloat(const std::string &address, float value) {
+    std::string packet;
+    appendOscString(&packet, address);
+    appendOscString(&packet, ",f");
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendBigEndian32(&packet, bits);
+
+    return packet;
+}
+
+std::vector<ControlSurface::Message> feedMidi(const std::vector<uint8_t> &bytes) {
+    ControlSurface::MidiParser parser;
+    std::vector<ControlSurface::Message> messages;
+
+    ControlSurface::Message message;
+    for (uint8_t byte : bytes) {
+        if (parser.feed(byte, &message)) messages.push_back(message);
+    }
+
+    return messages;
+}
+} /* namespace */
+
+TEST(ControlSurfaceTests, ParsesMidiWithRunningStatus) {
+    // CC 1 then, under running status, CC 1 again with a clock tick in the
+    // middle. SysEx ends running status, so the data bytes after it are
+    // dropped until the next status byte.
+    const std::vector<ControlSurface::Message> messages = feedMidi({
+        0xB2, 0x01, 0x7F,
+        0x01, 0xF8, 0x00,
+        0xF0, 0x7E, 0x01, 0xF7,
+        0x01, 0x40,
+        0x94, 0x24, 0x40
+    });
+
+    ASSERT_EQ(messages.size(), 3u);
+    EXPECT_EQ(messages[0].source, ControlSurface::Source::MidiControlChange);
+    EXPECT_EQ(messages[0].channel, 2);
+    EXPECT_EQ(messages[0].number, 1);
+    EXPECT_DOUBLE_EQ(messages[0].value, 1.0);
+    EXPECT_DOUBLE_EQ(messages[1].value, 0.0);
+
+    EXPECT_EQ(messages[2].source, ControlSurface::Source::MidiNote);
+    EXPECT_EQ(messages[2].channel, 4);
+    EXPECT_EQ(messages[2].number, 36);
+    EXPECT_NEAR(messages[2].value, 64 / 127.0, 1E-12);
+}
+
+TEST(ControlSurfaceTests, ParsesNoteOffAndPitchBend) {
+    const std::vector<ControlSurface::Message> messages = feedMidi({
+        0x90, 0x24, 0x40, 0x24, 0x00,
+        0x80, 0x25, 0x10,
+        0xE0, 0x7F, 0x7F
+    });
+
+    ASSERT_EQ(messages.size(), 4u);
+    EXPECT_DOUBLE_EQ(messages[1].value, 0.0);
+    EXPECT_EQ(messages[2].number, 37);
+    EXPECT_DOUBLE_EQ(messages[2].value, 0.0);
+    EXPECT_EQ(messages[3].source, ControlSurface::Source::MidiPitchBend);
+    EXPECT_DOUBLE_EQ(messages[3].value, 1.0);
+}
+
+TEST(ControlSurfaceTests, ParsesOscMessagesAndBundles) {
+    std::vector<ControlSurface::Message> messages;
+    const std::string throttle = oscFloat("/engine/throttle", 0.5f);
+    ASSERT_TRUE(ControlSurface::ParseOsc(throttle.data(), throttle.size(), &messages));
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0].address, "/engine/throttle");
+    EXPECT_DOUBLE_EQ(messages[0].value, 0.5);
+
+    std::string bundle;
+    appendOscString(&bundle, "#bundle");
+    appendBigEndian32(&bundle, 0);
+    appendBigEndian32(&bundle, 1);
+    for (const std::string &element : { oscFloat("/engine/clutch", 1.0f), oscFloat("/engine/starter", 0.0f) }) {
+        appendBigEndian32(&bundle, static_cast<uint32_t>(element.size()));
+        bundle += element;
+    }
+
+    messages.clear();
+    ASSERT_TRUE(ControlSurface::ParseOsc(bundle.data(), bundle.size(), &messages));
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[1].address, "/engine/starter");
+
+    // Truncated argument
+    messages.clear();
+    EXPECT_FALSE(ControlSurface::ParseOsc(throttle.data(), throttle.size() - 4, &messages));
+}
+
+TEST(ControlSurfaceTests, DispatchMapsBindings) {
+    ControlSurface surface;
+    ControlQueue *queue = surface.getQueue();
+    const ControlQueue::Clock::time_point now = ControlQueue::Clock::now();
+
+    ControlSurface::Message clutch;
+    clutch.source = ControlSurface::Source::MidiControlChange;
+    clutch.number = 2;
+    clutch.value = 0.25;
+
+    // The default clutch pedal is inverted and smoothed
+    EXPECT_FALSE(surface.owns(ControlQueue::Control::Clutch));
+    ASSERT_TRUE(surface.dispatch(clutch, now));
+    const ControlQueue::Event *event = queue->peek();
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ(event->control, ControlQueue::Control::Clutch);
+    EXPECT_DOUBLE_EQ(event->value, 0.75);
+    EXPECT_GT(event->smoothing, 0.0);
+    EXPECT_TRUE(event->time == now);
+    EXPECT_TRUE(surface.owns(ControlQueue::Control::Clutch));
+    queue->pop();
+
+    surface.release(ControlQueue::Control::Clutch);
+    EXPECT_FALSE(surface.owns(ControlQueue::Control::Clutch));
+
+    // Ignition toggles on each press and ignores releases
+    ControlSurface::Message ignition;
+    ignition.source = ControlSurface::Source::MidiNote;
+    ignition.number = 37;
+    for (double value : { 1.0, 0.0, 1.0 }) {
+        ignition.value = value;
+        EXPECT_TRUE(surface.dispatch(ignition, now));
+    }
+
+    ASSERT_EQ(queue->size(), 2u);
+    EXPECT_DOUBLE_EQ(queue->peek()->value, 1.0);
+    queue->pop();
+    EXPECT_DOUBLE_EQ(queue->peek()->value, 0.0);
+    queue->pop();
+
+    ControlSurface::Message unknown;
+    unknown.source = ControlSurface::Source::Osc;
+    unknown.address = "/mixer/fader";
+    EXPECT_FALSE(surface.dispatch(unknown, now));
+    EXPECT_EQ(surface.getStatistics().unmapped, 1u);
+    EXPECT_EQ(surface.getStatistics().messages, 5u);
+}
+
+TEST(ControlSurfaceTests, ReceivesOscOverUdp) {
+    ControlSurface::Parameters params;
+    params.oscPort = 0;
+
+    ControlSurface surface;
+    ASSERT_TRUE(surface.initialize(params));
+    ASSERT_GT(surface.getOscPort(), 0);
+
+#if defined(_WIN32)
+    WSADATA data;
+    ASSERT_EQ(WSAStartup(MAKEWORD(2, 2), &data), 0);
+    const SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#else
+    const int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#endif
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(surface.getOscPort()));
+
+    const std::string packet = oscFloat("/engine/throttle", 0.75f);
+    sendto(s, packet.data(), static_cast<int>(packet.size()), 0, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+
+    const ControlQueue::Event *event = nullptr;
+    for (int i = 0; i < 200 && (event = surface.getQueue()->peek()) == nullptr; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ(event->control, ControlQueue::Control::Throttle);
+    EXPECT_DOUBLE_EQ(event->value, 0.75);
+
+#if defined(_WIN32)
+    closesocket(s);
+    WSACleanup();
+#else
+    close(s);
+#endif
+
+    surface.destroy();
+    EXPECT_FALSE(surface.isRunning());
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include "../include/convolution_batch.h"
+#include "../include/convolution_worker.h"
+#include "../include/random_stream.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+std::vector<float> impulseResponse(int samples) {
+    RandomStream random;
+    random.seed(5, 0);
+
+    std::vector<float> ir(samples);
+    for (int i = 0; i < samples; ++i) {
+        ir[i] = random.uniform(-1.0f, 1.0f) * std::exp(-4.0f * i / samples);
+    }
+
+    return ir;
+}
+
+// Feeds each instance its own noise in uneven blocks and expects exactly
+// what separate copies of the prototype give
+void expectMatchesSeparate(const PartitionedConvolution &prototype, int instances, float activeFraction) {
+    ConvolutionBatch batch;
+    batch.initialize(prototype, instances);
+    batch.setActiveFraction(activeFraction);
+    ASSERT_EQ(batch.getInstanceCount(), instances);
+
+    std::vector<PartitionedConvolution> separate(instances);
+    std::vector<RandomStream> inputs(instances);
+    for (int i = 0; i < instances; ++i) {
+        separate[i].initialize(prototype);
+        separate[i].setActiveFraction(activeFraction);
+        inputs[i].seed(10 + i, 0);
+    }
+
+    const int blockSizes[] = { 1, 63, 64, 200, 1024, 17 };
+    std::vector<std::vector<float>> buffers(instances, std::vector<float>(1024));
+    std::vector<float *> pointers(instances);
+    for (int i = 0; i < instances; ++i) pointers[i] = buffers[i].data();
+
+    int samples = 0;
+    for (int block = 0; samples < 3 * prototype.getSampleCount(); ++block) {
+        const int n = blockSizes[block % 6];
+        std::vector<std::vector<float>> expected(instances, std::vector<float>(n));
+        for (int i = 0; i < instances; ++i) {
+            for (int j = 0; j < n; ++j) {
+                buffers[i][j] = inputs[i].uniform(-1.0f, 1.0f);
+                expected[i][j] = separate[i].f(buffers[i][j]);
+            }
+        }
+
+        // In place
+        batch.process(pointers.data(), pointers.data(), n);
+        for (int i = 0; i < instances; ++i) {
+            for (int j = 0; j < n; ++j) {
+                ASSERT_EQ(buffers[i][j], expected[i][j]);
+            }
+        }
+
+        samples += n;
+    }
+
+    for (PartitionedConvolution &convolution : separate) convolution.destroy();
+    batch.destroy();
+}
+
+} /* namespace */
+
+TEST(ConvolutionBatchTests, MatchesSeparateInstances) {
+    const std::vector<float> ir = impulseResponse(5000);
+
+    PartitionedConvolution prototype;
+    prototype.initialize(ir.data(), 5000, 64, 1024);
+
+    expectMatchesSeparate(prototype, 1, 1.0f);
+    expectMatchesSeparate(prototype, 7, 1.0f);
+    expectMatchesSeparate(prototype, 7, 0.5f);
+
+    prototype.destroy();
+}
+
+TEST(ConvolutionBatchTests, MatchesDeferredTail) {
+    ConvolutionWorker worker;
+    worker.initialize(1 / 240.0);
+
+    const std::vector<float> ir = impulseResponse(5000);
+
+    PartitionedConvolution prototype;
+    prototype.initialize(ir.data(), 5000, 64, 1024, &worker);
+    ASSERT_TRUE(prototype.isTailDeferred());
+
+    expectMatchesSeparate(prototype, 5, 1.0f);
+
+    prototype.destroy();
+    worker.destroy();
+}
+
+TEST(ConvolutionBatchTests, HeadOnlyAndEmpty) {
+    const std::vector<float> ir = impulseResponse(48);
+
+    PartitionedConvolution prototype;
+    prototype.initialize(ir.data(), 48, 64, 64);
+    expectMatchesSeparate(prototype, 3, 1.0f);
+
+    PartitionedConvolution empty;
+    ConvolutionBatch batch;
+    batch.initialize(empty, 4);
+    EXPECT_FALSE(batch.isInitialized());
+    batch.destroy();
+
+    prototype.destroy();
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include "../include/convolution_filter.h"
+#include "../include/convolution_worker.h"
+#include "../include/random_stream.h"
+
+#include <cmath>
+
+namespace {
+
+void setupImpulseResponse(ConvolutionFilter *filter, int samples) {
+    RandomStream random;
+    random.seed(5, 0);
+
+    filter->initialize(samples);
+    for (int i = 0; i < samples; ++i) {
+        filter->getImpulseResponse()[i] =
+            random.uniform(-1.0f, 1.0f) * std::exp(-4.0f * i / samples);
+    }
+}
+
+void expectMatchesDirect(int samples, int headSize, int tailSize) {
+    ConvolutionFilter direct, partitioned;
+    setupImpulseResponse(&direct, samples);
+    setupImpulseResponse(&partitioned, samples);
+    partitioned.preparePartitioned(headSize, tailSize);
+
+    EXPECT_EQ(partitioned.isPartitioned(), true);
+
+    RandomStream input;
+    input.seed(6, 0);
+
+    for (int i = 0; i < 3 * samples + 17; ++i) {
+        const float x = input.uniform(-1.0f, 1.0f);
+        const float expected = direct.f(x);
+        EXPECT_NEAR(partitioned.f(x), expected, 1E-3f * (1 + std::abs(expected)));
+    }
+
+    direct.destroy();
+    partitioned.destroy();
+}
+
+} /* namespace */
+
+TEST(ConvolutionFilterTests, PartitionedHeadOnly) {
+    expectMatchesDirect(40, 64, 1024);
+}
+
+TEST(ConvolutionFilterTests, PartitionedUniform) {
+    expectMatchesDirect(1000, 64, 64);
+}
+
+TEST(ConvolutionFilterTests, PartitionedNonUniform) {
+    expectMatchesDirect(5000, 64, 1024);
+}
+
+TEST(ConvolutionFilterTests, PartitionedFromPrototype) {
+    ConvolutionFilter prototype, reference, copy;
+    setupImpulseResponse(&prototype, 5000);
+    setupImpulseResponse(&reference, 5000);
+    prototype.preparePartitioned();
+    reference.preparePartitioned();
+
+    // Running the prototype first shows the copy starts from empty history
+    for (int i = 0; i < 100; ++i) prototype.f(1.0f);
+    copy.initialize(prototype, true);
+
+    EXPECT_EQ(copy.isPartitioned(), true);
+    EXPECT_EQ(copy.getSampleCount(), 5000);
+
+    ConvolutionFilter direct;
+    direct.initialize(prototype, false);
+    EXPECT_EQ(direct.isPartitioned(), false);
+    EXPECT_EQ(direct.getImpulseResponse(), prototype.getImpulseResponse());
+
+    // The taps and spectra are shared and outlive the prototype
+    prototype.destroy();
+
+    RandomStream input;
+    input.seed(7, 0);
+
+    for (int i = 0; i < 3 * 5000; ++i) {
+        const float x = input.uniform(-1.0f, 1.0f);
+        EXPECT_EQ(copy.f(x), reference.f(x));
+    }
+
+    reference.destroy();
+    copy.destroy();
+    direct.destroy();
+}
+
+TEST(ConvolutionFilterTests, PartitionedDeferredTail) {
+    constexpr int Taps = 20000;
+
+    ConvolutionWorker worker;
+    worker.initialize(1 / 240.0);
+
+    ConvolutionFilter direct, deferred;
+    setupImpulseResponse(&direct, Taps);
+    setupImpulseResponse(&deferred, Taps);
+    deferred.preparePartitioned(64, 1024, &worker);
+
+    // The same layout run without the worker gives the same result
+    PartitionedConvolution local;
+    PartitionedConvolution prototype;
+    prototype.initialize(deferred.getImpulseResponse(), Taps, 64, 1024, &worker);
+    local.initialize(prototype);
+    EXPECT_TRUE(local.isTailDeferred());
+
+    RandomStream input;
+    input.seed(8, 0);
+
+    float buffer[256];
+    for (int n = 0; n < 2 * Taps / 256; ++n) {
+        float expected[256], unthreaded[256];
+        for (int i = 0; i < 256; ++i) {
+            buffer[i] = input.uniform(-1.0f, 1.0f);
+            expected[i] = direct.f(buffer[i]);
+            unthreaded[i] = local.f(buffer[i]);
+        }
+
+        deferred.f_block(buffer, buffer, 256);
+        for (int i = 0; i < 256; ++i) {
+            ASSERT_NEAR(buffer[i], expected[i], 1E-3f * (1 + std::abs(expected[i])));
+            ASSERT_EQ(buffer[i], unthreaded[i]);
+        }
+    }
+
+    // A copy for no worker is laid out again rather than deferred
+    ConvolutionFilter copy;
+    copy.initialize(deferred, true);
+    EXPECT_TRUE(copy.isPartitioned());
+    EXPECT_TRUE(deferred.isTailDeferred());
+    EXPECT_FALSE(copy.isTailDeferred());
+
+    direct.destroy();
+    deferred.destroy();
+    copy.destroy();
+    local.destroy();
+    prototype.destroy();
+    worker.destroy();
+}
+
+TEST(ConvolutionFilterTests, BlockMatchesScalar) {
+    for (int samples : { 1, 7, 300 }) {
+        ConvolutionFilter scalar, block;
+        setupImpulseResponse(&scalar, samples);
+        setupImpulseResponse(&block, samples);
+
+        RandomStream input;
+        input.seed(7, 0);
+
+        float buffer[128];
+        for (int n = 0; n < 8; ++n) {
+            float expected[128];
+            for (int i = 0; i < 128; ++i) {
+                buffer[i] = input.uniform(-1.0f, 1.0f);
+                expected[i] = scalar.f(buffer[i]);
+            }
+
+            block.f_block(buffer, buffer, 128);
+            for (int i = 0; i < 128; ++i) {
+                EXPECT_EQ(buffer[i], expected[i]);
+            }
+        }
+
+        scalar.destroy();
+        block.destroy();
+    }
+}
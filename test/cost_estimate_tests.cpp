@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "../include/cost_estimate.h"
+
+#include <cstring>
+
+namespace {
+CostEstimate::Inputs v8() {
+    CostEstimate::Inputs inputs;
+    inputs.simulationFrequency = 10000;
+    inputs.fluidSteps = 8;
+    inputs.cylinders = 8;
+    inputs.pipes = 4;
+    inputs.audioSampleRate = 44100;
+    inputs.channels = 2;
+    inputs.impulseResponseTaps = { 4000 };
+
+    return inputs;
+}
+} /* namespace */
+
+TEST(CostEstimateTests, LoadFollowsSettings) {
+    const CostEstimate::Coefficients coefficients;
+    const CostEstimate::Report base = CostEstimate::Estimate(v8(), coefficients);
+    EXPECT_GT(base.physicsLoad, 0.0);
+    EXPECT_GT(base.fluidLoad, 0.0);
+    EXPECT_GT(base.convolutionLoad, 0.0);
+    EXPECT_DOUBLE_EQ(base.physicsThreadLoad, base.physicsLoad + base.fluidLoad);
+
+    CostEstimate::Inputs inputs = v8();
+    inputs.simulationFrequency *= 2;
+    const CostEstimate::Report doubled = CostEstimate::Estimate(inputs, coefficients);
+    EXPECT_NEAR(doubled.physicsThreadLoad, 2 * base.physicsThreadLoad, 1E-12);
+    EXPECT_DOUBLE_EQ(doubled.audioThreadLoad, base.audioThreadLoad);
+
+    inputs = v8();
+    inputs.fluidThreads = 2;
+    EXPECT_NEAR(CostEstimate::Estimate(inputs, coefficients).fluidLoad, base.fluidLoad / 2, 1E-12);
+
+    // Direct convolution of a long response costs more than partitioned
+    inputs = v8();
+    inputs.impulseResponseTaps = { 40000 };
+    inputs.partitionedConvolution = false;
+    const double direct = CostEstimate::Estimate(inputs, coefficients).convolutionLoad;
+    inputs.partitionedConvolution = true;
+    EXPECT_GT(direct, CostEstimate::Estimate(inputs, coefficients).convolutionLoad);
+}
+
+TEST(CostEstimateTests, FlagsTheDominantSetting) {
+    CostEstimate::Inputs inputs = v8();
+    inputs.fluidSteps = 64;
+
+    const CostEstimate::Report report = CostEstimate::Estimate(inputs, CostEstimate::Coefficients(), 0.7);
+    ASSERT_EQ(report.terms.size(), 4);
+    EXPECT_STREQ(report.terms.front().setting, "fluid_simulation_steps");
+    for (size_t i = 1; i < report.terms.size(); ++i) {
+        EXPECT_GE(report.terms[i - 1].load, report.terms[i].load);
+    }
+
+    EXPECT_FALSE(report.sustainable);
+    EXPECT_NE(CostEstimate::Describe(report).find("fluid"), std::string::npos);
+
+    inputs = v8();
+    inputs.simulationFrequency = 2000;
+    inputs.fluidSteps = 1;
+    EXPECT_TRUE(CostEstimate::Estimate(inputs, CostEstimate::Coefficients(), 0.7).sustainable);
+}
+
+TEST(CostEstimateTests, FitReproducesTheMeasurement) {
+    FidelityCalibration::Measurement measurement;
+    measurement.fixedMicroseconds = 20.0;
+    measurement.substepMicroseconds = 5.0;
+    measurement.directConvolutionMicroseconds = 4.0;
+    measurement.partitionedConvolutionMicroseconds = 0.5;
+
+    CostEstimate::Inputs inputs = v8();
+    inputs.fluidSteps = 10;
+    inputs.partitionedConvolution = false;
+
+    const CostEstimate::Coefficients fitted = CostEstimate::Fit(measurement, inputs);
+    const CostEstimate::Report report = CostEstimate::Estimate(inputs, fitted);
+    EXPECT_NEAR(report.physicsLoad, 1E-6 * 10000 * 20.0, 1E-9);
+    EXPECT_NEAR(report.fluidLoad, 1E-6 * 10000 * 10 * 5.0, 1E-9);
+    EXPECT_NEAR(report.convolutionLoad, 1E-6 * 44100 * 4.0, 1E-9);
+
+    inputs.partitionedConvolution = true;
+    EXPECT_NEAR(CostEstimate::Estimate(inputs, fitted).convolutionLoad, 1E-6 * 44100 * 0.5, 1E-9);
+}
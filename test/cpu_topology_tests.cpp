@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include "../include/cpu_topology.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+void writeFile(const std::filesystem::path &path, const std::string &contents) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path);
+    file << contents << "\n";
+}
+
+// Two sockets, each one node of four CPUs; pairs of CPUs share an L2 and
+// each socket shares an L3
+std::filesystem::path dualSocket() {
+    const std::filesystem::path root =
+        std::filesystem::path(testing::TempDir()) / "cpu_topology_tests";
+    std::filesystem::remove_all(root);
+
+    writeFile(root / "cpu" / "online", "0-7");
+    writeFile(root / "node" / "node0" / "cpulist", "0-3");
+    writeFile(root / "node" / "node1" / "cpulist", "4-7");
+
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        const std::filesystem::path directory = root / "cpu" / ("cpu" + std::to_string(cpu));
+        const int pair = cpu & ~1;
+        const int socket = cpu & ~3;
+
+        writeFile(directory / "topology" / "physical_package_id", std::to_string(cpu / 4));
+        writeFile(directory / "cache" / "index0" / "level", "1");
+        writeFile(directory / "cache" / "index0" / "type", "Data");
+        writeFile(directory / "cache" / "index0" / "shared_cpu_list", std::to_string(cpu));
+        writeFile(directory / "cache" / "index1" / "level", "2");
+        writeFile(directory / "cache" / "index1" / "type", "Unified");
+        writeFile(
+            directory / "cache" / "index1" / "shared_cpu_list",
+            std::to_string(pair) + "-" + std::to_string(pair + 1));
+        writeFile(directory / "cache" / "index2" / "level", "3");
+        writeFile(directory / "cache" / "index2" / "type", "Unified");
+        writeFile(
+            directory / "cache" / "index2" / "shared_cpu_list",
+            std::to_string(socket) + "-" + std::to_string(socket + 3));
+    }
+
+    return root;
+}
+} /* namespace */
+
+TEST(CpuTopologyTests, ParseCpuList) {
+    std::vector<int> cpus;
+    EXPECT_TRUE(CpuTopology::ParseCpuList("0-3,8,10-11\n", &cpus));
+    EXPECT_EQ(cpus, std::vector<int>({ 0, 1, 2, 3, 8, 10, 11 }));
+    EXPECT_EQ(CpuTopology::FormatCpuList(cpus), "0-3,8,10-11");
+
+    EXPECT_TRUE(CpuTopology::ParseCpuList("", &cpus));
+    EXPECT_TRUE(cpus.empty());
+
+    EXPECT_FALSE(CpuTopology::ParseCpuList("3-1", &cpus));
+    EXPECT_FALSE(CpuTopology::ParseCpuList("0,x", &cpus));
+}
+
+TEST(CpuTopologyTests, DetectFromSysfs) {
+    const std::filesystem::path root = dualSocket();
+
+    CpuTopology topology;
+    ASSERT_TRUE(topology.detectFromSysfs(root.string()));
+    ASSERT_EQ(topology.getCpuCount(), 8);
+    EXPECT_EQ(topology.getNodeCount(), 2);
+    EXPECT_EQ(topology.getL2GroupCount(), 4);
+
+    const CpuTopology::Cpu &cpu = topology.getCpus()[5];
+    EXPECT_EQ(cpu.node, 1);
+    EXPECT_EQ(cpu.package, 1);
+    EXPECT_EQ(cpu.l2, 4);
+    EXPECT_EQ(cpu.l3, 4);
+
+    EXPECT_FALSE(topology.detectFromSysfs((root / "missing").string()));
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(CpuTopologyTests, PlacementKeepsInstancesOnOneNodeAndCache) {
+    const std::filesystem::path root = dualSocket();
+
+    CpuTopology topology;
+    ASSERT_TRUE(topology.detectFromSysfs(root.string()));
+
+    // Alternating nodes, each instance on one L2 pair
+    std::vector<CpuTopology::Placement> placements = topology.place(4, 2);
+    ASSERT_EQ(placements.size(), 4u);
+    EXPECT_EQ(placements[0].node, 0);
+    EXPECT_EQ(placements[0].cpus, std::vector<int>({ 0, 1 }));
+    EXPECT_EQ(placements[1].node, 1);
+    EXPECT_EQ(placements[1].cpus, std::vector<int>({ 4, 5 }));
+    EXPECT_EQ(placements[2].cpus, std::vector<int>({ 2, 3 }));
+    EXPECT_EQ(placements[3].cpus, std::vector<int>({ 6, 7 }));
+
+    // Wider instances take whole pairs; more than fit wrap around
+    placements = topology.place(3, 3);
+    EXPECT_EQ(placements[0].cpus, std::vector<int>({ 0, 1, 2, 3 }));
+    EXPECT_EQ(placements[1].cpus, std::vector<int>({ 4, 5, 6, 7 }));
+    EXPECT_EQ(placements[2].node, 0);
+    EXPECT_EQ(placements[2].cpus, std::vector<int>({ 0, 1, 2, 3 }));
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(CpuTopologyTests, UniformFallback) {
+    CpuTopology topology;
+    topology.initializeUniform(4);
+    EXPECT_EQ(topology.getNodeCount(), 1);
+    EXPECT_EQ(topology.getL2GroupCount(), 4);
+
+    const std::vector<CpuTopology::Placement> placements = topology.place(2, 2);
+    EXPECT_EQ(placements[0].cpus, std::vector<int>({ 0, 1 }));
+    EXPECT_EQ(placements[1].cpus, std::vector<int>({ 2, 3 }));
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "../include/crank_bearing_constraint.h"
+
+#include "../include/crankshaft.h"
+#include "test_engine.h"
+
+#include <cfloat>
+
+namespace {
+
+// The output rows are filled over garbage to show every entry is written
+atg_scs::Constraint::Output calculate(CrankBearingConstraint *bearing, atg_scs::SystemState *state) {
+    atg_scs::Constraint::Output output;
+    double *raw = reinterpret_cast<double *>(&output);
+    for (size_t i = 0; i < sizeof(output) / sizeof(double); ++i) raw[i] = 1E30;
+
+    bearing->calculate(&output, state);
+    return output;
+}
+
+} /* namespace */
+
+TEST(CrankBearingConstraintTests, RowsAreConstantOverCrankAngle) {
+    Engine *engine = test_engine::buildEngine();
+    Vehicle *vehicle = test_engine::buildVehicle();
+    Transmission *transmission = test_engine::buildTransmission();
+    Crankshaft *crankshaft = engine->getCrankshaft(0);
+
+    CrankBearingConstraint bearing;
+    bearing.m_ks = 5000.0;
+    bearing.m_kd = 10.0;
+    bearing.connect(crankshaft);
+
+    // The crankshaft is body 1 of the state
+    double p_x[2] = { 0.0, 0.0 }, p_y[2] = { 0.0, 0.0 }, theta[2] = { 0.0, 0.0 };
+    double v_x[2] = { 0.0, 0.0 }, v_y[2] = { 0.0, 0.0 }, v_theta[2] = { 0.0, 0.0 };
+    atg_scs::SystemState state;
+    state.p_x = p_x;
+    state.p_y = p_y;
+    state.theta = theta;
+    state.v_x = v_x;
+    state.v_y = v_y;
+    state.v_theta = v_theta;
+    crankshaft->m_body.index = 1;
+
+    const double angles[] = { 0.0, 0.7, -2.1, 3.0, 40.0 };
+    for (const double angle : angles) {
+        p_x[1] = crankshaft->getPosX() + 1E-4;
+        p_y[1] = crankshaft->getPosY() - 3E-5;
+        theta[1] = angle;
+        v_theta[1] = -500.0;
+
+        const atg_scs::Constraint::Output output = calculate(&bearing, &state);
+        SCOPED_TRACE(::testing::Message() << "angle " << angle);
+
+        EXPECT_NEAR(output.C[0], 1E-4, 1E-15);
+        EXPECT_NEAR(output.C[1], -3E-5, 1E-15);
+
+        for (int row = 0; row < 2; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                EXPECT_EQ(output.J[row][col], (row == col) ? 1.0 : 0.0) << row << ", " << col;
+                EXPECT_EQ(output.J_dot[row][col], 0.0) << row << ", " << col;
+            }
+
+            EXPECT_EQ(output.ks[row], 5000.0);
+            EXPECT_EQ(output.kd[row], 10.0);
+            EXPECT_EQ(output.v_bias[row], 0.0);
+            EXPECT_EQ(output.limits[row][0], -DBL_MAX);
+            EXPECT_EQ(output.limits[row][1], DBL_MAX);
+        }
+    }
+
+    test_engine::release(engine, vehicle, transmission);
+}
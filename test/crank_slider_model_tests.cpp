@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+
+#include "../include/connecting_rod.h"
+#include "../include/constants.h"
+#include "../include/crank_slider_model.h"
+#include "../include/crankshaft.h"
+#include "../include/cylinder_bank.h"
+#include "../include/cylinder_constraint_batch.h"
+#include "../include/piston.h"
+#include "../include/units.h"
+
+#include <cmath>
+
+namespace {
+
+// Exposes the pose of one cylinder without an engine around it
+class TestCrankSliderModel : public CrankSliderModel {
+    public:
+        void addCylinder(Piston *piston, Crankshaft *crankshaft) {
+            m_cylinders = new Cylinder[1];
+            m_cylinderCount = 1;
+
+            Cylinder &cylinder = m_cylinders[0];
+            cylinder.piston = piston;
+            cylinder.rod = piston->getRod();
+            cylinder.crankshaft = crankshaft;
+            crankshaft->getRodJournalPositionLocal(
+                cylinder.rod->getJournal(),
+                &cylinder.journal_x,
+                &cylinder.journal_y);
+        }
+
+        // Poses the bodies at crank angle theta and speed omega; returns
+        // the piston travel per unit crank speed
+        double pose(double theta, double omega) {
+            Crankshaft *crankshaft = m_cylinders[0].crankshaft;
+            crankshaft->m_body.theta = theta;
+            crankshaft->m_body.v_theta = omega;
+
+            Pose pose;
+            EXPECT_TRUE(solve(
+                m_cylinders[0],
+                theta,
+                crankshaft->m_body.p_x,
+                crankshaft->m_body.p_y,
+                &pose));
+            applyPose(m_cylinders[0], pose, omega);
+
+            return pose.ds;
+        }
+};
+
+// One cylinder of a V, with the crankshaft as body 0, the piston 1 and the
+// rod 2, and the full model's link and wall constraints set up the way
+// PistonEngineSimulator does
+struct Rig {
+    static constexpr int Bodies = 3;
+
+    Crankshaft crankshaft;
+    CylinderBank bank;
+    ConnectingRod rod;
+    Piston piston;
+    TestCrankSliderModel model;
+    CylinderConstraintBatch constraints;
+
+    double p_x[Bodies], p_y[Bodies], theta[Bodies];
+    double v_x[Bodies], v_y[Bodies], v_theta[Bodies];
+    atg_scs::SystemState state;
+
+    Rig() {
+        Crankshaft::Parameters crankParams;
+        crankParams.mass = units::mass(30, units::kg);
+        crankParams.flywheelMass = units::mass(10, units::kg);
+        crankParams.momentOfInertia = 0.2;
+        crankParams.crankThrow = units::distance(1.8, units::inch);
+        crankParams.rodJournals = 1;
+        crankshaft.initialize(crankParams);
+        crankshaft.setRodJournalAngle(0, units::angle(20, units::deg));
+
+        CylinderBank::Parameters bankParams;
+        bankParams.crankshaft = &crankshaft;
+        bankParams.positionX = 0.0;
+        bankParams.positionY = 0.0;
+        bankParams.angle = units::angle(45, units::deg);
+        bankParams.bore = units::distance(4.0, units::inch);
+        bankParams.deckHeight = units::distance(9.0, units::inch);
+        bankParams.displayDepth = 0.4;
+        bankParams.cylinderCount = 4;
+        bankParams.index = 0;
+        bank.initialize(bankParams);
+
+        ConnectingRod::Parameters rodParams;
+        rodParams.mass = units::mass(600, units::g);
+        rodParams.momentOfInertia = 0.0015;
+        rodParams.centerOfMass = units::distance(-1.0, units::inch);
+        rodParams.length = units::distance(6.0, units::inch);
+        rodParams.piston = &piston;
+        rodParams.crankshaft = &crankshaft;
+        rodParams.journal = 0;
+        rod.initialize(rodParams);
+
+        Piston::Parameters pistonParams;
+        pistonParams.Rod = &rod;
+        pistonParams.Bank = &bank;
+        pistonParams.CylinderIndex = 0;
+        pistonParams.BlowbyFlowCoefficient = 0.0;
+        pistonParams.CompressionHeight = units::distance(1.2, units::inch);
+        pistonParams.WristPinPosition = units::distance(0.1, units::inch);
+        pistonParams.Displacement = 0.0;
+        pistonParams.mass = units::mass(500, units::g);
+        piston.initialize(pistonParams);
+
+        crankshaft.m_body.p_x = crankshaft.getPosX();
+        crankshaft.m_body.p_y = crankshaft.getPosY();
+        crankshaft.m_body.index = 0;
+        piston.m_body.index = 1;
+        rod.m_body.index = 2;
+
+        model.addCylinder(&piston, &crankshaft);
+
+        double journal_x, journal_y;
+        crankshaft.getRodJournalPositionLocal(0, &journal_x, &journal_y);
+        constraints.initialize(1);
+        constraints.setStiffness(5000, 10);
+        constraints.setWall(0, bank.getDx(), bank.getDy(), bank.getX(), bank.getY());
+        constraints.setLittleEnd(
+            0, &rod.m_body, &piston.m_body, rod.getLittleEndLocal(), piston.getWristPinLocation());
+        constraints.setBigEnd(0, &crankshaft.m_body, rod.getBigEndLocal(), journal_x, journal_y);
+
+        state.p_x = p_x;
+        state.p_y = p_y;
+        state.theta = theta;
+        state.v_x = v_x;
+        state.v_y = v_y;
+        state.v_theta = v_theta;
+    }
+
+    ~Rig() {
+        constraints.destroy();
+        model.destroy();
+        crankshaft.destroy();
+    }
+
+    double pose(double angle, double omega) {
+        const double ds = model.pose(angle, omega);
+
+        const atg_scs::RigidBody *bodies[] = { &crankshaft.m_body, &piston.m_body, &rod.m_body };
+        for (int i = 0; i < Bodies; ++i) {
+            p_x[i] = bodies[i]->p_x;
+            p_y[i] = bodies[i]->p_y;
+            theta[i] = bodies[i]->theta;
+            v_x[i] = bodies[i]->v_x;
+            v_y[i] = bodies[i]->v_y;
+            v_theta[i] = bodies[i]->v_theta;
+        }
+
+        return ds;
+    }
+
+    // World position of a point on the rod's axis
+    void rodPoint(double local_y, double *x, double *y) const {
+        *x = rod.m_body.p_x - std::sin(rod.m_body.theta) * local_y;
+        *y = rod.m_body.p_y + std::cos(rod.m_body.theta) * local_y;
+    }
+
+    // Position error and velocity error J * v of one constraint row
+    void evaluate(atg_scs::Constraint *constraint, int bodies, int row, double *C, double *C_dot) {
+        atg_scs::Constraint::Output output;
+        constraint->calculate(&output, &state);
+
+        *C = output.C[row];
+        *C_dot = 0.0;
+        for (int b = 0; b < bodies; ++b) {
+            const int index = constraint->m_bodies[b]->index;
+            *C_dot += output.J[row][3 * b + 0] * v_x[index];
+            *C_dot += output.J[row][3 * b + 1] * v_y[index];
+            *C_dot += output.J[row][3 * b + 2] * v_theta[index];
+        }
+    }
+};
+
+} /* namespace */
+
+TEST(CrankSliderModelTests, PoseSatisfiesConstraintModel) {
+    constexpr double omega = -units::rpm(4000);
+
+    Rig rig;
+    for (int i = 0; i < 72; ++i) {
+        rig.pose(2 * constants::pi * i / 72, omega);
+
+        // The little end refreshes the batch for the other two
+        struct {
+            atg_scs::Constraint *constraint;
+            int bodies;
+            int rows;
+        } cases[] = {
+            { rig.constraints.getLittleEnd(0), 2, 2 },
+            { rig.constraints.getBigEnd(0), 2, 2 },
+            { rig.constraints.getWall(0), 1, 1 }
+        };
+
+        for (const auto &c : cases) {
+            for (int r = 0; r < c.rows; ++r) {
+                double C, C_dot;
+                rig.evaluate(c.constraint, c.bodies, r, &C, &C_dot);
+                EXPECT_NEAR(C, 0.0, 1E-12);
+                EXPECT_NEAR(C_dot, 0.0, 1E-9 * std::abs(omega));
+            }
+        }
+    }
+}
+
+TEST(CrankSliderModelTests, VelocityMatchesPosition) {
+    constexpr double h = 1E-6;
+    constexpr double omega = 1.0;
+
+    Rig rig;
+    for (int i = 0; i < 36; ++i) {
+        const double angle = 2 * constants::pi * i / 36;
+
+        rig.pose(angle + h, omega);
+        const double ahead[] = { rig.p_x[1], rig.p_y[1], rig.p_x[2], rig.p_y[2], rig.theta[2] };
+        rig.pose(angle - h, omega);
+        const double behind[] = { rig.p_x[1], rig.p_y[1], rig.p_x[2], rig.p_y[2], rig.theta[2] };
+
+        const double ds = rig.pose(angle, omega);
+        const double velocity[] = { rig.v_x[1], rig.v_y[1], rig.v_x[2], rig.v_y[2], rig.v_theta[2] };
+        for (int k = 0; k < 5; ++k) {
+            EXPECT_NEAR(velocity[k], (ahead[k] - behind[k]) / (2 * h), 1E-7);
+        }
+
+        // The piston only moves along the bore
+        EXPECT_NEAR(rig.v_x[1], ds * rig.bank.getDx(), 1E-12);
+        EXPECT_NEAR(rig.v_y[1], ds * rig.bank.getDy(), 1E-12);
+    }
+}
+
+TEST(CrankSliderModelTests, TorqueMatchesConstraintForces) {
+    constexpr double F = 10000.0;
+
+    Rig rig;
+    for (int i = 0; i < 72; ++i) {
+        const double angle = 2 * constants::pi * i / 72;
+        const double ds = rig.pose(angle, 1.0);
+
+        // Quasi-static full model: the rod carries a force along itself that
+        // cancels the gas force along the bore, the wall takes the rest, and
+        // the crank feels the rod force at the pin
+        double pin_x, pin_y, wrist_x, wrist_y;
+        rig.rodPoint(rig.rod.getBigEndLocal(), &pin_x, &pin_y);
+        rig.rodPoint(rig.rod.getLittleEndLocal(), &wrist_x, &wrist_y);
+
+        const double length = std::sqrt(
+            (wrist_x - pin_x) * (wrist_x - pin_x) + (wrist_y - pin_y) * (wrist_y - pin_y));
+        const double u_x = (wrist_x - pin_x) / length;
+        const double u_y = (wrist_y - pin_y) / length;
+        const double rodForce = -F / (u_x * rig.bank.getDx() + u_y * rig.bank.getDy());
+
+        const double r_x = pin_x - rig.crankshaft.m_body.p_x;
+        const double r_y = pin_y - rig.crankshaft.m_body.p_y;
+        const double torque = r_x * (-rodForce * u_y) - r_y * (-rodForce * u_x);
+
+        // CrankSliderModel::apply() applies the gas force as F * ds
+        EXPECT_NEAR(F * ds, torque, 1E-9 * F);
+    }
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include "../include/crankshaft_link_constraint.h"
+
+#include "../include/constants.h"
+#include "../include/control_queue.h"
+#include "../include/crankshaft.h"
+#include "../include/simulator.h"
+#include "test_engine.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+// Two crankshafts of a state whose arrays hold only their angles and speeds
+struct Shafts {
+    double p_x[2] = { 0.0, 0.0 }, p_y[2] = { 0.0, 0.0 }, theta[2] = { 0.0, 0.0 };
+    double v_x[2] = { 0.0, 0.0 }, v_y[2] = { 0.0, 0.0 }, v_theta[2] = { 0.0, 0.0 };
+    atg_scs::SystemState state;
+
+    Shafts(Crankshaft *output, Crankshaft *geared) {
+        state.p_x = p_x;
+        state.p_y = p_y;
+        state.theta = theta;
+        state.v_x = v_x;
+        state.v_y = v_y;
+        state.v_theta = v_theta;
+        output->m_body.index = 0;
+        geared->m_body.index = 1;
+    }
+};
+
+void apply(Simulator *simulator, ControlQueue::Control control, double value) {
+    ControlQueue::Event event;
+    event.control = control;
+    event.value = value;
+    event.immediate = true;
+    simulator->applyControl(event);
+}
+
+} /* namespace */
+
+TEST(CrankshaftLinkConstraintTests, HoldsAngleAtConnect) {
+    Engine *engine = test_engine::buildEngine(false, 2);
+    Vehicle *vehicle = test_engine::buildVehicle();
+    Transmission *transmission = test_engine::buildTransmission();
+    Crankshaft *output = engine->getCrankshaft(0);
+    Crankshaft *geared = engine->getCrankshaft(1);
+
+    // Geared a third of a turn ahead
+    const double phase = 2 * constants::pi / 3;
+    output->m_body.theta = 0.4;
+    geared->m_body.theta = 0.4 + phase;
+
+    CrankshaftLinkConstraint link;
+    link.m_ks = 5000.0;
+    link.m_kd = 10.0;
+    link.connect(output, geared);
+
+    Shafts shafts(output, geared);
+    const double angles[] = { 0.0, 0.4, -3.0, 12.5, 4 * constants::pi - 1E-3 };
+    for (const double angle : angles) {
+        SCOPED_TRACE(::testing::Message() << "angle " << angle);
+
+        atg_scs::Constraint::Output result;
+        shafts.theta[0] = angle;
+        shafts.theta[1] = angle + phase;
+        link.calculate(&result, &shafts.state);
+        EXPECT_NEAR(result.C[0], 0.0, 1E-12);
+
+        // The error is the geared shaft's lead over the phase, and turns
+        // each shaft back towards it
+        shafts.theta[1] = angle + phase + 0.01;
+        link.calculate(&result, &shafts.state);
+        EXPECT_NEAR(result.C[0], 0.01, 1E-12);
+
+        shafts.theta[0] = angle + 0.01;
+        shafts.theta[1] = angle + phase;
+        link.calculate(&result, &shafts.state);
+        EXPECT_NEAR(result.C[0], -0.01, 1E-12);
+
+        const double J[6] = { 0.0, 0.0, -1.0, 0.0, 0.0, 1.0 };
+        for (int col = 0; col < 6; ++col) {
+            EXPECT_EQ(result.J[0][col], J[col]) << col;
+            EXPECT_EQ(result.J_dot[0][col], 0.0) << col;
+        }
+
+        EXPECT_EQ(result.ks[0], 5000.0);
+        EXPECT_EQ(result.kd[0], 10.0);
+        EXPECT_EQ(result.v_bias[0], 0.0);
+        EXPECT_EQ(result.limits[0][0], -DBL_MAX);
+        EXPECT_EQ(result.limits[0][1], DBL_MAX);
+    }
+
+    test_engine::release(engine, vehicle, transmission);
+}
+
+TEST(CrankshaftLinkConstraintTests, TwoCranksStayInPhase) {
+    Engine *engine = test_engine::buildEngine(false, 2);
+    Vehicle *vehicle = test_engine::buildVehicle();
+    Transmission *transmission = test_engine::buildTransmission();
+    Simulator *simulator = engine->createSimulator(vehicle, transmission, false, false);
+    simulator->setSimulationFrequency(10000);
+    simulator->setOfflineMode(true);
+
+    Crankshaft *output = engine->getOutputCrankshaft();
+    Crankshaft *geared = engine->getCrankshaft(1);
+    ASSERT_EQ(output, engine->getCrankshaft(0));
+
+    // Linked at the same angle, both just past a whole cycle so the first
+    // step wraps them
+    output->m_body.theta = geared->m_body.theta = 4 * constants::pi + 0.25;
+
+    apply(simulator, ControlQueue::Control::Ignition, 1.0);
+    apply(simulator, ControlQueue::Control::Throttle, 0.6);
+    apply(simulator, ControlQueue::Control::DynoEnabled, 1.0);
+    apply(simulator, ControlQueue::Control::DynoHold, 1.0);
+    apply(simulator, ControlQueue::Control::DynoSpeed, units::rpm(2000));
+
+    // 0.2 s, a few cycles at the dyno speed
+    double maxError = 0.0;
+    for (int frame = 0; frame < 10; ++frame) {
+        simulator->startFrameSteps(200);
+        while (simulator->simulateStep()) {
+            maxError = std::fmax(maxError, std::abs(geared->m_body.theta - output->m_body.theta));
+        }
+
+        simulator->endFrame();
+
+        ASSERT_TRUE(std::isfinite(output->m_body.theta));
+        EXPECT_LT(output->m_body.theta, 4 * constants::pi + 0.25) << "frame " << frame;
+        EXPECT_NEAR(
+            geared->m_body.v_theta,
+            output->m_body.v_theta,
+            0.05 * std::fmax(1.0, std::abs(output->m_body.v_theta))) << "frame " << frame;
+    }
+
+    EXPECT_LT(maxError, 1E-3);
+
+    simulator->releaseSimulation();
+    delete simulator;
+    test_engine::release(engine, vehicle, transmission);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "../include/cycle_audio_cache.h"
+#include "../include/constants.h"
+
+#include <cmath>
+
+namespace {
+constexpr int Period = 300;
+
+// An engine holding steady: every cycle is Period steps and the synthesizer
+// input is exactly periodic
+class SteadyEngine {
+    public:
+        double signal(long long step) const {
+            return std::sin(2 * constants::pi * 3 * step / Period) + 0.25 * std::sin(2 * constants::pi * step / Period);
+        }
+
+        // Steps the statistics and returns whether the step began a cycle
+        bool step(CycleStatistics *statistics) {
+            const int phase = static_cast<int>(m_step % Period);
+            const double angle = 4 * constants::pi * phase / Period;
+
+            double values[CycleStatistics::ChannelCount] = {};
+            values[static_cast<int>(CycleStatistics::Channel::CylinderVolume)] = 1E-4 * (1 - std::cos(angle));
+            statistics->addSample(angle, 1, values);
+
+            return statistics->isCycleStart();
+        }
+
+        long long m_step = 0;
+};
+} /* namespace */
+
+TEST(CycleAudioCacheTests, CapturesAfterSteadyCyclesAndReplaysInPhase) {
+    CycleAudioCache::Parameters params;
+    params.steadyCycles = 3;
+    params.captureCycles = 2;
+    params.crossfadeFrames = 32;
+    params.gainJitter = 0.02;
+
+    CycleAudioCache cache;
+    cache.initialize(params, 1);
+
+    CycleStatistics statistics;
+    SteadyEngine engine;
+    while (!cache.isReplaying()) {
+        ASSERT_LT(engine.m_step, 20 * Period);
+
+        const bool cycleStart = engine.step(&statistics);
+        double frame = engine.signal(engine.m_step);
+        cache.processLiveFrame(&frame, cycleStart, statistics);
+        ASSERT_EQ(frame, engine.signal(engine.m_step));
+
+        ++engine.m_step;
+    }
+
+    EXPECT_EQ(cache.getLoopFrames(), params.captureCycles * Period);
+    EXPECT_EQ(cache.getCrossfadeFrames(), params.crossfadeFrames);
+
+    // Picks up where the live signal stopped, across several loop seams
+    for (int i = 0; i < 5 * cache.getLoopFrames(); ++i, ++engine.m_step) {
+        const double replayed = *cache.nextReplayFrame();
+        ASSERT_NEAR(replayed, engine.signal(engine.m_step), 0.03 * 1.25) << i;
+    }
+
+    EXPECT_EQ(cache.getReplayedFrames(), 5ull * cache.getLoopFrames());
+
+    cache.interrupt();
+    EXPECT_EQ(cache.getState(), CycleAudioCache::State::Resuming);
+
+    // Live frames fade in from the replay and it starts over
+    for (int i = 0; i <= params.crossfadeFrames; ++i, ++engine.m_step) {
+        const bool cycleStart = engine.step(&statistics);
+        double frame = engine.signal(engine.m_step);
+        cache.processLiveFrame(&frame, cycleStart, statistics);
+        ASSERT_NEAR(frame, engine.signal(engine.m_step), 0.03 * 1.25);
+    }
+
+    EXPECT_EQ(cache.getState(), CycleAudioCache::State::Watching);
+}
+
+TEST(CycleAudioCacheTests, UnsteadyCyclesAreNotCaptured) {
+    CycleAudioCache::Parameters params;
+    params.steadyCycles = 3;
+    params.periodTolerance = 0.01;
+
+    CycleAudioCache cache;
+    cache.initialize(params, 2);
+
+    CycleStatistics statistics;
+
+    // The engine speeds up every cycle, by more than the tolerance
+    int period = 400;
+    for (int cycle = 0; cycle < 20; ++cycle, period -= 10) {
+        for (int i = 0; i < period; ++i) {
+            double values[CycleStatistics::ChannelCount] = {};
+            const double angle = 4 * constants::pi * i / period;
+            values[static_cast<int>(CycleStatistics::Channel::CylinderVolume)] = 1E-4 * (1 - std::cos(angle));
+            statistics.addSample(angle, 1, values);
+
+            double frame[2] = { 1.0, -1.0 };
+            cache.processLiveFrame(frame, statistics.isCycleStart(), statistics);
+            ASSERT_EQ(cache.getState(), CycleAudioCache::State::Watching);
+        }
+    }
+}
+
+TEST(CycleAudioCacheTests, InterruptAbandonsCapture) {
+    CycleAudioCache::Parameters params;
+    params.steadyCycles = 2;
+
+    CycleAudioCache cache;
+    cache.initialize(params, 1);
+
+    CycleStatistics statistics;
+    SteadyEngine engine;
+    while (cache.getState() != CycleAudioCache::State::Capturing) {
+        ASSERT_LT(engine.m_step, 20 * Period);
+
+        const bool cycleStart = engine.step(&statistics);
+        double frame = 0.0;
+        cache.processLiveFrame(&frame, cycleStart, statistics);
+        ++engine.m_step;
+    }
+
+    cache.interrupt();
+    EXPECT_EQ(cache.getState(), CycleAudioCache::State::Watching);
+
+    // Steady cycles are counted again from the interrupt
+    for (int i = 0; i < 2 * Period; ++i, ++engine.m_step) {
+        const bool cycleStart = engine.step(&statistics);
+        double frame = 0.0;
+        cache.processLiveFrame(&frame, cycleStart, statistics);
+        ASSERT_EQ(cache.getState(), CycleAudioCache::State::Watching);
+    }
+}
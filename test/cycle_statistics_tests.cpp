@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "../include/cycle_statistics.h"
+#include "../include/constants.h"
+
+#include <cmath>
+
+namespace {
+typedef CycleStatistics::Channel Channel;
+
+// Volume of a cylinder with a sinusoidal stroke and, per cycle, highPressure
+// on the power stroke and lowPressure otherwise, so the indicated work is
+// (high - low) * displacement
+void runCycle(
+    CycleStatistics *statistics,
+    int steps,
+    double highPressure,
+    double lowPressure,
+    double displacement,
+    double torque)
+{
+    for (int i = 0; i < steps; ++i) {
+        const double angle = 4 * constants::pi * i / steps;
+
+        double values[CycleStatistics::ChannelCount] = {};
+        values[static_cast<int>(Channel::Torque)] = torque;
+        values[static_cast<int>(Channel::CylinderVolume)] =
+            1E-5 + displacement * 0.5 * (1 - std::cos(angle));
+        values[static_cast<int>(Channel::CylinderPressure)] =
+            (angle >= 2 * constants::pi && angle < 3 * constants::pi) ? highPressure : lowPressure;
+
+        statistics->addSample(angle, 1, values);
+    }
+}
+} /* namespace */
+
+TEST(CycleStatisticsTests, SparseStepsFillEveryBin) {
+    CycleStatistics statistics;
+
+    // Far fewer steps than bins, so most bins are only reached by the fill;
+    // each cycle is closed by the first step of the next
+    double close[CycleStatistics::ChannelCount] = {};
+    close[static_cast<int>(Channel::Torque)] = 100.0;
+    runCycle(&statistics, 37, 0, 0, 0, 100.0);
+    statistics.addSample(0.0, 1, close);
+    EXPECT_NEAR(statistics.getAverage(Channel::Torque), 100.0, 1E-9);
+
+    close[static_cast<int>(Channel::Torque)] = -50.0;
+    runCycle(&statistics, 37, 0, 0, 0, -50.0);
+    statistics.addSample(0.0, 1, close);
+    EXPECT_NEAR(statistics.getAverage(Channel::Torque), -50.0, 1E-9);
+
+    for (int i = 0; i < CycleStatistics::Bins; ++i) {
+        ASSERT_EQ(statistics.getBin(Channel::Torque, i), -50.0);
+    }
+}
+
+TEST(CycleStatisticsTests, ReverseRotationFillsBackwards) {
+    CycleStatistics statistics;
+
+    double values[CycleStatistics::ChannelCount] = {};
+    values[static_cast<int>(Channel::Torque)] = 1.0;
+    statistics.addSample(CycleStatistics::GetBinAngle(10), -1, values);
+
+    values[static_cast<int>(Channel::Torque)] = 2.0;
+    statistics.addSample(CycleStatistics::GetBinAngle(5), -1, values);
+
+    for (int i = 5; i < 10; ++i) {
+        EXPECT_EQ(statistics.getBin(Channel::Torque, i), 2.0);
+    }
+
+    EXPECT_EQ(statistics.getBin(Channel::Torque, 10), 1.0);
+    EXPECT_EQ(statistics.getBin(Channel::Torque, 4), 0.0);
+    EXPECT_EQ(statistics.getBin(Channel::Torque, 11), 0.0);
+}
+
+TEST(CycleStatisticsTests, ImepFromPressureVolumeWork) {
+    CycleStatistics statistics;
+
+    const double displacement = 5E-4;
+    for (int cycle = 0; cycle < 6; ++cycle) {
+        runCycle(&statistics, 2000, 2E6, 1E5, displacement, 10.0);
+    }
+
+    // The first cycle started part way through a cycle and isn't counted
+    EXPECT_EQ(statistics.getCycleCount(), 4);
+    EXPECT_NEAR(statistics.getMeanImep(), 1.9E6, 1E4);
+    EXPECT_NEAR(statistics.getImepCoefficientOfVariation(), 0.0, 1E-6);
+    EXPECT_NEAR(statistics.getCycle(0).peakPressure, 2E6, 1E-6);
+    EXPECT_NEAR(statistics.getCycle(0).peakPressureAngle, 2 * constants::pi, 1E-2);
+}
+
+TEST(CycleStatisticsTests, VariabilityAcrossCycles) {
+    CycleStatistics statistics;
+
+    runCycle(&statistics, 1000, 2E6, 0, 5E-4, 0);
+    for (int cycle = 0; cycle < 20; ++cycle) {
+        runCycle(&statistics, 1000, (cycle % 2 == 0) ? 1.8E6 : 2.2E6, 0, 5E-4, 0);
+    }
+
+    EXPECT_NEAR(statistics.getMeanImep(), 2E6, 3E4);
+    EXPECT_NEAR(statistics.getImepCoefficientOfVariation(), 0.1, 0.01);
+}
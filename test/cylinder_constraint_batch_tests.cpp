@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include "../include/cylinder_constraint_batch.h"
+
+#include <cmath>
+
+namespace {
+constexpr int Cylinders = 2;
+constexpr int Bodies = 2 * Cylinders + 1;
+
+struct Rig {
+    atg_scs::RigidBody bodies[Bodies];
+    double p_x[Bodies], p_y[Bodies], theta[Bodies], v_theta[Bodies];
+    atg_scs::SystemState state;
+    CylinderConstraintBatch batch;
+
+    Rig() {
+        const double p_x0[] = { 0.0, 0.01, 0.02, -0.01, 0.03 };
+        const double p_y0[] = { 0.0, 0.12, 0.06, 0.11, 0.05 };
+        const double theta0[] = { 0.3, 0.05, -0.2, 1.1, 0.4 };
+        const double omega0[] = { 150.0, 2.0, -30.0, 5.0, 40.0 };
+
+        for (int i = 0; i < Bodies; ++i) {
+            bodies[i].index = i;
+            p_x[i] = p_x0[i];
+            p_y[i] = p_y0[i];
+            theta[i] = theta0[i];
+            v_theta[i] = omega0[i];
+        }
+
+        state.p_x = p_x;
+        state.p_y = p_y;
+        state.theta = theta;
+        state.v_theta = v_theta;
+
+        // Body 0 is the crankshaft, then a piston and a rod per cylinder
+        batch.initialize(Cylinders);
+        batch.setStiffness(100.0, 2.0);
+        for (int i = 0; i < Cylinders; ++i) {
+            atg_scs::RigidBody *piston = &bodies[1 + 2 * i];
+            atg_scs::RigidBody *rod = &bodies[2 + 2 * i];
+            batch.setLittleEnd(i, rod, piston, 0.07 + 0.01 * i, -0.01);
+            batch.setBigEnd(i, &bodies[0], -0.03, 0.04 * i, 0.045);
+            batch.setWall(i, std::cos(1.2 + i), std::sin(1.2 + i), 0.001, -0.002);
+        }
+    }
+
+    ~Rig() {
+        batch.destroy();
+    }
+
+    atg_scs::Constraint::Output calculate(atg_scs::Constraint *constraint) {
+        // The little end of the first cylinder refreshes the batch
+        atg_scs::Constraint::Output output;
+        batch.getLittleEnd(0)->calculate(&output, &state);
+        constraint->calculate(&output, &state);
+        return output;
+    }
+
+    double *coordinate(int body, int k) {
+        double *q[] = { p_x, p_y, theta };
+        return &q[k][body];
+    }
+};
+} /* namespace */
+
+TEST(CylinderConstraintBatchTests, JacobianMatchesPositionError) {
+    constexpr double h = 1E-6;
+
+    Rig rig;
+    for (int i = 0; i < Cylinders; ++i) {
+        struct {
+            atg_scs::Constraint *constraint;
+            int rows;
+            int bodies[2];
+        } cases[] = {
+            { rig.batch.getLittleEnd(i), 2, { 2 + 2 * i, 1 + 2 * i } },
+            { rig.batch.getBigEnd(i), 2, { 2 + 2 * i, 0 } },
+            { rig.batch.getWall(i), 1, { 1 + 2 * i, -1 } }
+        };
+
+        for (const auto &c : cases) {
+            const atg_scs::Constraint::Output output = rig.calculate(c.constraint);
+            for (int b = 0; b < 2 && c.bodies[b] >= 0; ++b) {
+                for (int k = 0; k < 3; ++k) {
+                    double *q = rig.coordinate(c.bodies[b], k);
+                    const double q0 = *q;
+
+                    *q = q0 + h;
+                    const atg_scs::Constraint::Output ahead = rig.calculate(c.constraint);
+                    *q = q0 - h;
+                    const atg_scs::Constraint::Output behind = rig.calculate(c.constraint);
+                    *q = q0;
+
+                    for (int r = 0; r < c.rows; ++r) {
+                        EXPECT_NEAR(
+                            output.J[r][3 * b + k],
+                            (ahead.C[r] - behind.C[r]) / (2 * h),
+                            1E-6);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(CylinderConstraintBatchTests, JacobianDerivativeMatchesRotation) {
+    constexpr double h = 1E-7;
+
+    Rig rig;
+    atg_scs::Constraint *constraints[] = {
+        rig.batch.getLittleEnd(1), rig.batch.getBigEnd(1), rig.batch.getWall(1)
+    };
+
+    for (atg_scs::Constraint *constraint : constraints) {
+        const atg_scs::Constraint::Output output = rig.calculate(constraint);
+
+        double theta0[Bodies];
+        for (int i = 0; i < Bodies; ++i) theta0[i] = rig.theta[i];
+
+        for (int i = 0; i < Bodies; ++i) rig.theta[i] = theta0[i] + rig.v_theta[i] * h;
+        const atg_scs::Constraint::Output ahead = rig.calculate(constraint);
+        for (int i = 0; i < Bodies; ++i) rig.theta[i] = theta0[i] - rig.v_theta[i] * h;
+        const atg_scs::Constraint::Output behind = rig.calculate(constraint);
+        for (int i = 0; i < Bodies; ++i) rig.theta[i] = theta0[i];
+
+        for (int r = 0; r < 2; ++r) {
+            for (int j = 0; j < 6; ++j) {
+                if (constraint == rig.batch.getWall(1) && (r > 0 || j > 2)) continue;
+
+                EXPECT_NEAR(
+                    output.J_dot[r][j],
+                    (ahead.J[r][j] - behind.J[r][j]) / (2 * h),
+                    1E-4);
+            }
+        }
+
+        EXPECT_EQ(output.ks[0], 100.0);
+        EXPECT_EQ(output.kd[0], 2.0);
+    }
+}
@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+
+#include "../include/debug_trace.h"
+#include "../include/debug_trace_buffers.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Logs through a file sink session and returns the component's log
+std::string traceSession(bool async, void (*log)()) {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "engine_sim_debug_trace_tests";
+    std::filesystem::remove_all(directory);
+
+    const std::string traceArg = "--debug-trace=" + directory.string();
+    const std::string asyncArg = std::string("--debug-trace-async=") + (async ? "on" : "off");
+    std::vector<std::string> args = {
+        "engine-sim-test", traceArg, asyncArg, "--debug-trace-snapshot=off", "--debug-trace-sinks=file"
+    };
+
+    std::vector<char *> argv;
+    for (std::string &arg : args) argv.push_back(&arg[0]);
+
+    EXPECT_TRUE(DebugTrace::InitializeFromArguments(static_cast<int>(argv.size()), argv.data()));
+    log();
+    DebugTrace::Shutdown();
+
+    std::ifstream file(directory / "trace_test.log");
+    std::stringstream contents;
+    contents << file.rdbuf();
+    file.close();
+
+    std::filesystem::remove_all(directory);
+    return contents.str();
+}
+
+void logWideArguments() {
+    const size_t size = (static_cast<size_t>(1) << 40) + 5;
+    const ptrdiff_t offset = -(static_cast<ptrdiff_t>(1) << 35);
+    DebugTrace::Log("trace_test", "size=%zu offset=%td max=%ju", size, offset, UINTMAX_MAX);
+}
+
+void logLongString() {
+    const std::string value(400, 'x');
+    DebugTrace::Log("trace_test", "value=%s end", value.c_str());
+}
+
+void logLongPreformatted() {
+    // Star widths can't be captured, so the whole message is formatted on
+    // the caller into the record
+    const std::string value(400, 'x');
+    DebugTrace::Log("trace_test", "width=%*d value=%s", 4, 7, value.c_str());
+}
+
+// Every record the ring holds, oldest first, by its frame
+std::vector<uint64_t> ringFrames(const debug_trace::CompactRing &ring) {
+    std::vector<uint64_t> frames;
+    size_t offset = ring.tail;
+    for (uint64_t i = 0; i < ring.count; ++i) {
+        debug_trace::RingRecordHeader header;
+        ring.copyOut(offset, &header, sizeof(header));
+        frames.push_back(header.frame);
+        offset = (offset + header.size) % ring.bytes.size();
+    }
+
+    return frames;
+}
+
+void pushRecord(debug_trace::CompactRing *ring, uint64_t frame, size_t payloadSize) {
+    std::vector<uint8_t> payload(payloadSize, static_cast<uint8_t>(frame));
+
+    debug_trace::RingRecordHeader header{};
+    header.size = static_cast<uint16_t>(sizeof(header) + payloadSize);
+    header.frame = frame;
+    ring->push(header, payload.data());
+}
+
+} /* namespace */
+
+TEST(DebugTraceTests, CapturesArgumentsAtFullWidth) {
+    for (bool async : { true, false }) {
+        const std::string log = traceSession(async, logWideArguments);
+        EXPECT_NE(log.find("size=1099511627781 offset=-34359738368 max=18446744073709551615"), std::string::npos)
+            << "async=" << async << "\n" << log;
+    }
+}
+
+TEST(DebugTraceTests, MarksTruncatedStrings) {
+    const std::string log = traceSession(true, logLongString);
+    const size_t start = log.find("value=");
+    ASSERT_NE(start, std::string::npos) << log;
+
+    // Cut to fit the record, ending in a marker, with the rest of the
+    // format still there
+    const size_t end = log.find(" end", start);
+    ASSERT_NE(end, std::string::npos) << log;
+
+    const std::string value = log.substr(start + 6, end - start - 6);
+    EXPECT_LT(value.size(), 400u);
+    EXPECT_EQ(value.substr(value.size() - 3), "...");
+    EXPECT_EQ(value.find_first_not_of('x'), value.size() - 3);
+}
+
+TEST(DebugTraceTests, MarksTruncatedPreformattedMessages) {
+    const std::string log = traceSession(true, logLongPreformatted);
+    const size_t start = log.find("width=   7 value=");
+    ASSERT_NE(start, std::string::npos) << log;
+
+    const size_t end = log.find('\n', start);
+    const std::string message = log.substr(start, end - start);
+    EXPECT_LT(message.size(), 400u);
+    EXPECT_EQ(message.substr(message.size() - 3), "...");
+}
+
+TEST(DebugTraceTests, RingEvictsOldestAcrossWrap) {
+    debug_trace::CompactRing ring;
+    ring.bytes.assign(100, 0);
+
+    pushRecord(&ring, 0, 8);
+    pushRecord(&ring, 1, 8);
+    EXPECT_EQ(ringFrames(ring), (std::vector<uint64_t>{ 0, 1 }));
+
+    // Only room once the first is gone, and written across the end
+    pushRecord(&ring, 2, 8);
+    EXPECT_EQ(ringFrames(ring), (std::vector<uint64_t>{ 1, 2 }));
+    EXPECT_EQ(ring.used, 80u);
+    EXPECT_EQ(ring.head, 20u);
+
+    debug_trace::RingRecordHeader header;
+    ring.copyOut(80, &header, sizeof(header));
+    uint8_t payload[8];
+    ring.copyOut((80 + sizeof(header)) % 100, payload, sizeof(payload));
+    for (uint8_t byte : payload) EXPECT_EQ(byte, 2);
+
+    // A record as big as the ring evicts all of it, one bigger is dropped
+    pushRecord(&ring, 3, 100 - sizeof(header));
+    EXPECT_EQ(ringFrames(ring), (std::vector<uint64_t>{ 3 }));
+    EXPECT_EQ(ring.used, 100u);
+
+    pushRecord(&ring, 4, 101 - sizeof(header));
+    EXPECT_EQ(ringFrames(ring), (std::vector<uint64_t>{ 3 }));
+
+    for (uint64_t frame = 5; frame < 50; ++frame) pushRecord(&ring, frame, frame % 20);
+    const std::vector<uint64_t> frames = ringFrames(ring);
+    ASSERT_FALSE(frames.empty());
+    EXPECT_EQ(frames.back(), 49u);
+    for (size_t i = 1; i < frames.size(); ++i) EXPECT_EQ(frames[i], frames[i - 1] + 1);
+}
+
+TEST(DebugTraceTests, StringTableInternsOnce) {
+    debug_trace::StringTable table;
+    table.initialize(64, 1024);
+
+    // Enough entries that some share a probe chain
+    std::vector<std::string> values;
+    for (int i = 0; i < 64; ++i) values.push_back("component_" + std::to_string(i));
+    for (int i = 0; i < 64; ++i) {
+        EXPECT_EQ(table.intern(values[i].c_str(), values[i].size()), i);
+    }
+
+    for (int i = 0; i < 64; ++i) {
+        EXPECT_EQ(table.intern(values[i].c_str(), values[i].size()), i);
+
+        size_t length;
+        const char *text = table.get(static_cast<uint16_t>(i), &length);
+        EXPECT_EQ(std::string(text, length), values[i]);
+    }
+
+    EXPECT_EQ(table.count, 64u);
+    EXPECT_EQ(table.intern("another", 7), debug_trace::StringTable::Full);
+
+    // A prefix is a string of its own
+    debug_trace::StringTable prefixes;
+    prefixes.initialize(4, 1024);
+    EXPECT_EQ(prefixes.intern("trace", 5), 0);
+    EXPECT_EQ(prefixes.intern("trace", 3), 1);
+    EXPECT_EQ(prefixes.intern("trace", 5), 0);
+}
+
+TEST(DebugTraceTests, StringTableStopsAtTextCapacity) {
+    debug_trace::StringTable table;
+    table.initialize(8, 6);
+
+    EXPECT_EQ(table.intern("abc", 3), 0);
+    EXPECT_EQ(table.intern("def", 3), 1);
+    EXPECT_EQ(table.intern("g", 1), debug_trace::StringTable::Full);
+
+    // Neither the earlier entries nor the count moved
+    EXPECT_EQ(table.intern("abc", 3), 0);
+    EXPECT_EQ(table.count, 2u);
+}
+
+TEST(DebugTraceTests, NamesOverflowSnapshotBucketById) {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "engine_sim_debug_trace_overflow_tests";
+    std::filesystem::remove_all(directory);
+
+    const std::string traceArg = "--debug-trace=" + directory.string();
+    std::vector<std::string> args = {
+        "engine-sim-test", traceArg, "--debug-trace-async=off", "--debug-trace-snapshot=on",
+        "--debug-trace-snapshot-ms=600000", "--debug-trace-sinks=file"
+    };
+
+    std::vector<char *> argv;
+    for (std::string &arg : args) argv.push_back(&arg[0]);
+
+    // More components than the table holds, so the last land in the
+    // shared bucket past it
+    ASSERT_TRUE(DebugTrace::InitializeFromArguments(static_cast<int>(argv.size()), argv.data()));
+    for (int i = 0; i < 80; ++i) {
+        DebugTrace::Log(("overflow_test_" + std::to_string(i)).c_str(), "tick");
+    }
+
+    DebugTrace::Shutdown();
+
+    auto read = [&directory](const std::string &name) {
+        std::ifstream file(directory / name);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    };
+
+    const std::string overflow = read("64.log");
+    EXPECT_NE(overflow.find("snapshot"), std::string::npos) << overflow;
+    EXPECT_EQ(read("main.log").find("tokens=tick"), std::string::npos);
+    EXPECT_NE(read("overflow_test_0.log").find("samples=1 "), std::string::npos);
+
+    std::filesystem::remove_all(directory);
+}
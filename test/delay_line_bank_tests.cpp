@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "../include/delay_line_bank.h"
+#include "../include/constants.h"
+
+#include <cmath>
+
+TEST(DelayLineBankTests, WholeSampleDelays) {
+    // 0, 1 and 37 samples at 1 kHz
+    const double delays[] = { 0.0, 0.001, 0.037 };
+
+    DelayLineBank bank;
+    bank.initialize(delays, 3, 1000.0);
+    EXPECT_GE(bank.getRowCount(), 40);
+
+    for (int t = 0; t < 200; ++t) {
+        const double input[] = { (double)t, (double)t, (double)t };
+        double output[3];
+        bank.process(input, output);
+
+        EXPECT_NEAR(output[0], t, 1E-9);
+        EXPECT_NEAR(output[1], std::max(t - 1, 0), 1E-9);
+        EXPECT_NEAR(output[2], std::max(t - 37, 0), 1E-9);
+    }
+}
+
+TEST(DelayLineBankTests, FractionalDelays) {
+    // A slow sine is delayed by the exact fraction, above and below one sample
+    const double rate = 10000.0;
+    const double delays[] = { 0.4 / rate, 12.3 / rate };
+    const double frequency = 50.0 / rate;
+
+    DelayLineBank bank;
+    bank.initialize(delays, 2, rate);
+    EXPECT_NEAR(bank.getDelaySamples(1), 12.3, 1E-9);
+
+    double input[200 * 2], output[200 * 2];
+    for (int t = 0; t < 200; ++t) {
+        input[t * 2 + 0] = input[t * 2 + 1] = std::sin(2 * constants::pi * frequency * t);
+    }
+
+    bank.process(input, output, 200);
+
+    for (int t = 50; t < 200; ++t) {
+        EXPECT_NEAR(output[t * 2 + 0], std::sin(2 * constants::pi * frequency * (t - 0.4)), 1E-3);
+        EXPECT_NEAR(output[t * 2 + 1], std::sin(2 * constants::pi * frequency * (t - 12.3)), 1E-6);
+    }
+}
+
+TEST(DelayLineBankTests, RetimingClearsHistory) {
+    const double delays[] = { 0.002 };
+
+    DelayLineBank bank;
+    bank.initialize(delays, 1, 1000.0);
+
+    double output;
+    for (int t = 0; t < 10; ++t) {
+        const double input = 1.0;
+        bank.process(&input, &output);
+    }
+
+    EXPECT_EQ(output, 1.0);
+
+    bank.initialize(delays, 1, 4000.0);
+    EXPECT_NEAR(bank.getDelaySamples(0), 8.0, 1E-9);
+
+    const double input = 1.0;
+    bank.process(&input, &output);
+    EXPECT_EQ(output, 0.0);
+}
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include "../include/denormals.h"
+
+#include <cmath>
+#include <limits>
+
+TEST(DenormalsTests, ScopeFlushesAndRestores) {
+    if (!DenormalScope::IsSupported()) GTEST_SKIP();
+
+    volatile float tiny = std::numeric_limits<float>::min();
+    volatile float half = 0.5f;
+
+    const bool wasFlushing = DenormalScope::IsFlushing();
+    {
+        DenormalScope disabled(false);
+        EXPECT_EQ(DenormalScope::IsFlushing(), wasFlushing);
+    }
+
+    {
+        DenormalScope denormals;
+        EXPECT_TRUE(DenormalScope::IsFlushing());
+        EXPECT_EQ(tiny * half, 0.0f);
+    }
+
+    EXPECT_EQ(DenormalScope::IsFlushing(), wasFlushing);
+    if (!wasFlushing) {
+        EXPECT_EQ(std::fpclassify(tiny * half), FP_SUBNORMAL);
+    }
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "../include/distributed_study.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace {
+std::string temporaryPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+ParameterStudy::Parameters makeStudy() {
+    ParameterStudy::Parameters params;
+    params.axes.push_back({ ParameterStudy::Parameter::IgnitionOffset, -4.0, 4.0, 2 });
+    params.sweep.minRpm = 2000.0;
+    params.sweep.maxRpm = 4000.0;
+    params.sweep.stepRpm = 1000.0;
+    params.sweep.settleTime = 3.5;
+    return params;
+}
+} /* namespace */
+
+TEST(DistributedStudyTests, WorkerReceivesStudyAndRunsEveryTask) {
+    const std::string snapshotPath = temporaryPath("engine_sim_distributed_study_source.snapshot");
+    const std::string receivedPath = temporaryPath("engine_sim_distributed_study_received.snapshot");
+    {
+        std::ofstream snapshot(snapshotPath, std::ios::binary);
+        snapshot << "not really an engine";
+    }
+
+    StudyCoordinator::Parameters coordinatorParams;
+    coordinatorParams.port = 0;
+
+    StudyCoordinator coordinator;
+    ASSERT_TRUE(coordinator.initialize(coordinatorParams, makeStudy(), snapshotPath));
+    ASSERT_GT(coordinator.getPort(), 0);
+    EXPECT_EQ(coordinator.getStudy().getTaskCount(), 6);
+
+    std::string received;
+    int created = 0;
+    bool prepared = false;
+    std::thread workerThread([&] {
+        StudyWorker::Parameters workerParams;
+        workerParams.host = "localhost";
+        workerParams.port = coordinator.getPort();
+        workerParams.threads = 2;
+        workerParams.snapshotPath = receivedPath;
+
+        StudyWorker worker;
+        worker.run(
+            workerParams,
+            [&](const ParameterStudy &study, const std::string &path) {
+                prepared = study.getTaskCount() == 6
+                    && study.getVariants()[1].values[0] == 4.0
+                    && study.getParameters().sweep.settleTime == 3.5;
+
+                std::ifstream file(path, std::ios::binary);
+                received.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                return true;
+            },
+            // No engine; every point comes back invalid
+            [&](int, const ParameterStudy::Variant &) -> Simulator * { ++created; return nullptr; },
+            [](int, Simulator *) { /* void */ });
+    });
+
+    const ParameterStudy::Result result = coordinator.run();
+    workerThread.join();
+
+    EXPECT_TRUE(prepared);
+    EXPECT_EQ(received, "not really an engine");
+    EXPECT_EQ(created, 6);
+
+    ASSERT_EQ(result.sweeps.size(), 2u);
+    EXPECT_EQ(result.sweeps[0].points.size(), 3u);
+
+    const StudyCoordinator::Statistics &stats = coordinator.getStatistics();
+    EXPECT_EQ(stats.workers, 1);
+    EXPECT_EQ(stats.dispatched, 6 + stats.duplicates);
+    EXPECT_EQ(stats.requeued, 0);
+
+    coordinator.destroy();
+    std::remove(snapshotPath.c_str());
+    std::remove(receivedPath.c_str());
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include "../include/drive_cycle.h"
+
+#include "../include/units.h"
+
+TEST(DriveCycleTests, ShiftRulesLaunchAndUpshift) {
+    DriveCycle::Parameters params;
+    params.starterTime = 1.0;
+    params.launchTime = 2.0;
+    params.shiftRules.shiftSpeed = units::rpm(6000);
+    params.shiftRules.launchClutchTime = 0.5;
+    params.shiftRules.shiftTime = 0.2;
+    params.shiftRules.shiftClutchTime = 0.1;
+
+    DriveCycle::ShiftController controller;
+    controller.initialize(params, 2);
+
+    SimulationSnapshot snapshot;
+    snapshot.rpm = 800;
+
+    HeadlessRunner::ControlPoint control = controller.update(0.5, snapshot);
+    EXPECT_TRUE(control.drivetrain);
+    EXPECT_TRUE(control.starter);
+    EXPECT_EQ(control.gear, -1);
+    EXPECT_EQ(control.clutch, 0.0);
+
+    control = controller.update(1.5, snapshot);
+    EXPECT_FALSE(control.starter);
+    EXPECT_EQ(control.gear, -1);
+
+    // The clutch ramps in over the launch
+    control = controller.update(2.0, snapshot);
+    EXPECT_EQ(control.gear, 0);
+    EXPECT_EQ(control.throttle, 1.0);
+    EXPECT_NEAR(controller.update(2.25, snapshot).clutch, 0.5, 1E-9);
+    EXPECT_EQ(controller.update(2.6, snapshot).clutch, 1.0);
+
+    snapshot.rpm = 6100;
+    control = controller.update(3.0, snapshot);
+    EXPECT_EQ(control.gear, 1);
+    EXPECT_EQ(control.clutch, 0.0);
+    EXPECT_EQ(control.throttle, 0.0);
+
+    // Back on throttle once the shift time is up, then the clutch ramps in
+    control = controller.update(3.25, snapshot);
+    EXPECT_EQ(control.throttle, 1.0);
+    EXPECT_EQ(control.clutch, 0.0);
+    EXPECT_NEAR(controller.update(3.3, snapshot).clutch, 0.5, 1E-9);
+
+    // No gear above the top one
+    control = controller.update(3.5, snapshot);
+    EXPECT_EQ(control.gear, 1);
+    EXPECT_EQ(control.clutch, 1.0);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "../include/dual.h"
+#include "../include/gas_system.h"
+#include "../include/units.h"
+
+namespace {
+
+typedef Dual<2> Dual2;
+
+// Central difference of the double flow rate in the upstream pressure
+double flowRateByP0(double k, double P0, double P1, double T, const GasSystem::FlowConstants &c) {
+    const double h = P0 * 1E-6;
+    return (GasSystem::flowRate(k, P0 + h, P1, T, T, c) - GasSystem::flowRate(k, P0 - h, P1, T, T, c))
+        / (2 * h);
+}
+
+} /* namespace */
+
+TEST(DualTests, Arithmetic) {
+    const Dual2 x = Dual2::Variable(3.0, 0);
+    const Dual2 y = Dual2::Variable(2.0, 1);
+
+    const Dual2 f = x * x * y + x / y - 4.0;
+    EXPECT_DOUBLE_EQ(f.value(), 9.0 * 2.0 + 1.5 - 4.0);
+    EXPECT_DOUBLE_EQ(f.derivative(0), 2 * 3.0 * 2.0 + 1 / 2.0);
+    EXPECT_DOUBLE_EQ(f.derivative(1), 9.0 - 3.0 / 4.0);
+
+    const Dual2 g = sqrt(x) * exp(y) + pow(x, 1.5) - log(y);
+    EXPECT_NEAR(g.derivative(0), 0.5 / std::sqrt(3.0) * std::exp(2.0) + 1.5 * std::sqrt(3.0), 1E-12);
+    EXPECT_NEAR(g.derivative(1), std::sqrt(3.0) * std::exp(2.0) - 0.5, 1E-12);
+
+    EXPECT_TRUE(x > y);
+    EXPECT_EQ(fmax(y, 2.5).derivative(1), 0.0);
+    EXPECT_EQ(fmax(x, 2.5).derivative(0), 1.0);
+}
+
+TEST(DualTests, FlowRateMatchesDouble) {
+    const GasSystem::FlowConstants c = GasSystem::flowConstants(5);
+    const double k = GasSystem::k_carb(300.0);
+    const double T = units::celcius(25.0);
+    const double P_a = units::pressure(1.0, units::atm);
+
+    for (double P1 : { 0.2 * P_a, 0.7 * P_a, 0.99 * P_a, 1.3 * P_a }) {
+        const Dual2 flow = GasSystem::flowRate<Dual2>(
+            k, Dual2::Variable(P_a, 0), Dual2(P1), Dual2::Variable(T, 1), T, c);
+        EXPECT_EQ(flow.value(), GasSystem::flowRate(k, P_a, P1, T, T, c));
+    }
+}
+
+TEST(DualTests, FlowRateDerivativeMatchesFiniteDifference) {
+    const GasSystem::FlowConstants c = GasSystem::flowConstants(5);
+    const double k = GasSystem::k_carb(300.0);
+    const double T = units::celcius(25.0);
+    const double P_a = units::pressure(1.0, units::atm);
+
+    // Choked, then unchoked
+    for (double P1 : { 0.2 * P_a, 0.8 * P_a }) {
+        const Dual2 flow = GasSystem::flowRate<Dual2>(
+            Dual2::Variable(k, 1), Dual2::Variable(P_a, 0), Dual2(P1), T, T, c);
+
+        const double expected = flowRateByP0(k, P_a, P1, T, c);
+        EXPECT_NEAR(flow.derivative(0), expected, std::abs(expected) * 1E-5);
+        EXPECT_NEAR(flow.derivative(1), flow.value() / k, std::abs(flow.value() / k) * 1E-12);
+    }
+}
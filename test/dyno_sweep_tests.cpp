@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include "../include/dyno_sweep.h"
+
+#include "../include/simulator.h"
+#include "test_engine.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// One test twin per hold point, built and released by the sweep
+struct Twins {
+    std::vector<Engine *> engines;
+    std::vector<Vehicle *> vehicles;
+    std::vector<Transmission *> transmissions;
+
+    explicit Twins(int points)
+        : engines(points, nullptr), vehicles(points, nullptr), transmissions(points, nullptr)
+    {
+        /* void */
+    }
+
+    Simulator *create(int point) {
+        engines[point] = test_engine::buildEngine();
+        vehicles[point] = test_engine::buildVehicle();
+        transmissions[point] = test_engine::buildTransmission();
+
+        Simulator *simulator = engines[point]->createSimulator(
+            vehicles[point], transmissions[point], false, false);
+        simulator->setSimulationFrequency(5000);
+        return simulator;
+    }
+
+    void release(int point, Simulator *simulator) {
+        simulator->releaseSimulation();
+        delete simulator;
+        test_engine::release(engines[point], vehicles[point], transmissions[point]);
+    }
+};
+
+std::vector<std::string> readLines(const std::string &path) {
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+
+    return lines;
+}
+
+} /* namespace */
+
+TEST(DynoSweepTests, ShortSweepOnTestEngine) {
+    DynoSweep::Parameters params;
+    params.minRpm = 1500;
+    params.maxRpm = 3000;
+    params.stepRpm = 500;
+    params.stopWhenSettled = false;
+    params.settleTime = 0.05;
+    params.measureCycles = 2;
+    params.threads = 2;
+
+    DynoSweep sweep;
+    sweep.initialize(params);
+    ASSERT_EQ(sweep.getHoldPoints(), std::vector<double>({ 1500, 2000, 2500, 3000 }));
+
+    Twins twins(4);
+    const DynoSweep::Result result = sweep.run(
+        [&](int point) { return twins.create(point); },
+        [&](int point, Simulator *simulator) { twins.release(point, simulator); });
+
+    ASSERT_EQ(result.points.size(), 4u);
+    for (size_t i = 0; i < result.points.size(); ++i) {
+        const DynoSweep::Point &point = result.points[i];
+        SCOPED_TRACE(::testing::Message() << "point " << i);
+
+        EXPECT_TRUE(point.valid);
+        EXPECT_NEAR(point.rpm, 1500 + 500.0 * i, 1E-6);
+        if (i > 0) EXPECT_GT(point.rpm, result.points[i - 1].rpm);
+
+        EXPECT_GE(point.simulatedTime, params.settleTime);
+        EXPECT_DOUBLE_EQ(point.power, point.torque * units::rpm(point.rpm));
+        EXPECT_FALSE(point.audioAnalyzed);
+    }
+
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "engine_sim_dyno_sweep_tests.csv").string();
+    ASSERT_TRUE(DynoSweep::WriteCsv(path, result));
+
+    const std::vector<std::string> lines = readLines(path);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(
+        lines[0],
+        "rpm,torque_nm,torque_lb_ft,power_kw,power_hp,manifold_kpa,intake_afr,"
+        "imep_kpa,imep_cov,settled_s,audio_db,centroid_hz,roughness");
+
+    // A value for every column up to settled_s, audio left empty
+    const char *rpms[] = { "1500,", "2000,", "2500,", "3000," };
+    for (int i = 0; i < 4; ++i) {
+        const std::string &line = lines[i + 1];
+        EXPECT_EQ(line.compare(0, 5, rpms[i]), 0) << line;
+        EXPECT_EQ(std::count(line.begin(), line.end(), ','), 12) << line;
+        EXPECT_EQ(line.substr(line.size() - 3), ",,,") << line;
+    }
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include "../include/engine_controller.h"
+
+#include "../include/engine.h"
+#include "test_engine.h"
+
+namespace {
+
+// Opens up the control law so it can be run without an engine
+class Probe : public EngineController {
+    public:
+        void run(double dt, const Sensors &sensors) {
+            control(dt, sensors, &m_outputs);
+        }
+};
+
+EngineController::Sensors at(double rpm, double throttle, double afr = 0.0) {
+    EngineController::Sensors sensors;
+    sensors.speed = units::rpm(rpm);
+    sensors.throttle = throttle;
+    sensors.intakeAfr = afr;
+    return sensors;
+}
+
+} /* namespace */
+
+TEST(EngineControllerTests, FuelTrimIntegratesAndClamps) {
+    EngineController::Parameters params;
+    params.targetAfr = 14.7;
+    params.fuelTrimGain = 2.0;
+    params.maxFuelTrim = 0.25;
+
+    Probe controller;
+    controller.initialize(params);
+
+    // 10% lean adds 0.2 per second
+    controller.run(0.1, at(2000, 0.5, 14.7 * 1.1));
+    EXPECT_NEAR(controller.getOutputs().fuelTrim, 0.02, 1E-12);
+
+    for (int i = 0; i < 1000; ++i) controller.run(0.1, at(2000, 0.5, 14.7 * 1.1));
+    EXPECT_DOUBLE_EQ(controller.getOutputs().fuelTrim, 0.25);
+
+    // No windup past the clamp: the first rich reading comes straight off it
+    controller.run(0.1, at(2000, 0.5, 14.7 * 0.9));
+    EXPECT_NEAR(controller.getOutputs().fuelTrim, 0.23, 1E-12);
+
+    for (int i = 0; i < 1000; ++i) controller.run(0.1, at(2000, 0.5, 14.7 * 0.9));
+    EXPECT_DOUBLE_EQ(controller.getOutputs().fuelTrim, -0.25);
+
+    controller.run(0.1, at(2000, 0.5, 14.7 * 1.1));
+    EXPECT_NEAR(controller.getOutputs().fuelTrim, -0.23, 1E-12);
+
+    // Held without a reading
+    controller.run(0.1, at(2000, 0.5, 0.0));
+    EXPECT_NEAR(controller.getOutputs().fuelTrim, -0.23, 1E-12);
+}
+
+TEST(EngineControllerTests, FuelTrimOffWithoutTarget) {
+    Probe controller;
+    controller.initialize(EngineController::Parameters());
+
+    for (int i = 0; i < 100; ++i) controller.run(0.1, at(2000, 0.5, 20.0));
+    EXPECT_EQ(controller.getOutputs().fuelTrim, 0.0);
+    EXPECT_EQ(controller.getOutputs().idleAir, 1.0);
+    EXPECT_EQ(controller.getOutputs().timingTrim, 0.0);
+    EXPECT_FALSE(controller.getOutputs().sparkCut);
+}
+
+TEST(EngineControllerTests, IdleAirRespondsAroundTarget) {
+    EngineController::Parameters params;
+    params.idleRpm = units::rpm(800);
+    params.idleThrottle = 0.02;
+    params.idleAirGain = 0.001 / units::rpm(1.0);
+    params.maxIdleAir = 2.0;
+    params.idleSparkGain = units::angle(0.02, units::deg) / units::rpm(1.0);
+    params.maxIdleSpark = units::angle(10.0, units::deg);
+
+    Probe controller;
+    controller.initialize(params);
+
+    // 100 rpm slow: more air and advance
+    controller.run(0.1, at(700, 0.0));
+    EXPECT_NEAR(controller.getOutputs().idleAir, 1.01, 1E-9);
+    EXPECT_NEAR(controller.getOutputs().timingTrim, units::angle(2.0, units::deg), 1E-9);
+
+    // 100 rpm fast: the air integrates back and the spark retards
+    controller.run(0.1, at(900, 0.0));
+    controller.run(0.1, at(900, 0.0));
+    EXPECT_NEAR(controller.getOutputs().idleAir, 0.99, 1E-9);
+    EXPECT_NEAR(controller.getOutputs().timingTrim, units::angle(-2.0, units::deg), 1E-9);
+
+    // On target the air holds and the spark is neutral
+    controller.run(0.1, at(800, 0.0));
+    EXPECT_NEAR(controller.getOutputs().idleAir, 0.99, 1E-9);
+    EXPECT_NEAR(controller.getOutputs().timingTrim, 0.0, 1E-9);
+
+    // Far off target both clamp
+    for (int i = 0; i < 1000; ++i) controller.run(0.1, at(200, 0.0));
+    EXPECT_DOUBLE_EQ(controller.getOutputs().idleAir, 2.0);
+    EXPECT_DOUBLE_EQ(controller.getOutputs().timingTrim, units::angle(10.0, units::deg));
+
+    for (int i = 0; i < 1000; ++i) controller.run(0.1, at(3000, 0.0));
+    EXPECT_DOUBLE_EQ(controller.getOutputs().idleAir, 0.0);
+    EXPECT_DOUBLE_EQ(controller.getOutputs().timingTrim, units::angle(-10.0, units::deg));
+
+    // Off idle the air holds where it was and the spark trim drops out
+    controller.run(0.1, at(700, 0.01));
+    const double idleAir = controller.getOutputs().idleAir;
+    EXPECT_GT(idleAir, 0.0);
+
+    controller.run(0.1, at(700, 0.5));
+    EXPECT_DOUBLE_EQ(controller.getOutputs().idleAir, idleAir);
+    EXPECT_EQ(controller.getOutputs().timingTrim, 0.0);
+}
+
+TEST(EngineControllerTests, RevLimiterCutsWithHysteresis) {
+    EngineController::Parameters params;
+    params.revLimit = units::rpm(6000);
+    params.revLimitHysteresis = units::rpm(200);
+
+    Probe controller;
+    controller.initialize(params);
+
+    const double rpms[] = { 5000, 6000, 6001, 5900, 5801, 5799, 5900, 6000, 6100 };
+    const bool cut[] = { false, false, true, true, true, false, false, false, true };
+    for (int i = 0; i < 9; ++i) {
+        controller.run(0.001, at(rpms[i], 1.0));
+        EXPECT_EQ(controller.getOutputs().sparkCut, cut[i]) << rpms[i] << " rpm";
+    }
+}
+
+TEST(EngineControllerTests, StepsAtControlRateAndApplies) {
+    Engine *engine = test_engine::buildEngine();
+    Vehicle *vehicle = test_engine::buildVehicle();
+    Transmission *transmission = test_engine::buildTransmission();
+
+    // Powers of two so the steps add up to a period exactly
+    EngineController::Parameters params;
+    params.controlRate = 1024;
+    params.idleRpm = units::rpm(800);
+    params.idleThrottle = 2.0;
+
+    EngineController controller;
+    controller.initialize(params);
+
+    for (int i = 0; i < 7; ++i) controller.step(1 / 8192.0, engine);
+    EXPECT_EQ(controller.getControlCount(), 0);
+    EXPECT_EQ(engine->getIgnitionModule()->getTimingTrim(), 0.0);
+
+    controller.step(1 / 8192.0, engine);
+    EXPECT_EQ(controller.getControlCount(), 1);
+    for (int i = 0; i < 24; ++i) controller.step(1 / 8192.0, engine);
+    EXPECT_EQ(controller.getControlCount(), 4);
+
+    // Below idle speed at rest, so the outputs have moved and reached the engine
+    const EngineController::Outputs &outputs = controller.getOutputs();
+    EXPECT_GT(outputs.idleAir, 1.0);
+    EXPECT_GT(outputs.timingTrim, 0.0);
+    EXPECT_EQ(engine->getIgnitionModule()->getTimingTrim(), outputs.timingTrim);
+    for (int i = 0; i < engine->getIntakeCount(); ++i) {
+        EXPECT_EQ(engine->getIntake(i)->getIdleAir(), outputs.idleAir);
+    }
+
+    controller.reset(engine);
+    EXPECT_EQ(engine->getIgnitionModule()->getTimingTrim(), 0.0);
+    EXPECT_EQ(engine->getIntake(0)->getIdleAir(), 1.0);
+
+    test_engine::release(engine, vehicle, transmission);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "../include/engine_definition.h"
+
+#include "../include/engine_instance.h"
+#include "test_engine.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace test_engine;
+
+// The twin written to a snapshot file, removed again on destruction
+struct SnapshotFile {
+    std::filesystem::path path;
+
+    SnapshotFile() {
+        path = std::filesystem::temp_directory_path() / "engine_sim_engine_definition_tests.snapshot";
+
+        Engine *engine = buildEngine();
+        Vehicle *vehicle = buildVehicle();
+        Transmission *transmission = buildTransmission();
+        EXPECT_TRUE(EngineSnapshot::write(path.string(), engine, vehicle, transmission));
+        release(engine, vehicle, transmission);
+    }
+
+    ~SnapshotFile() {
+        std::filesystem::remove(path);
+    }
+};
+
+bool contains(const std::vector<Function *> &functions, const Function *function) {
+    return std::find(functions.begin(), functions.end(), function) != functions.end();
+}
+
+} /* namespace */
+
+TEST(EngineDefinitionTests, InstancesShareTables) {
+    SnapshotFile file;
+
+    EngineDefinition definition;
+    ASSERT_TRUE(definition.load(file.path.string()));
+    EXPECT_EQ(definition.getInstanceCount(), 0);
+
+    const EngineSnapshot::SharedTables &tables = definition.getSharedTables();
+    ASSERT_GT(tables.getFunctionCount(), 0);
+
+    EngineInstance a, b;
+    ASSERT_TRUE(definition.instantiate(&a));
+    EXPECT_EQ(definition.getInstanceCount(), 1);
+    ASSERT_TRUE(definition.instantiate(&b));
+    EXPECT_EQ(definition.getInstanceCount(), 2);
+
+    ASSERT_TRUE(a.isLive());
+    ASSERT_TRUE(b.isLive());
+    EXPECT_NE(a.getEngine(), b.getEngine());
+    EXPECT_EQ(a.getDefinition(), &definition);
+
+    std::vector<Function *> functionsA, functionsB;
+    EngineSnapshot::collectFunctions(a.getEngine(), &functionsA);
+    EngineSnapshot::collectFunctions(b.getEngine(), &functionsB);
+    ASSERT_EQ(functionsA.size(), functionsB.size());
+
+    // The same objects, not copies of them
+    for (size_t i = 0; i < functionsA.size(); ++i) {
+        EXPECT_EQ(functionsA[i], functionsB[i]) << "function " << i;
+    }
+
+    for (int i = 0; i < tables.getFunctionCount(); ++i) {
+        EXPECT_TRUE(contains(functionsA, tables.getFunction(i))) << "shared function " << i;
+    }
+
+    uint64_t hash = 0;
+    ASSERT_TRUE(EngineSnapshot::hashStructure(b.getEngine(), b.getVehicle(), b.getTransmission(), &hash));
+    EXPECT_EQ(hash, definition.getStructureHash());
+
+    // Tearing one down leaves the other's tables in place
+    a.destroy();
+    EXPECT_FALSE(a.isLive());
+    EXPECT_EQ(definition.getInstanceCount(), 1);
+    for (int i = 0; i < tables.getFunctionCount(); ++i) {
+        EXPECT_GT(tables.getFunction(i)->getSampleCount(), 0) << "shared function " << i;
+    }
+
+    // Destroying twice counts once
+    b.destroy();
+    b.destroy();
+    EXPECT_EQ(definition.getInstanceCount(), 0);
+
+    definition.destroy();
+    EXPECT_FALSE(definition.isLoaded());
+}
+
+TEST(EngineDefinitionTests, InstancesTearDownOnAnyThread) {
+    constexpr int Instances = 8;
+    SnapshotFile file;
+
+    EngineDefinition definition;
+    ASSERT_TRUE(definition.load(file.path.string()));
+
+    std::vector<EngineInstance> instances(Instances);
+    for (EngineInstance &instance : instances) {
+        ASSERT_TRUE(definition.instantiate(&instance));
+    }
+
+    EXPECT_EQ(definition.getInstanceCount(), Instances);
+
+    std::vector<std::thread> threads;
+    for (EngineInstance &instance : instances) {
+        threads.emplace_back([&instance]() { instance.destroy(); });
+    }
+
+    for (std::thread &thread : threads) thread.join();
+
+    EXPECT_EQ(definition.getInstanceCount(), 0);
+    definition.destroy();
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "../include/engine_loader.h"
+
+#include "../include/engine_snapshot.h"
+#include "test_engine.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// The test twin with settings a script might have set
+EngineLoader::Result compiledTwin() {
+    EngineLoader::Result result;
+    result.engine = test_engine::buildEngine();
+    result.vehicle = test_engine::buildVehicle();
+    result.transmission = test_engine::buildTransmission();
+    result.configured = true;
+    result.settings.powerUnits = "kw";
+    result.settings.audioLatency = 0.035;
+    result.settings.threadedPhysics = true;
+    result.settings.audioCore = 3;
+    result.settings.telemetryExport = "twin_telemetry";
+
+    return result;
+}
+
+uint64_t structureHash(const EngineLoader::Result &result) {
+    uint64_t hash = 0;
+    EXPECT_TRUE(EngineSnapshot::hashStructure(result.engine, result.vehicle, result.transmission, &hash));
+    return hash;
+}
+
+} /* namespace */
+
+TEST(EngineLoaderTests, CompiledScriptRoundTrip) {
+    EngineLoader::Result written = compiledTwin();
+
+    std::vector<char> data;
+    ASSERT_TRUE(EngineLoader::WriteCompiledScript(written, &data));
+
+    EngineLoader::Result read;
+    ASSERT_TRUE(EngineLoader::ReadCompiledScript(data.data(), data.size(), &read));
+    ASSERT_NE(read.engine, nullptr);
+    ASSERT_NE(read.vehicle, nullptr);
+    ASSERT_NE(read.transmission, nullptr);
+    EXPECT_EQ(read.simulator, nullptr);
+    EXPECT_TRUE(read.cached);
+    EXPECT_TRUE(read.configured);
+
+    EXPECT_EQ(read.settings.powerUnits, "kw");
+    EXPECT_EQ(read.settings.audioLatency, 0.035);
+    EXPECT_TRUE(read.settings.threadedPhysics);
+    EXPECT_EQ(read.settings.audioCore, 3);
+    EXPECT_EQ(read.settings.telemetryExport, "twin_telemetry");
+    EXPECT_EQ(read.settings.torqueUnits, written.settings.torqueUnits);
+
+    EXPECT_EQ(read.engine->getName(), written.engine->getName());
+    EXPECT_EQ(read.engine->getCylinderCount(), written.engine->getCylinderCount());
+    EXPECT_EQ(read.transmission->getGearCount(), written.transmission->getGearCount());
+    EXPECT_EQ(structureHash(read), structureHash(written));
+
+    // Written again, nothing was lost on the way
+    std::vector<char> rewritten;
+    ASSERT_TRUE(EngineLoader::WriteCompiledScript(read, &rewritten));
+    EXPECT_EQ(rewritten, data);
+
+    EngineLoader::Release(&read);
+    EngineLoader::Release(&written);
+}
+
+TEST(EngineLoaderTests, CompiledScriptRejectsTruncation) {
+    EngineLoader::Result written = compiledTwin();
+
+    std::vector<char> data;
+    ASSERT_TRUE(EngineLoader::WriteCompiledScript(written, &data));
+
+    const size_t sizes[] = { 0, 3, data.size() / 2, data.size() - 1 };
+    for (const size_t size : sizes) {
+        EngineLoader::Result read;
+        EXPECT_FALSE(EngineLoader::ReadCompiledScript(data.data(), size, &read)) << "size " << size;
+        EXPECT_EQ(read.engine, nullptr);
+        EXPECT_FALSE(read.cached);
+    }
+
+    EngineLoader::Release(&written);
+}
+
+TEST(EngineLoaderTests, CompiledScriptKeyFollowsSources) {
+    const ArtifactCache::Key key = EngineLoader::CompiledScriptKey(0x1234);
+    EXPECT_EQ(key.getKind(), ArtifactCache::Kind::CompiledScript);
+    EXPECT_EQ(key.getHash(), EngineLoader::CompiledScriptKey(0x1234).getHash());
+    EXPECT_NE(key.getHash(), EngineLoader::CompiledScriptKey(0x1235).getHash());
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include "../include/engine_patch.h"
+
+#include "../include/simulator.h"
+#include "test_engine.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+
+using namespace test_engine;
+
+// A running twin and a freshly built one to patch it from
+struct Rig {
+    Engine *engine;
+    Vehicle *vehicle;
+    Transmission *transmission;
+    Simulator *simulator;
+
+    Engine *source;
+    Vehicle *sourceVehicle;
+    Transmission *sourceTransmission;
+
+    Rig() {
+        engine = buildEngine();
+        vehicle = buildVehicle();
+        transmission = buildTransmission();
+        simulator = engine->createSimulator(vehicle, transmission, false, false);
+
+        source = buildEngine();
+        sourceVehicle = buildVehicle();
+        sourceTransmission = buildTransmission();
+    }
+
+    ~Rig() {
+        simulator->releaseSimulation();
+        delete simulator;
+        release(engine, vehicle, transmission);
+        release(source, sourceVehicle, sourceTransmission);
+    }
+
+    bool apply(EnginePatch::Statistics *statistics) {
+        // No decoded kernels; the simulator has no audio to swap them into
+        const std::vector<std::shared_ptr<const ImpulseResponseCache::Kernel>> kernels(
+            source->getExhaustSystemCount());
+        return EnginePatch::Apply(
+            simulator, source, sourceVehicle, sourceTransmission, kernels, statistics);
+    }
+
+    uint64_t hash(Engine *e, Vehicle *v, Transmission *t) {
+        uint64_t result = 0;
+        EXPECT_TRUE(EngineSnapshot::hashStructure(e, v, t, &result));
+        return result;
+    }
+};
+
+// Scales one sample of a function
+void scaleSample(Function *function, int sample, double scale) {
+    std::vector<double> x(function->getSampleCount()), y(function->getSampleCount());
+    for (int i = 0; i < function->getSampleCount(); ++i) {
+        x[i] = function->getSampleX(i);
+        y[i] = function->getSampleY(i);
+    }
+
+    y[sample] *= scale;
+    function->setSamples(x.data(), y.data(), function->getSampleCount(), true);
+}
+
+// Initialized again from its own parameters with another audio level
+void setAudioVolume(ExhaustSystem *exhaust, double audioVolume) {
+    ExhaustSystem::Parameters params;
+    params.length = exhaust->getLength();
+    params.collectorCrossSectionArea = exhaust->getCollectorCrossSectionArea();
+    params.outletFlowRate = exhaust->getOutletFlowRate();
+    params.primaryTubeLength = exhaust->getPrimaryTubeLength();
+    params.primaryFlowRate = exhaust->getPrimaryFlowRate();
+    params.velocityDecay = exhaust->getVelocityDecay();
+    params.audioVolume = audioVolume;
+    params.impulseResponse = exhaust->getImpulseResponse();
+    params.primarySegments = exhaust->getPrimarySegments();
+    exhaust->initialize(params);
+}
+
+} /* namespace */
+
+TEST(EnginePatchTests, AppliesTunablesInPlace) {
+    Rig rig;
+
+    std::vector<Function *> sourceFunctions, targetFunctions;
+    EngineSnapshot::collectFunctions(rig.source, &sourceFunctions);
+    EngineSnapshot::collectFunctions(rig.engine, &targetFunctions);
+    ASSERT_FALSE(sourceFunctions.empty());
+    ASSERT_EQ(sourceFunctions.size(), targetFunctions.size());
+
+    std::vector<ImpulseResponse *> sourceResponses, targetResponses;
+    EngineSnapshot::collectImpulseResponses(rig.source, &sourceResponses);
+    EngineSnapshot::collectImpulseResponses(rig.engine, &targetResponses);
+    ASSERT_EQ(sourceResponses.size(), 1u);
+    ASSERT_EQ(targetResponses.size(), 1u);
+
+    // A function sample, the exhaust's impulse response volume and its
+    // audio level, none of which are structure
+    const int changed = static_cast<int>(sourceFunctions.size()) - 1;
+    scaleSample(sourceFunctions[changed], 5, 1.5);
+    sourceResponses[0]->initialize(sourceResponses[0]->getFilename(), 0.03);
+    setAudioVolume(rig.source->getExhaustSystem(0), 0.8);
+
+    EXPECT_EQ(
+        rig.hash(rig.source, rig.sourceVehicle, rig.sourceTransmission),
+        rig.hash(rig.engine, rig.vehicle, rig.transmission));
+    ASSERT_FALSE(targetFunctions[changed]->matches(*sourceFunctions[changed]));
+
+    EnginePatch::Statistics statistics;
+    ASSERT_TRUE(rig.apply(&statistics));
+    EXPECT_EQ(statistics.functions, 1);
+    EXPECT_EQ(statistics.impulseResponses, 1);
+    EXPECT_FALSE(statistics.ignition);
+    EXPECT_TRUE(statistics.audio);
+
+    EXPECT_EQ(rig.simulator->getEngine(), rig.engine);
+    for (size_t i = 0; i < targetFunctions.size(); ++i) {
+        EXPECT_TRUE(targetFunctions[i]->matches(*sourceFunctions[i])) << "function " << i;
+    }
+
+    EXPECT_DOUBLE_EQ(targetFunctions[changed]->getSampleY(5), sourceFunctions[changed]->getSampleY(5));
+    EXPECT_EQ(targetResponses[0]->getVolume(), 0.03);
+    EXPECT_EQ(targetResponses[0]->getFilename(), sourceResponses[0]->getFilename());
+    EXPECT_EQ(rig.engine->getExhaustSystem(0)->getAudioVolume(), 0.8);
+
+    // Nothing left to apply the second time
+    ASSERT_TRUE(rig.apply(&statistics));
+    EXPECT_EQ(statistics.functions, 0);
+    EXPECT_EQ(statistics.impulseResponses, 0);
+    EXPECT_FALSE(statistics.ignition);
+    EXPECT_FALSE(statistics.audio);
+}
+
+TEST(EnginePatchTests, RejectsStructureChange) {
+    Rig rig;
+
+    const uint64_t hash = rig.hash(rig.source, rig.sourceVehicle, rig.sourceTransmission);
+    ASSERT_EQ(hash, rig.hash(rig.engine, rig.vehicle, rig.transmission));
+
+    // A tunable alongside a change to the gas path
+    std::vector<Function *> sourceFunctions, targetFunctions;
+    EngineSnapshot::collectFunctions(rig.source, &sourceFunctions);
+    EngineSnapshot::collectFunctions(rig.engine, &targetFunctions);
+    scaleSample(sourceFunctions[0], 3, 2.0);
+    setAudioVolume(rig.source->getExhaustSystem(0), 0.8);
+
+    CylinderHead *head = rig.source->getHead(0);
+    head->setHeaderPrimaryLength(0, head->getHeaderPrimaryLength(0) * 2);
+    EXPECT_NE(rig.hash(rig.source, rig.sourceVehicle, rig.sourceTransmission), hash);
+
+    EnginePatch::Statistics statistics;
+    statistics.functions = 7;
+    EXPECT_FALSE(rig.apply(&statistics));
+    EXPECT_EQ(statistics.functions, 0);
+    EXPECT_EQ(statistics.impulseResponses, 0);
+    EXPECT_FALSE(statistics.ignition);
+    EXPECT_FALSE(statistics.audio);
+
+    // The running engine is left alone
+    EXPECT_FALSE(targetFunctions[0]->matches(*sourceFunctions[0]));
+    EXPECT_EQ(rig.engine->getExhaustSystem(0)->getAudioVolume(), 0.5);
+    EXPECT_EQ(rig.hash(rig.engine, rig.vehicle, rig.transmission), hash);
+}
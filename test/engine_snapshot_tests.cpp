@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include "../include/engine_snapshot.h"
+
+#include "test_engine.h"
+
+#include <vector>
+
+namespace {
+
+using namespace test_engine;
+
+// A whole snapshot of the twin, as written to a file
+std::vector<char> snapshotOfTwin() {
+    Engine *engine = buildEngine();
+    Vehicle *vehicle = buildVehicle();
+    Transmission *transmission = buildTransmission();
+
+    std::vector<char> data;
+    EXPECT_TRUE(EngineSnapshot::write(&data, engine, vehicle, transmission));
+    release(engine, vehicle, transmission);
+
+    return data;
+}
+
+} /* namespace */
+
+TEST(EngineSnapshotTests, WriteReadWriteIsIdentical) {
+    const std::vector<char> written = snapshotOfTwin();
+    ASSERT_GT(written.size(), sizeof(EngineSnapshot::Header));
+
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+    ASSERT_TRUE(EngineSnapshot::read(
+        written.data(), written.size(), &engine, &vehicle, &transmission));
+    ASSERT_NE(vehicle, nullptr);
+    ASSERT_NE(transmission, nullptr);
+
+    EXPECT_EQ(engine->getName(), "Snapshot Twin");
+    EXPECT_EQ(engine->getCylinderCount(), 2);
+    EXPECT_EQ(transmission->getGearCount(), 4);
+
+    std::vector<char> rewritten;
+    EXPECT_TRUE(EngineSnapshot::write(&rewritten, engine, vehicle, transmission));
+    EXPECT_EQ(rewritten, written);
+
+    release(engine, vehicle, transmission);
+}
+
+TEST(EngineSnapshotTests, SharedTablesReadIdentically) {
+    const std::vector<char> written = snapshotOfTwin();
+
+    // The second read reuses the first one's functions and lobes
+    EngineSnapshot::SharedTables shared;
+    for (int i = 0; i < 2; ++i) {
+        Engine *engine = nullptr;
+        Vehicle *vehicle = nullptr;
+        Transmission *transmission = nullptr;
+        ASSERT_TRUE(EngineSnapshot::read(
+            written.data(), written.size(), &engine, &vehicle, &transmission, &shared));
+
+        std::vector<char> rewritten;
+        EXPECT_TRUE(EngineSnapshot::write(&rewritten, engine, vehicle, transmission));
+        EXPECT_EQ(rewritten, written) << "read " << i;
+
+        delete vehicle;
+        delete transmission;
+        EngineSnapshot::releaseTables(engine, &shared);
+        engine->destroy();
+        delete engine;
+    }
+
+    EXPECT_GT(shared.getFunctionCount(), 0);
+    shared.release();
+}
+
+TEST(EngineSnapshotTests, RejectsFlippedByte) {
+    const std::vector<char> written = snapshotOfTwin();
+
+    for (size_t i = 0; i < written.size(); ++i) {
+        std::vector<char> corrupt = written;
+        corrupt[i] ^= 0x10;
+
+        Engine *engine = nullptr;
+        Vehicle *vehicle = nullptr;
+        Transmission *transmission = nullptr;
+        EXPECT_FALSE(EngineSnapshot::read(
+            corrupt.data(), corrupt.size(), &engine, &vehicle, &transmission))
+            << "byte " << i;
+        EXPECT_EQ(engine, nullptr);
+
+        release(engine, vehicle, transmission);
+    }
+
+    // Nor is a snapshot cut short
+    Engine *engine = nullptr;
+    Vehicle *vehicle = nullptr;
+    Transmission *transmission = nullptr;
+    EXPECT_FALSE(EngineSnapshot::read(
+        written.data(), written.size() - 1, &engine, &vehicle, &transmission));
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include "../include/event_counters.h"
+#include "../include/gas_system.h"
+#include "../include/units.h"
+
+#include <thread>
+
+TEST(EventCountersTests, CountsChokedFlowsAcrossThreads) {
+    if (!EventCounters::IsEnabled()) {
+        EventCounters::Totals totals;
+        EventCounters::GetTotals(&totals);
+        EXPECT_EQ(totals.get(EventCounters::Counter::GasFlows), 0u);
+        GTEST_SKIP() << "built without ENGINE_SIM_COUNT_EVENTS";
+    }
+
+    const GasSystem::FlowConstants constants = GasSystem::flowConstants(5);
+    const double T = units::celcius(25.0);
+
+    EventCounters::Totals before;
+    EventCounters::GetTotals(&before);
+
+    // One choked flow here, one unchoked on another thread
+    GasSystem::flowRate(1.0, units::pressure(10, units::atm), units::pressure(1, units::atm), T, T, constants);
+    std::thread worker([&] {
+        GasSystem::flowRate(1.0, units::pressure(1.1, units::atm), units::pressure(1, units::atm), T, T, constants);
+    });
+    worker.join();
+
+    EventCounters::Totals after;
+    EventCounters::GetTotals(&after);
+    const EventCounters::Totals counted = after.since(before);
+
+    EXPECT_EQ(counted.get(EventCounters::Counter::GasFlows), 2u);
+    EXPECT_EQ(counted.get(EventCounters::Counter::ChokedFlows), 1u);
+    EXPECT_DOUBLE_EQ(counted.chokedFraction(), 0.5);
+}
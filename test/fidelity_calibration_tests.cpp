@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "../include/fidelity_calibration.h"
+
+namespace {
+FidelityCalibration::Measurement measurement() {
+    FidelityCalibration::Measurement m;
+    m.frequency = 20000;
+    m.fluidSteps = 8;
+    m.fixedMicroseconds = 10.0;
+    m.substepMicroseconds = 2.0;
+    m.directConvolutionMicroseconds = 0.5;
+    m.partitionedConvolutionMicroseconds = 0.05;
+    m.convolutionChannels = 2;
+    m.audioSampleRate = 44100;
+
+    return m;
+}
+} /* namespace */
+
+TEST(FidelityCalibrationTests, KeepsScriptFidelityWhenItFits) {
+    FidelityCalibration::Settings settings;
+
+    // 20 kHz * (10 + 2 * 8) us = 52% of real time
+    const FidelityCalibration::Result result = FidelityCalibration::Choose(measurement(), settings);
+    EXPECT_TRUE(result.sustainable);
+    EXPECT_EQ(result.simulationFrequency, 20000);
+    EXPECT_EQ(result.fluidSimulationSteps, 8);
+    EXPECT_TRUE(result.partitionedConvolution);
+    EXPECT_NEAR(result.physicsLoad, 0.52, 1E-9);
+}
+
+TEST(FidelityCalibrationTests, LowersSubstepsBeforeFrequency) {
+    FidelityCalibration::Settings settings;
+    settings.headroom = 0.4;
+
+    // 20 kHz fits with 5 substeps: 20 kHz * (10 + 2 * 5) us = 40%
+    FidelityCalibration::Result result = FidelityCalibration::Choose(measurement(), settings);
+    EXPECT_TRUE(result.sustainable);
+    EXPECT_EQ(result.simulationFrequency, 20000);
+    EXPECT_EQ(result.fluidSimulationSteps, 5);
+
+    // Not even one substep fits at 20 kHz; 16 kHz * (10 + 2) us = 19.2%
+    settings.headroom = 0.2;
+    result = FidelityCalibration::Choose(measurement(), settings);
+    EXPECT_TRUE(result.sustainable);
+    EXPECT_EQ(result.simulationFrequency, 16000);
+    EXPECT_EQ(result.fluidSimulationSteps, 1);
+}
+
+TEST(FidelityCalibrationTests, ReportsUnsustainableHosts) {
+    FidelityCalibration::Settings settings;
+    settings.headroom = 0.01;
+
+    const FidelityCalibration::Result result = FidelityCalibration::Choose(measurement(), settings);
+    EXPECT_FALSE(result.sustainable);
+    EXPECT_EQ(result.simulationFrequency, settings.minFrequency);
+    EXPECT_EQ(result.fluidSimulationSteps, 1);
+}
+
+TEST(FidelityCalibrationTests, PrefersDirectConvolutionForShortResponses) {
+    FidelityCalibration::Measurement m = measurement();
+    m.directConvolutionMicroseconds = 0.01;
+
+    const FidelityCalibration::Result result =
+        FidelityCalibration::Choose(m, FidelityCalibration::Settings());
+    EXPECT_FALSE(result.partitionedConvolution);
+    EXPECT_NEAR(result.convolutionLoad, 1E-6 * 44100 * 2 * 0.01, 1E-12);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include "../include/file_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int Debounce = 20;
+
+// A scratch directory with a watcher on a few of its files
+struct Rig {
+    std::filesystem::path directory;
+    FileWatcher watcher;
+
+    Rig() {
+        directory = std::filesystem::temp_directory_path() / "engine_sim_file_watcher_tests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        directory = std::filesystem::canonical(directory);
+
+        watcher.initialize(Debounce);
+    }
+
+    ~Rig() {
+        watcher.destroy();
+        std::filesystem::remove_all(directory);
+    }
+
+    std::string path(const std::string &name) const {
+        return (directory / name).string();
+    }
+
+    void write(const std::string &name, const std::string &contents) const {
+        std::ofstream file(path(name), std::ios::trunc);
+        file << contents;
+    }
+
+    // Waits for the subscription to land before anything is changed
+    void watch(const std::vector<std::string> &names) {
+        std::vector<std::string> files;
+        for (const std::string &name : names) files.push_back(path(name));
+        watcher.watch(files);
+        ASSERT_TRUE(watcher.waitForSubscription(std::chrono::seconds(2)));
+    }
+
+    // Every change reported until name is among them, or two seconds pass
+    std::vector<std::string> changesUntil(const std::string &name) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+        std::vector<std::string> files, more;
+        while (std::find(files.begin(), files.end(), path(name)) == files.end()
+            && std::chrono::steady_clock::now() < deadline)
+        {
+            if (watcher.takeChanges(&more)) files.insert(files.end(), more.begin(), more.end());
+            else std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+};
+
+} /* namespace */
+
+TEST(FileWatcherTests, ReportsCreatedFile) {
+    Rig rig;
+    rig.watch({ "engine.mr" });
+
+    rig.write("engine.mr", "created");
+    EXPECT_EQ(rig.changesUntil("engine.mr"), std::vector<std::string>{ rig.path("engine.mr") });
+}
+
+TEST(FileWatcherTests, ReportsModifiedFileOnce) {
+    Rig rig;
+    rig.write("engine.mr", "original");
+    rig.write("fence.mr", "original");
+    rig.write("other.mr", "original");
+    rig.watch({ "engine.mr", "fence.mr" });
+
+    // A burst of writes settles into one change, and files outside the
+    // set are left out; the fence is written last, so once it is reported
+    // everything before it has been
+    for (int i = 0; i < 5; ++i) rig.write("engine.mr", "edit " + std::to_string(i));
+    rig.write("other.mr", "edit");
+    rig.write("fence.mr", "edit");
+
+    const std::vector<std::string> expected = { rig.path("engine.mr"), rig.path("fence.mr") };
+    EXPECT_EQ(rig.changesUntil("fence.mr"), expected);
+}
+
+TEST(FileWatcherTests, ReportsFileReplacedByRename) {
+    Rig rig;
+    rig.write("engine.mr", "original");
+    rig.watch({ "engine.mr" });
+
+    // How editors that save atomically write
+    rig.write("engine.mr.tmp", "saved");
+    std::filesystem::rename(rig.path("engine.mr.tmp"), rig.path("engine.mr"));
+    EXPECT_EQ(rig.changesUntil("engine.mr"), std::vector<std::string>{ rig.path("engine.mr") });
+}
+
+TEST(FileWatcherTests, SkipsEventsWhileUnwatched) {
+    Rig rig;
+    rig.write("engine.mr", "original");
+    rig.write("fence.mr", "original");
+    rig.watch({ "engine.mr" });
+    rig.watch({});
+
+    // Only the fence, watched after the edit, is reported
+    rig.write("engine.mr", "edit");
+    rig.watch({ "fence.mr" });
+    rig.write("fence.mr", "edit");
+    EXPECT_EQ(rig.changesUntil("fence.mr"), std::vector<std::string>{ rig.path("fence.mr") });
+}
+
+TEST(FileWatcherTests, WaitsForSubscriptionOnResume) {
+    Rig rig;
+    rig.watcher.setSuspended(true);
+
+    // Left for the watcher thread, which sleeps until resumed
+    rig.watcher.watch({ rig.path("engine.mr") });
+    EXPECT_FALSE(rig.watcher.waitForSubscription(std::chrono::milliseconds(20)));
+
+    rig.watcher.setSuspended(false);
+    ASSERT_TRUE(rig.watcher.waitForSubscription(std::chrono::seconds(2)));
+
+    rig.write("engine.mr", "created");
+    EXPECT_EQ(rig.changesUntil("engine.mr"), std::vector<std::string>{ rig.path("engine.mr") });
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include "../include/debug_trace.h"
+#include "../include/flight_recorder.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+std::string testDirectory() {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "engine_sim_flight_recorder_tests";
+    std::filesystem::create_directories(directory);
+
+    return directory.string();
+}
+
+void recordStep(FlightRecorder *recorder, uint64_t step, float pressure) {
+    const FlightRecorder::Frame frame = recorder->beginFrame();
+    *frame.header = FlightRecorder::FrameHeader();
+    frame.header->step = step;
+    frame.header->time = step * 1E-4;
+
+    for (int i = 0; i < recorder->getBodyCount(); ++i) {
+        frame.bodies[i] = { 0.0f, 0.0f, (float)step, 0.0f, 0.0f, 100.0f };
+    }
+
+    for (int i = 0; i < recorder->getChamberCount(); ++i) {
+        frame.chambers[i] = { pressure, 300.0f, 0.01f, 1E-4f, 0.0f, 0.0f };
+    }
+
+    recorder->commit();
+}
+
+// The steps of every frame in a dump, checking its header on the way
+std::vector<uint64_t> readSteps(const std::string &path, FlightRecorder::DumpHeader *header) {
+    std::ifstream in(path, std::ios::binary);
+    in.read(reinterpret_cast<char *>(header), sizeof(*header));
+    EXPECT_EQ(header->magic, FlightRecorder::Magic);
+    EXPECT_EQ(header->version, FlightRecorder::Version);
+    EXPECT_EQ(header->frameSize, FlightRecorder::GetFrameSize(header->bodyCount, header->chamberCount));
+
+    std::vector<uint64_t> steps;
+    std::vector<char> frame(header->frameSize);
+    for (uint32_t i = 0; i < header->frameCount; ++i) {
+        in.read(frame.data(), frame.size());
+        steps.push_back(reinterpret_cast<const FlightRecorder::FrameHeader *>(frame.data())->step);
+    }
+
+    EXPECT_TRUE(in.good());
+    return steps;
+}
+
+} /* namespace */
+
+TEST(FlightRecorderTests, DumpsTheLastFramesOldestFirst) {
+    FlightRecorder::Parameters params;
+    params.capacity = 8;
+    params.directory = testDirectory();
+
+    FlightRecorder recorder;
+    recorder.initialize(params);
+    recorder.setLayout(3, 2);
+    EXPECT_EQ(recorder.dump("empty"), "");
+
+    for (uint64_t step = 0; step < 13; ++step) recordStep(&recorder, step, 1E5f);
+    EXPECT_EQ(recorder.getFrameCount(), 8);
+    EXPECT_EQ(recorder.getDumpCount(), 0);
+
+    const std::string path = recorder.dump("test");
+    ASSERT_FALSE(path.empty());
+
+    FlightRecorder::DumpHeader header;
+    const std::vector<uint64_t> steps = readSteps(path, &header);
+    EXPECT_EQ(header.bodyCount, 3u);
+    EXPECT_EQ(header.chamberCount, 2u);
+    EXPECT_EQ(header.step, 12u);
+    EXPECT_STREQ(header.reason, "test");
+    EXPECT_EQ(steps, std::vector<uint64_t>({ 5, 6, 7, 8, 9, 10, 11, 12 }));
+
+    std::filesystem::remove(path);
+    recorder.destroy();
+}
+
+TEST(FlightRecorderTests, DumpsOncePerAnomaly) {
+    FlightRecorder::Parameters params;
+    params.capacity = 16;
+    params.directory = testDirectory();
+    params.maxAnomalyDumps = 2;
+
+    FlightRecorder recorder;
+    recorder.initialize(params);
+    recorder.setLayout(1, 1);
+
+    for (uint64_t step = 0; step < 4; ++step) recordStep(&recorder, step, 1E5f);
+    recordStep(&recorder, 4, NAN);
+    recordStep(&recorder, 5, NAN);
+    EXPECT_EQ(recorder.getDumpCount(), 1);
+
+    FlightRecorder::DumpHeader header;
+    std::vector<uint64_t> steps = readSteps(recorder.getLastDumpPath(), &header);
+    EXPECT_EQ(header.anomaly, static_cast<uint32_t>(FlightRecorder::Anomaly::NonFinite));
+    EXPECT_EQ(steps.back(), 4u);
+    std::filesystem::remove(recorder.getLastDumpPath());
+
+    // Healthy again, then out of bounds; the limit holds after that
+    recordStep(&recorder, 6, 1E5f);
+    recordStep(&recorder, 7, 1E9f);
+    EXPECT_EQ(recorder.getDumpCount(), 2);
+    readSteps(recorder.getLastDumpPath(), &header);
+    EXPECT_EQ(header.anomaly, static_cast<uint32_t>(FlightRecorder::Anomaly::Pressure));
+    std::filesystem::remove(recorder.getLastDumpPath());
+
+    recordStep(&recorder, 8, 1E5f);
+    recordStep(&recorder, 9, NAN);
+    EXPECT_EQ(recorder.getDumpCount(), 2);
+
+    recorder.destroy();
+}
+
+TEST(FlightRecorderTests, DumpsOnRequest) {
+    FlightRecorder::Parameters params;
+    params.capacity = 16;
+    params.directory = testDirectory();
+
+    FlightRecorder recorder;
+    recorder.initialize(params);
+    recorder.setLayout(2, 1);
+
+    recordStep(&recorder, 0, 1E5f);
+    DebugTrace::RequestDump("test");
+    recordStep(&recorder, 1, 1E5f);
+    recordStep(&recorder, 2, 1E5f);
+    EXPECT_EQ(recorder.getDumpCount(), 1);
+
+    FlightRecorder::DumpHeader header;
+    EXPECT_EQ(readSteps(recorder.getLastDumpPath(), &header), std::vector<uint64_t>({ 0, 1 }));
+    EXPECT_EQ(header.anomaly, static_cast<uint32_t>(FlightRecorder::Anomaly::Request));
+    std::filesystem::remove(recorder.getLastDumpPath());
+
+    // The recorder stepping on this thread
+    FlightRecorder::SetCurrent(&recorder);
+    FlightRecorder::DumpCurrent("current");
+    EXPECT_EQ(recorder.getDumpCount(), 2);
+    std::filesystem::remove(recorder.getLastDumpPath());
+
+    recorder.destroy();
+    EXPECT_EQ(FlightRecorder::GetCurrent(), nullptr);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include "../include/flow_graph.h"
+#include "../include/units.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// A plenum and its runners wired up by hand in place of compile(), which
+// needs a whole engine
+class StarFlowGraph : public FlowGraph {
+    public:
+        static constexpr int Runners = 4;
+
+        StarFlowGraph(double k_flow) {
+            m_k_flow = k_flow;
+
+            plenum.initialize(
+                units::pressure(1.0, units::atm),
+                units::volume(500.0, units::cc),
+                units::celcius(25.0));
+            for (int i = 0; i < Runners; ++i) {
+                runners[i].initialize(
+                    units::pressure(0.3 + 0.1 * i, units::atm),
+                    units::volume(50.0, units::cc),
+                    units::celcius(25.0));
+            }
+
+            const int connections = Runners;
+            m_volumes = new GasSystem *[1 + Runners];
+            m_crossSectionArea = new double[1 + Runners];
+            m_connections = new Connection[connections];
+            m_groupedConnections = new int[connections];
+            m_groups = new Group[connections];
+            m_flowStates = new GasSystem::FlowState[connections];
+            m_timesteps = new double[connections];
+            m_coefficients = new double[connections];
+            m_hubCoefficients = new double[connections];
+            m_pressureDrops = new double[connections];
+
+            addVolume(&plenum, units::area(20.0, units::cm2));
+            for (int i = 0; i < Runners; ++i) {
+                addVolume(&runners[i], units::area(5.0, units::cm2));
+
+                Connection &connection = m_connections[m_connectionCount++];
+                connection.system_0 = 0;
+                connection.system_1 = 1 + i;
+                connection.k_flow = &m_k_flow;
+                connection.pipe = &m_pipe;
+                connection.valveFlowRate = &m_valveFlowRate;
+                connection.coarsening = &m_coarsening;
+                connection.pendingSubsteps = &m_pendingSubsteps[i];
+                connection.pendingTime = &m_pendingTime[i];
+            }
+
+            m_stageBegin[(int)Stage::Intake] = 0;
+            m_stageBegin[(int)Stage::Exhaust] = m_connectionCount;
+            m_stageBegin[(int)Stage::Count] = m_connectionCount;
+            groupStage(Stage::Intake);
+            groupStage(Stage::Exhaust);
+        }
+
+        ~StarFlowGraph() {
+            destroy();
+        }
+
+        double totalN() const {
+            double n = plenum.n();
+            for (const GasSystem &runner : runners) n += runner.n();
+            return n;
+        }
+
+        GasSystem plenum;
+        GasSystem runners[Runners];
+
+    protected:
+        double m_k_flow;
+        PipeSegments *m_pipe = nullptr;
+        double m_valveFlowRate = 1.0;
+        int m_coarsening = 1;
+        int m_pendingSubsteps[Runners] = {};
+        double m_pendingTime[Runners] = {};
+};
+} /* namespace */
+
+TEST(FlowGraphTests, StarIsGroupedByHub) {
+    StarFlowGraph graph(GasSystem::k_28inH2O(100.0));
+    ASSERT_EQ(graph.getGroupCount(FlowGraph::Stage::Intake), 1);
+    EXPECT_EQ(graph.getGroupCount(FlowGraph::Stage::Exhaust), 0);
+
+    const FlowGraph::Group &group = graph.getGroup(FlowGraph::Stage::Intake, 0);
+    EXPECT_EQ(group.hub, 0);
+    EXPECT_EQ(group.end - group.begin, StarFlowGraph::Runners);
+}
+
+TEST(FlowGraphTests, ImplicitMatchesExplicitAtSmallSubsteps) {
+    StarFlowGraph explicitGraph(GasSystem::k_28inH2O(100.0));
+    StarFlowGraph implicitGraph(GasSystem::k_28inH2O(100.0));
+    implicitGraph.setImplicit(true);
+
+    const double dt = 1 / 200000.0;
+    for (int i = 0; i < 200; ++i) {
+        explicitGraph.sweep(FlowGraph::Stage::Intake, dt);
+        implicitGraph.sweep(FlowGraph::Stage::Intake, dt);
+    }
+
+    for (int i = 0; i < StarFlowGraph::Runners; ++i) {
+        const double p_explicit = explicitGraph.runners[i].pressure();
+        const double p_implicit = implicitGraph.runners[i].pressure();
+        EXPECT_NEAR(p_implicit, p_explicit, 0.01 * p_explicit);
+    }
+
+    EXPECT_NEAR(implicitGraph.totalN(), explicitGraph.totalN(), 1E-9 * explicitGraph.totalN());
+}
+
+TEST(FlowGraphTests, ImplicitStaysStableAtLargeSubsteps) {
+    StarFlowGraph explicitGraph(GasSystem::k_28inH2O(400.0));
+    StarFlowGraph implicitGraph(GasSystem::k_28inH2O(400.0));
+    implicitGraph.setImplicit(true);
+
+    const double n0 = implicitGraph.totalN();
+    const double dt = 1 / 5000.0;
+
+    // The pairwise sweep pushes the runners far past the plenum and
+    // diverges; solved together they fill toward it, overshooting less than
+    // the gas's own momentum makes them at fine substeps, and settle
+    double explicitOvershoot = 0, implicitOvershoot = 0;
+    for (int step = 0; step < 50; ++step) {
+        explicitGraph.sweep(FlowGraph::Stage::Intake, dt);
+        implicitGraph.sweep(FlowGraph::Stage::Intake, dt);
+
+        for (int i = 0; i < StarFlowGraph::Runners; ++i) {
+            const double p_explicit = explicitGraph.runners[i].pressure() / explicitGraph.plenum.pressure() - 1;
+            const double p_implicit = implicitGraph.runners[i].pressure() / implicitGraph.plenum.pressure() - 1;
+            if (!std::isfinite(p_explicit) || p_explicit > explicitOvershoot) explicitOvershoot = p_explicit;
+            implicitOvershoot = std::max(implicitOvershoot, p_implicit);
+        }
+    }
+
+    EXPECT_FALSE(explicitOvershoot < 0.5);
+    EXPECT_LT(implicitOvershoot, 0.01);
+
+    for (const GasSystem &runner : implicitGraph.runners) {
+        EXPECT_NEAR(runner.pressure(), implicitGraph.plenum.pressure(), 1E-3 * implicitGraph.plenum.pressure());
+    }
+
+    EXPECT_NEAR(implicitGraph.totalN(), n0, 1E-9 * n0);
+}
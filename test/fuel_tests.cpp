@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include "../include/fuel.h"
+
+#include <cmath>
+
+TEST(FuelTests, TabulatedBurningVelocityMatchesFormula) {
+    Fuel::Parameters params;
+    Fuel tabulated;
+    tabulated.initialize(params);
+    ASSERT_TRUE(tabulated.isBurningVelocityTabulated());
+
+    params.tabulateBurningVelocity = false;
+    Fuel direct;
+    direct.initialize(params);
+    ASSERT_FALSE(direct.isBurningVelocityTabulated());
+
+    const double bound = tabulated.getBurningVelocityTableError();
+    EXPECT_GT(bound, 0.0);
+    EXPECT_LT(bound, 0.02);
+
+    // Spark conditions, where the tables are finest
+    double maxError = 0.0;
+    for (double er = 0.6; er <= 1.6; er += 0.0173) {
+        for (double T = units::kelvin(350); T <= units::kelvin(1200); T += units::kelvin(13.7)) {
+            for (double P = units::pressure(2.0, units::atm); P <= units::pressure(80.0, units::atm); P += units::pressure(1.3, units::atm)) {
+                const double afr = er * params.molecularAfr;
+                const double exact = direct.laminarBurningVelocity(afr, T, P);
+                const double lookup = tabulated.laminarBurningVelocity(afr, T, P);
+                maxError = std::fmax(maxError, std::abs(lookup - exact) / std::abs(exact));
+            }
+        }
+    }
+
+    EXPECT_LT(maxError, bound);
+    EXPECT_LT(maxError, 0.002);
+
+    // Off the tables the formula is used as is
+    EXPECT_DOUBLE_EQ(
+        tabulated.laminarBurningVelocity(params.molecularAfr, units::kelvin(4000), units::pressure(1.0, units::atm)),
+        direct.laminarBurningVelocity(params.molecularAfr, units::kelvin(4000), units::pressure(1.0, units::atm)));
+}
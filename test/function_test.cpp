@@ -2,7 +2,10 @@
 
 #include "../include/function.h"
 
+#include <cmath>
+#include <iostream>
 #include <stdlib.h>
+#include <vector>
 
 TEST(FunctionTests, FunctionSanityCheck) {
     Function f;
@@ -78,3 +81,95 @@ TEST(FunctionTests, FunctionGaussianTest) {
 
     f.destroy();
 }
+
+TEST(FunctionTests, FunctionBakedMatchesFiltered) {
+    Function f;
+    f.initialize(0, 1.0);
+    for (int i = 0; i < 20; ++i) {
+        f.addSample((double)i, std::sin(i * 0.3) * 10.0);
+    }
+
+    f.bake(4096);
+    EXPECT_TRUE(f.isBaked());
+
+    Function reference;
+    reference.initialize(0, 1.0);
+    for (int i = 0; i < 20; ++i) {
+        reference.addSample((double)i, std::sin(i * 0.3) * 10.0);
+    }
+
+    for (double x = -10.0; x <= 30.0; x += 0.0137) {
+        EXPECT_NEAR(f.sampleTriangle(x), reference.sampleTriangle(x), 1E-2);
+
+        // sampleGaussian() steps just outside the end samples
+        if ((x > -0.1 && x < 0.0) || (x > 19.0 && x < 19.1)) continue;
+        EXPECT_NEAR(f.sampleGaussian(x), reference.sampleGaussian(x), 1E-2);
+    }
+
+    f.addSample(20.0, 0.0);
+    EXPECT_FALSE(f.isBaked());
+
+    f.destroy();
+    reference.destroy();
+}
+
+TEST(FunctionTests, FunctionAssignTest) {
+    Function source, target;
+    source.initialize(4, 1.0);
+    target.initialize(4, 1.0);
+
+    for (int i = 0; i < 10; ++i) {
+        source.addSample(i, i * 2.0);
+        target.addSample(i, 1.0);
+    }
+
+    source.bake();
+    EXPECT_FALSE(target.matches(source));
+
+    const unsigned int revision = target.getRevision();
+    target.assign(source);
+
+    EXPECT_TRUE(target.matches(source));
+    EXPECT_NE(target.getRevision(), revision);
+    for (int i = 0; i < 90; ++i) {
+        EXPECT_NEAR(target.sampleTriangle(i * 0.1), source.sampleTriangle(i * 0.1), 1E-9);
+    }
+
+    source.destroy();
+    target.destroy();
+}
+
+TEST(FunctionTests, FunctionSetSamplesMatchesAddSample) {
+    Function added, set;
+    added.initialize(0, 1.0);
+    set.initialize(0, 1.0);
+
+    std::vector<double> x, y;
+    for (int i = 0; i < 500; ++i) {
+        x.push_back(rand() % 1000 - 500.0);
+        y.push_back(i);
+        added.addSample(x.back(), y.back());
+    }
+
+    set.setSamples(x.data(), y.data(), (int)x.size());
+
+    EXPECT_TRUE(set.isOrdered());
+    EXPECT_EQ(set.getSampleCount(), 500);
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(set.getSampleX(i), added.getSampleX(i));
+    }
+
+    for (int i = -600; i < 600; ++i) {
+        EXPECT_NEAR(set.sampleTriangle(i * 0.9), added.sampleTriangle(i * 0.9), 1E-9);
+    }
+
+    // Replacing with fewer samples keeps the capacity and drops the rest
+    const double sortedX[] = { 0.0, 1.0, 2.0 };
+    const double sortedY[] = { 4.0, 5.0, 6.0 };
+    set.setSamples(sortedX, sortedY, 3, true);
+    EXPECT_EQ(set.getSampleCount(), 3);
+    EXPECT_NEAR(set.sampleTriangle(1.5), 5.5, 1E-9);
+
+    added.destroy();
+    set.destroy();
+}
@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+
+#include "../include/hardware_counters.h"
+
+TEST(HardwareCountersTests, CountsUserSpaceWork) {
+    HardwareCounters counters;
+    if (!counters.open()) {
+        GTEST_SKIP() << "hardware counters are unavailable on this system";
+    }
+
+    HardwareCounters::Sample start, end;
+    ASSERT_TRUE(counters.read(&start));
+
+    volatile double x = 1.0;
+    for (int i = 0; i < 1000000; ++i) {
+        x = x * 1.0000001 + 1e-9;
+    }
+
+    ASSERT_TRUE(counters.read(&end));
+
+    const HardwareCounters::Sample counted = end - start;
+    EXPECT_GT(counted.get(HardwareCounters::Counter::Instructions), 1000000u);
+    EXPECT_GT(counted.get(HardwareCounters::Counter::Cycles), 0u);
+    EXPECT_GT(counted.ipc(), 0.0);
+
+    counters.close();
+    EXPECT_FALSE(counters.isOpen());
+    EXPECT_FALSE(counters.read(&end));
+}
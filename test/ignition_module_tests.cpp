@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include "../include/constants.h"
+#include "../include/crankshaft.h"
+#include "../include/function.h"
+#include "../include/ignition_module.h"
+#include "../include/units.h"
+#include "../include/utilities.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr double FourPi = 4 * constants::pi;
+
+struct Firing {
+    int cylinder;
+
+    // Cycle angles at the start and end of the step that fired it
+    double r0, r1;
+};
+
+// A crankshaft turning at a steady speed in fixed crank angle steps, with a
+// flat timing curve
+struct Rig {
+    Crankshaft crankshaft;
+    Function timingCurve;
+    IgnitionModule ignition;
+    double step;
+
+    Rig(int cylinders, double advance, double stepAngle) {
+        Crankshaft::Parameters crankParams;
+        crankParams.mass = units::mass(30, units::kg);
+        crankParams.flywheelMass = units::mass(10, units::kg);
+        crankParams.momentOfInertia = 0.2;
+        crankParams.crankThrow = units::distance(2, units::inch);
+        crankParams.rodJournals = 1;
+        crankshaft.initialize(crankParams);
+        crankshaft.m_body.theta = 0.0;
+        crankshaft.m_body.v_theta = -units::rpm(3000);
+
+        timingCurve.initialize(2, units::rpm(20000));
+        timingCurve.addSample(0.0, advance);
+        timingCurve.addSample(units::rpm(10000), advance);
+
+        IgnitionModule::Parameters params;
+        params.cylinderCount = cylinders;
+        params.crankshaft = &crankshaft;
+        params.timingCurve = &timingCurve;
+        ignition.initialize(params);
+        ignition.m_enabled = true;
+
+        step = stepAngle;
+    }
+
+    ~Rig() {
+        ignition.destroy();
+        timingCurve.destroy();
+        crankshaft.destroy();
+    }
+
+    std::vector<Firing> run(int steps) {
+        const double dt = step / -crankshaft.m_body.v_theta;
+
+        std::vector<Firing> firings;
+        ignition.reset();
+        for (int i = 0; i < steps; ++i) {
+            const double r0 = crankshaft.getCycleAngle();
+            crankshaft.m_body.theta -= step;
+            ignition.update(dt);
+            const double r1 = crankshaft.getCycleAngle();
+
+            for (int j = 0; j < ignition.getCylinderCount(); ++j) {
+                if (ignition.getIgnitionEvent(j)) {
+                    firings.push_back({ j, r0, r1 });
+                }
+            }
+
+            ignition.resetIgnitionEvents();
+        }
+
+        return firings;
+    }
+};
+
+// The crank angle at which a plug fires falls inside the step it fired in
+void expectFiredAt(const Firing &firing, double angle) {
+    const double r0 = firing.r0;
+    const double r1 = (firing.r1 < r0) ? firing.r1 + FourPi : firing.r1;
+    double target = positiveMod(angle, FourPi);
+    if (target < r0) target += FourPi;
+
+    EXPECT_GE(target, r0) << "cylinder " << firing.cylinder;
+    EXPECT_LT(target, r1) << "cylinder " << firing.cylinder;
+}
+
+} /* namespace */
+
+TEST(IgnitionModuleTests, FiresInFiringOrder) {
+    // Four cylinders firing 1-3-4-2, one plug every 180 degrees
+    const int firingOrder[] = { 0, 2, 3, 1 };
+
+    Rig rig(4, 0.0, units::angle(1.0, units::deg));
+    for (int i = 0; i < 4; ++i) {
+        rig.ignition.setFiringOrder(firingOrder[i], (i + 0.25) * constants::pi);
+    }
+
+    const std::vector<Firing> firings = rig.run(3 * 720);
+    ASSERT_EQ(firings.size(), 12u);
+    for (size_t i = 0; i < firings.size(); ++i) {
+        EXPECT_EQ(firings[i].cylinder, firingOrder[i % 4]);
+        expectFiredAt(firings[i], ((i % 4) + 0.25) * constants::pi);
+    }
+}
+
+TEST(IgnitionModuleTests, AdvanceAndTrimFireEarlier) {
+    const double advance = units::angle(20.0, units::deg);
+    const double trim = units::angle(5.0, units::deg);
+    const double angles[] = {
+        units::angle(90.5, units::deg),
+        units::angle(270.5, units::deg),
+        units::angle(450.5, units::deg),
+        units::angle(719.5, units::deg)
+    };
+
+    Rig rig(4, advance, units::angle(1.0, units::deg));
+    for (int i = 0; i < 4; ++i) {
+        rig.ignition.setFiringOrder(i, angles[i]);
+    }
+
+    rig.ignition.setCylinderTrim(1, trim);
+
+    const std::vector<Firing> firings = rig.run(2 * 720);
+    ASSERT_EQ(firings.size(), 8u);
+    for (const Firing &firing : firings) {
+        const int i = firing.cylinder;
+        expectFiredAt(firing, angles[i] - advance - rig.ignition.getCylinderTrim(i));
+    }
+
+    // Each plug once per cycle
+    int fired[4] = {};
+    for (const Firing &firing : firings) ++fired[firing.cylinder];
+    for (int count : fired) EXPECT_EQ(count, 2);
+}
+
+TEST(IgnitionModuleTests, FiresAcrossCycleWrap) {
+    // A plug just before the end of the cycle, with a step that sweeps
+    // from before it to past the wrap
+    Rig rig(1, 0.0, units::angle(7.0, units::deg));
+    rig.ignition.setFiringOrder(0, FourPi - units::angle(0.5, units::deg));
+
+    const std::vector<Firing> firings = rig.run(3 * 720 / 7 + 1);
+    ASSERT_EQ(firings.size(), 3u);
+    for (const Firing &firing : firings) {
+        expectFiredAt(firing, FourPi - units::angle(0.5, units::deg));
+    }
+}
+
+TEST(IgnitionModuleTests, SparkCutSuppressesFiring) {
+    Rig rig(2, 0.0, units::angle(1.0, units::deg));
+    rig.ignition.setFiringOrder(0, 0.5 * constants::pi);
+    rig.ignition.setFiringOrder(1, 2.5 * constants::pi);
+
+    rig.ignition.setSparkCut(true);
+    EXPECT_TRUE(rig.run(720).empty());
+
+    rig.ignition.setSparkCut(false);
+    EXPECT_EQ(rig.run(720).size(), 2u);
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include "../include/artifact_cache.h"
+#include "../include/impulse_response_cache.h"
+#include "../include/impulse_response_processor.h"
+#include "../include/random_stream.h"
+#include "../include/wav_writer.h"
+
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+namespace {
+// Noise under an exponential decay, 60 dB down after decaySamples
+std::vector<float> decayingNoise(int samples, int decaySamples, int delay = 0) {
+    RandomStream random;
+    random.seed(42, 0);
+
+    std::vector<float> response(samples, 0.0f);
+    for (int i = delay; i < samples; ++i) {
+        const double envelope = std::pow(10.0, -3.0 * (i - delay) / decaySamples);
+        response[i] = static_cast<float>(envelope * (2 * random.uniform() - 1));
+    }
+
+    return response;
+}
+
+void load(const std::vector<float> &taps, ConvolutionFilter *filter) {
+    filter->initialize(static_cast<int>(taps.size()));
+    std::copy(taps.begin(), taps.end(), filter->getImpulseResponse());
+}
+} /* namespace */
+
+TEST(ImpulseResponseProcessorTests, EnergyTruncationKeepsTheSpectrum) {
+    const std::vector<float> response = decayingNoise(8000, 2000);
+
+    ConvolutionFilter original, processed;
+    load(response, &original);
+    load(response, &processed);
+
+    ImpulseResponseProcessor::Parameters params;
+    params.energyThreshold = 1E-6;
+    ImpulseResponseProcessor::Process(params, &processed);
+
+    // The last 60 dB of energy go a little past the 60 dB point
+    EXPECT_LT(processed.getSampleCount(), 4000);
+    EXPECT_GT(processed.getSampleCount(), 1500);
+
+    const ImpulseResponseProcessor::Report report =
+        ImpulseResponseProcessor::Compare(original, processed, 44100);
+    EXPECT_EQ(report.originalSamples, 8000);
+    EXPECT_LT(report.maxDeviation, 0.5);
+
+    // Nothing to cut from an impulse
+    load({ 1.0f, 0.0f, 0.0f }, &processed);
+    ImpulseResponseProcessor::Process(params, &processed);
+    EXPECT_EQ(processed.getSampleCount(), 1);
+
+    original.destroy();
+    processed.destroy();
+}
+
+TEST(ImpulseResponseProcessorTests, MinimumPhaseMovesEnergyForward) {
+    // Starts late and builds up, so most of its taps are spent on delay
+    std::vector<float> response = decayingNoise(4000, 1500, 1000);
+    for (int i = 1000; i < 1400; ++i) response[i] *= (i - 1000) / 400.0f;
+
+    std::vector<float> minimum;
+    ImpulseResponseProcessor::MinimumPhase(response.data(), static_cast<int>(response.size()), &minimum);
+    ASSERT_EQ(minimum.size(), response.size());
+
+    const int length = ImpulseResponseProcessor::EnergyLength(response.data(), 4000, 1E-6);
+    const int minimumLength = ImpulseResponseProcessor::EnergyLength(minimum.data(), 4000, 1E-6);
+    EXPECT_LT(minimumLength, length - 900);
+
+    ConvolutionFilter original, processed;
+    load(response, &original);
+    load(minimum, &processed);
+
+    const ImpulseResponseProcessor::Report report =
+        ImpulseResponseProcessor::Compare(original, processed, 44100);
+    EXPECT_LT(report.maxDeviation, 0.5);
+    EXPECT_LT(report.meanDeviation, 0.1);
+
+    original.destroy();
+    processed.destroy();
+}
+
+TEST(ImpulseResponseProcessorTests, CacheKeepsProcessedResponsesOnDisk) {
+    const std::filesystem::path directory =
+        std::filesystem::path(testing::TempDir()) / "impulse_response_processor_tests";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const std::vector<float> response = decayingNoise(6000, 1000);
+    std::vector<int16_t> samples(response.size());
+    for (size_t i = 0; i < response.size(); ++i) samples[i] = static_cast<int16_t>(20000 * response[i]);
+
+    const std::string path = (directory / "response.wav").string();
+    WavWriter writer;
+    ASSERT_TRUE(writer.open(path, 44100));
+    ASSERT_TRUE(writer.write(samples.data(), static_cast<int>(samples.size())));
+    ASSERT_TRUE(writer.close());
+
+    ArtifactCache::Shared().configure((directory / "cache").string());
+    ImpulseResponseCache::Clear();
+
+    const int hits = ImpulseResponseCache::GetDiskHitCount();
+    std::shared_ptr<const ImpulseResponseCache::Kernel> made = ImpulseResponseCache::Get(path, 1.0, 44100);
+    ASSERT_NE(made, nullptr);
+    EXPECT_EQ(ImpulseResponseCache::GetDiskHitCount(), hits);
+    EXPECT_LT(made->filter.getSampleCount(), 3000);
+
+    // A fresh process would find it on disk
+    ImpulseResponseCache::Clear();
+    std::shared_ptr<const ImpulseResponseCache::Kernel> read = ImpulseResponseCache::Get(path, 1.0, 44100);
+    ASSERT_NE(read, nullptr);
+    EXPECT_EQ(ImpulseResponseCache::GetDiskHitCount(), hits + 1);
+    ASSERT_EQ(read->filter.getSampleCount(), made->filter.getSampleCount());
+    for (int i = 0; i < read->filter.getSampleCount(); ++i) {
+        ASSERT_EQ(read->filter.getImpulseResponse()[i], made->filter.getImpulseResponse()[i]);
+    }
+
+    // Other settings make other files
+    ImpulseResponseProcessor::Parameters params;
+    params.minimumPhase = true;
+    ImpulseResponseCache::SetPreprocessing(params);
+    ASSERT_NE(ImpulseResponseCache::Get(path, 1.0, 44100), nullptr);
+    EXPECT_EQ(ImpulseResponseCache::GetDiskHitCount(), hits + 1);
+
+    ImpulseResponseCache::SetPreprocessing(ImpulseResponseProcessor::Parameters());
+    ArtifactCache::Shared().configure("");
+    ImpulseResponseCache::Clear();
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "../include/input_session.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+std::string sessionPath(const char *name) {
+    return (std::filesystem::path(testing::TempDir()) / name).string();
+}
+} /* namespace */
+
+TEST(InputSessionTests, RoundTrip) {
+    const std::string path = sessionPath("input_session_round_trip.eis");
+
+    InputSession recording;
+    ASSERT_TRUE(recording.record(path, 1234, 10000.0));
+    EXPECT_TRUE(recording.isRecording());
+
+    recording.write(0, ControlQueue::Control::Throttle, 0.25);
+    recording.write(0, ControlQueue::Control::Starter, 1.0);
+    recording.write(3, ControlQueue::Control::Throttle, 0.25);
+    recording.write(200, ControlQueue::Control::Throttle, 0.5);
+    ASSERT_TRUE(recording.flush());
+
+    // Gear changes step from wherever the gear is, so repeats are kept
+    recording.write(1000, ControlQueue::Control::Gear, 1.0);
+    recording.write(1000, ControlQueue::Control::Gear, 1.0);
+    EXPECT_EQ(recording.getEventCount(), 5);
+    ASSERT_TRUE(recording.close(5000));
+    EXPECT_FALSE(recording.isRecording());
+
+    InputSession replay;
+    ASSERT_TRUE(replay.load(path));
+    EXPECT_TRUE(replay.isReplaying());
+    EXPECT_EQ(replay.getSeed(), 1234);
+    EXPECT_EQ(replay.getSimulationFrequency(), 10000.0);
+    EXPECT_EQ(replay.getLength(), 5000);
+    EXPECT_EQ(replay.getEventCount(), 5);
+
+    const InputSession::Event *event = replay.next(0);
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ(event->control, ControlQueue::Control::Throttle);
+    EXPECT_EQ(event->value, 0.25);
+    ASSERT_NE(replay.next(0), nullptr);
+    EXPECT_EQ(replay.next(0), nullptr);
+
+    EXPECT_EQ(replay.next(199), nullptr);
+    event = replay.next(200);
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ(event->step, 200);
+    EXPECT_EQ(event->value, 0.5);
+
+    ASSERT_NE(replay.next(1000), nullptr);
+    ASSERT_NE(replay.next(1000), nullptr);
+    EXPECT_TRUE(replay.isFinished());
+
+    replay.close(0);
+    std::remove(path.c_str());
+}
+
+TEST(InputSessionTests, FullBufferDrops) {
+    const std::string path = sessionPath("input_session_drops.eis");
+
+    InputSession recording;
+    ASSERT_TRUE(recording.record(path, 0, 10000.0, 4));
+    for (int i = 0; i < 10; ++i) {
+        recording.write(i, ControlQueue::Control::Throttle, i / 10.0);
+    }
+
+    // Capacity counts the largest events, so at least that many fit
+    const size_t written = recording.getEventCount();
+    EXPECT_GE(written, 4);
+    EXPECT_GT(recording.getDroppedCount(), 0);
+    EXPECT_EQ(written + recording.getDroppedCount(), 10);
+
+    // Room again once flushed
+    ASSERT_TRUE(recording.flush());
+    recording.write(20, ControlQueue::Control::Throttle, 1.0);
+    EXPECT_EQ(recording.getEventCount(), written + 1);
+    ASSERT_TRUE(recording.close(20));
+
+    InputSession replay;
+    ASSERT_TRUE(replay.load(path));
+    EXPECT_EQ(replay.getEventCount(), written + 1);
+
+    replay.close(0);
+    std::remove(path.c_str());
+}
+
+TEST(InputSessionTests, TruncatedAndInvalidFiles) {
+    const std::string path = sessionPath("input_session_truncated.eis");
+
+    InputSession recording;
+    ASSERT_TRUE(recording.record(path, 7, 10000.0));
+    recording.write(10, ControlQueue::Control::Clutch, 0.5);
+    recording.write(40, ControlQueue::Control::Clutch, 1.0);
+    ASSERT_TRUE(recording.close(100));
+
+    const uintmax_t size = std::filesystem::file_size(path);
+
+    // Cut before the end marker, as a crash would leave it; it runs to its
+    // last event
+    std::filesystem::resize_file(path, size - 2);
+    InputSession replay;
+    ASSERT_TRUE(replay.load(path));
+    EXPECT_EQ(replay.getEventCount(), 2);
+    EXPECT_EQ(replay.getLength(), 40);
+
+    // Cut mid-event
+    std::filesystem::resize_file(path, size - 5);
+    EXPECT_FALSE(replay.load(path));
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not a session";
+    }
+
+    EXPECT_FALSE(replay.load(path));
+    EXPECT_FALSE(replay.load(sessionPath("input_session_missing.eis")));
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include "../include/job_system.h"
+
+#include <atomic>
+#include <vector>
+
+TEST(JobSystemTests, JobSystemSanityCheck) {
+    JobSystem system;
+    system.initialize(4);
+    system.destroy();
+}
+
+TEST(JobSystemTests, ParallelForRunsEveryIndexOnce) {
+    JobSystem system;
+    system.initialize(3);
+
+    std::vector<std::atomic<int>> counts(64);
+    for (std::atomic<int> &count : counts) count = 0;
+
+    long long expected = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const int n = 1 + i % 64;
+        system.parallelFor(n, [&counts](int j) { ++counts[j]; }, JobSystem::Priority::Normal, 1 + i % 5);
+        expected += n;
+    }
+
+    long long total = 0;
+    for (const std::atomic<int> &count : counts) total += count;
+
+    EXPECT_EQ(total, expected);
+    EXPECT_EQ(counts[0], 2000);
+
+    system.destroy();
+}
+
+TEST(JobSystemTests, NestedGroupsJoin) {
+    JobSystem system;
+    system.initialize(2);
+
+    std::atomic<int> leaves(0);
+    {
+        JobSystem::Group outer(&system);
+        for (int i = 0; i < 8; ++i) {
+            outer.run([&system, &leaves] {
+                JobSystem::Group inner(&system);
+                for (int j = 0; j < 8; ++j) {
+                    inner.run([&leaves] { ++leaves; });
+                }
+
+                inner.wait();
+                system.parallelFor(4, [&leaves](int) { ++leaves; });
+            });
+        }
+    }
+
+    EXPECT_EQ(leaves, 8 * (8 + 4));
+
+    system.destroy();
+}
+
+TEST(JobSystemTests, LoadingLeavesAWorkerForPhysics) {
+    JobSystem system;
+    system.initialize(2);
+
+    std::atomic<bool> release(false);
+    std::atomic<int> loading(0);
+
+    JobSystem::Group background(&system, JobSystem::Priority::Loading);
+    for (int i = 0; i < 4; ++i) {
+        background.run([&release, &loading] {
+            ++loading;
+            while (!release) std::this_thread::yield();
+        });
+    }
+
+    while (loading == 0) std::this_thread::yield();
+
+    // Neither the caller nor the free worker picks up the blocked loading
+    // jobs, so this completes while they're still waiting
+    std::atomic<int> physics(0);
+    system.parallelFor(16, [&physics](int) { ++physics; }, JobSystem::Priority::Physics);
+
+    EXPECT_EQ(physics, 16);
+    EXPECT_EQ(loading, 1);
+
+    release = true;
+    background.wait();
+
+    EXPECT_EQ(loading, 4);
+
+    system.destroy();
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "../include/kernel_dispatch.h"
+#include "../include/random_stream.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+std::vector<float> noise(RandomStream *random, int n, float scale) {
+    std::vector<float> v(n);
+    random->fill(v.data(), n, -scale, scale);
+
+    return v;
+}
+
+// Restores the ISA picked at startup
+class IsaScope {
+    public:
+        IsaScope() : m_saved(KernelDispatch::GetIsa()) { /* void */ }
+        ~IsaScope() { KernelDispatch::SetIsa(m_saved); }
+
+    private:
+        KernelDispatch::Isa m_saved;
+};
+} /* namespace */
+
+TEST(KernelDispatchTests, StartsOnASupportedIsa) {
+    EXPECT_TRUE(KernelDispatch::IsSupported(KernelDispatch::GetIsa()));
+    EXPECT_TRUE(KernelDispatch::IsSupported(KernelDispatch::Isa::Scalar));
+    EXPECT_TRUE(KernelDispatch::IsSupported(KernelDispatch::Best()));
+}
+
+TEST(KernelDispatchTests, ParsesNames) {
+    for (int i = 0; i < static_cast<int>(KernelDispatch::Isa::Count); ++i) {
+        const KernelDispatch::Isa isa = static_cast<KernelDispatch::Isa>(i);
+        KernelDispatch::Isa parsed;
+        ASSERT_TRUE(KernelDispatch::Parse(KernelDispatch::GetName(isa), &parsed));
+        EXPECT_EQ(parsed, isa);
+    }
+
+    KernelDispatch::Isa parsed;
+    EXPECT_FALSE(KernelDispatch::Parse("mmx", &parsed));
+}
+
+TEST(KernelDispatchTests, EveryIsaMatchesScalarExactly) {
+    IsaScope scope;
+
+    RandomStream random;
+    random.seed(7, 0);
+
+    const int n = 1037;
+    const std::vector<float> a = noise(&random, 2 * n, 1.0f);
+    const std::vector<float> b = noise(&random, 2 * n, 1.0f);
+    const std::vector<float> dither = noise(&random, n, 0.5f);
+    const std::vector<float> audio = noise(&random, n, 40000.0f);
+
+    ASSERT_TRUE(KernelDispatch::SetIsa(KernelDispatch::Isa::Scalar));
+    const KernelDispatch::Table &scalar = KernelDispatch::Get();
+
+    const float dot = scalar.dotProduct(a.data(), b.data(), n);
+    std::vector<int16_t> quantized(n);
+    scalar.quantizeToInt16(audio.data(), quantized.data(), n, 1.0f, dither.data());
+    std::vector<float> spectrum(2 * n, 0.25f);
+    scalar.multiplyAccumulateSpectrum(spectrum.data(), a.data(), b.data(), n);
+
+    for (int i = 0; i < static_cast<int>(KernelDispatch::Isa::Count); ++i) {
+        const KernelDispatch::Isa isa = static_cast<KernelDispatch::Isa>(i);
+        if (!KernelDispatch::SetIsa(isa)) continue;
+
+        SCOPED_TRACE(KernelDispatch::GetName(isa));
+        const KernelDispatch::Table &kernels = KernelDispatch::Get();
+
+        const float otherDot = kernels.dotProduct(a.data(), b.data(), n);
+        EXPECT_EQ(std::memcmp(&dot, &otherDot, sizeof(float)), 0);
+
+        std::vector<int16_t> otherQuantized(n);
+        kernels.quantizeToInt16(audio.data(), otherQuantized.data(), n, 1.0f, dither.data());
+        EXPECT_EQ(otherQuantized, quantized);
+
+        std::vector<float> otherSpectrum(2 * n, 0.25f);
+        kernels.multiplyAccumulateSpectrum(otherSpectrum.data(), a.data(), b.data(), n);
+        EXPECT_EQ(std::memcmp(otherSpectrum.data(), spectrum.data(), sizeof(float) * 2 * n), 0);
+    }
+}
+
+TEST(KernelDispatchTests, QuantizeSaturatesAndRoundsHalfAway) {
+    const float input[] = { 0.5f, -0.5f, 1.49f, -1.5f, 1E6f, -1E6f, -0.0f };
+    const int16_t expected[] = { 1, -1, 1, -2, INT16_MAX, INT16_MIN, 0 };
+
+    int16_t output[7];
+    KernelDispatch::Get().quantizeToInt16(input, output, 7, 1.0f, nullptr);
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_EQ(output[i], expected[i]);
+    }
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "../include/latency_probe.h"
+
+#include <chrono>
+
+TEST(LatencyProbeTests, OneProbeInFlight) {
+    using Clock = LatencyProbe::Clock;
+
+    LatencyProbe probe;
+    EXPECT_FALSE(probe.begin(Clock::now()));
+
+    probe.setEnabled(true);
+    const Clock::time_point t0 = Clock::now();
+    ASSERT_TRUE(probe.begin(t0));
+    EXPECT_FALSE(probe.begin(t0));
+
+    // Stages only advance in order
+    EXPECT_TRUE(probe.isWaiting(LatencyProbe::Stage::Applied));
+    EXPECT_FALSE(probe.isWaiting(LatencyProbe::Stage::Rendered));
+
+    const LatencyProbe::Stage stages[] = {
+        LatencyProbe::Stage::Applied,
+        LatencyProbe::Stage::Published,
+        LatencyProbe::Stage::Rendered,
+        LatencyProbe::Stage::Read,
+        LatencyProbe::Stage::Played
+    };
+
+    for (int i = 0; i < 5; ++i) {
+        probe.mark(stages[i], 0, t0 + std::chrono::milliseconds(i + 1));
+    }
+
+    EXPECT_EQ(probe.getCompletedCount(), 1);
+    EXPECT_TRUE(probe.begin(t0));
+}
+
+TEST(LatencyProbeTests, ReportsPercentilesPerStage) {
+    using Clock = LatencyProbe::Clock;
+
+    LatencyProbe probe;
+    probe.setEnabled(true);
+
+    // Render takes 1..100 ms, every other stage 1 ms
+    const Clock::time_point t0 = Clock::now();
+    for (int i = 1; i <= 100; ++i) {
+        ASSERT_TRUE(probe.begin(t0));
+        probe.mark(LatencyProbe::Stage::Applied, 0, t0 + std::chrono::milliseconds(1));
+        probe.mark(LatencyProbe::Stage::Published, 0, t0 + std::chrono::milliseconds(2));
+        probe.mark(LatencyProbe::Stage::Rendered, 0, t0 + std::chrono::milliseconds(2 + i));
+        probe.mark(LatencyProbe::Stage::Read, 0, t0 + std::chrono::milliseconds(3 + i));
+        probe.mark(LatencyProbe::Stage::Played, 0, t0 + std::chrono::milliseconds(4 + i));
+    }
+
+    const LatencyProbe::Statistics rendered = probe.getStatistics(LatencyProbe::Stage::Rendered);
+    EXPECT_EQ(rendered.count, 100);
+    EXPECT_NEAR(rendered.p50, 51.0, 1E-6);
+    EXPECT_NEAR(rendered.p99, 99.0, 1E-6);
+    EXPECT_NEAR(rendered.max, 100.0, 1E-6);
+
+    EXPECT_NEAR(probe.getStatistics(LatencyProbe::Stage::Applied).p99, 1.0, 1E-6);
+    EXPECT_NEAR(probe.getStatistics(LatencyProbe::Stage::Input).max, 104.0, 1E-6);
+
+    probe.reset();
+    EXPECT_EQ(probe.getStatistics(LatencyProbe::Stage::Rendered).count, 0);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include "../include/leveling_filter.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+std::vector<float> tone(int samples, float amplitude) {
+    std::vector<float> signal(samples);
+    for (int i = 0; i < samples; ++i) {
+        signal[i] = amplitude * std::sin(0.05f * i);
+    }
+
+    return signal;
+}
+} /* namespace */
+
+TEST(LevelingFilterTests, BlockModeSettlesToPerSampleGain) {
+    LevelingFilter perSample, block;
+    block.initializeBlockMode(64, 64);
+
+    std::vector<float> signal = tone(44100, 60000.0f);
+    std::vector<float> a(signal.size()), b(signal.size());
+    perSample.fast_f(signal.data(), a.data(), (int)signal.size());
+    block.block_f(signal.data(), b.data(), (int)signal.size());
+
+    EXPECT_NEAR(block.getAttenuation(), perSample.getAttenuation(), 0.01f);
+    EXPECT_EQ(block.getLookahead(), 64);
+
+    // The output is the input delayed by the look-ahead
+    for (int i = 0; i < 64; ++i) {
+        EXPECT_EQ(b[i], 0.0f);
+    }
+}
+
+TEST(LevelingFilterTests, LookaheadCatchesTransients) {
+    // Quiet, then a jump well past the target; with the look-ahead the gain
+    // is already down when the jump leaves the filter
+    constexpr int Quiet = 4096;
+    constexpr float Target = 30000.0f;
+
+    std::vector<float> signal = tone(Quiet, 3000.0f);
+    const std::vector<float> loud(2048, 90000.0f);
+    signal.insert(signal.end(), loud.begin(), loud.end());
+
+    LevelingFilter filter;
+    filter.p_maxLevel = 4.0f;
+    filter.initializeBlockMode(32, 64);
+
+    std::vector<float> output(signal.size() + 64);
+    signal.resize(output.size(), 0.0f);
+    filter.block_f(signal.data(), output.data(), (int)output.size());
+
+    float peak = 0;
+    for (size_t i = Quiet + filter.getLookahead(); i < output.size(); ++i) {
+        peak = std::fmax(peak, std::abs(output[i]));
+    }
+
+    EXPECT_LT(peak, 1.1f * Target);
+}
+
+TEST(LevelingFilterTests, BlockModeInPlaceWithPartialBlocks) {
+    LevelingFilter outOfPlace, inPlace;
+    outOfPlace.initializeBlockMode(64, 16);
+    inPlace.initializeBlockMode(64, 16);
+
+    const std::vector<float> signal = tone(1000, 40000.0f);
+    std::vector<float> expected(signal.size());
+    std::vector<float> actual = signal;
+
+    // Uneven render sizes against a single call
+    outOfPlace.block_f(signal.data(), expected.data(), (int)signal.size());
+    int offset = 0;
+    for (const int n : { 100, 37, 500, 363 }) {
+        inPlace.block_f(actual.data() + offset, actual.data() + offset, n);
+        offset += n;
+    }
+
+    // Block boundaries differ, so only the envelope is compared
+    EXPECT_NEAR(inPlace.getAttenuation(), outOfPlace.getAttenuation(), 1E-3f);
+    for (size_t i = 0; i < 16; ++i) {
+        EXPECT_EQ(actual[i], 0.0f);
+    }
+}
+
+TEST(LevelingFilterTests, LinkedChannelsShareTheGain) {
+    LevelingFilter mono, stereo;
+    mono.initializeBlockMode(64, 32);
+    stereo.initializeBlockMode(64, 32, 2);
+
+    // The right channel is a quieter copy of the left, as a panned source
+    const std::vector<float> signal = tone(8192, 60000.0f);
+    std::vector<float> interleaved(signal.size() * 2);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        interleaved[2 * i + 0] = signal[i];
+        interleaved[2 * i + 1] = 0.25f * signal[i];
+    }
+
+    std::vector<float> expected(signal.size()), actual(interleaved.size());
+    mono.block_f(signal.data(), expected.data(), (int)signal.size());
+    stereo.block_f(interleaved.data(), actual.data(), (int)signal.size());
+
+    EXPECT_EQ(stereo.getChannelCount(), 2);
+    EXPECT_NEAR(stereo.getAttenuation(), mono.getAttenuation(), 1E-6f);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        ASSERT_NEAR(actual[2 * i + 0], expected[i], 1E-2f) << i;
+        ASSERT_NEAR(actual[2 * i + 1], 0.25f * expected[i], 1E-2f) << i;
+    }
+}
+
+TEST(LevelingFilterTests, CopiesKeepTheirOwnDelay) {
+    LevelingFilter original;
+    original.initializeBlockMode(64, 32);
+
+    const std::vector<float> signal = tone(1024, 60000.0f);
+    std::vector<float> expected(signal.size()), actual(signal.size());
+
+    // A copy carries on from the same state without touching the original
+    LevelingFilter copy = original;
+    original.block_f(signal.data(), expected.data(), (int)signal.size());
+    original.initializeBlockMode(0, 0);
+    copy.block_f(signal.data(), actual.data(), (int)signal.size());
+
+    EXPECT_EQ(actual, expected);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "../include/metrics_exporter.h"
+
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// One blocking loopback request; the server closes after responding
+std::string get(int port, const char *path) {
+#if defined(_WIN32)
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+    DWORD timeout = 2000;
+#else
+    timeval timeout = { 2, 0 };
+#endif /* _WIN32 */
+
+    const auto s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+
+    sockaddr_in server;
+    std::memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(static_cast<uint16_t>(port));
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::string response;
+    if (connect(s, reinterpret_cast<const sockaddr *>(&server), sizeof(server)) == 0) {
+        const std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        send(s, request.data(), static_cast<int>(request.size()), 0);
+
+        char buffer[4096];
+        int n;
+        while ((n = static_cast<int>(recv(s, buffer, sizeof(buffer), 0))) > 0) {
+            response.append(buffer, n);
+        }
+    }
+
+#if defined(_WIN32)
+    closesocket(s);
+    WSACleanup();
+#else
+    close(s);
+#endif /* _WIN32 */
+
+    return response;
+}
+} /* namespace */
+
+TEST(MetricsExporterTests, ServesPublishedInstances) {
+    MetricsExporter::Parameters params;
+    params.port = 0;
+
+    MetricsExporter exporter;
+    ASSERT_TRUE(exporter.initialize(params));
+    ASSERT_GT(exporter.getPort(), 0);
+
+    MetricsExporter::InstanceMetrics metrics;
+    metrics.set(MetricsExporter::Metric::Steps, 1234);
+    metrics.set(MetricsExporter::Metric::AudioUnderruns, 3);
+    exporter.setInstanceLabel(2, "Test \"V8\"");
+    exporter.publish(2, metrics);
+
+    const std::string response = get(exporter.getPort(), "/metrics");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("# TYPE engine_sim_steps_total counter\n"), std::string::npos);
+    EXPECT_NE(
+        response.find("engine_sim_steps_total{instance=\"2\",engine=\"Test \\\"V8\\\"\"} 1234\n"),
+        std::string::npos);
+    EXPECT_NE(response.find("engine_sim_audio_underruns_total{instance=\"2\""), std::string::npos);
+    EXPECT_EQ(response.find("instance=\"0\""), std::string::npos);
+    EXPECT_EQ(exporter.getScrapeCount(), 1u);
+
+    exporter.removeInstance(2);
+    EXPECT_EQ(exporter.render().find("instance=\"2\""), std::string::npos);
+
+    EXPECT_EQ(get(exporter.getPort(), "/other").rfind("HTTP/1.1 404", 0), 0u);
+    EXPECT_EQ(exporter.getScrapeCount(), 1u);
+
+    exporter.destroy();
+    EXPECT_FALSE(exporter.isOpen());
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include "../include/min_max_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+typedef MinMaxPyramid::Point Point;
+
+std::vector<Point> window(const std::vector<Point> &ring, int start, int count) {
+    std::vector<Point> points;
+    for (int i = 0; i < count; ++i) {
+        points.push_back(ring[(start + i) % ring.size()]);
+    }
+
+    return points;
+}
+} /* namespace */
+
+TEST(MinMaxPyramidTests, SmallWindowIsCopied) {
+    std::vector<Point> ring(100);
+    for (int i = 0; i < 100; ++i) ring[i] = { (double)i, std::sin(i * 0.1) };
+
+    MinMaxPyramid pyramid;
+    pyramid.initialize(100);
+    pyramid.update(ring.data(), 0, 100);
+
+    std::vector<Point> out(100);
+    const int n = pyramid.decimate(ring.data(), 30, 100, 200, out.data());
+    ASSERT_EQ(n, 100);
+
+    const std::vector<Point> expected = window(ring, 30, 100);
+    for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(out[i].x, expected[i].x);
+        EXPECT_EQ(out[i].y, expected[i].y);
+    }
+}
+
+TEST(MinMaxPyramidTests, DecimationKeepsPeaksAndOrder) {
+    constexpr int Size = 1000;
+
+    std::vector<Point> ring(Size);
+    MinMaxPyramid pyramid;
+    pyramid.initialize(Size);
+
+    // Written one at a time, wrapping, with spikes a decimator that skips
+    // samples would lose
+    int writeIndex = 0;
+    for (int i = 0; i < 2500; ++i) {
+        const double y = (i % 97 == 0) ? 10.0 : (i % 89 == 0) ? -10.0 : std::sin(i * 0.01);
+        ring[writeIndex] = { (double)i, y };
+        pyramid.update(ring.data(), writeIndex, 1);
+        writeIndex = (writeIndex + 1) % Size;
+    }
+
+    std::vector<Point> out(Size);
+    const int n = pyramid.decimate(ring.data(), writeIndex, Size, 100, out.data());
+    EXPECT_LE(n, 100 + 4 * 16);
+    EXPECT_GT(n, 50);
+
+    for (int i = 1; i < n; ++i) {
+        EXPECT_LT(out[i - 1].x, out[i].x);
+    }
+
+    const std::vector<Point> expected = window(ring, writeIndex, Size);
+    const int spikes = (int)std::count_if(expected.begin(), expected.end(), [](const Point &p) {
+        return std::abs(p.y) == 10.0;
+    });
+    const int kept = (int)std::count_if(out.begin(), out.begin() + n, [](const Point &p) {
+        return std::abs(p.y) == 10.0;
+    });
+    EXPECT_GT(spikes, 0);
+    EXPECT_EQ(kept, spikes);
+
+    EXPECT_EQ(out[0].x, expected.front().x);
+    EXPECT_EQ(out[n - 1].x, expected.back().x);
+}
+
+TEST(MinMaxPyramidTests, BulkUpdateMatchesSingleUpdates) {
+    constexpr int Size = 64;
+
+    std::vector<Point> ring(Size);
+    MinMaxPyramid bulk, single;
+    bulk.initialize(Size);
+    single.initialize(Size);
+
+    int writeIndex = 0;
+    for (int block = 0; block < 10; ++block) {
+        const int first = writeIndex;
+        for (int i = 0; i < 23; ++i) {
+            ring[writeIndex] = { (double)(block * 23 + i), (double)((block * 23 + i) * 37 % 101) };
+            single.update(ring.data(), writeIndex, 1);
+            writeIndex = (writeIndex + 1) % Size;
+        }
+
+        bulk.update(ring.data(), first, 23);
+    }
+
+    ASSERT_EQ(bulk.getLevelCount(), 7);
+    for (int level = 1; level < bulk.getLevelCount(); ++level) {
+        for (int j = 0; j < (Size >> level); ++j) {
+            EXPECT_EQ(bulk.getBlock(level, j).loIndex, single.getBlock(level, j).loIndex);
+            EXPECT_EQ(bulk.getBlock(level, j).hiIndex, single.getBlock(level, j).hiIndex);
+        }
+    }
+
+    const MinMaxPyramid::Block &top = bulk.getBlock(6, 0);
+    const auto lowest = std::min_element(ring.begin(), ring.end(), [](const Point &a, const Point &b) {
+        return a.y < b.y;
+    });
+    const auto highest = std::max_element(ring.begin(), ring.end(), [](const Point &a, const Point &b) {
+        return a.y < b.y;
+    });
+    EXPECT_EQ(top.lo.y, lowest->y);
+    EXPECT_EQ(top.hi.y, highest->y);
+}
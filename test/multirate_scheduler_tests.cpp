@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include "../include/multirate_scheduler.h"
+
+#include "../include/control_queue.h"
+#include "../include/simulator.h"
+#include "test_engine.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// The test twin without a simulator, with a vehicle mass of its own
+struct Rig {
+    Engine *engine;
+    Vehicle *vehicle;
+    Transmission *transmission;
+    atg_scs::RigidBody vehicleMass;
+    std::vector<atg_scs::RigidBody *> bodies;
+
+    Rig() {
+        engine = test_engine::buildEngine();
+        vehicle = test_engine::buildVehicle();
+        transmission = test_engine::buildTransmission();
+        vehicleMass.reset();
+
+        for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+            bodies.push_back(&engine->getCrankshaft(i)->m_body);
+        }
+
+        for (int i = 0; i < engine->getCylinderCount(); ++i) {
+            bodies.push_back(&engine->getPiston(i)->m_body);
+            bodies.push_back(&engine->getConnectingRod(i)->m_body);
+        }
+
+        bodies.push_back(&vehicleMass);
+    }
+
+    ~Rig() {
+        test_engine::release(engine, vehicle, transmission);
+    }
+
+    // Distinct values for every body and field, standing in for a solve
+    void place(double seed) {
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            atg_scs::RigidBody *body = bodies[i];
+            const double k = seed + 0.37 * i;
+            body->p_x = 0.1 * k;
+            body->p_y = -0.2 * k;
+            body->theta = 1.3 * k;
+            body->v_x = 2.0 * k;
+            body->v_y = -3.5 * k;
+            body->v_theta = 40.0 * k;
+        }
+    }
+
+    std::vector<double> state() const {
+        std::vector<double> result;
+        for (const atg_scs::RigidBody *body : bodies) {
+            result.insert(result.end(), { body->p_x, body->p_y, body->theta, body->v_x, body->v_y, body->v_theta });
+        }
+
+        return result;
+    }
+};
+
+// Same bits, not just equal values
+uint64_t bits(double value) {
+    uint64_t result;
+    std::memcpy(&result, &value, sizeof(value));
+    return result;
+}
+
+void expectSameBits(const std::vector<double> &a, const std::vector<double> &b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(bits(a[i]), bits(b[i])) << "body " << i / 6 << " field " << i % 6;
+    }
+}
+
+void apply(Simulator *simulator, ControlQueue::Control control, double value) {
+    ControlQueue::Event event;
+    event.control = control;
+    event.value = value;
+    event.immediate = true;
+    simulator->applyControl(event);
+}
+
+// Crankshafts, pistons and rods of a loaded simulator's engine
+std::vector<double> engineState(Simulator *simulator) {
+    Engine *engine = simulator->getEngine();
+
+    std::vector<const atg_scs::RigidBody *> bodies;
+    for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+        bodies.push_back(&engine->getCrankshaft(i)->m_body);
+    }
+
+    for (int i = 0; i < engine->getCylinderCount(); ++i) {
+        bodies.push_back(&engine->getPiston(i)->m_body);
+        bodies.push_back(&engine->getConnectingRod(i)->m_body);
+    }
+
+    std::vector<double> result;
+    for (const atg_scs::RigidBody *body : bodies) {
+        result.insert(result.end(), { body->p_x, body->p_y, body->theta, body->v_x, body->v_y, body->v_theta });
+    }
+
+    return result;
+}
+
+} /* namespace */
+
+TEST(MultirateSchedulerTests, IntervalOneLeavesSolvedState) {
+    Rig rig;
+
+    MultirateScheduler scheduler;
+    scheduler.initialize(rig.engine, &rig.vehicleMass, 1);
+    ASSERT_EQ(scheduler.getInterval(), 1);
+
+    for (int round = 0; round < 3; ++round) {
+        ASSERT_TRUE(scheduler.isSolveDue());
+
+        rig.place(round);
+        scheduler.beginSolve();
+        rig.place(round + 10.0);
+        const std::vector<double> solved = rig.state();
+        scheduler.endSolve();
+
+        scheduler.interpolate();
+        expectSameBits(rig.state(), solved);
+    }
+
+    EXPECT_TRUE(scheduler.isSolveDue());
+    scheduler.destroy();
+}
+
+TEST(MultirateSchedulerTests, IntervalEndsOnSolvedState) {
+    constexpr int Interval = 4;
+    Rig rig;
+
+    MultirateScheduler scheduler;
+    scheduler.initialize(rig.engine, &rig.vehicleMass, Interval);
+    ASSERT_EQ(scheduler.getInterval(), Interval);
+
+    rig.place(1.0);
+    for (int round = 0; round < 3; ++round) {
+        ASSERT_TRUE(scheduler.isSolveDue());
+
+        // Each solve starts from where the last interval ended
+        const std::vector<double> start = rig.state();
+        scheduler.beginSolve();
+        rig.place(5.0 * (round + 2));
+        const std::vector<double> solved = rig.state();
+        scheduler.endSolve();
+
+        for (int step = 1; step < Interval; ++step) {
+            scheduler.interpolate();
+            EXPECT_FALSE(scheduler.isSolveDue());
+
+            const double s = static_cast<double>(step) / Interval;
+            const std::vector<double> state = rig.state();
+            for (size_t i = 0; i < state.size(); ++i) {
+                EXPECT_NEAR(state[i], start[i] + s * (solved[i] - start[i]), 1E-12)
+                    << "body " << i / 6 << " field " << i % 6 << " step " << step;
+            }
+        }
+
+        scheduler.interpolate();
+        EXPECT_TRUE(scheduler.isSolveDue());
+        expectSameBits(rig.state(), solved);
+    }
+
+    scheduler.destroy();
+}
+
+TEST(MultirateSchedulerTests, IntervalOneMatchesSolvingEveryStep) {
+    Engine *engines[2];
+    Vehicle *vehicles[2];
+    Transmission *transmissions[2];
+    Simulator *simulators[2];
+    for (int i = 0; i < 2; ++i) {
+        engines[i] = test_engine::buildEngine();
+        vehicles[i] = test_engine::buildVehicle();
+        transmissions[i] = test_engine::buildTransmission();
+        simulators[i] = engines[i]->createSimulator(vehicles[i], transmissions[i], false, false);
+        simulators[i]->setSimulationFrequency(10000);
+        simulators[i]->setOfflineMode(true);
+    }
+
+    // Back to 1 after a multirate interval, which has to leave nothing behind
+    simulators[1]->setRigidBodyInterval(4);
+    simulators[1]->setRigidBodyInterval(1);
+    ASSERT_EQ(simulators[1]->getRigidBodyInterval(), 1);
+
+    for (Simulator *simulator : simulators) {
+        apply(simulator, ControlQueue::Control::Throttle, 0.7);
+        apply(simulator, ControlQueue::Control::Ignition, 1.0);
+        apply(simulator, ControlQueue::Control::DynoEnabled, 1.0);
+        apply(simulator, ControlQueue::Control::DynoHold, 1.0);
+        apply(simulator, ControlQueue::Control::DynoSpeed, units::rpm(3000));
+
+        simulator->startFrameSteps(300);
+        while (simulator->simulateStep()) { /* void */ }
+        simulator->endFrame();
+    }
+
+    expectSameBits(engineState(simulators[1]), engineState(simulators[0]));
+    EXPECT_EQ(
+        bits(simulators[1]->getFilteredDynoTorque()),
+        bits(simulators[0]->getFilteredDynoTorque()));
+
+    for (int i = 0; i < 2; ++i) {
+        simulators[i]->releaseSimulation();
+        delete simulators[i];
+        test_engine::release(engines[i], vehicles[i], transmissions[i]);
+    }
+}
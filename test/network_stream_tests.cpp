@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include "../include/network_stream.h"
+#include "../include/simulation_snapshot.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// Blocking loopback client with a receive timeout
+class Client {
+    public:
+        explicit Client(int port) {
+            m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+#if defined(_WIN32)
+            DWORD timeout = 1000;
+#else
+            timeval timeout = { 1, 0 };
+#endif /* _WIN32 */
+            setsockopt(
+                m_socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+
+            std::memset(&m_server, 0, sizeof(m_server));
+            m_server.sin_family = AF_INET;
+            m_server.sin_port = htons(static_cast<uint16_t>(port));
+            m_server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        }
+
+        ~Client() {
+#if defined(_WIN32)
+            closesocket(m_socket);
+#else
+            close(m_socket);
+#endif /* _WIN32 */
+        }
+
+        template <typename T>
+        void send(const T &packet) {
+            sendto(
+                m_socket,
+                reinterpret_cast<const char *>(&packet),
+                sizeof(T),
+                0,
+                reinterpret_cast<const sockaddr *>(&m_server),
+                sizeof(m_server));
+        }
+
+        int receive(void *buffer, int size) {
+            return static_cast<int>(recv(m_socket, static_cast<char *>(buffer), size, 0));
+        }
+
+    private:
+#if defined(_WIN32)
+        SOCKET m_socket;
+#else
+        int m_socket;
+#endif /* _WIN32 */
+        sockaddr_in m_server;
+};
+
+NetworkStream::PacketHeader header(NetworkStream::PacketType type) {
+    NetworkStream::PacketHeader h = {};
+    h.magic = NetworkStream::Magic;
+    h.version = NetworkStream::Version;
+    h.type = static_cast<uint16_t>(type);
+    return h;
+}
+
+// Datagrams on loopback are delivered promptly but not synchronously
+bool pollUntil(NetworkStream &stream, NetworkStream::Controls *controls, int listeners) {
+    for (int i = 0; i < 100; ++i) {
+        const bool updated = stream.poll(controls);
+        if (stream.getListenerCount() == listeners && (controls == nullptr || updated)) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    return false;
+}
+} /* namespace */
+
+TEST(NetworkStreamTests, ListenersReceiveTelemetry) {
+    NetworkStream::Parameters params;
+    params.port = 0;
+
+    NetworkStream stream;
+    ASSERT_TRUE(stream.initialize(params));
+    ASSERT_GT(stream.getPort(), 0);
+
+    Client a(stream.getPort()), b(stream.getPort());
+    a.send(header(NetworkStream::PacketType::Hello));
+    b.send(header(NetworkStream::PacketType::Hello));
+    ASSERT_TRUE(pollUntil(stream, nullptr, 2));
+
+    SimulationSnapshot snapshot;
+    snapshot.time = 1.5;
+    snapshot.rpm = 3200.0;
+    snapshot.gear = 2;
+    snapshot.ignitionEnabled = true;
+    stream.sendTelemetry(snapshot);
+
+    for (Client *client : { &a, &b }) {
+        NetworkStream::TelemetryPacket packet;
+        ASSERT_EQ(client->receive(&packet, sizeof(packet)), static_cast<int>(sizeof(packet)));
+        EXPECT_EQ(packet.header.type, static_cast<uint16_t>(NetworkStream::PacketType::Telemetry));
+        EXPECT_DOUBLE_EQ(packet.time, 1.5);
+        EXPECT_FLOAT_EQ(packet.rpm, 3200.0f);
+        EXPECT_EQ(packet.gear, 2);
+        EXPECT_EQ(packet.flags, static_cast<uint32_t>(NetworkStream::IgnitionEnabled));
+        EXPECT_EQ(packet.listeners, 2u);
+    }
+
+    b.send(header(NetworkStream::PacketType::Goodbye));
+    ASSERT_TRUE(pollUntil(stream, nullptr, 1));
+
+    stream.destroy();
+    EXPECT_FALSE(stream.isOpen());
+}
+
+TEST(NetworkStreamTests, ControlPacketsUpdateControls) {
+    NetworkStream::Parameters params;
+    params.port = 0;
+
+    NetworkStream stream;
+    ASSERT_TRUE(stream.initialize(params));
+
+    Client client(stream.getPort());
+
+    // Wrong magic is ignored and doesn't register a listener
+    NetworkStream::PacketHeader bogus = header(NetworkStream::PacketType::Hello);
+    bogus.magic = 0;
+    client.send(bogus);
+
+    NetworkStream::ControlPacket control;
+    control.header = header(NetworkStream::PacketType::Control);
+    control.throttle = 2.0f;
+    control.clutch = 0.25f;
+    control.dynoSpeed = 2500.0f;
+    control.gear = 3;
+    control.flags = NetworkStream::StarterEnabled | NetworkStream::DynoEnabled;
+    client.send(control);
+
+    NetworkStream::Controls controls;
+    ASSERT_TRUE(pollUntil(stream, &controls, 1));
+    EXPECT_DOUBLE_EQ(controls.throttle, 1.0);
+    EXPECT_DOUBLE_EQ(controls.clutch, 0.25);
+    EXPECT_DOUBLE_EQ(controls.dynoSpeed, 2500.0);
+    EXPECT_EQ(controls.gear, 3);
+    EXPECT_FALSE(controls.ignition);
+    EXPECT_TRUE(controls.starter);
+    EXPECT_TRUE(controls.dyno);
+    EXPECT_EQ(stream.getStatistics().rejectedPackets, 1u);
+}
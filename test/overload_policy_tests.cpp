@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "../include/overload_policy.h"
+
+TEST(OverloadPolicyTests, ShedsInOrderAndRecoversOneLevelAtATime) {
+    OverloadPolicy::Parameters params;
+    params.shedHeadroom = 0.5;
+    params.recoverHeadroom = 0.9;
+    params.shedFrames = 3;
+    params.recoverFrames = 10;
+
+    OverloadPolicy policy;
+    policy.initialize(params);
+    EXPECT_EQ(policy.getLevel(), OverloadPolicy::Level::None);
+
+    // A brief dip isn't enough
+    EXPECT_FALSE(policy.update(0.4, false));
+    EXPECT_FALSE(policy.update(0.4, false));
+    EXPECT_FALSE(policy.update(0.7, false));
+    EXPECT_FALSE(policy.update(0.4, false));
+    EXPECT_EQ(policy.getLevel(), OverloadPolicy::Level::None);
+
+    EXPECT_FALSE(policy.update(0.4, false));
+    EXPECT_TRUE(policy.update(0.4, false));
+    EXPECT_EQ(policy.getLevel(), OverloadPolicy::Level::Scopes);
+    EXPECT_TRUE(policy.isShedding(OverloadPolicy::Level::Scopes));
+    EXPECT_FALSE(policy.isShedding(OverloadPolicy::Level::FluidSubsteps));
+
+    // Underruns shed straight away, up to the last level
+    EXPECT_TRUE(policy.update(1.0, true));
+    EXPECT_EQ(policy.getLevel(), OverloadPolicy::Level::FluidSubsteps);
+    EXPECT_TRUE(policy.update(1.0, true));
+    EXPECT_EQ(policy.getLevel(), OverloadPolicy::Level::Convolution);
+    EXPECT_FALSE(policy.update(0.0, true));
+    EXPECT_EQ(policy.getShedCount(), 3);
+
+    // Between the two headrooms nothing changes
+    for (int i = 0; i < 50; ++i) EXPECT_FALSE(policy.update(0.7, false));
+    EXPECT_EQ(policy.getLevel(), OverloadPolicy::Level::Convolution);
+
+    const OverloadPolicy::Level expected[] = {
+        OverloadPolicy::Level::FluidSubsteps,
+        OverloadPolicy::Level::Scopes,
+        OverloadPolicy::Level::None
+    };
+
+    for (OverloadPolicy::Level level : expected) {
+        for (int i = 0; i < params.recoverFrames - 1; ++i) EXPECT_FALSE(policy.update(1.0, false));
+        EXPECT_TRUE(policy.update(1.0, false));
+        EXPECT_EQ(policy.getLevel(), level);
+    }
+
+    for (int i = 0; i < 50; ++i) EXPECT_FALSE(policy.update(1.0, false));
+}
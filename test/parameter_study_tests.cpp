@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "../include/parameter_study.h"
+
+TEST(ParameterStudyTests, GridCoversEveryCombination) {
+    ParameterStudy::Parameters params;
+    params.axes.push_back({ ParameterStudy::Parameter::IgnitionOffset, -4.0, 4.0, 3 });
+    params.axes.push_back({ ParameterStudy::Parameter::HeaderPrimaryLength, 20.0, 30.0, 2 });
+    params.sweep.minRpm = 2000.0;
+    params.sweep.maxRpm = 4000.0;
+    params.sweep.stepRpm = 1000.0;
+
+    ParameterStudy study;
+    study.initialize(params);
+
+    const std::vector<ParameterStudy::Variant> &variants = study.getVariants();
+    ASSERT_EQ(variants.size(), 6u);
+    EXPECT_EQ(study.getTaskCount(), 18);
+
+    EXPECT_DOUBLE_EQ(variants[0].values[0], -4.0);
+    EXPECT_DOUBLE_EQ(variants[0].values[1], 20.0);
+    EXPECT_DOUBLE_EQ(variants[1].values[1], 30.0);
+    EXPECT_DOUBLE_EQ(variants[2].values[0], 0.0);
+    EXPECT_DOUBLE_EQ(variants[5].values[0], 4.0);
+    EXPECT_DOUBLE_EQ(variants[5].values[1], 30.0);
+}
+
+TEST(ParameterStudyTests, RandomDesignIsReproducible) {
+    ParameterStudy::Parameters params;
+    params.axes.push_back({ ParameterStudy::Parameter::IntakeCamAdvance, -10.0, 10.0 });
+    params.design = ParameterStudy::Design::Random;
+    params.samples = 32;
+    params.seed = 7;
+
+    ParameterStudy a, b;
+    a.initialize(params);
+    b.initialize(params);
+
+    ASSERT_EQ(a.getVariants().size(), 32u);
+    for (size_t i = 0; i < a.getVariants().size(); ++i) {
+        const double value = a.getVariants()[i].values[0];
+        EXPECT_GE(value, -10.0);
+        EXPECT_LT(value, 10.0);
+        EXPECT_EQ(value, b.getVariants()[i].values[0]);
+    }
+
+    ParameterStudy::Parameter parameter;
+    EXPECT_TRUE(ParameterStudy::ParseParameter("intake_runner_length", &parameter));
+    EXPECT_EQ(parameter, ParameterStudy::Parameter::IntakeRunnerLength);
+    EXPECT_FALSE(ParameterStudy::ParseParameter("bore", &parameter));
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "../include/pipe_segments.h"
+
+#include <cmath>
+
+namespace {
+const GasSystem::Mix Air(0.0, 0.79, 0.21);
+
+PipeSegments::Parameters makePipe(int segments) {
+    PipeSegments::Parameters params;
+    params.segments = segments;
+    params.length = units::distance(1.0, units::m);
+    params.crossSectionArea = units::area(10.0, units::cm2);
+    params.mix = Air;
+    return params;
+}
+
+double totalEnergy(const GasSystem &system) {
+    return system.totalEnergy();
+}
+} /* namespace */
+
+TEST(PipeSegmentsTests, UniformPipeStaysAtRest) {
+    PipeSegments pipe;
+    pipe.initialize(makePipe(16));
+
+    GasSystem left, right;
+    left.initialize(units::pressure(1.0, units::atm), units::volume(1.0, units::L), units::celcius(25.0), Air);
+    right.initialize(units::pressure(1.0, units::atm), units::volume(1.0, units::L), units::celcius(25.0), Air);
+
+    for (int i = 0; i < 100; ++i) {
+        pipe.flow(1E-5, &left, &right);
+    }
+
+    for (int i = 0; i < pipe.getSegmentCount(); ++i) {
+        EXPECT_NEAR(pipe.getPressure(i), units::pressure(1.0, units::atm), 1E-6);
+        EXPECT_NEAR(pipe.getVelocity(i), 0.0, 1E-9);
+    }
+
+    EXPECT_NEAR(left.pressure(), units::pressure(1.0, units::atm), 1E-6);
+    pipe.destroy();
+}
+
+TEST(PipeSegmentsTests, ConservesMolesAndEnergy) {
+    PipeSegments pipe;
+    pipe.initialize(makePipe(16));
+
+    GasSystem left, right;
+    left.initialize(units::pressure(3.0, units::atm), units::volume(0.5, units::L), units::celcius(600.0), Air);
+    right.initialize(units::pressure(1.0, units::atm), units::volume(2.0, units::L), units::celcius(25.0), Air);
+
+    const double n0 = left.n() + right.n() + pipe.getTotalN();
+    const double E0 = totalEnergy(left) + totalEnergy(right) + pipe.getTotalEnergy();
+    for (int i = 0; i < 2000; ++i) {
+        pipe.flow(1E-5, &left, &right);
+    }
+
+    const double n1 = left.n() + right.n() + pipe.getTotalN();
+    const double E1 = totalEnergy(left) + totalEnergy(right) + pipe.getTotalEnergy();
+    EXPECT_NEAR(n1, n0, n0 * 1E-9);
+    EXPECT_NEAR(E1, E0, E0 * 1E-9);
+
+    // Something actually moved
+    EXPECT_LT(left.pressure(), units::pressure(3.0, units::atm));
+    pipe.destroy();
+}
+
+TEST(PipeSegmentsTests, PulseTravelsAtSoundSpeed) {
+    PipeSegments pipe;
+    pipe.initialize(makePipe(64));
+
+    GasSystem left, right;
+    left.initialize(units::pressure(1.5, units::atm), units::volume(1.0, units::L), units::celcius(25.0), Air);
+    right.initialize(units::pressure(1.0, units::atm), units::volume(1.0, units::L), units::celcius(25.0), Air);
+
+    const double c = std::sqrt(1.4 * constants::R * units::celcius(25.0) / units::AirMolecularMass);
+    const double dt = 1E-5;
+    const int last = pipe.getSegmentCount() - 1;
+
+    double arrival = -1;
+    for (int i = 0; i < 1000 && arrival < 0; ++i) {
+        pipe.flow(dt, &left, &right);
+        if (pipe.getPressure(last) > units::pressure(1.05, units::atm)) {
+            arrival = (i + 1) * dt;
+        }
+    }
+
+    // The front steepens, so it arrives a little ahead of a small-signal
+    // wave; never all at once
+    ASSERT_GT(arrival, 0.0);
+    EXPECT_GT(arrival, 0.75 / c);
+    EXPECT_LT(arrival, 1.25 / c);
+    pipe.destroy();
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include "../include/plugin_processor.h"
+
+#include "../include/simulator.h"
+#include "test_engine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using Parameter = PluginProcessor::Parameter;
+
+// Host events at absolute sample positions
+struct TimedEvent {
+    long long position;
+    Parameter parameter;
+    double value;
+};
+
+const TimedEvent Automation[] = {
+    { 0, Parameter::Starter, 1.0 },
+    { 0, Parameter::Throttle, 0.3 },
+    { 1500, Parameter::Throttle, 0.9 },
+    { 3001, Parameter::Starter, 0.0 },
+    { 4500, Parameter::Throttle, 0.1 },
+    { 6143, Parameter::Gear, 1.0 }
+};
+
+// The test twin in a simulator without an audio thread, driven by a
+// processor at the given host block size
+std::vector<float> render(int blockSize, int samples) {
+    Engine *engine = test_engine::buildEngine();
+    Vehicle *vehicle = test_engine::buildVehicle();
+    Transmission *transmission = test_engine::buildTransmission();
+    Simulator *simulator = engine->createSimulator(vehicle, transmission, false, true);
+    simulator->synthesizer().setRandomSeed(1);
+
+    PluginProcessor processor;
+    processor.initialize(simulator, PluginProcessor::Parameters());
+
+    std::vector<float> output(samples);
+    std::vector<PluginProcessor::Event> events;
+    for (int start = 0; start < samples; start += blockSize) {
+        const int frames = std::min(blockSize, samples - start);
+
+        events.clear();
+        for (const TimedEvent &timed : Automation) {
+            if (timed.position < start || timed.position >= start + frames) continue;
+
+            PluginProcessor::Event event;
+            event.offset = static_cast<int>(timed.position - start);
+            event.parameter = timed.parameter;
+            event.value = timed.value;
+            events.push_back(event);
+        }
+
+        processor.process(events.data(), static_cast<int>(events.size()), output.data() + start, frames);
+    }
+
+    EXPECT_EQ(processor.getUnderrunCount(), 0u) << "block size " << blockSize;
+
+    processor.destroy();
+    simulator->releaseSimulation();
+    delete simulator;
+    test_engine::release(engine, vehicle, transmission);
+
+    return output;
+}
+
+// Same bits, not just equal values
+std::vector<uint32_t> bits(const std::vector<float> &samples) {
+    std::vector<uint32_t> result(samples.size());
+    std::memcpy(result.data(), samples.data(), sizeof(float) * samples.size());
+    return result;
+}
+
+} /* namespace */
+
+TEST(PluginProcessorTests, OutputIsIndependentOfBlockSize) {
+    constexpr int Samples = 8192;
+
+    const std::vector<float> reference = render(64, Samples);
+    EXPECT_TRUE(std::any_of(reference.begin(), reference.end(), [](float x) { return x != 0.0f; }));
+
+    for (const int blockSize : { 1, 17, 100, 256, 1000 }) {
+        const std::vector<uint32_t> output = bits(render(blockSize, Samples));
+        const std::vector<uint32_t> expected = bits(reference);
+        const auto mismatch = std::mismatch(output.begin(), output.end(), expected.begin());
+        EXPECT_EQ(mismatch.first, output.end())
+            << "block size " << blockSize << " first differs at sample " << (mismatch.first - output.begin());
+    }
+}
+
+TEST(PluginProcessorTests, DropsEventsPastCapacity) {
+    Engine *engine = test_engine::buildEngine();
+    Vehicle *vehicle = test_engine::buildVehicle();
+    Transmission *transmission = test_engine::buildTransmission();
+    Simulator *simulator = engine->createSimulator(vehicle, transmission, false, true);
+
+    PluginProcessor::Parameters params;
+    params.eventCapacity = 4;
+
+    PluginProcessor processor;
+    processor.initialize(simulator, params);
+
+    std::vector<PluginProcessor::Event> events(10);
+    for (int i = 0; i < 10; ++i) {
+        events[i].offset = i;
+        events[i].parameter = Parameter::Throttle;
+        events[i].value = 0.1 * i;
+    }
+
+    // The excess never applies, early or otherwise
+    std::vector<float> output(64);
+    processor.process(events.data(), static_cast<int>(events.size()), output.data(), 64);
+    processor.process(nullptr, 0, output.data(), 64);
+    processor.process(nullptr, 0, output.data(), 64);
+
+    EXPECT_EQ(processor.getDroppedEventCount(), 6u);
+    EXPECT_DOUBLE_EQ(processor.getParameter(Parameter::Throttle), 0.1 * 3);
+
+    processor.destroy();
+    simulator->releaseSimulation();
+    delete simulator;
+    test_engine::release(engine, vehicle, transmission);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "../include/polyphase_resampler.h"
+#include "../include/constants.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+std::vector<float> resample(
+    PolyphaseResampler &resampler,
+    double (*signal)(int),
+    int inputSamples)
+{
+    std::vector<float> output;
+    float buffer[64];
+    float *channels[] = { buffer };
+
+    for (int i = 0; i < inputSamples; ++i) {
+        const double frame[] = { signal(i) };
+        resampler.push(frame);
+
+        int n;
+        do {
+            n = resampler.generate(channels, 64);
+            output.insert(output.end(), buffer, buffer + n);
+        } while (n == 64);
+    }
+
+    return output;
+}
+
+double amplitude(const std::vector<float> &x, size_t start, double frequency) {
+    double re = 0, im = 0;
+    for (size_t i = start; i < x.size(); ++i) {
+        re += x[i] * std::cos(2 * constants::pi * frequency * i);
+        im += x[i] * std::sin(2 * constants::pi * frequency * i);
+    }
+
+    return 2 * std::sqrt(re * re + im * im) / (x.size() - start);
+}
+} /* namespace */
+
+TEST(PolyphaseResamplerTests, OutputCountFollowsRatio) {
+    PolyphaseResampler resampler;
+    resampler.initialize(1);
+    resampler.setRates(10000, 44100, 1900);
+
+    const std::vector<float> output = resample(resampler, [](int) { return 0.0; }, 10000);
+    EXPECT_NEAR((double)output.size(), 44100.0, 1.0);
+
+    resampler.setRates(10, 44100, 1900);
+    const std::vector<float> slow = resample(resampler, [](int) { return 0.0; }, 10);
+    EXPECT_NEAR((double)slow.size(), 44100.0, 1.0);
+
+    resampler.destroy();
+}
+
+TEST(PolyphaseResamplerTests, ConstantInputStaysConstant) {
+    PolyphaseResampler resampler;
+    resampler.initialize(1);
+    resampler.setRates(10000, 44100, 1900);
+
+    const std::vector<float> output = resample(resampler, [](int) { return 3.0; }, 1000);
+    for (size_t i = 200; i < output.size(); ++i) {
+        EXPECT_NEAR(output[i], 3.0f, 1e-4f);
+    }
+
+    resampler.destroy();
+}
+
+TEST(PolyphaseResamplerTests, RejectsImagesAndAboveCutoff) {
+    PolyphaseResampler resampler;
+    resampler.initialize(1);
+    resampler.setRates(10000, 44100, 1900);
+
+    // 1 kHz passes; its first image at 9 kHz is suppressed
+    std::vector<float> output = resample(
+        resampler, [](int i) { return std::sin(2 * constants::pi * 0.1 * i); }, 4000);
+    EXPECT_NEAR(amplitude(output, 1000, 1000.0 / 44100), 1.0, 0.02);
+    EXPECT_LT(amplitude(output, 1000, 9000.0 / 44100), 1e-3);
+
+    // 4 kHz is well past the 1.9 kHz cutoff
+    output = resample(
+        resampler, [](int i) { return std::sin(2 * constants::pi * 0.4 * i); }, 4000);
+    EXPECT_LT(amplitude(output, 1000, 4000.0 / 44100), 0.01);
+
+    resampler.destroy();
+}
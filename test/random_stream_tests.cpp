@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "../include/random_stream.h"
+
+#include <cmath>
+
+TEST(RandomStreamTests, SameSeedReproduces) {
+    RandomStream a, b, c;
+    a.seed(1234, 7);
+    b.seed(1234, 7);
+    c.seed(1234, 8);
+
+    int matchesOtherStream = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const uint32_t v = a.next();
+        EXPECT_EQ(v, b.next());
+        if (v == c.next()) ++matchesOtherStream;
+    }
+
+    EXPECT_LT(matchesOtherStream, 2);
+}
+
+TEST(RandomStreamTests, FillMatchesScalarDraws) {
+    RandomStream a, b;
+    a.seed(99, 3);
+    b.seed(99, 3);
+
+    float buffer[257];
+    a.fill(buffer, 257, -1.0f, 1.0f);
+
+    double sum = 0;
+    for (int i = 0; i < 257; ++i) {
+        EXPECT_EQ(buffer[i], b.uniform(-1.0f, 1.0f));
+        EXPECT_GE(buffer[i], -1.0f);
+        EXPECT_LT(buffer[i], 1.0f);
+        sum += buffer[i];
+    }
+
+    EXPECT_LT(std::abs(sum / 257), 0.2);
+    EXPECT_EQ(a.next(), b.next());
+}
+
+TEST(RandomStreamTests, UniformDoubleRange) {
+    RandomStream r;
+    r.seed(5, 0);
+
+    double sum = 0;
+    for (int i = 0; i < 10000; ++i) {
+        const double v = r.uniform();
+        EXPECT_GE(v, 0.0);
+        EXPECT_LT(v, 1.0);
+        sum += v;
+    }
+
+    EXPECT_NEAR(sum / 10000, 0.5, 0.02);
+}
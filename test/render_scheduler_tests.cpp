@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "../include/render_scheduler.h"
+
+TEST(RenderSchedulerTests, ModeFollowsWindowAndLatency) {
+    RenderScheduler scheduler;
+    scheduler.initialize(RenderScheduler::Parameters());
+
+    EXPECT_EQ(scheduler.update(true, true, 0.1, 0.1), RenderScheduler::Mode::Full);
+    EXPECT_EQ(scheduler.update(false, true, 0.1, 0.1), RenderScheduler::Mode::Unfocused);
+    EXPECT_EQ(scheduler.update(false, false, 0.1, 0.1), RenderScheduler::Mode::Hidden);
+    EXPECT_FALSE(scheduler.shouldRender());
+
+    // Enters below half the target and only leaves above 80% of it
+    EXPECT_EQ(scheduler.update(true, true, 0.04, 0.1), RenderScheduler::Mode::PhysicsBehind);
+    EXPECT_EQ(scheduler.update(true, true, 0.07, 0.1), RenderScheduler::Mode::PhysicsBehind);
+    EXPECT_EQ(scheduler.update(true, true, 0.09, 0.1), RenderScheduler::Mode::Full);
+
+    scheduler.setEnabled(false);
+    EXPECT_EQ(scheduler.update(false, false, 0.0, 0.1), RenderScheduler::Mode::Full);
+}
+
+TEST(RenderSchedulerTests, IdleTimeRespectsSteppingFramerate) {
+    using Clock = RenderScheduler::Clock;
+
+    RenderScheduler::Parameters params;
+    params.unfocusedFramerate = 10.0;
+    params.physicsBehindFramerate = 20.0;
+
+    RenderScheduler scheduler;
+    scheduler.initialize(params);
+
+    const Clock::time_point t0 = Clock::now();
+    scheduler.update(true, true, 0.1, 0.1);
+    EXPECT_EQ(scheduler.getIdleTime(t0, t0), Clock::duration::zero());
+
+    // The loop steps the simulator, so unfocused frames stay at 30 fps
+    scheduler.setSteppingSimulation(true);
+    scheduler.update(false, true, 0.1, 0.1);
+    EXPECT_NEAR(std::chrono::duration<double>(scheduler.getIdleTime(t0, t0)).count(), 1 / 30.0, 1E-6);
+
+    scheduler.setSteppingSimulation(false);
+    EXPECT_NEAR(std::chrono::duration<double>(scheduler.getIdleTime(t0, t0)).count(), 0.1, 1E-6);
+    EXPECT_EQ(scheduler.getIdleTime(t0, t0 + std::chrono::milliseconds(200)), Clock::duration::zero());
+
+    // Behind: no idling while the loop steps, and the UI is rate limited
+    scheduler.update(true, true, 0.0, 0.1);
+    EXPECT_NEAR(std::chrono::duration<double>(scheduler.getIdleTime(t0, t0)).count(), 0.05, 1E-6);
+    scheduler.setSteppingSimulation(true);
+    EXPECT_EQ(scheduler.getIdleTime(t0, t0), Clock::duration::zero());
+
+    EXPECT_TRUE(scheduler.takeUiUpdate(t0));
+    EXPECT_FALSE(scheduler.takeUiUpdate(t0 + std::chrono::milliseconds(10)));
+    EXPECT_TRUE(scheduler.takeUiUpdate(t0 + std::chrono::milliseconds(60)));
+}
+
+TEST(RenderSchedulerTests, PausedRendersOnRequest) {
+    using Clock = RenderScheduler::Clock;
+
+    RenderScheduler::Parameters params;
+    params.pausedFramerate = 20.0;
+    params.pausedRedrawInterval = 1.0;
+
+    RenderScheduler scheduler;
+    scheduler.initialize(params);
+    scheduler.setEnabled(false);
+    scheduler.setSteppingSimulation(true);
+    scheduler.setPaused(true);
+
+    const Clock::time_point t0 = Clock::now();
+    EXPECT_EQ(scheduler.update(true, true, 0.0, 0.1), RenderScheduler::Mode::Paused);
+    EXPECT_NEAR(std::chrono::duration<double>(scheduler.getIdleTime(t0, t0)).count(), 0.05, 1E-6);
+
+    // Pausing draws once, then only on request or after the interval
+    EXPECT_TRUE(scheduler.takeUiUpdate(t0));
+    EXPECT_TRUE(scheduler.shouldRender());
+    EXPECT_FALSE(scheduler.takeUiUpdate(t0 + std::chrono::milliseconds(100)));
+    EXPECT_FALSE(scheduler.shouldRender());
+
+    scheduler.requestRedraw();
+    EXPECT_TRUE(scheduler.takeUiUpdate(t0 + std::chrono::milliseconds(200)));
+    EXPECT_TRUE(scheduler.shouldRender());
+    EXPECT_FALSE(scheduler.takeUiUpdate(t0 + std::chrono::milliseconds(300)));
+    EXPECT_TRUE(scheduler.takeUiUpdate(t0 + std::chrono::milliseconds(1300)));
+
+    EXPECT_EQ(scheduler.update(true, false, 0.0, 0.1), RenderScheduler::Mode::Hidden);
+    EXPECT_FALSE(scheduler.shouldRender());
+
+    scheduler.setPaused(false);
+    EXPECT_EQ(scheduler.update(true, true, 0.0, 0.1), RenderScheduler::Mode::Full);
+    EXPECT_TRUE(scheduler.shouldRender());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "../include/ring_buffer.h"
+
+#include <vector>
+
+TEST(RingBufferTests, PowerOfTwoCapacityIsRoundedUp) {
+    RingBuffer<int, true> buffer;
+    buffer.initialize(100);
+    EXPECT_EQ(buffer.capacity(), 128);
+
+    RingBuffer<int> plain;
+    plain.initialize(100);
+    EXPECT_EQ(plain.capacity(), 100);
+}
+
+TEST(RingBufferTests, BulkWriteMatchesElementWrites) {
+    RingBuffer<int, true> bulk;
+    RingBuffer<int> single;
+    bulk.initialize(16);
+    single.initialize(16);
+
+    std::vector<int> values(11);
+    std::vector<int> a(11), b(11);
+
+    int next = 0;
+    for (int block = 0; block < 20; ++block) {
+        for (int &v : values) v = next++;
+
+        bulk.write(values.data(), values.size());
+        for (int v : values) single.write(v);
+
+        ASSERT_EQ(bulk.writeIndex(), single.writeIndex());
+        ASSERT_EQ(bulk.size(), single.size());
+
+        bulk.readAndRemove(values.size(), a.data());
+        single.readAndRemove(values.size(), b.data());
+        ASSERT_EQ(a, b);
+        ASSERT_EQ(a.back(), next - 1);
+    }
+}
+
+TEST(RingBufferTests, OversizedBulkWriteKeepsNewest) {
+    RingBuffer<int, true> buffer;
+    buffer.initialize(8);
+    buffer.write(-1);
+
+    std::vector<int> values(21);
+    for (int i = 0; i < 21; ++i) values[i] = i;
+    buffer.write(values.data(), values.size());
+
+    buffer.setStartIndex(buffer.writeIndex());
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(buffer.read(i), 13 + i);
+    }
+}
+
+TEST(RingBufferTests, MaskedIndexingWraps) {
+    RingBuffer<double, true> buffer;
+    buffer.initialize(4);
+    for (int i = 0; i < 4; ++i) buffer.write(i);
+
+    buffer.removeBeginning(6);
+    EXPECT_EQ(buffer.start(), 2);
+    EXPECT_EQ(buffer.read(1), 3.0);
+    EXPECT_EQ(buffer.read(5), 3.0);
+
+    buffer.overwrite(7.0, 3);
+    EXPECT_EQ(buffer.read(3), 7.0);
+    EXPECT_EQ(buffer.index(1, -3), 2);
+}
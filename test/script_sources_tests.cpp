@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include "../scripting/include/script_sources.h"
+
+#include "../include/engine_loader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A script tree in a temporary directory, removed again on destruction
+struct Scripts {
+    std::filesystem::path root;
+
+    Scripts() {
+        root = std::filesystem::temp_directory_path() / "engine_sim_script_sources_tests";
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "parts");
+        std::filesystem::create_directories(root / "library");
+    }
+
+    ~Scripts() {
+        std::filesystem::remove_all(root);
+    }
+
+    std::string write(const std::string &name, const std::string &contents) {
+        const std::filesystem::path path = (root / name).lexically_normal();
+        std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        out << contents;
+        return path.string();
+    }
+
+    std::string path(const std::string &name) const {
+        return (root / name).lexically_normal().string();
+    }
+};
+
+std::vector<std::string> paths(const es_script::ScriptSources &sources) {
+    std::vector<std::string> result;
+    for (const es_script::ScriptSources::File &file : sources.getFiles()) {
+        result.push_back(file.path);
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// main.mr imports a file next to it and one from the search path; the
+// decoys are imports in comments, which the compiler ignores
+void writeTree(Scripts *scripts) {
+    scripts->write(
+        "main.mr",
+        "// import \"commented.mr\"\n"
+        "import \"parts/head.mr\"\n"
+        "/* import \"blocked.mr\"\n"
+        "   import \"also_blocked.mr\" */\n"
+        "import \"engines.mr\"\n"
+        "reimport \"not_a_keyword.mr\"\n");
+    scripts->write("parts/head.mr", "import \"../main.mr\"\nnode head {}\n");
+    scripts->write("library/engines.mr", "node engine {}\n");
+
+    for (const char *decoy : { "commented.mr", "blocked.mr", "also_blocked.mr", "not_a_keyword.mr" }) {
+        scripts->write(decoy, "node decoy {}\n");
+    }
+}
+
+} /* namespace */
+
+TEST(ScriptSourcesTests, CollectsImportsOutsideComments) {
+    Scripts scripts;
+    writeTree(&scripts);
+
+    es_script::ScriptSources sources;
+    sources.addSearchPath(scripts.path("library"));
+    ASSERT_TRUE(sources.collect(scripts.path("main.mr")));
+
+    // The cycle back to main.mr is followed only once
+    std::vector<std::string> expected = {
+        scripts.path("library/engines.mr"),
+        scripts.path("main.mr"),
+        scripts.path("parts/head.mr")
+    };
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(paths(sources), expected);
+
+    // Collecting again is stable
+    es_script::ScriptSources again;
+    again.addSearchPath(scripts.path("library"));
+    ASSERT_TRUE(again.collect(scripts.path("main.mr")));
+    EXPECT_EQ(again.getHash(), sources.getHash());
+    EXPECT_TRUE(again.changedSince(sources).empty());
+
+    EXPECT_FALSE(sources.collect(scripts.path("missing.mr")));
+    EXPECT_TRUE(sources.getFiles().empty());
+}
+
+TEST(ScriptSourcesTests, EditedImportChangesCompiledScriptKey) {
+    Scripts scripts;
+    writeTree(&scripts);
+
+    es_script::ScriptSources before;
+    before.addSearchPath(scripts.path("library"));
+    ASSERT_TRUE(before.collect(scripts.path("main.mr")));
+
+    // Only the imported file changes; main.mr is untouched
+    scripts.write("library/engines.mr", "node engine { }\n");
+
+    es_script::ScriptSources after;
+    after.addSearchPath(scripts.path("library"));
+    ASSERT_TRUE(after.collect(scripts.path("main.mr")));
+
+    EXPECT_NE(after.getHash(), before.getHash());
+    EXPECT_EQ(after.changedSince(before), std::vector<std::string>{ scripts.path("library/engines.mr") });
+    EXPECT_NE(
+        EngineLoader::CompiledScriptKey(after.getHash()).getHash(),
+        EngineLoader::CompiledScriptKey(before.getHash()).getHash());
+
+    // Editing a decoy changes nothing
+    scripts.write("commented.mr", "node changed {}\n");
+
+    es_script::ScriptSources decoy;
+    decoy.addSearchPath(scripts.path("library"));
+    ASSERT_TRUE(decoy.collect(scripts.path("main.mr")));
+    EXPECT_EQ(decoy.getHash(), after.getHash());
+    EXPECT_EQ(
+        EngineLoader::CompiledScriptKey(decoy.getHash()).getHash(),
+        EngineLoader::CompiledScriptKey(after.getHash()).getHash());
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "../include/simulation_arena.h"
+
+#include <cstdint>
+
+namespace {
+int g_liveObjects = 0;
+
+struct Tracked {
+    Tracked() { ++g_liveObjects; }
+    ~Tracked() { --g_liveObjects; }
+
+    double value = 1.0;
+};
+} /* namespace */
+
+TEST(SimulationArenaTests, FootprintFitsAllocations) {
+    SimulationArena arena;
+    arena.initialize(
+        SimulationArena::footprint<char>(3)
+        + SimulationArena::footprint<double>(5)
+        + SimulationArena::footprint<Tracked>(7)
+        + SimulationArena::footprint<int>(0));
+
+    char *c = arena.allocate<char>(3);
+    double *d = arena.allocate<double>(5);
+    Tracked *t = arena.allocate<Tracked>(7);
+    int *empty = arena.allocate<int>(0);
+
+    EXPECT_NE(c, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % alignof(double), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(t) % alignof(Tracked), 0);
+    EXPECT_EQ(empty, nullptr);
+    EXPECT_LE(arena.getUsed(), arena.getCapacity());
+
+    EXPECT_EQ(d[4], 0.0);
+    EXPECT_EQ(t[6].value, 1.0);
+    EXPECT_EQ(g_liveObjects, 7);
+
+    arena.destroy();
+    EXPECT_EQ(g_liveObjects, 0);
+}
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include "../include/simulation_checkpoint.h"
+
+#include "../include/piston_engine_simulator.h"
+#include "../include/vtec_valvetrain.h"
+#include "test_engine.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The test twin loaded into a simulator without audio
+struct Rig {
+    Engine *engine;
+    Vehicle *vehicle;
+    Transmission *transmission;
+    PistonEngineSimulator *simulator;
+
+    explicit Rig(bool vtec = false) {
+        engine = test_engine::buildEngine(vtec);
+        vehicle = test_engine::buildVehicle();
+        transmission = test_engine::buildTransmission();
+        simulator = static_cast<PistonEngineSimulator *>(
+            engine->createSimulator(vehicle, transmission, false, false));
+    }
+
+    ~Rig() {
+        simulator->releaseSimulation();
+        delete simulator;
+        test_engine::release(engine, vehicle, transmission);
+    }
+};
+
+// A sample of the dynamic state a checkpoint covers
+struct State {
+    double crankAngle, crankSpeed, pistonY;
+    double chamberTemperature, peakTemperature;
+    bool lit;
+    int gear;
+    double throttle;
+
+    bool operator==(const State &other) const {
+        return crankAngle == other.crankAngle
+            && crankSpeed == other.crankSpeed
+            && pistonY == other.pistonY
+            && chamberTemperature == other.chamberTemperature
+            && peakTemperature == other.peakTemperature
+            && lit == other.lit
+            && gear == other.gear
+            && throttle == other.throttle;
+    }
+};
+
+State sample(Engine *engine, Transmission *transmission) {
+    CombustionChamber::FluidState *fluid = engine->getChamber(0)->getFluidState();
+
+    State state;
+    state.crankAngle = engine->getCrankshaft(0)->m_body.theta;
+    state.crankSpeed = engine->getCrankshaft(0)->m_body.v_theta;
+    state.pistonY = engine->getPiston(1)->m_body.p_y;
+    state.chamberTemperature = fluid->system.temperature();
+    state.peakTemperature = fluid->peakTemperature;
+    state.lit = fluid->lit;
+    state.gear = transmission->getGear();
+    state.throttle = engine->getThrottle();
+
+    return state;
+}
+
+// Moves every sampled field somewhere the others don't
+void perturb(Engine *engine, Transmission *transmission, int k) {
+    CombustionChamber::FluidState *fluid = engine->getChamber(0)->getFluidState();
+
+    engine->getCrankshaft(0)->m_body.theta = 0.25 * k;
+    engine->getCrankshaft(0)->m_body.v_theta = -units::rpm(1000.0 * k);
+    engine->getPiston(1)->m_body.p_y = units::distance(k, units::inch);
+    fluid->system.reset(units::pressure(1.0, units::atm), units::celcius(25.0 + 100.0 * k));
+    fluid->peakTemperature = 500.0 + 100.0 * k;
+    fluid->lit = (k % 2) == 1;
+    transmission->changeGear(k % transmission->getGearCount());
+    engine->setThrottle(0.1 * k);
+}
+
+std::vector<char> readBytes(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void writeBytes(const std::string &path, const std::vector<char> &data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+} /* namespace */
+
+TEST(SimulationCheckpointTests, RestoresCapturedState) {
+    Rig rig;
+    perturb(rig.engine, rig.transmission, 1);
+    const State captured = sample(rig.engine, rig.transmission);
+
+    SimulationCheckpoint checkpoint;
+    checkpoint.capture(rig.simulator);
+    ASSERT_FALSE(checkpoint.isEmpty());
+
+    perturb(rig.engine, rig.transmission, 2);
+    ASSERT_FALSE(sample(rig.engine, rig.transmission) == captured);
+
+    EXPECT_TRUE(checkpoint.restore(rig.simulator));
+    EXPECT_TRUE(sample(rig.engine, rig.transmission) == captured);
+
+    // Capturing again from the restored state gives the same checkpoint
+    SimulationCheckpoint again;
+    again.capture(rig.simulator);
+    EXPECT_EQ(again.getSize(), checkpoint.getSize());
+
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "engine_sim_simulation_checkpoint_tests";
+    std::filesystem::create_directories(directory);
+    ASSERT_TRUE(checkpoint.save((directory / "first.bin").string()));
+    ASSERT_TRUE(again.save((directory / "again.bin").string()));
+    EXPECT_EQ(readBytes((directory / "first.bin").string()), readBytes((directory / "again.bin").string()));
+    std::filesystem::remove_all(directory);
+}
+
+TEST(SimulationCheckpointTests, LeavesConfigurationAlone) {
+    Rig rig;
+    rig.simulator->setFluidSimulationSteps(8);
+
+    SimulationCheckpoint checkpoint;
+    checkpoint.capture(rig.simulator);
+
+    rig.simulator->setFluidSimulationSteps(3);
+    EXPECT_TRUE(checkpoint.restore(rig.simulator));
+    EXPECT_EQ(rig.simulator->getFluidSimulationSteps(), 3);
+}
+
+TEST(SimulationCheckpointTests, RollsBackCorruptCheckpoint) {
+    Rig rig;
+    perturb(rig.engine, rig.transmission, 1);
+
+    SimulationCheckpoint checkpoint;
+    checkpoint.capture(rig.simulator);
+
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "engine_sim_simulation_checkpoint_tests";
+    std::filesystem::create_directories(directory);
+    const std::string path = (directory / "checkpoint.bin").string();
+    ASSERT_TRUE(checkpoint.save(path));
+    const std::vector<char> data = readBytes(path);
+
+    perturb(rig.engine, rig.transmission, 2);
+    const State current = sample(rig.engine, rig.transmission);
+
+    // Cut short past the bodies and gas systems, which are restored by the
+    // time the reader runs out, and with a byte too many
+    for (const size_t size : { data.size() - 1, data.size() / 2, data.size() + 1 }) {
+        std::vector<char> corrupt = data;
+        corrupt.resize(size, 0);
+        writeBytes(path, corrupt);
+
+        SimulationCheckpoint loaded;
+        ASSERT_TRUE(loaded.load(path));
+        EXPECT_FALSE(loaded.restore(rig.simulator)) << "size " << size;
+        EXPECT_TRUE(sample(rig.engine, rig.transmission) == current) << "size " << size;
+    }
+
+    // A checkpoint of another engine layout is refused outright
+    std::vector<char> otherLayout = data;
+    otherLayout[sizeof(int32_t) * 4] ^= 0x01;
+    writeBytes(path, otherLayout);
+
+    SimulationCheckpoint loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_FALSE(loaded.restore(rig.simulator));
+    EXPECT_TRUE(sample(rig.engine, rig.transmission) == current);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(SimulationCheckpointTests, RestoresVtecSolenoid) {
+    Rig rig(true);
+    VtecValvetrain *vtec = test_engine::configureVtec(rig.engine, 0.0, 0.1);
+
+    // Engaged, and part way through the delay back out
+    Crankshaft *crankshaft = rig.engine->getCrankshaft(0);
+    crankshaft->m_body.v_theta = -units::rpm(6000);
+    vtec->update(0.1);
+    crankshaft->m_body.v_theta = -units::rpm(4000);
+    vtec->update(0.06);
+    ASSERT_TRUE(vtec->isEngaged());
+
+    SimulationCheckpoint checkpoint;
+    checkpoint.capture(rig.simulator);
+
+    vtec->update(0.06);
+    ASSERT_FALSE(vtec->isEngaged());
+    ASSERT_EQ(vtec->getActiveIntakeCamshaft(), vtec->getIntakeCamshaft());
+
+    EXPECT_TRUE(checkpoint.restore(rig.simulator));
+    EXPECT_TRUE(vtec->isEngaged());
+    EXPECT_EQ(vtec->getActiveIntakeCamshaft(), vtec->getVtecIntakeCamshaft());
+    EXPECT_EQ(vtec->getActiveExhaustCamshaft(), vtec->getVtecExhaustCamshaft());
+
+    // The rest of the delay, not all of it
+    crankshaft->m_body.v_theta = -units::rpm(4000);
+    vtec->update(0.05);
+    EXPECT_FALSE(vtec->isEngaged());
+
+    // A checkpoint of the other valvetrain doesn't fit
+    Rig standard;
+    SimulationCheckpoint other;
+    other.capture(standard.simulator);
+    EXPECT_FALSE(other.restore(rig.simulator));
+}
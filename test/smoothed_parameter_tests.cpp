@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "../include/smoothed_parameter.h"
+
+TEST(SmoothedParameterTests, RampEndsOnTheTarget) {
+    SmoothedParameter gain;
+    gain.reset(1.0f);
+    gain.setTarget(0.0f);
+
+    float step;
+    const float start = gain.ramp(4, &step);
+    EXPECT_EQ(start, 1.0f);
+    EXPECT_FLOAT_EQ(step, -0.25f);
+    EXPECT_FLOAT_EQ(start + 4 * step, 0.0f);
+    EXPECT_TRUE(gain.isSettled());
+
+    // A settled value ramps flat
+    EXPECT_EQ(gain.ramp(4, &step), 0.0f);
+    EXPECT_EQ(step, 0.0f);
+}
+
+TEST(SmoothedParameterTests, GlideSettlesAndThenStops) {
+    SmoothedParameter cutoff;
+    cutoff.reset(2000.0f);
+    EXPECT_FALSE(cutoff.glide(0.5f, 1.0f));
+
+    cutoff.setTarget(4000.0f);
+    int moves = 0;
+    float last = cutoff.getValue();
+    while (cutoff.glide(0.5f, 1.0f)) {
+        EXPECT_GT(cutoff.getValue(), last);
+        last = cutoff.getValue();
+        ++moves;
+        ASSERT_LT(moves, 100);
+    }
+
+    // Halving the distance every block lands within a hertz in 11 blocks
+    EXPECT_EQ(moves, 11);
+    EXPECT_EQ(cutoff.getValue(), 4000.0f);
+    EXPECT_FALSE(cutoff.glide(0.5f, 1.0f));
+
+    EXPECT_EQ(SmoothedParameter::GlideFraction(256, 44100.0f, 0.0f), 1.0f);
+    EXPECT_NEAR(SmoothedParameter::GlideFraction(441, 44100.0f, 0.01f), 1 - std::exp(-1.0f), 1E-6f);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include "../include/sound_bank_baker.h"
+#include "../include/sound_bank_player.h"
+#include "../include/constants.h"
+
+#include <cmath>
+#include <filesystem>
+
+TEST(SoundBankTests, CaptureNormalizesCyclesToPhase) {
+    constexpr int Cycles = 3;
+    constexpr int FramesPerCycle = 256;
+
+    SoundBankBaker::CycleCapture capture;
+    capture.begin(2, Cycles, 1 << 14);
+
+    // Cycles of different lengths, and some frames before the first start
+    const int lengths[] = { 700, 731, 688, 745, 710, 699 };
+    for (int i = 0; i < 50; ++i) {
+        const double frame[2] = { 5.0, 5.0 };
+        capture.addFrame(frame, false);
+    }
+
+    for (int length : lengths) {
+        for (int i = 0; i < length && !capture.isComplete(); ++i) {
+            const double phase = (double)i / length;
+            const double frame[2] = { std::sin(2 * constants::pi * phase), phase };
+            capture.addFrame(frame, i == 0);
+        }
+    }
+
+    ASSERT_TRUE(capture.isComplete());
+
+    std::vector<float> output((Cycles + 1) * FramesPerCycle * 2);
+    capture.normalize(FramesPerCycle, output.data());
+
+    for (int k = 0; k <= Cycles; ++k) {
+        for (int j = 0; j < FramesPerCycle; ++j) {
+            const double phase = (double)j / FramesPerCycle;
+            const float *frame = output.data() + ((size_t)k * FramesPerCycle + j) * 2;
+            ASSERT_NEAR(frame[0], std::sin(2 * constants::pi * phase), 1E-4) << k << " " << j;
+            ASSERT_NEAR(frame[1], phase, 2E-3) << k << " " << j;
+        }
+    }
+}
+
+TEST(SoundBankTests, SaveAndLoad) {
+    SoundBank bank;
+    bank.initialize({ 1000.0, 3000.0 }, { 0.2, 1.0 }, 2, 16, 2);
+    bank.setInputSampleRate(12000);
+    bank.setImpulseResponse(1, "es/sound-library/smooth/smooth_39.wav", 0.5);
+
+    Synthesizer::AudioParameters audioParams;
+    audioParams.airNoise = 0.25f;
+    bank.setAudioParameters(audioParams);
+
+    for (int r = 0; r < 2; ++r) {
+        for (int t = 0; t < 2; ++t) {
+            float *cell = bank.getCell(r, t);
+            for (int i = 0; i < bank.getCellFrames() * 2; ++i) cell[i] = static_cast<float>(r * 1000 + t * 100 + i);
+        }
+    }
+
+    const std::string path = testing::TempDir() + "sound_bank_tests.esb";
+    ASSERT_TRUE(bank.save(path));
+
+    SoundBank loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.getChannelCount(), 2);
+    EXPECT_EQ(loaded.getFramesPerCycle(), 16);
+    EXPECT_EQ(loaded.getCyclesPerCell(), 2);
+    EXPECT_EQ(loaded.getRpms(), bank.getRpms());
+    EXPECT_EQ(loaded.getThrottles(), bank.getThrottles());
+    EXPECT_EQ(loaded.getInputSampleRate(), 12000);
+    EXPECT_EQ(loaded.getAudioParameters().airNoise, 0.25f);
+    EXPECT_EQ(loaded.getImpulseResponse(0).filename, "");
+    EXPECT_EQ(loaded.getImpulseResponse(1).filename, "es/sound-library/smooth/smooth_39.wav");
+    EXPECT_EQ(loaded.getImpulseResponse(1).volume, 0.5);
+
+    for (int r = 0; r < 2; ++r) {
+        for (int t = 0; t < 2; ++t) {
+            for (int i = 0; i < bank.getCellFrames() * 2; ++i) {
+                ASSERT_EQ(loaded.getCell(r, t)[i], bank.getCell(r, t)[i]);
+            }
+        }
+    }
+
+    // A truncated file is rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_FALSE(loaded.load(path));
+}
+
+TEST(SoundBankTests, PlayerBlendsCellsAndFollowsSpeed) {
+    constexpr int FramesPerCycle = 64;
+
+    // Cells hold a constant per speed and throttle
+    SoundBank bank;
+    bank.initialize({ 1000.0, 2000.0 }, { 0.0, 1.0 }, 1, FramesPerCycle, 3);
+    bank.setInputSampleRate(10000);
+    for (int r = 0; r < 2; ++r) {
+        for (int t = 0; t < 2; ++t) {
+            float *cell = bank.getCell(r, t);
+            for (int i = 0; i < bank.getCellFrames(); ++i) cell[i] = static_cast<float>(1 + r + 10 * t);
+        }
+    }
+
+    SoundBankPlayer player;
+    player.initialize(&bank, SoundBankPlayer::Parameters());
+    player.seed(7);
+
+    double frame = 0.0;
+    player.setOperatingPoint(1500.0, 0.5);
+    player.generate(&frame, 1);
+    EXPECT_NEAR(frame, 0.25 * (1 + 2 + 11 + 12), 1E-9);
+
+    player.setOperatingPoint(500.0, 2.0);
+    player.generate(&frame, 1);
+    EXPECT_NEAR(frame, 11.0, 1E-9);
+
+    // 1200 rpm is 10 cycles a second; a grain starts with each one
+    player.setOperatingPoint(1200.0, 0.0);
+    const unsigned long long grains = player.getGrainCount();
+    std::vector<double> frames(10000);
+    player.generate(frames.data(), static_cast<int>(frames.size()));
+    EXPECT_NEAR((double)(player.getGrainCount() - grains), 10.0, 1.0);
+    for (double f : frames) ASSERT_NEAR(f, 1.2, 1E-9);
+
+    std::vector<int16_t> audio(2048);
+    EXPECT_EQ(player.render(static_cast<int>(audio.size()), audio.data()), 2048);
+
+    player.destroy();
+}
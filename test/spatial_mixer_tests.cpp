@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include "../include/spatial_mixer.h"
+#include "../include/constants.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+void initializeSource(Synthesizer *synthesizer, double frequency) {
+    Synthesizer::Parameters params;
+    params.inputChannelCount = 1;
+    params.inputBufferSize = 4096;
+    params.audioBufferSize = 44100;
+    params.inputSampleRate = 44100;
+    params.audioSampleRate = 44100;
+    params.leveling = false;
+    params.initialAudioParameters.convolution = 0.0f;
+    params.initialAudioParameters.airNoise = 0.0f;
+    params.initialAudioParameters.inputSampleNoise = 0.0f;
+    synthesizer->initialize(params);
+    synthesizer->setOfflineMode(true);
+    synthesizer->initializeImpulseResponse(nullptr, 0, 0.0f, 0);
+
+    std::vector<double> input(2048);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = 2000 * std::sin(2 * constants::pi * frequency * i / 44100.0);
+    }
+
+    synthesizer->writeInput(input.data(), (int)input.size());
+    synthesizer->endInputBlock();
+    synthesizer->renderPendingAudio();
+}
+} /* namespace */
+
+TEST(SpatialMixerTests, DistanceAndPanning) {
+    SpatialMixer::Parameters params;
+    params.referenceDistance = 5.0f;
+    params.rolloff = 1.0f;
+
+    SpatialMixer mixer;
+    mixer.initialize(params);
+
+    float left, right;
+    mixer.computeGains(0.0f, 2.0f, 1.0f, &left, &right);
+    EXPECT_NEAR(left, std::sqrt(0.5f), 1E-5f);
+    EXPECT_NEAR(right, std::sqrt(0.5f), 1E-5f);
+
+    // Twice the reference distance is half the gain, all of it on the right
+    mixer.computeGains(10.0f, 0.0f, 1.0f, &left, &right);
+    EXPECT_NEAR(left, 0.0f, 1E-5f);
+    EXPECT_NEAR(right, 0.5f, 1E-5f);
+
+    // Constant power across the pan
+    mixer.computeGains(-3.0f, 4.0f, 2.0f, &left, &right);
+    EXPECT_NEAR(left * left + right * right, 4.0f, 1E-4f);
+    EXPECT_GT(left, right);
+
+    mixer.destroy();
+}
+
+TEST(SpatialMixerTests, MixesSourcesPannedAndLeveledOnce) {
+    Synthesizer near, far;
+    initializeSource(&near, 220.0);
+    initializeSource(&far, 220.0);
+    EXPECT_FALSE(near.isLeveling());
+
+    SpatialMixer::Parameters params;
+    params.blockSize = 128;
+    params.levelerMinGain = 1.0f;
+    params.levelerMaxGain = 1.0f;
+
+    SpatialMixer mixer;
+    mixer.initialize(params);
+    const int a = mixer.addSource(&near);
+    const int b = mixer.addSource(&far);
+    ASSERT_EQ(mixer.getSourceCount(), 2);
+
+    mixer.setSourcePosition(a, -5.0f, 0.0f);
+    mixer.setSourcePosition(b, 20.0f, 0.0f);
+
+    constexpr int Frames = 1024;
+    std::vector<float> output(Frames * SpatialMixer::OutputChannels);
+    mixer.mix(Frames, output.data());
+
+    // Past the first block's fade in and the leveler's lookahead, the left
+    // bus is the near source alone and the right the far one at a quarter
+    double leftEnergy = 0, rightEnergy = 0;
+    for (int i = 512; i < Frames; ++i) {
+        leftEnergy += output[2 * i] * output[2 * i];
+        rightEnergy += output[2 * i + 1] * output[2 * i + 1];
+    }
+
+    ASSERT_GT(leftEnergy, 0.0);
+    EXPECT_NEAR(std::sqrt(rightEnergy / leftEnergy), 0.25, 0.02);
+    EXPECT_EQ(mixer.getStatistics().underruns, 0);
+
+    // Once both have played out the mix goes on with silence
+    mixer.mix(Frames, output.data());
+    mixer.mix(Frames, output.data());
+    EXPECT_GE(mixer.getStatistics().underruns, 2 * (Frames / 128));
+    EXPECT_EQ(output[2 * (Frames - 1)], 0.0f);
+
+    mixer.removeSource(a);
+    EXPECT_EQ(mixer.getSourceCount(), 1);
+
+    mixer.destroy();
+    near.destroy();
+    far.destroy();
+}
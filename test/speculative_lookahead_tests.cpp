@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+
+#include "../include/speculative_lookahead.h"
+
+#include <chrono>
+
+TEST(SpeculativeLookaheadTests, WithoutBranchesOutputPassesThrough) {
+    JobSystem jobs;
+    jobs.initialize(0);
+
+    SpeculativeLookahead lookahead;
+    lookahead.initialize(&jobs, SpeculativeLookahead::Parameters());
+    EXPECT_FALSE(lookahead.hasBranches());
+
+    EXPECT_FALSE(lookahead.update(nullptr, 0.5, std::chrono::steady_clock::now()));
+    EXPECT_FALSE(lookahead.engage(1.0, 0, 4096));
+    EXPECT_FALSE(lookahead.isEngaged());
+
+    float samples[64];
+    for (int i = 0; i < 64; ++i) samples[i] = (float)i;
+    lookahead.mix(samples, 64, 0);
+    for (int i = 0; i < 64; ++i) EXPECT_EQ(samples[i], (float)i);
+
+    EXPECT_EQ(lookahead.getStatistics().forks, 0ull);
+
+    lookahead.destroy();
+    jobs.destroy();
+}
+
+TEST(SpeculativeLookaheadTests, FutureNames) {
+    EXPECT_STREQ(SpeculativeLookahead::GetFutureName(SpeculativeLookahead::Future::Hold), "hold");
+    EXPECT_STREQ(SpeculativeLookahead::GetFutureName(SpeculativeLookahead::Future::Up), "up");
+    EXPECT_STREQ(SpeculativeLookahead::GetFutureName(SpeculativeLookahead::Future::Down), "down");
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "../include/gas_system.h"
+#include "../include/speculative_stepping.h"
+#include "../include/units.h"
+
+#include <limits>
+
+namespace {
+
+GasSystem atmosphere() {
+    GasSystem system;
+    system.initialize(
+        units::pressure(1.0, units::atm),
+        units::volume(1.0, units::L),
+        units::celcius(25.0));
+
+    return system;
+}
+
+} /* namespace */
+
+TEST(SpeculativeSteppingTests, HealthyGasPasses) {
+    const SpeculativeStepping::Parameters params;
+    const GasSystem system = atmosphere();
+
+    EXPECT_EQ(SpeculativeStepping::CheckGas(system, params), SpeculativeStepping::Failure::None);
+}
+
+TEST(SpeculativeSteppingTests, GasOutOfBoundsFails) {
+    SpeculativeStepping::Parameters params;
+
+    GasSystem system = atmosphere();
+    system.setN(-system.n());
+    EXPECT_EQ(SpeculativeStepping::CheckGas(system, params), SpeculativeStepping::Failure::GasBounds);
+
+    system = atmosphere();
+    system.setN(std::numeric_limits<double>::quiet_NaN());
+    EXPECT_EQ(SpeculativeStepping::CheckGas(system, params), SpeculativeStepping::Failure::NonFinite);
+
+    system = atmosphere();
+    params.maxPressure = units::pressure(0.5, units::atm);
+    EXPECT_EQ(SpeculativeStepping::CheckGas(system, params), SpeculativeStepping::Failure::GasBounds);
+
+    params = SpeculativeStepping::Parameters();
+    params.maxTemperature = units::celcius(0.0);
+    EXPECT_EQ(SpeculativeStepping::CheckGas(system, params), SpeculativeStepping::Failure::GasBounds);
+}
+
+TEST(SpeculativeSteppingTests, StatisticsCountFramesAndFailures) {
+    SpeculativeStepping stepping;
+    stepping.initialize(SpeculativeStepping::Parameters());
+
+    stepping.recordFrame(false);
+    stepping.recordFrame(true);
+    stepping.recordFailure(SpeculativeStepping::Failure::Speed, true);
+    stepping.recordFailure(SpeculativeStepping::Failure::NonFinite, false);
+
+    const SpeculativeStepping::Statistics &stats = stepping.getStatistics();
+    EXPECT_EQ(stats.frames, 2ull);
+    EXPECT_EQ(stats.refinedFrames, 1ull);
+    EXPECT_EQ(stats.rollbacks, 1ull);
+    EXPECT_EQ(stats.failures[static_cast<int>(SpeculativeStepping::Failure::Speed)], 1ull);
+    EXPECT_EQ(stats.failures[static_cast<int>(SpeculativeStepping::Failure::NonFinite)], 1ull);
+
+    stepping.reset();
+    EXPECT_EQ(stepping.getStatistics().frames, 0ull);
+    EXPECT_EQ(stepping.getStatistics().rollbacks, 0ull);
+}
+
+TEST(SpeculativeSteppingTests, FailureNames) {
+    EXPECT_STREQ(SpeculativeStepping::GetFailureName(SpeculativeStepping::Failure::None), "none");
+    EXPECT_STREQ(
+        SpeculativeStepping::GetFailureName(SpeculativeStepping::Failure::ConstraintDrift),
+        "constraint_drift");
+    EXPECT_STREQ(SpeculativeStepping::GetFailureName(SpeculativeStepping::Failure::Count), "unknown");
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include "../include/startup_timeline.h"
+
+#include <thread>
+
+TEST(StartupTimelineTests, RecordsPhasesPerThread) {
+    StartupTimeline::Start();
+    {
+        StartupTimeline::Scope scope("main_phase");
+    }
+
+    std::thread worker([] {
+        StartupTimeline::Scope scope("worker_phase");
+    });
+    worker.join();
+
+    StartupTimeline::Mark("first_sound");
+    StartupTimeline::Stop();
+
+    // Nothing is recorded once stopped
+    {
+        StartupTimeline::Scope scope("late_phase");
+    }
+
+    const std::vector<StartupTimeline::Event> events = StartupTimeline::GetEvents();
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].name, "main_phase");
+    EXPECT_EQ(events[0].thread, 0);
+    EXPECT_EQ(events[1].name, "worker_phase");
+    EXPECT_EQ(events[1].thread, 1);
+    EXPECT_TRUE(events[2].instant);
+
+    int64_t firstSound = -1;
+    EXPECT_TRUE(StartupTimeline::FindMark("first_sound", &firstSound));
+    EXPECT_GE(firstSound, events[1].begin + events[1].duration);
+    EXPECT_FALSE(StartupTimeline::FindMark("worker_phase", &firstSound));
+}
+
+TEST(StartupTimelineTests, ChromeTraceFormat) {
+    StartupTimeline::Start();
+    StartupTimeline::Record("compile_script", 100, 350);
+    StartupTimeline::Stop();
+
+    const std::string trace = StartupTimeline::ToChromeTrace();
+    EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+    EXPECT_NE(
+        trace.find("{\"name\":\"compile_script\",\"ph\":\"X\",\"ts\":100,\"dur\":250,\"pid\":1,\"tid\":0}"),
+        std::string::npos);
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "../include/steady_state_detector.h"
+
+#include <cmath>
+
+namespace {
+
+// 60 frames/s at 3000 rpm: one engine cycle every 40 ms
+SimulationSnapshot sample(double t, double torque) {
+    SimulationSnapshot snapshot;
+    snapshot.time = t;
+    snapshot.rpm = 3000.0;
+    snapshot.filteredDynoTorque = torque;
+    snapshot.manifoldPressure = 90000.0;
+    snapshot.intakeAfr = 13.0;
+
+    return snapshot;
+}
+
+} /* namespace */
+
+TEST(SteadyStateDetectorTests, SettlesOnceTransientDecays) {
+    SteadyStateDetector detector;
+    detector.initialize(SteadyStateDetector::Parameters());
+
+    int events = 0;
+    double settledTime = 0;
+    for (int i = 0; i <= 600; ++i) {
+        const double t = i / 60.0;
+        const double torque = 300.0 + 200.0 * std::exp(-t / 0.5);
+        if (detector.addSample(sample(t, torque))) {
+            ++events;
+            settledTime = t;
+        }
+    }
+
+    EXPECT_EQ(events, 1);
+    EXPECT_TRUE(detector.isSettled());
+    EXPECT_EQ(detector.getSettledTime(), settledTime);
+    EXPECT_GT(settledTime, 0.5);
+    EXPECT_LT(settledTime, 3.0);
+    EXPECT_NEAR(detector.getWindowAverage().torque, 300.0, 6.0);
+}
+
+TEST(SteadyStateDetectorTests, OscillationNeverSettles) {
+    SteadyStateDetector detector;
+    detector.initialize(SteadyStateDetector::Parameters());
+
+    // A period of three cycles doesn't average out within a cycle, so the
+    // cycle averages keep swinging across the window
+    for (int i = 0; i <= 600; ++i) {
+        const double t = i / 60.0;
+        EXPECT_FALSE(detector.addSample(sample(t, 300.0 + 50.0 * std::sin(t * 2 * 3.14159265 / 0.12))));
+    }
+
+    EXPECT_FALSE(detector.isSettled());
+    EXPECT_GT(detector.getCycleCount(), 200);
+
+    detector.reset();
+    EXPECT_EQ(detector.getCycleCount(), 0);
+}
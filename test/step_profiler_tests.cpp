@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include "../include/step_profiler.h"
+
+#include <thread>
+
+TEST(StepProfilerTests, CapturesSpansPerThread) {
+    if (!StepProfiler::IsEnabled()) {
+        EXPECT_EQ(StepProfiler::ToChromeTrace().find("\"ph\":\"X\""), std::string::npos);
+        GTEST_SKIP() << "built without ENGINE_SIM_PROFILE_STEPS";
+    }
+
+    StepProfiler::StartCapture(16);
+    std::thread worker([] {
+        StepProfiler::SetThreadName("test_worker");
+        const uint64_t start = StepProfiler::Now();
+        StepProfiler::Record(StepProfiler::Stage::SynthesizerLockWait, start, StepProfiler::Now());
+    });
+    worker.join();
+
+    for (int i = 0; i < 32; ++i) {
+        const uint64_t start = StepProfiler::Now();
+        StepProfiler::Record(StepProfiler::Stage::Step, start, StepProfiler::Now());
+    }
+
+    StepProfiler::StopCapture();
+
+    // The ring kept only the most recent spans, all from this thread
+    const std::string trace = StepProfiler::ToChromeTrace();
+    EXPECT_NE(trace.find("\"args\":{\"name\":\"test_worker\"}"), std::string::npos);
+    EXPECT_NE(trace.find("{\"name\":\"step\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_EQ(trace.find("synthesizer_lock_wait"), std::string::npos);
+
+    int spans = 0;
+    for (size_t i = trace.find("\"ph\":\"X\""); i != std::string::npos; i = trace.find("\"ph\":\"X\"", i + 1)) {
+        ++spans;
+    }
+
+    EXPECT_EQ(spans, 16);
+}
+
+TEST(StepProfilerTests, StatisticsSinceSnapshot) {
+    StepProfiler::Statistics earlier;
+    earlier.count = 2;
+    earlier.totalMicroseconds = 3.0;
+    earlier.buckets[4] = 2;
+
+    StepProfiler::Statistics later = earlier;
+    later.count = 12;
+    later.totalMicroseconds = 23.0;
+    later.buckets[4] = 3;
+    later.buckets[10] = 9;
+
+    const StepProfiler::Statistics window = later.since(earlier);
+    EXPECT_EQ(window.count, 10u);
+    EXPECT_DOUBLE_EQ(window.averageMicroseconds(), 2.0);
+    EXPECT_EQ(window.buckets[4], 1u);
+    EXPECT_DOUBLE_EQ(window.percentileMicroseconds(0.5), 1.024);
+}
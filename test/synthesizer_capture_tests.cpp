@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include "../include/synthesizer_replay.h"
+#include "../include/constants.h"
+
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+namespace {
+std::string capturePath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// A pair of exhaust pulses at different rates, like two banks of cylinders
+bool recordPulses(const std::string &path, int frames, double audioVolume) {
+    std::vector<SynthesizerCapture::Channel> channels(2);
+    channels[0].audioVolume = audioVolume;
+    channels[1].audioVolume = audioVolume;
+
+    Synthesizer::AudioParameters audioParameters;
+    audioParameters.convolution = 0.0f;
+    audioParameters.airNoise = 0.0f;
+    audioParameters.inputSampleNoise = 0.0f;
+
+    SynthesizerCapture capture;
+    if (!capture.record(path, 10000.0, audioParameters, channels, 1024)) return false;
+
+    std::vector<double> block(2 * 100);
+    for (int f = 0; f < frames; f += 100) {
+        for (int i = 0; i < 100; ++i) {
+            const double t = (f + i) / 10000.0;
+            block[2 * i + 0] = 1000 * audioVolume * std::sin(2 * constants::pi * 90 * t);
+            block[2 * i + 1] = 1000 * audioVolume * std::sin(2 * constants::pi * 130 * t);
+        }
+
+        capture.write(block.data(), 100);
+        if (!capture.flush()) return false;
+    }
+
+    return capture.close();
+}
+
+double rms(const std::vector<int16_t> &samples) {
+    double sum = 0;
+    for (int16_t s : samples) sum += (double)s * s;
+    return std::sqrt(sum / std::max<size_t>(samples.size(), 1));
+}
+} /* namespace */
+
+TEST(SynthesizerCaptureTests, RecordAndLoad) {
+    const std::string path = capturePath("synthesizer_capture_tests.essc");
+
+    std::vector<SynthesizerCapture::Channel> channels(2);
+    channels[1].impulseResponse = "es/sound-library/smooth/smooth_39.wav";
+    channels[1].impulseResponseVolume = 0.5;
+    channels[1].audioVolume = 2.0;
+
+    Synthesizer::AudioParameters audioParameters;
+    audioParameters.airNoise = 0.25f;
+
+    SynthesizerCapture capture;
+    ASSERT_TRUE(capture.record(path, 12000.0, audioParameters, channels, 8));
+
+    // Everything past the capacity until the next flush is dropped
+    std::vector<double> frames(2 * 10);
+    for (int i = 0; i < 20; ++i) frames[i] = i * 0.5;
+
+    capture.write(frames.data(), 10);
+    ASSERT_TRUE(capture.flush());
+    capture.write(frames.data(), 3);
+    ASSERT_TRUE(capture.close());
+
+    EXPECT_EQ(capture.getWrittenCount(), 11);
+    EXPECT_EQ(capture.getDroppedCount(), 2);
+
+    SynthesizerCapture loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.getChannelCount(), 2);
+    EXPECT_EQ(loaded.getInputSampleRate(), 12000.0);
+    EXPECT_EQ(loaded.getAudioParameters().airNoise, 0.25f);
+    EXPECT_TRUE(loaded.getChannel(0).impulseResponse.empty());
+    EXPECT_EQ(loaded.getChannel(1).impulseResponse, channels[1].impulseResponse);
+    EXPECT_EQ(loaded.getChannel(1).impulseResponseVolume, 0.5);
+    EXPECT_EQ(loaded.getChannel(1).audioVolume, 2.0);
+
+    ASSERT_EQ(loaded.getFrameCount(), 11);
+    for (int i = 0; i < 16; ++i) EXPECT_EQ(loaded.getFrames()[i], frames[i]);
+    for (int i = 0; i < 6; ++i) EXPECT_EQ(loaded.getFrames()[16 + i], frames[i]);
+
+    // A capture cut short mid-frame keeps the whole frames
+    const uintmax_t size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - sizeof(float) * 3);
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.getFrameCount(), 9);
+
+    std::filesystem::resize_file(path, sizeof(SynthesizerCapture::Header));
+    EXPECT_FALSE(loaded.load(path));
+
+    std::filesystem::remove(path);
+}
+
+TEST(SynthesizerCaptureTests, ReplayRescalesExhaustVolume) {
+    const std::string path = capturePath("synthesizer_capture_replay_tests.essc");
+    constexpr int Frames = 20000;
+    ASSERT_TRUE(recordPulses(path, Frames, 0.5));
+
+    SynthesizerCapture capture;
+    ASSERT_TRUE(capture.load(path));
+    ASSERT_EQ(capture.getFrameCount(), Frames);
+
+    // Loudness follows the exhaust volume, so the leveler has to hold still
+    SynthesizerReplay::Parameters params;
+    params.audioSampleRate = 22050;
+    params.overrideAudioParameters = true;
+    params.audioParameters = capture.getAudioParameters();
+    params.audioParameters.levelerMinGain = 1.0f;
+    params.audioParameters.levelerMaxGain = 1.0f;
+
+    auto render = [&](double audioVolume, std::vector<int16_t> *output) {
+        params.channels = { capture.getChannel(0), capture.getChannel(1) };
+        for (SynthesizerCapture::Channel &channel : params.channels) channel.audioVolume = audioVolume;
+
+        SynthesizerReplay replay;
+        ASSERT_TRUE(replay.initialize(&capture, params));
+
+        std::vector<int16_t> block(512);
+        while (!replay.isFinished()) {
+            const int n = replay.render(512, block.data());
+            if (n == 0) break;
+            output->insert(output->end(), block.begin(), block.begin() + n);
+        }
+
+        EXPECT_TRUE(replay.isFinished());
+        replay.destroy();
+    };
+
+    std::vector<int16_t> original, louder;
+    render(0.5, &original);
+    render(1.0, &louder);
+
+    // The whole capture plays, at the output rate, and nothing more
+    const size_t expected = (size_t)Frames * 22050 / 10000;
+    EXPECT_EQ(original.size(), expected);
+    EXPECT_EQ(louder.size(), expected);
+
+    ASSERT_GT(rms(original), 10.0);
+    EXPECT_NEAR(rms(louder) / rms(original), 2.0, 0.1);
+
+    std::filesystem::remove(path);
+}
@@ -3,6 +3,10 @@
 #include "../include/synthesizer.h"
 
 #include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -188,3 +192,587 @@ TEST(SynthesizerTests, SynthesizerSystemTest) {
 
     delete[] output;
 }
+
+TEST(SynthesizerTests, SynthesizerBlockRenderMatchesScalar) {
+    constexpr int blocks = 8;
+    constexpr int blockSize = 200;
+
+    Synthesizer::Parameters params;
+    params.inputBufferSize = blockSize;
+    params.inputChannelCount = 4;
+    params.levelerBlockSize = 0;
+    params.audioSampleRate = 44100;
+    params.inputSampleRate = 10000;
+
+    Synthesizer scalar, block;
+    scalar.initialize(params);
+    block.initialize(params);
+
+    std::vector<float> convolution(64);
+    for (size_t i = 0; i < convolution.size(); ++i) {
+        convolution[i] = std::exp(-(float)i / 8) * ((i % 2 == 0) ? 1.0f : -0.5f);
+    }
+
+    for (Synthesizer *synth : { &scalar, &block }) {
+        synth->setRandomSeed(42);
+        for (int i = 0; i < params.inputChannelCount; ++i) {
+            synth->m_filters[i].convolution.initialize((int)convolution.size());
+            std::copy(
+                convolution.begin(),
+                convolution.end(),
+                synth->m_filters[i].convolution.getImpulseResponse());
+        }
+    }
+
+    int16_t output[blockSize];
+    for (int b = 0; b < blocks; ++b) {
+        for (Synthesizer *synth : { &scalar, &block }) {
+            for (int i = 0; i < params.inputChannelCount; ++i) {
+                for (int j = 0; j < blockSize; ++j) {
+                    const int t = b * blockSize + j;
+                    synth->m_inputChannels[i].transferBuffer[j] =
+                        1000.0f * std::sin(0.01f * t * (i + 1));
+                }
+
+                synth->m_filters[i].jitterFilter.setJitterScale(synth->m_audioParameters.inputSampleNoise);
+                synth->m_filters[i].airNoise.fill(
+                    synth->m_inputChannels[i].noiseBuffer, blockSize, -1.0f, 1.0f);
+            }
+        }
+
+        block.renderAudioBlock(blockSize, output);
+        for (int j = 0; j < blockSize; ++j) {
+            EXPECT_EQ(output[j], scalar.renderAudio(j));
+        }
+    }
+
+    scalar.destroy();
+    block.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerInputRingDropsWhenFull) {
+    Synthesizer synth;
+    setupSynchronizedSynthesizer(synth);
+
+    for (int i = 0; i < 3 * synth.m_inputBufferSize; ++i) {
+        const double data[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+        synth.writeInput(data);
+    }
+
+    EXPECT_EQ(synth.inputSamplesAvailable(), 0);
+
+    synth.endInputBlock();
+
+    EXPECT_EQ(synth.inputSamplesAvailable(), synth.m_inputBufferSize);
+    EXPECT_EQ(synth.isProcessed(), false);
+    EXPECT_GT(synth.m_inputDroppedCount.load(), 0u);
+
+    synth.renderAudio();
+
+    EXPECT_EQ(synth.inputSamplesAvailable(), 0);
+    EXPECT_EQ(synth.isProcessed(), true);
+
+    synth.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerBlockInputMatchesPerFrame) {
+    constexpr int frames = 200;
+
+    Synthesizer::Parameters params;
+    params.inputBufferSize = 4096;
+    params.inputChannelCount = 2;
+    params.audioSampleRate = 44100;
+    params.inputSampleRate = 10000;
+
+    Synthesizer perFrame, block;
+    perFrame.initialize(params);
+    block.initialize(params);
+
+    std::vector<double> data(frames * params.inputChannelCount);
+    for (int f = 0; f < frames; ++f) {
+        data[f * 2 + 0] = std::sin(0.05 * f);
+        data[f * 2 + 1] = std::cos(0.02 * f);
+    }
+
+    for (int f = 0; f < frames; ++f) {
+        perFrame.writeInput(data.data() + f * 2);
+    }
+
+    block.writeInput(data.data(), 7);
+    block.writeInput(data.data() + 7 * 2, frames - 7);
+
+    perFrame.endInputBlock();
+    block.endInputBlock();
+
+    ASSERT_EQ(block.inputSamplesAvailable(), perFrame.inputSamplesAvailable());
+    for (int i = 0; i < params.inputChannelCount; ++i) {
+        for (int j = 0; j < block.inputSamplesAvailable(); ++j) {
+            EXPECT_EQ(block.m_inputChannels[i].data[j], perFrame.m_inputChannels[i].data[j]);
+        }
+    }
+
+    perFrame.destroy();
+    block.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerMultichannelOutputFollowsMix) {
+    Synthesizer::Parameters params;
+    params.inputBufferSize = 1024;
+    params.audioBufferSize = 4096;
+    params.inputChannelCount = 2;
+    params.outputChannelCount = 2;
+    params.audioSampleRate = 44100;
+    params.inputSampleRate = 10000;
+
+    Synthesizer synth;
+    synth.initialize(params);
+    synth.setOfflineMode(true);
+
+    EXPECT_EQ(synth.getOutputMix(0, 0), 1.0f);
+    EXPECT_EQ(synth.getOutputMix(1, 0), 0.0f);
+    EXPECT_EQ(synth.getOutputMix(1, 1), 1.0f);
+
+    synth.setOutputMix(0, 1, 0.5f);
+
+    for (int f = 0; f < 100; ++f) {
+        const double data[] = { 1000.0 * std::sin(0.3 * f), 0.0 };
+        synth.writeInput(data);
+    }
+
+    synth.endInputBlock();
+    synth.renderAudio();
+
+    const int frames = synth.multichannelFramesAvailable();
+    ASSERT_GT(frames, 0);
+    EXPECT_EQ(frames, synth.audioSamplesAvailable());
+
+    const float *data = nullptr;
+    EXPECT_EQ(synth.peekMultichannelOutput(&data), frames);
+
+    float peak = 0.0f;
+    for (int j = 0; j < frames; ++j) {
+        EXPECT_FLOAT_EQ(data[j * 2 + 1], 0.5f * data[j * 2 + 0]);
+        peak = std::max(peak, std::abs(data[j * 2]));
+    }
+
+    EXPECT_GT(peak, 0.0f);
+
+    std::vector<float> copy(4 * 2);
+    EXPECT_EQ(synth.readMultichannelOutput(4, copy.data()), 4);
+    EXPECT_EQ(copy[0], data[0]);
+    EXPECT_EQ(synth.multichannelFramesAvailable(), frames - 4);
+
+    synth.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerFloatOutputQuantizesOnRead) {
+    Synthesizer::Parameters params;
+    params.inputBufferSize = 1024;
+    params.audioBufferSize = 4096;
+    params.inputChannelCount = 1;
+    params.audioSampleRate = 44100;
+    params.inputSampleRate = 10000;
+
+    Synthesizer synth;
+    synth.initialize(params);
+    synth.setOfflineMode(true);
+
+    for (int f = 0; f < 200; ++f) {
+        const double data[] = { 50.0 * std::sin(0.2 * f) };
+        synth.writeInput(data);
+    }
+
+    synth.endInputBlock();
+    synth.renderAudio();
+
+    const int n = synth.audioSamplesAvailable();
+    ASSERT_GT(n, 0);
+
+    std::vector<float> samples(n);
+    EXPECT_EQ(synth.readAudioOutput(n, samples.data()), n);
+
+    std::vector<int16_t> plain(n), dithered(n);
+    synth.quantizeOutput(samples.data(), plain.data(), n);
+
+    synth.setOutputDither(true);
+    synth.quantizeOutput(samples.data(), dithered.data(), n);
+
+    int differences = 0;
+    for (int i = 0; i < n; ++i) {
+        const long expected = std::min(
+            32767L, std::max(-32768L, std::lround(samples[i] * Synthesizer::Int16Scale)));
+        EXPECT_NEAR(plain[i], expected, 1);
+        EXPECT_NEAR(dithered[i], plain[i], 1);
+        if (dithered[i] != plain[i]) ++differences;
+    }
+
+    EXPECT_GT(differences, 0);
+
+    synth.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerPendingRenderDoesNotWait) {
+    Synthesizer synth;
+    setupSynchronizedSynthesizer(synth);
+
+    // Nothing has arrived yet; renderAudio() would block here
+    EXPECT_EQ(synth.renderPendingAudio(), 0);
+    EXPECT_EQ(synth.audioSamplesAvailable(), 0);
+
+    for (int i = 0; i < 100; ++i) {
+        const double data[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+        synth.writeInput(data);
+    }
+
+    synth.endInputBlock();
+
+    EXPECT_EQ(synth.renderPendingAudio(), 100);
+    EXPECT_EQ(synth.audioSamplesAvailable(), 100);
+    EXPECT_EQ(synth.isProcessed(), true);
+    EXPECT_EQ(synth.renderPendingAudio(), 0);
+
+    std::vector<float> samples(100);
+    EXPECT_EQ(synth.readAudioOutput(100, samples.data()), 100);
+
+    synth.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerFollowsLatencyProbeSample) {
+    Synthesizer synth;
+    setupSynchronizedSynthesizer(synth);
+
+    LatencyProbe probe;
+    probe.setEnabled(true);
+    synth.setLatencyProbe(&probe);
+
+    const double data[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+    for (int i = 0; i < 40; ++i) synth.writeInput(data);
+    synth.endInputBlock();
+    synth.renderPendingAudio();
+
+    std::vector<float> samples(100);
+    EXPECT_EQ(synth.readAudioOutput(30, samples.data()), 30);
+
+    // Control applied now; the next block carries its sample
+    ASSERT_TRUE(probe.begin(LatencyProbe::Clock::now()));
+    probe.mark(LatencyProbe::Stage::Applied);
+
+    synth.writeInput(data, 1);
+    EXPECT_TRUE(probe.isWaiting(LatencyProbe::Stage::Published));
+    synth.endInputBlock();
+    EXPECT_EQ(probe.getPosition(LatencyProbe::Stage::Published), 40);
+
+    EXPECT_EQ(synth.renderPendingAudio(), 1);
+    EXPECT_EQ(probe.getPosition(LatencyProbe::Stage::Rendered), 40);
+
+    // Ten samples ahead of it are still unread
+    EXPECT_EQ(synth.readAudioOutput(20, samples.data()), 11);
+    EXPECT_TRUE(probe.isWaiting(LatencyProbe::Stage::Played));
+    EXPECT_EQ(probe.getPosition(LatencyProbe::Stage::Read), 10);
+
+    probe.mark(LatencyProbe::Stage::Played);
+    EXPECT_EQ(probe.getCompletedCount(), 1);
+
+    synth.destroy();
+}
+
+TEST(SynthesizerTests, ImpulseResponseResampledKeepsGainAndDuration) {
+    // A decaying 1 kHz tone recorded at 44.1 kHz
+    std::vector<int16_t> recorded(4410);
+    for (size_t i = 0; i < recorded.size(); ++i) {
+        const double t = i / 44100.0;
+        recorded[i] = static_cast<int16_t>(
+            20000 * std::exp(-t / 0.02) * std::cos(2 * 3.14159265358979 * 1000 * t));
+    }
+
+    ConvolutionFilter native, resampled;
+    Synthesizer::prepareImpulseResponse(
+        recorded.data(), static_cast<unsigned int>(recorded.size()), 1.0f, &native);
+    Synthesizer::prepareImpulseResponse(
+        recorded.data(), static_cast<unsigned int>(recorded.size()), 1.0f, &resampled, 44100, 48000);
+
+    EXPECT_NEAR(
+        resampled.getSampleCount(),
+        native.getSampleCount() * 48000.0 / 44100.0,
+        1.0);
+
+    // Response to a 1 kHz tone, well inside both bands, is the same
+    auto gainAt = [](ConvolutionFilter &filter, double sampleRate) {
+        double re = 0, im = 0;
+        for (int i = 0; i < filter.getSampleCount(); ++i) {
+            const double phase = 2 * 3.14159265358979 * 1000 * i / sampleRate;
+            re += filter.getImpulseResponse()[i] * std::cos(phase);
+            im += filter.getImpulseResponse()[i] * std::sin(phase);
+        }
+
+        return std::sqrt(re * re + im * im);
+    };
+
+    const double expected = gainAt(native, 44100);
+    EXPECT_NEAR(gainAt(resampled, 48000), expected, expected * 0.01);
+
+    native.destroy();
+    resampled.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerConcealsWithTheLastPeriod) {
+    Synthesizer::Parameters params;
+    params.inputBufferSize = 1024;
+    params.audioBufferSize = 8192;
+    params.inputChannelCount = 1;
+    params.audioSampleRate = 44100;
+    params.inputSampleRate = 10000;
+
+    // The reference gets the same input and never conceals
+    constexpr int Period = 400;
+    Synthesizer synth, reference;
+    for (Synthesizer *s : { &synth, &reference }) {
+        s->initialize(params);
+        s->setOfflineMode(true);
+        s->setConcealmentPeriod(Period / 44100.0);
+    }
+
+    int f = 0;
+    auto render = [&](int frames) {
+        for (int i = 0; i < frames; ++i, ++f) {
+            const double data[] = { 50.0 * std::sin(0.07 * f) };
+            synth.writeInput(data);
+            reference.writeInput(data);
+        }
+
+        for (Synthesizer *s : { &synth, &reference }) {
+            s->endInputBlock();
+            s->renderAudio();
+        }
+    };
+
+    std::vector<float> samples(4096), expected(4096);
+    EXPECT_EQ(synth.concealOutput(100, samples.data()), 0);
+
+    render(600);
+    const int n = synth.audioSamplesAvailable();
+    ASSERT_GT(n, Period);
+    EXPECT_EQ(synth.readAudioOutput(n, samples.data()), n);
+    EXPECT_EQ(reference.readAudioOutput(n, expected.data()), n);
+
+    // Continues from the last sample, then repeats the period quieter
+    std::vector<float> concealed(3 * Period);
+    ASSERT_EQ(synth.concealOutput((int)concealed.size(), concealed.data()), (int)concealed.size());
+    EXPECT_NEAR(concealed[0], samples[n - 1], 1E-5);
+    EXPECT_EQ(synth.getConcealedSampleCount(), concealed.size());
+
+    float peak = 0;
+    for (int i = 2 * Period; i < 3 * Period; ++i) {
+        EXPECT_NEAR(concealed[i], Synthesizer::ConcealmentDecay * concealed[i - Period], 1E-3);
+        peak = std::max(peak, std::abs(concealed[i]));
+    }
+
+    EXPECT_GT(peak, 0.0f);
+
+    // Output crossfades back in from the repeat and is untouched after
+    render(200);
+    const int m = synth.audioSamplesAvailable();
+    ASSERT_GT(m, Synthesizer::ConcealmentFade);
+    EXPECT_EQ(synth.readAudioOutput(m, samples.data()), m);
+    EXPECT_EQ(reference.readAudioOutput(m, expected.data()), m);
+    EXPECT_GT(std::abs(samples[0] - expected[0]), 0.0f);
+    for (int i = Synthesizer::ConcealmentFade; i < m; ++i) {
+        ASSERT_EQ(samples[i], expected[i]) << i;
+    }
+
+    // Turned off, there's nothing to conceal with
+    synth.setConcealmentPeriod(0);
+    EXPECT_EQ(synth.concealOutput(100, samples.data()), 0);
+
+    synth.destroy();
+    reference.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerSharesIdenticalImpulseResponses) {
+    Synthesizer::Parameters params;
+    params.inputBufferSize = 1024;
+    params.audioBufferSize = 8192;
+    params.inputChannelCount = 4;
+    params.audioSampleRate = 44100;
+    params.inputSampleRate = 10000;
+
+    std::vector<int16_t> a(300), b(200);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = (int16_t)(20000 * std::exp(-0.01 * i) * std::cos(0.3 * i));
+    for (size_t i = 0; i < b.size(); ++i) b[i] = (int16_t)(15000 * std::exp(-0.02 * i) * std::sin(0.1 * i));
+
+    // Multichannel output keeps the reference convolving every channel
+    Synthesizer synth, reference;
+    synth.initialize(params);
+    params.outputChannelCount = 1;
+    reference.initialize(params);
+
+    auto load = [&](int channel, const std::vector<int16_t> &response, float volume) {
+        for (Synthesizer *s : { &synth, &reference }) {
+            s->initializeImpulseResponse(response.data(), (unsigned int)response.size(), volume, channel);
+        }
+    };
+
+    load(0, a, 1.0f);
+    load(1, b, 1.0f);
+    load(2, a, 1.0f);
+    load(3, a, 0.5f);
+    EXPECT_EQ(synth.getConvolutionCount(), 3);
+    EXPECT_EQ(reference.getConvolutionCount(), 4);
+    EXPECT_EQ(synth.getConvolution(2).getSampleCount(), synth.getConvolution(0).getSampleCount());
+
+    // Replacing the shared channel's response leaves it with the others
+    load(0, b, 1.0f);
+    EXPECT_EQ(synth.getConvolutionCount(), 3);
+    load(3, a, 1.0f);
+    EXPECT_EQ(synth.getConvolutionCount(), 2);
+
+    for (Synthesizer *s : { &synth, &reference }) s->setOfflineMode(true);
+
+    int f = 0;
+    for (int block = 0; block < 4; ++block) {
+        for (int i = 0; i < 500; ++i, ++f) {
+            const double data[] = {
+                50.0 * std::sin(0.07 * f), 30.0 * std::sin(0.11 * f), 20.0 * std::cos(0.05 * f), 10.0
+            };
+
+            synth.writeInput(data);
+            reference.writeInput(data);
+        }
+
+        for (Synthesizer *s : { &synth, &reference }) {
+            s->endInputBlock();
+            s->renderAudio();
+        }
+
+        const int n = synth.audioSamplesAvailable();
+        ASSERT_EQ(reference.audioSamplesAvailable(), n);
+
+        std::vector<float> samples(n), expected(n);
+        synth.readAudioOutput(n, samples.data());
+        reference.readAudioOutput(n, expected.data());
+        // Only the order of the float sums differs
+        float peak = 0;
+        for (int i = 0; i < n; ++i) peak = std::max(peak, std::abs(expected[i]));
+        for (int i = 0; i < n; ++i) {
+            EXPECT_NEAR(samples[i], expected[i], 1E-3 * peak) << i;
+        }
+    }
+
+    synth.destroy();
+    reference.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerSwapsImpulseResponsesAtNextBlock) {
+    Synthesizer::Parameters params;
+    params.inputBufferSize = 1024;
+    params.audioBufferSize = 8192;
+    params.inputChannelCount = 2;
+    params.audioSampleRate = 44100;
+    params.inputSampleRate = 10000;
+
+    std::vector<int16_t> a(300);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = (int16_t)(20000 * std::exp(-0.01 * i) * std::cos(0.3 * i));
+
+    std::shared_ptr<ConvolutionFilter> prepared(
+        new ConvolutionFilter, [](ConvolutionFilter *filter) { filter->destroy(); delete filter; });
+    Synthesizer::prepareImpulseResponse(a.data(), (unsigned int)a.size(), 1.0f, prepared.get());
+
+    Synthesizer synth, reference;
+    synth.initialize(params);
+    reference.initialize(params);
+    reference.initializeImpulseResponse(*prepared, 0);
+    reference.initializeImpulseResponse(nullptr, 0, 0.0f, 1);
+
+    // Nothing changes until the renderer takes them, and the caller's
+    // reference can go at once
+    synth.swapImpulseResponses({ prepared, nullptr });
+    prepared.reset();
+    EXPECT_EQ(synth.getConvolution(0).getSampleCount(), 1);
+
+    for (int i = 0; i < 500; ++i) {
+        const double data[] = { 50.0 * std::sin(0.07 * i), 10.0 };
+        synth.writeInput(data);
+        reference.writeInput(data);
+    }
+
+    for (Synthesizer *s : { &synth, &reference }) {
+        s->endInputBlock();
+        s->renderPendingAudio();
+    }
+
+    EXPECT_EQ(synth.getConvolution(0).getSampleCount(), reference.getConvolution(0).getSampleCount());
+
+    const int n = synth.audioSamplesAvailable();
+    ASSERT_EQ(reference.audioSamplesAvailable(), n);
+    ASSERT_GT(n, 0);
+
+    std::vector<float> samples(n), expected(n);
+    synth.readAudioOutput(n, samples.data());
+    reference.readAudioOutput(n, expected.data());
+    EXPECT_EQ(samples, expected);
+
+    synth.destroy();
+    reference.destroy();
+}
+
+TEST(SynthesizerTests, SynthesizerRampsVolumeChanges) {
+    Synthesizer::Parameters params;
+    params.inputChannelCount = 1;
+    params.inputBufferSize = 4096;
+    params.audioBufferSize = 44100;
+    params.inputSampleRate = 44100;
+    params.audioSampleRate = 44100;
+    params.leveling = false;
+    params.initialAudioParameters.convolution = 0.0f;
+    params.initialAudioParameters.airNoise = 0.0f;
+    params.initialAudioParameters.inputSampleNoise = 0.0f;
+
+    Synthesizer synth;
+    synth.initialize(params);
+    synth.setOfflineMode(true);
+
+    auto render = [&synth](int offset, std::vector<float> *output) {
+        std::vector<double> input(1024);
+        for (size_t i = 0; i < input.size(); ++i) {
+            input[i] = 2000 * std::sin(0.05 * (offset + (double)i));
+        }
+
+        synth.writeInput(input.data(), (int)input.size());
+        synth.endInputBlock();
+        synth.renderPendingAudio();
+
+        float buffer[1024];
+        int read;
+        while ((read = synth.readAudioOutput(1024, buffer)) > 0) {
+            output->insert(output->end(), buffer, buffer + read);
+        }
+    };
+
+    std::vector<float> before, after;
+    render(0, &before);
+    render(1024, &before);
+
+    Synthesizer::AudioParameters muted = synth.getAudioParameters();
+    muted.volume = 0.0f;
+    synth.setAudioParameters(muted);
+    render(2048, &after);
+    render(3072, &after);
+
+    ASSERT_GT(after.size(), 64u);
+
+    // The mute fades out across the next block instead of stepping
+    float peak = 0;
+    for (size_t i = before.size() / 2; i < before.size(); ++i) peak = std::fmax(peak, std::abs(before[i]));
+    ASSERT_GT(peak, 0.0f);
+
+    float head = 0;
+    for (int i = 0; i < 32; ++i) head = std::fmax(head, std::abs(after[i]));
+    EXPECT_GT(head, 0.5f * peak);
+    EXPECT_EQ(after.back(), 0.0f);
+
+    for (size_t i = 1; i < after.size(); ++i) {
+        ASSERT_LT(std::abs(after[i] - after[i - 1]), 0.2f * peak) << i;
+    }
+
+    synth.destroy();
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "../include/telemetry_export.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace {
+std::string temporaryPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+TelemetryExport::Sample makeSample(int i) {
+    TelemetryExport::Sample sample = {};
+    sample.time = i * 0.001;
+    sample.rpm = 1000.0f + i;
+    sample.gear = i % 6;
+    sample.cylinderPressure[0] = 101325.0f + i;
+    return sample;
+}
+} /* namespace */
+
+TEST(TelemetryExportTests, ReaderSeesRecordsInOrder) {
+    const std::string path = temporaryPath("engine_sim_telemetry_export_order.bin");
+
+    TelemetryExport writer;
+    ASSERT_TRUE(writer.open(path, 64));
+    writer.setLayout(4, 0.001);
+
+    TelemetryExportReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.getCylinderCount(), 4);
+
+    for (int i = 0; i < 10; ++i) writer.write(makeSample(i));
+
+    std::vector<TelemetryExport::Sample> samples(64);
+    ASSERT_EQ(reader.read(samples.data(), 64), 10);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(samples[i].index, static_cast<uint64_t>(i));
+        EXPECT_FLOAT_EQ(samples[i].rpm, 1000.0f + i);
+        EXPECT_EQ(samples[i].gear, i % 6);
+        EXPECT_FLOAT_EQ(samples[i].cylinderPressure[0], 101325.0f + i);
+    }
+
+    EXPECT_EQ(reader.read(samples.data(), 64), 0);
+
+    reader.close();
+    writer.close();
+    std::remove(path.c_str());
+}
+
+TEST(TelemetryExportTests, LappedRecordsAreDropped) {
+    const std::string path = temporaryPath("engine_sim_telemetry_export_lapped.bin");
+
+    TelemetryExport writer;
+    ASSERT_TRUE(writer.open(path, 16));
+
+    TelemetryExportReader reader;
+    ASSERT_TRUE(reader.open(path));
+
+    for (int i = 0; i < 40; ++i) writer.write(makeSample(i));
+
+    std::vector<TelemetryExport::Sample> samples(64);
+    ASSERT_EQ(reader.read(samples.data(), 64), 16);
+    EXPECT_EQ(samples[0].index, 24u);
+    EXPECT_EQ(samples[15].index, 39u);
+    EXPECT_EQ(reader.getDroppedCount(), 24u);
+
+    reader.close();
+    writer.close();
+    std::remove(path.c_str());
+}
+
+TEST(TelemetryExportTests, DecimationSkipsSteps) {
+    TelemetryExport writer;
+    const std::string path = temporaryPath("engine_sim_telemetry_export_decimation.bin");
+    ASSERT_TRUE(writer.open(path, 16, 4));
+
+    int due = 0;
+    for (int i = 0; i < 40; ++i) {
+        if (writer.isDue()) ++due;
+    }
+
+    EXPECT_EQ(due, 10);
+
+    writer.close();
+    std::remove(path.c_str());
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include "../include/telemetry_log.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+std::string temporaryPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// 10 kHz steps of a four cylinder engine around 3000 rpm
+TelemetryExport::Sample makeSample(int i) {
+    const double t = i * 1E-4;
+    const double crank = 2 * M_PI * 50 * t;
+
+    TelemetryExport::Sample sample;
+    std::memset(&sample, 0, sizeof(sample));
+    sample.index = (uint64_t)i;
+    sample.time = t;
+    sample.rpm = (float)(3000 + 50 * std::sin(2 * M_PI * 2 * t));
+    sample.throttle = (t < 0.5) ? 0.2f : 0.8f;
+    sample.dynoTorque = (float)(180 + 20 * std::sin(crank * 2));
+    sample.manifoldPressure = (float)(60000 + 8000 * std::sin(crank * 2));
+    sample.intakeAfr = 14.7f;
+    sample.vehicleSpeed = (float)(10 + t);
+    sample.gear = 2;
+    sample.flags = TelemetryExport::IgnitionEnabled;
+    for (int c = 0; c < 4; ++c) {
+        const double phase = std::cos(crank / 2 - c * M_PI / 2);
+        sample.cylinderPressure[c] = (float)(101325 + 3E6 * std::pow(std::max(0.0, phase), 8));
+    }
+
+    sample.events[0] = (i % 100 == 0) ? 1 : 0;
+    return sample;
+}
+
+size_t csvSize(const std::vector<TelemetryExport::Sample> &samples) {
+    size_t size = 0;
+    char line[1024];
+    for (const TelemetryExport::Sample &s : samples) {
+        int n = std::snprintf(
+            line, sizeof(line), "%llu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d,%u",
+            (unsigned long long)s.index, s.time, s.rpm, s.throttle, s.dynoTorque,
+            s.manifoldPressure, s.intakeAfr, s.vehicleSpeed, s.gear, s.flags);
+        for (int c = 0; c < 4; ++c) n += std::snprintf(line, sizeof(line), ",%.9g", s.cylinderPressure[c]);
+        for (int e = 0; e < EventCounters::CounterCount; ++e) n += std::snprintf(line, sizeof(line), ",%u", s.events[e]);
+        size += n + 1;
+    }
+
+    return size;
+}
+} /* namespace */
+
+TEST(TelemetryLogTests, ChunksRoundTripLosslessly) {
+    std::vector<TelemetryExport::Sample> samples;
+    for (int i = 0; i < 10000; ++i) samples.push_back(makeSample(i));
+
+    std::vector<uint8_t> encoded;
+    TelemetryLog::EncodeChunk(samples.data(), (int)samples.size(), 4, &encoded);
+
+    std::vector<TelemetryExport::Sample> decoded;
+    ASSERT_TRUE(TelemetryLog::DecodeChunk(encoded.data(), encoded.size(), (int)samples.size(), 4, &decoded));
+    ASSERT_EQ(decoded.size(), samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        ASSERT_EQ(std::memcmp(&decoded[i], &samples[i], sizeof(TelemetryExport::Sample)), 0) << i;
+    }
+
+    // A chunk cut short doesn't decode
+    decoded.clear();
+    EXPECT_FALSE(TelemetryLog::DecodeChunk(encoded.data(), encoded.size() - 1, (int)samples.size(), 4, &decoded));
+
+    // Smooth channels at a high step rate are what the encoding is for
+    EXPECT_LT(encoded.size() * 10, csvSize(samples));
+}
+
+TEST(TelemetryLogTests, LogsWhatTheExportWrites) {
+    const std::string exportPath = temporaryPath("engine_sim_telemetry_log_export.bin");
+    const std::string logPath = temporaryPath("engine_sim_telemetry_log.estl");
+
+    TelemetryExport writer;
+    ASSERT_TRUE(writer.open(exportPath, 16384));
+    writer.setLayout(4, 1E-4);
+
+    TelemetryLog::Parameters params;
+    params.chunkRows = 1000;
+
+    TelemetryLog log;
+    ASSERT_TRUE(log.open(exportPath, logPath, params));
+
+    for (int i = 0; i < 2500; ++i) writer.write(makeSample(i));
+    log.close();
+
+    const TelemetryLog::Statistics statistics = log.getStatistics();
+    EXPECT_EQ(statistics.rows, 2500ull);
+    EXPECT_EQ(statistics.chunks, 3ull);
+    EXPECT_EQ(statistics.dropped, 0ull);
+    EXPECT_EQ(statistics.bytes, (unsigned long long)std::filesystem::file_size(logPath));
+
+    TelemetryLogReader reader;
+    ASSERT_TRUE(reader.open(logPath));
+    EXPECT_EQ(reader.getCylinderCount(), 4);
+    EXPECT_DOUBLE_EQ(reader.getRecordInterval(), 1E-4);
+    EXPECT_EQ(reader.getColumnNames(), TelemetryLog::GetColumnNames(4));
+
+    std::vector<TelemetryExport::Sample> samples;
+    while (reader.readChunk(&samples)) {
+        /* void */
+    }
+
+    ASSERT_EQ(samples.size(), 2500u);
+    for (int i = 0; i < 2500; ++i) {
+        const TelemetryExport::Sample expected = makeSample(i);
+        EXPECT_EQ(samples[i].index, (uint64_t)i);
+        EXPECT_EQ(samples[i].time, expected.time);
+        EXPECT_EQ(samples[i].rpm, expected.rpm);
+        EXPECT_EQ(samples[i].cylinderPressure[3], expected.cylinderPressure[3]);
+    }
+
+    reader.close();
+    writer.close();
+    std::remove(logPath.c_str());
+    std::remove(exportPath.c_str());
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "../include/telemetry_tap.h"
+
+#include <thread>
+
+TEST(TelemetryTapTests, DropsWhenFull) {
+    TelemetryTap tap;
+    tap.initialize(3);
+
+    TelemetryTap::Record record = {};
+    for (int i = 0; i < 6; ++i) {
+        record.cycleAngle = (float)i;
+        EXPECT_EQ(tap.write(record), i < 4);
+    }
+
+    EXPECT_EQ(tap.getPendingCount(), 4);
+    EXPECT_EQ(tap.getDroppedCount(), 2ull);
+
+    TelemetryTap::Record records[8];
+    ASSERT_EQ(tap.read(records, 8), 4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(records[i].cycleAngle, (float)i);
+    }
+
+    EXPECT_EQ(tap.read(records, 8), 0);
+
+    tap.destroy();
+}
+
+TEST(TelemetryTapTests, ConcurrentReadsAreInOrder) {
+    constexpr int Writes = 50000;
+
+    TelemetryTap tap;
+    tap.initialize(256);
+
+    std::thread writer([&tap] {
+        TelemetryTap::Record record = {};
+        for (int i = 0; i < Writes; ++i) {
+            record.cycleAngle = (float)i;
+            record.pressure = (float)-i;
+            while (!tap.write(record)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    TelemetryTap::Record records[64];
+    while (expected < Writes) {
+        const int n = tap.read(records, 64);
+        for (int i = 0; i < n; ++i, ++expected) {
+            ASSERT_EQ(records[i].cycleAngle, (float)expected);
+            ASSERT_EQ(records[i].pressure, (float)-expected);
+        }
+    }
+
+    writer.join();
+    tap.destroy();
+}
@@ -0,0 +1,313 @@
+#ifndef ATG_ENGINE_SIM_TEST_ENGINE_H
+#define ATG_ENGINE_SIM_TEST_ENGINE_H
+
+#include "../include/camshaft.h"
+#include "../include/constants.h"
+#include "../include/direct_throttle_linkage.h"
+#include "../include/engine.h"
+#include "../include/engine_snapshot.h"
+#include "../include/function.h"
+#include "../include/impulse_response.h"
+#include "../include/standard_valvetrain.h"
+#include "../include/transmission.h"
+#include "../include/units.h"
+#include "../include/vehicle.h"
+#include "../include/vtec_valvetrain.h"
+
+#include <cmath>
+
+// A small engine built without a script, for tests that need a whole one
+namespace test_engine {
+
+inline Function *newFunction(double x0, double x1, double (*f)(double)) {
+    constexpr int Samples = 32;
+
+    Function *function = new Function;
+    function->initialize(Samples, (x1 - x0) / Samples);
+    for (int i = 0; i < Samples; ++i) {
+        const double x = x0 + (x1 - x0) * i / (Samples - 1);
+        function->addSample(x, f(x));
+    }
+
+    return function;
+}
+
+inline double lift(double theta) {
+    return units::distance(0.4, units::inch) * std::exp(-theta * theta / 0.5);
+}
+
+inline double flow(double lift) {
+    return units::flow(200.0, units::scfm) * lift / units::distance(0.5, units::inch);
+}
+
+inline double advance(double omega) {
+    return units::angle(10.0, units::deg) + omega * 0.01;
+}
+
+inline double turbulence(double speed) {
+    return 0.5 * speed + 3.0;
+}
+
+// An inline twin built the way EngineNode::buildEngine() does, with its
+// functions, camshafts, valvetrain and impulse response on the heap, as a
+// compiled script leaves them, so releaseTables() frees them too. With vtec
+// the head switches to a second, later pair of cams above 5000 rpm. Any
+// crankshafts after the first carry nothing and are only geared to it.
+inline Engine *buildEngine(bool vtec = false, int crankshafts = 1) {
+    Function *intakeFlow = newFunction(0.0, units::distance(0.5, units::inch), flow);
+    Function *exhaustFlow = newFunction(0.0, units::distance(0.5, units::inch), flow);
+    Function *lobeProfile = newFunction(-constants::pi / 2, constants::pi / 2, lift);
+    Function *timingCurve = newFunction(0.0, units::rpm(8000), advance);
+    Function *flameSpeed = newFunction(0.0, 10.0, turbulence);
+    Function *chamberTurbulence = newFunction(0.0, 20.0, turbulence);
+
+    DirectThrottleLinkage::Parameters throttleParams;
+    throttleParams.gamma = 2.0;
+    DirectThrottleLinkage *throttle = new DirectThrottleLinkage;
+    throttle->initialize(throttleParams);
+
+    Engine::Parameters params;
+    params.name = "Snapshot Twin";
+    params.cylinderBanks = 1;
+    params.cylinderCount = 2;
+    params.crankshaftCount = crankshafts;
+    params.exhaustSystemCount = 1;
+    params.intakeCount = 1;
+    params.throttle = throttle;
+    params.initialSimulationFrequency = 10000;
+    params.initialHighFrequencyGain = 0.01;
+    params.initialNoise = 1.0;
+    params.initialJitter = 0.5;
+
+    Engine *engine = new Engine;
+    engine->initialize(params);
+
+    Crankshaft::Parameters crankshaftParams;
+    crankshaftParams.mass = units::mass(30, units::kg);
+    crankshaftParams.flywheelMass = units::mass(10, units::kg);
+    crankshaftParams.momentOfInertia = 0.2;
+    crankshaftParams.crankThrow = units::distance(1.8, units::inch);
+    crankshaftParams.frictionTorque = units::torque(5.0, units::ft_lb);
+    crankshaftParams.rodJournals = 2;
+
+    Crankshaft *crankshaft = engine->getCrankshaft(0);
+    crankshaft->initialize(crankshaftParams);
+    crankshaft->setRodJournalAngle(0, 0.0);
+    crankshaft->setRodJournalAngle(1, constants::pi);
+
+    crankshaftParams.rodJournals = 0;
+    for (int i = 1; i < crankshafts; ++i) {
+        crankshaftParams.pos_x = units::distance(8.0 * i, units::inch);
+        engine->getCrankshaft(i)->initialize(crankshaftParams);
+    }
+
+    CylinderBank::Parameters bankParams;
+    bankParams.crankshaft = crankshaft;
+    bankParams.positionX = 0.0;
+    bankParams.positionY = 0.0;
+    bankParams.angle = 0.0;
+    bankParams.bore = units::distance(3.5, units::inch);
+    bankParams.deckHeight = units::distance(9.0, units::inch);
+    bankParams.displayDepth = 0.4;
+    bankParams.cylinderCount = 2;
+    bankParams.index = 0;
+    CylinderBank *bank = engine->getCylinderBank(0);
+    bank->initialize(bankParams);
+
+    for (int i = 0; i < 2; ++i) {
+        Piston::Parameters pistonParams;
+        pistonParams.Rod = engine->getConnectingRod(i);
+        pistonParams.Bank = bank;
+        pistonParams.CylinderIndex = i;
+        pistonParams.BlowbyFlowCoefficient = 1E-6;
+        pistonParams.CompressionHeight = units::distance(1.2, units::inch);
+        pistonParams.WristPinPosition = 0.0;
+        pistonParams.Displacement = 0.0;
+        pistonParams.mass = units::mass(500, units::g);
+        engine->getPiston(i)->initialize(pistonParams);
+
+        ConnectingRod::Parameters rodParams;
+        rodParams.mass = units::mass(600, units::g);
+        rodParams.momentOfInertia = 0.0015;
+        rodParams.centerOfMass = 0.0;
+        rodParams.length = units::distance(6.0, units::inch);
+        rodParams.piston = engine->getPiston(i);
+        rodParams.crankshaft = crankshaft;
+        rodParams.journal = i;
+        engine->getConnectingRod(i)->initialize(rodParams);
+    }
+
+    Camshaft *camshafts[4];
+    for (int i = 0; i < (vtec ? 4 : 2); ++i) {
+        Camshaft::Parameters camshaftParams;
+        camshaftParams.lobes = 2;
+        camshaftParams.advance = units::angle(2.0 * (i % 2) - 4.0 * (i / 2), units::deg);
+        camshaftParams.crankshaft = crankshaft;
+        camshaftParams.lobeProfile = lobeProfile;
+
+        camshafts[i] = new Camshaft;
+        camshafts[i]->initialize(camshaftParams);
+        camshafts[i]->setLobeCenterline(0, units::angle(110.0 + 250.0 * (i % 2), units::deg));
+        camshafts[i]->setLobeCenterline(1, units::angle(470.0 + 250.0 * (i % 2), units::deg));
+    }
+
+    Valvetrain *valvetrain = nullptr;
+    if (vtec) {
+        VtecValvetrain::Parameters valvetrainParams;
+        valvetrainParams.minRpm = units::rpm(5000);
+        valvetrainParams.minSpeed = 0.0;
+        valvetrainParams.manifoldVacuum = -1.0;
+        valvetrainParams.minThrottlePosition = -1.0;
+        valvetrainParams.intakeCamshaft = camshafts[0];
+        valvetrainParams.exhaustCamshaft = camshafts[1];
+        valvetrainParams.vtecIntakeCamshaft = camshafts[2];
+        valvetrainParams.vtexExhaustCamshaft = camshafts[3];
+        valvetrainParams.engine = engine;
+        VtecValvetrain *vtecValvetrain = new VtecValvetrain;
+        vtecValvetrain->initialize(valvetrainParams);
+        valvetrain = vtecValvetrain;
+    }
+    else {
+        StandardValvetrain::Parameters valvetrainParams;
+        valvetrainParams.intakeCamshaft = camshafts[0];
+        valvetrainParams.exhaustCamshaft = camshafts[1];
+        StandardValvetrain *standardValvetrain = new StandardValvetrain;
+        standardValvetrain->initialize(valvetrainParams);
+        valvetrain = standardValvetrain;
+    }
+
+    CylinderHead::Parameters headParams;
+    headParams.Bank = bank;
+    headParams.IntakePortFlow = intakeFlow;
+    headParams.ExhaustPortFlow = exhaustFlow;
+    headParams.ValvetrainSystem = valvetrain;
+    headParams.CombustionChamberVolume = units::volume(50.0, units::cc);
+    headParams.IntakeRunnerVolume = units::volume(150.0, units::cc);
+    headParams.IntakeRunnerCrossSectionArea = units::area(2.0, units::cm2);
+    headParams.ExhaustRunnerVolume = units::volume(50.0, units::cc);
+    headParams.ExhaustRunnerCrossSectionArea = units::area(2.0, units::cm2);
+
+    CylinderHead *head = engine->getHead(0);
+    head->initialize(headParams);
+
+    ImpulseResponse *impulseResponse = new ImpulseResponse;
+    impulseResponse->initialize("smooth_39.wav", 0.01);
+
+    ExhaustSystem::Parameters exhaustParams;
+    exhaustParams.length = units::distance(60.0, units::inch);
+    exhaustParams.collectorCrossSectionArea = units::area(5.0, units::cm2);
+    exhaustParams.outletFlowRate = units::flow(300.0, units::scfm);
+    exhaustParams.primaryTubeLength = units::distance(10.0, units::inch);
+    exhaustParams.primaryFlowRate = units::flow(100.0, units::scfm);
+    exhaustParams.velocityDecay = 1.0;
+    exhaustParams.audioVolume = 0.5;
+    exhaustParams.impulseResponse = impulseResponse;
+    engine->getExhaustSystem(0)->initialize(exhaustParams);
+
+    Intake::Parameters intakeParams;
+    intakeParams.volume = units::volume(1.0, units::L);
+    intakeParams.CrossSectionArea = units::area(10.0, units::cm2);
+    intakeParams.InputFlowK = 1E-4;
+    intakeParams.IdleFlowK = 1E-6;
+    intakeParams.RunnerFlowRate = 1E-4;
+    engine->getIntake(0)->initialize(intakeParams);
+
+    for (int i = 0; i < 2; ++i) {
+        head->setExhaustSystem(i, engine->getExhaustSystem(0));
+        head->setIntake(i, engine->getIntake(0));
+        head->setSoundAttenuation(i, 0.5 + 0.25 * i);
+        head->setHeaderPrimaryLength(i, units::distance(10.0 + i, units::inch));
+    }
+
+    IgnitionModule::Parameters ignitionParams;
+    ignitionParams.cylinderCount = 2;
+    ignitionParams.crankshaft = crankshaft;
+    ignitionParams.timingCurve = timingCurve;
+
+    IgnitionModule *ignition = engine->getIgnitionModule();
+    ignition->initialize(ignitionParams);
+    ignition->setFiringOrder(0, 0.0);
+    ignition->setFiringOrder(1, 2 * constants::pi);
+    ignition->setCylinderTrim(1, units::angle(1.5, units::deg));
+
+    Fuel::Parameters fuelParams;
+    fuelParams.turbulenceToFlameSpeedRatio = flameSpeed;
+    engine->getFuel()->initialize(fuelParams);
+
+    for (int i = 0; i < 2; ++i) {
+        CombustionChamber::Parameters chamberParams;
+        chamberParams.PistonPtr = engine->getPiston(i);
+        chamberParams.Head = head;
+        chamberParams.FuelPtr = engine->getFuel();
+        chamberParams.MeanPistonSpeedToTurbulence = chamberTurbulence;
+        chamberParams.StartingPressure = units::pressure(1.0, units::atm);
+        chamberParams.StartingTemperature = units::celcius(25.0);
+        chamberParams.CrankcasePressure = units::pressure(1.0, units::atm);
+        engine->getChamber(i)->initialize(chamberParams);
+    }
+
+    return engine;
+}
+
+// The VTEC twin's solenoid given a hysteresis (rpm) and a delay (seconds)
+inline VtecValvetrain *configureVtec(Engine *engine, double rpmHysteresis, double engagementDelay) {
+    VtecValvetrain *vtec = static_cast<VtecValvetrain *>(engine->getHead(0)->getValvetrain());
+
+    VtecValvetrain::Parameters params;
+    params.minRpm = vtec->getMinRpm();
+    params.minSpeed = vtec->getMinSpeed();
+    params.manifoldVacuum = vtec->getManifoldVacuum();
+    params.minThrottlePosition = vtec->getMinThrottlePosition();
+    params.rpmHysteresis = units::rpm(rpmHysteresis);
+    params.engagementDelay = engagementDelay;
+    params.intakeCamshaft = vtec->getIntakeCamshaft();
+    params.exhaustCamshaft = vtec->getExhaustCamshaft();
+    params.vtecIntakeCamshaft = vtec->getVtecIntakeCamshaft();
+    params.vtexExhaustCamshaft = vtec->getVtecExhaustCamshaft();
+    params.engine = engine;
+    vtec->initialize(params);
+
+    return vtec;
+}
+
+inline Vehicle *buildVehicle() {
+    Vehicle::Parameters params;
+    params.mass = units::mass(1200, units::kg);
+    params.dragCoefficient = 0.3;
+    params.crossSectionArea = 2.0;
+    params.diffRatio = 3.9;
+    params.tireRadius = units::distance(11, units::inch);
+    params.rollingResistance = 200.0;
+
+    Vehicle *vehicle = new Vehicle;
+    vehicle->initialize(params);
+    return vehicle;
+}
+
+inline Transmission *buildTransmission() {
+    const double gearRatios[] = { 3.2, 2.1, 1.4, 1.0 };
+
+    Transmission::Parameters params;
+    params.GearCount = 4;
+    params.GearRatios = gearRatios;
+    params.MaxClutchTorque = units::torque(300.0, units::ft_lb);
+
+    Transmission *transmission = new Transmission;
+    transmission->initialize(params);
+    return transmission;
+}
+
+inline void release(Engine *engine, Vehicle *vehicle, Transmission *transmission) {
+    delete vehicle;
+    delete transmission;
+
+    if (engine != nullptr) {
+        EngineSnapshot::releaseTables(engine);
+        engine->destroy();
+        delete engine;
+    }
+}
+
+} /* namespace test_engine */
+
+#endif /* ATG_ENGINE_SIM_TEST_ENGINE_H */
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "../include/thread_policy.h"
+
+#include <thread>
+
+TEST(ThreadPolicyTests, SettingsRoundTrip) {
+    const ThreadPolicy::Settings previous = ThreadPolicy::GetSettings();
+
+    ThreadPolicy::Settings settings;
+    settings.realtimeAudio = false;
+    settings.physicsCore = 3;
+    ThreadPolicy::SetSettings(settings);
+
+    const ThreadPolicy::Settings read = ThreadPolicy::GetSettings();
+    EXPECT_FALSE(read.realtimeAudio);
+    EXPECT_FALSE(read.realtimePhysics);
+    EXPECT_EQ(read.audioCore, -1);
+    EXPECT_EQ(read.physicsCore, 3);
+
+    ThreadPolicy::SetSettings(previous);
+}
+
+#if defined(__linux__) || defined(_WIN32)
+TEST(ThreadPolicyTests, PinsWithoutRealtime) {
+    const ThreadPolicy::Settings previous = ThreadPolicy::GetSettings();
+
+    ThreadPolicy::Settings settings;
+    settings.realtimeAudio = false;
+    settings.realtimePhysics = false;
+    settings.physicsCore = 0;
+    ThreadPolicy::SetSettings(settings);
+
+    bool applied = false;
+    std::thread thread([&applied] {
+        applied = ThreadPolicy::ApplyToCurrentThread(ThreadPolicy::Role::Physics, 1 / 240.0);
+    });
+    thread.join();
+
+    EXPECT_TRUE(applied);
+
+    ThreadPolicy::SetSettings(previous);
+}
+#endif
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include "../include/thread_pool.h"
+
+#include <vector>
+
+TEST(ThreadPoolTests, ThreadPoolSanityCheck) {
+    ThreadPool pool;
+    pool.initialize(4);
+    pool.destroy();
+}
+
+TEST(ThreadPoolTests, ThreadPoolRunsEveryIndexOnce) {
+    ThreadPool pool;
+    pool.initialize(4);
+
+    std::vector<int> counts(64, 0);
+    long long expected = 0;
+    for (int i = 0; i < 10000; ++i) {
+        const int n = 1 + i % 64;
+        pool.parallelFor(n, [&counts](int j) { ++counts[j]; });
+        expected += n;
+    }
+
+    long long total = 0;
+    for (int count : counts) total += count;
+
+    EXPECT_EQ(total, expected);
+    EXPECT_EQ(counts[0], 10000);
+
+    pool.destroy();
+}
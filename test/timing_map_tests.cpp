@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "../include/timing_map.h"
+#include "../include/function.h"
+#include "../include/units.h"
+
+namespace {
+void linearCurve(Function *f, double advance0, double advance1) {
+    f->initialize(2, units::rpm(1000));
+    f->addSample(0.0, advance0);
+    f->addSample(units::rpm(8000), advance1);
+}
+} /* namespace */
+
+TEST(TimingMapTests, BilinearBetweenGridPoints) {
+    TimingMap map;
+    map.initialize(3, 2, 0.0, 2.0, 10.0, 20.0);
+    map.setValue(0, 0, 0.0); map.setValue(1, 0, 1.0); map.setValue(2, 0, 2.0);
+    map.setValue(0, 1, 10.0); map.setValue(1, 1, 11.0); map.setValue(2, 1, 12.0);
+
+    EXPECT_DOUBLE_EQ(map.sample(0.0, 10.0), 0.0);
+    EXPECT_DOUBLE_EQ(map.sample(2.0, 20.0), 12.0);
+    EXPECT_DOUBLE_EQ(map.sample(0.5, 15.0), 5.5);
+    EXPECT_DOUBLE_EQ(map.sample(1.5, 12.5), 4.0);
+
+    // Clamped to the edges outside the grid
+    EXPECT_DOUBLE_EQ(map.sample(-5.0, 0.0), 0.0);
+    EXPECT_DOUBLE_EQ(map.sample(10.0, 100.0), 12.0);
+
+    map.destroy();
+}
+
+TEST(TimingMapTests, BuildBlendsRowsByPressure) {
+    Function low, high;
+    linearCurve(&low, units::angle(10, units::deg), units::angle(30, units::deg));
+    linearCurve(&high, units::angle(5, units::deg), units::angle(15, units::deg));
+
+    // Given out of order
+    const Function *rows[] = { &high, &low };
+    const double pressures[] = { units::pressure(100, units::kPa), units::pressure(30, units::kPa) };
+
+    TimingMap map;
+    map.initialize(
+        33, 15,
+        0.0, units::rpm(8000),
+        units::pressure(30, units::kPa), units::pressure(100, units::kPa));
+    map.build(rows, pressures, 2);
+
+    const double speed = units::rpm(4000);
+    EXPECT_NEAR(map.sample(speed, units::pressure(30, units::kPa)), low.sampleTriangle(speed), 1E-9);
+    EXPECT_NEAR(map.sample(speed, units::pressure(100, units::kPa)), high.sampleTriangle(speed), 1E-9);
+    EXPECT_NEAR(
+        map.sample(speed, units::pressure(65, units::kPa)),
+        0.5 * (low.sampleTriangle(speed) + high.sampleTriangle(speed)),
+        1E-9);
+
+    map.destroy();
+    low.destroy();
+    high.destroy();
+}
+
+TEST(TimingMapTests, AssignAndMatch) {
+    TimingMap a, b;
+    a.initialize(2, 2, 0.0, 1.0, 0.0, 1.0);
+    a.setValue(1, 1, 3.0);
+
+    EXPECT_FALSE(b.matches(a));
+    b.assign(a);
+    EXPECT_TRUE(b.matches(a));
+    EXPECT_DOUBLE_EQ(b.sample(1.0, 1.0), 3.0);
+
+    a.destroy();
+    b.assign(a);
+    EXPECT_FALSE(b.isBaked());
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "../include/triple_buffer.h"
+
+#include <thread>
+
+TEST(TripleBufferTests, ReaderSeesLatestWrite) {
+    TripleBuffer<int> buffer;
+    buffer.reset(0);
+
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.read(), 0);
+
+    buffer.write(1);
+    buffer.write(2);
+
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.read(), 2);
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.read(), 2);
+}
+
+TEST(TripleBufferTests, ConcurrentWritesAreMonotonic) {
+    struct Value {
+        int a = 0;
+        int b = 0;
+    };
+
+    constexpr int Writes = 200000;
+
+    TripleBuffer<Value> buffer;
+    buffer.reset(Value());
+
+    std::thread writer([&buffer] {
+        for (int i = 1; i <= Writes; ++i) {
+            Value v;
+            v.a = i;
+            v.b = -i;
+            buffer.write(v);
+        }
+    });
+
+    int last = 0;
+    while (last < Writes) {
+        if (!buffer.update()) continue;
+
+        const Value &v = buffer.read();
+        ASSERT_EQ(v.a, -v.b);
+        ASSERT_GT(v.a, last);
+        last = v.a;
+    }
+
+    writer.join();
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "../include/vtec_valvetrain.h"
+
+#include "test_engine.h"
+
+namespace {
+
+// The VTEC twin, driven by setting the crank speed directly
+struct Rig {
+    Engine *engine;
+    VtecValvetrain *vtec;
+
+    Rig(double rpmHysteresis, double engagementDelay) {
+        engine = test_engine::buildEngine(true);
+        vtec = test_engine::configureVtec(engine, rpmHysteresis, engagementDelay);
+    }
+
+    ~Rig() {
+        test_engine::release(engine, nullptr, nullptr);
+    }
+
+    bool update(double rpm, double dt = 0.01) {
+        engine->getCrankshaft(0)->m_body.v_theta = -units::rpm(rpm);
+        vtec->update(dt);
+        return vtec->isEngaged();
+    }
+};
+
+} /* namespace */
+
+TEST(VtecValvetrainTests, SwitchesAtMinRpmWithoutHysteresis) {
+    Rig rig(0.0, 0.0);
+
+    EXPECT_FALSE(rig.update(4990));
+    EXPECT_EQ(rig.vtec->getActiveIntakeCamshaft(), rig.vtec->getIntakeCamshaft());
+
+    EXPECT_TRUE(rig.update(5010));
+    EXPECT_EQ(rig.vtec->getActiveIntakeCamshaft(), rig.vtec->getVtecIntakeCamshaft());
+    EXPECT_EQ(rig.vtec->getActiveExhaustCamshaft(), rig.vtec->getVtecExhaustCamshaft());
+
+    EXPECT_FALSE(rig.update(4990));
+    EXPECT_EQ(rig.vtec->getActiveExhaustCamshaft(), rig.vtec->getExhaustCamshaft());
+}
+
+TEST(VtecValvetrainTests, RpmHysteresisHoldsEngagement) {
+    Rig rig(500.0, 0.0);
+
+    EXPECT_FALSE(rig.update(4800));
+    EXPECT_TRUE(rig.update(5010));
+
+    // Stays on down to minRpm less the hysteresis
+    EXPECT_TRUE(rig.update(4800));
+    EXPECT_TRUE(rig.update(4510));
+    EXPECT_FALSE(rig.update(4490));
+
+    // And coming back up it needs minRpm again
+    EXPECT_FALSE(rig.update(4800));
+    EXPECT_TRUE(rig.update(5010));
+}
+
+TEST(VtecValvetrainTests, EngagementDelayAppliesBothWays) {
+    Rig rig(0.0, 0.1);
+
+    EXPECT_FALSE(rig.update(6000, 0.06));
+    EXPECT_TRUE(rig.update(6000, 0.05));
+
+    // A dip shorter than the delay doesn't disengage, and restarts the
+    // count when the conditions come back
+    EXPECT_TRUE(rig.update(4000, 0.06));
+    EXPECT_TRUE(rig.update(6000, 0.01));
+    EXPECT_TRUE(rig.update(4000, 0.06));
+    EXPECT_FALSE(rig.update(4000, 0.05));
+    EXPECT_EQ(rig.vtec->getActiveIntakeCamshaft(), rig.vtec->getIntakeCamshaft());
+}
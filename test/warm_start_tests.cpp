@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "../include/constants.h"
+#include "../include/intake.h"
+#include "../include/units.h"
+#include "../include/warm_start.h"
+
+namespace {
+
+// Roughly a 2 L four cylinder's
+void initializeIntake(Intake *intake) {
+    Intake::Parameters params;
+    params.volume = units::volume(1.0, units::L);
+    params.CrossSectionArea = units::area(10.0, units::cm2);
+    params.InputFlowK = GasSystem::k_carb(600.0);
+    params.IdleFlowK = GasSystem::k_carb(0.5);
+    params.RunnerFlowRate = GasSystem::k_carb(250.0);
+    intake->initialize(params);
+}
+
+double demand(double rpm) {
+    const double displacement = units::volume(2.0, units::L);
+    return 0.85 * displacement * (units::rpm(rpm) / (4 * constants::pi))
+        / (constants::R * units::celcius(40.0));
+}
+
+} /* namespace */
+
+TEST(WarmStartTests, ManifoldPressureFollowsThrottleAndSpeed) {
+    Intake intake;
+    initializeIntake(&intake);
+
+    const double atmosphere = intake.getAtmospherePressure();
+
+    // Closed to the idle stop
+    const double idle = WarmStart::EstimateManifoldPressure(&intake, demand(800.0));
+    const double fast = WarmStart::EstimateManifoldPressure(&intake, demand(3000.0));
+    EXPECT_GT(idle, 0.0);
+    EXPECT_LT(idle, atmosphere);
+    EXPECT_LT(fast, idle);
+
+    intake.m_throttle = 0.0;
+    const double open = WarmStart::EstimateManifoldPressure(&intake, demand(800.0));
+    EXPECT_GT(open, idle);
+    EXPECT_LE(open, atmosphere);
+
+    intake.destroy();
+}
+
+TEST(WarmStartTests, ChamberFollowsCyclePhase) {
+    const WarmStart::Settings settings;
+    const double pi = constants::pi;
+    const double minVolume = units::volume(50.0, units::cc);
+    const double maxVolume = units::volume(550.0, units::cc);
+    const double midVolume = 0.5 * (minVolume + maxVolume);
+    const double manifold = units::pressure(40.0, units::kPa);
+    const double exhaust = units::pressure(1.0, units::atm);
+
+    auto estimate = [&](double phase, double volume) {
+        return WarmStart::EstimateChamber(
+            phase, volume, minVolume, maxVolume, manifold, exhaust, settings);
+    };
+
+    const WarmStart::ChamberEstimate intake = estimate(2.5 * pi, midVolume);
+    EXPECT_DOUBLE_EQ(intake.pressure, manifold);
+    EXPECT_FALSE(intake.burned);
+
+    // Compression heats the charge and expansion cools the burned gas
+    const WarmStart::ChamberEstimate earlyCompression = estimate(3.2 * pi, midVolume);
+    const WarmStart::ChamberEstimate lateCompression = estimate(3.9 * pi, minVolume);
+    EXPECT_GT(lateCompression.pressure, earlyCompression.pressure);
+    EXPECT_GT(lateCompression.temperature, earlyCompression.temperature);
+    EXPECT_FALSE(lateCompression.burned);
+
+    const WarmStart::ChamberEstimate firing = estimate(0.0, minVolume);
+    const WarmStart::ChamberEstimate power = estimate(0.5 * pi, midVolume);
+    EXPECT_TRUE(firing.burned);
+    EXPECT_DOUBLE_EQ(firing.temperature, settings.combustionTemperature);
+    EXPECT_GT(firing.pressure, lateCompression.pressure);
+    EXPECT_LT(power.temperature, firing.temperature);
+    EXPECT_LT(power.pressure, firing.pressure);
+
+    const WarmStart::ChamberEstimate exhaustStroke = estimate(1.5 * pi, midVolume);
+    EXPECT_TRUE(exhaustStroke.burned);
+    EXPECT_DOUBLE_EQ(exhaustStroke.pressure, exhaust);
+    EXPECT_DOUBLE_EQ(exhaustStroke.temperature, settings.exhaustTemperature);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "../include/wav_file.h"
+#include "../include/wav_writer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+void append32(std::vector<char> *data, uint32_t v) {
+    for (int i = 0; i < 4; ++i) data->push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void append16(std::vector<char> *data, uint16_t v) {
+    data->push_back(static_cast<char>(v & 0xFF));
+    data->push_back(static_cast<char>(v >> 8));
+}
+
+std::vector<char> makeWav(uint16_t format, int channels, int bits, const std::vector<char> &samples) {
+    std::vector<char> data = { 'R', 'I', 'F', 'F' };
+    append32(&data, static_cast<uint32_t>(4 + 8 + 16 + 8 + 3 + 1 + 8 + samples.size()));
+    data.insert(data.end(), { 'W', 'A', 'V', 'E' });
+
+    data.insert(data.end(), { 'f', 'm', 't', ' ' });
+    append32(&data, 16);
+    append16(&data, format);
+    append16(&data, static_cast<uint16_t>(channels));
+    append32(&data, 44100);
+    append32(&data, 44100 * channels * bits / 8);
+    append16(&data, static_cast<uint16_t>(channels * bits / 8));
+    append16(&data, static_cast<uint16_t>(bits));
+
+    // Odd-sized chunks are padded and must be skipped over
+    data.insert(data.end(), { 'L', 'I', 'S', 'T' });
+    append32(&data, 3);
+    data.insert(data.end(), { 'a', 'b', 'c', 0 });
+
+    data.insert(data.end(), { 'd', 'a', 't', 'a' });
+    append32(&data, static_cast<uint32_t>(samples.size()));
+    data.insert(data.end(), samples.begin(), samples.end());
+
+    return data;
+}
+
+} /* namespace */
+
+TEST(WavFileTests, Pcm16Stereo) {
+    std::vector<char> samples;
+    for (int16_t v : { 100, -1, -32768, 7, 32767, 0 }) {
+        append16(&samples, static_cast<uint16_t>(v));
+    }
+
+    const std::vector<char> data = makeWav(1, 2, 16, samples);
+
+    WavFile file;
+    ASSERT_TRUE(file.decode(data.data(), data.size()));
+    EXPECT_EQ(file.getChannelCount(), 2);
+    EXPECT_EQ(file.getSampleRate(), 44100);
+    ASSERT_EQ(file.getSampleCount(), 3u);
+    EXPECT_EQ(file.getSamples()[0], 100);
+    EXPECT_EQ(file.getSamples()[1], -32768);
+    EXPECT_EQ(file.getSamples()[2], 32767);
+}
+
+TEST(WavFileTests, Pcm24AndFloat) {
+    std::vector<char> pcm24 = { 0x00, 0x34, 0x12, 0x00, 0x00, static_cast<char>(0x80) };
+    const std::vector<char> data24 = makeWav(1, 1, 24, pcm24);
+
+    WavFile file;
+    ASSERT_TRUE(file.decode(data24.data(), data24.size()));
+    ASSERT_EQ(file.getSampleCount(), 2u);
+    EXPECT_EQ(file.getSamples()[0], 0x1234);
+    EXPECT_EQ(file.getSamples()[1], -32768);
+
+    std::vector<char> floats;
+    for (float v : { 0.5f, -2.0f }) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(float));
+        append32(&floats, bits);
+    }
+
+    const std::vector<char> dataFloat = makeWav(3, 1, 32, floats);
+    ASSERT_TRUE(file.decode(dataFloat.data(), dataFloat.size()));
+    ASSERT_EQ(file.getSampleCount(), 2u);
+    EXPECT_EQ(file.getSamples()[0], 16384);
+    EXPECT_EQ(file.getSamples()[1], -32767);
+}
+
+TEST(WavFileTests, RejectsMalformed) {
+    std::vector<char> samples(8, 0);
+    std::vector<char> data = makeWav(2, 1, 16, samples);
+
+    WavFile file;
+    EXPECT_FALSE(file.decode(data.data(), data.size()));
+    EXPECT_EQ(file.getSampleCount(), 0u);
+
+    data = makeWav(1, 1, 16, samples);
+    data[8] = 'X';
+    EXPECT_FALSE(file.decode(data.data(), data.size()));
+    EXPECT_FALSE(file.decode(data.data(), 10));
+    EXPECT_FALSE(file.load("does-not-exist.wav"));
+}
+
+TEST(WavFileTests, WriterRoundTrip) {
+    const std::string path = "wav_writer_round_trip.wav";
+    const int16_t block0[] = { 0, 1000, -1000 };
+    const int16_t block1[] = { 32767, -32768 };
+
+    WavWriter writer;
+    ASSERT_TRUE(writer.open(path, 22050));
+    EXPECT_TRUE(writer.write(block0, 3));
+    EXPECT_TRUE(writer.write(block1, 2));
+    EXPECT_EQ(writer.getSampleCount(), 5);
+    ASSERT_TRUE(writer.close());
+
+    WavFile file;
+    ASSERT_TRUE(file.load(path));
+    EXPECT_EQ(file.getSampleRate(), 22050);
+    EXPECT_EQ(file.getChannelCount(), 1);
+    ASSERT_EQ(file.getSampleCount(), 5u);
+    EXPECT_EQ(file.getSamples()[1], 1000);
+    EXPECT_EQ(file.getSamples()[4], -32768);
+
+    file.destroy();
+    std::remove(path.c_str());
+}
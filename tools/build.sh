@@ -97,7 +97,7 @@ done
 if [[ ${RUN_METAL_SHADERS} -eq 1 ]]; then
     local_start_ts="$(date +%s)"
     log_build "shader translation start"
-    ./tools/translate_shaders_to_msl.sh --build-metallib
+    ./tools/translate_shaders_to_msl.sh --library build/generated/msl/engine_sim_shaders.metallib
     local_end_ts="$(date +%s)"
     log_build "shader translation end elapsed_s=$((local_end_ts - local_start_ts))"
 fi
@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+
+import argparse
+import json
+import math
+import os
+import pathlib
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+import wave
+
+# Every bundled script is run through engine-sim-headless with the same
+# controls and seed: the dyno holds the engine at a fixed speed while the
+# throttle steps through part and full load. Offline runs are deterministic,
+# so the audio and torque traces must match their baselines closely, while
+# speed and memory are compared with looser, machine dependent margins.
+DEFAULT_GROUPS = ("atg-video-1", "atg-video-2")
+RUN_ARGUMENTS = (
+    "--duration=6",
+    "--starter-time=1",
+    "--dyno-rpm=3000",
+    "--throttle=0:0.1,2:0.1,2.5:1.0,4:1.0,4.5:0.3",
+    "--seed=1",
+    "--telemetry-interval=0.05",
+)
+
+# Analysis windows of the audio fingerprint, and the start of the compared
+# part of both traces (after the starter and the first firings)
+FINGERPRINT_WINDOW = 2205
+COMPARE_FROM = 1.5
+
+INSTANCE_RE = re.compile(r"^instance=0 engine=\S* .*steps_per_s=(?P<steps>[\d.]+)")
+AUDIO_RE = re.compile(r"^instance=0 audio_blocks=(?P<blocks>\d+) audio_block_us=(?P<us>[\d.]+)")
+TELEMETRY_RE = re.compile(r"^telemetry instance=0 t=(?P<t>[\d.]+) .*torque_nm=(?P<torque>-?[\d.]+)")
+PEAK_PRESSURE_RE = re.compile(r"^instance=0 peak_cylinder_pressure_psi=(?P<psi>[\d.]+)")
+SPECTRUM_RE = re.compile(
+    r"^telemetry_audio instance=0 t=(?P<t>[\d.]+) .*centroid_hz=(?P<centroid>[\d.]+)"
+    r" .*firing_h1_db=(?P<h1>-?[\d.]+) firing_h2_db=(?P<h2>-?[\d.]+)"
+    r" firing_h3_db=(?P<h3>-?[\d.]+) firing_h4_db=(?P<h4>-?[\d.]+)"
+)
+
+
+def find_scripts(asset_path: pathlib.Path, groups, name_filter):
+    scripts = []
+    for group in groups:
+        for script in sorted((asset_path / "assets" / "engines" / group).glob("*.mr")):
+            text = script.read_text(encoding="utf-8", errors="replace")
+            if not re.search(r"^(public\s+)?node\s+main\b", text, re.MULTILINE):
+                continue
+            if name_filter and name_filter not in f"{group}/{script.stem}":
+                continue
+            scripts.append((group, script))
+    return scripts
+
+
+def audio_fingerprint(path: pathlib.Path):
+    # Level (dBFS) and zero crossing rate per window; enough to catch a
+    # changed timbre or a level drift without storing the audio itself
+    with wave.open(str(path), "rb") as wav:
+        rate = wav.getframerate()
+        frames = wav.readframes(wav.getnframes())
+
+    samples = memoryview(frames).cast("h")
+    fingerprint = []
+    for start in range(0, len(samples) - FINGERPRINT_WINDOW + 1, FINGERPRINT_WINDOW):
+        window = samples[start:start + FINGERPRINT_WINDOW]
+        energy = sum(x * x for x in window) / FINGERPRINT_WINDOW
+        crossings = sum(1 for a, b in zip(window, window[1:]) if (a < 0) != (b < 0))
+        fingerprint.append(
+            {
+                "t": round(start / rate, 4),
+                "db": round(10 * math.log10(max(energy, 1.0) / 32768.0 ** 2), 2),
+                "zcr": round(crossings / FINGERPRINT_WINDOW, 5),
+            }
+        )
+    return fingerprint
+
+
+def run_script(binary: pathlib.Path, asset_path: pathlib.Path, script: pathlib.Path, extra_arguments=()):
+    with tempfile.TemporaryDirectory() as work_dir:
+        work = pathlib.Path(work_dir)
+
+        # Engine scripts only declare their nodes; the wrapper runs one
+        wrapper = work / "main.mr"
+        wrapper.write_text(
+            'import "engine_sim.mr"\n'
+            f'import "{script.resolve().as_posix()}"\n'
+            "main()\n",
+            encoding="utf-8",
+        )
+
+        audio_path = work / "audio.wav"
+        command = [
+            str(binary),
+            f"--asset-path={asset_path}",
+            f"--script={wrapper}",
+            f"--audio-output={audio_path}",
+            *RUN_ARGUMENTS,
+            *extra_arguments,
+        ]
+
+        with open(work / "stderr.txt", "w+", encoding="utf-8") as errors:
+            process = subprocess.Popen(
+                command, cwd=work, stdout=subprocess.PIPE, stderr=errors, text=True
+            )
+            stdout = process.stdout.read()
+            returncode, peak_rss_mb = wait_for(process)
+
+            if returncode != 0:
+                errors.seek(0)
+                print(errors.read(), file=sys.stderr)
+                return None
+
+        result = {"steps_per_s": None, "audio_block_us": None, "peak_pressure_psi": None, "torque": [], "spectrum": []}
+        for line in stdout.splitlines():
+            match = INSTANCE_RE.match(line)
+            if match:
+                result["steps_per_s"] = float(match.group("steps"))
+            match = AUDIO_RE.match(line)
+            if match:
+                result["audio_block_us"] = float(match.group("us"))
+            match = TELEMETRY_RE.match(line)
+            if match:
+                result["torque"].append(
+                    {"t": float(match.group("t")), "nm": float(match.group("torque"))}
+                )
+            match = PEAK_PRESSURE_RE.match(line)
+            if match:
+                result["peak_pressure_psi"] = float(match.group("psi"))
+            match = SPECTRUM_RE.match(line)
+            if match:
+                result["spectrum"].append(
+                    {
+                        "t": float(match.group("t")),
+                        "centroid_hz": float(match.group("centroid")),
+                        "harmonics_db": [float(match.group(h)) for h in ("h1", "h2", "h3", "h4")],
+                    }
+                )
+
+        result["peak_rss_mb"] = peak_rss_mb
+        result["audio"] = audio_fingerprint(audio_path) if audio_path.exists() else []
+        return result
+
+
+def wait_for(process):
+    # Returns the exit code and the peak resident set of that child alone
+    # (in MB); ru_maxrss is in bytes on macOS and in kilobytes elsewhere
+    if not hasattr(os, "wait4"):
+        return process.wait(), None
+
+    _, status, usage = os.wait4(process.pid, 0)
+    process.returncode = os.waitstatus_to_exitcode(status)
+    scale = 1024.0 * 1024.0 if sys.platform == "darwin" else 1024.0
+    return process.returncode, round(usage.ru_maxrss / scale, 1)
+
+
+def compare(result, baseline, tolerances):
+    failures = []
+
+    def slower(name, value, reference, higher_is_better):
+        if value is None or reference is None or reference <= 0:
+            return
+        change = (value - reference) / reference
+        if higher_is_better:
+            change = -change
+        if change > tolerances[name]:
+            failures.append(f"{name} {value:.1f} vs {reference:.1f} ({100 * change:+.1f}% worse)")
+
+    slower("steps_per_s", result["steps_per_s"], baseline.get("steps_per_s"), True)
+    slower("audio_block_us", result["audio_block_us"], baseline.get("audio_block_us"), False)
+    slower("peak_rss_mb", result["peak_rss_mb"], baseline.get("peak_rss_mb"), False)
+
+    reference_audio = [w for w in baseline.get("audio", []) if w["t"] >= COMPARE_FROM]
+    audio = [w for w in result["audio"] if w["t"] >= COMPARE_FROM]
+    if len(audio) != len(reference_audio):
+        failures.append(f"audio length {len(audio)} windows vs {len(reference_audio)}")
+    else:
+        for w, r in zip(audio, reference_audio):
+            if abs(w["db"] - r["db"]) > tolerances["audio_db"]:
+                failures.append(f"audio level at {w['t']:.2f}s {w['db']:.2f} vs {r['db']:.2f} dBFS")
+                break
+            if abs(w["zcr"] - r["zcr"]) > tolerances["audio_zcr"] * max(r["zcr"], 0.01):
+                failures.append(f"audio zero crossings at {w['t']:.2f}s {w['zcr']:.4f} vs {r['zcr']:.4f}")
+                break
+
+    reference_torque = [p for p in baseline.get("torque", []) if p["t"] >= COMPARE_FROM]
+    torque = [p for p in result["torque"] if p["t"] >= COMPARE_FROM]
+    if len(torque) != len(reference_torque):
+        failures.append(f"torque trace length {len(torque)} vs {len(reference_torque)}")
+    else:
+        for p, r in zip(torque, reference_torque):
+            limit = max(tolerances["torque_nm"], tolerances["torque"] * abs(r["nm"]))
+            if abs(p["nm"] - r["nm"]) > limit:
+                failures.append(f"torque at {p['t']:.2f}s {p['nm']:.1f} vs {r['nm']:.1f} Nm")
+                break
+
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Speed and output regression check of the bundled engine scripts."
+    )
+    parser.add_argument("--binary", required=True, help="Path to engine-sim-headless")
+    parser.add_argument("--asset-path", default=".", help="Repository root (default: .)")
+    parser.add_argument(
+        "--baselines",
+        default="tools/perf_baselines",
+        help="Baseline directory, one <group>/<script>.json per script",
+    )
+    parser.add_argument("--groups", default=",".join(DEFAULT_GROUPS))
+    parser.add_argument("--filter", default="", help="Only scripts whose group/name contains this")
+    parser.add_argument(
+        "--update",
+        action="store_true",
+        help="Record the results as the new baselines instead of comparing",
+    )
+    parser.add_argument("--speed-tolerance", type=float, default=0.10, help="Relative (0.10)")
+    parser.add_argument("--memory-tolerance", type=float, default=0.20, help="Relative (0.20)")
+    parser.add_argument("--audio-db-tolerance", type=float, default=1.0, help="dB per window (1.0)")
+    parser.add_argument("--audio-zcr-tolerance", type=float, default=0.15, help="Relative (0.15)")
+    parser.add_argument("--torque-tolerance", type=float, default=0.03, help="Relative (0.03)")
+    args = parser.parse_args()
+
+    tolerances = {
+        "steps_per_s": args.speed_tolerance,
+        "audio_block_us": args.speed_tolerance,
+        "peak_rss_mb": args.memory_tolerance,
+        "audio_db": args.audio_db_tolerance,
+        "audio_zcr": args.audio_zcr_tolerance,
+        "torque": args.torque_tolerance,
+        "torque_nm": 1.0,
+    }
+
+    binary = pathlib.Path(args.binary)
+    asset_path = pathlib.Path(args.asset_path).resolve()
+    baselines = pathlib.Path(args.baselines)
+    if not binary.exists():
+        print(f"error: binary not found: {binary}", file=sys.stderr)
+        return 2
+
+    scripts = find_scripts(asset_path, args.groups.split(","), args.filter)
+    if not scripts:
+        print(f"error: no engine scripts found under {asset_path / 'assets' / 'engines'}", file=sys.stderr)
+        return 2
+
+    # Without baselines there's nothing to compare against, which must not
+    # pass as a clean run
+    if not args.update and not any(baselines.glob("*/*.json")):
+        print(
+            f"error: no baselines in {baselines}; record them on the reference machine with --update"
+            " and commit them",
+            file=sys.stderr,
+        )
+        return 2
+
+    regressions = 0
+    for group, script in scripts:
+        name = f"{group}/{script.stem}"
+        result = run_script(binary, asset_path, script)
+        if result is None:
+            print(f"{name}: FAILED to run")
+            regressions += 1
+            continue
+
+        summary = (
+            f"steps_per_s={result['steps_per_s']} audio_block_us={result['audio_block_us']}"
+            f" peak_rss_mb={result['peak_rss_mb']}"
+        )
+
+        baseline_path = baselines / group / f"{script.stem}.json"
+        if args.update:
+            baseline_path.parent.mkdir(parents=True, exist_ok=True)
+            result["host"] = {"machine": platform.machine(), "system": platform.system(), "node": platform.node()}
+            baseline_path.write_text(json.dumps(result, indent=1) + "\n", encoding="utf-8")
+            print(f"{name}: recorded {summary}")
+            continue
+
+        if not baseline_path.exists():
+            print(f"{name}: NO BASELINE {summary} (record one with --update)")
+            regressions += 1
+            continue
+
+        failures = compare(result, json.loads(baseline_path.read_text(encoding="utf-8")), tolerances)
+        if failures:
+            regressions += 1
+            print(f"{name}: REGRESSED {summary}")
+            for failure in failures:
+                print(f"  {failure}")
+        else:
+            print(f"{name}: ok {summary}")
+
+    print(f"scripts={len(scripts)} regressions={regressions}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
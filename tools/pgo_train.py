@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+
+import argparse
+import math
+import os
+import pathlib
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# Training workload for profile-guided builds. A spread of cylinder counts
+# and layouts is run through an instrumented engine-sim-headless at idle,
+# cruise and wide open throttle with audio, and through a full-load dyno
+# sweep, so the profiles see both branches of the choked flow selection,
+# every ignition path and the whole synthesizer filter chain.
+DEFAULT_ENGINES = (
+    "atg-video-1/01_honda_trx520",
+    "atg-video-1/06_subaru_ej25",
+    "atg-video-1/07_audi_i5",
+    "atg-video-2/03_2jz",
+    "atg-video-2/07_gm_ls",
+    "atg-video-2/10_lfa_v10",
+    "atg-video-2/11_merlin_v12",
+)
+
+COMMON_ARGUMENTS = ("--seed=1", "--starter-time=1")
+WORKLOADS = {
+    "idle": ("--duration=4", "--throttle=0:0"),
+    "cruise": ("--duration=4", "--dyno-rpm=2500", "--throttle=0:0.25"),
+    "wot": ("--duration=4", "--dyno-rpm=5500", "--throttle=0:1.0"),
+    "sweep": ("--dyno-sweep=1500:6000:1500", "--sweep-throttle=1", "--sweep-threads=1"),
+}
+
+# Speed is compared as the real-time factor; a sweep's is summed over its
+# points
+INSTANCE_RE = re.compile(r"^instance=0 engine=\S* .*rt_factor=(?P<rt>[\d.]+)")
+DYNO_RE = re.compile(r"^dyno rpm=.* simulated_s=(?P<simulated>[\d.]+) wall_s=(?P<wall>[\d.]+)")
+AUDIO_RE = re.compile(r"^instance=0 audio_blocks=(?P<blocks>\d+) audio_block_us=(?P<us>[\d.]+)")
+
+
+def find_engines(asset_path: pathlib.Path, names):
+    engines = []
+    for name in names:
+        script = asset_path / "assets" / "engines" / f"{name}.mr"
+        if not script.exists():
+            print(f"warning: engine script not found: {script}", file=sys.stderr)
+            continue
+        engines.append((name, script))
+    return engines
+
+
+def run(binary: pathlib.Path, asset_path: pathlib.Path, script: pathlib.Path, workload, environment=None):
+    with tempfile.TemporaryDirectory() as work_dir:
+        work = pathlib.Path(work_dir)
+
+        # Engine scripts only declare their nodes; the wrapper runs one
+        wrapper = work / "main.mr"
+        wrapper.write_text(
+            'import "engine_sim.mr"\n'
+            f'import "{script.resolve().as_posix()}"\n'
+            "main()\n",
+            encoding="utf-8",
+        )
+
+        command = [
+            str(binary),
+            f"--asset-path={asset_path}",
+            f"--script={wrapper}",
+            *COMMON_ARGUMENTS,
+            *WORKLOADS[workload],
+        ]
+
+        process = subprocess.run(
+            command, cwd=work, env=environment, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True
+        )
+        if process.returncode != 0:
+            print(process.stderr, file=sys.stderr)
+            return None
+
+        result = {"rt_factor": None, "audio_block_us": None}
+        simulated = wall = 0.0
+        for line in process.stdout.splitlines():
+            match = INSTANCE_RE.match(line)
+            if match:
+                result["rt_factor"] = float(match.group("rt"))
+            match = DYNO_RE.match(line)
+            if match:
+                simulated += float(match.group("simulated"))
+                wall += float(match.group("wall"))
+            match = AUDIO_RE.match(line)
+            if match:
+                result["audio_block_us"] = float(match.group("us"))
+
+        if result["rt_factor"] is None and wall > 0:
+            result["rt_factor"] = simulated / wall
+        return result
+
+
+def train(args, engines):
+    profile_dir = pathlib.Path(args.profile_dir).resolve()
+    profile_dir.mkdir(parents=True, exist_ok=True)
+
+    # Stale counts from an older build would be merged into the new ones
+    for stale in list(profile_dir.rglob("*.gcda")) + list(profile_dir.glob("*.profraw")):
+        stale.unlink()
+
+    environment = dict(os.environ)
+    environment["LLVM_PROFILE_FILE"] = str(profile_dir / "engine-sim-%p.profraw")
+
+    failures = 0
+    for name, script in engines:
+        for workload in WORKLOADS:
+            if run(pathlib.Path(args.binary), pathlib.Path(args.asset_path).resolve(), script, workload, environment) is None:
+                print(f"{name} {workload}: FAILED to run")
+                failures += 1
+            else:
+                print(f"{name} {workload}: ok")
+
+    raw = sorted(profile_dir.glob("*.profraw"))
+    if args.llvm_profdata:
+        if not raw:
+            print(f"error: no .profraw files were written to {profile_dir}", file=sys.stderr)
+            return 2
+
+        merged = profile_dir / "engine-sim.profdata"
+        subprocess.run(
+            [args.llvm_profdata, "merge", f"--output={merged}", *map(str, raw)], check=True
+        )
+        print(f"profile={merged} raw_profiles={len(raw)}")
+    else:
+        print(f"profile_dir={profile_dir} gcda_files={len(list(profile_dir.rglob('*.gcda')))}")
+
+    return 1 if failures else 0
+
+
+def best_of(binary, asset_path, script, workload, repeats):
+    # The fastest of a few runs, to keep scheduler noise out of the figures
+    best = None
+    for _ in range(repeats):
+        result = run(binary, asset_path, script, workload)
+        if result is None or result["rt_factor"] is None:
+            return None
+        if best is None or result["rt_factor"] > best["rt_factor"]:
+            best = result
+    return best
+
+
+def compare(args, engines):
+    binary = pathlib.Path(args.binary)
+    baseline = pathlib.Path(args.baseline)
+    asset_path = pathlib.Path(args.asset_path).resolve()
+
+    speedups = []
+    for name, script in engines:
+        for workload in WORKLOADS:
+            optimized = best_of(binary, asset_path, script, workload, args.repeats)
+            reference = best_of(baseline, asset_path, script, workload, args.repeats)
+            if optimized is None or reference is None:
+                print(f"{name} {workload}: FAILED to run")
+                return 1
+
+            speedup = optimized["rt_factor"] / reference["rt_factor"]
+            speedups.append(speedup)
+            summary = (
+                f"rt_factor={optimized['rt_factor']:.2f} baseline={reference['rt_factor']:.2f}"
+                f" speedup={speedup:.3f}"
+            )
+            if optimized["audio_block_us"] and reference["audio_block_us"]:
+                summary += (
+                    f" audio_block_us={optimized['audio_block_us']:.1f}"
+                    f" baseline={reference['audio_block_us']:.1f}"
+                )
+            print(f"{name} {workload}: {summary}")
+
+    geomean = math.exp(sum(math.log(s) for s in speedups) / len(speedups))
+    print(f"runs={len(speedups)} geomean_speedup={geomean:.3f}")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="PGO training workload, and the comparison of a PGO build against a plain one."
+    )
+    parser.add_argument("--binary", required=True, help="Path to engine-sim-headless")
+    parser.add_argument("--asset-path", default=".", help="Repository root (default: .)")
+    parser.add_argument("--engines", default=",".join(DEFAULT_ENGINES), help="group/script names")
+    parser.add_argument("--profile-dir", default="pgo", help="Where the instrumented build writes (pgo)")
+    parser.add_argument("--llvm-profdata", default="", help="Merge Clang's .profraw files with this")
+    parser.add_argument(
+        "--baseline",
+        default="",
+        help="Instead of training, time --binary against this engine-sim-headless",
+    )
+    parser.add_argument("--repeats", type=int, default=3, help="Runs per timing, best kept (3)")
+    args = parser.parse_args()
+
+    if args.llvm_profdata and not shutil.which(args.llvm_profdata):
+        print(f"error: llvm-profdata not found: {args.llvm_profdata}", file=sys.stderr)
+        return 2
+
+    for binary in filter(None, (args.binary, args.baseline)):
+        if not pathlib.Path(binary).exists():
+            print(f"error: binary not found: {binary}", file=sys.stderr)
+            return 2
+
+    engines = find_engines(pathlib.Path(args.asset_path).resolve(), args.engines.split(","))
+    if not engines:
+        print("error: none of the engine scripts were found", file=sys.stderr)
+        return 2
+
+    return compare(args, engines) if args.baseline else train(args, engines)
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
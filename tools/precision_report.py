@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+
+import argparse
+import pathlib
+import sys
+
+from perf_regression import COMPARE_FROM, DEFAULT_GROUPS, find_scripts, run_script
+
+# Runs every bundled script through a double and a float build of
+# engine-sim-headless (ENGINE_SIM_FLUID_SINGLE_PRECISION=ON) with the
+# regression harness's controls and reports how far the float build drifts:
+# last-cycle peak cylinder pressure, the dyno torque trace, and the audio
+# level, spectral centroid and firing harmonics over time.
+#
+# Only reports; the limits are the caller's call. Exits non-zero when a run
+# fails or when --max-torque-error is given and exceeded.
+
+
+def worst(pairs):
+    # Largest absolute and mean absolute difference over matched samples
+    if not pairs:
+        return None, None
+    differences = [abs(a - b) for a, b in pairs]
+    return max(differences), sum(differences) / len(differences)
+
+
+def relative(value, reference):
+    if value is None or reference is None or reference == 0:
+        return None
+    return (value - reference) / abs(reference)
+
+
+def compare_runs(double_run, float_run):
+    report = {}
+    report["peak_pressure"] = relative(float_run["peak_pressure_psi"], double_run["peak_pressure_psi"])
+
+    torque = [
+        (f["nm"], d["nm"])
+        for f, d in zip(float_run["torque"], double_run["torque"])
+        if d["t"] >= COMPARE_FROM
+    ]
+    report["torque_max_nm"], report["torque_mean_nm"] = worst(torque)
+    reference_torque = [abs(d) for _, d in torque]
+    report["torque_scale_nm"] = max(reference_torque) if reference_torque else None
+
+    audio = [
+        (f["db"], d["db"])
+        for f, d in zip(float_run["audio"], double_run["audio"])
+        if d["t"] >= COMPARE_FROM
+    ]
+    report["audio_db_max"], report["audio_db_mean"] = worst(audio)
+
+    spectrum_f = [s for s in float_run["spectrum"] if s["t"] >= COMPARE_FROM]
+    spectrum_d = [s for s in double_run["spectrum"] if s["t"] >= COMPARE_FROM]
+    centroid = [(f["centroid_hz"], d["centroid_hz"]) for f, d in zip(spectrum_f, spectrum_d)]
+    harmonics = [
+        (fh, dh)
+        for f, d in zip(spectrum_f, spectrum_d)
+        for fh, dh in zip(f["harmonics_db"], d["harmonics_db"])
+    ]
+    report["centroid_max_hz"], report["centroid_mean_hz"] = worst(centroid)
+    report["harmonics_max_db"], report["harmonics_mean_db"] = worst(harmonics)
+    report["speedup"] = (
+        float_run["steps_per_s"] / double_run["steps_per_s"]
+        if float_run["steps_per_s"] and double_run["steps_per_s"]
+        else None
+    )
+    return report
+
+
+def format_value(value, fmt):
+    return "n/a" if value is None else format(value, fmt)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Float against double fluid precision report of the bundled engine scripts."
+    )
+    parser.add_argument("--double-binary", required=True, help="engine-sim-headless, default build")
+    parser.add_argument("--float-binary", required=True, help="engine-sim-headless, single precision build")
+    parser.add_argument("--asset-path", default=".", help="Repository root (default: .)")
+    parser.add_argument("--groups", default=",".join(DEFAULT_GROUPS))
+    parser.add_argument("--filter", default="", help="Only scripts whose group/name contains this")
+    parser.add_argument(
+        "--max-torque-error",
+        type=float,
+        default=None,
+        help="Fail when the mean torque difference exceeds this fraction of the peak torque",
+    )
+    args = parser.parse_args()
+
+    binaries = {"double": pathlib.Path(args.double_binary), "float": pathlib.Path(args.float_binary)}
+    for name, binary in binaries.items():
+        if not binary.exists():
+            print(f"error: {name} binary not found: {binary}", file=sys.stderr)
+            return 2
+
+    asset_path = pathlib.Path(args.asset_path).resolve()
+    scripts = find_scripts(asset_path, args.groups.split(","), args.filter)
+    if not scripts:
+        print(f"error: no engine scripts found under {asset_path / 'assets' / 'engines'}", file=sys.stderr)
+        return 2
+
+    failures = 0
+    for group, script in scripts:
+        name = f"{group}/{script.stem}"
+        runs = {
+            precision: run_script(binary, asset_path, script, ("--audio-metrics",))
+            for precision, binary in binaries.items()
+        }
+        if runs["double"] is None or runs["float"] is None:
+            print(f"{name}: FAILED to run")
+            failures += 1
+            continue
+
+        report = compare_runs(runs["double"], runs["float"])
+        peak = report["peak_pressure"]
+        print(
+            f"{name}:"
+            f" peak_pressure={format_value(None if peak is None else 100 * peak, '+.2f')}%"
+            f" torque_max_nm={format_value(report['torque_max_nm'], '.2f')}"
+            f" torque_mean_nm={format_value(report['torque_mean_nm'], '.2f')}"
+            f" audio_db_max={format_value(report['audio_db_max'], '.2f')}"
+            f" centroid_max_hz={format_value(report['centroid_max_hz'], '.1f')}"
+            f" harmonics_max_db={format_value(report['harmonics_max_db'], '.2f')}"
+            f" speedup={format_value(report['speedup'], '.2f')}"
+        )
+
+        if (
+            args.max_torque_error is not None
+            and report["torque_mean_nm"] is not None
+            and report["torque_scale_nm"]
+            and report["torque_mean_nm"] > args.max_torque_error * report["torque_scale_nm"]
+        ):
+            print(f"  mean torque difference above {100 * args.max_torque_error:.1f}% of peak torque")
+            failures += 1
+
+    print(f"scripts={len(scripts)} failures={failures}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -2,14 +2,27 @@
 
 import argparse
 import collections
+import datetime
 import pathlib
+import mmap
 import re
+import struct
 import sys
 
 LINE_RE = re.compile(
     r"^\[(?P<ts>[^\]]+)\]\s+\[mono_ms=(?P<mono>\d+)\]\s+\[frame=(?P<frame>\d+)\]\s+\[tid=(?P<tid>\d+)\]\s+(?P<msg>.*)$"
 )
 
+ANOMALY_TOKENS = ("anomaly_detector", "stall_warning", "memory_growth_warning")
+
+# Layout of trace.events.bin written by the binary sink
+# (--debug-trace-sinks=binary): a 24 byte header then 40 byte records of
+# mono_ms, frame, tid, message_offset (8 bytes each), message_length (4),
+# component and token string ids (2 each), all little-endian
+BINARY_MAGIC = 0x45545345
+BINARY_HEADER = struct.Struct("<IIIIq")
+BINARY_RECORD_WORDS = 5
+
 
 def parse_log_file(path: pathlib.Path):
     events = []
@@ -40,7 +53,7 @@ def summarize(events):
         by_file[event["file"]] += 1
         by_frame[event["frame"]] += 1
         msg = event["msg"]
-        if "anomaly_detector" in msg or "stall_warning" in msg or "memory_growth_warning" in msg:
+        if any(token in msg for token in ANOMALY_TOKENS):
             anomalies.append(event)
 
     print(f"total_events={len(events)}")
@@ -62,6 +75,77 @@ def summarize(events):
             )
 
 
+def load_binary_session(trace_dir: pathlib.Path):
+    events_path = trace_dir / "trace.events.bin"
+    with events_path.open("rb") as fh:
+        header = fh.read(BINARY_HEADER.size)
+        if len(header) < BINARY_HEADER.size:
+            print(f"error: truncated binary trace session: {events_path}", file=sys.stderr)
+            return None
+
+        magic, _, record_size, _, start_ms = BINARY_HEADER.unpack(header)
+        if magic != BINARY_MAGIC or record_size != 8 * BINARY_RECORD_WORDS:
+            print(f"error: not a binary trace session: {events_path}", file=sys.stderr)
+            return None
+
+        # A session that is still being written may end in a partial record
+        count = (events_path.stat().st_size - BINARY_HEADER.size) // record_size
+        records = memoryview(b"").cast("Q")
+        if count > 0:
+            events = mmap.mmap(fh.fileno(), 0, access=mmap.ACCESS_READ)
+            records = memoryview(events)[BINARY_HEADER.size:BINARY_HEADER.size + count * record_size].cast("Q")
+
+    messages_path = trace_dir / "trace.messages.bin"
+    messages = b""
+    if messages_path.exists() and messages_path.stat().st_size > 0:
+        with messages_path.open("rb") as fh:
+            messages = mmap.mmap(fh.fileno(), 0, access=mmap.ACCESS_READ)
+
+    strings = (trace_dir / "trace.strings.txt").read_text(encoding="utf-8").splitlines()
+    return start_ms, records, messages, strings
+
+
+def summarize_binary(start_ms, records, messages, strings):
+    # Columns are strided views of the mapped records; the last word packs
+    # message_length, component and token
+    mono = records[0::BINARY_RECORD_WORDS]
+    frames = records[1::BINARY_RECORD_WORDS]
+    packed = records[4::BINARY_RECORD_WORDS]
+
+    def name(string_id):
+        return strings[string_id] if string_id < len(strings) else f"string_{string_id}"
+
+    by_component = collections.Counter((word >> 32) & 0xFFFF for word in packed)
+    by_frame = collections.Counter(frames)
+
+    print(f"total_events={len(mono)}")
+    print("events_by_component_log:")
+    for component, count in by_component.most_common():
+        print(f"  {name(component)}.log: {count}")
+
+    print("top_frames_by_event_count:")
+    for frame, count in by_frame.most_common(10):
+        print(f"  frame={frame} events={count}")
+
+    print("anomaly_events:")
+    anomaly_ids = {i for i, value in enumerate(strings) if value in ANOMALY_TOKENS}
+    anomalies = [i for i, word in enumerate(packed) if (word >> 48) in anomaly_ids]
+    if not anomalies:
+        print("  (none)")
+        return
+
+    anomalies.sort(key=lambda i: mono[i])
+    for i in anomalies[-50:]:
+        offset = records[i * BINARY_RECORD_WORDS + 3]
+        length = packed[i] & 0xFFFFFFFF
+        msg = bytes(messages[offset:offset + length]).decode("utf-8", errors="replace")
+        ts = datetime.datetime.fromtimestamp((start_ms + mono[i]) / 1000.0)
+        print(
+            f"  ts={ts.strftime('%Y-%m-%d %H:%M:%S.%f')[:-3]} frame={frames[i]}"
+            f" file={name((packed[i] >> 32) & 0xFFFF)}.log msg={msg}"
+        )
+
+
 def main():
     parser = argparse.ArgumentParser(
         description="Offline replay parser for debug trace logs."
@@ -70,6 +154,11 @@ def main():
         "trace_dir",
         help="Trace session directory (for example logs/debug/<session-id>)",
     )
+    parser.add_argument(
+        "--text",
+        action="store_true",
+        help="Parse the .log files even if the session has a binary trace",
+    )
     args = parser.parse_args()
 
     trace_dir = pathlib.Path(args.trace_dir)
@@ -77,6 +166,14 @@ def main():
         print(f"error: trace_dir not found: {trace_dir}", file=sys.stderr)
         return 2
 
+    if not args.text and (trace_dir / "trace.events.bin").exists():
+        session = load_binary_session(trace_dir)
+        if session is None:
+            return 2
+
+        summarize_binary(*session)
+        return 0
+
     log_files = sorted(trace_dir.glob("*.log"))
     if not log_files:
         print(f"error: no .log files found in {trace_dir}", file=sys.stderr)
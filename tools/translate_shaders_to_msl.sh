@@ -7,6 +7,7 @@ SHADER_ROOT="${ROOT_DIR}/dependencies/submodules/delta-studio/engines/basic/shad
 OUT_DIR="${ROOT_DIR}/build/generated/msl"
 KEEP_SPIRV=0
 BUILD_METALLIB=0
+LIBRARY_OUT=""
 TRANSLATION_SUCCESS=0
 TRANSLATION_FAILURE=0
 METALLIB_SUCCESS=0
@@ -34,6 +35,8 @@ Options:
   --out-dir <dir>       Output directory (default: ${OUT_DIR})
   --keep-spirv          Keep intermediate SPIR-V binaries
   --build-metallib      Compile generated .metal into .metallib (requires xcrun)
+  --library <file>      Also link every HLSL entry point into one .metallib
+                        that the app bundle ships (implies --build-metallib)
   --help                Show this help
 EOF
 }
@@ -52,6 +55,11 @@ while [[ $# -gt 0 ]]; do
         BUILD_METALLIB=1
         shift
         ;;
+    --library)
+        LIBRARY_OUT="$2"
+        BUILD_METALLIB=1
+        shift 2
+        ;;
     --help)
         usage
         exit 0
@@ -189,6 +197,24 @@ if [[ ${BUILD_METALLIB} -eq 1 ]]; then
     log_build "metallib phase end success=${METALLIB_SUCCESS} failure=${METALLIB_FAILURE}"
 fi
 
+# The HLSL entry points keep their names through spirv-cross, so they can
+# share one library; the GLSL ones are all main0
+if [[ -n "${LIBRARY_OUT}" ]]; then
+    log_build "metallib link begin output=${LIBRARY_OUT}"
+    mkdir -p "$(dirname "${LIBRARY_OUT}")"
+    air_files=()
+    while IFS= read -r -d '' air_file; do
+        air_files+=("${air_file}")
+    done < <(find "${HLSL_OUT_DIR}/air" -maxdepth 1 -name "*.air" -print0 | sort -z)
+
+    if [[ ${#air_files[@]} -gt 0 ]] && xcrun metallib "${air_files[@]}" -o "${LIBRARY_OUT}"; then
+        log_build "metallib link success inputs=${#air_files[@]} output=${LIBRARY_OUT}"
+    else
+        METALLIB_FAILURE=$((METALLIB_FAILURE + 1))
+        log_build "metallib link failure inputs=${#air_files[@]} output=${LIBRARY_OUT}"
+    fi
+fi
+
 PHASE_END_TS="$(date +%s)"
 log_build "shader translation summary success=${TRANSLATION_SUCCESS} failure=${TRANSLATION_FAILURE}"
 log_build "shader translation pipeline end elapsed_s=$((PHASE_END_TS - PHASE_START_TS))"